@@ -0,0 +1,375 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QRegExp>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+
+#include "Engine/AppManager.h"
+#include "Engine/CLArgs.h"
+#include "Engine/MemoryInfo.h"
+
+// Default minimum time in seconds during which each benchmark is timed
+#define NATRON_BENCHMARK_DEFAULT_MIN_TIME 0.5
+
+// A benchmark stops after this many iterations even if the minimum time is not reached
+#define NATRON_BENCHMARK_MAX_ITERATIONS 1000000000ULL
+
+NATRON_NAMESPACE_ENTER;
+
+BenchmarkState::BenchmarkState(int arg,
+                               double minTime)
+    : _arg(arg)
+    , _minTime(minTime)
+    , _iterations(0)
+    , _batchEnd(1)
+    , _started(false)
+    , _timing(false)
+    , _realTimer()
+    , _cpuStart(0)
+    , _realTime(0)
+    , _cpuTime(0)
+    , _bytesPerIteration(0)
+    , _itemsPerIteration(0)
+    , _error()
+{
+}
+
+bool
+BenchmarkState::keepRunning()
+{
+    if ( !_error.empty() ) {
+        pauseTiming();
+
+        return false;
+    }
+    if (!_started) {
+        _started = true;
+        resumeTiming();
+    }
+    if (_iterations < _batchEnd) {
+        ++_iterations;
+
+        return true;
+    }
+
+    // The batch is done: check the time spent and estimate how many iterations are left
+    pauseTiming();
+    if ( (_realTime >= _minTime) || (_iterations >= NATRON_BENCHMARK_MAX_ITERATIONS) ) {
+        return false;
+    }
+    double nextEnd = (double)_iterations * 10.;
+    if (_realTime > 0) {
+        // Aim a bit above the minimum time so that the next batch is the last one
+        nextEnd = std::min( nextEnd, (double)_iterations * _minTime * 1.4 / _realTime );
+    }
+    _batchEnd = std::max( _iterations + 1, std::min( (U64)nextEnd, (U64)NATRON_BENCHMARK_MAX_ITERATIONS ) );
+    resumeTiming();
+
+    ++_iterations;
+
+    return true;
+} // keepRunning
+
+void
+BenchmarkState::pauseTiming()
+{
+    if (!_timing) {
+        return;
+    }
+    _realTime += _realTimer.nsecsElapsed() * 1e-9;
+    _cpuTime += (double)(std::clock() - _cpuStart) / CLOCKS_PER_SEC;
+    _timing = false;
+}
+
+void
+BenchmarkState::resumeTiming()
+{
+    if (_timing) {
+        return;
+    }
+    _timing = true;
+    _cpuStart = std::clock();
+    _realTimer.start();
+}
+
+void
+BenchmarkState::skipWithError(const std::string& error)
+{
+    _error = error;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+struct BenchmarkDefinition
+{
+    std::string name;
+    BenchmarkFunction func;
+    int arg;
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    U64 iterations;
+
+    // Per iteration, in nanoseconds
+    double realTime;
+    double cpuTime;
+    double bytesPerSecond;
+    double itemsPerSecond;
+    std::string error;
+};
+
+std::vector<BenchmarkDefinition>&
+getRegisteredBenchmarks()
+{
+    // Function-static so that it is constructed before the registrations of the other translation units
+    static std::vector<BenchmarkDefinition> benchmarks;
+
+    return benchmarks;
+}
+
+void
+printUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "Options:\n"
+              << "  --benchmark_filter=<regexp>     Only run the benchmarks whose name matches the regular expression.\n"
+              << "  --benchmark_list_tests          List the benchmarks and exit.\n"
+              << "  --benchmark_min_time=<seconds>  Minimum time during which each benchmark is timed (default: "
+              << NATRON_BENCHMARK_DEFAULT_MIN_TIME << ").\n"
+              << "  --benchmark_out=<file.json>     Also write the results to the given file, in the JSON format of Google Benchmark.\n"
+              << "  --help                          Print this help and exit." << std::endl;
+}
+
+bool
+writeJSONResults(const std::string& filePath,
+                 const char* program,
+                 const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream ofile( filePath.c_str() );
+
+    if ( !ofile.good() ) {
+        return false;
+    }
+    ofile << "{\n"
+          << "  \"context\": {\n"
+          << "    \"date\": \"" << QDateTime::currentDateTime().toString(Qt::ISODate).toStdString() << "\",\n"
+          << "    \"executable\": \"" << program << "\",\n"
+          << "    \"num_cpus\": " << QThread::idealThreadCount() << ",\n"
+#ifdef DEBUG
+          << "    \"library_build_type\": \"debug\"\n"
+#else
+          << "    \"library_build_type\": \"release\"\n"
+#endif
+          << "  },\n"
+          << "  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        ofile << (i == 0 ? "\n" : ",\n")
+              << "    {\n"
+              << "      \"name\": \"" << r.name << "\",\n"
+              << "      \"run_name\": \"" << r.name << "\",\n"
+              << "      \"run_type\": \"iteration\",\n"
+              << "      \"repetitions\": 1,\n"
+              << "      \"repetition_index\": 0,\n"
+              << "      \"threads\": 1,\n";
+        if ( !r.error.empty() ) {
+            ofile << "      \"error_occurred\": true,\n"
+                  << "      \"error_message\": \"" << r.error << "\",\n";
+        }
+        ofile << "      \"iterations\": " << r.iterations << ",\n"
+              << "      \"real_time\": " << r.realTime << ",\n"
+              << "      \"cpu_time\": " << r.cpuTime << ",\n"
+              << "      \"time_unit\": \"ns\"";
+        if (r.bytesPerSecond > 0) {
+            ofile << ",\n      \"bytes_per_second\": " << r.bytesPerSecond;
+        }
+        if (r.itemsPerSecond > 0) {
+            ofile << ",\n      \"items_per_second\": " << r.itemsPerSecond;
+        }
+        ofile << "\n    }";
+    }
+    ofile << "\n  ]\n}\n";
+
+    return ofile.good();
+} // writeJSONResults
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+BenchmarkRegistration::BenchmarkRegistration(const char* name,
+                                             BenchmarkFunction func,
+                                             const char* args)
+{
+    BenchmarkDefinition def;
+
+    def.func = func;
+    QStringList argsList = QString::fromUtf8(args).split( QLatin1Char(','), QString::SkipEmptyParts );
+    if ( argsList.isEmpty() ) {
+        def.name = name;
+        def.arg = -1;
+        getRegisteredBenchmarks().push_back(def);
+
+        return;
+    }
+    for (int i = 0; i < argsList.size(); ++i) {
+        def.arg = argsList[i].trimmed().toInt();
+        def.name = std::string(name) + '/' + argsList[i].trimmed().toStdString();
+        getRegisteredBenchmarks().push_back(def);
+    }
+}
+
+int
+runBenchmarks(int argc,
+              char* argv[])
+{
+    QRegExp filter;
+    std::string outFile;
+    double minTime = NATRON_BENCHMARK_DEFAULT_MIN_TIME;
+    bool listOnly = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.compare(0, 19, "--benchmark_filter=") == 0) {
+            filter = QRegExp( QString::fromUtf8( arg.substr(19).c_str() ) );
+        } else if (arg.compare(0, 16, "--benchmark_out=") == 0) {
+            outFile = arg.substr(16);
+        } else if (arg.compare(0, 21, "--benchmark_min_time=") == 0) {
+            minTime = std::atof( arg.substr(21).c_str() );
+        } else if (arg == "--benchmark_list_tests") {
+            listOnly = true;
+        } else if ( (arg == "--help") || (arg == "-h") ) {
+            printUsage(argv[0]);
+
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+
+            return 1;
+        }
+    }
+    if ( !filter.isEmpty() && !filter.isValid() ) {
+        std::cerr << "Invalid --benchmark_filter regular expression: " << filter.errorString().toStdString() << std::endl;
+
+        return 1;
+    }
+
+    std::vector<BenchmarkDefinition> benchmarks;
+    {
+        const std::vector<BenchmarkDefinition>& registered = getRegisteredBenchmarks();
+        for (std::size_t i = 0; i < registered.size(); ++i) {
+            if ( filter.isEmpty() || (filter.indexIn( QString::fromUtf8( registered[i].name.c_str() ) ) != -1) ) {
+                benchmarks.push_back(registered[i]);
+            }
+        }
+    }
+    if (listOnly) {
+        for (std::size_t i = 0; i < benchmarks.size(); ++i) {
+            std::cout << benchmarks[i].name << std::endl;
+        }
+
+        return 0;
+    }
+
+    // The cache, the luts and the thread pool are those of the application: set it up as the unit tests do
+    AppManager* manager = new AppManager;
+    {
+        int appArgc = 0;
+        QStringList args;
+        args << QString::fromUtf8("--clear-cache");
+        CLArgs cl(args, true);
+        if ( !manager->load(appArgc, 0, cl) ) {
+            std::cerr << "Could not initialize the application" << std::endl;
+            delete manager;
+
+            return 1;
+        }
+    }
+
+    std::printf("%-48s %15s %15s %12s %14s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations", "Throughput");
+    std::printf( "%s\n", std::string(108, '-').c_str() );
+
+    int nFailed = 0;
+    std::vector<BenchmarkResult> results;
+    for (std::size_t i = 0; i < benchmarks.size(); ++i) {
+        BenchmarkState state(benchmarks[i].arg, minTime);
+        benchmarks[i].func(state);
+
+        BenchmarkResult r;
+        r.name = benchmarks[i].name;
+        r.iterations = state.getIterations();
+        r.error = state.getError();
+        r.realTime = r.iterations ? state.getRealTime() * 1e9 / r.iterations : 0.;
+        r.cpuTime = r.iterations ? state.getCpuTime() * 1e9 / r.iterations : 0.;
+        r.bytesPerSecond = state.getRealTime() > 0 ? state.getBytesProcessed() * r.iterations / state.getRealTime() : 0.;
+        r.itemsPerSecond = state.getRealTime() > 0 ? state.getItemsProcessed() * r.iterations / state.getRealTime() : 0.;
+        results.push_back(r);
+
+        if ( !r.error.empty() ) {
+            ++nFailed;
+            std::printf( "%-48s ERROR: %s\n", r.name.c_str(), r.error.c_str() );
+            continue;
+        }
+        std::string throughput;
+        if (r.bytesPerSecond > 0) {
+            throughput = printAsRAM( (U64)r.bytesPerSecond ).toStdString() + "/s";
+        } else if (r.itemsPerSecond > 0) {
+            throughput = QString::number(r.itemsPerSecond, 'g', 4).toStdString() + " items/s";
+        }
+        std::printf( "%-48s %15.0f %15.0f %12llu %14s\n", r.name.c_str(), r.realTime, r.cpuTime, (unsigned long long)r.iterations, throughput.c_str() );
+        std::fflush(stdout);
+    }
+
+    delete manager;
+
+    if ( !outFile.empty() && !writeJSONResults(outFile, argv[0], results) ) {
+        std::cerr << "Could not write " << outFile << std::endl;
+
+        return 1;
+    }
+
+    return nFailed ? 1 : 0;
+} // runBenchmarks
+
+NATRON_NAMESPACE_EXIT;
+
+int
+main(int argc,
+     char* argv[])
+{
+    return NATRON_NAMESPACE::runBenchmarks(argc, argv);
+}
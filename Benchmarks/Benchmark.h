@@ -0,0 +1,184 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_BENCHMARKS_BENCHMARK_H
+#define NATRON_BENCHMARKS_BENCHMARK_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <ctime>
+#include <string>
+
+#include <QtCore/QElapsedTimer>
+
+#include "Global/GlobalDefines.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief The state of a running benchmark, passed to the benchmark function.
+ * The function does its setup, then runs the code to measure in a loop:
+ *
+ *     while ( state.keepRunning() ) {
+ *         ...
+ *     }
+ *
+ * The loop runs until the code has been timed for at least the minimum time given on the command line.
+ * The interface follows the one of Google Benchmark so that benchmarks may be ported to it if it ever gets vendored.
+ **/
+class BenchmarkState
+{
+public:
+
+    BenchmarkState(int arg, double minTime);
+
+    /**
+     * @brief Returns true while the loop must run another iteration.
+     * The time is measured from the first call until it returns false.
+     **/
+    bool keepRunning();
+
+    /**
+     * @brief The argument the benchmark was registered with, e.g. the size of the image, or -1 if none.
+     **/
+    int getArg() const
+    {
+        return _arg;
+    }
+
+    /**
+     * @brief Excludes the code between pauseTiming() and resumeTiming() from the measured time.
+     **/
+    void pauseTiming();
+
+    void resumeTiming();
+
+    /**
+     * @brief Number of bytes, resp. items processed by an iteration, to report a throughput.
+     **/
+    void setBytesProcessed(U64 bytesPerIteration)
+    {
+        _bytesPerIteration = bytesPerIteration;
+    }
+
+    void setItemsProcessed(U64 itemsPerIteration)
+    {
+        _itemsPerIteration = itemsPerIteration;
+    }
+
+    /**
+     * @brief Marks the benchmark as failed, e.g. because the setup failed. keepRunning() returns false after this call.
+     **/
+    void skipWithError(const std::string& error);
+
+    U64 getIterations() const
+    {
+        return _iterations;
+    }
+
+    // Measured times, in seconds
+    double getRealTime() const
+    {
+        return _realTime;
+    }
+
+    double getCpuTime() const
+    {
+        return _cpuTime;
+    }
+
+    U64 getBytesProcessed() const
+    {
+        return _bytesPerIteration;
+    }
+
+    U64 getItemsProcessed() const
+    {
+        return _itemsPerIteration;
+    }
+
+    const std::string& getError() const
+    {
+        return _error;
+    }
+
+private:
+
+    int _arg;
+    double _minTime;
+    U64 _iterations;
+
+    // keepRunning() checks the time once _iterations reaches _batchEnd
+    U64 _batchEnd;
+    bool _started;
+    bool _timing;
+    QElapsedTimer _realTimer;
+    std::clock_t _cpuStart;
+    double _realTime;
+    double _cpuTime;
+    U64 _bytesPerIteration;
+    U64 _itemsPerIteration;
+    std::string _error;
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState& state);
+
+/**
+ * @brief Registers a benchmark at static initialization time. Use the NATRON_BENCHMARK macros instead.
+ * args is a comma separated list of integers: the benchmark is run once for each of them, e.g. "256,1024,4096".
+ **/
+class BenchmarkRegistration
+{
+public:
+
+    BenchmarkRegistration(const char* name,
+                          BenchmarkFunction func,
+                          const char* args = "");
+};
+
+/**
+ * @brief Runs the benchmarks registered matching the command line options, see --help.
+ * Returns the exit code of the process.
+ **/
+int runBenchmarks(int argc, char* argv[]);
+
+NATRON_NAMESPACE_EXIT;
+
+/**
+ * @brief Defines a benchmark named suite_name, in the same way as TEST(suite, name) in the unit tests.
+ * The body is a function taking a BenchmarkState& named state.
+ **/
+#define NATRON_BENCHMARK(suite, name) \
+    NATRON_BENCHMARK_WITH_ARGS(suite, name, "")
+
+/**
+ * @brief Same as NATRON_BENCHMARK but the benchmark is run for each argument of the comma separated list args,
+ * which is returned by state.getArg(). The benchmark is reported as suite_name/arg.
+ **/
+#define NATRON_BENCHMARK_WITH_ARGS(suite, name, args) \
+    static void suite ## _ ## name ## _Benchmark(NATRON_NAMESPACE::BenchmarkState & state); \
+    static NATRON_NAMESPACE::BenchmarkRegistration suite ## _ ## name ## _Registration(#suite "_" #name, suite ## _ ## name ## _Benchmark, args); \
+    static void suite ## _ ## name ## _Benchmark(NATRON_NAMESPACE::BenchmarkState & state)
+
+#endif // NATRON_BENCHMARKS_BENCHMARK_H
@@ -0,0 +1,63 @@
+# ***** BEGIN LICENSE BLOCK *****
+# This file is part of Natron <http://www.natron.fr/>,
+# Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+#
+# Natron is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# Natron is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+# ***** END LICENSE BLOCK *****
+
+# Benchmarks of the engine kernels. Run NatronBenchmarks --help for the options.
+# The results may be written in the JSON format of Google Benchmark with --benchmark_out=<file.json>
+# so that they can be compared across builds with its tools/compare.py script.
+
+TARGET = NatronBenchmarks
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+# Cairo is still the default renderer for Roto
+!enable-osmesa {
+   CONFIG += enable-cairo
+}
+CONFIG += moc
+CONFIG += boost qt python shiboken pyside osmesa fontconfig
+enable-cairo: CONFIG += cairo
+CONFIG += static-yaml-cpp static-engine static-serialization static-host-support static-breakpadclient static-libmv static-openmvg static-ceres static-libtess
+QT += core network
+QT -= gui
+greaterThan(QT_MAJOR_VERSION, 4): QT += concurrent
+
+!noexpat: CONFIG += expat
+
+include(../global.pri)
+
+SOURCES += \
+    Benchmark.cpp \
+    BezierBenchmarks.cpp \
+    CacheBenchmarks.cpp \
+    CurveBenchmarks.cpp \
+    Hash64Benchmarks.cpp \
+    ImageBenchmarks.cpp \
+    LutBenchmarks.cpp
+
+HEADERS += \
+    Benchmark.h
+
+# End-to-end render benchmarks of NatronRenderer, not built
+OTHER_FILES += \
+    Render/make_multilayer_exr.py \
+    Render/run_render_benchmarks.py \
+    Render/projects/deep_merge_tree.py \
+    Render/projects/heavy_roto.py \
+    Render/projects/multilayer_exr.py \
+    Render/projects/tracker_heavy.py \
+    Render/projects/transform_chain.py
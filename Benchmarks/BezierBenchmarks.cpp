@@ -0,0 +1,102 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cmath>
+#include <list>
+#include <vector>
+
+#include "Benchmark.h"
+
+#include "Engine/Bezier.h"
+#include "Engine/BezierCP.h"
+#include "Engine/RectD.h"
+#include "Engine/Transform.h"
+
+NATRON_NAMESPACE_USING
+
+#ifndef M_PI
+#define M_PI        3.14159265358979323846264338327950288   /* pi             */
+#endif
+
+// The argument of the benchmarks is the number of control points of the shape
+#define BEZIER_BENCHMARK_N_CONTROL_POINTS "4,32,256"
+
+/**
+ * @brief Makes a closed shape approximating a circle of radius 500 with the given number of control points.
+ **/
+static std::list<BezierCPPtr>
+makeCircle(int nPoints)
+{
+    std::list<BezierCPPtr> cps;
+    const double radius = 500.;
+    // Length of the tangents so that each segment approximates an arc of the circle
+    double tangent = radius * 4. / 3. * std::tan(M_PI / (2. * nPoints));
+
+    for (int i = 0; i < nPoints; ++i) {
+        double angle = 2. * M_PI * i / nPoints;
+        double x = radius * std::cos(angle);
+        double y = radius * std::sin(angle);
+        double dx = -std::sin(angle) * tangent;
+        double dy = std::cos(angle) * tangent;
+        BezierCPPtr cp(new BezierCP);
+        cp->setStaticPosition(x, y);
+        cp->setLeftBezierStaticPosition(x - dx, y - dy);
+        cp->setRightBezierStaticPosition(x + dx, y + dy);
+        cps.push_back(cp);
+    }
+
+    return cps;
+}
+
+static void
+benchmarkDeCasteljau(BenchmarkState& state,
+                     Bezier::DeCasteljauAlgorithmEnum algo)
+{
+    std::list<BezierCPPtr> cps = makeCircle( state.getArg() );
+    Transform::Matrix3x3 identity;
+    std::vector<ParametricPoint> points;
+    U64 nPoints = 0;
+
+    while ( state.keepRunning() ) {
+        points.clear();
+        RectD bbox;
+        Bezier::deCasteljau(false /*isOpenBezier*/, cps, TimeValue(0), RenderScale(1.), 0. /*featherDistance*/, true /*finished*/, true /*clockWise*/,
+                            algo, -1 /*nbPointsPerSegment*/, 1. /*errorScale*/, identity, &points, &bbox);
+        nPoints = points.size();
+    }
+    // Report the number of points generated per second
+    state.setItemsProcessed(nPoints);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Bezier, DeCasteljauIterative, BEZIER_BENCHMARK_N_CONTROL_POINTS)
+{
+    benchmarkDeCasteljau(state, Bezier::eDeCasteljauAlgorithmIterative);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Bezier, DeCasteljauRecursive, BEZIER_BENCHMARK_N_CONTROL_POINTS)
+{
+    benchmarkDeCasteljau(state, Bezier::eDeCasteljauAlgorithmRecursive);
+}
@@ -0,0 +1,137 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <vector>
+
+#include <QtCore/QThread>
+
+#include "Benchmark.h"
+
+#include "Engine/Cache.h"
+#include "Engine/EffectInstanceActionResults.h"
+#include "Engine/RectD.h"
+
+NATRON_NAMESPACE_USING
+
+// The argument of the benchmarks is the number of threads accessing the cache concurrently
+#define CACHE_BENCHMARK_N_THREADS "1,4,8"
+
+// Number of cache accesses made by each thread in an iteration
+#define CACHE_BENCHMARK_N_ACCESSES_PER_THREAD 2000
+
+// Number of distinct entries looked up by the Cache_GetOrInsert benchmark: after the first iteration, all of them are cached
+#define CACHE_BENCHMARK_N_KEYS 1024
+
+/**
+ * @brief Looks up the region of definition results for consecutive hashes and inserts them when they are not cached,
+ * the same way EffectInstance::getRegionOfDefinition_public does.
+ **/
+class CacheAccessThread
+    : public QThread
+{
+    U64 _firstHash;
+    U64 _moduloHash;
+
+public:
+
+    CacheAccessThread(U64 firstHash,
+                      U64 moduloHash)
+        : QThread()
+        , _firstHash(firstHash)
+        , _moduloHash(moduloHash)
+    {
+    }
+
+    virtual ~CacheAccessThread()
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        const std::string pluginID("fr.inria.benchmarks.cache");
+        for (U64 i = 0; i < CACHE_BENCHMARK_N_ACCESSES_PER_THREAD; ++i) {
+            U64 hash = _moduloHash ? 1 + (_firstHash + i) % _moduloHash : _firstHash + i;
+            GetRegionOfDefinitionKeyPtr key( new GetRegionOfDefinitionKey( hash, RenderScale(1.), pluginID ) );
+            GetRegionOfDefinitionResultsPtr results = GetRegionOfDefinitionResults::create(key);
+            CacheEntryLockerBasePtr cacheAccess = results->getFromCache();
+            CacheEntryLockerBase::CacheEntryStatusEnum status = cacheAccess->getStatus();
+            while (status == CacheEntryLockerBase::eCacheEntryStatusComputationPending) {
+                status = cacheAccess->waitForPendingEntry();
+            }
+            if (status == CacheEntryLockerBase::eCacheEntryStatusMustCompute) {
+                results->setRoD( RectD(0, 0, hash, hash) );
+                cacheAccess->insertInCache();
+            }
+        }
+    }
+};
+
+/**
+ * @brief Runs nThreads CacheAccessThread concurrently and waits for them.
+ * If moduloHash is not 0, the hashes wrap around so that the accesses hit the same entries.
+ **/
+static void
+runCacheAccessThreads(int nThreads,
+                      U64 firstHash,
+                      U64 moduloHash)
+{
+    std::vector<CacheAccessThread*> threads(nThreads);
+
+    for (int i = 0; i < nThreads; ++i) {
+        // Each thread starts at a different entry so that they do not always wait for each other on the same one
+        threads[i] = new CacheAccessThread( firstHash + (U64)i * CACHE_BENCHMARK_N_ACCESSES_PER_THREAD, moduloHash );
+        threads[i]->start();
+    }
+    for (int i = 0; i < nThreads; ++i) {
+        threads[i]->wait();
+        delete threads[i];
+    }
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Cache, GetOrInsert, CACHE_BENCHMARK_N_THREADS)
+{
+    int nThreads = state.getArg();
+
+    while ( state.keepRunning() ) {
+        runCacheAccessThreads(nThreads, 0, CACHE_BENCHMARK_N_KEYS);
+    }
+    state.setItemsProcessed( (U64)nThreads * CACHE_BENCHMARK_N_ACCESSES_PER_THREAD );
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Cache, Insert, CACHE_BENCHMARK_N_THREADS)
+{
+    // Hashes above the ones of Cache_GetOrInsert which are never looked up twice: every access is a miss followed by an insertion
+    int nThreads = state.getArg();
+    static U64 nextHash = 1ULL << 32;
+
+    while ( state.keepRunning() ) {
+        runCacheAccessThreads(nThreads, nextHash, 0);
+        nextHash += (U64)nThreads * CACHE_BENCHMARK_N_ACCESSES_PER_THREAD;
+    }
+    state.setItemsProcessed( (U64)nThreads * CACHE_BENCHMARK_N_ACCESSES_PER_THREAD );
+}
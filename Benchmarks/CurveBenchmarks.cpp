@@ -0,0 +1,108 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <vector>
+
+#include "Benchmark.h"
+
+#include "Engine/Curve.h"
+
+NATRON_NAMESPACE_USING
+
+// The argument of the benchmarks is the number of keyframes of the curve
+#define CURVE_BENCHMARK_KEYFRAMES "4,64,1024"
+
+// Number of times at which the curve is evaluated by an iteration
+#define CURVE_BENCHMARK_N_EVALUATIONS 10000
+
+static void
+makeCurve(int nKeyFrames,
+          Curve* curve)
+{
+    for (int i = 0; i < nKeyFrames; ++i) {
+        curve->addKeyFrame( KeyFrame( i * 10., (i % 3) * 0.5 - i * 0.01 ) );
+    }
+}
+
+static std::vector<TimeValue>
+makeSortedTimes(int nKeyFrames)
+{
+    // From slightly before the first keyframe to slightly after the last one
+    std::vector<TimeValue> times(CURVE_BENCHMARK_N_EVALUATIONS);
+    double range = nKeyFrames * 10. + 20.;
+
+    for (int i = 0; i < CURVE_BENCHMARK_N_EVALUATIONS; ++i) {
+        times[i] = TimeValue(-10. + range * i / CURVE_BENCHMARK_N_EVALUATIONS);
+    }
+
+    return times;
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Curve, GetValueAt, CURVE_BENCHMARK_KEYFRAMES)
+{
+    Curve curve;
+
+    makeCurve(state.getArg(), &curve);
+    std::vector<TimeValue> times = makeSortedTimes( state.getArg() );
+    double sum = 0.;
+    while ( state.keepRunning() ) {
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            sum += curve.getValueAt(times[i]);
+        }
+    }
+    state.setItemsProcessed( times.size() );
+    ignore_result(sum);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Curve, GetValuesAt, CURVE_BENCHMARK_KEYFRAMES)
+{
+    Curve curve;
+
+    makeCurve(state.getArg(), &curve);
+    std::vector<TimeValue> times = makeSortedTimes( state.getArg() );
+    std::vector<double> values;
+    while ( state.keepRunning() ) {
+        curve.getValuesAt(times, true, &values);
+    }
+    state.setItemsProcessed( times.size() );
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Curve, SnapshotGetValueAt, CURVE_BENCHMARK_KEYFRAMES)
+{
+    Curve curve;
+
+    makeCurve(state.getArg(), &curve);
+    CurveSnapshotConstPtr snapshot = curve.createEvaluationSnapshot();
+    std::vector<TimeValue> times = makeSortedTimes( state.getArg() );
+    double sum = 0.;
+    while ( state.keepRunning() ) {
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            sum += snapshot->getValueAt(times[i]);
+        }
+    }
+    state.setItemsProcessed( times.size() );
+    ignore_result(sum);
+}
@@ -0,0 +1,78 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <vector>
+
+#include "Benchmark.h"
+
+#include "Engine/Hash64.h"
+
+NATRON_NAMESPACE_USING
+
+// The argument of the benchmarks is the number of values hashed by an iteration
+#define HASH64_BENCHMARK_SIZES "16,1024,65536"
+
+NATRON_BENCHMARK_WITH_ARGS(Hash64, Append, HASH64_BENCHMARK_SIZES)
+{
+    int n = state.getArg();
+    std::vector<U64> values(n);
+
+    for (int i = 0; i < n; ++i) {
+        values[i] = (U64)i * 0x9E3779B97F4A7C15ULL;
+    }
+    Hash64 hash;
+    U64 result = 0;
+    while ( state.keepRunning() ) {
+        hash.reset();
+        for (int i = 0; i < n; ++i) {
+            hash.append(values[i]);
+        }
+        hash.computeHash();
+        result ^= hash.value();
+    }
+    state.setBytesProcessed( n * sizeof(U64) );
+    ignore_result(result);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Hash64, AppendArray, HASH64_BENCHMARK_SIZES)
+{
+    int n = state.getArg();
+    std::vector<double> values(n);
+
+    for (int i = 0; i < n; ++i) {
+        values[i] = i * 0.25;
+    }
+    Hash64 hash;
+    U64 result = 0;
+    while ( state.keepRunning() ) {
+        hash.reset();
+        hash.appendArray(&values[0], values.size());
+        hash.computeHash();
+        result ^= hash.value();
+    }
+    state.setBytesProcessed( n * sizeof(double) );
+    ignore_result(result);
+}
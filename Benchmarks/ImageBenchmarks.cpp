@@ -0,0 +1,194 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <bitset>
+
+#include "Benchmark.h"
+
+#include "Engine/CacheEntryBase.h"
+#include "Engine/Image.h"
+#include "Engine/ImagePlaneDesc.h"
+
+NATRON_NAMESPACE_USING
+
+// The argument of the benchmarks is the width and height of the images, in pixels
+#define IMAGE_BENCHMARK_SIZES "512,2048"
+
+static ImagePtr
+createImage(int size,
+            ImageBitDepthEnum depth,
+            ImageBufferLayoutEnum layout,
+            const ImagePlaneDesc& plane = ImagePlaneDesc::getRGBAComponents())
+{
+    Image::InitStorageArgs args;
+
+    args.bounds = RectI(0, 0, size, size);
+    args.bitdepth = depth;
+    args.bufferFormat = layout;
+    args.plane = plane;
+    args.storage = eStorageModeRAM;
+    ImagePtr image = Image::create(args);
+    if (image) {
+        // Non uniform pixels so that the conversions do not take a shortcut
+        RectI half(0, 0, size, size / 2);
+        image->fill(args.bounds, 0.18f, 0.5f, 0.9f, 1.f);
+        image->fill(half, 0.7f, 0.05f, 0.3f, 0.5f);
+    }
+
+    return image;
+}
+
+static void
+benchmarkCopyPixels(BenchmarkState& state,
+                    ImageBitDepthEnum srcDepth,
+                    ImageBufferLayoutEnum srcLayout,
+                    ImageBitDepthEnum dstDepth,
+                    ImageBufferLayoutEnum dstLayout,
+                    ViewerColorSpaceEnum dstColorspace)
+{
+    int size = state.getArg();
+    ImagePtr src = createImage(size, srcDepth, srcLayout);
+    ImagePtr dst = createImage(size, dstDepth, dstLayout);
+
+    if (!src || !dst) {
+        state.skipWithError("Could not create the images");
+
+        return;
+    }
+
+    Image::CopyPixelsArgs args;
+    args.roi = src->getBounds();
+    args.dstColorspace = dstColorspace;
+    args.forceCopyEvenIfBuffersHaveSameLayout = true;
+    while ( state.keepRunning() ) {
+        dst->copyPixels(*src, args);
+    }
+    state.setBytesProcessed( (U64)size * size * 4 * getSizeOfForBitDepth(srcDepth) );
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Image, CopyPixelsFloatPacked, IMAGE_BENCHMARK_SIZES)
+{
+    benchmarkCopyPixels(state, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect, eViewerColorSpaceLinear);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Image, CopyPixelsFloatPackedToMonoChannel, IMAGE_BENCHMARK_SIZES)
+{
+    benchmarkCopyPixels(state, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect, eImageBitDepthFloat, eImageBufferLayoutMonoChannelFullRect, eViewerColorSpaceLinear);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Image, CopyPixelsMonoChannelToFloatPacked, IMAGE_BENCHMARK_SIZES)
+{
+    benchmarkCopyPixels(state, eImageBitDepthFloat, eImageBufferLayoutMonoChannelFullRect, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect, eViewerColorSpaceLinear);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Image, CopyPixelsFloatToByteSRGB, IMAGE_BENCHMARK_SIZES)
+{
+    benchmarkCopyPixels(state, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect, eImageBitDepthByte, eImageBufferLayoutRGBAPackedFullRect, eViewerColorSpaceSRGB);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Image, CopyPixelsByteToFloat, IMAGE_BENCHMARK_SIZES)
+{
+    benchmarkCopyPixels(state, eImageBitDepthByte, eImageBufferLayoutRGBAPackedFullRect, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect, eViewerColorSpaceLinear);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Image, CopyPixelsShortToFloat, IMAGE_BENCHMARK_SIZES)
+{
+    benchmarkCopyPixels(state, eImageBitDepthShort, eImageBufferLayoutRGBAPackedFullRect, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect, eViewerColorSpaceLinear);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Image, FillFloat, IMAGE_BENCHMARK_SIZES)
+{
+    int size = state.getArg();
+    ImagePtr image = createImage(size, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect);
+
+    if (!image) {
+        state.skipWithError("Could not create the image");
+
+        return;
+    }
+    RectI roi = image->getBounds();
+    while ( state.keepRunning() ) {
+        image->fill(roi, 0.1f, 0.2f, 0.3f, 1.f);
+    }
+    state.setBytesProcessed( (U64)size * size * 4 * sizeof(float) );
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Image, ApplyMaskMix, IMAGE_BENCHMARK_SIZES)
+{
+    int size = state.getArg();
+    ImagePtr image = createImage(size, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect);
+    ImagePtr original = createImage(size, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect);
+    ImagePtr mask = createImage(size, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect, ImagePlaneDesc::getAlphaComponents());
+
+    if (!image || !original || !mask) {
+        state.skipWithError("Could not create the images");
+
+        return;
+    }
+    RectI roi = image->getBounds();
+    while ( state.keepRunning() ) {
+        image->applyMaskMix(roi, mask, original, true /*masked*/, false /*maskInvert*/, 0.5f);
+    }
+    state.setBytesProcessed( (U64)size * size * 4 * sizeof(float) );
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Image, ApplyMaskMixAndCopyUnProcessedChannels, IMAGE_BENCHMARK_SIZES)
+{
+    int size = state.getArg();
+    ImagePtr image = createImage(size, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect);
+    ImagePtr original = createImage(size, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect);
+    ImagePtr mask = createImage(size, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect, ImagePlaneDesc::getAlphaComponents());
+
+    if (!image || !original || !mask) {
+        state.skipWithError("Could not create the images");
+
+        return;
+    }
+    RectI roi = image->getBounds();
+    std::bitset<4> processChannels;
+    processChannels[0] = processChannels[1] = processChannels[2] = true;
+    while ( state.keepRunning() ) {
+        image->applyMaskMixAndCopyUnProcessedChannels(roi, processChannels, mask, original, true /*masked*/, false /*maskInvert*/, 0.5f);
+    }
+    state.setBytesProcessed( (U64)size * size * 4 * sizeof(float) );
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Image, DownscaleMipMap, IMAGE_BENCHMARK_SIZES)
+{
+    int size = state.getArg();
+    ImagePtr image = createImage(size, eImageBitDepthFloat, eImageBufferLayoutRGBAPackedFullRect);
+
+    if (!image) {
+        state.skipWithError("Could not create the image");
+
+        return;
+    }
+    RectI roi = image->getBounds();
+    while ( state.keepRunning() ) {
+        ImagePtr downscaled = image->downscaleMipMap(roi, 1);
+    }
+    state.setBytesProcessed( (U64)size * size * 4 * sizeof(float) );
+}
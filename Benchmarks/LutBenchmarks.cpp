@@ -0,0 +1,119 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <vector>
+
+#include "Benchmark.h"
+
+#include "Engine/Lut.h"
+
+NATRON_NAMESPACE_USING
+using namespace NATRON_NAMESPACE::Color;
+
+// The argument of the benchmarks is the number of values converted by an iteration
+#define LUT_BENCHMARK_SIZES "4096,1048576"
+
+static std::vector<float>
+makeLinearValues(int n)
+{
+    std::vector<float> values(n);
+
+    for (int i = 0; i < n; ++i) {
+        // Slightly above 1 so that the clamped values are also measured
+        values[i] = 1.05f * i / n;
+    }
+
+    return values;
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Lut, ToFloatPlanarSRGB, LUT_BENCHMARK_SIZES)
+{
+    int n = state.getArg();
+    const Lut* lut = LutManager::sRGBLut();
+    std::vector<float> from = makeLinearValues(n);
+    std::vector<float> to(n);
+
+    while ( state.keepRunning() ) {
+        lut->to_float_planar(&to[0], &from[0], n);
+    }
+    state.setItemsProcessed(n);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Lut, FromFloatPlanarSRGB, LUT_BENCHMARK_SIZES)
+{
+    int n = state.getArg();
+    const Lut* lut = LutManager::sRGBLut();
+    std::vector<float> from = makeLinearValues(n);
+    std::vector<float> to(n);
+
+    while ( state.keepRunning() ) {
+        lut->from_float_planar(&to[0], &from[0], n);
+    }
+    state.setItemsProcessed(n);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Lut, ToUint8xxFastSRGB, LUT_BENCHMARK_SIZES)
+{
+    int n = state.getArg();
+    const Lut* lut = LutManager::sRGBLut();
+    std::vector<float> from = makeLinearValues(n);
+    std::vector<unsigned short> to(n);
+
+    while ( state.keepRunning() ) {
+        lut->toColorSpaceUint8xxFromLinearFloatFast(&from[0], 1, &to[0], 1, n);
+    }
+    state.setItemsProcessed(n);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Lut, ToUint8xxFastPackedRGBA, LUT_BENCHMARK_SIZES)
+{
+    // Converts the red channel of a packed RGBA buffer, as the viewer does
+    int n = state.getArg();
+    const Lut* lut = LutManager::sRGBLut();
+    std::vector<float> from = makeLinearValues(n * 4);
+    std::vector<unsigned short> to(n * 4);
+
+    while ( state.keepRunning() ) {
+        lut->toColorSpaceUint8xxFromLinearFloatFast(&from[0], 4, &to[0], 4, n);
+    }
+    state.setItemsProcessed(n);
+}
+
+NATRON_BENCHMARK_WITH_ARGS(Lut, ToColorSpaceFloatExactSRGB, "4096")
+{
+    // The transfer function without the tables, for comparison with the Fast conversions
+    int n = state.getArg();
+    const Lut* lut = LutManager::sRGBLut();
+    std::vector<float> from = makeLinearValues(n);
+    std::vector<float> to(n);
+
+    while ( state.keepRunning() ) {
+        for (int i = 0; i < n; ++i) {
+            to[i] = lut->toColorSpaceFloatFromLinearFloat(from[i]);
+        }
+    }
+    state.setItemsProcessed(n);
+}
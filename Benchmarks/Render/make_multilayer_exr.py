@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+# ***** BEGIN LICENSE BLOCK *****
+# This file is part of Natron <http://www.natron.fr/>,
+# Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+#
+# Natron is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# Natron is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+# ***** END LICENSE BLOCK *****
+
+"""Writes the synthetic multi-layer EXR sequence read by projects/multilayer_exr.py.
+
+Each frame holds the layers a 3D renderer typically outputs (beauty, diffuse, specular,
+normals and depth) filled with gradients that differ per channel and per frame, so that
+the files do not compress to nothing. Requires the OpenEXR Python bindings.
+
+Usage: make_multilayer_exr.py <output pattern with ####> <first frame> <last frame> [<width> <height>]
+"""
+
+import struct
+import sys
+
+import Imath
+import OpenEXR
+
+LAYERS = [("R", "G", "B", "A"),
+          ("diffuse.R", "diffuse.G", "diffuse.B"),
+          ("specular.R", "specular.G", "specular.B"),
+          ("normals.R", "normals.G", "normals.B"),
+          ("depth.Z",)]
+
+
+def make_pattern(width, index):
+    """A row twice as wide as the image from which each row of a channel is sliced."""
+    values = [((x * (index + 3)) % (2 * width)) / float(2 * width) for x in range(2 * width)]
+    return struct.pack("<%de" % len(values), *values)
+
+
+def write_frame(path, width, height, frame):
+    header = OpenEXR.Header(width, height)
+    half = Imath.Channel(Imath.PixelType(Imath.PixelType.HALF))
+    channels = [name for layer in LAYERS for name in layer]
+    header["channels"] = dict((name, half) for name in channels)
+    pixels = {}
+    for index, name in enumerate(channels):
+        pattern = make_pattern(width, index)
+        rows = []
+        for y in range(height):
+            offset = (y * (index + 1) + frame * 17) % width
+            rows.append(pattern[2 * offset:2 * (offset + width)])
+        pixels[name] = b"".join(rows)
+    exr = OpenEXR.OutputFile(path, header)
+    exr.writePixels(pixels)
+    exr.close()
+
+
+def main(argv):
+    if len(argv) not in (4, 6):
+        sys.stderr.write(__doc__)
+        return 1
+    pattern = argv[1]
+    first, last = int(argv[2]), int(argv[3])
+    width, height = (int(argv[4]), int(argv[5])) if len(argv) == 6 else (1920, 1080)
+    for frame in range(first, last + 1):
+        write_frame(pattern.replace("####", "%04d" % frame), width, height, frame)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,42 @@
+# -*- coding: utf-8 -*-
+# Reference project of the render benchmarks, see ../run_render_benchmarks.py
+# A balanced tree of Merge nodes over 64 animated generators: measures the request pass
+# and the scheduling of many branches rendering concurrently.
+
+import os
+
+N_SOURCES = 64
+GENERATORS = ["net.sf.openfx.CheckerBoardPlugin",
+              "net.sf.openfx.ColorWheel",
+              "net.sf.openfx.Radial",
+              "net.sf.openfx.Rectangle"]
+
+# app is defined by NatronRenderer when it executes the script
+
+layer = []
+for i in range(N_SOURCES):
+    source = app.createNode(GENERATORS[i % len(GENERATORS)])
+    transform = app.createNode("net.sf.openfx.TransformPlugin")
+    transform.connectInput(0, source)
+    translate = transform.getParam("translate")
+    translate.setValueAtTime(-200. + 7. * i, 1, 0)
+    translate.setValueAtTime(200. - 5. * i, 24, 0)
+    transform.getParam("scale").setValue(0.5 + (i % 5) * 0.1, 0)
+    layer.append(transform)
+
+# Merge the branches two by two until a single one remains
+while len(layer) > 1:
+    merged = []
+    for i in range(0, len(layer) - 1, 2):
+        merge = app.createNode("net.sf.openfx.MergePlugin")
+        merge.connectInput(0, layer[i])
+        merge.connectInput(1, layer[i + 1])
+        merge.getParam("mix").setValue(0.75)
+        merged.append(merge)
+    if len(layer) % 2:
+        merged.append(layer[-1])
+    layer = merged
+
+writer = app.createWriter(os.environ["NATRON_BENCHMARK_OUTPUT"])
+writer.setScriptName("BenchmarkWrite")
+writer.connectInput(0, layer[0])
@@ -0,0 +1,28 @@
+# -*- coding: utf-8 -*-
+# Reference project of the render benchmarks, see ../run_render_benchmarks.py
+# A Roto node with 200 animated and feathered shapes: measures the tessellation and the
+# rasterization of the shapes.
+
+import os
+
+N_SHAPES = 200
+
+# app is defined by NatronRenderer when it executes the script
+
+roto = app.createNode("fr.inria.built-in.Roto")
+shapes = roto.getItemsTable()
+for i in range(N_SHAPES):
+    x = 100. + (i * 97) % 1700
+    y = 100. + (i * 61) % 900
+    if i % 2:
+        shape = shapes.createEllipse(x, y, 40. + i % 80, True, 1)
+    else:
+        shape = shapes.createRectangle(x, y, 40. + i % 80, 1)
+    # Animate the shape so that each frame is rendered from scratch
+    for point in range(shape.getNumControlPoints()):
+        shape.movePointByIndex(point, 24, 30. + i % 13, -20. + i % 7)
+    shape.getParam("feather").setValue(5. + i % 20)
+
+writer = app.createWriter(os.environ["NATRON_BENCHMARK_OUTPUT"])
+writer.setScriptName("BenchmarkWrite")
+writer.connectInput(0, roto)
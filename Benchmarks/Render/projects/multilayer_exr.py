@@ -0,0 +1,22 @@
+# -*- coding: utf-8 -*-
+# Reference project of the render benchmarks, see ../run_render_benchmarks.py
+# Reads the multi-layer EXR sequence given by NATRON_BENCHMARK_EXR, transforms all its layers
+# and writes them back: measures the decoding, the processing and the encoding of many planes.
+
+import os
+
+# app is defined by NatronRenderer when it executes the script
+
+reader = app.createReader(os.environ["NATRON_BENCHMARK_EXR"])
+
+transform = app.createNode("net.sf.openfx.TransformPlugin")
+transform.connectInput(0, reader)
+transform.getParam("processAllPlanes").setValue(True)
+rotate = transform.getParam("rotate")
+rotate.setValueAtTime(0., 1)
+rotate.setValueAtTime(5., 24)
+
+writer = app.createWriter(os.environ["NATRON_BENCHMARK_OUTPUT"])
+writer.setScriptName("BenchmarkWrite")
+writer.connectInput(0, transform)
+writer.getParam("processAllPlanes").setValue(True)
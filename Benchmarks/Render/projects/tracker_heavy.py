@@ -0,0 +1,37 @@
+# -*- coding: utf-8 -*-
+# Reference project of the render benchmarks, see ../run_render_benchmarks.py
+# A Tracker node with 100 animated tracks stabilizing a moving checkerboard: measures the
+# evaluation of the tracks and of the transform their motion defines on each frame.
+
+import os
+
+N_TRACKS = 100
+
+# app is defined by NatronRenderer when it executes the script
+
+source = app.createNode("net.sf.openfx.CheckerBoardPlugin")
+transform = app.createNode("net.sf.openfx.TransformPlugin")
+transform.connectInput(0, source)
+translate = transform.getParam("translate")
+translate.setValueAtTime(0., 1, 0)
+translate.setValueAtTime(120., 24, 0)
+translate.setValueAtTime(0., 1, 1)
+translate.setValueAtTime(-60., 24, 1)
+
+tracker = app.createNode("fr.inria.built-in.Tracker")
+tracker.connectInput(0, transform)
+tracks = tracker.getItemsTable()
+for i in range(N_TRACKS):
+    track = tracks.createTrack()
+    center = track.getParam("centerPoint")
+    x = 100. + (i * 173) % 1700
+    y = 100. + (i * 89) % 900
+    # The keyframes follow the motion of the transform as if the tracks had been tracked
+    for frame in range(1, 25):
+        center.setValueAtTime(x + 120. * (frame - 1) / 23., frame, 0)
+        center.setValueAtTime(y - 60. * (frame - 1) / 23., frame, 1)
+tracker.getParam("motionType").set("Stabilize")
+
+writer = app.createWriter(os.environ["NATRON_BENCHMARK_OUTPUT"])
+writer.setScriptName("BenchmarkWrite")
+writer.connectInput(0, tracker)
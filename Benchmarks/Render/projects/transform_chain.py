@@ -0,0 +1,30 @@
+# -*- coding: utf-8 -*-
+# Reference project of the render benchmarks, see ../run_render_benchmarks.py
+# A chain of 32 animated Transform nodes: measures the concatenation of the transforms, which
+# is expected to resample the source once whatever the length of the chain.
+
+import os
+
+N_TRANSFORMS = 32
+
+# app is defined by NatronRenderer when it executes the script
+
+node = app.createNode("net.sf.openfx.CheckerBoardPlugin")
+for i in range(N_TRANSFORMS):
+    transform = app.createNode("net.sf.openfx.TransformPlugin")
+    transform.connectInput(0, node)
+    rotate = transform.getParam("rotate")
+    rotate.setValueAtTime(0., 1)
+    rotate.setValueAtTime(1. + i % 3, 24)
+    transform.getParam("translate").setValue(3. * ((i % 5) - 2), 0)
+    transform.getParam("scale").setValue(1.01 if i % 2 else 0.99, 0)
+    node = transform
+
+blur = app.createNode("net.sf.cimg.CImgBlur")
+blur.connectInput(0, node)
+blur.getParam("size").setValue(3., 0)
+blur.getParam("size").setValue(3., 1)
+
+writer = app.createWriter(os.environ["NATRON_BENCHMARK_OUTPUT"])
+writer.setScriptName("BenchmarkWrite")
+writer.connectInput(0, blur)
@@ -0,0 +1,305 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+# ***** BEGIN LICENSE BLOCK *****
+# This file is part of Natron <http://www.natron.fr/>,
+# Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+#
+# Natron is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# Natron is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+# ***** END LICENSE BLOCK *****
+
+"""End-to-end render benchmarks of NatronRenderer.
+
+Renders each reference project of the projects directory with NatronRenderer and reports
+the frames per second, the peak resident memory of the process and the cache hit rate of
+the render, as well as the startup time of NatronRenderer.
+
+To compare two builds or two sets of settings objectively:
+  - run both with the same plug-ins, given with --plugin-path: only the plug-ins found there
+    are loaded, whatever is installed on the machine,
+  - write the results of each run with --output and compare them with --compare.
+
+Each render runs in a new process with the default settings (--no-settings), on which the
+settings given with --setting are applied, and starts from an empty cache (--clear-cache).
+The cache hit rates are measured in an additional render with the render statistics enabled,
+so that collecting them does not slow down the timed renders.
+
+Sample uses:
+  run_render_benchmarks.py --renderer /opt/Natron/bin/NatronRenderer --plugin-path /opt/Natron/Plugins/OFX/Natron --output new.json
+  run_render_benchmarks.py --setting numberOfThreads=8 --projects deep_merge_tree,heavy_roto
+  run_render_benchmarks.py --compare old.json new.json
+"""
+
+import argparse
+import datetime
+import glob
+import json
+import os
+import platform
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+PROJECTS_DIR = os.path.join(SCRIPT_DIR, "projects")
+
+# Name of the Write node created by each reference project
+WRITER_NAME = "BenchmarkWrite"
+
+# The projects are animated over these frames
+DEFAULT_FRAME_RANGE = "1-24"
+
+# Matches the per-node cache statistics written in the -stats.txt files by NatronRenderer -s
+CACHE_STATS_RE = re.compile(r"^Cache hits: (\d+), misses: (\d+)", re.MULTILINE)
+
+
+def median(values):
+    values = sorted(values)
+    if not values:
+        return None
+    mid = len(values) // 2
+    if len(values) % 2:
+        return values[mid]
+    return 0.5 * (values[mid - 1] + values[mid])
+
+
+def parse_frame_range(frame_range):
+    first, last = frame_range.split("-")
+    return int(first), int(last)
+
+
+def max_rss_bytes(rusage):
+    if rusage is None:
+        return None
+    # ru_maxrss is in bytes on macOS and in kilobytes elsewhere
+    if sys.platform == "darwin":
+        return rusage.ru_maxrss
+    return rusage.ru_maxrss * 1024
+
+
+def run_process(cmd, env, log_file):
+    """Runs cmd and returns its exit code, wall clock time in seconds and peak RSS in bytes."""
+    with open(log_file, "ab") as log, open(os.devnull, "rb") as devnull:
+        log.write(("$ %s\n" % " ".join(cmd)).encode("utf-8"))
+        log.flush()
+        start = time.time()
+        proc = subprocess.Popen(cmd, env=env, stdin=devnull, stdout=log, stderr=subprocess.STDOUT)
+        if hasattr(os, "wait4"):
+            # wait4 returns the resources used by this child only
+            _, status, rusage = os.wait4(proc.pid, 0)
+            proc.returncode = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -1
+        else:
+            proc.wait()
+            rusage = None
+        wall = time.time() - start
+    return proc.returncode, wall, max_rss_bytes(rusage)
+
+
+class Runner(object):
+
+    def __init__(self, args, work_dir):
+        self.args = args
+        self.work_dir = work_dir
+        self.log_file = os.path.join(work_dir, "renderer.log")
+        self.env = dict(os.environ)
+        if args.plugin_path:
+            self.env["OFX_PLUGIN_PATH"] = os.path.abspath(args.plugin_path)
+
+    def base_command(self):
+        cmd = [self.args.renderer, "--no-settings", "--clear-cache"]
+        for setting in self.args.setting:
+            cmd += ["--settings", setting]
+        return cmd
+
+    def measure_startup(self):
+        """Time to start NatronRenderer and load the plug-ins, in interpreter mode with an empty input."""
+        times = []
+        rss = []
+        for _ in range(self.args.repetitions):
+            code, wall, peak = run_process(self.base_command() + ["-t"], self.env, self.log_file)
+            if code != 0:
+                return {"status": "failed", "error": "exit code %d, see %s" % (code, self.log_file)}
+            times.append(wall)
+            rss.append(peak)
+        return {"status": "ok", "times": times, "time": median(times), "peak_rss": max(rss) if None not in rss else None}
+
+    def render(self, script, output_dir, stats):
+        env = dict(self.env)
+        env["NATRON_BENCHMARK_OUTPUT"] = os.path.join(output_dir, "frame####.exr")
+        if self.args.exr:
+            env["NATRON_BENCHMARK_EXR"] = self.args.exr
+        cmd = self.base_command()
+        if stats:
+            cmd.append("-s")
+        cmd += ["-w", WRITER_NAME, self.args.frames, script]
+        return run_process(cmd, env, self.log_file)
+
+    def run_project(self, name, startup_time):
+        script = os.path.join(PROJECTS_DIR, name + ".py")
+        if name == "multilayer_exr" and not self.args.exr:
+            return {"status": "skipped", "error": "no multi-layer EXR sequence, see --exr"}
+
+        first, last = parse_frame_range(self.args.frames)
+        n_frames = last - first + 1
+        result = {"status": "ok", "frames": n_frames, "times": []}
+        rss = []
+        for _ in range(self.args.repetitions):
+            output_dir = tempfile.mkdtemp(dir=self.work_dir)
+            code, wall, peak = self.render(script, output_dir, stats=False)
+            shutil.rmtree(output_dir, ignore_errors=True)
+            if code != 0:
+                return {"status": "failed", "error": "exit code %d, see %s" % (code, self.log_file)}
+            result["times"].append(wall)
+            rss.append(peak)
+        result["time"] = median(result["times"])
+        result["peak_rss"] = max(rss) if None not in rss else None
+        # The startup is measured separately: the frame rate is the one of the render only
+        render_time = result["time"] - (startup_time or 0.)
+        result["fps"] = n_frames / render_time if render_time > 0 else None
+
+        if not self.args.no_stats:
+            output_dir = tempfile.mkdtemp(dir=self.work_dir)
+            code, _, _ = self.render(script, output_dir, stats=True)
+            hits = misses = 0
+            for stats_file in glob.glob(os.path.join(output_dir, "*-stats.txt")):
+                with open(stats_file) as f:
+                    for match in CACHE_STATS_RE.finditer(f.read()):
+                        hits += int(match.group(1))
+                        misses += int(match.group(2))
+            shutil.rmtree(output_dir, ignore_errors=True)
+            if code == 0:
+                result["cache_hits"] = hits
+                result["cache_misses"] = misses
+                result["cache_hit_rate"] = float(hits) / (hits + misses) if hits + misses else None
+        return result
+
+
+def list_projects():
+    return sorted(os.path.splitext(os.path.basename(p))[0] for p in glob.glob(os.path.join(PROJECTS_DIR, "*.py")))
+
+
+def format_bytes(value):
+    if value is None:
+        return "-"
+    for unit in ("B", "KiB", "MiB", "GiB"):
+        if value < 1024. or unit == "GiB":
+            return "%.1f %s" % (value, unit)
+        value /= 1024.
+
+
+def format_value(value, fmt):
+    return "-" if value is None else fmt % value
+
+
+def print_results(results):
+    startup = results["startup"]
+    if startup["status"] == "ok":
+        print("Startup time: %.2f s, peak RSS: %s" % (startup["time"], format_bytes(startup["peak_rss"])))
+    else:
+        print("Startup: %s (%s)" % (startup["status"], startup.get("error", "")))
+    print("%-20s %10s %10s %12s %16s" % ("Project", "Time (s)", "Frames/s", "Peak RSS", "Cache hit rate"))
+    for name, r in sorted(results["projects"].items()):
+        if r["status"] != "ok":
+            print("%-20s %s: %s" % (name, r["status"], r.get("error", "")))
+            continue
+        print("%-20s %10.2f %10s %12s %16s" % (name, r["time"], format_value(r["fps"], "%.2f"),
+                                               format_bytes(r["peak_rss"]),
+                                               format_value(r.get("cache_hit_rate"), "%.3f")))
+
+
+def compare(base_file, new_file):
+    with open(base_file) as f:
+        base = json.load(f)
+    with open(new_file) as f:
+        new = json.load(f)
+    print("Comparing %s (base) to %s (new): ratios new / base" % (base_file, new_file))
+    if base["startup"].get("time") and new["startup"].get("time"):
+        print("Startup time: %.3f" % (new["startup"]["time"] / base["startup"]["time"]))
+    print("%-20s %10s %12s %16s" % ("Project", "Frames/s", "Peak RSS", "Cache hit rate"))
+
+    def ratio(b, n, key):
+        if b.get(key) and n.get(key) is not None:
+            return "%.3f" % (n[key] / b[key])
+        return "-"
+
+    for name in sorted(set(base["projects"]) & set(new["projects"])):
+        b = base["projects"][name]
+        n = new["projects"][name]
+        if b["status"] != "ok" or n["status"] != "ok":
+            print("%-20s base: %s, new: %s" % (name, b["status"], n["status"]))
+            continue
+        print("%-20s %10s %12s %16s" % (name, ratio(b, n, "fps"), ratio(b, n, "peak_rss"), ratio(b, n, "cache_hit_rate")))
+    return 0
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--renderer", default="NatronRenderer", help="path of the NatronRenderer executable")
+    parser.add_argument("--plugin-path", help="directory of the OpenFX plug-ins to load instead of the installed ones")
+    parser.add_argument("--projects", help="comma separated list of projects to render (default: all of %s)" % ", ".join(list_projects()))
+    parser.add_argument("--frames", default=DEFAULT_FRAME_RANGE, help="frame range to render, default: %s" % DEFAULT_FRAME_RANGE)
+    parser.add_argument("--repetitions", type=int, default=3, help="number of renders of each project, the median time is reported")
+    parser.add_argument("--setting", action="append", default=[], metavar="NAME=VALUE", help="Natron setting applied to all the renders, may be repeated")
+    parser.add_argument("--exr", help="multi-layer EXR sequence read by the multilayer_exr project, e.g. made with make_multilayer_exr.py")
+    parser.add_argument("--no-stats", action="store_true", help="do not measure the cache hit rates")
+    parser.add_argument("--output", help="also write the results to this JSON file")
+    parser.add_argument("--compare", nargs=2, metavar=("BASE", "NEW"), help="compare two JSON files written with --output and exit")
+    args = parser.parse_args(argv[1:])
+
+    if args.compare:
+        return compare(args.compare[0], args.compare[1])
+
+    projects = args.projects.split(",") if args.projects else list_projects()
+    for name in projects:
+        if not os.path.isfile(os.path.join(PROJECTS_DIR, name + ".py")):
+            parser.error("unknown project %s" % name)
+
+    work_dir = tempfile.mkdtemp(prefix="natron-render-benchmarks-")
+    runner = Runner(args, work_dir)
+    results = {
+        "context": {
+            "date": datetime.datetime.now().isoformat(),
+            "host": platform.node(),
+            "platform": platform.platform(),
+            "renderer": args.renderer,
+            "plugin_path": args.plugin_path,
+            "settings": args.setting,
+            "frames": args.frames,
+            "repetitions": args.repetitions,
+        },
+        "projects": {},
+    }
+    results["startup"] = runner.measure_startup()
+    for name in projects:
+        sys.stdout.write("Rendering %s...\n" % name)
+        sys.stdout.flush()
+        results["projects"][name] = runner.run_project(name, results["startup"].get("time"))
+
+    print_results(results)
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+
+    failed = [name for name, r in results["projects"].items() if r["status"] == "failed"]
+    if failed or results["startup"]["status"] != "ok":
+        print("Some renders failed, the output of NatronRenderer is in %s" % runner.log_file)
+        return 1
+    shutil.rmtree(work_dir, ignore_errors=True)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
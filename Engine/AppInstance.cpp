@@ -72,6 +72,7 @@ CLANG_DIAG_ON(unknown-pragmas)
 #include "Engine/RenderQueue.h"
 #include "Engine/SerializableWindow.h"
 #include "Engine/Settings.h"
+#include "Engine/StartupTrace.h"
 #include "Engine/PyPanelI.h"
 #include "Engine/TabWidgetI.h"
 #include "Engine/ViewerInstance.h"
@@ -528,7 +529,10 @@ AppInstance::loadInternal(const CLArgs& cl,
         return;
     }
 
-    executeCommandLinePythonCommands(cl);
+    {
+        StartupTrace::Scope_RAII trace("Execute command-line Python commands", "startup");
+        executeCommandLinePythonCommands(cl);
+    }
 
     QString exportDocPath = cl.getExportDocsPath();
     if ( !exportDocPath.isEmpty() ) {
@@ -557,12 +561,34 @@ AppInstance::loadInternal(const CLArgs& cl,
 
 
         if ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) {
+            // When the writers to render are given, only the nodes they depend on need to be created.
+            // A script passed with --onload may access any node: load all of them in that case.
+            const std::list<CLArgs::WriterArg>& writerArgs = cl.getWriterArgs();
+            std::list<std::string> outputNodes;
+            bool canSkipNodes = !writerArgs.empty() && cl.getDefaultOnProjectLoadedScript().isEmpty();
+            for (std::list<CLArgs::WriterArg>::const_iterator it = writerArgs.begin(); it != writerArgs.end(); ++it) {
+                if (it->mustCreate) {
+                    canSkipNodes = false;
+                    break;
+                }
+                outputNodes.push_back( it->name.toStdString() );
+            }
+            if (canSkipNodes) {
+                const std::list<CLArgs::ReaderArg>& readerArgs = cl.getReaderArgs();
+                for (std::list<CLArgs::ReaderArg>::const_iterator it = readerArgs.begin(); it != readerArgs.end(); ++it) {
+                    outputNodes.push_back( it->name.toStdString() );
+                }
+                _imp->_currentProject->setOutputNodesToLoad(outputNodes);
+            }
+
             ///Load the project
+            StartupTrace::Scope_RAII trace("Load project", "startup");
             if ( !_imp->_currentProject->loadProject( info.path(), info.fileName() ) ) {
                 throw std::invalid_argument( tr("Project file loading failed.").toStdString() );
             }
         } else if ( info.suffix() == QString::fromUtf8("py") ) {
             ///Load the python script
+            StartupTrace::Scope_RAII trace("Load Python script", "startup");
             loadPythonScript(info);
         } else {
             throw std::invalid_argument( tr("%1 only accepts python scripts or .ntp project files.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ).toStdString() );
@@ -573,6 +599,7 @@ AppInstance::loadInternal(const CLArgs& cl,
         if ( !extraOnProjectCreatedScript.isEmpty() ) {
             QFileInfo cbInfo(extraOnProjectCreatedScript);
             if ( cbInfo.exists() ) {
+                StartupTrace::Scope_RAII trace("Execute --onload script", "startup");
                 loadPythonScript(cbInfo);
             }
         }
@@ -608,8 +635,11 @@ AppInstance::loadInternal(const CLArgs& cl,
             }
         }
 
-        ///launch renders
-        if ( !writersWork.empty() ) {
+        // The startup ends when the renders start
+        StartupTrace::finish();
+
+        ///launch renders, unless they are distributed to the render workers, see RenderCoordinator
+        if ( !writersWork.empty() && (cl.getRenderCoordinatorPort() == 0) ) {
             _imp->renderQueue->renderNonBlocking(writersWork);
         }
     } else if (appPTR->getAppType() == AppManager::eAppTypeInterpreter) {
@@ -618,6 +648,7 @@ AppInstance::loadInternal(const CLArgs& cl,
             if ( info.suffix() == QString::fromUtf8("py") ) {
                 loadPythonScript(info);
             } else if ( info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT) ) {
+                StartupTrace::Scope_RAII trace("Load project", "startup");
                 if ( !_imp->_currentProject->loadProject( info.path(), info.fileName() ) ) {
                     throw std::invalid_argument( tr("Project file loading failed.").toStdString() );
                 }
@@ -629,10 +660,12 @@ AppInstance::loadInternal(const CLArgs& cl,
         if ( !extraOnProjectCreatedScript.isEmpty() ) {
             QFileInfo cbInfo(extraOnProjectCreatedScript);
             if ( cbInfo.exists() ) {
+                StartupTrace::Scope_RAII trace("Execute --onload script", "startup");
                 loadPythonScript(cbInfo);
             }
         }
 
+        StartupTrace::finish();
 
         appPTR->launchPythonInterpreter();
     } else {
@@ -643,6 +676,7 @@ AppInstance::loadInternal(const CLArgs& cl,
         if ( !extraOnProjectCreatedScript.isEmpty() ) {
             QFileInfo cbInfo(extraOnProjectCreatedScript);
             if ( cbInfo.exists() ) {
+                StartupTrace::Scope_RAII trace("Execute --onload script", "startup");
                 loadPythonScript(cbInfo);
             }
         }
@@ -843,8 +877,11 @@ AppInstance::createNodeFromPyPlug(const PluginPtr& plugin, const CreateNodeArgsP
                 pythonModuleName = pythonModuleName.substr(0, foundDot);
             }
 
+            // The module is not imported at startup if the PyPlug infos were read from the manifest of the AppManager:
+            // import it the first time a node of this type is created
             int appID = getAppID() + 1;
             std::stringstream ss;
+            ss << "import " << pythonModuleName << "\n";
             ss << pythonModuleName;
             ss << ".createInstance(app" << appID;
             if (istoolsetScript) {
@@ -32,6 +32,9 @@
 #include <stdexcept>
 #include <cstring> // for std::memcpy, strlen
 #include <sstream> // stringstream
+#include <algorithm> // sort
+#include <functional> // greater
+#include <map>
 
 #if defined(Q_OS_LINUX)
 #include <sys/signal.h>
@@ -64,9 +67,11 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include <ceres/version.h>
 #include <openMVG/version.hpp>
 
+#include <QtCore/QDataStream>
 #include <QtCore/QDateTime>
 #include <QtCore/QDebug>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
 #include <QtCore/QTextCodec>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QSettings>
@@ -88,10 +93,13 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/CLArgs.h"
 #include "Engine/Cache.h"
 #include "Engine/CreateNodeArgs.h"
+#include "Engine/CudaDriver.h"
 #include "Engine/StorageDeleterThread.h"
 #include "Engine/DiskCacheNode.h"
 #include "Engine/DimensionIdx.h"
 #include "Engine/Dot.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/EngineCalibration.h"
 #include "Engine/ExistenceCheckThread.h"
 #include "Engine/FileSystemModel.h" // FileSystemModel::initDriveLettersToNetworkShareNamesMapping
 #include "Global/FStreamsSupport.h"
@@ -101,6 +109,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/LibraryBinary.h"
 #include "Engine/KeybindShortcut.h"
 #include "Engine/Log.h"
+#include "Engine/MemoryAccount.h"
 #include "Engine/MemoryInfo.h" // getSystemTotalRAM, printAsRAM
 #include "Engine/Node.h"
 #include "Engine/OfxImageEffectInstance.h"
@@ -109,15 +118,23 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/OSGLContext.h"
 #include "Engine/OSGLFunctions.h"
 #include "Engine/OneViewNode.h"
+#include "Engine/PluginMemory.h"
 #include "Engine/ProcessHandler.h" // ProcessInputChannel
 #include "Engine/Project.h"
 #include "Engine/PrecompNode.h"
 #include "Engine/ReadNode.h"
+#include "Engine/RenderCoordinator.h"
+#include "Engine/RenderServer.h"
+#include "Engine/RenderWorker.h"
 #include "Engine/RotoPaint.h"
 #include "Engine/RotoShapeRenderNode.h"
 #include "Engine/RotoShapeRenderCairo.h"
 #include "Engine/StandardPaths.h"
+#include "Engine/RenderTrace.h"
+#include "Engine/MetricsServer.h"
+#include "Engine/StartupTrace.h"
 #include "Engine/StubNode.h"
+#include "Engine/TreeRender.h"
 #include "Engine/Settings.h"
 #include "Engine/TrackerNode.h"
 #include "Engine/ThreadPool.h"
@@ -394,14 +411,36 @@ void
 AppManager::takeNatronGIL()
 {
     _imp->natronPythonGIL.lock();
+    ++_imp->natronPythonGILLockCount.localData();
 }
 
 void
 AppManager::releaseNatronGIL()
 {
+    --_imp->natronPythonGILLockCount.localData();
     _imp->natronPythonGIL.unlock();
 }
 
+int
+AppManager::releaseNatronGILFully()
+{
+    int& lockCount = _imp->natronPythonGILLockCount.localData();
+    int ret = lockCount;
+    for (; lockCount > 0; --lockCount) {
+        _imp->natronPythonGIL.unlock();
+    }
+
+    return ret;
+}
+
+void
+AppManager::restoreNatronGIL(int lockCount)
+{
+    for (int i = 0; i < lockCount; ++i) {
+        takeNatronGIL();
+    }
+}
+
 void
 AppManager::loadProjectFromFileFunction(std::istream& ifile, const std::string& filename, const AppInstancePtr& /*app*/, SERIALIZATION_NAMESPACE::ProjectSerialization* obj)
 {
@@ -489,7 +528,13 @@ AppManager::checkForOlderProjectFile(const AppInstancePtr& app, const QString& f
 bool
 AppManager::loadFromArgs(const CLArgs& cl)
 {
-
+    if ( cl.isStartupTraceEnabled() ) {
+        StartupTrace::setEnabled( cl.getStartupTraceFilePath().toStdString() );
+    }
+    if ( !cl.getRenderTraceFilePath().isEmpty() ) {
+        _imp->renderTraceFilePath = cl.getRenderTraceFilePath().toStdString();
+        RenderTrace::start();
+    }
 
     // Ensure Qt knows C-strings are UTF-8 before creating the QApplication for argv
 #if QT_VERSION < 0x050000
@@ -503,11 +548,17 @@ AppManager::loadFromArgs(const CLArgs& cl)
     // on Linux, X11 will create a context that would corrupt
     // the XUniqueContext created by Qt
     _imp->renderingContextPool.reset( new GPUContextPool() );
-    initializeOpenGLFunctionsOnce(true);
+    {
+        StartupTrace::Scope_RAII trace("Initialize OpenGL", "startup");
+        initializeOpenGLFunctionsOnce(true);
+    }
 
     //  QCoreApplication will hold a reference to that appManagerArgc integer until it dies.
     //  Thus ensure that the QCoreApplication is destroyed when returning this function.
-    initializeQApp(_imp->nArgs, &_imp->commandLineArgsUtf8.front());
+    {
+        StartupTrace::Scope_RAII trace("Create the Qt application", "startup");
+        initializeQApp(_imp->nArgs, &_imp->commandLineArgsUtf8.front());
+    }
     // see C++ standard 23.2.4.2 vector capacity [lib.vector.capacity]
     // resizing to a smaller size doesn't free/move memory, so the data pointer remains valid
     assert(_imp->nArgs <= (int)_imp->commandLineArgsUtf8.size());
@@ -516,6 +567,9 @@ AppManager::loadFromArgs(const CLArgs& cl)
 #ifdef QT_CUSTOM_THREADPOOL
     // Set the global thread pool
     QThreadPool::setGlobalInstance(new ThreadPool);
+    _imp->ioThreadPool.reset(new ThreadPool);
+#else
+    _imp->ioThreadPool.reset(new QThreadPool);
 #endif
 
     // set fontconfig path on all platforms
@@ -541,6 +595,7 @@ AppManager::loadFromArgs(const CLArgs& cl)
     }
 
     try {
+        StartupTrace::Scope_RAII trace("Initialize Python", "startup");
         initPython();
     } catch (const std::runtime_error& e) {
         std::cerr << e.what() << std::endl;
@@ -553,6 +608,7 @@ AppManager::loadFromArgs(const CLArgs& cl)
 
     QThreadPool::globalInstance()->setExpiryTimeout(-1); //< make threads never exit on their own
     //otherwise it might crash with thread local storage
+    _imp->ioThreadPool->setExpiryTimeout(-1);
 
 
     ///the QCoreApplication must have been created so far.
@@ -602,6 +658,9 @@ AppManager::~AppManager()
     }
 #endif
 
+    // Stop serving the metrics before the objects they read are destroyed
+    _imp->metricsServer.reset();
+
     bool appsEmpty;
     {
         QMutexLocker k(&_imp->_appInstancesMutex);
@@ -632,6 +691,11 @@ AppManager::~AppManager()
 
     ///Caches may have launched some threads to delete images, wait for them to be done
     QThreadPool::globalInstance()->waitForDone();
+    _imp->ioThreadPool->waitForDone();
+
+    if ( !_imp->renderTraceFilePath.empty() ) {
+        RenderTrace::stop(_imp->renderTraceFilePath);
+    }
 
     tearDownPython();
     _imp->tearDownGL();
@@ -868,7 +932,7 @@ AppManager::loadInternal(const CLArgs& cl)
 # endif
 
     // Settings: we must load these and set the custom settings (using python) ASAP, before creating the OFX Plugin Cache
-    
+    boost::scoped_ptr<StartupTrace::Scope_RAII> settingsTrace( new StartupTrace::Scope_RAII("Load settings", "startup") );
     _imp->_settings = Settings::create();
     _imp->_settings->initializeKnobsPublic();
 
@@ -887,29 +951,41 @@ AppManager::loadInternal(const CLArgs& cl)
         ///Call restore after initializing knobs
         _imp->_settings->loadSettingsFromFile(Settings::eLoadSettingsTypeKnobs);
     }
+    settingsTrace.reset();
 
     // Create cache once we loaded the cache directory path wanted by the user
+    boost::scoped_ptr<StartupTrace::Scope_RAII> cacheTrace( new StartupTrace::Scope_RAII("Attach caches", "startup") );
     _imp->generalPurposeCache = Cache<false>::create(false /*enableTileStorage*/);
     try {
         // If the cache is busy because another process is using it and we are not compiled
         // with NATRON_CACHE_INTERPROCESS_ROBUST, just create a process local cache instead.
-        _imp->tileCache = Cache<true>::create(true /*enableTileStorage*/);
+        _imp->tileCache = Cache<true>::create(true /*enableTileStorage*/, _imp->_settings->getTileCacheTileSizePo2());
     } catch (const BusyCacheException&) {
-        _imp->tileCache = Cache<false>::create(true /*enableTileStorage*/);
+        _imp->tileCache = Cache<false>::create(true /*enableTileStorage*/, _imp->_settings->getTileCacheTileSizePo2());
     }
 
     if (cl.isCacheClearRequestedOnLaunch()) {
         _imp->tileCache->clear();
     }
     _imp->tileCache->setMaximumCacheSize(_imp->_settings->getTileCacheSize());
+    _imp->tileCache->setCompressedTierMaximumSize(_imp->_settings->getCompressedCacheTierSize());
+    _imp->tileCache->setRemoteTier(_imp->_settings->getRemoteCacheTierPath(), _imp->_settings->getRemoteCacheTierMinimumRenderTime());
+    _imp->tileCache->setDirtyTilesHighWatermark(_imp->_settings->getDiskCacheFlushWatermark());
+    _imp->tileCache->setEvictionPolicy((CacheBase::CacheEvictionPolicyEnum)_imp->_settings->getCacheEvictionPolicy());
+    _imp->tileCache->setQuotaGroupSize(CacheBase::eCacheQuotaGroupProject, _imp->_settings->getProjectCacheQuota());
+    _imp->tileCache->setQuotaGroupSize(CacheBase::eCacheQuotaGroupNode, _imp->_settings->getNodeCacheQuota());
+    _imp->tileCache->setQuotaGroupSize(CacheBase::eCacheQuotaGroupViewer, _imp->_settings->getViewerReservedCacheSize());
+    _imp->tileCache->setTileStorageAllocation((CacheBase::CacheTileStoragePagesEnum)_imp->_settings->getTileCachePages(), _imp->_settings->isTileCacheInterleavedAcrossNUMANodes());
     _imp->generalPurposeCache->setMaximumCacheSize(_imp->_settings->getGeneralPurposeCacheSize());
 
     _imp->storageDeleteThread.reset(new StorageDeleterThread);
+    cacheTrace.reset();
 
     _imp->declareSettingsToPython();
 
     // executeCommandLineSettingCommands
     {
+        StartupTrace::Scope_RAII trace("Execute --settings commands", "startup");
         const std::list<std::string>& commands = cl.getSettingCommands();
 
         for (std::list<std::string>::const_iterator it = commands.begin(); it != commands.end(); ++it) {
@@ -1132,6 +1208,14 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
         _imp->initProcessInputChannel( cl.getIPCPipeName() );
     }
 
+    if (cl.getMetricsPort() > 0) {
+        _imp->metricsServer.reset( new MetricsServer() );
+        if ( !_imp->metricsServer->listen( cl.getMetricsPort() ) ) {
+            std::cerr << tr("Could not serve the metrics on port %1").arg( cl.getMetricsPort() ).toStdString() << std::endl;
+            _imp->metricsServer.reset();
+        }
+    }
+
 
     if ( cl.isInterpreterMode() ) {
         _imp->_appType = eAppTypeInterpreter;
@@ -1160,6 +1244,9 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
 
     AppInstancePtr mainInstance = newAppInstance(args, false);
 
+    // If the instance did not start rendering, the startup ends here
+    StartupTrace::finish();
+
     hideSplashScreen();
 
     if (!mainInstance) {
@@ -1169,6 +1256,50 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
     } else {
         onLoadCompleted();
 
+        ///With --calibrate, print the recommended settings for this machine
+        if ( isBackground() && cl.isCalibrationRequested() ) {
+            EngineCalibrationResults results;
+            EngineCalibration::run(&results);
+            std::cout << EngineCalibration::getReport(results);
+            if ( cl.isCalibrationApplyRequested() ) {
+                bool restartNeeded = EngineCalibration::apply(results);
+                std::cout << tr("The recommended settings were saved.").toStdString() << std::endl;
+                if (restartNeeded) {
+                    std::cout << tr("The cache tile size changes when %1 is restarted.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ).toStdString() << std::endl;
+                }
+            }
+        }
+
+        ///With --render-server, keep the plug-ins loaded and render the jobs sent by the clients
+        if ( isBackground() && !cl.getRenderServerName().isEmpty() ) {
+            RenderServer server(mainInstance);
+            _imp->renderServer = &server;
+            bool ok = server.exec( cl.getRenderServerName() );
+            _imp->renderServer = 0;
+            if (!ok) {
+                return false;
+            }
+        }
+
+        ///With --render-coordinator, distribute the frames of the project to the render workers instead of rendering them
+        if ( isBackground() && (cl.getRenderCoordinatorPort() > 0) ) {
+            RenderCoordinator coordinator(mainInstance);
+            if ( !coordinator.exec(cl.getRenderCoordinatorPort(), args) ) {
+                return false;
+            }
+        }
+
+        ///With --render-worker, render the frames sent by the render coordinator
+        if ( isBackground() && !cl.getRenderWorkerCoordinator().isEmpty() ) {
+            RenderWorker worker(mainInstance);
+            _imp->renderWorker = &worker;
+            bool ok = worker.exec( cl.getRenderWorkerCoordinator() );
+            _imp->renderWorker = 0;
+            if (!ok) {
+                return false;
+            }
+        }
+
         ///In background project auto-run the rendering is finished at this point, just exit the instance
         if ( ( (_imp->_appType == eAppTypeBackgroundAutoRun) ||
                ( _imp->_appType == eAppTypeBackgroundAutoRunLaunchedFromGui) ||
@@ -1394,6 +1525,14 @@ AppManager::writeToOutputPipe(const QString & longMessage,
                               const QString & shortMessage,
                               bool printIfNoChannel)
 {
+    if (_imp->renderServer) {
+        _imp->renderServer->writeToClient(shortMessage);
+
+        return true;
+    }
+    if (_imp->renderWorker) {
+        _imp->renderWorker->onOutputMessage(shortMessage);
+    }
     if (!_imp->_backgroundIPC) {
         if (printIfNoChannel) {
             QMutexLocker k(&_imp->errorLogMutex);
@@ -1415,23 +1554,39 @@ AppManager::loadAllPlugins()
     assert( _imp->_plugins.empty() );
     assert( _imp->_formats.empty() );
 
+    // This is most of the startup time of a background render, see StartupTrace
+    StartupTrace::Scope_RAII trace("Load plug-ins", "startup");
+
     // Load plug-ins bundled into Natron
-    loadBuiltinNodePlugins(&_imp->readerPlugins, &_imp->writerPlugins);
+    {
+        StartupTrace::Scope_RAII trace("Load built-in plug-ins", "startup");
+        loadBuiltinNodePlugins(&_imp->readerPlugins, &_imp->writerPlugins);
+    }
 
     // Load OpenFX plug-ins
-    _imp->ofxHost->loadOFXPlugins( &_imp->readerPlugins, &_imp->writerPlugins);
+    {
+        StartupTrace::Scope_RAII trace("Load OpenFX plug-ins", "startup");
+        _imp->ofxHost->loadOFXPlugins( &_imp->readerPlugins, &_imp->writerPlugins);
+    }
 
     // Load PyPlugs and init.py & initGui.py scripts
     // Should be done after settings are declared
-    loadPythonGroups();
+    {
+        StartupTrace::Scope_RAII trace("Load PyPlugs and startup scripts", "startup");
+        loadPythonGroups();
+    }
 
-    // Load presets after all plug-ins are loaded
-    loadNodesPresets();
+    {
+        StartupTrace::Scope_RAII trace("Load presets and plug-in settings", "startup");
+
+        // Load presets after all plug-ins are loaded
+        loadNodesPresets();
 
-    _imp->_settings->loadSettingsFromFile(Settings::eLoadSettingsTypePlugins);
+        _imp->_settings->loadSettingsFromFile(Settings::eLoadSettingsTypePlugins);
 
 
-    onAllPluginsLoaded();
+        onAllPluginsLoaded();
+    }
 }
 
 void
@@ -1450,6 +1605,27 @@ AppManager::onAllPluginsLoaded()
 
     //Make sure there is no duplicates with the same label
     const PluginsMap& plugins = getPluginsList();
+
+    // Index the user creatable plug-ins by label without suffix, in the order of the plug-ins map,
+    // so that finding a duplicate does not require visiting all plug-ins for each plug-in
+    typedef std::map<std::string, std::vector<PluginsMap::const_iterator> > PluginsByLabelMap;
+    PluginsByLabelMap pluginsByLabel;
+    for (PluginsMap::const_iterator it = plugins.begin(); it != plugins.end(); ++it) {
+        if (it->second.empty()) {
+            continue;
+        }
+        bool isUserCreatable = false;
+        for (PluginVersionsOrdered::const_reverse_iterator itver = it->second.rbegin(); itver != it->second.rend(); ++itver) {
+            if ( (*itver)->getIsUserCreatable() ) {
+                isUserCreatable = true;
+                break;
+            }
+        }
+        if (isUserCreatable) {
+            pluginsByLabel[Plugin::makeLabelWithoutSuffix( (*it->second.rbegin())->getPluginLabel() )].push_back(it);
+        }
+    }
+
     for (PluginsMap::const_iterator it = plugins.begin(); it != plugins.end(); ++it) {
         assert( !it->second.empty() );
         if (it->second.empty()) {
@@ -1476,31 +1652,16 @@ AppManager::onAllPluginsLoaded()
         std::string labelWithoutSuffix = Plugin::makeLabelWithoutSuffix( (*first)->getPluginLabel() );
 
         // Find a duplicate
-        for (PluginsMap::const_iterator it2 = plugins.begin();
-             it2 != plugins.end();
-             ++it2) {
-            if (it->first == it2->first) {
-                continue;
-            }
-
-            PluginVersionsOrdered::reverse_iterator other = it2->second.rbegin();
-            bool isOtherUserCreatable = false;
-            for (PluginVersionsOrdered::reverse_iterator it2ver = it2->second.rbegin(); it2ver != it2->second.rend(); ++it2ver) {
-                if ( (*it2ver)->getIsUserCreatable() ) {
-                    isOtherUserCreatable = true;
-                    break;
+        PluginsByLabelMap::const_iterator foundLabel = pluginsByLabel.find(labelWithoutSuffix);
+        if ( foundLabel != pluginsByLabel.end() ) {
+            for (std::vector<PluginsMap::const_iterator>::const_iterator it2 = foundLabel->second.begin(); it2 != foundLabel->second.end(); ++it2) {
+                if ( it->first == (*it2)->first ) {
+                    continue;
                 }
-            }
-
-            if (!isOtherUserCreatable) {
-                continue;
-            }
-
-            // If we find another plug-in (with a different ID) but with the same label without suffix and same grouping
-            // then keep the original label
-            std::string otherLabelWithoutSuffix = Plugin::makeLabelWithoutSuffix( (*other)->getPluginLabel() );
-            if (otherLabelWithoutSuffix == labelWithoutSuffix) {
 
+                // If we find another plug-in (with a different ID) but with the same label without suffix and same grouping
+                // then keep the original label
+                PluginVersionsOrdered::const_reverse_iterator other = (*it2)->second.rbegin();
                 std::vector<std::string> otherGrouping = (*other)->getPropertyNUnsafe<std::string>(kNatronPluginPropGrouping);
                 std::vector<std::string> thisGrouping = (*first)->getPropertyNUnsafe<std::string>(kNatronPluginPropGrouping);
                 bool allEqual = false;
@@ -2015,6 +2176,120 @@ AppManager::loadNodesPresets()
     }
 }
 
+// Name of the file in the cache directory holding the manifest of the PyPlugs encoded with Python scripts
+#define NATRON_PYPLUGS_MANIFEST_FILE_NAME "PyPlugsManifest.dat"
+#define NATRON_PYPLUGS_MANIFEST_FILE_MAGIC 0x4e505950
+#define NATRON_PYPLUGS_MANIFEST_FILE_VERSION 1
+
+/**
+ * @brief What is known of a Python script found in the plug-in paths, as of its last modification time.
+ * The infos are those returned by getGroupInfos(), which imports the module: they are only computed the first
+ * time the script is found, or when it was modified since.
+ **/
+struct PyPlugManifestEntry
+{
+    qint64 lastModified;
+    bool isPyPlug;
+    bool importsNatronGui;
+
+    // True if getGroupInfos() was called on the script, gotInfos is then what it returned
+    bool infosComputed;
+    bool gotInfos;
+    QString pluginID;
+    QString pluginLabel;
+    QString iconFilePath;
+    QString grouping;
+    QString description;
+    bool isToolset;
+    quint32 version;
+
+    PyPlugManifestEntry()
+    : lastModified(0)
+    , isPyPlug(false)
+    , importsNatronGui(false)
+    , infosComputed(false)
+    , gotInfos(false)
+    , pluginID()
+    , pluginLabel()
+    , iconFilePath()
+    , grouping()
+    , description()
+    , isToolset(false)
+    , version(0)
+    {
+    }
+};
+
+// The entries by absolute file path of the script
+typedef std::map<QString, PyPlugManifestEntry> PyPlugManifest;
+
+static QString
+getPyPlugsManifestFilePath()
+{
+    return StandardPaths::writableLocation(StandardPaths::eStandardLocationCache) + QLatin1Char('/') + QString::fromUtf8(NATRON_PYPLUGS_MANIFEST_FILE_NAME);
+}
+
+static void
+readPyPlugsManifest(PyPlugManifest* manifest)
+{
+    QFile file( getPyPlugsManifestFilePath() );
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        return;
+    }
+    QDataStream ds(&file);
+    ds.setVersion(QDataStream::Qt_4_8);
+    quint32 magic = 0, version = 0, nEntries = 0;
+    ds >> magic >> version >> nEntries;
+    if ( (ds.status() != QDataStream::Ok) || (magic != NATRON_PYPLUGS_MANIFEST_FILE_MAGIC) || (version != NATRON_PYPLUGS_MANIFEST_FILE_VERSION) ) {
+        return;
+    }
+    for (quint32 i = 0; i < nEntries; ++i) {
+        QString filePath;
+        PyPlugManifestEntry entry;
+        ds >> filePath >> entry.lastModified >> entry.isPyPlug >> entry.importsNatronGui >> entry.infosComputed >> entry.gotInfos;
+        ds >> entry.pluginID >> entry.pluginLabel >> entry.iconFilePath >> entry.grouping >> entry.description >> entry.isToolset >> entry.version;
+        if (ds.status() != QDataStream::Ok) {
+            // Truncated file, e.g: another process was writing it
+            manifest->clear();
+
+            return;
+        }
+        (*manifest)[filePath] = entry;
+    }
+} // readPyPlugsManifest
+
+static void
+writePyPlugsManifest(const PyPlugManifest& manifest)
+{
+    QString filePath = getPyPlugsManifestFilePath();
+    QDir().mkpath( QFileInfo(filePath).absolutePath() );
+
+    // Write to a temporary file first so that another process starting meanwhile never reads a partial manifest
+    QString tmpFilePath = filePath + QString::fromUtf8(".tmp");
+    {
+        QFile file(tmpFilePath);
+        if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+            return;
+        }
+        QDataStream ds(&file);
+        ds.setVersion(QDataStream::Qt_4_8);
+        ds << (quint32)NATRON_PYPLUGS_MANIFEST_FILE_MAGIC << (quint32)NATRON_PYPLUGS_MANIFEST_FILE_VERSION << (quint32)manifest.size();
+        for (PyPlugManifest::const_iterator it = manifest.begin(); it != manifest.end(); ++it) {
+            const PyPlugManifestEntry& entry = it->second;
+            ds << it->first << entry.lastModified << entry.isPyPlug << entry.importsNatronGui << entry.infosComputed << entry.gotInfos;
+            ds << entry.pluginID << entry.pluginLabel << entry.iconFilePath << entry.grouping << entry.description << entry.isToolset << entry.version;
+        }
+        if (ds.status() != QDataStream::Ok) {
+            file.close();
+            QFile::remove(tmpFilePath);
+
+            return;
+        }
+    }
+    QFile::remove(filePath);
+    QFile::rename(tmpFilePath, filePath);
+} // writePyPlugsManifest
+
 void
 AppManager::loadPythonGroups()
 {
@@ -2135,7 +2410,14 @@ AppManager::loadPythonGroups()
         }
     }
 
-    // Load deprecated PyPlugs encoded using Python scripts
+    // Load deprecated PyPlugs encoded using Python scripts.
+    // Getting the infos of a PyPlug imports its module, which executes the script: this is only done for the scripts
+    // that are not in the manifest or that were modified since. The module is otherwise imported in createNodeFromPyPlug()
+    // when a node of that type is created, e.g: when a project using it is loaded.
+    PyPlugManifest manifest;
+    readPyPlugsManifest(&manifest);
+    PyPlugManifest newManifest;
+    bool manifestChanged = false;
     Q_FOREACH(const QString &plugin, allPlugins) {
         QString moduleName = plugin;
         QString modulePath;
@@ -2150,54 +2432,73 @@ AppManager::loadPythonGroups()
             moduleName = moduleName.remove(0, lastSlash + 1);
         }
 
-        std::string pluginLabel, pluginID, pluginGrouping, iconFilePath, pluginDescription, pluginPath;
+        qint64 lastModified = QFileInfo(plugin).lastModified().toMSecsSinceEpoch();
+        PyPlugManifest::const_iterator found = manifest.find(plugin);
+        PyPlugManifestEntry entry;
+        if ( (found != manifest.end()) && (found->second.lastModified == lastModified) ) {
+            entry = found->second;
+        } else {
+            manifestChanged = true;
+            entry.lastModified = lastModified;
 
-        {
             // Open the file and check for a line that imports NatronGui, if so do not attempt to load the script.
             QFile file(plugin);
             if (!file.open(QIODevice::ReadOnly)) {
                 continue;
             }
             QTextStream ts(&file);
-            bool gotNatronGuiImport = false;
-            bool isPyPlug = false;
             while (!ts.atEnd()) {
                 QString line = ts.readLine();
                 if (line.startsWith(QString::fromUtf8("import %1").arg(QLatin1String(NATRON_GUI_PYTHON_MODULE_NAME))) ||
                     line.startsWith(QString::fromUtf8("from %1 import").arg(QLatin1String(NATRON_GUI_PYTHON_MODULE_NAME)))) {
-                    gotNatronGuiImport = true;
+                    entry.importsNatronGui = true;
                 }
                 if (line.startsWith(QString::fromUtf8("# This file was automatically generated by Natron PyPlug exporter"))) {
-                    isPyPlug = true;
+                    entry.isPyPlug = true;
                 }
 
             }
-            if (appPTR->isBackground() && gotNatronGuiImport) {
-                continue;
-            }
-            if (!isPyPlug) {
-                continue;
-            }
         }
+        newManifest[plugin] = entry;
+        PyPlugManifestEntry& newEntry = newManifest[plugin];
 
-        unsigned int version;
-        bool isToolset;
-        bool gotInfos = NATRON_PYTHON_NAMESPACE::getGroupInfos(moduleName.toStdString(), &pluginID, &pluginLabel, &iconFilePath, &pluginGrouping, &pluginDescription, &pluginPath, &isToolset, &version);
+        if (appPTR->isBackground() && newEntry.importsNatronGui) {
+            continue;
+        }
+        if (!newEntry.isPyPlug) {
+            continue;
+        }
 
+        if (!newEntry.infosComputed) {
+            std::string pluginLabel, pluginID, pluginGrouping, iconFilePath, pluginDescription, pluginPath;
+            unsigned int version = 0;
+            bool isToolset = false;
+            newEntry.gotInfos = NATRON_PYTHON_NAMESPACE::getGroupInfos(moduleName.toStdString(), &pluginID, &pluginLabel, &iconFilePath, &pluginGrouping, &pluginDescription, &pluginPath, &isToolset, &version);
+            newEntry.infosComputed = true;
+            newEntry.pluginID = QString::fromUtf8( pluginID.c_str() );
+            newEntry.pluginLabel = QString::fromUtf8( pluginLabel.c_str() );
+            newEntry.iconFilePath = QString::fromUtf8( iconFilePath.c_str() );
+            newEntry.grouping = QString::fromUtf8( pluginGrouping.c_str() );
+            newEntry.description = QString::fromUtf8( pluginDescription.c_str() );
+            newEntry.isToolset = isToolset;
+            newEntry.version = version;
+            manifestChanged = true;
+        }
 
-        if (!gotInfos) {
+        if (!newEntry.gotInfos) {
             continue;
         }
 
 
+        std::string pluginGrouping = newEntry.grouping.toStdString();
         std::vector<std::string> grouping;
         boost::split(grouping, pluginGrouping, boost::is_any_of("/"));
 
-        PluginPtr p = Plugin::create(0, 0, pluginID, pluginLabel, version, 0, grouping);
+        PluginPtr p = Plugin::create(0, 0, newEntry.pluginID.toStdString(), newEntry.pluginLabel.toStdString(), newEntry.version, 0, grouping);
         p->setProperty<std::string>(kNatronPluginPropPyPlugScriptAbsoluteFilePath, plugin.toStdString());
-        p->setProperty<bool>(kNatronPluginPropPyPlugIsToolset, isToolset);
-        p->setProperty<std::string>(kNatronPluginPropDescription, pluginDescription);
-        p->setProperty<std::string>(kNatronPluginPropIconFilePath, iconFilePath);
+        p->setProperty<bool>(kNatronPluginPropPyPlugIsToolset, newEntry.isToolset);
+        p->setProperty<std::string>(kNatronPluginPropDescription, newEntry.description.toStdString());
+        p->setProperty<std::string>(kNatronPluginPropIconFilePath, newEntry.iconFilePath.toStdString());
         p->setProperty<bool>(kNatronPluginPropPyPlugIsPythonScript, true);
         p->setProperty<std::string>(kNatronPluginPropResourcesPath, modulePath.toStdString());
         //p->setProperty<bool>(kNatronPluginPropDescriptionIsMarkdown, false);
@@ -2206,6 +2507,14 @@ AppManager::loadPythonGroups()
         registerPlugin(p);
 
     }
+
+    // Scripts that were removed from the plug-in paths
+    if ( newManifest.size() != manifest.size() ) {
+        manifestChanged = true;
+    }
+    if (manifestChanged) {
+        writePyPlugsManifest(newManifest);
+    }
 } // AppManager::loadPythonGroups
 
 void
@@ -2505,6 +2814,12 @@ AppManager::getTileCache() const
     return _imp->tileCache;
 }
 
+QThreadPool*
+AppManager::getIOThreadPool() const
+{
+    return _imp->ioThreadPool.get();
+}
+
 void
 AppManager::deleteCacheEntriesInSeparateThread(const std::list<ImageStorageBasePtr> & entriesToDelete)
 {
@@ -2517,25 +2832,64 @@ AppManager::checkCachesMemory()
     _imp->storageDeleteThread->checkCachesMemory();
 }
 
+std::size_t
+AppManager::getPendingDeletionBytes() const
+{
+    return _imp->storageDeleteThread->getPendingDeletionBytes();
+}
+
+static QString
+printMemoryAccount(const MemoryAccount& account)
+{
+    QString ret = printAsRAM( account.getTotalBytes() );
+    for (int i = 0; i < eMemoryAccountTypeCount; ++i) {
+        std::size_t bytes = account.getBytes( (MemoryAccountTypeEnum)i );
+        if (bytes > 0) {
+            ret += QString::fromUtf8(" %1: %2").arg( QString::fromUtf8( MemoryAccount::getTypeLabel( (MemoryAccountTypeEnum)i ) ) ).arg( printAsRAM(bytes) );
+        }
+    }
+    ret += AppManager::tr(" (peak: %1)").arg( printAsRAM( account.getPeakTotalBytes() ) );
+
+    return ret;
+}
+
 void
 AppManager::printCacheMemoryStats() const
 {
     appPTR->clearErrorLog_mt_safe();
     std::map<std::string, CacheReportInfo> infos;
-    _imp->tileCache->getMemoryStats(&infos);
+    std::map<std::string, CacheQuotaGroupReportInfo> quotaGroupsInfos;
+    _imp->tileCache->getMemoryStats(&infos, &quotaGroupsInfos);
 
 
     QString reportStr;
     std::size_t totalBytes = 0;
     int totalNEntries = 0;
+    std::size_t totalCompressedBytes = 0;
+    U64 totalCompressedHits = 0, totalCompressedMisses = 0;
+    U64 totalRemoteHits = 0, totalRemoteMisses = 0, totalRemotePublished = 0;
+    U64 totalHits = 0, totalMisses = 0, totalPendingWaits = 0, totalEvictions = 0;
+    double totalPendingWaitTimeMS = 0;
     reportStr += QLatin1String("\n");
     if (!infos.empty()) {
         for (std::map<std::string, CacheReportInfo>::iterator it = infos.begin(); it!= infos.end(); ++it) {
-            if (it->second.nBytes == 0) {
+            U64 nLookUps = it->second.nHits + it->second.nMisses + it->second.nPendingWaits;
+            if (it->second.nBytes == 0 && it->second.nCompressedBytes == 0 && nLookUps == 0) {
                 continue;
             }
             totalBytes += it->second.nBytes;
             totalNEntries += it->second.nEntries;
+            totalCompressedBytes += it->second.nCompressedBytes;
+            totalCompressedHits += it->second.nCompressedTierHits;
+            totalCompressedMisses += it->second.nCompressedTierMisses;
+            totalRemoteHits += it->second.nRemoteTierHits;
+            totalRemoteMisses += it->second.nRemoteTierMisses;
+            totalRemotePublished += it->second.nRemoteTierPublishedTiles;
+            totalHits += it->second.nHits;
+            totalMisses += it->second.nMisses;
+            totalPendingWaits += it->second.nPendingWaits;
+            totalPendingWaitTimeMS += it->second.pendingWaitTimeMS;
+            totalEvictions += it->second.nEvictions;
             
             reportStr += QString::fromUtf8(it->first.c_str());
             reportStr += QLatin1String("--> ");
@@ -2547,6 +2901,15 @@ AppManager::printCacheMemoryStats() const
                 reportStr += tr(" Number of Cache Entries: ");
                 reportStr += QString::number(it->second.nEntries);
             }
+            if (it->second.nCompressedBytes > 0) {
+                reportStr += tr(" Compressed: %1 in %2 tiles").arg(printAsRAM(it->second.nCompressedBytes)).arg(it->second.nCompressedTiles);
+            }
+            if (nLookUps > 0) {
+                reportStr += tr(" Look-ups: %1 hits, %2 misses, %3 waits (%4 ms)").arg(QString::number(it->second.nHits)).arg(QString::number(it->second.nMisses)).arg(QString::number(it->second.nPendingWaits)).arg(it->second.pendingWaitTimeMS, 0, 'f', 0);
+            }
+            if (it->second.nEvictions > 0) {
+                reportStr += tr(" Evictions: %1").arg(QString::number(it->second.nEvictions));
+            }
             reportStr += QLatin1String("\n");
         }
         reportStr += QLatin1String("-------------------------------\n");
@@ -2555,6 +2918,99 @@ AppManager::printCacheMemoryStats() const
     reportStr += QLatin1String("--> ");
     reportStr += printAsRAM(totalBytes);
     reportStr += tr(" taken by %1 cache entries.").arg(QString::number(totalNEntries));
+    if (totalHits > 0 || totalMisses > 0 || totalPendingWaits > 0) {
+        U64 nLookUps = totalHits + totalMisses + totalPendingWaits;
+        reportStr += QLatin1String("\n");
+        reportStr += tr("Look-ups --> %1 (hit rate: %2%), %3 waits for pending entries (%4 ms), %5 evictions").arg(QString::number(nLookUps)).arg((double)totalHits / nLookUps * 100., 0, 'f', 1).arg(QString::number(totalPendingWaits)).arg(totalPendingWaitTimeMS, 0, 'f', 0).arg(QString::number(totalEvictions));
+    }
+    if (totalCompressedBytes > 0 || totalCompressedHits > 0 || totalCompressedMisses > 0) {
+        U64 nLookups = totalCompressedHits + totalCompressedMisses;
+        double hitRate = nLookups > 0 ? (double)totalCompressedHits / nLookups * 100. : 0.;
+        reportStr += QLatin1String("\n");
+        reportStr += tr("Compressed tier --> %1, %2 tiles restored (hit rate: %3%)").arg(printAsRAM(totalCompressedBytes)).arg(QString::number(totalCompressedHits)).arg(hitRate, 0, 'f', 1);
+    }
+    if (totalRemoteHits > 0 || totalRemoteMisses > 0 || totalRemotePublished > 0) {
+        U64 nLookups = totalRemoteHits + totalRemoteMisses;
+        double hitRate = nLookups > 0 ? (double)totalRemoteHits / nLookups * 100. : 0.;
+        reportStr += QLatin1String("\n");
+        reportStr += tr("Shared tier --> %1 tiles read (hit rate: %2%), %3 tiles published").arg(QString::number(totalRemoteHits)).arg(hitRate, 0, 'f', 1).arg(QString::number(totalRemotePublished));
+    }
+    std::size_t pendingDeletionBytes = getPendingDeletionBytes();
+    if (pendingDeletionBytes > 0) {
+        reportStr += QLatin1String("\n");
+        reportStr += tr("Pending deletion --> %1").arg(printAsRAM(pendingDeletionBytes));
+    }
+    std::size_t pluginMemoryPoolBytes = PluginMemory::getPoolIdleBytes();
+    if (pluginMemoryPoolBytes > 0) {
+        reportStr += QLatin1String("\n");
+        reportStr += tr("Plug-in memory pool --> %1").arg(printAsRAM(pluginMemoryPoolBytes));
+    }
+    if (!quotaGroupsInfos.empty()) {
+        reportStr += QLatin1String("\n-------------------------------\n");
+        for (std::map<std::string, CacheQuotaGroupReportInfo>::iterator it = quotaGroupsInfos.begin(); it != quotaGroupsInfos.end(); ++it) {
+            reportStr += QString::fromUtf8(it->first.c_str());
+            reportStr += QLatin1String("--> ");
+            reportStr += printAsRAM(it->second.nBytes);
+            if (it->second.quota > 0) {
+                if (it->second.type == (int)CacheBase::eCacheQuotaGroupViewer) {
+                    reportStr += tr(" (reserved: %1)").arg(printAsRAM(it->second.quota));
+                } else {
+                    reportStr += tr(" (quota: %1)").arg(printAsRAM(it->second.quota));
+                }
+            }
+            reportStr += QLatin1String("\n");
+        }
+    }
+
+    // The memory allocated outside of the cache by each node, the largest first
+    std::vector<std::pair<std::size_t, NodePtr> > nodesMemory;
+    const AppInstanceVec& instances = getAppInstances();
+    for (AppInstanceVec::const_iterator it = instances.begin(); it != instances.end(); ++it) {
+        ProjectPtr project = (*it)->getProject();
+        if (!project) {
+            continue;
+        }
+        NodesList nodes;
+        project->getNodes_recursive(nodes, false);
+        for (NodesList::const_iterator it2 = nodes.begin(); it2 != nodes.end(); ++it2) {
+            std::size_t bytes = (*it2)->getMemoryAccount()->getTotalBytes();
+            if (bytes > 0) {
+                nodesMemory.push_back( std::make_pair(bytes, *it2) );
+            }
+        }
+    }
+    if ( !nodesMemory.empty() ) {
+        std::sort( nodesMemory.begin(), nodesMemory.end(), std::greater<std::pair<std::size_t, NodePtr> >() );
+        reportStr += QLatin1String("\n-------------------------------\n");
+        reportStr += tr("Memory of the nodes outside of the cache:");
+        reportStr += QLatin1String("\n");
+        for (std::size_t i = 0; i < nodesMemory.size(); ++i) {
+            reportStr += QString::fromUtf8( nodesMemory[i].second->getFullyQualifiedName().c_str() );
+            reportStr += QLatin1String("--> ");
+            reportStr += printMemoryAccount( *nodesMemory[i].second->getMemoryAccount() );
+            reportStr += QLatin1String("\n");
+        }
+    }
+
+    std::list<TreeRenderPtr> renders = TreeRender::getActiveRenders();
+    bool hasRendersMemory = false;
+    for (std::list<TreeRenderPtr>::const_iterator it = renders.begin(); it != renders.end(); ++it) {
+        MemoryAccountPtr account = (*it)->getMemoryAccount();
+        EffectInstancePtr root = (*it)->getOriginalTreeRoot();
+        if ( !root || (account->getTotalBytes() == 0) ) {
+            continue;
+        }
+        if (!hasRendersMemory) {
+            reportStr += QLatin1String("\n-------------------------------\n");
+            reportStr += tr("Memory of the renders in progress:");
+            reportStr += QLatin1String("\n");
+            hasRendersMemory = true;
+        }
+        reportStr += tr("%1 at frame %2").arg( QString::fromUtf8( root->getNode()->getFullyQualifiedName().c_str() ) ).arg( (double)(*it)->getTime() );
+        reportStr += QLatin1String("--> ");
+        reportStr += printMemoryAccount(*account);
+        reportStr += QLatin1String("\n");
+    }
 
     appPTR->writeToErrorLog_mt_safe(tr("Cache Report"), QDateTime::currentDateTime(), reportStr);
 
@@ -2806,6 +3262,12 @@ AppManager::getOFXCurrentEffect_TLS() const
     return _imp->ofxHost->getCurrentEffect_TLS();
 }
 
+U64
+AppManager::getOFXCurrentActionID_TLS() const
+{
+    return _imp->ofxHost->getCurrentActionID_TLS();
+}
+
 void
 AppManager::setLastPythonAPICaller_TLS(const EffectInstancePtr& effect)
 {
@@ -3389,6 +3851,20 @@ AppManager::getGPUContextPool() const
     return _imp->renderingContextPool.get();
 }
 
+CudaDriverPtr
+AppManager::getCudaDriver() const
+{
+    QMutexLocker k(&_imp->cudaDriverMutex);
+    if (!_imp->cudaDriver) {
+        _imp->cudaDriver.reset( new CudaDriver() );
+        if ( _imp->cudaDriver->isValid() ) {
+            qDebug() << "CUDA rendering of OpenFX plug-ins uses" << _imp->cudaDriver->getDeviceName().c_str();
+        }
+    }
+
+    return _imp->cudaDriver;
+}
+
 void
 AppManager::refreshOpenGLRenderingFlagOnAllInstances()
 {
@@ -3743,6 +4219,21 @@ PythonGILLocker::~PythonGILLocker()
 //    PyGILState_Release(state);
 }
 
+PythonGILUnlocker::PythonGILUnlocker()
+    : _lockCount(0)
+{
+    if (appPTR) {
+        _lockCount = appPTR->releaseNatronGILFully();
+    }
+}
+
+PythonGILUnlocker::~PythonGILUnlocker()
+{
+    if (appPTR) {
+        appPTR->restoreNatronGIL(_lockCount);
+    }
+}
+
 static bool
 getGroupInfosInternal(const std::string& pythonModule,
                       std::string* pluginID,
@@ -184,6 +184,14 @@ public:
 
     CacheBasePtr getTileCache() const;
 
+    /**
+     * @brief Returns the thread pool running the render tasks of the effects which are I/O-bound
+     * (see EffectInstance::isIOBound()), so that a task waiting for a file to be read or written
+     * does not hold one of the threads of the global thread pool, which is sized after the number of cores.
+     * Its size is controlled by the "numIOThreads" setting.
+     **/
+    QThreadPool* getIOThreadPool() const;
+
     void deleteCacheEntriesInSeparateThread(const std::list<ImageStorageBasePtr> & entriesToDelete);
 
     /**
@@ -192,6 +200,11 @@ public:
      **/
     void checkCachesMemory();
 
+    /**
+     * @brief Returns the size in bytes of the image storages waiting to be deleted by deleteCacheEntriesInSeparateThread()
+     **/
+    std::size_t getPendingDeletionBytes() const;
+
     SettingsPtr getCurrentSettings() const WARN_UNUSED_RETURN;
     const KnobFactory & getKnobFactory() const WARN_UNUSED_RETURN;
 
@@ -273,6 +286,8 @@ public:
     
     OfxEffectInstancePtr getOFXCurrentEffect_TLS() const;
 
+    U64 getOFXCurrentActionID_TLS() const;
+
     /**
      * @brief Returns a list of IDs of all the plug-ins currently loaded.
      * Each ID can be passed to the AppInstance::createNode function to instantiate a node
@@ -340,6 +355,14 @@ public:
 
     void releaseNatronGIL();
 
+    /**
+     * @brief Releases the GIL if it is held by the calling thread, however many times it was taken.
+     * Returns the number of times it was taken, to pass to restoreNatronGIL().
+     **/
+    int releaseNatronGILFully();
+
+    void restoreNatronGIL(int lockCount);
+
 #ifdef __NATRON_WIN32__
     void registerUNCPath(const QString& path, const QChar& driveLetter);
     QString mapUNCPathToPathWithDriveLetter(const QString& uncPath) const;
@@ -358,6 +381,12 @@ public:
     const OfxHost* getOFXHost() const;
     GPUContextPool* getGPUContextPool() const;
 
+    /**
+     * @brief Returns the CUDA driver used by OpenFX plug-ins rendering with CUDA. It is loaded the first time this is called:
+     * check CudaDriver::isValid() to know whether a CUDA device is available.
+     **/
+    CudaDriverPtr getCudaDriver() const;
+
     const MultiThread* getMultiThreadHandler() const;
 
 
@@ -700,6 +729,22 @@ public:
     ~PythonGILLocker();
 };
 
+/**
+ * @brief Small helper class to use as RAII around a blocking engine call made from Python (render, project loading, node creation...):
+ * it releases the GIL held by the calling thread so that render threads may evaluate Python expressions and other threads may
+ * run Python code while the call blocks. The GIL is taken again when the object is destroyed.
+ * Python callbacks called meanwhile take the GIL with PythonGILLocker. No Python object may be used while the GIL is released.
+ **/
+class PythonGILUnlocker
+{
+    int _lockCount;
+
+public:
+    PythonGILUnlocker();
+
+    ~PythonGILUnlocker();
+};
+
 NATRON_NAMESPACE_EXIT;
 
 
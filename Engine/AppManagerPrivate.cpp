@@ -57,6 +57,7 @@
 #include "Engine/Format.h"
 #include "Engine/MultiThread.h"
 #include "Engine/Image.h"
+#include "Engine/MetricsServer.h"
 #include "Engine/OfxHost.h"
 #include "Engine/OSGLContext.h"
 #include "Engine/Settings.h"
@@ -89,6 +90,10 @@ AppManagerPrivate::AppManagerPrivate()
     , generalPurposeCache()
     , tileCache()
     , _backgroundIPC()
+    , renderServer(0)
+    , renderWorker(0)
+    , renderTraceFilePath()
+    , metricsServer()
     , _loaded(false)
     , _binaryPath()
     , errorLogMutex()
@@ -105,6 +110,7 @@ AppManagerPrivate::AppManagerPrivate()
     , breakpadAliveThread()
 #endif
     , natronPythonGIL(QMutex::Recursive)
+    , natronPythonGILLockCount()
     , glRequirements()
     , glHasTextureFloat(false)
     , hasInitializedOpenGLFunctions(false)
@@ -113,6 +119,8 @@ AppManagerPrivate::AppManagerPrivate()
     , glVersionMinor(0)
     , renderingContextPool()
     , openGLRenderers()
+    , cudaDriverMutex()
+    , cudaDriver()
 {
     setMaxCacheFiles();
 }
@@ -37,6 +37,8 @@ CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QString>
 #include <QtCore/QAtomicInt>
 #include <QtCore/QCoreApplication>
+#include <QtCore/QThreadPool>
+#include <QtCore/QThreadStorage>
 CLANG_DIAG_ON(uninitialized)
 
 
@@ -118,7 +120,13 @@ public:
 
     boost::scoped_ptr<StorageDeleterThread> storageDeleteThread; // thread used to kill cache entries without blocking a render thread
 
+    boost::scoped_ptr<QThreadPool> ioThreadPool; // threads running the I/O-bound render tasks, see getIOThreadPool()
+
     boost::scoped_ptr<ProcessInputChannel> _backgroundIPC; //< object used to communicate with the main app
+    RenderServer* renderServer; //< if running with --render-server, the server writing to its current client
+    RenderWorker* renderWorker; //< if running with --render-worker, the worker rendering the frames of the coordinator
+    std::string renderTraceFilePath; //< if running with --render-trace, the file where the render trace is written when exiting
+    boost::scoped_ptr<MetricsServer> metricsServer; //< if running with --metrics-port, the server of the engine metrics
 
     //if this app is background, see the ProcessInputChannel def
     bool _loaded; //< true when the first instance is completly loaded.
@@ -159,6 +167,9 @@ public:
 
     QMutex natronPythonGIL;
 
+    // Number of times the calling thread locked natronPythonGIL
+    QThreadStorage<int> natronPythonGILLockCount;
+
 #ifdef Q_OS_WIN32
     //On Windows only, track the UNC path we came across because the WIN32 API does not provide any function to map
     //from UNC path to path with drive letter.
@@ -193,6 +204,10 @@ public:
 
     boost::scoped_ptr<GPUContextPool> renderingContextPool;
     std::list<OpenGLRendererInfo> openGLRenderers;
+
+    // Protects cudaDriver, which is loaded on demand
+    mutable QMutex cudaDriverMutex;
+    mutable CudaDriverPtr cudaDriver;
     boost::scoped_ptr<QCoreApplication> _qApp;
 
 
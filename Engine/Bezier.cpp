@@ -24,13 +24,14 @@
 
 #include "Bezier.h"
 
-#include <algorithm> // min, max
+#include <algorithm> // min, max, equal
 #include <sstream>
 #include <locale>
 #include <limits>
 #include <cmath>
 #include <cassert>
 #include <stdexcept>
+#include <vector>
 
 #include <QtCore/QThread>
 #include <QCoreApplication>
@@ -94,24 +95,6 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 NATRON_NAMESPACE_ENTER;
 
-struct BezierShape
-{
-    BezierCPs points; //< the control points of the curve
-    BezierCPs featherPoints; //< the feather points, the number of feather points must equal the number of cp.
-
-    bool finished; //< when finished is true, the last point of the list is connected to the first point of the list.
-
-    BezierShape()
-    : points()
-    , featherPoints()
-    , finished(false)
-    {
-
-    }
-};
-
-typedef std::map<ViewIdx, BezierShape> PerViewBezierShapeMap;
-
 struct BezierPrivate
 {
     mutable QMutex itemMutex; //< protects points & featherPoits
@@ -1074,6 +1057,14 @@ bezierSegmentMeetsPoint(const BezierCP & first,
     p2 = Transform::matApply(transform, p2);
     p3 = Transform::matApply(transform, p3);
 
+    // The segment lies within the bounding box of its control polygon: skip the sampling of segments too far from the point
+    if ( ( x < std::min( std::min(p0.x, p1.x), std::min(p2.x, p3.x) ) - distance ) ||
+         ( x > std::max( std::max(p0.x, p1.x), std::max(p2.x, p3.x) ) + distance ) ||
+         ( y < std::min( std::min(p0.y, p1.y), std::min(p2.y, p3.y) ) - distance ) ||
+         ( y > std::max( std::max(p0.y, p1.y), std::max(p2.y, p3.y) ) + distance ) ) {
+        return false;
+    }
+
     ///Use the control polygon to approximate segment length
     double length = ( std::sqrt( (p1.x - p0.x) * (p1.x - p0.x) + (p1.y - p0.y) * (p1.y - p0.y) ) +
                       std::sqrt( (p2.x - p1.x) * (p2.x - p1.x) + (p2.y - p1.y) * (p2.y - p1.y) ) +
@@ -1197,6 +1188,23 @@ Bezier::copyItem(const KnobTableItem& other)
 
 } // copyItem
 
+void
+Bezier::getShapesSnapshot(PerViewBezierShapeMap* shapes) const
+{
+    QMutexLocker l(&_imp->itemMutex);
+    *shapes = _imp->viewShapes;
+}
+
+void
+Bezier::restoreShapesSnapshot(const PerViewBezierShapeMap& shapes)
+{
+    {
+        QMutexLocker l(&_imp->itemMutex);
+        _imp->viewShapes = shapes;
+    }
+    evaluateCurveModified();
+}
+
 BezierCPPtr
 Bezier::addControlPointInternal(double x, double y, TimeValue time, ViewIdx view)
 {
@@ -3220,44 +3228,37 @@ Bezier::controlPointsWithinRect(TimeValue time,
     if (!shape) {
         return ret;
     }
+    // The control points selected in the first pass, so that their feather point is not selected a second time
+    std::vector<bool> selectedControlPoints(shape->points.size(), false);
     if ( (mode == 0) || (mode == 1) ) {
-        for (BezierCPs::const_iterator it = shape->points.begin(); it != shape->points.end(); ++it, ++i) {
+        BezierCPs::const_iterator itF = shape->featherPoints.begin();
+        for (BezierCPs::const_iterator it = shape->points.begin(); it != shape->points.end(); ++it, ++itF, ++i) {
             double x, y;
             (*it)->getPositionAtTime(time,  &x, &y);
             if ( ( x >= (l - acceptance) ) && ( x <= (r + acceptance) ) && ( y >= (b - acceptance) ) && ( y <= (t - acceptance) ) ) {
                 std::pair<BezierCPPtr, BezierCPPtr > p;
                 p.first = *it;
-                BezierCPs::const_iterator itF = shape->featherPoints.begin();
-                std::advance(itF, i);
                 p.second = *itF;
                 ret.push_back(p);
+                selectedControlPoints[i] = true;
             }
         }
     }
     i = 0;
     if ( (mode == 0) || (mode == 2) ) {
-        for (BezierCPs::const_iterator it = shape->featherPoints.begin(); it != shape->featherPoints.end(); ++it, ++i) {
+        BezierCPs::const_iterator itCp = shape->points.begin();
+        for (BezierCPs::const_iterator it = shape->featherPoints.begin(); it != shape->featherPoints.end(); ++it, ++itCp, ++i) {
             double x, y;
             (*it)->getPositionAtTime(time,  &x, &y);
             if ( ( x >= (l - acceptance) ) && ( x <= (r + acceptance) ) && ( y >= (b - acceptance) ) && ( y <= (t - acceptance) ) ) {
-                std::pair<BezierCPPtr, BezierCPPtr > p;
-                p.first = *it;
-                BezierCPs::const_iterator itF = shape->points.begin();
-                std::advance(itF, i);
-                p.second = *itF;
-
                 ///avoid duplicates
-                bool found = false;
-                for (std::list< std::pair<BezierCPPtr, BezierCPPtr > >::iterator it2 = ret.begin();
-                     it2 != ret.end(); ++it2) {
-                    if (it2->first == *itF) {
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) {
-                    ret.push_back(p);
+                if (selectedControlPoints[i]) {
+                    continue;
                 }
+                std::pair<BezierCPPtr, BezierCPPtr > p;
+                p.first = *it;
+                p.second = *itCp;
+                ret.push_back(p);
             }
         }
     }
@@ -3721,30 +3722,21 @@ Bezier::appendToHash(const ComputeHashArgs& args, Hash64* hash)
 
         std::list<BezierCPPtr>::const_iterator fIt = fps.begin();
         for (std::list<BezierCPPtr>::const_iterator it = cps.begin(); it!=cps.end(); ++it, ++fIt) {
-            double x, y, lx, ly, rx, ry;
-            (*it)->getPositionAtTime(args.time, &x, &y);
-            (*it)->getLeftBezierPointAtTime(args.time, &lx, &ly);
-            (*it)->getRightBezierPointAtTime(args.time, &rx, &ry);
-            double fx, fy, flx, fly, frx, fry;
-            (*fIt)->getPositionAtTime(args.time, &fx, &fy);
-            (*fIt)->getLeftBezierPointAtTime(args.time, &flx, &fly);
-            (*fIt)->getRightBezierPointAtTime(args.time, &frx, &fry);
-
-            hash->append(x);
-            hash->append(y);
-            hash->append(lx);
-            hash->append(ly);
-            hash->append(rx);
-            hash->append(ry);
+            // x, y, left x, left y, right x, right y
+            double cp[6];
+            (*it)->getPositionAtTime(args.time, &cp[0], &cp[1]);
+            (*it)->getLeftBezierPointAtTime(args.time, &cp[2], &cp[3]);
+            (*it)->getRightBezierPointAtTime(args.time, &cp[4], &cp[5]);
+            double fp[6];
+            (*fIt)->getPositionAtTime(args.time, &fp[0], &fp[1]);
+            (*fIt)->getLeftBezierPointAtTime(args.time, &fp[2], &fp[3]);
+            (*fIt)->getRightBezierPointAtTime(args.time, &fp[4], &fp[5]);
+
+            hash->appendArray(cp, 6);
 
             // Only add feather if different
-            if (x != fx || y != fy || lx != flx || ly != fly || rx != frx || ry != fry) {
-                hash->append(fx);
-                hash->append(fy);
-                hash->append(flx);
-                hash->append(fly);
-                hash->append(frx);
-                hash->append(fry);
+            if ( !std::equal(cp, cp + 6, fp) ) {
+                hash->appendArray(fp, 6);
             }
         }
     }
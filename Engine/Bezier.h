@@ -28,6 +28,7 @@
 #include "Global/Macros.h"
 
 #include <list>
+#include <map>
 #include <set>
 #include <string>
 
@@ -72,6 +73,24 @@ struct ParametricPoint
     double x,y,t;
 };
 
+struct BezierShape
+{
+    BezierCPs points; //< the control points of the curve
+    BezierCPs featherPoints; //< the feather points, the number of feather points must equal the number of cp.
+
+    bool finished; //< when finished is true, the last point of the list is connected to the first point of the list.
+
+    BezierShape()
+    : points()
+    , featherPoints()
+    , finished(false)
+    {
+
+    }
+};
+
+typedef std::map<ViewIdx, BezierShape> PerViewBezierShapeMap;
+
 struct BezierPrivate;
 class Bezier
     : public RotoDrawableItem
@@ -149,6 +168,18 @@ public:
 
     void clearAllPoints();
 
+    /**
+     * @brief Returns the control points and feather points of all views. Unlike copyItem(), the points are not copied:
+     * the returned lists share the same points as the curve. This is meant for undo/redo of edits that only insert or remove
+     * points without modifying the others: the snapshot of a curve with thousands of points then costs only the lists.
+     **/
+    void getShapesSnapshot(PerViewBezierShapeMap* shapes) const;
+
+    /**
+     * @brief Restores the control points and feather points of all views from a snapshot returned by getShapesSnapshot().
+     **/
+    void restoreShapesSnapshot(const PerViewBezierShapeMap& shapes);
+
     /**
      * @brief Adds a new control point to the curve. A feather point will be added, at the same position.
      * If auto keying is enabled and this is the first point and there's no keyframe a new keyframe will be set at the current time.
@@ -60,6 +60,8 @@ class BufferedFrameContainer
 public:
 
     BufferedFrameContainer()
+    : renderTime(0)
+    , renderStageNotified(false)
     {
 
     }
@@ -71,6 +73,13 @@ public:
     // The list of frames that should be processed together by the scheduler
     std::list<BufferedFramePtr> frames;
 
+    // The time in seconds spent rendering the frames
+    double renderTime;
+
+    // True if the frames were encoded by the FrameEncodeQueue: the scheduler was already notified
+    // with OutputSchedulerThread::notifyFrameRenderStageFinished() when their input was rendered
+    bool renderStageNotified;
+
 
 };
 
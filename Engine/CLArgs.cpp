@@ -41,6 +41,7 @@
 #include "Global/StrUtils.h"
 
 #include "Engine/AppManager.h"
+#include "Engine/FrameStreamWriter.h"
 
 NATRON_NAMESPACE_ENTER;
 
@@ -61,12 +62,23 @@ public:
     bool isBackground;
     bool useDefaultSettings;
     bool clearCacheOnLaunch;
+    bool calibrate;
+    bool applyCalibration;
+    bool enableStartupTrace;
+    QString startupTraceFilePath;
+    QString renderTraceFilePath;
+    int metricsPort;
     QString ipcPipe;
+    QString renderServerName;
+    int renderCoordinatorPort;
+    QString renderWorkerCoordinator;
     int error;
     bool isInterpreterMode;
     std::list<std::pair<int, std::pair<int, int> > > frameRanges;
     bool rangeSet;
     bool enableRenderStats;
+    bool enableIncrementalRender;
+    bool resumeRender;
     bool isEmpty;
     mutable QString imageFilename;
     QString breakpadPipeFilePath;
@@ -88,12 +100,23 @@ public:
         , isBackground(false)
         , useDefaultSettings(false)
         , clearCacheOnLaunch(false)
+        , calibrate(false)
+        , applyCalibration(false)
+        , enableStartupTrace(false)
+        , startupTraceFilePath()
+        , renderTraceFilePath()
+        , metricsPort(0)
         , ipcPipe()
+        , renderServerName()
+        , renderCoordinatorPort(0)
+        , renderWorkerCoordinator()
         , error(0)
         , isInterpreterMode(false)
         , frameRanges()
         , rangeSet(false)
         , enableRenderStats(false)
+        , enableIncrementalRender(false)
+        , resumeRender(false)
         , isEmpty(true)
         , imageFilename()
         , breakpadPipeFilePath()
@@ -219,17 +242,28 @@ CLArgs::operator=(const CLArgs& other)
     _imp->isPythonScript = other._imp->isPythonScript;
     _imp->defaultOnProjectLoadedScript = other._imp->defaultOnProjectLoadedScript;
     _imp->clearCacheOnLaunch = other._imp->clearCacheOnLaunch;
+    _imp->calibrate = other._imp->calibrate;
+    _imp->applyCalibration = other._imp->applyCalibration;
+    _imp->enableStartupTrace = other._imp->enableStartupTrace;
+    _imp->startupTraceFilePath = other._imp->startupTraceFilePath;
+    _imp->renderTraceFilePath = other._imp->renderTraceFilePath;
+    _imp->metricsPort = other._imp->metricsPort;
     _imp->writers = other._imp->writers;
     _imp->readers = other._imp->readers;
     _imp->pythonCommands = other._imp->pythonCommands;
     _imp->settingCommands = other._imp->settingCommands;
     _imp->isBackground = other._imp->isBackground;
     _imp->ipcPipe = other._imp->ipcPipe;
+    _imp->renderServerName = other._imp->renderServerName;
+    _imp->renderCoordinatorPort = other._imp->renderCoordinatorPort;
+    _imp->renderWorkerCoordinator = other._imp->renderWorkerCoordinator;
     _imp->error = other._imp->error;
     _imp->isInterpreterMode = other._imp->isInterpreterMode;
     _imp->frameRanges = other._imp->frameRanges;
     _imp->rangeSet = other._imp->rangeSet;
     _imp->enableRenderStats = other._imp->enableRenderStats;
+    _imp->enableIncrementalRender = other._imp->enableIncrementalRender;
+    _imp->resumeRender = other._imp->resumeRender;
     _imp->isEmpty = other._imp->isEmpty;
     _imp->imageFilename = other._imp->imageFilename;
     _imp->exportDocsPath = other._imp->exportDocsPath;
@@ -283,6 +317,15 @@ CLArgs::printUsage(const std::string& programName)
         "    init.py script is loaded.\n"
         "  --clear-cache\n"
         "    Clears the cache on startup.\n"
+        "  --calibrate [apply]\n"
+        "    Measures this machine for a few seconds and prints the recommended number\n"
+        "    of render threads, cache tile size and compressed cache size, then exits.\n"
+        "    With apply, the recommended settings are also saved to the preferences.\n"
+        "    Other applications should be idle during the measures.\n"
+        "  --startup-trace [<json file path>]\n"
+        "    Prints the time and memory spent in each phase of the startup.\n"
+        "    If a .json file path is given, the trace is also written to it in the\n"
+        "    Chrome trace format, which can be opened with chrome://tracing.\n"
         "  --no-settings\n"
         "    When passed on the command-line, the %1 settings will not be restored\n"
         "    from the preferences file on disk so that %1 uses the default ones.\n"
@@ -321,6 +364,20 @@ CLArgs::printUsage(const std::string& programName)
         "    Note that if specified, the frame range is the same for all Write nodes\n"
         "    to render.\n"
         "    You may only specify absolute file paths to the writer optional filename.\n"
+        "    Instead of a filename, stream:<format>[:<path>] streams the frames in input\n"
+        "    of the Write node in order to the standard output (if path is - or is not\n"
+        "    given) or to a named pipe, so that an external encoder consumes them, e.g:\n"
+        "      %3 project.%2 -w Write1 stream:y4m | ffmpeg -i - out.mp4\n"
+        "    The frames have the project format and frame rate and are converted to\n"
+        "    8-bit sRGB. The format is one of:\n"
+        "      y4m: a YUV4MPEG2 stream (4:4:4, Rec.709)\n"
+        "      rgb: raw packed RGB frames (rgb24), top row first\n"
+        "      yuv: raw planar 4:4:4 Rec.709 frames (yuv444p), top row first\n"
+        "    When streaming to the standard output, the messages printed by the render\n"
+        "    go to the standard error.\n"
+        "    A path of shm:<name> publishes the frames to a ring buffer in the shared\n"
+        "    memory segment <name> instead, so that an external player such as a review\n"
+        "    tool displays them live. See FrameStreamWriter.h for its layout.\n"
         "  -i [ --reader ] <reader node script name> <filename>\n"
         "     Specify the input file/sequence/video to load for the given Reader node.\n"
         "     If the specified reader node cannot be found, the process will abort."
@@ -332,14 +389,56 @@ CLArgs::printUsage(const std::string& programName)
         "    executing the callbacks onProjectLoaded and onProjectCreated.\n"
         "    The rules on the execution of Python scripts (see below) also apply to\n"
         "    this script.\n"
+        "  --render-server <server name>\n"
+        "    Instead of rendering a single project, stay resident and render the jobs\n"
+        "    sent to the local socket named <server name>. Plug-ins stay loaded and\n"
+        "    the project is only loaded again when it changes. Each job is a line\n"
+        "    made of --render_job followed by the tab-separated project file path,\n"
+        "    Write node name, first frame, last frame and frame step. Only the\n"
+        "    project file path is mandatory. Send --quit to stop the server.\n"
+        "  --render-coordinator <port>\n"
+        "    Instead of rendering the frames of the project, distribute them to the\n"
+        "    render workers which connect to this port. Each worker is sent the next\n"
+        "    frame to render as soon as it is done with the previous one and the\n"
+        "    frames that fail are retried on another worker. The project file path\n"
+        "    must be valid on all the hosts. Write nodes cannot be created or have\n"
+        "    their output file changed from the command line in this mode.\n"
+        "  --render-worker <host>:<port>\n"
+        "    Render the frames distributed by the render coordinator listening on\n"
+        "    <host>:<port> until it has no frame left.\n"
         "  -s [ --render-stats]\n"
         "     Enable render statistics that will be produced for\n"
         "     each frame in form of a file located next to the image produced by\n"
         "     the Writer node, with the same name and a -stats.txt extension. The\n"
-        "     breakdown contains informations about each nodes, render times etc...\n"
+        "     breakdown contains informations about each nodes, render times, time\n"
+        "     spent in each action, cache hits, memory allocated, threads used etc...\n"
         "     This option is useful for debugging purposes or to control that a render\n"
         "     is working correctly.\n"
-        "     **Please note** that it does not work when writing video files."
+        "     **Please note** that it does not work when writing video files.\n"
+        "  --incremental\n"
+        "     Only render the frames whose result changed since the previous render.\n"
+        "     The hash of each rendered frame is stored in a file next to the image\n"
+        "     produced by the Writer node, with the same name and a -hash.txt\n"
+        "     extension. A frame whose image exists and whose hash did not change is\n"
+        "     skipped. Changes made to the files read by the project are not detected.\n"
+        "     **Please note** that it does not work when writing video files.\n"
+        "  --resume\n"
+        "     Resume the render of a previous process which was interrupted (e.g: a\n"
+        "     preempted or crashed render): the frames it completed are skipped.\n"
+        "     The frames written by each Writer node are recorded in a file named\n"
+        "     after its output files with a -checkpoint.txt extension. A frame is\n"
+        "     skipped if it is in this file and its image has the size recorded.\n"
+        "     **Please note** that it does not work when writing video files.\n"
+        "  --render-trace <json file path>\n"
+        "    Records the timeline of the renders on each thread: request passes, render\n"
+        "    tasks, plug-in actions, cache waits and Python expressions. It is written\n"
+        "    to the given file in the Chrome trace format when exiting, which can be\n"
+        "    opened with chrome://tracing or https://ui.perfetto.dev.\n"
+        "  --metrics-port <port>\n"
+        "    Serves live metrics of the engine at http://<host>:<port>/metrics in the\n"
+        "    Prometheus text format, to monitor the renders of a render farm: frames\n"
+        "    rendered, frame render times, render threads, queue depths, cache usage\n"
+        "    and hits, and memory.\n"
         "Sample uses:\n"
         "  %1 /Users/Me/MyNatronProjects/MyProject.ntp\n"
         "  %1 -b -w MyWriter /Users/Me/MyNatronProjects/MyProject.ntp\n"
@@ -448,6 +547,42 @@ CLArgs::isCacheClearRequestedOnLaunch() const
     return _imp->clearCacheOnLaunch;
 }
 
+bool
+CLArgs::isCalibrationRequested() const
+{
+    return _imp->calibrate;
+}
+
+bool
+CLArgs::isCalibrationApplyRequested() const
+{
+    return _imp->applyCalibration;
+}
+
+bool
+CLArgs::isStartupTraceEnabled() const
+{
+    return _imp->enableStartupTrace;
+}
+
+const QString&
+CLArgs::getStartupTraceFilePath() const
+{
+    return _imp->startupTraceFilePath;
+}
+
+const QString&
+CLArgs::getRenderTraceFilePath() const
+{
+    return _imp->renderTraceFilePath;
+}
+
+int
+CLArgs::getMetricsPort() const
+{
+    return _imp->metricsPort;
+}
+
 bool
 CLArgs::isBackgroundMode() const
 {
@@ -505,12 +640,42 @@ CLArgs::getIPCPipeName() const
     return _imp->ipcPipe;
 }
 
+const QString&
+CLArgs::getRenderServerName() const
+{
+    return _imp->renderServerName;
+}
+
+int
+CLArgs::getRenderCoordinatorPort() const
+{
+    return _imp->renderCoordinatorPort;
+}
+
+const QString&
+CLArgs::getRenderWorkerCoordinator() const
+{
+    return _imp->renderWorkerCoordinator;
+}
+
 bool
 CLArgs::areRenderStatsEnabled() const
 {
     return _imp->enableRenderStats;
 }
 
+bool
+CLArgs::isIncrementalRenderEnabled() const
+{
+    return _imp->enableIncrementalRender;
+}
+
+bool
+CLArgs::isResumeRenderEnabled() const
+{
+    return _imp->resumeRender;
+}
+
 bool
 CLArgs::isPythonScript() const
 {
@@ -757,6 +922,32 @@ CLArgsPrivate::parse()
         }
     }
 
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("calibrate"), QString() );
+        if ( it != args.end() ) {
+            calibrate = true;
+            isBackground = true;
+            it = args.erase(it);
+            if ( ( it != args.end() ) && ( *it == QString::fromUtf8("apply") ) ) {
+                applyCalibration = true;
+                args.erase(it);
+            }
+        }
+    }
+
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("startup-trace"), QString() );
+        if ( it != args.end() ) {
+            enableStartupTrace = true;
+            it = args.erase(it);
+            // The file path is optional: it must be a .json file so it is not mistaken for the project
+            if ( ( it != args.end() ) && it->endsWith(QString::fromUtf8(".json"), Qt::CaseInsensitive) ) {
+                startupTraceFilePath = *it;
+                args.erase(it);
+            }
+        }
+    }
+
     {
         QStringList::iterator it = hasToken( QString::fromUtf8("no-settings"), QString() );
         if ( it != args.end() ) {
@@ -784,6 +975,40 @@ CLArgsPrivate::parse()
         }
     }
 
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("render-trace"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+            if ( ( it != args.end() ) && it->endsWith(QString::fromUtf8(".json"), Qt::CaseInsensitive) ) {
+                renderTraceFilePath = *it;
+                args.erase(it);
+            } else {
+                std::cout << tr("You must specify the .json file where to write the render trace").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+        }
+    }
+
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("metrics-port"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+            bool ok = false;
+            if ( it != args.end() ) {
+                metricsPort = it->toInt(&ok);
+            }
+            if ( !ok || (metricsPort <= 0) || (metricsPort > 65535) ) {
+                std::cout << tr("You must specify a valid port number for the metrics server").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+            args.erase(it);
+        }
+    }
+
     {
         QStringList::iterator it = hasToken( QString::fromUtf8("render-stats"), QString::fromUtf8("s") );
         if ( it != args.end() ) {
@@ -792,6 +1017,22 @@ CLArgsPrivate::parse()
         }
     }
 
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("incremental"), QString() );
+        if ( it != args.end() ) {
+            enableIncrementalRender = true;
+            args.erase(it);
+        }
+    }
+
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("resume"), QString() );
+        if ( it != args.end() ) {
+            resumeRender = true;
+            args.erase(it);
+        }
+    }
+
     {
         QStringList::iterator it = hasToken( QString::fromUtf8(NATRON_BREAKPAD_PROCESS_PID), QString() );
         if ( it != args.end() ) {
@@ -904,6 +1145,59 @@ CLArgsPrivate::parse()
         }
     }
 
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("render-server"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+            if ( it != args.end() ) {
+                renderServerName = *it;
+                args.erase(it);
+                isBackground = true;
+            } else {
+                std::cout << tr("You must specify the name of the render server").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+        }
+    }
+
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("render-coordinator"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+            bool ok = false;
+            if ( it != args.end() ) {
+                renderCoordinatorPort = it->toInt(&ok);
+            }
+            if ( !ok || (renderCoordinatorPort <= 0) || (renderCoordinatorPort > 65535) ) {
+                std::cout << tr("You must specify a valid port number for the render coordinator").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+            args.erase(it);
+            isBackground = true;
+        }
+    }
+
+    {
+        QStringList::iterator it = hasToken( QString::fromUtf8("render-worker"), QString() );
+        if ( it != args.end() ) {
+            it = args.erase(it);
+            if ( ( it != args.end() ) && it->contains( QLatin1Char(':') ) ) {
+                renderWorkerCoordinator = *it;
+                args.erase(it);
+                isBackground = true;
+            } else {
+                std::cout << tr("You must specify the address of the render coordinator as <host>:<port>").toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+        }
+    }
+
     {
         QStringList::iterator it = hasToken( QString::fromUtf8("onload"), QString::fromUtf8("l") );
         if ( it != args.end() ) {
@@ -1087,6 +1381,28 @@ CLArgsPrivate::parse()
             }
         }
 
+        // Stream the frames instead of writing them: stream:<format>[:<path>]
+        if ( w.filename.startsWith( QString::fromUtf8("stream:") ) ) {
+            QString streamSpec = w.filename.mid(7);
+            int sep = streamSpec.indexOf( QChar::fromLatin1(':') );
+            w.streamFormat = sep == -1 ? streamSpec : streamSpec.left(sep);
+            w.streamPath = sep == -1 ? QString() : streamSpec.mid(sep + 1);
+            if ( w.streamPath.isEmpty() ) {
+                w.streamPath = QString::fromUtf8("-");
+            }
+#ifdef __NATRON_UNIX__
+            w.streamPath = AppManager::qt_tildeExpansion(w.streamPath);
+#endif
+            FrameStreamWriter::FrameStreamFormatEnum format;
+            if ( !FrameStreamWriter::getFormatFromString(w.streamFormat.toStdString(), &format) ) {
+                std::cout << tr("Invalid stream format %1: it must be y4m, rgb or yuv").arg(w.streamFormat).toStdString() << std::endl;
+                error = 1;
+
+                return;
+            }
+            w.filename.clear();
+        }
+
         writers.push_back(w);
         if ( nextNext != args.end() ) {
             ++nextNext;
@@ -57,8 +57,13 @@ public:
         QString filename;
         bool mustCreate;
 
+        // If the filename is stream:<format>[:<path>], the frames are streamed to path (or the standard output)
+        // in the given format instead of being written by the writer, see FrameStreamWriter
+        QString streamFormat;
+        QString streamPath;
+
         WriterArg()
-            : name(), filename(), mustCreate(false)
+            : name(), filename(), mustCreate(false), streamFormat(), streamPath()
         {
         }
     };
@@ -112,6 +117,31 @@ public:
 
     bool isCacheClearRequestedOnLaunch() const;
 
+    /*
+     * @brief With --calibrate, the process runs EngineCalibration, prints its report and exits.
+     * With --calibrate apply, the recommended settings are also saved.
+     */
+    bool isCalibrationRequested() const;
+    bool isCalibrationApplyRequested() const;
+
+    /*
+     * @brief Should the startup trace be printed, see StartupTrace. If the returned file path
+     * is not empty, it is also exported as a Chrome trace to this file.
+     */
+    bool isStartupTraceEnabled() const;
+    const QString& getStartupTraceFilePath() const;
+
+    /*
+     * @brief If not empty, the render trace is recorded from startup and written to this file
+     * when exiting, see RenderTrace.
+     */
+    const QString& getRenderTraceFilePath() const;
+
+    /*
+     * @brief If not 0, the metrics of the engine are served on this port, see MetricsServer.
+     */
+    int getMetricsPort() const;
+
     /*
      * @brief Has a Natron project or Python script been passed to the command line ?
      */
@@ -126,10 +156,32 @@ public:
     const QString& getDefaultOnProjectLoadedScript() const;
     const QString& getIPCPipeName() const;
 
+    /*
+     * @brief If not empty, the background process stays resident and renders the jobs sent to
+     * the local server of that name, see RenderServer.
+     */
+    const QString& getRenderServerName() const;
+
+    /*
+     * @brief If not 0, the frames of the project are not rendered by this process but distributed
+     * to the render workers connecting to this port, see RenderCoordinator.
+     */
+    int getRenderCoordinatorPort() const;
+
+    /*
+     * @brief If not empty, the <host>:<port> address of the render coordinator for which this process
+     * renders frames, see RenderWorker.
+     */
+    const QString& getRenderWorkerCoordinator() const;
+
     bool isPythonScript() const;
 
     bool areRenderStatsEnabled() const;
 
+    bool isIncrementalRenderEnabled() const;
+
+    bool isResumeRenderEnabled() const;
+
     const QString& getBreakpadProcessExecutableFilePath() const;
 
     qint64 getBreakpadProcessPID() const;
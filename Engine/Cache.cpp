@@ -25,24 +25,38 @@
 #include "Cache.h"
 
 #include <cassert>
+#include <cstring>
 #include <stdexcept>
 #include <set>
 #include <list>
+#include <map>
+#include <sstream>
+#include <iomanip>
 
 #ifdef __NATRON_UNIX__
 #include <time.h>
 #endif
 
 #include <QMutex>
+#include <QAtomicInt>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QTemporaryFile>
+#include <QThreadPool>
 #include <QWaitCondition>
 #include <QDebug>
 #include <QReadWriteLock>
+#include <QThread>
 
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
 GCC_DIAG_OFF(unused-parameter)
 #include <boost/unordered_set.hpp>
 #include <boost/format.hpp>
+#include <boost/tuple/tuple.hpp>
 #include <boost/interprocess/containers/vector.hpp>
 #include <boost/interprocess/containers/map.hpp>
 
@@ -65,6 +79,7 @@ GCC_DIAG_OFF(unused-parameter)
 #include <boost/thread/shared_mutex.hpp> // local r-w mutex
 #include <boost/thread/locks.hpp>
 #include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp> // timed_wait
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 GCC_DIAG_ON(unused-parameter)
 
@@ -76,13 +91,14 @@ GCC_DIAG_ON(unused-parameter)
 #include "Global/QtCompat.h"
 
 #include "Engine/AppManager.h"
+#include "Engine/Hash64.h"
 #include "Engine/StorageDeleterThread.h"
 #include "Global/FStreamsSupport.h"
 #include "Engine/MemoryFile.h"
 #include "Engine/MemoryInfo.h"
 #include "Engine/Settings.h"
 #include "Engine/StandardPaths.h"
-#include "Engine/RamBuffer.h"
+#include "Engine/ProcessLocalBuffer.h"
 #include "Engine/Timer.h"
 #include "Engine/ThreadPool.h"
 
@@ -92,14 +108,28 @@ GCC_DIAG_ON(unused-parameter)
 #define NATRON_CACHE_BUCKETS_N_DIGITS 2
 #define NATRON_CACHE_BUCKETS_COUNT 256
 
-// Grow the bucket ToC shared memory by 512Kb at once
+// Grow the bucket ToC shared memory by at least 512Kb at once
 #define NATRON_CACHE_BUCKET_TOC_FILE_GROW_N_BYTES 524288 // = 512 * 1024
 
+// The bucket ToC grows geometrically: it is at least doubled, but not by more than this amount at once
+#define NATRON_CACHE_BUCKET_TOC_FILE_MAX_GROW_N_BYTES 16777216 // = 16 * 1024 * 1024
+
+// The estimated size taken in the ToC by each tile of an entry (its indices and a share of the entry header), used
+// to size the ToC of a bucket from the maximum size of the cache when it is first created
+#define NATRON_CACHE_BUCKET_TOC_BYTES_PER_TILE 64
+
+// The ToC of a bucket is not created larger than this, whatever the maximum size of the cache
+#define NATRON_CACHE_BUCKET_TOC_FILE_MAX_INITIAL_N_BYTES 4194304 // = 4 * 1024 * 1024
+
 // Used to prevent loading older caches when we change the serialization scheme
-#define NATRON_CACHE_SERIALIZATION_VERSION 5
+#define NATRON_CACHE_SERIALIZATION_VERSION 6
+
+// If we change the MemorySegmentEntryHeader struct or the Hash64 function which computes the entries keys,
+// we must increment this version so we do not attempt to read an invalid structure.
+#define NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION 7
 
-// If we change the MemorySegmentEntryHeader struct, we must increment this version so we do not attempt to read an invalid structure.
-#define NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION 1
+// The name of the journal file in the cache directory, see CacheJournalData
+#define NATRON_CACHE_JOURNAL_FILE_NAME "Journal"
 
 
 // After this amount of milliseconds, if a thread is not able to access a mutex, the cache is assumed to be inconsistent
@@ -107,13 +137,39 @@ GCC_DIAG_ON(unused-parameter)
 #define NATRON_CACHE_INTERPROCESS_MUTEX_TIMEOUT_MS 10000
 #endif
 
-// Each file is 1GB
-// Note that we don't split the free tiles list across each buckets, otherwise 1 bucket could have only 256 tiles available per 1GiB of memory.
-// But a single HD image could already take up a full bucket worth of tiles, hence we group the free tiles list of all buckets into the free tiles list
-// of the first bucket.
-#define NATRON_NUM_TILES_PER_BUCKET_FILE 256
-#define NATRON_NUM_TILES_PER_FILE (NATRON_NUM_TILES_PER_BUCKET_FILE * NATRON_CACHE_BUCKETS_COUNT)
-#define NATRON_TILE_STORAGE_FILE_SIZE (NATRON_TILE_SIZE_BYTES * NATRON_NUM_TILES_PER_FILE)
+// Each file is 1GB, whatever the tile size: the number of tiles per file depends on the tileSizePo2
+// the cache was created with (see CachePrivate::nTilesPerBucketFile).
+// Each bucket owns the free tiles list of a contiguous range of nTilesPerBucketFile tiles of each file.
+#define NATRON_TILE_STORAGE_FILE_SIZE ((std::size_t)1 << 30)
+
+// The IO thread of a persistent cache flushes the tiles written at least at this interval
+#define NATRON_CACHE_FLUSH_INTERVAL_MS 5000
+
+// When flushing tiles, ranges of dirty tiles separated by less than this amount of bytes are merged in a single flush:
+// only dirty pages are written so this does not write more data but it issues less system calls.
+#define NATRON_CACHE_FLUSH_MAX_GAP_BYTES 1048576 // = 1024 * 1024
+
+// With the eCacheEvictionPolicyCost policy, the entry to evict in a bucket is the one with the lowest
+// eviction priority amongst this number of least recently used entries
+#define NATRON_CACHE_EVICTION_COST_N_CANDIDATES 16
+
+// evictLRUEntries() starts evicting when the cache size exceeds this fraction of its maximum size...
+#define NATRON_CACHE_EVICTION_HIGH_WATERMARK 0.95
+
+// ...and then evicts until it is below this fraction, so that the entries are evicted in batches ahead of the limit
+// rather than a few at a time for each insertion once the limit is reached.
+#define NATRON_CACHE_EVICTION_LOW_WATERMARK 0.85
+
+// The tiles files of the remote tier start with this header, see CachePrivate::getRemoteTileFilePath()
+#define NATRON_REMOTE_TILE_FILE_MAGIC 0x4e52544c // "NRTL"
+#define NATRON_REMOTE_TILE_FILE_VERSION 1
+
+// Number of threads writing tiles to the remote tier. They mostly wait for the shared storage.
+#define NATRON_REMOTE_TIER_N_WRITER_THREADS 2
+
+// When more than this amount of bytes is waiting to be written to the remote tier, new tiles are not published:
+// the renders must not pile up memory faster than the shared storage can absorb it.
+#define NATRON_REMOTE_TIER_MAX_PENDING_BYTES ((std::size_t)256 * 1024 * 1024)
 
 //#define CACHE_TRACE_ENTRY_ACCESS
 //#define CACHE_TRACE_TIMEOUTS
@@ -169,6 +225,10 @@ NATRON_NAMESPACE_ENTER;
 // In a situation of abandonnement, we cannot assume any state on the cache, thus we wipe it and recreate it.
 // Since we don't hold any information as precious as a database would, we are safe to do so anyway.
 //
+// A process can also crash whilst no other process is active. The next process to open the cache then only checks
+// the buckets that the journal (see CacheJournalData) flags as not detached cleanly, when they are first accessed:
+// a bucket whose data structures were being modified (see BucketModification_RAII) is wiped alone.
+//
 // Algorithm to detect and recover from abandonnement in a inter process cache:
 //
 // In addition to the 256 interprocess mutex, we add a global file lock to monitor process access to the cache.
@@ -240,7 +300,6 @@ NATRON_NAMESPACE_ENTER;
 
 
 // A process local storage holder
-typedef RamBuffer<char> ProcessLocalBuffer;
 typedef boost::shared_ptr<ProcessLocalBuffer> ProcessLocalBufferPtr;
 
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
@@ -310,6 +369,14 @@ public:
         catch(...){}
     }
 
+    // Try to take the lock without blocking. Returns true if the lock was taken.
+    bool try_lock()
+    {
+        assert(mp_mutex && !m_locked);
+        m_locked = (mp_mutex->*try_lock_func)();
+        return m_locked;
+    }
+
     //!Effects: If mutex() == 0 or if already locked, throws a lock_exception()
     //!   exception. Calls lock() on the referenced mutex.
     //!Postconditions: owns() == true.
@@ -318,7 +385,7 @@ public:
     void lock()
     {
         assert(mp_mutex && !m_locked);
-        mp_mutex->lock();
+        (mp_mutex->*lock_func)();
         m_locked = true;
     }
 
@@ -335,7 +402,7 @@ public:
     void unlock()
     {
         assert(mp_mutex && m_locked);
-        mp_mutex->unlock();
+        (mp_mutex->*unlock_func)();
         m_locked = false;
     }
 
@@ -592,19 +659,19 @@ inline
 void disconnectLinkedListNode(const LRUListNodePtr& node)
 {
     // Remove from the LRU linked list:
+    LRUListNodePtr prev = node->prev;
+    LRUListNodePtr next = node->next;
 
     // Make the previous item successor point to this item successor
-    if (node->prev) {
-        node->prev->next = node->next;
+    if (prev) {
+        prev->next = next;
     }
 
-    node->prev = 0;
-
-
     // Make the next item predecessor point to this item predecessor
-    if (node->next) {
-        node->next->prev = node->prev;
+    if (next) {
+        next->prev = prev;
     }
+    node->prev = 0;
     node->next = 0;
 }
 
@@ -660,15 +727,41 @@ struct MemorySegmentEntryHeaderBase
     // The corresponding node in the LRU list
     LRUListNode lruNode;
 
+    // The hash of the holder that produced this entry, see CacheEntryKeyBase::getHolderHash()
+    U64 holderHash;
+
+    // The time in seconds it took to compute this entry, see CacheBase::addEntryCost
+    // and the eviction priority of the entry, see CacheBucket::updateEvictionPriority.
+    // Protected by lruListMutex
+    double cost;
+    double evictionPriority;
+
+    // The quota groups this entry is accounted to (0 if none), see CachePrivate::registerQuotaGroup()
+    U64 projectQuotaGroup, nodeQuotaGroup;
+
+    // True if the entry is accounted to the viewer outputs reserved share, see CacheBase::eCacheQuotaGroupViewer
+    bool isViewerOutput;
+
     // List of tile indices allocated for this entry
     ExternalSegmentTypeULongLongList tileIndices;
 
+    // For each tile in tileIndices, in the same order, the local index passed in tilesToAlloc
+    // to retrieveAndLockTiles(). This identifies the tile within the entry, see the compressed tier.
+    ExternalSegmentTypeULongLongList tileLocalIndices;
+
     MemorySegmentEntryHeaderBase(const void_allocator& allocator)
     : size(0)
     , status(eEntryStatusNull)
     , computeThreadMagic(0)
     , lruNode()
+    , holderHash(0)
+    , cost(0)
+    , evictionPriority(0)
+    , projectQuotaGroup(0)
+    , nodeQuotaGroup(0)
+    , isViewerOutput(false)
     , tileIndices(allocator)
+    , tileLocalIndices(allocator)
     {}
 
 };
@@ -718,6 +811,54 @@ struct MemorySegmentEntryHeader<false> : public MemorySegmentEntryHeaderBase
 
 };
 
+// Identifies a tile in the compressed tier: <entry hash, tile local index>
+typedef std::pair<U64, U64> CompressedTileKey;
+
+/**
+ * @brief A copy of a tile evicted from the tile storage, before it gets compressed
+ **/
+struct EvictedTile
+{
+    CompressedTileKey key;
+    std::string pluginID;
+    QByteArray data;
+};
+
+/**
+ * @brief Restricts the entries that may be evicted by CachePrivate::evictOneEntryPerBucket()
+ **/
+struct CacheEvictionFilter
+{
+    // If not 0, only the entries accounted to this quota group may be evicted
+    U64 quotaGroup;
+
+    // If true, the viewer outputs may not be evicted
+    bool protectViewerOutputs;
+
+    CacheEvictionFilter()
+    : quotaGroup(0)
+    , protectViewerOutputs(false)
+    {
+
+    }
+
+    bool isEmpty() const
+    {
+        return !quotaGroup && !protectViewerOutputs;
+    }
+
+    bool acceptEntry(const MemorySegmentEntryHeaderBase& entry) const
+    {
+        if (protectViewerOutputs && entry.isViewerOutput) {
+            return false;
+        }
+        if (quotaGroup && entry.projectQuotaGroup != quotaGroup && entry.nodeQuotaGroup != quotaGroup) {
+            return false;
+        }
+        return true;
+    }
+};
+
 /**
  * @brief An enum indicating the state of the bucket. This enables corrupted cache detection in case
  * NATRON_CACHE_INTERPROCESS_ROBUST is not defined. If NATRON_CACHE_INTERPROCESS_ROBUST is defined,
@@ -769,16 +910,32 @@ struct CacheBucketIPCData
     // Protected by lruListMutex
     LRUListNodePtr lruListFront, lruListBack;
 
+    // The GreedyDual-Size inflation value: the eviction priority of the last entry evicted with the
+    // eCacheEvictionPolicyCost policy. This makes entries that were not accessed for a long time
+    // eventually evicted, even if they are expensive.
+    // Protected by lruListMutex
+    double evictionInflation;
+
     // A version indicator for the serialization. If the cache version doesn't correspond
     // to NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION, we wipe it.
     // Never changes, thread-safe
     unsigned int version;
 
+    // The size in bytes of a tile in the tile storage referenced by indices in this bucket.
+    // If it doesn't correspond to the tile size of the cache, we wipe it.
+    // Never changes, thread-safe
+    U64 tileSizeBytes;
+
     // What operation is done on the bucket. When obtaining a write lock on the bucket,
     // if the state is other than eBucketStateOk we detected an inconsistency.
     // The bucket state is protected by the bucketMutex
     BucketStateEnum bucketState;
 
+    // The number of modifications of the bucket data structures currently in progress, see BucketModification_RAII.
+    // This is not 0 when a bucket is attached only if a process crashed whilst modifying the bucket.
+    // Protected by the bucketMutex, or by the lruListMutex with the bucketMutex taken in read mode
+    volatile U32 nModificationsInProgress;
+
     // The number of bytes taken by the bucket
     // Protected by bucketMutex
     std::size_t size;
@@ -792,11 +949,14 @@ struct CacheBucketIPCData
     //
     U64_Set freeTiles;
 
-    CacheBucketIPCData(const void_allocator& allocator)
+    CacheBucketIPCData(const void_allocator& allocator, U64 tileSize)
     : lruListFront(0)
     , lruListBack(0)
+    , evictionInflation(0)
     , version(NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION)
+    , tileSizeBytes(tileSize)
     , bucketState(eBucketStateOk)
+    , nModificationsInProgress(0)
     , size(0)
     , entriesMap(allocator)
     , freeTiles(allocator)
@@ -806,8 +966,11 @@ struct CacheBucketIPCData
     CacheBucketIPCData()
     : lruListFront(0)
     , lruListBack(0)
+    , evictionInflation(0)
     , version(NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION)
+    , tileSizeBytes(0)
     , bucketState(eBucketStateOk)
+    , nModificationsInProgress(0)
     , size(0)
     , entriesMap()
     , freeTiles()
@@ -838,6 +1001,12 @@ struct CacheBucket
     // Weak pointer to the cache
     boost::weak_ptr<Cache<persistent> > cache;
 
+    // Raw pointer to the cache private data. The buckets are owned by the cache, so this is valid
+    // as long as the bucket lives. This is used on the look-up path instead of cache.lock() so that concurrent
+    // readers do not all atomically increment the same shared reference count for each access.
+    // This is also used to map the ToC file, which CacheBucketsAttacher may do whilst the cache is being destroyed.
+    CachePrivate<persistent>* cacheImp;
+
     // A memory manager of the tocFile. It is only valid when the tocFile is memory mapped.
     boost::shared_ptr<ExternalSegmentType> tocFileManager;
 
@@ -854,31 +1023,87 @@ struct CacheBucket
     // This is only valid if the cache is persistent
     StoragePtrType tocFile;
 
+    // The path of the tocFile. The file is only opened the first time the bucket is accessed, see tocAttached
+    std::string tocFilePath;
+
+    // True once this process mapped the tocFile and checked it, see remapToCMemoryFile().
+    // Buckets are attached on their first access or in the background by CacheBucketsAttacher so that
+    // opening the cache does not depend on the number of buckets.
+    // Process local, protected by the tocData.segmentMutex
+    bool tocAttached;
+
     // Pointer to the IPC data that live in tocFile memory mapped file. This is valid
     // as long as tocFile is mapped
     IPCData *ipc;
 
+    // Process local access counters of this bucket for each plug-in, see CacheReportInfo.
+    // They are kept per bucket so that look-ups in different buckets do not contend on the same mutex.
+    mutable boost::mutex accessStatsMutex;
+    std::map<std::string, CacheReportInfo> accessStats;
+
+    // Process local wake-up of the threads waiting in waitForPendingEntry() for an entry of this bucket.
+    // The generation is incremented each time a pending entry of this bucket is inserted or released by this process.
+    // Entries computed by another process are only noticed when the wait times out.
+    boost::mutex pendingEntriesMutex;
+    boost::condition_variable_any pendingEntriesCond;
+    U64 pendingEntriesGeneration;
+
     CacheBucket()
     : cache()
+    , cacheImp(0)
     , tocFileManager()
     , bucketIndex(-1)
     , tocFile()
+    , tocFilePath()
+    , tocAttached(false)
     , ipc(0)
+    , accessStatsMutex()
+    , accessStats()
+    , pendingEntriesMutex()
+    , pendingEntriesCond()
+    , pendingEntriesGeneration(0)
     {
 
     }
 
+    /**
+     * @brief Wakes up the threads waiting for a pending entry of this bucket. This does not require any lock on the bucket.
+     **/
+    void notifyPendingEntriesChanged();
+
+    /**
+     * @brief Returns the current value of pendingEntriesGeneration, to be passed to waitForPendingEntriesChanged()
+     **/
+    U64 getPendingEntriesGeneration();
+
+    /**
+     * @brief Blocks until notifyPendingEntriesChanged() is called after generation was read or the timeout expires.
+     **/
+    void waitForPendingEntriesChanged(U64 generation, std::size_t timeoutMS);
+
+    /**
+     * @brief Update the access counters of the given plug-in in this bucket.
+     * These functions only take the accessStatsMutex and do not require any lock on the bucket.
+     **/
+    void recordLookUp(const std::string& pluginID, CacheEntryLockerBase::CacheEntryStatusEnum status);
+    void recordPendingWait(const std::string& pluginID, double timeMS);
+    void recordEviction(const std::string& pluginID);
+    void recordAllocation(const std::string& pluginID, std::size_t nBytes);
+
     /**
      * @brief Deallocates the cache entry pointed to by cacheEntryIt from the ToC memory mapped file.
      * This function assumes that tocData.segmentMutex must be taken in write mode
      * This function may take the tileData.segmentMutex in write mode.
      * @param cacheEntryIt A valid iterator pointing to the entry. It will be invalidated when returning from the function.
      * @param storage A pointer to the map containing the cacheEntryIt iterator.
+     * @param evictedTiles If non NULL, a copy of each tile of the entry is appended to it before the tile is freed,
+     * so that they can be inserted in the compressed tier once the locks are released.
      *
      * This function may throw a AbandonnedLockException
      **/
     void deallocateCacheEntryImpl(typename EntriesMap::iterator cacheEntryIt,
-                                  EntriesMap* storage);
+                                  EntriesMap* storage,
+                                  std::vector<EvictedTile>* evictedTiles = 0);
 
     /**
      * @brief Lookup the cache for a MemorySegmentEntry matching the hash key.
@@ -911,17 +1136,51 @@ struct CacheBucket
 
     ShmEntryReadRetCodeEnum deserializeEntry(EntryType* entry, const CacheEntryBasePtr& processLocalEntry, U64 hash, bool hasWriteRights);
 
+    /**
+     * @brief Moves the given entry to the tail of the LRU list (most recently used).
+     * This function assumes that the bucketLock of the bucket is taken at least in read mode.
+     * @param blocking If false and the LRU list mutex is already taken by another thread, this function
+     * returns immediately without promoting the entry and returns false.
+     *
+     * This function may throw a AbandonnedLockException
+     **/
+    bool promoteEntryInLRU(EntryType* entry, bool blocking);
+
+    /**
+     * @brief Set the GreedyDual-Size eviction priority of the entry from its cost and size: cheap entries
+     * per byte get a low priority and are evicted first with the eCacheEvictionPolicyCost policy.
+     * The bucketMutex must be taken at least in read mode and the lruListMutex must be taken.
+     **/
+    void updateEvictionPriority(EntryType* entry);
+
     void checkToCMemorySegmentStatus(boost::scoped_ptr<Sharable_ReadLock>* tocReadLock,
                                      boost::scoped_ptr<Sharable_WriteLock>* tocWriteLock);
 
     /**
      * @brief Returns whether the ToC memory mapped file mapping is still valid.
+     * This returns false if this process did not attach the bucket yet.
      * The tocData.segmentMutex is assumed to be taken for read-lock
      **/
     bool isToCFileMappingValid() const;
 
+    /**
+     * @brief Returns true if a modification of the bucket was interrupted, i.e: the process modifying it crashed.
+     * The ToC must be mapped and no thread may be modifying the bucket.
+     **/
+    bool hasInterruptedModification() const;
+
+    /**
+     * @brief Returns false if the ToC cannot be used: a modification was interrupted or the LRU list is not
+     * consistent with the entries. This walks the LRU list of the bucket only.
+     * The tocData.segmentMutex is assumed to be taken for write-lock
+     **/
+    bool isToCConsistent() const;
+
     /**
      * @brief Ensures that the ToC memory mapped file mapping is still valid and re-open it if not.
+     * The first time this process accesses the bucket, this function opens the ToC file. If the journal indicates
+     * that a process did not detach from the bucket cleanly, the ToC is checked and wiped if it is corrupted:
+     * the other buckets are not affected.
      * @param tocFileLock The tocData.segmentMutex is assumed to be taken for write-lock: this is the lock currently taken
      * @param minFreeSize Indicates that the file should have at least this amount of free bytes.
      * If not, this function will call growTileFile.
@@ -1101,6 +1360,11 @@ struct CacheIPCData
         // Data related to the table of content memory mapped file
         SharedMemorySegmentData tocData;
 
+        // True once a process attached the bucket and checked its ToC, so that the other processes
+        // attaching it while the shared memory lives do not check it again.
+        // Protected by tocData.segmentMutex
+        bool tocValidated;
+
         // Protects the bucket data structures except the LRU linked list
         SharedMutex bucketMutex;
 
@@ -1110,6 +1374,15 @@ struct CacheIPCData
         // protect it from being written by multiple concurrent threads.
         ExclusiveMutex lruListMutex;
 
+        PerBucketData()
+        : tocData()
+        , tocValidated(false)
+        , bucketMutex()
+        , lruListMutex()
+        {
+
+        }
+
     };
 
 
@@ -1119,16 +1392,193 @@ struct CacheIPCData
     // and taken in write mode when a file is removed/added
     SharedMutex tilesStorageMutex;
 
+    // The number of tile storage files created by all processes sharing the cache. If a process has mapped fewer
+    // files, it must map the others with mapTileStorageFilesCreatedByOtherProcesses() before using a tile index.
+    // Protected by tilesStorageMutex
+    U32 nTilesStorageFiles;
 
     CacheIPCData()
     : bucketsData()
     , tilesStorageMutex()
+    , nTilesStorageFiles(0)
+    {
+
+    }
+
+};
+
+/**
+ * @brief The journal of a persistent cache, memory mapped from the NATRON_CACHE_JOURNAL_FILE_NAME file.
+ * It is read when opening the cache instead of each bucket ToC so that attaching to the cache takes the same time
+ * whatever its size. A bucket is flagged dirty as soon as a process attaches it and only the last process
+ * detaching from the cache flags it clean again: after a crash, only the buckets that were in use are checked,
+ * when they are first accessed.
+ **/
+struct CacheJournalData
+{
+    // Must be NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION and the tile size of the cache, otherwise all buckets
+    // and the tiles storage are wiped
+    U32 version;
+    U32 tileSizeBytes;
+
+    // For each bucket, 1 if a process attached it and did not detach from the cache cleanly.
+    // Protected by the tocData.segmentMutex of the bucket
+    unsigned char bucketsDirty[NATRON_CACHE_BUCKETS_COUNT];
+};
+
+
+/**
+ * @brief A tile evicted from the tile storage, kept compressed in process memory
+ **/
+struct CompressedTile
+{
+    QByteArray data;
+
+    // The ID of the plug-in that produced the tile, for statistics
+    std::string pluginID;
+
+    // The corresponding node in the compressed tier LRU list
+    std::list<CompressedTileKey>::iterator lruIt;
+};
+
+typedef std::map<CompressedTileKey, CompressedTile> CompressedTilesMap;
+
+// For each tile storage file index, the indices of tiles in this file.
+// The tiles are sorted so that contiguous tiles can be flushed at once.
+typedef std::map<U32, std::set<U32> > TilesPerFileMap;
+
+template <bool persistent>
+struct CachePrivate;
+
+struct RemoteTileHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    U64 tileSizeBytes;
+};
+
+/**
+ * @brief A tile waiting to be written to the remote tier: the header followed by the compressed pixels
+ **/
+struct RemoteTile
+{
+    QString filePath;
+    QByteArray data;
+};
+
+/**
+ * @brief Writes tiles to the remote tier on CachePrivate::remoteTierWriters
+ **/
+template <bool persistent>
+class RemoteTilesWriter
+: public QRunnable
+{
+    CachePrivate<persistent>* _imp;
+    std::vector<RemoteTile> _tiles;
+
+public:
+
+    RemoteTilesWriter(CachePrivate<persistent>* imp, const std::vector<RemoteTile>& tiles)
+    : QRunnable()
+    , _imp(imp)
+    , _tiles(tiles)
+    {
+        setAutoDelete(true);
+    }
+
+    virtual ~RemoteTilesWriter()
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+};
+
+/**
+ * @brief Attaches the buckets of a persistent cache after it is opened on CachePrivate::bucketsAttacher,
+ * so that the buckets are already attached when they are first accessed by a render.
+ **/
+template <bool persistent>
+class CacheBucketsAttacher
+: public QRunnable
+{
+    CachePrivate<persistent>* _imp;
+
+public:
+
+    CacheBucketsAttacher(CachePrivate<persistent>* imp)
+    : QRunnable()
+    , _imp(imp)
+    {
+        setAutoDelete(true);
+    }
+
+    virtual ~CacheBucketsAttacher()
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+};
+
+/**
+ * @brief Frees the tile storage files dropped by Cache::clear() on CachePrivate::discardedStorageDeleter
+ **/
+template <bool persistent>
+class DiscardedTilesStorageDeleter
+: public QRunnable
+{
+    typedef typename CacheBucket<persistent>::StoragePtrType StoragePtrType;
+
+    std::vector<StoragePtrType> _storage;
+
+public:
+
+    DiscardedTilesStorageDeleter(const std::vector<StoragePtrType>& storage)
+    : QRunnable()
+    , _storage(storage)
     {
+        setAutoDelete(true);
+    }
 
+    virtual ~DiscardedTilesStorageDeleter()
+    {
     }
 
+private:
+
+    virtual void run() OVERRIDE FINAL;
 };
 
+/**
+ * @brief Performs in the background the I/O of a persistent cache on the tile storage: it flushes the tiles written
+ * (see CacheBase::setDirtyTilesHighWatermark) and faults in the tiles to prefetch (see CacheBase::prefetchEntries).
+ **/
+template <bool persistent>
+class CacheIOThread
+: public QThread
+{
+    CachePrivate<persistent>* _imp;
+
+public:
+
+    CacheIOThread(CachePrivate<persistent>* imp)
+    : QThread()
+    , _imp(imp)
+    {
+        setObjectName( QString::fromUtf8("CacheIO") );
+    }
+
+    virtual ~CacheIOThread()
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+};
 
 template <bool persistent>
 struct CachePrivate
@@ -1146,11 +1596,93 @@ struct CachePrivate
     // regulate the cache size.
     std::size_t maximumSize;
 
-    // Protects all maximumSize.
+    // The policy used by evictLRUEntries().
+    // Like maximumSize this is local to the process.
+    CacheBase::CacheEvictionPolicyEnum evictionPolicy;
+
+    // How the tile storage is allocated when the cache is not persistent, see setTileStorageAllocation()
+    CacheBase::CacheTileStoragePagesEnum tileStoragePages;
+    bool tileStorageInterleaveNUMANodes;
+
+    // Protects all maximumSize, evictionPolicy and the tile storage allocation policy.
     // Since it lives in process memory, this mutex
     // only protects against threads.
     boost::mutex maximumSizeMutex;
 
+    // The compressed tier: tiles evicted from the tile storage by evictLRUEntries() are compressed
+    // and kept here until the tier exceeds compressedTierMaximumSize, in which case the least recently
+    // evicted tiles are dropped. It lives in process memory, even if the cache is persistent.
+    // If compressedTierMaximumSize is 0, the tier is disabled.
+    std::size_t compressedTierMaximumSize;
+    std::size_t compressedTierSize;
+    CompressedTilesMap compressedTiles;
+    std::list<CompressedTileKey> compressedTilesLRU;
+
+    // For each plug-in ID, the number of tiles restored from the compressed tier and the number of tiles that were not found
+    std::map<std::string, std::pair<U64, U64> > compressedTierHitsMisses;
+
+    // Protects all compressed tier data above
+    boost::mutex compressedTierMutex;
+
+    // The remote tier: a directory shared by the hosts of a render farm where the tiles of entries that took at least
+    // remoteTierMinimumRenderCost seconds to render are written, see CacheBase::setRemoteTier.
+    // If remoteTierPath is empty, the tier is disabled.
+    std::string remoteTierPath;
+    double remoteTierMinimumRenderCost;
+
+    // Bytes copied by publishRemoteTiles() that were not written yet
+    std::size_t remoteTierPendingBytes;
+
+    // For each plug-in ID, the number of tiles read from the remote tier, the number of tiles that were not found
+    // and the number of tiles published
+    std::map<std::string, boost::tuple<U64, U64, U64> > remoteTierStats;
+
+    // Protects all remote tier data above
+    boost::mutex remoteTierMutex;
+
+    // Writes the tiles of the remote tier in the background: the renders do not wait for the shared storage
+    QThreadPool remoteTierWriters;
+
+    // The tiles of a persistent cache written by this process since they were last flushed.
+    // They are flushed by ioThread periodically or as soon as dirtyTilesSize exceeds
+    // dirtyTilesHighWatermark (if not 0). This lives in process memory: each process flushes the tiles it wrote.
+    TilesPerFileMap dirtyTiles;
+    std::size_t dirtyTilesSize;
+    std::size_t dirtyTilesHighWatermark;
+
+    // The quota of each group for each CacheBase::CacheQuotaGroupTypeEnum, 0 if unlimited
+    std::size_t quotaGroupsSize[3];
+
+    // For each quota group the bytes accounted to it, and the bytes taken by viewer outputs.
+    // Like maximumSize this is local to the process: in a persistent cache shared by several processes,
+    // each process only accounts the entries it created.
+    std::map<U64, std::size_t> quotaGroupsUsage;
+    std::size_t viewerOutputsUsage;
+
+    // The type and name of each group registered with registerQuotaGroup(), for getMemoryStats()
+    std::map<U64, std::pair<CacheBase::CacheQuotaGroupTypeEnum, std::string> > quotaGroupsNames;
+
+    // Protects all quota groups data above. This mutex may be taken while holding a bucket lock
+    // but no other lock may be taken while holding it.
+    boost::mutex quotaGroupsMutex;
+
+    // Incremented each time this process removes entries from the cache, see getRemovedEntriesCount()
+    QAtomicInt removedEntriesCount;
+
+    // Each request is a list of holder hashes passed to prefetchEntries(), processed by ioThread
+    std::list<std::vector<U64> > prefetchRequests;
+
+    bool ioThreadMustQuit;
+
+    // Protects all dirty tiles and prefetch data above. This mutex is never held while taking another lock.
+    QMutex ioThreadMutex;
+
+    // Wakes up the IO thread
+    QWaitCondition ioThreadCond;
+
+    // Only valid for a persistent cache with tile storage
+    boost::scoped_ptr<CacheIOThread<persistent> > ioThread;
+
     // Each bucket handle entries with the 2 first hexadecimal numbers of the hash
     // This allows to hopefully dispatch threads and processes in 256 different buckets so that they are less likely
     // to take the same lock.
@@ -1215,10 +1747,65 @@ struct CachePrivate
 
     bool useTileStorage;
 
-    CachePrivate(Cache<persistent>* publicInterface, bool enableTileStorage)
+    // The tile geometry of the tiles storage, see NATRON_TILE_SIZE_PO2_DEFAULT.
+    // Never changes after construction
+    int tileSizePo2;
+    std::size_t tileSizeBytes;
+
+    // Number of tiles of each tiles storage file owned by each bucket
+    U64 nTilesPerBucketFile;
+
+    // Set when a bucket table of content was wiped because it was created with another version or tile size:
+    // the tiles storage files on disk can then no longer be referenced and must be wiped as well.
+    bool tilesStorageInvalid;
+
+    // Removes the tile storage files dropped by clear() in the background: removing hundreds of 1GB files
+    // can take seconds and the cache must be usable again immediately.
+    QThreadPool discardedStorageDeleter;
+
+    // Used to give a unique name to the files dropped by clear()
+    U64 discardedStorageCount;
+
+    // The journal of a persistent cache, NULL otherwise. The journal memory is valid as long as journalFile is mapped.
+    MemoryFilePtr journalFile;
+    CacheJournalData* journal;
+
+    // Attaches the buckets that were not accessed yet in the background, see CacheBucketsAttacher
+    QThreadPool bucketsAttacher;
+    QAtomicInt bucketsAttacherMustQuit;
+
+    CachePrivate(Cache<persistent>* publicInterface, bool enableTileStorage, int tileSizePo2)
     : _publicInterface(publicInterface)
     , maximumSize((std::size_t)8 * 1024 * 1024 * 1024) // 8GB max by default
+    , evictionPolicy(CacheBase::eCacheEvictionPolicyLRU)
+    , tileStoragePages(CacheBase::eCacheTileStoragePagesDefault)
+    , tileStorageInterleaveNUMANodes(false)
     , maximumSizeMutex()
+    , compressedTierMaximumSize(0)
+    , compressedTierSize(0)
+    , compressedTiles()
+    , compressedTilesLRU()
+    , compressedTierHitsMisses()
+    , compressedTierMutex()
+    , remoteTierPath()
+    , remoteTierMinimumRenderCost(0)
+    , remoteTierPendingBytes(0)
+    , remoteTierStats()
+    , remoteTierMutex()
+    , remoteTierWriters()
+    , dirtyTiles()
+    , dirtyTilesSize(0)
+    , dirtyTilesHighWatermark((std::size_t)256 * 1024 * 1024) // 256MiB by default
+    , quotaGroupsUsage()
+    , viewerOutputsUsage(0)
+    , quotaGroupsNames()
+    , quotaGroupsMutex()
+    , removedEntriesCount()
+    , prefetchRequests()
+    , ioThreadMustQuit(false)
+    , ioThreadMutex()
+    , ioThreadCond()
+    , ioThread()
     , buckets()
     , tilesStorage()
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
@@ -1231,8 +1818,24 @@ struct CachePrivate
     , timerFrequency(getPerformanceFrequency())
 #endif
     , useTileStorage(enableTileStorage)
+    , tileSizePo2(std::max(NATRON_TILE_SIZE_PO2_MIN, std::min(NATRON_TILE_SIZE_PO2_MAX, tileSizePo2)))
+    , tileSizeBytes(NATRON_TILE_SIZE_BYTES_FOR_PO2(this->tileSizePo2))
+    , nTilesPerBucketFile(NATRON_TILE_STORAGE_FILE_SIZE / tileSizeBytes / NATRON_CACHE_BUCKETS_COUNT)
+    , tilesStorageInvalid(false)
+    , discardedStorageDeleter()
+    , discardedStorageCount(0)
+    , journalFile()
+    , journal(0)
+    , bucketsAttacher()
+    , bucketsAttacherMustQuit()
     {
-
+        assert(nTilesPerBucketFile > 0);
+        for (int i = 0; i < 3; ++i) {
+            quotaGroupsSize[i] = 0;
+        }
+        remoteTierWriters.setMaxThreadCount(NATRON_REMOTE_TIER_N_WRITER_THREADS);
+        discardedStorageDeleter.setMaxThreadCount(1);
+        bucketsAttacher.setMaxThreadCount(1);
     }
 
     virtual ~CachePrivate()
@@ -1263,6 +1866,25 @@ struct CachePrivate
     // This function may throw a AbandonnedLockException
     void clearCacheBucket(int bucket_i);
 
+    /**
+     * @brief Opens the journal of a persistent cache. Returns false if it did not exist or if it was written
+     * by another version or with another tile size, in which case the whole cache must be wiped.
+     * This must be called with the globalFileLock taken.
+     **/
+    bool openJournal();
+
+    /**
+     * @brief If this is the last process using the cache, flags the buckets attached by this process clean
+     * in the journal, after flushing their ToC. Called when the cache is destroyed.
+     **/
+    void closeJournal();
+
+    /**
+     * @brief Attaches all the buckets that were not accessed yet, called by CacheBucketsAttacher.
+     * Returns early if bucketsAttacherMustQuit is set.
+     **/
+    void attachBuckets();
+
     /**
      * @brief Ensure the cache returns to a correct state. Currently it wipes the cache.
      **/
@@ -1274,31 +1896,130 @@ struct CachePrivate
 
     void createTileStorage();
 
-    void freeAllocatedTiles(U64 entryHash, const std::vector<U64>& tilesToAlloc, const std::vector<std::pair<U64, void*> >& allocatedTiles);
-
     /**
-     * @brief Scan for existing tile files. This function throws an exception if the cache is corrupted
+     * @brief Drops all the tile storage files. They are removed in the background by discardedStorageDeleter:
+     * the files of a persistent cache are first renamed so that new files can be created right away.
+     * The tilesStorageMutex must be taken in write mode.
      **/
-    void reOpenTileStorage();
+    void discardTilesStorage();
 
-};
+    /**
+     * @brief Compress the given tiles and insert them in the compressed tier.
+     * This function must be called without any bucket lock taken.
+     **/
+    void insertCompressedTiles(const std::vector<EvictedTile>& evictedTiles);
 
+    /**
+     * @brief Remove from the compressed tier all tiles of the given entry
+     **/
+    void removeCompressedTiles(U64 entryHash);
 
-/**
- * @brief A small RAII object that should be instanciated whenever taking a write lock on the bucket
- * If the cache is corrupted, the ctor will throw a CorruptedCacheException
- **/
-template <bool persistent>
-class BucketStateHandler_RAII
-{
-    const CacheBucket<persistent>* bucket;
-public:
+    /**
+     * @brief Drop the least recently evicted tiles until the compressed tier fits in its maximum size.
+     * The compressedTierMutex must be held.
+     **/
+    void trimCompressedTier();
 
-    BucketStateHandler_RAII(const CacheBucket<persistent>* bucket)
-    :  bucket(bucket)
-    {
+    /**
+     * @brief Returns the path of the file holding the given tile in the remote tier rooted at rootPath.
+     * Tiles are addressed by the hash of their entry and their local index: two processes rendering the same image
+     * on different hosts produce the same tiles. The tile size is part of the path since the local index depends on it.
+     **/
+    QString getRemoteTileFilePath(const std::string& rootPath, U64 entryHash, U64 tileLocalIndex) const;
 
-        // The bucketMutex must be taken in write mode
+    void freeAllocatedTiles(U64 entryHash, const std::vector<U64>& tilesToAlloc, const std::vector<std::pair<U64, void*> >& allocatedTiles);
+
+    /**
+     * @brief Mark the given tiles as written so that the IO thread flushes them on disk.
+     **/
+    void markTilesDirty(const std::vector<U64>& encodedTileIndices);
+
+    /**
+     * @brief Calls flushMemory() once for each range of contiguous tiles of each tile storage file.
+     * The tilesStorageMutex must be taken at least in read mode.
+     **/
+    void flushTilesRanges(const TilesPerFileMap& tiles, int flushType);
+
+    /**
+     * @brief Flush all tiles marked dirty so far. This function takes the tilesStorageMutex in read mode.
+     **/
+    void flushDirtyTiles(int flushType);
+
+    /**
+     * @brief Fault in the table of content and the tiles of all entries produced by one of the given holder hashes.
+     * This function takes the bucket locks and the tilesStorageMutex in read mode.
+     **/
+    void prefetchEntriesInternal(const std::vector<U64>& holderHashes);
+
+    /**
+     * @brief Returns the ID of the quota group of the given type and name, or 0 if the name is empty.
+     **/
+    U64 registerQuotaGroup(CacheBase::CacheQuotaGroupTypeEnum type, const std::string& name);
+
+    /**
+     * @brief Account nBytes to the quota groups of the given entry, or remove them if added is false.
+     * Returns true if one of the groups of the entry now exceeds its quota.
+     **/
+    bool updateQuotaGroupsUsage(const MemorySegmentEntryHeaderBase& entry, std::size_t nBytes, bool added);
+
+    /**
+     * @brief Returns for each quota group exceeding its quota the number of bytes in excess.
+     **/
+    void getExceededQuotaGroups(std::list<std::pair<U64, std::size_t> >* groups);
+
+    /**
+     * @brief Returns true if the viewer outputs fit in their reserved share and should not be evicted.
+     **/
+    bool mustProtectViewerOutputs();
+
+    /**
+     * @brief Evicts at most one entry accepted by the filter in each bucket, chosen according to the given policy.
+     * The number of bytes freed is returned in freedBytes.
+     * Returns false if no entry could be evicted.
+     * This function must be called without any bucket lock taken.
+     **/
+    bool evictOneEntryPerBucket(CacheBase::CacheEvictionPolicyEnum policy,
+                                const CacheEvictionFilter& filter,
+                                bool useCompressedTier,
+                                std::size_t* freedBytes);
+
+    void startIOThread();
+
+    /**
+     * @brief Stops the IO thread, the tiles not flushed yet are left to the system and pending prefetches are dropped.
+     **/
+    void quitIOThread();
+
+    /**
+     * @brief Scan for existing tile files. This function throws an exception if the cache is corrupted
+     **/
+    void reOpenTileStorage();
+
+    /**
+     * @brief Map the tile storage files that other processes sharing the cache created since this process
+     * last mapped them, so that their tiles indices are the same in all processes.
+     * The tilesStorageMutex must be taken in write mode.
+     **/
+    void mapTileStorageFilesCreatedByOtherProcesses();
+
+};
+
+
+/**
+ * @brief A small RAII object that should be instanciated whenever taking a write lock on the bucket
+ * If the cache is corrupted, the ctor will throw a CorruptedCacheException
+ **/
+template <bool persistent>
+class BucketStateHandler_RAII
+{
+    const CacheBucket<persistent>* bucket;
+public:
+
+    BucketStateHandler_RAII(const CacheBucket<persistent>* bucket)
+    :  bucket(bucket)
+    {
+
+        // The bucketMutex must be taken in write mode
 
         if (bucket->ipc->bucketState != eBucketStateOk) {
             throw CorruptedCacheException();
@@ -1315,6 +2036,32 @@ public:
     }
 };
 
+/**
+ * @brief A small RAII object that should be instanciated around any modification of the bucket data structures
+ * that is not already covered by a BucketStateHandler_RAII, e.g: the free tiles or the LRU list.
+ * The counter lives in the ToC file: if the process crashes during the modification, the bucket is wiped
+ * the next time it is attached. Unlike BucketStateHandler_RAII, this may be nested.
+ **/
+template <bool persistent>
+class BucketModification_RAII
+{
+    const CacheBucket<persistent>* bucket;
+public:
+
+    BucketModification_RAII(const CacheBucket<persistent>* bucket)
+    :  bucket(bucket)
+    {
+        ++bucket->ipc->nModificationsInProgress;
+    }
+
+
+    ~BucketModification_RAII()
+    {
+        assert(bucket->ipc->nModificationsInProgress > 0);
+        --bucket->ipc->nModificationsInProgress;
+    }
+};
+
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
 
 /**
@@ -1324,12 +2071,12 @@ public:
  * Since any mutex in the cache is held in the globalMemorySegment, unmapping the segment could potentially crash any process
  * so we must carefully lock the access to the globalMemorySegment
  **/
-template <bool persistent>
 class SharedMemoryProcessLocalReadLocker
 {
     boost::scoped_ptr<boost::shared_lock<boost::shared_mutex> > processLocalLocker;
 public:
 
+    template <bool persistent>
     SharedMemoryProcessLocalReadLocker(CachePrivate<persistent>* imp)
     {
 
@@ -1357,8 +2104,8 @@ public:
  * @brief Creates a locker object around the given process shared mutex.
  * If after some time the mutex cannot be taken it is declared abandonned and throws a AbandonnedLockException
  **/
-template <typename LOCK>
-void createTimedLock(CachePrivate* imp,  boost::scoped_ptr<LOCK>& lock, typename LOCK::mutex_type* mutex)
+template <typename LOCK, bool persistent>
+void createTimedLock(CachePrivate<persistent>* imp,  boost::scoped_ptr<LOCK>& lock, typename LOCK::mutex_type* mutex)
 {
 
     lock.reset(new LOCK(*mutex, imp->timerFrequency));
@@ -1410,6 +2157,8 @@ CacheEntryLocker<persistent>::create(const boost::shared_ptr<Cache<persistent> >
     std::size_t timeSpentWaiting = 0;
     ret->_imp->lookupAndSetStatus(&timeSpentWaiting, 0);
 
+    ret->_imp->bucket->recordLookUp(entry->getKey()->getHolderPluginID(), ret->_imp->status);
+
     return ret;
 }
 
@@ -1418,11 +2167,120 @@ bool
 CacheBucket<persistent>::isToCFileMappingValid() const
 {
     // Private - the tocData.segmentMutex is assumed to be taken for read lock
-    boost::shared_ptr<Cache<persistent> > c = cache.lock();
-    assert(!c->_imp->ipc->bucketsData[bucketIndex].tocData.segmentMutex.try_lock());
-    return c->_imp->ipc->bucketsData[bucketIndex].tocData.mappingValid ;
+    assert(!cacheImp->ipc->bucketsData[bucketIndex].tocData.segmentMutex.try_lock());
+    return tocAttached && cacheImp->ipc->bucketsData[bucketIndex].tocData.mappingValid ;
+}
+
+template <bool persistent>
+bool
+CacheBucket<persistent>::hasInterruptedModification() const
+{
+    return ipc->bucketState != eBucketStateOk || ipc->nModificationsInProgress != 0;
+}
+
+template <bool persistent>
+bool
+CacheBucket<persistent>::isToCConsistent() const
+{
+    // Private - the tocData.segmentMutex is assumed to be taken for write lock
+    if (hasInterruptedModification()) {
+        return false;
+    }
+
+    // Walk the LRU list: each node must be in the mapping, be linked back to its predecessor and belong to an entry
+    // of the bucket. The walk is bounded by the number of entries so that a corrupted list cannot loop forever.
+    const char* mappingStart = tocFile->getData();
+    const char* mappingEnd = mappingStart + tocFile->size();
+    std::size_t nEntries = ipc->entriesMap.size();
+    std::size_t nNodes = 0;
+    const LRUListNode* prev = 0;
+    for (const LRUListNode* node = ipc->lruListFront.get(); node; node = node->next.get()) {
+        const char* nodeAddr = reinterpret_cast<const char*>(node);
+        if (nodeAddr < mappingStart || nodeAddr + sizeof(LRUListNode) > mappingEnd) {
+            return false;
+        }
+        if (++nNodes > nEntries || node->prev.get() != prev) {
+            return false;
+        }
+        if (ipc->entriesMap.find(node->hash) == ipc->entriesMap.end()) {
+            return false;
+        }
+        prev = node;
+    }
+    return ipc->lruListBack.get() == prev;
+} // isToCConsistent
+
+
+template <bool persistent>
+void
+CacheBucket<persistent>::recordLookUp(const std::string& pluginID, CacheEntryLockerBase::CacheEntryStatusEnum status)
+{
+    boost::unique_lock<boost::mutex> k(accessStatsMutex);
+    CacheReportInfo& stats = accessStats[pluginID];
+    switch (status) {
+        case CacheEntryLockerBase::eCacheEntryStatusCached:
+            ++stats.nHits;
+            break;
+        case CacheEntryLockerBase::eCacheEntryStatusMustCompute:
+            ++stats.nMisses;
+            break;
+        case CacheEntryLockerBase::eCacheEntryStatusComputationPending:
+            ++stats.nPendingWaits;
+            break;
+    }
+} // recordLookUp
+
+template <bool persistent>
+void
+CacheBucket<persistent>::recordPendingWait(const std::string& pluginID, double timeMS)
+{
+    boost::unique_lock<boost::mutex> k(accessStatsMutex);
+    accessStats[pluginID].pendingWaitTimeMS += timeMS;
+}
+
+template <bool persistent>
+void
+CacheBucket<persistent>::notifyPendingEntriesChanged()
+{
+    boost::unique_lock<boost::mutex> k(pendingEntriesMutex);
+    ++pendingEntriesGeneration;
+    pendingEntriesCond.notify_all();
+}
+
+template <bool persistent>
+U64
+CacheBucket<persistent>::getPendingEntriesGeneration()
+{
+    boost::unique_lock<boost::mutex> k(pendingEntriesMutex);
+    return pendingEntriesGeneration;
+}
+
+template <bool persistent>
+void
+CacheBucket<persistent>::waitForPendingEntriesChanged(U64 generation, std::size_t timeoutMS)
+{
+    boost::unique_lock<boost::mutex> k(pendingEntriesMutex);
+    if (generation != pendingEntriesGeneration) {
+        return;
+    }
+    pendingEntriesCond.timed_wait( k, boost::posix_time::milliseconds( (long)timeoutMS ) );
+}
+
+template <bool persistent>
+void
+CacheBucket<persistent>::recordEviction(const std::string& pluginID)
+{
+    boost::unique_lock<boost::mutex> k(accessStatsMutex);
+    ++accessStats[pluginID].nEvictions;
 }
 
+template <bool persistent>
+void
+CacheBucket<persistent>::recordAllocation(const std::string& pluginID, std::size_t nBytes)
+{
+    boost::unique_lock<boost::mutex> k(accessStatsMutex);
+    accessStats[pluginID].nBytesAllocated += nBytes;
+}
 
 template <typename StoragePtrType>
 void ensureMappingValidInternal(Sharable_WriteLock& lock,
@@ -1509,6 +2367,30 @@ void resizeStorage(const ProcessLocalBufferPtr& storage, std::size_t numBytes)
     storage->resize(numBytes);
 }
 
+template <typename StoragePtrType>
+void setStorageAllocationPolicy(const StoragePtrType& storage, CacheBase::CacheTileStoragePagesEnum pages, bool interleaveNUMANodes);
+
+template <>
+void setStorageAllocationPolicy(const MemoryFilePtr& /*storage*/, CacheBase::CacheTileStoragePagesEnum /*pages*/, bool /*interleaveNUMANodes*/) {}
+
+template <>
+void setStorageAllocationPolicy(const ProcessLocalBufferPtr& storage, CacheBase::CacheTileStoragePagesEnum pages, bool interleaveNUMANodes)
+{
+    ProcessLocalBuffer::PageTypeEnum pageType = ProcessLocalBuffer::ePageTypeDefault;
+    switch (pages) {
+        case CacheBase::eCacheTileStoragePagesDefault:
+            pageType = ProcessLocalBuffer::ePageTypeDefault;
+            break;
+        case CacheBase::eCacheTileStoragePagesTransparentHuge:
+            pageType = ProcessLocalBuffer::ePageTypeTransparentHuge;
+            break;
+        case CacheBase::eCacheTileStoragePagesExplicitHuge:
+            pageType = ProcessLocalBuffer::ePageTypeExplicitHuge;
+            break;
+    }
+    storage->setAllocationPolicy(pageType, interleaveNUMANodes);
+}
+
 
 template <bool persistent>
 static void reOpenToCData(CacheBucket<persistent>* bucket, bool create)
@@ -1532,10 +2414,14 @@ static void reOpenToCData(CacheBucket<persistent>* bucket, bool create)
         }
         // The ipc data pointer must be re-fetched
         void_allocator allocator(bucket->tocFileManager->get_segment_manager());
-        bucket->ipc = bucket->tocFileManager->template find_or_construct<CacheBucketIPCData<persistent> >("BucketData")(allocator);
-
-        // If the version of the data is different than this build, wipe it and re-create it
-        if (bucket->ipc->version != NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION) {
+        bucket->ipc = bucket->tocFileManager->template find_or_construct<CacheBucketIPCData<persistent> >("BucketData")(allocator, (U64)bucket->cacheImp->tileSizeBytes);
+
+        // If the version of the data is different than this build or if the tiles it references do not have
+        // the size of the tiles of this cache, wipe it and re-create it.
+        // The tiles storage referenced by the old table of content is then unreachable, flag it so it gets wiped too.
+        if (bucket->ipc->version != NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION ||
+            bucket->ipc->tileSizeBytes != (U64)bucket->cacheImp->tileSizeBytes) {
+            bucket->cacheImp->tilesStorageInvalid = true;
             std::string tileFilePath = getStoragePath(bucket->tocFile);
             clearStorage(bucket->tocFile);
             openStorage(bucket->tocFile, tileFilePath, MemoryFile::eFileOpenModeOpenTruncateOrCreate);
@@ -1570,6 +2456,31 @@ void resizeAndPreserve(const ProcessLocalBufferPtr& storage, std::size_t newSize
 }
 
 
+template <typename StoragePtrType>
+bool renameStorage(const StoragePtrType& storage, const std::string& path);
+
+template <>
+bool renameStorage(const MemoryFilePtr& storage, const std::string& path)
+{
+    return storage->rename(path);
+}
+
+template <>
+bool renameStorage(const ProcessLocalBufferPtr& /*storage*/, const std::string& /*path*/) { return true; }
+
+template <typename StoragePtrType>
+void preallocateStorage(const StoragePtrType& storage, std::size_t offset, std::size_t numBytes);
+
+template <>
+void preallocateStorage(const MemoryFilePtr& storage, std::size_t offset, std::size_t numBytes)
+{
+    // This is only an optimization: if the file system cannot reserve the blocks, they are allocated when written
+    (void)storage->preallocate(offset, numBytes);
+}
+
+template <>
+void preallocateStorage(const ProcessLocalBufferPtr& /*storage*/, std::size_t /*offset*/, std::size_t /*numBytes*/) {}
+
 template <typename StoragePtrType>
 void flushMemory(const StoragePtrType& storage, int flag, char* ptr, std::size_t numBytes);
 
@@ -1582,24 +2493,47 @@ void flushMemory(const MemoryFilePtr& storage, int flag, char* ptr, std::size_t
 template <>
 void flushMemory(const ProcessLocalBufferPtr& /*storage*/, int /*flag*/, char* /*ptr*/, std::size_t /*numBytes*/) {}
 
+template <typename StoragePtrType>
+void prefetchMemory(const StoragePtrType& storage, char* ptr, std::size_t numBytes);
+
+template <>
+void prefetchMemory(const MemoryFilePtr& storage, char* ptr, std::size_t numBytes)
+{
+    storage->prefetch(ptr, numBytes);
+}
+
+template <>
+void prefetchMemory(const ProcessLocalBufferPtr& /*storage*/, char* /*ptr*/, std::size_t /*numBytes*/) {}
+
 
 template <bool persistent>
 void
 CacheBucket<persistent>::remapToCMemoryFile(Sharable_WriteLock& lock, std::size_t minFreeSize)
 {
     // Private - the tocData.segmentMutex is assumed to be taken for write lock
-    boost::shared_ptr<Cache<persistent> > c = cache.lock();
+    CacheIPCData::PerBucketData& bucketData = cacheImp->ipc->bucketsData[bucketIndex];
+
+    // The ToC must be checked if this process did not attach the bucket yet and a process did not detach from it cleanly,
+    // unless another process already checked it
+    bool mustValidate = false;
+    if (!tocAttached) {
+        mustValidate = !bucketData.tocValidated && cacheImp->journal && cacheImp->journal->bucketsDirty[bucketIndex];
+    }
+
     if (persistent) {
-        if (!c->_imp->ipc->bucketsData[bucketIndex].tocData.mappingValid) {
+        if (!tocAttached) {
+            // This is the first access to the bucket by this process: open the file
+            openStorage(tocFile, tocFilePath, (int)MemoryFile::eFileOpenModeOpenOrCreate);
+        } else if (!bucketData.tocData.mappingValid) {
             // Save the entire file
             flushMemory(tocFile, (int)MemoryFile::eFlushTypeSync, NULL, 0);
         }
 
 #ifdef CACHE_TRACE_FILE_MAPPING
-        qDebug() << "Checking ToC mapping:" << c->_imp->ipc->bucketsData[bucketIndex].tocData.mappingValid;
+        qDebug() << "Checking ToC mapping:" << cacheImp->ipc->bucketsData[bucketIndex].tocData.mappingValid;
 #endif
 
-        ensureMappingValidInternal(lock, tocFile, &c->_imp->ipc->bucketsData[bucketIndex].tocData);
+        ensureMappingValidInternal(lock, tocFile, &cacheImp->ipc->bucketsData[bucketIndex].tocData);
     }
     // Ensure the size of the ToC file is reasonable
     std::size_t curNumBytes = tocFile->size();
@@ -1607,17 +2541,47 @@ CacheBucket<persistent>::remapToCMemoryFile(Sharable_WriteLock& lock, std::size_
     if (curNumBytes == 0) {
         growToCFile(lock, minFreeSize);
     } else {
-        reOpenToCData(this, false /*create*/);
+        bool consistent = true;
+        try {
+            reOpenToCData(this, false /*create*/);
+        } catch (const std::exception&) {
+            if (!mustValidate) {
+                throw;
+            }
+            consistent = false;
+        }
+        if (consistent && mustValidate) {
+            consistent = isToCConsistent();
+        }
 
-        // Check that there's enough memory, if not grow the file
-        ExternalSegmentType::size_type freeMem = tocFileManager->get_free_memory();
-        if (freeMem < minFreeSize) {
-            std::size_t minbytesToGrow = minFreeSize - freeMem;
-            growToCFile(lock, minbytesToGrow);
+        if (!consistent) {
+            // A process crashed whilst using this bucket: wipe it alone. The tiles it referenced and the free tiles
+            // it owned can no longer be allocated until the cache is cleared.
+            qDebug() << "Cache bucket" << bucketIndex << "is corrupted, wiping it";
+            clearStorage(tocFile);
+            openStorage(tocFile, tocFilePath, (int)MemoryFile::eFileOpenModeOpenTruncateOrCreate);
+            growToCFile(lock, minFreeSize);
+        } else {
+            // Check that there's enough memory, if not grow the file
+            ExternalSegmentType::size_type freeMem = tocFileManager->get_free_memory();
+            if (freeMem < minFreeSize) {
+                std::size_t minbytesToGrow = minFreeSize - freeMem;
+                growToCFile(lock, minbytesToGrow);
+            }
         }
     }
     assert(tocFileManager->get_free_memory() >= minFreeSize);
 
+    if (!tocAttached) {
+        tocAttached = true;
+        bucketData.tocValidated = true;
+
+        // Flag the bucket dirty until the last process detaches from the cache, see closeJournal()
+        if (cacheImp->journal) {
+            cacheImp->journal->bucketsDirty[bucketIndex] = 1;
+        }
+    }
+
 } // remapToCMemoryFile
 
 
@@ -1627,26 +2591,47 @@ CacheBucket<persistent>::growToCFile(Sharable_WriteLock& lock, std::size_t bytes
 {
     // Private - the tocData.segmentMutex is assumed to be taken for write lock
 
-    boost::shared_ptr<Cache<persistent> > c = cache.lock();
 
     if (persistent) {
-        c->_imp->ipc->bucketsData[bucketIndex].tocData.mappingValid = false;
+        cacheImp->ipc->bucketsData[bucketIndex].tocData.mappingValid = false;
 
-        --c->_imp->ipc->bucketsData[bucketIndex].tocData.nProcessWithMappingValid;
-        while (c->_imp->ipc->bucketsData[bucketIndex].tocData.nProcessWithMappingValid > 0) {
-            c->_imp->ipc->bucketsData[bucketIndex].tocData.mappedProcessesNotEmpty.wait(lock);
+        --cacheImp->ipc->bucketsData[bucketIndex].tocData.nProcessWithMappingValid;
+        while (cacheImp->ipc->bucketsData[bucketIndex].tocData.nProcessWithMappingValid > 0) {
+            cacheImp->ipc->bucketsData[bucketIndex].tocData.mappedProcessesNotEmpty.wait(lock);
         }
     }
 
 
     std::size_t oldSize = tocFile->size();
 
+    // Each growth remaps the file and blocks all accesses to the bucket: grow geometrically so that a burst of
+    // insertions does not grow the file many times. When the file is created, size it from the maximum size of the
+    // cache so that most buckets never need to grow.
+    std::size_t minBytesToAdd;
+    if (oldSize == 0) {
+        std::size_t maxSize = cacheImp->_publicInterface->getMaximumCacheSize();
+        std::size_t estimatedSize;
+        if (cacheImp->useTileStorage) {
+            estimatedSize = maxSize / cacheImp->tileSizeBytes / NATRON_CACHE_BUCKETS_COUNT * NATRON_CACHE_BUCKET_TOC_BYTES_PER_TILE;
+        } else {
+            // Entries are entirely stored in the ToC
+            estimatedSize = maxSize / NATRON_CACHE_BUCKETS_COUNT;
+        }
+        minBytesToAdd = std::min(estimatedSize, (std::size_t)NATRON_CACHE_BUCKET_TOC_FILE_MAX_INITIAL_N_BYTES);
+    } else {
+        minBytesToAdd = std::min(oldSize, (std::size_t)NATRON_CACHE_BUCKET_TOC_FILE_MAX_GROW_N_BYTES);
+    }
+    bytesToAdd = std::max(bytesToAdd, minBytesToAdd);
+
     // Round to the nearest next multiple of NATRON_CACHE_BUCKET_TOC_FILE_GROW_N_BYTES
     std::size_t bytesToAddRounded = std::max((std::size_t)1, (std::size_t)std::ceil(bytesToAdd / (double) NATRON_CACHE_BUCKET_TOC_FILE_GROW_N_BYTES)) * NATRON_CACHE_BUCKET_TOC_FILE_GROW_N_BYTES;
     std::size_t newSize = oldSize + bytesToAddRounded;
 
     resizeAndPreserve(tocFile, newSize);
 
+    // Reserve the disk blocks of the new part of the file now rather than on the page faults of the next insertions
+    preallocateStorage(tocFile, oldSize, bytesToAddRounded);
+
 #ifdef CACHE_TRACE_FILE_MAPPING
     qDebug() << "Growing ToC file to " << printAsRAM(newSize);
 #endif
@@ -1655,12 +2640,12 @@ CacheBucket<persistent>::growToCFile(Sharable_WriteLock& lock, std::size_t bytes
     reOpenToCData(this, oldSize == 0 /*create*/);
 
     if (persistent) {
-        ++c->_imp->ipc->bucketsData[bucketIndex].tocData.nProcessWithMappingValid;
+        ++cacheImp->ipc->bucketsData[bucketIndex].tocData.nProcessWithMappingValid;
 
         // Flag that the mapping is valid again and notify all other threads waiting
-        c->_imp->ipc->bucketsData[bucketIndex].tocData.mappingValid = true;
+        cacheImp->ipc->bucketsData[bucketIndex].tocData.mappingValid = true;
 
-        c->_imp->ipc->bucketsData[bucketIndex].tocData.mappingInvalidCond.notify_all();
+        cacheImp->ipc->bucketsData[bucketIndex].tocData.mappingInvalidCond.notify_all();
     }
 
 } // growToCFile
@@ -1670,7 +2655,7 @@ bool
 CacheBucket<persistent>::tryCacheLookupImpl(U64 hash, typename EntriesMap::iterator* found, EntriesMap** storage)
 {
     // The bucket mutex is assumed to be taken at least in read lock mode
-    assert(!cache.lock()->_imp->ipc->bucketsData[bucketIndex].bucketMutex.try_lock());
+    assert(!cacheImp->ipc->bucketsData[bucketIndex].bucketMutex.try_lock());
     *storage = &ipc->entriesMap;
     *found = (*storage)->find(hash);
     return *found != (*storage)->end();
@@ -1744,14 +2729,11 @@ CacheBucket<persistent>::readFromSharedMemoryEntryImpl(EntryType* cacheEntry,
                                                        U64 hash,
                                                        bool hasWriteRights)
 {
-    boost::shared_ptr<Cache<persistent> > c = cache.lock();
-    
-    
     // Private - the tocData.segmentMutex is assumed to be taken at least in read lock mode
-    assert(!c->_imp->ipc->bucketsData[bucketIndex].tocData.segmentMutex.try_lock());
+    assert(!cacheImp->ipc->bucketsData[bucketIndex].tocData.segmentMutex.try_lock());
 
     // The bucket mutex is assumed to be taken at least in read lock mode
-    assert(!cache.lock()->_imp->ipc->bucketsData[bucketIndex].bucketMutex.try_lock());
+    assert(!cacheImp->ipc->bucketsData[bucketIndex].bucketMutex.try_lock());
 
     // The entry must have been looked up in tryCacheLookup()
     assert(cacheEntry);
@@ -1767,32 +2749,70 @@ CacheBucket<persistent>::readFromSharedMemoryEntryImpl(EntryType* cacheEntry,
     } // persistent
 
 
-    // Update LRU record if this item is not already at the tail of the list
+    // Update LRU record if this item is not already at the tail of the list.
     //
+    // Under the bucket read lock, many threads may hit entries of the same bucket at once
+    // (e.g: all render threads reading the same upstream Read node). The LRU list mutex is exclusive,
+    // so do not make readers wait for each other: if another thread is already updating the list,
+    // skip the promotion. The LRU order is then only approximate, which is harmless since
+    // the next hit on this entry will promote it.
+    promoteEntryInLRU(cacheEntry, hasWriteRights /*blocking*/);
+
+    return eShmEntryReadRetCodeOk;
+
+} // readFromSharedMemoryEntryImpl
+
+template <bool persistent>
+bool
+CacheBucket<persistent>::promoteEntryInLRU(EntryType* cacheEntry, bool blocking)
+{
     // Take the LRU list mutex
-    {
-        boost::scoped_ptr<ExclusiveLock> lruWriteLock;
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
-        lruWriteLock.reset(new ExclusiveLock(c->_imp->ipc->bucketsData[bucketIndex].lruListMutex));
+    ExclusiveLock lruWriteLock(cacheImp->ipc->bucketsData[bucketIndex].lruListMutex, boost::defer_lock);
+    if (blocking) {
+        lruWriteLock.lock();
+    } else if (!lruWriteLock.try_lock()) {
+        return false;
+    }
 #else
-        createTimedLock<ExclusiveLock>(c->_imp.get(), lruWriteLock, &c->_imp->ipc->bucketsData[bucketIndex].lruListMutex);
+    ExclusiveLock lruWriteLock(cacheImp->ipc->bucketsData[bucketIndex].lruListMutex, cacheImp->timerFrequency);
+    if (blocking) {
+        if (!lruWriteLock.timed_lock()) {
+            throw AbandonnedLockException();
+        }
+    } else if (!lruWriteLock.try_lock()) {
+        return false;
+    }
 #endif
 
-        assert(ipc->lruListBack && !ipc->lruListBack->next);
-        if (getRawPointer(ipc->lruListBack) != &cacheEntry->lruNode) {
+    assert(ipc->lruListBack && !ipc->lruListBack->next);
+    if (getRawPointer(ipc->lruListBack) != &cacheEntry->lruNode) {
 
-            LRUListNodePtr entryNode(&cacheEntry->lruNode);
-            disconnectLinkedListNode(entryNode);
+        BucketModification_RAII<persistent> modification(this);
+        LRUListNodePtr entryNode(&cacheEntry->lruNode);
 
-            // And push_back to the tail of the list...
-            insertLinkedListNode(entryNode, ipc->lruListBack, LRUListNodePtr(0));
-            ipc->lruListBack = entryNode;
+        // If this node is the front of the list, the front becomes its successor
+        if (getRawPointer(ipc->lruListFront) == &cacheEntry->lruNode) {
+            ipc->lruListFront = cacheEntry->lruNode.next;
         }
-    } // lruWriteLock
+        disconnectLinkedListNode(entryNode);
 
-    return eShmEntryReadRetCodeOk;
+        // And push_back to the tail of the list...
+        insertLinkedListNode(entryNode, ipc->lruListBack, LRUListNodePtr(0));
+        ipc->lruListBack = entryNode;
+    }
+    updateEvictionPriority(cacheEntry);
+    return true;
+} // promoteEntryInLRU
 
-} // readFromSharedMemoryEntryImpl
+template <bool persistent>
+void
+CacheBucket<persistent>::updateEvictionPriority(EntryType* cacheEntry)
+{
+    // Size in MiB, avoid dividing by 0 for entries without tiles
+    double sizeMiB = (cacheEntry->size + cacheEntry->tileIndices.size() * cacheImp->tileSizeBytes) / (1024. * 1024.);
+    cacheEntry->evictionPriority = ipc->evictionInflation + cacheEntry->cost / std::max(sizeMiB, 1. / 1024);
+} // updateEvictionPriority
 
 /**
  * @brief Given an encoded tile index, the left most 32 bits represents the tile index in the file
@@ -1802,13 +2822,13 @@ inline void getTileIndex(U64 encoded, U32* tileIndex, U32* fileIndex)
 {
     *fileIndex = encoded;
     *tileIndex = encoded >> 32;
-    assert(*tileIndex >= 0 && *tileIndex < NATRON_NUM_TILES_PER_FILE);
 }
 
 template <bool persistent>
 void
 CacheBucket<persistent>::deallocateCacheEntryImpl(typename EntriesMap::iterator cacheEntryIt,
-                                      EntriesMap* storage)
+                                      EntriesMap* storage,
+                                      std::vector<EvictedTile>* evictedTiles)
 {
 
      boost::shared_ptr<Cache<persistent> > c = cache.lock();
@@ -1822,11 +2842,12 @@ CacheBucket<persistent>::deallocateCacheEntryImpl(typename EntriesMap::iterator
     assert(cacheEntryIt != storage->end());
 
     ipc->size -= cacheEntryIt->second->size;
+    c->_imp->updateQuotaGroupsUsage(*cacheEntryIt->second, cacheEntryIt->second->size + cacheEntryIt->second->tileIndices.size() * c->_imp->tileSizeBytes, false /*added*/);
 
     // Clear allocated tiles for this entry
     if (!cacheEntryIt->second->tileIndices.empty()) {
 
-        ipc->size -= cacheEntryIt->second->tileIndices.size() * NATRON_TILE_SIZE_BYTES;
+        ipc->size -= cacheEntryIt->second->tileIndices.size() * c->_imp->tileSizeBytes;
 
         // Take the tilesStorageMutex in read mode to indicate that we are operating on it (flush)
         boost::scoped_ptr<Sharable_ReadLock> tileAlignedFileLock;
@@ -1836,34 +2857,76 @@ CacheBucket<persistent>::deallocateCacheEntryImpl(typename EntriesMap::iterator
         createTimedLock<Sharable_ReadLock>(c->_imp.get(), tileAlignedFileLock, &c->_imp->ipc->tilesStorageMutex);
 #endif
 
+        // Tiles to invalidate, flushed in contiguous ranges before they are made free again
+        TilesPerFileMap tilesToInvalidate;
+
+        ExternalSegmentTypeULongLongList::const_iterator localIt = cacheEntryIt->second->tileLocalIndices.begin();
         for (ExternalSegmentTypeULongLongList::const_iterator it = cacheEntryIt->second->tileIndices.begin(); it != cacheEntryIt->second->tileIndices.end(); ++it) {
 
             U32 fileIndex, tileIndex;
             getTileIndex(*it, &tileIndex, &fileIndex);
 
+            if (evictedTiles && localIt != cacheEntryIt->second->tileLocalIndices.end() && fileIndex < c->_imp->tilesStorage.size()) {
+                // Keep a copy of the tile: it will be compressed by the caller once the locks are released
+                EvictedTile evicted;
+                evicted.key = std::make_pair(cacheEntryIt->first, *localIt);
+                evicted.pluginID = std::string(cacheEntryIt->second->pluginID.c_str());
+                evicted.data = QByteArray(c->_imp->tilesStorage[fileIndex]->getData() + tileIndex * c->_imp->tileSizeBytes, (int)c->_imp->tileSizeBytes);
+                evictedTiles->push_back(evicted);
+            }
+            if (localIt != cacheEntryIt->second->tileLocalIndices.end()) {
+                ++localIt;
+            }
+
             if (persistent) {
-                // Invalidate this portion of the memory mapped file so it doesn't get written on disk
-                StoragePtrType storage;
-                if (fileIndex < c->_imp->tilesStorage.size()) {
-                    storage = c->_imp->tilesStorage[fileIndex];
-                }
-                if (storage) {
-                    std::size_t dataOffset = tileIndex * NATRON_TILE_SIZE_BYTES;
-                    flushMemory(storage, (int)MemoryFile::eFlushTypeInvalidate, storage->getData() + dataOffset, NATRON_TILE_SIZE_BYTES);
+                tilesToInvalidate[fileIndex].insert(tileIndex);
+            }
+        }
+
+        if (persistent) {
+            // The tiles content no longer needs to be written
+            {
+                QMutexLocker k(&c->_imp->ioThreadMutex);
+                for (TilesPerFileMap::const_iterator it = tilesToInvalidate.begin(); it != tilesToInvalidate.end(); ++it) {
+                    TilesPerFileMap::iterator foundFile = c->_imp->dirtyTiles.find(it->first);
+                    if (foundFile == c->_imp->dirtyTiles.end()) {
+                        continue;
+                    }
+                    for (std::set<U32>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
+                        if (foundFile->second.erase(*it2) > 0) {
+                            c->_imp->dirtyTilesSize -= c->_imp->tileSizeBytes;
+                        }
+                    }
+                    if (foundFile->second.empty()) {
+                        c->_imp->dirtyTiles.erase(foundFile);
+                    }
                 }
-                
             }
 
-            // Retrieve the bucket index directly from the tile index: we know that each file contains exactly NATRON_NUM_TILES_PER_BUCKET_FILE * NATRON_CACHE_BUCKETS_COUNT
-            int tileBucketIndex = tileIndex % NATRON_NUM_TILES_PER_BUCKET_FILE;
+            // Invalidate these portions of the memory mapped files so they don't get written on disk
+            c->_imp->flushTilesRanges(tilesToInvalidate, (int)MemoryFile::eFlushTypeInvalidate);
+        }
+
+        for (ExternalSegmentTypeULongLongList::const_iterator it = cacheEntryIt->second->tileIndices.begin(); it != cacheEntryIt->second->tileIndices.end(); ++it) {
+
+            U32 fileIndex, tileIndex;
+            getTileIndex(*it, &tileIndex, &fileIndex);
+
+            // Retrieve the bucket index directly from the tile index: we know that each file contains exactly nTilesPerBucketFile * NATRON_CACHE_BUCKETS_COUNT
+            // and that createTileStorage() gives each bucket a contiguous range of nTilesPerBucketFile tiles.
+            int tileBucketIndex = tileIndex / c->_imp->nTilesPerBucketFile;
             assert(tileBucketIndex >= 0 && tileBucketIndex < NATRON_CACHE_BUCKETS_COUNT);
-            // Take the bucket mutex except if this is the current bucket
+            // Take the ToC lock and the bucket mutex except if this is the current bucket.
+            // The ToC lock also ensures that this process attached the bucket.
+            boost::scoped_ptr<Sharable_ReadLock> tileBucketTocReadLock;
+            boost::scoped_ptr<Sharable_WriteLock> tileBucketTocWriteLock;
             boost::scoped_ptr<Sharable_WriteLock> bucketWriteLock;
             if (tileBucketIndex != bucketIndex) {
+                c->_imp->buckets[tileBucketIndex].checkToCMemorySegmentStatus(&tileBucketTocReadLock, &tileBucketTocWriteLock);
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
                 bucketWriteLock.reset(new Sharable_WriteLock(c->_imp->ipc->bucketsData[tileBucketIndex].bucketMutex));
 #else
-                createTimedLock<Sharable_WriteLock>(c->_imp.get(), *bucketWriteLock, &c->_imp->ipc->bucketsData[tileBucketIndex].bucketMutex);
+                createTimedLock<Sharable_WriteLock>(c->_imp.get(), bucketWriteLock, &c->_imp->ipc->bucketsData[tileBucketIndex].bucketMutex);
 #endif
             }
 
@@ -1872,11 +2935,13 @@ CacheBucket<persistent>::deallocateCacheEntryImpl(typename EntriesMap::iterator
             qDebug() << "Bucket" << bucketIndex << ": tile freed" << tileIndex << " Nb free tiles left:" << c->_imp->buckets[tileBucketIndex].ipc->freeTiles.size();
 #endif
             // free tiles are all shared in the FIRST bucket
+            BucketModification_RAII<persistent> modification(&c->_imp->buckets[tileBucketIndex]);
             std::pair<U64_Set::iterator, bool>  insertOk = c->_imp->buckets[tileBucketIndex].ipc->freeTiles.insert(*it);
             assert(insertOk.second);
             (void)insertOk;
         }
         cacheEntryIt->second->tileIndices.clear();
+        cacheEntryIt->second->tileLocalIndices.clear();
     }
 
 
@@ -1896,7 +2961,9 @@ CacheBucket<persistent>::deallocateCacheEntryImpl(typename EntriesMap::iterator
             ipc->lruListBack = cacheEntryIt->second->lruNode.prev;
         }
         if (&cacheEntryIt->second->lruNode == getRawPointer(ipc->lruListFront)) {
-            ipc->lruListFront = cacheEntryIt->second->lruNode.prev;
+            // We are the first node, we can't have a previous entry
+            assert(!cacheEntryIt->second->lruNode.prev);
+            ipc->lruListFront = cacheEntryIt->second->lruNode.next;
         }
 
         // Remove this entry's node from the list
@@ -1913,6 +2980,8 @@ CacheBucket<persistent>::deallocateCacheEntryImpl(typename EntriesMap::iterator
     qDebug() << QThread::currentThread() << cacheEntryIt->first << ": destroy entry";
 #endif
     storage->erase(cacheEntryIt);
+
+    c->_imp->removedEntriesCount.fetchAndAddRelaxed(1);
 } // deallocateCacheEntryImpl
 
 /*
@@ -2140,7 +3209,7 @@ CacheEntryLockerPrivate<persistent>::lookupAndCreate(boost::scoped_ptr<Sharable_
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
                         tocWriteLock.reset(new Sharable_WriteLock(cache->_imp->ipc->bucketsData[bucket->bucketIndex].tocData.segmentMutex));
 #else
-                        createTimedLock<Sharable_WriteLock>(cache->_imp.get(), *tocWriteLock, &cache->_imp->ipc->bucketsData[bucket->bucketIndex].tocData.segmentMutex);
+                        createTimedLock<Sharable_WriteLock>(cache->_imp.get(), tocWriteLock, &cache->_imp->ipc->bucketsData[bucket->bucketIndex].tocData.segmentMutex);
 #endif
                     }
 #ifdef DEBUG
@@ -2206,6 +3275,13 @@ CacheEntryLockerPrivate<persistent>::lookupAndCreate(boost::scoped_ptr<Sharable_
     cacheEntry->size = entryToCSize;
 
     cacheEntry->pluginID.append(processLocalEntry->getKey()->getHolderPluginID().c_str());
+    cacheEntry->holderHash = processLocalEntry->getKey()->getHolderHash();
+    {
+        std::string projectQuotaGroup, nodeQuotaGroup;
+        processLocalEntry->getKey()->getQuotaGroups(&projectQuotaGroup, &nodeQuotaGroup, &cacheEntry->isViewerOutput);
+        cacheEntry->projectQuotaGroup = cache->_imp->registerQuotaGroup(CacheBase::eCacheQuotaGroupProject, projectQuotaGroup);
+        cacheEntry->nodeQuotaGroup = cache->_imp->registerQuotaGroup(CacheBase::eCacheQuotaGroupNode, nodeQuotaGroup);
+    }
 
     // Lock the statusMutex: this will lock-out other threads interested in this entry.
     // This mutex is unlocked in deallocateCacheEntryImpl() or in insertInCache()
@@ -2230,11 +3306,10 @@ template <bool persistent>
 void
 CacheBucket<persistent>::checkToCMemorySegmentStatus(boost::scoped_ptr<Sharable_ReadLock>* tocReadLock, boost::scoped_ptr<Sharable_WriteLock>* tocWriteLock)
 {
-    boost::shared_ptr<Cache<persistent> > c = cache.lock();
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
-    tocReadLock->reset(new Sharable_ReadLock(c->_imp->ipc->bucketsData[bucketIndex].tocData.segmentMutex));
+    tocReadLock->reset(new Sharable_ReadLock(cacheImp->ipc->bucketsData[bucketIndex].tocData.segmentMutex));
 #else
-    createTimedLock<Sharable_ReadLock>(c->_imp.get(), *tocReadLock, &c->_imp->ipc->bucketsData[bucketIndex].tocData.segmentMutex);
+    createTimedLock<Sharable_ReadLock>(cacheImp, *tocReadLock, &cacheImp->ipc->bucketsData[bucketIndex].tocData.segmentMutex);
 #endif
 
     if (persistent) {
@@ -2246,9 +3321,9 @@ CacheBucket<persistent>::checkToCMemorySegmentStatus(boost::scoped_ptr<Sharable_
             tocReadLock->reset();
 
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
-            tocWriteLock->reset(new Sharable_WriteLock(c->_imp->ipc->bucketsData[bucketIndex].tocData.segmentMutex));
+            tocWriteLock->reset(new Sharable_WriteLock(cacheImp->ipc->bucketsData[bucketIndex].tocData.segmentMutex));
 #else
-            createTimedLock<Sharable_WriteLock>(c->_imp.get(), *tocWriteLock, &c->_imp->ipc->bucketsData[bucketIndex].tocData.segmentMutex);
+            createTimedLock<Sharable_WriteLock>(cacheImp, *tocWriteLock, &cacheImp->ipc->bucketsData[bucketIndex].tocData.segmentMutex);
 #endif
 
             remapToCMemoryFile(**tocWriteLock, 0);
@@ -2461,6 +3536,7 @@ CacheEntryLockerPrivate<persistent>::insertInternal()
     
     // Record the memory taken by the entry in the bucket
     bucket->ipc->size += cacheEntryIt->second->size;
+    cache->_imp->updateQuotaGroupsUsage(*cacheEntryIt->second, cacheEntryIt->second->size, true /*added*/);
 
     // Insert the hash in the LRU linked list
     // Lock the LRU list mutex
@@ -2493,6 +3569,7 @@ CacheEntryLockerPrivate<persistent>::insertInternal()
             bucket->ipc->lruListBack = thisNodePtr;
 
         }
+        bucket->updateEvictionPriority(cacheEntryIt->second.get());
     } // lruWriteLock
     cacheEntryIt->second->computeThreadMagic = 0;
     cacheEntryIt->second->status = MemorySegmentEntryHeaderBase::eEntryStatusReady;
@@ -2549,7 +3626,7 @@ CacheEntryLocker<persistent>::insertInCache()
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
                 tocWriteLock.reset(new Sharable_WriteLock(_imp->cache->_imp->ipc->bucketsData[_imp->bucket->bucketIndex].tocData.segmentMutex));
 #else
-                createTimedLock<Sharable_WriteLock>(_imp->cache->->_imp.get(), tocWriteLock, &_imp->cache->_imp->ipc->bucketsData[_imp->bucket->bucketIndex].tocData.segmentMutex);
+                createTimedLock<Sharable_WriteLock>(_imp->cache->_imp.get(), tocWriteLock, &_imp->cache->_imp->ipc->bucketsData[_imp->bucket->bucketIndex].tocData.segmentMutex);
 #endif
             }
             // Grow the file
@@ -2557,6 +3634,9 @@ CacheEntryLocker<persistent>::insertInCache()
 
             ++attempt_i;
         }
+        // Wake up the threads of this process waiting for the entry
+        _imp->bucket->notifyPendingEntriesChanged();
+
         if (!ok) {
             return;
         }
@@ -2587,6 +3667,7 @@ CacheEntryLocker<persistent>::waitForPendingEntry(std::size_t timeout)
     // The thread can only wait if the status was set to eCacheEntryStatusComputationPending
     assert(_imp->status == eCacheEntryStatusComputationPending);
     assert(_imp->processLocalEntry);
+    assert(_imp->bucket);
 
     // If this thread is a threadpool thread, it may wait for a while that results gets available.
     // Release the thread to the thread pool so that it may use this thread for other runnables
@@ -2615,11 +3696,18 @@ CacheEntryLocker<persistent>::waitForPendingEntry(std::size_t timeout)
     //
     // Instead we chose a "polling" method: we lookup the entry every X ms: this has the advantage not to retain any cache mutex
     // so the amount of time we wait is really just imparing this thead rather than the whole cache bucket.
+    // When the entry is computed by a thread of this process, the wait is interrupted as soon as it is inserted or released,
+    // see CacheBucket::notifyPendingEntriesChanged(). The polling is only a fallback for entries computed by other processes.
 
     std::size_t timeSpentWaitingForPendingEntryMS = 0;
     std::size_t timeToWaitMS = 20;
 
+    TimeLapse waitTimer;
+
     do {
+        // Read the generation before the look-up so that an insertion in-between is not missed
+        U64 generation = _imp->bucket->getPendingEntriesGeneration();
+
         // Look up the cache and sleep if not found
         _imp->lookupAndSetStatus(&timeSpentWaitingForPendingEntryMS, timeout);
 
@@ -2627,7 +3715,7 @@ CacheEntryLocker<persistent>::waitForPendingEntry(std::size_t timeout)
 
             timeSpentWaitingForPendingEntryMS += timeToWaitMS;
             if (timeout == 0 || timeSpentWaitingForPendingEntryMS < timeout) {
-                CacheEntryLockerBase::sleep_milliseconds(timeToWaitMS);
+                _imp->bucket->waitForPendingEntriesChanged(generation, timeToWaitMS);
 
                 // Increase the time to wait at the next iteration
                 timeToWaitMS *= 1.2;
@@ -2637,6 +3725,8 @@ CacheEntryLocker<persistent>::waitForPendingEntry(std::size_t timeout)
 
     } while(_imp->status == eCacheEntryStatusComputationPending);
 
+    _imp->bucket->recordPendingWait(_imp->processLocalEntry->getKey()->getHolderPluginID(), waitTimer.getTimeSinceCreation() * 1000.);
+
     // Concurrency resumes!
 
     if (hasReleasedThread) {
@@ -2699,20 +3789,29 @@ CacheEntryLocker<persistent>::~CacheEntryLocker()
 #endif
                                                             );
         }
+
+        // The threads of this process waiting for the entry may now compute it
+        _imp->bucket->notifyPendingEntriesChanged();
     }
 } // ~CacheEntryLocker
 
 
 template <bool persistent>
-Cache<persistent>::Cache(bool enableTileStorage)
-: _imp(new CachePrivate<persistent>(this, enableTileStorage))
+Cache<persistent>::Cache(bool enableTileStorage, int tileSizePo2)
+: _imp(new CachePrivate<persistent>(this, enableTileStorage, tileSizePo2))
 {
 
 }
 template <bool persistent>
 Cache<persistent>::~Cache()
 {
-
+    // The writers hold a pointer to _imp
+    _imp->bucketsAttacherMustQuit.fetchAndStoreOrdered(1);
+    _imp->bucketsAttacher.waitForDone();
+    _imp->remoteTierWriters.waitForDone();
+    _imp->discardedStorageDeleter.waitForDone();
+    _imp->quitIOThread();
+    _imp->closeJournal();
 }
 
 template <bool persistent>
@@ -2852,6 +3951,13 @@ Cache<persistent>::initialize(const boost::shared_ptr<Cache<persistent> >& thisS
 
     }
 
+    // Open the journal while we still have the file lock in write mode so that no other process
+    // writes it concurrently. If it cannot be trusted, the whole cache is wiped below.
+    bool journalValid = true;
+    if (persistent) {
+        journalValid = _imp->openJournal();
+    }
+
     if (persistent && gotFileLock) {
         _imp->globalFileLock->unlock();
         // Indicate that we use the shared memory by taking the file lock in read mode.
@@ -2862,10 +3968,12 @@ Cache<persistent>::initialize(const boost::shared_ptr<Cache<persistent> >& thisS
     }
 
 
-    // Open each bucket individual memory segment.
+    // Each bucket has its individual memory segment.
     // They are not created in shared memory but in a memory mapped file instead
     // to be persistent when the OS shutdown.
     // Each segment controls the table of content of the bucket.
+    // For a persistent cache the files are only opened when the bucket is first accessed, see remapToCMemoryFile():
+    // attaching to the cache does not depend on its size.
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
     SHMReadLockerPtr shmReader(new SharedMemoryProcessLocalReadLocker(_imp.get()));
 #endif
@@ -2875,6 +3983,7 @@ Cache<persistent>::initialize(const boost::shared_ptr<Cache<persistent> >& thisS
 
         // Hold a weak pointer to the cache on the bucket
         _imp->buckets[i].cache = thisShared;
+        _imp->buckets[i].cacheImp = _imp.get();
         _imp->buckets[i].bucketIndex = i;
         
 
@@ -2884,16 +3993,14 @@ Cache<persistent>::initialize(const boost::shared_ptr<Cache<persistent> >& thisS
             // Get the bucket directory path. It ends with a separator.
             QString bucketDirPath = _imp->getBucketAbsoluteDirPath(i);
 
-            std::string tocFilePath = bucketDirPath.toStdString() + "Index";
-            openStorage(_imp->buckets[i].tocFile, tocFilePath, (int)MemoryFile::eFileOpenModeOpenOrCreate);
-            
+            _imp->buckets[i].tocFilePath = bucketDirPath.toStdString() + "Index";
         }
         
         
     } // for each bucket
 
-    // Remap each bucket, this may potentially fail
-    for (int i = 0; i < NATRON_CACHE_BUCKETS_COUNT; ++i) {
+    // Remap each bucket of a process local cache, this may potentially fail
+    for (int i = 0; !persistent && i < NATRON_CACHE_BUCKETS_COUNT; ++i) {
         try {
 
             boost::scoped_ptr<Sharable_WriteLock> tocWriteLock;
@@ -2920,6 +4027,11 @@ Cache<persistent>::initialize(const boost::shared_ptr<Cache<persistent> >& thisS
 
     if (persistent) {
 
+        if (!journalValid) {
+            // The tables of content of the buckets may reference tiles with another size or another layout:
+            // they are wiped by clear() below, after the tiles storage files are removed.
+            _imp->tilesStorageInvalid = true;
+        }
 
         try {
 
@@ -2929,16 +4041,31 @@ Cache<persistent>::initialize(const boost::shared_ptr<Cache<persistent> >& thisS
             writeLock.reset(new Sharable_WriteLock(_imp->ipc->tilesStorageMutex));
 #else
             // Take read lock on the tile data
-            createTimedLock<Sharable_WriteLock>(_imp.get(), writeLock, _imp->ipc->tilesStorageMutex);
+            createTimedLock<Sharable_WriteLock>(_imp.get(), writeLock, &_imp->ipc->tilesStorageMutex);
 #endif
             _imp->reOpenTileStorage();
-            if (_imp->tilesStorage.empty()) {
+            if (journalValid && _imp->tilesStorage.empty()) {
                 // Ensure we initialize the cache with at least one tile storage file
                 _imp->createTileStorage();
             }
         } catch (const CorruptedCacheException&) {
+            journalValid = false;
+        }
+
+        if (!journalValid) {
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+            // clear() may remap the shared memory: it must not be read-locked by this thread
+            shmReader.reset();
+#endif
             clear();
         }
+
+        if (_imp->useTileStorage) {
+            _imp->startIOThread();
+        }
+
+        // Attach the buckets that are not accessed by the first renders in the background
+        _imp->bucketsAttacher.start( new CacheBucketsAttacher<persistent>(_imp.get()) );
     } // persistent
     
     
@@ -2947,9 +4074,9 @@ Cache<persistent>::initialize(const boost::shared_ptr<Cache<persistent> >& thisS
 
 template <bool persistent>
 CacheBasePtr
-Cache<persistent>::create(bool enableTileStorage)
+Cache<persistent>::create(bool enableTileStorage, int tileSizePo2)
 {
-    boost::shared_ptr<Cache<persistent> > ret (new Cache<persistent>(enableTileStorage));
+    boost::shared_ptr<Cache<persistent> > ret (new Cache<persistent>(enableTileStorage, tileSizePo2));
     ret->initialize(ret);
     return ret;
 } // create
@@ -2965,6 +4092,10 @@ struct CacheTilesLockImpl
     boost::scoped_ptr<Sharable_ReadLock> tileReadLock;
     boost::scoped_ptr<Sharable_WriteLock> tileWriteLock;
 
+    // The encoded indices of the tiles allocated by retrieveAndLockTiles(): the caller writes them
+    // and they must be flushed afterwards.
+    std::vector<U64> allocatedTiles;
+
     CacheTilesLockImpl()
     {
 
@@ -2980,6 +4111,89 @@ struct CacheTilesLockImpl
 
 };
 
+template <bool persistent>
+void
+CachePrivate<persistent>::discardTilesStorage()
+{
+    // The lock must be taken in write mode
+    assert(!ipc->tilesStorageMutex.try_lock());
+
+    if (tilesStorage.empty()) {
+        return;
+    }
+
+    std::vector<StoragePtrType> discardedStorage;
+    for (std::size_t i = 0; i < tilesStorage.size(); ++i) {
+        bool renamed = true;
+        if (persistent) {
+            // The name does not match "TilesStorage*" so that reOpenTileStorage() ignores it
+            std::stringstream ss;
+            ss << directoryContainingCachePath << "/" <<  NATRON_CACHE_DIRECTORY_NAME << "/DiscardedTilesStorage" << QCoreApplication::applicationPid() << "_" << discardedStorageCount << "_" << i + 1;
+            renamed = renameStorage(tilesStorage[i], ss.str());
+        }
+        if (renamed) {
+            discardedStorage.push_back(tilesStorage[i]);
+        } else {
+            // The file cannot be renamed while it is mapped on some platforms: remove it now since
+            // a new file is created with the same name
+            clearStorage(tilesStorage[i]);
+        }
+    }
+    ++discardedStorageCount;
+    tilesStorage.clear();
+
+    if (!discardedStorage.empty()) {
+        discardedStorageDeleter.start( new DiscardedTilesStorageDeleter<persistent>(discardedStorage) );
+    }
+} // discardTilesStorage
+
+template <bool persistent>
+void
+CacheBucketsAttacher<persistent>::run()
+{
+    // Renders attach the buckets they access themselves: this only needs the idle time of the machine
+    QThread::currentThread()->setPriority(QThread::LowestPriority);
+    _imp->attachBuckets();
+}
+
+template <bool persistent>
+void
+CachePrivate<persistent>::attachBuckets()
+{
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+    SHMReadLockerPtr shmReader(new SharedMemoryProcessLocalReadLocker(this));
+#endif
+
+    for (int i = 0; i < NATRON_CACHE_BUCKETS_COUNT; ++i) {
+        if (bucketsAttacherMustQuit.fetchAndAddOrdered(0)) {
+            return;
+        }
+        try {
+            // This remaps the bucket if it is not attached yet
+            boost::scoped_ptr<Sharable_ReadLock> tocReadLock;
+            boost::scoped_ptr<Sharable_WriteLock> tocWriteLock;
+            buckets[i].checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
+        } catch (...) {
+            // Any exception caught here means the cache is corrupted
+            recoverFromInconsistentState(
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+                                         shmReader
+#endif
+                                         );
+            return;
+        }
+    }
+} // attachBuckets
+
+template <bool persistent>
+void
+DiscardedTilesStorageDeleter<persistent>::run()
+{
+    for (std::size_t i = 0; i < _storage.size(); ++i) {
+        clearStorage(_storage[i]);
+    }
+}
+
 template <bool persistent>
 void
 CachePrivate<persistent>::createTileStorage()
@@ -2990,19 +4204,26 @@ CachePrivate<persistent>::createTileStorage()
     // The lock must be taken in write mode
     assert(!ipc->tilesStorageMutex.try_lock());
 
+    // Do not re-create a file that another process created
+    mapTileStorageFilesCreatedByOtherProcesses();
+
     StoragePtrType data(new StorageType);
     if (persistent) {
         std::stringstream ss;
         ss << directoryContainingCachePath << "/" <<  NATRON_CACHE_DIRECTORY_NAME << "/TilesStorage" << tilesStorage.size() + 1;
         openStorage(data, ss.str(), (int)MemoryFile::eFileOpenModeOpenOrCreate);
+    } else {
+        boost::unique_lock<boost::mutex> k(maximumSizeMutex);
+        setStorageAllocationPolicy(data, tileStoragePages, tileStorageInterleaveNUMANodes);
     }
     resizeStorage(data, NATRON_TILE_STORAGE_FILE_SIZE);
 
     U64 fileIndex = tilesStorage.size();
     tilesStorage.push_back(data);
+    ipc->nTilesStorageFiles = tilesStorage.size();
 
     // The number of tiles should be a multiple of the buckets count
-    assert(NATRON_NUM_TILES_PER_FILE % NATRON_CACHE_BUCKETS_COUNT == 0);
+    assert((NATRON_TILE_STORAGE_FILE_SIZE / tileSizeBytes) % NATRON_CACHE_BUCKETS_COUNT == 0);
 
 #ifdef CACHE_TRACE_TILES_ALLOCATION
     std::cout << "=============================================\nFree tiles state:\n\n";
@@ -3014,19 +4235,15 @@ CachePrivate<persistent>::createTileStorage()
         boost::scoped_ptr<Sharable_ReadLock> tocReadLock;
         boost::scoped_ptr<Sharable_WriteLock> tocWriteLock;
 
-        // Take the ToC write lock
-#ifndef NATRON_CACHE_INTERPROCESS_ROBUST
-        tocReadLock.reset(new Sharable_ReadLock(ipc->bucketsData[bucket_i].tocData.segmentMutex));
-#else
-        createTimedLock<Sharable_ReadLock>(_imp.get(), *tocReadLock, &ipc->bucketsData[bucket_i].tocData.segmentMutex);
-#endif
+        // Take the ToC read lock, this attaches the bucket if needed
+        buckets[bucket_i].checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
 
 
         // Take the bucket mutex
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
         bucketWriteLock.reset(new Sharable_WriteLock(ipc->bucketsData[bucket_i].bucketMutex));
 #else
-        createTimedLock<Sharable_WriteLock>(_imp.get(), *bucketWriteLock, &ipc->bucketsData[bucket_i].bucketMutex);
+        createTimedLock<Sharable_WriteLock>(this, bucketWriteLock, &ipc->bucketsData[bucket_i].bucketMutex);
 #endif
         
         
@@ -3042,8 +4259,8 @@ CachePrivate<persistent>::createTileStorage()
         // First insert in a temporary set and then assign to the free tiles set to avoid out of memory exceptions
         std::set<U64> tmpSet;
         tmpSet.insert(buckets[bucket_i].ipc->freeTiles.begin(), buckets[bucket_i].ipc->freeTiles.end());
-        U64 nTiles = bucket_i * NATRON_NUM_TILES_PER_BUCKET_FILE;
-        for (U64 i = nTiles; i < nTiles + NATRON_NUM_TILES_PER_BUCKET_FILE; ++i) {
+        U64 nTiles = bucket_i * nTilesPerBucketFile;
+        for (U64 i = nTiles; i < nTiles + nTilesPerBucketFile; ++i) {
             U64 encodedIndex = 0;
             encodedIndex = ((i << 32) | fileIndex);
             tmpSet.insert(encodedIndex);
@@ -3053,6 +4270,7 @@ CachePrivate<persistent>::createTileStorage()
             int nAttempts = 0;
             while (nAttempts < 2) {
                 try {
+                    BucketModification_RAII<persistent> modification(&buckets[bucket_i]);
                     buckets[bucket_i].ipc->freeTiles.clear();
                     buckets[bucket_i].ipc->freeTiles.insert(tmpSet.begin(), tmpSet.end());
                     break;
@@ -3069,7 +4287,7 @@ CachePrivate<persistent>::createTileStorage()
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
                         tocWriteLock.reset(new Sharable_WriteLock(ipc->bucketsData[bucket_i].tocData.segmentMutex));
 #else
-                        createTimedLock<Sharable_WriteLock>(c->_imp.get(), tocWriteLock, &ipc->bucketsData[bucket_i].tocData.segmentMutex);
+                        createTimedLock<Sharable_WriteLock>(this, tocWriteLock, &ipc->bucketsData[bucket_i].tocData.segmentMutex);
 #endif
                     }
 
@@ -3079,7 +4297,7 @@ CachePrivate<persistent>::createTileStorage()
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
                     bucketWriteLock.reset(new Sharable_WriteLock(ipc->bucketsData[bucket_i].bucketMutex));
 #else
-                    createTimedLock<Sharable_WriteLock>(_imp.get(), *bucketWriteLock, &ipc->bucketsData[bucket_i].bucketMutex);
+                    createTimedLock<Sharable_WriteLock>(this, bucketWriteLock, &ipc->bucketsData[bucket_i].bucketMutex);
 #endif
                 }
                 ++nAttempts;
@@ -3111,13 +4329,46 @@ CachePrivate<true>::reOpenTileStorage()
         dirPath = QString::fromUtf8(ss.str().c_str());
     }
     QDir d(dirPath);
+
+    // Files dropped by a clear() of a process that exited before they were removed
+    {
+        QStringList discardedFilters;
+        discardedFilters.push_back(QString::fromUtf8("DiscardedTilesStorage*"));
+        QStringList discardedFiles = d.entryList(discardedFilters, QDir::Files | QDir::NoDotAndDotDot);
+        for (QStringList::iterator it = discardedFiles.begin(); it != discardedFiles.end(); ++it) {
+            d.remove(*it);
+        }
+    }
+
     QStringList nameFilters;
     nameFilters.push_back(QString::fromUtf8("TilesStorage*"));
-    QStringList files = d.entryList(nameFilters, QDir::Files | QDir::NoDotAndDotDot, QDir::Name /*sort by name*/);
-    files.sort();
+    QStringList files = d.entryList(nameFilters, QDir::Files | QDir::NoDotAndDotDot);
+
+    // The file index is encoded in the tile indices: files must be mapped in the order of their number
+    // (i.e: TilesStorage10 after TilesStorage9), which is the same in all processes.
+    std::map<int, QString> filesPerIndex;
     for (QStringList::iterator it = files.begin(); it != files.end(); ++it) {
+        if (tilesStorageInvalid) {
+            // The tiles in this file are no longer referenced by any table of content (e.g: they were
+            // created with a different tile size): remove it.
+            d.remove(*it);
+            continue;
+        }
+        bool ok;
+        int fileNumber = it->mid(12 /*length of TilesStorage*/).toInt(&ok);
+        if (ok && fileNumber > 0) {
+            filesPerIndex[fileNumber] = *it;
+        }
+    }
+    tilesStorageInvalid = false;
+
+    for (std::map<int, QString>::iterator it = filesPerIndex.begin(); it != filesPerIndex.end(); ++it) {
+        if (it->first != (int)tilesStorage.size() + 1) {
+            // A file is missing: the tiles indices of the following files would be wrong
+            throw CorruptedCacheException();
+        }
+        std::string filePath = dirPath.toStdString() + "/" + it->second.toStdString();
         MemoryFilePtr data(new MemoryFile);
-        std::string filePath = dirPath.toStdString() + "/" + it->toStdString();
         (data)->open(filePath, MemoryFile::eFileOpenModeOpenOrCreate);
         if ((data)->size() != NATRON_TILE_STORAGE_FILE_SIZE) {
             (data)->resize(NATRON_TILE_STORAGE_FILE_SIZE, false);
@@ -3125,8 +4376,35 @@ CachePrivate<true>::reOpenTileStorage()
         tilesStorage.push_back(data);
     }
 
+    // Another process may already have the cache opened with the same files
+    ipc->nTilesStorageFiles = std::max(ipc->nTilesStorageFiles, (U32)tilesStorage.size());
+
 }
 
+template <>
+void
+CachePrivate<false>::mapTileStorageFilesCreatedByOtherProcesses() {}
+
+template <>
+void
+CachePrivate<true>::mapTileStorageFilesCreatedByOtherProcesses()
+{
+    // The lock must be taken in write mode
+    assert(!ipc->tilesStorageMutex.try_lock());
+
+    while (tilesStorage.size() < ipc->nTilesStorageFiles) {
+        std::stringstream ss;
+        ss << directoryContainingCachePath << "/" <<  NATRON_CACHE_DIRECTORY_NAME << "/TilesStorage" << tilesStorage.size() + 1;
+        MemoryFilePtr data(new MemoryFile);
+        data->open(ss.str(), MemoryFile::eFileOpenModeOpenOrCreate);
+        if (data->size() != NATRON_TILE_STORAGE_FILE_SIZE) {
+            // The file was created by another process, it should have its final size already
+            throw CorruptedCacheException();
+        }
+        tilesStorage.push_back(data);
+    }
+} // mapTileStorageFilesCreatedByOtherProcesses
+
 static int getBucketIndexForTile(U64 entryHash, U64 tileIndex)
 {
     return CacheBase::getBucketCacheBucketIndex(entryHash + tileIndex);
@@ -3156,18 +4434,350 @@ CachePrivate<persistent>::freeAllocatedTiles(U64 entryHash, const std::vector<U6
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
             bucketWriteLock.reset(new Sharable_WriteLock(ipc->bucketsData[bucketIndex].bucketMutex));
 #else
-            createTimedLock<Sharable_WriteLock>(_imp.get(), bucketWriteLock, &_imp->ipc->bucketsData[bucketIndex].bucketMutex);
+            createTimedLock<Sharable_WriteLock>(this, bucketWriteLock, &ipc->bucketsData[bucketIndex].bucketMutex);
 #endif
         }
 
         // Re-insert the tile index in the freeTiles list. Since we are adding data, this may throw an exception
         // because the ToC might run out of memory. In this case, we grow it and try again.
+        BucketModification_RAII<persistent> modification(&tileBucket);
         tileBucket.ipc->freeTiles.insert(allocatedTiles[i].first);
 
     } // for each allocated tile
 
 } // freeAllocatedTiles
 
+template <bool persistent>
+void
+CachePrivate<persistent>::markTilesDirty(const std::vector<U64>& encodedTileIndices)
+{
+    QMutexLocker k(&ioThreadMutex);
+    for (std::vector<U64>::const_iterator it = encodedTileIndices.begin(); it != encodedTileIndices.end(); ++it) {
+        U32 fileIndex, tileIndex;
+        getTileIndex(*it, &tileIndex, &fileIndex);
+        if (dirtyTiles[fileIndex].insert(tileIndex).second) {
+            dirtyTilesSize += tileSizeBytes;
+        }
+    }
+    if (dirtyTilesHighWatermark > 0 && dirtyTilesSize >= dirtyTilesHighWatermark) {
+        ioThreadCond.wakeOne();
+    }
+} // markTilesDirty
+
+/**
+ * @brief Merge the given sorted tile indices in ranges of contiguous tiles [first, last].
+ * Tiles separated by at most maxGapTiles tiles are merged in the same range.
+ **/
+static void
+getContiguousTilesRanges(const std::set<U32>& tiles, U32 maxGapTiles, std::vector<std::pair<U32, U32> >* ranges)
+{
+    std::set<U32>::const_iterator tileIt = tiles.begin();
+    while (tileIt != tiles.end()) {
+        // Extend the range as long as the next tile follows
+        U32 firstTile = *tileIt;
+        U32 lastTile = firstTile;
+        ++tileIt;
+        while (tileIt != tiles.end() && *tileIt <= lastTile + 1 + maxGapTiles) {
+            lastTile = *tileIt;
+            ++tileIt;
+        }
+        ranges->push_back(std::make_pair(firstTile, lastTile));
+    }
+} // getContiguousTilesRanges
+
+template <bool persistent>
+void
+CachePrivate<persistent>::flushTilesRanges(const TilesPerFileMap& tiles, int flushType)
+{
+    // Never merge ranges when invalidating: this would discard the tiles inbetween
+    U32 maxGapTiles = 0;
+    if (flushType != (int)MemoryFile::eFlushTypeInvalidate) {
+        maxGapTiles = NATRON_CACHE_FLUSH_MAX_GAP_BYTES / tileSizeBytes;
+    }
+
+    for (TilesPerFileMap::const_iterator it = tiles.begin(); it != tiles.end(); ++it) {
+        if (it->first >= tilesStorage.size() || !tilesStorage[it->first]) {
+            // The file was removed since
+            continue;
+        }
+        const StoragePtrType& storage = tilesStorage[it->first];
+        char* data = storage->getData();
+
+        std::vector<std::pair<U32, U32> > ranges;
+        getContiguousTilesRanges(it->second, maxGapTiles, &ranges);
+        for (std::size_t i = 0; i < ranges.size(); ++i) {
+            flushMemory(storage, flushType, data + ranges[i].first * tileSizeBytes, (ranges[i].second - ranges[i].first + 1) * tileSizeBytes);
+        }
+    }
+} // flushTilesRanges
+
+template <bool persistent>
+void
+CachePrivate<persistent>::flushDirtyTiles(int flushType)
+{
+    if (!persistent || !useTileStorage) {
+        return;
+    }
+
+    TilesPerFileMap tiles;
+    {
+        QMutexLocker k(&ioThreadMutex);
+        tiles.swap(dirtyTiles);
+        dirtyTilesSize = 0;
+    }
+    if (tiles.empty()) {
+        return;
+    }
+
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+    SHMReadLockerPtr shmReader(new SharedMemoryProcessLocalReadLocker(this));
+#endif
+    try {
+        // Take the tilesStorageMutex in read mode to indicate that we are operating on it (flush)
+        boost::scoped_ptr<Sharable_ReadLock> tileReadLock;
+#ifndef NATRON_CACHE_INTERPROCESS_ROBUST
+        tileReadLock.reset(new Sharable_ReadLock(ipc->tilesStorageMutex));
+#else
+        createTimedLock<Sharable_ReadLock>(this, tileReadLock, &ipc->tilesStorageMutex);
+#endif
+        flushTilesRanges(tiles, flushType);
+    } catch (...) {
+        // Any exception caught here means the cache is corrupted
+        recoverFromInconsistentState(
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+                                     shmReader
+#endif
+                                     );
+    }
+} // flushDirtyTiles
+
+template <bool persistent>
+void
+CachePrivate<persistent>::prefetchEntriesInternal(const std::vector<U64>& holderHashes)
+{
+    std::set<U64> holderHashesSet(holderHashes.begin(), holderHashes.end());
+    holderHashesSet.erase(0);
+    if (holderHashesSet.empty()) {
+        return;
+    }
+
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+    SHMReadLockerPtr shmReader(new SharedMemoryProcessLocalReadLocker(this));
+#endif
+
+    // Walking the entries faults in the table of content of each bucket
+    TilesPerFileMap tilesToPrefetch;
+    for (int bucket_i = 0; bucket_i < NATRON_CACHE_BUCKETS_COUNT; ++bucket_i) {
+        CacheBucket<persistent>& bucket = buckets[bucket_i];
+
+        try {
+            // Take the read lock on the toc file mapping
+            boost::scoped_ptr<Sharable_ReadLock> tocReadLock;
+            boost::scoped_ptr<Sharable_WriteLock> tocWriteLock;
+            bucket.checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
+
+            // Take read lock on the bucket
+            boost::scoped_ptr<Sharable_ReadLock> bucketLock;
+#ifndef NATRON_CACHE_INTERPROCESS_ROBUST
+            bucketLock.reset(new Sharable_ReadLock(ipc->bucketsData[bucket_i].bucketMutex));
+#else
+            createTimedLock<Sharable_ReadLock>(this, bucketLock, &ipc->bucketsData[bucket_i].bucketMutex);
+#endif
+
+            for (typename CacheBucket<persistent>::EntriesMap::const_iterator it = bucket.ipc->entriesMap.begin(); it != bucket.ipc->entriesMap.end(); ++it) {
+                if (it->second->status != MemorySegmentEntryHeaderBase::eEntryStatusReady ||
+                    holderHashesSet.find(it->second->holderHash) == holderHashesSet.end()) {
+                    continue;
+                }
+                for (ExternalSegmentTypeULongLongList::const_iterator it2 = it->second->tileIndices.begin(); it2 != it->second->tileIndices.end(); ++it2) {
+                    U32 fileIndex, tileIndex;
+                    getTileIndex(*it2, &tileIndex, &fileIndex);
+                    tilesToPrefetch[fileIndex].insert(tileIndex);
+                }
+            }
+        } catch (...) {
+            // Any exception caught here means the cache is corrupted
+            recoverFromInconsistentState(
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+                                         shmReader
+#endif
+                                         );
+            return;
+        }
+    } // for each bucket
+
+    if (tilesToPrefetch.empty()) {
+        return;
+    }
+
+    try {
+        // Take the tilesStorageMutex in read mode to indicate that we are operating on it
+        boost::scoped_ptr<Sharable_ReadLock> tileReadLock;
+#ifndef NATRON_CACHE_INTERPROCESS_ROBUST
+        tileReadLock.reset(new Sharable_ReadLock(ipc->tilesStorageMutex));
+#else
+        createTimedLock<Sharable_ReadLock>(this, tileReadLock, &ipc->tilesStorageMutex);
+#endif
+        for (TilesPerFileMap::const_iterator it = tilesToPrefetch.begin(); it != tilesToPrefetch.end(); ++it) {
+            if (it->first >= tilesStorage.size() || !tilesStorage[it->first]) {
+                continue;
+            }
+            const StoragePtrType& storage = tilesStorage[it->first];
+            char* data = storage->getData();
+
+            // Do not merge ranges: this would read from the disk tiles that were not requested
+            std::vector<std::pair<U32, U32> > ranges;
+            getContiguousTilesRanges(it->second, 0, &ranges);
+            for (std::size_t i = 0; i < ranges.size(); ++i) {
+                prefetchMemory(storage, data + ranges[i].first * tileSizeBytes, (ranges[i].second - ranges[i].first + 1) * tileSizeBytes);
+            }
+        }
+    } catch (...) {
+        // Any exception caught here means the cache is corrupted
+        recoverFromInconsistentState(
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+                                     shmReader
+#endif
+                                     );
+    }
+} // prefetchEntriesInternal
+
+template <bool persistent>
+void
+CachePrivate<persistent>::startIOThread()
+{
+    assert(!ioThread);
+    ioThread.reset(new CacheIOThread<persistent>(this));
+    ioThread->start();
+}
+
+template <bool persistent>
+void
+CachePrivate<persistent>::quitIOThread()
+{
+    if (!ioThread) {
+        return;
+    }
+    {
+        QMutexLocker k(&ioThreadMutex);
+        ioThreadMustQuit = true;
+        ioThreadCond.wakeOne();
+    }
+    ioThread->wait();
+    ioThread.reset();
+}
+
+template <bool persistent>
+void
+CacheIOThread<persistent>::run()
+{
+    for (;;) {
+        std::vector<U64> prefetchRequest;
+        bool hasPrefetchRequest = false;
+        {
+            QMutexLocker k(&_imp->ioThreadMutex);
+            bool highWatermarkReached = _imp->dirtyTilesHighWatermark > 0 && _imp->dirtyTilesSize >= _imp->dirtyTilesHighWatermark;
+            if (!_imp->ioThreadMustQuit && !highWatermarkReached && _imp->prefetchRequests.empty()) {
+                _imp->ioThreadCond.wait(&_imp->ioThreadMutex, NATRON_CACHE_FLUSH_INTERVAL_MS);
+            }
+            if (_imp->ioThreadMustQuit) {
+                return;
+            }
+            if (!_imp->prefetchRequests.empty()) {
+                prefetchRequest.swap(_imp->prefetchRequests.front());
+                _imp->prefetchRequests.pop_front();
+                hasPrefetchRequest = true;
+            }
+        }
+
+        // We are not on a render thread, so wait for the data to be written: this way the next batch of tiles
+        // does not pile up in the I/O queue whilst the previous one is still being written.
+        _imp->flushDirtyTiles((int)MemoryFile::eFlushTypeSync);
+
+        if (hasPrefetchRequest) {
+            _imp->prefetchEntriesInternal(prefetchRequest);
+        }
+    }
+} // run
+
+template <bool persistent>
+void
+CachePrivate<persistent>::insertCompressedTiles(const std::vector<EvictedTile>& evictedTiles)
+{
+    if (evictedTiles.empty()) {
+        return;
+    }
+    {
+        boost::unique_lock<boost::mutex> k(compressedTierMutex);
+        if (compressedTierMaximumSize == 0) {
+            return;
+        }
+    }
+
+    // Compress outside of the lock. Use the fastest compression level: we only want to remove
+    // the redundancy of typical image tiles (constant areas, unused alpha, etc...)
+    std::vector<QByteArray> compressedData(evictedTiles.size());
+    for (std::size_t i = 0; i < evictedTiles.size(); ++i) {
+        compressedData[i] = qCompress(evictedTiles[i].data, 1);
+    }
+
+    boost::unique_lock<boost::mutex> k(compressedTierMutex);
+    for (std::size_t i = 0; i < evictedTiles.size(); ++i) {
+
+        // Do not keep tiles that do not compress
+        if (compressedData[i].isEmpty() || compressedData[i].size() >= evictedTiles[i].data.size()) {
+            continue;
+        }
+
+        CompressedTilesMap::iterator found = compressedTiles.find(evictedTiles[i].key);
+        if (found != compressedTiles.end()) {
+            compressedTierSize -= found->second.data.size();
+            compressedTilesLRU.erase(found->second.lruIt);
+            compressedTiles.erase(found);
+        }
+
+        compressedTilesLRU.push_back(evictedTiles[i].key);
+
+        CompressedTile& tile = compressedTiles[evictedTiles[i].key];
+        tile.data = compressedData[i];
+        tile.pluginID = evictedTiles[i].pluginID;
+        tile.lruIt = --compressedTilesLRU.end();
+        compressedTierSize += tile.data.size();
+    }
+    trimCompressedTier();
+} // insertCompressedTiles
+
+template <bool persistent>
+void
+CachePrivate<persistent>::removeCompressedTiles(U64 entryHash)
+{
+    boost::unique_lock<boost::mutex> k(compressedTierMutex);
+
+    // All tiles of the entry are contiguous in the map since they are sorted by entry hash first
+    CompressedTilesMap::iterator it = compressedTiles.lower_bound(std::make_pair(entryHash, (U64)0));
+    while (it != compressedTiles.end() && it->first.first == entryHash) {
+        compressedTierSize -= it->second.data.size();
+        compressedTilesLRU.erase(it->second.lruIt);
+        compressedTiles.erase(it++);
+    }
+} // removeCompressedTiles
+
+template <bool persistent>
+void
+CachePrivate<persistent>::trimCompressedTier()
+{
+    // The compressedTierMutex must be held
+    while (compressedTierSize > compressedTierMaximumSize && !compressedTilesLRU.empty()) {
+        CompressedTilesMap::iterator found = compressedTiles.find(compressedTilesLRU.front());
+        assert(found != compressedTiles.end());
+        if (found != compressedTiles.end()) {
+            compressedTierSize -= found->second.data.size();
+            compressedTiles.erase(found);
+        }
+        compressedTilesLRU.pop_front();
+    }
+} // trimCompressedTier
+
 
 template <bool persistent>
 bool
@@ -3214,6 +4824,17 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
         createTimedLock<Sharable_ReadLock>(_imp.get(), tilesLock->tileReadLock, &_imp->ipc->tilesStorageMutex);
 #endif
 
+        // Another process sharing the cache may have created tile storage files: map them before using any tile index
+        if (_imp->tilesStorage.size() < _imp->ipc->nTilesStorageFiles) {
+            tilesLock->tileReadLock.reset();
+#ifndef NATRON_CACHE_INTERPROCESS_ROBUST
+            tilesLock->tileWriteLock.reset(new Sharable_WriteLock(_imp->ipc->tilesStorageMutex));
+#else
+            createTimedLock<Sharable_WriteLock>(_imp.get(), tilesLock->tileWriteLock, &_imp->ipc->tilesStorageMutex);
+#endif
+            _imp->mapTileStorageFilesCreatedByOtherProcesses();
+        }
+
 
         if (tilesToAlloc && tilesToAlloc->size() > 0) {
             allocatedTilesData->resize(tilesToAlloc->size());
@@ -3284,6 +4905,7 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
                 assert(tileBucket.ipc->freeTiles.size() >= 1);
                 U64 freeTileEncodedIndex;
                 {
+                    BucketModification_RAII<persistent> modification(&tileBucket);
                     U64_Set::iterator freeTileIt = tileBucket.ipc->freeTiles.begin();
                     freeTileEncodedIndex = *freeTileIt;
                     tileBucket.ipc->freeTiles.erase(freeTileIt);
@@ -3308,8 +4930,8 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
                 char* data = (*storage)->getData();
 
                 // Set the tile index on the entry so we can free it afterwards.
-                char* ptr = data + tileIndex * NATRON_TILE_SIZE_BYTES;
-                assert((ptr >= data) && (ptr < (data + NATRON_NUM_TILES_PER_FILE * NATRON_TILE_SIZE_BYTES)));
+                char* ptr = data + tileIndex * _imp->tileSizeBytes;
+                assert((ptr >= data) && (ptr < (data + NATRON_TILE_STORAGE_FILE_SIZE)));
                 (*allocatedTilesData)[i] = std::make_pair(freeTileEncodedIndex, ptr);
 
             } // for each tile to allocate
@@ -3360,7 +4982,14 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
                 cacheEntry = found->second.get();
 
                 // Increment the size of the entry in the cache
-                bucket.ipc->size += tilesToAlloc->size() * NATRON_TILE_SIZE_BYTES;
+                bucket.ipc->size += tilesToAlloc->size() * _imp->tileSizeBytes;
+                bucket.recordAllocation(entry->getKey()->getHolderPluginID(), tilesToAlloc->size() * _imp->tileSizeBytes);
+
+                // If the entry quota groups are now above their quota, let the storage deleter thread
+                // evict entries of these groups: we cannot evict here since we hold a bucket lock.
+                if (_imp->updateQuotaGroupsUsage(*cacheEntry, tilesToAlloc->size() * _imp->tileSizeBytes, true /*added*/)) {
+                    appPTR->checkCachesMemory();
+                }
             }
 
             // Actually add the allocated tile indices in the cache entry so that we can free them when the cache entry gets destroyed.
@@ -3369,6 +4998,7 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
 
             // First work on a local set on the heap and then copy it to the ToC
             std::vector<U64> tmpSet(cacheEntry->tileIndices.size() + tilesToAlloc->size());
+            std::vector<U64> tmpLocalSet(cacheEntry->tileLocalIndices.size() + tilesToAlloc->size());
             {
                 int i = 0;
                 for (ExternalSegmentTypeULongLongList::const_iterator it = cacheEntry->tileIndices.begin(); it != cacheEntry->tileIndices.end(); ++it, ++i) {
@@ -3377,6 +5007,13 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
                 for (std::size_t c = 0; c < tilesToAlloc->size(); ++c, ++i) {
                     tmpSet[i] = (*allocatedTilesData)[c].first;
                 }
+                i = 0;
+                for (ExternalSegmentTypeULongLongList::const_iterator it = cacheEntry->tileLocalIndices.begin(); it != cacheEntry->tileLocalIndices.end(); ++it, ++i) {
+                    tmpLocalSet[i] = *it;
+                }
+                for (std::size_t c = 0; c < tilesToAlloc->size(); ++c, ++i) {
+                    tmpLocalSet[i] = (*tilesToAlloc)[c];
+                }
             }
 
 
@@ -3386,11 +5023,13 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
                 try {
                     cacheEntry->tileIndices.clear();
                     cacheEntry->tileIndices.insert(cacheEntry->tileIndices.end(), tmpSet.begin(), tmpSet.end());
+                    cacheEntry->tileLocalIndices.clear();
+                    cacheEntry->tileLocalIndices.insert(cacheEntry->tileLocalIndices.end(), tmpLocalSet.begin(), tmpLocalSet.end());
                     break;
                 } catch (const bip::bad_alloc&) {
 
                     // We may not have enough memory to store all indices, so grow the ToC mapping
-                    std::size_t tocMemNeeded = tmpSet.size() * sizeof(U64) * 2;
+                    std::size_t tocMemNeeded = (tmpSet.size() + tmpLocalSet.size()) * sizeof(U64) * 2;
 
                     // Release the bucket mutex because it will become invalid while we grow the ToC file
                     bucketWriteLock.reset();
@@ -3401,7 +5040,7 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
                         tocWriteLock.reset(new Sharable_WriteLock(_imp->ipc->bucketsData[cacheEntryBucketIndex].tocData.segmentMutex));
 #else
-                        createTimedLock<Sharable_WriteLock>(c->_imp.get(), tocWriteLock, &_imp->ipc->bucketsData[cacheEntryBucketIndex].tocData.segmentMutex);
+                        createTimedLock<Sharable_WriteLock>(_imp.get(), tocWriteLock, &_imp->ipc->bucketsData[cacheEntryBucketIndex].tocData.segmentMutex);
 #endif
                     }
 
@@ -3438,6 +5077,13 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
                 ++nAttempts;
             }
 
+            if (persistent) {
+                // Once the caller is done writing the tiles, unLockTiles() marks them dirty
+                tilesLock->allocatedTiles.resize(allocatedTilesData->size());
+                for (std::size_t i = 0; i < allocatedTilesData->size(); ++i) {
+                    tilesLock->allocatedTiles[i] = (*allocatedTilesData)[i].first;
+                }
+            }
 
         } // numTilesToAlloc > 0
 
@@ -3460,8 +5106,8 @@ Cache<persistent>::retrieveAndLockTiles(const CacheEntryBasePtr& entry,
 
 
                 char* data = (*storage)->getData();
-                char* tileDataPtr = data + tileIndex * NATRON_TILE_SIZE_BYTES;
-                assert((tileDataPtr >= data) && (tileDataPtr < (data + NATRON_NUM_TILES_PER_FILE * NATRON_TILE_SIZE_BYTES)));
+                char* tileDataPtr = data + tileIndex * _imp->tileSizeBytes;
+                assert((tileDataPtr >= data) && (tileDataPtr < (data + NATRON_TILE_STORAGE_FILE_SIZE)));
                 (*existingTilesData)[i] = tileDataPtr;
             } // for each tile indices
         }
@@ -3500,8 +5146,8 @@ Cache<persistent>::checkTileIndex(U64 encodedIndex) const
         return false;
     }
     char* data = _imp->tilesStorage[fileIndex]->getData();
-    char* tileDataPtr = data + tileIndex * NATRON_TILE_SIZE_BYTES;
-    if (tileDataPtr < data || tileDataPtr >= (data + NATRON_NUM_TILES_PER_FILE * NATRON_TILE_SIZE_BYTES)) {
+    char* tileDataPtr = data + tileIndex * _imp->tileSizeBytes;
+    if (tileDataPtr < data || tileDataPtr >= (data + NATRON_TILE_STORAGE_FILE_SIZE)) {
         assert(false);
         return false;
     }
@@ -3513,7 +5159,11 @@ template <bool persistent>
 void
 Cache<persistent>::unLockTiles(void* cacheData)
 {
-    delete (CacheTilesLockImpl*)cacheData;
+    CacheTilesLockImpl* tilesLock = (CacheTilesLockImpl*)cacheData;
+    if (persistent && tilesLock && !tilesLock->allocatedTiles.empty()) {
+        _imp->markTilesDirty(tilesLock->allocatedTiles);
+    }
+    delete tilesLock;
 } // unLockTiles
 
 
@@ -3573,7 +5223,7 @@ Cache<persistent>::releaseTiles(const CacheEntryBasePtr& entry, const std::vecto
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
             entryBucketWriteLock.reset(new Sharable_WriteLock(_imp->ipc->bucketsData[cacheEntryBucketIndex].bucketMutex));
 #else
-            createTimedLock<Sharable_WriteLock>(_imp.get(), bucketWriteLock, &_imp->ipc->bucketsData[cacheEntryBucketIndex].bucketMutex);
+            createTimedLock<Sharable_WriteLock>(_imp.get(), entryBucketWriteLock, &_imp->ipc->bucketsData[cacheEntryBucketIndex].bucketMutex);
 #endif
 
             bool gotEntry = bucket.tryCacheLookupImpl(entryHash, &found, &storage);
@@ -3583,6 +5233,12 @@ Cache<persistent>::releaseTiles(const CacheEntryBasePtr& entry, const std::vecto
                 for (std::size_t i = 0; i < cacheIndices.size(); ++i) {
                     ExternalSegmentTypeULongLongList::iterator foundTile = std::find(cacheEntry->tileIndices.begin(), cacheEntry->tileIndices.end(), cacheIndices[i]);
                     if (foundTile != cacheEntry->tileIndices.end()) {
+                        // Remove the local index at the same position
+                        ExternalSegmentTypeULongLongList::iterator foundLocal = cacheEntry->tileLocalIndices.begin();
+                        std::advance(foundLocal, std::distance(cacheEntry->tileIndices.begin(), foundTile));
+                        if (foundLocal != cacheEntry->tileLocalIndices.end()) {
+                            cacheEntry->tileLocalIndices.erase(foundLocal);
+                        }
                         cacheEntry->tileIndices.erase(foundTile);
                     }
                 }
@@ -3612,6 +5268,7 @@ Cache<persistent>::releaseTiles(const CacheEntryBasePtr& entry, const std::vecto
                 createTimedLock<Sharable_WriteLock>(_imp.get(), bucketWriteLock, &_imp->ipc->bucketsData[bucketIndex].bucketMutex);
 #endif
 
+                BucketModification_RAII<persistent> modification(&tileBucket);
                 tileBucket.ipc->freeTiles.insert(cacheIndices[i]);
             }
         }
@@ -3759,33 +5416,453 @@ CacheBase::fileExists(const std::string& filename)
 #endif
 }
 
-
+
+template <bool persistent>
+void
+Cache<persistent>::setMaximumCacheSize(std::size_t size)
+{
+    std::size_t curSize = getMaximumCacheSize();
+    {
+        boost::unique_lock<boost::mutex> k(_imp->maximumSizeMutex);
+        _imp->maximumSize = size;
+    }
+
+    // Clear exceeding entries if we are shrinking the cache.
+    if (size < curSize) {
+        evictLRUEntries(0);
+    }
+}
+
+template <bool persistent>
+std::size_t
+Cache<persistent>::getMaximumCacheSize() const
+{
+    {
+        boost::unique_lock<boost::mutex> k(_imp->maximumSizeMutex);
+        return _imp->maximumSize;
+    }
+}
+
+template <bool persistent>
+void
+Cache<persistent>::setEvictionPolicy(CacheEvictionPolicyEnum policy)
+{
+    boost::unique_lock<boost::mutex> k(_imp->maximumSizeMutex);
+    _imp->evictionPolicy = policy;
+}
+
+template <bool persistent>
+CacheBase::CacheEvictionPolicyEnum
+Cache<persistent>::getEvictionPolicy() const
+{
+    boost::unique_lock<boost::mutex> k(_imp->maximumSizeMutex);
+    return _imp->evictionPolicy;
+}
+
+template <bool persistent>
+void
+Cache<persistent>::setTileStorageAllocation(CacheTileStoragePagesEnum pages, bool interleaveNUMANodes)
+{
+    {
+        boost::unique_lock<boost::mutex> k(_imp->maximumSizeMutex);
+        if (_imp->tileStoragePages == pages && _imp->tileStorageInterleaveNUMANodes == interleaveNUMANodes) {
+            return;
+        }
+        _imp->tileStoragePages = pages;
+        _imp->tileStorageInterleaveNUMANodes = interleaveNUMANodes;
+    }
+
+    // The tile storage of a cache in RAM is re-allocated with the new policy
+    if (!persistent && _imp->useTileStorage) {
+        clear();
+    }
+}
+
+template <bool persistent>
+void
+Cache<persistent>::addEntryCost(const CacheEntryBasePtr& entry, double cost)
+{
+    if (!entry || cost <= 0) {
+        return;
+    }
+
+    U64 hash = entry->getHashKey();
+    int bucketIndex = Cache::getBucketCacheBucketIndex(hash);
+
+    CacheBucket<persistent>& bucket = _imp->buckets[bucketIndex];
+
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+    SHMReadLockerPtr shmReader(new SharedMemoryProcessLocalReadLocker(_imp.get()));
+#endif
+
+    try {
+
+        // Take the read lock on the toc file mapping
+        boost::scoped_ptr<Sharable_ReadLock> tocReadLock;
+        boost::scoped_ptr<Sharable_WriteLock> tocWriteLock;
+        bucket.checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
+
+        // The cost is protected by the LRU list mutex, the bucket only needs to be locked in read mode
+        boost::scoped_ptr<Sharable_ReadLock> readLock;
+#ifndef NATRON_CACHE_INTERPROCESS_ROBUST
+        readLock.reset(new Sharable_ReadLock(_imp->ipc->bucketsData[bucketIndex].bucketMutex));
+#else
+        createTimedLock<Sharable_ReadLock>(_imp.get(), readLock, &_imp->ipc->bucketsData[bucketIndex].bucketMutex);
+#endif
+
+        typename CacheBucket<persistent>::EntriesMap::iterator cacheEntryIt;
+        typename CacheBucket<persistent>::EntriesMap* storage;
+        if (!bucket.tryCacheLookupImpl(hash, &cacheEntryIt, &storage)) {
+            return;
+        }
+
+        boost::scoped_ptr<ExclusiveLock> lruWriteLock;
+#ifndef NATRON_CACHE_INTERPROCESS_ROBUST
+        lruWriteLock.reset(new ExclusiveLock(_imp->ipc->bucketsData[bucketIndex].lruListMutex));
+#else
+        createTimedLock<ExclusiveLock>(_imp.get(), lruWriteLock, &_imp->ipc->bucketsData[bucketIndex].lruListMutex);
+#endif
+        cacheEntryIt->second->cost += cost;
+        bucket.updateEvictionPriority(cacheEntryIt->second.get());
+    } catch (...) {
+        // Any exception caught here means the cache is corrupted
+        _imp->recoverFromInconsistentState(
+#ifdef NATRON_CACHE_INTERPROCESS_ROBUST
+                                            shmReader
+#endif
+                                           );
+    }
+} // addEntryCost
+
+template <bool persistent>
+void
+Cache<persistent>::setCompressedTierMaximumSize(std::size_t size)
+{
+    boost::unique_lock<boost::mutex> k(_imp->compressedTierMutex);
+    _imp->compressedTierMaximumSize = size;
+    _imp->trimCompressedTier();
+}
+
+template <bool persistent>
+std::size_t
+Cache<persistent>::getCompressedTierMaximumSize() const
+{
+    boost::unique_lock<boost::mutex> k(_imp->compressedTierMutex);
+    return _imp->compressedTierMaximumSize;
+}
+
+template <bool persistent>
+void
+Cache<persistent>::setRemoteTier(const std::string& path,
+                                 double minimumRenderCost)
+{
+    boost::unique_lock<boost::mutex> k(_imp->remoteTierMutex);
+    _imp->remoteTierPath = path;
+    _imp->remoteTierMinimumRenderCost = minimumRenderCost;
+}
+
+template <bool persistent>
+std::string
+Cache<persistent>::getRemoteTierPath() const
+{
+    boost::unique_lock<boost::mutex> k(_imp->remoteTierMutex);
+    return _imp->remoteTierPath;
+}
+
+template <bool persistent>
+QString
+CachePrivate<persistent>::getRemoteTileFilePath(const std::string& rootPath,
+                                                U64 entryHash,
+                                                U64 tileLocalIndex) const
+{
+    // Dispatch the files in sub-directories like the buckets so that no directory holds too many files
+    std::stringstream ss;
+    ss << rootPath << '/' << tileSizePo2 << '/' << std::hex << std::setw(2) << std::setfill('0') << (entryHash >> 56);
+    ss << '/' << std::setw(16) << entryHash << '_' << std::setw(16) << tileLocalIndex << ".tile";
+
+    return QString::fromUtf8( ss.str().c_str() );
+}
+
+template <bool persistent>
+void
+RemoteTilesWriter<persistent>::run()
+{
+    for (std::size_t i = 0; i < _tiles.size(); ++i) {
+        const RemoteTile& tile = _tiles[i];
+
+        // Another process may have written the same tile
+        if ( !QFile::exists(tile.filePath) && QDir().mkpath( QFileInfo(tile.filePath).absolutePath() ) ) {
+
+            // Write the file under a temporary name and rename it so that other processes never read a partial tile
+            QTemporaryFile tmpf( tile.filePath + QString::fromUtf8("_XXXXXX.tmp") );
+            if ( tmpf.open() && ( tmpf.write(tile.data) == (qint64)tile.data.size() ) ) {
+                tmpf.close();
+                tmpf.setAutoRemove(false);
+                QString tmpFileName = tmpf.fileName();
+                if ( !QFile::rename(tmpFileName, tile.filePath) ) {
+                    QFile::remove(tmpFileName);
+                }
+            }
+        }
+
+        boost::unique_lock<boost::mutex> k(_imp->remoteTierMutex);
+        _imp->remoteTierPendingBytes -= tile.data.size();
+    }
+} // run
+
+template <bool persistent>
+bool
+Cache<persistent>::retrieveAndLockRemoteTiles(const CacheEntryBasePtr& entry,
+                                              const std::vector<U64>& tilesToRestore,
+                                              std::vector<std::pair<U64, void*> >* allocatedTilesData,
+                                              void** cacheData)
+{
+    assert(_imp->useTileStorage);
+    assert(cacheData && allocatedTilesData);
+    *cacheData = 0;
+    allocatedTilesData->clear();
+    allocatedTilesData->resize(tilesToRestore.size(), std::make_pair((U64)-1, (void*)0));
+
+    std::string rootPath = getRemoteTierPath();
+    if (tilesToRestore.empty() || rootPath.empty()) {
+        return false;
+    }
+
+    U64 entryHash = entry->getHashKey();
+
+    // Read and decompress without any lock: the shared storage may be slow
+    std::vector<U64> tilesToAlloc;
+    std::vector<std::size_t> tilesToAllocInputIndex;
+    std::vector<QByteArray> uncompressedData;
+    for (std::size_t i = 0; i < tilesToRestore.size(); ++i) {
+        QFile file( _imp->getRemoteTileFilePath(rootPath, entryHash, tilesToRestore[i]) );
+        if ( !file.open(QIODevice::ReadOnly) ) {
+            continue;
+        }
+        QByteArray fileData = file.readAll();
+        if ( (std::size_t)fileData.size() <= sizeof(RemoteTileHeader) ) {
+            continue;
+        }
+        RemoteTileHeader header;
+        memcpy( &header, fileData.constData(), sizeof(header) );
+        if (header.magic != NATRON_REMOTE_TILE_FILE_MAGIC || header.version != NATRON_REMOTE_TILE_FILE_VERSION || header.tileSizeBytes != _imp->tileSizeBytes) {
+            continue;
+        }
+        QByteArray data = qUncompress( fileData.mid( sizeof(RemoteTileHeader) ) );
+        if ((std::size_t)data.size() != _imp->tileSizeBytes) {
+            // Corrupted data, the tile must be rendered
+            continue;
+        }
+        tilesToAlloc.push_back(tilesToRestore[i]);
+        tilesToAllocInputIndex.push_back(i);
+        uncompressedData.push_back(data);
+    }
+
+    {
+        boost::unique_lock<boost::mutex> k(_imp->remoteTierMutex);
+        boost::tuple<U64, U64, U64>& stats = _imp->remoteTierStats[entry->getKey()->getHolderPluginID()];
+        stats.get<0>() += tilesToAlloc.size();
+        stats.get<1>() += tilesToRestore.size() - tilesToAlloc.size();
+    }
+
+    if (tilesToAlloc.empty()) {
+        return false;
+    }
+
+    std::vector<std::pair<U64, void*> > allocatedTiles;
+    if (!retrieveAndLockTiles(entry, 0 /*tileIndices*/, &tilesToAlloc, 0 /*existingTilesData*/, &allocatedTiles, cacheData)) {
+        return false;
+    }
+    assert(allocatedTiles.size() == tilesToAlloc.size());
+    for (std::size_t i = 0; i < allocatedTiles.size(); ++i) {
+        memcpy(allocatedTiles[i].second, uncompressedData[i].constData(), _imp->tileSizeBytes);
+        (*allocatedTilesData)[tilesToAllocInputIndex[i]] = allocatedTiles[i];
+    }
+    return true;
+} // retrieveAndLockRemoteTiles
+
+template <bool persistent>
+void
+Cache<persistent>::publishRemoteTiles(const CacheEntryBasePtr& entry,
+                                      const std::vector<U64>& tileLocalIndices,
+                                      const std::vector<void*>& tilesData,
+                                      double renderCost)
+{
+    assert(tileLocalIndices.size() == tilesData.size());
+    std::string rootPath;
+    {
+        boost::unique_lock<boost::mutex> k(_imp->remoteTierMutex);
+        if (_imp->remoteTierPath.empty() || renderCost < _imp->remoteTierMinimumRenderCost || _imp->remoteTierPendingBytes >= NATRON_REMOTE_TIER_MAX_PENDING_BYTES) {
+            return;
+        }
+        rootPath = _imp->remoteTierPath;
+    }
+    if (tilesData.empty()) {
+        return;
+    }
+
+    RemoteTileHeader header;
+    header.magic = NATRON_REMOTE_TILE_FILE_MAGIC;
+    header.version = NATRON_REMOTE_TILE_FILE_VERSION;
+    header.tileSizeBytes = _imp->tileSizeBytes;
+
+    // Copy the tiles now: they may be freed as soon as the caller unlocks them.
+    // Compress them to save bandwidth on the shared storage.
+    U64 entryHash = entry->getHashKey();
+    std::vector<RemoteTile> tiles(tilesData.size());
+    std::size_t nBytes = 0;
+    for (std::size_t i = 0; i < tilesData.size(); ++i) {
+        tiles[i].filePath = _imp->getRemoteTileFilePath(rootPath, entryHash, tileLocalIndices[i]);
+        tiles[i].data = QByteArray( (const char*)&header, sizeof(header) );
+        tiles[i].data.append( qCompress( QByteArray::fromRawData( (const char*)tilesData[i], (int)_imp->tileSizeBytes ), 1 ) );
+        nBytes += tiles[i].data.size();
+    }
+
+    {
+        boost::unique_lock<boost::mutex> k(_imp->remoteTierMutex);
+        _imp->remoteTierPendingBytes += nBytes;
+        _imp->remoteTierStats[entry->getKey()->getHolderPluginID()].get<2>() += tiles.size();
+    }
+    _imp->remoteTierWriters.start( new RemoteTilesWriter<persistent>(_imp.get(), tiles) );
+} // publishRemoteTiles
+
+template <bool persistent>
+void
+Cache<persistent>::setDirtyTilesHighWatermark(std::size_t size)
+{
+    QMutexLocker k(&_imp->ioThreadMutex);
+    _imp->dirtyTilesHighWatermark = size;
+
+    // The new threshold may already be exceeded
+    _imp->ioThreadCond.wakeOne();
+}
+
+template <bool persistent>
+std::size_t
+Cache<persistent>::getDirtyTilesHighWatermark() const
+{
+    QMutexLocker k(&_imp->ioThreadMutex);
+    return _imp->dirtyTilesHighWatermark;
+}
+
 template <bool persistent>
 void
-Cache<persistent>::setMaximumCacheSize(std::size_t size)
+Cache<persistent>::setQuotaGroupSize(CacheQuotaGroupTypeEnum type, std::size_t size)
 {
-    std::size_t curSize = getMaximumCacheSize();
+    bool mustEvict;
     {
-        boost::unique_lock<boost::mutex> k(_imp->maximumSizeMutex);
-        _imp->maximumSize = size;
+        boost::unique_lock<boost::mutex> k(_imp->quotaGroupsMutex);
+        mustEvict = size > 0 && (_imp->quotaGroupsSize[type] == 0 || size < _imp->quotaGroupsSize[type]);
+        _imp->quotaGroupsSize[type] = size;
     }
-
-    // Clear exceeding entries if we are shrinking the cache.
-    if (size < curSize) {
+    if (mustEvict && type != eCacheQuotaGroupViewer) {
         evictLRUEntries(0);
     }
 }
 
+template <bool persistent>
+int
+Cache<persistent>::getRemovedEntriesCount() const
+{
+    return _imp->removedEntriesCount.fetchAndAddOrdered(0);
+}
+
 template <bool persistent>
 std::size_t
-Cache<persistent>::getMaximumCacheSize() const
+Cache<persistent>::getQuotaGroupSize(CacheQuotaGroupTypeEnum type) const
 {
-    {
-        boost::unique_lock<boost::mutex> k(_imp->maximumSizeMutex);
-        return _imp->maximumSize;
+    boost::unique_lock<boost::mutex> k(_imp->quotaGroupsMutex);
+    return _imp->quotaGroupsSize[type];
+}
+
+template <bool persistent>
+void
+Cache<persistent>::prefetchEntries(const std::vector<U64>& holderHashes)
+{
+    if (holderHashes.empty() || !_imp->ioThread) {
+        // Only the tile storage of a persistent cache is backed by files
+        return;
     }
+    QMutexLocker k(&_imp->ioThreadMutex);
+    _imp->prefetchRequests.push_back(holderHashes);
+    _imp->ioThreadCond.wakeOne();
 }
 
+template <bool persistent>
+bool
+Cache<persistent>::retrieveAndLockCompressedTiles(const CacheEntryBasePtr& entry,
+                                                  const std::vector<U64>& tilesToRestore,
+                                                  std::vector<std::pair<U64, void*> >* allocatedTilesData,
+                                                  void** cacheData)
+{
+    assert(_imp->useTileStorage);
+    assert(cacheData && allocatedTilesData);
+    *cacheData = 0;
+    allocatedTilesData->clear();
+    allocatedTilesData->resize(tilesToRestore.size(), std::make_pair((U64)-1, (void*)0));
+
+    if (tilesToRestore.empty()) {
+        return false;
+    }
+
+    U64 entryHash = entry->getHashKey();
+
+    // Extract the tiles from the tier: once restored they live again in the tile storage
+    std::vector<QByteArray> compressedData(tilesToRestore.size());
+    {
+        boost::unique_lock<boost::mutex> k(_imp->compressedTierMutex);
+        if (_imp->compressedTierMaximumSize == 0) {
+            return false;
+        }
+
+        std::pair<U64, U64>& hitsMisses = _imp->compressedTierHitsMisses[entry->getKey()->getHolderPluginID()];
+        for (std::size_t i = 0; i < tilesToRestore.size(); ++i) {
+            CompressedTilesMap::iterator found = _imp->compressedTiles.find(std::make_pair(entryHash, tilesToRestore[i]));
+            if (found == _imp->compressedTiles.end()) {
+                ++hitsMisses.second;
+                continue;
+            }
+            ++hitsMisses.first;
+            compressedData[i] = found->second.data;
+            _imp->compressedTierSize -= found->second.data.size();
+            _imp->compressedTilesLRU.erase(found->second.lruIt);
+            _imp->compressedTiles.erase(found);
+        }
+    }
+
+    // Decompress outside of the lock
+    std::vector<U64> tilesToAlloc;
+    std::vector<std::size_t> tilesToAllocInputIndex;
+    std::vector<QByteArray> uncompressedData;
+    for (std::size_t i = 0; i < compressedData.size(); ++i) {
+        if (compressedData[i].isEmpty()) {
+            continue;
+        }
+        QByteArray data = qUncompress(compressedData[i]);
+        if ((std::size_t)data.size() != _imp->tileSizeBytes) {
+            // Corrupted data, the tile must be rendered again
+            continue;
+        }
+        tilesToAlloc.push_back(tilesToRestore[i]);
+        tilesToAllocInputIndex.push_back(i);
+        uncompressedData.push_back(data);
+    }
+    if (tilesToAlloc.empty()) {
+        return false;
+    }
+
+    std::vector<std::pair<U64, void*> > allocatedTiles;
+    if (!retrieveAndLockTiles(entry, 0 /*tileIndices*/, &tilesToAlloc, 0 /*existingTilesData*/, &allocatedTiles, cacheData)) {
+        return false;
+    }
+    assert(allocatedTiles.size() == tilesToAlloc.size());
+    for (std::size_t i = 0; i < allocatedTiles.size(); ++i) {
+        memcpy(allocatedTiles[i].second, uncompressedData[i].constData(), _imp->tileSizeBytes);
+        (*allocatedTilesData)[tilesToAllocInputIndex[i]] = allocatedTiles[i];
+    }
+    return true;
+} // retrieveAndLockCompressedTiles
+
 template <bool persistent>
 std::size_t
 Cache<persistent>::getCurrentSize() const
@@ -3929,26 +6006,42 @@ Cache<persistent>::isPersistent() const
 }
 
 void
-CacheBase::getTileSizePx(ImageBitDepthEnum bitdepth, int *tx, int *ty)
+CacheBase::getTileSizePxForPo2(int tileSizePo2, ImageBitDepthEnum bitdepth, int *tx, int *ty)
 {
+    // All tiles have the same number of bytes, whatever the bitdepth
+    int tileSize8Bit = 1 << tileSizePo2;
     switch (bitdepth) {
         case eImageBitDepthByte:
-            *tx = NATRON_TILE_SIZE_X_8_BIT;
-            *ty = NATRON_TILE_SIZE_Y_8_BIT;
+            *tx = tileSize8Bit;
+            *ty = tileSize8Bit;
             break;
         case eImageBitDepthShort:
         case eImageBitDepthHalf:
-            *tx = NATRON_TILE_SIZE_X_16_BIT;
-            *ty = NATRON_TILE_SIZE_Y_16_BIT;
+            *tx = tileSize8Bit;
+            *ty = tileSize8Bit / 2;
             break;
         case eImageBitDepthFloat:
-            *tx = NATRON_TILE_SIZE_X_32_BIT;
-            *ty = NATRON_TILE_SIZE_Y_32_BIT;
+            *tx = tileSize8Bit / 2;
+            *ty = tileSize8Bit / 2;
             break;
         case eImageBitDepthNone:
             *tx = *ty = 0;
             break;
     }
+} // getTileSizePxForPo2
+
+template <bool persistent>
+void
+Cache<persistent>::getTileSizePx(ImageBitDepthEnum bitdepth, int *tx, int *ty) const
+{
+    getTileSizePxForPo2(_imp->tileSizePo2, bitdepth, tx, ty);
+}
+
+template <bool persistent>
+std::size_t
+Cache<persistent>::getTileSizeBytes() const
+{
+    return _imp->tileSizeBytes;
 }
 
 template <bool persistent>
@@ -4069,6 +6162,8 @@ Cache<persistent>::removeEntry(const CacheEntryBasePtr& entry)
                                            );
     }
 
+    // Tiles of this entry evicted earlier must not be restored anymore
+    _imp->removeCompressedTiles(hash);
 
 } // removeEntry
 
@@ -4099,6 +6194,59 @@ CachePrivate<persistent>::recoverFromInconsistentState(
 
 } // recoverFromInconsistentState
 
+template <bool persistent>
+bool
+CachePrivate<persistent>::openJournal()
+{
+    std::stringstream ss;
+    ss << directoryContainingCachePath << "/" << NATRON_CACHE_DIRECTORY_NAME << "/" << NATRON_CACHE_JOURNAL_FILE_NAME;
+
+    journalFile.reset(new MemoryFile);
+    journalFile->open(ss.str(), MemoryFile::eFileOpenModeOpenOrCreate);
+    bool valid = journalFile->size() == sizeof(CacheJournalData);
+    if (!valid) {
+        journalFile->resize(sizeof(CacheJournalData), false /*preserve*/);
+    }
+    journal = reinterpret_cast<CacheJournalData*>(journalFile->getData());
+    valid = valid && journal->version == NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION && journal->tileSizeBytes == (U32)tileSizeBytes;
+    if (!valid) {
+        // The cache is wiped, all buckets are re-created clean
+        journal->version = NATRON_MEMORY_SEGMENT_ENTRY_HEADER_VERSION;
+        journal->tileSizeBytes = (U32)tileSizeBytes;
+        std::memset(journal->bucketsDirty, 0, sizeof(journal->bucketsDirty));
+    }
+    return valid;
+} // openJournal
+
+template <bool persistent>
+void
+CachePrivate<persistent>::closeJournal()
+{
+    if (!journal || !globalFileLock) {
+        return;
+    }
+
+    // If another process still uses the cache, it flags the buckets clean when it detaches.
+    // Other processes cannot attach to the cache whilst we have the file lock in write mode.
+    globalFileLock->unlock_sharable();
+    if (!globalFileLock->try_lock()) {
+        return;
+    }
+
+    // No thread of this process uses the cache anymore and no other process is attached: no lock is needed.
+    // The ToC of a bucket must be on disk before the journal tells that the bucket can be trusted.
+    for (int i = 0; i < NATRON_CACHE_BUCKETS_COUNT; ++i) {
+        CacheBucket<persistent>& bucket = buckets[i];
+        if (!bucket.tocAttached || !bucket.ipc || bucket.hasInterruptedModification()) {
+            continue;
+        }
+        flushMemory(bucket.tocFile, (int)MemoryFile::eFlushTypeSync, NULL, 0);
+        journal->bucketsDirty[i] = 0;
+    }
+    journalFile->flush(MemoryFile::eFlushTypeSync, NULL, 0);
+    globalFileLock->unlock();
+} // closeJournal
+
 template <bool persistent>
 void
 CachePrivate<persistent>::clearCacheBucket(int bucket_i)
@@ -4116,9 +6264,8 @@ CachePrivate<persistent>::clearCacheBucket(int bucket_i)
         createTimedLock<Sharable_WriteLock>(this, tocWriteLock, &ipc->bucketsData[bucket_i].tocData.segmentMutex);
 #endif
         // Close and re-create the memory mapped files
-        std::string tocFilePath = getStoragePath(bucket.tocFile);
         clearStorage(bucket.tocFile);
-        openStorage(bucket.tocFile, tocFilePath, (int)MemoryFile::eFileOpenModeOpenTruncateOrCreate);
+        openStorage(bucket.tocFile, bucket.tocFilePath, (int)MemoryFile::eFileOpenModeOpenTruncateOrCreate);
         bucket.remapToCMemoryFile(*tocWriteLock, 0);
 
     }
@@ -4131,6 +6278,13 @@ void
 Cache<persistent>::clear()
 {
 
+    {
+        boost::unique_lock<boost::mutex> k(_imp->compressedTierMutex);
+        _imp->compressedTiles.clear();
+        _imp->compressedTilesLRU.clear();
+        _imp->compressedTierSize = 0;
+    }
+
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
     _imp->ensureSharedMemoryIntegrity();
     SHMReadLockerPtr shmReader(new SharedMemoryProcessLocalReadLocker(_imp.get()));
@@ -4142,21 +6296,36 @@ Cache<persistent>::clear()
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
         tileWriteLock.reset(new Sharable_WriteLock(_imp->ipc->tilesStorageMutex));
 #else
-        createTimedLock<Sharable_WriteLock>(this, tileWriteLock, &_imp->ipc->tilesStorageMutex);
+        createTimedLock<Sharable_WriteLock>(_imp.get(), tileWriteLock, &_imp->ipc->tilesStorageMutex);
 #endif
-        for (std::size_t i = 0; i < _imp->tilesStorage.size(); ++i) {
-            clearStorage(_imp->tilesStorage[i]);
+        _imp->discardTilesStorage();
+        _imp->ipc->nTilesStorageFiles = 0;
+
+        {
+            QMutexLocker k(&_imp->ioThreadMutex);
+            _imp->dirtyTiles.clear();
+            _imp->dirtyTilesSize = 0;
         }
-        _imp->tilesStorage.clear();
 
 
         for (int bucket_i = 0; bucket_i < NATRON_CACHE_BUCKETS_COUNT; ++bucket_i) {
             _imp->clearCacheBucket(bucket_i);
+
+            boost::unique_lock<boost::mutex> k(_imp->buckets[bucket_i].accessStatsMutex);
+            _imp->buckets[bucket_i].accessStats.clear();
         } // for each bucket
 
+        {
+            boost::unique_lock<boost::mutex> k(_imp->quotaGroupsMutex);
+            _imp->quotaGroupsUsage.clear();
+            _imp->viewerOutputsUsage = 0;
+        }
+
         // Ensure we initialize the cache with at least one tile storage file
         _imp->createTileStorage();
 
+        _imp->removedEntriesCount.fetchAndAddRelaxed(1);
+
     } catch (...) {
 
     }
@@ -4166,111 +6335,284 @@ Cache<persistent>::clear()
 } // clear()
 
 template <bool persistent>
-void
-Cache<persistent>::evictLRUEntries(std::size_t nBytesToFree)
+U64
+CachePrivate<persistent>::registerQuotaGroup(CacheBase::CacheQuotaGroupTypeEnum type, const std::string& name)
 {
-    std::size_t maxSize = getMaximumCacheSize();
+    if (name.empty()) {
+        return 0;
+    }
+    Hash64 hash;
+    hash.append((int)type);
+    Hash64::appendString(name, &hash);
+    hash.computeHash();
+    U64 groupID = hash.value();
+
+    boost::unique_lock<boost::mutex> k(quotaGroupsMutex);
+    std::pair<CacheBase::CacheQuotaGroupTypeEnum, std::string>& groupName = quotaGroupsNames[groupID];
+    if (groupName.second.empty()) {
+        groupName = std::make_pair(type, name);
+    }
+    return groupID;
+} // registerQuotaGroup
 
-    // If max size == 0 then there's no limit.
-    if (maxSize == 0) {
-        return;
+template <bool persistent>
+bool
+CachePrivate<persistent>::updateQuotaGroupsUsage(const MemorySegmentEntryHeaderBase& entry, std::size_t nBytes, bool added)
+{
+    if (nBytes == 0) {
+        return false;
+    }
+    boost::unique_lock<boost::mutex> k(quotaGroupsMutex);
+    bool quotaExceeded = false;
+    const U64 groups[2] = {entry.projectQuotaGroup, entry.nodeQuotaGroup};
+    const std::size_t quotas[2] = {quotaGroupsSize[CacheBase::eCacheQuotaGroupProject], quotaGroupsSize[CacheBase::eCacheQuotaGroupNode]};
+    for (int i = 0; i < 2; ++i) {
+        if (!groups[i]) {
+            continue;
+        }
+        std::map<U64, std::size_t>::iterator found = quotaGroupsUsage.find(groups[i]);
+        if (added) {
+            if (found == quotaGroupsUsage.end()) {
+                found = quotaGroupsUsage.insert(std::make_pair(groups[i], (std::size_t)0)).first;
+            }
+            found->second += nBytes;
+            if (quotas[i] > 0 && found->second > quotas[i]) {
+                quotaExceeded = true;
+            }
+        } else if (found != quotaGroupsUsage.end()) {
+            // The entry may not have been accounted entirely if it was created by another process
+            found->second -= std::min(found->second, nBytes);
+            if (found->second == 0) {
+                quotaGroupsUsage.erase(found);
+            }
+        }
     }
+    if (entry.isViewerOutput) {
+        if (added) {
+            viewerOutputsUsage += nBytes;
+        } else {
+            viewerOutputsUsage -= std::min(viewerOutputsUsage, nBytes);
+        }
+    }
+    return quotaExceeded;
+} // updateQuotaGroupsUsage
 
-    if (nBytesToFree >= maxSize) {
-        maxSize = 0;
-    } else {
-        maxSize = maxSize - nBytesToFree;
+template <bool persistent>
+void
+CachePrivate<persistent>::getExceededQuotaGroups(std::list<std::pair<U64, std::size_t> >* groups)
+{
+    boost::unique_lock<boost::mutex> k(quotaGroupsMutex);
+    for (std::map<U64, std::size_t>::const_iterator it = quotaGroupsUsage.begin(); it != quotaGroupsUsage.end(); ++it) {
+        std::map<U64, std::pair<CacheBase::CacheQuotaGroupTypeEnum, std::string> >::const_iterator foundName = quotaGroupsNames.find(it->first);
+        if (foundName == quotaGroupsNames.end()) {
+            continue;
+        }
+        std::size_t quota = quotaGroupsSize[foundName->second.first];
+        if (quota > 0 && it->second > quota) {
+            groups->push_back(std::make_pair(it->first, it->second - quota));
+        }
     }
+} // getExceededQuotaGroups
 
-    std::size_t curSize = getCurrentSize();
+template <bool persistent>
+bool
+CachePrivate<persistent>::mustProtectViewerOutputs()
+{
+    boost::unique_lock<boost::mutex> k(quotaGroupsMutex);
+    std::size_t reservedSize = quotaGroupsSize[CacheBase::eCacheQuotaGroupViewer];
+    return reservedSize > 0 && viewerOutputsUsage <= reservedSize;
+} // mustProtectViewerOutputs
 
-    bool mustEvictEntries = curSize > maxSize;
+template <bool persistent>
+bool
+CachePrivate<persistent>::evictOneEntryPerBucket(CacheBase::CacheEvictionPolicyEnum policy,
+                                                 const CacheEvictionFilter& filter,
+                                                 bool useCompressedTier,
+                                                 std::size_t* freedBytes)
+{
+    *freedBytes = 0;
 
-    while (mustEvictEntries) {
-        
-        bool foundBucketThatCanEvict = false;
+    // Tiles of evicted entries are copied before being freed so that they can be compressed in the compressed tier
+    std::vector<EvictedTile> evictedTiles;
+
+    bool foundBucketThatCanEvict = false;
 
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
-        SHMReadLockerPtr shmReader(new SharedMemoryProcessLocalReadLocker(_imp.get()));
+    SHMReadLockerPtr shmReader(new SharedMemoryProcessLocalReadLocker(this));
 #endif
 
-        // Check each bucket
-        for (int bucket_i = 0; bucket_i < NATRON_CACHE_BUCKETS_COUNT; ++bucket_i) {
-            CacheBucket<persistent> & bucket = _imp->buckets[bucket_i];
+    // Check each bucket
+    for (int bucket_i = 0; bucket_i < NATRON_CACHE_BUCKETS_COUNT; ++bucket_i) {
+        CacheBucket<persistent> & bucket = buckets[bucket_i];
 
-            try {
-                // Take the read lock on the toc file mapping
-                boost::scoped_ptr<Sharable_ReadLock> tocReadLock;
-                boost::scoped_ptr<Sharable_WriteLock> tocWriteLock;
-                bucket.checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
+        try {
+            // Take the read lock on the toc file mapping
+            boost::scoped_ptr<Sharable_ReadLock> tocReadLock;
+            boost::scoped_ptr<Sharable_WriteLock> tocWriteLock;
+            bucket.checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
 
 
-                // Take write lock on the bucket
-                boost::scoped_ptr<Sharable_WriteLock> bucketLock;
+            // Take write lock on the bucket
+            boost::scoped_ptr<Sharable_WriteLock> bucketLock;
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
-                bucketLock.reset(new Sharable_WriteLock(_imp->ipc->bucketsData[bucket_i].bucketMutex));
+            bucketLock.reset(new Sharable_WriteLock(ipc->bucketsData[bucket_i].bucketMutex));
 #else
-                createTimedLock<Sharable_WriteLock>(_imp.get(), bucketLock, &_imp->ipc->bucketsData[bucket_i].bucketMutex);
+            createTimedLock<Sharable_WriteLock>(this, bucketLock, &ipc->bucketsData[bucket_i].bucketMutex);
 #endif
 
-                BucketStateHandler_RAII<persistent> bucketStateHandler(&bucket);
+            BucketStateHandler_RAII<persistent> bucketStateHandler(&bucket);
 
 
-                U64 hash = 0;
-                {
-                    // Lock the LRU list
+            U64 hash = 0;
+            {
+                // Lock the LRU list
 #ifndef NATRON_CACHE_INTERPROCESS_ROBUST
-                    boost::scoped_ptr<ExclusiveLock> writeLock (new ExclusiveLock(_imp->ipc->bucketsData[bucket_i].lruListMutex));
+                boost::scoped_ptr<ExclusiveLock> writeLock (new ExclusiveLock(ipc->bucketsData[bucket_i].lruListMutex));
 #else
-                    boost::scoped_ptr<ExclusiveLock> lruWriteLock;
-                    createTimedLock<ExclusiveLock>(_imp.get(), lruWriteLock, &_imp->ipc->bucketsData[bucket_i].lruListMutex);
+                boost::scoped_ptr<ExclusiveLock> lruWriteLock;
+                createTimedLock<ExclusiveLock>(this, lruWriteLock, &ipc->bucketsData[bucket_i].lruListMutex);
 #endif
-                    // The least recently used entry is the one at the front of the linked list
+                // The least recently used entry is the one at the front of the linked list
+                if (policy == CacheBase::eCacheEvictionPolicyLRU && filter.isEmpty()) {
                     if (bucket.ipc->lruListFront) {
                         hash = bucket.ipc->lruListFront->hash;
                     }
+                } else {
+                    // With the LRU policy, evict the least recently used entry accepted by the filter.
+                    // GreedyDual-Size: amongst the least recently used entries, evict the one that is the cheapest
+                    // to compute again per byte. Only a few candidates are considered so that this stays cheap
+                    // and recent entries are never evicted before old ones of similar cost.
+                    int nMaxCandidates = policy == CacheBase::eCacheEvictionPolicyLRU ? 1 : NATRON_CACHE_EVICTION_COST_N_CANDIDATES;
+                    int nCandidates = 0;
+                    double minPriority = 0;
+                    for (bip::offset_ptr<LRUListNode> it = bucket.ipc->lruListFront; it && nCandidates < nMaxCandidates; it = it->next) {
+                        typename CacheBucket<persistent>::EntriesMap::iterator candidateIt;
+                        typename CacheBucket<persistent>::EntriesMap* candidateStorage;
+                        if (!bucket.tryCacheLookupImpl(it->hash, &candidateIt, &candidateStorage)) {
+                            continue;
+                        }
+                        if (!filter.acceptEntry(*candidateIt->second)) {
+                            continue;
+                        }
+                        ++nCandidates;
+                        if (hash == 0 || candidateIt->second->evictionPriority < minPriority) {
+                            hash = it->hash;
+                            minPriority = candidateIt->second->evictionPriority;
+                        }
+                    }
+                    if (hash != 0 && policy == CacheBase::eCacheEvictionPolicyCost) {
+                        // Entries accessed from now on get a priority relative to the evicted one
+                        bucket.ipc->evictionInflation = std::max(bucket.ipc->evictionInflation, minPriority);
+                    }
                 }
-                if (hash == 0) {
-                    continue;
-                }
+            }
+            if (hash == 0) {
+                continue;
+            }
 
-                // Deallocate the memory taken by the cache entry in the ToC
-                typename CacheBucket<persistent>::EntriesMap::iterator cacheEntryIt;
-                typename CacheBucket<persistent>::EntriesMap* storage;
-                if (!bucket.tryCacheLookupImpl(hash, &cacheEntryIt, &storage)) {
-                    continue;
-                }
+            // Deallocate the memory taken by the cache entry in the ToC
+            typename CacheBucket<persistent>::EntriesMap::iterator cacheEntryIt;
+            typename CacheBucket<persistent>::EntriesMap* storage;
+            if (!bucket.tryCacheLookupImpl(hash, &cacheEntryIt, &storage)) {
+                continue;
+            }
 
 
-                // We evicted one, decrease the size
-                curSize -= cacheEntryIt->second->size;
-                curSize -= cacheEntryIt->second->tileIndices.size() * NATRON_TILE_SIZE_BYTES;
-                
-                bucket.deallocateCacheEntryImpl(cacheEntryIt, storage);
+            // We evicted one, count the freed bytes
+            *freedBytes += cacheEntryIt->second->size;
+            *freedBytes += cacheEntryIt->second->tileIndices.size() * tileSizeBytes;
 
+            bucket.recordEviction(std::string(cacheEntryIt->second->pluginID.c_str()));
 
+            bucket.deallocateCacheEntryImpl(cacheEntryIt, storage, useCompressedTier ? &evictedTiles : 0);
 
-            } catch (...) {
-                // Any exception caught here means the cache is corrupted
-                _imp->recoverFromInconsistentState(
+
+
+        } catch (...) {
+            // Any exception caught here means the cache is corrupted
+            recoverFromInconsistentState(
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
-                                                    shmReader
+                                         shmReader
 #endif
-                                                   );
-                return;
+                                        );
+            return false;
+        }
+
+        // The bucket locks are released: compress the tiles of the evicted entry
+        if (!evictedTiles.empty()) {
+            insertCompressedTiles(evictedTiles);
+            evictedTiles.clear();
+        }
+        
+        foundBucketThatCanEvict = true;
+        
+    } // for each bucket
+
+    return foundBucketThatCanEvict;
+} // evictOneEntryPerBucket
+
+template <bool persistent>
+void
+Cache<persistent>::evictLRUEntries(std::size_t nBytesToFree)
+{
+    bool useCompressedTier = _imp->useTileStorage && getCompressedTierMaximumSize() > 0;
+
+    CacheEvictionPolicyEnum evictionPolicy = getEvictionPolicy();
+
+    // First bring the quota groups exceeding their quota back under it by evicting their own entries,
+    // so that a single project or node cannot evict the entries of the others.
+    std::list<std::pair<U64, std::size_t> > exceededGroups;
+    _imp->getExceededQuotaGroups(&exceededGroups);
+    for (std::list<std::pair<U64, std::size_t> >::const_iterator it = exceededGroups.begin(); it != exceededGroups.end(); ++it) {
+        CacheEvictionFilter filter;
+        filter.quotaGroup = it->first;
+        std::size_t excessBytes = it->second;
+        while (excessBytes > 0) {
+            std::size_t freedBytes;
+            if (!_imp->evictOneEntryPerBucket(evictionPolicy, filter, useCompressedTier, &freedBytes)) {
+                break;
             }
-            
-            foundBucketThatCanEvict = true;
-            
-        } // for each bucket
+            excessBytes -= std::min(excessBytes, freedBytes);
+        }
+    }
+
+    std::size_t maxSize = getMaximumCacheSize();
+
+    // If max size == 0 then there's no limit.
+    if (maxSize == 0) {
+        return;
+    }
+
+    if (nBytesToFree >= maxSize) {
+        maxSize = 0;
+    } else {
+        maxSize = maxSize - nBytesToFree;
+    }
+
+    std::size_t curSize = getCurrentSize();
+
+    // Nothing is evicted until the high watermark is reached, then the cache is trimmed down to the low watermark
+    const std::size_t highWatermark = (std::size_t)(maxSize * NATRON_CACHE_EVICTION_HIGH_WATERMARK);
+    const std::size_t lowWatermark = (std::size_t)(maxSize * NATRON_CACHE_EVICTION_LOW_WATERMARK);
+
+    bool mustEvictEntries = curSize > highWatermark;
+
+    while (mustEvictEntries) {
+
+        // Viewer outputs are not evicted while they fit in their reserved share of the cache
+        CacheEvictionFilter filter;
+        filter.protectViewerOutputs = _imp->mustProtectViewerOutputs();
+
+        std::size_t freedBytes;
 
         // No bucket can be evicted anymore, exit.
-        if (!foundBucketThatCanEvict) {
+        if (!_imp->evictOneEntryPerBucket(evictionPolicy, filter, useCompressedTier, &freedBytes)) {
             break;
         }
 
         // Update mustEvictEntries for next iteration
-        mustEvictEntries = curSize > maxSize;
+        curSize -= std::min(curSize, freedBytes);
+        mustEvictEntries = curSize > lowWatermark;
 
     } // while(mustEvictEntries)
 
@@ -4278,8 +6620,36 @@ Cache<persistent>::evictLRUEntries(std::size_t nBytesToFree)
 
 template <bool persistent>
 void
-Cache<persistent>::getMemoryStats(std::map<std::string, CacheReportInfo>* infos) const
+Cache<persistent>::getMemoryStats(std::map<std::string, CacheReportInfo>* infos,
+                                  std::map<std::string, CacheQuotaGroupReportInfo>* quotaGroupsInfos,
+                                  std::vector<CacheReportInfo>* bucketsInfos) const
 {
+    if (bucketsInfos) {
+        bucketsInfos->clear();
+        bucketsInfos->resize(NATRON_CACHE_BUCKETS_COUNT);
+    }
+
+    // Report the quota groups: this is only process local data
+    if (quotaGroupsInfos) {
+        boost::unique_lock<boost::mutex> k(_imp->quotaGroupsMutex);
+        for (std::map<U64, std::pair<CacheQuotaGroupTypeEnum, std::string> >::const_iterator it = _imp->quotaGroupsNames.begin(); it != _imp->quotaGroupsNames.end(); ++it) {
+            std::map<U64, std::size_t>::const_iterator foundUsage = _imp->quotaGroupsUsage.find(it->first);
+            if (foundUsage == _imp->quotaGroupsUsage.end()) {
+                continue;
+            }
+            CacheQuotaGroupReportInfo& groupData = (*quotaGroupsInfos)[it->second.second];
+            groupData.type = (int)it->second.first;
+            groupData.nBytes = foundUsage->second;
+            groupData.quota = _imp->quotaGroupsSize[it->second.first];
+        }
+        if (_imp->viewerOutputsUsage > 0 || _imp->quotaGroupsSize[eCacheQuotaGroupViewer] > 0) {
+            CacheQuotaGroupReportInfo& groupData = (*quotaGroupsInfos)["Viewers"];
+            groupData.type = (int)eCacheQuotaGroupViewer;
+            groupData.nBytes = _imp->viewerOutputsUsage;
+            groupData.quota = _imp->quotaGroupsSize[eCacheQuotaGroupViewer];
+        }
+    }
+
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
     boost::scoped_ptr<SharedMemoryProcessLocalReadLocker> shmReader(new SharedMemoryProcessLocalReadLocker(_imp.get()));
 #endif
@@ -4319,6 +6689,11 @@ Cache<persistent>::getMemoryStats(std::map<std::string, CacheReportInfo>* infos)
                     ++entryData.nEntries;
                     entryData.nBytes += cacheEntryIt->second->size;
                 }
+                if (bucketsInfos) {
+                    CacheReportInfo& bucketData = (*bucketsInfos)[bucket_i];
+                    ++bucketData.nEntries;
+                    bucketData.nBytes += cacheEntryIt->second->size;
+                }
                 it = it->next;
             }
         } catch(...) {
@@ -4332,64 +6707,84 @@ Cache<persistent>::getMemoryStats(std::map<std::string, CacheReportInfo>* infos)
 
         }
 
-        
+
+        // Report the access counters of the bucket
+        {
+            boost::unique_lock<boost::mutex> k(bucket.accessStatsMutex);
+            for (std::map<std::string, CacheReportInfo>::const_iterator it = bucket.accessStats.begin(); it != bucket.accessStats.end(); ++it) {
+                CacheReportInfo& entryData = (*infos)[it->first];
+                entryData.nHits += it->second.nHits;
+                entryData.nMisses += it->second.nMisses;
+                entryData.nPendingWaits += it->second.nPendingWaits;
+                entryData.pendingWaitTimeMS += it->second.pendingWaitTimeMS;
+                entryData.nEvictions += it->second.nEvictions;
+                entryData.nBytesAllocated += it->second.nBytesAllocated;
+                if (bucketsInfos) {
+                    CacheReportInfo& bucketData = (*bucketsInfos)[bucket_i];
+                    bucketData.nHits += it->second.nHits;
+                    bucketData.nMisses += it->second.nMisses;
+                    bucketData.nPendingWaits += it->second.nPendingWaits;
+                    bucketData.pendingWaitTimeMS += it->second.pendingWaitTimeMS;
+                    bucketData.nEvictions += it->second.nEvictions;
+                    bucketData.nBytesAllocated += it->second.nBytesAllocated;
+                }
+            }
+        }
     } // for each bucket
+
+    // Report the compressed tier
+    boost::unique_lock<boost::mutex> k(_imp->compressedTierMutex);
+    for (CompressedTilesMap::const_iterator it = _imp->compressedTiles.begin(); it != _imp->compressedTiles.end(); ++it) {
+        CacheReportInfo& entryData = (*infos)[it->second.pluginID];
+        ++entryData.nCompressedTiles;
+        entryData.nCompressedBytes += it->second.data.size();
+    }
+    for (std::map<std::string, std::pair<U64, U64> >::const_iterator it = _imp->compressedTierHitsMisses.begin(); it != _imp->compressedTierHitsMisses.end(); ++it) {
+        CacheReportInfo& entryData = (*infos)[it->first];
+        entryData.nCompressedTierHits = it->second.first;
+        entryData.nCompressedTierMisses = it->second.second;
+    }
+
+    // Report the remote tier
+    boost::unique_lock<boost::mutex> remoteLocker(_imp->remoteTierMutex);
+    for (std::map<std::string, boost::tuple<U64, U64, U64> >::const_iterator it = _imp->remoteTierStats.begin(); it != _imp->remoteTierStats.end(); ++it) {
+        CacheReportInfo& entryData = (*infos)[it->first];
+        entryData.nRemoteTierHits = it->second.get<0>();
+        entryData.nRemoteTierMisses = it->second.get<1>();
+        entryData.nRemoteTierPublishedTiles = it->second.get<2>();
+    }
 } // getMemoryStats
 
 template <bool persistent>
 void
 Cache<persistent>::flushCacheOnDisk(bool async)
 {
-    (void)async;
-#if 0
     if (!persistent) {
         return;
     }
 
+    int flushType = async ? (int)MemoryFile::eFlushTypeAsync : (int)MemoryFile::eFlushTypeSync;
+
+    // Flush the tiles written so far, in contiguous ranges
+    _imp->flushDirtyTiles(flushType);
+
 #ifdef NATRON_CACHE_INTERPROCESS_ROBUST
     SHMReadLockerPtr shmReader(new SharedMemoryProcessLocalReadLocker(_imp.get()));
 #endif
-    
+
+    // Flush the table of content of each bucket
     for (int bucket_i = 0; bucket_i < NATRON_CACHE_BUCKETS_COUNT; ++bucket_i) {
         CacheBucket<persistent>& bucket = _imp->buckets[bucket_i];
 
         try {
+            // Take the read lock on the toc file mapping: this remaps it if needed
+            boost::scoped_ptr<Sharable_ReadLock> tocReadLock;
             boost::scoped_ptr<Sharable_WriteLock> tocWriteLock;
-#ifndef NATRON_CACHE_INTERPROCESS_ROBUST
-            tocWriteLock.reset(new Sharable_WriteLock(_imp->ipc->bucketsData[bucket_i].tocData.segmentMutex));
-#else
-            createTimedLock<Sharable_WriteLock>(_imp.get(), tocWriteLock, &_imp->ipc->bucketsData[bucket_i].tocData.segmentMutex);
-#endif
-            // First take a read lock and check if the mapping is valid. Otherwise take a write lock
-            if (!bucket.isToCFileMappingValid()) {
-                // This function will flush for us.
-                bucket.remapToCMemoryFile(*tocWriteLock, 0);
-            } else {
-                bucket.tocFile->flush(async ? MemoryFile::eFlushTypeAsync : MemoryFile::eFlushTypeSync, NULL, 0);
-            }
-
-            {
-
-                boost::scoped_ptr<Sharable_ReadLock> tilesStorageReadLock;
-#ifndef NATRON_CACHE_INTERPROCESS_ROBUST
-                tilesStorageReadLock.reset(new Sharable_ReadLock(_imp->ipc->tilesStorageMutex));
-#else
-                createTimedLock<Sharable_WriteLock>(this, tilesStorageReadLock, &_imp->ipc->tilesStorageMutex);
-#endif
-                for (U64_Set::const_iterator it = _imp->buckets[bucket_i].ipc->freeTiles.begin(); it != _imp->buckets[bucket_i].ipc->freeTiles.end(); ++it) {
-                    U32 tileIndex, fileIndex;
-                    getTileIndex(*it, &tileIndex, &fileIndex);
-
-                    if (fileIndex >= _imp->tilesStorage.size()) {
-                        continue;
-                    }
-                    CachePrivate::TileAlignedData* storage = &_imp->tilesStorage[fileIndex];
-                    std::size_t dataOffset = tileIndex * NATRON_TILE_SIZE_BYTES;
-                    storage->tileAlignedFile->flush(MemoryFile::eFlushTypeInvalidate, storage->tileAlignedFile->data() + dataOffset, NATRON_TILE_SIZE_BYTES);
+            bucket.checkToCMemorySegmentStatus(&tocReadLock, &tocWriteLock);
 
-                }
+            if (bucket.tocFile) {
+                flushMemory(bucket.tocFile, flushType, NULL, 0);
             }
-
         } catch (...) {
             // Any exception caught here means the cache is corrupted
             _imp->recoverFromInconsistentState(
@@ -4397,11 +6792,10 @@ Cache<persistent>::flushCacheOnDisk(bool async)
                                                 shmReader
 #endif
                                                );
-
+            return;
         }
 
     } // for each bucket
-#endif
 } // flushCacheOnDisk
 
 template class Cache<true>;
@@ -51,19 +51,15 @@
 // Each 8 bit tile will have pow(2, tileSizePo2) pixels in each dimension.
 // 16 bit tiles will have one side halved
 // 32 bit tiles will have both dimension halved (so tile size for 32bit is actually pow(2, tileSizePo2-1)
+// A tile thus always has pow(2, 2 * tileSizePo2) bytes, whatever its bitdepth.
 //
+// The tileSizePo2 is a parameter of the tile cache, given to Cache::create(). The larger the tiles,
+// the fewer tiles an image needs and the lower the bookkeeping overhead per image.
+#define NATRON_TILE_SIZE_PO2_DEFAULT 7
+#define NATRON_TILE_SIZE_PO2_MIN 6
+#define NATRON_TILE_SIZE_PO2_MAX 9
 
-
-#define NATRON_TILE_SIZE_X_8_BIT 128
-#define NATRON_TILE_SIZE_Y_8_BIT 128
-
-#define NATRON_TILE_SIZE_X_16_BIT NATRON_TILE_SIZE_X_8_BIT
-#define NATRON_TILE_SIZE_Y_16_BIT (NATRON_TILE_SIZE_Y_8_BIT / 2)
-
-#define NATRON_TILE_SIZE_X_32_BIT (NATRON_TILE_SIZE_X_8_BIT / 2)
-#define NATRON_TILE_SIZE_Y_32_BIT (NATRON_TILE_SIZE_Y_8_BIT / 2)
-
-#define NATRON_TILE_SIZE_BYTES (NATRON_TILE_SIZE_X_8_BIT * NATRON_TILE_SIZE_Y_8_BIT)
+#define NATRON_TILE_SIZE_BYTES_FOR_PO2(tileSizePo2) ((std::size_t)1 << (2 * (tileSizePo2)))
 
 
 // The name of the directory containing all buckets on disk
@@ -101,6 +97,10 @@
 // the cache may not be placed in a network drive.
 // If not defined, the cache supports only a single process writing/reading from the cache concurrently, other processes will resort
 // in a process-local cache.
+// This is defined when building with CONFIG+=cache-interprocess, e.g: so that several NatronRenderer processes
+// rendering chunks of the same project on a host share the images they computed.
+// Mutexes are taken with a timeout: if a process crashes while holding one, the others wipe the shared memory
+// and the cache instead of waiting forever, see CachePrivate::recoverFromInconsistentState().
 //#define NATRON_CACHE_INTERPROCESS_ROBUST
 
 NATRON_NAMESPACE_ENTER;
@@ -111,9 +111,64 @@ struct CacheReportInfo
     int nEntries;
     std::size_t nBytes;
 
+    // Tiles held in the compressed tier, see CacheBase::setCompressedTierMaximumSize
+    int nCompressedTiles;
+    std::size_t nCompressedBytes;
+
+    // Number of tiles restored from the compressed tier and number of tiles that were looked-up but not found
+    U64 nCompressedTierHits, nCompressedTierMisses;
+
+    // Number of tiles read from the remote tier and number of tiles that were looked-up but not found, see CacheBase::setRemoteTier
+    U64 nRemoteTierHits, nRemoteTierMisses;
+
+    // Number of tiles written to the remote tier by this process
+    U64 nRemoteTierPublishedTiles;
+
+    // Access counters of this process since the cache was created or cleared: look-ups that found the entry,
+    // look-ups that had to compute it and look-ups that had to wait for another thread to compute it
+    U64 nHits, nMisses, nPendingWaits;
+
+    // Total time in milliseconds spent in CacheEntryLocker::waitForPendingEntry()
+    double pendingWaitTimeMS;
+
+    // Number of entries evicted and number of bytes allocated for tiles
+    U64 nEvictions;
+    std::size_t nBytesAllocated;
+
     CacheReportInfo()
     : nEntries(0)
     , nBytes(0)
+    , nCompressedTiles(0)
+    , nCompressedBytes(0)
+    , nCompressedTierHits(0)
+    , nCompressedTierMisses(0)
+    , nRemoteTierHits(0)
+    , nRemoteTierMisses(0)
+    , nRemoteTierPublishedTiles(0)
+    , nHits(0)
+    , nMisses(0)
+    , nPendingWaits(0)
+    , pendingWaitTimeMS(0)
+    , nEvictions(0)
+    , nBytesAllocated(0)
+    {
+
+    }
+};
+
+struct CacheQuotaGroupReportInfo
+{
+    // See CacheBase::CacheQuotaGroupTypeEnum
+    int type;
+
+    // The bytes accounted to the group and the quota of the group (0 if unlimited)
+    std::size_t nBytes;
+    std::size_t quota;
+
+    CacheQuotaGroupReportInfo()
+    : type(0)
+    , nBytes(0)
+    , quota(0)
     {
 
     }
@@ -288,9 +343,21 @@ public:
 
 
     /**
-     * @brief Returns the tile size (of one dimension) in pixels for the given bitdepth/
+     * @brief Returns the tile size (of one dimension) in pixels for the given bitdepth
+     * of a tile storage created with the given tileSizePo2.
+     **/
+    static void getTileSizePxForPo2(int tileSizePo2, ImageBitDepthEnum bitdepth, int *tx, int *ty);
+
+    /**
+     * @brief Returns the tile size (of one dimension) in pixels for the given bitdepth
+     * in this cache tile storage.
+     **/
+    virtual void getTileSizePx(ImageBitDepthEnum bitdepth, int *tx, int *ty) const = 0;
+
+    /**
+     * @brief Returns the number of bytes of a single tile in this cache tile storage.
      **/
-    static void getTileSizePx(ImageBitDepthEnum bitdepth, int *tx, int *ty);
+    virtual std::size_t getTileSizeBytes() const = 0;
 
     /**
      * @brief Returns whether the cache is persistent or not
@@ -319,6 +386,115 @@ public:
      **/
     virtual std::size_t getCurrentSize() const = 0;
 
+    /**
+     * @brief Set the maximum size in bytes of the compressed tier. Tiles evicted from the tile storage
+     * by evictLRUEntries() are compressed and kept in process memory up to this size, so that they can be
+     * restored with retrieveAndLockCompressedTiles() instead of being rendered again.
+     * A size of 0 disables the compressed tier.
+     **/
+    virtual void setCompressedTierMaximumSize(std::size_t size) = 0;
+    virtual std::size_t getCompressedTierMaximumSize() const = 0;
+
+    /**
+     * @brief Set the directory of the remote tier, typically on a storage shared by all the hosts of a render farm.
+     * The tiles of entries that took at least minimumRenderCost seconds to render are written there in the background
+     * with publishRemoteTiles(), one file per tile named after the entry hash, so that any process on any host
+     * rendering the same image can read them with retrieveAndLockRemoteTiles() instead of rendering them.
+     * An empty path disables the remote tier.
+     **/
+    virtual void setRemoteTier(const std::string& path, double minimumRenderCost) = 0;
+    virtual std::string getRemoteTierPath() const = 0;
+
+    enum CacheEvictionPolicyEnum
+    {
+        // Evict the least recently used entries first
+        eCacheEvictionPolicyLRU,
+
+        // Amongst the least recently used entries, evict first the ones that are the cheapest to
+        // compute again relative to their size (GreedyDual-Size), see addEntryCost()
+        eCacheEvictionPolicyCost
+    };
+
+    /**
+     * @brief Set the policy used by evictLRUEntries() to choose the entries to evict
+     **/
+    virtual void setEvictionPolicy(CacheEvictionPolicyEnum policy) = 0;
+    virtual CacheEvictionPolicyEnum getEvictionPolicy() const = 0;
+
+    enum CacheTileStoragePagesEnum
+    {
+        // Tiles are allocated with the default page size of the system
+        eCacheTileStoragePagesDefault,
+
+        // The system is advised to back the tiles with transparent huge pages
+        eCacheTileStoragePagesTransparentHuge,
+
+        // Tiles are allocated in the huge pages reserved by the system, or transparent huge pages if there is none
+        eCacheTileStoragePagesExplicitHuge
+    };
+
+    /**
+     * @brief Set how the tile storage files are allocated in RAM. Huge pages reduce the TLB misses when
+     * accessing large images. If interleaveNUMANodes is true, the pages of the tile storage are spread
+     * across all NUMA nodes so that render threads running on any socket get the same memory bandwidth.
+     * This only has an effect on Linux. Changing the policy clears the cache so that the tile storage gets re-allocated.
+     * This has no effect on a persistent cache: its tile storage is backed by memory mapped files.
+     **/
+    virtual void setTileStorageAllocation(CacheTileStoragePagesEnum pages, bool interleaveNUMANodes) = 0;
+
+    /**
+     * @brief Add the given time in seconds spent computing the entry to its cost,
+     * used by the eCacheEvictionPolicyCost policy. The entry must be in the cache.
+     **/
+    virtual void addEntryCost(const CacheEntryBasePtr& entry, double cost) = 0;
+
+    /**
+     * @brief Set the amount in bytes of tiles written since the last flush above which a persistent cache
+     * flushes them on disk. Tiles are flushed in the background by coalescing contiguous tiles of each
+     * tile storage file, so that the disk receives large sequential writes rather than one write per tile.
+     * Regardless of this value, tiles are flushed periodically. A value of 0 only flushes periodically.
+     * This has no effect on a cache that is not persistent.
+     **/
+    virtual void setDirtyTilesHighWatermark(std::size_t size) = 0;
+    virtual std::size_t getDirtyTilesHighWatermark() const = 0;
+
+    enum CacheQuotaGroupTypeEnum
+    {
+        // Each project (i.e: AppInstance) may use at most the quota
+        eCacheQuotaGroupProject,
+
+        // Each node may use at most the quota
+        eCacheQuotaGroupNode,
+
+        // The quota is reserved for viewer outputs: they are not evicted by other entries while they fit in it
+        eCacheQuotaGroupViewer
+    };
+
+    /**
+     * @brief Set the quota in bytes of each group of the given type, see CacheEntryKeyBase::setQuotaGroups().
+     * When a group exceeds its quota, evictLRUEntries() evicts the entries of that group first, regardless of
+     * the cache maximum size. A quota of 0 disables quotas for that type of group.
+     **/
+    virtual void setQuotaGroupSize(CacheQuotaGroupTypeEnum type, std::size_t size) = 0;
+    virtual std::size_t getQuotaGroupSize(CacheQuotaGroupTypeEnum type) const = 0;
+
+    /**
+     * @brief Returns a counter incremented each time entries are removed from the cache by this process (evicted,
+     * removed or cleared). Clients that keep track of entries they know are cached only need to look them up
+     * again when it changed. It may wrap around: only compare it for equality.
+     * Entries removed by other processes sharing a persistent cache are not counted.
+     * This is MT-safe and does not lock.
+     **/
+    virtual int getRemovedEntriesCount() const = 0;
+
+    /**
+     * @brief Asynchronously faults in the table of content and the tiles of all entries whose key was produced by a
+     * holder with one of the given hashes, see CacheEntryKeyBase::getHolderHash().
+     * This is useful with a persistent cache, so that the first access to these entries does not wait for the disk.
+     * This has no effect on a cache that is not persistent.
+     **/
+    virtual void prefetchEntries(const std::vector<U64>& holderHashes) = 0;
+
     /**
      * @brief Look-up the cache for the given entry's key.
      * The entry is assumed to have its key set.
@@ -339,7 +515,7 @@ public:
      * @param tilesToAlloc A vector of size of the number of desired tiles in output. The numbers in the vector are used to offset the bucket of the 
      * cache on which to retrieve tiles from.
      * @param allocatedTilesData[out] In output, this contains each tiles allocated as a pair of <tileIndex, pointer>
-     * Each tile will have exactly NATRON_TILE_SIZE_BYTES bytes. The index is the index that must be passed back to the unLockTiles
+     * Each tile will have exactly getTileSizeBytes() bytes. The index is the index that must be passed back to the unLockTiles
      * and releaseTiles functions.
      *
      * @param tileIndices List of existing tile indices for which we want to retrieve a pointer to. In output they will be set to existingTilesData
@@ -363,6 +539,42 @@ public:
                               std::vector<std::pair<U64, void*> >* allocatedTilesData,
                               void** cacheData) = 0;
 
+    /**
+     * @brief Restore tiles of the given entry that were evicted to the compressed tier.
+     * @param tilesToRestore The local indices of the tiles, as they were passed in tilesToAlloc to retrieveAndLockTiles()
+     * when the tiles were allocated.
+     * @param allocatedTilesData[out] Of the same size as tilesToRestore: for each tile found in the compressed tier, it is
+     * removed from the tier and decompressed into a newly allocated tile of the tile storage, as returned by retrieveAndLockTiles().
+     * Tiles that were not found are set to <-1, NULL>.
+     * The same rules as retrieveAndLockTiles() apply: unLockTiles() must be called with the cacheData pointer in any case.
+     * @returns True if at least one tile was restored.
+     **/
+    virtual bool retrieveAndLockCompressedTiles(const CacheEntryBasePtr& entry,
+                                                const std::vector<U64>& tilesToRestore,
+                                                std::vector<std::pair<U64, void*> >* allocatedTilesData,
+                                                void** cacheData) = 0;
+
+    /**
+     * @brief Same as retrieveAndLockCompressedTiles() except that the tiles are read from the remote tier, see setRemoteTier().
+     * The tiles read stay in the remote tier.
+     **/
+    virtual bool retrieveAndLockRemoteTiles(const CacheEntryBasePtr& entry,
+                                            const std::vector<U64>& tilesToRestore,
+                                            std::vector<std::pair<U64, void*> >* allocatedTilesData,
+                                            void** cacheData) = 0;
+
+    /**
+     * @brief Write the given tiles of the entry to the remote tier if renderCost, the time in seconds spent rendering them,
+     * is at least the minimum render cost passed to setRemoteTier(). Tiles already in the remote tier are not written again.
+     * @param tileLocalIndices The local indices of the tiles, as passed in tilesToAlloc to retrieveAndLockTiles()
+     * @param tilesData Of the same size as tileLocalIndices, the tiles as returned by retrieveAndLockTiles(). They are copied
+     * before returning and written asynchronously.
+     **/
+    virtual void publishRemoteTiles(const CacheEntryBasePtr& entry,
+                                    const std::vector<U64>& tileLocalIndices,
+                                    const std::vector<void*>& tilesData,
+                                    double renderCost) = 0;
+
 #ifdef DEBUG
     /**
      * @brief Debug: Ensures that the index is valid in the storage. Can only be called between retrieveAndLockTiles and 
@@ -396,6 +608,8 @@ public:
     /**
      * @brief Clears the cache of its last recently used entries so at least nBytesToFree are available for the given storage.
      * This should be called before allocating any buffer in the application to ensure we do not hit the swap.
+     * Entries are evicted only once the cache size exceeds a high watermark, slightly below the maximum size minus nBytesToFree,
+     * and then until it is below a lower watermark, so that the next insertions do not each trigger an eviction.
      *
      * This function is not blocking and it is not guaranteed that the memory is available when returning. 
      * Evicted entries will be deleted in a separate thread so this thread can continue its own work.
@@ -421,9 +635,12 @@ public:
     virtual void flushCacheOnDisk(bool async) = 0;
 
     /**
-     * @brief Returns cache stats for each plug-in
+     * @brief Returns cache stats for each plug-in and optionally the bytes used by each quota group, see setQuotaGroupSize()
+     * @param bucketsInfos If non NULL, it is resized to the number of buckets and receives the stats of each bucket.
      **/
-    virtual void getMemoryStats(std::map<std::string, CacheReportInfo>* infos) const = 0;
+    virtual void getMemoryStats(std::map<std::string, CacheReportInfo>* infos,
+                                std::map<std::string, CacheQuotaGroupReportInfo>* quotaGroupsInfos = 0,
+                                std::vector<CacheReportInfo>* bucketsInfos = 0) const = 0;
 
 
 };
@@ -469,7 +686,7 @@ class Cache
 
     void initialize(const boost::shared_ptr<Cache<persistent> >& thisShared);
 
-    Cache(bool enableTileStorage);
+    Cache(bool enableTileStorage, int tileSizePo2);
 
 public:
 
@@ -481,15 +698,33 @@ public:
     /**
      * @brief Create a new instance of a cache
      * If the cache is persistent, this function may throw a BusyCacheException exception if the cache is used by another process
+     * @param tileSizePo2 The size of the tiles of the tile storage, see NATRON_TILE_SIZE_PO2_DEFAULT.
+     * If a persistent cache on disk was created with another tile size, it is wiped.
      **/
-    static CacheBasePtr create(bool enableTileStorage);
+    static CacheBasePtr create(bool enableTileStorage, int tileSizePo2 = NATRON_TILE_SIZE_PO2_DEFAULT);
 
 
     virtual bool isPersistent() const OVERRIDE FINAL;
     virtual std::string getCacheDirectoryPath() const OVERRIDE FINAL;
+    virtual void getTileSizePx(ImageBitDepthEnum bitdepth, int *tx, int *ty) const OVERRIDE FINAL;
+    virtual std::size_t getTileSizeBytes() const OVERRIDE FINAL;
     virtual void setMaximumCacheSize(std::size_t size) OVERRIDE FINAL;
     virtual std::size_t getMaximumCacheSize() const OVERRIDE FINAL;
     virtual std::size_t getCurrentSize() const OVERRIDE FINAL;
+    virtual void setCompressedTierMaximumSize(std::size_t size) OVERRIDE FINAL;
+    virtual std::size_t getCompressedTierMaximumSize() const OVERRIDE FINAL;
+    virtual void setRemoteTier(const std::string& path, double minimumRenderCost) OVERRIDE FINAL;
+    virtual std::string getRemoteTierPath() const OVERRIDE FINAL;
+    virtual void setEvictionPolicy(CacheEvictionPolicyEnum policy) OVERRIDE FINAL;
+    virtual CacheEvictionPolicyEnum getEvictionPolicy() const OVERRIDE FINAL;
+    virtual void setTileStorageAllocation(CacheTileStoragePagesEnum pages, bool interleaveNUMANodes) OVERRIDE FINAL;
+    virtual void addEntryCost(const CacheEntryBasePtr& entry, double cost) OVERRIDE FINAL;
+    virtual void setDirtyTilesHighWatermark(std::size_t size) OVERRIDE FINAL;
+    virtual std::size_t getDirtyTilesHighWatermark() const OVERRIDE FINAL;
+    virtual void setQuotaGroupSize(CacheQuotaGroupTypeEnum type, std::size_t size) OVERRIDE FINAL;
+    virtual std::size_t getQuotaGroupSize(CacheQuotaGroupTypeEnum type) const OVERRIDE FINAL;
+    virtual int getRemovedEntriesCount() const OVERRIDE FINAL;
+    virtual void prefetchEntries(const std::vector<U64>& holderHashes) OVERRIDE FINAL;
     virtual CacheEntryLockerBasePtr get(const CacheEntryBasePtr& entry) const OVERRIDE FINAL;
     virtual bool retrieveAndLockTiles(const CacheEntryBasePtr& entry,
                                       const std::vector<U64>* tileIndices,
@@ -497,6 +732,18 @@ public:
                                       std::vector<void*>* existingTilesData,
                                       std::vector<std::pair<U64, void*> >* allocatedTilesData,
                                       void** cacheData) OVERRIDE FINAL;
+    virtual bool retrieveAndLockCompressedTiles(const CacheEntryBasePtr& entry,
+                                                const std::vector<U64>& tilesToRestore,
+                                                std::vector<std::pair<U64, void*> >* allocatedTilesData,
+                                                void** cacheData) OVERRIDE FINAL;
+    virtual bool retrieveAndLockRemoteTiles(const CacheEntryBasePtr& entry,
+                                            const std::vector<U64>& tilesToRestore,
+                                            std::vector<std::pair<U64, void*> >* allocatedTilesData,
+                                            void** cacheData) OVERRIDE FINAL;
+    virtual void publishRemoteTiles(const CacheEntryBasePtr& entry,
+                                    const std::vector<U64>& tileLocalIndices,
+                                    const std::vector<void*>& tilesData,
+                                    double renderCost) OVERRIDE FINAL;
 #ifdef DEBUG
     virtual bool checkTileIndex(U64 encodedIndex) const OVERRIDE FINAL WARN_UNUSED_RETURN;
 #endif
@@ -507,7 +754,9 @@ public:
     virtual void clear() OVERRIDE FINAL;
     virtual void removeEntry(const CacheEntryBasePtr& entry) OVERRIDE FINAL;
     virtual void flushCacheOnDisk(bool async) OVERRIDE FINAL;
-    virtual void getMemoryStats(std::map<std::string, CacheReportInfo>* infos) const OVERRIDE FINAL;
+    virtual void getMemoryStats(std::map<std::string, CacheReportInfo>* infos,
+                                std::map<std::string, CacheQuotaGroupReportInfo>* quotaGroupsInfos = 0,
+                                std::vector<CacheReportInfo>* bucketsInfos = 0) const OVERRIDE FINAL;
 
 
 private:
@@ -36,12 +36,17 @@ struct CacheEntryKeyBasePrivate
 {
     mutable QMutex lock;
     std::string pluginID;
+    std::string projectQuotaGroup, nodeQuotaGroup;
+    bool isViewerOutput;
     mutable U64 hash;
     mutable bool hashComputed;
 
     CacheEntryKeyBasePrivate()
     : lock()
     , pluginID()
+    , projectQuotaGroup()
+    , nodeQuotaGroup()
+    , isViewerOutput(false)
     , hash(0)
     , hashComputed(false)
     {
@@ -113,6 +118,30 @@ CacheEntryKeyBase::setHolderPluginID(const std::string& holderID) {
     _imp->pluginID = holderID;
 }
 
+U64
+CacheEntryKeyBase::getHolderHash() const
+{
+    return 0;
+}
+
+void
+CacheEntryKeyBase::setQuotaGroups(const std::string& projectGroup, const std::string& nodeGroup, bool isViewerOutput)
+{
+    QMutexLocker k(&_imp->lock);
+    _imp->projectQuotaGroup = projectGroup;
+    _imp->nodeQuotaGroup = nodeGroup;
+    _imp->isViewerOutput = isViewerOutput;
+}
+
+void
+CacheEntryKeyBase::getQuotaGroups(std::string* projectGroup, std::string* nodeGroup, bool* isViewerOutput) const
+{
+    QMutexLocker k(&_imp->lock);
+    *projectGroup = _imp->projectQuotaGroup;
+    *nodeGroup = _imp->nodeQuotaGroup;
+    *isViewerOutput = _imp->isViewerOutput;
+}
+
 std::size_t
 CacheEntryKeyBase::getMetadataSize() const
 {
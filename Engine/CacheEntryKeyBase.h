@@ -54,6 +54,7 @@ NATRON_NAMESPACE_ENTER;
 #define kCacheKeyUniqueIDGetComponentsResults 6
 #define kCacheKeyUniqueIDGetFrameRangeResults 7
 #define kCacheKeyUniqueIDGetDistortionResults 9
+#define kCacheKeyUniqueIDGetRegionsOfInterestResults 10
 
 
 
@@ -126,6 +127,22 @@ public:
     std::string getHolderPluginID() const;
     void setHolderPluginID(const std::string& holderID);
 
+    /**
+     * @brief Returns a hash identifying the state of the holder that produced this entry
+     * (e.g: the node hash at a given time and view), or 0 if the entry is not associated to a holder state.
+     * This is used by CacheBase::prefetchEntries().
+     **/
+    virtual U64 getHolderHash() const;
+
+    /**
+     * @brief Set the quota groups the entry is accounted to, see CacheBase::setQuotaGroupSize().
+     * The project group is typically the application ID and the node group the fully qualified name of the
+     * node prefixed by the application ID. An empty string means the entry does not belong to a group of that type.
+     * The quota groups are not part of the hash.
+     **/
+    void setQuotaGroups(const std::string& projectGroup, const std::string& nodeGroup, bool isViewerOutput);
+    void getQuotaGroups(std::string* projectGroup, std::string* nodeGroup, bool* isViewerOutput) const;
+
     
     /**
      * @brief Must return a unique string identifying this class.
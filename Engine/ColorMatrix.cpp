@@ -0,0 +1,103 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ColorMatrix.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "Engine/Image.h"
+
+NATRON_NAMESPACE_ENTER;
+
+ColorMatrix::ColorMatrix()
+: inputNbToTransform(-1)
+{
+    for (int i = 0; i < 12; ++i) {
+        m[i] = 0.;
+    }
+    m[0] = m[5] = m[10] = 1.;
+}
+
+ColorMatrix::~ColorMatrix()
+{
+}
+
+ColorMatrix
+ColorMatrix::concatenate(const ColorMatrix& after, const ColorMatrix& before)
+{
+    ColorMatrix ret;
+    ret.inputNbToTransform = before.inputNbToTransform;
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 4; ++col) {
+            double v = 0.;
+            for (int k = 0; k < 3; ++k) {
+                v += after.m[row * 4 + k] * before.m[k * 4 + col];
+            }
+            ret.m[row * 4 + col] = v;
+        }
+        // The offset of after is added to the transformed offset of before
+        ret.m[row * 4 + 3] += after.m[row * 4 + 3];
+    }
+
+    return ret;
+}
+
+ImagePtr
+ColorMatrix::applyToImageCopy(const ColorMatrix& matrix, const ImagePtr& image)
+{
+    assert(image);
+    if ( !image || (image->getStorageMode() == eStorageModeGLTex) ) {
+        return ImagePtr();
+    }
+
+    Image::InitStorageArgs initArgs;
+    initArgs.bounds = image->getBounds();
+    initArgs.proxyScale = image->getProxyScale();
+    initArgs.mipMapLevel = image->getMipMapLevel();
+    initArgs.plane = image->getLayer();
+    initArgs.bitdepth = image->getBitDepth();
+    initArgs.bufferFormat = image->getBufferFormat();
+    initArgs.storage = eStorageModeRAM;
+    ImagePtr ret = Image::create(initArgs);
+    if (!ret) {
+        return ret;
+    }
+
+    Image::CopyPixelsArgs copyArgs;
+    copyArgs.roi = initArgs.bounds;
+    ActionRetCodeEnum stat = ret->copyPixels(*image, copyArgs);
+    if ( isFailureRetCode(stat) ) {
+        return ImagePtr();
+    }
+    stat = ret->applyColorMatrix(initArgs.bounds, matrix.m);
+    if ( isFailureRetCode(stat) ) {
+        return ImagePtr();
+    }
+
+    return ret;
+} // applyToImageCopy
+
+NATRON_NAMESPACE_EXIT;
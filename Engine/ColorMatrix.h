@@ -0,0 +1,72 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_ColorMatrix_h
+#define Engine_ColorMatrix_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief A colour operation that can be represented as a 3x4 matrix applied to the RGB channels of one input of an effect.
+ * Effects returning one from EffectInstance::getColorMatrix() are concatenated: a chain of such effects is not rendered,
+ * instead the effect fetching the image at the bottom of the chain receives the image at the top of the chain with the
+ * product of their matrices applied in a single pass.
+ **/
+class ColorMatrix
+{
+public:
+
+    // Initializes to the identity, with no input
+    ColorMatrix();
+
+    ~ColorMatrix();
+
+    /**
+     * @brief Returns the matrix applying first before and then after. The input is the one of before.
+     **/
+    static ColorMatrix concatenate(const ColorMatrix& after, const ColorMatrix& before);
+
+    /**
+     * @brief Returns a copy of the given image with the matrix applied, or NULL if it could not be done.
+     * The image must have a CPU storage.
+     **/
+    static ImagePtr applyToImageCopy(const ColorMatrix& matrix, const ImagePtr& image);
+
+public:
+
+    // Index of the input to which the matrix is applied
+    int inputNbToTransform;
+
+    // The rows for the red, green and blue channels: each row holds the coefficients
+    // of the red, green and blue channels followed by an offset
+    double m[12];
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // Engine_ColorMatrix_h
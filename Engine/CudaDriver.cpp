@@ -0,0 +1,285 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "CudaDriver.h"
+
+#include <vector>
+
+#include "Engine/LibraryBinary.h"
+
+// The library of the driver API, installed with the NVIDIA driver. CUDA is not available on macOS.
+#if defined(__NATRON_WIN32__)
+#define NATRON_CUDA_DRIVER_LIBRARY "nvcuda.dll"
+#define NATRON_CUDA_API __stdcall
+#elif defined(__NATRON_LINUX__)
+#define NATRON_CUDA_DRIVER_LIBRARY "libcuda.so.1"
+#define NATRON_CUDA_API
+#else
+#define NATRON_CUDA_API
+#endif
+
+#define NATRON_CUDA_SUCCESS 0
+
+NATRON_NAMESPACE_ENTER;
+
+// The types of the driver API, see cuda.h. CUdeviceptr is 64-bit since CUDA 3.2, this is why the _v2 functions are used.
+typedef int CUresult;
+typedef int CUdevice;
+typedef void* CUcontext;
+typedef void* CUstream;
+typedef U64 CUdeviceptr;
+
+typedef CUresult (NATRON_CUDA_API *CuInitFunc)(unsigned int flags);
+typedef CUresult (NATRON_CUDA_API *CuDeviceGetCountFunc)(int* count);
+typedef CUresult (NATRON_CUDA_API *CuDeviceGetFunc)(CUdevice* device, int ordinal);
+typedef CUresult (NATRON_CUDA_API *CuDeviceGetNameFunc)(char* name, int len, CUdevice device);
+typedef CUresult (NATRON_CUDA_API *CuDevicePrimaryCtxRetainFunc)(CUcontext* context, CUdevice device);
+typedef CUresult (NATRON_CUDA_API *CuDevicePrimaryCtxReleaseFunc)(CUdevice device);
+typedef CUresult (NATRON_CUDA_API *CuCtxPushCurrentFunc)(CUcontext context);
+typedef CUresult (NATRON_CUDA_API *CuCtxPopCurrentFunc)(CUcontext* context);
+typedef CUresult (NATRON_CUDA_API *CuStreamCreateFunc)(CUstream* stream, unsigned int flags);
+typedef CUresult (NATRON_CUDA_API *CuStreamDestroyFunc)(CUstream stream);
+typedef CUresult (NATRON_CUDA_API *CuStreamSynchronizeFunc)(CUstream stream);
+typedef CUresult (NATRON_CUDA_API *CuMemAllocFunc)(CUdeviceptr* buffer, std::size_t size);
+typedef CUresult (NATRON_CUDA_API *CuMemFreeFunc)(CUdeviceptr buffer);
+typedef CUresult (NATRON_CUDA_API *CuMemcpyHtoDFunc)(CUdeviceptr dst, const void* src, std::size_t size);
+typedef CUresult (NATRON_CUDA_API *CuMemcpyDtoHFunc)(void* dst, CUdeviceptr src, std::size_t size);
+
+struct CudaDriverPrivate
+{
+    boost::scoped_ptr<LibraryBinary> library;
+    CuDevicePrimaryCtxReleaseFunc cuDevicePrimaryCtxRelease;
+    CuCtxPushCurrentFunc cuCtxPushCurrent;
+    CuCtxPopCurrentFunc cuCtxPopCurrent;
+    CuStreamCreateFunc cuStreamCreate;
+    CuStreamDestroyFunc cuStreamDestroy;
+    CuStreamSynchronizeFunc cuStreamSynchronize;
+    CuMemAllocFunc cuMemAlloc;
+    CuMemFreeFunc cuMemFree;
+    CuMemcpyHtoDFunc cuMemcpyHtoD;
+    CuMemcpyDtoHFunc cuMemcpyDtoH;
+    CUdevice device;
+    CUcontext context;
+    std::string deviceName;
+    bool valid;
+
+    CudaDriverPrivate()
+    : library()
+    , cuDevicePrimaryCtxRelease(0)
+    , cuCtxPushCurrent(0)
+    , cuCtxPopCurrent(0)
+    , cuStreamCreate(0)
+    , cuStreamDestroy(0)
+    , cuStreamSynchronize(0)
+    , cuMemAlloc(0)
+    , cuMemFree(0)
+    , cuMemcpyHtoD(0)
+    , cuMemcpyDtoH(0)
+    , device(0)
+    , context(0)
+    , deviceName()
+    , valid(false)
+    {
+    }
+
+    void load();
+};
+
+template <typename T>
+static T
+getCudaFunction(const LibraryBinary& library,
+                const std::string& name)
+{
+    std::pair<bool, T> found = library.findFunction<T>(name);
+
+    return found.first ? found.second : 0;
+}
+
+void
+CudaDriverPrivate::load()
+{
+#ifdef NATRON_CUDA_DRIVER_LIBRARY
+    std::vector<std::string> functions;
+    functions.push_back("cuInit");
+    functions.push_back("cuDeviceGetCount");
+    functions.push_back("cuDeviceGet");
+    functions.push_back("cuDeviceGetName");
+    functions.push_back("cuDevicePrimaryCtxRetain");
+    functions.push_back("cuDevicePrimaryCtxRelease");
+    functions.push_back("cuCtxPushCurrent_v2");
+    functions.push_back("cuCtxPopCurrent_v2");
+    functions.push_back("cuStreamCreate");
+    functions.push_back("cuStreamDestroy_v2");
+    functions.push_back("cuStreamSynchronize");
+    functions.push_back("cuMemAlloc_v2");
+    functions.push_back("cuMemFree_v2");
+    functions.push_back("cuMemcpyHtoD_v2");
+    functions.push_back("cuMemcpyDtoH_v2");
+
+    library.reset( new LibraryBinary(NATRON_CUDA_DRIVER_LIBRARY) );
+    if ( !library->isValid() || !library->loadFunctions(functions) ) {
+        // A driver older than CUDA 7 does not have the primary context functions
+        library.reset();
+
+        return;
+    }
+
+    CuInitFunc cuInit = getCudaFunction<CuInitFunc>(*library, "cuInit");
+    CuDeviceGetCountFunc cuDeviceGetCount = getCudaFunction<CuDeviceGetCountFunc>(*library, "cuDeviceGetCount");
+    CuDeviceGetFunc cuDeviceGet = getCudaFunction<CuDeviceGetFunc>(*library, "cuDeviceGet");
+    CuDeviceGetNameFunc cuDeviceGetName = getCudaFunction<CuDeviceGetNameFunc>(*library, "cuDeviceGetName");
+    CuDevicePrimaryCtxRetainFunc cuDevicePrimaryCtxRetain = getCudaFunction<CuDevicePrimaryCtxRetainFunc>(*library, "cuDevicePrimaryCtxRetain");
+    cuDevicePrimaryCtxRelease = getCudaFunction<CuDevicePrimaryCtxReleaseFunc>(*library, "cuDevicePrimaryCtxRelease");
+    cuCtxPushCurrent = getCudaFunction<CuCtxPushCurrentFunc>(*library, "cuCtxPushCurrent_v2");
+    cuCtxPopCurrent = getCudaFunction<CuCtxPopCurrentFunc>(*library, "cuCtxPopCurrent_v2");
+    cuStreamCreate = getCudaFunction<CuStreamCreateFunc>(*library, "cuStreamCreate");
+    cuStreamDestroy = getCudaFunction<CuStreamDestroyFunc>(*library, "cuStreamDestroy_v2");
+    cuStreamSynchronize = getCudaFunction<CuStreamSynchronizeFunc>(*library, "cuStreamSynchronize");
+    cuMemAlloc = getCudaFunction<CuMemAllocFunc>(*library, "cuMemAlloc_v2");
+    cuMemFree = getCudaFunction<CuMemFreeFunc>(*library, "cuMemFree_v2");
+    cuMemcpyHtoD = getCudaFunction<CuMemcpyHtoDFunc>(*library, "cuMemcpyHtoD_v2");
+    cuMemcpyDtoH = getCudaFunction<CuMemcpyDtoHFunc>(*library, "cuMemcpyDtoH_v2");
+
+    int nDevices = 0;
+    if ( (cuInit(0) != NATRON_CUDA_SUCCESS) || (cuDeviceGetCount(&nDevices) != NATRON_CUDA_SUCCESS) || (nDevices == 0) ) {
+        return;
+    }
+    if ( cuDeviceGet(&device, 0) != NATRON_CUDA_SUCCESS ) {
+        return;
+    }
+    char name[256];
+    if ( cuDeviceGetName(name, sizeof(name), device) == NATRON_CUDA_SUCCESS ) {
+        name[sizeof(name) - 1] = '\0';
+        deviceName = name;
+    }
+    if ( cuDevicePrimaryCtxRetain(&context, device) != NATRON_CUDA_SUCCESS ) {
+        context = 0;
+
+        return;
+    }
+    valid = true;
+#endif // NATRON_CUDA_DRIVER_LIBRARY
+} // load
+
+CudaDriver::CudaDriver()
+    : _imp( new CudaDriverPrivate() )
+{
+    _imp->load();
+}
+
+CudaDriver::~CudaDriver()
+{
+    if (_imp->context) {
+        _imp->cuDevicePrimaryCtxRelease(_imp->device);
+    }
+}
+
+bool
+CudaDriver::isValid() const
+{
+    return _imp->valid;
+}
+
+const std::string&
+CudaDriver::getDeviceName() const
+{
+    return _imp->deviceName;
+}
+
+bool
+CudaDriver::pushContext() const
+{
+    return _imp->valid && _imp->cuCtxPushCurrent(_imp->context) == NATRON_CUDA_SUCCESS;
+}
+
+void
+CudaDriver::popContext() const
+{
+    if (_imp->valid) {
+        CUcontext context;
+        _imp->cuCtxPopCurrent(&context);
+    }
+}
+
+void*
+CudaDriver::createStream() const
+{
+    CUstream stream = 0;
+    if ( !_imp->valid || (_imp->cuStreamCreate(&stream, 0) != NATRON_CUDA_SUCCESS) ) {
+        return 0;
+    }
+
+    return stream;
+}
+
+void
+CudaDriver::destroyStream(void* stream) const
+{
+    if (_imp->valid && stream) {
+        _imp->cuStreamDestroy(stream);
+    }
+}
+
+bool
+CudaDriver::synchronizeStream(void* stream) const
+{
+    return _imp->valid && _imp->cuStreamSynchronize(stream) == NATRON_CUDA_SUCCESS;
+}
+
+U64
+CudaDriver::allocateBuffer(std::size_t size) const
+{
+    CUdeviceptr buffer = 0;
+    if ( !_imp->valid || (_imp->cuMemAlloc(&buffer, size) != NATRON_CUDA_SUCCESS) ) {
+        return 0;
+    }
+
+    return buffer;
+}
+
+void
+CudaDriver::freeBuffer(U64 buffer) const
+{
+    if (_imp->valid && buffer) {
+        _imp->cuMemFree(buffer);
+    }
+}
+
+bool
+CudaDriver::copyToDevice(U64 dst,
+                         const void* src,
+                         std::size_t size) const
+{
+    return _imp->valid && _imp->cuMemcpyHtoD(dst, src, size) == NATRON_CUDA_SUCCESS;
+}
+
+bool
+CudaDriver::copyFromDevice(void* dst,
+                           U64 src,
+                           std::size_t size) const
+{
+    return _imp->valid && _imp->cuMemcpyDtoH(dst, src, size) == NATRON_CUDA_SUCCESS;
+}
+
+NATRON_NAMESPACE_EXIT;
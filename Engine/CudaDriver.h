@@ -0,0 +1,111 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_CUDADRIVER_H
+#define NATRON_ENGINE_CUDADRIVER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+#include <string>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct CudaDriverPrivate;
+
+/**
+ * @brief The CUDA driver API, loaded at runtime from the library installed with the NVIDIA driver so that Natron
+ * does not depend on the CUDA toolkit. This is used to give OpenFX plug-ins rendering with CUDA their images on
+ * the first CUDA device, in its primary context: that is also the context used by plug-ins written with the
+ * CUDA runtime API.
+ * All functions are MT-safe. The functions using the device must be called between pushContext() and popContext().
+ **/
+class CudaDriver
+{
+public:
+
+    /**
+     * @brief Loads the driver library and retains the primary context of the first device.
+     * isValid() returns false if there is no driver or no CUDA device.
+     **/
+    CudaDriver();
+
+    ~CudaDriver();
+
+    bool isValid() const;
+
+    /**
+     * @brief Returns the name of the device, e.g: "NVIDIA GeForce RTX 3080"
+     **/
+    const std::string& getDeviceName() const;
+
+    /**
+     * @brief Makes the context of the device current on the calling thread, until popContext() is called
+     **/
+    bool pushContext() const;
+
+    void popContext() const;
+
+    /**
+     * @brief Returns a new stream, or NULL if it could not be created
+     **/
+    void* createStream() const;
+
+    void destroyStream(void* stream) const;
+
+    /**
+     * @brief Blocks until the work queued on the stream is done. Returns false if any of that work failed.
+     **/
+    bool synchronizeStream(void* stream) const;
+
+    /**
+     * @brief Allocates size bytes on the device and returns their address, or 0 if the memory could not be allocated
+     **/
+    U64 allocateBuffer(std::size_t size) const;
+
+    void freeBuffer(U64 buffer) const;
+
+    /**
+     * @brief Synchronous copies between the memory of the device and the memory of the host
+     **/
+    bool copyToDevice(U64 dst, const void* src, std::size_t size) const;
+
+    bool copyFromDevice(void* dst, U64 src, std::size_t size) const;
+
+private:
+
+    boost::scoped_ptr<CudaDriverPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_CUDADRIVER_H
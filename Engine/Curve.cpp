@@ -233,6 +233,7 @@ Curve::setPeriodic(bool periodic)
     QMutexLocker k(&_imp->_lock);
     _imp->isPeriodic = periodic;
     _imp->keyFrames.clear();
+    _imp->invalidateEvaluationCache();
 }
 
 bool
@@ -253,6 +254,7 @@ Curve::clearKeyFrames()
     QMutexLocker l(&_imp->_lock);
 
     _imp->keyFrames.clear();
+    _imp->invalidateEvaluationCache();
 }
 
 bool
@@ -270,6 +272,7 @@ Curve::clone(const Curve & other)
     QMutexLocker l(&_imp->_lock);
 
     _imp->keyFrames.clear();
+    _imp->invalidateEvaluationCache();
     std::transform( otherKeys.begin(), otherKeys.end(), std::inserter( _imp->keyFrames, _imp->keyFrames.begin() ), KeyFrameCloner() );
     onCurveChanged();
 }
@@ -280,6 +283,7 @@ Curve::cloneIndexRange(const Curve& other, int firstKeyIdx, int nKeys)
     KeyFrameSet otherKeys = other.getKeyFrames_mt_safe();
     QMutexLocker l(&_imp->_lock);
     _imp->keyFrames.clear();
+    _imp->invalidateEvaluationCache();
     if (firstKeyIdx >= (int)otherKeys.size()) {
         return;
     }
@@ -315,6 +319,7 @@ Curve::cloneAndCheckIfChanged(const Curve& other, double offset, const RangeD* r
     KeyFrameSet tmpSet = _imp->keyFrames;
     KeyFrameSet::iterator oit = tmpSet.begin();
     _imp->keyFrames.clear();
+    _imp->invalidateEvaluationCache();
     for (KeyFrameSet::iterator it = otherKeys.begin(); it != otherKeys.end(); ++it) {
         TimeValue time = it->getTime();
         if ( range && ( (time < range->min) || (time > range->max) ) ) {
@@ -350,6 +355,7 @@ Curve::clone(const Curve & other,
     QMutexLocker l(&_imp->_lock);
 
     _imp->keyFrames.clear();
+    _imp->invalidateEvaluationCache();
     for (KeyFrameSet::iterator it = otherKeys.begin(); it != otherKeys.end(); ++it) {
         TimeValue time = it->getTime();
         if ( copyRange && ( (time < range->min) || (time > range->max) ) ) {
@@ -446,6 +452,7 @@ Curve::setOrAddKeyframe(KeyFrame key)
             ret = eValueChangedReturnCodeKeyframeModified;
         }
         _imp->keyFrames.erase(it.first);
+        _imp->invalidateEvaluationCache();
         it = addKeyFrameNoUpdate(key);
     } else {
         ret = eValueChangedReturnCodeKeyframeAdded;
@@ -462,6 +469,7 @@ std::pair<KeyFrameSet::iterator, bool> Curve::addKeyFrameNoUpdate(const KeyFrame
     // PRIVATE - should not lock
     if (_imp->type != eCurveTypeParametric) { //< if keyframes are clamped to integers
         std::pair<KeyFrameSet::iterator, bool> newKey = _imp->keyFrames.insert(cp);
+        _imp->invalidateEvaluationCache();
         // keyframe at this time exists, erase and insert again
         bool addedKey = true;
         if (!newKey.second) {
@@ -483,6 +491,7 @@ std::pair<KeyFrameSet::iterator, bool> Curve::addKeyFrameNoUpdate(const KeyFrame
             }
         }
         std::pair<KeyFrameSet::iterator, bool> newKey = _imp->keyFrames.insert(cp);
+        _imp->invalidateEvaluationCache();
         newKey.second = addedKey;
 
         return newKey;
@@ -555,6 +564,7 @@ Curve::removeKeyFrame(KeyFrameSet::const_iterator it)
     }
 
     _imp->keyFrames.erase(it);
+    _imp->invalidateEvaluationCache();
 
     if (mustRefreshPrev) {
         refreshDerivatives( eCurveChangedReasonDerivativesChanged, find( prevKey.getTime(), _imp->keyFrames.end()) );
@@ -606,6 +616,7 @@ Curve::removeKeyFramesBeforeTime(TimeValue time,
         newSet.insert(*it);
     }
     _imp->keyFrames = newSet;
+    _imp->invalidateEvaluationCache();
     if ( !_imp->keyFrames.empty() ) {
         refreshDerivatives( Curve::eCurveChangedReasonKeyframeChanged, _imp->keyFrames.begin() );
     }
@@ -629,6 +640,7 @@ Curve::removeKeyFramesAfterTime(TimeValue time,
         newSet.insert(*it);
     }
     _imp->keyFrames = newSet;
+    _imp->invalidateEvaluationCache();
     if ( !_imp->keyFrames.empty() ) {
         KeyFrameSet::iterator last = _imp->keyFrames.end();
         --last;
@@ -809,42 +821,44 @@ Curve::getKeyFrameWithTime(TimeValue time,
     return true;
 }
 
-/// compute interpolation parameters from keyframes and an iterator
-/// to the next keyframe (the first with time > t)
+/// if the curve is periodic, bring back t in the curve keyframes range
 static void
-interParams(const KeyFrameSet &keyFrames,
-            bool isPeriodic,
-            double xMin,
-            double xMax,
-            TimeValue *t,
-            KeyFrameSet::const_iterator itup,
-            TimeValue *tcur,
-            double *vcur,
-            double *vcurDerivRight,
-            KeyframeTypeEnum *interp,
-            TimeValue *tnext,
-            double *vnext,
-            double *vnextDerivLeft,
-            KeyframeTypeEnum *interpNext)
+wrapPeriodicTime(const KeyFrameSet &keyFrames,
+                 double xMin,
+                 double xMax,
+                 TimeValue *t)
 {
-
-    assert(keyFrames.size() >= 1);
-    assert( itup == keyFrames.end() || *t < itup->getTime() );
     double period = xMax - xMin;
-    if (isPeriodic) {
-        // if the curve is periodic, bring back t in the curve keyframes range
-        double minKeyFrameX = keyFrames.begin()->getTime() + xMin;
-        assert(xMin < xMax);
-        if (*t < minKeyFrameX || *t > minKeyFrameX + period) {
-            // This will bring t either in minTime <= t <= maxTime or t in the range minTime - (maxTime - minTime) < t < minTime
-            *t = TimeValue(std::fmod(*t - minKeyFrameX, period ) + minKeyFrameX);
-            if (*t < minKeyFrameX) {
-                *t = TimeValue(*t + period);
-            }
-            assert(*t >= minKeyFrameX && *t <= minKeyFrameX + period);
+    double minKeyFrameX = keyFrames.begin()->getTime() + xMin;
+    assert(xMin < xMax);
+    if (*t < minKeyFrameX || *t > minKeyFrameX + period) {
+        // This will bring t either in minTime <= t <= maxTime or t in the range minTime - (maxTime - minTime) < t < minTime
+        *t = TimeValue(std::fmod(*t - minKeyFrameX, period ) + minKeyFrameX);
+        if (*t < minKeyFrameX) {
+            *t = TimeValue(*t + period);
         }
-        itup = keyFrames.upper_bound(KeyFrame(*t, 0.));
+        assert(*t >= minKeyFrameX && *t <= minKeyFrameX + period);
     }
+}
+
+/// compute interpolation parameters from keyframes and an iterator
+/// to the next keyframe (the first with time > t), once t was wrapped
+/// with wrapPeriodicTime() if the curve is periodic
+static void
+interParamsFromNextKey(const KeyFrameSet &keyFrames,
+                       bool isPeriodic,
+                       double period,
+                       KeyFrameSet::const_iterator itup,
+                       TimeValue *tcur,
+                       double *vcur,
+                       double *vcurDerivRight,
+                       KeyframeTypeEnum *interp,
+                       TimeValue *tnext,
+                       double *vnext,
+                       double *vnextDerivLeft,
+                       KeyframeTypeEnum *interpNext)
+{
+    assert(keyFrames.size() >= 1);
     if ( itup == keyFrames.begin() ) {
         // We are in the case where all keys have a greater time
         // If periodic, we are in between xMin and the first keyframe
@@ -902,7 +916,6 @@ interParams(const KeyFrameSet &keyFrames,
         // get the last keyframe with time <= t
         KeyFrameSet::const_iterator itcur = itup;
         --itcur;
-        assert(itcur->getTime() <= *t);
         *tcur = itcur->getTime();
         *vcur = itcur->getValue();
         *vcurDerivRight = itcur->getRightDerivative();
@@ -912,8 +925,100 @@ interParams(const KeyFrameSet &keyFrames,
         *vnextDerivLeft = itup->getLeftDerivative();
         *interpNext = itup->getInterpolation();
     }
+} // interParamsFromNextKey
+
+/// compute interpolation parameters from keyframes and an iterator
+/// to the next keyframe (the first with time > t)
+static void
+interParams(const KeyFrameSet &keyFrames,
+            bool isPeriodic,
+            double xMin,
+            double xMax,
+            TimeValue *t,
+            KeyFrameSet::const_iterator itup,
+            TimeValue *tcur,
+            double *vcur,
+            double *vcurDerivRight,
+            KeyframeTypeEnum *interp,
+            TimeValue *tnext,
+            double *vnext,
+            double *vnextDerivLeft,
+            KeyframeTypeEnum *interpNext)
+{
+
+    assert(keyFrames.size() >= 1);
+    assert( itup == keyFrames.end() || *t < itup->getTime() );
+    if (isPeriodic) {
+        wrapPeriodicTime(keyFrames, xMin, xMax, t);
+        itup = keyFrames.upper_bound(KeyFrame(*t, 0.));
+    }
+    interParamsFromNextKey(keyFrames, isPeriodic, xMax - xMin, itup, tcur, vcur, vcurDerivRight, interp, tnext, vnext, vnextDerivLeft, interpNext);
+}
+
+void
+CurvePrivate::refreshSegments()
+{
+    assert( !keyFrames.empty() );
+    keyTimes.resize( keyFrames.size() );
+    segments.resize(keyFrames.size() + 1);
+
+    std::size_t i = 0;
+    for (KeyFrameSet::const_iterator it = keyFrames.begin(); it != keyFrames.end(); ++it, ++i) {
+        keyTimes[i] = it->getTime();
+    }
+
+    // Segment i is the one where the first keyframe with a time greater than t is the i-th one
+    KeyFrameSet::const_iterator itup = keyFrames.begin();
+    for (i = 0; i < segments.size(); ++i) {
+        TimeValue tcur, tnext;
+        double vcurDerivRight, vnextDerivLeft, vcur, vnext;
+        KeyframeTypeEnum interp, interpNext;
+        interParamsFromNextKey(keyFrames, isPeriodic, xMax - xMin, itup, &tcur, &vcur, &vcurDerivRight, &interp, &tnext, &vnext, &vnextDerivLeft, &interpNext);
+        Interpolation::getCubicCoefficients(tcur, vcur, vcurDerivRight, vnextDerivLeft, tnext, vnext, interp, interpNext, &segments[i].tcur, &segments[i].tnext, segments[i].c);
+        if ( itup != keyFrames.end() ) {
+            ++itup;
+        }
+    }
+    lastSegmentIndex = 0;
+    segmentsValid = true;
+} // refreshSegments
+
+/// round the interpolated value of a curve to what its type allows
+static double
+roundValueToCurveType(Curve::CurveTypeEnum type,
+                      double v)
+{
+    switch (type) {
+    case Curve::eCurveTypeString:
+    case Curve::eCurveTypeInt:
+
+        return std::floor(v + 0.5);
+    case Curve::eCurveTypeBool:
+
+        return v >= 0.5 ? 1. : 0.;
+    default:
+
+        return v;
+    }
 }
 
+int
+CurvePrivate::findSegment(double t)
+{
+    assert(segmentsValid);
+    const int nKeys = (int)keyTimes.size();
+
+    // Try the segment of the previous evaluation and the next one before doing a binary search
+    for (int i = lastSegmentIndex; i <= std::min(lastSegmentIndex + 1, nKeys); ++i) {
+        if ( ( (i == 0) || (keyTimes[i - 1] <= t) ) && ( (i == nKeys) || (t < keyTimes[i]) ) ) {
+            lastSegmentIndex = i;
+            return i;
+        }
+    }
+    lastSegmentIndex = (int)( std::upper_bound(keyTimes.begin(), keyTimes.end(), t) - keyTimes.begin() );
+    return lastSegmentIndex;
+} // findSegment
+
 double
 Curve::getValueAt(TimeValue t,
                   bool doClamp) const
@@ -945,35 +1050,15 @@ Curve::getValueAt(TimeValue t,
         //    //if there's only 1 keyframe, don't bother interpolating
         //    return (*_imp->keyFrames.begin()).getValue();
         //}
-        TimeValue tcur, tnext;
-        double vcurDerivRight, vnextDerivLeft, vcur, vnext;
-        KeyframeTypeEnum interp, interpNext;
-        KeyFrame k(t, 0.);
-        // find the first keyframe with time greater than t
-        KeyFrameSet::const_iterator itup;
-        itup = _imp->keyFrames.upper_bound(k);
-        interParams(_imp->keyFrames,
-                    _imp->isPeriodic,
-                    _imp->xMin,
-                    _imp->xMax,
-                    &t,
-                    itup,
-                    &tcur,
-                    &vcur,
-                    &vcurDerivRight,
-                    &interp,
-                    &tnext,
-                    &vnext,
-                    &vnextDerivLeft,
-                    &interpNext);
-
-        v = Interpolation::interpolate(tcur, vcur,
-                                       vcurDerivRight,
-                                       vnextDerivLeft,
-                                       tnext, vnext,
-                                       t,
-                                       interp,
-                                       interpNext);
+        if (!_imp->segmentsValid) {
+            _imp->refreshSegments();
+        }
+        if (_imp->isPeriodic) {
+            wrapPeriodicTime(_imp->keyFrames, _imp->xMin, _imp->xMax, &t);
+        }
+        // the segment starting at the last keyframe with time lower or equal to t
+        const CurveSegment& segment = _imp->segments[_imp->findSegment(t)];
+        v = Interpolation::evaluateCubic(segment.c, segment.tcur, segment.tnext, t);
 #ifdef NATRON_CURVE_USE_CACHE
         _imp->resultCache[t] = v;
 #endif
@@ -983,18 +1068,87 @@ Curve::getValueAt(TimeValue t,
         v = clampValueToCurveYRange(v);
     }
 
-    switch (_imp->type) {
-    case Curve::eCurveTypeString:
-    case Curve::eCurveTypeInt:
+    return roundValueToCurveType(_imp->type, v);
+} // getValueAt
 
-        return std::floor(v + 0.5);
-    case Curve::eCurveTypeBool:
+void
+Curve::getValuesAt(const std::vector<TimeValue>& times,
+                   bool doClamp,
+                   std::vector<double>* values) const
+{
+    values->resize( times.size() );
 
-        return v >= 0.5 ? 1. : 0.;
-    default:
+    QMutexLocker l(&_imp->_lock);
 
-        return v;
+    if ( _imp->keyFrames.empty() ) {
+        // A curve with no control points is considered to be 0, see getValueAt()
+        std::fill(values->begin(), values->end(), 0.);
+
+        return;
+    }
+    if (!_imp->segmentsValid) {
+        _imp->refreshSegments();
+    }
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        TimeValue t = times[i];
+        if (_imp->isPeriodic) {
+            wrapPeriodicTime(_imp->keyFrames, _imp->xMin, _imp->xMax, &t);
+        }
+        // findSegment() first tries the segment of the previous time
+        const CurveSegment& segment = _imp->segments[_imp->findSegment(t)];
+        double v = Interpolation::evaluateCubic(segment.c, segment.tcur, segment.tnext, t);
+        if ( doClamp ) {
+            v = clampValueToCurveYRange(v);
+        }
+        (*values)[i] = roundValueToCurveType(_imp->type, v);
+    }
+} // getValuesAt
+
+CurveSnapshotConstPtr
+Curve::createEvaluationSnapshot() const
+{
+    boost::shared_ptr<CurveSnapshot> ret(new CurveSnapshot);
+    {
+        QMutexLocker l(&_imp->_lock);
+        *ret->_imp = *_imp;
+    }
+    if ( !ret->_imp->keyFrames.empty() ) {
+        ret->_imp->refreshSegments();
+    }
+    return ret;
+}
+
+CurveSnapshot::CurveSnapshot()
+    : _imp( new CurvePrivate() )
+{
+}
+
+CurveSnapshot::~CurveSnapshot()
+{
+}
+
+double
+CurveSnapshot::getValueAt(TimeValue t,
+                          bool doClamp) const
+{
+    if ( _imp->keyFrames.empty() ) {
+        return 0.;
+    }
+    assert(_imp->segmentsValid);
+    if (_imp->isPeriodic) {
+        wrapPeriodicTime(_imp->keyFrames, _imp->xMin, _imp->xMax, &t);
     }
+
+    // Do not use findSegment(): it remembers the last segment found and the snapshot must not be modified
+    std::size_t segmentIndex = std::upper_bound(_imp->keyTimes.begin(), _imp->keyTimes.end(), (double)t) - _imp->keyTimes.begin();
+    const CurveSegment& segment = _imp->segments[segmentIndex];
+    double v = Interpolation::evaluateCubic(segment.c, segment.tcur, segment.tnext, t);
+
+    if (doClamp) {
+        v = std::max( _imp->yMin, std::min(_imp->yMax, v) );
+    }
+
+    return roundValueToCurveType(_imp->type, v);
 } // getValueAt
 
 double
@@ -1213,6 +1367,7 @@ Curve::setXRange(double a,
 
     _imp->xMin = a;
     _imp->xMax = b;
+    _imp->invalidateEvaluationCache();
 }
 
 std::pair<double, double> Curve::getXRange() const
@@ -1238,6 +1393,17 @@ Curve::getKeyFrames_mt_safe() const
     return _imp->keyFrames;
 }
 
+KeyFrameSetConstPtr
+Curve::getKeyFramesSnapshot_mt_safe() const
+{
+    QMutexLocker l(&_imp->_lock);
+
+    if (!_imp->keyFramesSnapshot) {
+        _imp->keyFramesSnapshot.reset( new KeyFrameSet(_imp->keyFrames) );
+    }
+    return _imp->keyFramesSnapshot;
+}
+
 KeyFrameSet::iterator
 Curve::setKeyFrameValueAndTimeNoUpdate(double value,
                                        TimeValue time,
@@ -1250,6 +1416,7 @@ Curve::setKeyFrameValueAndTimeNoUpdate(double value,
     newKey.setTime(time);
     newKey.setValue(value);
     _imp->keyFrames.erase(k);
+    _imp->invalidateEvaluationCache();
 
     return addKeyFrameNoUpdate(newKey).first;
 }
@@ -1451,6 +1618,7 @@ Curve::transformKeyframesValueAndTime(const std::list<double>& times,
     
     // Now move finalSet to the member keyframes
     _imp->keyFrames.clear();
+    _imp->invalidateEvaluationCache();
     for (KeyFrameSet::const_iterator it = finalSet.begin();
          it != finalSet.end();
          ++it) {
@@ -1749,6 +1917,7 @@ Curve::refreshDerivatives(Curve::CurveChangedReasonEnum reason,
     newKey.setRightDerivative(vcurDerivRight);
 
     std::pair<KeyFrameSet::iterator, bool> newKeyIt = _imp->keyFrames.insert(newKey);
+    _imp->invalidateEvaluationCache();
 
     // keyframe at this time exists, erase and insert again
     if (!newKeyIt.second) {
@@ -1954,6 +2123,7 @@ Curve::fromSerialization(const SERIALIZATION_NAMESPACE::SerializationObjectBase&
     }
     QMutexLocker l(&_imp->_lock);
     _imp->keyFrames.clear();
+    _imp->invalidateEvaluationCache();
     for (std::list<SERIALIZATION_NAMESPACE::KeyFrameSerialization>::const_iterator it = s->keys.begin(); it != s->keys.end(); ++it) {
         KeyFrame k;
         k.setTime(TimeValue(it->time));
@@ -2065,8 +2235,10 @@ Curve::setKeyframesInternal(const KeyFrameSet& keys, bool refreshDerivatives)
 {
     if (!refreshDerivatives) {
         _imp->keyFrames = keys;
+        _imp->invalidateEvaluationCache();
     } else {
         _imp->keyFrames.clear();
+        _imp->invalidateEvaluationCache();
 
         // Now recompute auto tangents
         for (KeyFrameSet::iterator it = keys.begin(); it != keys.end(); ++it) {
@@ -2117,21 +2289,23 @@ Curve::smooth(const RangeD* range)
     KeyFrameSet newSet;
     if (start != _imp->keyFrames.end()) {
 
+        // The keyframes are inserted in order: pass the end as hint so that each insertion is in constant time
+
         // Add keyframes before range first
         for (KeyFrameSet::iterator it = _imp->keyFrames.begin(); it != start; ++it) {
-            newSet.insert(*it);
+            newSet.insert(newSet.end(), *it);
         }
 
         // Now insert modified keyframes
         for (std::size_t i = 0; i < smoothedCurve.size(); ++i, ++start) {
             KeyFrame k(*start);
             k.setValue(smoothedCurve[i]);
-            newSet.insert(k);
+            newSet.insert(newSet.end(), k);
         }
 
         // Now insert original keys after range
         for (KeyFrameSet::iterator it = start; it != _imp->keyFrames.end(); ++it) {
-            newSet.insert(*it);
+            newSet.insert(newSet.end(), *it);
         }
 
         setKeyframesInternal(newSet, true);
@@ -131,6 +131,7 @@ struct KeyFrame_compare_time
 
 
 typedef std::set<KeyFrame, KeyFrame_compare_time> KeyFrameSet;
+typedef boost::shared_ptr<const KeyFrameSet> KeyFrameSetConstPtr;
 
 
 struct CurvePrivate;
@@ -289,12 +290,32 @@ public:
      */
     double getValueAt(TimeValue t, bool clamp = true) const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Same as getValueAt() for each time in times: values[i] is the value at times[i].
+     * The curve is locked once for all times and when the times are sorted by increasing order,
+     * each keyframe segment is looked up only once.
+     **/
+    void getValuesAt(const std::vector<TimeValue>& times, bool clamp, std::vector<double>* values) const;
+
     double getDerivativeAt(TimeValue t) const WARN_UNUSED_RETURN;
 
     double getIntegrateFromTo(TimeValue t1, TimeValue t2) const WARN_UNUSED_RETURN;
 
     KeyFrameSet getKeyFrames_mt_safe() const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Same as getKeyFrames_mt_safe() except that the returned set is shared by all callers
+     * instead of being copied for each of them: the keyframes are only copied again once the curve is modified.
+     **/
+    KeyFrameSetConstPtr getKeyFramesSnapshot_mt_safe() const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Returns a read-only copy of the curve that evaluates to the same values as getValueAt().
+     * Unlike the curve, the copy may be evaluated concurrently by several threads without taking any lock.
+     * It is not affected by the changes made to the curve after this call.
+     **/
+    CurveSnapshotConstPtr createEvaluationSnapshot() const WARN_UNUSED_RETURN;
+
     void clearKeyFrames();
 
     /**
@@ -615,6 +636,30 @@ private:
     boost::scoped_ptr<CurvePrivate> _imp;
 };
 
+/**
+ * @brief An immutable copy of a curve made by Curve::createEvaluationSnapshot().
+ * Everything needed by getValueAt() is computed when it is created so that it is MT-safe without locking.
+ **/
+class CurveSnapshot
+{
+public:
+
+    ~CurveSnapshot();
+
+    /**
+     * @brief Same as Curve::getValueAt()
+     **/
+    double getValueAt(TimeValue t, bool clamp = true) const WARN_UNUSED_RETURN;
+
+private:
+
+    friend class Curve;
+
+    CurveSnapshot();
+
+    boost::scoped_ptr<CurvePrivate> _imp;
+};
+
 NATRON_NAMESPACE_EXIT;
 
 #endif // Engine_Curve_h
@@ -31,6 +31,8 @@
 #include <boost/shared_ptr.hpp>
 #endif
 
+#include <vector>
+
 #include <QtCore/QMutex>
 
 #include "Engine/Variant.h"
@@ -45,6 +47,16 @@ NATRON_NAMESPACE_ENTER;
 
 //#define NATRON_CURVE_USE_CACHE
 
+/**
+ * @brief The interpolation of a curve between two consecutive keyframes, as a cubic polynomial.
+ * See Interpolation::getCubicCoefficients()
+ **/
+struct CurveSegment
+{
+    double tcur, tnext;
+    double c[4];
+};
+
 
 struct CurvePrivate
 {
@@ -54,6 +66,24 @@ struct CurvePrivate
     std::map<double, double> resultCache; //< a cache for interpolations
 #endif
 
+    // The following are a cache of keyFrames for getValueAt(), which is called very often: the keyframes set
+    // does not have to be walked and the interpolation parameters do not have to be computed for each evaluation.
+    // They are re-created from keyFrames when needed once invalidateEvaluationCache() has been called.
+
+    // The times of keyFrames, in a contiguous array
+    std::vector<double> keyTimes;
+
+    // segments[i] is used for times t such that keyTimes[i-1] <= t < keyTimes[i]: segments[0] is before the first
+    // keyframe and segments[keyTimes.size()] after the last one.
+    std::vector<CurveSegment> segments;
+    bool segmentsValid;
+
+    // The segment used by the last call to getValueAt(): consecutive evaluations are most of the time in the same segment or the next one
+    int lastSegmentIndex;
+
+    // A read-only copy of keyFrames shared by all the callers of getKeyFramesSnapshot_mt_safe(), null if it must be re-created
+    KeyFrameSetConstPtr keyFramesSnapshot;
+
     Curve::CurveTypeEnum type;
     double xMin, xMax;
     double yMin, yMax;
@@ -67,6 +97,11 @@ struct CurvePrivate
 #ifdef NATRON_CURVE_USE_CACHE
     , resultCache()
 #endif
+    , keyTimes()
+    , segments()
+    , segmentsValid(false)
+    , lastSegmentIndex(0)
+    , keyFramesSnapshot()
     , type(Curve::eCurveTypeDouble)
     , xMin(-std::numeric_limits<double>::infinity())
     , xMax(std::numeric_limits<double>::infinity())
@@ -89,6 +124,7 @@ struct CurvePrivate
     void operator=(const CurvePrivate & other)
     {
         keyFrames = other.keyFrames;
+        invalidateEvaluationCache();
         type = other.type;
         xMin = other.xMin;
         xMax = other.xMax;
@@ -100,7 +136,25 @@ struct CurvePrivate
         canMoveY = other.canMoveY;
     }
 
-    
+    /**
+     * @brief Must be called whenever keyFrames, isPeriodic, xMin or xMax are modified. The lock must be held.
+     **/
+    void invalidateEvaluationCache()
+    {
+        segmentsValid = false;
+        lastSegmentIndex = 0;
+        keyFramesSnapshot.reset();
+    }
+
+    /**
+     * @brief Re-creates keyTimes and segments from keyFrames. The lock must be held.
+     **/
+    void refreshSegments();
+
+    /**
+     * @brief Returns the index in segments of the segment to use at time t. The lock must be held and segments must be valid.
+     **/
+    int findSegment(double t);
 };
 
 NATRON_NAMESPACE_EXIT;
@@ -24,16 +24,32 @@
 
 #include "DiskCacheNode.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <sstream>
 #include <stdexcept>
+#include <vector>
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryFile>
 
 #include "Engine/Node.h"
 #include "Engine/Image.h"
 #include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/Cache.h"
+#include "Engine/Hash64.h"
+#include "Engine/KnobFile.h"
 #include "Engine/KnobTypes.h"
+#include "Engine/MemoryFile.h"
 #include "Engine/Project.h"
 #include "Engine/RenderQueue.h"
+#include "Engine/StandardPaths.h"
 #include "Engine/TimeLine.h"
+#include "Engine/TreeRender.h"
 #include "Engine/ViewIdx.h"
 
 #define kDiskCacheNodeFirstFrame "firstFrame"
@@ -48,6 +64,22 @@
 #define kDiskCacheNodeFrameRangeLabel "Frame Range"
 #define kDiskCacheNodeFrameRangeHint ""
 
+#define kDiskCacheNodeCheckpoint "checkpoint"
+#define kDiskCacheNodeCheckpointLabel "Checkpoint Files"
+#define kDiskCacheNodeCheckpointHint "When checked, the images rendered at zoom-level 100% by Pre-cache or during playback are also written to one file per frame " \
+    "in the Checkpoint Directory. As long as the input tree renders the same image, the file is read back instead of rendering the input, " \
+    "even after the cache was cleared, after a restart or in another process rendering the same project."
+
+#define kDiskCacheNodeCheckpointDirectory "checkpointDirectory"
+#define kDiskCacheNodeCheckpointDirectoryLabel "Checkpoint Directory (empty = default)"
+#define kDiskCacheNodeCheckpointDirectoryHint "The directory where the checkpoint files are written. If empty, they are written in the DiskCacheCheckpoints directory of the cache location."
+
+#define NATRON_DISK_CACHE_CHECKPOINT_FILE_MAGIC 0x4e434b50 // "NCKP"
+#define NATRON_DISK_CACHE_CHECKPOINT_FILE_VERSION 1
+
+// The directory, in the cache location, where the checkpoint files are written by default
+#define NATRON_DISK_CACHE_CHECKPOINT_DIRECTORY_NAME "DiskCacheCheckpoints"
+
 NATRON_NAMESPACE_ENTER;
 
 struct DiskCacheNodePrivate
@@ -56,12 +88,248 @@ struct DiskCacheNodePrivate
     KnobIntWPtr firstFrame;
     KnobIntWPtr lastFrame;
     KnobButtonWPtr preRender;
+    KnobBoolWPtr checkpoint;
+    KnobPathWPtr checkpointDirectory;
 
     DiskCacheNodePrivate()
     {
     }
 };
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/*
+ * A checkpoint file holds one plane of the image at mipmap level 0 with the same layout as the tiles of the cache:
+ * each channel is split in tiles of tileSizeX * tileSizeY floats aligned on multiples of the tile size.
+ * The tiles of the first channel come first, row by row, then those of the next channel.
+ * Pixels of the tiles outside of the image bounds are 0.
+ */
+struct CheckpointFileHeader
+{
+    unsigned int magic;
+    unsigned int version;
+
+    // The hash of the input, at the time and view of the image
+    U64 hash;
+
+    // The bounds of the image, in pixel coordinates
+    int x1, y1, x2, y2;
+    int nComps;
+    int tileSizeX, tileSizeY;
+};
+
+int
+roundDownToTile(int v,
+                int tileSize)
+{
+    return (int)std::floor( (double)v / tileSize ) * tileSize;
+}
+
+int
+roundUpToTile(int v,
+              int tileSize)
+{
+    return (int)std::ceil( (double)v / tileSize ) * tileSize;
+}
+
+/**
+ * @brief Returns the offset in the file of the given pixel of the given channel.
+ **/
+std::size_t
+getCheckpointPixelOffset(const CheckpointFileHeader& header,
+                         int c,
+                         int x,
+                         int y)
+{
+    int gridX1 = roundDownToTile(header.x1, header.tileSizeX);
+    int gridY1 = roundDownToTile(header.y1, header.tileSizeY);
+    std::size_t nTilesX = ( roundUpToTile(header.x2, header.tileSizeX) - gridX1 ) / header.tileSizeX;
+    std::size_t nTilesY = ( roundUpToTile(header.y2, header.tileSizeY) - gridY1 ) / header.tileSizeY;
+    std::size_t tileX = (x - gridX1) / header.tileSizeX;
+    std::size_t tileY = (y - gridY1) / header.tileSizeY;
+    std::size_t tileIndex = (c * nTilesY + tileY) * nTilesX + tileX;
+    std::size_t pixelIndex = (std::size_t)(y - gridY1 - tileY * header.tileSizeY) * header.tileSizeX + (x - gridX1 - tileX * header.tileSizeX);
+
+    return sizeof(CheckpointFileHeader) + ( tileIndex * header.tileSizeX * header.tileSizeY + pixelIndex ) * sizeof(float);
+}
+
+std::size_t
+getCheckpointFileSize(const CheckpointFileHeader& header)
+{
+    std::size_t nTilesX = ( roundUpToTile(header.x2, header.tileSizeX) - roundDownToTile(header.x1, header.tileSizeX) ) / header.tileSizeX;
+    std::size_t nTilesY = ( roundUpToTile(header.y2, header.tileSizeY) - roundDownToTile(header.y1, header.tileSizeY) ) / header.tileSizeY;
+
+    return sizeof(CheckpointFileHeader) + header.nComps * nTilesX * nTilesY * header.tileSizeX * header.tileSizeY * sizeof(float);
+}
+
+/**
+ * @brief Copies the roi from the mapped checkpoint file to the image. The image must be at mipmap level 0.
+ **/
+void
+readCheckpointPixels(const char* data,
+                     const CheckpointFileHeader& header,
+                     const RectI& roi,
+                     const ImagePtr& image)
+{
+    Image::CPUData cpuData;
+    image->getCPUData(&cpuData);
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        void* dstPtrs[4];
+        int dstPixelStride;
+        Image::getChannelPointers( (const void**)cpuData.ptrs, roi.x1, y, cpuData.bounds, cpuData.nComps, cpuData.bitDepth, dstPtrs, &dstPixelStride );
+        for (int c = 0; c < header.nComps; ++c) {
+            float* dstPix = (float*)dstPtrs[c];
+            int x = roi.x1;
+            while (x < roi.x2) {
+                // Pixels are contiguous up to the end of the tile
+                int segmentEnd = std::min( roi.x2, roundDownToTile(x, header.tileSizeX) + header.tileSizeX );
+                const float* srcPix = reinterpret_cast<const float*>( data + getCheckpointPixelOffset(header, c, x, y) );
+                for (; x < segmentEnd; ++x, ++srcPix, dstPix += dstPixelStride) {
+                    *dstPix = *srcPix;
+                }
+            }
+        }
+    }
+} // readCheckpointPixels
+
+/**
+ * @brief Fills the roi of the image at the given mipmap level from the checkpoint file.
+ * Returns false if the file does not exist, does not correspond to the hash or does not contain the roi.
+ **/
+bool
+readCheckpointFile(const std::string& filePath,
+                   U64 hash,
+                   const RectI& roi,
+                   unsigned int mipMapLevel,
+                   const ImagePtr& image)
+{
+    if ( !QFile::exists( QString::fromUtf8( filePath.c_str() ) ) ) {
+        return false;
+    }
+    MemoryFile file;
+    try {
+        file.open(filePath, MemoryFile::eFileOpenModeOpen);
+    } catch (const std::exception& /*e*/) {
+        return false;
+    }
+    const char* data = file.getData();
+    if ( !data || (file.size() < sizeof(CheckpointFileHeader)) ) {
+        return false;
+    }
+    CheckpointFileHeader header;
+    std::memcpy( &header, data, sizeof(header) );
+    if ( (header.magic != NATRON_DISK_CACHE_CHECKPOINT_FILE_MAGIC) || (header.version != NATRON_DISK_CACHE_CHECKPOINT_FILE_VERSION) || (header.hash != hash) ||
+         (header.nComps != (int)image->getComponentsCount()) || (header.tileSizeX <= 0) || (header.tileSizeY <= 0) || (file.size() != getCheckpointFileSize(header)) ) {
+        return false;
+    }
+
+    RectI fileBounds(header.x1, header.y1, header.x2, header.y2);
+    if (mipMapLevel == 0) {
+        if ( !fileBounds.contains(roi) ) {
+            return false;
+        }
+        readCheckpointPixels(data, header, roi, image);
+
+        return true;
+    }
+
+    // The file holds the full resolution image: downscale the corresponding area
+    RectI fullResRoI;
+    if ( !roi.upscalePowerOfTwo(mipMapLevel).intersect(fileBounds, &fullResRoI) ) {
+        return false;
+    }
+    Image::InitStorageArgs initArgs;
+    initArgs.bounds = fullResRoI;
+    initArgs.plane = image->getLayer();
+    initArgs.bitdepth = eImageBitDepthFloat;
+    ImagePtr fullResImage = Image::create(initArgs);
+    if (!fullResImage) {
+        return false;
+    }
+    readCheckpointPixels(data, header, fullResRoI, fullResImage);
+    ImagePtr downscaledImage = fullResImage->downscaleMipMap(fullResRoI, mipMapLevel);
+    if (!downscaledImage) {
+        return false;
+    }
+    Image::CopyPixelsArgs cpyArgs;
+    cpyArgs.roi = roi;
+
+    return !isFailureRetCode( image->copyPixels(*downscaledImage, cpyArgs) );
+} // readCheckpointFile
+
+/**
+ * @brief Writes the roi of the image, which must be at mipmap level 0, to the checkpoint file.
+ **/
+void
+writeCheckpointFile(const std::string& filePath,
+                    U64 hash,
+                    const RectI& roi,
+                    const ImagePtr& image)
+{
+    CheckpointFileHeader header;
+    std::memset( &header, 0, sizeof(header) );
+    header.magic = NATRON_DISK_CACHE_CHECKPOINT_FILE_MAGIC;
+    header.version = NATRON_DISK_CACHE_CHECKPOINT_FILE_VERSION;
+    header.hash = hash;
+    header.x1 = roi.x1;
+    header.y1 = roi.y1;
+    header.x2 = roi.x2;
+    header.y2 = roi.y2;
+    header.nComps = (int)image->getComponentsCount();
+    appPTR->getTileCache()->getTileSizePx(eImageBitDepthFloat, &header.tileSizeX, &header.tileSizeY);
+
+    // Write the file under a temporary name and rename it so that other processes never map a partial file
+    QString qFilePath = QString::fromUtf8( filePath.c_str() );
+    QTemporaryFile tmpf( qFilePath + QString::fromUtf8("_XXXXXX.tmp") );
+    if ( !tmpf.open() ) {
+        return;
+    }
+    if ( tmpf.write( (const char*)&header, sizeof(header) ) != (qint64)sizeof(header) ) {
+        return;
+    }
+
+    Image::CPUData cpuData;
+    image->getCPUData(&cpuData);
+    std::vector<float> tile(header.tileSizeX * header.tileSizeY);
+    const qint64 tileBytes = (qint64)( tile.size() * sizeof(float) );
+    int gridX2 = roundUpToTile(roi.x2, header.tileSizeX);
+    int gridY2 = roundUpToTile(roi.y2, header.tileSizeY);
+    for (int c = 0; c < header.nComps; ++c) {
+        for (int tileY = roundDownToTile(roi.y1, header.tileSizeY); tileY < gridY2; tileY += header.tileSizeY) {
+            for (int tileX = roundDownToTile(roi.x1, header.tileSizeX); tileX < gridX2; tileX += header.tileSizeX) {
+                std::fill( tile.begin(), tile.end(), 0.f );
+                RectI tileBounds(tileX, tileY, tileX + header.tileSizeX, tileY + header.tileSizeY);
+                RectI area;
+                if ( tileBounds.intersect(roi, &area) ) {
+                    for (int y = area.y1; y < area.y2; ++y) {
+                        void* srcPtrs[4];
+                        int srcPixelStride;
+                        Image::getChannelPointers( (const void**)cpuData.ptrs, area.x1, y, cpuData.bounds, cpuData.nComps, cpuData.bitDepth, srcPtrs, &srcPixelStride );
+                        const float* srcPix = (const float*)srcPtrs[c];
+                        float* dstPix = &tile[(y - tileY) * header.tileSizeX + (area.x1 - tileX)];
+                        for (int x = area.x1; x < area.x2; ++x, ++dstPix, srcPix += srcPixelStride) {
+                            *dstPix = *srcPix;
+                        }
+                    }
+                }
+                if ( tmpf.write( (const char*)&tile[0], tileBytes ) != tileBytes ) {
+                    return;
+                }
+            }
+        }
+    }
+    tmpf.close();
+    tmpf.setAutoRemove(false);
+    QString tmpFileName = tmpf.fileName();
+    QFile::remove(qFilePath);
+    if ( !QFile::rename(tmpFileName, qFilePath) ) {
+        // Another process wrote the same file in the meantime
+        QFile::remove(tmpFileName);
+    }
+} // writeCheckpointFile
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 PluginPtr
 DiskCacheNode::createPlugin()
 {
@@ -77,6 +345,8 @@ DiskCacheNode::createPlugin()
                        "for the viewer cache but you can set its location and size in the preferences. A solid state drive disk is recommended for efficiency of this node. "
                        "By default all images that pass into the node are cached but they depend on the zoom-level of the viewer. For convenience you can cache "
                        "a specific frame range at scale 100% much like a writer node would do.\n"
+                       "With Checkpoint Files checked, the images cached at scale 100% are also written to one file per frame which is reused "
+                       "as long as the input tree renders the same image, even after the cache was cleared or %1 was restarted.\n"
                        "WARNING: The DiskCache node must be part of the tree when you want to read cached data from it.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) );
     ret->setProperty<std::string>(kNatronPluginPropDescription, desc.toStdString());
     ret->setProperty<int>(kNatronPluginPropRenderSafety, (int)eRenderSafetyFullySafe);
@@ -174,6 +444,21 @@ DiskCacheNode::initializeKnobs()
     preRender->setHintToolTip( tr("Cache the frame range specified by rendering images at zoom-level 100% only.") );
     page->addKnob(preRender);
     _imp->preRender = preRender;
+
+    KnobBoolPtr checkpoint = createKnob<KnobBool>(kDiskCacheNodeCheckpoint);
+    checkpoint->setLabel(tr(kDiskCacheNodeCheckpointLabel));
+    checkpoint->setHintToolTip(tr(kDiskCacheNodeCheckpointHint));
+    checkpoint->setAnimationEnabled(false);
+    checkpoint->setDefaultValue(false);
+    page->addKnob(checkpoint);
+    _imp->checkpoint = checkpoint;
+
+    KnobPathPtr checkpointDirectory = createKnob<KnobPath>(kDiskCacheNodeCheckpointDirectory);
+    checkpointDirectory->setLabel(tr(kDiskCacheNodeCheckpointDirectoryLabel));
+    checkpointDirectory->setHintToolTip(tr(kDiskCacheNodeCheckpointDirectoryHint));
+    checkpointDirectory->setMultiPath(false);
+    page->addKnob(checkpointDirectory);
+    _imp->checkpointDirectory = checkpointDirectory;
 }
 
 void
@@ -183,6 +468,8 @@ DiskCacheNode::fetchRenderCloneKnobs()
     _imp->frameRange = toKnobChoice(getKnobByName(kDiskCacheNodeFrameRange));
     _imp->firstFrame = toKnobInt(getKnobByName(kDiskCacheNodeFirstFrame));
     _imp->lastFrame = toKnobInt(getKnobByName(kDiskCacheNodeLastFrame));
+    _imp->checkpoint = toKnobBool(getKnobByName(kDiskCacheNodeCheckpoint));
+    _imp->checkpointDirectory = toKnobPath(getKnobByName(kDiskCacheNodeCheckpointDirectory));
 }
 
 bool
@@ -265,13 +552,94 @@ DiskCacheNode::getFrameRange(double *first,
     return eActionStatusOK;
 }
 
+std::string
+DiskCacheNode::getCheckpointFilePath(TimeValue time,
+                                     ViewIdx view,
+                                     const ImagePlaneDesc& plane,
+                                     U64* inputHash) const
+{
+    if ( !_imp->checkpoint.lock()->getValue() ) {
+        return std::string();
+    }
+    EffectInstancePtr input = getInputRenderEffect(0, time, view);
+    if (!input) {
+        return std::string();
+    }
+
+    // The file is identified by the hash of the input: it is invalidated by any change upstream
+    ComputeHashArgs hashArgs;
+    hashArgs.time = time;
+    hashArgs.view = view;
+    hashArgs.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+    U64 hash = input->computeHash(hashArgs);
+    if (inputHash) {
+        *inputHash = hash;
+    }
+
+    QString dirPath = QString::fromUtf8( _imp->checkpointDirectory.lock()->getValue().c_str() );
+    if ( dirPath.isEmpty() ) {
+        dirPath = StandardPaths::writableLocation(StandardPaths::eStandardLocationCache) + QLatin1Char('/') + QString::fromUtf8(NATRON_DISK_CACHE_CHECKPOINT_DIRECTORY_NAME);
+    }
+    if ( !QDir().mkpath(dirPath) ) {
+        return std::string();
+    }
+
+    // The plane name may contain characters that are not valid in a file name
+    Hash64 planeHash;
+    Hash64::appendString(plane.getPlaneID(), &planeHash);
+    planeHash.append( plane.getNumComponents() );
+    planeHash.computeHash();
+
+    std::stringstream ss;
+    ss << dirPath.toStdString() << '/' << std::hex << hash << '_' << planeHash.value() << ".ntc";
+
+    return ss.str();
+} // getCheckpointFilePath
+
+ActionRetCodeEnum
+DiskCacheNode::getRegionsOfInterest(TimeValue time,
+                                    const RenderScale & scale,
+                                    const RectD & renderWindow,
+                                    ViewIdx view,
+                                    RoIMap* ret)
+{
+    // When the checkpoint file exists, the input is not rendered: render() reads the file instead.
+    // If the file turns out to be invalid, render() fetches the input image itself.
+    ImagePlaneDesc plane, pairedPlane;
+    getMetadataComponents(-1, &plane, &pairedPlane);
+    std::string filePath = getCheckpointFilePath(time, view, plane, 0);
+    if ( !filePath.empty() && QFile::exists( QString::fromUtf8( filePath.c_str() ) ) ) {
+        ret->insert( std::make_pair( 0, RectD() ) );
+
+        return eActionStatusOK;
+    }
+
+    return EffectInstance::getRegionsOfInterest(time, scale, renderWindow, view, ret);
+} // getRegionsOfInterest
+
 ActionRetCodeEnum
 DiskCacheNode::render(const RenderActionArgs& args)
 {
+    // Checkpoint files are in full resolution pixel coordinates
+    const bool useCheckpoint = (args.proxyScale.x == 1.) && (args.proxyScale.y == 1.);
+
+    // Only write checkpoints from renders which are not interactive, e.g: Pre-cache
+    TreeRenderPtr currentRender = getCurrentRender();
+    const bool writeCheckpoint = useCheckpoint && (args.mipMapLevel == 0) && currentRender && currentRender->isPlayback() && !currentRender->isDraftRender();
+
     // fetch source images and copy them
 
     for (std::list<std::pair<ImagePlaneDesc, ImagePtr > >::const_iterator it = args.outputPlanes.begin(); it != args.outputPlanes.end(); ++it) {
 
+        U64 inputHash = 0;
+        std::string checkpointFilePath;
+        if (useCheckpoint) {
+            checkpointFilePath = getCheckpointFilePath(args.time, args.view, it->first, &inputHash);
+        }
+        if ( !checkpointFilePath.empty() && readCheckpointFile(checkpointFilePath, inputHash, args.roi, args.mipMapLevel, it->second) ) {
+            continue;
+        }
+
         GetImageInArgs inArgs(&args.mipMapLevel, &args.proxyScale, &args.roi, &args.backendType);
         inArgs.inputNb = 0;
         inArgs.plane = &it->first;
@@ -287,6 +655,10 @@ DiskCacheNode::render(const RenderActionArgs& args)
             return stat;
         }
 
+        if ( writeCheckpoint && !checkpointFilePath.empty() && !isRenderAborted() ) {
+            writeCheckpointFile(checkpointFilePath, inputHash, args.roi, it->second);
+        }
+
     }
     return eActionStatusOK;
 
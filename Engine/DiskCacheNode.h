@@ -117,6 +117,19 @@ private:
 
     virtual ActionRetCodeEnum render(const RenderActionArgs& args) OVERRIDE FINAL;
 
+    virtual ActionRetCodeEnum getRegionsOfInterest(TimeValue time,
+                                                   const RenderScale & scale,
+                                                   const RectD & renderWindow,
+                                                   ViewIdx view,
+                                                   RoIMap* ret) OVERRIDE FINAL WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Returns the path of the checkpoint file of the given plane of the input image at the given time and view,
+     * or an empty string if checkpoint files are disabled or the input is disconnected.
+     * If inputHash is not NULL, it is set to the hash of the input.
+     **/
+    std::string getCheckpointFilePath(TimeValue time, ViewIdx view, const ImagePlaneDesc& plane, U64* inputHash) const;
+
     virtual bool knobChanged(const KnobIPtr&,
                              ValueChangedReasonEnum reason,
                              ViewSetSpec view,
@@ -26,8 +26,36 @@
 
 
 #include <list>
+#include <cmath>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_array.hpp>
+#endif
+
+#include <QtCore/QAtomicPointer>
+
 #include "Engine/EffectInstance.h"
 #include "Engine/Transform.h"
+
+// Spacing between the points of the grid on which a stack containing distortion functions is evaluated.
+// Positions inside a grid cell are bilinearly interpolated from its 4 corners instead of calling the distortion functions.
+#define NATRON_DISTORTION_GRID_SPACING 8
+
+// Number of grid cells on each side of a tile of the grid. The tiles are evaluated when first needed.
+#define NATRON_DISTORTION_GRID_TILE_SIZE 16
+
+// Number of tiles that may be evaluated for a stack: positions in other tiles call the distortion functions.
+// Must be a power of 2.
+#define NATRON_DISTORTION_GRID_N_TILES 1024
+
+// Maximum difference allowed between the interpolated and the exact position at the center of the cells of a tile.
+// If it is exceeded somewhere in the tile, the positions in the tile call the distortion functions.
+#define NATRON_DISTORTION_GRID_MAX_ERROR 0.01
+
+// Positions further away from the origin than this are not interpolated
+#define NATRON_DISTORTION_GRID_MAX_COORDINATE 1e7
+
 NATRON_NAMESPACE_ENTER;
 
 DistortionFunction2D::DistortionFunction2D()
@@ -51,9 +79,63 @@ DistortionFunction2D::~DistortionFunction2D()
 }
 
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// A tile of the grid on which the stack is evaluated
+struct DistortionGridTile
+{
+    // Index of the tile
+    int tx, ty;
+
+    // If true, the interpolation error is too high and the positions in the tile are not interpolated
+    bool exact;
+
+    // The undistorted positions of the (NATRON_DISTORTION_GRID_TILE_SIZE + 1)^2 grid points of the tile, rows first
+    std::vector<double> xs, ys;
+};
+
+DistortionGridTile*
+loadTile(const QAtomicPointer<DistortionGridTile>& slot)
+{
+#if QT_VERSION < 0x050000
+    return slot;
+#else
+    return slot.loadAcquire();
+#endif
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 struct Distortion2DStackPrivate
 {
     std::list<DistortionFunction2DPtr> stack;
+
+    // The tiles of the grid evaluated so far, in a hash table indexed by the tile index.
+    // Only allocated if the stack contains a distortion function: matrices alone are cheaper to apply than to interpolate.
+    // The tiles are only added once the stack is complete, from the render threads of the effect applying the stack:
+    // a slot is set once with a compare-and-swap and never changes until the stack is destroyed.
+    boost::scoped_array<QAtomicPointer<DistortionGridTile> > gridTiles;
+
+    Distortion2DStackPrivate()
+    : stack()
+    , gridTiles()
+    {
+    }
+
+    ~Distortion2DStackPrivate()
+    {
+        if (gridTiles) {
+            for (int i = 0; i < NATRON_DISTORTION_GRID_N_TILES; ++i) {
+                delete loadTile(gridTiles[i]);
+            }
+        }
+    }
+
+    void applyStack(double distortedX, double distortedY, double* undistortedX, double* undistortedY) const;
+
+    DistortionGridTile* createTile(int tx, int ty) const;
+
+    const DistortionGridTile* getTile(int tx, int ty);
 };
 
 
@@ -73,6 +155,9 @@ Distortion2DStack::pushDistortionFunction(const DistortionFunction2DPtr& distort
     // The distortion is either a function or a transformation matrix.
     assert(!distortion->transformMatrix && distortion->func);
     _imp->stack.push_back(distortion);
+    if (!_imp->gridTiles) {
+        _imp->gridTiles.reset(new QAtomicPointer<DistortionGridTile>[NATRON_DISTORTION_GRID_N_TILES]);
+    }
 }
 
 void
@@ -113,10 +198,10 @@ Distortion2DStack::getStack() const
 
 
 void
-Distortion2DStack::applyDistortionStack(double distortedX, double distortedY, const Distortion2DStack& stack, double* undistortedX, double* undistortedY)
+Distortion2DStackPrivate::applyStack(double distortedX, double distortedY, double* undistortedX, double* undistortedY) const
 {
     Transform::Point3D p(distortedX, distortedY, 1.);
-    for (std::list<DistortionFunction2DPtr>::const_iterator it = stack._imp->stack.begin(); it != stack._imp->stack.end(); ++it) {
+    for (std::list<DistortionFunction2DPtr>::const_iterator it = stack.begin(); it != stack.end(); ++it) {
         // If there's a matrix, apply, otherwise call the distortion function
         if ((*it)->transformMatrix) {
             p = Transform::matApply(*(*it)->transformMatrix, p);
@@ -130,4 +215,111 @@ Distortion2DStack::applyDistortionStack(double distortedX, double distortedY, co
     *undistortedY = p.y;
 }
 
+DistortionGridTile*
+Distortion2DStackPrivate::createTile(int tx, int ty) const
+{
+    const int nPoints = NATRON_DISTORTION_GRID_TILE_SIZE + 1;
+    DistortionGridTile* tile = new DistortionGridTile;
+    tile->tx = tx;
+    tile->ty = ty;
+    tile->exact = false;
+    tile->xs.resize(nPoints * nPoints);
+    tile->ys.resize(nPoints * nPoints);
+
+    const double x0 = (double)tx * NATRON_DISTORTION_GRID_TILE_SIZE * NATRON_DISTORTION_GRID_SPACING;
+    const double y0 = (double)ty * NATRON_DISTORTION_GRID_TILE_SIZE * NATRON_DISTORTION_GRID_SPACING;
+    for (int j = 0; j < nPoints; ++j) {
+        for (int i = 0; i < nPoints; ++i) {
+            int index = j * nPoints + i;
+            applyStack(x0 + i * NATRON_DISTORTION_GRID_SPACING, y0 + j * NATRON_DISTORTION_GRID_SPACING, &tile->xs[index], &tile->ys[index]);
+        }
+    }
+
+    // The interpolation error is the highest near the center of the cells: check it there
+    for (int j = 0; j < NATRON_DISTORTION_GRID_TILE_SIZE && !tile->exact; ++j) {
+        for (int i = 0; i < NATRON_DISTORTION_GRID_TILE_SIZE; ++i) {
+            int index = j * nPoints + i;
+            double interpX = (tile->xs[index] + tile->xs[index + 1] + tile->xs[index + nPoints] + tile->xs[index + nPoints + 1]) / 4.;
+            double interpY = (tile->ys[index] + tile->ys[index + 1] + tile->ys[index + nPoints] + tile->ys[index + nPoints + 1]) / 4.;
+            double exactX, exactY;
+            applyStack(x0 + (i + 0.5) * NATRON_DISTORTION_GRID_SPACING, y0 + (j + 0.5) * NATRON_DISTORTION_GRID_SPACING, &exactX, &exactY);
+            // Written so that NaNs returned by the distortion functions also disable the interpolation
+            if ( !(std::abs(interpX - exactX) <= NATRON_DISTORTION_GRID_MAX_ERROR) || !(std::abs(interpY - exactY) <= NATRON_DISTORTION_GRID_MAX_ERROR) ) {
+                tile->exact = true;
+                break;
+            }
+        }
+    }
+    if (tile->exact) {
+        std::vector<double>().swap(tile->xs);
+        std::vector<double>().swap(tile->ys);
+    }
+
+    return tile;
+} // createTile
+
+const DistortionGridTile*
+Distortion2DStackPrivate::getTile(int tx, int ty)
+{
+    unsigned int hash = ( (unsigned int)tx * 73856093u ) ^ ( (unsigned int)ty * 19349663u );
+    // Probe a few slots on collisions
+    for (unsigned int i = 0; i < 8; ++i) {
+        QAtomicPointer<DistortionGridTile>& slot = gridTiles[(hash + i) & (NATRON_DISTORTION_GRID_N_TILES - 1)];
+        DistortionGridTile* tile = loadTile(slot);
+        if (!tile) {
+            DistortionGridTile* newTile = createTile(tx, ty);
+            if ( slot.testAndSetOrdered(0, newTile) ) {
+                return newTile;
+            }
+            // Another thread filled the slot meanwhile
+            delete newTile;
+            tile = loadTile(slot);
+        }
+        if ( (tile->tx == tx) && (tile->ty == ty) ) {
+            return tile;
+        }
+    }
+
+    return 0;
+} // getTile
+
+void
+Distortion2DStack::applyDistortionStack(double distortedX, double distortedY, const Distortion2DStack& stack, double* undistortedX, double* undistortedY)
+{
+    Distortion2DStackPrivate* imp = stack._imp.get();
+    if ( !imp->gridTiles ||
+         !( std::abs(distortedX) < NATRON_DISTORTION_GRID_MAX_COORDINATE ) ||
+         !( std::abs(distortedY) < NATRON_DISTORTION_GRID_MAX_COORDINATE ) ) {
+        imp->applyStack(distortedX, distortedY, undistortedX, undistortedY);
+
+        return;
+    }
+
+    // Find the grid cell containing the position and the tile containing the cell
+    double gx = distortedX / NATRON_DISTORTION_GRID_SPACING;
+    double gy = distortedY / NATRON_DISTORTION_GRID_SPACING;
+    int cx = (int)std::floor(gx);
+    int cy = (int)std::floor(gy);
+    int tx = cx >= 0 ? cx / NATRON_DISTORTION_GRID_TILE_SIZE : -( (-cx - 1) / NATRON_DISTORTION_GRID_TILE_SIZE ) - 1;
+    int ty = cy >= 0 ? cy / NATRON_DISTORTION_GRID_TILE_SIZE : -( (-cy - 1) / NATRON_DISTORTION_GRID_TILE_SIZE ) - 1;
+
+    const DistortionGridTile* tile = imp->getTile(tx, ty);
+    if ( !tile || tile->exact ) {
+        imp->applyStack(distortedX, distortedY, undistortedX, undistortedY);
+
+        return;
+    }
+
+    const int nPoints = NATRON_DISTORTION_GRID_TILE_SIZE + 1;
+    int index = (cy - ty * NATRON_DISTORTION_GRID_TILE_SIZE) * nPoints + (cx - tx * NATRON_DISTORTION_GRID_TILE_SIZE);
+    double fx = gx - cx;
+    double fy = gy - cy;
+    double w00 = (1. - fx) * (1. - fy);
+    double w10 = fx * (1. - fy);
+    double w01 = (1. - fx) * fy;
+    double w11 = fx * fy;
+    *undistortedX = w00 * tile->xs[index] + w10 * tile->xs[index + 1] + w01 * tile->xs[index + nPoints] + w11 * tile->xs[index + nPoints + 1];
+    *undistortedY = w00 * tile->ys[index] + w10 * tile->ys[index + 1] + w01 * tile->ys[index + nPoints] + w11 * tile->ys[index + nPoints + 1];
+} // applyDistortionStack
+
 NATRON_NAMESPACE_EXIT;
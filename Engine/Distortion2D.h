@@ -107,6 +107,9 @@ public:
 
     /**
      * @brief Applies a distortion stack onto a 2D position in canonical coordinates.
+     * If the stack contains distortion functions, the stack is evaluated on a grid, one tile of the grid at a time
+     * when a position in the tile is first requested, and the positions are interpolated from the grid
+     * where the interpolation error is low enough. This is MT-safe once the stack is complete.
      **/
     static void applyDistortionStack(double distortedX, double distortedY, const Distortion2DStack& stack, double* undistortedX, double* undistortedY);
 
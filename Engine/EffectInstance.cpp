@@ -54,6 +54,8 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/AppManager.h"
 #include "Engine/EffectOpenGLContextData.h"
 #include "Engine/Cache.h"
+#include "Engine/CacheEntryBase.h"
+#include "Engine/ColorMatrix.h"
 #include "Engine/EffectInstanceActionResults.h"
 #include "Engine/EffectInstanceTLSData.h"
 #include "Engine/Image.h"
@@ -61,12 +63,15 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/KnobFile.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/Log.h"
+#include "Engine/MemoryAccount.h"
 #include "Engine/MemoryInfo.h" // printAsRAM
 #include "Engine/Node.h"
+#include "Engine/NodeGroup.h"
 #include "Engine/OfxEffectInstance.h"
 #include "Engine/OfxOverlayInteract.h"
 #include "Engine/OfxImageEffectInstance.h"
 #include "Engine/GPUContextPool.h"
+#include "Engine/GroupInput.h"
 #include "Engine/OSGLContext.h"
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/PluginMemory.h"
@@ -126,28 +131,99 @@ EffectInstance::createRenderCopy(const FrameViewRenderKey& key) const
     }
     EffectInstancePtr clone = createFunc(boost::const_pointer_cast<EffectInstance>(shared_from_this()), key);
 
+    clone->initializeRenderCloneInputs(key);
+
+    TreeRenderPtr render = key.render.lock();
+    RenderStatsPtr stats = render ? render->getStatsObject() : RenderStatsPtr();
+    if (stats) {
+        stats->addRenderCloneForNode(getNode(), false /*reused*/);
+    }
+
+    return clone;
+}
+
+/**
+ * @brief Returns the first effect upstream of the given one which is not an unconditional pass-through, see
+ * EffectInstance::getUnconditionalPassThroughInput(). A pass-through with a disconnected input is returned as is
+ * so that it reports the disconnected input.
+ **/
+static EffectInstancePtr
+skipPassThroughEffects(const EffectInstancePtr& effect)
+{
+    EffectInstancePtr ret = effect;
+    while (ret) {
+        int passThroughInput = ret->getUnconditionalPassThroughInput();
+        if (passThroughInput == -1) {
+            break;
+        }
+        EffectInstancePtr input = ret->getInputMainInstance(passThroughInput);
+        if (!input) {
+            break;
+        }
+        ret = input;
+    }
+
+    return ret;
+}
+
+void
+EffectInstance::initializeRenderCloneInputs(const FrameViewRenderKey& key)
+{
+    EffectInstancePtr mainInstance = toEffectInstance(getMainInstance());
+    assert(mainInstance);
 
     // Make a copy of the main instance input locally so the state of the graph does not change throughout the render
     int nInputs = getMaxInputCount();
-    clone->_imp->renderData->mainInstanceInputs.resize(nInputs);
-    clone->_imp->renderData->renderInputs.resize(nInputs);
+    _imp->renderData->mainInstanceInputs.resize(nInputs);
+    _imp->renderData->renderInputs.resize(nInputs);
 
     FrameViewPair p = {key.time, key.view};
     for (int i = 0; i < nInputs; ++i) {
-        if (clone->isInputMask(i) && !clone->isMaskEnabled(i)) {
+        if (isInputMask(i) && !isMaskEnabled(i)) {
             continue;
         }
-        EffectInstancePtr mainInstanceInput = getInputMainInstance(i);
-        clone->_imp->renderData->mainInstanceInputs[i] = mainInstanceInput;
+        // Dots and disabled nodes are collapsed once here, so the render does not go through them
+        EffectInstancePtr mainInstanceInput = skipPassThroughEffects( mainInstance->getInputMainInstance(i) );
+        _imp->renderData->mainInstanceInputs[i] = mainInstanceInput;
         if (mainInstanceInput) {
             EffectInstancePtr inputClone = toEffectInstance(mainInstanceInput->createRenderClone(key));
-            clone->_imp->renderData->renderInputs[i][p] = inputClone;
+            _imp->renderData->renderInputs[i][p] = inputClone;
         }
     }
+} // initializeRenderCloneInputs
 
-    return clone;
+bool
+EffectInstance::isRenderCloneReusable() const
+{
+    // Items of a knobs table have their own render clones tied to the render
+    if (getItemsTable()) {
+        return false;
+    }
+    // The hash does not change while drawing a paint stroke
+    return !isDuringPaintStrokeCreation();
 }
 
+void
+EffectInstance::reuseRenderCopy(const FrameViewRenderKey& key)
+{
+    KnobHolder::reuseRenderCopy(key);
+
+    // Forget everything about the previous render
+    _imp->renderData.reset(new RenderCloneData);
+    {
+        QMutexLocker k(&_imp->common->pluginsPropMutex);
+        _imp->renderData->props = _imp->common->props;
+    }
+
+    initializeRenderCloneInputs(key);
+
+    TreeRenderPtr render = key.render.lock();
+    RenderStatsPtr stats = render ? render->getStatsObject() : RenderStatsPtr();
+    if (stats) {
+        stats->addRenderCloneForNode(getNode(), true /*reused*/);
+    }
+} // reuseRenderCopy
+
 RenderEngine*
 EffectInstance::createRenderEngine()
 {
@@ -161,7 +237,7 @@ EffectInstance::appendToHash(const ComputeHashArgs& args, Hash64* hash)
     NodePtr node = getNode();
 
     // Append the plug-in ID in case for there is a coincidence of all parameter values (and ordering!) between 2 plug-ins
-    Hash64::appendQString(QString::fromUtf8(node->getPluginID().c_str()), hash);
+    Hash64::appendString(node->getPluginID(), hash);
 
     // Also append the project knobs to the hash. Their hash will only change when the project properties have been invalidated
     U64 projectHash = getApp()->getProject()->computeHash(args);
@@ -179,6 +255,10 @@ EffectInstance::appendToHash(const ComputeHashArgs& args, Hash64* hash)
         int nInputs = getMaxInputCount();
         for (int i = 0; i < nInputs; ++i) {
             EffectInstancePtr input = getInputRenderEffectAtAnyTimeView(i);
+            if ( !isRenderClone() ) {
+                // Skip pass-through effects as render clones do, so that the hash is the same on the render clones
+                input = skipPassThroughEffects(input);
+            }
             if (!input) {
                 hash->append(0);
             } else {
@@ -218,6 +298,9 @@ EffectInstance::appendToHash(const ComputeHashArgs& args, Hash64* hash)
                         inputArgs.view = viewIt->first;
 
                         EffectInstancePtr inputEffect = getInputRenderEffect(it->first, inputArgs.time, inputArgs.view);
+                        if ( !isRenderClone() ) {
+                            inputEffect = skipPassThroughEffects(inputEffect);
+                        }
                         if (!inputEffect) {
                             continue;
                         }
@@ -291,6 +374,9 @@ EffectInstance::invalidateHashCacheRecursive(const bool recurse, std::set<Hashab
             }
             outputNode->getEffectInstance()->invalidateHashCacheRecursive(recurse, invalidatedObjects);
         }
+    } else {
+        // The outputs were not invalidated, the next invalidation of this node must not be skipped
+        setInvalidationIncomplete();
     }
     return true;
 } // invalidateHashCacheImplementation
@@ -301,6 +387,308 @@ EffectInstance::invalidateHashCacheInternal(std::set<HashableObject*>* invalidat
     return invalidateHashCacheRecursive(true /*recurse*/, invalidatedObjects);
 }
 
+bool
+EffectInstance::getRegionAffectedByInputChange(TimeValue time,
+                                               ViewIdx view,
+                                               int inputNb,
+                                               const RectD& inputRegion,
+                                               RectD* region)
+{
+    if ( getCanDistort() || getCanTransform() ) {
+        return false;
+    }
+
+    // The input must only be fetched at the same frame/view
+    {
+        GetFramesNeededResultsPtr framesNeededResults;
+        ActionRetCodeEnum stat = getFramesNeeded_public(time, view, &framesNeededResults);
+        if ( isFailureRetCode(stat) ) {
+            return false;
+        }
+        FramesNeededMap framesNeeded;
+        framesNeededResults->getFramesNeeded(&framesNeeded);
+        FramesNeededMap::const_iterator foundInput = framesNeeded.find(inputNb);
+        if ( foundInput == framesNeeded.end() ) {
+            // The input is not used
+            region->clear();
+            return true;
+        }
+        const TimeValue roundedTime = roundImageTimeToEpsilon(time);
+        for (FrameRangesMap::const_iterator it = foundInput->second.begin(); it != foundInput->second.end(); ++it) {
+            if (it->first != view) {
+                return false;
+            }
+            for (std::size_t i = 0; i < it->second.size(); ++i) {
+                if ( ( roundImageTimeToEpsilon( TimeValue(it->second[i].min) ) != roundedTime ) || ( roundImageTimeToEpsilon( TimeValue(it->second[i].max) ) != roundedTime ) ) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Get the margins around the render window of the region of interest on the input.
+    // They are checked on 2 render windows: if they differ, the region of interest does not only depend
+    // on the render window (e.g: the effect fetches the whole image).
+    double margins[2][4];
+    for (int i = 0; i < 2; ++i) {
+        RectD renderWindow = inputRegion;
+        if (i == 1) {
+            renderWindow.translate( (int)std::ceil( inputRegion.width() ) + 1, (int)std::ceil( inputRegion.height() ) + 1 );
+        }
+        RoIMap rois;
+        ActionRetCodeEnum stat = getRegionsOfInterest_public(time, RenderScale(1.), renderWindow, view, &rois);
+        if ( isFailureRetCode(stat) ) {
+            return false;
+        }
+        RoIMap::const_iterator foundInput = rois.find(inputNb);
+        if ( foundInput == rois.end() ) {
+            // The input is not used
+            region->clear();
+            return true;
+        }
+        const RectD& roi = foundInput->second;
+        if ( roi.isInfinite() ) {
+            return false;
+        }
+        margins[i][0] = renderWindow.x1 - roi.x1;
+        margins[i][1] = renderWindow.y1 - roi.y1;
+        margins[i][2] = roi.x2 - renderWindow.x2;
+        margins[i][3] = roi.y2 - renderWindow.y2;
+        for (int m = 0; m < 4; ++m) {
+            if ( (margins[i][m] < 0) || ( (i == 1) && (std::abs(margins[1][m] - margins[0][m]) > 1e-6) ) ) {
+                return false;
+            }
+        }
+    }
+
+    // A pixel of the output reading the input up to a margin on one side is affected by a change as far from it on the other side
+    region->x1 = inputRegion.x1 - margins[0][2];
+    region->y1 = inputRegion.y1 - margins[0][3];
+    region->x2 = inputRegion.x2 + margins[0][0];
+    region->y2 = inputRegion.y2 + margins[0][1];
+    return true;
+} // getRegionAffectedByInputChange
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Merges region into dirtyRegion, either of which may be null
+ **/
+void
+mergeDirtyRegion(const RectD& region, RectD* dirtyRegion)
+{
+    if ( region.isNull() ) {
+        return;
+    }
+    if ( dirtyRegion->isNull() ) {
+        *dirtyRegion = region;
+    } else {
+        dirtyRegion->merge(region);
+    }
+}
+
+/**
+ * @brief Propagates the region changed by DirtyRegionChange_RAII from the effect that changed to the effects downstream.
+ **/
+class DirtyRegionPropagation
+{
+    EffectInstance* _source;
+    TimeValue _time;
+    ViewIdx _view;
+    RectD _sourceRegion;
+    const std::set<HashableObject*>& _invalidatedObjects;
+
+    // For each effect visited, whether its region is known and the region
+    std::map<EffectInstance*, std::pair<bool, RectD> > _regions;
+
+public:
+
+    DirtyRegionPropagation(EffectInstance* source,
+                           TimeValue time,
+                           ViewIdx view,
+                           const RectD& sourceRegion,
+                           const std::set<HashableObject*>& invalidatedObjects)
+    : _source(source)
+    , _time(time)
+    , _view(view)
+    , _sourceRegion(sourceRegion)
+    , _invalidatedObjects(invalidatedObjects)
+    , _regions()
+    {
+    }
+
+    /**
+     * @brief Returns false if the region of the output of the effect which changed is not known
+     **/
+    bool getDirtyRegion(EffectInstance* effect, RectD* region);
+
+private:
+
+    bool computeDirtyRegion(EffectInstance* effect, RectD* region);
+};
+
+bool
+DirtyRegionPropagation::getDirtyRegion(EffectInstance* effect, RectD* region)
+{
+    region->clear();
+
+    // The effects that were not invalidated did not change
+    if ( _invalidatedObjects.find(effect) == _invalidatedObjects.end() ) {
+        return true;
+    }
+
+    std::map<EffectInstance*, std::pair<bool, RectD> >::const_iterator found = _regions.find(effect);
+    if ( found != _regions.end() ) {
+        *region = found->second.second;
+        return found->second.first;
+    }
+
+    // Mark it unknown while computing it in case there is a cycle
+    _regions[effect] = std::make_pair( false, RectD() );
+
+    bool known = computeDirtyRegion(effect, region);
+    if (!known) {
+        region->clear();
+    }
+    _regions[effect] = std::make_pair(known, *region);
+    return known;
+}
+
+bool
+DirtyRegionPropagation::computeDirtyRegion(EffectInstance* effect, RectD* region)
+{
+    if (effect == _source) {
+        *region = _sourceRegion;
+        return true;
+    }
+
+    // The nodes inside the group that changed, e.g: the internal nodes of a RotoPaint, change within the same region
+    {
+        NodeGroup* sourceGroup = dynamic_cast<NodeGroup*>(_source);
+        if ( sourceGroup && ( toNodeGroup( effect->getNode()->getGroup() ).get() == sourceGroup ) ) {
+            *region = _sourceRegion;
+            return true;
+        }
+    }
+
+    // A group changes as its output node
+    NodeGroup* isGroup = dynamic_cast<NodeGroup*>(effect);
+    if (isGroup) {
+        NodePtr outputNode = isGroup->getOutputNode();
+        if (!outputNode) {
+            return false;
+        }
+        return getDirtyRegion(outputNode->getEffectInstance().get(), region);
+    }
+
+    // The input of a group changes as the corresponding input of the group
+    if ( dynamic_cast<GroupInput*>(effect) ) {
+        NodeGroupPtr containingGroup = toNodeGroup( effect->getNode()->getGroup() );
+        if (!containingGroup) {
+            return false;
+        }
+        NodePtr realInput = containingGroup->getRealInputForInput( effect->getNode() );
+        if (!realInput) {
+            return true;
+        }
+        return getDirtyRegion(realInput->getEffectInstance().get(), region);
+    }
+
+    bool hasDirtyInput = false;
+    int nInputs = effect->getMaxInputCount();
+    for (int i = 0; i < nInputs; ++i) {
+        EffectInstancePtr input = effect->getInputMainInstance(i);
+        if (!input) {
+            continue;
+        }
+        RectD inputRegion;
+        if ( !getDirtyRegion(input.get(), &inputRegion) ) {
+            return false;
+        }
+        if ( inputRegion.isNull() ) {
+            continue;
+        }
+        hasDirtyInput = true;
+        RectD affectedRegion;
+        if ( !effect->getRegionAffectedByInputChange(_time, _view, i, inputRegion, &affectedRegion) ) {
+            return false;
+        }
+        mergeDirtyRegion(affectedRegion, region);
+    }
+
+    // The hash of the effect was invalidated but none of its inputs changed: what changed is unknown
+    return hasDirtyInput;
+} // computeDirtyRegion
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+EffectInstance::DirtyRegionChange_RAII::DirtyRegionChange_RAII(const EffectInstancePtr& effect,
+                                                               TimeValue time)
+: _effect(effect)
+, _time(time)
+, _region()
+, _regionSet(false)
+, _unreportedInvalidationsCount( HashableObject::getUnreportedInvalidationsCount() )
+, _invalidatedObjects()
+, _previousInvalidatedObjects(0)
+{
+    _previousInvalidatedObjects = HashableObject::beginReportedInvalidations(&_invalidatedObjects);
+}
+
+void
+EffectInstance::DirtyRegionChange_RAII::addDirtyRegion(const RectD& region)
+{
+    mergeDirtyRegion(region, &_region);
+    _regionSet = true;
+}
+
+EffectInstance::DirtyRegionChange_RAII::~DirtyRegionChange_RAII()
+{
+    HashableObject::endReportedInvalidations(_previousInvalidatedObjects);
+
+    if ( _invalidatedObjects.empty() ) {
+        return;
+    }
+
+    // If another thread invalidated anything meanwhile, it is not accounted for in the region
+    if ( !_effect || !_regionSet || (HashableObject::getUnreportedInvalidationsCount() != _unreportedInvalidationsCount) ) {
+        HashableObject::notifyUnreportedInvalidation();
+        return;
+    }
+
+    try {
+        // For each effect invalidated, the region which changed for each view
+        std::map<EffectInstance*, std::vector<RectD> > perEffectRegions;
+        std::set<EffectInstance*> unknownRegionEffects;
+
+        int nViews = _effect->getRenderViewsCount();
+        for (int v = 0; v < nViews; ++v) {
+            DirtyRegionPropagation propagation(_effect.get(), _time, ViewIdx(v), _region, _invalidatedObjects);
+            for (std::set<HashableObject*>::const_iterator it = _invalidatedObjects.begin(); it != _invalidatedObjects.end(); ++it) {
+                EffectInstance* effect = dynamic_cast<EffectInstance*>(*it);
+                if ( !effect || effect->isRenderClone() ) {
+                    continue;
+                }
+                RectD region;
+                if ( !propagation.getDirtyRegion(effect, &region) ) {
+                    unknownRegionEffects.insert(effect);
+                }
+                perEffectRegions[effect].push_back(region);
+            }
+        }
+
+        for (std::map<EffectInstance*, std::vector<RectD> >::iterator it = perEffectRegions.begin(); it != perEffectRegions.end(); ++it) {
+            if ( unknownRegionEffects.find(it->first) != unknownRegionEffects.end() ) {
+                it->second.clear();
+            }
+            it->first->_imp->reportDirtyRegion(_time, it->second, _unreportedInvalidationsCount);
+        }
+    } catch (...) {
+        // Some effects may not have been reported
+        HashableObject::notifyUnreportedInvalidation();
+    }
+} // ~DirtyRegionChange_RAII
+
 void
 EffectInstance::refreshMetadaWarnings(const NodeMetadata &metadata)
 {
@@ -740,6 +1128,38 @@ EffectInstance::GetImageInArgs::GetImageInArgs(const unsigned int* currentMipMap
 
 bool
 EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* outArgs)
+{
+    // If the plane is not provided, the render resolves it
+    std::list<ImagePlaneDesc> planes;
+    if (inArgs.plane) {
+        planes.push_back(*inArgs.plane);
+    }
+    std::list<GetImageOutArgs> results;
+    if ( !getImagePlanesInternal(inArgs, planes, &results) ) {
+        return false;
+    }
+    assert(results.size() == 1);
+    *outArgs = results.front();
+
+    return true;
+} // getImagePlane
+
+bool
+EffectInstance::getImagePlanes(const GetImageInArgs& inArgs,
+                               const std::list<ImagePlaneDesc>& planes,
+                               std::list<GetImageOutArgs>* outArgs)
+{
+    if ( planes.empty() ) {
+        return false;
+    }
+
+    return getImagePlanesInternal(inArgs, planes, outArgs);
+} // getImagePlanes
+
+bool
+EffectInstance::getImagePlanesInternal(const GetImageInArgs& inArgs,
+                                       const std::list<ImagePlaneDesc>& planes,
+                                       std::list<GetImageOutArgs>* outArgs)
 {
 
     // Extract arguments and make default values if needed
@@ -821,39 +1241,100 @@ EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* out
     if (roiCanonical.isNull()) {
         return false;
     }
-
-    // Launch a render to recover the image.
-    // It should be very fast if the image was already rendered.
-    FrameViewRequestPtr outputRequest;
+    // Launch a render to recover the images, one per plane.
+    // It should be very fast if the images were already rendered.
+    std::list<FrameViewRequestPtr> outputRequests;
     {
-        ActionRetCodeEnum status;
-        if (currentRender) {
-            status = currentRender->launchRenderWithArgs(inputEffect, inputTime, inputView, inputProxyScale, inputMipMapLevel, inArgs.plane, &roiCanonical, &outputRequest);
+        ActionRetCodeEnum status = eActionStatusOK;
+        const ImagePlaneDesc* plane = planes.empty() ? 0 : &planes.front();
+        if (currentRender && planes.size() > 1) {
+
+            // The planes are requested in a single pass with the same RoI so that the input may render them in a single action
+            status = currentRender->launchRenderWithArgs(inputEffect, inputTime, inputView, inputProxyScale, inputMipMapLevel, planes, &roiCanonical, &outputRequests);
+        } else if (currentRender) {
+
+            // If the input frame was not requested by the request pass, the plug-in is probably fetching the frames it needs
+            // one after another: render the next ones in the same pass so that they share the upstream requests and render in parallel.
+            FrameViewRequestPtr requestRenderedAhead;
+            std::list<FrameViewPair> framesToRenderAhead;
+            if (isRenderClone() && !inputEffect->isRenderClone()) {
+                requestRenderedAhead = _imp->takeInputRequestRenderedAhead(inArgs.inputNb, inputTime, inputView);
+                if (!requestRenderedAhead) {
+                    _imp->getInputFramesToRenderAhead(inArgs.inputNb, inputTime, inputView, &framesToRenderAhead);
+                }
+            }
+            if (framesToRenderAhead.empty()) {
+                FrameViewRequestPtr outputRequest;
+                status = currentRender->launchRenderWithArgs(inputEffect, inputTime, inputView, inputProxyScale, inputMipMapLevel, plane, &roiCanonical, &outputRequest);
+                outputRequests.push_back(outputRequest);
+            } else {
+                std::list<FrameViewPair> frames = framesToRenderAhead;
+                {
+                    FrameViewPair p = {inputTime, inputView};
+                    frames.push_front(p);
+                }
+                status = currentRender->launchRenderWithArgs(inputEffect, frames, inputProxyScale, inputMipMapLevel, plane, &roiCanonical, &outputRequests);
+                if (!isFailureRetCode(status)) {
+                    assert(outputRequests.size() == frames.size());
+                    std::list<FrameViewRequestPtr> requestsRenderedAhead = outputRequests;
+                    requestsRenderedAhead.pop_front();
+                    outputRequests.resize(1);
+                    _imp->addInputRequestsRenderedAhead(inArgs.inputNb, framesToRenderAhead, requestsRenderedAhead);
+                }
+            }
         } else {
-            // We are not during a render, create one.
-            TreeRender::CtorArgsPtr rargs(new TreeRender::CtorArgs());
-            rargs->time = inputTime;
-            rargs->view = inputView;
-            rargs->treeRootEffect = inputEffect;
-            rargs->canonicalRoI = &roiCanonical;
-            rargs->proxyScale = inputProxyScale;
-            rargs->mipMapLevel = inputMipMapLevel;
-            rargs->plane = inArgs.plane;
-            rargs->draftMode = isDraftMode;
-            rargs->playback = isPlayback;
-            rargs->byPassCache = false;
-            TreeRenderPtr renderObject = TreeRender::create(rargs);
-            if (!currentRender) {
+            // We are not during a render, create one for each plane.
+            std::list<ImagePlaneDesc>::const_iterator itPlane = planes.begin();
+            do {
+                TreeRender::CtorArgsPtr rargs(new TreeRender::CtorArgs());
+                rargs->time = inputTime;
+                rargs->view = inputView;
+                rargs->treeRootEffect = inputEffect;
+                rargs->canonicalRoI = &roiCanonical;
+                rargs->proxyScale = inputProxyScale;
+                rargs->mipMapLevel = inputMipMapLevel;
+                rargs->plane = itPlane == planes.end() ? 0 : &*itPlane;
+                rargs->draftMode = isDraftMode;
+                rargs->playback = isPlayback;
+                rargs->byPassCache = false;
+                TreeRenderPtr renderObject = TreeRender::create(rargs);
                 currentRender = renderObject;
-            }
-            status = renderObject->launchRender(&outputRequest);
+                FrameViewRequestPtr outputRequest;
+                status = renderObject->launchRender(&outputRequest);
+                outputRequests.push_back(outputRequest);
+                if (itPlane != planes.end()) {
+                    ++itPlane;
+                }
+            } while ( !isFailureRetCode(status) && itPlane != planes.end() );
         }
         if (isFailureRetCode(status)) {
             return false;
         }
     }
+    assert( outputRequests.size() == std::max(planes.size(), (std::size_t)1) );
+
+    for (std::list<FrameViewRequestPtr>::const_iterator it = outputRequests.begin(); it != outputRequests.end(); ++it) {
+        GetImageOutArgs planeOutArgs;
+        if ( !*it || !getImagePlaneFromRequest(inArgs, inputEffect, currentRender, *it, roiCanonical, roiExpand, inputCombinedScale, inputPar, &planeOutArgs) ) {
+            return false;
+        }
+        outArgs->push_back(planeOutArgs);
+    }
 
+    return true;
+} // getImagePlanesInternal
 
+bool
+EffectInstance::getImagePlaneFromRequest(const GetImageInArgs& inArgs,
+                                         const EffectInstancePtr& inputEffect,
+                                         const TreeRenderPtr& currentRender,
+                                         const FrameViewRequestPtr& outputRequest,
+                                         const RectD& roiCanonical,
+                                         const RectD& roiExpand,
+                                         const RenderScale& inputCombinedScale,
+                                         double inputPar,
+                                         GetImageOutArgs* outArgs)
+{
     // Copy in output the distortion stack
     outArgs->distortionStack = outputRequest->getDistorsionStack();
 
@@ -914,11 +1395,16 @@ EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* out
 
     // If this node does not support multi-plane or the image is the color plane,
     // map it to this node preferred color plane
+    bool mustMapPlane = false;
     if (!supportsMultiPlane || outArgs->image->getLayer().isColorPlane()) {
         ImagePlaneDesc plane, pairedPlane;
         getMetadataComponents(inArgs.inputNb, &plane, &pairedPlane);
         if (outArgs->image->getLayer() != plane) {
-            mustConvertImage = true;
+            // If only the plane changes, the pixels can be shared, see below
+            if (outArgs->image->getLayer().getNumComponents() != plane.getNumComponents()) {
+                mustConvertImage = true;
+            }
+            mustMapPlane = true;
             preferredLayer = plane;
         }
     }
@@ -928,6 +1414,12 @@ EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* out
         mustConvertImage = true;
     }
 
+    // The colour effects concatenated upstream were not rendered: apply their matrix on a copy of the image
+    ColorMatrixPtr colorMatrix = outputRequest->getColorMatrix();
+    if (colorMatrix) {
+        mustConvertImage = true;
+    }
+
 
     if (roiExpandPixels != roiPixels) {
         outArgs->roiPixel = roiExpandPixels;
@@ -937,9 +1429,22 @@ EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* out
 
     outArgs->roiPixel.intersect(outArgs->image->getBounds(), &outArgs->roiPixel);
 
+    if (mustMapPlane && !mustConvertImage) {
+        // The input image has the layout and bit depth expected by this effect and only needs to be labeled
+        // with another plane: hand out its buffer instead of copying it. The input images are read-only.
+        ImagePtr sharedImage = outArgs->image->createSharedBufferImage(preferredLayer);
+        if (sharedImage) {
+            outArgs->image = sharedImage;
+        } else {
+            mustConvertImage = true;
+        }
+    }
+
     ImagePtr convertedImage = outArgs->image;
     if (mustConvertImage) {
 
+        RenderStatsActionTimer_RAII statsTimer(this, eRenderStatsActionConversion);
+
         Image::InitStorageArgs initArgs;
         {
             initArgs.bounds = outArgs->roiPixel;
@@ -958,6 +1463,13 @@ EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* out
         if (!convertedImage) {
             return false;
         }
+        {
+            RenderStatsPtr stats = currentRender->getStatsObject();
+            if ( stats && stats->isInDepthProfilingEnabled() ) {
+                std::size_t bytesAllocated = (std::size_t)initArgs.bounds.area() * preferredLayer.getNumComponents() * getSizeOfForBitDepth(thisBitDepth);
+                stats->addBytesAllocatedForNode(getNode(), bytesAllocated);
+            }
+        }
 
         int channelForMask = - 1;
         ImagePlaneDesc maskComps;
@@ -988,6 +1500,12 @@ EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* out
         if (isFailureRetCode(stat)) {
             return false;   
         }
+        if (colorMatrix) {
+            stat = convertedImage->applyColorMatrix(initArgs.bounds, colorMatrix->m);
+            if (isFailureRetCode(stat)) {
+                return false;
+            }
+        }
         outArgs->image = convertedImage;
     } // mustConvertImage
 
@@ -1003,7 +1521,7 @@ EffectInstance::getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* out
 
 
     return true;
-} // getImagePlane
+} // getImagePlaneFromRequest
 
 
 bool
@@ -1113,6 +1631,15 @@ EffectInstance::NotifyInputNRenderingStarted_RAII::~NotifyInputNRenderingStarted
 }
 
 
+void
+EffectInstance::onKnobSerializationInvalidated()
+{
+    NodePtr node = getNode();
+    if (node) {
+        node->invalidateAutoSaveSerialization();
+    }
+}
+
 void
 EffectInstance::evaluate(bool isSignificant,
                          bool refreshMetadata)
@@ -1207,6 +1734,9 @@ PluginMemoryPtr
 EffectInstance::createPluginMemory()
 {
     PluginMemoryPtr ret( new PluginMemory() );
+    std::vector<MemoryAccountPtr> memoryAccounts;
+    MemoryAccount::getEffectAccounts(shared_from_this(), &memoryAccounts);
+    ret->setMemoryAccounts(memoryAccounts, eMemoryAccountTypePlugin);
     return ret;
 }
 
@@ -1353,6 +1883,27 @@ EffectInstance::clearLastRenderedImage()
     }
 }
 
+void
+EffectInstance::prefetchCachedImages(TimeValue first, TimeValue last, ViewIdx view)
+{
+    CacheBasePtr tileCache = appPTR->getTileCache();
+    if (!tileCache || !tileCache->isPersistent()) {
+        // The cached images are already in memory
+        return;
+    }
+
+    // Images in the cache are identified by the node hash at their time and view, see ImageCacheKey
+    std::vector<U64> hashes;
+    for (double t = first; t <= last; t += 1.) {
+        HashableObject::ComputeHashArgs args;
+        args.time = TimeValue(t);
+        args.view = view;
+        args.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+        hashes.push_back(computeHash(args));
+    }
+    tileCache->prefetchEntries(hashes);
+} // prefetchCachedImages
+
 void
 EffectInstance::setAccumBuffer(const ImagePtr& accumBuffer)
 {
@@ -2246,6 +2797,14 @@ EffectInstance::getAfterFrameRenderCallback() const
     return s ? s->getValue() : std::string();
 }
 
+bool
+EffectInstance::isAfterFrameRenderCallbackAsynchronous() const
+{
+    KnobBoolPtr b = _imp->defKnobs->afterFrameRenderAsync.lock();
+
+    return b ? b->getValue() : false;
+}
+
 std::string
 EffectInstance::getAfterNodeCreatedCallback() const
 {
@@ -160,6 +160,14 @@ NATRON_NAMESPACE_ENTER;
 #define kNatronNodeKnobExportPyPlugButton "exportPyPlug"
 #define kNatronNodeKnobExportPyPlugButtonLabel "Export"
 
+#define kNatronNodeKnobCacheBoundary "cacheBoundary"
+#define kNatronNodeKnobCacheBoundaryLabel "Cache boundary"
+#define kNatronNodeKnobCacheBoundaryHint "When checked, the output of this group is cached as a whole: the cache key only depends on the parameters of the group, " \
+"its inputs at the same frame and the nodes of the sub-graph that are not animated. When the image is found in the cache, " \
+"the nodes of the sub-graph are not visited at all.\n" \
+"Only check this for groups (such as PyPlugs) whose output at a frame does not depend on the inputs at other frames and whose " \
+"internal nodes are controlled by the parameters of the group"
+
 #define kNatronNodeKnobConvertToGroupButton "convertToGroup"
 #define kNatronNodeKnobConvertToGroupButtonLabel "Convert to Group"
 
@@ -431,8 +439,33 @@ public:
      **/
     bool getImagePlane(const GetImageInArgs& inArgs, GetImageOutArgs* outArgs) WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Same as getImagePlane() but fetches several planes of the same input at once, e.g: the AOVs of a multi-layer image.
+     * During a render, the planes are requested in a single pass with the RoI and RoD computed once and a
+     * multi-planar input that is rendered renders all the requested planes in a single render action.
+     * The plane of inArgs is ignored.
+     * @param outArgs[out] The result for each plane, in the same order as planes.
+     * @returns True if all images are valid.
+     **/
+    bool getImagePlanes(const GetImageInArgs& inArgs, const std::list<ImagePlaneDesc>& planes, std::list<GetImageOutArgs>* outArgs) WARN_UNUSED_RETURN;
+
 private:
 
+    bool getImagePlanesInternal(const GetImageInArgs& inArgs, const std::list<ImagePlaneDesc>& planes, std::list<GetImageOutArgs>* outArgs);
+
+    /**
+     * @brief Maps the image rendered for the request of a getImagePlane() call to the format expected by this effect
+     **/
+    bool getImagePlaneFromRequest(const GetImageInArgs& inArgs,
+                                  const EffectInstancePtr& inputEffect,
+                                  const TreeRenderPtr& currentRender,
+                                  const FrameViewRequestPtr& outputRequest,
+                                  const RectD& roiCanonical,
+                                  const RectD& roiExpand,
+                                  const RenderScale& inputCombinedScale,
+                                  double inputPar,
+                                  GetImageOutArgs* outArgs);
+
     /**
      * @brief In output the RoI in canonical coordinates is set to ask for on the input effect.
      * @param roiCanonical The RoI in output to fetch on the input
@@ -643,7 +676,31 @@ protected:
                                      const RenderScale & renderScale,
                                      ViewIdx view,
                                      DistortionFunction2D* distortion) WARN_UNUSED_RETURN;
-    
+
+public:
+
+    /**
+     * @brief For effects whose render is a 3x4 matrix applied to the RGB channels of a single input (e.g a
+     * colour grade), this returns the matrix. Natron then concatenates consecutive colour effects and applies
+     * their product once, when the image is fetched by the first effect downstream that is not a colour effect.
+     * @returns eActionStatusReplyDefault if the effect is not a colour matrix at the given time.
+     **/
+    ActionRetCodeEnum getColorMatrix_public(TimeValue time,
+                                            const RenderScale & renderScale,
+                                            ViewIdx view,
+                                            ColorMatrix* matrix) WARN_UNUSED_RETURN;
+
+protected:
+
+    /**
+     * @brief Must set matrix->inputNbToTransform to the input the matrix applies to and fill matrix->m.
+     * The default implementation returns eActionStatusReplyDefault.
+     **/
+    virtual ActionRetCodeEnum getColorMatrix(TimeValue time,
+                                             const RenderScale & renderScale,
+                                             ViewIdx view,
+                                             ColorMatrix* matrix) WARN_UNUSED_RETURN;
+
 public:
 
     /**
@@ -740,6 +797,21 @@ protected:
 
 public:
 
+    /**
+     * @brief Returns in region the part of the output of the effect at the given time/view which may change when the
+     * given region (in canonical coordinates) of the input inputNb changes at the same time/view. This is used to propagate
+     * the changes reported with DirtyRegionChange_RAII downstream.
+     * Returns false if it cannot be determined, in which case the whole output may change.
+     * By default this is inferred from the regions of interest, which is only possible for effects which do not distort their
+     * input, only fetch it at the same time/view and request a fixed area around the render window.
+     **/
+    virtual bool getRegionAffectedByInputChange(TimeValue time,
+                                                ViewIdx view,
+                                                int inputNb,
+                                                const RectD& inputRegion,
+                                                RectD* region);
+
+
     /**
      * @brief Computes the frame/view pairs needed by this effect in input for the render action.
      * @param time The time at which the input should be sampled
@@ -1028,6 +1100,15 @@ public:
         return false;
     }
 
+    /**
+     * @brief Returns true if the render action of this effect mostly waits for files to be read or written.
+     * The render tasks of such effects run in the I/O thread pool, see AppManager::getIOThreadPool().
+     **/
+    virtual bool isIOBound() const WARN_UNUSED_RETURN
+    {
+        return isReader() || isWriter();
+    }
+
     /**
      * @brief Is this node an output node ? An output node means
      * that a RenderEngine can be created.
@@ -1223,9 +1304,19 @@ protected:
 
     virtual KnobHolderPtr createRenderCopy(const FrameViewRenderKey& key) const OVERRIDE;
 
+    virtual bool isRenderCloneReusable() const OVERRIDE;
+
+    virtual void reuseRenderCopy(const FrameViewRenderKey& key) OVERRIDE;
+
     
 private:
 
+    /**
+     * @brief Called on a render clone to freeze the state of the main instance inputs for the render and create
+     * the render clones of the inputs.
+     **/
+    void initializeRenderCloneInputs(const FrameViewRenderKey& key);
+
     ActionRetCodeEnum launchRenderInternal(const RequestPassSharedDataPtr& requestPassSharedData, const FrameViewRequestPtr& requestData);
 
 
@@ -1260,6 +1351,38 @@ public:
         ~NotifyInputNRenderingStarted_RAII();
     };
 
+    /**
+     * @brief Reports that the changes made during the lifetime of this object only change the given region of the output of
+     * the effect at the given time, for all views. The images rendered before by the effect and the effects downstream
+     * then remain valid outside of the region that they change: only the tiles in that region are rendered again
+     * with the new hashes, the others are copied from the cache.
+     * The call to invalidateHashCache() for the change must be made during the lifetime of this object, but not the
+     * evaluation: the render must start once this object is destroyed.
+     * If addDirtyRegion() is not called, the change is handled as an invalidation that was not reported.
+     **/
+    class DirtyRegionChange_RAII
+    {
+        EffectInstancePtr _effect;
+        TimeValue _time;
+        RectD _region;
+        bool _regionSet;
+        int _unreportedInvalidationsCount;
+        std::set<HashableObject*> _invalidatedObjects;
+        std::set<HashableObject*>* _previousInvalidatedObjects;
+
+public:
+
+        DirtyRegionChange_RAII(const EffectInstancePtr& effect,
+                               TimeValue time);
+
+        /**
+         * @brief Add a region of the output of the effect changed by the change, in canonical coordinates
+         **/
+        void addDirtyRegion(const RectD& region);
+
+        ~DirtyRegionChange_RAII();
+    };
+
 
 public:
 
@@ -1434,6 +1557,13 @@ public:
 
     virtual void clearLastRenderedImage();
 
+    /**
+     * @brief Asynchronously faults in the images of this node that are already in the persistent tile cache
+     * for all frames in the given range, so that the first render of these frames does not wait for the disk.
+     * This must be called on the main instance.
+     **/
+    void prefetchCachedImages(TimeValue first, TimeValue last, ViewIdx view);
+
 
     /**
      * @brief Use this function to post a transient message to the user. It will be displayed using
@@ -1450,7 +1580,10 @@ public:
 
 
     /**
-     * @brief Must return the preferred layout of images that are received with getImage
+     * @brief Must return the preferred layout of images that are received with getImage.
+     * This is also the layout of the images rendered by this effect: an effect that processes its images
+     * tile by tile may return eImageBufferLayoutMonoChannelTiled so that its images are not copied to
+     * a full rect buffer when they are read from and written to the cache.
      **/
     virtual ImageBufferLayoutEnum getPreferredBufferLayout() const
     {
@@ -1673,6 +1806,11 @@ public:
      **/
     virtual void evaluate(bool isSignificant, bool refreshMetadata) OVERRIDE;
 
+    /**
+     * @brief Reimplemented from KnobHolder: invalidates the auto-save serialization of the node
+     **/
+    virtual void onKnobSerializationInvalidated() OVERRIDE FINAL;
+
     PluginMemoryPtr createMemoryChunk(std::size_t nBytes);
 
 protected:
@@ -1791,6 +1929,13 @@ public:
     std::string getBeforeFrameRenderCallback() const;
     std::string getAfterRenderCallback() const;
     std::string getAfterFrameRenderCallback() const;
+
+    /**
+     * @brief Returns true if the after frame render callback must be run on a dedicated thread instead of
+     * the thread that delivered the frame, see OutputSchedulerThread::runAfterFrameRenderedCallback()
+     **/
+    bool isAfterFrameRenderCallbackAsynchronous() const;
+
     std::string getAfterNodeCreatedCallback() const;
     std::string getBeforeNodeRemovalCallback() const;
     std::string getAfterSelectionChangedCallback() const;
@@ -1860,6 +2005,11 @@ public:
 
     void setForceCachingEnabled(bool b);
 
+    /**
+     * @brief Returns true if this is a group whose output is cached as a whole, see kNatronNodeKnobCacheBoundaryHint
+     **/
+    bool isCacheBoundaryEnabled() const;
+
     bool isKeepInAnimationModuleButtonDown() const;
 
     bool getHideInputsKnobValue() const;
@@ -1870,6 +2020,13 @@ public:
 
     bool isNodeDisabledForFrame(TimeValue time, ViewIdx view) const;
 
+    /**
+     * @brief If this effect forwards one of its inputs unchanged at any time, view and plane, returns the index of that input,
+     * otherwise returns -1. This is the case of Dot and GroupOutput nodes and of nodes disabled with a non animated disable parameter.
+     * Render clones skip such effects upstream so that no render clone nor FrameViewRequest is created for them.
+     **/
+    int getUnconditionalPassThroughInput() const;
+
     void setNodeDisabled(bool disabled);
 
     void restoreSublabel();
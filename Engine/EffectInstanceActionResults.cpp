@@ -160,7 +160,7 @@ IsIdentityKey::appendToHash(Hash64* hash) const
 {
     EffectInstanceActionKeyBase::appendToHash(hash);
     hash->append((double)_time);
-    Hash64::appendQString(QString::fromUtf8(_plane.getPlaneID().c_str()), hash);
+    Hash64::appendString(_plane.getPlaneID(), hash);
 }
 
 IsIdentityResults::IsIdentityResults()
@@ -261,6 +261,58 @@ GetFramesNeededResults::fromMemorySegment(bool /*isLockedForWriting*/,
     throw std::runtime_error("GetFramesNeededResults::fromMemorySegment serialization from a persistent cache unimplemented");
 } // fromMemorySegment
 
+void
+GetRegionsOfInterestKey::appendToHash(Hash64* hash) const
+{
+    EffectInstanceActionKeyBase::appendToHash(hash);
+    hash->append(_renderWindow.x1);
+    hash->append(_renderWindow.y1);
+    hash->append(_renderWindow.x2);
+    hash->append(_renderWindow.y2);
+}
+
+GetRegionsOfInterestResults::GetRegionsOfInterestResults()
+: CacheEntryBase(appPTR->getGeneralPurposeCache())
+, _rois()
+{
+
+}
+
+GetRegionsOfInterestResultsPtr
+GetRegionsOfInterestResults::create(const GetRegionsOfInterestKeyPtr& key)
+{
+    GetRegionsOfInterestResultsPtr ret(new GetRegionsOfInterestResults());
+    ret->setKey(key);
+    return ret;
+}
+
+const RoIMap&
+GetRegionsOfInterestResults::getRegionsOfInterest() const
+{
+    return _rois;
+}
+
+void
+GetRegionsOfInterestResults::setRegionsOfInterest(const RoIMap& rois)
+{
+    _rois = rois;
+}
+
+void
+GetRegionsOfInterestResults::toMemorySegment(IPCPropertyMap* /*properties*/) const
+{
+    assert(false);
+    throw std::runtime_error("GetRegionsOfInterestResults::toMemorySegment serialization to a persistent cache unimplemented");
+} // toMemorySegment
+
+CacheEntryBase::FromMemorySegmentRetCodeEnum
+GetRegionsOfInterestResults::fromMemorySegment(bool /*isLockedForWriting*/,
+                                               const IPCPropertyMap& /*properties*/)
+{
+    assert(false);
+    throw std::runtime_error("GetRegionsOfInterestResults::fromMemorySegment serialization from a persistent cache unimplemented");
+} // fromMemorySegment
+
 
 
 GetFrameRangeResults::GetFrameRangeResults()
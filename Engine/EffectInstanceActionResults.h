@@ -369,6 +369,79 @@ toGetFramesNeededResults(const CacheEntryBasePtr& entry)
 }
 
 
+class GetRegionsOfInterestKey : public EffectInstanceActionKeyBase
+{
+public:
+
+    GetRegionsOfInterestKey(U64 nodeTimeViewVariantHash,
+                            const RenderScale& scale,
+                            const RectD& renderWindow,
+                            const std::string& pluginID)
+    : EffectInstanceActionKeyBase(nodeTimeViewVariantHash, scale, pluginID)
+    , _renderWindow(renderWindow)
+    {
+
+    }
+
+    virtual ~GetRegionsOfInterestKey()
+    {
+
+    }
+
+    virtual int getUniqueID() const OVERRIDE FINAL
+    {
+        return kCacheKeyUniqueIDGetRegionsOfInterestResults;
+    }
+
+private:
+
+    virtual void appendToHash(Hash64* hash) const OVERRIDE FINAL;
+
+    // The regions of interest are only valid for the render window they were computed for
+    RectD _renderWindow;
+};
+
+typedef std::map<int, RectD> RoIMap; // RoIs are in canonical coordinates
+
+class GetRegionsOfInterestResults : public CacheEntryBase
+{
+    GetRegionsOfInterestResults();
+
+public:
+
+    static GetRegionsOfInterestResultsPtr create(const GetRegionsOfInterestKeyPtr& key);
+
+    virtual ~GetRegionsOfInterestResults()
+    {
+
+    }
+
+    // This is thread-safe and doesn't require a mutex:
+    // The thread computing this entry and calling the setter is guaranteed
+    // to be the only one interacting with this object. Then all objects
+    // should call the getter.
+    //
+    const RoIMap& getRegionsOfInterest() const;
+    void setRegionsOfInterest(const RoIMap& rois);
+
+    virtual void toMemorySegment(IPCPropertyMap* properties) const OVERRIDE FINAL;
+
+    virtual CacheEntryBase::FromMemorySegmentRetCodeEnum fromMemorySegment(bool isLockedForWriting,
+                                                                           const IPCPropertyMap& properties) OVERRIDE FINAL;
+
+private:
+
+    RoIMap _rois;
+
+};
+
+inline GetRegionsOfInterestResultsPtr
+toGetRegionsOfInterestResults(const CacheEntryBasePtr& entry)
+{
+    return boost::dynamic_pointer_cast<GetRegionsOfInterestResults>(entry);
+}
+
+
 class GetFrameRangeKey : public EffectInstanceActionKeyBase
 {
 public:
@@ -31,6 +31,7 @@
 
 #include "Engine/AppInstance.h"
 #include "Engine/Cache.h"
+#include "Engine/ColorMatrix.h"
 #include "Engine/EffectInstanceActionResults.h"
 #include "Engine/EffectOpenGLContextData.h"
 #include "Engine/Format.h"
@@ -40,6 +41,7 @@
 #include "Engine/Node.h"
 #include "Engine/NodeMetadata.h"
 #include "Engine/Project.h"
+#include "Engine/RenderStats.h"
 #include "Engine/ThreadPool.h"
 
 
@@ -849,6 +851,42 @@ EffectInstance::getDistortion_public(TimeValue inArgsTime,
 
 } // getDistortion_public
 
+ActionRetCodeEnum
+EffectInstance::getColorMatrix(TimeValue /*time*/,
+                               const RenderScale & /*renderScale*/,
+                               ViewIdx /*view*/,
+                               ColorMatrix* /*matrix*/)
+{
+    return eActionStatusReplyDefault;
+}
+
+ActionRetCodeEnum
+EffectInstance::getColorMatrix_public(TimeValue inArgsTime,
+                                      const RenderScale & renderScale,
+                                      ViewIdx view,
+                                      ColorMatrix* matrix)
+{
+    assert(matrix);
+
+    TimeValue time = inArgsTime;
+    {
+        int roundedTime = std::floor(time + 0.5);
+        if (roundedTime != time && !canRenderContinuously()) {
+            time = TimeValue(roundedTime);
+        }
+    }
+
+    const bool renderScaleSupported = getCurrentSupportRenderScale();
+    const RenderScale mappedScale = renderScaleSupported ? renderScale : RenderScale(1.);
+
+    ActionRetCodeEnum stat = getColorMatrix(time, mappedScale, view, matrix);
+    if ( (stat == eActionStatusOK) && (matrix->inputNbToTransform == -1) ) {
+        return eActionStatusReplyDefault;
+    }
+
+    return stat;
+} // getColorMatrix_public
+
 ActionRetCodeEnum
 EffectInstance::isIdentity(TimeValue /*time*/,
                            const RenderScale & /*scale*/,
@@ -959,7 +997,11 @@ EffectInstance::isIdentity_public(bool useIdentityCache, // only set to true whe
         ViewIdx identityView = view;
         int identityInputNb = -1;
         ImagePlaneDesc identityPlane = plane;
-        ActionRetCodeEnum stat = isIdentity(time, mappedScale, mappedRenderWindow, view, plane, &identityTime, &identityView, &identityInputNb, &identityPlane);
+        ActionRetCodeEnum stat;
+        {
+            RenderStatsActionTimer_RAII statsTimer(this, eRenderStatsActionIsIdentity);
+            stat = isIdentity(time, mappedScale, mappedRenderWindow, view, plane, &identityTime, &identityView, &identityInputNb, &identityPlane);
+        }
         if (isFailureRetCode(stat)) {
             return stat;
         }
@@ -1100,7 +1142,11 @@ EffectInstance::getRegionOfDefinition_public(TimeValue inArgsTime,
 
 
             RectD rod;
-            ActionRetCodeEnum stat = getRegionOfDefinition(time, mappedScale, view, &rod);
+            ActionRetCodeEnum stat;
+            {
+                RenderStatsActionTimer_RAII statsTimer(this, eRenderStatsActionGetRegionOfDefinition);
+                stat = getRegionOfDefinition(time, mappedScale, view, &rod);
+            }
 
             if (isFailureRetCode(stat)) {
                 return stat;
@@ -1286,9 +1332,59 @@ EffectInstance::getRegionsOfInterest_public(TimeValue inArgsTime,
 
     assert(renderWindow.x2 >= renderWindow.x1 && renderWindow.y2 >= renderWindow.y1);
 
+    // The regions of interest only depend on the node hash: for a node that is not frame varying the results computed
+    // by a previous render at another frame are re-used.
+    // When drawing a paint-stroke, never use the cache because the hash does not change at each render step.
+    bool useCache = !isDuringPaintStrokeCreation();
+
+    U64 hash = 0;
+    if (useCache) {
+        ComputeHashArgs hashArgs;
+        hashArgs.time = time;
+        hashArgs.view = view;
+        hashArgs.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+        hash = computeHash(hashArgs);
+    }
+
+    GetRegionsOfInterestKeyPtr cacheKey;
+    cacheKey.reset(new GetRegionsOfInterestKey(hash, mappedScale, renderWindow, getNode()->getPluginID()));
+
+    GetRegionsOfInterestResultsPtr results = GetRegionsOfInterestResults::create(cacheKey);
+
+    CacheEntryLockerBasePtr cacheAccess;
+    if (useCache) {
+
+        cacheAccess = results->getFromCache();
+
+        CacheEntryLockerBase::CacheEntryStatusEnum cacheStatus = cacheAccess->getStatus();
+        while (cacheStatus == CacheEntryLockerBase::eCacheEntryStatusComputationPending) {
+            cacheStatus = cacheAccess->waitForPendingEntry();
+        }
+
+        if (cacheStatus == CacheEntryLockerBase::eCacheEntryStatusCached) {
+            if (!cacheAccess->isPersistent()) {
+                results = toGetRegionsOfInterestResults(cacheAccess->getProcessLocalEntry());
+            }
+            *ret = results->getRegionsOfInterest();
+            return eActionStatusOK;
+        }
+        assert(cacheStatus == CacheEntryLockerBase::eCacheEntryStatusMustCompute);
+    }
 
- 
-    return getRegionsOfInterest(time, mappedScale, renderWindow, view, ret);
+    ActionRetCodeEnum stat;
+    {
+        RenderStatsActionTimer_RAII statsTimer(this, eRenderStatsActionGetRegionsOfInterest);
+        stat = getRegionsOfInterest(time, mappedScale, renderWindow, view, ret);
+    }
+    if (isFailureRetCode(stat)) {
+        return stat;
+    }
+
+    if (cacheAccess) {
+        results->setRegionsOfInterest(*ret);
+        cacheAccess->insertInCache();
+    }
+    return stat;
 
 } // getRegionsOfInterest_public
 
@@ -571,11 +571,14 @@ EffectInstance::getClosestSupportedBitDepth(ImageBitDepthEnum depth)
     bool foundShort = false;
     bool foundByte = false;
     bool foundFloat = false;
+    bool foundHalf = false;
     for (std::list<ImageBitDepthEnum>::const_iterator it = _imp->common->supportedDepths.begin(); it != _imp->common->supportedDepths.end(); ++it) {
         if (*it == depth) {
             return depth;
         } else if (*it == eImageBitDepthFloat) {
             foundFloat = true;
+        } else if (*it == eImageBitDepthHalf) {
+            foundHalf = true;
         } else if (*it == eImageBitDepthShort) {
             foundShort = true;
         } else if (*it == eImageBitDepthByte) {
@@ -584,6 +587,8 @@ EffectInstance::getClosestSupportedBitDepth(ImageBitDepthEnum depth)
     }
     if (foundFloat) {
         return eImageBitDepthFloat;
+    } else if (foundHalf) {
+        return eImageBitDepthHalf;
     } else if (foundShort) {
         return eImageBitDepthShort;
     } else if (foundByte) {
@@ -601,6 +606,7 @@ EffectInstance::getBestSupportedBitDepth() const
 {
     bool foundShort = false;
     bool foundByte = false;
+    bool foundHalf = false;
 
     for (std::list<ImageBitDepthEnum>::const_iterator it = _imp->common->supportedDepths.begin(); it != _imp->common->supportedDepths.end(); ++it) {
         switch (*it) {
@@ -612,6 +618,7 @@ EffectInstance::getBestSupportedBitDepth() const
                 foundShort = true;
                 break;
             case eImageBitDepthHalf:
+                foundHalf = true;
                 break;
 
             case eImageBitDepthFloat:
@@ -623,7 +630,9 @@ EffectInstance::getBestSupportedBitDepth() const
         }
     }
 
-    if (foundShort) {
+    if (foundHalf) {
+        return eImageBitDepthHalf;
+    } else if (foundShort) {
         return eImageBitDepthShort;
     } else if (foundByte) {
         return eImageBitDepthByte;
@@ -766,7 +775,7 @@ EffectInstance::addUserComponents(const ImagePlaneDesc& comps)
     {
         QMutexLocker k(&_imp->common->createdPlanesMutex);
         for (std::list<ImagePlaneDesc>::iterator it = _imp->common->createdPlanes.begin(); it != _imp->common->createdPlanes.end(); ++it) {
-            if ( it->getPlaneID() == comps.getPlaneID() ) {
+            if ( it->isSamePlane(comps) ) {
                 return false;
             }
         }
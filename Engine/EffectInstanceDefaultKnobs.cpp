@@ -27,10 +27,12 @@
 #include "Engine/AppInstance.h"
 #include "Engine/Backdrop.h"
 #include "Engine/Project.h"
+#include "Engine/Dot.h"
 #include "Engine/FileSystemModel.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/KnobFile.h"
 #include "Engine/GroupInput.h"
+#include "Engine/GroupOutput.h"
 #include "Engine/Node.h"
 #include "Engine/NodeGuiI.h"
 #include "Engine/KnobItemsTable.h"
@@ -335,6 +337,20 @@ EffectInstance::createNodePage(const KnobPagePtr& settingsPage)
         _imp->defKnobs->forceCaching = param;
     }
 
+    if ( dynamic_cast<NodeGroup*>(this) ) {
+        KnobBoolPtr param = createKnob<KnobBool>(kNatronNodeKnobCacheBoundary);
+        param->setLabel(tr(kNatronNodeKnobCacheBoundaryLabel));
+        param->setDeclaredByPlugin(false);
+        param->setDefaultValue(false);
+        param->setAnimationEnabled(false);
+        param->setAddNewLine(false);
+        param->setIsPersistent(true);
+        param->setHintToolTip( tr(kNatronNodeKnobCacheBoundaryHint) );
+        settingsPage->addKnob(param);
+
+        _imp->defKnobs->cacheBoundary = param;
+    }
+
     {
         KnobBoolPtr param = createKnob<KnobBool>(kEnablePreviewKnobName);
         param->setLabel(tr("Preview"));
@@ -574,6 +590,22 @@ EffectInstance::createNodePage(const KnobPagePtr& settingsPage)
             _imp->defKnobs->afterFrameRender = param;
         }
 
+        {
+            KnobBoolPtr param =  createKnob<KnobBool>("afterFrameRenderAsync");
+            param->setLabel(tr("Asynchronous after frame render"));
+            param->setDeclaredByPlugin(false);
+            param->setAnimationEnabled(false);
+            param->setEvaluateOnChange(false);
+            param->setDefaultValue(false);
+            param->setHintToolTip( tr("When checked, the after frame render callback is run on a dedicated thread, in the order the frames "
+                                      "were rendered, so that a slow callback does not stall the render of the next frames.\n"
+                                      "The render only waits for the callback when many frames are already waiting for it to run. "
+                                      "The render is finished once the callbacks of all rendered frames have run.") );
+            settingsPage->addKnob(param);
+
+            _imp->defKnobs->afterFrameRenderAsync = param;
+        }
+
         {
             KnobStringPtr param =  createKnob<KnobString>("afterRender");
             param->setDeclaredByPlugin(false);
@@ -1038,6 +1070,13 @@ EffectInstance::isForceCachingEnabled() const
     return b ? b->getValue() : false;
 }
 
+bool
+EffectInstance::isCacheBoundaryEnabled() const
+{
+    KnobBoolPtr b = _imp->defKnobs->cacheBoundary.lock();
+    return b ? b->getValue() : false;
+}
+
 void
 EffectInstance::setForceCachingEnabled(bool value)
 {
@@ -1218,6 +1257,32 @@ EffectInstance::getDisabledKnobValue() const
     return !enabled;
 }
 
+int
+EffectInstance::getUnconditionalPassThroughInput() const
+{
+    EffectInstancePtr thisShared = boost::const_pointer_cast<EffectInstance>( shared_from_this() );
+    if ( toDot(thisShared) ) {
+        return 0;
+    }
+    GroupOutputPtr isGroupOutput = toGroupOutput(thisShared);
+    if (isGroupOutput) {
+        // The output node of a cache boundary renders a copy of its input
+        return isGroupOutput->isCacheBoundary() ? -1 : 0;
+    }
+
+    // The disabled state may vary with the time, the view, the lifetime or the enclosing group: only
+    // handle the case where the node itself is disabled at all times, the others are handled by isIdentity_public()
+    KnobBoolPtr b = _imp->renderKnobs.disableNodeKnob.lock();
+    if ( !b || b->hasAnimation() || b->hasExpression(DimIdx(0), ViewIdx(0)) || !b->getValue() ) {
+        return -1;
+    }
+    if ( b->getViewsList().size() > 1 ) {
+        return -1;
+    }
+
+    return getNode()->getPreferredInput();
+} // getUnconditionalPassThroughInput
+
 
 void
 EffectInstance::setNodeDisabled(bool disabled)
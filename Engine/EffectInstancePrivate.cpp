@@ -30,6 +30,8 @@
 #include <QDebug>
 
 #include "Engine/AppInstance.h"
+#include "Engine/EffectInstanceActionResults.h"
+#include "Engine/FrameViewRequest.h"
 #include "Engine/Node.h"
 #include "Engine/NodeGroup.h"
 #include "Engine/OSGLContext.h"
@@ -43,6 +45,16 @@
 
 #define kNatronPersistentWarningCheckForNan "NatronPersistentWarningCheckForNan"
 
+// This controls how many frames needed by a plug-in on an input are rendered in the same pass when the plug-in
+// fetches a frame that was not pre-fetched. Their images are held until the plug-in fetches them, hence the limit.
+#define NATRON_MAX_FRAMES_RENDERED_AHEAD 4
+
+// Number of frame/view hashes for which an image was created that are remembered to report the changes of DirtyRegionChange_RAII
+#define NATRON_DIRTY_REGION_MAX_RENDERED_HASHES 16
+
+// Number of images created before the changes reported with DirtyRegionChange_RAII that are remembered for each frame/view
+#define NATRON_DIRTY_REGION_MAX_PREVIOUS_HASHES 4
+
 NATRON_NAMESPACE_ENTER;
 
 
@@ -123,6 +135,212 @@ EffectInstance::Implementation::getTimeInvariantMetadataResults() const
     return renderData->metadataResults;
 }
 
+void
+EffectInstance::Implementation::getInputFramesToRenderAhead(int inputNb, TimeValue inputTime, ViewIdx inputView, std::list<FrameViewPair>* frames)
+{
+    if (!renderData) {
+        return;
+    }
+    GetFramesNeededResultsPtr framesNeededResults;
+    ActionRetCodeEnum stat = _publicInterface->getFramesNeeded_public(_publicInterface->getCurrentRenderTime(), _publicInterface->getCurrentRenderView(), &framesNeededResults);
+    if (isFailureRetCode(stat)) {
+        return;
+    }
+    FramesNeededMap framesNeeded;
+    framesNeededResults->getFramesNeeded(&framesNeeded);
+
+    FramesNeededMap::const_iterator foundInput = framesNeeded.find(inputNb);
+    if (foundInput == framesNeeded.end()) {
+        return;
+    }
+    FrameRangesMap::const_iterator foundView = foundInput->second.find(inputView);
+    if (foundView == foundInput->second.end()) {
+        return;
+    }
+
+    const TimeValue roundedInputTime = roundImageTimeToEpsilon(inputTime);
+
+    QMutexLocker k(&renderData->lock);
+    const FrameViewRequestStrongMap& renderedAhead = renderData->inputRequestsRenderedAhead[inputNb];
+
+    // Only the frames following inputTime are rendered ahead: plug-ins usually fetch their frames in order
+    bool foundInputTime = false;
+    int nFrames = 0;
+    for (std::size_t range = 0; range < foundView->second.size(); ++range) {
+        for (double f = foundView->second[range].min; f <= foundView->second[range].max; f += 1.) {
+            TimeValue time = roundImageTimeToEpsilon(TimeValue(f));
+            if (!foundInputTime) {
+                foundInputTime = time == roundedInputTime;
+                continue;
+            }
+            if (time == roundedInputTime) {
+                continue;
+            }
+            FrameViewPair p = {time, inputView};
+
+            // Skip frames that were requested by the request pass or rendered ahead already
+            if (renderedAhead.find(p) != renderedAhead.end()) {
+                continue;
+            }
+            EffectInstancePtr inputEffect = _publicInterface->getInputRenderEffect(inputNb, time, inputView);
+            if (!inputEffect || inputEffect->isRenderClone()) {
+                continue;
+            }
+            frames->push_back(p);
+            if (++nFrames >= NATRON_MAX_FRAMES_RENDERED_AHEAD) {
+                return;
+            }
+        }
+    }
+} // getInputFramesToRenderAhead
+
+void
+EffectInstance::Implementation::addInputRequestsRenderedAhead(int inputNb, const std::list<FrameViewPair>& frames, const std::list<FrameViewRequestPtr>& requests)
+{
+    if (!renderData) {
+        return;
+    }
+    assert(frames.size() == requests.size());
+    QMutexLocker k(&renderData->lock);
+    FrameViewRequestStrongMap& renderedAhead = renderData->inputRequestsRenderedAhead[inputNb];
+    std::list<FrameViewRequestPtr>::const_iterator itRequest = requests.begin();
+    for (std::list<FrameViewPair>::const_iterator it = frames.begin(); it != frames.end() && itRequest != requests.end(); ++it, ++itRequest) {
+        renderedAhead[*it] = *itRequest;
+    }
+}
+
+FrameViewRequestPtr
+EffectInstance::Implementation::takeInputRequestRenderedAhead(int inputNb, TimeValue inputTime, ViewIdx inputView)
+{
+    if (!renderData) {
+        return FrameViewRequestPtr();
+    }
+    QMutexLocker k(&renderData->lock);
+    std::map<int, FrameViewRequestStrongMap>::iterator foundInput = renderData->inputRequestsRenderedAhead.find(inputNb);
+    if (foundInput == renderData->inputRequestsRenderedAhead.end()) {
+        return FrameViewRequestPtr();
+    }
+    FrameViewPair p = {roundImageTimeToEpsilon(inputTime), inputView};
+    FrameViewRequestStrongMap::iterator found = foundInput->second.find(p);
+    if (found == foundInput->second.end()) {
+        return FrameViewRequestPtr();
+    }
+    FrameViewRequestPtr ret = found->second;
+    foundInput->second.erase(found);
+    return ret;
+}
+
+void
+EffectInstance::Implementation::addRenderedFrameViewHash(TimeValue time, ViewIdx view, U64 hash)
+{
+    FrameViewPair p = {roundImageTimeToEpsilon(time), view};
+    QMutexLocker k(&common->dirtyRegionsMutex);
+    for (std::list<std::pair<FrameViewPair, U64> >::iterator it = common->renderedHashes.begin(); it != common->renderedHashes.end(); ++it) {
+        if ( (it->first.time == p.time) && (it->first.view == p.view) ) {
+            common->renderedHashes.erase(it);
+            break;
+        }
+    }
+    common->renderedHashes.push_front( std::make_pair(p, hash) );
+    if (common->renderedHashes.size() > NATRON_DIRTY_REGION_MAX_RENDERED_HASHES) {
+        common->renderedHashes.pop_back();
+    }
+}
+
+void
+EffectInstance::Implementation::getPreviousFrameViewHashes(TimeValue time, ViewIdx view, U64 currentHash, std::list<std::pair<U64, RectD> >* hashes) const
+{
+    // If anything changed without being reported, the regions are not reliable anymore
+    int unreportedInvalidationsCount = HashableObject::getUnreportedInvalidationsCount();
+    TimeValue roundedTime = roundImageTimeToEpsilon(time);
+    QMutexLocker k(&common->dirtyRegionsMutex);
+    for (std::list<PreviousFrameViewHash>::const_reverse_iterator it = common->previousHashes.rbegin(); it != common->previousHashes.rend(); ++it) {
+        if ( (it->unreportedInvalidationsCount != unreportedInvalidationsCount) ||
+             (it->frameView.time != roundedTime) ||
+             (it->frameView.view != view) ||
+             (it->hash == currentHash) ) {
+            continue;
+        }
+        hashes->push_back( std::make_pair(it->hash, it->dirtyRegion) );
+    }
+}
+
+void
+EffectInstance::Implementation::reportDirtyRegion(TimeValue time, const std::vector<RectD>& perViewRegion, int unreportedInvalidationsCount)
+{
+    QMutexLocker k(&common->dirtyRegionsMutex);
+    if ( perViewRegion.empty() ) {
+        // What changed is not known: no image rendered before can be used anymore
+        common->previousHashes.clear();
+        return;
+    }
+
+    TimeValue roundedTime = roundImageTimeToEpsilon(time);
+
+    // Images of other frames may have changed in an unknown way
+    for (std::list<PreviousFrameViewHash>::iterator it = common->previousHashes.begin(); it != common->previousHashes.end();) {
+        if ( (it->frameView.time != roundedTime) ||
+             (it->unreportedInvalidationsCount != unreportedInvalidationsCount) ||
+             (it->frameView.view < 0) || (it->frameView.view >= (int)perViewRegion.size()) ) {
+            it = common->previousHashes.erase(it);
+        } else {
+            const RectD& region = perViewRegion[it->frameView.view];
+            if ( !region.isNull() ) {
+                if ( it->dirtyRegion.isNull() ) {
+                    it->dirtyRegion = region;
+                } else {
+                    it->dirtyRegion.merge(region);
+                }
+            }
+            ++it;
+        }
+    }
+
+    // Remember the images rendered until now at this frame
+    for (std::list<std::pair<FrameViewPair, U64> >::const_iterator it = common->renderedHashes.begin(); it != common->renderedHashes.end(); ++it) {
+        if ( (it->first.time != roundedTime) || (it->first.view < 0) || (it->first.view >= (int)perViewRegion.size()) ) {
+            continue;
+        }
+        int nHashesForFrameView = 0;
+        bool alreadyPresent = false;
+        for (std::list<PreviousFrameViewHash>::const_iterator it2 = common->previousHashes.begin(); it2 != common->previousHashes.end(); ++it2) {
+            if (it2->frameView.view != it->first.view) {
+                continue;
+            }
+            if (it2->hash == it->second) {
+                alreadyPresent = true;
+                break;
+            }
+            ++nHashesForFrameView;
+        }
+        if (alreadyPresent) {
+            continue;
+        }
+
+        // Keep the oldest image: this is the one most likely to be entirely in the cache. Drop the one after it.
+        if (nHashesForFrameView >= NATRON_DIRTY_REGION_MAX_PREVIOUS_HASHES) {
+            bool foundOldest = false;
+            for (std::list<PreviousFrameViewHash>::iterator it2 = common->previousHashes.begin(); it2 != common->previousHashes.end(); ++it2) {
+                if (it2->frameView.view != it->first.view) {
+                    continue;
+                }
+                if (foundOldest) {
+                    common->previousHashes.erase(it2);
+                    break;
+                }
+                foundOldest = true;
+            }
+        }
+
+        PreviousFrameViewHash p;
+        p.frameView = it->first;
+        p.hash = it->second;
+        p.dirtyRegion = perViewRegion[it->first.view];
+        p.unreportedInvalidationsCount = unreportedInvalidationsCount;
+        common->previousHashes.push_back(p);
+    }
+} // reportDirtyRegion
+
 
 RenderScale
 EffectInstance::getCombinedScale(unsigned int mipMapLevel, const RenderScale& proxyScale)
@@ -291,7 +509,10 @@ EffectInstance::Implementation::tiledRenderingFunctor(const RectToRender & rectT
         _publicInterface->getNode()->clearPersistentMessage(kNatronPersistentErrorGenericRenderMessage);
 
         // Apply post-processing
-        stat = renderHandlerPostProcess(rectToRender, args);
+        {
+            RenderStatsActionTimer_RAII statsTimer(_publicInterface, eRenderStatsActionPostProcess);
+            stat = renderHandlerPostProcess(rectToRender, args);
+        }
         if (isFailureRetCode(stat)) {
             return stat;
         }
@@ -503,7 +724,11 @@ EffectInstance::Implementation::renderHandlerPlugin(const RectToRender & rectToR
                 setupGLForRender<GL_CPU>(osmesaRenderImage, args.glContext, actionArgs.roi, _publicInterface->getNode()->isGLFinishRequiredBeforeRender(), &contextAttacher);
             }
         }
-        ActionRetCodeEnum stat = _publicInterface->render_public(actionArgs);
+        ActionRetCodeEnum stat;
+        {
+            RenderStatsActionTimer_RAII statsTimer(_publicInterface, eRenderStatsActionRender);
+            stat = _publicInterface->render_public(actionArgs);
+        }
 
         if (args.backendType == eRenderBackendTypeOpenGL ||
             args.backendType == eRenderBackendTypeOSMesa) {
@@ -600,27 +825,6 @@ EffectInstance::Implementation::renderHandlerPostProcess(const RectToRender & re
     // Check for NaNs, copy to output image and mark for rendered
     for (std::map<ImagePlaneDesc, ImagePtr>::const_iterator it = args.cachedPlanes.begin(); it != args.cachedPlanes.end(); ++it) {
 
-        if (checkNaNs) {
-
-            if (!it->second->checkForNaNs(rectToRender.rect)) {
-                _publicInterface->getNode()->clearPersistentMessage(kNatronPersistentWarningCheckForNan);
-            } else {
-                QString warning = QString::fromUtf8( _publicInterface->getNode()->getScriptName_mt_safe().c_str() );
-                warning.append( QString::fromUtf8(": ") );
-                warning.append( tr("rendered rectangle (") );
-                warning.append( QString::number(rectToRender.rect.x1) );
-                warning.append( QChar::fromLatin1(',') );
-                warning.append( QString::number(rectToRender.rect.y1) );
-                warning.append( QString::fromUtf8(")-(") );
-                warning.append( QString::number(rectToRender.rect.x2) );
-                warning.append( QChar::fromLatin1(',') );
-                warning.append( QString::number(rectToRender.rect.y2) );
-                warning.append( QString::fromUtf8(") ") );
-                warning.append( tr("contains NaN values. They have been converted to 1.") );
-                _publicInterface->getNode()->setPersistentMessage( eMessageTypeWarning, kNatronPersistentWarningCheckForNan, warning.toStdString() );
-            }
-        } // checkNaNs
-
         ImagePtr mainInputImage;
 
         bool copyUnProcessed = it->second->canCallCopyUnProcessedChannels(processChannels);
@@ -643,23 +847,59 @@ EffectInstance::Implementation::renderHandlerPostProcess(const RectToRender & re
                     }
                 }
             }
-            if (mainInputImage) {
-                ActionRetCodeEnum stat = it->second->copyUnProcessedChannels(rectToRender.rect, processChannels, mainInputImage);
-                if (isFailureRetCode(stat)) {
-                    return stat;
-                }
-            }
         }
-        
 
-        if (useMaskMix) {
+        // When the unprocessed channels are copied and mask/mix is applied, the NaNs are replaced in the same pass
+        const bool fusePostProcess = mainInputImage && useMaskMix;
+
+        std::size_t nNaNs = 0;
+        if (checkNaNs && !fusePostProcess) {
+            nNaNs = it->second->checkForNaNs(rectToRender.rect);
+        }
+
+        if (fusePostProcess) {
+            ActionRetCodeEnum stat = it->second->applyMaskMixAndCopyUnProcessedChannels(rectToRender.rect, processChannels, maskImage, mainInputImage, maskImage.get() /*masked*/, false /*maskInvert*/, mix, checkNaNs ? &nNaNs : 0);
+            if (isFailureRetCode(stat)) {
+                return stat;
+            }
+        } else if (mainInputImage) {
+            ActionRetCodeEnum stat = it->second->copyUnProcessedChannels(rectToRender.rect, processChannels, mainInputImage);
+            if (isFailureRetCode(stat)) {
+                return stat;
+            }
+        } else if (useMaskMix) {
             ActionRetCodeEnum stat = it->second->applyMaskMix(rectToRender.rect, maskImage, mainInputImage, maskImage.get() /*masked*/, false /*maskInvert*/, mix);
             if (isFailureRetCode(stat)) {
                 return stat;
             }
         }
 
-        
+        if (checkNaNs) {
+
+            if (nNaNs == 0) {
+                _publicInterface->getNode()->clearPersistentMessage(kNatronPersistentWarningCheckForNan);
+            } else {
+                QString warning = QString::fromUtf8( _publicInterface->getNode()->getScriptName_mt_safe().c_str() );
+                warning.append( QString::fromUtf8(": ") );
+                warning.append( tr("rendered rectangle (") );
+                warning.append( QString::number(rectToRender.rect.x1) );
+                warning.append( QChar::fromLatin1(',') );
+                warning.append( QString::number(rectToRender.rect.y1) );
+                warning.append( QString::fromUtf8(")-(") );
+                warning.append( QString::number(rectToRender.rect.x2) );
+                warning.append( QChar::fromLatin1(',') );
+                warning.append( QString::number(rectToRender.rect.y2) );
+                warning.append( QString::fromUtf8(") ") );
+                warning.append( tr("contains NaN values. They have been converted to 1.") );
+                _publicInterface->getNode()->setPersistentMessage( eMessageTypeWarning, kNatronPersistentWarningCheckForNan, warning.toStdString() );
+
+                RenderStatsPtr stats = _publicInterface->getCurrentRender()->getStatsObject();
+                if (stats) {
+                    stats->addNaNsReplacedForNode(_publicInterface->getNode(), nNaNs);
+                }
+            }
+        } // checkNaNs
+
     } // for each plane to render
     return eActionStatusOK;
 } // renderHandlerPostProcess
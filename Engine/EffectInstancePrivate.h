@@ -128,10 +128,12 @@ struct DefaultKnobs
     KnobStringWPtr nodeInfos;
     KnobButtonWPtr refreshInfoButton;
     KnobBoolWPtr forceCaching;
+    KnobBoolWPtr cacheBoundary;
     KnobBoolWPtr hideInputs;
     KnobStringWPtr beforeFrameRender;
     KnobStringWPtr beforeRender;
     KnobStringWPtr afterFrameRender;
+    KnobBoolWPtr afterFrameRenderAsync;
     KnobStringWPtr afterRender;
     KnobBoolWPtr enabledChan[4];
     KnobStringWPtr premultWarning;
@@ -204,6 +206,24 @@ struct DynamicProperties
 };
 
 // Data shared accross all clones
+/**
+ * @brief A frame/view hash of the effect for which an image was created in the cache before a change reported with
+ * EffectInstance::DirtyRegionChange_RAII. The tiles of this image outside of dirtyRegion are still valid for the current hash.
+ **/
+struct PreviousFrameViewHash
+{
+    FrameViewPair frameView;
+
+    U64 hash;
+
+    // The union of the regions of the output of the effect which changed since the image was created, in canonical coordinates
+    RectD dirtyRegion;
+
+    // The value of HashableObject::getUnreportedInvalidationsCount() when the first change was reported:
+    // if it changed, a change was not accounted for in dirtyRegion
+    int unreportedInvalidationsCount;
+};
+
 struct EffectInstanceCommonData
 {
     mutable QMutex attachedContextsMutex;
@@ -260,6 +280,15 @@ struct EffectInstanceCommonData
     // Active interacts, only accessed on the main thread
     std::list<OverlayInteractBasePtr> interacts;
 
+    // Protects renderedHashes and previousHashes
+    mutable QMutex dirtyRegionsMutex;
+
+    // The last frame/view hashes for which an image was created in the cache, most recent first
+    std::list<std::pair<FrameViewPair, U64> > renderedHashes;
+
+    // The hashes rendered before the changes reported with DirtyRegionChange_RAII, oldest first
+    std::list<PreviousFrameViewHash> previousHashes;
+
 
     EffectInstanceCommonData()
     : attachedContextsMutex(QMutex::Recursive)
@@ -278,6 +307,9 @@ struct EffectInstanceCommonData
     , accumBufferMutex()
     , accumBuffer()
     , interacts()
+    , dirtyRegionsMutex()
+    , renderedHashes()
+    , previousHashes()
     {
 
     }
@@ -285,6 +317,7 @@ struct EffectInstanceCommonData
 };
 
 typedef std::map<FrameViewPair, EffectInstanceWPtr, FrameView_compare_less> FrameViewEffectMap;
+typedef std::map<FrameViewPair, FrameViewRequestPtr, FrameView_compare_less> FrameViewRequestStrongMap;
 
 struct FrameViewKey
 {
@@ -351,6 +384,10 @@ struct RenderCloneData
     // All requests made on the clone
     FrameViewRequestMap requests;
 
+    // For each input, the requests of the frames rendered ahead of the getImage calls of the plug-in,
+    // see EffectInstance::getImagePlane(). They are held until fetched, otherwise the image might be released before.
+    std::map<int, FrameViewRequestStrongMap> inputRequestsRenderedAhead;
+
     // The results of the get frame range action for this render
     GetFrameRangeResultsPtr frameRangeResults;
 
@@ -366,6 +403,7 @@ struct RenderCloneData
     , mainInstanceInputs()
     , renderInputs()
     , requests()
+    , inputRequestsRenderedAhead()
     , frameRangeResults()
     , metadataResults()
     , props()
@@ -377,6 +415,8 @@ struct RenderCloneData
 
 };
 
+class PlaneRequestsRenderedTogether_RAII;
+
 class EffectInstance::Implementation
 {
     Q_DECLARE_TR_FUNCTIONS(EffectInstance)
@@ -442,6 +482,23 @@ public:
      * @brief Get the results of the getFrameRange action for this render
      **/
     GetTimeInvariantMetadataResultsPtr getTimeInvariantMetadataResults() const;
+
+    /**
+     * @brief Appends to frames the frames needed by this effect on the given input after inputTime,
+     * that were neither requested by the request pass nor already rendered ahead, up to
+     * NATRON_MAX_FRAMES_RENDERED_AHEAD frames.
+     **/
+    void getInputFramesToRenderAhead(int inputNb, TimeValue inputTime, ViewIdx inputView, std::list<FrameViewPair>* frames);
+
+    /**
+     * @brief Holds the requests of the given input frames rendered ahead until they are fetched with takeInputRequestRenderedAhead()
+     **/
+    void addInputRequestsRenderedAhead(int inputNb, const std::list<FrameViewPair>& frames, const std::list<FrameViewRequestPtr>& requests);
+
+    /**
+     * @brief Returns the request of the given input frame if it was rendered ahead and releases it.
+     **/
+    FrameViewRequestPtr takeInputRequestRenderedAhead(int inputNb, TimeValue inputTime, ViewIdx inputView);
     
 
     /**
@@ -477,6 +534,47 @@ public:
                                           const RectD& canonicalRoi,
                                           bool *concatenated);
 
+    /**
+     * @brief Helper function in the implementation of renderRoI to handle colour effects that can concatenate,
+     * see EffectInstance::getColorMatrix_public
+     **/
+    ActionRetCodeEnum handleColorConcatenation(const RequestPassSharedDataPtr& requestPassSharedData,
+                                               const FrameViewRequestPtr& requestData,
+                                               const FrameViewRequestPtr& requester,
+                                               const RenderScale& renderScale,
+                                               const RectD& canonicalRoi,
+                                               bool *concatenated);
+
+    /**
+     * @brief Helper function in the implementation of renderRoI to render once per render the effects that produce the same image,
+     * see TreeRender::getOrRegisterIdenticalRequest
+     **/
+    ActionRetCodeEnum handleIdenticalRequest(const RequestPassSharedDataPtr& requestPassSharedData,
+                                             const FrameViewRequestPtr& requestData,
+                                             const RectD& canonicalRoi,
+                                             bool *isIdentical);
+
+    /**
+     * @brief Returns true if the given request may subscribe to the requests of other renders producing the same image
+     * and may be registered for them, see TreeRender::getInFlightRequest
+     **/
+    bool canShareRequestWithOtherRenders(const FrameViewRequestPtr& requestData,
+                                         CacheAccessModeEnum cachePolicy,
+                                         U64* nodeFrameViewHash);
+
+    /**
+     * @brief Helper function in the implementation of renderRoI: if another render is going to render the same image,
+     * subscribe to its request instead of rendering it again, see TreeRender::getInFlightRequest
+     **/
+    void handleInFlightRequest(U64 nodeFrameViewHash,
+                               const FrameViewRequestPtr& requestData,
+                               bool *subscribed);
+
+    /**
+     * @brief Called in launchRender for a request that subscribed to the request of another render in handleInFlightRequest():
+     * waits for the results of the other render. If it does not render the image, the image is rendered by a new render.
+     **/
+    ActionRetCodeEnum fetchInFlightRequestResults(const FrameViewRequestPtr& requestData);
 
    
     /**
@@ -497,6 +595,22 @@ public:
                                                  const RectD& roi,
                                                  const std::map<int, std::list<ImagePlaneDesc> >& neededInputLayers);
 
+    /**
+     * @brief Claims the other requests of planes on this render clone which can be rendered by the render
+     * action of requestData, so that a multi-planar effect renders the planes requested together in a single action.
+     **/
+    void claimPlaneRequestsToRenderTogether(const RequestPassSharedDataPtr& requestPassSharedData,
+                                            const FrameViewRequestPtr& requestData,
+                                            const std::list<ImagePlaneDesc>& producedPlanes,
+                                            PlaneRequestsRenderedTogether_RAII* planeRequests);
+
+    /**
+     * @brief Returns the planes requested on this render clone by the render at the scale of requestData,
+     * i.e: the planes needed downstream.
+     **/
+    void getPlanesRequestedInRender(const FrameViewRequestPtr& requestData,
+                                    std::list<ImagePlaneDesc>* planes) const;
+
 
     bool canSplitRenderWindowWithIdentityRectangles(const RenderScale& renderMappedScale,
                                                     RectD* inputRoDIntersection);
@@ -505,6 +619,24 @@ public:
 
     static StorageModeEnum storageModeFromBackendType(RenderBackendTypeEnum backend);
 
+    /**
+     * @brief Remembers that an image of the effect was created in the cache for the given frame/view hash, see DirtyRegionChange_RAII
+     **/
+    void addRenderedFrameViewHash(TimeValue time, ViewIdx view, U64 hash);
+
+    /**
+     * @brief Returns the hashes of the images of the effect created at the given frame/view before the changes reported since,
+     * most recent first, with the region in canonical coordinates which changed since each of them.
+     **/
+    void getPreviousFrameViewHashes(TimeValue time, ViewIdx view, U64 currentHash, std::list<std::pair<U64, RectD> >* hashes) const;
+
+    /**
+     * @brief Called by DirtyRegionChange_RAII for each effect invalidated by a change at the given time.
+     * perViewRegion contains for each view the region of the output of the effect which changed,
+     * or is empty if it is not known.
+     **/
+    void reportDirtyRegion(TimeValue time, const std::vector<RectD>& perViewRegion, int unreportedInvalidationsCount);
+
     ImagePtr createCachedImage(const RectI& roiPixels,
                                const std::vector<RectI>& perMipMapPixelRoD,
                                unsigned int mappedMipMapLevel,
@@ -28,12 +28,19 @@
 #include <map>
 #include <sstream>
 #include <algorithm> // min, max
+#include <cmath>
 #include <fstream>
 #include <cassert>
 #include <stdexcept>
 #include <sstream> // stringstream
 
+#if defined(__NATRON_LINUX__) || defined(__FreeBSD__)
+#include <fcntl.h> // posix_fadvise
+#include <unistd.h>
+#endif
+
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/make_shared.hpp>
 #include <boost/scoped_ptr.hpp>
 #endif
 
@@ -50,6 +57,8 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #endif
 
+#include <ofxNatron.h>
+
 #include "Global/QtCompat.h"
 
 #include "Engine/AppInstance.h"
@@ -61,6 +70,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/Cache.h"
 #include "Engine/CacheEntryBase.h"
 #include "Engine/CacheEntryKeyBase.h"
+#include "Engine/ColorMatrix.h"
 #include "Engine/Image.h"
 #include "Engine/ImageCacheEntry.h"
 #include "Engine/KnobFile.h"
@@ -77,6 +87,8 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/GPUContextPool.h"
 #include "Engine/PluginMemory.h"
 #include "Engine/Project.h"
+#include "Engine/ReadNode.h"
+#include "Engine/RenderArena.h"
 #include "Engine/RenderStats.h"
 #include "Engine/RotoDrawableItem.h"
 #include "Engine/RotoShapeRenderNode.h"
@@ -98,9 +110,62 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 // do not all stick altogether in memory
 #define NATRON_MAX_FRAMES_NEEDED_PRE_FETCHING 3
 
+// Plug-ins that do not support tiles but let the host split the render window (host frame threading)
+// are rendered by horizontal stripes of at most this amount of pixels, so that the buffers they allocate
+// for a render call stay bounded on large formats
+#define NATRON_NON_TILED_RENDER_STRIPE_MAX_PIXELS 4194304
+
+// Interactive renders (i.e: not playback nor render on disk) of tiled plug-ins are split in blocks of about this size in pixels,
+// rendered from the center of the RoI outwards
+#define NATRON_INTERACTIVE_RENDER_BLOCK_SIZE 256
+
+// The inputs RoI of a block extend beyond the block by the size of the kernel of the effect (e.g: the radius of a blur), and the
+// inputs RoIs of neighbouring blocks overlap: the overlapping input pixels are rendered and converted again for each block.
+// The interactive render blocks are enlarged so that their inputs RoI is at most this many times as wide and as high as the block
+#define NATRON_RENDER_BLOCK_MAX_ROI_EXPANSION 2
+
 NATRON_NAMESPACE_ENTER;
 
 
+/**
+ * @brief Releases from the system page cache the pages of the file decoded by the given reader at the current render time and view.
+ * Once decoded, the image is in the cache: keeping the file in the page cache too would double the memory used by each frame.
+ * The reader plug-ins do their own I/O so their reads cannot be unbuffered, but the advice applies to the file for all processes.
+ **/
+static void
+dropReadFileFromSystemCache(EffectInstance* reader)
+{
+#if defined(__NATRON_LINUX__) || defined(__FreeBSD__)
+    NodePtr node = reader->getNode();
+    if ( ReadNode::isVideoReader( node->getPluginID() ) ) {
+        // The frames of a video are all in the same file: keep it for the next frames
+        return;
+    }
+    KnobFilePtr fileKnob = toKnobFile( node->getKnobByName(kOfxImageEffectFileParamName) );
+    if (!fileKnob) {
+        return;
+    }
+
+    // The frame of the sequence, before the time offset of the reader
+    TimeValue fileTime = reader->getCurrentRenderTime();
+    KnobIntPtr timeOffsetKnob = toKnobInt( node->getKnobByName("timeOffset") );
+    if (timeOffsetKnob) {
+        fileTime = TimeValue(fileTime - timeOffsetKnob->getValue());
+    }
+    std::string filePath = fileKnob->getValueAtTime(fileTime, DimIdx(0), reader->getCurrentRenderView());
+    reader->getApp()->getProject()->canonicalizePath(filePath);
+
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return;
+    }
+    ignore_result( ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) );
+    ::close(fd);
+#else
+    Q_UNUSED(reader);
+#endif
+} // dropReadFileFromSystemCache
+
 /**
  * @brief This function determines the planes to render and calls recursively on upstream nodes unavailable planes
  **/
@@ -230,7 +295,12 @@ EffectInstance::Implementation::handleIdentityEffect(double par,
         }
 
         FrameViewRequestPtr createdRequest;
-        return _publicInterface->requestRender(inputTimeIdentity, inputIdentityView, requestData->getProxyScale(), requestData->getMipMapLevel(), identityPlane, canonicalRoi, -1, requestData, requestPassSharedData, &createdRequest, 0);
+        ActionRetCodeEnum stat = _publicInterface->requestRender(inputTimeIdentity, inputIdentityView, requestData->getProxyScale(), requestData->getMipMapLevel(), identityPlane, canonicalRoi, -1, requestData, requestPassSharedData, &createdRequest, 0);
+        if (!isFailureRetCode(stat) && createdRequest) {
+            // The colour matrix of a concatenated colour effect upstream still has to be applied downstream
+            requestData->setColorMatrix(createdRequest->getColorMatrix());
+        }
+        return stat;
 
     } else {
         assert(inputNbIdentity != -1);
@@ -240,11 +310,183 @@ EffectInstance::Implementation::handleIdentityEffect(double par,
         }
 
         FrameViewRequestPtr createdRequest;
-        return identityInput->requestRender(inputTimeIdentity, inputIdentityView, requestData->getProxyScale(), requestData->getMipMapLevel(), identityPlane, canonicalRoi, inputNbIdentity, requestData, requestPassSharedData, &createdRequest, 0);
+        ActionRetCodeEnum stat = identityInput->requestRender(inputTimeIdentity, inputIdentityView, requestData->getProxyScale(), requestData->getMipMapLevel(), identityPlane, canonicalRoi, inputNbIdentity, requestData, requestPassSharedData, &createdRequest, 0);
+        if (!isFailureRetCode(stat) && createdRequest) {
+            requestData->setColorMatrix(createdRequest->getColorMatrix());
+        }
+        return stat;
 
     }
 } // EffectInstance::Implementation::handleIdentityEffect
 
+/**
+ * @brief Returns the hash identifying the image of the effect at its current render time/view in the cache:
+ * effects with the same hash produce the same image
+ **/
+static U64
+getCurrentFrameViewHash(EffectInstance* effect)
+{
+    HashableObject::ComputeHashArgs args;
+    args.time = effect->getCurrentRenderTime();
+    args.view = effect->getCurrentRenderView();
+    args.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+
+    return effect->computeHash(args);
+}
+
+ActionRetCodeEnum
+EffectInstance::Implementation::handleIdenticalRequest(const RequestPassSharedDataPtr& requestPassSharedData,
+                                                       const FrameViewRequestPtr& requestData,
+                                                       const RectD& canonicalRoi,
+                                                       bool *isIdentical)
+{
+    *isIdentical = false;
+
+    // When the cache is by-passed each effect must render.
+    // The render of a writer has side effects and an accumulating effect renders on top of its previous image: they always render.
+    TreeRenderPtr render = _publicInterface->getCurrentRender();
+    if ( render->isByPassCacheEnabled() || _publicInterface->isWriter() || _publicInterface->isAccumulationEnabled() ) {
+        return eActionStatusOK;
+    }
+
+    U64 nodeFrameViewHash = getCurrentFrameViewHash(_publicInterface);
+    FrameViewRequestPtr identicalRequest = render->getOrRegisterIdenticalRequest(nodeFrameViewHash, requestData);
+    if (!identicalRequest) {
+        return eActionStatusOK;
+    }
+
+    // Render the identical request instead and copy its results, as for identity effects
+    EffectInstancePtr identicalEffect = identicalRequest->getEffect();
+    EffectInstancePtr identicalMainInstance = toEffectInstance( identicalEffect->getMainInstance() );
+    if (!identicalMainInstance) {
+        identicalMainInstance = identicalEffect;
+    }
+
+    *isIdentical = true;
+
+    FrameViewRequestPtr createdRequest;
+    ActionRetCodeEnum stat = identicalMainInstance->requestRender(identicalEffect->getCurrentRenderTime(), identicalEffect->getCurrentRenderView(), requestData->getProxyScale(), requestData->getMipMapLevel(), identicalRequest->getPlaneDesc(), canonicalRoi, -1, requestData, requestPassSharedData, &createdRequest, 0);
+    if (!isFailureRetCode(stat) && createdRequest) {
+        requestData->setColorMatrix(createdRequest->getColorMatrix());
+    }
+    return stat;
+} // EffectInstance::Implementation::handleIdenticalRequest
+
+bool
+EffectInstance::Implementation::canShareRequestWithOtherRenders(const FrameViewRequestPtr& requestData,
+                                                                CacheAccessModeEnum cachePolicy,
+                                                                U64* nodeFrameViewHash)
+{
+    // Only images rendered on the CPU can be used by other renders. As for identical requests, writers and
+    // accumulating effects always render and every effect renders when the cache is by-passed.
+    // Images on which a colour matrix remains to be applied are modified at the end of the render.
+    TreeRenderPtr render = _publicInterface->getCurrentRender();
+    if ( (cachePolicy == eCacheAccessModeNone) || render->isByPassCacheEnabled() || _publicInterface->isWriter() || requestData->getColorMatrix() ) {
+        return false;
+    }
+    *nodeFrameViewHash = getCurrentFrameViewHash(_publicInterface);
+
+    return true;
+}
+
+void
+EffectInstance::Implementation::handleInFlightRequest(U64 nodeFrameViewHash,
+                                                      const FrameViewRequestPtr& requestData,
+                                                      bool *subscribed)
+{
+    *subscribed = false;
+    requestData->setInFlightRequest(FrameViewRequestPtr());
+
+    // A request which already has images was rendered by this render and is being rendered again for a larger RoI
+    if ( (requestData->getStatus() != FrameViewRequest::eFrameViewRequestStatusNotRendered) || requestData->getFullscaleImagePlane() ) {
+        return;
+    }
+
+    TreeRenderPtr render = _publicInterface->getCurrentRender();
+    FrameViewRequestPtr inFlightRequest = render->getInFlightRequest(nodeFrameViewHash, requestData);
+    if (!inFlightRequest) {
+        return;
+    }
+
+    // The other request must render at least the portion we need, on the CPU and without a colour matrix to apply
+    if ( (inFlightRequest->getCachePolicy() == eCacheAccessModeNone) ||
+         inFlightRequest->getColorMatrix() ||
+         !inFlightRequest->getCurrentRoI().contains( requestData->getCurrentRoI() ) ) {
+        return;
+    }
+    if ( (inFlightRequest->getStatus() == FrameViewRequest::eFrameViewRequestStatusRendered) && isFailureRetCode( inFlightRequest->waitForPendingResults() ) ) {
+        return;
+    }
+
+    // The inputs are not requested: the image is taken from the other request in launchRender
+    requestData->setInFlightRequest(inFlightRequest);
+    *subscribed = true;
+} // handleInFlightRequest
+
+ActionRetCodeEnum
+EffectInstance::Implementation::fetchInFlightRequestResults(const FrameViewRequestPtr& requestData)
+{
+    FrameViewRequestPtr inFlightRequest = requestData->getInFlightRequest();
+    assert(inFlightRequest);
+
+    ActionRetCodeEnum stat = requestData->waitForInFlightRequestResults();
+    requestData->setInFlightRequest(FrameViewRequestPtr());
+    if ( _publicInterface->isRenderAborted() ) {
+        return eActionStatusAborted;
+    }
+
+    ImagePtr image;
+    if ( !isFailureRetCode(stat) ) {
+        image = inFlightRequest->getRequestedScaleImagePlane();
+    }
+    if (!image) {
+        // The other render was aborted or did not render the image. The inputs were not requested in this render,
+        // so render the image with a render of its own.
+        TreeRenderPtr currentRender = _publicInterface->getCurrentRender();
+        EffectInstancePtr mainInstance = toEffectInstance( _publicInterface->getMainInstance() );
+        if (!mainInstance) {
+            return eActionStatusFailed;
+        }
+        ImagePlaneDesc plane = requestData->getPlaneDesc();
+        RectD roi = requestData->getCurrentRoI();
+
+        TreeRender::CtorArgsPtr rargs(new TreeRender::CtorArgs);
+        rargs->treeRootEffect = mainInstance;
+        rargs->time = _publicInterface->getCurrentRenderTime();
+        rargs->view = _publicInterface->getCurrentRenderView();
+        rargs->proxyScale = requestData->getProxyScale();
+        rargs->mipMapLevel = requestData->getMipMapLevel();
+        rargs->plane = &plane;
+        rargs->canonicalRoI = &roi;
+        rargs->stats = currentRender->getStatsObject();
+        rargs->draftMode = currentRender->isDraftRender();
+        rargs->playback = currentRender->isPlayback();
+        rargs->byPassCache = false;
+        rargs->priority = currentRender->getPriority();
+
+        TreeRenderPtr render = TreeRender::create(rargs);
+        if (!render) {
+            return eActionStatusFailed;
+        }
+        FrameViewRequestPtr outputRequest;
+        stat = render->launchRender(&outputRequest);
+        if ( isFailureRetCode(stat) ) {
+            return stat;
+        }
+        if (outputRequest) {
+            image = outputRequest->getRequestedScaleImagePlane();
+        }
+        if (!image) {
+            return eActionStatusFailed;
+        }
+    }
+
+    requestData->setRequestedScaleImagePlane(image);
+    requestData->setFullscaleImagePlane(image);
+
+    return eActionStatusOK;
+} // fetchInFlightRequestResults
+
 ActionRetCodeEnum
 EffectInstance::Implementation::handleConcatenation(const RequestPassSharedDataPtr& requestPassSharedData,
                                                     const FrameViewRequestPtr& requestData,
@@ -347,11 +589,79 @@ EffectInstance::Implementation::handleConcatenation(const RequestPassSharedDataP
     // Set the stack on the frame view request
     requestData->setDistorsionStack(distoStack);
 
+    // The colour matrix of a concatenated colour effect upstream still has to be applied downstream
+    requestData->setColorMatrix(inputRequest->getColorMatrix());
+
     *concatenated = true;
 
     return eActionStatusOK;
 } // handleConcatenation
 
+ActionRetCodeEnum
+EffectInstance::Implementation::handleColorConcatenation(const RequestPassSharedDataPtr& requestPassSharedData,
+                                                         const FrameViewRequestPtr& requestData,
+                                                         const FrameViewRequestPtr& requester,
+                                                         const RenderScale& renderScale,
+                                                         const RectD& canonicalRoi,
+                                                         bool *concatenated)
+{
+    *concatenated = false;
+
+    // The matrix is applied when the image is fetched by the effect downstream: the tree root has nobody to apply it.
+    // The matrix is only applied on the CPU.
+    TreeRenderPtr render = _publicInterface->getCurrentRender();
+    if ( !requester || !render->isConcatenationEnabled() || render->getGPUOpenGLContext() ) {
+        return eActionStatusOK;
+    }
+    if ( !requestData->getPlaneDesc().isColorPlane() ) {
+        return eActionStatusOK;
+    }
+
+    ColorMatrix matrix;
+    {
+        ActionRetCodeEnum stat = _publicInterface->getColorMatrix_public(_publicInterface->getCurrentRenderTime(), renderScale, _publicInterface->getCurrentRenderView(), &matrix);
+        if (isFailureRetCode(stat)) {
+            return stat;
+        }
+        if (stat == eActionStatusReplyDefault) {
+            return eActionStatusOK;
+        }
+    }
+
+    EffectInstancePtr colorInput = _publicInterface->getInputMainInstance(matrix.inputNbToTransform);
+    if (!colorInput) {
+        return eActionStatusInputDisconnected;
+    }
+
+    FrameViewRequestPtr inputRequest;
+    {
+        ActionRetCodeEnum stat = colorInput->requestRender(_publicInterface->getCurrentRenderTime(), _publicInterface->getCurrentRenderView(), requestData->getProxyScale(), requestData->getMipMapLevel(), requestData->getPlaneDesc(), canonicalRoi, matrix.inputNbToTransform, requestData, requestPassSharedData, &inputRequest, 0);
+        if (isFailureRetCode(stat)) {
+            return stat;
+        }
+    }
+
+    // The colour must be applied after the distortions concatenated upstream, which only this effect may receive:
+    // render normally in that case.
+    if ( !inputRequest || inputRequest->getDistorsionStack() ) {
+        return eActionStatusOK;
+    }
+
+    // Fold the matrix with the ones of the colour effects upstream
+    ColorMatrixPtr product;
+    ColorMatrixPtr upstreamMatrix = inputRequest->getColorMatrix();
+    if (upstreamMatrix) {
+        product.reset( new ColorMatrix( ColorMatrix::concatenate(matrix, *upstreamMatrix) ) );
+    } else {
+        product.reset( new ColorMatrix(matrix) );
+    }
+    requestData->setColorMatrix(product);
+
+    *concatenated = true;
+
+    return eActionStatusOK;
+} // handleColorConcatenation
+
 ActionRetCodeEnum
 EffectInstance::Implementation::lookupCachedImage(unsigned int mipMapLevel,
                                                   const RenderScale& proxyScale,
@@ -364,6 +674,7 @@ EffectInstance::Implementation::lookupCachedImage(unsigned int mipMapLevel,
                                                   bool* hasPendingTiles,
                                                   bool* hasUnrenderedTiles)
 {
+    RenderStatsActionTimer_RAII statsTimer(_publicInterface, eRenderStatsActionCacheLookup);
     if (!*image) {
         *image = createCachedImage(pixelRoi, perMipMapPixelRoD, mipMapLevel, proxyScale, plane, backend, cachePolicy, true /*delayAllocation*/);
     } else {
@@ -456,6 +767,125 @@ EffectInstance::Implementation::canSplitRenderWindowWithIdentityRectangles(const
     return false;
 } // canSplitRenderWindowWithIdentityRectangles
 
+struct RenderBlock_CompareDistance
+{
+    bool operator() (const std::pair<double, RectI>& lhs, const std::pair<double, RectI>& rhs) const
+    {
+        return lhs.first < rhs.first;
+    }
+};
+
+/**
+ * @brief Splits the given rectangles in blocks aligned on a grid of blockSizeX x blockSizeY pixels and sorts the blocks by
+ * increasing distance of their center to the center of the roi.
+ **/
+static void
+splitRectsInBlocksFromCenter(const std::list<RectI>& rects,
+                             const RectI& roi,
+                             int blockSizeX,
+                             int blockSizeY,
+                             std::list<RectI>* blocks)
+{
+    double centerX = (roi.x1 + roi.x2) / 2.;
+    double centerY = (roi.y1 + roi.y2) / 2.;
+
+    std::vector<std::pair<double, RectI> > sortedBlocks;
+    for (std::list<RectI>::const_iterator it = rects.begin(); it != rects.end(); ++it) {
+        int gridX1 = (int)std::floor( (double)it->x1 / blockSizeX ) * blockSizeX;
+        int gridY1 = (int)std::floor( (double)it->y1 / blockSizeY ) * blockSizeY;
+        for (int y = gridY1; y < it->y2; y += blockSizeY) {
+            for (int x = gridX1; x < it->x2; x += blockSizeX) {
+                RectI block( std::max(x, it->x1), std::max(y, it->y1), std::min(x + blockSizeX, it->x2), std::min(y + blockSizeY, it->y2) );
+                if ( block.isNull() ) {
+                    continue;
+                }
+                double dx = (block.x1 + block.x2) / 2. - centerX;
+                double dy = (block.y1 + block.y2) / 2. - centerY;
+                sortedBlocks.push_back( std::make_pair(dx * dx + dy * dy, block) );
+            }
+        }
+    }
+    std::stable_sort( sortedBlocks.begin(), sortedBlocks.end(), RenderBlock_CompareDistance() );
+
+    blocks->clear();
+    for (std::size_t i = 0; i < sortedBlocks.size(); ++i) {
+        blocks->push_back(sortedBlocks[i].second);
+    }
+} // splitRectsInBlocksFromCenter
+
+/**
+ * @brief Returns in pixels how much the inputs RoIs of the effect grow on each side of the given render window, e.g: the radius
+ * of a blur. Inputs RoIs that are only offset from the render window (e.g: a translation) do not overlap between neighbouring
+ * windows and do not count.
+ **/
+static void
+getInputsRoIExpansion(EffectInstance* effect,
+                      const RectI& renderWindow,
+                      const RenderScale& scale,
+                      int* expansionX,
+                      int* expansionY)
+{
+    *expansionX = 0;
+    *expansionY = 0;
+
+    TimeValue time = effect->getCurrentRenderTime();
+    ViewIdx view = effect->getCurrentRenderView();
+
+    RectD rod;
+    {
+        GetRegionOfDefinitionResultsPtr results;
+        ActionRetCodeEnum stat = effect->getRegionOfDefinition_public(time, scale, view, &results);
+        if (isFailureRetCode(stat)) {
+            return;
+        }
+        rod = results->getRoD();
+    }
+
+    double par = effect->getAspectRatio(-1);
+    RectD renderWindowCanonical;
+    renderWindow.toCanonical(scale, par, rod, &renderWindowCanonical);
+
+    RoIMap inputsRoi;
+    {
+        ActionRetCodeEnum stat = effect->getRegionsOfInterest_public(time, scale, renderWindowCanonical, view, &inputsRoi);
+        if (isFailureRetCode(stat)) {
+            return;
+        }
+    }
+
+    double expansionXCanonical = 0., expansionYCanonical = 0.;
+    for (RoIMap::const_iterator it = inputsRoi.begin(); it != inputsRoi.end(); ++it) {
+        if ( it->second.isNull() || it->second.isInfinite() ) {
+            continue;
+        }
+        expansionXCanonical = std::max( expansionXCanonical, (it->second.width() - renderWindowCanonical.width()) / 2. );
+        expansionYCanonical = std::max( expansionYCanonical, (it->second.height() - renderWindowCanonical.height()) / 2. );
+    }
+    *expansionX = (int)std::ceil(expansionXCanonical * scale.x / par);
+    *expansionY = (int)std::ceil(expansionYCanonical * scale.y);
+} // getInputsRoIExpansion
+
+/**
+ * @brief Returns the number of blocks of blockSizeX x blockSizeY pixels aligned on their grid that intersect the given rectangles
+ **/
+static std::size_t
+getNumBlocks(const std::list<RectI>& rects,
+             int blockSizeX,
+             int blockSizeY)
+{
+    std::size_t nBlocks = 0;
+    for (std::list<RectI>::const_iterator it = rects.begin(); it != rects.end(); ++it) {
+        if ( it->isNull() ) {
+            continue;
+        }
+        std::size_t nX = (int)std::ceil( (double)it->x2 / blockSizeX ) - (int)std::floor( (double)it->x1 / blockSizeX );
+        std::size_t nY = (int)std::ceil( (double)it->y2 / blockSizeY ) - (int)std::floor( (double)it->y1 / blockSizeY );
+        nBlocks += nX * nY;
+    }
+
+    return nBlocks;
+} // getNumBlocks
+
 ActionRetCodeEnum
 EffectInstance::Implementation::checkRestToRender(bool updateTilesStateFromCache,
                                                   const FrameViewRequestPtr& requestData,
@@ -524,10 +954,28 @@ EffectInstance::Implementation::checkRestToRender(bool updateTilesStateFromCache
     if (!_publicInterface->getCurrentSupportTiles()) {
         // If not using the cache, render the full RoI
         // The RoI has already been set to the pixelRoD in this case
-        RectToRender r;
-        r.rect = renderMappedRoI;
-        r.identityInputNumber = -1;
-        renderRects->push_back(r);
+        if ( (_publicInterface->getCurrentRenderThreadSafety() != eRenderSafetyFullySafeFrame) || renderMappedRoI.isNull() ) {
+            RectToRender r;
+            r.rect = renderMappedRoI;
+            r.identityInputNumber = -1;
+            renderRects->push_back(r);
+            return eActionStatusOK;
+        }
+
+        // The plug-in lets the host render any part of the render window independently: render horizontal stripes,
+        // at least one per thread. The images still cover the full RoD since the plug-in does not support tiles.
+        int height = renderMappedRoI.height();
+        int nStripes = (int)std::ceil( (double)renderMappedRoI.area() / NATRON_NON_TILED_RENDER_STRIPE_MAX_PIXELS );
+        nStripes = std::min( height, std::max( nStripes, (int)MultiThread::getNCPUsAvailable() ) );
+        int stripeHeight = std::max(1, (height + nStripes - 1) / nStripes);
+        for (int y = renderMappedRoI.y1; y < renderMappedRoI.y2; y += stripeHeight) {
+            RectToRender r;
+            r.rect = renderMappedRoI;
+            r.rect.y1 = y;
+            r.rect.y2 = std::min(y + stripeHeight, renderMappedRoI.y2);
+            r.identityInputNumber = -1;
+            renderRects->push_back(r);
+        }
         return eActionStatusOK;
     }
 
@@ -611,14 +1059,56 @@ EffectInstance::Implementation::checkRestToRender(bool updateTilesStateFromCache
         }
     }
 
+    const unsigned int nThreads = MultiThread::getNCPUsAvailable();
+
+    // When the user is waiting for the render in the viewer, render the part of the image around the center of the RoI first
+    // (i.e: the center of the viewport for the nodes upstream of the viewer). When the blocks are rendered one after another,
+    // the tiles of each block are published to the cache as soon as it is rendered.
+    bool renderFromCenter = false;
+    if ( !requestData->getParentRender()->isPlayback() ) {
+        int blockSizeX = std::max(1, (NATRON_INTERACTIVE_RENDER_BLOCK_SIZE + tilesState.tileSizeX - 1) / tilesState.tileSizeX) * tilesState.tileSizeX;
+        int blockSizeY = std::max(1, (NATRON_INTERACTIVE_RENDER_BLOCK_SIZE + tilesState.tileSizeY - 1) / tilesState.tileSizeY) * tilesState.tileSizeY;
+
+        // For effects with a large kernel, group the tiles in larger blocks so that less input pixels are rendered
+        // several times, as long as there are still enough blocks to keep all threads busy.
+        {
+            int centerX = (renderMappedRoI.x1 + renderMappedRoI.x2) / 2;
+            int centerY = (renderMappedRoI.y1 + renderMappedRoI.y2) / 2;
+            RectI centerBlock(centerX - blockSizeX / 2, centerY - blockSizeY / 2, centerX - blockSizeX / 2 + blockSizeX, centerY - blockSizeY / 2 + blockSizeY);
+            int expansionX, expansionY;
+            getInputsRoIExpansion(_publicInterface, centerBlock, renderMappedScale, &expansionX, &expansionY);
+
+            // (blockSize + 2 * expansion) / blockSize <= NATRON_RENDER_BLOCK_MAX_ROI_EXPANSION
+            int minBlockSizeX = (int)std::ceil( 2. * expansionX / (NATRON_RENDER_BLOCK_MAX_ROI_EXPANSION - 1) );
+            int minBlockSizeY = (int)std::ceil( 2. * expansionY / (NATRON_RENDER_BLOCK_MAX_ROI_EXPANSION - 1) );
+            int wantedBlockSizeX = std::max(blockSizeX, (minBlockSizeX + tilesState.tileSizeX - 1) / tilesState.tileSizeX * tilesState.tileSizeX);
+            int wantedBlockSizeY = std::max(blockSizeY, (minBlockSizeY + tilesState.tileSizeY - 1) / tilesState.tileSizeY * tilesState.tileSizeY);
+            bool frameThreaded = _publicInterface->getCurrentRenderThreadSafety() == eRenderSafetyFullySafeFrame;
+            while ( (wantedBlockSizeX > blockSizeX || wantedBlockSizeY > blockSizeY) &&
+                    frameThreaded && (getNumBlocks(reducedRects, wantedBlockSizeX, wantedBlockSizeY) < nThreads) ) {
+                wantedBlockSizeX = std::max(blockSizeX, wantedBlockSizeX / 2 / tilesState.tileSizeX * tilesState.tileSizeX);
+                wantedBlockSizeY = std::max(blockSizeY, wantedBlockSizeY / 2 / tilesState.tileSizeY * tilesState.tileSizeY);
+            }
+            blockSizeX = wantedBlockSizeX;
+            blockSizeY = wantedBlockSizeY;
+        }
+
+        std::list<RectI> blocks;
+        splitRectsInBlocksFromCenter(reducedRects, renderMappedRoI, blockSizeX, blockSizeY, &blocks);
+
+        // With less blocks than threads, splitting the render window evenly below balances the threads better
+        if ( (blocks.size() > 1) && ( (_publicInterface->getCurrentRenderThreadSafety() != eRenderSafetyFullySafeFrame) || (blocks.size() >= nThreads) ) ) {
+            reducedRects = blocks;
+            renderFromCenter = true;
+        }
+    }
+
     // For each reduced rect to render, add it to the final list
-    if (reducedRects.size() == 1 && _publicInterface->getCurrentRenderThreadSafety() == eRenderSafetyFullySafeFrame) {
+    if (!renderFromCenter && reducedRects.size() == 1 && _publicInterface->getCurrentRenderThreadSafety() == eRenderSafetyFullySafeFrame) {
         RectI mainRenderRect = reducedRects.front();
 
         // If plug-in wants host frame threading and there is only 1 rect to render, split it
         // in the number of available threads in the thread-pool
-
-        const unsigned int nThreads = MultiThread::getNCPUsAvailable();
         reducedRects = mainRenderRect.splitIntoSmallerRects(nThreads);
     }
     for (std::list<RectI>::const_iterator it = reducedRects.begin(); it != reducedRects.end(); ++it) {
@@ -685,6 +1175,11 @@ EffectInstance::Implementation::createCachedImage(const RectI& roiPixels,
         nodeFrameViewHash = _publicInterface->computeHash(args);
     }
 
+    // Remember the image so that its tiles outside of the region changed by an edit may be re-used, see DirtyRegionChange_RAII
+    if ( (cachePolicy == eCacheAccessModeReadWrite) || (cachePolicy == eCacheAccessModeWriteOnly) ) {
+        addRenderedFrameViewHash(_publicInterface->getCurrentRenderTime(), _publicInterface->getCurrentRenderView(), nodeFrameViewHash);
+    }
+
     bool supportsDraft = _publicInterface->isDraftRenderSupported();
 
     // The bitdepth of the image
@@ -713,6 +1208,22 @@ EffectInstance::Implementation::createCachedImage(const RectI& roiPixels,
         // We need to create the image before because it does the cache look-up itself, and we don't want to got further if
         // there's something cached.
         initArgs.delayAllocation = delayAllocation;
+
+        if (cachePolicy == eCacheAccessModeReadWrite) {
+            std::list<std::pair<U64, RectD> > previousHashes;
+            getPreviousFrameViewHashes(_publicInterface->getCurrentRenderTime(), _publicInterface->getCurrentRenderView(), nodeFrameViewHash, &previousHashes);
+            if ( !previousHashes.empty() ) {
+                RenderScale combinedScale = EffectInstance::getCombinedScale(mappedMipMapLevel, proxyScale);
+                double par = _publicInterface->getAspectRatio(-1);
+                for (std::list<std::pair<U64, RectD> >::const_iterator it = previousHashes.begin(); it != previousHashes.end(); ++it) {
+                    RectI dirtyPixelRegion;
+                    if ( !it->second.isNull() ) {
+                        it->second.toPixelEnclosing(combinedScale, par, &dirtyPixelRegion);
+                    }
+                    initArgs.previousTimeViewVariantHashes.push_back( std::make_pair(it->first, dirtyPixelRegion) );
+                }
+            }
+        }
     }
 
 
@@ -812,6 +1323,10 @@ EffectInstance::Implementation::launchRenderForSafetyAndBackend(const FrameViewR
 
         renderRetCode = launchPluginRenderAndHostFrameThreading(requestData, glContext, glContextData, combinedScale, backendType, renderRects, cachedPlanes);
 
+        if ( (renderRetCode == eActionStatusOK) && _publicInterface->isReader() && appPTR->getCurrentSettings()->isReadFilesSystemCacheBypassEnabled() ) {
+            dropReadFileFromSystemCache(_publicInterface);
+        }
+
         if (backendType == eRenderBackendTypeOpenGL ||
             backendType == eRenderBackendTypeOSMesa) {
 
@@ -1068,8 +1583,8 @@ EffectInstance::requestRender(TimeValue timeInArgs,
         }
     }
     if (!*createdRequest) {
-        // Create a request if it did not already exist
-        createdRequest->reset(new FrameViewRequest(plane, mipMapLevel, proxyScale, renderClone, requestPassSharedData->getTreeRender()));
+        // Create a request if it did not already exist, in the arena of the render
+        *createdRequest = boost::allocate_shared<FrameViewRequest>(RenderArenaAllocator<FrameViewRequest>( requestPassSharedData->getArena() ), plane, mipMapLevel, proxyScale, renderClone, requestPassSharedData->getTreeRender());
         renderClone->_imp->renderData->requests.insert(std::make_pair(requestKey, *createdRequest));
     }
 
@@ -1204,6 +1719,32 @@ EffectInstance::requestRenderInternal(const RectD & roiCanonical,
         }
     }
 
+    {
+        bool concatenated;
+        ActionRetCodeEnum upstreamRetCode = _imp->handleColorConcatenation(requestPassSharedData, requestData, requester, mappedCombinedScale, roiCanonical, &concatenated);
+        if (isFailureRetCode(upstreamRetCode)) {
+            return upstreamRetCode;
+        }
+        if (concatenated) {
+            requestData->initStatus(FrameViewRequest::eFrameViewRequestStatusPassThrough);
+            return eActionStatusOK;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////// Handle identical effects //////////////////////////////////////////////////////////////
+    {
+        bool isIdentical;
+        ActionRetCodeEnum upstreamRetCode = _imp->handleIdenticalRequest(requestPassSharedData, requestData, roiCanonical, &isIdentical);
+        if (isFailureRetCode(upstreamRetCode)) {
+            return upstreamRetCode;
+        }
+        if (isIdentical) {
+            requestData->initStatus(FrameViewRequest::eFrameViewRequestStatusPassThrough);
+            return eActionStatusOK;
+        }
+    }
+
 
 
     ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -1227,7 +1768,7 @@ EffectInstance::requestRenderInternal(const RectD & roiCanonical,
         // Round the roi to the tile size if the render is cached
         ImageBitDepthEnum outputBitDepth = getBitDepth(-1);
         int tileWidth, tileHeight;
-        CacheBase::getTileSizePx(outputBitDepth, &tileWidth, &tileHeight);
+        appPTR->getTileCache()->getTileSizePx(outputBitDepth, &tileWidth, &tileHeight);
         renderMappedRoI.roundToTileSize(tileWidth, tileHeight);
 
 
@@ -1285,7 +1826,8 @@ EffectInstance::requestRenderInternal(const RectD & roiCanonical,
 
     
 
-    const bool isAccumulating = false; //isAccumulationEnabled();
+    // While painting, only the points added since the previous draw step are rendered on top of the image of the previous step
+    const bool isAccumulating = isAccumulationEnabled();
 
 
     // Should the output of this render be cached ?
@@ -1308,8 +1850,20 @@ EffectInstance::requestRenderInternal(const RectD & roiCanonical,
         }
     }
     requestData->setCachePolicy(cachePolicy);
-    
-    
+
+    // If another render is going to render the same image, wait for its results instead of requesting the inputs
+    // and meeting it on the pending tiles of the cache
+    U64 nodeFrameViewHash = 0;
+    const bool canShareRequest = _imp->canShareRequestWithOtherRenders(requestData, cachePolicy, &nodeFrameViewHash);
+    if (canShareRequest) {
+        bool subscribed;
+        _imp->handleInFlightRequest(nodeFrameViewHash, requestData, &subscribed);
+        if (subscribed) {
+            requestData->initStatus(FrameViewRequest::eFrameViewRequestStatusNotRendered);
+            return eActionStatusOK;
+        }
+    }
+
 
     // Get the image on the FrameViewRequest
     // If this request was already rendered once in the tree,
@@ -1378,6 +1932,13 @@ EffectInstance::requestRenderInternal(const RectD & roiCanonical,
             return stat;
         }
 
+        {
+            RenderStatsPtr stats = render->getStatsObject();
+            if ( stats && stats->isInDepthProfilingEnabled() ) {
+                stats->addCacheLookupForNode(getNode(), !hasPendingTiles && !hasUnRenderedTile);
+            }
+        }
+
         if (!hasPendingTiles && !hasUnRenderedTile) {
             requestStatus = FrameViewRequest::eFrameViewRequestStatusRendered;
         } else if (mappedMipMapLevel != requestData->getMipMapLevel()) {
@@ -1423,6 +1984,11 @@ EffectInstance::requestRenderInternal(const RectD & roiCanonical,
         if (isFailureRetCode(upstreamRetCode)) {
             return upstreamRetCode;
         }
+
+        // Let the other renders wait for the image of this request instead of rendering it
+        if (canShareRequest) {
+            render->registerInFlightRequest(nodeFrameViewHash, requestData);
+        }
     }
     return eActionStatusOK;
 } // requestRenderInternal
@@ -1439,18 +2005,20 @@ EffectInstance::launchRender(const RequestPassSharedDataPtr& requestPassSharedDa
             case FrameViewRequest::eFrameViewRequestStatusRendered:
             case FrameViewRequest::eFrameViewRequestStatusPassThrough:
                 return eActionStatusOK;
-            case FrameViewRequest::eFrameViewRequestStatusPending: {
-                // We should NEVER be recursively computing twice the same FrameViewRequest.
-                assert(false);
-                return eActionStatusFailed;
-                //ActionRetCodeEnum stat = requestData->waitForPendingResults();
-                //return stat;
-            }
+            case FrameViewRequest::eFrameViewRequestStatusPending:
+                // The request is rendered by the render action of another plane of this effect, see launchRenderInternal()
+                return requestData->waitForPendingResults();
             case FrameViewRequest::eFrameViewRequestStatusNotRendered:
                 break;
         }
     }
-    ActionRetCodeEnum stat = launchRenderInternal(requestPassSharedData, requestData);
+    ActionRetCodeEnum stat;
+    if ( requestData->getInFlightRequest() ) {
+        // The image is rendered by another render, see handleInFlightRequest()
+        stat = _imp->fetchInFlightRequestResults(requestData);
+    } else {
+        stat = launchRenderInternal(requestPassSharedData, requestData);
+    }
 
     // Notify that we are done rendering
     requestData->notifyRenderFinished(stat);
@@ -1458,20 +2026,151 @@ EffectInstance::launchRender(const RequestPassSharedDataPtr& requestPassSharedDa
 } // launchRender
 
 static void finishProducedPlanesTilesStatesMap(const std::map<ImagePlaneDesc, ImagePtr>& producedPlanes,
-                                               bool aborted)
+                                               bool aborted,
+                                               double timeSpentRendering = 0)
 {
+    // The render time is shared between all planes produced at once
+    double planeRenderCost = producedPlanes.empty() ? 0 : timeSpentRendering / producedPlanes.size();
     for (std::map<ImagePlaneDesc, ImagePtr>::const_iterator it = producedPlanes.begin(); it!=producedPlanes.end(); ++it) {
         ImageCacheEntryPtr entry = it->second->getCacheEntry();
         if (aborted) {
             entry->markCacheTilesAsAborted();
         } else {
-            entry->markCacheTilesAsRendered();
+            entry->markCacheTilesAsRendered(planeRenderCost);
         }
     }
 }
 
+/**
+ * @brief The requests of other planes of a render clone that are rendered by the render action of another request.
+ * They are notified as rendered with the status of that render when this object is destroyed.
+ **/
+class PlaneRequestsRenderedTogether_RAII
+{
+    std::map<ImagePlaneDesc, FrameViewRequestPtr> _requests;
+    ActionRetCodeEnum _stat;
+
+public:
+
+    PlaneRequestsRenderedTogether_RAII()
+    : _requests()
+    , _stat(eActionStatusFailed)
+    {
+    }
+
+    ~PlaneRequestsRenderedTogether_RAII()
+    {
+        for (std::map<ImagePlaneDesc, FrameViewRequestPtr>::const_iterator it = _requests.begin(); it != _requests.end(); ++it) {
+            it->second->notifyRenderFinished(_stat);
+        }
+    }
+
+    /**
+     * @brief Takes ownership of the render of the given request if nobody started rendering it
+     **/
+    bool claim(const FrameViewRequestPtr& request)
+    {
+        if ( _requests.find( request->getPlaneDesc() ) != _requests.end() ) {
+            return false;
+        }
+        if (request->notifyRenderStarted() != FrameViewRequest::eFrameViewRequestStatusNotRendered) {
+            return false;
+        }
+        _requests[request->getPlaneDesc()] = request;
+
+        return true;
+    }
+
+    FrameViewRequestPtr getRequest(const ImagePlaneDesc& plane) const
+    {
+        std::map<ImagePlaneDesc, FrameViewRequestPtr>::const_iterator found = _requests.find(plane);
+
+        return found == _requests.end() ? FrameViewRequestPtr() : found->second;
+    }
+
+    const std::map<ImagePlaneDesc, FrameViewRequestPtr>& getRequests() const
+    {
+        return _requests;
+    }
+
+    void setStatus(ActionRetCodeEnum stat)
+    {
+        _stat = stat;
+    }
+};
+
+void
+EffectInstance::Implementation::claimPlaneRequestsToRenderTogether(const RequestPassSharedDataPtr& requestPassSharedData,
+                                                                   const FrameViewRequestPtr& requestData,
+                                                                   const std::list<ImagePlaneDesc>& producedPlanes,
+                                                                   PlaneRequestsRenderedTogether_RAII* planeRequests)
+{
+    // Only a multi-planar effect can render several planes in a single action. When accumulating
+    // a single plane is rendered at once.
+    if ( !_publicInterface->isMultiPlanar() || _publicInterface->isAccumulationEnabled() ) {
+        return;
+    }
+
+    // The images of the other requests must be rendered directly, without a downscale step.
+    if ( requestData->getRenderMappedMipMapLevel() != requestData->getMipMapLevel() ) {
+        return;
+    }
+
+    std::list<FrameViewRequestPtr> otherRequests;
+    {
+        QMutexLocker k(&renderData->lock);
+        for (FrameViewRequestMap::const_iterator it = renderData->requests.begin(); it != renderData->requests.end(); ++it) {
+            FrameViewRequestPtr request = it->second.lock();
+            if ( request && (request != requestData) ) {
+                otherRequests.push_back(request);
+            }
+        }
+    }
+
+    const RectD roi = requestData->getCurrentRoI();
+    for (std::list<FrameViewRequestPtr>::const_iterator it = otherRequests.begin(); it != otherRequests.end(); ++it) {
+        const FrameViewRequestPtr& request = *it;
+
+        // Only the planes requested with the same arguments and which are ready to render
+        if ( (request->getMipMapLevel() != requestData->getMipMapLevel()) ||
+             (request->getRenderMappedMipMapLevel() != requestData->getRenderMappedMipMapLevel()) ||
+             (request->getProxyScale().x != requestData->getProxyScale().x) ||
+             (request->getProxyScale().y != requestData->getProxyScale().y) ||
+             (request->getRenderDevice() != requestData->getRenderDevice()) ||
+             (request->getCurrentRoI() != roi) ||
+             (request->getStatus() != FrameViewRequest::eFrameViewRequestStatusNotRendered) ||
+             !request->getFullscaleImagePlane() ||
+             !requestPassSharedData->isTaskToRender(request) ||
+             (request->getNumDependencies(requestPassSharedData) > 0) ) {
+            continue;
+        }
+        if ( std::find( producedPlanes.begin(), producedPlanes.end(), request->getPlaneDesc() ) == producedPlanes.end() ) {
+            continue;
+        }
+        planeRequests->claim(request);
+    }
+} // claimPlaneRequestsToRenderTogether
+
+void
+EffectInstance::Implementation::getPlanesRequestedInRender(const FrameViewRequestPtr& requestData,
+                                                           std::list<ImagePlaneDesc>* planes) const
+{
+    QMutexLocker k(&renderData->lock);
+    for (FrameViewRequestMap::const_iterator it = renderData->requests.begin(); it != renderData->requests.end(); ++it) {
+        if ( (it->first.mipMapLevel != requestData->getMipMapLevel()) ||
+             (it->first.proxyScale.x != requestData->getProxyScale().x) ||
+             (it->first.proxyScale.y != requestData->getProxyScale().y) ) {
+            continue;
+        }
+        if ( !it->second.lock() ) {
+            continue;
+        }
+        planes->push_back(it->first.plane);
+    }
+} // getPlanesRequestedInRender
+
 ActionRetCodeEnum
-EffectInstance::launchRenderInternal(const RequestPassSharedDataPtr& /*requestPassSharedData*/, const FrameViewRequestPtr& requestData)
+EffectInstance::launchRenderInternal(const RequestPassSharedDataPtr& requestPassSharedData, const FrameViewRequestPtr& requestData)
 {
     assert(isRenderClone() && getCurrentRender());
 
@@ -1513,7 +2212,7 @@ EffectInstance::launchRenderInternal(const RequestPassSharedDataPtr& /*requestPa
     {
         ImageBitDepthEnum outputBitDepth = getBitDepth(-1);
         int tileWidth, tileHeight;
-        CacheBase::getTileSizePx(outputBitDepth, &tileWidth, &tileHeight);
+        appPTR->getTileCache()->getTileSizePx(outputBitDepth, &tileWidth, &tileHeight);
         assert(renderMappedRoI.x1 % tileWidth == 0 || renderMappedRoI.x1 == perMipMapLevelRoDPixel[mappedMipMapLevel].x1);
         assert(renderMappedRoI.y1 % tileWidth == 0 || renderMappedRoI.y1 == perMipMapLevelRoDPixel[mappedMipMapLevel].y1);
         assert(renderMappedRoI.x2 % tileWidth == 0 || renderMappedRoI.x2 == perMipMapLevelRoDPixel[mappedMipMapLevel].x2);
@@ -1530,18 +2229,40 @@ EffectInstance::launchRenderInternal(const RequestPassSharedDataPtr& /*requestPa
     ImagePtr fullscalePlane = requestData->getFullscaleImagePlane();
     // Allocate the cache storage image now if it was not yet allocated
     assert(fullscalePlane);
-    fullscalePlane->ensureBuffersAllocated();
+    std::size_t bytesAllocated = fullscalePlane->ensureBuffersAllocated();
+    RenderStatsPtr stats = getCurrentRender()->getStatsObject();
+    if ( stats && stats->isInDepthProfilingEnabled() && (bytesAllocated > 0) ) {
+        stats->addBytesAllocatedForNode(getNode(), bytesAllocated);
+    }
 
     RenderBackendTypeEnum backendType = requestData->getRenderDevice();
 
-    const bool renderAllProducedPlanes = isAllProducedPlanesAtOncePreferred();
+    // A reader decodes the planes needed downstream in this render rather than all the planes of the file:
+    // in a multi-layer file, usually only a few of the layers are used.
+    const bool renderAllProducedPlanes = isAllProducedPlanesAtOncePreferred() && !isReader();
+    std::list<ImagePlaneDesc> planesRequestedInRender;
+    if ( isAllProducedPlanesAtOncePreferred() && isReader() ) {
+        _imp->getPlanesRequestedInRender(requestData, &planesRequestedInRender);
+    }
+
+    // The other planes requested on this effect in the same pass (e.g: the AOVs fetched with getImagePlanes())
+    // are rendered by this action, into the images of their own request
+    PlaneRequestsRenderedTogether_RAII planeRequestsRenderedTogether;
+    _imp->claimPlaneRequestsToRenderTogether(requestPassSharedData, requestData, producedPlanes, &planeRequestsRenderedTogether);
 
     for (std::list<ImagePlaneDesc>::const_iterator it = producedPlanes.begin(); it != producedPlanes.end(); ++it) {
         ImagePtr imagePlane;
+        FrameViewRequestPtr otherPlaneRequest;
         if (*it == requestData->getPlaneDesc()) {
             imagePlane = fullscalePlane;
+        } else if ( (otherPlaneRequest = planeRequestsRenderedTogether.getRequest(*it)) ) {
+            imagePlane = otherPlaneRequest->getFullscaleImagePlane();
+            std::size_t otherBytesAllocated = imagePlane->ensureBuffersAllocated();
+            if ( stats && stats->isInDepthProfilingEnabled() && (otherBytesAllocated > 0) ) {
+                stats->addBytesAllocatedForNode(getNode(), otherBytesAllocated);
+            }
         } else {
-            if (!renderAllProducedPlanes) {
+            if ( !renderAllProducedPlanes && ( std::find(planesRequestedInRender.begin(), planesRequestedInRender.end(), *it) == planesRequestedInRender.end() ) ) {
                 continue;
             } else {
                 imagePlane = _imp->createCachedImage(renderMappedRoI, perMipMapLevelRoDPixel, mappedMipMapLevel, requestData->getProxyScale(), *it, backendType, requestData->getCachePolicy(), false /*delayAllocation*/);
@@ -1575,8 +2296,20 @@ EffectInstance::launchRenderInternal(const RequestPassSharedDataPtr& /*requestPa
 
         // There may be no rectangles to render if all rectangles are pending (i.e: this render should wait for another thread
         // to complete the render first)
+        double timeSpentRendering = 0;
         if (!renderRects.empty()) {
+            TimeLapse timeRecorder;
             renderRetCode = _imp->launchRenderForSafetyAndBackend(requestData, mappedCombinedScale, backendType, renderRects, cachedImagePlanes);
+            timeSpentRendering = timeRecorder.getTimeSinceCreation();
+
+            // Keep track of the time per pixel of the node so that the next renders can schedule the slowest branches first
+            if (!isFailureRetCode(renderRetCode)) {
+                double nPixels = 0;
+                for (std::list<RectToRender>::const_iterator it = renderRects.begin(); it != renderRects.end(); ++it) {
+                    nPixels += (double)it->rect.width() * it->rect.height();
+                }
+                getNode()->addRenderTimeSample(timeSpentRendering, nPixels);
+            }
         }
 
         if (isFailureRetCode(renderRetCode)) {
@@ -1584,12 +2317,17 @@ EffectInstance::launchRenderInternal(const RequestPassSharedDataPtr& /*requestPa
             break;
         }
 
-        // Mark what we rendered in the tiles state map
-        finishProducedPlanesTilesStatesMap(cachedImagePlanes, false /*aborted*/);
+        // Mark what we rendered in the tiles state map, the render time is recorded as the cost of the cache entries
+        finishProducedPlanesTilesStatesMap(cachedImagePlanes, false /*aborted*/, timeSpentRendering);
 
         // Wait for any pending results for the requested plane.
         // After this line other threads that should have computed should be done
-        if (fullscalePlane->getCacheEntry()->waitForPendingTiles()) {
+        bool pendingTilesRendered;
+        {
+            RenderStatsActionTimer_RAII statsTimer(this, eRenderStatsActionTileWait);
+            pendingTilesRendered = fullscalePlane->getCacheEntry()->waitForPendingTiles();
+        }
+        if (pendingTilesRendered) {
             hasPendingTiles = false;
             renderRects.clear();
         } else {
@@ -1612,6 +2350,18 @@ EffectInstance::launchRenderInternal(const RequestPassSharedDataPtr& /*requestPa
         return isFailureRetCode(renderRetCode) ? renderRetCode : eActionStatusAborted;
     }
 
+    // The tiles of the other planes that were pending in other renders must be rendered before they are notified
+    if (renderRetCode == eActionStatusOK) {
+        const std::map<ImagePlaneDesc, FrameViewRequestPtr>& otherRequests = planeRequestsRenderedTogether.getRequests();
+        for (std::map<ImagePlaneDesc, FrameViewRequestPtr>::const_iterator it = otherRequests.begin(); it != otherRequests.end(); ++it) {
+            RenderStatsActionTimer_RAII statsTimer(this, eRenderStatsActionTileWait);
+            if ( !it->second->getFullscaleImagePlane()->getCacheEntry()->waitForPendingTiles() ) {
+                return eActionStatusAborted;
+            }
+        }
+        planeRequestsRenderedTogether.setStatus(eActionStatusOK);
+    }
+
     // If using GPU and out of memory retry on CPU if possible
     if (renderRetCode == eActionStatusOutOfMemory && !renderRects.empty() && backendType == eRenderBackendTypeOpenGL) {
 
@@ -1667,7 +2417,12 @@ EffectInstance::launchRenderInternal(const RequestPassSharedDataPtr& /*requestPa
         // However another thread could have marked pending the tiles at dstMipMapLevel in between, thus we just have to wait for it to be read
         assert(!hasUnrenderedTile);
 
-        if (!downscaledImage->getCacheEntry()->waitForPendingTiles()) {
+        bool pendingTilesRendered;
+        {
+            RenderStatsActionTimer_RAII statsTimer(this, eRenderStatsActionTileWait);
+            pendingTilesRendered = downscaledImage->getCacheEntry()->waitForPendingTiles();
+        }
+        if (!pendingTilesRendered) {
             return eActionStatusAborted;
         }
 
@@ -1720,9 +2475,9 @@ public:
         if (tlsData) {
             tlsData->clearActionStack();
         }
-        int fromIndex, toIndex;
-        ImageMultiThreadProcessorBase::getThreadRange(threadID, nThreads, 0, _rectsToRender.size(), &fromIndex, &toIndex);
-        for (int i = fromIndex; i < toIndex; ++i) {
+        // Interleave the rectangles between the threads: when they are sorted by priority (see checkRestToRender), all threads start
+        // with the rectangles rendered first
+        for (std::size_t i = threadID; i < _rectsToRender.size(); i += nThreads) {
             ActionRetCodeEnum stat = _imp->tiledRenderingFunctor(_rectsToRender[i], *_args);
             if (isFailureRetCode(stat)) {
                 return stat;
@@ -1807,6 +2562,15 @@ EffectInstance::Implementation::launchPluginRenderAndHostFrameThreading(const Fr
 
     if (!attemptHostFrameThreading) {
 
+        // When rendering several rectangles one after another, publish the tiles of each rectangle to the cache
+        // as soon as it is rendered: other renders waiting on these tiles may then use them without waiting
+        // for the whole render window. The tiles of the last rectangle are published by the caller.
+        const bool publishRenderedTiles = renderRects.size() > 1 &&
+                                          backendType == eRenderBackendTypeCPU &&
+                                          requestData->getCachePolicy() != eCacheAccessModeNone;
+
+        std::list<RectToRender>::const_iterator lastRect = renderRects.end();
+        --lastRect;
         for (std::list<RectToRender>::const_iterator it = renderRects.begin(); it != renderRects.end(); ++it) {
 
             ActionRetCodeEnum functorRet = tiledRenderingFunctor(*it, *functorArgs);
@@ -1814,6 +2578,12 @@ EffectInstance::Implementation::launchPluginRenderAndHostFrameThreading(const Fr
                 return functorRet;
             }
 
+            if (publishRenderedTiles && it != lastRect) {
+                for (std::map<ImagePlaneDesc, ImagePtr>::const_iterator it2 = cachedPlanes.begin(); it2 != cachedPlanes.end(); ++it2) {
+                    it2->second->getCacheEntry()->markCacheTilesInRegionAsRendered(it->rect);
+                }
+            }
+
         } // for (std::list<RectI>::const_iterator it = rectsToRender.begin(); it != rectsToRender.end(); ++it) {
 
     } else { // attemptHostFrameThreading
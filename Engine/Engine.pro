@@ -69,6 +69,9 @@ INCLUDEPATH += $$PWD/../google-breakpad/src
 # hoedown
 INCLUDEPATH += $$PWD/../libs/hoedown/src
 
+#qhttpserver
+INCLUDEPATH += $$PWD/../libs/qhttpserver/src
+
 #To overcome wrongly generated #include <...> by shiboken
 INCLUDEPATH += $$PWD
 INCLUDEPATH += $$PWD/NatronEngine
@@ -87,10 +90,12 @@ SOURCES += \
     CacheEntryBase.cpp \
     CacheEntryKeyBase.cpp \
     CLArgs.cpp \
+    ColorMatrix.cpp \
     CoonsRegularization.cpp \
     ColorParser.cpp \
     CornerPinOverlayInteract.cpp \
     CreateNodeArgs.cpp \
+    CudaDriver.cpp \
     Curve.cpp \
     DiskCacheNode.cpp \
     Distortion2D.cpp \
@@ -104,12 +109,16 @@ SOURCES += \
     EffectInstancePrivate.cpp \
     EffectInstanceRenderRoI.cpp \
     EffectOpenGLContextData.cpp \
+    EngineCalibration.cpp \
+    EngineMetrics.cpp \
     ExistenceCheckThread.cpp \
     ExprTk.cpp \
     FileDownloader.cpp \
     FileSystemModel.cpp \
     FitCurve.cpp \
     Format.cpp \
+    FrameEncodeQueue.cpp \
+    FrameStreamWriter.cpp \
     FrameViewRequest.cpp \
     GenericSchedulerThread.cpp \
     GenericSchedulerThreadWatcher.cpp \
@@ -128,6 +137,7 @@ SOURCES += \
     ImageFill.cpp \
     ImagePrivate.cpp \
     ImageMaskMix.cpp \
+    ImageResample.cpp \
     ImageStorage.cpp \
     ImageTilesState.cpp \
     IPCCommon.cpp \
@@ -146,9 +156,11 @@ SOURCES += \
     Log.cpp \
     Lut.cpp \
     Markdown.cpp \
+    MemoryAccount.cpp \
     MemoryFile.cpp \
     MultiThread.cpp \
     MemoryInfo.cpp \
+    MetricsServer.cpp \
     Node.cpp \
     NodeDocumentation.cpp \
     NodeInputs.cpp \
@@ -184,6 +196,7 @@ SOURCES += \
     PluginMemory.cpp \
     PrecompNode.cpp \
     ProcessHandler.cpp \
+    ProcessLocalBuffer.cpp \
     Project.cpp \
     ProjectPrivate.cpp \
     PropertiesHolder.cpp \
@@ -193,6 +206,8 @@ SOURCES += \
     PyNodeGroup.cpp \
     PyNode.cpp \
     PyExprUtils.cpp \
+    PyImageBuffer.cpp \
+    PyGlobalFunctions.cpp \
     PyOverlayInteract.cpp \
     PyParameter.cpp \
     PyRoto.cpp \
@@ -200,10 +215,16 @@ SOURCES += \
     PyTracker.cpp \
     QtEnumConvert.cpp \
     ReadNode.cpp \
+    ReadNodePrefetcher.cpp \
     RectD.cpp \
     RectI.cpp \
+    RenderArena.cpp \
     RenderStats.cpp \
     RenderQueue.cpp \
+    RenderTrace.cpp \
+    RenderCoordinator.cpp \
+    RenderServer.cpp \
+    RenderWorker.cpp \
     RotoBezierTriangulation.cpp \
     RotoDrawableItem.cpp \
     RotoItem.cpp \
@@ -213,6 +234,7 @@ SOURCES += \
     RotoShapeRenderNode.cpp \
     RotoShapeRenderNodePrivate.cpp \
     RotoShapeRenderCairo.cpp \
+    RotoShapeRenderCPU.cpp \
     RotoShapeRenderGL.cpp \
     RotoStrokeItem.cpp \
     RotoUndoCommand.cpp \
@@ -222,6 +244,7 @@ SOURCES += \
     SplitterI.cpp \
     Smooth1D.cpp \
     StandardPaths.cpp \
+    StartupTrace.cpp \
     StorageDeleterThread.cpp \
     StringAnimationManager.cpp \
     StubNode.cpp \
@@ -244,6 +267,7 @@ SOURCES += \
     Transform.cpp \
     TransformOverlayInteract.cpp \
     Utils.cpp \
+    ViewerFlipbookCache.cpp \
     ViewerInstance.cpp \
     ViewerNode.cpp \
     ViewerNodePrivate.cpp \
@@ -337,8 +361,10 @@ HEADERS += \
     CornerPinOverlayInteract.h \
     ChoiceOption.h \
     Color.h \
+    ColorMatrix.h \
     ColorParser.h \
     CreateNodeArgs.h \
+    CudaDriver.h \
     Curve.h \
     CurvePrivate.h \
     DimensionIdx.h \
@@ -352,12 +378,16 @@ HEADERS += \
     EffectInstanceActionResults.h \
     EffectOpenGLContextData.h \
     ExistenceCheckThread.h \
+    EngineCalibration.h \
     EngineFwd.h \
+    EngineMetrics.h \
     FeatherPoint.h \
     FileDownloader.h \
     FileSystemModel.h \
     FitCurve.h \
     Format.h \
+    FrameEncodeQueue.h \
+    FrameStreamWriter.h \
     FrameViewRequest.h \
     GenericSchedulerThread.h \
     GenericSchedulerThreadWatcher.h \
@@ -365,6 +395,7 @@ HEADERS += \
     GPUContextPool.h \
     GroupInput.h \
     GroupOutput.h \
+    HalfFloat.h \
     HashableObject.h \
     Hash64.h \
     HistogramCPU.h \
@@ -397,9 +428,11 @@ HEADERS += \
     LRUHashTable.h \
     Lut.h \
     Markdown.h \
+    MemoryAccount.h \
     MemoryFile.h \
     MemoryInfo.h \
     MergingEnum.h \
+    MetricsServer.h \
     MultiThread.h \
     Node.h \
     NodePrivate.h \
@@ -436,6 +469,7 @@ HEADERS += \
     PluginMemory.h \
     PrecompNode.h \
     ProcessHandler.h \
+    ProcessLocalBuffer.h \
     Project.h \
     ProjectPrivate.h \
     PropertiesHolder.h \
@@ -446,6 +480,7 @@ HEADERS += \
     PyNode.h \
     PyOverlayInteract.h \
     PyExprUtils.h \
+    PyImageBuffer.h \
     PyParameter.h \
     PyRoto.h \
     PyTracker.h \
@@ -454,10 +489,16 @@ HEADERS += \
     QtEnumConvert.h \
     RamBuffer.h \
     ReadNode.h \
+    ReadNodePrefetcher.h \
     RectD.h \
     RectI.h \
+    RenderArena.h \
     RenderStats.h \
     RenderQueue.h \
+    RenderTrace.h \
+    RenderCoordinator.h \
+    RenderServer.h \
+    RenderWorker.h \
     RotoBezierTriangulation.h \
     RotoDrawableItem.h \
     RotoLayer.h \
@@ -468,6 +509,7 @@ HEADERS += \
     RotoShapeRenderNode.h \
     RotoShapeRenderNodePrivate.h \
     RotoShapeRenderCairo.h \
+    RotoShapeRenderCPU.h \
     RotoShapeRenderGL.h \
     RotoStrokeItem.h \
     RotoUndoCommand.h \
@@ -478,6 +520,7 @@ HEADERS += \
     Singleton.h \
     SplitterI.h \
     StandardPaths.h \
+    StartupTrace.h \
     StorageDeleterThread.h \
     StringAnimationManager.h \
     StubNode.h \
@@ -506,6 +549,7 @@ HEADERS += \
     UndoCommand.h \
     Utils.h \
     Variant.h \
+    ViewerFlipbookCache.h \
     ViewerInstance.h \
     ViewerNode.h \
     ViewerNodePrivate.h \
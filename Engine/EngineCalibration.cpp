@@ -0,0 +1,374 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "EngineCalibration.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <sstream>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+#include "Engine/AppManager.h"
+#include "Engine/Cache.h"
+#include "Engine/MemoryInfo.h"
+#include "Engine/Settings.h"
+
+// The size of the frame rendered by the calibration kernel
+#define NATRON_CALIBRATION_FRAME_WIDTH 1920
+#define NATRON_CALIBRATION_FRAME_HEIGHT 1080
+
+// Each measure renders frames for at least this time, in milliseconds
+#define NATRON_CALIBRATION_MIN_TIME_MS 250
+
+// A setting is only recommended over a lower number of threads or over the current tile size if it is at least
+// this much faster: below that the difference is within the noise of the measure
+#define NATRON_CALIBRATION_MIN_GAIN 0.05
+
+// When it is enabled, the compressed cache tier is given this fraction of the RAM
+#define NATRON_CALIBRATION_COMPRESSED_TIER_RAM_FRACTION 8
+
+NATRON_NAMESPACE_ENTER;
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief A 32-bit float RGBA frame with planar channels, as the channels of an image are in separate tiles in the cache.
+ * Each tile of the destination frame is blurred from the source frame into a tile buffer, as when a render thread
+ * renders a tile of the cache, then copied to the destination frame.
+ **/
+struct CalibrationFrame
+{
+    std::vector<float> src[4];
+    std::vector<float> dst[4];
+
+    CalibrationFrame()
+    {
+        const std::size_t nPixels = (std::size_t)NATRON_CALIBRATION_FRAME_WIDTH * NATRON_CALIBRATION_FRAME_HEIGHT;
+        for (int c = 0; c < 4; ++c) {
+            src[c].resize(nPixels);
+            dst[c].resize(nPixels);
+        }
+
+        // Gradients with some detail so that the compressed tiles are neither trivial nor noise
+        for (int y = 0; y < NATRON_CALIBRATION_FRAME_HEIGHT; ++y) {
+            for (int x = 0; x < NATRON_CALIBRATION_FRAME_WIDTH; ++x) {
+                std::size_t i = (std::size_t)y * NATRON_CALIBRATION_FRAME_WIDTH + x;
+                src[0][i] = (float)x / NATRON_CALIBRATION_FRAME_WIDTH;
+                src[1][i] = (float)y / NATRON_CALIBRATION_FRAME_HEIGHT;
+                src[2][i] = (float)( ( (x / 16) + (y / 16) ) % 2 ) * 0.5f + 0.25f;
+                src[3][i] = 1.f;
+            }
+        }
+    }
+
+    void renderTile(int x1,
+                    int y1,
+                    int tileWidth,
+                    int tileHeight,
+                    std::vector<float>* tile)
+    {
+        const int x2 = std::min(x1 + tileWidth, NATRON_CALIBRATION_FRAME_WIDTH);
+        const int y2 = std::min(y1 + tileHeight, NATRON_CALIBRATION_FRAME_HEIGHT);
+
+        for (int c = 0; c < 4; ++c) {
+            const float* srcPixels = &src[c][0];
+            for (int y = y1; y < y2; ++y) {
+                const float* rows[3];
+                rows[0] = srcPixels + (std::size_t)std::max(y - 1, 0) * NATRON_CALIBRATION_FRAME_WIDTH;
+                rows[1] = srcPixels + (std::size_t)y * NATRON_CALIBRATION_FRAME_WIDTH;
+                rows[2] = srcPixels + (std::size_t)std::min(y + 1, NATRON_CALIBRATION_FRAME_HEIGHT - 1) * NATRON_CALIBRATION_FRAME_WIDTH;
+                float* tilePixels = &(*tile)[(std::size_t)(y - y1) * tileWidth];
+                for (int x = x1; x < x2; ++x) {
+                    const int xm = std::max(x - 1, 0);
+                    const int xp = std::min(x + 1, NATRON_CALIBRATION_FRAME_WIDTH - 1);
+                    float sum = 0.f;
+                    for (int r = 0; r < 3; ++r) {
+                        sum += rows[r][xm] + rows[r][x] + rows[r][xp];
+                    }
+                    tilePixels[x - x1] = sum * (1.f / 9.f);
+                }
+            }
+
+            float* dstPixels = &dst[c][0];
+            for (int y = y1; y < y2; ++y) {
+                std::copy( &(*tile)[(std::size_t)(y - y1) * tileWidth], &(*tile)[(std::size_t)(y - y1) * tileWidth] + (x2 - x1),
+                           dstPixels + (std::size_t)y * NATRON_CALIBRATION_FRAME_WIDTH + x1 );
+            }
+        }
+    } // renderTile
+};
+
+class CalibrationTileRunnable
+    : public QRunnable
+{
+    CalibrationFrame* _frame;
+    int _tileWidth, _tileHeight, _nTilesX, _nTiles;
+    QAtomicInt* _nextTile;
+
+public:
+
+    CalibrationTileRunnable(CalibrationFrame* frame,
+                            int tileWidth,
+                            int tileHeight,
+                            int nTilesX,
+                            int nTiles,
+                            QAtomicInt* nextTile)
+    : QRunnable()
+    , _frame(frame)
+    , _tileWidth(tileWidth)
+    , _tileHeight(tileHeight)
+    , _nTilesX(nTilesX)
+    , _nTiles(nTiles)
+    , _nextTile(nextTile)
+    {
+        setAutoDelete(true);
+    }
+
+    virtual ~CalibrationTileRunnable()
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        std::vector<float> tile( (std::size_t)_tileWidth * _tileHeight );
+
+        // Take the tiles in turn, as the render threads take the tiles of an image
+        for (;;) {
+            int i = _nextTile->fetchAndAddRelaxed(1);
+            if (i >= _nTiles) {
+                return;
+            }
+            _frame->renderTile( (i % _nTilesX) * _tileWidth, (i / _nTilesX) * _tileHeight, _tileWidth, _tileHeight, &tile );
+        }
+    }
+};
+
+void
+renderFrame(CalibrationFrame* frame,
+            QThreadPool* pool,
+            int nThreads,
+            int tileSizePo2)
+{
+    int tileWidth, tileHeight;
+    CacheBase::getTileSizePxForPo2(tileSizePo2, eImageBitDepthFloat, &tileWidth, &tileHeight);
+    const int nTilesX = (NATRON_CALIBRATION_FRAME_WIDTH + tileWidth - 1) / tileWidth;
+    const int nTilesY = (NATRON_CALIBRATION_FRAME_HEIGHT + tileHeight - 1) / tileHeight;
+
+    QAtomicInt nextTile(0);
+    for (int i = 0; i < nThreads; ++i) {
+        pool->start( new CalibrationTileRunnable(frame, tileWidth, tileHeight, nTilesX, nTilesX * nTilesY, &nextTile) );
+    }
+    pool->waitForDone();
+}
+
+/**
+ * @brief Returns the throughput of the kernel in megapixels per second
+ **/
+double
+measureThroughput(CalibrationFrame* frame,
+                  int nThreads,
+                  int tileSizePo2)
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(nThreads);
+
+    // Start the threads and bring the frame in the CPU caches before measuring
+    renderFrame(frame, &pool, nThreads, tileSizePo2);
+
+    QElapsedTimer timer;
+    timer.start();
+    int nFrames = 0;
+    do {
+        renderFrame(frame, &pool, nThreads, tileSizePo2);
+        ++nFrames;
+    } while (timer.elapsed() < NATRON_CALIBRATION_MIN_TIME_MS);
+
+    double seconds = std::max(timer.nsecsElapsed() / 1e9, 1e-9);
+
+    return (double)nFrames * NATRON_CALIBRATION_FRAME_WIDTH * NATRON_CALIBRATION_FRAME_HEIGHT / seconds / 1e6;
+}
+
+/**
+ * @brief Returns the time in seconds to restore a tile of the given size compressed as in the compressed cache tier
+ **/
+double
+measureTileDecompressTime(const CalibrationFrame& frame,
+                          int tileSizePo2)
+{
+    int tileWidth, tileHeight;
+    CacheBase::getTileSizePxForPo2(tileSizePo2, eImageBitDepthFloat, &tileWidth, &tileHeight);
+    std::vector<float> tile( (std::size_t)tileWidth * tileHeight );
+    for (int y = 0; y < tileHeight; ++y) {
+        std::copy( &frame.dst[0][(std::size_t)y * NATRON_CALIBRATION_FRAME_WIDTH], &frame.dst[0][(std::size_t)y * NATRON_CALIBRATION_FRAME_WIDTH] + tileWidth, &tile[(std::size_t)y * tileWidth] );
+    }
+
+    // The same compression level as the compressed tier of the tile cache
+    QByteArray compressed = qCompress( (const uchar*)&tile[0], (int)(tile.size() * sizeof(float)), 1 );
+
+    QElapsedTimer timer;
+    timer.start();
+    int nTiles = 0;
+    do {
+        QByteArray data = qUncompress(compressed);
+        std::copy( data.constData(), data.constData() + data.size(), (char*)&tile[0] );
+        ++nTiles;
+    } while (timer.elapsed() < NATRON_CALIBRATION_MIN_TIME_MS);
+
+    return timer.nsecsElapsed() / 1e9 / nTiles;
+}
+
+int
+getCurrentNumberOfThreads()
+{
+    int nThreads = appPTR->getCurrentSettings()->getNumberOfThreads();
+
+    return nThreads <= 0 ? appPTR->getHardwareIdealThreadCount() : nThreads;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+
+void
+EngineCalibration::run(EngineCalibrationResults* results)
+{
+    CalibrationFrame frame;
+    const int hwThreadsCount = std::max(1, appPTR->getHardwareIdealThreadCount());
+    const int currentTileSizePo2 = appPTR->getCurrentSettings()->getTileCacheTileSizePo2();
+
+    // Scaling with the number of threads, with the current tile size
+    results->threadsThroughput.clear();
+    double bestThroughput = 0;
+    for (int nThreads = 1; ; nThreads = std::min(nThreads * 2, hwThreadsCount)) {
+        double throughput = measureThroughput(&frame, nThreads, currentTileSizePo2);
+        results->threadsThroughput.push_back( std::make_pair(nThreads, throughput) );
+        bestThroughput = std::max(bestThroughput, throughput);
+        if (nThreads == hwThreadsCount) {
+            break;
+        }
+    }
+
+    // The lowest number of threads that is as fast as the best one: the other threads are better left to the other processes
+    int nThreads = hwThreadsCount;
+    for (std::size_t i = 0; i < results->threadsThroughput.size(); ++i) {
+        if ( results->threadsThroughput[i].second >= bestThroughput * (1. - NATRON_CALIBRATION_MIN_GAIN) ) {
+            nThreads = results->threadsThroughput[i].first;
+            break;
+        }
+    }
+    results->nRenderThreads = nThreads == hwThreadsCount ? 0 : nThreads;
+
+    // Tile sizes, with the recommended number of threads. Keep the current tile size unless another one is clearly faster:
+    // changing it wipes the disk cache.
+    results->tileSizeThroughput.clear();
+    double currentTileSizeThroughput = 0;
+    double bestTileSizeThroughput = 0;
+    int bestTileSizePo2 = currentTileSizePo2;
+    for (int po2 = NATRON_TILE_SIZE_PO2_MIN; po2 <= NATRON_TILE_SIZE_PO2_MAX; ++po2) {
+        double throughput = measureThroughput(&frame, nThreads, po2);
+        results->tileSizeThroughput.push_back( std::make_pair(po2, throughput) );
+        if (po2 == currentTileSizePo2) {
+            currentTileSizeThroughput = throughput;
+        }
+        if (throughput > bestTileSizeThroughput) {
+            bestTileSizeThroughput = throughput;
+            bestTileSizePo2 = po2;
+        }
+    }
+    results->tileSizePo2 = bestTileSizeThroughput >= currentTileSizeThroughput * (1. + NATRON_CALIBRATION_MIN_GAIN) ? bestTileSizePo2 : currentTileSizePo2;
+
+    // The compressed cache tier is only worth it if restoring a tile is faster than rendering it again,
+    // even with a kernel as cheap as the calibration one
+    {
+        int tileWidth, tileHeight;
+        CacheBase::getTileSizePxForPo2(results->tileSizePo2, eImageBitDepthFloat, &tileWidth, &tileHeight);
+
+        // The kernel renders the 4 channels of a pixel, a tile holds a single channel
+        results->tileRenderTime = (double)tileWidth * tileHeight / 4. / (results->threadsThroughput[0].second * 1e6);
+        results->tileDecompressTime = measureTileDecompressTime(frame, results->tileSizePo2);
+        if (results->tileDecompressTime < results->tileRenderTime) {
+            U64 totalRAM = getSystemTotalRAM();
+            U64 maxSize = (U64)INT_MAX * 1024 * 1024;
+            results->compressedCacheTierSize = (std::size_t)std::min(totalRAM / NATRON_CALIBRATION_COMPRESSED_TIER_RAM_FRACTION, maxSize);
+        } else {
+            results->compressedCacheTierSize = 0;
+        }
+    }
+
+    // The reference render: a frame with the current settings compared to the recommended ones
+    const double framePixels = (double)NATRON_CALIBRATION_FRAME_WIDTH * NATRON_CALIBRATION_FRAME_HEIGHT / 1e6;
+    results->currentFramesPerSecond = measureThroughput(&frame, getCurrentNumberOfThreads(), currentTileSizePo2) / framePixels;
+    results->recommendedFramesPerSecond = measureThroughput(&frame, nThreads, results->tileSizePo2) / framePixels;
+} // run
+
+std::string
+EngineCalibration::getReport(const EngineCalibrationResults& results)
+{
+    std::stringstream ss;
+    ss << tr("Calibration kernel throughput (%1x%2 32-bit float RGBA frame):").arg(NATRON_CALIBRATION_FRAME_WIDTH).arg(NATRON_CALIBRATION_FRAME_HEIGHT).toStdString() << std::endl;
+    for (std::size_t i = 0; i < results.threadsThroughput.size(); ++i) {
+        ss << "  " << tr("%1 thread(s): %2 Mpx/s").arg(results.threadsThroughput[i].first).arg(results.threadsThroughput[i].second, 0, 'f', 1).toStdString() << std::endl;
+    }
+    for (std::size_t i = 0; i < results.tileSizeThroughput.size(); ++i) {
+        int tileWidth, tileHeight;
+        CacheBase::getTileSizePxForPo2(results.tileSizeThroughput[i].first, eImageBitDepthFloat, &tileWidth, &tileHeight);
+        ss << "  " << tr("%1x%2 tiles: %3 Mpx/s").arg(tileWidth).arg(tileHeight).arg(results.tileSizeThroughput[i].second, 0, 'f', 1).toStdString() << std::endl;
+    }
+    ss << tr("Tile render time: %1 us, restore time from the compressed cache: %2 us").arg(results.tileRenderTime * 1e6, 0, 'f', 1).arg(results.tileDecompressTime * 1e6, 0, 'f', 1).toStdString() << std::endl;
+    ss << tr("Reference render: %1 frames/s with the current settings, %2 frames/s with the recommended settings").arg(results.currentFramesPerSecond, 0, 'f', 1).arg(results.recommendedFramesPerSecond, 0, 'f', 1).toStdString() << std::endl;
+    ss << std::endl;
+    ss << tr("Recommended settings:").toStdString() << std::endl;
+    if (results.nRenderThreads == 0) {
+        ss << "  " << tr("Number of render threads: 0 (all the %1 hardware threads)").arg( appPTR->getHardwareIdealThreadCount() ).toStdString() << std::endl;
+    } else {
+        ss << "  " << tr("Number of render threads: %1").arg(results.nRenderThreads).toStdString() << std::endl;
+    }
+    ss << "  " << tr("Cache tile size: %1 KiB").arg( (qulonglong)(NATRON_TILE_SIZE_BYTES_FOR_PO2(results.tileSizePo2) / 1024) ).toStdString() << std::endl;
+    ss << "  " << tr("Compressed cache size: %1 MiB").arg( (qulonglong)(results.compressedCacheTierSize / (1024 * 1024)) ).toStdString() << std::endl;
+
+    return ss.str();
+} // getReport
+
+bool
+EngineCalibration::apply(const EngineCalibrationResults& results)
+{
+    SettingsPtr settings = appPTR->getCurrentSettings();
+    bool restartNeeded = settings->getTileCacheTileSizePo2() != results.tileSizePo2;
+
+    settings->setNumberOfThreads(results.nRenderThreads);
+    settings->setTileCacheTileSizePo2(results.tileSizePo2);
+    settings->setCompressedCacheTierSize(results.compressedCacheTierSize);
+    settings->saveSettingsToFile();
+
+    return restartNeeded;
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,117 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_ENGINECALIBRATION_H
+#define NATRON_ENGINE_ENGINECALIBRATION_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QCoreApplication>
+CLANG_DIAG_ON(deprecated)
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct EngineCalibrationResults
+{
+    // The throughput of the calibration kernel, in megapixels per second, for each number of threads tested
+    std::vector<std::pair<int, double> > threadsThroughput;
+
+    // The throughput of the calibration kernel with the recommended number of threads, for each tileSizePo2 tested
+    std::vector<std::pair<int, double> > tileSizeThroughput;
+
+    // The time to render a tile of the default size on one thread and to restore it from the compressed cache tier, in seconds
+    double tileRenderTime;
+    double tileDecompressTime;
+
+    // The frames per second of the reference render with the current settings and with the recommended settings
+    double currentFramesPerSecond;
+    double recommendedFramesPerSecond;
+
+    // The recommended settings: the value of the "numRenderThreads" setting (0 if all the hardware threads are useful),
+    // the tileSizePo2 of the tile cache and the size in bytes of the compressed cache tier
+    int nRenderThreads;
+    int tileSizePo2;
+    std::size_t compressedCacheTierSize;
+
+    EngineCalibrationResults()
+    : threadsThroughput()
+    , tileSizeThroughput()
+    , tileRenderTime(0)
+    , tileDecompressTime(0)
+    , currentFramesPerSecond(0)
+    , recommendedFramesPerSecond(0)
+    , nRenderThreads(0)
+    , tileSizePo2(0)
+    , compressedCacheTierSize(0)
+    {
+    }
+};
+
+/**
+ * @brief Measures the machine to recommend the settings that are otherwise tuned by hand for each hardware: the number of
+ * render threads, the tile size of the cache and the size of the compressed cache tier.
+ * The calibration kernel renders a 32-bit float RGBA HD frame by tiles on a given number of threads, in the same
+ * way as the render threads render the tiles of an image in the cache. The reference render is that kernel with
+ * the current settings compared to the recommended ones.
+ * The number of concurrent frames is not calibrated: the scheduler already adapts it during each render.
+ *
+ * This is run with the --calibrate command-line option or from the Threading page of the settings.
+ * It takes a few seconds and uses all the cores: it should be run on an otherwise idle machine.
+ **/
+class EngineCalibration
+{
+    Q_DECLARE_TR_FUNCTIONS(EngineCalibration)
+
+public:
+
+    /**
+     * @brief Runs the calibration. This is blocking and does not use the render thread pool.
+     **/
+    static void run(EngineCalibrationResults* results);
+
+    /**
+     * @brief Returns a human readable report of the measures and of the recommended settings
+     **/
+    static std::string getReport(const EngineCalibrationResults& results);
+
+    /**
+     * @brief Applies the recommended settings and saves them to the settings file.
+     * Returns true if a restart is needed for all of them to take effect.
+     **/
+    static bool apply(const EngineCalibrationResults& results);
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_ENGINECALIBRATION_H
@@ -68,6 +68,7 @@ class QString;
 class QStringList;
 class QTextStream;
 class QThread;
+class QThreadPool;
 class QTimer;
 class QUrl;
 class QWaitCondition;
@@ -141,9 +142,14 @@ class CacheEntryKeyBase;
 class CacheEntryBase;
 class CacheEntryLockerBase;
 template<bool persistent> class CacheEntryLocker;
+class ColorMatrix;
 class CompNodeItem;
 class CreateNodeArgs;
+class CudaDriver;
+class CudaImageStorage;
 class Curve;
+class CurveSnapshot;
+struct ParametricCurveLUT;
 class DimIdx;
 class DiskCacheNode;
 class DistortionFunction2D;
@@ -157,7 +163,10 @@ class ExistenceCheckerThread;
 class FileSystemItem;
 class FileSystemModel;
 class Format;
+class FrameEncodeQueue;
+class FrameStreamWriter;
 class FramebufferConfig;
+struct FrameViewPair;
 struct FrameViewRenderKey;
 class FrameViewRequest;
 class GLRendererID;
@@ -173,6 +182,8 @@ class GetRegionOfDefinitionKey;
 class GetRegionOfDefinitionResults;
 class GetDistortionKey;
 class GetDistortionResults;
+class GetRegionsOfInterestKey;
+class GetRegionsOfInterestResults;
 class GetFrameRangeKey;
 class GetFrameRangeResults;
 class GetFramesNeededKey;
@@ -222,7 +233,9 @@ class KnobItemsTable;
 class LayeredCompNode;
 class LibraryBinary;
 class LogEntry;
+class MemoryAccount;
 class MemoryFile;
+class MetricsServer;
 class ImageStorageBase;
 class CacheImageTileStorage;
 class MultiThread;
@@ -262,13 +275,18 @@ class ProjectBeingLoadedInfo;
 class PyPanelI;
 class RAMImageStorage;
 class ReadNode;
+class ReadNodePrefetcher;
 class RectD;
 class RectI;
+class RenderArena;
 class RenderEngine;
 class RenderStats;
 class RenderActionTLSData;
 class RotoDrawableItem;
 class RenderQueue;
+class RenderCoordinator;
+class RenderServer;
+class RenderWorker;
 class RequestPassSharedData;
 class RotoItem;
 class RotoLayer;
@@ -303,6 +321,7 @@ class TreeRender;
 class UndoCommand;
 class ViewIdx;
 class ViewerCurrentFrameRequestSchedulerStartArgs;
+class ViewerFlipbookCache;
 class ViewerInstance;
 class ViewerNode;
 class WriteNode;
@@ -331,12 +350,17 @@ typedef boost::shared_ptr<BezierCP> BezierCPPtr;
 typedef boost::shared_ptr<BufferedFrame> BufferedFramePtr;
 typedef boost::shared_ptr<BufferedFrameContainer> BufferedFrameContainerPtr;
 typedef boost::shared_ptr<CacheEntryLockerBase> CacheEntryLockerBasePtr;
+typedef boost::shared_ptr<ColorMatrix> ColorMatrixPtr;
 typedef boost::shared_ptr<CompNodeItem> CompNodeItemPtr;
 typedef boost::shared_ptr<CacheBase> CacheBasePtr;
 typedef boost::shared_ptr<Curve> CurvePtr;
+typedef boost::shared_ptr<const CurveSnapshot> CurveSnapshotConstPtr;
+typedef boost::shared_ptr<const ParametricCurveLUT> ParametricCurveLUTConstPtr;
 typedef boost::shared_ptr<CacheEntryKeyBase> CacheEntryKeyBasePtr;
 typedef boost::shared_ptr<CacheEntryBase> CacheEntryBasePtr;
 typedef boost::shared_ptr<CreateNodeArgs> CreateNodeArgsPtr;
+typedef boost::shared_ptr<CudaDriver> CudaDriverPtr;
+typedef boost::shared_ptr<CudaImageStorage> CudaImageStoragePtr;
 typedef boost::shared_ptr<DiskCacheNode> DiskCacheNodePtr;
 typedef boost::shared_ptr<DistortionFunction2D> DistortionFunction2DPtr;
 typedef boost::shared_ptr<Distortion2DStack> Distortion2DStackPtr;
@@ -345,6 +369,7 @@ typedef boost::shared_ptr<EffectInstance> EffectInstancePtr;
 typedef boost::shared_ptr<EffectInstance const> EffectInstanceConstPtr;
 typedef boost::shared_ptr<EffectInstanceTLSData> EffectInstanceTLSDataPtr;
 typedef boost::shared_ptr<EffectOpenGLContextData> EffectOpenGLContextDataPtr;
+typedef boost::shared_ptr<FrameStreamWriter> FrameStreamWriterPtr;
 typedef boost::shared_ptr<FrameViewRequest> FrameViewRequestPtr;
 typedef boost::shared_ptr<const FrameViewRequest> FrameViewRequestConstPtr;
 typedef boost::shared_ptr<FileSystemItem> FileSystemItemPtr;
@@ -355,6 +380,8 @@ typedef boost::shared_ptr<GetRegionOfDefinitionResults> GetRegionOfDefinitionRes
 typedef boost::shared_ptr<GetRegionOfDefinitionKey> GetRegionOfDefinitionKeyPtr;
 typedef boost::shared_ptr<GetDistortionResults> GetDistortionResultsPtr;
 typedef boost::shared_ptr<GetDistortionKey> GetDistortionKeyPtr;
+typedef boost::shared_ptr<GetRegionsOfInterestResults> GetRegionsOfInterestResultsPtr;
+typedef boost::shared_ptr<GetRegionsOfInterestKey> GetRegionsOfInterestKeyPtr;
 typedef boost::shared_ptr<GetFramesNeededKey> GetFramesNeededKeyPtr;
 typedef boost::shared_ptr<GetFramesNeededResults> GetFramesNeededResultsPtr;
 typedef boost::shared_ptr<GetFrameRangeKey> GetFrameRangeKeyPtr;
@@ -408,6 +435,7 @@ typedef boost::shared_ptr<NamedKnobHolder> NamedKnobHolderPtr;
 typedef boost::shared_ptr<NoOpBase> NoOpBasePtr;
 typedef boost::shared_ptr<ImageStorageBase> ImageStorageBasePtr;
 typedef boost::shared_ptr<CacheImageTileStorage> CacheImageTileStoragePtr;
+typedef boost::shared_ptr<MemoryAccount> MemoryAccountPtr;
 typedef boost::shared_ptr<MemoryFile> MemoryFilePtr;
 typedef boost::shared_ptr<Node> NodePtr;
 typedef boost::shared_ptr<Node const> NodeConstPtr;
@@ -430,6 +458,7 @@ typedef boost::shared_ptr<PluginGroupNode> PluginGroupNodePtr;
 typedef boost::shared_ptr<PluginMemory> PluginMemoryPtr;
 typedef boost::shared_ptr<RAMImageStorage> RAMImageStoragePtr;
 typedef boost::shared_ptr<ReadNode> ReadNodePtr;
+typedef boost::shared_ptr<RenderArena> RenderArenaPtr;
 typedef boost::shared_ptr<RenderEngine> RenderEnginePtr;
 typedef boost::shared_ptr<RenderActionTLSData> RenderActionTLSDataPtr;
 typedef boost::shared_ptr<RequestPassSharedData> RequestPassSharedDataPtr;
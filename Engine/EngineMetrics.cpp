@@ -0,0 +1,352 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "EngineMetrics.h"
+
+#include <set>
+#include <map>
+#include <sstream>
+
+#include <QtCore/QMutex>
+#include <QtCore/QThreadPool>
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/Cache.h"
+#include "Engine/FrameEncodeQueue.h"
+#include "Engine/MemoryInfo.h"
+#include "Engine/OutputSchedulerThread.h"
+#include "Engine/RenderQueue.h"
+
+NATRON_NAMESPACE_ENTER;
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// Upper bounds in seconds of the buckets of the frame render time histogram
+const double frameRenderTimeBuckets[] = { 0.05, 0.1, 0.25, 0.5, 1., 2.5, 5., 10., 30., 60., 120., 300. };
+const int nFrameRenderTimeBuckets = (int)( sizeof(frameRenderTimeBuckets) / sizeof(frameRenderTimeBuckets[0]) );
+
+// Upper bounds in seconds of the buckets of the histogram of the time between a scheduler task request and its start
+const double taskStartLatencyBuckets[] = { 0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1. };
+const int nTaskStartLatencyBuckets = (int)( sizeof(taskStartLatencyBuckets) / sizeof(taskStartLatencyBuckets[0]) );
+
+struct EngineMetricsData
+{
+    // Protects schedulers. It is held while the schedulers are read so that they cannot be destroyed meanwhile
+    QMutex schedulersLock;
+    std::set<OutputSchedulerThread*> schedulers;
+
+    // Protects the counters below. It is never held while taking another lock:
+    // the counters are updated by the schedulers while they hold their own locks
+    QMutex countersLock;
+    U64 nFramesRendered;
+    U64 nRenderFailures;
+
+    // Number of frames in each bucket of frameRenderTimeBuckets (not cumulative), the last one counts the frames above the last bound
+    U64 frameRenderTimeCounts[nFrameRenderTimeBuckets + 1];
+    double frameRenderTimeSum;
+
+    // Same for taskStartLatencyBuckets
+    U64 taskStartLatencyCounts[nTaskStartLatencyBuckets + 1];
+    double taskStartLatencySum;
+
+    EngineMetricsData()
+    : schedulersLock()
+    , schedulers()
+    , countersLock()
+    , nFramesRendered(0)
+    , nRenderFailures(0)
+    , frameRenderTimeSum(0)
+    , taskStartLatencySum(0)
+    {
+        for (int i = 0; i <= nFrameRenderTimeBuckets; ++i) {
+            frameRenderTimeCounts[i] = 0;
+        }
+        for (int i = 0; i <= nTaskStartLatencyBuckets; ++i) {
+            taskStartLatencyCounts[i] = 0;
+        }
+    }
+};
+
+EngineMetricsData&
+getMetricsData()
+{
+    static EngineMetricsData data;
+    return data;
+}
+
+void
+writeMetricHeader(std::ostream& os,
+                  const char* name,
+                  const char* type,
+                  const char* help)
+{
+    os << "# HELP " << name << ' ' << help << '\n';
+    os << "# TYPE " << name << ' ' << type << '\n';
+}
+
+void
+writeHistogram(std::ostream& os,
+               const char* name,
+               const char* help,
+               const double* buckets,
+               int nBuckets,
+               const U64* counts,
+               double sum)
+{
+    writeMetricHeader(os, name, "histogram", help);
+    U64 cumulativeCount = 0;
+    for (int i = 0; i < nBuckets; ++i) {
+        cumulativeCount += counts[i];
+        os << name << "_bucket{le=\"" << buckets[i] << "\"} " << cumulativeCount << '\n';
+    }
+    cumulativeCount += counts[nBuckets];
+    os << name << "_bucket{le=\"+Inf\"} " << cumulativeCount << '\n';
+    os << name << "_sum " << sum << '\n';
+    os << name << "_count " << cumulativeCount << '\n';
+}
+
+template <typename T>
+void
+writeMetric(std::ostream& os,
+            const char* name,
+            const char* type,
+            const char* help,
+            T value)
+{
+    writeMetricHeader(os, name, type, help);
+    os << name << ' ' << value << '\n';
+}
+
+struct CacheMetrics
+{
+    const char* label;
+    std::size_t size, maxSize;
+    CacheReportInfo totals;
+};
+
+void
+getCacheMetrics(const CacheBasePtr& cache,
+                const char* label,
+                std::vector<CacheMetrics>* metrics)
+{
+    if (!cache) {
+        return;
+    }
+    CacheMetrics m;
+    m.label = label;
+    m.size = cache->getCurrentSize();
+    m.maxSize = cache->getMaximumCacheSize();
+
+    std::map<std::string, CacheReportInfo> infos;
+    cache->getMemoryStats(&infos);
+    for (std::map<std::string, CacheReportInfo>::const_iterator it = infos.begin(); it != infos.end(); ++it) {
+        m.totals.nEntries += it->second.nEntries;
+        m.totals.nHits += it->second.nHits;
+        m.totals.nMisses += it->second.nMisses;
+        m.totals.nPendingWaits += it->second.nPendingWaits;
+        m.totals.pendingWaitTimeMS += it->second.pendingWaitTimeMS;
+        m.totals.nEvictions += it->second.nEvictions;
+    }
+    metrics->push_back(m);
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+void
+EngineMetrics::registerScheduler(OutputSchedulerThread* scheduler)
+{
+    EngineMetricsData& data = getMetricsData();
+    QMutexLocker k(&data.schedulersLock);
+    data.schedulers.insert(scheduler);
+}
+
+void
+EngineMetrics::unregisterScheduler(OutputSchedulerThread* scheduler)
+{
+    EngineMetricsData& data = getMetricsData();
+    QMutexLocker k(&data.schedulersLock);
+    data.schedulers.erase(scheduler);
+}
+
+void
+EngineMetrics::addFrameRendered(double renderTime)
+{
+    int bucket = 0;
+    while ( (bucket < nFrameRenderTimeBuckets) && (renderTime > frameRenderTimeBuckets[bucket]) ) {
+        ++bucket;
+    }
+
+    EngineMetricsData& data = getMetricsData();
+    QMutexLocker k(&data.countersLock);
+    ++data.nFramesRendered;
+    ++data.frameRenderTimeCounts[bucket];
+    data.frameRenderTimeSum += renderTime;
+}
+
+void
+EngineMetrics::addRenderFailure()
+{
+    EngineMetricsData& data = getMetricsData();
+    QMutexLocker k(&data.countersLock);
+    ++data.nRenderFailures;
+}
+
+void
+EngineMetrics::addSchedulerTaskStartLatency(double latency)
+{
+    int bucket = 0;
+    while ( (bucket < nTaskStartLatencyBuckets) && (latency > taskStartLatencyBuckets[bucket]) ) {
+        ++bucket;
+    }
+
+    EngineMetricsData& data = getMetricsData();
+    QMutexLocker k(&data.countersLock);
+    ++data.taskStartLatencyCounts[bucket];
+    data.taskStartLatencySum += latency;
+}
+
+std::string
+EngineMetrics::toPrometheusText()
+{
+    EngineMetricsData& data = getMetricsData();
+
+    // Copy the counters so that the lock is not held while reading the rest
+    U64 nFramesRendered, nRenderFailures;
+    U64 frameRenderTimeCounts[nFrameRenderTimeBuckets + 1];
+    double frameRenderTimeSum;
+    U64 taskStartLatencyCounts[nTaskStartLatencyBuckets + 1];
+    double taskStartLatencySum;
+    {
+        QMutexLocker k(&data.countersLock);
+        nFramesRendered = data.nFramesRendered;
+        nRenderFailures = data.nRenderFailures;
+        for (int i = 0; i <= nFrameRenderTimeBuckets; ++i) {
+            frameRenderTimeCounts[i] = data.frameRenderTimeCounts[i];
+        }
+        frameRenderTimeSum = data.frameRenderTimeSum;
+        for (int i = 0; i <= nTaskStartLatencyBuckets; ++i) {
+            taskStartLatencyCounts[i] = data.taskStartLatencyCounts[i];
+        }
+        taskStartLatencySum = data.taskStartLatencySum;
+    }
+
+    int nRenderThreads = 0, nActiveRenderThreads = 0, nQueuedEncodes = 0, nActiveSchedulers = 0;
+    {
+        QMutexLocker k(&data.schedulersLock);
+        for (std::set<OutputSchedulerThread*>::const_iterator it = data.schedulers.begin(); it != data.schedulers.end(); ++it) {
+            nRenderThreads += (*it)->getNRenderThreads();
+            nActiveRenderThreads += (*it)->getNActiveRenderThreads();
+            if ( (*it)->isWorking() ) {
+                ++nActiveSchedulers;
+            }
+            FrameEncodeQueue* encodeQueue = (*it)->getFrameEncodeQueue();
+            if (encodeQueue) {
+                nQueuedEncodes += encodeQueue->getNumQueuedFrames();
+            }
+        }
+    }
+
+    int nQueuedRenders = 0, nActiveQueuedRenders = 0;
+    const AppInstanceVec& apps = appPTR->getAppInstances();
+    for (AppInstanceVec::const_iterator it = apps.begin(); it != apps.end(); ++it) {
+        RenderQueuePtr queue = (*it)->getRenderQueue();
+        if (queue) {
+            nQueuedRenders += queue->getNumQueuedRenders();
+            nActiveQueuedRenders += queue->getNumActiveRenders();
+        }
+    }
+
+    std::vector<CacheMetrics> caches;
+    getCacheMetrics(appPTR->getTileCache(), "tile", &caches);
+    getCacheMetrics(appPTR->getGeneralPurposeCache(), "general", &caches);
+
+    std::ostringstream os;
+    // Enough digits for the sums of render times to be exact
+    os.precision(15);
+
+    writeMetricHeader(os, "natron_build_info", "gauge", "Version of Natron and whether it runs in background mode.");
+    os << "natron_build_info{version=\"" << NATRON_VERSION_STRING << "\",background=\"" << ( appPTR->isBackground() ? "true" : "false" ) << "\"} 1\n";
+
+    writeMetric(os, "natron_frames_rendered_total", "counter", "Frames rendered by all renders and playbacks.", nFramesRendered);
+    writeMetric(os, "natron_render_failures_total", "counter", "Renders that failed.", nRenderFailures);
+
+    writeHistogram(os, "natron_frame_render_seconds", "Time spent rendering each frame.",
+                   frameRenderTimeBuckets, nFrameRenderTimeBuckets, frameRenderTimeCounts, frameRenderTimeSum);
+    writeHistogram(os, "natron_scheduler_task_start_seconds", "Time between the request of a render, playback or tracking task and its start by the scheduler thread.",
+                   taskStartLatencyBuckets, nTaskStartLatencyBuckets, taskStartLatencyCounts, taskStartLatencySum);
+
+    writeMetric(os, "natron_schedulers_active", "gauge", "Renders and playbacks in progress.", nActiveSchedulers);
+    writeMetric(os, "natron_render_threads", "gauge", "Render threads of all renders and playbacks.", nRenderThreads);
+    writeMetric(os, "natron_render_threads_active", "gauge", "Render threads currently rendering a frame.", nActiveRenderThreads);
+    writeMetric(os, "natron_encode_queue_depth", "gauge", "Rendered frames waiting to be encoded by a writer.", nQueuedEncodes);
+    writeMetric(os, "natron_render_queue_depth", "gauge", "Renders waiting in the render queue.", nQueuedRenders);
+    writeMetric(os, "natron_render_queue_active", "gauge", "Renders of the render queue in progress.", nActiveQueuedRenders);
+
+    QThreadPool* threadPool = QThreadPool::globalInstance();
+    writeMetric(os, "natron_thread_pool_active_threads", "gauge", "Threads of the global thread pool running a task.", threadPool->activeThreadCount());
+    writeMetric(os, "natron_thread_pool_max_threads", "gauge", "Maximum number of threads of the global thread pool.", threadPool->maxThreadCount());
+
+    writeMetricHeader(os, "natron_cache_size_bytes", "gauge", "Memory used by the cache.");
+    for (std::size_t i = 0; i < caches.size(); ++i) {
+        os << "natron_cache_size_bytes{cache=\"" << caches[i].label << "\"} " << (U64)caches[i].size << '\n';
+    }
+    writeMetricHeader(os, "natron_cache_max_size_bytes", "gauge", "Maximum size of the cache.");
+    for (std::size_t i = 0; i < caches.size(); ++i) {
+        os << "natron_cache_max_size_bytes{cache=\"" << caches[i].label << "\"} " << (U64)caches[i].maxSize << '\n';
+    }
+    writeMetricHeader(os, "natron_cache_entries", "gauge", "Entries in the cache.");
+    for (std::size_t i = 0; i < caches.size(); ++i) {
+        os << "natron_cache_entries{cache=\"" << caches[i].label << "\"} " << caches[i].totals.nEntries << '\n';
+    }
+    writeMetricHeader(os, "natron_cache_hits_total", "counter", "Cache look-ups that found the entry.");
+    for (std::size_t i = 0; i < caches.size(); ++i) {
+        os << "natron_cache_hits_total{cache=\"" << caches[i].label << "\"} " << caches[i].totals.nHits << '\n';
+    }
+    writeMetricHeader(os, "natron_cache_misses_total", "counter", "Cache look-ups that had to compute the entry.");
+    for (std::size_t i = 0; i < caches.size(); ++i) {
+        os << "natron_cache_misses_total{cache=\"" << caches[i].label << "\"} " << caches[i].totals.nMisses << '\n';
+    }
+    writeMetricHeader(os, "natron_cache_pending_waits_total", "counter", "Cache look-ups that waited for another thread to compute the entry.");
+    for (std::size_t i = 0; i < caches.size(); ++i) {
+        os << "natron_cache_pending_waits_total{cache=\"" << caches[i].label << "\"} " << caches[i].totals.nPendingWaits << '\n';
+    }
+    writeMetricHeader(os, "natron_cache_pending_wait_seconds_total", "counter", "Time spent waiting for another thread to compute a cache entry.");
+    for (std::size_t i = 0; i < caches.size(); ++i) {
+        os << "natron_cache_pending_wait_seconds_total{cache=\"" << caches[i].label << "\"} " << caches[i].totals.pendingWaitTimeMS / 1000. << '\n';
+    }
+    writeMetricHeader(os, "natron_cache_evictions_total", "counter", "Entries evicted from the cache.");
+    for (std::size_t i = 0; i < caches.size(); ++i) {
+        os << "natron_cache_evictions_total{cache=\"" << caches[i].label << "\"} " << caches[i].totals.nEvictions << '\n';
+    }
+
+    writeMetric(os, "natron_process_resident_memory_bytes", "gauge", "Resident memory of the process.", (U64)getCurrentRSS());
+    writeMetric(os, "natron_process_peak_resident_memory_bytes", "gauge", "Peak resident memory of the process.", (U64)getPeakRSS());
+    writeMetric(os, "natron_system_memory_bytes", "gauge", "Total RAM of the system.", getSystemTotalRAM());
+    writeMetric(os, "natron_pending_deletion_bytes", "gauge", "Memory of the cache entries waiting to be deleted.", (U64)appPTR->getPendingDeletionBytes());
+
+    return os.str();
+} // toPrometheusText
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,78 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_ENGINEMETRICS_H
+#define NATRON_ENGINE_ENGINEMETRICS_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <string>
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Collects the metrics of the engine served by the MetricsServer: the counters updated by the renders
+ * (frames rendered, frame render times, failures) and the current state of the render schedulers, the render queues,
+ * the caches and the memory, which are read when the metrics are requested.
+ * All functions are MT-safe.
+ **/
+class EngineMetrics
+{
+public:
+
+    /**
+     * @brief Called by each OutputSchedulerThread when it is created and destroyed, to report its render threads
+     **/
+    static void registerScheduler(OutputSchedulerThread* scheduler);
+    static void unregisterScheduler(OutputSchedulerThread* scheduler);
+
+    /**
+     * @brief Called when a frame is rendered by a scheduler, renderTime is the time spent rendering it in seconds
+     **/
+    static void addFrameRendered(double renderTime);
+
+    /**
+     * @brief Called when a render fails
+     **/
+    static void addRenderFailure();
+
+    /**
+     * @brief Called by a GenericSchedulerThread when it starts a task, latency is the time in seconds since the task was requested
+     **/
+    static void addSchedulerTaskStartLatency(double latency);
+
+    /**
+     * @brief Returns all the metrics in the Prometheus text exposition format (version 0.0.4).
+     * This must be called on the main thread since it reads the application instances.
+     **/
+    static std::string toPrometheusText();
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_ENGINEMETRICS_H
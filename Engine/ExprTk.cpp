@@ -458,12 +458,16 @@ struct random
         , lastRandomHash(0)
     {
         exprtk::enable_zero_parameters(*this);
+        reset(time);
+    }
+
+    // Restart the sequence of random numbers for the given time
+    void reset(TimeValue time)
+    {
         // Make the hash vary from time
-        {
-            alias_cast_float ac;
-            ac.data = (float)time;
-            lastRandomHash = ac.raw;
-        }
+        alias_cast_float ac;
+        ac.data = (float)time;
+        lastRandomHash = ac.raw;
     }
     
     virtual exprtk_scalar_t operator()(const std::size_t& overloadIdx,
@@ -504,13 +508,17 @@ struct randomInt
     randomInt(TimeValue time)
         : exprtk_igeneric_function_t("Z|T|TTT")
         , lastRandomHash(0)
+    {
+        reset(time);
+    }
+
+    // Restart the sequence of random numbers for the given time
+    void reset(TimeValue time)
     {
         // Make the hash vary from time
-        {
-            alias_cast_float ac;
-            ac.data = (float)time;
-            lastRandomHash += ac.raw;
-        }
+        alias_cast_float ac;
+        ac.data = (float)time;
+        lastRandomHash = ac.raw;
     }
     virtual exprtk_scalar_t operator()(const std::size_t& overloadIdx,
                                        parameter_list_t parameters) OVERRIDE FINAL
@@ -635,22 +643,21 @@ addGenericFunctions(TimeValue time,
     }
 }
 
-// Some functions (random) hold an internal state. Instead of using the same state for all threads,
-// We create a copy of the function update in this symbol table
+// Some functions (random) hold an internal state. The functions are already local to the thread
+// since each thread compiles its own expression: reset their state so that evaluating
+// the expression at a given time always returns the same result.
+// The compiled expression references the function objects registered at compile time, so they
+// must be reset in place rather than replaced in the symbol table.
 void
-makeLocalCopyOfStateFunctions(TimeValue time,
-                              exprtk_symbol_table_t& symbol_table,
-                              exprtk_igeneric_function_table_t* functions)
+resetStateFunctions(TimeValue time,
+                    const exprtk_igeneric_function_table_t& functions)
 {
-    symbol_table.remove_function("random");
-    symbol_table.remove_function("randomInt");
-    {
-        shared_ptr<exprtk_igeneric_function_t> ptr( new random(time) );
-        functions->push_back( make_pair("random", ptr) );
-    }
-    {
-        shared_ptr<exprtk_igeneric_function_t> ptr( new randomInt(time) );
-        functions->push_back( make_pair("randomInt", ptr) );
+    for (exprtk_igeneric_function_table_t::const_iterator it = functions.begin(); it != functions.end(); ++it) {
+        if (it->first == "random") {
+            static_cast<random*>( it->second.get() )->reset(time);
+        } else if (it->first == "randomInt") {
+            static_cast<randomInt*>( it->second.get() )->reset(time);
+        }
     }
 }
 
@@ -1655,16 +1662,15 @@ KnobHelper::executeExprTkExpression(TimeValue time,
         // Update the frame & view in the know table
         symbol_table->variable_ref("frame") = (double)time;
 
-        // Remove from the symbol table functions that hold a state, and re-add a new fresh local copy of them so that the state
-        // is local to this thread.
-        makeLocalCopyOfStateFunctions(time, *symbol_table, &data->genericFunctions);
+        // Reset the functions that hold a state for this time
+        resetStateFunctions(time, data->genericFunctions);
     } else {
         double time_f = (double)time;
         symbol_table->create_variable("frame", time_f);
         string viewName = getHolder()->getApp()->getProject()->getViewName(view);
         symbol_table->create_stringvar("view", viewName);
 
-        addStandardFunctions(obj->expressionString, time, *symbol_table, data->functions, data->varargFunctions, data->genericFunctions, 0);
+        addStandardFunctions(obj->exprtkExpression, time, *symbol_table, data->functions, data->varargFunctions, data->genericFunctions, 0);
 
 
         KnobIPtr thisShared = shared_from_this();
@@ -1687,7 +1693,7 @@ KnobHelper::executeExprTkExpression(TimeValue time,
         parser.enable_unknown_symbol_resolver(&musr);
 
         string error;
-        if ( !parseExprtkExpression(obj->expressionString, obj->modifiedExpression, parser, *data->expressionObject, &error) ) {
+        if ( !parseExprtkExpression(obj->exprtkExpression, obj->modifiedExpression, parser, *data->expressionObject, &error) ) {
             return KnobHelper::eExpressionReturnValueTypeError;
         }
     } else {
@@ -25,6 +25,9 @@
 #include "FileSystemModel.h"
 
 #include <vector>
+#include <list>
+#include <set>
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 
@@ -45,14 +48,138 @@ CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QDebug>
 #include <QtCore/QUrl>
 #include <QtCore/QMimeData>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
 #include <SequenceParsing.h>
 
+// Number of files of a directory parsed and grouped in sequences by the same task
+#define NATRON_FILESYSTEM_GROUPING_CHUNK_SIZE 2048
+
+// Number of directory listings kept in the listing cache
+#define NATRON_FILESYSTEM_LISTING_CACHE_MAX_ENTRIES 64
+
+// Listings of directories modified less than this number of seconds ago are not cached:
+// the modification time of a directory has a one second resolution on most file systems
+#define NATRON_FILESYSTEM_LISTING_CACHE_MIN_AGE_SECS 2
+
 
 NATRON_NAMESPACE_ENTER;
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+struct DirectoryListing
+{
+    QDateTime lastModified;
+    QFileInfoList entries;
+
+    // Value of DirectoryListingCache::accessCount when the listing was last used
+    U64 lastAccess;
+};
+
+/**
+ * @brief The listings of the directories last browsed, so that going back to a directory (or opening a new dialog in it)
+ * does not list it again. A listing is valid as long as the modification time of the directory did not change.
+ **/
+struct DirectoryListingCache
+{
+    QMutex lock;
+    std::map<QString, DirectoryListing> listings;
+    U64 accessCount;
+
+    DirectoryListingCache()
+        : lock()
+        , listings()
+        , accessCount(0)
+    {
+    }
+};
+
+DirectoryListingCache&
+getDirectoryListingCache()
+{
+    static DirectoryListingCache cache;
+
+    return cache;
+}
+
+QString
+getDirectoryListingKey(const QString& path,
+                       QDir::Filters filters,
+                       QDir::SortFlags sort)
+{
+    return path + QLatin1Char('|') + QString::number( (int)filters ) + QLatin1Char('|') + QString::number( (int)sort );
+}
+
+QFileInfoList
+listDirectory(const QString& path,
+              QDir::Filters filters,
+              QDir::SortFlags sort)
+{
+    QDateTime lastModified = QFileInfo(path).lastModified();
+    QString key = getDirectoryListingKey(path, filters, sort);
+    DirectoryListingCache& cache = getDirectoryListingCache();
+    {
+        QMutexLocker k(&cache.lock);
+        std::map<QString, DirectoryListing>::iterator found = cache.listings.find(key);
+        if ( found != cache.listings.end() ) {
+            if ( lastModified.isValid() && (found->second.lastModified == lastModified) ) {
+                found->second.lastAccess = ++cache.accessCount;
+
+                return found->second.entries;
+            }
+            cache.listings.erase(found);
+        }
+    }
+
+    // List outside of the lock: this may take a while on a network directory
+    QFileInfoList entries = QDir(path).entryInfoList(filters, sort);
+
+    if ( !lastModified.isValid() || ( lastModified.secsTo( QDateTime::currentDateTime() ) < NATRON_FILESYSTEM_LISTING_CACHE_MIN_AGE_SECS ) ) {
+        // The directory may be modified again within the resolution of its modification time
+        return entries;
+    }
+
+    QMutexLocker k(&cache.lock);
+    if ( (int)cache.listings.size() >= NATRON_FILESYSTEM_LISTING_CACHE_MAX_ENTRIES ) {
+        std::map<QString, DirectoryListing>::iterator leastRecentlyUsed = cache.listings.begin();
+        for (std::map<QString, DirectoryListing>::iterator it = cache.listings.begin(); it != cache.listings.end(); ++it) {
+            if (it->second.lastAccess < leastRecentlyUsed->second.lastAccess) {
+                leastRecentlyUsed = it;
+            }
+        }
+        cache.listings.erase(leastRecentlyUsed);
+    }
+    DirectoryListing& listing = cache.listings[key];
+    listing.lastModified = lastModified;
+    listing.entries = entries;
+    listing.lastAccess = ++cache.accessCount;
+
+    return entries;
+} // listDirectory
+
+/**
+ * @brief Removes all the cached listings of the given directory
+ **/
+void
+invalidateDirectoryListing(const QString& path)
+{
+    QString prefix = path + QLatin1Char('|');
+    DirectoryListingCache& cache = getDirectoryListingCache();
+    QMutexLocker k(&cache.lock);
+
+    for (std::map<QString, DirectoryListing>::iterator it = cache.listings.begin(); it != cache.listings.end();) {
+        if ( it->first.startsWith(prefix) ) {
+            cache.listings.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 static QStringList
 getSplitPath(const QString& path)
 {
@@ -1296,6 +1423,10 @@ FileSystemModel::onWatchedFileChanged(const QString& file)
 {
     ///Get the item corresponding to the current directory
     QFileInfo info(file);
+
+    // The modification time of the directory does not change when a file is modified in place
+    invalidateDirectoryListing( info.absolutePath() );
+
     FileSystemItemPtr parent = _imp->getItemFromPath( info.absolutePath() );
 
     if (parent) {
@@ -1389,6 +1520,16 @@ struct FileGathererThreadPrivate
         return false;
     }
 
+    /**
+     * @brief Same as checkForAbort() but does not acknowledge the abort request: this may be called from any thread.
+     **/
+    bool isAbortRequested() const
+    {
+        QMutexLocker k(&abortRequestsMutex);
+
+        return abortRequests > 0;
+    }
+
     bool checkForAbort()
     {
         QMutexLocker k(&abortRequestsMutex);
@@ -1521,7 +1662,9 @@ FileGathererThread::run()
     }
 }
 
-static bool
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+bool
 isVideoFileExtension(const std::string& ext)
 {
     if ( (ext == "mov") ||
@@ -1544,26 +1687,168 @@ isVideoFileExtension(const std::string& ext)
     return false;
 }
 
-typedef std::list< std::pair< SequenceParsing::SequenceFromFilesPtr, QFileInfo > > FileSequences;
+struct SequenceGroup
+{
+    SequenceParsing::SequenceFromFilesPtr sequence;
+
+    // Indices of the files of the sequence, the first one first
+    std::vector<int> files;
+
+    // False if no other file may be inserted in the sequence
+    bool canBeGrouped;
+};
+
+// A range of consecutive files grouped in sequences by the same task
+struct SequenceGroupingChunk
+{
+    const std::vector<std::string>* files;
+    const std::vector<bool>* canBeGrouped;
+    bool checkPath;
+    bool enableSizeEstimation;
+    int begin, end;
+
+    // Filled by the task: the parsed files of the chunk, indexed from begin
+    std::vector<SequenceParsing::FileNameContent> contents;
+    std::list<SequenceGroup> groups;
+
+    // If not NULL, the task returns early when an abort is requested on the gatherer
+    const FileGathererThreadPrivate* gatherer;
+};
+
+void
+groupChunkInSequences(SequenceGroupingChunk& chunk)
+{
+    chunk.contents.reserve(chunk.end - chunk.begin);
+    for (int i = chunk.begin; i < chunk.end; ++i) {
+        if ( chunk.gatherer && ( (i - chunk.begin) % 256 == 0 ) && chunk.gatherer->isAbortRequested() ) {
+            return;
+        }
+
+        chunk.contents.push_back( SequenceParsing::FileNameContent( (*chunk.files)[i] ) );
+        const SequenceParsing::FileNameContent& fileContent = chunk.contents.back();
+        bool canBeGrouped = (*chunk.canBeGrouped)[i];
+
+        if (canBeGrouped) {
+            ///Note that we use a reverse iterator because we have more chance to find a match in the last recently added entries
+            bool foundMatchingSequence = false;
+            for (std::list<SequenceGroup>::reverse_iterator it = chunk.groups.rbegin(); it != chunk.groups.rend(); ++it) {
+                if ( it->canBeGrouped && it->sequence->tryInsertFile(fileContent, chunk.checkPath) ) {
+                    it->files.push_back(i);
+                    foundMatchingSequence = true;
+                    break;
+                }
+            }
+            if (foundMatchingSequence) {
+                continue;
+            }
+        }
+
+        SequenceGroup group;
+        group.sequence.reset( new SequenceParsing::SequenceFromFiles(fileContent, chunk.enableSizeEstimation) );
+        group.files.push_back(i);
+        group.canBeGrouped = canBeGrouped;
+        chunk.groups.push_back(group);
+    }
+} // groupChunkInSequences
+
+/**
+ * @brief Implementation of FileSystemModel::groupFilesInSequences(). Returns false if aborted by the gatherer.
+ **/
+bool
+groupFilesInSequencesInternal(const std::vector<std::string>& files,
+                              const std::vector<bool>& canBeGrouped,
+                              bool checkPath,
+                              bool enableSizeEstimation,
+                              const FileGathererThreadPrivate* gatherer,
+                              std::vector<std::pair<SequenceParsing::SequenceFromFilesPtr, int> >* sequences)
+{
+    assert( files.size() == canBeGrouped.size() );
+    int nFiles = (int)files.size();
+    std::vector<SequenceGroupingChunk> chunks( (nFiles + NATRON_FILESYSTEM_GROUPING_CHUNK_SIZE - 1) / NATRON_FILESYSTEM_GROUPING_CHUNK_SIZE );
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        chunks[i].files = &files;
+        chunks[i].canBeGrouped = &canBeGrouped;
+        chunks[i].checkPath = checkPath;
+        chunks[i].enableSizeEstimation = enableSizeEstimation;
+        chunks[i].begin = (int)i * NATRON_FILESYSTEM_GROUPING_CHUNK_SIZE;
+        chunks[i].end = std::min(chunks[i].begin + NATRON_FILESYSTEM_GROUPING_CHUNK_SIZE, nFiles);
+        chunks[i].gatherer = gatherer;
+    }
+
+    // Parsing the file names is what takes most of the time: parse and group each chunk concurrently
+    if (chunks.size() > 1) {
+        QtConcurrent::blockingMap(chunks, groupChunkInSequences);
+    } else if ( !chunks.empty() ) {
+        groupChunkInSequences(chunks[0]);
+    }
+
+    if ( gatherer && gatherer->isAbortRequested() ) {
+        return false;
+    }
+
+    // Merge the sequences of each chunk with the sequences of the previous chunks: a sequence usually spans several chunks
+    std::list<SequenceGroup> merged;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        SequenceGroupingChunk& chunk = chunks[i];
+        for (std::list<SequenceGroup>::iterator itGroup = chunk.groups.begin(); itGroup != chunk.groups.end(); ++itGroup) {
+            std::list<SequenceGroup>::reverse_iterator mergedWith = merged.rend();
+            if (itGroup->canBeGrouped) {
+                const SequenceParsing::FileNameContent& firstFile = chunk.contents[itGroup->files.front() - chunk.begin];
+                for (std::list<SequenceGroup>::reverse_iterator it = merged.rbegin(); it != merged.rend(); ++it) {
+                    if ( it->canBeGrouped && it->sequence->tryInsertFile(firstFile, checkPath) ) {
+                        mergedWith = it;
+                        break;
+                    }
+                }
+            }
+            if ( mergedWith == merged.rend() ) {
+                merged.push_back(*itGroup);
+                continue;
+            }
+            for (std::size_t j = 1; j < itGroup->files.size(); ++j) {
+                const SequenceParsing::FileNameContent& file = chunk.contents[itGroup->files[j] - chunk.begin];
+                if ( !mergedWith->sequence->tryInsertFile(file, checkPath) ) {
+                    // Should not happen since the file matched a sequence of the same pattern
+                    SequenceGroup group;
+                    group.sequence.reset( new SequenceParsing::SequenceFromFiles(file, enableSizeEstimation) );
+                    group.files.push_back(itGroup->files[j]);
+                    group.canBeGrouped = true;
+                    merged.push_back(group);
+                }
+            }
+        }
+        // Release the parsed files of the chunk as soon as possible, there may be a lot of them
+        chunk.contents.clear();
+        chunk.groups.clear();
+    }
 
-#define KERNEL_INCR() \
-    switch (viewOrder) \
-    { \
-    case Qt::AscendingOrder: \
-        ++i; \
-        break; \
-    case Qt::DescendingOrder: \
-        --i; \
-        break; \
+    sequences->clear();
+    sequences->reserve( merged.size() );
+    for (std::list<SequenceGroup>::const_iterator it = merged.begin(); it != merged.end(); ++it) {
+        sequences->push_back( std::make_pair(it->sequence, it->files.front()) );
     }
 
+    return true;
+} // groupFilesInSequencesInternal
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+void
+FileSystemModel::groupFilesInSequences(const std::vector<std::string>& files,
+                                       const std::vector<bool>& canBeGrouped,
+                                       bool checkPath,
+                                       bool enableSizeEstimation,
+                                       std::vector<std::pair<SequenceParsing::SequenceFromFilesPtr, int> >* sequences)
+{
+    ignore_result( groupFilesInSequencesInternal(files, canBeGrouped, checkPath, enableSizeEstimation, 0, sequences) );
+}
+
 void
 FileGathererThread::gatheringKernel(const FileSystemItemPtr& item)
 {
     if (!item) {
         return;
     }
-    QDir dir( item->absoluteFilePath() );
     FileSystemModelPtr model = _imp->getModel();
     if (!model) {
         return;
@@ -1592,76 +1877,76 @@ FileGathererThread::gatheringKernel(const FileSystemItemPtr& item)
     sort |= QDir::DirsFirst;
 
     ///All entries in the directory
-    QFileInfoList all = dir.entryInfoList(model->filter(), sort);
-
-    ///List of all possible file sequences in the directory or directories
-    FileSequences sequences;
-    int start = 0;
-    int end = 0;
-    switch (viewOrder) {
-    case Qt::AscendingOrder:
-        start = 0;
-        end = all.size();
-        break;
-    case Qt::DescendingOrder:
-        start = all.size() - 1;
-        end = -1;
-        break;
+    QFileInfoList all = listDirectory(item->absoluteFilePath(), model->filter(), sort);
+
+    if ( _imp->checkForAbort() ) {
+        return;
     }
 
-    int i = start;
-    while (i != end) {
-        ///If we must abort we do it now
-        if ( _imp->checkForAbort() ) {
-            return;
+    ///The entries to display in the order of the view: directories and files accepted by the regexps
+    std::vector<int> entries;
+    entries.reserve( all.size() );
+    for (int i = 0; i < all.size(); ++i) {
+        int entry = viewOrder == Qt::AscendingOrder ? i : all.size() - 1 - i;
+        /// If the item does not match the filter regexp set by the user, discard it
+        if ( all[entry].isDir() || model->isAcceptedByRegexps( all[entry].fileName() ) ) {
+            entries.push_back(entry);
         }
+    }
 
-        if ( all[i].isDir() ) {
-            ///This is a directory
-            sequences.push_back( std::make_pair(SequenceParsing::SequenceFromFilesPtr(), all[i]) );
-        } else {
-            QString filename = all[i].fileName();
-            /// If the item does not match the filter regexp set by the user, discard it
-            if ( !model->isAcceptedByRegexps(filename) ) {
-                KERNEL_INCR();
-                continue;
-            }
+    ///If file sequence fetching is disabled, files are displayed as is
+    if ( !model->isSequenceModeEnabled() ) {
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            item->addChild(SequenceParsing::SequenceFromFilesPtr(), all[entries[i]]);
+        }
+        Q_EMIT directoryLoaded( item->absoluteFilePath() );
 
-            /// If file sequence fetching is disabled, accept it
-            if ( !model->isSequenceModeEnabled() ) {
-                sequences.push_back( std::make_pair(SequenceParsing::SequenceFromFilesPtr(), all[i]) );
-                KERNEL_INCR();
-                continue;
-            }
+        return;
+    }
 
-            std::string absoluteFilePath = generateChildAbsoluteName(item.get(), filename).toStdString();
-            bool foundMatchingSequence = false;
+    ///Group the files in sequences
+    std::vector<std::string> files;
+    std::vector<bool> canBeGrouped;
+    files.reserve( entries.size() );
+    canBeGrouped.reserve( entries.size() );
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const QFileInfo& info = all[entries[i]];
+        if ( info.isDir() ) {
+            continue;
+        }
+        QString filename = info.fileName();
+        files.push_back( generateChildAbsoluteName(item.get(), filename).toStdString() );
+        ///Video files are never grouped
+        int lastDotPos = filename.lastIndexOf( QChar::fromLatin1('.') );
+        std::string extension = lastDotPos == -1 ? std::string() : filename.mid(lastDotPos + 1).toStdString();
+        canBeGrouped.push_back( !isVideoFileExtension(extension) );
+    }
 
-            /// If we reach here, this is a valid file and we need to determine if it belongs to another sequence or we need
-            /// to create a new one
-            SequenceParsing::FileNameContent fileContent(absoluteFilePath);
+    std::vector<std::pair<SequenceParsing::SequenceFromFilesPtr, int> > sequences;
+    if ( !groupFilesInSequencesInternal(files, canBeGrouped, false, true, _imp.get(), &sequences) ) {
+        _imp->checkForAbort();
 
-            if ( !isVideoFileExtension( fileContent.getExtension() ) ) {
-                ///Note that we use a reverse iterator because we have more chance to find a match in the last recently added entries
-                for (FileSequences::reverse_iterator it = sequences.rbegin(); it != sequences.rend(); ++it) {
-                    if ( it->first && it->first->tryInsertFile(fileContent, false) ) {
-                        foundMatchingSequence = true;
-                        break;
-                    }
-                }
-            }
+        return;
+    }
 
-            if (!foundMatchingSequence) {
-                SequenceParsing::SequenceFromFilesPtr newSequence( new SequenceParsing::SequenceFromFiles(fileContent, true) );
-                sequences.push_back( std::make_pair(newSequence, all[i]) );
-            }
-        }
-        KERNEL_INCR();
+    ///The sequences are displayed at the position of their first file
+    std::vector<SequenceParsing::SequenceFromFilesPtr> sequenceStartingAtFile( files.size() );
+    for (std::size_t i = 0; i < sequences.size(); ++i) {
+        sequenceStartingAtFile[sequences[i].second] = sequences[i].first;
     }
 
-    ///Now iterate through the sequences and create the children as necessary
-    for (FileSequences::iterator it = sequences.begin(); it != sequences.end(); ++it) {
-        item->addChild(it->first, it->second);
+    ///Now iterate through the directories and sequences and create the children as necessary
+    int fileIndex = 0;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const QFileInfo& info = all[entries[i]];
+        if ( info.isDir() ) {
+            item->addChild(SequenceParsing::SequenceFromFilesPtr(), info);
+        } else {
+            if (sequenceStartingAtFile[fileIndex]) {
+                item->addChild(sequenceStartingAtFile[fileIndex], info);
+            }
+            ++fileIndex;
+        }
     }
 
     Q_EMIT directoryLoaded( item->absoluteFilePath() );
@@ -1696,15 +1981,39 @@ FileSystemModel::filesListFromPattern(const std::string& pattern, SequenceParsin
         return false;
     }
 
-    QStringList files = dir.entryList(QDir::Files | QDir::NoDotAndDotDot);
+    // The directory is listed once for all the frames of the sequence and the listing is kept until the directory changes
+    QFileInfoList files = listDirectory(dir.path(), QDir::Files | QDir::NoDotAndDotDot, QDir::NoSort);
 
     StringList filesList;
-    for (QStringList::iterator it = files.begin(); it!=files.end(); ++it) {
-        filesList.push_back(it->toStdString());
+    for (QFileInfoList::const_iterator it = files.begin(); it!=files.end(); ++it) {
+        filesList.push_back(it->fileName().toStdString());
     }
     return SequenceParsing::filesListFromPattern_fast(pattern, filesList, sequence);
 }
 
+void
+FileSystemModel::filesExist(const std::vector<std::string>& filePaths,
+                            std::vector<bool>* exist)
+{
+    exist->resize( filePaths.size() );
+
+    // The names of the files of each directory, listed once
+    std::map<std::string, std::set<std::string> > directories;
+    for (std::size_t i = 0; i < filePaths.size(); ++i) {
+        std::string fileName = filePaths[i];
+        std::string path = SequenceParsing::removePath(fileName);
+        std::map<std::string, std::set<std::string> >::iterator found = directories.find(path);
+        if ( found == directories.end() ) {
+            found = directories.insert( std::make_pair( path, std::set<std::string>() ) ).first;
+            QFileInfoList entries = listDirectory(QString::fromUtf8( path.c_str() ), QDir::Files | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot, QDir::NoSort);
+            for (QFileInfoList::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+                found->second.insert( it->fileName().toStdString() );
+            }
+        }
+        (*exist)[i] = found->second.find(fileName) != found->second.end();
+    }
+} // filesExist
+
 NATRON_NAMESPACE_EXIT;
 
 NATRON_NAMESPACE_USING;
@@ -28,6 +28,8 @@
 #include "Global/Macros.h"
 
 #include <map>
+#include <string>
+#include <vector>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
@@ -329,6 +331,26 @@ public:
 
     static bool filesListFromPattern(const std::string& pattern,  std::map<int,std::map<int,std::string> >* sequence);
 
+    /**
+     * @brief Sets in exist whether each of the given files exists. Instead of a stat per file, each directory is listed once
+     * and its listing is kept as long as the modification time of the directory does not change, so that checking all the
+     * frames of a long sequence on a network storage is a single listing.
+     * This is MT-safe.
+     **/
+    static void filesExist(const std::vector<std::string>& filePaths, std::vector<bool>* exist);
+
+    /**
+     * @brief Groups the given files in sequences. The file names are parsed and grouped by chunks concurrently
+     * and the sequences of consecutive chunks are then merged, so that this scales to directories with many frames.
+     * A file for which canBeGrouped is false gets its own sequence. Each sequence is returned with the index
+     * of its first file in files, in the order of the files.
+     **/
+    static void groupFilesInSequences(const std::vector<std::string>& files,
+                                      const std::vector<bool>& canBeGrouped,
+                                      bool checkPath,
+                                      bool enableSizeEstimation,
+                                      std::vector<std::pair<SequenceParsing::SequenceFromFilesPtr, int> >* sequences);
+
 
 public Q_SLOTS:
 
@@ -26,8 +26,12 @@
 
 #include <cmath>
 #include <cassert>
+#include <list>
+#include <map>
 #include <stdexcept>
 
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+
 #ifndef M_PI_2
 #define M_PI_2      1.57079632679489661923132169163975144   /* pi/2           */
 #endif
@@ -504,6 +508,73 @@ fit_cubic_for_sub_set(const std::vector<Point>& points,
     fit_cubic_internal(points, tHat1, tHat2, error, generatedBezier);
 }
 
+/**
+ * @brief Buckets points in square cells of the given tolerance, so that finding whether a point was already
+ * inserted within the tolerance only looks at the 9 cells around it instead of all the points.
+ **/
+class PointGrid
+{
+    typedef std::pair<long long, long long> Cell;
+    typedef std::map<Cell, std::vector<Point> > CellsMap;
+
+    double _tolerance;
+    CellsMap _cells;
+
+public:
+
+    PointGrid(double tolerance)
+    : _tolerance(tolerance)
+    , _cells()
+    {
+    }
+
+    bool containsNearby(const Point& p) const
+    {
+        Cell c = getCell(p);
+        for (long long y = c.second - 1; y <= c.second + 1; ++y) {
+            for (long long x = c.first - 1; x <= c.first + 1; ++x) {
+                CellsMap::const_iterator found = _cells.find( Cell(x, y) );
+                if ( found == _cells.end() ) {
+                    continue;
+                }
+                for (std::vector<Point>::const_iterator it = found->second.begin(); it != found->second.end(); ++it) {
+                    if ( (std::abs(it->x - p.x) < _tolerance) && (std::abs(it->y - p.y) < _tolerance) ) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void insert(const Point& p)
+    {
+        _cells[getCell(p)].push_back(p);
+    }
+
+private:
+
+    Cell getCell(const Point& p) const
+    {
+        return Cell( (long long)std::floor(p.x / _tolerance), (long long)std::floor(p.y / _tolerance) );
+    }
+};
+
+// The fit of a set of points delimited by corners, independent of the other sets
+struct FitSubsetJob
+{
+    const std::vector<Point>* points;
+    double error;
+    std::vector<SimpleBezierCP> generatedBezier;
+};
+
+void
+fitSubsetJob(FitSubsetJob& job)
+{
+    fit_cubic_for_sub_set(*job.points, job.error, &job.generatedBezier);
+}
+
 NATRON_NAMESPACE_ANONYMOUS_EXIT
 
 
@@ -517,102 +588,84 @@ FitCurve::fit_cubic(const std::vector<Point>& points,
     }
 
     //First remove (almost) duplicate points
-    std::list<Point> newPoints;
-    for (std::vector<Point>::const_iterator it = points.begin(); it != points.end(); ++it) {
-        bool foundDuplicate = false;
-        for (std::list<Point>::const_iterator it2 = newPoints.begin(); it2 != newPoints.end(); ++it2) {
-            if ( (std::abs(it2->x - it->x) < 1e-4) && (std::abs(it2->y - it->y) < 1e-4) ) {
-                foundDuplicate = true;
-                break;
+    std::vector<Point> newPoints;
+    {
+        PointGrid insertedPoints(1e-4);
+        for (std::vector<Point>::const_iterator it = points.begin(); it != points.end(); ++it) {
+            if ( !insertedPoints.containsNearby(*it) ) {
+                insertedPoints.insert(*it);
+                newPoints.push_back(*it);
             }
         }
-        if (!foundDuplicate) {
-            newPoints.push_back(*it);
-        }
     }
 
     //Divide the original points by identifying "corners": points where the angle between the previous, current and next point
-    //creates a discontinuity
+    //creates a discontinuity. A set ends at the corner and the next set starts after it.
     std::list<std::vector<Point> > pointSets;
-    bool foundCorner;
-
-    do {
-        foundCorner = false;
-        if (newPoints.size() <= 2) {
-            break;
-        }
-        std::list<Point>::iterator prev = newPoints.begin();
-        std::list<Point>::iterator it = newPoints.begin();
-        ++it;
-        std::list<Point>::iterator next = it;
-        if ( next != newPoints.end() ) {
-            ++next;
+    std::size_t setStart = 0;
+    std::size_t i = 1;
+    while ( (newPoints.size() - setStart > 2) && (i + 1 < newPoints.size()) ) {
+        const Point& prev = newPoints[i - 1];
+        const Point& cur = newPoints[i];
+        const Point& next = newPoints[i + 1];
+        Point u, v;
+        u.x = cur.x - prev.x;
+        u.y = cur.y - prev.y;
+
+        v.x = next.x - cur.x;
+        v.y = next.y - cur.y;
+
+        double distU = std::sqrt(u.x * u.x + u.y * u.y);
+        double distV = std::sqrt(v.x * v.x + v.y * v.y);
+        assert(distV != 0);
+        double alpha = std::acos(distU / distV);
+        if ( !(alpha > M_PI_2) ) {
+            ++i;
+            continue;
         }
-        for (; it != newPoints.end(); ++prev, ++it, ++next) {
-            if ( it == newPoints.end() ) {
-                it = newPoints.begin();
-            }
-            if ( next == newPoints.end() ) {
-                break;
-                //next = newPoints.begin();
-            }
-
-            Point u, v;
-            u.x = it->x - prev->x;
-            u.y = it->y - prev->y;
-
-            v.x = next->x - it->x;
-            v.y = next->y - it->y;
-
-            double distU = std::sqrt(u.x * u.x + u.y * u.y);
-            double distV = std::sqrt(v.x * v.x + v.y * v.y);
-            assert(distV != 0);
-            double alpha = std::acos(distU / distV);
-            if (alpha > M_PI_2) {
-                std::vector<Point> subset;
-
-                for (std::list<Point>::iterator it2 = newPoints.begin(); it2 != next; ++it2) {
-                    subset.push_back(*it2);
-                }
-                newPoints.erase(newPoints.begin(), next);
+        std::vector<Point> subset(newPoints.begin() + setStart, newPoints.begin() + i + 1);
+        setStart = i + 1;
 
-                //If only a single point remains, just add it to this bezier curve
-                if (newPoints.size() == 1) {
-                    subset.push_back( newPoints.front() );
-                    newPoints.clear();
-                }
-                pointSets.push_back(subset);
-                foundCorner = true;
-                break;
-            }
-        }
-    } while (foundCorner);
-    if ( !newPoints.empty() ) {
-        std::vector<Point> subset;
-        for (std::list<Point>::iterator it2 = newPoints.begin(); it2 != newPoints.end(); ++it2) {
-            subset.push_back(*it2);
+        //If only a single point remains, just add it to this bezier curve
+        if (newPoints.size() - setStart == 1) {
+            subset.push_back( newPoints.back() );
+            setStart = newPoints.size();
         }
         pointSets.push_back(subset);
+        i = setStart + 1;
+    }
+    if ( setStart < newPoints.size() ) {
+        pointSets.push_back( std::vector<Point>(newPoints.begin() + setStart, newPoints.end()) );
     }
 
+    // The sets are fitted independently: fit them concurrently
+    std::vector<FitSubsetJob> jobs( pointSets.size() );
+    {
+        std::size_t jobIndex = 0;
+        for (std::list<std::vector<Point> >::const_iterator it = pointSets.begin(); it != pointSets.end(); ++it, ++jobIndex) {
+            jobs[jobIndex].points = &*it;
+            jobs[jobIndex].error = error;
+        }
+    }
+    if (jobs.size() > 1) {
+        QtConcurrent::blockingMap(jobs, fitSubsetJob);
+    } else if (jobs.size() == 1) {
+        fitSubsetJob(jobs[0]);
+    }
 
-    for (std::list<std::vector<Point> >::iterator it = pointSets.begin(); it != pointSets.end(); ++it) {
-        std::vector<SimpleBezierCP> subsetBezier;
-        fit_cubic_for_sub_set(*it, error, &subsetBezier);
-        for (std::size_t i = 0; i < subsetBezier.size(); ++i) {
-            //For the first segment point check if the  point is not already inserted in generatedBezie
-            bool found = false;
-            if (i == 0) {
-                for (std::vector<SimpleBezierCP>::iterator it2 = generatedBezier->begin(); it2 != generatedBezier->end(); ++it2) {
-                    if ( (std::abs(it2->p.x - subsetBezier[i].p.x) < 1e-6) && (std::abs(it2->p.y - subsetBezier[i].p.y) < 1e-6) ) {
-                        found = true;
-                        break;
-                    }
-                }
-            }
-            if (!found) {
-                generatedBezier->push_back(subsetBezier[i]);
+    PointGrid generatedPoints(1e-6);
+    for (std::vector<SimpleBezierCP>::const_iterator it = generatedBezier->begin(); it != generatedBezier->end(); ++it) {
+        generatedPoints.insert(it->p);
+    }
+    for (std::size_t j = 0; j < jobs.size(); ++j) {
+        const std::vector<SimpleBezierCP>& subsetBezier = jobs[j].generatedBezier;
+        for (std::size_t k = 0; k < subsetBezier.size(); ++k) {
+            //For the first segment point check if the  point is not already inserted in generatedBezier
+            if ( (k == 0) && generatedPoints.containsNearby(subsetBezier[k].p) ) {
+                continue;
             }
+            generatedPoints.insert(subsetBezier[k].p);
+            generatedBezier->push_back(subsetBezier[k]);
         }
     }
 } // FitCurve::fit_cubic
@@ -0,0 +1,328 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "FrameEncodeQueue.h"
+
+#include <list>
+#include <cassert>
+#include <stdexcept>
+
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+#include <QtCore/QWaitCondition>
+
+#include "Engine/BufferableObject.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/FrameViewRequest.h"
+#include "Engine/Node.h"
+#include "Engine/OutputSchedulerThread.h"
+#include "Engine/Timer.h"
+#include "Engine/TreeRender.h"
+#include "Engine/WriteNode.h"
+
+// Number of frames encoded concurrently when the writer does not need them in order
+#define NATRON_FRAME_ENCODE_N_THREADS 4
+
+// Number of rendered frames that may wait to be encoded before the render threads block
+#define NATRON_FRAME_ENCODE_MAX_QUEUED_FRAMES 4
+
+NATRON_NAMESPACE_ENTER;
+
+struct FrameEncodeRequest
+{
+    NodeWPtr writer;
+    TimeValue time;
+    std::vector<ViewIdx> viewsToRender;
+    RenderStatsPtr stats;
+    double renderTime;
+
+    // The value of FrameEncodeQueuePrivate::generation when the frame was queued
+    U64 generation;
+};
+
+struct FrameEncodeQueuePrivate
+{
+    OutputSchedulerThread* scheduler;
+
+    // Protects all data below
+    QMutex lock;
+
+    // Woken up when a frame is taken out of the queue
+    QWaitCondition queueNotFullCond;
+
+    // The frames waiting to be encoded, in the order they were queued
+    std::list<FrameEncodeRequest> queue;
+
+    // The encodes in progress, so that they can be aborted
+    std::list<TreeRenderPtr> activeRenders;
+
+    // Incremented in abort(): frames of a previous generation are not encoded
+    U64 generation;
+
+    // If true, frames are encoded by a single worker
+    bool ordered;
+
+    // Number of worker runnables started on threadPool
+    int nActiveWorkers;
+
+    QThreadPool threadPool;
+
+    FrameEncodeQueuePrivate(OutputSchedulerThread* scheduler)
+    : scheduler(scheduler)
+    , lock()
+    , queueNotFullCond()
+    , queue()
+    , activeRenders()
+    , generation(0)
+    , ordered(false)
+    , nActiveWorkers(0)
+    , threadPool()
+    {
+        threadPool.setMaxThreadCount(NATRON_FRAME_ENCODE_N_THREADS);
+    }
+
+    /**
+     * @brief Pops the next frame to encode. Returns false if there is none, in which case the worker calling this must return.
+     **/
+    bool popNextRequest(FrameEncodeRequest* request)
+    {
+        QMutexLocker k(&lock);
+        if ( queue.empty() ) {
+            --nActiveWorkers;
+
+            return false;
+        }
+        *request = queue.front();
+        queue.pop_front();
+        queueNotFullCond.wakeAll();
+
+        return true;
+    }
+
+    ActionRetCodeEnum encodeViews(const FrameEncodeRequest& request, const NodePtr& writer);
+
+    void encode(const FrameEncodeRequest& request);
+};
+
+class FrameEncodeWorker
+    : public QRunnable
+{
+    FrameEncodeQueuePrivate* _imp;
+
+public:
+
+    FrameEncodeWorker(FrameEncodeQueuePrivate* imp)
+        : QRunnable()
+        , _imp(imp)
+    {
+        setAutoDelete(true);
+    }
+
+    virtual ~FrameEncodeWorker()
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        FrameEncodeRequest request;
+        while ( _imp->popNextRequest(&request) ) {
+            _imp->encode(request);
+        }
+    }
+};
+
+FrameEncodeQueue::FrameEncodeQueue(OutputSchedulerThread* scheduler)
+    : _imp( new FrameEncodeQueuePrivate(scheduler) )
+{
+}
+
+FrameEncodeQueue::~FrameEncodeQueue()
+{
+    stop();
+}
+
+void
+FrameEncodeQueue::start(bool ordered)
+{
+    QMutexLocker k(&_imp->lock);
+    assert( _imp->queue.empty() && _imp->nActiveWorkers == 0 );
+    _imp->ordered = ordered;
+}
+
+void
+FrameEncodeQueue::queueFrame(const NodePtr& writer,
+                             TimeValue time,
+                             const std::vector<ViewIdx>& viewsToRender,
+                             const RenderStatsPtr& stats,
+                             double renderTime)
+{
+    QMutexLocker k(&_imp->lock);
+    U64 generation = _imp->generation;
+    while ( ( (int)_imp->queue.size() >= NATRON_FRAME_ENCODE_MAX_QUEUED_FRAMES ) && (generation == _imp->generation) ) {
+        _imp->queueNotFullCond.wait(&_imp->lock);
+    }
+    if (generation != _imp->generation) {
+        // Aborted while waiting
+        return;
+    }
+
+    FrameEncodeRequest request;
+    request.writer = writer;
+    request.time = time;
+    request.viewsToRender = viewsToRender;
+    request.stats = stats;
+    request.renderTime = renderTime;
+    request.generation = generation;
+    _imp->queue.push_back(request);
+
+    // A single worker encodes the frames in order
+    int maxWorkers = _imp->ordered ? 1 : NATRON_FRAME_ENCODE_N_THREADS;
+    if (_imp->nActiveWorkers < maxWorkers) {
+        ++_imp->nActiveWorkers;
+        _imp->threadPool.start( new FrameEncodeWorker( _imp.get() ) );
+    }
+} // queueFrame
+
+ActionRetCodeEnum
+FrameEncodeQueuePrivate::encodeViews(const FrameEncodeRequest& request,
+                                     const NodePtr& writer)
+{
+    if ( request.viewsToRender.empty() ) {
+        return eActionStatusOK;
+    }
+
+    // Same arguments as the render of the writer input in DefaultRenderFrameRunnable so that it is found in the cache.
+    // All views are encoded concurrently by the same TreeRender.
+    TreeRender::CtorArgsPtr args(new TreeRender::CtorArgs);
+    args->treeRootEffect = writer->getEffectInstance();
+    args->time = request.time;
+    args->view = request.viewsToRender[0];
+    args->extraViews.assign(request.viewsToRender.begin() + 1, request.viewsToRender.end());
+    args->plane = 0;
+    args->mipMapLevel = 0;
+    args->proxyScale = RenderScale(1.);
+    args->canonicalRoI = 0;
+    args->stats = request.stats;
+    args->draftMode = false;
+    args->playback = true;
+    args->byPassCache = false;
+    args->priority = eRenderPriorityWrite;
+
+    TreeRenderPtr render = TreeRender::create(args);
+    if (!render) {
+        return eActionStatusFailed;
+    }
+    {
+        QMutexLocker k(&lock);
+        if (request.generation != generation) {
+            return eActionStatusAborted;
+        }
+        activeRenders.push_back(render);
+    }
+
+    std::list<FrameViewRequestPtr> outputRequests;
+    ActionRetCodeEnum stat = render->launchRender(&outputRequests);
+
+    QMutexLocker k(&lock);
+    activeRenders.remove(render);
+
+    return stat;
+} // encodeViews
+
+void
+FrameEncodeQueuePrivate::encode(const FrameEncodeRequest& request)
+{
+    NodePtr writer = request.writer.lock();
+    if (!writer) {
+        return;
+    }
+    NodePtr outputNode = writer;
+
+    // The writer encoding the frames is the internal writer of the Write node
+    {
+        WriteNodePtr isWrite = toWriteNode( writer->getEffectInstance() );
+        if (isWrite) {
+            NodePtr embeddedWriter = isWrite->getEmbeddedWriter();
+            if (embeddedWriter) {
+                writer = embeddedWriter;
+            }
+        }
+    }
+
+    BufferedFrameContainerPtr frameContainer(new BufferedFrameContainer);
+    frameContainer->time = request.time;
+    frameContainer->renderStageNotified = true;
+
+    TimeLapse encodeTimer;
+    ActionRetCodeEnum stat = encodeViews(request, writer);
+    if (stat == eActionStatusAborted) {
+        // The render was aborted: do not report the frame
+        return;
+    }
+    if ( isFailureRetCode(stat) ) {
+        scheduler->notifyRenderFailure( stat, std::string() );
+    } else {
+        scheduler->onFrameWritten(outputNode, request.time, request.viewsToRender);
+    }
+    for (std::size_t i = 0; i < request.viewsToRender.size(); ++i) {
+        BufferedFramePtr frame(new BufferedFrame);
+        frame->view = request.viewsToRender[i];
+        frame->stats = request.stats;
+        frameContainer->frames.push_back(frame);
+    }
+    frameContainer->renderTime = request.renderTime + encodeTimer.getTimeSinceCreation();
+
+    scheduler->notifyFrameRendered(frameContainer, eSchedulingPolicyFFA);
+    scheduler->runAfterFrameRenderedCallback(request.time);
+} // encode
+
+void
+FrameEncodeQueue::abort()
+{
+    QMutexLocker k(&_imp->lock);
+    ++_imp->generation;
+    _imp->queue.clear();
+    _imp->queueNotFullCond.wakeAll();
+    for (std::list<TreeRenderPtr>::const_iterator it = _imp->activeRenders.begin(); it != _imp->activeRenders.end(); ++it) {
+        (*it)->setRenderAborted();
+    }
+}
+
+void
+FrameEncodeQueue::stop()
+{
+    abort();
+    _imp->threadPool.waitForDone();
+}
+
+int
+FrameEncodeQueue::getNumQueuedFrames() const
+{
+    QMutexLocker k(&_imp->lock);
+
+    return (int)_imp->queue.size();
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,104 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_FRAMEENCODEQUEUE_H
+#define NATRON_ENGINE_FRAMEENCODEQUEUE_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/TimeValue.h"
+#include "Engine/ViewIdx.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct FrameEncodeQueuePrivate;
+
+/**
+ * @brief The encode stage of a render on disk: instead of rendering a frame entirely, the render threads of the
+ * DefaultScheduler render the image in input of the writer, which stays in the cache, and queue the frame here.
+ * The writer then compresses and writes the frame on the encode threads while the render threads render the next frames.
+ * When a frame is written, it is reported to the scheduler with OutputSchedulerThread::notifyFrameRendered().
+ *
+ * The number of frames waiting to be encoded is bounded: queueFrame() blocks when it is reached, so that the
+ * render threads do not fill the memory faster than the writer can write.
+ * For writers that need the frames in order (video writers), the frames are encoded one at a time in the order they were queued.
+ * All functions are MT-safe.
+ **/
+class FrameEncodeQueue
+{
+public:
+
+    FrameEncodeQueue(OutputSchedulerThread* scheduler);
+
+    ~FrameEncodeQueue();
+
+    /**
+     * @brief Called when a render starts. If ordered is true, the frames are encoded one at a time.
+     **/
+    void start(bool ordered);
+
+    /**
+     * @brief Queue the encode of the given frame by the writer. The image in input of the writer must have been rendered
+     * at mipmap level 0 for all the given views. renderTime is the time spent rendering it.
+     * This blocks while the maximum number of frames are already waiting to be encoded.
+     **/
+    void queueFrame(const NodePtr& writer,
+                    TimeValue time,
+                    const std::vector<ViewIdx>& viewsToRender,
+                    const RenderStatsPtr& stats,
+                    double renderTime);
+
+    /**
+     * @brief Aborts the encodes in progress. The frames waiting to be encoded are dropped.
+     **/
+    void abort();
+
+    /**
+     * @brief Same as abort() but also waits for the encodes in progress to return.
+     **/
+    void stop();
+
+    /**
+     * @brief Returns the number of frames waiting to be encoded
+     **/
+    int getNumQueuedFrames() const;
+
+private:
+
+    boost::scoped_ptr<FrameEncodeQueuePrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_FRAMEENCODEQUEUE_H
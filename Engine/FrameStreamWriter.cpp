@@ -0,0 +1,411 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "FrameStreamWriter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cerrno>
+#include <cstring> // strerror
+#include <iostream>
+#include <new> // placement new
+#include <sstream>
+
+#ifdef __NATRON_WIN32__
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#include <csignal>
+#endif
+
+#include <QtCore/QMutex>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+GCC_DIAG_OFF(unused-parameter)
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+GCC_DIAG_ON(unused-parameter)
+#endif
+
+#include "Engine/Format.h"
+#include "Engine/Image.h"
+#include "Engine/ImagePlaneDesc.h"
+
+namespace bip = boost::interprocess;
+
+NATRON_NAMESPACE_ENTER;
+
+struct FrameStreamWriterPrivate
+{
+    FrameStreamWriter::FrameStreamFormatEnum format;
+    std::string filePath;
+
+    // The frames have the size of the project format
+    RectI frameRect;
+    double pixelAspectRatio;
+    double frameRate;
+
+    // Protects the data below
+    QMutex lock;
+    FILE* file;
+    bool headerWritten;
+
+    // When publishing to shared memory, the name of the segment and its mapping
+    std::string sharedMemoryName;
+    boost::scoped_ptr<bip::mapped_region> sharedMemoryRegion;
+
+    FrameStreamWriterPrivate(FrameStreamWriter::FrameStreamFormatEnum format,
+                             const std::string& filePath,
+                             const Format& frameFormat,
+                             double frameRate)
+    : format(format)
+    , filePath(filePath)
+    , frameRect(frameFormat)
+    , pixelAspectRatio( frameFormat.getPixelAspectRatio() )
+    , frameRate(frameRate)
+    , lock()
+    , file(0)
+    , headerWritten(false)
+    , sharedMemoryName()
+    , sharedMemoryRegion()
+    {
+        static const std::string sharedMemoryPrefix("shm:");
+        if ( filePath.compare(0, sharedMemoryPrefix.size(), sharedMemoryPrefix) == 0 ) {
+            sharedMemoryName = filePath.substr( sharedMemoryPrefix.size() );
+        }
+    }
+
+    bool writeHeader();
+
+    bool openSharedMemory(std::string* error);
+
+    bool publishFrame(const std::vector<unsigned char>& frameData, double time);
+};
+
+FrameStreamWriter::FrameStreamWriter(FrameStreamFormatEnum format,
+                                     const std::string& filePath,
+                                     const Format& frameFormat,
+                                     double frameRate)
+    : _imp( new FrameStreamWriterPrivate(format, filePath, frameFormat, frameRate) )
+{
+}
+
+FrameStreamWriter::~FrameStreamWriter()
+{
+    close();
+}
+
+bool
+FrameStreamWriter::getFormatFromString(const std::string& str,
+                                       FrameStreamFormatEnum* format)
+{
+    if (str == "y4m") {
+        *format = eFrameStreamFormatY4M;
+    } else if (str == "rgb") {
+        *format = eFrameStreamFormatRGB;
+    } else if (str == "yuv") {
+        *format = eFrameStreamFormatYUV;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool
+FrameStreamWriter::open(std::string* error)
+{
+    QMutexLocker k(&_imp->lock);
+
+    if ( _imp->file || _imp->sharedMemoryRegion ) {
+        return true;
+    }
+    if ( !_imp->sharedMemoryName.empty() ) {
+        return _imp->openSharedMemory(error);
+    }
+    if (_imp->filePath == "-") {
+        // Keep a private descriptor on the standard output for the stream and send everything else printed
+        // on the standard output to the standard error
+        std::cout.flush();
+        std::fflush(stdout);
+#ifdef __NATRON_WIN32__
+        int fd = _dup( _fileno(stdout) );
+        if (fd != -1) {
+            _setmode(fd, _O_BINARY);
+            _dup2( _fileno(stderr), _fileno(stdout) );
+            _imp->file = _fdopen(fd, "wb");
+        }
+#else
+        int fd = dup(STDOUT_FILENO);
+        if (fd != -1) {
+            dup2(STDERR_FILENO, STDOUT_FILENO);
+            _imp->file = fdopen(fd, "wb");
+        }
+#endif
+    } else {
+        _imp->file = std::fopen(_imp->filePath.c_str(), "wb");
+    }
+    if (!_imp->file) {
+        *error = std::string("Cannot open the frame stream ") + _imp->filePath + ": " + std::strerror(errno);
+
+        return false;
+    }
+#ifndef __NATRON_WIN32__
+    // If the reader closes the pipe, the writes fail instead of killing the process
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    return true;
+} // open
+
+void
+FrameStreamWriter::close()
+{
+    QMutexLocker k(&_imp->lock);
+
+    if (_imp->file) {
+        std::fclose(_imp->file);
+        _imp->file = 0;
+    }
+    if (_imp->sharedMemoryRegion) {
+        _imp->sharedMemoryRegion.reset();
+        bip::shared_memory_object::remove( _imp->sharedMemoryName.c_str() );
+    }
+}
+
+bool
+FrameStreamWriterPrivate::openSharedMemory(std::string* error)
+{
+    const U64 frameSizeBytes = (U64)frameRect.width() * frameRect.height() * 3;
+    // Keep the pixels of each slot 16 bytes aligned
+    const U64 slotsOffset = ( (sizeof(FrameStreamSharedMemoryHeader) + 15) / 16 ) * 16;
+    const U64 slotSizeBytes = ( (sizeof(FrameStreamSharedMemorySlot) + frameSizeBytes + 15) / 16 ) * 16;
+
+    try {
+        bip::shared_memory_object::remove( sharedMemoryName.c_str() );
+        bip::shared_memory_object shm(bip::create_only, sharedMemoryName.c_str(), bip::read_write);
+        shm.truncate( (bip::offset_t)(slotsOffset + slotSizeBytes * NATRON_FRAME_STREAM_SHARED_MEMORY_N_SLOTS) );
+        sharedMemoryRegion.reset( new bip::mapped_region(shm, bip::read_write) );
+    } catch (const bip::interprocess_exception& e) {
+        sharedMemoryRegion.reset();
+        bip::shared_memory_object::remove( sharedMemoryName.c_str() );
+        *error = std::string("Cannot create the shared memory segment ") + sharedMemoryName + ": " + e.what();
+
+        return false;
+    }
+
+    // The slots are zeroed by the truncation: their frameIndex is 0
+    FrameStreamSharedMemoryHeader* header = new (sharedMemoryRegion->get_address()) FrameStreamSharedMemoryHeader;
+    std::memcpy( header->magic, kFrameStreamSharedMemoryMagic, sizeof(header->magic) );
+    header->version = kFrameStreamSharedMemoryVersion;
+    header->format = (U32)format;
+    header->width = (U32)frameRect.width();
+    header->height = (U32)frameRect.height();
+    header->frameRate = frameRate;
+    header->pixelAspectRatio = pixelAspectRatio;
+    header->nSlots = NATRON_FRAME_STREAM_SHARED_MEMORY_N_SLOTS;
+    header->padding = 0;
+    header->frameSizeBytes = frameSizeBytes;
+    header->slotSizeBytes = slotSizeBytes;
+    header->slotsOffset = slotsOffset;
+    header->publishedCount = 0;
+
+    return true;
+} // openSharedMemory
+
+bool
+FrameStreamWriterPrivate::publishFrame(const std::vector<unsigned char>& frameData,
+                                       double time)
+{
+    FrameStreamSharedMemoryHeader* header = (FrameStreamSharedMemoryHeader*)sharedMemoryRegion->get_address();
+    if (frameData.size() != header->frameSizeBytes) {
+        return false;
+    }
+
+    // Only this writes publishedCount: it can be read without the lock
+    const U64 frameIndex = header->publishedCount + 1;
+    unsigned char* slotPtr = (unsigned char*)header + header->slotsOffset + ( (frameIndex - 1) % header->nSlots ) * header->slotSizeBytes;
+    FrameStreamSharedMemorySlot* slot = (FrameStreamSharedMemorySlot*)slotPtr;
+    std::memcpy( slotPtr + sizeof(FrameStreamSharedMemorySlot), &frameData[0], frameData.size() );
+
+    bip::scoped_lock<bip::interprocess_mutex> k(header->lock);
+    slot->frameIndex = frameIndex;
+    slot->time = time;
+    header->publishedCount = frameIndex;
+
+    return true;
+}
+
+/**
+ * @brief Writes value as a ratio of integers, as in the Y4M header. NTSC rates are written over 1001.
+ **/
+static std::string
+getRatioString(double value)
+{
+    std::stringstream ss;
+    double ntsc = value * 1.001;
+    if ( (std::floor(value) != value) && (std::fabs( ntsc - std::floor(ntsc + 0.5) ) < 1e-3) ) {
+        ss << (long)std::floor(ntsc + 0.5) * 1000 << ':' << 1001;
+    } else {
+        long num = (long)std::floor(value * 1000 + 0.5);
+        long den = 1000;
+        long a = num, b = den;
+        while (b != 0) {
+            long r = a % b;
+            a = b;
+            b = r;
+        }
+        if (a == 0) {
+            a = 1;
+        }
+        ss << num / a << ':' << den / a;
+    }
+
+    return ss.str();
+}
+
+bool
+FrameStreamWriterPrivate::writeHeader()
+{
+    if (format != FrameStreamWriter::eFrameStreamFormatY4M) {
+        return true;
+    }
+    std::stringstream ss;
+    ss << "YUV4MPEG2 W" << frameRect.width() << " H" << frameRect.height() << " F" << getRatioString(frameRate)
+       << " Ip A" << getRatioString(pixelAspectRatio) << " C444 XCOLORRANGE=LIMITED\n";
+    std::string header = ss.str();
+
+    return std::fwrite(header.c_str(), 1, header.size(), file) == header.size();
+}
+
+bool
+FrameStreamWriter::convertImage(const ImagePtr& image,
+                                std::vector<unsigned char>* frameData) const
+{
+    const RectI& frameRect = _imp->frameRect;
+    if ( !image || frameRect.isNull() ) {
+        return false;
+    }
+
+    // Convert to 8-bit sRGB: the stream is meant to be displayed
+    Image::InitStorageArgs initArgs;
+    initArgs.bounds = frameRect;
+    initArgs.plane = ImagePlaneDesc::getRGBAComponents();
+    initArgs.bitdepth = eImageBitDepthByte;
+    initArgs.storage = eStorageModeRAM;
+    initArgs.bufferFormat = eImageBufferLayoutRGBAPackedFullRect;
+    ImagePtr rgbaImage = Image::create(initArgs);
+    if (!rgbaImage) {
+        return false;
+    }
+    rgbaImage->fillZero(frameRect);
+
+    RectI roi;
+    if ( image->getBounds().intersect(frameRect, &roi) ) {
+        Image::CopyPixelsArgs cpyArgs;
+        cpyArgs.roi = roi;
+        cpyArgs.srcColorspace = eViewerColorSpaceLinear;
+        cpyArgs.dstColorspace = eViewerColorSpaceSRGB;
+        if ( isFailureRetCode( rgbaImage->copyPixels(*image, cpyArgs) ) ) {
+            return false;
+        }
+    }
+
+    Image::CPUData imageData;
+    rgbaImage->getCPUData(&imageData);
+    const unsigned char* pixels = (const unsigned char*)imageData.ptrs[0];
+
+    const int width = frameRect.width();
+    const int height = frameRect.height();
+    const std::size_t planeSize = (std::size_t)width * height;
+    frameData->resize(planeSize * 3);
+    unsigned char* dst = &(*frameData)[0];
+
+    // Images are bottom row first, the frames of the stream are top row first
+    for (int y = 0; y < height; ++y) {
+        const unsigned char* srcPix = pixels + (std::size_t)(height - 1 - y) * width * 4;
+        if (_imp->format == eFrameStreamFormatRGB) {
+            unsigned char* dstPix = dst + (std::size_t)y * width * 3;
+            for (int x = 0; x < width; ++x, srcPix += 4, dstPix += 3) {
+                dstPix[0] = srcPix[0];
+                dstPix[1] = srcPix[1];
+                dstPix[2] = srcPix[2];
+            }
+        } else {
+            // Rec.709 limited range YCbCr
+            unsigned char* dstY = dst + (std::size_t)y * width;
+            unsigned char* dstCb = dstY + planeSize;
+            unsigned char* dstCr = dstCb + planeSize;
+            for (int x = 0; x < width; ++x, srcPix += 4) {
+                const int r = srcPix[0];
+                const int g = srcPix[1];
+                const int b = srcPix[2];
+                dstY[x] = (unsigned char)( ( 47 * r + 157 * g + 16 * b + 4096 + 128 ) >> 8 );
+                dstCb[x] = (unsigned char)( ( -26 * r - 87 * g + 113 * b + 32768 + 128 ) >> 8 );
+                dstCr[x] = (unsigned char)( ( 113 * r - 103 * g - 10 * b + 32768 + 128 ) >> 8 );
+            }
+        }
+    }
+
+    return true;
+} // convertImage
+
+bool
+FrameStreamWriter::writeFrame(const std::vector<unsigned char>& frameData,
+                              double time)
+{
+    QMutexLocker k(&_imp->lock);
+
+    if (_imp->sharedMemoryRegion) {
+        return _imp->publishFrame(frameData, time);
+    }
+
+    if (!_imp->file) {
+        return false;
+    }
+    if (!_imp->headerWritten) {
+        if ( !_imp->writeHeader() ) {
+            return false;
+        }
+        _imp->headerWritten = true;
+    }
+    if (_imp->format == eFrameStreamFormatY4M) {
+        static const char frameHeader[] = "FRAME\n";
+        if (std::fwrite(frameHeader, 1, sizeof(frameHeader) - 1, _imp->file) != sizeof(frameHeader) - 1) {
+            return false;
+        }
+    }
+    if ( !frameData.empty() && (std::fwrite(&frameData[0], 1, frameData.size(), _imp->file) != frameData.size()) ) {
+        return false;
+    }
+
+    // The reader may consume the frames as they come
+    return std::fflush(_imp->file) == 0;
+} // writeFrame
+
+NATRON_NAMESPACE_EXIT;
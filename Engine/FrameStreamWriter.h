@@ -0,0 +1,170 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_FRAMESTREAMWRITER_H
+#define NATRON_ENGINE_FRAMESTREAMWRITER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <string>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+#define kFrameStreamSharedMemoryMagic "NATRNFRM"
+#define kFrameStreamSharedMemoryVersion 1
+
+// Number of frames of the shared memory ring buffer
+#define NATRON_FRAME_STREAM_SHARED_MEMORY_N_SLOTS 3
+
+NATRON_NAMESPACE_ENTER;
+
+struct FrameStreamWriterPrivate;
+
+/**
+ * @brief The header at the start of the shared memory segment a frame stream publishes to. The segment is
+ * followed by nSlots slots of slotSizeBytes bytes, starting at slotsOffset: each slot is a FrameStreamSharedMemorySlot
+ * followed by frameSizeBytes bytes of pixels, in the format of the stream.
+ *
+ * A frame is written in slot (publishedCount % nSlots) without the lock, then publishedCount and the slot header
+ * are updated under the lock. A reader locks, reads the slot of the frame publishedCount - 1, copies its pixels
+ * and then checks under the lock that no more than nSlots - 2 frames were published meanwhile, otherwise the copy
+ * may have been overwritten and must be discarded.
+ **/
+struct FrameStreamSharedMemoryHeader
+{
+    char magic[8];
+    U32 version;
+
+    // The FrameStreamWriter::FrameStreamFormatEnum of the pixels. The Y4M format publishes the same pixels as yuv.
+    U32 format;
+    U32 width;
+    U32 height;
+    double frameRate;
+    double pixelAspectRatio;
+    U32 nSlots;
+    U32 padding;
+    U64 frameSizeBytes;
+    U64 slotSizeBytes;
+    U64 slotsOffset;
+
+    // Protects publishedCount and the slot headers
+    boost::interprocess::interprocess_mutex lock;
+
+    // The number of frames published: the last one is in slot (publishedCount - 1) % nSlots
+    U64 publishedCount;
+};
+
+struct FrameStreamSharedMemorySlot
+{
+    // The publishedCount of the frame in this slot (starting at 1), 0 if the slot was never written
+    U64 frameIndex;
+
+    // The frame number in the timeline
+    double time;
+};
+
+/**
+ * @brief Streams the frames rendered by a render on disk to the standard output or a named pipe, so that an
+ * external encoder (e.g: ffmpeg -f yuv4mpegpipe -i -) consumes them without intermediate files.
+ * The frames may also be published to a named shared memory ring buffer (see FrameStreamSharedMemoryHeader), so that
+ * an external player such as a review tool displays them live without any copy to the disk or the network.
+ * The frames are the image in input of the writer, converted to 8-bit sRGB in the project format. They are converted
+ * on the render threads with convertImage() and written in order by the DefaultScheduler with writeFrame().
+ *
+ * When streaming to the standard output, the standard output of the process is redirected to the standard error
+ * once the stream is opened, so that the messages printed during the render do not end up in the stream.
+ **/
+class FrameStreamWriter
+{
+public:
+
+    enum FrameStreamFormatEnum
+    {
+        // A YUV4MPEG2 stream: a header followed by 4:4:4 8-bit Rec.709 frames
+        eFrameStreamFormatY4M = 0,
+
+        // Raw packed 8-bit RGB frames (rgb24), top row first
+        eFrameStreamFormatRGB,
+
+        // Raw planar 8-bit 4:4:4 Rec.709 frames (yuv444p), top row first
+        eFrameStreamFormatYUV
+    };
+
+    /**
+     * @brief A file path of "-" streams to the standard output, a file path of "shm:<name>" publishes the frames
+     * to the shared memory segment <name>
+     **/
+    FrameStreamWriter(FrameStreamFormatEnum format,
+                      const std::string& filePath,
+                      const Format& frameFormat,
+                      double frameRate);
+
+    ~FrameStreamWriter();
+
+    /**
+     * @brief Returns in format the stream format named by str (y4m, rgb or yuv)
+     **/
+    static bool getFormatFromString(const std::string& str, FrameStreamFormatEnum* format);
+
+    /**
+     * @brief Opens the stream. This blocks until a reader opens the other end if the file is a named pipe.
+     * A shared memory segment is created, replacing any segment with the same name.
+     * Returns false and the reason in error if it could not be opened.
+     **/
+    bool open(std::string* error);
+
+    /**
+     * @brief Converts the given image to the pixels of a frame of the stream in frameData. The parts of the
+     * project format that are not covered by the image are black. This may be called concurrently.
+     **/
+    bool convertImage(const ImagePtr& image, std::vector<unsigned char>* frameData) const;
+
+    /**
+     * @brief Writes a frame converted by convertImage() at the given time. The Y4M header is written before the first frame.
+     * Returns false if the stream could not be written, e.g: the reader closed the pipe.
+     **/
+    bool writeFrame(const std::vector<unsigned char>& frameData, double time);
+
+    /**
+     * @brief Closes the stream, the reader then gets the end of the file. The shared memory segment is removed: readers
+     * that mapped it keep their mapping. This is also done by the destructor.
+     **/
+    void close();
+
+private:
+
+    boost::scoped_ptr<FrameStreamWriterPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_FRAMESTREAMWRITER_H
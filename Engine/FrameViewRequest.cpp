@@ -28,6 +28,7 @@
 #include <stdexcept>
 
 #include <QDebug>
+#include <QtCore/QWaitCondition>
 #include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 
 
@@ -59,6 +60,9 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 #ifdef DEBUG
 //#define TRACE_REQUEST_LIFETIME
+
+// Interval in milliseconds at which a request waiting for the request of another render checks if that render still renders it
+#define NATRON_IN_FLIGHT_REQUEST_POLL_INTERVAL_MS 50
 #endif
 
 NATRON_NAMESPACE_ENTER;
@@ -203,6 +207,12 @@ struct FrameViewRequestPrivate
     // The stack of upstram effect distortions
     Distortion2DStackPtr distortionStack;
 
+    // The matrix of upstream concatenated colour effects
+    ColorMatrixPtr colorMatrix;
+
+    // The request of another render producing the same image, see TreeRender::getInFlightRequest()
+    FrameViewRequestPtr inFlightRequest;
+
 #ifdef TRACE_REQUEST_LIFETIME
     std::string nodeName;
 #endif
@@ -210,6 +220,10 @@ struct FrameViewRequestPrivate
     // True if cache write is allowed but not cache read
     bool byPassCache;
 
+    // Woken up when the status is no longer pending. The mutex is separate since lock is recursive.
+    QMutex renderFinishedMutex;
+    QWaitCondition renderFinishedCond;
+
     FrameViewRequestPrivate(const ImagePlaneDesc& plane,
                             unsigned int mipMapLevel,
                             const RenderScale& proxyScale,
@@ -237,7 +251,11 @@ struct FrameViewRequestPrivate
     , neededComps()
     , distortion()
     , distortionStack()
+    , colorMatrix()
+    , inFlightRequest()
     , byPassCache(false)
+    , renderFinishedMutex()
+    , renderFinishedCond()
     {
 #ifdef TRACE_REQUEST_LIFETIME
         nodeName = effect->getNode()->getScriptName_mt_safe();
@@ -393,8 +411,8 @@ FrameViewRequest::notifyRenderStarted()
 {
     QMutexLocker k(&_imp->lock);
 
-    // Only one single thread should be computing a FrameViewRequest
-    assert(_imp->status != FrameViewRequest::eFrameViewRequestStatusPending);
+    // Only one single thread computes a FrameViewRequest: it may be pending if it is rendered
+    // by the render action of another plane, see EffectInstance::launchRenderInternal
     if (_imp->status == FrameViewRequest::eFrameViewRequestStatusNotRendered) {
         _imp->status = FrameViewRequest::eFrameViewRequestStatusPending;
         return FrameViewRequest::eFrameViewRequestStatusNotRendered;
@@ -405,13 +423,79 @@ FrameViewRequest::notifyRenderStarted()
 
 void
 FrameViewRequest::notifyRenderFinished(ActionRetCodeEnum stat)
+{
+    {
+        QMutexLocker k(&_imp->lock);
+        assert(_imp->status == FrameViewRequest::eFrameViewRequestStatusPending);
+        _imp->retCode = stat;
+        _imp->status = FrameViewRequest::eFrameViewRequestStatusRendered;
+    }
+    QMutexLocker k(&_imp->renderFinishedMutex);
+    _imp->renderFinishedCond.wakeAll();
+}
+
+ActionRetCodeEnum
+FrameViewRequest::waitForPendingResults() const
+{
+    QMutexLocker k(&_imp->renderFinishedMutex);
+    for (;;) {
+        {
+            QMutexLocker l(&_imp->lock);
+            if (_imp->status != FrameViewRequest::eFrameViewRequestStatusPending) {
+                return _imp->retCode;
+            }
+        }
+        _imp->renderFinishedCond.wait(&_imp->renderFinishedMutex);
+    }
+}
+
+FrameViewRequestPtr
+FrameViewRequest::getInFlightRequest() const
 {
     QMutexLocker k(&_imp->lock);
-    assert(_imp->status == FrameViewRequest::eFrameViewRequestStatusPending);
-    _imp->retCode = stat;
-    _imp->status = FrameViewRequest::eFrameViewRequestStatusRendered;
+    return _imp->inFlightRequest;
 }
 
+void
+FrameViewRequest::setInFlightRequest(const FrameViewRequestPtr& request)
+{
+    QMutexLocker k(&_imp->lock);
+    _imp->inFlightRequest = request;
+}
+
+ActionRetCodeEnum
+FrameViewRequest::waitForInFlightRequestResults() const
+{
+    FrameViewRequestPtr request = getInFlightRequest();
+    EffectInstancePtr effect = getEffect();
+    if (!request || !effect) {
+        return eActionStatusFailed;
+    }
+
+    QMutexLocker k(&request->_imp->renderFinishedMutex);
+    for (;;) {
+        if ( effect->isRenderAborted() ) {
+            return eActionStatusAborted;
+        }
+
+        // Check the registration first: a request is unregistered after its render called notifyRenderFinished()
+        bool inFlight = TreeRender::isInFlightRequest(request);
+        {
+            QMutexLocker l(&request->_imp->lock);
+            if (request->_imp->status == FrameViewRequest::eFrameViewRequestStatusRendered) {
+                return request->_imp->retCode;
+            }
+        }
+        TreeRenderPtr render = request->getParentRender();
+        if ( !inFlight || !render || render->isRenderAborted() ) {
+            return eActionStatusFailed;
+        }
+
+        // The render of this request may be aborted while waiting, do not wait forever
+        request->_imp->renderFinishedCond.wait(&request->_imp->renderFinishedMutex, NATRON_IN_FLIGHT_REQUEST_POLL_INTERVAL_MS);
+    }
+} // waitForInFlightRequestResults
+
 
 RectD
 FrameViewRequest::getCurrentRoI() const
@@ -633,6 +717,20 @@ FrameViewRequest::setDistorsionStack(const Distortion2DStackPtr& stack)
     _imp->distortionStack = stack;
 }
 
+ColorMatrixPtr
+FrameViewRequest::getColorMatrix() const
+{
+    QMutexLocker k(&_imp->lock);
+    return _imp->colorMatrix;
+}
+
+void
+FrameViewRequest::setColorMatrix(const ColorMatrixPtr& matrix)
+{
+    QMutexLocker k(&_imp->lock);
+    _imp->colorMatrix = matrix;
+}
+
 
 
 NATRON_NAMESPACE_EXIT;
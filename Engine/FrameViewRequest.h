@@ -59,9 +59,6 @@ inline TimeValue roundImageTimeToEpsilon(TimeValue time)
 }
 
 
-typedef std::map<int, RectD> RoIMap; // RoIs are in canonical coordinates
-
-
 struct FrameViewPair
 {
     TimeValue time;
@@ -182,6 +179,25 @@ public:
      **/
     void notifyRenderFinished(ActionRetCodeEnum stat);
 
+    /**
+     * @brief If the status is eFrameViewRequestStatusPending, waits for the thread rendering it to call notifyRenderFinished().
+     * Returns the status of the render.
+     **/
+    ActionRetCodeEnum waitForPendingResults() const;
+
+    /**
+     * @brief The request of another render that renders the image of this request, see TreeRender::getInFlightRequest().
+     * When set, this request does not request its inputs and takes the images of the other request once it is rendered.
+     **/
+    FrameViewRequestPtr getInFlightRequest() const;
+    void setInFlightRequest(const FrameViewRequestPtr& request);
+
+    /**
+     * @brief Waits until the request returned by getInFlightRequest() is rendered by its render and returns the status of that render.
+     * Returns eActionStatusFailed if its render will not render it and eActionStatusAborted if the render of this request is aborted.
+     **/
+    ActionRetCodeEnum waitForInFlightRequestResults() const;
+
     /**
      * @brief Get the render mapped mipmap level (i.e: 0 if the node
      * does not support render scale)
@@ -354,6 +370,13 @@ public:
     Distortion2DStackPtr getDistorsionStack() const;
     void setDistorsionStack(const Distortion2DStackPtr& stack);
 
+    /**
+     * @brief The product of the colour matrices of the concatenated upstream colour effects, which remains
+     * to be applied to the image of this request. NULL if there is none.
+     **/
+    ColorMatrixPtr getColorMatrix() const;
+    void setColorMatrix(const ColorMatrixPtr& matrix);
+
 private:
 
     friend class FrameViewRequestLocker;
@@ -25,11 +25,14 @@
 #include "GPUContextPool.h"
 
 #include <set>
+#include <vector>
+#include <algorithm>
 #include <stdexcept>
 
 #include <QMutex>
 #include <QWaitCondition>
 #include <QtCore/QThread>
+#include <QtCore/QByteArray>
 
 #include "Engine/AppManager.h"
 #include "Engine/OSGLContext.h"
@@ -44,7 +47,8 @@ struct GPUContextPoolPrivate
     mutable QMutex contextPoolMutex;
 
     // protected by contextPoolMutex
-    std::set<OSGLContextPtr> glContextPool;
+    // The contexts in creation order: when several renderers are used, consecutive contexts are on different renderers
+    std::vector<OSGLContextPtr> glContextPool;
 
     OSGLContextWPtr lastUsedGLContext;
 
@@ -154,33 +158,35 @@ GPUContextPool::getOrCreateOpenGLContext(bool retrieveLastContext, bool checkIfG
     OSGLContextPtr shareContext;// _imp->glShareContext.lock();
     OSGLContextPtr newContext;
     SettingsPtr settings =  appPTR->getCurrentSettings();
-    GLRendererID rendererID;
+    std::vector<GLRendererID> rendererIDs;
     if (settings) {
-        rendererID = settings->getActiveOpenGLRendererID();
+        settings->getOpenGLRendererIDsForRendering(&rendererIDs);
+    } else {
+        rendererIDs.push_back( GLRendererID() );
     }
 
-    int maxContexts = settings ? std::max(settings->getMaxOpenGLContexts(), 1) : 1;
+    // The max number of contexts is per renderer
+    int maxContexts = (settings ? std::max(settings->getMaxOpenGLContexts(), 1) : 1) * (int)rendererIDs.size();
 
     if ( (int)_imp->glContextPool.size() < maxContexts ) {
-        //  Create a new one
+        //  Create a new one, on each renderer in turn so that each frame rendered is assigned to the next renderer
+        const GLRendererID& rendererID = rendererIDs[_imp->glContextPool.size() % rendererIDs.size()];
         newContext = OSGLContext::create( FramebufferConfig(), shareContext.get(), true /*useGPU*/, -1, -1, rendererID );
-        _imp->glContextPool.insert(newContext);
+        _imp->glContextPool.push_back(newContext);
     } else {
-        while ((int)_imp->glContextPool.size() > maxContexts) {
-            _imp->glContextPool.erase(_imp->glContextPool.begin());
-        }
+        _imp->glContextPool.resize(maxContexts);
 
         // Cycle through all contexts for all renders
         OSGLContextPtr lastContext = _imp->lastUsedGLContext.lock();
         if (!lastContext) {
-            newContext = *_imp->glContextPool.begin();
+            newContext = _imp->glContextPool.front();
         } else {
-            std::set<OSGLContextPtr>::iterator foundLast = _imp->glContextPool.find(lastContext);
-            assert( foundLast != _imp->glContextPool.end() );
+            std::vector<OSGLContextPtr>::iterator foundLast = std::find(_imp->glContextPool.begin(), _imp->glContextPool.end(), lastContext);
             if ( foundLast == _imp->glContextPool.end() ) {
-                throw std::logic_error("No context to attach");
+                // The last context was removed from the pool
+                newContext = _imp->glContextPool.front();
             } else {
-                std::set<OSGLContextPtr>::iterator next = foundLast;
+                std::vector<OSGLContextPtr>::iterator next = foundLast;
                 ++next;
                 if ( next == _imp->glContextPool.end() ) {
                     next = _imp->glContextPool.begin();
@@ -232,8 +238,19 @@ GPUContextPool::getOrCreateCPUOpenGLContext(bool retrieveLastContext)
         rendererID = settings->getOpenGLCPUDriver();
     }
 
-    // For CPU Contexts, use the threads count, we are not limited by the graphic card
-    const int maxContexts = appPTR->getHardwareIdealThreadCount();
+    // For CPU Contexts, use the threads count by default, we are not limited by the graphic card
+    int maxContexts = settings ? settings->getMaxCPUOpenGLContexts() : 0;
+    if (maxContexts <= 0) {
+        maxContexts = appPTR->getHardwareIdealThreadCount();
+    }
+
+    if ( _imp->cpuGLContextPool.empty() && settings && qgetenv("LP_NUM_THREADS").isEmpty() ) {
+        // llvmpipe reads its rasterizer threads count when the first context is created
+        int nThreads = settings->getCPUOpenGLRendererThreads();
+        if (nThreads > 0) {
+            qputenv( "LP_NUM_THREADS", QByteArray::number(nThreads) );
+        }
+    }
 
     if ( (int)_imp->cpuGLContextPool.size() < maxContexts ) {
         //  Create a new one
@@ -24,13 +24,19 @@
 
 #include "GenericSchedulerThread.h"
 
+#include <list>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QMutex>
 #include <QtCore/QWaitCondition>
 #include <QtCore/QMetaType>
 #include <QtCore/QDebug>
 
+#include "Engine/EngineMetrics.h"
 #include "Engine/GenericSchedulerThreadWatcher.h"
+#include "Engine/Timer.h"
 
 #ifdef DEBUG
 //#define TRACE_GENERIC_SCHEDULER_THREAD
@@ -50,6 +56,45 @@ public:
     }
 };
 
+// A task requested by startTask() or quitThread()
+struct QueuedTask
+{
+    GenericThreadStartArgsPtr args;
+
+    // The value of GenericSchedulerThreadPrivate::nAbortRequests when the task was requested
+    int abortCount;
+
+    // When the task was requested
+    TimestampVal requestTime;
+};
+
+// A node of the stack of the tasks requested and not yet taken by the scheduler thread
+struct PostedTask
+{
+    QueuedTask task;
+    PostedTask* next;
+};
+
+PostedTask*
+loadPostedTask(const QAtomicPointer<PostedTask>& ptr)
+{
+#if QT_VERSION < 0x050000
+    return ptr;
+#else
+    return ptr.loadAcquire();
+#endif
+}
+
+int
+loadInt(const QAtomicInt& value)
+{
+#if QT_VERSION < 0x050000
+    return value;
+#else
+    return value.loadAcquire();
+#endif
+}
+
 NATRON_NAMESPACE_ANONYMOUS_EXIT
 static GenericSchedulerThreadMetaTypesRegistration registration;
 struct GenericSchedulerThreadPrivate
@@ -72,14 +117,28 @@ struct GenericSchedulerThreadPrivate
     mutable QMutex abortRequestedMutex;
     mutable QWaitCondition abortRequestedCond;
 
+    // Incremented (under abortRequestedMutex) by each abort request: the tasks requested before the abort being processed are discarded
+    QAtomicInt nAbortRequests;
+
     // The state of the thread protected by threadStateMutex
     GenericSchedulerThread::ThreadStateEnum threadState;
     mutable QMutex threadStateMutex;
 
-    // The tasks queue, protected by enqueuedTasksMutex
-    std::list<GenericThreadStartArgsPtr> enqueuedTasks, queuedTaskWhileProcessingAbort;
-    QWaitCondition tasksEmptyCond;
-    mutable QMutex enqueuedTasksMutex;
+    // The tasks requested and not yet taken by the scheduler thread, the most recent first. This is a lock-free stack:
+    // any thread pushes to it and the scheduler thread takes all of it at once, so that requesting a task never
+    // waits for the scheduler thread, even when hundreds of tasks are requested per second while dragging a slider.
+    QAtomicPointer<PostedTask> postedTasks;
+
+    // 1 while the scheduler thread waits in tasksPostedCond for a task to be requested
+    QAtomicInt schedulerWaiting;
+    QWaitCondition tasksPostedCond;
+    QMutex tasksPostedMutex;
+
+    // The tasks taken from postedTasks, in the order they were requested. Only accessed by the scheduler thread.
+    std::list<QueuedTask> enqueuedTasks;
+
+    // The frequency of the timestamps of the tasks
+    double timestampFrequency;
 
     // true when the main-thread is calling executeOnMainThread
     bool executingOnMainThread;
@@ -99,12 +158,15 @@ struct GenericSchedulerThreadPrivate
     , abortRequested(0)
     , abortRequestedMutex()
     , abortRequestedCond()
+    , nAbortRequests(0)
     , threadState(GenericSchedulerThread::eThreadStateStopped)
     , threadStateMutex()
+    , postedTasks(0)
+    , schedulerWaiting(0)
+    , tasksPostedCond()
+    , tasksPostedMutex()
     , enqueuedTasks()
-    , queuedTaskWhileProcessingAbort()
-    , tasksEmptyCond()
-    , enqueuedTasksMutex()
+    , timestampFrequency( getPerformanceFrequency() )
     , executingOnMainThread(false)
     , executingOnMainThreadCond()
     , executingOnMainThreadMutex()
@@ -112,6 +174,93 @@ struct GenericSchedulerThreadPrivate
     {
     }
 
+    ~GenericSchedulerThreadPrivate()
+    {
+        PostedTask* task = postedTasks.fetchAndStoreOrdered(0);
+        while (task) {
+            PostedTask* next = task->next;
+            delete task;
+            task = next;
+        }
+    }
+
+    /**
+     * @brief Pushes a task for the scheduler thread and wakes it up if it is waiting. This never blocks unless the scheduler thread is waiting.
+     **/
+    void postTask(const GenericThreadStartArgsPtr& args)
+    {
+        PostedTask* task = new PostedTask;
+        task->task.args = args;
+        task->task.abortCount = loadInt(nAbortRequests);
+        task->task.requestTime = getTimestampInSeconds();
+        PostedTask* head;
+        do {
+            head = loadPostedTask(postedTasks);
+            task->next = head;
+        } while ( !postedTasks.testAndSetOrdered(head, task) );
+
+        // The push above and the store of schedulerWaiting in waitForPostedTasks() are both full barriers:
+        // either the scheduler thread sees the task before waiting or we see that it waits
+        if ( loadInt(schedulerWaiting) ) {
+            QMutexLocker k(&tasksPostedMutex);
+            tasksPostedCond.wakeOne();
+        }
+    }
+
+    /**
+     * @brief Called by the scheduler thread to move the posted tasks to enqueuedTasks, coalescing them:
+     * the quit request discards the tasks requested before it, and with eTaskQueueBehaviorSkipToMostRecent
+     * only the most recent task and the tasks that cannot be skipped are kept.
+     **/
+    void takePostedTasks(GenericSchedulerThread::TaskQueueBehaviorEnum behavior)
+    {
+        PostedTask* task = postedTasks.fetchAndStoreOrdered(0);
+        if (!task) {
+            return;
+        }
+
+        // The stack has the most recent task first
+        std::list<QueuedTask> tasks;
+        while (task) {
+            tasks.push_front(task->task);
+            PostedTask* next = task->next;
+            delete task;
+            task = next;
+        }
+        for (std::list<QueuedTask>::const_iterator it = tasks.begin(); it != tasks.end(); ++it) {
+            if ( it->args->isNull() ) {
+                enqueuedTasks.clear();
+            }
+            enqueuedTasks.push_back(*it);
+        }
+
+        if ( (behavior == GenericSchedulerThread::eTaskQueueBehaviorSkipToMostRecent) && (enqueuedTasks.size() > 1) ) {
+            std::list<QueuedTask>::iterator last = enqueuedTasks.end();
+            --last;
+            for (std::list<QueuedTask>::iterator it = enqueuedTasks.begin(); it != last;) {
+                if ( it->args->isSkippable() ) {
+                    it = enqueuedTasks.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Called by the scheduler thread to wait until a task is posted
+     **/
+    void waitForPostedTasks()
+    {
+        QMutexLocker k(&tasksPostedMutex);
+
+        schedulerWaiting.fetchAndStoreOrdered(1);
+        while ( !loadPostedTask(postedTasks) ) {
+            tasksPostedCond.wait(&tasksPostedMutex);
+        }
+        schedulerWaiting.fetchAndStoreOrdered(0);
+    }
+
     void setThreadState(GenericSchedulerThread::ThreadStateEnum state)
     {
         QMutexLocker k(&threadStateMutex);
@@ -169,13 +318,10 @@ GenericSchedulerThread::quitThread(bool allowRestarts)
     }
 
 
-    // Clear any task enqueued and push a fake request
+    // Push a fake request: the scheduler thread discards the tasks requested before it
     {
-        QMutexLocker k(&_imp->enqueuedTasksMutex);
-        _imp->enqueuedTasks.clear();
         GenericThreadStartArgsPtr stubArgs( new GenericThreadStartArgs(true) );
-        _imp->enqueuedTasks.push_back(stubArgs);
-        _imp->tasksEmptyCond.wakeOne();
+        _imp->postTask(stubArgs);
     }
 
 #ifdef TRACE_GENERIC_SCHEDULER_THREAD
@@ -325,6 +471,7 @@ GenericSchedulerThread::abortThreadedTask(bool keepOldestRender)
         qDebug() << QThread::currentThread() << ": Aborting task on" <<  getThreadName().c_str();
 #endif
         ++_imp->abortRequested;
+        _imp->nAbortRequests.fetchAndAddOrdered(1);
 
     }
 
@@ -408,22 +555,10 @@ GenericSchedulerThread::startTask(const GenericThreadStartArgsPtr& inArgs)
     }
 
     bool running = isRunning();
-    {
-        QMutexLocker k1(&_imp->enqueuedTasksMutex);
-        QMutexLocker k2(&_imp->abortRequestedMutex);
 #ifdef TRACE_GENERIC_SCHEDULER_THREAD
-        qDebug() << QThread::currentThread() << ": Requesting task on" <<  getThreadName().c_str() << ", is thread aborted?" << (bool)(_imp->abortRequested > 0);
+    qDebug() << QThread::currentThread() << ": Requesting task on" <<  getThreadName().c_str();
 #endif
-        if (_imp->abortRequested > 0) {
-            _imp->queuedTaskWhileProcessingAbort.push_back(inArgs);
-        } else {
-            _imp->enqueuedTasks.push_back(inArgs);
-        }
-
-        if (running) {
-            _imp->tasksEmptyCond.wakeOne();
-        }
-    }
+    _imp->postTask(inArgs);
     if (!running) {
         start();
     }
@@ -446,30 +581,29 @@ GenericSchedulerThread::run()
         {
             GenericThreadStartArgsPtr args;
             {
-                QMutexLocker k(&_imp->enqueuedTasksMutex);
+                _imp->takePostedTasks(behavior);
+                QueuedTask task;
                 switch (behavior) {
                     case eTaskQueueBehaviorProcessInOrder: {
                         if ( !_imp->enqueuedTasks.empty() ) {
-                            args = _imp->enqueuedTasks.front();
+                            task = _imp->enqueuedTasks.front();
                             _imp->enqueuedTasks.pop_front();
                         }
                         break;
                     }
                     case eTaskQueueBehaviorSkipToMostRecent: {
+                        // takePostedTasks() only left the tasks that cannot be skipped before the most recent one
                         if ( !_imp->enqueuedTasks.empty() ) {
-                            args = _imp->enqueuedTasks.back();
+                            task = _imp->enqueuedTasks.back();
                             _imp->enqueuedTasks.pop_back();
-                            std::list<GenericThreadStartArgsPtr> unskippableTasks;
-                            for (std::list<GenericThreadStartArgsPtr>::iterator it = _imp->enqueuedTasks.begin(); it != _imp->enqueuedTasks.end(); ++it) {
-                                if (!(*it)->isSkippable()) {
-                                    unskippableTasks.push_back(*it);
-                                }
-                            }
-                            _imp->enqueuedTasks = unskippableTasks;
                         }
                         break;
                     }
                 }
+                args = task.args;
+                if ( args && !args->isNull() ) {
+                    EngineMetrics::addSchedulerTaskStartLatency( getTimeElapsed(task.requestTime, getTimestampInSeconds(), _imp->timestampFrequency) );
+                }
             }
             {
                 _imp->setThreadState(eThreadStateActive);
@@ -514,22 +648,26 @@ GenericSchedulerThread::run()
         
         // Reset the abort requested flag:
         // If a thread A called abortThreadedTask() multiple times and the scheduler thread B was running in the meantime, it could very well
-        // stop and wait in the tasksEmptyCond
-        QMutexLocker tasksLocker(&_imp->enqueuedTasksMutex);
+        // stop and wait in the tasksPostedCond
         {
             QMutexLocker k(&_imp->abortRequestedMutex);
+            _imp->takePostedTasks(behavior);
             if (state == eThreadStateAborted) {
-                // If the processing was aborted, clear task that were requested prior to the abort flag was passed, and insert the task that were posted
-                // after the abort was requested up until now
-#ifdef TRACE_GENERIC_SCHEDULER_THREAD
-                qDebug() << getThreadName().c_str() << ": Thread going idle after being aborted. " << _imp->queuedTaskWhileProcessingAbort.size() << "tasks were pushed while abort being processed.";
-#endif
+                // If the processing was aborted, clear the tasks that were requested before the last abort request and keep the tasks
+                // that were requested after it up until now
+                int abortCount = loadInt(_imp->nAbortRequests);
                 if (behavior == eTaskQueueBehaviorProcessInOrder) {
-                    _imp->enqueuedTasks.clear();
+                    for (std::list<QueuedTask>::iterator it = _imp->enqueuedTasks.begin(); it != _imp->enqueuedTasks.end();) {
+                        if ( (it->abortCount < abortCount) && !it->args->isNull() ) {
+                            it = _imp->enqueuedTasks.erase(it);
+                        } else {
+                            ++it;
+                        }
+                    }
                 }
-
-                _imp->enqueuedTasks.insert( _imp->enqueuedTasks.end(), _imp->queuedTaskWhileProcessingAbort.begin(), _imp->queuedTaskWhileProcessingAbort.end() );
-                _imp->queuedTaskWhileProcessingAbort.clear();
+#ifdef TRACE_GENERIC_SCHEDULER_THREAD
+                qDebug() << getThreadName().c_str() << ": Thread going idle after being aborted. " << _imp->enqueuedTasks.size() << "tasks were pushed while abort being processed.";
+#endif
             } else {
 #ifdef TRACE_GENERIC_SCHEDULER_THREAD
                 qDebug() << getThreadName().c_str() << ": Thread going idle normally.";
@@ -542,8 +680,9 @@ GenericSchedulerThread::run()
             }
         }
 
-        while (_imp->enqueuedTasks.empty() && _imp->queuedTaskWhileProcessingAbort.empty()) {
-            _imp->tasksEmptyCond.wait(&_imp->enqueuedTasksMutex);
+        while ( _imp->enqueuedTasks.empty() ) {
+            _imp->waitForPostedTasks();
+            _imp->takePostedTasks(behavior);
         }
 #ifdef TRACE_GENERIC_SCHEDULER_THREAD
         qDebug() << getThreadName().c_str() << ": Received start request";
@@ -27,6 +27,14 @@
 #include <cassert>
 #include <stdexcept>
 
+#include "Engine/AppInstance.h"
+#include "Engine/FrameViewRequest.h"
+#include "Engine/Hash64.h"
+#include "Engine/Image.h"
+#include "Engine/Node.h"
+#include "Engine/NodeGroup.h"
+#include "Engine/Project.h"
+
 NATRON_NAMESPACE_ENTER;
 
 
@@ -45,6 +53,126 @@ GroupOutput::createPlugin()
     return ret;
 }
 
+bool
+GroupOutput::isCacheBoundary() const
+{
+    NodeGroupPtr isGrp = toNodeGroup( getNode()->getGroup() );
+    return isGrp && isGrp->isCacheBoundaryEnabled();
+}
+
+ActionRetCodeEnum
+GroupOutput::isIdentity(TimeValue time,
+                        const RenderScale & scale,
+                        const RectI & roi,
+                        ViewIdx view,
+                        const ImagePlaneDesc& plane,
+                        TimeValue* inputTime,
+                        ViewIdx* inputView,
+                        int* inputNb,
+                        ImagePlaneDesc* inputPlane)
+{
+    if ( isCacheBoundary() ) {
+        // Render a copy of the input so that it gets cached
+        *inputNb = -1;
+
+        return eActionStatusOK;
+    }
+
+    return NoOpBase::isIdentity(time, scale, roi, view, plane, inputTime, inputView, inputNb, inputPlane);
+}
+
+ActionRetCodeEnum
+GroupOutput::render(const RenderActionArgs& args)
+{
+    // Only called for a cache boundary: copy the source images
+    for (std::list<std::pair<ImagePlaneDesc, ImagePtr > >::const_iterator it = args.outputPlanes.begin(); it != args.outputPlanes.end(); ++it) {
+
+        GetImageInArgs inArgs(&args.mipMapLevel, &args.proxyScale, &args.roi, &args.backendType);
+        inArgs.inputNb = 0;
+        inArgs.plane = &it->first;
+        GetImageOutArgs outArgs;
+        if (!getImagePlane(inArgs, &outArgs)) {
+            return eActionStatusInputDisconnected;
+        }
+
+        Image::CopyPixelsArgs cpyArgs;
+        cpyArgs.roi = args.roi;
+        ActionRetCodeEnum stat = it->second->copyPixels(*outArgs.image, cpyArgs);
+        if (isFailureRetCode(stat)) {
+            return stat;
+        }
+    }
+
+    return eActionStatusOK;
+} // render
+
+bool
+GroupOutput::shouldCacheOutput(bool isFrameVaryingOrAnimated,
+                               int visitsCount) const
+{
+    if ( isCacheBoundary() ) {
+        return true;
+    }
+
+    return NoOpBase::shouldCacheOutput(isFrameVaryingOrAnimated, visitsCount);
+}
+
+void
+GroupOutput::appendToHash(const ComputeHashArgs& args,
+                          Hash64* hash)
+{
+    NodeGroupPtr isGrp = toNodeGroup( getNode()->getGroup() );
+    if ( !isGrp || !isGrp->isCacheBoundaryEnabled() || (args.hashType != HashableObject::eComputeHashTypeTimeViewVariant) ) {
+        NoOpBase::appendToHash(args, hash);
+
+        return;
+    }
+
+    // The image of a cache boundary is keyed by what is exposed by the group rather than by the sub-graph:
+    // the TimeViewVariant hash would otherwise have to be computed on all nodes of the sub-graph for each frame.
+    NodePtr groupNode = isGrp->getNode();
+    Hash64::appendString(getNode()->getPluginID(), hash);
+    Hash64::appendString(groupNode->getPluginID(), hash);
+
+    U64 projectHash = getApp()->getProject()->computeHash(args);
+    hash->append(projectHash);
+
+    // The parameters of the group at this time
+    isGrp->KnobHolder::appendToHash(args, hash);
+
+    // The nodes of the sub-graph: the TimeViewInvariant hash does not change with the time so it is computed once
+    {
+        NodePtr outputInput = isGrp->getOutputNodeInput();
+        EffectInstancePtr outputInputEffect = outputInput ? outputInput->getEffectInstance() : EffectInstancePtr();
+        if (outputInputEffect) {
+            ComputeHashArgs invariantArgs = args;
+            invariantArgs.hashType = HashableObject::eComputeHashTypeTimeViewInvariant;
+            hash->append( outputInputEffect->computeHash(invariantArgs) );
+        } else {
+            hash->append(0);
+        }
+    }
+
+    hash->append( (double)roundImageTimeToEpsilon(args.time) );
+    hash->append( (int)args.view );
+
+    // The inputs of the group at the same time
+    int nInputs = isGrp->getMaxInputCount();
+    for (int i = 0; i < nInputs; ++i) {
+        EffectInstancePtr input = isGrp->getInputMainInstance(i);
+        if (!input) {
+            hash->append(0);
+        } else {
+            hash->append( input->computeHash(args) );
+        }
+    }
+
+    bool disabled = isNodeDisabledForFrame(args.time, args.view);
+    hash->append(disabled);
+
+    hash->computeHash();
+} // appendToHash
+
 NATRON_NAMESPACE_EXIT;
 NATRON_NAMESPACE_USING
 #include "moc_GroupOutput.cpp"
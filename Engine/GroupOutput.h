@@ -83,6 +83,31 @@ public:
     {
         return true;
     }
+
+    /**
+     * @brief Returns true if the group containing this node has kNatronNodeKnobCacheBoundary checked.
+     * In that case this node is not skipped by the render: it renders a copy of its input which is always cached,
+     * with a key that does not require to visit the nodes of the sub-graph for each frame.
+     **/
+    bool isCacheBoundary() const;
+
+private:
+
+    virtual ActionRetCodeEnum isIdentity(TimeValue time,
+                                         const RenderScale & scale,
+                                         const RectI & roi,
+                                         ViewIdx view,
+                                         const ImagePlaneDesc& plane,
+                                         TimeValue* inputTime,
+                                         ViewIdx* inputView,
+                                         int* inputNb,
+                                         ImagePlaneDesc* inputPlane) OVERRIDE FINAL WARN_UNUSED_RETURN;
+
+    virtual ActionRetCodeEnum render(const RenderActionArgs& args) OVERRIDE FINAL WARN_UNUSED_RETURN;
+
+    virtual bool shouldCacheOutput(bool isFrameVaryingOrAnimated, int visitsCount) const OVERRIDE FINAL WARN_UNUSED_RETURN;
+
+    virtual void appendToHash(const ComputeHashArgs& args, Hash64* hash) OVERRIDE FINAL;
 };
 
 inline GroupOutputPtr
@@ -0,0 +1,183 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_HALFFLOAT_H
+#define NATRON_ENGINE_HALFFLOAT_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstring> // memcpy
+
+#ifdef __F16C__
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__ARM_FP16_FORMAT_IEEE)
+#include <arm_neon.h>
+#define NATRON_HALF_FLOAT_NEON
+#endif
+
+#include "Global/GlobalDefines.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief A pixel value of an eImageBitDepthHalf image: an IEEE 754 binary16 floating point value, as in OpenEXR.
+ * This is only a storage type: values are converted to float to be processed.
+ * Conversions from float round to the nearest even value.
+ **/
+struct HalfFloat
+{
+    unsigned short bits;
+
+    HalfFloat()
+    : bits(0)
+    {
+    }
+
+    HalfFloat(float f)
+    : bits( fromFloat(f) )
+    {
+    }
+
+    operator float() const
+    {
+        return toFloat(bits);
+    }
+
+    static inline unsigned short fromFloat(float f)
+    {
+        U32 x;
+        std::memcpy(&x, &f, sizeof(U32));
+        const U32 sign = (x >> 16) & 0x8000;
+        const U32 absx = x & 0x7fffffff;
+
+        if (absx >= 0x7f800000) {
+            // Infinity or NaN: keep NaNs quiet
+            return (unsigned short)( sign | 0x7c00 | (absx > 0x7f800000 ? 0x200 : 0) );
+        }
+        if (absx >= 0x477ff000) {
+            // Rounds above the largest half (65504)
+            return (unsigned short)(sign | 0x7c00);
+        }
+        if (absx < 0x38800000) {
+            // Below the smallest normal half (2^-14): subnormal or zero
+            if (absx < 0x33000000) {
+                return (unsigned short)sign;
+            }
+            const U32 e = absx >> 23;
+            const U32 m = (absx & 0x7fffff) | 0x800000;
+            const U32 shift = 126 - e;
+            U32 h = m >> shift;
+            const U32 rem = m & ( (1u << shift) - 1 );
+            const U32 halfway = 1u << (shift - 1);
+            if ( (rem > halfway) || ( (rem == halfway) && (h & 1) ) ) {
+                ++h;
+            }
+
+            return (unsigned short)(sign | h);
+        }
+
+        // Normal: re-bias the exponent, a carry of the rounding correctly increments the exponent
+        U32 h = (absx - 0x38000000) >> 13;
+        const U32 rem = absx & 0x1fff;
+        if ( (rem > 0x1000) || ( (rem == 0x1000) && (h & 1) ) ) {
+            ++h;
+        }
+
+        return (unsigned short)(sign | h);
+    } // fromFloat
+
+    static inline float toFloat(unsigned short h)
+    {
+        const U32 sign = (U32)(h & 0x8000) << 16;
+        int e = (h >> 10) & 0x1f;
+        U32 m = h & 0x3ff;
+        U32 x;
+
+        if (e == 0) {
+            if (m == 0) {
+                x = sign;
+            } else {
+                // Subnormal: normalize
+                e = 1;
+                while ( !(m & 0x400) ) {
+                    m <<= 1;
+                    --e;
+                }
+                m &= 0x3ff;
+                x = sign | ( (U32)(e + 112) << 23 ) | (m << 13);
+            }
+        } else if (e == 31) {
+            x = sign | 0x7f800000 | (m << 13);
+        } else {
+            x = sign | ( (U32)(e + 112) << 23 ) | (m << 13);
+        }
+
+        float f;
+        std::memcpy(&f, &x, sizeof(float));
+
+        return f;
+    }
+
+    /**
+     * @brief Converts n contiguous values. This uses the F16C instructions on x86 and NEON on ARM when
+     * the compiler targets them.
+     **/
+    static inline void toFloat(const HalfFloat* src, float* dst, int n)
+    {
+        int i = 0;
+#ifdef __F16C__
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps( dst + i, _mm256_cvtph_ps( _mm_loadu_si128( (const __m128i*)(src + i) ) ) );
+        }
+#elif defined(NATRON_HALF_FLOAT_NEON)
+        for (; i + 4 <= n; i += 4) {
+            vst1q_f32( dst + i, vcvt_f32_f16( vreinterpret_f16_u16( vld1_u16( (const uint16_t*)(src + i) ) ) ) );
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = toFloat(src[i].bits);
+        }
+    }
+
+    static inline void fromFloat(const float* src, HalfFloat* dst, int n)
+    {
+        int i = 0;
+#ifdef __F16C__
+        for (; i + 8 <= n; i += 8) {
+            _mm_storeu_si128( (__m128i*)(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT) );
+        }
+#elif defined(NATRON_HALF_FLOAT_NEON)
+        for (; i + 4 <= n; i += 4) {
+            vst1_u16( (uint16_t*)(dst + i), vreinterpret_u16_f16( vcvt_f16_f32( vld1q_f32(src + i) ) ) );
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i].bits = fromFloat(src[i]);
+        }
+    }
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_HALFFLOAT_H
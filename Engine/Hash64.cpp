@@ -26,11 +26,9 @@
 
 #include <algorithm>  // for std::for_each
 #include <cassert>
+#include <cstring> // memcpy
 #include <stdexcept>
 
-#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
-#include <boost/crc.hpp>
-#endif
 #include <QtCore/QString>
 
 #include "Engine/Node.h"
@@ -38,58 +36,99 @@
 
 NATRON_NAMESPACE_ENTER;
 
+#define NATRON_HASH64_PRIME_1 0x9E3779B185EBCA87ULL
+#define NATRON_HASH64_PRIME_2 0xC2B2AE3D27D4EB4FULL
+#define NATRON_HASH64_PRIME_3 0x165667B19E3779F9ULL
+#define NATRON_HASH64_PRIME_4 0x85EBCA77C2B2AE63ULL
+#define NATRON_HASH64_PRIME_5 0x27D4EB2F165667C5ULL
+
+void
+Hash64::resetAccumulators()
+{
+    acc[0] = NATRON_HASH64_PRIME_1 + NATRON_HASH64_PRIME_2;
+    acc[1] = NATRON_HASH64_PRIME_2;
+    acc[2] = 0;
+    acc[3] = 0 - NATRON_HASH64_PRIME_1;
+}
+
 void
 Hash64::computeHash()
 {
     if (hashValid) {
         return;
     }
-    if ( node_values.empty() ) {
+    if (nValues == 0) {
         return;
     }
 
-    const unsigned char* data = reinterpret_cast<const unsigned char*>( &node_values.front() );
-    boost::crc_optimal<64, 0x42F0E1EBA9EA3693ULL, 0, 0, false, false> crc_64;
-    crc_64.process_bytes(data, node_values.size() * sizeof(node_values[0]));
-    hash = crc_64.checksum();
+    // Merge the accumulators and avalanche as XXH64 does. The accumulators are left untouched so that values may still be appended.
+    U64 h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+    for (int i = 0; i < 4; ++i) {
+        h ^= mix(0, acc[i]);
+        h = h * NATRON_HASH64_PRIME_1 + NATRON_HASH64_PRIME_4;
+    }
+    h += nValues * sizeof(U64);
+
+    h ^= h >> 33;
+    h *= NATRON_HASH64_PRIME_2;
+    h ^= h >> 29;
+    h *= NATRON_HASH64_PRIME_3;
+    h ^= h >> 32;
+
+    hash = h;
     hashValid = true;
 }
 
 void
 Hash64::reset()
 {
-    node_values.clear();
+    resetAccumulators();
+    nValues = 0;
     hash = 0;
     hashValid = false;
 }
 
 void
-Hash64::appendQString(const QString & str, Hash64* hash)
+Hash64::appendBytes(const void* data, std::size_t size)
 {
-    std::size_t curSize = hash->node_values.size();
-    hash->node_values.resize(curSize + str.size());
-
-    int c = (int)curSize;
-    for (QString::const_iterator it = str.begin(); it != str.end(); ++it, ++c) {
-        hash->node_values[c] = toU64<unsigned short>(it->unicode());
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    std::size_t nWords = size / sizeof(U64);
+    for (std::size_t i = 0; i < nWords; ++i) {
+        U64 v;
+        std::memcpy(&v, bytes + i * sizeof(U64), sizeof(U64));
+        appendU64(v);
+    }
+    std::size_t remaining = size - nWords * sizeof(U64);
+    if (remaining) {
+        U64 v = 0;
+        std::memcpy(&v, bytes + nWords * sizeof(U64), remaining);
+        appendU64(v);
     }
+
+    // Append the size so that the zero padding of the last value cannot be confused with actual data
+    appendU64( (U64)size );
 }
 
 void
-Hash64::appendCurve(const CurvePtr& curve, Hash64* hash)
+Hash64::appendQString(const QString & str, Hash64* hash)
 {
-    KeyFrameSet keys = curve->getKeyFrames_mt_safe();
+    hash->appendBytes( str.utf16(), str.size() * sizeof(ushort) );
+}
 
-    std::size_t curSize = hash->node_values.size();
-    hash->node_values.resize(curSize + 4 * keys.size());
+void
+Hash64::appendString(const std::string & str, Hash64* hash)
+{
+    hash->appendBytes( str.data(), str.size() );
+}
 
+void
+Hash64::appendCurve(const CurvePtr& curve, Hash64* hash)
+{
+    KeyFrameSetConstPtr keys = curve->getKeyFramesSnapshot_mt_safe();
 
-    int c = curSize;
-    for (KeyFrameSet::const_iterator it = keys.begin(); it!=keys.end(); ++it, c += 4) {
-        hash->node_values[c] = toU64((double)it->getTime());
-        hash->node_values[c + 1] = toU64(it->getValue());
-        hash->node_values[c + 2] = toU64(it->getLeftDerivative());
-        hash->node_values[c + 3] = toU64(it->getRightDerivative());
+    for (KeyFrameSet::const_iterator it = keys->begin(); it!=keys->end(); ++it) {
+        double values[4] = { (double)it->getTime(), it->getValue(), it->getLeftDerivative(), it->getRightDerivative() };
+        hash->appendArray(values, 4);
     }
 }
 
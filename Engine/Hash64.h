@@ -44,14 +44,20 @@ NATRON_NAMESPACE_ENTER;
     - the hash values for the  tree upstream
  */
 
+/**
+ * @brief A streaming 64-bit hash: values are mixed as soon as they are appended, using 4 independent
+ * accumulators in the same way as XXH64, so nothing is buffered and consecutive values can be processed in parallel
+ * by the CPU. Use appendArray() to hash contiguous arrays in one call.
+ **/
 class Hash64
 {
 public:
     Hash64()
     : hash(0)
-    , node_values()
+    , nValues(0)
     , hashValid(false)
     {
+        resetAccumulators();
     }
 
     ~Hash64()
@@ -65,7 +71,7 @@ public:
 
     bool isEmpty() const
     {
-        return node_values.empty();
+        return nValues == 0;
     }
 
     void computeHash();
@@ -106,26 +112,51 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
     void insert(const std::vector<U64>& elements)
     {
-        std::size_t curSize = node_values.size();
-        node_values.resize(curSize + elements.size());
-
-        int c = curSize;
-        for (std::vector<U64>::const_iterator it = elements.begin(); it != elements.end(); ++it, ++c) {
-            node_values[c] = *it;
+        if ( !elements.empty() ) {
+            appendArray(&elements.front(), elements.size());
         }
-        hashValid = false;
-
     }
 
     template<typename T>
     void append(T value)
     {
-        node_values.push_back( toU64(value) );
+        appendU64( toU64(value) );
+    }
+
+    /**
+     * @brief Appends count values of a POD type of at most 8 bytes, same as calling append() on each of them.
+     **/
+    template<typename T>
+    void appendArray(const T* values, std::size_t count)
+    {
+        std::size_t i = 0;
+
+        // Complete the current stripe so that the next 4 values go to the 4 accumulators
+        for (; i < count && (nValues & 3); ++i) {
+            appendU64( toU64(values[i]) );
+        }
+        for (; i + 4 <= count; i += 4) {
+            acc[0] = mix(acc[0], toU64(values[i]));
+            acc[1] = mix(acc[1], toU64(values[i + 1]));
+            acc[2] = mix(acc[2], toU64(values[i + 2]));
+            acc[3] = mix(acc[3], toU64(values[i + 3]));
+            nValues += 4;
+        }
+        for (; i < count; ++i) {
+            appendU64( toU64(values[i]) );
+        }
         hashValid = false;
     }
 
+    /**
+     * @brief Appends raw bytes packed in 64-bit values, followed by their count.
+     **/
+    void appendBytes(const void* data, std::size_t size);
+
     static void appendQString(const QString & str, Hash64* hash);
 
+    static void appendString(const std::string & str, Hash64* hash);
+
     static void appendCurve(const CurvePtr& curve, Hash64* hash);
 
     bool operator== (const Hash64 & h) const
@@ -139,6 +170,31 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
     }
 
 private:
+
+    static U64 rotl(U64 x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static U64 mix(U64 accumulator, U64 input)
+    {
+        accumulator += input * 0xC2B2AE3D27D4EB4FULL;
+        accumulator = rotl(accumulator, 31);
+        accumulator *= 0x9E3779B185EBCA87ULL;
+
+        return accumulator;
+    }
+
+    void appendU64(U64 v)
+    {
+        U64& a = acc[nValues & 3];
+        a = mix(a, v);
+        ++nValues;
+        hashValid = false;
+    }
+
+    void resetAccumulators();
+
     template<typename T>
     struct alias_cast_t
     {
@@ -155,7 +211,10 @@ private:
     };
 
     U64 hash;
-    std::vector<U64> node_values;
+
+    // The XXH64 accumulators, the i-th value appended goes to acc[i % 4]
+    U64 acc[4];
+    U64 nValues;
     bool hashValid;
 };
 
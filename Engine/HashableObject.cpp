@@ -25,12 +25,49 @@
 #include "HashableObject.h"
 #include <list>
 #include <QMutex>
+#include <QtCore/QAtomicInt>
 
 #include "Engine/Hash64.h"
 #include "Engine/FrameViewRequest.h"
+#include "Engine/ThreadStorage.h"
 
 NATRON_NAMESPACE_ENTER
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// Incremented each time any object caches a hash, see HashableObject::notifyCacheFilled().
+// If it did not change since an object was invalidated, nothing can have been cached in the objects that
+// are reached by its invalidation: they are still invalidated and do not need to be walked again.
+QAtomicInt cacheVersion;
+
+// The cache version when the invalidation being done on this thread started
+ThreadStorage<int> invalidationVersion;
+
+// Incremented by each invalidation out of a scope opened with HashableObject::beginReportedInvalidations()
+QAtomicInt unreportedInvalidationsCount;
+
+struct ReportedInvalidationsScope
+{
+    // The objects invalidated in the scope opened on this thread, or NULL if there is none
+    std::set<HashableObject*>* invalidatedObjects;
+
+    ReportedInvalidationsScope()
+    : invalidatedObjects(0)
+    {
+
+    }
+};
+
+ThreadStorage<ReportedInvalidationsScope> reportedInvalidationsScope;
+
+int
+getCacheVersion()
+{
+    return cacheVersion.fetchAndAddRelaxed(0);
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 struct HashableObjectPrivate
 {
     // The list of other objects that need this hash as part of their result
@@ -48,6 +85,11 @@ struct HashableObjectPrivate
 
     bool metadataSlaveCacheValid;
 
+    // The cache version at the start of the last invalidation of this object.
+    // Only meaningful if invalidatedAtVersionValid is true.
+    int invalidatedAtVersion;
+    bool invalidatedAtVersionValid;
+
     // protects all members
     mutable QMutex hashCacheMutex;
 
@@ -62,6 +104,8 @@ struct HashableObjectPrivate
     , timeViewInvariantCacheValid(false)
     , metadataSlaveCache(0)
     , metadataSlaveCacheValid(false)
+    , invalidatedAtVersion(0)
+    , invalidatedAtVersionValid(false)
     , hashCacheMutex(QMutex::Recursive) // It might recurse when calling getValue on a knob with an expression because of randomSeed
     , hashCacheEnabled(true)
     {
@@ -76,6 +120,8 @@ struct HashableObjectPrivate
     , timeViewInvariantCacheValid(false)
     , metadataSlaveCache()
     , metadataSlaveCacheValid(false)
+    , invalidatedAtVersion(0)
+    , invalidatedAtVersionValid(false)
     , hashCacheMutex(QMutex::Recursive)
     , hashCacheEnabled(true)
     {
@@ -116,6 +162,10 @@ void
 HashableObject::addHashListener(const HashableObjectPtr& parent)
 {
     _imp->listeners.insert(parent);
+
+    // The listener may have a hash cached: the next invalidation must reach it
+    QMutexLocker k(&_imp->hashCacheMutex);
+    _imp->invalidatedAtVersionValid = false;
 }
 
 void
@@ -165,8 +215,12 @@ HashableObjectPrivate::findCachedHashInternal(const HashableObject::FindHashArgs
 bool
 HashableObject::findCachedHash(const FindHashArgs& args, U64 *hash) const
 {
+    FindHashArgs findArgs = args;
+    if ( (args.hashType == eComputeHashTypeTimeViewVariant) && isHashTimeInvariant(args.view) ) {
+        findArgs.time = TimeValue(0);
+    }
     QMutexLocker k(&_imp->hashCacheMutex);
-    return _imp->findCachedHashInternal(args, hash);
+    return _imp->findCachedHashInternal(findArgs, hash);
 }
 
 
@@ -182,13 +236,19 @@ HashableObject::computeHash_noCache(const ComputeHashArgs& args, Hash64* hash)
 U64
 HashableObject::computeHash(const ComputeHashArgs& args)
 {
+    // If the hash does not depend on the time, cache it for all frames at time 0
+    TimeValue cacheTime = args.time;
+    if ( (args.hashType == eComputeHashTypeTimeViewVariant) && isHashTimeInvariant(args.view) ) {
+        cacheTime = TimeValue(0);
+    }
+
     {
         // Find a hash in the cache.
         QMutexLocker k(&_imp->hashCacheMutex);
         U64 hashValue;
         if (_imp->hashCacheEnabled) {
             FindHashArgs findArgs;
-            findArgs.time = args.time;
+            findArgs.time = cacheTime;
             findArgs.view = args.view;
             findArgs.hashType = args.hashType;
             if (_imp->findCachedHashInternal(findArgs, &hashValue)) {
@@ -216,10 +276,11 @@ HashableObject::computeHash(const ComputeHashArgs& args)
                 _imp->metadataSlaveCacheValid = true;
                 break;
             case eComputeHashTypeTimeViewVariant:
-                FrameViewPair fv = {roundImageTimeToEpsilon(args.time), args.view};
+                FrameViewPair fv = {roundImageTimeToEpsilon(cacheTime), args.view};
                 _imp->timeViewVariantHashCache[fv] = hashValue;
                 break;
         }
+        notifyCacheFilled();
 
         return hashValue;
         
@@ -239,9 +300,20 @@ HashableObject::invalidateHashCacheInternal(std::set<HashableObject*>* invalidat
     }
     invalidatedObjects->insert(this);
 
+    int version = invalidationVersion.localData();
     {
         QMutexLocker k(&_imp->hashCacheMutex);
 
+        // If nothing was cached since this object was last invalidated, this object and all the objects
+        // reached by its invalidation are still invalidated.
+        // When the invalidations are reported, all the objects reached must be known.
+        if ( _imp->invalidatedAtVersionValid && (_imp->invalidatedAtVersion == getCacheVersion()) && !reportedInvalidationsScope.localData().invalidatedObjects ) {
+            _imp->invalidatedAtVersion = version;
+            return false;
+        }
+        _imp->invalidatedAtVersion = version;
+        _imp->invalidatedAtVersionValid = true;
+
         // Edit: we cannot do this below: The main instance hash cache may be empty because nobody asked to compute the hash on the main thread
         // but some other object that depend on this hash may very well need to have their hash cache cleared.
 #if 0
@@ -266,8 +338,71 @@ HashableObject::invalidateHashCacheInternal(std::set<HashableObject*>* invalidat
 void
 HashableObject::invalidateHashCache()
 {
+    // Objects are marked with the version at the start of the invalidation: if anything is cached
+    // while it is in progress, they will be walked again by the next invalidation.
+    int& version = invalidationVersion.localData();
+    int prevVersion = version;
+    version = getCacheVersion();
+
+    std::set<HashableObject*>* reportedObjects = reportedInvalidationsScope.localData().invalidatedObjects;
+    if (!reportedObjects) {
+        notifyUnreportedInvalidation();
+    }
+
     std::set<HashableObject*> objs;
     invalidateHashCacheInternal(&objs);
+
+    if (reportedObjects) {
+        reportedObjects->insert(objs.begin(), objs.end());
+    }
+
+    version = prevVersion;
+}
+
+std::set<HashableObject*>*
+HashableObject::beginReportedInvalidations(std::set<HashableObject*>* invalidatedObjects)
+{
+    assert(invalidatedObjects);
+    ReportedInvalidationsScope& scope = reportedInvalidationsScope.localData();
+    std::set<HashableObject*>* previousObjects = scope.invalidatedObjects;
+    scope.invalidatedObjects = invalidatedObjects;
+    return previousObjects;
+}
+
+void
+HashableObject::endReportedInvalidations(std::set<HashableObject*>* previousInvalidatedObjects)
+{
+    ReportedInvalidationsScope& scope = reportedInvalidationsScope.localData();
+    // The objects invalidated in a nested scope are also invalidated by the outer scope
+    if (previousInvalidatedObjects && scope.invalidatedObjects) {
+        previousInvalidatedObjects->insert(scope.invalidatedObjects->begin(), scope.invalidatedObjects->end());
+    }
+    scope.invalidatedObjects = previousInvalidatedObjects;
+}
+
+int
+HashableObject::getUnreportedInvalidationsCount()
+{
+    return unreportedInvalidationsCount.fetchAndAddRelaxed(0);
+}
+
+void
+HashableObject::notifyUnreportedInvalidation()
+{
+    unreportedInvalidationsCount.fetchAndAddRelaxed(1);
+}
+
+void
+HashableObject::setInvalidationIncomplete()
+{
+    QMutexLocker k(&_imp->hashCacheMutex);
+    _imp->invalidatedAtVersionValid = false;
+}
+
+void
+HashableObject::notifyCacheFilled()
+{
+    cacheVersion.fetchAndAddRelaxed(1);
 }
 
 void
@@ -158,12 +158,59 @@ public:
      * @brief Invalidate the hash cache and invalidate recursively the listeners as well.
      * This should be called after anything that the hash computation relies on has changed.
      * This internally calls invalidateHashCacheInternal.
+     * If nothing was cached by any object since this object was last invalidated, the objects
+     * reached by the invalidation are known to be already invalidated and they are not walked again.
      **/
     void invalidateHashCache();
 
+    /**
+     * @brief Must be called whenever something that is cleared by an implementation of invalidateHashCacheInternal()
+     * is cached outside of the hash cache, or if an implementation of invalidateHashCacheInternal() must be called
+     * again on the next invalidation even if nothing was cached.
+     * This is thread-safe.
+     **/
+    static void notifyCacheFilled();
+
+    /**
+     * @brief Opens a scope on this thread in which the objects reached by invalidateHashCache() are added to invalidatedObjects,
+     * so that the caller knows exactly what a change invalidated. The walk of the invalidations is never skipped in the scope.
+     * Invalidations out of such a scope are counted by getUnreportedInvalidationsCount().
+     * Returns the set of the scope that was opened on this thread, which must be passed back to endReportedInvalidations().
+     **/
+    static std::set<HashableObject*>* beginReportedInvalidations(std::set<HashableObject*>* invalidatedObjects);
+    static void endReportedInvalidations(std::set<HashableObject*>* previousInvalidatedObjects);
+
+    /**
+     * @brief Returns the number of invalidations that were not done in a scope opened with beginReportedInvalidations().
+     * If it did not change, every invalidation since was reported.
+     * This is thread-safe.
+     **/
+    static int getUnreportedInvalidationsCount();
+
+    /**
+     * @brief Increments the count returned by getUnreportedInvalidationsCount(), e.g. when a reported change could not be accounted for.
+     * This is thread-safe.
+     **/
+    static void notifyUnreportedInvalidation();
+
 
 protected:
 
+    /**
+     * @brief Must be called by implementations of invalidateHashCacheInternal() that did not invalidate
+     * all the objects depending on this object, so that its next invalidation is not skipped.
+     **/
+    void setInvalidationIncomplete();
+
+    /**
+     * @brief Can be implemented to return true if the eComputeHashTypeTimeViewVariant hash does not depend
+     * on the time for the given view. In that case it is computed once and cached for all frames.
+     **/
+    virtual bool isHashTimeInvariant(ViewIdx /*view*/) const
+    {
+        return false;
+    }
+
 
     /**
      * @brief Must be implemented by deriving classes to add to the hash.
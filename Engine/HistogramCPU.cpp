@@ -31,13 +31,21 @@
 #include <QtCore/QMutex>
 #include <QtCore/QWaitCondition>
 
+#ifdef __NATRON_SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "Engine/Image.h"
+#include "Engine/MultiThread.h"
 #include "Engine/Smooth1D.h"
 #include "Engine/Node.h"
 #include "Engine/TreeRender.h"
 #include "Engine/ViewerNode.h"
 #include "Engine/ViewerInstance.h"
 
+// The histograms are computed with this many more bins than requested, then smoothed and downsampled
+#define NATRON_HISTOGRAM_BINS_UPSCALE 5
+
 NATRON_NAMESPACE_ENTER;
 
 struct HistogramRequest
@@ -232,141 +240,262 @@ HistogramCPU::getMostRecentlyProducedHistogram(std::vector<float>* histogram1,
 }
 
 
+/**
+ * @brief Extracts the values displayed by the given mode of a scan-line of width pixels.
+ * The mode corresponds to the enum Histogram::DisplayModeEnum.
+ **/
 template <int srcNComps, int mode>
 void
-computeHisto_internal(const HistogramRequest & request,
-                      const Image::CPUData& imageData,
-                      const RectI& roi,
-                      int upscale,
-                      std::vector<float> *histo)
+getScanLineValues(const float* src_pixels[4],
+                  int pixelStride,
+                  int width,
+                  float* values)
 {
-    assert(histo);
-    histo->resize(request.binsCount * upscale);
-    std::fill(histo->begin(), histo->end(), 0.f);
-    double binSize = (request.vmax - request.vmin) / histo->size();
-
-    int pixelStride;
-    const float* src_pixels[4];
-    Image::getChannelPointers<float>((const float**)imageData.ptrs, roi.x1, roi.y1, imageData.bounds, imageData.nComps, (float**)src_pixels, &pixelStride);
-
-    for (int y = roi.y1; y < roi.y2; ++y) {
-
-        for (int x = roi.x1; x < roi.x2; ++x) {
-
-            float v;
-            switch (mode) {
-                case 1: // A
-                    if (srcNComps == 1) {
-                        v = *src_pixels[0];
-                    } else if (srcNComps < 4) {
-                        v = 1.;
-                    } else {
-                        v = *src_pixels[3];
-                    }
-                    break;
-                case 2: { // Y
-                    float tmpPix[3];
-                    for (int i = 0; i < 3; ++i) {
-                        if (src_pixels[i]) {
-                            tmpPix[i] = *src_pixels[i];
-                        } else {
-                            tmpPix[i] = 0;
-                        }
-                    }
-                    v = 0.299 * tmpPix[0] + 0.587 * tmpPix[1] + 0.114 * tmpPix[2];
-                }   break;
-                case 3: // R
-                    if (srcNComps == 1) {
-                        v = 0;
-                    } else {
-                        v = *src_pixels[0];
-                    }
-                    break;
-                case 4: // G
-                    if (srcNComps < 2) {
-                        v = 0;
-                    } else {
-                        v = *src_pixels[1];
-                    }
-                    break;
-                case 5: // B
-                    if (srcNComps < 3) {
-                        v = 0;
+    switch (mode) {
+        case 1: // A
+            if (srcNComps == 1) {
+                for (int x = 0; x < width; ++x) {
+                    values[x] = src_pixels[0][x * pixelStride];
+                }
+            } else if (srcNComps < 4) {
+                std::fill(values, values + width, 1.f);
+            } else {
+                for (int x = 0; x < width; ++x) {
+                    values[x] = src_pixels[3][x * pixelStride];
+                }
+            }
+            break;
+        case 2: { // Y
+            for (int x = 0; x < width; ++x) {
+                float tmpPix[3];
+                for (int i = 0; i < 3; ++i) {
+                    if (src_pixels[i]) {
+                        tmpPix[i] = src_pixels[i][x * pixelStride];
                     } else {
-                        v = *src_pixels[3];
+                        tmpPix[i] = 0;
                     }
-                    break;
-                default:
-                    assert(false);
-                    break;
-            } // switch (mode)
-
-            if ( (request.vmin <= v) && (v < request.vmax) ) {
-                int index = (int)( (v - request.vmin) / binSize );
-                assert( 0 <= index && index < (int)histo->size() );
-                (*histo)[index] += 1.f;
-            }
-
-            for (int c = 0; c < srcNComps; ++c) {
-                if (src_pixels[c]) {
-                    src_pixels[c] += pixelStride;
                 }
+                values[x] = 0.299 * tmpPix[0] + 0.587 * tmpPix[1] + 0.114 * tmpPix[2];
             }
-        } // for each pixel along the lin
-
-        // Remove what was done on the previous line and go to the next
-        for (int c = 0; c < srcNComps; ++c) {
-            if (src_pixels[c]) {
-                src_pixels[c] += ((imageData.bounds .width()- roi.width()) * pixelStride);
+        }   break;
+        case 3: // R
+        case 4: // G
+        case 5: { // B
+            const int channel = mode - 3;
+            if (srcNComps == 1 || srcNComps <= channel) {
+                std::fill(values, values + width, 0.f);
+            } else {
+                for (int x = 0; x < width; ++x) {
+                    values[x] = src_pixels[channel][x * pixelStride];
+                }
             }
-        }
-    } // for each scan-line
-}
+        }   break;
+        default:
+            assert(false);
+            break;
+    } // switch (mode)
+} // getScanLineValues
 
 template <int srcNComps>
 void
-computeHistoForNComps(const HistogramRequest & request,
-                      int mode,
-                      const Image::CPUData& imageData,
-                      const RectI& roi,
-                      int upscale,
-                      std::vector<float> *histo)
+getScanLineValuesForNComps(int mode,
+                           const float* src_pixels[4],
+                           int pixelStride,
+                           int width,
+                           float* values)
 {
-
     /// keep the mode parameter in sync with Histogram::DisplayModeEnum
     switch (mode) {
         case 1:     //< A
-            computeHisto_internal<srcNComps, 1>(request, imageData, roi, upscale, histo);
+            getScanLineValues<srcNComps, 1>(src_pixels, pixelStride, width, values);
             break;
         case 2:     //<Y
-            computeHisto_internal<srcNComps, 2>(request, imageData, roi, upscale, histo);
+            getScanLineValues<srcNComps, 2>(src_pixels, pixelStride, width, values);
             break;
         case 3:     //< R
-            computeHisto_internal<srcNComps, 3>(request, imageData, roi, upscale, histo);
+            getScanLineValues<srcNComps, 3>(src_pixels, pixelStride, width, values);
             break;
         case 4:     //< G
-            computeHisto_internal<srcNComps, 4>(request, imageData, roi, upscale, histo);
+            getScanLineValues<srcNComps, 4>(src_pixels, pixelStride, width, values);
             break;
         case 5:     //< B
-            computeHisto_internal<srcNComps, 5>(request, imageData, roi, upscale, histo);
+            getScanLineValues<srcNComps, 5>(src_pixels, pixelStride, width, values);
             break;
-            
+
         default:
             assert(false);
             break;
     }
 }
 
+/**
+ * @brief Adds the n values that are in [vmin, vmax[ to the bins
+ **/
+static void
+binScanLineValues(const float* values,
+                  int n,
+                  float vmin,
+                  float vmax,
+                  float binsPerUnit,
+                  unsigned int* bins,
+                  int nBins)
+{
+    int i = 0;
+#ifdef __NATRON_SSE2__
+    // The bin indices are computed 4 at a time, only the increments are scalar
+    const __m128 vminV = _mm_set1_ps(vmin);
+    const __m128 vmaxV = _mm_set1_ps(vmax);
+    const __m128 binsPerUnitV = _mm_set1_ps(binsPerUnit);
+    for (; i + 4 <= n; i += 4) {
+        const __m128 v = _mm_loadu_ps(values + i);
+        const int inRange = _mm_movemask_ps( _mm_and_ps( _mm_cmpge_ps(v, vminV), _mm_cmplt_ps(v, vmaxV) ) );
+        if (!inRange) {
+            continue;
+        }
+        int indices[4];
+        _mm_storeu_si128( (__m128i*)indices, _mm_cvttps_epi32( _mm_mul_ps(_mm_sub_ps(v, vminV), binsPerUnitV) ) );
+        for (int k = 0; k < 4; ++k) {
+            if ( inRange & (1 << k) ) {
+                // Rounding may give nBins for values right below vmax
+                ++bins[std::min(indices[k], nBins - 1)];
+            }
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        const float v = values[i];
+        if ( (vmin <= v) && (v < vmax) ) {
+            int index = std::min( (int)( (v - vmin) * binsPerUnit ), nBins - 1 );
+            assert(0 <= index);
+            ++bins[index];
+        }
+    }
+} // binScanLineValues
+
+/**
+ * @brief Computes the upscaled histograms of up to 3 display modes in a single pass over the image.
+ * Each thread bins its scan-lines in its own histograms which are then added to the result.
+ **/
+class HistogramProcessor : public ImageMultiThreadProcessorBase
+{
+    Image::CPUData _imageData;
+    int _modes[3];
+    int _nHistograms;
+    int _nBins;
+    float _vmin, _vmax;
+
+    QMutex _binsMutex;
+    std::vector<unsigned int> _bins[3];
+
+public:
+
+    HistogramProcessor()
+    : ImageMultiThreadProcessorBase(EffectInstancePtr())
+    , _imageData()
+    , _nHistograms(0)
+    , _nBins(0)
+    , _vmin(0)
+    , _vmax(0)
+    , _binsMutex()
+    {
+    }
+
+    virtual ~HistogramProcessor()
+    {
+    }
+
+    void setValues(const Image::CPUData& imageData,
+                   const int modes[3],
+                   int nHistograms,
+                   int nBins,
+                   double vmin,
+                   double vmax)
+    {
+        assert(nHistograms >= 1 && nHistograms <= 3);
+        _imageData = imageData;
+        _nHistograms = nHistograms;
+        _nBins = nBins;
+        _vmin = vmin;
+        _vmax = vmax;
+        for (int k = 0; k < _nHistograms; ++k) {
+            _modes[k] = modes[k];
+            _bins[k].assign(_nBins, 0);
+        }
+    }
+
+    void getHistogram(int index, std::vector<float>* histo) const
+    {
+        histo->resize(_bins[index].size());
+        for (std::size_t i = 0; i < _bins[index].size(); ++i) {
+            (*histo)[i] = (float)_bins[index][i];
+        }
+    }
+
+private:
+
+    virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
+    {
+        const int width = renderWindow.width();
+        if (width <= 0 || _nBins <= 0) {
+            return eActionStatusOK;
+        }
+        const float binsPerUnit = _nBins / (_vmax - _vmin);
+
+        std::vector<float> values(width);
+        std::vector<unsigned int> localBins[3];
+        for (int k = 0; k < _nHistograms; ++k) {
+            localBins[k].assign(_nBins, 0);
+        }
+
+        for (int y = renderWindow.y1; y < renderWindow.y2; ++y) {
+
+            int pixelStride;
+            const float* src_pixels[4];
+            Image::getChannelPointers<float>((const float**)_imageData.ptrs, renderWindow.x1, y, _imageData.bounds, _imageData.nComps, (float**)src_pixels, &pixelStride);
+
+            for (int k = 0; k < _nHistograms; ++k) {
+                switch (_imageData.nComps) {
+                    case 1:
+                        getScanLineValuesForNComps<1>(_modes[k], src_pixels, pixelStride, width, &values[0]);
+                        break;
+                    case 2:
+                        getScanLineValuesForNComps<2>(_modes[k], src_pixels, pixelStride, width, &values[0]);
+                        break;
+                    case 3:
+                        getScanLineValuesForNComps<3>(_modes[k], src_pixels, pixelStride, width, &values[0]);
+                        break;
+                    case 4:
+                        getScanLineValuesForNComps<4>(_modes[k], src_pixels, pixelStride, width, &values[0]);
+                        break;
+                    default:
+                        return eActionStatusFailed;
+                }
+                binScanLineValues(&values[0], width, _vmin, _vmax, binsPerUnit, &localBins[k][0], _nBins);
+            }
+        } // for each scan-line
+
+        QMutexLocker k(&_binsMutex);
+        for (int h = 0; h < _nHistograms; ++h) {
+            for (int i = 0; i < _nBins; ++i) {
+                _bins[h][i] += localBins[h][i];
+            }
+        }
+        return eActionStatusOK;
+    } // multiThreadProcessImages
+};
 
+/**
+ * @brief Smoothes the upscaled histogram and downsamples it to the requested bins count in the given
+ * histogram of ret.
+ **/
 static void
 computeHistogramStatic(const HistogramRequest & request,
-                       int mode,
-                       const Image::CPUData& imageData,
+                       std::vector<float>& histo_upscaled,
                        const RectI& roi,
                        FinishedHistogramPtr ret,
                        int histogramIndex)
 {
-    const int upscale = 5;
+    const int upscale = NATRON_HISTOGRAM_BINS_UPSCALE;
     std::vector<float> *histo = 0;
 
     switch (histogramIndex) {
@@ -387,25 +516,6 @@ computeHistogramStatic(const HistogramRequest & request,
         return;
     }
 
-    // a histogram with upscale more bins
-    std::vector<float> histo_upscaled;
-
-    switch (imageData.nComps) {
-        case 1:
-            computeHistoForNComps<1>(request, mode, imageData, roi, upscale, &histo_upscaled);
-            break;
-        case 2:
-            computeHistoForNComps<2>(request, mode, imageData, roi, upscale, &histo_upscaled);
-            break;
-        case 3:
-            computeHistoForNComps<3>(request, mode, imageData, roi, upscale, &histo_upscaled);
-            break;
-        case 4:
-            computeHistoForNComps<4>(request, mode, imageData, roi, upscale, &histo_upscaled);
-            break;
-    }
-
-
     ret->pixelsCount = roi.area();
 
 
@@ -537,23 +647,44 @@ HistogramCPU::run()
             roiPixels.intersect(imageData.bounds, &roiPixels);
         }
 
+        int modes[3];
+        int nHistograms = 0;
         switch (request.mode) {
         case 0:     //< RGB
-            computeHistogramStatic(request, 3, imageData, roiPixels, ret, 1);
-            computeHistogramStatic(request, 4, imageData, roiPixels, ret, 2);
-            computeHistogramStatic(request, 5, imageData, roiPixels, ret, 3);
+            modes[0] = 3;
+            modes[1] = 4;
+            modes[2] = 5;
+            nHistograms = 3;
             break;
         case 1:
         case 2:
         case 3:
         case 4:
         case 5:
-            computeHistogramStatic(request, request.mode, imageData, roiPixels, ret, 1);
+            modes[0] = request.mode;
+            nHistograms = 1;
             break;
         default:
             assert(false);     //< unknown case.
             break;
         }
+        if (nHistograms == 0) {
+            continue;
+        }
+
+        // All histograms are computed in a single multi-threaded pass over the image
+        HistogramProcessor processor;
+        processor.setValues(imageData, modes, nHistograms, request.binsCount * NATRON_HISTOGRAM_BINS_UPSCALE, request.vmin, request.vmax);
+        processor.setRenderWindow(roiPixels);
+        if ( isFailureRetCode( processor.process() ) ) {
+            continue;
+        }
+        for (int k = 0; k < nHistograms; ++k) {
+            // a histogram with upscale more bins
+            std::vector<float> histo_upscaled;
+            processor.getHistogram(k, &histo_upscaled);
+            computeHistogramStatic(request, histo_upscaled, roiPixels, ret, k + 1);
+        }
 
 
         {
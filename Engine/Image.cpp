@@ -42,6 +42,10 @@
 // When defined, tiles will be fetched from the cache (and optionnally downscaled) sequentially
 //#define NATRON_IMAGE_SEQUENTIAL_INIT
 
+// When copying unprocessed channels and applying mask/mix in a single pass, each thread processes its render window
+// by bands of this amount of pixels so that a band is still in the cache when the second operation reads it
+#define NATRON_IMAGE_POST_PROCESS_BAND_PIXELS 8192
+
 NATRON_NAMESPACE_ENTER;
 
 Image::Image()
@@ -93,6 +97,7 @@ Image::InitStorageArgs::InitStorageArgs()
 , mipMapLevel(0)
 , isDraft(false)
 , nodeTimeViewVariantHash(0)
+, previousTimeViewVariantHashes()
 , glContext()
 , textureTarget(GL_TEXTURE_2D)
 , externalBuffer()
@@ -162,6 +167,17 @@ ImagePrivate::init(const Image::InitStorageArgs& args)
         return eActionStatusFailed;
     }
 
+    // Tiles have the same size as the cache tiles so that they may be copied with a single memcpy
+    if (bufferFormat == eImageBufferLayoutMonoChannelTiled) {
+        if (args.storage != eStorageModeRAM) {
+            return eActionStatusFailed;
+        }
+        appPTR->getTileCache()->getTileSizePx(bitdepth, &tileSizeX, &tileSizeY);
+        if (tileSizeX <= 0 || tileSizeY <= 0) {
+            return eActionStatusFailed;
+        }
+    }
+
 
     // If allocating OpenGL textures, ensure the context is current
     OSGLContextAttacherPtr contextLocker;
@@ -210,6 +226,11 @@ static bool isCopyPixelsNeeded(ImagePrivate* thisImage, ImagePrivate* otherImage
     if (thisImage->bufferFormat != otherImage->bufferFormat && thisImage->plane.getNumComponents() != 1) {
         return true;
     }
+    // Tiled buffers do not have the layout of a full rect buffer, even with 1 component
+    if (thisImage->bufferFormat != otherImage->bufferFormat &&
+        (thisImage->bufferFormat == eImageBufferLayoutMonoChannelTiled || otherImage->bufferFormat == eImageBufferLayoutMonoChannelTiled)) {
+        return true;
+    }
 
     return false;
 }
@@ -281,14 +302,41 @@ Image::copyPixels(const Image& other, const CopyPixelsArgs& args)
 
 } // copyPixels
 
-void
+ImagePtr
+Image::createSharedBufferImage(const ImagePlaneDesc& plane) const
+{
+    if (_imp->storage != eStorageModeRAM || _imp->bufferFormat != eImageBufferLayoutRGBAPackedFullRect) {
+        return ImagePtr();
+    }
+    if ((int)plane.getNumComponents() != _imp->plane.getNumComponents()) {
+        return ImagePtr();
+    }
+    if (!_imp->channels[0]) {
+        return ImagePtr();
+    }
+
+    InitStorageArgs initArgs;
+    initArgs.bounds = _imp->originalBounds;
+    initArgs.plane = plane;
+    initArgs.bitdepth = _imp->bitdepth;
+    initArgs.bufferFormat = _imp->bufferFormat;
+    initArgs.storage = _imp->storage;
+    initArgs.proxyScale = _imp->proxyScale;
+    initArgs.mipMapLevel = _imp->mipMapLevel;
+    initArgs.renderClone = _imp->renderClone.lock();
+    initArgs.externalBuffer = _imp->channels[0];
+    return Image::create(initArgs);
+} // createSharedBufferImage
+
+std::size_t
 Image::ensureBuffersAllocated()
 {
     QMutexLocker k(&_imp->tilesAllocatedMutex);
     if (_imp->tilesAllocated) {
-        return;
+        return 0;
     }
 
+    std::size_t bytesAllocated = 0;
     for (int i = 0; i < 4; ++i) {
         if (!_imp->channels[i]) {
             continue;
@@ -300,10 +348,13 @@ Image::ensureBuffersAllocated()
         if (_imp->channels[i]->hasAllocateMemoryArgs()) {
             // Allocate the buffer
             _imp->channels[i]->allocateMemoryFromSetArgs();
+            bytesAllocated += _imp->channels[i]->getBufferSize();
         }
     }
 
     _imp->tilesAllocated = true;
+
+    return bytesAllocated;
 } // ensureBuffersAllocated
 
 ImageBufferLayoutEnum
@@ -382,9 +433,71 @@ void
 Image::getCPUData(CPUData* data) const
 {
     ImagePrivate* imp = _imp.get();
-    ImagePrivate::getCPUDataInternal(imp->originalBounds, imp->plane.getNumComponents(), imp->channels, imp->bitdepth, imp->bufferFormat, data);
+    ImagePrivate::getCPUDataInternal(imp->originalBounds, imp->plane.getNumComponents(), imp->channels, imp->bitdepth, imp->bufferFormat, imp->tileSizeX, imp->tileSizeY, data);
 }
 
+void
+Image::getCPUTileData(const CPUData& data, const RectI& rect, CPUData* tileData)
+{
+    *tileData = data;
+    if ( !data.isTiled() ) {
+        return;
+    }
+
+    RectI allTilesBounds = data.bounds;
+    allTilesBounds.roundToTileSize(data.tileSizeX, data.tileSizeY);
+
+    RectI tileBounds = rect;
+    tileBounds.roundToTileSize(data.tileSizeX, data.tileSizeY);
+    assert(tileBounds.width() == data.tileSizeX && tileBounds.height() == data.tileSizeY);
+    tileData->bounds = tileBounds;
+    tileData->tileSizeX = 0;
+    tileData->tileSizeY = 0;
+    if ( !allTilesBounds.contains(tileBounds) ) {
+        // Outside of the image: there are no pixels
+        memset(tileData->ptrs, 0, sizeof(void*) * 4);
+        return;
+    }
+
+    // Tiles are stored one after another, row by row
+    const int nTilesPerRow = allTilesBounds.width() / data.tileSizeX;
+    const std::size_t tileIndex = (std::size_t)( (tileBounds.y1 - allTilesBounds.y1) / data.tileSizeY ) * nTilesPerRow + (tileBounds.x1 - allTilesBounds.x1) / data.tileSizeX;
+    const std::size_t tileSizeBytes = (std::size_t)data.tileSizeX * data.tileSizeY * getSizeOfForBitDepth(data.bitDepth);
+
+    for (int i = 0; i < data.nComps; ++i) {
+        if (data.ptrs[i]) {
+            tileData->ptrs[i] = (char*)data.ptrs[i] + tileIndex * tileSizeBytes;
+        }
+    }
+} // getCPUTileData
+
+ImageConstPtr
+Image::getFullRectImage() const
+{
+    if (_imp->bufferFormat != eImageBufferLayoutMonoChannelTiled) {
+        return shared_from_this();
+    }
+    InitStorageArgs initArgs;
+    initArgs.bounds = _imp->originalBounds;
+    initArgs.plane = _imp->plane;
+    initArgs.bitdepth = _imp->bitdepth;
+    initArgs.mipMapLevel = _imp->mipMapLevel;
+    initArgs.proxyScale = _imp->proxyScale;
+    initArgs.renderClone = _imp->renderClone.lock();
+    ImagePtr fullRectImage = Image::create(initArgs);
+    if (!fullRectImage) {
+        return fullRectImage;
+    }
+    CopyPixelsArgs cpyArgs;
+    cpyArgs.roi = _imp->originalBounds;
+    ActionRetCodeEnum stat = fullRectImage->copyPixels(*this, cpyArgs);
+    if ( isFailureRetCode(stat) ) {
+        return ImageConstPtr();
+    }
+
+    return fullRectImage;
+} // getFullRectImage
+
 
 
 CacheAccessModeEnum
@@ -401,10 +514,7 @@ Image::getCacheEntry() const
 
 class FillProcessor : public ImageMultiThreadProcessorBase
 {
-    void* _ptrs[4];
-    RectI _bounds;
-    ImageBitDepthEnum _bitDepth;
-    int _nComps;
+    Image::CPUData _data;
     RGBAColourF _color;
 
 public:
@@ -419,20 +529,20 @@ public:
     {
     }
 
-    void setValues(void* ptrs[4], const RectI& bounds, ImageBitDepthEnum bitDepth, int nComps, const RGBAColourF& color)
+    void setValues(const Image::CPUData& data, const RGBAColourF& color)
     {
-        memcpy(_ptrs, ptrs, sizeof(void*) * 4);
-        _bounds = bounds;
-        _bitDepth = bitDepth;
-        _nComps = nComps;
+        _data = data;
         _color = color;
+        alignRenderWindowToTiles(data.tileSizeX, data.tileSizeY);
     }
 
 private:
 
     virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
     {
-        ImagePrivate::fillCPU(_ptrs, _color.r, _color.g, _color.b, _color.a, _nComps, _bitDepth, _bounds, renderWindow, _effect);
+        Image::CPUData data;
+        Image::getCPUTileData(_data, renderWindow, &data);
+        ImagePrivate::fillCPU(data.ptrs, _color.r, _color.g, _color.b, _color.a, data.nComps, data.bitDepth, data.bounds, renderWindow, _effect);
         return eActionStatusOK;
     }
 };
@@ -461,7 +571,7 @@ Image::fill(const RectI & roi,
     RGBAColourF color = {r, g, b, a};
 
     FillProcessor processor(_imp->renderClone.lock());
-    processor.setValues(data.ptrs, data.bounds, data.bitDepth, data.nComps, color);
+    processor.setValues(data, color);
     processor.setRenderWindow(clippedRoi);
     return processor.process();
 
@@ -492,6 +602,14 @@ Image::ensureBounds(const RectI& roi)
     RectI newBounds = oldBounds;
     newBounds.merge(roi);
 
+    // When the RoI of a request grows before the image was rendered, the buffers were not allocated yet:
+    // there is nothing to copy, keep delaying the allocation to the render of the new bounds.
+    bool tilesAllocated;
+    {
+        QMutexLocker k(&_imp->tilesAllocatedMutex);
+        tilesAllocated = _imp->tilesAllocated;
+    }
+
     ImagePtr tmpImage;
     {
         Image::InitStorageArgs initArgs;
@@ -507,14 +625,17 @@ Image::ensureBounds(const RectI& roi)
             initArgs.textureTarget = isGlEntry->getGLTextureTarget();
             initArgs.glContext = isGlEntry->getOpenGLContext();
         }
+        initArgs.delayAllocation = !tilesAllocated;
         tmpImage = Image::create(initArgs);
         if (!tmpImage) {
             return eActionStatusFailed;
         }
     }
-    Image::CopyPixelsArgs cpyArgs;
-    cpyArgs.roi = oldBounds;
-    tmpImage->copyPixels(*this, cpyArgs);
+    if (tilesAllocated) {
+        Image::CopyPixelsArgs cpyArgs;
+        cpyArgs.roi = oldBounds;
+        tmpImage->copyPixels(*this, cpyArgs);
+    }
 
     // Swap images so that this image becomes the resized one, but keep the internal cache entry object
     ImageCacheEntryPtr internalCacheEntry = _imp->cacheEntry;
@@ -666,6 +787,36 @@ Image::isBitDepthConversionLossy(ImageBitDepthEnum from,
 }
 
 
+class HalveImageProcessor : public ImageMultiThreadProcessorBase
+{
+    Image::CPUData _srcImgData, _dstImgData;
+public:
+
+    HalveImageProcessor(const EffectInstancePtr& renderClone)
+    : ImageMultiThreadProcessorBase(renderClone)
+    {
+
+    }
+
+    virtual ~HalveImageProcessor()
+    {
+    }
+
+    void setValues(const Image::CPUData& srcImgData,
+                   const Image::CPUData& dstImgData)
+    {
+        _srcImgData = srcImgData;
+        _dstImgData = dstImgData;
+    }
+
+private:
+
+    virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
+    {
+        return ImagePrivate::halveImage((const void**)_srcImgData.ptrs, _srcImgData.nComps, _srcImgData.bitDepth, _srcImgData.bounds, _dstImgData.ptrs, _dstImgData.bounds, renderWindow, _effect);
+    }
+};
+
 ImagePtr
 Image::downscaleMipMap(const RectI & roi, unsigned int downscaleLevels) const
 {
@@ -684,7 +835,12 @@ Image::downscaleMipMap(const RectI & roi, unsigned int downscaleLevels) const
     ImagePtr mipmapImage;
 
     RectI previousLevelRoI = roi;
-    ImageConstPtr previousLevelImage = shared_from_this();
+
+    // Each destination pixel is the average of 4 source pixels which may be in different tiles
+    ImageConstPtr previousLevelImage = getFullRectImage();
+    if (!previousLevelImage) {
+        return ImagePtr();
+    }
 
     // Build all the mipmap levels until we reach the one we are interested in
     for (unsigned int i = 0; i < downscaleLevels; ++i) {
@@ -713,7 +869,11 @@ Image::downscaleMipMap(const RectI & roi, unsigned int downscaleLevels) const
         Image::CPUData dstTileData;
         mipmapImage->getCPUData(&dstTileData);
 
-        ActionRetCodeEnum stat = ImagePrivate::halveImage((const void**)srcTileData.ptrs, srcTileData.nComps, srcTileData.bitDepth, srcTileData.bounds, dstTileData.ptrs, dstTileData.bounds, _imp->renderClone.lock());
+        // Each thread halves full rows of the destination image
+        HalveImageProcessor processor(_imp->renderClone.lock());
+        processor.setValues(srcTileData, dstTileData);
+        processor.setRenderWindow(dstTileData.bounds);
+        ActionRetCodeEnum stat = processor.process();
         if (isFailureRetCode(stat)) {
             return ImagePtr();
         }
@@ -726,28 +886,237 @@ Image::downscaleMipMap(const RectI & roi, unsigned int downscaleLevels) const
 
 } // downscaleMipMap
 
-bool
+class CheckForNaNsProcessor : public ImageMultiThreadProcessorBase
+{
+    Image::CPUData _dstImgData;
+    QMutex _nNaNsMutex;
+    std::size_t _nNaNs;
+public:
+
+    CheckForNaNsProcessor(const EffectInstancePtr& renderClone)
+    : ImageMultiThreadProcessorBase(renderClone)
+    , _dstImgData()
+    , _nNaNsMutex()
+    , _nNaNs(0)
+    {
+
+    }
+
+    virtual ~CheckForNaNsProcessor()
+    {
+    }
+
+    void setValues(const Image::CPUData& dstImgData)
+    {
+        _dstImgData = dstImgData;
+        alignRenderWindowToTiles(dstImgData.tileSizeX, dstImgData.tileSizeY);
+    }
+
+    std::size_t getNumNaNs() const
+    {
+        return _nNaNs;
+    }
+
+private:
+
+    virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
+    {
+        Image::CPUData dstImgData;
+        Image::getCPUTileData(_dstImgData, renderWindow, &dstImgData);
+        std::size_t nNaNs = ImagePrivate::checkForNaNs(dstImgData.ptrs, dstImgData.nComps, dstImgData.bitDepth, dstImgData.bounds, renderWindow);
+        if (nNaNs > 0) {
+            QMutexLocker k(&_nNaNsMutex);
+            _nNaNs += nNaNs;
+        }
+        return eActionStatusOK;
+    }
+};
+
+std::size_t
 Image::checkForNaNs(const RectI& roi)
 {
     if (getBitDepth() != eImageBitDepthFloat) {
-        return false;
+        return 0;
     }
     if (getStorageMode() == eStorageModeGLTex) {
-        return false;
+        return 0;
     }
 
-    bool hasNan = false;
     Image::CPUData data;
     getCPUData(&data);
 
     RectI clippedRoi;
     roi.intersect(data.bounds, &clippedRoi);
-    hasNan |= _imp->checkForNaNs(data.ptrs, data.nComps, data.bitDepth, data.bounds, clippedRoi);
 
-    return hasNan;
+    CheckForNaNsProcessor processor(_imp->renderClone.lock());
+    processor.setValues(data);
+    processor.setRenderWindow(clippedRoi);
+    processor.process();
+    return processor.getNumNaNs();
 
 } // checkForNaNs
 
+class ColorMatrixProcessor : public ImageMultiThreadProcessorBase
+{
+    Image::CPUData _dstImgData;
+    const double* _matrix;
+public:
+
+    ColorMatrixProcessor(const EffectInstancePtr& renderClone)
+    : ImageMultiThreadProcessorBase(renderClone)
+    , _dstImgData()
+    , _matrix(0)
+    {
+
+    }
+
+    virtual ~ColorMatrixProcessor()
+    {
+    }
+
+    void setValues(const Image::CPUData& dstImgData, const double matrix[12])
+    {
+        _dstImgData = dstImgData;
+        _matrix = matrix;
+        alignRenderWindowToTiles(dstImgData.tileSizeX, dstImgData.tileSizeY);
+    }
+
+private:
+
+    virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
+    {
+        Image::CPUData dstImgData;
+        Image::getCPUTileData(_dstImgData, renderWindow, &dstImgData);
+        ImagePrivate::applyColorMatrix(dstImgData.ptrs, dstImgData.nComps, dstImgData.bitDepth, dstImgData.bounds, renderWindow, _matrix);
+        return eActionStatusOK;
+    }
+};
+
+ActionRetCodeEnum
+Image::applyColorMatrix(const RectI& roi, const double matrix[12])
+{
+    if (getStorageMode() == eStorageModeGLTex) {
+        return eActionStatusFailed;
+    }
+
+    Image::CPUData data;
+    getCPUData(&data);
+    if (data.nComps < 3) {
+        return eActionStatusOK;
+    }
+
+    RectI clippedRoi;
+    if ( !roi.intersect(data.bounds, &clippedRoi) ) {
+        return eActionStatusOK;
+    }
+
+    ColorMatrixProcessor processor(_imp->renderClone.lock());
+    processor.setValues(data, matrix);
+    processor.setRenderWindow(clippedRoi);
+    return processor.process();
+
+} // applyColorMatrix
+
+class ResampleProcessor : public ImageMultiThreadProcessorBase
+{
+    Image::CPUData _srcImgData, _dstImgData;
+    const Transform::Matrix3x3* _dstToSrc;
+    Image::ResampleFilterEnum _filter;
+    bool _clamp;
+public:
+
+    ResampleProcessor(const EffectInstancePtr& renderClone)
+    : ImageMultiThreadProcessorBase(renderClone)
+    , _srcImgData()
+    , _dstImgData()
+    , _dstToSrc(0)
+    , _filter(Image::eResampleFilterImpulse)
+    , _clamp(false)
+    {
+
+    }
+
+    virtual ~ResampleProcessor()
+    {
+    }
+
+    void setValues(const Image::CPUData& srcImgData,
+                   const Image::CPUData& dstImgData,
+                   const Transform::Matrix3x3& dstToSrc,
+                   Image::ResampleFilterEnum filter,
+                   bool clamp)
+    {
+        _srcImgData = srcImgData;
+        _dstImgData = dstImgData;
+        _dstToSrc = &dstToSrc;
+        _filter = filter;
+        _clamp = clamp;
+        assert( !srcImgData.isTiled() );
+        alignRenderWindowToTiles(dstImgData.tileSizeX, dstImgData.tileSizeY);
+    }
+
+private:
+
+    virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
+    {
+        Image::CPUData dstImgData;
+        Image::getCPUTileData(_dstImgData, renderWindow, &dstImgData);
+        return ImagePrivate::resampleCPU(_srcImgData, dstImgData, renderWindow, *_dstToSrc, _filter, _clamp, _effect);
+    }
+};
+
+ActionRetCodeEnum
+Image::resample(const Image& srcImage,
+                const Transform::Matrix3x3& dstToSrc,
+                ResampleFilterEnum filter,
+                bool clamp,
+                const RectI& roi)
+{
+    if ( (getStorageMode() == eStorageModeGLTex) || (srcImage.getStorageMode() == eStorageModeGLTex) ) {
+        return eActionStatusFailed;
+    }
+
+    // The filter reads pixels around each destination pixel, which may be in other tiles of the source
+    ImageConstPtr fullRectSrcImage = srcImage.getFullRectImage();
+    if (!fullRectSrcImage) {
+        return eActionStatusFailed;
+    }
+
+    Image::CPUData srcData;
+    fullRectSrcImage->getCPUData(&srcData);
+    Image::CPUData dstData;
+    getCPUData(&dstData);
+    if ( (srcData.bitDepth != dstData.bitDepth) || (srcData.nComps != dstData.nComps) ) {
+        return eActionStatusFailed;
+    }
+
+    RectI clippedRoi;
+    if ( !roi.intersect(dstData.bounds, &clippedRoi) ) {
+        return eActionStatusOK;
+    }
+
+    ResampleProcessor processor(_imp->renderClone.lock());
+    processor.setValues(srcData, dstData, dstToSrc, filter, clamp);
+    processor.setRenderWindow(clippedRoi);
+    return processor.process();
+
+} // resample
+
+
+/**
+ * @brief Returns the image to read for a source image read at the same pixels as the destination in the given roi.
+ * The tiles on the border of a tiled image extend beyond its bounds: if the roi is not contained in the bounds,
+ * a full rect copy of the image is read instead so that the pixels outside of the bounds are not read from the tiles.
+ **/
+static ImageConstPtr
+getSourceImageForRoI(const ImagePtr& image, const RectI& roi)
+{
+    if ( !image || (image->getBufferFormat() != eImageBufferLayoutMonoChannelTiled) || image->getBounds().contains(roi) ) {
+        return image;
+    }
+
+    return image->getFullRectImage();
+}
 
 class MaskMixProcessor : public ImageMultiThreadProcessorBase
 {
@@ -782,13 +1151,20 @@ public:
         _dstTileData = dstTileData;
         _mix = mix;
         _maskInvert = maskInvert;
+        alignRenderWindowToTiles(srcTileData.tileSizeX, srcTileData.tileSizeY);
+        alignRenderWindowToTiles(maskTileData.tileSizeX, maskTileData.tileSizeY);
+        alignRenderWindowToTiles(dstTileData.tileSizeX, dstTileData.tileSizeY);
     }
 
 private:
 
     virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
     {
-        ImagePrivate::applyMaskMixCPU((const void**)_srcTileData.ptrs, _srcTileData.bounds, _srcTileData.nComps, (const void**)_maskTileData.ptrs, _maskTileData.bounds, _dstTileData.ptrs, _dstTileData.bitDepth, _dstTileData.nComps, _mix, _maskInvert, _dstTileData.bounds, renderWindow, _effect);
+        Image::CPUData srcTileData, maskTileData, dstTileData;
+        Image::getCPUTileData(_srcTileData, renderWindow, &srcTileData);
+        Image::getCPUTileData(_maskTileData, renderWindow, &maskTileData);
+        Image::getCPUTileData(_dstTileData, renderWindow, &dstTileData);
+        ImagePrivate::applyMaskMixCPU((const void**)srcTileData.ptrs, srcTileData.bounds, srcTileData.nComps, (const void**)maskTileData.ptrs, maskTileData.bounds, dstTileData.ptrs, dstTileData.bitDepth, dstTileData.nComps, _mix, _maskInvert, dstTileData.bounds, renderWindow, _effect);
         if (_effect && _effect->isRenderAborted()) {
             return eActionStatusAborted;
         }
@@ -833,13 +1209,19 @@ Image::applyMaskMix(const RectI& roi,
     assert(!originalImg || (originalImg->getBitDepth() == getBitDepth()));
     assert(!maskImg || (maskImg->getBitDepth() == getBitDepth()));
 
+    ImageConstPtr srcImage = getSourceImageForRoI(originalImg, roi);
+    ImageConstPtr maskImage = getSourceImageForRoI(maskImg, roi);
+    if ( (originalImg && !srcImage) || (maskImg && !maskImage) ) {
+        return eActionStatusFailed;
+    }
+
     Image::CPUData srcImgData, maskImgData;
-    if (originalImg) {
-        originalImg->getCPUData(&srcImgData);
+    if (srcImage) {
+        srcImage->getCPUData(&srcImgData);
     }
 
-    if (maskImg) {
-        maskImg->getCPUData(&maskImgData);
+    if (maskImage) {
+        maskImage->getCPUData(&maskImgData);
         assert(maskImgData.nComps == 1);
     }
 
@@ -901,13 +1283,18 @@ public:
         _srcImgData = srcImgData;
         _dstImgData = dstImgData;
         _processChannels = processChannels;
+        alignRenderWindowToTiles(srcImgData.tileSizeX, srcImgData.tileSizeY);
+        alignRenderWindowToTiles(dstImgData.tileSizeX, dstImgData.tileSizeY);
     }
 
 private:
 
     virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
     {
-        return ImagePrivate::copyUnprocessedChannelsCPU((const void**)_srcImgData.ptrs, _srcImgData.bounds, _srcImgData.nComps, (void**)_dstImgData.ptrs, _dstImgData.bitDepth, _dstImgData.nComps, _dstImgData.bounds, _processChannels, renderWindow, _effect);
+        Image::CPUData srcImgData, dstImgData;
+        Image::getCPUTileData(_srcImgData, renderWindow, &srcImgData);
+        Image::getCPUTileData(_dstImgData, renderWindow, &dstImgData);
+        return ImagePrivate::copyUnprocessedChannelsCPU((const void**)srcImgData.ptrs, srcImgData.bounds, srcImgData.nComps, (void**)dstImgData.ptrs, dstImgData.bitDepth, dstImgData.nComps, dstImgData.bounds, _processChannels, renderWindow, _effect);
     }
 };
 
@@ -941,9 +1328,14 @@ Image::copyUnProcessedChannels(const RectI& roi,
     // This function only works if original  image has the same bitdepth as output
     assert(!originalImg || (originalImg->getBitDepth() == getBitDepth()));
 
+    ImageConstPtr srcImage = getSourceImageForRoI(originalImg, roi);
+    if (originalImg && !srcImage) {
+        return eActionStatusFailed;
+    }
+
     Image::CPUData srcImgData;
-    if (originalImg) {
-        originalImg->getCPUData(&srcImgData);
+    if (srcImage) {
+        srcImage->getCPUData(&srcImgData);
     }
 
 
@@ -960,4 +1352,183 @@ Image::copyUnProcessedChannels(const RectI& roi,
 
 } // copyUnProcessedChannels
 
+
+class MaskMixCopyUnProcessedProcessor : public ImageMultiThreadProcessorBase
+{
+    Image::CPUData _srcImgData, _maskImgData, _dstImgData;
+    std::bitset<4> _processChannels;
+    double _mix;
+    bool _maskInvert;
+    bool _replaceNaNs;
+    QMutex _nNaNsMutex;
+    std::size_t _nNaNs;
+public:
+
+    MaskMixCopyUnProcessedProcessor(const EffectInstancePtr& renderClone)
+    : ImageMultiThreadProcessorBase(renderClone)
+    , _srcImgData()
+    , _maskImgData()
+    , _dstImgData()
+    , _processChannels()
+    , _mix(0)
+    , _maskInvert(false)
+    , _replaceNaNs(false)
+    , _nNaNsMutex()
+    , _nNaNs(0)
+    {
+
+    }
+
+    virtual ~MaskMixCopyUnProcessedProcessor()
+    {
+    }
+
+    void setValues(const Image::CPUData& srcImgData,
+                   const Image::CPUData& maskImgData,
+                   const Image::CPUData& dstImgData,
+                   std::bitset<4> processChannels,
+                   double mix,
+                   bool maskInvert,
+                   bool replaceNaNs)
+    {
+        _srcImgData = srcImgData;
+        _maskImgData = maskImgData;
+        _dstImgData = dstImgData;
+        _processChannels = processChannels;
+        _mix = mix;
+        _maskInvert = maskInvert;
+        _replaceNaNs = replaceNaNs;
+        alignRenderWindowToTiles(srcImgData.tileSizeX, srcImgData.tileSizeY);
+        alignRenderWindowToTiles(maskImgData.tileSizeX, maskImgData.tileSizeY);
+        alignRenderWindowToTiles(dstImgData.tileSizeX, dstImgData.tileSizeY);
+    }
+
+    std::size_t getNumNaNs() const
+    {
+        return _nNaNs;
+    }
+
+private:
+
+    virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
+    {
+        // All operations are per-pixel: applying them band after band gives the same result
+        // as applying them one after the other on the whole window
+        Image::CPUData srcImgData, maskImgData, dstImgData;
+        Image::getCPUTileData(_srcImgData, renderWindow, &srcImgData);
+        Image::getCPUTileData(_maskImgData, renderWindow, &maskImgData);
+        Image::getCPUTileData(_dstImgData, renderWindow, &dstImgData);
+
+        int rowsPerBand = std::max(1, NATRON_IMAGE_POST_PROCESS_BAND_PIXELS / std::max(1, renderWindow.width()));
+        RectI band = renderWindow;
+        std::size_t nNaNs = 0;
+        for (int y = renderWindow.y1; y < renderWindow.y2; y += rowsPerBand) {
+            band.y1 = y;
+            band.y2 = std::min(y + rowsPerBand, renderWindow.y2);
+            if (_replaceNaNs) {
+                nNaNs += ImagePrivate::checkForNaNs(dstImgData.ptrs, dstImgData.nComps, dstImgData.bitDepth, dstImgData.bounds, band);
+            }
+            ActionRetCodeEnum stat = ImagePrivate::copyUnprocessedChannelsCPU((const void**)srcImgData.ptrs, srcImgData.bounds, srcImgData.nComps, (void**)dstImgData.ptrs, dstImgData.bitDepth, dstImgData.nComps, dstImgData.bounds, _processChannels, band, _effect);
+            if (isFailureRetCode(stat)) {
+                return stat;
+            }
+            ImagePrivate::applyMaskMixCPU((const void**)srcImgData.ptrs, srcImgData.bounds, srcImgData.nComps, (const void**)maskImgData.ptrs, maskImgData.bounds, dstImgData.ptrs, dstImgData.bitDepth, dstImgData.nComps, _mix, _maskInvert, dstImgData.bounds, band, _effect);
+            if (_effect && _effect->isRenderAborted()) {
+                return eActionStatusAborted;
+            }
+        }
+        if (nNaNs > 0) {
+            QMutexLocker k(&_nNaNsMutex);
+            _nNaNs += nNaNs;
+        }
+        return eActionStatusOK;
+    }
+};
+
+ActionRetCodeEnum
+Image::applyMaskMixAndCopyUnProcessedChannels(const RectI& roi,
+                                              const std::bitset<4> processChannels,
+                                              const ImagePtr& maskImg,
+                                              const ImagePtr& originalImg,
+                                              bool masked,
+                                              bool maskInvert,
+                                              float mix,
+                                              std::size_t* nNaNsReplaced)
+{
+    // If only one of the two operations does something, there is nothing to fuse
+    if ( !canCallCopyUnProcessedChannels(processChannels) || (!masked && (mix == 1)) ) {
+        if (nNaNsReplaced) {
+            *nNaNsReplaced = checkForNaNs(roi);
+        }
+        if (!canCallCopyUnProcessedChannels(processChannels)) {
+            return applyMaskMix(roi, maskImg, originalImg, masked, maskInvert, mix);
+        }
+        return copyUnProcessedChannels(roi, processChannels, originalImg);
+    }
+
+    if (nNaNsReplaced) {
+        *nNaNsReplaced = 0;
+    }
+
+    // Mask must be alpha
+    assert( !masked || !maskImg || maskImg->getLayer().getNumComponents() == 1 );
+
+    if (getStorageMode() == eStorageModeGLTex) {
+
+        GLImageStoragePtr originalImageTexture, maskTexture, dstTexture;
+        if (originalImg) {
+            assert(originalImg->getStorageMode() == eStorageModeGLTex);
+            originalImageTexture = toGLImageStorage(originalImg->_imp->channels[0]);
+        }
+        if (maskImg && masked) {
+            assert(maskImg->getStorageMode() == eStorageModeGLTex);
+            maskTexture = toGLImageStorage(maskImg->_imp->channels[0]);
+        }
+        dstTexture = toGLImageStorage(_imp->channels[0]);
+
+        RectI realRoi;
+        roi.intersect(dstTexture->getBounds(), &realRoi);
+        ImagePrivate::applyMaskMixCopyUnprocessedChannelsGL(originalImageTexture, maskTexture, dstTexture, mix, maskInvert, processChannels, realRoi);
+        return eActionStatusOK;
+    }
+
+    // This function only works if original image and mask image have the same bitdepth as output
+    assert(!originalImg || (originalImg->getBitDepth() == getBitDepth()));
+    assert(!maskImg || (maskImg->getBitDepth() == getBitDepth()));
+
+    ImageConstPtr srcImage = getSourceImageForRoI(originalImg, roi);
+    ImageConstPtr maskImage = getSourceImageForRoI(maskImg, roi);
+    if ( (originalImg && !srcImage) || (maskImg && !maskImage) ) {
+        return eActionStatusFailed;
+    }
+
+    Image::CPUData srcImgData, maskImgData;
+    if (srcImage) {
+        srcImage->getCPUData(&srcImgData);
+    }
+
+    if (maskImage) {
+        maskImage->getCPUData(&maskImgData);
+        assert(maskImgData.nComps == 1);
+    }
+
+    Image::CPUData dstImgData;
+    getCPUData(&dstImgData);
+
+    RectI tileRoI;
+    roi.intersect(dstImgData.bounds, &tileRoI);
+
+    MaskMixCopyUnProcessedProcessor processor(_imp->renderClone.lock());
+    // NaNs can only be held by floating point images
+    const bool replaceNaNs = nNaNsReplaced && dstImgData.bitDepth == eImageBitDepthFloat;
+    processor.setValues(srcImgData, maskImgData, dstImgData, processChannels, mix, maskInvert, replaceNaNs);
+    processor.setRenderWindow(tileRoI);
+    ActionRetCodeEnum stat = processor.process();
+    if (replaceNaNs) {
+        *nNaNsReplaced = processor.getNumNaNs();
+    }
+    return stat;
+
+} // applyMaskMixAndCopyUnProcessedChannels
+
 NATRON_NAMESPACE_EXIT;
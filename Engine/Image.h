@@ -39,6 +39,7 @@
 
 #include "Global/GLIncludes.h"
 #include "Engine/Cache.h" // CacheEntryLockerPtr - put it in EngineFwd.h?
+#include "Engine/HalfFloat.h"
 #include "Engine/ImagePlaneDesc.h"
 #include "Engine/ImageTilesState.h"
 #include "Engine/RectI.h"
@@ -104,8 +105,7 @@ public:
         // - If storage is an OpenGL texture, then it is expected that the buffer layout is set to
         // eImageBufferLayoutRGBAPackedFullRect and bitdepth to eImageBitDepthFloat
         //
-        // - If storage is on disk (using MMAP), then it is expected that the buffer layout is set to
-        // eImageBufferLayoutMonoChannelTiled as this is the only format supported by MMAP.
+        // - If the buffer layout is eImageBufferLayoutMonoChannelTiled, the storage must be eStorageModeRAM.
         //
         // Default - eStorageModeRAM
         StorageModeEnum storage;
@@ -169,6 +169,14 @@ public:
         // Default - 0
         U64 nodeTimeViewVariantHash;
 
+        // The hashes of images of the same node at the same time/view rendered before the node changed, most recent first,
+        // with the region in pixel coordinates at mipMapLevel which changed since. The cached tiles of these images outside of this region
+        // are re-used instead of being rendered again. See EffectInstance::DirtyRegionChange_RAII.
+        // This is relevant only if cachePolicy is eCacheAccessModeReadWrite.
+        //
+        // Default - empty
+        std::vector<std::pair<U64, RectI> > previousTimeViewVariantHashes;
+
 
         // If the storage is set to OpenGL texture, this is the OpenGL context to which the texture belongs to.
         //
@@ -213,8 +221,9 @@ public:
     /**
      * @brief Must be called after Image::create if delayAllocation=true was passed to InitStorageArgs to allocate memory buffers.
      * Note that this function may throw a std::bad_alloc if a buffer allocation fails.
+     * Returns the size in bytes of the buffers allocated by this call.
      **/
-    void ensureBuffersAllocated();
+    std::size_t ensureBuffersAllocated();
 
     /**
      * @brief Returns the internal buffer formating
@@ -306,6 +315,23 @@ public:
         eMonoToPackedConversionCopyToAll
     };
 
+    /**
+     * @brief The filters used by resample(), in the same order as the filter choice of the transform nodes.
+     **/
+    enum ResampleFilterEnum
+    {
+        // Nearest neighbor
+        eResampleFilterImpulse = 0,
+        eResampleFilterBilinear,
+        eResampleFilterCubic,
+        eResampleFilterKeys,
+        eResampleFilterSimon,
+        eResampleFilterRifman,
+        eResampleFilterMitchell,
+        eResampleFilterParzen,
+        eResampleFilterNotch
+    };
+
     struct CopyPixelsArgs
     {
         // The portion of rectangle to copy.
@@ -375,6 +401,16 @@ public:
      **/
     ActionRetCodeEnum copyPixels(const Image& other, const CopyPixelsArgs& args);
 
+    /**
+     * @brief Returns an image of the given plane whose pixels are the pixels of this image, without any copy.
+     * The plane must have the same number of components as the plane of this image.
+     * Since the buffer is shared, the returned image must only be read from, e.g: to hand it to a plug-in
+     * as a source image.
+     * This is only supported for RAM images in the eImageBufferLayoutRGBAPackedFullRect layout,
+     * otherwise NULL is returned.
+     **/
+    ImagePtr createSharedBufferImage(const ImagePlaneDesc& plane) const;
+
     /**
      * @brief Helper function to get string from a layer and bitdepth
      **/
@@ -515,11 +551,18 @@ public:
         ImageBitDepthEnum bitDepth;
         int nComps;
 
+        // If the image has the eImageBufferLayoutMonoChannelTiled layout, the size of the tiles,
+        // otherwise 0. The pointers of a tiled image cannot be passed to getChannelPointers():
+        // use getCPUTileData() to get the buffer of each tile.
+        int tileSizeX, tileSizeY;
+
         CPUData()
         : ptrs()
         , bounds()
         , bitDepth(eImageBitDepthNone)
         , nComps(0)
+        , tileSizeX(0)
+        , tileSizeY(0)
         {
             memset(ptrs, 0, sizeof(void*) * 4);
         }
@@ -529,11 +572,27 @@ public:
         , bounds(other.bounds)
         , bitDepth(other.bitDepth)
         , nComps(other.nComps)
+        , tileSizeX(other.tileSizeX)
+        , tileSizeY(other.tileSizeY)
         {
             memcpy(ptrs, other.ptrs, sizeof(void*) * 4);
         }
+
+        bool isTiled() const
+        {
+            return tileSizeX > 0;
+        }
     };
 
+    /**
+     * @brief Returns in tileData the buffers of the tile of data containing the given rectangle, which must
+     * be contained in a single tile. The tile is described as a eImageBufferLayoutMonoChannelFullRect buffer whose
+     * bounds are the tile bounds: these may be larger than the bounds of the image for the tiles on the border, the
+     * pixels outside of the image bounds are allocated but never rendered.
+     * If data does not have the eImageBufferLayoutMonoChannelTiled layout, tileData is set to data.
+     **/
+    static void getCPUTileData(const CPUData& data, const RectI& rect, CPUData* tileData);
+
     /**
      * @brief For an image that is represented as an OpenGL texture, returns the associated texture.
      **/
@@ -544,6 +603,13 @@ public:
      **/
     void getCPUData(CPUData* data) const;
 
+    /**
+     * @brief Returns a copy of this image in the eImageBufferLayoutRGBAPackedFullRect layout if it has the
+     * eImageBufferLayoutMonoChannelTiled layout, otherwise returns this image.
+     * This is used by the functions that read pixels around the pixel they write, across multiple tiles.
+     **/
+    ImageConstPtr getFullRectImage() const;
+
     /**
      * @brief Returns the cache access policy for this image
      **/
@@ -600,10 +666,34 @@ public:
     ImagePtr downscaleMipMap(const RectI & roi, unsigned int downscaleLevels) const;
 
     /**
-     * @brief Returns true if the image contains NaNs or infinite values, and fix them.
+     * @brief Replaces the NaNs of the image in the given roi by 1 and returns how many were replaced.
+     * The scan-lines are processed in parallel. Only floating point images are checked.
      * Currently, no OpenGL implementation is provided.
      */
-    bool checkForNaNs(const RectI& roi) WARN_UNUSED_RETURN;
+    std::size_t checkForNaNs(const RectI& roi) WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Applies a 3x4 colour matrix to the RGB channels of the image in the given roi: matrix holds the rows
+     * for the red, green and blue channels, the 4th column of each row being an offset. Alpha is left unchanged
+     * and images with fewer than 3 channels are not modified.
+     * The scan-lines are processed in parallel. Currently, no OpenGL implementation is provided.
+     */
+    ActionRetCodeEnum applyColorMatrix(const RectI& roi, const double matrix[12]);
+
+    /**
+     * @brief Fills the given roi of this image by resampling the source image with the given filter: each pixel of this image
+     * at (x, y) in pixel coordinates is sampled in the source image at dstToSrc * (x, y). The source is black outside of its bounds.
+     * If clamp is true, the filters with negative lobes (Keys, Simon, Rifman) are clamped to the values of the nearest pixels.
+     * Transforms that only scale and translate are filtered separately along both axes, with the filter weights of each
+     * row and column computed once.
+     * Both images must have the same bitdepth and number of components.
+     * The scan-lines are processed in parallel. Currently, no OpenGL implementation is provided.
+     */
+    ActionRetCodeEnum resample(const Image& srcImage,
+                               const Transform::Matrix3x3& dstToSrc,
+                               ResampleFilterEnum filter,
+                               bool clamp,
+                               const RectI& roi);
 
 
     /**
@@ -629,6 +719,21 @@ public:
                       bool maskInvert,
                       float mix);
 
+    /**
+     * @brief Same as copyUnProcessedChannels() followed by applyMaskMix() with the same original image,
+     * but the image is processed in a single pass.
+     * If nNaNsReplaced is not NULL, the NaNs of this image are also replaced as done by checkForNaNs()
+     * before the other operations and nNaNsReplaced is set to their count.
+     **/
+    ActionRetCodeEnum applyMaskMixAndCopyUnProcessedChannels(const RectI& roi,
+                                                             std::bitset<4> processChannels,
+                                                             const ImagePtr& maskImg,
+                                                             const ImagePtr& originalImg,
+                                                             bool masked,
+                                                             bool maskInvert,
+                                                             float mix,
+                                                             std::size_t* nNaNsReplaced = 0);
+
 
     /**
      * @brief Clamp the pixel to the given minval and maxval
@@ -691,6 +796,10 @@ template<>
 inline float
 Image::clampIfInt(float v) { return v; }
 
+template<>
+inline HalfFloat
+Image::clampIfInt(float v) { return HalfFloat(v); }
+
 NATRON_NAMESPACE_EXIT;
 
 #endif // NATRON_ENGINE_IMAGE_H
@@ -240,13 +240,18 @@ struct TileData
 /**
  * @brief Since all tiles in the cache share the same cache entry (same image) we want the allocation of the tiles from the cache to 
  * come from different buckets so that we distribute uniformly the tile file storage.
+ * This index also identifies the tile in the cache compressed tier: low quality (draft) tiles get a different index
+ * so that they are never restored in place of a full quality tile.
  **/
-static U64 makeTileCacheIndex(int tx, int ty, unsigned int mipMapLevel, int channelIndex) {
+static U64 makeTileCacheIndex(int tx, int ty, unsigned int mipMapLevel, int channelIndex, bool lowQuality = false) {
     Hash64 hash;
     hash.append(channelIndex);
     hash.append(mipMapLevel);
     hash.append(tx);
     hash.append(ty);
+    if (lowQuality) {
+        hash.append((U64)1);
+    }
     hash.computeHash();
     return hash.value();
 }
@@ -327,6 +332,10 @@ struct ImageCacheEntryPrivate
     // Pointer to the image holding this ImageCacheEntry
     ImageWPtr image;
 
+    // Keys of the images rendered before the node changed with the region which changed since, see setPreviousKeys()
+    // Protected by lock
+    std::vector<std::pair<ImageCacheKeyPtr, RectI> > previousKeys;
+
     ImageCacheEntryPrivate(ImageCacheEntry* publicInterface,
                            const ImagePtr& image,
                            const std::vector<RectI>& mipMapPixelRods,
@@ -359,6 +368,7 @@ struct ImageCacheEntryPrivate
     , tilesToFetch()
     , cachePolicy(cachePolicy)
     , image(image)
+    , previousKeys()
     {
         assert(perMipMapPixelRod.size() >= mipMapLevel + 1);
         for (int i = 0; i < 4; ++i) {
@@ -367,7 +377,7 @@ struct ImageCacheEntryPrivate
 
         assert(nComps > 0);
         int tileSizeX, tileSizeY;
-        CacheBase::getTileSizePx(depth, &tileSizeX, &tileSizeY);
+        appPTR->getTileCache()->getTileSizePx(depth, &tileSizeX, &tileSizeY);
 
 #ifndef NDEBUG
         assert(perMipMapPixelRod[mipMapLevel].contains(roi));
@@ -424,8 +434,38 @@ struct ImageCacheEntryPrivate
      **/
     ActionRetCodeEnum fetchAndCopyCachedTiles() WARN_UNUSED_RETURN;
 
+    enum RestoreTierEnum
+    {
+        // The tiles evicted earlier by this process, see CacheBase::retrieveAndLockCompressedTiles
+        eRestoreTierCompressed,
+
+        // The tiles published by any process sharing the remote tier, see CacheBase::retrieveAndLockRemoteTiles
+        eRestoreTierRemote
+    };
+
+    /**
+     * @brief Restore from the given tier of the cache the tiles marked for rendering at the mipMapLevel.
+     * Restored tiles are marked rendered and their pixels are copied to the local storage.
+     * This must be called after a call to readAndUpdateStateMap
+     **/
+    ActionRetCodeEnum fetchAndCopyRestoredTiles(RestoreTierEnum tier) WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Copy to the local storage the tiles marked for rendering at the mipMapLevel that are cached in the images of previousKeys
+     * outside of the region which changed since. The tiles copied are added to reusedTiles: they must then be published
+     * with markTilesAsRendered(). This must be called after a call to readAndUpdateStateMap, without the lock of internalCacheEntry.
+     **/
+    ActionRetCodeEnum fetchAndCopyPreviousKeysTiles(TilesSet* reusedTiles) WARN_UNUSED_RETURN;
+
     void updateCachedTilesStateMap();
 
+    /**
+     * @brief Implementation of markCacheTilesAsRendered() and markCacheTilesInRegionAsRendered().
+     * If region is non null, only the marked tiles entirely contained in region are published to the cache and the others
+     * remain marked. Likewise if tiles is non null, only the marked tiles in this set are published.
+     **/
+    void markTilesAsRendered(const RectI* region, const TilesSet* tiles, double renderCost);
+
     enum LookupTileStateRetCodeEnum
     {
         eLookupTileStateRetCodeUpToDate,
@@ -477,6 +517,13 @@ ImageCacheEntry::~ImageCacheEntry()
     markCacheTilesAsAborted();
 }
 
+void
+ImageCacheEntry::setPreviousKeys(const std::vector<std::pair<ImageCacheKeyPtr, RectI> >& keys)
+{
+    boost::unique_lock<boost::mutex> locker(_imp->lock);
+    _imp->previousKeys = keys;
+}
+
 ImageCacheKeyPtr
 ImageCacheEntry::getCacheKey() const
 {
@@ -530,6 +577,10 @@ class CachePixelsTransferProcessorBase : public MultiThreadProcessorBase
 protected:
     std::vector<boost::shared_ptr<TileData> > _tasks;
     ImageCacheEntryPrivate* _imp;
+
+    // If the local buffers have the eImageBufferLayoutMonoChannelTiled layout, their tiles
+    // have the layout of the cache tiles and are copied with a memcpy
+    Image::CPUData _localData;
     void* _localBuffers[4];
     int _pixelStride;
 public:
@@ -538,6 +589,7 @@ public:
     : MultiThreadProcessorBase(renderClone)
     , _tasks()
     , _imp(0)
+    , _localData()
     , _localBuffers()
     , _pixelStride(0)
     {
@@ -555,9 +607,10 @@ public:
         _tasks = tasks;
 
         // Extract channel pointers
-        Image::CPUData data;
-        ImagePrivate::getCPUDataInternal(_imp->roi, _imp->nComps, _imp->imageBuffers, _imp->bitdepth, _imp->format, &data);
-        Image::getChannelPointers((const void**)data.ptrs, _imp->roi.x1, _imp->roi.y1, _imp->roi, _imp->nComps, _imp->bitdepth, _localBuffers, &_pixelStride);
+        ImagePrivate::getCPUDataInternal(_imp->roi, _imp->nComps, _imp->imageBuffers, _imp->bitdepth, _imp->format, _imp->localTilesState.tileSizeX, _imp->localTilesState.tileSizeY, &_localData);
+        if ( !_localData.isTiled() ) {
+            Image::getChannelPointers((const void**)_localData.ptrs, _imp->roi.x1, _imp->roi.y1, _imp->roi, _imp->nComps, _imp->bitdepth, _localBuffers, &_pixelStride);
+        }
     }
 };
 
@@ -596,6 +649,28 @@ public:
             RectI tileBoundsRounded = task.bounds;
             tileBoundsRounded.roundToTileSize(_imp->localTilesState.tileSizeX, _imp->localTilesState.tileSizeY);
 
+            if ( _localData.isTiled() ) {
+                // The local tile has the same layout as the cache tile
+                Image::CPUData localTileData;
+                Image::getCPUTileData(_localData, tileBoundsRounded, &localTileData);
+                PIX* localTilePix = (PIX*)localTileData.ptrs[task.channel_i];
+                assert(localTilePix);
+                const std::size_t tileSizeBytes = (std::size_t)_imp->localTilesState.tileSizeX * _imp->localTilesState.tileSizeY * sizeof(PIX);
+                if (copyToCache) {
+                    memcpy(task.ptr, localTilePix, tileSizeBytes);
+                    if (task.bounds.width() != _imp->localTilesState.tileSizeX ||
+                        task.bounds.height() != _imp->localTilesState.tileSizeY) {
+                        ImageCacheEntryProcessing::repeatEdgesForDepth<PIX>((PIX*)task.ptr, task.bounds, _imp->localTilesState.tileSizeX, _imp->localTilesState.tileSizeY);
+                    }
+                } else {
+                    if (_effect && _effect->isRenderAborted()) {
+                        return eActionStatusAborted;
+                    }
+                    memcpy(localTilePix, task.ptr, tileSizeBytes);
+                }
+                continue;
+            }
+
             if (copyToCache) {
 
                 // When copying to the cache, always copy full tiles, but ensure we do not copy outside of the bounds of the RoI for tiles on the border
@@ -1090,20 +1165,21 @@ static void fetchTileIndicesInPyramid(unsigned int lookupLevel,
                                       int tileSizeY,
                                       const TileCacheIndex& tile,
                                       int nComps,
+                                      bool lowQuality,
                                       std::vector<U64> *tileIndicesToFetch,
                                       std::vector<U64>* tilesAllocNeeded)
 {
     if (tile.upscaleTiles[0]) {
         // We must downscale the upscaled tiles
         for (int c = 0; c < nComps; ++c) {
-            U64 tileBucketHash = makeTileCacheIndex(tile.tx, tile.ty, lookupLevel, c);
+            U64 tileBucketHash = makeTileCacheIndex(tile.tx, tile.ty, lookupLevel, c, lowQuality);
             tilesAllocNeeded->push_back(tileBucketHash);
         }
         for (int i = 0; i < 4; ++i) {
             assert(tile.upscaleTiles[i]);
             // Check that the upscaled tile exists
             if (tile.upscaleTiles[i]->tx != -1) {
-                fetchTileIndicesInPyramid(lookupLevel - 1, tileSizeX, tileSizeY, *tile.upscaleTiles[i], nComps, tileIndicesToFetch, tilesAllocNeeded);
+                fetchTileIndicesInPyramid(lookupLevel - 1, tileSizeX, tileSizeY, *tile.upscaleTiles[i], nComps, lowQuality, tileIndicesToFetch, tilesAllocNeeded);
             }
         }
     } else {
@@ -1220,7 +1296,7 @@ ImageCacheEntryPrivate::fetchAndCopyCachedTiles()
     // Number of tiles to allocate to downscale
     std::vector<U64> tilesAllocNeeded;
     for (std::size_t i = 0; i < tilesToFetch.size(); ++i) {
-        fetchTileIndicesInPyramid(mipMapLevel, localTilesState.tileSizeX, localTilesState.tileSizeY, tilesToFetch[i], nComps, &tileIndicesToFetch, &tilesAllocNeeded);
+        fetchTileIndicesInPyramid(mipMapLevel, localTilesState.tileSizeX, localTilesState.tileSizeY, tilesToFetch[i], nComps, isDraftModeEnabled, &tileIndicesToFetch, &tilesAllocNeeded);
     }
 
     if (tileIndicesToFetch.empty() && tilesAllocNeeded.empty()) {
@@ -1382,10 +1458,297 @@ ImageCacheEntryPrivate::fetchAndCopyCachedTiles()
 
 } // fetchAndCopyCachedTiles
 
+ActionRetCodeEnum
+ImageCacheEntryPrivate::fetchAndCopyRestoredTiles(RestoreTierEnum tier)
+{
+    if (mipMapLevel >= markedTiles.size() || markedTiles[mipMapLevel].empty()) {
+        return eActionStatusOK;
+    }
+
+    CacheBasePtr tileCache = internalCacheEntry->getCache();
+    switch (tier) {
+        case eRestoreTierCompressed:
+            if (tileCache->getCompressedTierMaximumSize() == 0) {
+                return eActionStatusOK;
+            }
+            break;
+        case eRestoreTierRemote:
+            // Draft tiles are never published
+            if (isDraftModeEnabled || tileCache->getRemoteTierPath().empty()) {
+                return eActionStatusOK;
+            }
+            break;
+    }
+
+    // Look-up all channels of each marked tile
+    std::vector<TileCoord> markedCoords(markedTiles[mipMapLevel].begin(), markedTiles[mipMapLevel].end());
+    std::vector<U64> tilesToRestore;
+    for (std::size_t i = 0; i < markedCoords.size(); ++i) {
+        for (int c = 0; c < nComps; ++c) {
+            tilesToRestore.push_back(makeTileCacheIndex(markedCoords[i].tx, markedCoords[i].ty, mipMapLevel, c, isDraftModeEnabled));
+        }
+    }
+
+    // Tiles for which only some channels were restored must be released once the cache is unlocked
+    std::vector<U64> localTileIndicesToRelease, cacheTileIndicesToRelease;
+
+    ActionRetCodeEnum stat = eActionStatusOK;
+    bool stateMapUpdated = false;
+    {
+        std::vector<std::pair<U64, void*> > restoredTiles;
+        void* cacheData;
+        bool gotTiles;
+        if (tier == eRestoreTierCompressed) {
+            gotTiles = tileCache->retrieveAndLockCompressedTiles(internalCacheEntry, tilesToRestore, &restoredTiles, &cacheData);
+        } else {
+            gotTiles = tileCache->retrieveAndLockRemoteTiles(internalCacheEntry, tilesToRestore, &restoredTiles, &cacheData);
+        }
+        CacheDataLock_RAII cacheDataDeleter(tileCache, cacheData);
+        if (!gotTiles) {
+            return eActionStatusOK;
+        }
+        assert(restoredTiles.size() == tilesToRestore.size());
+
+        // We are going to copy data from the cache, ensure our local buffers are allocated
+        image.lock()->ensureBuffersAllocated();
+
+        TileStateHeader cacheStateMap(localTilesState.tileSizeX, localTilesState.tileSizeY, &internalCacheEntry->perMipMapTilesState[mipMapLevel]);
+        assert(!cacheStateMap.state->tiles.empty());
+
+        std::vector<boost::shared_ptr<TileData> > tilesToCopy;
+        for (std::size_t i = 0; i < markedCoords.size(); ++i) {
+
+            bool allChannelsRestored = true;
+            for (int c = 0; c < nComps; ++c) {
+                if (!restoredTiles[i * nComps + c].second) {
+                    allChannelsRestored = false;
+                    break;
+                }
+            }
+            if (!allChannelsRestored) {
+                for (int c = 0; c < nComps; ++c) {
+                    if (restoredTiles[i * nComps + c].second) {
+                        localTileIndicesToRelease.push_back(tilesToRestore[i * nComps + c]);
+                        cacheTileIndicesToRelease.push_back(restoredTiles[i * nComps + c].first);
+                    }
+                }
+                continue;
+            }
+
+            const TileCoord& coord = markedCoords[i];
+            TileState* cacheTileState = cacheStateMap.getTileAt(coord.tx, coord.ty);
+            TileState* localTileState = localTilesState.getTileAt(coord.tx, coord.ty);
+            assert(cacheTileState->status == eTileStatusPending);
+            cacheTileState->status = isDraftModeEnabled ? eTileStatusRenderedLowQuality : eTileStatusRenderedHighestQuality;
+            localTileState->status = cacheTileState->status;
+
+            for (int c = 0; c < nComps; ++c) {
+                cacheTileState->channelsTileStorageIndex[c] = restoredTiles[i * nComps + c].first;
+                localTileState->channelsTileStorageIndex[c] = restoredTiles[i * nComps + c].first;
+
+                boost::shared_ptr<TileData> copy(new TileData);
+                copy->bounds = localTileState->bounds;
+                copy->channel_i = c;
+                copy->ptr = restoredTiles[i * nComps + c].second;
+                copy->tileCache_i = restoredTiles[i * nComps + c].first;
+                tilesToCopy.push_back(copy);
+            }
+
+            // This tile no longer needs to be rendered
+            markedTiles[mipMapLevel].erase(coord);
+            stateMapUpdated = true;
+#ifdef TRACE_TILES_STATUS
+            qDebug() << QThread::currentThread() << effect->getScriptName_mt_safe().c_str() << image.lock()->getLayer().getPlaneLabel().c_str() << internalCacheEntry->getHashKey() << "marking " << coord.tx << coord.ty << "rendered from the" << (tier == eRestoreTierCompressed ? "compressed" : "remote") << "tier";
+#endif
+        } // for each marked tile
+
+        if (!tilesToCopy.empty()) {
+            boost::scoped_ptr<CachePixelsTransferProcessorBase> processor;
+            switch (bitdepth) {
+                case eImageBitDepthByte:
+                    processor.reset(new CachePixelsTransferProcessor<false /*copyToCache*/, unsigned char>(effect));
+                    break;
+                case eImageBitDepthShort:
+                    processor.reset(new CachePixelsTransferProcessor<false /*copyToCache*/, unsigned short>(effect));
+                    break;
+                case eImageBitDepthFloat:
+                    processor.reset(new CachePixelsTransferProcessor<false /*copyToCache*/, float>(effect));
+                    break;
+                default:
+                    break;
+            }
+            processor->setValues(this, tilesToCopy);
+            stat = processor->launchThreadsBlocking();
+        }
+    } // cacheDataDeleter
+
+    if (!cacheTileIndicesToRelease.empty()) {
+        tileCache->releaseTiles(internalCacheEntry, localTileIndicesToRelease, cacheTileIndicesToRelease);
+    }
+
+    // In persistent mode we have to actually copy the states map from the cache entry to the cache
+    if (internalCacheEntry->isPersistent() && stateMapUpdated) {
+        updateCachedTilesStateMap();
+    }
+    return stat;
+} // fetchAndCopyRestoredTiles
+
+ActionRetCodeEnum
+ImageCacheEntryPrivate::fetchAndCopyPreviousKeysTiles(TilesSet* reusedTiles)
+{
+    if (previousKeys.empty() || mipMapLevel >= markedTiles.size() || markedTiles[mipMapLevel].empty()) {
+        return eActionStatusOK;
+    }
+
+    // In persistent mode, the state map of the previous images would have to be read from the memory segment
+    CacheBasePtr tileCache = internalCacheEntry->getCache();
+    if (tileCache->isPersistent()) {
+        return eActionStatusOK;
+    }
+
+    if (bitdepth != eImageBitDepthByte && bitdepth != eImageBitDepthShort && bitdepth != eImageBitDepthFloat) {
+        return eActionStatusOK;
+    }
+
+    // The tiles that we still have to render
+    TilesSet tilesToReuse = markedTiles[mipMapLevel];
+
+    for (std::size_t k = 0; k < previousKeys.size() && !tilesToReuse.empty(); ++k) {
+
+        const ImageCacheKeyPtr& previousKey = previousKeys[k].first;
+        const RectI& dirtyRegion = previousKeys[k].second;
+
+        // Do not create an entry in the cache if the image is not there anymore
+        if (!tileCache->hasCacheEntryForHash(previousKey->getHash())) {
+            continue;
+        }
+
+        ImageCacheEntryInternalBasePtr previousEntry = ImageCacheEntryInternal<false>::create(previousKey);
+        previousEntry->tileSizeX = localTilesState.tileSizeX;
+        previousEntry->tileSizeY = localTilesState.tileSizeY;
+        CacheEntryLockerBasePtr cacheAccess = previousEntry->getFromCache();
+        if (cacheAccess->getStatus() != CacheEntryLockerBase::eCacheEntryStatusCached) {
+            continue;
+        }
+        ImageCacheEntryInternalBasePtr cachedEntry = toImageCacheEntryInternal(cacheAccess->getProcessLocalEntry());
+        ImageCacheEntryInternal<false>* nonPersistentCachedEntry = dynamic_cast<ImageCacheEntryInternal<false>* >(cachedEntry.get());
+        if (!nonPersistentCachedEntry) {
+            continue;
+        }
+
+        // Keep the state map locked while copying so that the tiles are not released meanwhile
+        boost::shared_lock<boost::shared_mutex> readLock(nonPersistentCachedEntry->perMipMapTilesStateMutex);
+        if (mipMapLevel >= cachedEntry->perMipMapTilesState.size() ||
+            cachedEntry->tileSizeX != localTilesState.tileSizeX ||
+            cachedEntry->tileSizeY != localTilesState.tileSizeY) {
+            continue;
+        }
+        TileStateHeader previousStateMap(localTilesState.tileSizeX, localTilesState.tileSizeY, &cachedEntry->perMipMapTilesState[mipMapLevel]);
+        if (previousStateMap.state->tiles.empty()) {
+            continue;
+        }
+        const RectI& previousBounds = previousStateMap.state->boundsRoundedToTileSize;
+
+        std::vector<TileCoord> foundCoords;
+        std::vector<U64> tileIndicesToFetch;
+        std::vector<boost::shared_ptr<TileData> > tilesToCopy;
+        for (TilesSet::const_iterator it = tilesToReuse.begin(); it != tilesToReuse.end(); ++it) {
+            if (it->tx < previousBounds.x1 || it->tx >= previousBounds.x2 || it->ty < previousBounds.y1 || it->ty >= previousBounds.y2) {
+                continue;
+            }
+            const TileState* localTileState = localTilesState.getTileAt(it->tx, it->ty);
+            if (localTileState->bounds.intersects(dirtyRegion)) {
+                continue;
+            }
+            const TileState* previousTileState = previousStateMap.getTileAt(it->tx, it->ty);
+
+            // A tile on the border of a different RoD does not hold the same pixels
+            if (previousTileState->bounds != localTileState->bounds) {
+                continue;
+            }
+            if (previousTileState->status != eTileStatusRenderedHighestQuality &&
+                (!isDraftModeEnabled || previousTileState->status != eTileStatusRenderedLowQuality)) {
+                continue;
+            }
+            bool hasAllChannels = true;
+            for (int c = 0; c < nComps; ++c) {
+                if (previousTileState->channelsTileStorageIndex[c] == (U64)-1) {
+                    hasAllChannels = false;
+                    break;
+                }
+            }
+            if (!hasAllChannels) {
+                continue;
+            }
+            foundCoords.push_back(*it);
+            for (int c = 0; c < nComps; ++c) {
+                tileIndicesToFetch.push_back(previousTileState->channelsTileStorageIndex[c]);
+
+                boost::shared_ptr<TileData> copy(new TileData);
+                copy->bounds = localTileState->bounds;
+                copy->channel_i = c;
+                copy->ptr = 0;
+                copy->tileCache_i = previousTileState->channelsTileStorageIndex[c];
+                tilesToCopy.push_back(copy);
+            }
+        }
+        if (foundCoords.empty()) {
+            continue;
+        }
+
+        // We are going to copy data from the cache, ensure our local buffers are allocated
+        image.lock()->ensureBuffersAllocated();
+
+        std::vector<void*> fetchedExistingTiles;
+        void* cacheData;
+        bool gotTiles = tileCache->retrieveAndLockTiles(cachedEntry, &tileIndicesToFetch, NULL, &fetchedExistingTiles, NULL, &cacheData);
+        CacheDataLock_RAII cacheDataDeleter(tileCache, cacheData);
+        if (!gotTiles || fetchedExistingTiles.size() != tilesToCopy.size()) {
+            continue;
+        }
+        for (std::size_t i = 0; i < tilesToCopy.size(); ++i) {
+            tilesToCopy[i]->ptr = fetchedExistingTiles[i];
+        }
+
+        boost::scoped_ptr<CachePixelsTransferProcessorBase> processor;
+        switch (bitdepth) {
+            case eImageBitDepthByte:
+                processor.reset(new CachePixelsTransferProcessor<false /*copyToCache*/, unsigned char>(effect));
+                break;
+            case eImageBitDepthShort:
+                processor.reset(new CachePixelsTransferProcessor<false /*copyToCache*/, unsigned short>(effect));
+                break;
+            case eImageBitDepthFloat:
+                processor.reset(new CachePixelsTransferProcessor<false /*copyToCache*/, float>(effect));
+                break;
+            default:
+                break;
+        }
+        processor->setValues(this, tilesToCopy);
+        ActionRetCodeEnum stat = processor->launchThreadsBlocking();
+        if (isFailureRetCode(stat)) {
+            return stat;
+        }
+
+        for (std::size_t i = 0; i < foundCoords.size(); ++i) {
+            reusedTiles->insert(foundCoords[i]);
+            tilesToReuse.erase(foundCoords[i]);
+#ifdef TRACE_TILES_STATUS
+            qDebug() << QThread::currentThread() << effect->getScriptName_mt_safe().c_str() << image.lock()->getLayer().getPlaneLabel().c_str() << internalCacheEntry->getHashKey() << "re-using " << foundCoords[i].tx << foundCoords[i].ty << "from" << previousKey->getHash();
+#endif
+        }
+    } // for each previous key
+
+    return eActionStatusOK;
+} // fetchAndCopyPreviousKeysTiles
+
 ActionRetCodeEnum
 ImageCacheEntry::fetchCachedTilesAndUpdateStatus(TileStateHeader* tileStatus, bool* hasUnRenderedTile, bool *hasPendingResults)
 {
 
+    // The tiles copied from the images in previousKeys, published once the lock is released
+    TilesSet reusedTiles;
+
     // Protect all local structures against multiple threads using this object.
     {
         boost::unique_lock<boost::mutex> locker(_imp->lock);
@@ -1549,11 +1912,37 @@ ImageCacheEntry::fetchCachedTilesAndUpdateStatus(TileStateHeader* tileStatus, bo
                 if (isFailureRetCode(stat)) {
                     return stat;
                 }
+
+                // The tiles we must render may have been evicted to the compressed tier: restore them instead.
+                // Otherwise another host may have published them to the remote tier.
+                if (markedTilesModified) {
+                    stat = _imp->fetchAndCopyRestoredTiles(ImageCacheEntryPrivate::eRestoreTierCompressed);
+                    if (isFailureRetCode(stat)) {
+                        return stat;
+                    }
+                    stat = _imp->fetchAndCopyRestoredTiles(ImageCacheEntryPrivate::eRestoreTierRemote);
+                    if (isFailureRetCode(stat)) {
+                        return stat;
+                    }
+                }
                 
             }
+
+            // The tiles left to render may not have changed since a previous image of the node was rendered.
+            // This is done without the lock of the cache entry since the previous image entry is locked.
+            if (markedTilesModified) {
+                ActionRetCodeEnum stat = _imp->fetchAndCopyPreviousKeysTiles(&reusedTiles);
+                if (isFailureRetCode(stat)) {
+                    return stat;
+                }
+            }
         } // _imp->cachePolicy = eCacheAccessModeNone
 
     } // locker
+
+    if (!reusedTiles.empty()) {
+        _imp->markTilesAsRendered(0, &reusedTiles, 0);
+    }
     
     getStatus(tileStatus, hasUnRenderedTile, hasPendingResults);
     return eActionStatusOK;
@@ -1789,44 +2178,58 @@ ImageCacheEntry::markCacheTilesInRegionAsNotRendered(const RectI& roi)
 } // markCacheTilesInRegionAsNotRendered
 
 void
-ImageCacheEntry::markCacheTilesAsRendered()
+ImageCacheEntryPrivate::markTilesAsRendered(const RectI* region, const TilesSet* tiles, double renderCost)
 {
     // Make sure to call fetchCachedTilesAndUpdateStatus() first
-    assert(_imp->internalCacheEntry);
+    assert(internalCacheEntry);
 
     // Protect all local structures against multiple threads using this object.
-    boost::unique_lock<boost::mutex> locker(_imp->lock);
+    boost::unique_lock<boost::mutex> locker(lock);
     
-    if (_imp->markedTiles.empty()) {
+    if (markedTiles.empty()) {
+        return;
+    }
+
+    // When publishing a region only, the tiles outside of it are still being rendered by this thread
+    if ((region || tiles) && (mipMapLevel >= markedTiles.size() || markedTiles[mipMapLevel].empty())) {
         return;
     }
 
     boost::scoped_ptr<boost::unique_lock<boost::shared_mutex> > writeLock;
-    if (!_imp->internalCacheEntry->isPersistent()) {
+    if (!internalCacheEntry->isPersistent()) {
         // In non-persistent mode, lock the cache entry since it's shared across threads.
         // In persistent mode the entry is copied in fromMemorySegment
-        ImageCacheEntryInternal<false>* nonPersistentLocalEntry = dynamic_cast<ImageCacheEntryInternal<false>* >(_imp->internalCacheEntry.get());
+        ImageCacheEntryInternal<false>* nonPersistentLocalEntry = dynamic_cast<ImageCacheEntryInternal<false>* >(internalCacheEntry.get());
         assert(nonPersistentLocalEntry);
         writeLock.reset(new boost::unique_lock<boost::shared_mutex>(nonPersistentLocalEntry->perMipMapTilesStateMutex));
     }
 
     // We should have gotten the state map from the cache in fetchCachedTilesAndUpdateStatus()
-    assert(!_imp->internalCacheEntry->perMipMapTilesState.empty());
+    assert(!internalCacheEntry->perMipMapTilesState.empty());
 
-    assert(!_imp->localTilesState.state->tiles.empty());
+    assert(!localTilesState.state->tiles.empty());
 
 
     // Read the cache map and update our local map
-    CacheBasePtr cache = _imp->internalCacheEntry->getCache();
+    CacheBasePtr cache = internalCacheEntry->getCache();
     bool hasModifiedTileMap = false;
 
     std::vector<boost::shared_ptr<TileData> > tilesToCopy;
+    std::vector<TileCoord> publishedTiles;
 
     {
 
-        TileStateHeader cacheStateMap = TileStateHeader(_imp->localTilesState.tileSizeX, _imp->localTilesState.tileSizeY, &_imp->internalCacheEntry->perMipMapTilesState[_imp->mipMapLevel]);
+        TileStateHeader cacheStateMap = TileStateHeader(localTilesState.tileSizeX, localTilesState.tileSizeY, &internalCacheEntry->perMipMapTilesState[mipMapLevel]);
+
+        for (TilesSet::iterator it = markedTiles[mipMapLevel].begin(); it != markedTiles[mipMapLevel].end(); ++it) {
 
-        for (TilesSet::iterator it = _imp->markedTiles[_imp->mipMapLevel].begin(); it != _imp->markedTiles[_imp->mipMapLevel].end(); ++it) {
+            // A tile partially covered by the region is not rendered yet
+            if (region && !region->contains(localTilesState.getTileAt(it->tx, it->ty)->bounds)) {
+                continue;
+            }
+            if (tiles && tiles->find(*it) == tiles->end()) {
+                continue;
+            }
 
             TileState* cacheTileState = cacheStateMap.getTileAt(it->tx, it->ty);
 
@@ -1834,22 +2237,22 @@ ImageCacheEntry::markCacheTilesAsRendered()
             // readAndUpdateStateMap
             // Mark it as eTileStatusRendered now
             assert(cacheTileState->status == eTileStatusPending);
-            cacheTileState->status = _imp->isDraftModeEnabled ? eTileStatusRenderedLowQuality : eTileStatusRenderedHighestQuality;
+            cacheTileState->status = isDraftModeEnabled ? eTileStatusRenderedLowQuality : eTileStatusRenderedHighestQuality;
 
 #ifdef TRACE_TILES_STATUS
-            qDebug() << QThread::currentThread() << _imp->effect->getScriptName_mt_safe().c_str() << _imp->image.lock()->getLayer().getPlaneLabel().c_str() << _imp->internalCacheEntry->getHashKey() <<  "marking " << it->tx << it->ty << "rendered at level" << i;
+            qDebug() << QThread::currentThread() << effect->getScriptName_mt_safe().c_str() << image.lock()->getLayer().getPlaneLabel().c_str() << internalCacheEntry->getHashKey() <<  "marking " << it->tx << it->ty << "rendered at level" << i;
 #endif
             hasModifiedTileMap = true;
 
 
-            TileState* localTileState = _imp->localTilesState.getTileAt(it->tx, it->ty);
+            TileState* localTileState = localTilesState.getTileAt(it->tx, it->ty);
             assert(localTileState->status == eTileStatusNotRendered);
             if (localTileState->status == eTileStatusNotRendered) {
 
                 localTileState->status = cacheTileState->status;
 
-                if (_imp->cachePolicy != eCacheAccessModeNone) {
-                    for (int c = 0; c < _imp->nComps; ++c) {
+                if (cachePolicy != eCacheAccessModeNone) {
+                    for (int c = 0; c < nComps; ++c) {
                         // Mark this tile in the list of tiles to copy
                         boost::shared_ptr<TileData> copy(new TileData);
                         copy->bounds = localTileState->bounds;
@@ -1858,55 +2261,69 @@ ImageCacheEntry::markCacheTilesAsRendered()
                     }
                 }
             }
+            if (region || tiles) {
+                publishedTiles.push_back(*it);
+            }
+        }
+    }
 
+    if (region || tiles) {
+        for (std::size_t i = 0; i < publishedTiles.size(); ++i) {
+            markedTiles[mipMapLevel].erase(publishedTiles[i]);
         }
+    } else {
+        markedTiles.clear();
     }
-    
-    _imp->markedTiles.clear();
 
 #ifdef DEBUG
-    // Check that all tiles are marked either rendered or pending
-    RectI roiRounded = _imp->roi;
-    roiRounded.roundToTileSize(_imp->localTilesState.tileSizeX, _imp->localTilesState.tileSizeY);
-    for (int ty = roiRounded.y1; ty < roiRounded.y2; ty += _imp->localTilesState.tileSizeY) {
-        for (int tx = roiRounded.x1; tx < roiRounded.x2; tx += _imp->localTilesState.tileSizeX) {
-
-            assert(tx % _imp->localTilesState.tileSizeX == 0 && ty % _imp->localTilesState.tileSizeY == 0);
-            TileState* localTileState = _imp->localTilesState.getTileAt(tx, ty);
-            assert(localTileState->status == eTileStatusPending || localTileState->status == eTileStatusRenderedHighestQuality || localTileState->status == eTileStatusRenderedLowQuality);
+    if (!region && !tiles) {
+        // Check that all tiles are marked either rendered or pending
+        RectI roiRounded = roi;
+        roiRounded.roundToTileSize(localTilesState.tileSizeX, localTilesState.tileSizeY);
+        for (int ty = roiRounded.y1; ty < roiRounded.y2; ty += localTilesState.tileSizeY) {
+            for (int tx = roiRounded.x1; tx < roiRounded.x2; tx += localTilesState.tileSizeX) {
+
+                assert(tx % localTilesState.tileSizeX == 0 && ty % localTilesState.tileSizeY == 0);
+                TileState* localTileState = localTilesState.getTileAt(tx, ty);
+                assert(localTileState->status == eTileStatusPending || localTileState->status == eTileStatusRenderedHighestQuality || localTileState->status == eTileStatusRenderedLowQuality);
+            }
         }
     }
 #endif
 
     if (!hasModifiedTileMap) {
+        // All tiles may have been published already with markCacheTilesInRegionAsRendered()
+        if (renderCost > 0 && cachePolicy != eCacheAccessModeNone) {
+            cache->addEntryCost(internalCacheEntry, renderCost);
+        }
         return;
     }
 
     // The following is only done when interacting with the cache: we copy our local buffers to the cache
-    if (_imp->cachePolicy == eCacheAccessModeNone) {
+    if (cachePolicy == eCacheAccessModeNone) {
         return;
     }
 
     // We are going to fetch data from the cache, ensure our local buffers are allocated
-    _imp->image.lock()->ensureBuffersAllocated();
+    image.lock()->ensureBuffersAllocated();
 
 
     std::vector<U64> tilesAllocNeeded(tilesToCopy.size());
     for (std::size_t i = 0; i < tilesToCopy.size(); ++i) {
-        tilesAllocNeeded[i] = makeTileCacheIndex(tilesToCopy[i]->bounds.x1, tilesToCopy[i]->bounds.y1, _imp->mipMapLevel, tilesToCopy[i]->channel_i);
+        tilesAllocNeeded[i] = makeTileCacheIndex(tilesToCopy[i]->bounds.x1, tilesToCopy[i]->bounds.y1, mipMapLevel, tilesToCopy[i]->channel_i, isDraftModeEnabled);
     }
 
     // Allocated buffers for tiles
     std::vector<std::pair<U64, void*> > allocatedTiles;
     void* cacheData;
-    bool gotTiles = cache->retrieveAndLockTiles(_imp->internalCacheEntry, 0 /*existingTiles*/, &tilesAllocNeeded, NULL, &allocatedTiles, &cacheData);
+    bool gotTiles = cache->retrieveAndLockTiles(internalCacheEntry, 0 /*existingTiles*/, &tilesAllocNeeded, NULL, &allocatedTiles, &cacheData);
     CacheDataLock_RAII cacheDataDeleter(cache, cacheData);
     if (!gotTiles) {
         return;
     }
 
     // This is the tiles state at the mipmap level of interest in the cache
-    TileStateHeader cacheStateMap(_imp->localTilesState.tileSizeX, _imp->localTilesState.tileSizeY, &_imp->internalCacheEntry->perMipMapTilesState[_imp->mipMapLevel]);
+    TileStateHeader cacheStateMap(localTilesState.tileSizeX, localTilesState.tileSizeY, &internalCacheEntry->perMipMapTilesState[mipMapLevel]);
     assert(!cacheStateMap.state->tiles.empty());
 
     // Set the tile pointer to the tiles to copy
@@ -1918,45 +2335,71 @@ ImageCacheEntry::markCacheTilesAsRendered()
         assert(cache->checkTileIndex(tilesToCopy[i]->tileCache_i));
 #endif
         // update the tile indices
-        int tx = (int)std::floor((double)tilesToCopy[i]->bounds.x1 / _imp->localTilesState.tileSizeX) * _imp->localTilesState.tileSizeX;
-        int ty = (int)std::floor((double)tilesToCopy[i]->bounds.y1 / _imp->localTilesState.tileSizeY) * _imp->localTilesState.tileSizeY;
+        int tx = (int)std::floor((double)tilesToCopy[i]->bounds.x1 / localTilesState.tileSizeX) * localTilesState.tileSizeX;
+        int ty = (int)std::floor((double)tilesToCopy[i]->bounds.y1 / localTilesState.tileSizeY) * localTilesState.tileSizeY;
         TileState* cacheTileState = cacheStateMap.getTileAt(tx, ty);
         assert(allocatedTiles[i].first != (U64)-1);
         cacheTileState->channelsTileStorageIndex[tilesToCopy[i]->channel_i] = allocatedTiles[i].first;
 
-        TileState* localTileState = _imp->localTilesState.getTileAt(tx, ty);
+        TileState* localTileState = localTilesState.getTileAt(tx, ty);
         localTileState->channelsTileStorageIndex[tilesToCopy[i]->channel_i] = allocatedTiles[i].first;
     }
 
 
     // Finally copy over multiple threads each tile
     boost::scoped_ptr<CachePixelsTransferProcessorBase> processor;
-    switch (_imp->bitdepth) {
+    switch (bitdepth) {
         case eImageBitDepthByte:
-            processor.reset(new CachePixelsTransferProcessor<true /*copyToCache*/, unsigned char>(_imp->effect));
+            processor.reset(new CachePixelsTransferProcessor<true /*copyToCache*/, unsigned char>(effect));
             break;
         case eImageBitDepthShort:
-            processor.reset(new CachePixelsTransferProcessor<true /*copyToCache*/, unsigned short>(_imp->effect));
+            processor.reset(new CachePixelsTransferProcessor<true /*copyToCache*/, unsigned short>(effect));
             break;
         case eImageBitDepthFloat:
-            processor.reset(new CachePixelsTransferProcessor<true /*copyToCache*/, float>(_imp->effect));
+            processor.reset(new CachePixelsTransferProcessor<true /*copyToCache*/, float>(effect));
             break;
         default:
             break;
     }
 
-    processor->setValues(_imp.get(), tilesToCopy);
+    processor->setValues(this, tilesToCopy);
     ActionRetCodeEnum stat = processor->launchThreadsBlocking();
 
     // We never abort when copying tiles to the cache since they are anyway already rendered.
     assert(stat != eActionStatusAborted);
     (void)stat;
 
+    // Expensive tiles are shared with the other hosts through the remote tier. The tiles are copied before being unlocked.
+    if (!isDraftModeEnabled && renderCost > 0) {
+        std::vector<void*> tilesData(tilesToCopy.size());
+        for (std::size_t i = 0; i < tilesToCopy.size(); ++i) {
+            tilesData[i] = tilesToCopy[i]->ptr;
+        }
+        cache->publishRemoteTiles(internalCacheEntry, tilesAllocNeeded, tilesData, renderCost);
+    }
+
     // In persistent mode we have to actually copy the cache entry tiles state map to the cache
-    if (_imp->internalCacheEntry->isPersistent()) {
-        _imp->updateCachedTilesStateMap();
+    if (internalCacheEntry->isPersistent()) {
+        updateCachedTilesStateMap();
     }
-} // markCacheTilesAsRendered
+
+    // Expensive entries are kept longer in the cache with the eCacheEvictionPolicyCost policy
+    if (renderCost > 0) {
+        cache->addEntryCost(internalCacheEntry, renderCost);
+    }
+} // markTilesAsRendered
+
+void
+ImageCacheEntry::markCacheTilesAsRendered(double renderCost)
+{
+    _imp->markTilesAsRendered(0, 0, renderCost);
+}
+
+void
+ImageCacheEntry::markCacheTilesInRegionAsRendered(const RectI& roi)
+{
+    _imp->markTilesAsRendered(&roi, 0, 0);
+}
 
 bool
 ImageCacheEntry::waitForPendingTiles()
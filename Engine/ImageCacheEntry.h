@@ -44,6 +44,8 @@ struct ImageCacheEntryPrivate;
  * This is the object that interacts with the cache.
  * A storage is passed in parameter that is assumed to be of the size of the
  * roi and the cache data is copied to/from this storage.
+ * If the storage has the eImageBufferLayoutMonoChannelTiled layout, each tile is copied
+ * with a single memcpy.
  * Internally the cached tiles are thread safe and each tile is guaranteed to be
  * rendered by a single thread/process.
  *
@@ -89,6 +91,13 @@ public:
 
     ImageCacheKeyPtr getCacheKey() const;
 
+    /**
+     * @brief Set the keys of images of the same node rendered before it changed, most recent first, with the region
+     * in pixel coordinates at the mipmap level which changed since. In fetchCachedTilesAndUpdateStatus(), the tiles to render
+     * outside of this region are copied from these images if they are cached instead of being rendered.
+     **/
+    void setPreviousKeys(const std::vector<std::pair<ImageCacheKeyPtr, RectI> >& keys);
+
     /**
      * @brief Ensure the given RoI is tracked by the tiles state map. This function does not grow the associated storage
      * and assumes that the caller has taken care that the storage size matches the unioned roi
@@ -118,8 +127,17 @@ public:
      * This function transfers the local pixels to the cache and also updates the tiles state map in the cache.
      * This will also notify any other effect waiting for these tiles.
      * Do not call if the render was aborted otherwise non-rendered pixels will be pushed to the cache and marked as rendered.
+     * @param renderCost The time in seconds spent rendering the tiles, added to the cost of the cache entry, see CacheBase::addEntryCost
+     **/
+    void markCacheTilesAsRendered(double renderCost = 0);
+
+    /**
+     * @brief Same as markCacheTilesAsRendered() except that only the tiles entirely contained in the given RoI are
+     * published to the cache. This may be called while the rest of the RoI is still rendering, so that other renders
+     * waiting for these tiles may use them without waiting for the whole RoI.
+     * markCacheTilesAsRendered() must still be called once the render is finished.
      **/
-    void markCacheTilesAsRendered();
+    void markCacheTilesInRegionAsRendered(const RectI& roi);
 
     /**
      * @brief This function should be called if the render was aborted to mark tiles that were marked pending
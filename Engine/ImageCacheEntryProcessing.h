@@ -31,6 +31,10 @@
 #include "Engine/RectI.h"
 #include "Global/GlobalDefines.h"
 
+#ifdef __NATRON_SSE2__
+#include <emmintrin.h>
+#endif
+
 NATRON_NAMESPACE_ENTER;
 
 class ImageCacheEntryProcessing
@@ -311,6 +315,63 @@ static void repeatEdges(ImageBitDepthEnum depth,
 
 
 
+/**
+ * @brief Writes to dst the average of each 2x2 block of pixels of the rows src and srcNext, for n pixels of dst
+ **/
+template <typename PIX>
+static void halveRow(const PIX* src,
+                     const PIX* srcNext,
+                     PIX* dst,
+                     int n)
+{
+    for (int x = 0; x < n; ++x, src += 2, srcNext += 2) {
+        // The integer division truncates as does the conversion from double of the floating point version
+        dst[x] = (PIX)( ( (int)src[0] + (int)src[1] + (int)srcNext[0] + (int)srcNext[1] ) / 4 );
+    }
+}
+
+static void halveRow(const float* src,
+                     const float* srcNext,
+                     float* dst,
+                     int n)
+{
+    int x = 0;
+#ifdef __NATRON_SSE2__
+    // The sum is done in double precision, as in the scalar loop below, so that both give the same result
+    const __m128d quarter = _mm_set1_pd(0.25);
+    for (; x + 4 <= n; x += 4, src += 8, srcNext += 8) {
+        __m128 row0 = _mm_loadu_ps(src);
+        __m128 row1 = _mm_loadu_ps(src + 4);
+        __m128 nextRow0 = _mm_loadu_ps(srcNext);
+        __m128 nextRow1 = _mm_loadu_ps(srcNext + 4);
+
+        // Averaged pixels are as such:
+        // a b
+        // c d
+        __m128 a = _mm_shuffle_ps(row0, row1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 b = _mm_shuffle_ps(row0, row1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 c = _mm_shuffle_ps(nextRow0, nextRow1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 d = _mm_shuffle_ps(nextRow0, nextRow1, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128d lo = _mm_add_pd(_mm_add_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(b)), _mm_add_pd(_mm_cvtps_pd(c), _mm_cvtps_pd(d)));
+        a = _mm_movehl_ps(a, a);
+        b = _mm_movehl_ps(b, b);
+        c = _mm_movehl_ps(c, c);
+        d = _mm_movehl_ps(d, d);
+        __m128d hi = _mm_add_pd(_mm_add_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(b)), _mm_add_pd(_mm_cvtps_pd(c), _mm_cvtps_pd(d)));
+
+        _mm_storeu_ps(dst + x, _mm_movelh_ps(_mm_cvtpd_ps(_mm_mul_pd(lo, quarter)), _mm_cvtpd_ps(_mm_mul_pd(hi, quarter))));
+    }
+#endif
+    for (; x < n; ++x, src += 2, srcNext += 2) {
+        assert(src[0] == src[0] && src[1] == src[1] && srcNext[0] == srcNext[0] && srcNext[1] == srcNext[1]); // NaN check
+        double sum = (double)src[0] + (double)src[1];
+        sum += ( (double)srcNext[0] + (double)srcNext[1] );
+        sum /= 4;
+        dst[x] = (float)sum;
+    }
+} // halveRow
+
 template <typename PIX>
 static void downscaleMipMapForDepth(const PIX* srcTilesPtr[4],
                                     PIX* dstTilePtr,
@@ -360,25 +421,12 @@ static void downscaleMipMapForDepth(const PIX* srcTilesPtr[4],
             const PIX* src_pixels_next = srcTilesPtr[t_i] + tileSizeX;
 
             for (int y = 0; y < halfTileSizeY; ++y) {
-                for (int x = 0; x < halfTileSizeX; ++x) {
-                    
-                    assert(*src_pixels == *src_pixels); // NaN check
-                    assert(*(src_pixels + 1) == *(src_pixels + 1)); // NaN check
-                    assert(*(src_pixels_next) == *(src_pixels_next)); // NaN check
-                    assert(*(src_pixels_next + 1) == *(src_pixels_next + 1)); // NaN check
-
-                    double sum = (double)*src_pixels + (double)*(src_pixels + 1);
-                    sum += ((double)*src_pixels_next + (double)*(src_pixels_next + 1));
-                    sum /= 4;
-                    *dst_pixels = (PIX)sum;
-
-                    src_pixels_next += 2;
-                    src_pixels += 2;
-                    ++dst_pixels;
-                }
-                src_pixels += tileSizeX;
-                src_pixels_next += tileSizeX;
-                dst_pixels += halfTileSizeX;
+                halveRow(src_pixels, src_pixels_next, dst_pixels, halfTileSizeX);
+
+                // Skip the next source row which was already read
+                src_pixels += tileSizeX * 2;
+                src_pixels_next += tileSizeX * 2;
+                dst_pixels += tileSizeX;
             }
         }
     }
@@ -88,6 +88,12 @@ ImageCacheKey::getNodeTimeVariantHashKey() const
     return _imp->data.nodeTimeViewVariantHash;
 }
 
+U64
+ImageCacheKey::getHolderHash() const
+{
+    return _imp->data.nodeTimeViewVariantHash;
+}
+
 int
 ImageCacheKey::getUniqueID() const
 {
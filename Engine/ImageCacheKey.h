@@ -46,6 +46,8 @@ public:
 
     U64 getNodeTimeVariantHashKey() const;
 
+    virtual U64 getHolderHash() const OVERRIDE FINAL;
+
     const RenderScale& getProxyScale() const;
 
     virtual void toMemorySegment(IPCPropertyMap* properties) const OVERRIDE FINAL;
@@ -27,18 +27,28 @@
 #include <algorithm> // min, max
 #include <cassert>
 #include <stdexcept>
+#include <vector>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
 #include <boost/math/special_functions/fpclassify.hpp>
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#ifdef __NATRON_SSE2__
+#include <emmintrin.h>
 #endif
 
 #include <QtCore/QDebug>
 
 #include "Engine/AppManager.h"
+#include "Engine/HalfFloat.h"
 #include "Engine/Lut.h"
 
+// Number of scan-lines of a half image converted at once through a temporary float buffer
+#define NATRON_HALF_CONVERSION_STRIP_HEIGHT 32
+
 NATRON_NAMESPACE_ENTER;
 
 ///explicit template instantiations
@@ -133,9 +143,249 @@ lutFromColorspace(ViewerColorSpaceEnum cs)
 }
 
 ///Fast version when components are the same
-template <typename SRCPIX, int srcMaxValue, typename DSTPIX, int dstMaxValue>
+/**
+ * @brief Converts n contiguous values from SRCPIX to DSTPIX. This gives the same result as calling
+ * Image::convertPixelDepth on each value, the specializations below only process several values at once.
+ **/
+template <typename SRCPIX, typename DSTPIX>
+static void
+convertContiguousValues(const SRCPIX* src, DSTPIX* dst, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        dst[i] = Image::convertPixelDepth<SRCPIX, DSTPIX>(src[i]);
+    }
+}
+
+/**
+ * @brief Converts n pixels of a packed RGBA scan-line to 4 coplanar scan-lines.
+ **/
+template <typename PIX>
 static void
-convertToFormatInternal_sameComps(const RectI & renderWindow,
+deinterleaveRGBAValues(const PIX* src, PIX* dst[4], int n)
+{
+    for (int i = 0; i < n; ++i, src += 4) {
+        dst[0][i] = src[0];
+        dst[1][i] = src[1];
+        dst[2][i] = src[2];
+        dst[3][i] = src[3];
+    }
+}
+
+/**
+ * @brief Converts n pixels of 4 coplanar scan-lines to a packed RGBA scan-line.
+ **/
+template <typename PIX>
+static void
+interleaveRGBAValues(const PIX* src[4], PIX* dst, int n)
+{
+    for (int i = 0; i < n; ++i, dst += 4) {
+        dst[0] = src[0][i];
+        dst[1] = src[1][i];
+        dst[2] = src[2][i];
+        dst[3] = src[3][i];
+    }
+}
+
+#ifdef __NATRON_SSE2__
+
+// Same as Color::floatToInt<numvals> on 4 values
+template <int numvals>
+static inline __m128i
+floatToInt_SSE2(__m128 v)
+{
+    v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps((float)(numvals - 1))), _mm_set1_ps(0.5f)));
+}
+
+template <>
+void
+convertContiguousValues(const float* src, unsigned char* dst, int n)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_packs_epi32(floatToInt_SSE2<256>(_mm_loadu_ps(src + i)), floatToInt_SSE2<256>(_mm_loadu_ps(src + i + 4)));
+        __m128i b = _mm_packs_epi32(floatToInt_SSE2<256>(_mm_loadu_ps(src + i + 8)), floatToInt_SSE2<256>(_mm_loadu_ps(src + i + 12)));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(a, b));
+    }
+    for (; i < n; ++i) {
+        dst[i] = Image::convertPixelDepth<float, unsigned char>(src[i]);
+    }
+}
+
+template <>
+void
+convertContiguousValues(const float* src, unsigned short* dst, int n)
+{
+    // SSE2 only has a signed saturating pack: offset the values to the signed range and back
+    const __m128i offset32 = _mm_set1_epi32(32768);
+    const __m128i offset16 = _mm_set1_epi16((short)0x8000);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_sub_epi32(floatToInt_SSE2<65536>(_mm_loadu_ps(src + i)), offset32);
+        __m128i b = _mm_sub_epi32(floatToInt_SSE2<65536>(_mm_loadu_ps(src + i + 4)), offset32);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(_mm_packs_epi32(a, b), offset16));
+    }
+    for (; i < n; ++i) {
+        dst[i] = Image::convertPixelDepth<float, unsigned short>(src[i]);
+    }
+}
+
+template <>
+void
+convertContiguousValues(const unsigned char* src, float* dst, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 maxValue = _mm_set1_ps(255.f);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), maxValue));
+        _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), maxValue));
+        _mm_storeu_ps(dst + i + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), maxValue));
+        _mm_storeu_ps(dst + i + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), maxValue));
+    }
+    for (; i < n; ++i) {
+        dst[i] = Image::convertPixelDepth<unsigned char, float>(src[i]);
+    }
+}
+
+template <>
+void
+convertContiguousValues(const unsigned short* src, float* dst, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 maxValue = _mm_set1_ps(65535.f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), maxValue));
+        _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), maxValue));
+    }
+    for (; i < n; ++i) {
+        dst[i] = Image::convertPixelDepth<unsigned short, float>(src[i]);
+    }
+}
+
+template <>
+void
+deinterleaveRGBAValues(const float* src, float* dst[4], int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4, src += 16) {
+        __m128 r = _mm_loadu_ps(src);
+        __m128 g = _mm_loadu_ps(src + 4);
+        __m128 b = _mm_loadu_ps(src + 8);
+        __m128 a = _mm_loadu_ps(src + 12);
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+        _mm_storeu_ps(dst[0] + i, r);
+        _mm_storeu_ps(dst[1] + i, g);
+        _mm_storeu_ps(dst[2] + i, b);
+        _mm_storeu_ps(dst[3] + i, a);
+    }
+    for (; i < n; ++i, src += 4) {
+        dst[0][i] = src[0];
+        dst[1][i] = src[1];
+        dst[2][i] = src[2];
+        dst[3][i] = src[3];
+    }
+}
+
+template <>
+void
+interleaveRGBAValues(const float* src[4], float* dst, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4, dst += 16) {
+        __m128 p0 = _mm_loadu_ps(src[0] + i);
+        __m128 p1 = _mm_loadu_ps(src[1] + i);
+        __m128 p2 = _mm_loadu_ps(src[2] + i);
+        __m128 p3 = _mm_loadu_ps(src[3] + i);
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+        _mm_storeu_ps(dst, p0);
+        _mm_storeu_ps(dst + 4, p1);
+        _mm_storeu_ps(dst + 8, p2);
+        _mm_storeu_ps(dst + 12, p3);
+    }
+    for (; i < n; ++i, dst += 4) {
+        dst[0] = src[0][i];
+        dst[1] = src[1][i];
+        dst[2] = src[2][i];
+        dst[3] = src[3][i];
+    }
+}
+
+#endif // __NATRON_SSE2__
+
+template <>
+void
+convertContiguousValues(const HalfFloat* src, float* dst, int n)
+{
+    HalfFloat::toFloat(src, dst, n);
+}
+
+template <>
+void
+convertContiguousValues(const float* src, HalfFloat* dst, int n)
+{
+    HalfFloat::fromFloat(src, dst, n);
+}
+
+/**
+ * @brief Converts the values in roi between two buffers with the same number of components and the same layout
+ **/
+template <typename SRCPIX, typename DSTPIX>
+static void
+convertValuesInRect(const void* srcBufPtrs[4],
+                    const RectI& srcBounds,
+                    void* dstBufPtrs[4],
+                    const RectI& dstBounds,
+                    int nComps,
+                    const RectI& roi)
+{
+    // Co-planar buffers have 1 comp per buffer, otherwise a scan-line of all components is contiguous
+    const bool coplanar = nComps > 1 && srcBufPtrs[1];
+    const int nBuffers = coplanar ? nComps : 1;
+    const int nValuesPerRow = coplanar ? roi.width() : roi.width() * nComps;
+
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        SRCPIX* srcPixelPtrs[4];
+        int srcPixelStride;
+        Image::getChannelPointers<SRCPIX>((const SRCPIX**)srcBufPtrs, roi.x1, y, srcBounds, nComps, srcPixelPtrs, &srcPixelStride);
+
+        DSTPIX* dstPixelPtrs[4];
+        int dstPixelStride;
+        Image::getChannelPointers<DSTPIX>((const DSTPIX**)dstBufPtrs, roi.x1, y, dstBounds, nComps, dstPixelPtrs, &dstPixelStride);
+
+        for (int c = 0; c < nBuffers; ++c) {
+            convertContiguousValues<SRCPIX, DSTPIX>(srcPixelPtrs[c], dstPixelPtrs[c], nValuesPerRow);
+        }
+    }
+} // convertValuesInRect
+
+/**
+ * @brief A float buffer over bounds with the same layout as the given buffers
+ **/
+struct TemporaryFloatBuffer
+{
+    std::vector<float> data;
+    void* ptrs[4];
+
+    TemporaryFloatBuffer(const void* layoutBufPtrs[4], int nComps, const RectI& bounds)
+    : data( (std::size_t)bounds.area() * nComps )
+    {
+        memset(ptrs, 0, sizeof(void*) * 4);
+        if (nComps > 1 && layoutBufPtrs[1]) {
+            for (int c = 0; c < nComps; ++c) {
+                ptrs[c] = &data[(std::size_t)bounds.area() * c];
+            }
+        } else {
+            ptrs[0] = &data[0];
+        }
+    }
+};
+const RectI & renderWindow,
                                   ViewerColorSpaceEnum srcColorSpace,
                                   ViewerColorSpaceEnum dstColorSpace,
                                   const void* srcBufPtrs[4],
@@ -191,6 +441,14 @@ convertToFormatInternal_sameComps(const RectI & renderWindow,
                     // In packed RGBA mode or single channel coplanar a single call to memcpy is needed per scan-line
                     memcpy(dstPixelPtrs[0], srcPixelPtrs[0], nBytesToCopy);
                 }
+            } else if (nComp == 4 && srcPixelStride == 4 && dstPixelStride == 1 &&
+                       dstPixelPtrs[0] && dstPixelPtrs[1] && dstPixelPtrs[2] && dstPixelPtrs[3]) {
+                // Packed RGBA to coplanar RGBA
+                deinterleaveRGBAValues<SRCPIX>(srcPixelPtrs[0], (SRCPIX**)dstPixelPtrs, renderWindow.width());
+            } else if (nComp == 4 && srcPixelStride == 1 && dstPixelStride == 4 &&
+                       srcPixelPtrs[0] && srcPixelPtrs[1] && srcPixelPtrs[2] && srcPixelPtrs[3]) {
+                // Coplanar RGBA to packed RGBA
+                interleaveRGBAValues<SRCPIX>(srcPixelPtrs, (SRCPIX*)dstPixelPtrs[0], renderWindow.width());
             } else {
                 // Different strides, copy manually
                 for (int c = 0; c < 4; ++c) {
@@ -209,6 +467,38 @@ convertToFormatInternal_sameComps(const RectI & renderWindow,
             }
 
         } else {
+
+            if (!srcLut && !dstLut) {
+                // Without colorspace conversion there is no error diffusion: each value is converted independently,
+                // convert whole scan-lines at once when the layouts match
+                const SRCPIX* srcPixelPtrs[4];
+                int srcPixelStride;
+                Image::getChannelPointers<SRCPIX>((const SRCPIX**)srcBufPtrs, renderWindow.x1, y, srcBounds, nComp, (SRCPIX**)srcPixelPtrs, &srcPixelStride);
+
+                DSTPIX* dstPixelPtrs[4];
+                int dstPixelStride;
+                Image::getChannelPointers<DSTPIX>((const DSTPIX**)dstBufPtrs, renderWindow.x1, y, dstBounds, nComp, (DSTPIX**)dstPixelPtrs, &dstPixelStride);
+
+                if (srcPixelStride == dstPixelStride) {
+                    if (srcPixelStride == 1) {
+                        for (int c = 0; c < 4; ++c) {
+                            if (!dstPixelPtrs[c]) {
+                                continue;
+                            }
+                            if (srcPixelPtrs[c]) {
+                                convertContiguousValues<SRCPIX, DSTPIX>(srcPixelPtrs[c], dstPixelPtrs[c], renderWindow.width());
+                            } else {
+                                std::fill(dstPixelPtrs[c], dstPixelPtrs[c] + renderWindow.width(), DSTPIX(0));
+                            }
+                        }
+                        continue;
+                    } else if (srcPixelPtrs[0] && dstPixelPtrs[0]) {
+                        convertContiguousValues<SRCPIX, DSTPIX>(srcPixelPtrs[0], dstPixelPtrs[0], renderWindow.width() * nComp);
+                        continue;
+                    }
+                }
+            }
+
             // Start of the line for error diffusion
             // coverity[dont_call]
             int start = rand() % renderWindow.width() + renderWindow.x1;
@@ -829,6 +1119,46 @@ ImagePrivate::convertCPUImage(const RectI & renderWindow,
 {
     assert( srcBounds.contains(renderWindow) && dstBounds.contains(renderWindow) );
 
+    if (srcBitDepth == eImageBitDepthHalf || dstBitDepth == eImageBitDepthHalf) {
+        // Half images are converted to/from float by strips of scan-lines, the float images are converted by the kernels below
+        if ( renderWindow.isNull() ) {
+            return;
+        }
+        for (int y1 = renderWindow.y1; y1 < renderWindow.y2; y1 += NATRON_HALF_CONVERSION_STRIP_HEIGHT) {
+            if (renderClone && renderClone->isRenderAborted()) {
+                return;
+            }
+            const RectI strip( renderWindow.x1, y1, renderWindow.x2, std::min(y1 + NATRON_HALF_CONVERSION_STRIP_HEIGHT, renderWindow.y2) );
+
+            boost::scoped_ptr<TemporaryFloatBuffer> srcFloat;
+            const void* srcFloatPtrs[4] = {srcBufPtrs[0], srcBufPtrs[1], srcBufPtrs[2], srcBufPtrs[3]};
+            RectI srcFloatBounds = srcBounds;
+            ImageBitDepthEnum srcFloatDepth = srcBitDepth;
+            if (srcBitDepth == eImageBitDepthHalf) {
+                srcFloat.reset( new TemporaryFloatBuffer(srcBufPtrs, srcNComps, strip) );
+                convertValuesInRect<HalfFloat, float>(srcBufPtrs, srcBounds, srcFloat->ptrs, strip, srcNComps, strip);
+                for (int c = 0; c < 4; ++c) {
+                    srcFloatPtrs[c] = srcFloat->ptrs[c];
+                }
+                srcFloatBounds = strip;
+                srcFloatDepth = eImageBitDepthFloat;
+            }
+
+            if (dstBitDepth != eImageBitDepthHalf) {
+                convertCPUImage(strip, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcFloatPtrs, srcNComps, srcFloatDepth, srcFloatBounds, dstBufPtrs, dstNComps, dstBitDepth, dstBounds, renderClone);
+                continue;
+            }
+
+            // Some conversions leave channels of the destination untouched: start from the destination values
+            TemporaryFloatBuffer dstFloat( (const void**)dstBufPtrs, dstNComps, strip );
+            convertValuesInRect<HalfFloat, float>( (const void**)dstBufPtrs, dstBounds, dstFloat.ptrs, strip, dstNComps, strip );
+            convertCPUImage(strip, srcColorSpace, dstColorSpace, requiresUnpremult, conversionChannel, alphaHandling, monoConversion, srcFloatPtrs, srcNComps, srcFloatDepth, srcFloatBounds, dstFloat.ptrs, dstNComps, eImageBitDepthFloat, strip, renderClone);
+            convertValuesInRect<float, HalfFloat>( (const void**)dstFloat.ptrs, strip, dstBufPtrs, dstBounds, dstNComps, strip );
+        }
+
+        return;
+    }
+
     switch ( srcBitDepth ) {
         case eImageBitDepthByte:
             ///Same as a copy
@@ -1058,17 +1388,48 @@ convertGLTextureToRGBAPackedCPUBufferInternal(const GLImageStoragePtr& texture,
     GL::Viewport( roi.x1 - texBounds.x1, roi.y1 - texBounds.y1, roi.width(), roi.height() );
     glCheckFramebufferError(GL);
 
-    // Ensure all drawing commands are finished
-    GL::Flush();
-    GL::Finish();
+    // Read the texture into a PBO: glReadPixels then returns without waiting for the drawing commands
+    // to be finished (no glFinish() is needed) and the transfer is done by the GPU. Only mapping the
+    // PBO waits for the data to be available.
+    GLuint pboID = glContext->getOrCreatePBOId();
+    assert(pboID != 0);
+
+    GL::BindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, pboID);
+
+    const std::size_t texturePixelSize = 4 * sizeof(float);
+    const std::size_t pboRowBytes = roi.width() * texturePixelSize;
+    const std::size_t pboDataBytes = pboRowBytes * roi.height();
+
+    GL::BufferDataARB(GL_PIXEL_PACK_BUFFER_ARB, pboDataBytes, 0, GL_STREAM_READ_ARB);
+    GL::ReadPixels(roi.x1 - texBounds.x1, roi.y1 - texBounds.y1, roi.width(), roi.height(), texture->getGLTextureFormat(), texture->getGLTextureType(), 0);
     glCheckError(GL);
 
-    // Transfer the texture to the CPU buffer
+    const unsigned char* gpuData = (const unsigned char*)GL::MapBufferARB(GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB);
+    glCheckError(GL);
+    if (!gpuData) {
+        GL::BindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, 0);
+        GL::BindTexture(target, 0);
+        GL::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        throw std::bad_alloc();
+    }
+
+    // Transfer the PBO to the CPU buffer: the rows of the PBO are only of the width of the roi
     {
-        unsigned char* data = Image::pixelAtStatic(roi.x1, roi.y1, texBounds, outBuffer->getNumComponents(), getSizeOfForBitDepth(outBuffer->getBitDepth()), (unsigned char*)outBuffer->getData());
-        GL::ReadPixels(roi.x1 - texBounds.x1, roi.y1 - texBounds.y1, roi.width(), roi.height(), texture->getGLTextureFormat(), texture->getGLTextureType(), (GLvoid*)data);
+        const std::size_t dstRowBytes = outBuffer->getRowSize();
+        unsigned char* dstPixels = Image::pixelAtStatic(roi.x1, roi.y1, texBounds, outBuffer->getNumComponents(), getSizeOfForBitDepth(outBuffer->getBitDepth()), (unsigned char*)outBuffer->getData());
+        const unsigned char* srcData = gpuData;
+        for (int y = roi.y1; y < roi.y2; ++y) {
+            memcpy(dstPixels, srcData, pboRowBytes);
+            srcData += pboRowBytes;
+            dstPixels += dstRowBytes;
+        }
     }
 
+    GLboolean result = GL::UnmapBufferARB(GL_PIXEL_PACK_BUFFER_ARB); // release the mapped buffer
+    assert(result == GL_TRUE);
+    Q_UNUSED(result);
+
+    GL::BindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, 0);
     GL::BindTexture(target, 0);
     GL::BindFramebuffer(GL_FRAMEBUFFER, 0);
     glCheckError(GL);
@@ -1115,12 +1476,19 @@ public:
         _srcTileData = srcTileData;
         _dstTileData = dstTileData;
         _copyArgs = copyArgs;
+        alignRenderWindowToTiles(srcTileData.tileSizeX, srcTileData.tileSizeY);
+        alignRenderWindowToTiles(dstTileData.tileSizeX, dstTileData.tileSizeY);
     }
 
 private:
 
     virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
     {
+        // If an image is tiled, the render window is contained in a single tile of it
+        Image::CPUData srcTileData, dstTileData;
+        Image::getCPUTileData(_srcTileData, renderWindow, &srcTileData);
+        Image::getCPUTileData(_dstTileData, renderWindow, &dstTileData);
+
         // This function is very optimized and templated for most common cases
         // In the best optimized case, memcpy is used
         ImagePrivate::convertCPUImage(renderWindow,
@@ -1130,14 +1498,14 @@ private:
                                       _copyArgs.conversionChannel,
                                       _copyArgs.alphaHandling,
                                       _copyArgs.monoConversion,
-                                      (const void**)_srcTileData.ptrs,
-                                      _srcTileData.nComps,
-                                      _srcTileData.bitDepth,
-                                      _srcTileData.bounds,
-                                      (void**)_dstTileData.ptrs,
-                                      _dstTileData.nComps,
-                                      _dstTileData.bitDepth,
-                                      _dstTileData.bounds,
+                                      (const void**)srcTileData.ptrs,
+                                      srcTileData.nComps,
+                                      srcTileData.bitDepth,
+                                      srcTileData.bounds,
+                                      (void**)dstTileData.ptrs,
+                                      dstTileData.nComps,
+                                      dstTileData.bitDepth,
+                                      dstTileData.bounds,
                                       _effect);
         if (_effect && _effect->isRenderAborted()) {
             return eActionStatusAborted;
@@ -24,6 +24,8 @@
 
 #include "ImagePrivate.h"
 
+#include "Engine/HalfFloat.h"
+
 NATRON_NAMESPACE_ENTER;
 
 template <typename GL>
@@ -264,6 +266,8 @@ ImagePrivate::fillCPU(void* ptrs[4],
             fillForDepth<unsigned short, 65535>(ptrs, r, g, b, a, nComps, bounds, roi, renderClone);
             break;
         case eImageBitDepthHalf:
+            fillForDepth<HalfFloat, 1>(ptrs, r, g, b, a, nComps, bounds, roi, renderClone);
+            break;
         default:
             break;
     }
@@ -24,192 +24,96 @@
 
 #include "ImagePrivate.h"
 
-NATRON_NAMESPACE_ENTER;
+#include <cstring> // for std::memcpy
 
-template<int srcNComps, int dstNComps, typename PIX, int maxValue, bool masked, bool maskInvert>
-static void
-applyMaskMixForMaskInvert(const void* originalImgPtrs[4],
-                          const RectI& originalImgBounds,
-                          const void* maskImgPtrs[4],
-                          const RectI& maskImgBounds,
-                          void* dstImgPtrs[4],
-                          double mix,
-                          const RectI& bounds,
-                          const RectI& roi,
-                          const EffectInstancePtr& renderClone)
-{
+#include "Engine/MultiThread.h"
 
-    PIX* dstPixelPtrs[4];
-    int dstPixelStride;
-    Image::getChannelPointers<PIX, dstNComps>((const PIX**)dstImgPtrs, roi.x1, roi.y1, bounds, (PIX**)dstPixelPtrs, &dstPixelStride);
+NATRON_NAMESPACE_ENTER;
 
-    const std::size_t dstRowElements = (std::size_t)bounds.width() * dstPixelStride;
+NATRON_NAMESPACE_ANONYMOUS_ENTER
 
-    for ( int y = roi.y1; y < roi.y2; ++y) {
+struct MaskMixKernelArgs
+{
+    const void* originalImgPtrs[4];
+    RectI originalImgBounds;
+    int originalImgNComps;
+    const void* maskImgPtrs[4];
+    RectI maskImgBounds;
+    void* dstImgPtrs[4];
+    RectI dstImgBounds;
+    double mix;
+    bool invertMask;
+    EffectInstancePtr renderClone;
+};
+
+template <typename PIX, int maxValue, int dstNComps, bool dstPacked, bool masked>
+struct MaskMixKernel
+{
+    static ActionRetCodeEnum process(const MaskMixKernelArgs& args, const RectI& roi)
+    {
+        // The layout is a template parameter so that the pixel stride of the output is known at compile time
+        const int dstPixelStride = dstPacked ? dstNComps : 1;
 
-        if (renderClone && renderClone->isRenderAborted()) {
-            return;
-        }
-        for (int x = roi.x1; x < roi.x2; ++x) {
+        for (int y = roi.y1; y < roi.y2; ++y) {
 
-            PIX* srcPixelPtrs[4];
-            int srcPixelStride;
-            Image::getChannelPointers<PIX, srcNComps>((const PIX**)originalImgPtrs, roi.x1, roi.y1, originalImgBounds, (PIX**)srcPixelPtrs, &srcPixelStride);
+            if (args.renderClone && args.renderClone->isRenderAborted()) {
+                return eActionStatusAborted;
+            }
 
-            float maskScale = 1.f;
-            if (!masked) {
-                // just mix
-                float alpha = mix;
-                for (int c = 0; c < dstNComps; ++c) {
-                    if (srcPixelPtrs[c]) {
-                        float dstF = Image::convertPixelDepth<PIX, float>(*dstPixelPtrs[c]);
-                        float srcF = Image::convertPixelDepth<PIX, float>(*srcPixelPtrs[c]);
-                        float v = dstF * alpha + (1.f - alpha) * srcF;
-                        *dstPixelPtrs[c] = Image::convertPixelDepth<float, PIX>(v);
+            PIX* dstPixelPtrs[4];
+            int dstStride;
+            Image::getChannelPointers<PIX, dstNComps>((const PIX**)args.dstImgPtrs, roi.x1, y, args.dstImgBounds, (PIX**)dstPixelPtrs, &dstStride);
+            assert(dstStride == dstPixelStride);
 
-                        dstPixelPtrs[c] += dstPixelStride;
-                        srcPixelPtrs[c] += srcPixelStride;
-                    }
-                }
-            } else {
+            // Channels that are not in the original image are left untouched
+            const PIX* srcPixelPtrs[4];
+            int srcPixelStride;
+            Image::getChannelPointers<PIX>((const PIX**)args.originalImgPtrs, roi.x1, y, args.originalImgBounds, args.originalImgNComps, (PIX**)srcPixelPtrs, &srcPixelStride);
 
+            const PIX* maskPixelPtr = 0;
+            if (masked) {
                 PIX* maskPixelPtrs[4];
                 int maskPixelStride;
-                Image::getChannelPointers<PIX, 1>((const PIX**)maskImgPtrs, roi.x1, roi.y1, maskImgBounds, (PIX**)maskPixelPtrs, &maskPixelStride);
-
-                // figure the scale factor from that pixel
-                if (maskPixelPtrs[0] == 0) {
-                    maskScale = maskInvert ? 1.f : 0.f;
-                } else {
-                    maskScale = *maskPixelPtrs[0] / float(maxValue);
-                    if (maskInvert) {
-                        maskScale = 1.f - maskScale;
+                Image::getChannelPointers<PIX, 1>((const PIX**)args.maskImgPtrs, roi.x1, y, args.maskImgBounds, (PIX**)maskPixelPtrs, &maskPixelStride);
+                maskPixelPtr = maskPixelPtrs[0];
+            }
+
+            for (int x = roi.x1; x < roi.x2; ++x) {
+
+                float alpha = args.mix;
+                if (masked) {
+                    // figure the scale factor from that pixel
+                    float maskScale;
+                    if (!maskPixelPtr) {
+                        maskScale = args.invertMask ? 1.f : 0.f;
+                    } else {
+                        maskScale = *maskPixelPtr / float(maxValue);
+                        if (args.invertMask) {
+                            maskScale = 1.f - maskScale;
+                        }
+                        ++maskPixelPtr;
                     }
+                    alpha *= maskScale;
                 }
-                float alpha = mix * maskScale;
                 for (int c = 0; c < dstNComps; ++c) {
                     if (srcPixelPtrs[c]) {
                         float dstF = Image::convertPixelDepth<PIX, float>(*dstPixelPtrs[c]);
                         float srcF = Image::convertPixelDepth<PIX, float>(*srcPixelPtrs[c]);
                         float v = dstF * alpha + (1.f - alpha) * srcF;
                         *dstPixelPtrs[c] = Image::convertPixelDepth<float, PIX>(v);
-
-                        dstPixelPtrs[c] += dstPixelStride;
                         srcPixelPtrs[c] += srcPixelStride;
-                        maskPixelPtrs[c] += maskPixelStride;
                     }
+                    dstPixelPtrs[c] += dstPixelStride;
                 }
-            }
-        }
-        for (int c = 0; c < dstNComps; ++c) {
-            dstPixelPtrs[c] += (dstRowElements - roi.width() * dstPixelStride);
-        }
-    }
-} // applyMaskMixForMaskInvert
-
-template<int srcNComps, int dstNComps, typename PIX, int maxValue, bool masked>
-static void
-applyMaskMixForMasked(const void* originalImgPtrs[4],
-                      const RectI& originalImgBounds,
-                      const void* maskImgPtrs[4],
-                      const RectI& maskImgBounds,
-                      void* dstImgPtrs[4],
-                      double mix,
-                      bool invertMask,
-                      const RectI& bounds,
-                      const RectI& roi,
-                      const EffectInstancePtr& renderClone)
-{
-    if (invertMask) {
-        applyMaskMixForMaskInvert<srcNComps, dstNComps, PIX, maxValue, masked, true>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, bounds, roi, renderClone);
-    } else {
-        applyMaskMixForMaskInvert<srcNComps, dstNComps, PIX, maxValue, masked, false>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, bounds, roi, renderClone);
-    }
-}
-
-template<int srcNComps, int dstNComps, typename PIX, int maxValue>
-static void
-applyMaskMixForDepth(const void* originalImgPtrs[4],
-                     const RectI& originalImgBounds,
-                     const void* maskImgPtrs[4],
-                     const RectI& maskImgBounds,
-                     void* dstImgPtrs[4],
-                     double mix,
-                     bool invertMask,
-                     const RectI& bounds,
-                     const RectI& roi,
-                     const EffectInstancePtr& renderClone)
-{
-    if (maskImgPtrs[0]) {
-        applyMaskMixForMasked<srcNComps, dstNComps, PIX, maxValue, true>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderClone);
-    } else {
-        applyMaskMixForMasked<srcNComps, dstNComps, PIX, maxValue, false>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderClone);
-    }
-}
+            } // for each pixel
+        } // for each scan-line
+        return eActionStatusOK;
+    } // process
+};
 
-template <int srcNComps, int dstNComps>
-static void
-applyMaskMixForDstComponents(const void* originalImgPtrs[4],
-                             const RectI& originalImgBounds,
-                             const void* maskImgPtrs[4],
-                             const RectI& maskImgBounds,
-                             void* dstImgPtrs[4],
-                             ImageBitDepthEnum dstImgBitDepth,
-                             double mix,
-                             bool invertMask,
-                             const RectI& bounds,
-                             const RectI& roi,
-                             const EffectInstancePtr& renderClone)
-{
-    switch (dstImgBitDepth) {
-        case eImageBitDepthByte:
-            applyMaskMixForDepth<srcNComps, dstNComps, unsigned char, 255>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderClone);
-            break;
-        case eImageBitDepthShort:
-            applyMaskMixForDepth<srcNComps, dstNComps, unsigned short, 65535>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderClone);
-            break;
-        case eImageBitDepthFloat:
-            applyMaskMixForDepth<srcNComps, dstNComps, float, 1>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, mix, invertMask, bounds, roi, renderClone);
-            break;
-        default:
-            assert(false);
-            break;
-    }
-}
+typedef ImageKernelTable<MaskMixKernelArgs, MaskMixKernel> MaskMixKernelTable;
 
-template<int srcNComps>
-static void
-applyMaskMixForSrcComponents(const void* originalImgPtrs[4],
-                             const RectI& originalImgBounds,
-                             const void* maskImgPtrs[4],
-                             const RectI& maskImgBounds,
-                             void* dstImgPtrs[4],
-                             ImageBitDepthEnum dstImgBitDepth,
-                             int dstImgNComps,
-                             double mix,
-                             bool invertMask,
-                             const RectI& bounds,
-                             const RectI& roi,
-                             const EffectInstancePtr& renderClone)
-{
-
-    switch (dstImgNComps) {
-        case 1:
-            applyMaskMixForDstComponents<srcNComps, 1>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, mix, invertMask, bounds, roi, renderClone);
-            break;
-        case 2:
-            applyMaskMixForDstComponents<srcNComps, 2>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, mix, invertMask, bounds, roi, renderClone);
-            break;
-        case 3:
-            applyMaskMixForDstComponents<srcNComps, 3>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, mix, invertMask, bounds, roi, renderClone);
-            break;
-        case 4:
-            applyMaskMixForDstComponents<srcNComps, 4>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, mix, invertMask, bounds, roi, renderClone);
-            break;
-        default:
-            break;
-    }
-}
+NATRON_NAMESPACE_ANONYMOUS_EXIT
 
 void
 ImagePrivate::applyMaskMixCPU(const void* originalImgPtrs[4],
@@ -226,24 +130,25 @@ ImagePrivate::applyMaskMixCPU(const void* originalImgPtrs[4],
                               const RectI& roi,
                               const EffectInstancePtr& renderClone)
 {
-    switch (originalImgNComps) {
-        case 1:
-            applyMaskMixForSrcComponents<1>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, dstImgNComps, mix, invertMask, bounds, roi, renderClone);
-            break;
-        case 2:
-            applyMaskMixForSrcComponents<2>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, dstImgNComps, mix, invertMask, bounds, roi, renderClone);
-            break;
-        case 3:
-            applyMaskMixForSrcComponents<3>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, dstImgNComps, mix, invertMask, bounds, roi, renderClone);
-            break;
-        case 4:
-            applyMaskMixForSrcComponents<4>(originalImgPtrs, originalImgBounds, maskImgPtrs, maskImgBounds, dstImgPtrs, dstImgBitDepth, dstImgNComps, mix, invertMask, bounds, roi, renderClone);
-            break;
-        default:
-            break;
+    MaskMixKernelTable::KernelFunction kernel = MaskMixKernelTable::getKernel(dstImgBitDepth, dstImgNComps, MaskMixKernelTable::isPackedLayout(dstImgPtrs, dstImgNComps), maskImgPtrs[0] != 0);
+    assert(kernel);
+    if (!kernel) {
+        return;
     }
 
-}
+    MaskMixKernelArgs args;
+    memcpy(args.originalImgPtrs, originalImgPtrs, sizeof(void*) * 4);
+    args.originalImgBounds = originalImgBounds;
+    args.originalImgNComps = originalImgNComps;
+    memcpy(args.maskImgPtrs, maskImgPtrs, sizeof(void*) * 4);
+    args.maskImgBounds = maskImgBounds;
+    memcpy(args.dstImgPtrs, dstImgPtrs, sizeof(void*) * 4);
+    args.dstImgBounds = bounds;
+    args.mix = mix;
+    args.invertMask = invertMask;
+    args.renderClone = renderClone;
+    kernel(args, roi);
+} // applyMaskMixCPU
 
 template <typename GL>
 void applyMaskMixGLInternal(const GLImageStoragePtr& originalTexture,
@@ -251,10 +156,17 @@ void applyMaskMixGLInternal(const GLImageStoragePtr& originalTexture,
                             const GLImageStoragePtr& dstTexture,
                             double mix,
                             bool maskInvert,
+                            const std::bitset<4>* processChannels,
                             const RectI& roi,
                             const OSGLContextPtr& glContext)
 {
-    GLShaderBasePtr shader = glContext->getOrCreateMaskMixShader(maskTexture.get() != 0, maskInvert);
+    // If processChannels is set, the channels that are not processed are also copied from the original texture
+    GLShaderBasePtr shader;
+    if (processChannels) {
+        shader = glContext->getOrCreateMaskMixCopyUnprocessedChannelsShader(maskTexture.get() != 0, maskInvert, (*processChannels)[0], (*processChannels)[1], (*processChannels)[2], (*processChannels)[3]);
+    } else {
+        shader = glContext->getOrCreateMaskMixShader(maskTexture.get() != 0, maskInvert);
+    }
     assert(shader);
     GLuint fboID = glContext->getOrCreateFBOId();
 
@@ -338,9 +250,37 @@ ImagePrivate::applyMaskMixGL(const GLImageStoragePtr& originalTexture,
         contextAttacher->attach();
 
         if (context->isGPUContext()) {
-            applyMaskMixGLInternal<GL_GPU>(originalTexture, maskTexture, dstTexture, mix, invertMask, roi, context);
+            applyMaskMixGLInternal<GL_GPU>(originalTexture, maskTexture, dstTexture, mix, invertMask, 0, roi, context);
+        } else {
+            applyMaskMixGLInternal<GL_CPU>(originalTexture, maskTexture, dstTexture, mix, invertMask, 0, roi, context);
+        }
+    }
+}
+
+void
+ImagePrivate::applyMaskMixCopyUnprocessedChannelsGL(const GLImageStoragePtr& originalTexture,
+                                                    const GLImageStoragePtr& maskTexture,
+                                                    const GLImageStoragePtr& dstTexture,
+                                                    double mix,
+                                                    bool invertMask,
+                                                    const std::bitset<4> processChannels,
+                                                    const RectI& roi)
+{
+    OSGLContextPtr context = dstTexture->getOpenGLContext();
+    assert(context);
+
+    // Save the current context
+    OSGLContextSaver saveCurrentContext;
+
+    {
+        // Ensure this context is attached
+        OSGLContextAttacherPtr contextAttacher = OSGLContextAttacher::create(context);
+        contextAttacher->attach();
+
+        if (context->isGPUContext()) {
+            applyMaskMixGLInternal<GL_GPU>(originalTexture, maskTexture, dstTexture, mix, invertMask, &processChannels, roi, context);
         } else {
-            applyMaskMixGLInternal<GL_CPU>(originalTexture, maskTexture, dstTexture, mix, invertMask, roi, context);
+            applyMaskMixGLInternal<GL_CPU>(originalTexture, maskTexture, dstTexture, mix, invertMask, &processChannels, roi, context);
         }
     }
 }
@@ -27,9 +27,12 @@
 #include <ofxNatron.h>
 
 #include <cassert>
+#include <map>
 #include <sstream>
 #include <stdexcept>
 
+#include <QtCore/QReadWriteLock>
+
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
@@ -47,9 +50,65 @@ static const char* motionComps[2] = {"U", "V"};
 static const char* disparityComps[2] = {"X", "Y"};
 static const char* xyComps[2] = {"X", "Y"};
 
+// The index of kNatronColorPlaneID, it is interned first
+#define NATRON_COLOR_PLANE_INDEX 0
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief The global registry of plane IDs and of the planes already decoded from an OpenFX string.
+ * Plane IDs are never removed: there are as many as different layers seen in the session.
+ **/
+struct ImagePlaneRegistry
+{
+    // Protects all data below
+    QReadWriteLock lock;
+
+    std::map<std::string, int> planeIndices;
+
+    // The planes decoded by ofxCustomCompToNatronComp, by OpenFX string
+    std::map<std::string, ImagePlaneDesc> ofxCustomPlanes;
+
+    ImagePlaneRegistry()
+    : lock()
+    , planeIndices()
+    , ofxCustomPlanes()
+    {
+        planeIndices[kNatronColorPlaneID] = NATRON_COLOR_PLANE_INDEX;
+    }
+};
+
+ImagePlaneRegistry&
+getImagePlaneRegistry()
+{
+    static ImagePlaneRegistry registry;
+
+    return registry;
+}
+
+int
+internPlaneID(const std::string& planeID)
+{
+    ImagePlaneRegistry& registry = getImagePlaneRegistry();
+    {
+        QReadLocker k(&registry.lock);
+        std::map<std::string, int>::const_iterator found = registry.planeIndices.find(planeID);
+        if ( found != registry.planeIndices.end() ) {
+            return found->second;
+        }
+    }
+    QWriteLocker k(&registry.lock);
+    std::pair<std::map<std::string, int>::iterator, bool> ret = registry.planeIndices.insert( std::make_pair( planeID, (int)registry.planeIndices.size() ) );
+
+    return ret.first->second;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 
 ImagePlaneDesc::ImagePlaneDesc()
-    : _planeID("none")
+    : _planeIndex( internPlaneID("none") )
+    , _planeID("none")
 
     , _planeLabel("none")
     , _channels()
@@ -62,7 +121,8 @@ ImagePlaneDesc::ImagePlaneDesc(const std::string& planeID,
                                const std::string& planeLabel,
                                const std::string& channelsLabel,
                                const std::vector<std::string>& channels)
-: _planeID(planeID)
+: _planeIndex( internPlaneID(planeID) )
+, _planeID(planeID)
 , _planeLabel(planeLabel)
 , _channels(channels)
 , _channelsLabel(channelsLabel)
@@ -84,7 +144,8 @@ ImagePlaneDesc::ImagePlaneDesc(const std::string& planeName,
                                const std::string& channelsLabel,
                                const char** channels,
                                int count)
-: _planeID(planeName)
+: _planeIndex( internPlaneID(planeName) )
+, _planeID(planeName)
 , _planeLabel(planeLabel)
 , _channels()
 , _channelsLabel(channelsLabel)
@@ -114,6 +175,7 @@ ImagePlaneDesc::ImagePlaneDesc(const ImagePlaneDesc& other)
 ImagePlaneDesc&
 ImagePlaneDesc::operator=(const ImagePlaneDesc& other)
 {
+    _planeIndex = other._planeIndex;
     _planeID = other._planeID;
     _planeLabel = other._planeLabel;
     _channels = other._channels;
@@ -134,24 +196,7 @@ ImagePlaneDesc::isColorPlane(const std::string& planeID)
 bool
 ImagePlaneDesc::isColorPlane() const
 {
-    return ImagePlaneDesc::isColorPlane(_planeID);
-}
-
-
-
-bool
-ImagePlaneDesc::operator==(const ImagePlaneDesc& other) const
-{
-    if ( _channels.size() != other._channels.size() ) {
-        return false;
-    }
-    return _planeID == other._planeID;
-}
-
-bool
-ImagePlaneDesc::operator<(const ImagePlaneDesc& other) const
-{
-    return _planeID < other._planeID;
+    return _planeIndex == NATRON_COLOR_PLANE_INDEX;
 }
 
 int
@@ -278,6 +323,7 @@ ImagePlaneDesc::fromSerialization(const SERIALIZATION_NAMESPACE::SerializationOb
     if (!s) {
         return;
     }
+    _planeIndex = internPlaneID(s->planeID);
     _planeID = s->planeID;
     _planeLabel = s->planeLabel;
     _channelsLabel = s->channelsLabel;
@@ -443,12 +489,27 @@ extractOFXEncodedCustomPlane(const std::string& comp, std::string* layerName, st
 static ImagePlaneDesc
 ofxCustomCompToNatronComp(const std::string& comp)
 {
+    // Plug-ins query the same planes over and over for each clip, do not decode them each time
+    ImagePlaneRegistry& registry = getImagePlaneRegistry();
+    {
+        QReadLocker k(&registry.lock);
+        std::map<std::string, ImagePlaneDesc>::const_iterator found = registry.ofxCustomPlanes.find(comp);
+        if ( found != registry.ofxCustomPlanes.end() ) {
+            return found->second;
+        }
+    }
+
     std::string planeID, planeLabel, channelsLabel;
     std::vector<std::string> channels;
     if (!extractOFXEncodedCustomPlane(comp, &planeID, &planeLabel, &channelsLabel, &channels)) {
         return ImagePlaneDesc::getNoneComponents();
     }
-    return ImagePlaneDesc(planeID, planeLabel, channelsLabel, channels);
+    ImagePlaneDesc plane(planeID, planeLabel, channelsLabel, channels);
+
+    QWriteLocker k(&registry.lock);
+    registry.ofxCustomPlanes.insert( std::make_pair(comp, plane) );
+
+    return plane;
 }
 
 ImagePlaneDesc
@@ -70,6 +70,9 @@ NATRON_NAMESPACE_ENTER;
  * If empty, the channels label is set to the concatenation of all channels.
  * The channels are the unique identifier for each channel composing the plane.
  * The plane can only be composed from 1 to 4 (included) channels.
+ *
+ * The planeID is interned in a global registry when the plane is created: comparing planes and using them as keys in
+ * a std::map only compares integers. The strings are only used for display and serialization.
  **/
 class ImagePlaneDesc : public SERIALIZATION_NAMESPACE::SerializableObjectBase
 {
@@ -129,16 +132,30 @@ public:
      **/
     const std::string& getChannelsLabel() const;
 
+    /**
+     * @brief Returns true if this plane has the same planeID as the other plane, regardless of their channels.
+     * This is the same as getPlaneID() == other.getPlaneID() but only compares the interned indices.
+     **/
+    bool isSamePlane(const ImagePlaneDesc& other) const
+    {
+        return _planeIndex == other._planeIndex;
+    }
 
-    bool operator==(const ImagePlaneDesc& other) const;
+    bool operator==(const ImagePlaneDesc& other) const
+    {
+        return _planeIndex == other._planeIndex && _channels.size() == other._channels.size();
+    }
 
     bool operator!=(const ImagePlaneDesc& other) const
     {
         return !(*this == other);
     }
 
-    // For std::map
-    bool operator<(const ImagePlaneDesc& other) const;
+    // For std::map. Planes are ordered by the order in which their planeID was first interned, the color plane is first.
+    bool operator<(const ImagePlaneDesc& other) const
+    {
+        return _planeIndex < other._planeIndex;
+    }
 
     operator bool() const
     {
@@ -250,6 +267,9 @@ public:
 
 
 private:
+
+    // The index of _planeID in the global registry of plane IDs
+    int _planeIndex;
     std::string _planeID, _planeLabel;
     std::vector<std::string> _channels;
     std::string _channelsLabel;
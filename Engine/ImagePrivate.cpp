@@ -25,11 +25,17 @@
 
 #include "ImagePrivate.h"
 
+#include "Engine/AppInstance.h"
 #include "Engine/Hash64.h"
+#include "Engine/MemoryAccount.h"
 #include "Engine/Node.h"
 #include <QDebug>
 #include <QThread>
 
+#ifdef __NATRON_SSE2__
+#include <emmintrin.h>
+#endif
+
 NATRON_NAMESPACE_ENTER;
 
 void
@@ -38,12 +44,16 @@ ImagePrivate::getCPUDataInternal(const RectI& bounds,
                                  const ImageStorageBasePtr storage[4],
                                  ImageBitDepthEnum depth,
                                  ImageBufferLayoutEnum format,
+                                 int tileSizeX,
+                                 int tileSizeY,
                                  Image::CPUData* data)
 {
     memset(data->ptrs, 0, sizeof(void*) * 4);
     data->bounds = bounds;
     data->bitDepth = depth;
     data->nComps = nComps;
+    data->tileSizeX = 0;
+    data->tileSizeY = 0;
 
 
     switch (format) {
@@ -59,6 +69,16 @@ ImagePrivate::getCPUDataInternal(const RectI& bounds,
                 data->ptrs[i] = fromIsRAMBuffer->getData();
             }
             break;
+        case eImageBufferLayoutMonoChannelTiled:
+            assert(tileSizeX > 0 && tileSizeY > 0);
+            for (int i = 0; i < data->nComps; ++i) {
+                RAMImageStoragePtr fromIsRAMBuffer = toRAMImageStorage(storage[i]);
+                assert(fromIsRAMBuffer);
+                data->ptrs[i] = fromIsRAMBuffer->getData();
+            }
+            data->tileSizeX = tileSizeX;
+            data->tileSizeY = tileSizeY;
+            break;
         case eImageBufferLayoutRGBACoplanarFullRect: {
             RAMImageStoragePtr fromIsRAMBuffer = toRAMImageStorage(storage[0]);
             assert(fromIsRAMBuffer);
@@ -88,7 +108,8 @@ ImagePrivate::initAndFetchFromCache(const Image::InitStorageArgs& args)
     // A mono channel image should have one per channel
     std::vector<int> channelIndices;
     switch (bufferFormat) {
-        case eImageBufferLayoutMonoChannelFullRect: {
+        case eImageBufferLayoutMonoChannelFullRect:
+        case eImageBufferLayoutMonoChannelTiled: {
 
             for (int nc = 0; nc < plane.getNumComponents(); ++nc) {
                 channelIndices.push_back(nc);
@@ -103,14 +124,29 @@ ImagePrivate::initAndFetchFromCache(const Image::InitStorageArgs& args)
 
     EffectInstancePtr effect = renderClone.lock();
     std::string pluginID;
+    std::string projectQuotaGroup, nodeQuotaGroup;
+    bool isViewerOutput = false;
     if (effect) {
         // If the effect is aborted, do not even bother fetching all tiles
         if (effect->isRenderAborted()) {
             return eActionStatusAborted;
         }
-        pluginID = effect->getNode()->getPluginID();
+        NodePtr node = effect->getNode();
+        pluginID = node->getPluginID();
+
+        // Account the image to the quota groups of its project and node in the cache
+        AppInstancePtr app = node->getApp();
+        if (app) {
+            projectQuotaGroup = app->getAppIDString();
+            nodeQuotaGroup = projectQuotaGroup + "." + node->getFullyQualifiedName();
+        }
+        isViewerOutput = (bool)node->isEffectViewerInstance();
     }
 
+    // Attribute the buffers to the node and the render
+    std::vector<MemoryAccountPtr> memoryAccounts;
+    MemoryAccount::getEffectAccounts(effect, &memoryAccounts);
+
 
     // Create storage for each channels
     try {
@@ -134,6 +170,10 @@ ImagePrivate::initAndFetchFromCache(const Image::InitStorageArgs& args)
                     boost::shared_ptr<RAMAllocateMemoryArgs> a(new RAMAllocateMemoryArgs());
                     a->bitDepth = bitdepth;
                     a->bounds = originalBounds;
+                    if (bufferFormat == eImageBufferLayoutMonoChannelTiled) {
+                        // The tiles cover the bounds rounded to the tile size
+                        a->bounds.roundToTileSize(tileSizeX, tileSizeY);
+                    }
 
                     if (channelIndices[c] == -1) {
                         a->numComponents = (std::size_t)plane.getNumComponents();
@@ -142,11 +182,14 @@ ImagePrivate::initAndFetchFromCache(const Image::InitStorageArgs& args)
                     }
                     allocArgs = a;
                 }   break;
+                case eStorageModeCudaBuffer:
                 case eStorageModeNone:
                     return eActionStatusFailed;
             }
             assert(allocArgs && channels[c]);
 
+            channels[c]->setMemoryAccounts(memoryAccounts, storage == eStorageModeGLTex ? eMemoryAccountTypeImageGL : eMemoryAccountTypeImageRAM);
+
             if (tilesAllocated) {
                 // Allocate the memory for the tile.
                 // This may throw a std::bad_alloc
@@ -170,7 +213,7 @@ ImagePrivate::initAndFetchFromCache(const Image::InitStorageArgs& args)
     U64 layerID;
     {
         Hash64 hash;
-        Hash64::appendQString(QString::fromUtf8(planeID.c_str()), &hash);
+        Hash64::appendString(planeID, &hash);
         hash.computeHash();
         layerID = hash.value();
     }
@@ -179,6 +222,7 @@ ImagePrivate::initAndFetchFromCache(const Image::InitStorageArgs& args)
                                            layerID,
                                            args.proxyScale,
                                            pluginID));
+    key->setQuotaGroups(projectQuotaGroup, nodeQuotaGroup, isViewerOutput);
 
 
     cacheEntry.reset(new ImageCacheEntry(_publicInterface->shared_from_this(),
@@ -194,6 +238,19 @@ ImagePrivate::initAndFetchFromCache(const Image::InitStorageArgs& args)
                                          key,
                                          cachePolicy));
 
+    if ( (cachePolicy == eCacheAccessModeReadWrite) && !args.previousTimeViewVariantHashes.empty() ) {
+        std::vector<std::pair<ImageCacheKeyPtr, RectI> > previousKeys;
+        for (std::size_t i = 0; i < args.previousTimeViewVariantHashes.size(); ++i) {
+            ImageCacheKeyPtr previousKey(new ImageCacheKey(args.previousTimeViewVariantHashes[i].first,
+                                                           layerID,
+                                                           args.proxyScale,
+                                                           pluginID));
+            previousKey->setQuotaGroups(projectQuotaGroup, nodeQuotaGroup, isViewerOutput);
+            previousKeys.push_back( std::make_pair(previousKey, args.previousTimeViewVariantHashes[i].second) );
+        }
+        cacheEntry->setPreviousKeys(previousKeys);
+    }
+
     return eActionStatusOK;
 } // initTileAndFetchFromCache
 
@@ -204,6 +261,11 @@ ImagePrivate::initFromExternalBuffer(const Image::InitStorageArgs& args)
 {
     assert(args.externalBuffer);
 
+    // An external buffer is a single buffer with all channels
+    if (args.bufferFormat == eImageBufferLayoutMonoChannelTiled) {
+        return eActionStatusFailed;
+    }
+
     if (args.bitdepth != args.externalBuffer->getBitDepth()) {
         assert(false);
         // When providing an external buffer, the bitdepth must be the same as the requested depth
@@ -330,12 +392,14 @@ halveImageForInternal(const void* srcPtrs[4],
                       const RectI& srcBounds,
                       void* dstPtrs[4],
                       const RectI& dstBounds,
+                      const RectI& dstRows,
                       const EffectInstancePtr& renderClone)
 {
+    assert(dstRows.x1 == dstBounds.x1 && dstRows.x2 == dstBounds.x2 && dstBounds.y1 <= dstRows.y1 && dstRows.y2 <= dstBounds.y2);
 
     PIX* dstPixelPtrs[4];
     int dstPixelStride;
-    Image::getChannelPointers<PIX, nComps>((const PIX**)dstPtrs, dstBounds.x1, dstBounds.y1, dstBounds, (PIX**)dstPixelPtrs, &dstPixelStride);
+    Image::getChannelPointers<PIX, nComps>((const PIX**)dstPtrs, dstBounds.x1, dstRows.y1, dstBounds, (PIX**)dstPixelPtrs, &dstPixelStride);
 
     const PIX* srcPixelPtrs[4];
     int srcPixelStride;
@@ -344,8 +408,12 @@ halveImageForInternal(const void* srcPtrs[4],
     const int dstRowElementsCount = dstBounds.width() * dstPixelStride;
     const int srcRowElementsCount = srcBounds.width() * srcPixelStride;
 
+    // Each row of the destination covers 2 rows of the source
+    for (int k = 0; k < nComps; ++k) {
+        srcPixelPtrs[k] += (dstRows.y1 - dstBounds.y1) * srcRowElementsCount * 2;
+    }
 
-    for (int y = dstBounds.y1; y < dstBounds.y2; ++y) {
+    for (int y = dstRows.y1; y < dstRows.y2; ++y) {
 
         if (renderClone && renderClone->isRenderAborted()) {
             return eActionStatusAborted;
@@ -415,17 +483,18 @@ halveImageForDepth(const void* srcPtrs[4],
                    const RectI& srcBounds,
                    void* dstPtrs[4],
                    const RectI& dstBounds,
+                   const RectI& dstRows,
                    const EffectInstancePtr& renderClone)
 {
     switch (nComps) {
         case 1:
-            return halveImageForInternal<PIX, maxValue, 1>(srcPtrs, srcBounds, dstPtrs, dstBounds, renderClone);
+            return halveImageForInternal<PIX, maxValue, 1>(srcPtrs, srcBounds, dstPtrs, dstBounds, dstRows, renderClone);
         case 2:
-            return halveImageForInternal<PIX, maxValue, 2>(srcPtrs, srcBounds, dstPtrs, dstBounds, renderClone);
+            return halveImageForInternal<PIX, maxValue, 2>(srcPtrs, srcBounds, dstPtrs, dstBounds, dstRows, renderClone);
         case 3:
-            return halveImageForInternal<PIX, maxValue, 3>(srcPtrs, srcBounds, dstPtrs, dstBounds, renderClone);
+            return halveImageForInternal<PIX, maxValue, 3>(srcPtrs, srcBounds, dstPtrs, dstBounds, dstRows, renderClone);
         case 4:
-            return halveImageForInternal<PIX, maxValue, 4>(srcPtrs, srcBounds, dstPtrs, dstBounds, renderClone);
+            return halveImageForInternal<PIX, maxValue, 4>(srcPtrs, srcBounds, dstPtrs, dstBounds, dstRows, renderClone);
         default:
         return eActionStatusFailed;
     }
@@ -439,15 +508,16 @@ ImagePrivate::halveImage(const void* srcPtrs[4],
                          const RectI& srcBounds,
                          void* dstPtrs[4],
                          const RectI& dstBounds,
+                         const RectI& dstRows,
                          const EffectInstancePtr& renderClone)
 {
     switch ( bitDepth ) {
         case eImageBitDepthByte:
-            return halveImageForDepth<unsigned char, 255>(srcPtrs, nComps, srcBounds, dstPtrs, dstBounds, renderClone);
+            return halveImageForDepth<unsigned char, 255>(srcPtrs, nComps, srcBounds, dstPtrs, dstBounds, dstRows, renderClone);
         case eImageBitDepthShort:
-            return halveImageForDepth<unsigned short, 65535>(srcPtrs, nComps, srcBounds, dstPtrs, dstBounds, renderClone);
+            return halveImageForDepth<unsigned short, 65535>(srcPtrs, nComps, srcBounds, dstPtrs, dstBounds, dstRows, renderClone);
         case eImageBitDepthFloat:
-            return halveImageForDepth<float, 1>(srcPtrs, nComps, srcBounds, dstPtrs, dstBounds, renderClone);
+            return halveImageForDepth<float, 1>(srcPtrs, nComps, srcBounds, dstPtrs, dstBounds, dstRows, renderClone);
             break;
         default:
         return eActionStatusFailed;
@@ -455,8 +525,68 @@ ImagePrivate::halveImage(const void* srcPtrs[4],
 } // halveImage
 
 
+/**
+ * @brief Replaces the NaNs in the n contiguous values by 1 and returns how many were replaced.
+ * Integer values never hold NaNs.
+ **/
+template <typename PIX>
+static std::size_t
+replaceNaNs(PIX* /*values*/,
+            int /*n*/)
+{
+    return 0;
+}
+
+static std::size_t
+replaceNaNs(float* values,
+            int n)
+{
+    std::size_t nReplaced = 0;
+    int i = 0;
+#ifdef __NATRON_SSE2__
+    const __m128 one = _mm_set1_ps(1.f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(values + i);
+        // Only NaNs compare unordered with themselves
+        __m128 isNaN = _mm_cmpunord_ps(v, v);
+        int mask = _mm_movemask_ps(isNaN);
+        if (mask) {
+            // Images rarely contain NaNs: only write back the vectors that had some
+            v = _mm_or_ps( _mm_and_ps(isNaN, one), _mm_andnot_ps(isNaN, v) );
+            _mm_storeu_ps(values + i, v);
+            nReplaced += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        // we remove NaNs, but infinity values should pose no problem
+        // (if they do, please explain here which ones)
+        if (values[i] != values[i]) { // check for NaN
+            values[i] = 1.f;
+            ++nReplaced;
+        }
+    }
+    return nReplaced;
+} // replaceNaNs
+
+static std::size_t
+replaceNaNs(HalfFloat* values,
+            int n)
+{
+    // Replace NaNs by 1, as for float images
+    const unsigned short one = HalfFloat::fromFloat(1.f);
+    std::size_t nReplaced = 0;
+    for (int i = 0; i < n; ++i) {
+        if ( (values[i].bits & 0x7fff) > 0x7c00 ) {
+            values[i].bits = one;
+            ++nReplaced;
+        }
+    }
+    return nReplaced;
+}
+
 template <typename PIX, int maxValue, int nComps>
-bool
+std::size_t
 checkForNaNsInternal(void* ptrs[4],
                      const RectI& bounds,
                      const RectI& roi)
@@ -467,30 +597,25 @@ checkForNaNsInternal(void* ptrs[4],
     Image::getChannelPointers<PIX, nComps>((const PIX**)ptrs, roi.x1, roi.y1, bounds, (PIX**)dstPixelPtrs, &dstPixelStride);
     const int rowElementsCount = bounds.width() * dstPixelStride;
 
-    bool hasnan = false;
+    // The NaNs are replaced in every channel, hence the pixels of a scan-line can be processed as
+    // one contiguous run of values: a single run for packed images, or one run per channel for coplanar images
+    const bool isPacked = dstPixelStride == nComps;
+    const int nRuns = isPacked ? 1 : nComps;
+    const int runLength = isPacked ? roi.width() * nComps : roi.width();
+
+    std::size_t nNaNs = 0;
     for (int y = roi.y1; y < roi.y2; ++y) {
-        for (int x = roi.x1; x < roi.x2; ++x) {
-            for (int k = 0; k < nComps; ++k) {
-                // we remove NaNs, but infinity values should pose no problem
-                // (if they do, please explain here which ones)
-                if (*dstPixelPtrs[k] != *dstPixelPtrs[k]) { // check for NaN
-                    *dstPixelPtrs[k] = 1.;
-                    hasnan = true;
-                }
-                dstPixelPtrs[k] += dstPixelStride;
-            }
-        }
-        // Remove what was done at the previous scan-line and got to the next
-        for (int k = 0; k < nComps; ++k) {
-            dstPixelPtrs[k] += (rowElementsCount - roi.width() * dstPixelStride);
+        for (int k = 0; k < nRuns; ++k) {
+            nNaNs += replaceNaNs(dstPixelPtrs[k], runLength);
+            dstPixelPtrs[k] += rowElementsCount;
         }
     } // for each scan-line
 
-    return hasnan;
+    return nNaNs;
 } // checkForNaNsInternal
 
 template <typename PIX, int maxValue>
-bool
+std::size_t
 checkForNaNsForDepth(void* ptrs[4],
                      int nComps,
                      const RectI& bounds,
@@ -512,12 +637,12 @@ checkForNaNsForDepth(void* ptrs[4],
         default:
             break;
     }
-    return false;
+    return 0;
 
 }
 
 
-bool
+std::size_t
 ImagePrivate::checkForNaNs(void* ptrs[4],
                            int nComps,
                            ImageBitDepthEnum bitdepth,
@@ -532,7 +657,7 @@ ImagePrivate::checkForNaNs(void* ptrs[4],
             return checkForNaNsForDepth<unsigned short, 65535>(ptrs, nComps, bounds, roi);
             break;
         case eImageBitDepthHalf:
-            assert(false);
+            return checkForNaNsForDepth<HalfFloat, 1>(ptrs, nComps, bounds, roi);
             break;
         case eImageBitDepthFloat:
             return checkForNaNsForDepth<float, 1>(ptrs, nComps, bounds, roi);
@@ -540,7 +665,86 @@ ImagePrivate::checkForNaNs(void* ptrs[4],
         case eImageBitDepthNone:
             break;
     }
-    return false;
+    return 0;
+}
+
+template <typename PIX, int maxValue, int nComps>
+void
+applyColorMatrixInternal(void* ptrs[4],
+                         const RectI& bounds,
+                         const RectI& roi,
+                         const double matrix[12])
+{
+    PIX* dstPixelPtrs[4];
+    int dstPixelStride;
+    Image::getChannelPointers<PIX, nComps>((const PIX**)ptrs, roi.x1, roi.y1, bounds, (PIX**)dstPixelPtrs, &dstPixelStride);
+    const int rowElementsCount = bounds.width() * dstPixelStride;
+
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        PIX* rPix = dstPixelPtrs[0];
+        PIX* gPix = dstPixelPtrs[1];
+        PIX* bPix = dstPixelPtrs[2];
+        for (int x = roi.x1; x < roi.x2; ++x) {
+            double r = *rPix / (double)maxValue;
+            double g = *gPix / (double)maxValue;
+            double b = *bPix / (double)maxValue;
+            *rPix = Image::clampIfInt<PIX>( (float)( (matrix[0] * r + matrix[1] * g + matrix[2] * b + matrix[3]) * maxValue ) );
+            *gPix = Image::clampIfInt<PIX>( (float)( (matrix[4] * r + matrix[5] * g + matrix[6] * b + matrix[7]) * maxValue ) );
+            *bPix = Image::clampIfInt<PIX>( (float)( (matrix[8] * r + matrix[9] * g + matrix[10] * b + matrix[11]) * maxValue ) );
+            rPix += dstPixelStride;
+            gPix += dstPixelStride;
+            bPix += dstPixelStride;
+        }
+        for (int k = 0; k < 3; ++k) {
+            dstPixelPtrs[k] += rowElementsCount;
+        }
+    } // for each scan-line
+} // applyColorMatrixInternal
+
+template <typename PIX, int maxValue>
+void
+applyColorMatrixForDepth(void* ptrs[4],
+                         int nComps,
+                         const RectI& bounds,
+                         const RectI& roi,
+                         const double matrix[12])
+{
+    switch (nComps) {
+        case 3:
+            applyColorMatrixInternal<PIX, maxValue, 3>(ptrs, bounds, roi, matrix);
+            break;
+        case 4:
+            applyColorMatrixInternal<PIX, maxValue, 4>(ptrs, bounds, roi, matrix);
+            break;
+        default:
+            break;
+    }
+}
+
+void
+ImagePrivate::applyColorMatrix(void* ptrs[4],
+                               int nComps,
+                               ImageBitDepthEnum bitdepth,
+                               const RectI& bounds,
+                               const RectI& roi,
+                               const double matrix[12])
+{
+    switch ( bitdepth ) {
+        case eImageBitDepthByte:
+            applyColorMatrixForDepth<unsigned char, 255>(ptrs, nComps, bounds, roi, matrix);
+            break;
+        case eImageBitDepthShort:
+            applyColorMatrixForDepth<unsigned short, 65535>(ptrs, nComps, bounds, roi, matrix);
+            break;
+        case eImageBitDepthHalf:
+            applyColorMatrixForDepth<HalfFloat, 1>(ptrs, nComps, bounds, roi, matrix);
+            break;
+        case eImageBitDepthFloat:
+            applyColorMatrixForDepth<float, 1>(ptrs, nComps, bounds, roi, matrix);
+            break;
+        case eImageBitDepthNone:
+            break;
+    }
 }
 
 NATRON_NAMESPACE_EXIT;
@@ -80,6 +80,9 @@ struct ImagePrivate
     // The buffer format
     ImageBufferLayoutEnum bufferFormat;
 
+    // If the buffer format is eImageBufferLayoutMonoChannelTiled, the size of a tile, otherwise 0
+    int tileSizeX, tileSizeY;
+
     // This must be set if the cache policy is not none.
     // This will be used to prevent inserting in the cache part of images that had
     // their render aborted.
@@ -108,6 +111,8 @@ struct ImagePrivate
     , cachePolicy(eCacheAccessModeNone)
     , cacheEntry()
     , bufferFormat(eImageBufferLayoutRGBAPackedFullRect)
+    , tileSizeX(0)
+    , tileSizeY(0)
     , renderClone()
     , bitdepth(eImageBitDepthNone)
     , storage(eStorageModeNone)
@@ -128,6 +133,8 @@ struct ImagePrivate
                                    const ImageStorageBasePtr storage[4],
                                    ImageBitDepthEnum depth,
                                    ImageBufferLayoutEnum format,
+                                   int tileSizeX,
+                                   int tileSizeY,
                                    Image::CPUData* data);
 
     /**
@@ -202,19 +209,39 @@ struct ImagePrivate
                         const RectI& roi,
                         const EffectInstancePtr& renderClone);
 
+    /**
+     * @brief Halves the source image into the rows of the destination image that are in dstRows.
+     * dstRows must span the full width of dstBounds.
+     **/
     static ActionRetCodeEnum halveImage(const void* srcPtrs[4],
                            int nComps,
                            ImageBitDepthEnum bitdepth,
                            const RectI& srcBounds,
                            void* dstPtrs[4],
                            const RectI& dstBounds,
+                           const RectI& dstRows,
                            const EffectInstancePtr& renderClone);
 
-    static bool checkForNaNs(void* ptrs[4],
-                             int nComps,
-                             ImageBitDepthEnum bitdepth,
-                             const RectI& bounds,
-                             const RectI& roi);
+    static std::size_t checkForNaNs(void* ptrs[4],
+                                    int nComps,
+                                    ImageBitDepthEnum bitdepth,
+                                    const RectI& bounds,
+                                    const RectI& roi);
+
+    static void applyColorMatrix(void* ptrs[4],
+                                 int nComps,
+                                 ImageBitDepthEnum bitdepth,
+                                 const RectI& bounds,
+                                 const RectI& roi,
+                                 const double matrix[12]);
+
+    static ActionRetCodeEnum resampleCPU(const Image::CPUData& src,
+                                         const Image::CPUData& dst,
+                                         const RectI& roi,
+                                         const Transform::Matrix3x3& dstToSrc,
+                                         Image::ResampleFilterEnum filter,
+                                         bool clamp,
+                                         const EffectInstancePtr& renderClone);
 
     static void applyMaskMixGL(const GLImageStoragePtr& originalTexture,
                                const GLImageStoragePtr& maskTexture,
@@ -223,6 +250,17 @@ struct ImagePrivate
                                bool invertMask,
                                const RectI& roi);
 
+    /**
+     * @brief Same as copyUnprocessedChannelsGL() followed by applyMaskMixGL() but in a single pass
+     **/
+    static void applyMaskMixCopyUnprocessedChannelsGL(const GLImageStoragePtr& originalTexture,
+                                                      const GLImageStoragePtr& maskTexture,
+                                                      const GLImageStoragePtr& dstTexture,
+                                                      double mix,
+                                                      bool invertMask,
+                                                      const std::bitset<4> processChannels,
+                                                      const RectI& roi);
+
     static void applyMaskMixCPU(const void* originalImgPtrs[4],
                                 const RectI& originalImgBounds,
                                 int originalImgNComps,
@@ -0,0 +1,515 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ImagePrivate.h"
+
+#include <algorithm> // min, max
+#include <cmath>
+#include <vector>
+
+#ifdef __NATRON_SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Engine/Transform.h"
+
+NATRON_NAMESPACE_ENTER;
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// The taps of a filter along one axis: tap k is the source pixel first + k and reads the pixel index[k],
+// which differs only for the taps outside of the source image
+struct ResampleTaps
+{
+    int first;
+    int index[4];
+    float weight[4];
+};
+
+/**
+ * @brief The cubic filters are all Mitchell-Netravali BC-splines
+ **/
+inline void
+getBCSplineParameters(Image::ResampleFilterEnum filter, double* B, double* C)
+{
+    switch (filter) {
+    case Image::eResampleFilterKeys:
+        *B = 0.; *C = 0.5;
+        break;
+    case Image::eResampleFilterSimon:
+        *B = 0.; *C = 0.75;
+        break;
+    case Image::eResampleFilterRifman:
+        *B = 0.; *C = 1.;
+        break;
+    case Image::eResampleFilterMitchell:
+        *B = 1. / 3.; *C = 1. / 3.;
+        break;
+    case Image::eResampleFilterParzen:
+        *B = 1.; *C = 0.;
+        break;
+    case Image::eResampleFilterNotch:
+    default:
+        *B = 1.5; *C = -0.25;
+        break;
+    }
+}
+
+inline double
+evaluateBCSpline(double B, double C, double t)
+{
+    t = std::abs(t);
+    if (t < 1.) {
+        return ( (12. - 9. * B - 6. * C) * t * t * t + (-18. + 12. * B + 6. * C) * t * t + (6. - 2. * B) ) / 6.;
+    } else if (t < 2.) {
+        return ( (-B - 6. * C) * t * t * t + (6. * B + 30. * C) * t * t + (-12. * B - 48. * C) * t + (8. * B + 24. * C) ) / 6.;
+    }
+
+    return 0.;
+}
+
+/**
+ * @brief Returns the 4 taps around the continuous source position s (in pixel coordinates, pixel centers at +0.5).
+ * Taps outside of [begin, end[ have a zero weight and read the nearest pixel inside so that they can be read unconditionally.
+ * Returns false if no tap is inside.
+ **/
+inline bool
+getFilterTaps(Image::ResampleFilterEnum filter,
+              double B,
+              double C,
+              double s,
+              int begin,
+              int end,
+              ResampleTaps* taps)
+{
+    s -= 0.5;
+    double fl = std::floor(s);
+    int i0 = (int)fl;
+    double d = s - fl;
+    double w[4] = {0., 0., 0., 0.};
+
+    switch (filter) {
+    case Image::eResampleFilterImpulse:
+        w[d < 0.5 ? 1 : 2] = 1.;
+        break;
+    case Image::eResampleFilterBilinear:
+        w[1] = 1. - d;
+        w[2] = d;
+        break;
+    case Image::eResampleFilterCubic: {
+        double smooth = d * d * (3. - 2. * d);
+        w[1] = 1. - smooth;
+        w[2] = smooth;
+        break;
+    }
+    default:
+        for (int k = 0; k < 4; ++k) {
+            w[k] = evaluateBCSpline(B, C, d - (k - 1));
+        }
+        break;
+    }
+
+    bool anyInside = false;
+    taps->first = i0 - 1;
+    for (int k = 0; k < 4; ++k) {
+        int index = i0 - 1 + k;
+        if ( (index < begin) || (index >= end) ) {
+            taps->index[k] = std::min(std::max(index, begin), end - 1);
+            taps->weight[k] = 0.f;
+        } else {
+            taps->index[k] = index;
+            taps->weight[k] = (float)w[k];
+            anyInside |= (w[k] != 0.);
+        }
+    }
+
+    return anyInside;
+} // getFilterTaps
+
+inline bool
+filterHasNegativeLobes(Image::ResampleFilterEnum filter)
+{
+    return filter == Image::eResampleFilterKeys || filter == Image::eResampleFilterSimon || filter == Image::eResampleFilterRifman;
+}
+
+// Reads and writes pixels whatever the buffer layout
+template <typename PIX, int nComps>
+struct ResampleBuffer
+{
+    PIX* origin[4];
+    int pixelStride;
+    int rowStride;
+    RectI bounds;
+
+    ResampleBuffer(void* ptrs[4], const RectI& bounds)
+    : bounds(bounds)
+    {
+        Image::getChannelPointers<PIX, nComps>( (const PIX**)ptrs, bounds.x1, bounds.y1, bounds, origin, &pixelStride );
+        rowStride = bounds.width() * pixelStride;
+    }
+
+    inline std::size_t offset(int x, int y) const
+    {
+        return (std::size_t)(y - bounds.y1) * rowStride + (std::size_t)(x - bounds.x1) * pixelStride;
+    }
+
+    inline bool isPacked() const
+    {
+        return nComps == 1 || pixelStride == nComps;
+    }
+};
+
+template <typename PIX, int maxValue, int nComps>
+inline void
+writePixel(const ResampleBuffer<PIX, nComps>& dst,
+           std::size_t offset,
+           const float value[4])
+{
+    for (int c = 0; c < nComps; ++c) {
+        dst.origin[c][offset] = Image::clampIfInt<PIX>(value[c] * maxValue);
+    }
+}
+
+// Clamps the value between the values of the 2x2 source pixels nearest to the sampled position, to remove the overshoots of the negative lobes
+template <typename PIX, int nComps>
+inline void
+clampToNearestPixels(const ResampleBuffer<PIX, nComps>& src,
+                     int firstX,
+                     int firstY,
+                     float value[4])
+{
+    for (int c = 0; c < nComps; ++c) {
+        float minValue = 0.f, maxValue = 0.f;
+        bool first = true;
+        for (int j = 1; j < 3; ++j) {
+            for (int i = 1; i < 3; ++i) {
+                const int x = firstX + i;
+                const int y = firstY + j;
+                // Outside of the source image is black
+                float v = src.bounds.contains(x, y) ? (float)src.origin[c][src.offset(x, y)] : 0.f;
+                if (first) {
+                    minValue = maxValue = v;
+                    first = false;
+                } else {
+                    minValue = std::min(minValue, v);
+                    maxValue = std::max(maxValue, v);
+                }
+            }
+        }
+        value[c] = std::min(std::max(value[c], minValue), maxValue);
+    }
+}
+
+/**
+ * @brief Horizontally filters the source row y into row, which holds nComps floats per pixel of roi. The value are not normalized.
+ **/
+template <typename PIX, int nComps>
+void
+filterRowHorizontally(const ResampleBuffer<PIX, nComps>& src,
+                      int y,
+                      const std::vector<ResampleTaps>& tapsX,
+                      float* row)
+{
+    const std::size_t rowOffset = src.offset(src.bounds.x1, y);
+    const int width = (int)tapsX.size();
+#ifdef __NATRON_SSE2__
+    // float is the only pixel type of 4 bytes
+    if ( (nComps == 4) && src.isPacked() && (sizeof(PIX) == sizeof(float)) ) {
+        const float* srcRow = (const float*)src.origin[0] + rowOffset;
+        for (int x = 0; x < width; ++x, row += 4) {
+            const ResampleTaps& taps = tapsX[x];
+            __m128 acc = _mm_mul_ps( _mm_loadu_ps(srcRow + taps.index[0] * 4), _mm_set1_ps(taps.weight[0]) );
+            acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps(srcRow + taps.index[1] * 4), _mm_set1_ps(taps.weight[1]) ) );
+            acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps(srcRow + taps.index[2] * 4), _mm_set1_ps(taps.weight[2]) ) );
+            acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps(srcRow + taps.index[3] * 4), _mm_set1_ps(taps.weight[3]) ) );
+            _mm_storeu_ps(row, acc);
+        }
+
+        return;
+    }
+#endif
+    for (int x = 0; x < width; ++x, row += nComps) {
+        const ResampleTaps& taps = tapsX[x];
+        for (int c = 0; c < nComps; ++c) {
+            const PIX* srcRow = src.origin[c] + rowOffset;
+            float acc = 0.f;
+            for (int k = 0; k < 4; ++k) {
+                acc += taps.weight[k] * (float)srcRow[(std::size_t)taps.index[k] * src.pixelStride];
+            }
+            row[c] = acc;
+        }
+    }
+} // filterRowHorizontally
+
+/**
+ * @brief Resampling when the transform only scales and translates along the axes: the filter is separable and the
+ * weights of each column and each row of the roi are computed once. The source rows are filtered horizontally
+ * once, then combined vertically.
+ **/
+template <typename PIX, int maxValue, int nComps>
+ActionRetCodeEnum
+resampleSeparable(const ResampleBuffer<PIX, nComps>& src,
+                  const ResampleBuffer<PIX, nComps>& dst,
+                  const RectI& roi,
+                  const Transform::Matrix3x3& dstToSrc,
+                  Image::ResampleFilterEnum filter,
+                  bool clamp,
+                  const EffectInstancePtr& renderClone)
+{
+    double B = 0., C = 0.;
+    getBCSplineParameters(filter, &B, &C);
+
+    const double scaleX = dstToSrc.a / dstToSrc.i;
+    const double offsetX = dstToSrc.c / dstToSrc.i;
+    const double scaleY = dstToSrc.e / dstToSrc.i;
+    const double offsetY = dstToSrc.f / dstToSrc.i;
+
+    const int width = roi.width();
+    std::vector<ResampleTaps> tapsX(width);
+    std::vector<char> columnInside(width);
+    for (int x = 0; x < width; ++x) {
+        columnInside[x] = getFilterTaps(filter, B, C, scaleX * (roi.x1 + x + 0.5) + offsetX, src.bounds.x1, src.bounds.x2, &tapsX[x]);
+        // The horizontal pass reads relative to the start of the source row
+        for (int k = 0; k < 4; ++k) {
+            tapsX[x].index[k] -= src.bounds.x1;
+        }
+    }
+
+    // The source rows are filtered horizontally when they are first needed
+    std::vector<ResampleTaps> tapsY( roi.height() );
+    std::vector<char> rowInside( roi.height() );
+    int firstSrcRow = src.bounds.y2, lastSrcRow = src.bounds.y1 - 1;
+    for (int y = 0; y < roi.height(); ++y) {
+        rowInside[y] = getFilterTaps(filter, B, C, scaleY * (roi.y1 + y + 0.5) + offsetY, src.bounds.y1, src.bounds.y2, &tapsY[y]);
+        if (rowInside[y]) {
+            firstSrcRow = std::min(firstSrcRow, tapsY[y].index[0]);
+            lastSrcRow = std::max(lastSrcRow, tapsY[y].index[3]);
+        }
+    }
+    std::vector<int> rowSlots(std::max(0, lastSrcRow - firstSrcRow + 1), -1);
+    std::vector<float> filteredRows;
+    const std::size_t filteredRowSize = (std::size_t)width * nComps;
+
+    const bool doClamp = clamp && filterHasNegativeLobes(filter);
+    for (int y = 0; y < roi.height(); ++y) {
+
+        if ( renderClone && renderClone->isRenderAborted() ) {
+            return eActionStatusAborted;
+        }
+
+        const std::size_t dstRowOffset = dst.offset(roi.x1, roi.y1 + y);
+        const ResampleTaps& taps = tapsY[y];
+
+        const float* rows[4] = {0, 0, 0, 0};
+        if (rowInside[y]) {
+            for (int k = 0; k < 4; ++k) {
+                int& slot = rowSlots[taps.index[k] - firstSrcRow];
+                if (slot == -1) {
+                    slot = (int)(filteredRows.size() / filteredRowSize);
+                    filteredRows.resize(filteredRows.size() + filteredRowSize);
+                    filterRowHorizontally<PIX, nComps>(src, taps.index[k], tapsX, &filteredRows[0] + slot * filteredRowSize);
+                }
+            }
+            // Pointers are taken once all the rows of this output row are allocated
+            for (int k = 0; k < 4; ++k) {
+                rows[k] = &filteredRows[0] + rowSlots[taps.index[k] - firstSrcRow] * filteredRowSize;
+            }
+        }
+
+        for (int x = 0; x < width; ++x) {
+            float value[4] = {0.f, 0.f, 0.f, 0.f};
+            if (rowInside[y] && columnInside[x]) {
+                const std::size_t o = (std::size_t)x * nComps;
+#ifdef __NATRON_SSE2__
+                if (nComps == 4) {
+                    __m128 acc = _mm_mul_ps( _mm_loadu_ps(rows[0] + o), _mm_set1_ps(taps.weight[0]) );
+                    acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps(rows[1] + o), _mm_set1_ps(taps.weight[1]) ) );
+                    acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps(rows[2] + o), _mm_set1_ps(taps.weight[2]) ) );
+                    acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps(rows[3] + o), _mm_set1_ps(taps.weight[3]) ) );
+                    _mm_storeu_ps(value, acc);
+                } else
+#endif
+                {
+                    for (int c = 0; c < nComps; ++c) {
+                        value[c] = taps.weight[0] * rows[0][o + c] + taps.weight[1] * rows[1][o + c] + taps.weight[2] * rows[2][o + c] + taps.weight[3] * rows[3][o + c];
+                    }
+                }
+                if (doClamp) {
+                    clampToNearestPixels<PIX, nComps>(src, tapsX[x].first, taps.first, value);
+                }
+                for (int c = 0; c < nComps; ++c) {
+                    value[c] /= maxValue;
+                }
+            }
+            writePixel<PIX, maxValue, nComps>(dst, dstRowOffset + (std::size_t)x * dst.pixelStride, value);
+        }
+    } // for each row
+
+    return eActionStatusOK;
+} // resampleSeparable
+
+/**
+ * @brief Resampling for any other transform: the taps are computed for each pixel
+ **/
+template <typename PIX, int maxValue, int nComps>
+ActionRetCodeEnum
+resampleGeneral(const ResampleBuffer<PIX, nComps>& src,
+                const ResampleBuffer<PIX, nComps>& dst,
+                const RectI& roi,
+                const Transform::Matrix3x3& dstToSrc,
+                Image::ResampleFilterEnum filter,
+                bool clamp,
+                const EffectInstancePtr& renderClone)
+{
+    double B = 0., C = 0.;
+    getBCSplineParameters(filter, &B, &C);
+
+    const bool doClamp = clamp && filterHasNegativeLobes(filter);
+    ResampleTaps tapsX, tapsY;
+    for (int y = roi.y1; y < roi.y2; ++y) {
+
+        if ( renderClone && renderClone->isRenderAborted() ) {
+            return eActionStatusAborted;
+        }
+
+        const std::size_t dstRowOffset = dst.offset(roi.x1, y);
+        const double dy = y + 0.5;
+        for (int x = roi.x1; x < roi.x2; ++x) {
+            float value[4] = {0.f, 0.f, 0.f, 0.f};
+            const double dx = x + 0.5;
+            const double w = dstToSrc.g * dx + dstToSrc.h * dy + dstToSrc.i;
+            if (w > 0.) {
+                const double sx = (dstToSrc.a * dx + dstToSrc.b * dy + dstToSrc.c) / w;
+                const double sy = (dstToSrc.d * dx + dstToSrc.e * dy + dstToSrc.f) / w;
+                if ( getFilterTaps(filter, B, C, sx, src.bounds.x1, src.bounds.x2, &tapsX) &&
+                     getFilterTaps(filter, B, C, sy, src.bounds.y1, src.bounds.y2, &tapsY) ) {
+                    for (int j = 0; j < 4; ++j) {
+                        if (tapsY.weight[j] == 0.f) {
+                            continue;
+                        }
+                        float rowValue[4] = {0.f, 0.f, 0.f, 0.f};
+                        for (int i = 0; i < 4; ++i) {
+                            const std::size_t o = src.offset(tapsX.index[i], tapsY.index[j]);
+                            for (int c = 0; c < nComps; ++c) {
+                                rowValue[c] += tapsX.weight[i] * (float)src.origin[c][o];
+                            }
+                        }
+                        for (int c = 0; c < nComps; ++c) {
+                            value[c] += tapsY.weight[j] * rowValue[c];
+                        }
+                    }
+                    if (doClamp) {
+                        clampToNearestPixels<PIX, nComps>(src, tapsX.first, tapsY.first, value);
+                    }
+                    for (int c = 0; c < nComps; ++c) {
+                        value[c] /= maxValue;
+                    }
+                }
+            }
+            writePixel<PIX, maxValue, nComps>(dst, dstRowOffset + (std::size_t)(x - roi.x1) * dst.pixelStride, value);
+        }
+    } // for each row
+
+    return eActionStatusOK;
+} // resampleGeneral
+
+template <typename PIX, int maxValue, int nComps>
+ActionRetCodeEnum
+resampleForComponents(const Image::CPUData& src,
+                      const Image::CPUData& dst,
+                      const RectI& roi,
+                      const Transform::Matrix3x3& dstToSrc,
+                      Image::ResampleFilterEnum filter,
+                      bool clamp,
+                      const EffectInstancePtr& renderClone)
+{
+    ResampleBuffer<PIX, nComps> srcBuffer( (void**)src.ptrs, src.bounds );
+    ResampleBuffer<PIX, nComps> dstBuffer( (void**)dst.ptrs, dst.bounds );
+
+    const bool isAxisAligned = dstToSrc.b == 0. && dstToSrc.d == 0. && dstToSrc.g == 0. && dstToSrc.h == 0. && dstToSrc.i != 0.;
+    if (isAxisAligned) {
+        return resampleSeparable<PIX, maxValue, nComps>(srcBuffer, dstBuffer, roi, dstToSrc, filter, clamp, renderClone);
+    } else {
+        return resampleGeneral<PIX, maxValue, nComps>(srcBuffer, dstBuffer, roi, dstToSrc, filter, clamp, renderClone);
+    }
+}
+
+template <typename PIX, int maxValue>
+ActionRetCodeEnum
+resampleForDepth(const Image::CPUData& src,
+                 const Image::CPUData& dst,
+                 const RectI& roi,
+                 const Transform::Matrix3x3& dstToSrc,
+                 Image::ResampleFilterEnum filter,
+                 bool clamp,
+                 const EffectInstancePtr& renderClone)
+{
+    switch (src.nComps) {
+    case 1:
+        return resampleForComponents<PIX, maxValue, 1>(src, dst, roi, dstToSrc, filter, clamp, renderClone);
+    case 2:
+        return resampleForComponents<PIX, maxValue, 2>(src, dst, roi, dstToSrc, filter, clamp, renderClone);
+    case 3:
+        return resampleForComponents<PIX, maxValue, 3>(src, dst, roi, dstToSrc, filter, clamp, renderClone);
+    case 4:
+        return resampleForComponents<PIX, maxValue, 4>(src, dst, roi, dstToSrc, filter, clamp, renderClone);
+    default:
+        break;
+    }
+
+    return eActionStatusFailed;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+ActionRetCodeEnum
+ImagePrivate::resampleCPU(const Image::CPUData& src,
+                          const Image::CPUData& dst,
+                          const RectI& roi,
+                          const Transform::Matrix3x3& dstToSrc,
+                          Image::ResampleFilterEnum filter,
+                          bool clamp,
+                          const EffectInstancePtr& renderClone)
+{
+    assert(src.bitDepth == dst.bitDepth && src.nComps == dst.nComps);
+    assert( dst.bounds.contains(roi) );
+    if ( src.bounds.isNull() ) {
+        return eActionStatusOK;
+    }
+    switch (src.bitDepth) {
+    case eImageBitDepthByte:
+        return resampleForDepth<unsigned char, 255>(src, dst, roi, dstToSrc, filter, clamp, renderClone);
+    case eImageBitDepthShort:
+        return resampleForDepth<unsigned short, 65535>(src, dst, roi, dstToSrc, filter, clamp, renderClone);
+    case eImageBitDepthFloat:
+        return resampleForDepth<float, 1>(src, dst, roi, dstToSrc, filter, clamp, renderClone);
+    case eImageBitDepthHalf:
+    case eImageBitDepthNone:
+        break;
+    }
+
+    return eActionStatusFailed;
+} // resampleCPU
+
+NATRON_NAMESPACE_EXIT;
@@ -31,6 +31,7 @@
 
 #include "Engine/AppManager.h"
 #include "Engine/Cache.h"
+#include "Engine/CudaDriver.h"
 #include "Engine/OSGLContext.h"
 #include "Engine/RamBuffer.h"
 #include "Engine/Texture.h"
@@ -46,14 +47,38 @@ struct ImageStorageBasePrivate
     ImageBitDepthEnum bitdepth;
     boost::shared_ptr<AllocateMemoryArgs> allocArgs;
 
+    // The accounts charged for the memory, see setMemoryAccounts()
+    std::vector<MemoryAccountPtr> memoryAccounts;
+    MemoryAccountTypeEnum memoryAccountType;
+
+    // The number of bytes added to memoryAccounts, protected by allocatedLock
+    std::size_t accountedBytes;
+
     ImageStorageBasePrivate()
     : allocated(false)
     , allocatedLock()
     , bitdepth()
     , allocArgs()
+    , memoryAccounts()
+    , memoryAccountType(eMemoryAccountTypeImageRAM)
+    , accountedBytes(0)
     {
 
     }
+
+    /**
+     * @brief Removes the accounted bytes from the memory accounts. Must be called with allocatedLock held.
+     **/
+    void releaseAccountedBytes()
+    {
+        if (accountedBytes == 0) {
+            return;
+        }
+        for (std::size_t i = 0; i < memoryAccounts.size(); ++i) {
+            memoryAccounts[i]->removeBytes(memoryAccountType, accountedBytes);
+        }
+        accountedBytes = 0;
+    }
 };
 
 ImageStorageBase::ImageStorageBase()
@@ -64,7 +89,8 @@ ImageStorageBase::ImageStorageBase()
 
 ImageStorageBase::~ImageStorageBase()
 {
-
+    QMutexLocker k(&_imp->allocatedLock);
+    _imp->releaseAccountedBytes();
 }
 
 ImageBitDepthEnum
@@ -117,6 +143,16 @@ ImageStorageBase::allocateMemoryFromSetArgs()
     allocateMemory(*args);
 }
 
+void
+ImageStorageBase::setMemoryAccounts(const std::vector<MemoryAccountPtr>& accounts,
+                                    MemoryAccountTypeEnum type)
+{
+    QMutexLocker k(&_imp->allocatedLock);
+    assert(!_imp->allocated);
+    _imp->memoryAccounts = accounts;
+    _imp->memoryAccountType = type;
+}
+
 void
 ImageStorageBase::allocateMemory(const AllocateMemoryArgs& args)
 {
@@ -130,6 +166,12 @@ ImageStorageBase::allocateMemory(const AllocateMemoryArgs& args)
     {
         QMutexLocker k(&_imp->allocatedLock);
         _imp->allocated = true;
+        if ( !_imp->memoryAccounts.empty() ) {
+            _imp->accountedBytes = getBufferSize();
+            for (std::size_t i = 0; i < _imp->memoryAccounts.size(); ++i) {
+                _imp->memoryAccounts[i]->addBytes(_imp->memoryAccountType, _imp->accountedBytes);
+            }
+        }
     }
 
 }
@@ -144,6 +186,8 @@ ImageStorageBase::deallocateMemory()
 
     deallocateMemoryImpl();
 
+    QMutexLocker k(&_imp->allocatedLock);
+    _imp->releaseAccountedBytes();
 }
 
 
@@ -324,7 +368,7 @@ struct GLImageStoragePrivate
 {
 
     OSGLContextWPtr glContext;
-    boost::scoped_ptr<Texture> texture;
+    GLTexturePtr texture;
 
     GLImageStoragePrivate()
     : glContext()
@@ -351,6 +395,7 @@ GLImageStorage::~GLImageStorage()
         if (context) {
             attacher = OSGLContextAttacher::create(context);
             attacher->attach();
+            context->releaseTextureToPool(_imp->texture);
         }
         _imp->texture.reset();
     }
@@ -411,6 +456,13 @@ GLImageStorage::allocateMemoryImpl(const AllocateMemoryArgs& args)
     glType = GL_FLOAT;
 
 
+    // Re-use a texture of the same size released by another image to avoid a glTexImage2D call
+    _imp->texture = glArgs->glContext->takeTextureFromPool(glArgs->textureTarget, internalFormat, glArgs->bounds.width(), glArgs->bounds.height());
+    if (_imp->texture) {
+        _imp->texture->setBoundsKeepingStorage(glArgs->bounds);
+        return;
+    }
+
     _imp->texture.reset( new Texture(glArgs->textureTarget,
                                      GL_NONE,
                                      GL_NONE,
@@ -443,6 +495,7 @@ GLImageStorage::deallocateMemoryImpl()
         // Ensure the context is current to the thread
         OSGLContextAttacherPtr attacher = OSGLContextAttacher::create(glContext);
         attacher->attach();
+        glContext->releaseTextureToPool(_imp->texture);
         _imp->texture.reset();
     }
 
@@ -481,4 +534,94 @@ GLImageStorage::getGLTextureType() const
 
 
 
+struct CudaImageStoragePrivate
+{
+    CudaDriverPtr driver;
+    U64 buffer;
+    std::size_t sizeBytes;
+
+    CudaImageStoragePrivate()
+    : driver()
+    , buffer(0)
+    , sizeBytes(0)
+    {
+
+    }
+};
+
+CudaImageStorage::CudaImageStorage()
+: ImageStorageBase()
+, _imp(new CudaImageStoragePrivate())
+{
+
+}
+
+CudaImageStorage::~CudaImageStorage()
+{
+    if (_imp->buffer) {
+        _imp->driver->freeBuffer(_imp->buffer);
+    }
+}
+
+StorageModeEnum
+CudaImageStorage::getStorageMode() const
+{
+    return eStorageModeCudaBuffer;
+}
+
+std::size_t
+CudaImageStorage::getBufferSize() const
+{
+    return _imp->sizeBytes;
+}
+
+U64
+CudaImageStorage::getDeviceBuffer() const
+{
+    return _imp->buffer;
+}
+
+bool
+CudaImageStorage::copyFromHost(const void* src)
+{
+    if (!_imp->buffer) {
+        return false;
+    }
+    return _imp->driver->copyToDevice(_imp->buffer, src, _imp->sizeBytes);
+}
+
+bool
+CudaImageStorage::copyToHost(void* dst) const
+{
+    if (!_imp->buffer) {
+        return false;
+    }
+    return _imp->driver->copyFromDevice(dst, _imp->buffer, _imp->sizeBytes);
+}
+
+void
+CudaImageStorage::allocateMemoryImpl(const AllocateMemoryArgs& args)
+{
+    const CudaAllocateMemoryArgs* cudaArgs = dynamic_cast<const CudaAllocateMemoryArgs*>(&args);
+    assert(cudaArgs && cudaArgs->driver);
+
+    assert(!_imp->buffer);
+
+    _imp->driver = cudaArgs->driver;
+    _imp->buffer = cudaArgs->driver->allocateBuffer(cudaArgs->sizeBytes);
+    if (!_imp->buffer) {
+        throw std::bad_alloc();
+    }
+    _imp->sizeBytes = cudaArgs->sizeBytes;
+}
+
+void
+CudaImageStorage::deallocateMemoryImpl()
+{
+    assert(_imp->buffer);
+    _imp->driver->freeBuffer(_imp->buffer);
+    _imp->buffer = 0;
+    _imp->sizeBytes = 0;
+}
+
 NATRON_NAMESPACE_EXIT;
@@ -27,9 +27,12 @@
 
 #include "Global/Macros.h"
 
+#include <vector>
+
 #include "Global/GlobalDefines.h"
 
 #include "Engine/CacheEntryBase.h"
+#include "Engine/MemoryAccount.h"
 
 #include "Engine/EngineFwd.h"
 
@@ -117,6 +120,12 @@ public:
      **/
     void allocateMemoryFromSetArgs();
 
+    /**
+     * @brief Set the accounts to which the memory of this entry is attributed as the given type while it is allocated,
+     * see MemoryAccount. This must be called before allocating the memory.
+     **/
+    void setMemoryAccounts(const std::vector<MemoryAccountPtr>& accounts, MemoryAccountTypeEnum type);
+
     /**
      * @brief Returns the internal storage that your entry uses
      **/
@@ -317,6 +326,70 @@ toGLImageStorage(const ImageStorageBasePtr& entry)
     return boost::dynamic_pointer_cast<GLImageStorage>(entry);
 }
 
+class CudaAllocateMemoryArgs : public AllocateMemoryArgs
+{
+public:
+
+    CudaAllocateMemoryArgs()
+    : AllocateMemoryArgs()
+    , sizeBytes(0)
+    , driver()
+    {
+
+    }
+
+    virtual ~CudaAllocateMemoryArgs()
+    {
+
+    }
+
+    std::size_t sizeBytes;
+    CudaDriverPtr driver;
+};
+
+/**
+ * @brief Image storage based on a buffer in the memory of a CUDA device. This is not used by images in the cache:
+ * it holds the copy of a RAM image given to an OpenFX plug-in rendering with CUDA.
+ * The allocate() args must be of CudaAllocateMemoryArgs type. The memory is allocated, copied and freed in the
+ * context of the device, which must be current on the calling thread.
+ **/
+struct CudaImageStoragePrivate;
+class CudaImageStorage : public ImageStorageBase
+{
+public:
+
+    CudaImageStorage();
+
+    virtual ~CudaImageStorage();
+
+    virtual StorageModeEnum getStorageMode() const OVERRIDE FINAL;
+
+    virtual std::size_t getBufferSize() const OVERRIDE FINAL;
+
+    /**
+     * @brief Returns the address of the buffer on the device
+     **/
+    U64 getDeviceBuffer() const;
+
+    /**
+     * @brief Copies getBufferSize() bytes from the memory of the host to the buffer
+     **/
+    bool copyFromHost(const void* src);
+
+    /**
+     * @brief Copies the buffer to getBufferSize() bytes of the memory of the host
+     **/
+    bool copyToHost(void* dst) const;
+
+private:
+
+    virtual void allocateMemoryImpl(const AllocateMemoryArgs& args) OVERRIDE FINAL;
+
+    virtual void deallocateMemoryImpl() OVERRIDE FINAL;
+
+    boost::scoped_ptr<CudaImageStoragePrivate> _imp;
+};
+
 
 
 NATRON_NAMESPACE_EXIT;
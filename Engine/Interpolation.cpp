@@ -419,16 +419,18 @@ Interpolation::solveQuartic(double c0,
  * Note that for CATMULL-ROM you must use the function interpolate_catmullRom
  * which will compute the derivatives for you.
  **/
-double
-Interpolation::interpolate(double tcur,
-                           const double vcur,              //start control point
-                           const double vcurDerivRight, //being the derivative dv/dt at tcur
-                           const double vnextDerivLeft, //being the derivative dv/dt at tnext
-                           double tnext,
-                           const double vnext,               //end control point
-                           double currentTime,
-                           KeyframeTypeEnum interp,
-                           KeyframeTypeEnum interpNext)
+void
+Interpolation::getCubicCoefficients(double tcur,
+                                    const double vcur,              //start control point
+                                    const double vcurDerivRight, //being the derivative dv/dt at tcur
+                                    const double vnextDerivLeft, //being the derivative dv/dt at tnext
+                                    double tnext,
+                                    const double vnext,               //end control point
+                                    KeyframeTypeEnum interp,
+                                    KeyframeTypeEnum interpNext,
+                                    double* segmentTcur,
+                                    double* segmentTnext,
+                                    double c[4])
 {
     double P0 = vcur;
     double P3 = vnext;
@@ -456,16 +458,41 @@ Interpolation::interpolate(double tcur,
         P3 = P0 + P0pr;
         tnext = tcur + 1;
     }
-    double c0, c1, c2, c3;
-    hermiteToCubicCoeffs(P0, P0pr, P3pl, P3, &c0, &c1, &c2, &c3);
+    hermiteToCubicCoeffs(P0, P0pr, P3pl, P3, &c[0], &c[1], &c[2], &c[3]);
+    *segmentTcur = tcur;
+    *segmentTnext = tnext;
+} // getCubicCoefficients
 
-    const double t = (currentTime - tcur) / (tnext - tcur);
-    double ret = cubicEval(c0, c1, c2, c3, t);
+double
+Interpolation::evaluateCubic(const double c[4],
+                             double segmentTcur,
+                             double segmentTnext,
+                             double currentTime)
+{
+    const double t = (currentTime - segmentTcur) / (segmentTnext - segmentTcur);
 
     // cubicDerive: divide the result by (tnext-tcur)
 
     // cubicIntegrate: multiply the result by (tnext-tcur)
-    return ret;
+    return cubicEval(c[0], c[1], c[2], c[3], t);
+}
+
+double
+Interpolation::interpolate(double tcur,
+                           const double vcur,              //start control point
+                           const double vcurDerivRight, //being the derivative dv/dt at tcur
+                           const double vnextDerivLeft, //being the derivative dv/dt at tnext
+                           double tnext,
+                           const double vnext,               //end control point
+                           double currentTime,
+                           KeyframeTypeEnum interp,
+                           KeyframeTypeEnum interpNext)
+{
+    double c[4];
+    double segmentTcur, segmentTnext;
+    getCubicCoefficients(tcur, vcur, vcurDerivRight, vnextDerivLeft, tnext, vnext, interp, interpNext, &segmentTcur, &segmentTnext, c);
+
+    return evaluateCubic(c, segmentTcur, segmentTnext, currentTime);
 }
 
 /// derive at currentTime. The derivative is with respect to currentTime
@@ -50,6 +50,28 @@ double interpolate(double tcur, const double vcur, //start control point
                    KeyframeTypeEnum interp,
                    KeyframeTypeEnum interpNext) WARN_UNUSED_RETURN;
 
+/**
+ * @brief Computes the cubic polynomial used by interpolate() between the two given control points.
+ * The interpolated value at currentTime is evaluateCubic(c, *segmentTcur, *segmentTnext, currentTime),
+ * which gives exactly the same result as interpolate(). This is useful to evaluate the same segment many times.
+ * segmentTcur and segmentTnext may differ from tcur and tnext before the first or after the last keyframe.
+ **/
+void getCubicCoefficients(double tcur, const double vcur, //start control point
+                          const double vcurDerivRight, //being the derivative dv/dt at tcur
+                          const double vnextDerivLeft, //being the derivative dv/dt at tnext
+                          double tnext, const double vnext, //end control point
+                          KeyframeTypeEnum interp,
+                          KeyframeTypeEnum interpNext,
+                          double* segmentTcur,
+                          double* segmentTnext,
+                          double c[4]);
+
+/// evaluate at currentTime the cubic polynomial returned by getCubicCoefficients()
+double evaluateCubic(const double c[4],
+                     double segmentTcur,
+                     double segmentTnext,
+                     double currentTime) WARN_UNUSED_RETURN;
+
 /// derive at currentTime. The derivative is with respect to currentTime
 double derive(double tcur, const double vcur, //start control point
               const double vcurDerivRight, //being the derivative dv/dt at tcur
@@ -125,6 +125,10 @@
 #define kShortcutActionEnableRenderStatsLabel "Enable Render Statistics"
 #define kShortcutActionEnableRenderStatsHint "Show a statistics window, subsequent renders will display useful timing informations about nodes"
 
+#define kShortcutActionRecordRenderTrace "recordRenderTrace"
+#define kShortcutActionRecordRenderTraceLabel "Record Render Trace"
+#define kShortcutActionRecordRenderTraceHint "Record the timeline of the renders on each thread. When unchecked, the trace is saved in the Chrome trace format, which can be opened with chrome://tracing or https://ui.perfetto.dev"
+
 #define kShortcutActionConnectViewerToInput1 "connectViewerInput1"
 #define kShortcutActionConnectViewerToInput1Label "Connect Viewer to Input 1"
 #define kShortcutActionConnectViewerToInput1Hint "Connect Viewer to Input 1"
@@ -38,6 +38,7 @@
 #include <QtCore/QCoreApplication>
 #include <QtCore/QThread>
 #include <QtCore/QDebug>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 
 #include "Global/GlobalDefines.h"
 
@@ -52,6 +53,9 @@
 #include "Engine/KnobGuiI.h"
 #include "Engine/KnobTypes.h"
 
+// Minimum total number of keyframes of the curves restored by a KnobDeferredCurvesRestore_RAII to restore them concurrently
+#define NATRON_KNOB_CONCURRENT_CURVES_RESTORE_MIN_KEYFRAMES 1000
+
 SERIALIZATION_NAMESPACE_USING
 
 NATRON_NAMESPACE_ENTER;
@@ -957,6 +961,13 @@ KnobHelper::evaluateValueChangeInternal(DimSpec dimension,
 
     evaluatedKnobs->insert(thisShared);
 
+    if (reason != eValueChangedReasonTimeChanged) {
+        holder->onKnobSerializationInvalidated();
+
+        // The change may have added or removed animation or an expression
+        holder->invalidateTimeDependentKnobs();
+    }
+
     if (reason == eValueChangedReasonTimeChanged) {
         // Only notify gui must be refreshed when reason is time changed
         if (!isValueChangesBlocked()) {
@@ -2336,6 +2347,9 @@ KnobHelper::invalidateHashCacheInternal(std::set<HashableObject*>* invalidatedOb
     if (hasExpr) {
         clearExpressionsResults(DimSpec::all(), ViewSetSpec::all());
         refreshStaticValue(getCurrentRenderTime());
+
+        // The static value must be refreshed again on the next change of a dependency
+        notifyCacheFilled();
     }
     return HashableObject::invalidateHashCacheInternal(invalidatedObjects);
 }
@@ -3479,6 +3493,72 @@ KnobHelper::toSerialization(SerializationObjectBase* serializationBase)
 } // KnobHelper::toSerialization
 
 
+// The active KnobDeferredCurvesRestore_RAII, only accessed on the main thread
+static KnobDeferredCurvesRestore_RAII* activeDeferredCurvesRestore = 0;
+
+KnobDeferredCurvesRestore_RAII::KnobDeferredCurvesRestore_RAII()
+: _curves()
+, _nKeyframes(0)
+, _isActive(false)
+{
+    assert( QThread::currentThread() == qApp->thread() );
+    if (!activeDeferredCurvesRestore) {
+        activeDeferredCurvesRestore = this;
+        _isActive = true;
+    }
+}
+
+static void
+restoreDeferredCurve(const KnobDeferredCurvesRestore_RAII::DeferredCurve& deferred)
+{
+    deferred.curve->fromSerialization(*deferred.serialization);
+}
+
+KnobDeferredCurvesRestore_RAII::~KnobDeferredCurvesRestore_RAII()
+{
+    if (!_isActive) {
+        return;
+    }
+    activeDeferredCurvesRestore = 0;
+
+    // Below this amount of keyframes the cost of dispatching to the thread-pool is higher than restoring the curves
+    if ( (_curves.size() > 1) && (_nKeyframes >= NATRON_KNOB_CONCURRENT_CURVES_RESTORE_MIN_KEYFRAMES) ) {
+        QtConcurrent::blockingMap(_curves, restoreDeferredCurve);
+    } else {
+        for (std::vector<DeferredCurve>::const_iterator it = _curves.begin(); it != _curves.end(); ++it) {
+            restoreDeferredCurve(*it);
+        }
+    }
+
+    // Back on the main thread, do what KnobHelper::fromSerialization() does after restoring a knob
+    std::set<KnobHelper*> evaluatedKnobs;
+    for (std::vector<DeferredCurve>::const_iterator it = _curves.begin(); it != _curves.end(); ++it) {
+        it->knob->getSignalSlotHandler()->s_curveAnimationChanged(it->view, it->dimension);
+        it->knob->autoAdjustFoldExpandDimensions(it->view);
+        if ( evaluatedKnobs.insert( it->knob.get() ).second ) {
+            KnobHolderPtr holder = it->knob->getHolder();
+            TimeValue time = holder ? holder->getTimelineCurrentTime() : TimeValue(0);
+            it->knob->evaluateValueChange(DimSpec::all(), time, ViewSetSpec::all(), eValueChangedReasonRestoreDefault);
+        }
+    }
+} // ~KnobDeferredCurvesRestore_RAII
+
+KnobDeferredCurvesRestore_RAII*
+KnobDeferredCurvesRestore_RAII::getActiveInstance()
+{
+    if ( QThread::currentThread() != qApp->thread() ) {
+        return 0;
+    }
+    return activeDeferredCurvesRestore;
+}
+
+void
+KnobDeferredCurvesRestore_RAII::addCurve(const DeferredCurve& curve)
+{
+    _curves.push_back(curve);
+    _nKeyframes += curve.serialization->keys.size();
+}
+
 void
 KnobHelper::fromSerialization(const SerializationObjectBase& serializationBase)
 {
@@ -3689,8 +3769,19 @@ KnobHelper::fromSerialization(const SerializationObjectBase& serializationBase)
                 if (!it->second[d]._animationCurve.keys.empty()) {
                     CurvePtr curve = getAnimationCurve(view_i, dimensionIndex);
                     if (curve) {
-                        curve->fromSerialization(it->second[d]._animationCurve);
-                        _signalSlotHandler->s_curveAnimationChanged(view_i, dimensionIndex);
+                        KnobDeferredCurvesRestore_RAII* deferredRestore = KnobDeferredCurvesRestore_RAII::getActiveInstance();
+                        if (deferredRestore) {
+                            KnobDeferredCurvesRestore_RAII::DeferredCurve deferred;
+                            deferred.knob = toKnobHelper(shared_from_this());
+                            deferred.curve = curve;
+                            deferred.serialization = &it->second[d]._animationCurve;
+                            deferred.view = view_i;
+                            deferred.dimension = dimensionIndex;
+                            deferredRestore->addCurve(deferred);
+                        } else {
+                            curve->fromSerialization(it->second[d]._animationCurve);
+                            _signalSlotHandler->s_curveAnimationChanged(view_i, dimensionIndex);
+                        }
                     }
                 } else if (it->second[d]._expression.empty() && !it->second[d]._slaveMasterLink.hasLink) {
                     // restore value if no expression/link
@@ -4029,6 +4120,9 @@ KnobHelper::restoreKnobLinks(const boost::shared_ptr<SERIALIZATION_NAMESPACE::Kn
 
 typedef std::map<FrameViewRenderKey, KnobHolderPtr, FrameViewRenderKey_compare_less> RenderCloneMap;
 
+// The maximum number of render clones of a holder kept for re-use once their render is finished
+#define NATRON_RENDER_CLONES_POOL_MAX_SIZE 8
+
 struct KnobHolderCommonData
 {
     AppInstanceWPtr app;
@@ -4084,6 +4178,12 @@ struct KnobHolderCommonData
     mutable QMutex renderClonesMutex;
     RenderCloneMap renderClones;
 
+    // Render clones of finished renders that may be re-used by the next renders.
+    // They are only valid while the hash of the main instance is renderClonesPoolHash.
+    // Protected by renderClonesMutex
+    std::list<KnobHolderPtr> renderClonesPool;
+    U64 renderClonesPoolHash;
+
     KnobHolderCommonData()
     : app()
     , evaluationBlockedMutex(QMutex::Recursive)
@@ -4102,6 +4202,8 @@ struct KnobHolderCommonData
     , knobsTableParamBefore()
     , renderClonesMutex()
     , renderClones()
+    , renderClonesPool()
+    , renderClonesPoolHash(0)
     {
 
     }
@@ -4115,6 +4217,11 @@ struct KnobHolder::KnobHolderPrivate
 
     std::vector< KnobIPtr > knobs;
     std::map<std::string, KnobIWPtr> knobsOrdered;
+
+    // The knobs refreshed when the timeline time changes, see getTimeDependentKnobs().
+    // Recomputed when timeDependentKnobsValid is false. Protected by knobsMutex
+    mutable KnobsVec timeDependentKnobs;
+    mutable bool timeDependentKnobsValid;
     bool knobsInitialized;
     bool isInitializingKnobs;
 
@@ -4132,6 +4239,8 @@ struct KnobHolder::KnobHolderPrivate
     , knobsMutex()
     , knobs()
     , knobsOrdered()
+    , timeDependentKnobs()
+    , timeDependentKnobsValid(false)
     , knobsInitialized(false)
     , isInitializingKnobs(false)
     , mainInstance()
@@ -4146,6 +4255,8 @@ struct KnobHolder::KnobHolderPrivate
     , knobsMutex()
     , knobs()
     , knobsOrdered()
+    , timeDependentKnobs()
+    , timeDependentKnobsValid(false)
     , knobsInitialized(false)
     , isInitializingKnobs(false)
     , mainInstance()
@@ -4341,6 +4452,7 @@ KnobHolder::addKnob(const KnobIPtr& k)
             _imp->knobsOrdered[k->getName()] = k;
         }
         _imp->knobs.push_back(k);
+        _imp->timeDependentKnobsValid = false;
     }
 
 }
@@ -4360,6 +4472,7 @@ KnobHolder::insertKnob(int index,
         }
         _imp->knobsOrdered[k->getName()] = k;
     }
+    _imp->timeDependentKnobsValid = false;
 
     if ( index >= (int)_imp->knobs.size() ) {
         _imp->knobs.push_back(k);
@@ -4375,6 +4488,7 @@ KnobHolder::removeKnobFromList(const KnobIConstPtr& knob)
 {
     QMutexLocker kk(&_imp->knobsMutex);
 
+    _imp->timeDependentKnobsValid = false;
     for (KnobsVec::iterator it = _imp->knobs.begin(); it != _imp->knobs.end(); ++it) {
         if (*it == knob) {
             _imp->knobs.erase(it);
@@ -5176,6 +5290,48 @@ KnobHolder::removeRenderClone(const TreeRenderPtr& render)
     if (clones.empty()) {
         return false;
     }
+
+    // Keep the clones that can be re-used in the pool, the next renders will pick them up in createRenderClone()
+    // if the main instance did not change in-between.
+    std::list<KnobHolderPtr> clonesToPool, clonesToRemove;
+    for (std::list<KnobHolderPtr>::const_iterator it = clones.begin(); it != clones.end(); ++it) {
+        if ((*it)->isRenderCloneReusable()) {
+            clonesToPool.push_back(*it);
+        } else {
+            clonesToRemove.push_back(*it);
+        }
+    }
+    if (!clonesToPool.empty()) {
+        // Compute the hash before locking renderClonesMutex: computing the hash may create render clones
+        ComputeHashArgs hashArgs;
+        hashArgs.time = getTimelineCurrentTime();
+        hashArgs.view = ViewIdx(0);
+        hashArgs.hashType = HashableObject::eComputeHashTypeTimeViewInvariant;
+        U64 hash = computeHash(hashArgs);
+
+        QMutexLocker locker(&_imp->common->renderClonesMutex);
+        if (hash != _imp->common->renderClonesPoolHash) {
+            clonesToRemove.insert(clonesToRemove.end(), _imp->common->renderClonesPool.begin(), _imp->common->renderClonesPool.end());
+            _imp->common->renderClonesPool.clear();
+            _imp->common->renderClonesPoolHash = hash;
+        }
+        for (std::list<KnobHolderPtr>::const_iterator it = clonesToPool.begin(); it != clonesToPool.end(); ++it) {
+            if (_imp->common->renderClonesPool.size() >= NATRON_RENDER_CLONES_POOL_MAX_SIZE) {
+                clonesToRemove.push_back(*it);
+            } else {
+                _imp->common->renderClonesPool.push_back(*it);
+            }
+        }
+    }
+
+    removeKnobsRenderClones(clonesToRemove);
+
+    return true;
+}
+
+void
+KnobHolder::removeKnobsRenderClones(const std::list<KnobHolderPtr>& clones) const
+{
     for (std::list<KnobHolderPtr>::const_iterator it = clones.begin(); it != clones.end(); ++it) {
         // For each knob, remove the clone from the map
         for (std::size_t i = 0; i < _imp->knobs.size(); ++i) {
@@ -5187,8 +5343,18 @@ KnobHolder::removeRenderClone(const TreeRenderPtr& render)
             }
         }
     }
+} // removeKnobsRenderClones
 
-    return true;
+void
+KnobHolder::reuseRenderCopy(const FrameViewRenderKey& key)
+{
+    _imp->currentRender = key;
+
+    // The values read by the previous render may have changed since: animated values are not part
+    // of the hash that tells whether this clone can be re-used.
+    for (KnobsVec::const_iterator it = _imp->knobs.begin(); it != _imp->knobs.end(); ++it) {
+        (*it)->clearRenderValuesCache();
+    }
 }
 
 KnobHolderPtr
@@ -5203,7 +5369,48 @@ KnobHolder::createRenderClone(const FrameViewRenderKey& key) const
         }
     }
 
-    KnobHolderPtr copy = createRenderCopy(key);
+    // Look for a clone of a finished render that can be re-used.
+    // The pooled clones are only valid if the main instance hash was not invalidated since they were pooled.
+    // Do not wait for the hash to be computed here, this is done when clones are pooled in removeRenderClone().
+    KnobHolderPtr copy;
+    {
+        FindHashArgs findArgs;
+        findArgs.time = TimeValue(0);
+        findArgs.view = ViewIdx(0);
+        findArgs.hashType = HashableObject::eComputeHashTypeTimeViewInvariant;
+        U64 hash;
+        bool hashValid = findCachedHash(findArgs, &hash);
+
+        std::list<KnobHolderPtr> clonesToRemove;
+        {
+            QMutexLocker k(&_imp->common->renderClonesMutex);
+            if (!_imp->common->renderClonesPool.empty()) {
+                if (!hashValid || hash != _imp->common->renderClonesPoolHash) {
+                    clonesToRemove = _imp->common->renderClonesPool;
+                    _imp->common->renderClonesPool.clear();
+                } else {
+                    for (std::list<KnobHolderPtr>::iterator it = _imp->common->renderClonesPool.begin(); it != _imp->common->renderClonesPool.end(); ++it) {
+                        // Do not re-use a clone that is still referenced by its previous render.
+                        // If knobs were added to the main instance since, the clone is out of date.
+                        if (it->use_count() == 1 && (*it)->_imp->knobs.size() == _imp->knobs.size()) {
+                            copy = *it;
+                            _imp->common->renderClonesPool.erase(it);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        removeKnobsRenderClones(clonesToRemove);
+    }
+    if (copy) {
+        copy->reuseRenderCopy(key);
+        QMutexLocker k(&_imp->common->renderClonesMutex);
+        _imp->common->renderClones[key] = copy;
+        return copy;
+    }
+
+    copy = createRenderCopy(key);
     if (!copy) {
         return copy;
     }
@@ -5256,8 +5463,10 @@ KnobHolder::refreshAfterTimeChange(bool isPlayback,
     if ( !app || app->isGuiFrozen() ) {
         return;
     }
-    for (std::size_t i = 0; i < _imp->knobs.size(); ++i) {
-        _imp->knobs[i]->onTimeChanged(isPlayback, time);
+    KnobsVec knobs;
+    getTimeDependentKnobs(&knobs);
+    for (std::size_t i = 0; i < knobs.size(); ++i) {
+        knobs[i]->onTimeChanged(isPlayback, time);
     }
     if (_imp->common->knobsTable) {
         _imp->common->knobsTable->refreshAfterTimeChange(isPlayback, time);
@@ -5265,6 +5474,29 @@ KnobHolder::refreshAfterTimeChange(bool isPlayback,
     refreshExtraStateAfterTimeChanged(isPlayback, time);
 }
 
+void
+KnobHolder::getTimeDependentKnobs(KnobsVec* knobs) const
+{
+    QMutexLocker k(&_imp->knobsMutex);
+    if (!_imp->timeDependentKnobsValid) {
+        _imp->timeDependentKnobs.clear();
+        for (KnobsVec::const_iterator it = _imp->knobs.begin(); it != _imp->knobs.end(); ++it) {
+            if ( (*it)->evaluateValueChangeOnTimeChange() || (*it)->hasAnimation() ) {
+                _imp->timeDependentKnobs.push_back(*it);
+            }
+        }
+        _imp->timeDependentKnobsValid = true;
+    }
+    *knobs = _imp->timeDependentKnobs;
+}
+
+void
+KnobHolder::invalidateTimeDependentKnobs()
+{
+    QMutexLocker k(&_imp->knobsMutex);
+    _imp->timeDependentKnobsValid = false;
+}
+
 TimeValue
 KnobHolder::getTimelineCurrentTime() const
 {
@@ -5301,9 +5533,11 @@ void
 KnobHolder::refreshAfterTimeChangeOnlyKnobsWithTimeEvaluation(TimeValue time)
 {
     assert( QThread::currentThread() == qApp->thread() );
-    for (std::size_t i = 0; i < _imp->knobs.size(); ++i) {
-        if ( _imp->knobs[i]->evaluateValueChangeOnTimeChange() ) {
-            _imp->knobs[i]->onTimeChanged(false, time);
+    KnobsVec knobs;
+    getTimeDependentKnobs(&knobs);
+    for (std::size_t i = 0; i < knobs.size(); ++i) {
+        if ( knobs[i]->evaluateValueChangeOnTimeChange() ) {
+            knobs[i]->onTimeChanged(false, time);
         }
     }
 }
@@ -5415,9 +5649,12 @@ KnobHolder::getHasAnimation() const
 void
 KnobHolder::setHasAnimation(bool hasAnimation)
 {
-    QMutexLocker k(&_imp->common->hasAnimationMutex);
+    {
+        QMutexLocker k(&_imp->common->hasAnimationMutex);
 
-    _imp->common->hasAnimation = hasAnimation;
+        _imp->common->hasAnimation = hasAnimation;
+    }
+    invalidateTimeDependentKnobs();
 }
 
 void
@@ -5434,9 +5671,12 @@ KnobHolder::updateHasAnimation()
             }
         }
     }
-    QMutexLocker k(&_imp->common->hasAnimationMutex);
+    {
+        QMutexLocker k(&_imp->common->hasAnimationMutex);
 
-    _imp->common->hasAnimation = hasAnimation;
+        _imp->common->hasAnimation = hasAnimation;
+    }
+    invalidateTimeDependentKnobs();
 }
 
 void
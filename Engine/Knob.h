@@ -673,6 +673,12 @@ public:
      **/
     virtual double getValueAtWithExpression(TimeValue time, ViewIdx view, DimIdx dimension) = 0;
 
+    /**
+     * @brief Same as getValueAtWithExpression for several times at once. A Python expression is evaluated at all times
+     * with a single lock of the Python interpreter, which is much faster than calling getValueAtWithExpression for each time.
+     **/
+    virtual void getValuesAtWithExpression(const std::vector<TimeValue>& times, ViewIdx view, DimIdx dimension, std::vector<double>* values) = 0;
+
     /**
      * @brief Set an expression on the knob. If this expression is invalid, this function throws an excecption with the error from the
      * Python interpreter or exprTK compiler
@@ -1798,6 +1804,22 @@ protected:
     ///The return value must be Py_DECRREF
     bool executePythonExpression(TimeValue time, ViewIdx view, DimIdx dimension, PyObject** ret, std::string* error) const;
 
+    /**
+     * @brief Same as executePythonExpression for several times: the expression function is looked up once and then called
+     * for each time, instead of parsing a new script for each time. Each returned value must be Py_DECRREF.
+     * If the expression fails at any time, this returns false and rets is empty.
+     **/
+    bool executePythonExpressionAtTimes(const std::vector<TimeValue>& times, ViewIdx view, DimIdx dimension, std::vector<PyObject*>* rets, std::string* error) const;
+
+    /**
+     * @brief Evaluates the Python expression of the given dimension and view at all the given times with executePythonExpressionAtTimes().
+     * This returns false if the results should instead be computed by evaluating the expression for each time separately:
+     * if the expression is not evaluated by Python, if its results are cached, if it is called recursively or if it failed,
+     * in which case the evaluation for each time reports the error.
+     * The Python GIL must be held by the caller.
+     **/
+    bool evaluatePythonExpressionAtTimes(const std::vector<TimeValue>& times, ViewIdx view, DimIdx dimension, std::vector<PyObject*>* rets);
+
 public:
 
     enum ExpressionReturnValueTypeEnum
@@ -1810,6 +1832,12 @@ protected:
     
     ExpressionReturnValueTypeEnum executeExprTkExpression(TimeValue time, ViewIdx view, DimIdx dimension, double* retValueIsScalar, std::string* retValueIsString, std::string* error);
 
+    /**
+     * @brief Returns the language with which the expression is evaluated. This is exprtk for Python expressions
+     * that could be translated to exprtk, otherwise this is the same as getExpressionLanguage().
+     **/
+    ExpressionLanguageEnum getExpressionEvaluationLanguage(ViewIdx view, DimIdx dimension) const WARN_UNUSED_RETURN;
+
     /// The return value must be Py_DECRREF
     /// The expression must put its result in the Python variable named "ret"
     static bool executePythonExpression(const std::string& expr, PyObject** ret, std::string* error);
@@ -1926,6 +1954,44 @@ toKnobHelper(const KnobIPtr& knob)
     return boost::dynamic_pointer_cast<KnobHelper>(knob);
 }
 
+/**
+ * @brief While an instance of this class exists on the main thread, KnobHelper::fromSerialization() does not
+ * restore the animation curves itself: they are all restored concurrently when the outermost instance is destroyed.
+ * Restoring a curve only touches the curve, and it is the bulk of the work when loading nodes with a
+ * lot of animation, such as Roto or Tracker nodes.
+ * Nothing should read the animation of the restored knobs until this object is destroyed.
+ **/
+class KnobDeferredCurvesRestore_RAII
+{
+public:
+
+    struct DeferredCurve
+    {
+        KnobHelperPtr knob;
+        CurvePtr curve;
+        const SERIALIZATION_NAMESPACE::CurveSerialization* serialization;
+        ViewIdx view;
+        DimIdx dimension;
+    };
+
+    KnobDeferredCurvesRestore_RAII();
+
+    ~KnobDeferredCurvesRestore_RAII();
+
+    /**
+     * @brief Returns the active instance if called on the main thread while an instance exists, or NULL
+     **/
+    static KnobDeferredCurvesRestore_RAII* getActiveInstance();
+
+    void addCurve(const DeferredCurve& curve);
+
+private:
+
+    std::vector<DeferredCurve> _curves;
+    std::size_t _nKeyframes;
+    bool _isActive;
+};
+
 struct DimTimeView
 {
     TimeValue time;
@@ -2021,6 +2087,15 @@ public:
      **/
     virtual T getValueAtTime(TimeValue time, DimIdx dimension = DimIdx(0), ViewIdx view = ViewIdx(0), bool clampToMinMax = true)  WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Same as getValueAtTime for each time in times: values[i] is the value at times[i].
+     * This is faster than calling getValueAtTime for each time: the knob is looked up once for all times
+     * and the animation curve is evaluated in a single call, see Curve::getValuesAt.
+     * Times sorted by increasing order are evaluated faster.
+     * Note that an expression is still evaluated for each time.
+     **/
+    void getValuesAtTimes(const std::vector<TimeValue>& times, DimIdx dimension, ViewIdx view, bool clampToMinMax, std::vector<T>* values);
+
     /**
      * @brief Same as getValueAtTime excepts that it ignores expression, hard-links (slave/master) and doesn't clamp to min/max.
      * This is useful to display the internal curve on the Curve Editor
@@ -2038,6 +2113,8 @@ public:
      **/
     virtual double getValueAtWithExpression(TimeValue time, ViewIdx view, DimIdx dimension)  OVERRIDE FINAL WARN_UNUSED_RETURN;
 
+    virtual void getValuesAtWithExpression(const std::vector<TimeValue>& times, ViewIdx view, DimIdx dimension, std::vector<double>* values) OVERRIDE FINAL;
+
 public:
 
     virtual void appendToHash(const ComputeHashArgs& args, Hash64* hash) OVERRIDE;
@@ -2045,6 +2122,12 @@ public:
 
     virtual T getValueForHash(DimIdx dim, ViewIdx view);
 
+protected:
+
+    virtual bool isHashTimeInvariant(ViewIdx view) const OVERRIDE;
+
+public:
+
     //////////// Overriden from AnimatingObjectI
     virtual KeyframeDataTypeEnum getKeyFrameDataType() const OVERRIDE FINAL;
 
@@ -2332,6 +2415,7 @@ public:
         if (_valuesCache) {
             _valuesCache->clear();
         }
+        refreshRenderValuesSnapshot();
     }
 
     virtual void clearExpressionsResults(DimSpec dimension, ViewSetSpec view) OVERRIDE FINAL;
@@ -2434,6 +2518,48 @@ private:
 
     typedef std::map<DimTimeView, T, ValueDimTimeViewCompareLess> ValuesCacheMap;
 
+    /**
+     * @brief The value of a dimension/view of a render clone, copied from the main instance when the clone
+     * was created.
+     **/
+    struct RenderValueSnapshot
+    {
+        // False if the value cannot be read from the snapshot, e.g: if it has an expression
+        bool valid;
+
+        // The static value and the same value clamped to the min/max
+        T value, clampedValue;
+
+        // If the dimension/view is animated, an immutable copy of its animation curve
+        CurveSnapshotConstPtr curve;
+
+        RenderValueSnapshot()
+        : valid(false)
+        , value()
+        , clampedValue()
+        , curve()
+        {
+
+        }
+    };
+
+    // For each dimension, the snapshot of each view
+    typedef std::vector<std::map<ViewIdx, RenderValueSnapshot> > RenderValuesSnapshot;
+
+    /**
+     * @brief On a render clone, copies the values and animation curves of all dimensions/views to _renderValuesSnapshot.
+     * This must be called while no render thread uses the clone.
+     **/
+    void refreshRenderValuesSnapshot();
+
+    /**
+     * @brief Returns the snapshot of the given dimension/view, or NULL if the value must be read from the knob.
+     * This does not take any lock.
+     **/
+    const RenderValueSnapshot* getRenderValueSnapshot(DimIdx dimension, ViewIdx view) const;
+
+    T getValueFromRenderValueSnapshot(const RenderValueSnapshot& snapshot, TimeValue time, bool clamp) const;
+
 
     struct Data
     {
@@ -2472,6 +2598,11 @@ private:
     // consistant throughout a render.
     boost::scoped_ptr<ValuesCacheMap> _valuesCache;
 
+    // Used only on render clones: the values are read from here without locking while rendering.
+    // It is taken when the clone is created or re-used for another render and is never modified while a render
+    // uses the clone: a value changed on the main instance is only seen by the renders launched afterwards.
+    boost::scoped_ptr<const RenderValuesSnapshot> _renderValuesSnapshot;
+
     // The Data pointer is shared accross the "main" instance and the render clones.
     boost::shared_ptr<Data> _data;
 
@@ -2741,6 +2872,19 @@ public:
 
     void refreshAfterTimeChange(bool isPlayback, TimeValue time);
 
+    /**
+     * @brief Returns the knobs that must be refreshed when the timeline time changes: the animated or expression-driven knobs
+     * and the knobs whose function evaluateValueChangeOnTimeChange() return true.
+     * The list is cached so that a time change does not visit all knobs of all nodes, and recomputed after a call
+     * to invalidateTimeDependentKnobs().
+     **/
+    void getTimeDependentKnobs(KnobsVec* knobs) const;
+
+    /**
+     * @brief Must be called whenever the animation or expression of a knob of this holder may have changed
+     **/
+    void invalidateTimeDependentKnobs();
+
     virtual TimeValue getTimelineCurrentTime() const;
 
     /**
@@ -2958,6 +3102,13 @@ public:
      **/
     virtual bool onKnobValueChanged_public(const KnobIPtr& k, ValueChangedReasonEnum reason, TimeValue time, ViewSetSpec view);
 
+    /**
+     * @brief Called whenever the value, animation or expression of a knob of this holder was modified,
+     * on any thread and even if value changes are blocked. Implement to invalidate anything derived from
+     * the serialization of the knobs.
+     **/
+    virtual void onKnobSerializationInvalidated() {}
+
 
 
     /*Add a knob to the vector. This is called by the
@@ -3080,6 +3231,27 @@ protected:
      * Derived implementation should call base-class version
      **/
     virtual void fetchRenderCloneKnobs();
+
+    /**
+     * @brief Returns true if this render clone may be kept once its render is finished to be re-used by a later render,
+     * as long as the hash of the main instance does not change. Clones holding state tied to the render that created them
+     * must return false.
+     **/
+    virtual bool isRenderCloneReusable() const
+    {
+        return false;
+    }
+
+    /**
+     * @brief Called on a render clone returned by isRenderCloneReusable() when it is re-used for another render,
+     * instead of creating a new copy with createRenderCopy(). The knobs of the clone are already initialized.
+     * Derived implementation should call base-class version
+     **/
+    virtual void reuseRenderCopy(const FrameViewRenderKey& key);
+
+private:
+
+    void removeKnobsRenderClones(const std::list<KnobHolderPtr>& clones) const;
 };
 
 
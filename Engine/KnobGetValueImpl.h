@@ -77,7 +77,7 @@ Knob<T>::getValueFromExpression(TimeValue time,
         }
         std::string error;
         if (!exprOk) {
-            if (getExpressionLanguage(view, dimension) == eExpressionLanguagePython) {
+            if (getExpressionEvaluationLanguage(view, dimension) == eExpressionLanguagePython) {
                 EffectInstancePtr effect = toEffectInstance(getHolder());
                 if (effect) {
                     appPTR->setLastPythonAPICaller_TLS(effect);
@@ -88,6 +88,7 @@ Knob<T>::getValueFromExpression(TimeValue time,
             if (exprOk && cachingEnabled) {
                 QMutexLocker k(&_data->expressionResultsMutex);
                 _data->expressionResults[dimension][view].insert(std::make_pair(key, *ret));
+                notifyCacheFilled();
             }
         }
         if (!exprOk) {
@@ -194,6 +195,7 @@ Knob<T>::getValueFromExpression_pod(TimeValue time,
             if (exprOk && cachingEnabled) {
                 QMutexLocker k(&_data->expressionResultsMutex);
                 _data->expressionResults[dimension][view].insert(std::make_pair(key, (T)*ret));
+                notifyCacheFilled();
             }
         }
         if (!exprOk) {
@@ -216,6 +218,51 @@ Knob<T>::getValueFromExpression_pod(TimeValue time,
     return true;
 } // getValueFromExpression_pod
 
+template <typename T>
+const typename Knob<T>::RenderValueSnapshot*
+Knob<T>::getRenderValueSnapshot(DimIdx dimension,
+                                ViewIdx view) const
+{
+    if (!_renderValuesSnapshot) {
+        return 0;
+    }
+    const std::map<ViewIdx, RenderValueSnapshot>& viewsSnapshot = (*_renderValuesSnapshot)[dimension];
+
+    // If the view is not split, fallback on the main view, as checkIfViewExistsOrFallbackMainView() does
+    typename std::map<ViewIdx, RenderValueSnapshot>::const_iterator found = viewsSnapshot.find(view);
+    if ( found == viewsSnapshot.end() ) {
+        found = viewsSnapshot.find( ViewIdx(0) );
+        if ( found == viewsSnapshot.end() ) {
+            return 0;
+        }
+    }
+    return found->second.valid ? &found->second : 0;
+} // getRenderValueSnapshot
+
+template <typename T>
+T
+Knob<T>::getValueFromRenderValueSnapshot(const RenderValueSnapshot& snapshot,
+                                         TimeValue time,
+                                         bool clamp) const
+{
+    if (snapshot.curve) {
+        //getValueAt already clamps to the range for us
+        return (T)snapshot.curve->getValueAt(time, clamp);
+    }
+    return clamp ? snapshot.clampedValue : snapshot.value;
+}
+
+template <>
+std::string
+KnobStringBase::getValueFromRenderValueSnapshot(const RenderValueSnapshot& snapshot,
+                                                TimeValue /*time*/,
+                                                bool /*clamp*/) const
+{
+    // Animated strings are never read from the snapshot
+    assert(!snapshot.curve);
+    return snapshot.value;
+}
+
 template <typename T>
 T
 Knob<T>::getValueInternal(TimeValue tlsCurrentTime,
@@ -264,6 +311,12 @@ Knob<T>::getValue(DimIdx dimension,
         throw std::invalid_argument("Knob::getValue: dimension out of range");
     }
 
+    // On a render clone, read the value copied when the render started without locking
+    const RenderValueSnapshot* snapshot = getRenderValueSnapshot(dimension, view);
+    if (snapshot) {
+        return getValueFromRenderValueSnapshot(*snapshot, getCurrentRenderTime(), clamp);
+    }
+
 
 
     // Figure out the view to read
@@ -429,6 +482,51 @@ Knob<T>::getValueAtWithExpression(TimeValue time,
     return getRawCurveValueAt(time, view, dimension);
 } // getValueAtWithExpression
 
+template <typename T>
+void
+Knob<T>::getValuesAtWithExpression(const std::vector<TimeValue>& times,
+                                   ViewIdx view,
+                                   DimIdx dimension,
+                                   std::vector<double>* values)
+{
+    values->resize( times.size() );
+    if ( times.empty() ) {
+        return;
+    }
+
+    bool exprValid = isExpressionValid(dimension, view, 0);
+    std::string expr = getExpression(dimension, view);
+    if (!expr.empty() && exprValid) {
+        PythonGILLocker pgl;
+        std::vector<PyObject*> rets;
+        if ( evaluatePythonExpressionAtTimes(times, view, dimension, &rets) ) {
+            assert( rets.size() == times.size() );
+            for (std::size_t i = 0; i < rets.size(); ++i) {
+                PyObject* ret = rets[i];
+                if ( PyFloat_Check(ret) ) {
+                    (*values)[i] = (double)PyFloat_AsDouble(ret);
+                } else if ( PyInt_Check(ret) ) {
+                    (*values)[i] = (int)PyInt_AsLong(ret);
+                } else if ( PyLong_Check(ret) ) {
+                    (*values)[i] = (int)PyLong_AsLong(ret);
+                } else if (PyObject_IsTrue(ret) == 1) {
+                    (*values)[i] = 1;
+                } else {
+                    //Strings should always fall here
+                    (*values)[i] = 0.;
+                }
+                Py_DECREF(ret); //< new ref
+            }
+
+            return;
+        }
+    }
+
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        (*values)[i] = getValueAtWithExpression(times[i], view, dimension);
+    }
+} // getValuesAtWithExpression
+
 template<typename T>
 T
 Knob<T>::getValueAtTime(TimeValue time,
@@ -441,6 +539,12 @@ Knob<T>::getValueAtTime(TimeValue time,
         throw std::invalid_argument("Knob::getValueAtTime: dimension out of range");
     }
 
+    // On a render clone, read the value copied when the render started without locking
+    const RenderValueSnapshot* snapshot = getRenderValueSnapshot(dimension, view);
+    if (snapshot) {
+        return getValueFromRenderValueSnapshot(*snapshot, time, clamp);
+    }
+
 
     // Figure out the view to read
     ViewIdx view_i = checkIfViewExistsOrFallbackMainView(view);
@@ -492,6 +596,89 @@ Knob<T>::getValueAtTime(TimeValue time,
     return getValueInternal(time, dimension, view_i, clamp);
 } // getValueAtTime
 
+template<typename T>
+void
+Knob<T>::getValuesAtTimes(const std::vector<TimeValue>& times,
+                          DimIdx dimension,
+                          ViewIdx view,
+                          bool clamp,
+                          std::vector<T>* values)
+{
+    if  ( ( dimension >= getNDimensions() ) || (dimension < 0) ) {
+        throw std::invalid_argument("Knob::getValuesAtTimes: dimension out of range");
+    }
+    values->resize( times.size() );
+    if ( times.empty() ) {
+        return;
+    }
+
+    // On a render clone, read the value copied when the render started without locking
+    const RenderValueSnapshot* snapshot = getRenderValueSnapshot(dimension, view);
+    if (snapshot) {
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            (*values)[i] = getValueFromRenderValueSnapshot(*snapshot, times[i], clamp);
+        }
+        return;
+    }
+
+    ViewIdx view_i = checkIfViewExistsOrFallbackMainView(view);
+
+    // The expression must be evaluated at each time
+    if ( hasExpression(dimension, view_i) ) {
+        // Python expressions are evaluated at all times with a single lock of the interpreter
+        {
+            PythonGILLocker pgl;
+            std::vector<PyObject*> rets;
+            if ( evaluatePythonExpressionAtTimes(times, view_i, dimension, &rets) ) {
+                assert( rets.size() == times.size() );
+                for (std::size_t i = 0; i < rets.size(); ++i) {
+                    (*values)[i] = pyObjectToType<T>(rets[i], view_i);
+                    Py_DECREF(rets[i]); //< new ref
+                    if (clamp) {
+                        (*values)[i] = clampToMinMax( (*values)[i], dimension );
+                    }
+                }
+
+                return;
+            }
+        }
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            (*values)[i] = getValueAtTime(times[i], dimension, view_i, clamp);
+        }
+        return;
+    }
+
+    CurvePtr curve = getAnimationCurve(view_i, dimension);
+    if ( curve && (curve->getKeyFramesCount() > 0) ) {
+        //getValuesAt already clamps to the range for us
+        std::vector<double> curveValues;
+        curve->getValuesAt(times, clamp, &curveValues);
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            (*values)[i] = (T)curveValues[i];
+        }
+        return;
+    }
+
+    // Not animated: the value is the same at all times
+    T value = getValueInternal(times[0], dimension, view_i, clamp);
+    std::fill(values->begin(), values->end(), value);
+} // getValuesAtTimes
+
+template<>
+void
+KnobStringBase::getValuesAtTimes(const std::vector<TimeValue>& times,
+                                 DimIdx dimension,
+                                 ViewIdx view,
+                                 bool clamp,
+                                 std::vector<std::string>* values)
+{
+    // Strings may have a custom interpolation and getValueAtTime may be overriden (e.g: KnobFile)
+    values->resize( times.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        (*values)[i] = getValueAtTime(times[i], dimension, view, clamp);
+    }
+} // getValuesAtTimes
+
 
 template<typename T>
 double
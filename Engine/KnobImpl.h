@@ -511,7 +511,7 @@ Knob<T>::evaluateExpression(TimeValue time,
         throw std::invalid_argument("KnobHelper::evaluateExpression(): Dimension out of range");
     }
 
-    ExpressionLanguageEnum lang = getExpressionLanguage(view, dimension);
+    ExpressionLanguageEnum lang = getExpressionEvaluationLanguage(view, dimension);
     switch (lang) {
         case eExpressionLanguagePython: {
             PythonGILLocker pgl;
@@ -552,7 +552,7 @@ Knob<T>::evaluateExpression_pod(TimeValue time,
         throw std::invalid_argument("KnobHelper::evaluateExpression_pod(): Dimension out of range");
     }
 
-    ExpressionLanguageEnum lang = getExpressionLanguage(view, dimension);
+    ExpressionLanguageEnum lang = getExpressionEvaluationLanguage(view, dimension);
     switch (lang) {
         case eExpressionLanguagePython: {
             PythonGILLocker pgl;
@@ -958,7 +958,10 @@ Knob<T>::populate()
     KnobHelper::populate();
 
     if (getHolder() && getHolder()->isRenderClone()) {
+        // The data is shared with the main instance which is already initialized
         _valuesCache.reset(new ValuesCacheMap);
+        refreshRenderValuesSnapshot();
+        return;
     }
     int nDims = getNDimensions();
     _data->expressionResults.resize(nDims);
@@ -972,6 +975,50 @@ Knob<T>::populate()
 
 }
 
+template<typename T>
+void
+Knob<T>::refreshRenderValuesSnapshot()
+{
+    KnobHolderPtr holder = getHolder();
+    if ( !holder || !holder->isRenderClone() ) {
+        return;
+    }
+
+    int nDims = getNDimensions();
+    std::list<ViewIdx> views = getViewsList();
+    boost::scoped_ptr<RenderValuesSnapshot> snapshot(new RenderValuesSnapshot(nDims));
+    for (int i = 0; i < nDims; ++i) {
+        for (std::list<ViewIdx>::const_iterator it = views.begin(); it != views.end(); ++it) {
+            RenderValueSnapshot& viewSnapshot = (*snapshot)[i][*it];
+
+            // Expressions are evaluated for each render time, they are read from the knob
+            if ( hasExpression(DimIdx(i), *it) ) {
+                continue;
+            }
+            ValueKnobDimView<T>* data = dynamic_cast<ValueKnobDimView<T>*>(getDataForDimView(DimIdx(i), *it).get());
+            if (!data) {
+                continue;
+            }
+            CurvePtr curve;
+            {
+                QMutexLocker k(&data->valueMutex);
+                viewSnapshot.value = data->value;
+                curve = data->animationCurve;
+            }
+            if ( curve && curve->isAnimated() ) {
+                // Animated strings may have a custom interpolation
+                if (curve->getType() == Curve::eCurveTypeString) {
+                    continue;
+                }
+                viewSnapshot.curve = curve->createEvaluationSnapshot();
+            }
+            viewSnapshot.clampedValue = clampToMinMax(viewSnapshot.value, DimIdx(i));
+            viewSnapshot.valid = true;
+        }
+    }
+    _renderValuesSnapshot.reset( snapshot.release() );
+} // refreshRenderValuesSnapshot
+
 template<typename T>
 bool
 Knob<T>::isTypePOD() const
@@ -1239,6 +1286,25 @@ Knob<T>::appendToHash(const ComputeHashArgs& args, Hash64* hash)
     }
 } // appendToHash
 
+template <typename T>
+bool
+Knob<T>::isHashTimeInvariant(ViewIdx view) const
+{
+    // Without animation the value appended by appendToHash is the same at all times.
+    // An expression may depend on the frame.
+    if ( hasAnyExpression() ) {
+        return false;
+    }
+    int nDims = getNDimensions();
+    for (int i = 0; i < nDims; ++i) {
+        if ( isAnimated(DimIdx(i), view) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 template <>
 AnimatingObjectI::KeyframeDataTypeEnum
 Knob<int>::getKeyFrameDataType() const
@@ -25,6 +25,7 @@
 
 #include "KnobItemsTable.h"
 
+#include <algorithm> // find
 #include <sstream> // stringstream
 
 #include <QMutex>
@@ -470,6 +471,11 @@ KnobItemsTable::insertItem(int index, const KnobTableItemPtr& item, const KnobTa
 
     item->onItemInsertedInModel_recursive();
 
+    NodePtr node = getNode();
+    if (node) {
+        node->invalidateAutoSaveSerialization();
+    }
+
     Q_EMIT itemInserted(index, item, reason);
     
 }
@@ -496,6 +502,10 @@ KnobItemsTable::removeItem(const KnobTableItemPtr& item, TableChangeReasonEnum r
         }
     }
     if (removed) {
+        NodePtr node = getNode();
+        if (node) {
+            node->invalidateAutoSaveSerialization();
+        }
         Q_EMIT itemRemoved(item, reason);
 
         if (!getPythonPrefix().empty()) {
@@ -716,6 +726,19 @@ KnobTableItem::evaluate(bool isSignificant, bool refreshMetadata)
     node->getEffectInstance()->evaluate(isSignificant, refreshMetadata);
 }
 
+void
+KnobTableItem::onKnobSerializationInvalidated()
+{
+    KnobItemsTablePtr model = getModel();
+    if (!model) {
+        return;
+    }
+    NodePtr node = model->getNode();
+    if (node) {
+        node->invalidateAutoSaveSerialization();
+    }
+}
+
 void
 KnobTableItem::setLabel(const std::string& label, TableChangeReasonEnum reason)
 {
@@ -2717,13 +2740,17 @@ KnobItemsTable::fromSerialization(const SERIALIZATION_NAMESPACE::SerializationOb
 void
 KnobTableItem::refreshAfterTimeChange(bool isPlayback, TimeValue time)
 {
+    // Only the animated or expression-driven knobs need to be refreshed
+    KnobsVec timeDependentKnobs;
+    getTimeDependentKnobs(&timeDependentKnobs);
+
     // Since the same  knob may appear across multiple columns, ensure it is refreshed once
     std::set<KnobIPtr> updatedKnobs;
 
     QMutexLocker k(&_imp->common->lock);
-    for (std::size_t i = 0; i < _imp->common->columns.size(); ++i) {
+    for (std::size_t i = 0; !timeDependentKnobs.empty() && i < _imp->common->columns.size(); ++i) {
         KnobIPtr colKnob = _imp->common->columns[i].knob.lock();
-        if (colKnob) {
+        if ( colKnob && ( std::find(timeDependentKnobs.begin(), timeDependentKnobs.end(), colKnob) != timeDependentKnobs.end() ) ) {
             std::pair<std::set<KnobIPtr>::iterator, bool> ok = updatedKnobs.insert(colKnob);
             if (ok.second) {
                 colKnob->onTimeChanged(isPlayback, time);
@@ -449,6 +449,12 @@ protected:
      **/
     virtual void evaluate(bool isSignificant, bool refreshMetadata) OVERRIDE;
 
+    /**
+     * @brief Reimplemented from KnobHolder.
+     * Items are serialized with the node holding the model: this invalidates its auto-save serialization.
+     **/
+    virtual void onKnobSerializationInvalidated() OVERRIDE FINAL;
+
     /**
      * @brief Refresh all animated knobs and recurses on children items
      **/
@@ -112,13 +112,20 @@ public:
     // The knobs/dimension/view we depend on in the expression
     KnobDimViewKeySet dependencies;
 
+    // The expression function defined by validatePythonExpression(), looked up on the first evaluation so that
+    // evaluating the expression is a single call instead of compiling and running a script.
+    // Only read and written with the Python GIL held.
+    PyObject* function;
+
     KnobExprPython()
     : hasRet(false)
+    , dependencies()
+    , function(0)
     {
 
     }
 
-    virtual ~KnobExprPython() {}
+    virtual ~KnobExprPython();
 };
 
 struct EffectFunctionDependency;
@@ -144,6 +151,10 @@ public:
     // effect dependencies mapped against their variable name in the expression
     std::map<std::string, EffectFunctionDependency> effectDependencies;
 
+    // The expression compiled by exprtk. This is different from expressionString if this
+    // is a Python expression that was translated to exprtk
+    std::string exprtkExpression;
+
     KnobExprExprTk()
     {
 
@@ -495,6 +506,13 @@ struct KnobHelperPrivate
     std::string validatePythonExpression(const std::string& expression, DimIdx dimension, ViewIdx view, bool hasRetVariable, std::string* resultAsString) const;
     void validateExprTkExpression(const std::string& expression, DimIdx dimension, ViewIdx view, std::string* resultAsString, KnobExprExprTk* ret) const;
 
+    /**
+     * @brief Translates a single-line Python expression to exprtk so that it can be evaluated without taking the Python GIL.
+     * Only the common forms are recognized (parameter values, frame arithmetic, math functions), see PythonToExprTkTranslator.
+     * @returns False if the expression cannot be translated, in which case it must be run by Python.
+     **/
+    bool translatePythonExpressionToExprTk(const std::string& expression, DimIdx dimension, ViewIdx view, std::string* exprtkExpression) const;
+
 
 
     void parseListenersFromExpression(DimIdx dimension, ViewIdx view);
@@ -506,6 +524,13 @@ struct KnobHelperPrivate
      **/
     std::string getReachablePythonAttributesForExpression(bool addTab, DimIdx dimension, ViewIdx view) const;
 
+    /**
+     * @brief Returns a new reference to the function of the Python expression at the given dimension/view, or NULL
+     * if there is no Python expression or the function could not be found, in which case the error is returned in error.
+     * The Python GIL must be held.
+     **/
+    PyObject* getPythonExpressionFunction(DimIdx dimension, ViewIdx view, std::string* error) const;
+
 
 };
 
@@ -650,6 +650,9 @@ KnobButton::trigger()
 // don't show help in the tootlip if there are more entries that this
 #define KNOBCHOICE_MAX_ENTRIES_HELP 40
 
+// The number of samples of the lookup table of parametric curves, see KnobParametric::getCurveLUT()
+#define NATRON_PARAMETRIC_CURVE_LUT_SIZE 4096
+
 ChoiceKnobDimView::ChoiceKnobDimView()
 : ValueKnobDimView<int>()
 , menuOptions()
@@ -2667,11 +2670,18 @@ struct KnobParametricSharedData
     std::vector< CurvePtr >  defaultCurves;
     std::vector<RGBAColourD> curvesColor;
 
+    // Protects curveLUTs
+    mutable QMutex curveLUTsMutex;
+
+    // The last lookup table built for each dimension, shared with render clones
+    std::vector<ParametricCurveLUTConstPtr> curveLUTs;
 
     KnobParametricSharedData(int dimension)
     : curvesMutex()
     , defaultCurves(dimension)
     , curvesColor(dimension)
+    , curveLUTsMutex()
+    , curveLUTs(dimension)
     {
 
     }
@@ -2682,6 +2692,9 @@ struct KnobParametricSharedData
 struct KnobParametricRenderCurves
 {
     std::vector<CurvePtr> curves;
+
+    // The curves of a render clone do not change during the render: the lookup tables do not need to be checked again
+    std::vector<ParametricCurveLUTConstPtr> curveLUTs;
 };
 
 struct KnobParametricPrivate
@@ -2715,6 +2728,7 @@ KnobParametric::KnobParametric(const KnobHolderPtr& holder, const KnobIPtr& main
 {
     _imp->renderLocalCurves.reset(new KnobParametricRenderCurves);
     _imp->renderLocalCurves->curves.resize(getNDimensions());
+    _imp->renderLocalCurves->curveLUTs.resize(getNDimensions());
     _imp->common = toKnobParametric(mainInstance)->_imp->common;
 }
 
@@ -2862,9 +2876,12 @@ KnobParametric::getDefaultParametricCurve(DimIdx dimension) const
 void
 KnobParametric::clearRenderValuesCache()
 {
+    KnobDoubleBase::clearRenderValuesCache();
     if (_imp->renderLocalCurves) {
         _imp->renderLocalCurves->curves.clear();
         _imp->renderLocalCurves->curves.resize(getNDimensions());
+        _imp->renderLocalCurves->curveLUTs.clear();
+        _imp->renderLocalCurves->curveLUTs.resize(getNDimensions());
     }
 }
 
@@ -2999,6 +3016,88 @@ KnobParametric::evaluateCurve(DimIdx dimension,
     return eActionStatusOK;
 }
 
+bool
+ParametricCurveLUT::getValueAt(double parametricPosition,
+                               double* value) const
+{
+    if ( values.empty() || !(parametricPosition >= xMin && parametricPosition <= xMax) ) {
+        return false;
+    }
+    if (values.size() == 1 || xMax <= xMin) {
+        *value = values[0];
+        return true;
+    }
+    double pos = (parametricPosition - xMin) / (xMax - xMin) * (values.size() - 1);
+    std::size_t i = std::min( (std::size_t)pos, values.size() - 2 );
+    double t = pos - i;
+    *value = values[i] + (values[i + 1] - values[i]) * t;
+    return true;
+} // getValueAt
+
+ParametricCurveLUTConstPtr
+KnobParametric::getCurveLUT(DimIdx dimension,
+                            ViewIdx view) const
+{
+    if ( dimension < 0 || dimension >= (int)_imp->common->defaultCurves.size() ) {
+        return ParametricCurveLUTConstPtr();
+    }
+    if ( _imp->renderLocalCurves && _imp->renderLocalCurves->curveLUTs[dimension] ) {
+        return _imp->renderLocalCurves->curveLUTs[dimension];
+    }
+    CurvePtr curve = getParametricCurve(dimension, view);
+    if (!curve) {
+        return ParametricCurveLUTConstPtr();
+    }
+    KeyFrameSetConstPtr keys = curve->getKeyFramesSnapshot_mt_safe();
+    for (KeyFrameSet::const_iterator it = keys->begin(); it != keys->end(); ++it) {
+        if (it->getInterpolation() == eKeyframeTypeConstant) {
+            // Linear interpolation of the table would smooth the steps of the curve
+            return ParametricCurveLUTConstPtr();
+        }
+    }
+    std::pair<double, double> range = curve->getXRange();
+    if ( (boost::math::isinf)(range.first) || (boost::math::isinf)(range.second) || (range.second < range.first) ) {
+        return ParametricCurveLUTConstPtr();
+    }
+
+    Hash64 hash;
+    Hash64::appendCurve(curve, &hash);
+    hash.append(range.first);
+    hash.append(range.second);
+    hash.append(curve->isCurvePeriodic());
+    hash.computeHash();
+    U64 curveHash = hash.value();
+
+    {
+        QMutexLocker k(&_imp->common->curveLUTsMutex);
+        const ParametricCurveLUTConstPtr& lut = _imp->common->curveLUTs[dimension];
+        if ( lut && (lut->curveHash == curveHash) ) {
+            return lut;
+        }
+    }
+
+    // Sample the curve outside of the lock, several threads may sample the same curve concurrently
+    // but they all produce the same table.
+    boost::shared_ptr<ParametricCurveLUT> lut(new ParametricCurveLUT);
+    lut->curveHash = curveHash;
+    lut->xMin = range.first;
+    lut->xMax = range.second;
+    std::vector<TimeValue> positions(NATRON_PARAMETRIC_CURVE_LUT_SIZE);
+    for (int i = 0; i < NATRON_PARAMETRIC_CURVE_LUT_SIZE; ++i) {
+        positions[i] = TimeValue( range.first + (range.second - range.first) * i / (NATRON_PARAMETRIC_CURVE_LUT_SIZE - 1) );
+    }
+    curve->getValuesAt(positions, true /*clamp*/, &lut->values);
+
+    {
+        QMutexLocker k(&_imp->common->curveLUTsMutex);
+        _imp->common->curveLUTs[dimension] = lut;
+    }
+    if (_imp->renderLocalCurves) {
+        _imp->renderLocalCurves->curveLUTs[dimension] = lut;
+    }
+    return lut;
+} // getCurveLUT
+
 ActionRetCodeEnum
 KnobParametric::getNControlPoints(DimIdx dimension,
                                   ViewIdx view,
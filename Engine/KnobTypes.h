@@ -1246,6 +1246,34 @@ toParametricKnobDimView(const KnobDimViewBasePtr& data)
 }
 
 struct KnobParametricPrivate;
+/**
+ * @brief The values of a parametric curve sampled at regular positions over its parametric range.
+ * Plug-ins evaluate parametric curves once per lookup, which may be once per pixel: the lookup table
+ * answers these calls without locking or searching the keyframes of the curve.
+ **/
+struct ParametricCurveLUT
+{
+    // The hash of the control points and range of the curve that was sampled
+    U64 curveHash;
+    double xMin, xMax;
+    std::vector<double> values;
+
+    ParametricCurveLUT()
+    : curveHash(0)
+    , xMin(0)
+    , xMax(0)
+    , values()
+    {
+
+    }
+
+    /**
+     * @brief Linearly interpolates the table at the given parametric position.
+     * Returns false if the position is outside of the parametric range.
+     **/
+    bool getValueAt(double parametricPosition, double* value) const;
+};
+
 class KnobParametric
     :  public QObject, public KnobDoubleBase
 {
@@ -1313,6 +1341,15 @@ public:
     ActionRetCodeEnum addControlPoint(ValueChangedReasonEnum reason, DimIdx dimension, double key, double value, KeyframeTypeEnum interpolation = eKeyframeTypeSmooth) WARN_UNUSED_RETURN;
     ActionRetCodeEnum addControlPoint(ValueChangedReasonEnum reason, DimIdx dimension, double key, double value, double leftDerivative, double rightDerivative, KeyframeTypeEnum interpolation = eKeyframeTypeSmooth) WARN_UNUSED_RETURN;
     ActionRetCodeEnum evaluateCurve(DimIdx dimension, ViewIdx view, double parametricPosition, double *returnValue) const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Returns the lookup table of the curve at the given dimension. It is shared by the knob and all its render clones
+     * and sampled again only when the control points of the curve change.
+     * Returns NULL if the curve cannot be sampled faithfully, e.g: if it has constant interpolated control points,
+     * in which case the curve should be evaluated with evaluateCurve().
+     **/
+    ParametricCurveLUTConstPtr getCurveLUT(DimIdx dimension, ViewIdx view) const WARN_UNUSED_RETURN;
+
     ActionRetCodeEnum getNControlPoints(DimIdx dimension, ViewIdx view, int *returnValue) const WARN_UNUSED_RETURN;
     ActionRetCodeEnum getNthControlPoint(DimIdx dimension,
                                   ViewIdx view,
@@ -28,8 +28,24 @@
 #include <algorithm> // min, max
 #include <cassert>
 #include <stdexcept>
+#include <sstream> // stringstream
 
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryFile>
+
+#include "Engine/Hash64.h"
+#include "Engine/MemoryFile.h"
 #include "Engine/RectI.h"
+#include "Engine/StandardPaths.h"
+
+// Identifies the files of the lut cache, increment the version when the layout of the tables changes
+#define NATRON_LUT_CACHE_FILE_MAGIC 0x4e4c5554 // "NLUT"
+#define NATRON_LUT_CACHE_FILE_VERSION 1
+
+// The directory, in the cache location, where the lut tables are shared between processes
+#define NATRON_LUT_CACHE_DIRECTORY_NAME "LutCache"
 
 /*
  * The to_byte* and from_byte* functions implement and generalize the algorithm
@@ -262,6 +278,19 @@ Lut::toColorSpaceUint8xxFromLinearFloatFast(float v) const
     return toFunc_hipart_to_uint8xx[hipart(v)];
 }
 
+void
+Lut::toColorSpaceUint8xxFromLinearFloatFast(const float* from,
+                                            int inDelta,
+                                            unsigned short* to,
+                                            int outDelta,
+                                            int n) const
+{
+    assert(init_);
+    for (int i = 0; i < n; ++i, from += inDelta, to += outDelta) {
+        *to = toFunc_hipart_to_uint8xx[hipart(*from)];
+    }
+}
+
 // the following only works for increasing LUTs
 unsigned short
 Lut::toColorSpaceUint16FromLinearFloatFast(float v) const
@@ -320,17 +349,116 @@ Lut::fromColorSpaceUint16ToLinearFloatFast(unsigned short v) const
     return v32f_prev + (v - v16u_prev) * (v32f_next - v32f_prev) / (v16u_next - v16u_prev);
 }
 
+// The layout of a lut file: the header is followed by the 2 tables
+struct LutTablesHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    U64 hash;
+};
+
+static const std::size_t kLutTablesToOffset = sizeof(LutTablesHeader);
+static const std::size_t kLutTablesFromOffset = kLutTablesToOffset + 0x10000 * sizeof(unsigned short);
+static const std::size_t kLutTablesSize = kLutTablesFromOffset + 256 * sizeof(float);
+
+/**
+ * @brief Returns the path of the file shared by all processes holding the tables of the given lut,
+ * or an empty string if it cannot be determined.
+ **/
+static std::string
+getLutCacheFilePath(const std::string& name,
+                    U64 hash)
+{
+    if ( !QCoreApplication::instance() ) {
+        return std::string();
+    }
+    QString dirPath = StandardPaths::writableLocation(StandardPaths::eStandardLocationCache) + QLatin1Char('/') + QString::fromUtf8(NATRON_LUT_CACHE_DIRECTORY_NAME);
+    if ( !QDir().mkpath(dirPath) ) {
+        return std::string();
+    }
+
+    // The name may contain characters that are not valid in a file name: the hash is enough to identify the lut
+    std::stringstream ss;
+    ss << dirPath.toStdString() << '/' << std::hex << hash << ".lut";
+
+    return ss.str();
+}
+
+Lut::~Lut()
+{
+}
+
+bool
+Lut::mapSharedTables(const std::string& filePath,
+                     U64 hash) const
+{
+    if ( !QFile::exists( QString::fromUtf8( filePath.c_str() ) ) ) {
+        return false;
+    }
+    boost::scoped_ptr<MemoryFile> file( new MemoryFile() );
+    try {
+        file->open(filePath, MemoryFile::eFileOpenModeOpen);
+    } catch (const std::exception& /*e*/) {
+        return false;
+    }
+    const char* data = file->getData();
+    if ( !data || (file->size() != kLutTablesSize) ) {
+        return false;
+    }
+    LutTablesHeader header;
+    std::memcpy( &header, data, sizeof(header) );
+    if ( (header.magic != NATRON_LUT_CACHE_FILE_MAGIC) || (header.version != NATRON_LUT_CACHE_FILE_VERSION) || (header.hash != hash) ) {
+        return false;
+    }
+    toFunc_hipart_to_uint8xx = reinterpret_cast<const unsigned short*>(data + kLutTablesToOffset);
+    fromFunc_uint8_to_float = reinterpret_cast<const float*>(data + kLutTablesFromOffset);
+    _sharedTables.swap(file);
+    std::vector<char>().swap(_tables);
+
+    return true;
+} // mapSharedTables
+
 void
 Lut::fillTables() const
 {
     if (init_) {
         return;
     }
+
+    // The byte to float table is cheap to compute: together with a few samples of the other direction
+    // it identifies the transfer functions, so that a lut that changed does not use stale tables.
+    float fromTable[256];
+    for (int b = 0; b < 256; ++b) {
+        fromTable[b] = _fromFunc( Color::intToFloat<256>(b) );
+    }
+    Hash64 hash;
+    Hash64::appendString(_name, &hash);
+    hash.appendArray(fromTable, 256);
+    for (int i = 0; i < 0x10000; i += 0x400) {
+        hash.append( _toFunc( index_to_float( (unsigned short)i ) ) );
+    }
+    hash.computeHash();
+
+    // Renderer processes running on the same machine all use the same tables: map those written by the first one
+    std::string filePath = getLutCacheFilePath( _name, hash.value() );
+    if ( !filePath.empty() && mapSharedTables( filePath, hash.value() ) ) {
+        return;
+    }
+
+    _tables.resize(kLutTablesSize);
+    LutTablesHeader header;
+    header.magic = NATRON_LUT_CACHE_FILE_MAGIC;
+    header.version = NATRON_LUT_CACHE_FILE_VERSION;
+    header.hash = hash.value();
+    std::memcpy( &_tables[0], &header, sizeof(header) );
+    unsigned short* toTable = reinterpret_cast<unsigned short*>(&_tables[kLutTablesToOffset]);
+    float* fromTableDst = reinterpret_cast<float*>(&_tables[kLutTablesFromOffset]);
+
     // fill all
     for (int i = 0; i < 0x10000; ++i) {
         float inp = index_to_float( (unsigned short)i );
         float f = _toFunc(inp);
-        toFunc_hipart_to_uint8xx[i] = Color::floatToInt<0xff01>(f);
+        toTable[i] = Color::floatToInt<0xff01>(f);
     }
     // fill fromFunc_uint8_to_float, and make sure that
     // the entries of toFunc_hipart_to_uint8xx corresponding
@@ -338,12 +466,38 @@ Lut::fillTables() const
     // so that toFunc(fromFunc(b)) is identity
     //
     for (int b = 0; b < 256; ++b) {
-        float f = _fromFunc( Color::intToFloat<256>(b) );
-        fromFunc_uint8_to_float[b] = f;
+        float f = fromTable[b];
+        fromTableDst[b] = f;
         int i = hipart(f);
-        toFunc_hipart_to_uint8xx[i] = Color::charToUint8xx(b);
+        toTable[i] = Color::charToUint8xx(b);
     }
-}
+    toFunc_hipart_to_uint8xx = toTable;
+    fromFunc_uint8_to_float = fromTableDst;
+
+    if ( filePath.empty() ) {
+        return;
+    }
+
+    // Write the file under a temporary name and rename it so that other processes never map a partial file
+    QString qFilePath = QString::fromUtf8( filePath.c_str() );
+    QTemporaryFile tmpf( qFilePath + QString::fromUtf8("_XXXXXX.tmp") );
+    if ( !tmpf.open() ) {
+        return;
+    }
+    if ( tmpf.write( &_tables[0], (qint64)_tables.size() ) != (qint64)_tables.size() ) {
+        return;
+    }
+    tmpf.close();
+    tmpf.setAutoRemove(false);
+    QString tmpFileName = tmpf.fileName();
+    if ( !QFile::rename(tmpFileName, qFilePath) ) {
+        // Another process wrote the same tables in the meantime
+        QFile::remove(tmpFileName);
+    }
+
+    // Release the private copy of the tables
+    mapSharedTables( filePath, hash.value() );
+} // fillTables
 
 #ifdef DEAD_CODE
 void
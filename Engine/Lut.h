@@ -34,11 +34,18 @@
 #include <cmath>
 #include <map>
 #include <string>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
 
 CLANG_DIAG_OFF(deprecated)
 #include <QtCore/QMutex>
 CLANG_DIAG_ON(deprecated)
 
+#include "Global/GlobalDefines.h"
+
 #include "Engine/EngineFwd.h"
 
 NATRON_NAMESPACE_ENTER;
@@ -136,9 +143,12 @@ class Lut
     toColorSpaceFunctionV1 _toFunc;
 
     /// the fast lookup tables are mutable, because they are automatically initialized post-construction,
-    /// and never change afterwards
-    mutable unsigned short toFunc_hipart_to_uint8xx[0x10000];         /// contains  2^16 = 65536 values between 0-255
-    mutable float fromFunc_uint8_to_float[256];         /// values between 0-1.f
+    /// and never change afterwards.
+    /// They point to the lut file shared by all processes (_sharedTables), or to _tables if it could not be mapped.
+    mutable const unsigned short* toFunc_hipart_to_uint8xx;         /// contains  2^16 = 65536 values between 0-255
+    mutable const float* fromFunc_uint8_to_float;         /// values between 0-1.f
+    mutable std::vector<char> _tables;
+    mutable boost::scoped_ptr<MemoryFile> _sharedTables;
     mutable bool init_;         ///< false if the tables are not yet initialized
     mutable QMutex _lock;         ///< protects init_
 
@@ -150,16 +160,28 @@ class Lut
         : _name(name)
         , _fromFunc(fromFunc)
         , _toFunc(toFunc)
+        , toFunc_hipart_to_uint8xx(0)
+        , fromFunc_uint8_to_float(0)
+        , _tables()
+        , _sharedTables()
         , init_(false)
         , _lock()
     {
     }
 
+    ~Lut();
+
     ///init luts
     ///it uses fromColorSpaceFloatToLinearFloat(float) and toColorSpaceFloatFromLinearFloat(float)
     ///Called by validate()
     void fillTables() const;
 
+    /**
+     * @brief Maps the lut file with the given path if it holds the tables of the given hash.
+     * Returns false if the file does not exist or is invalid.
+     **/
+    bool mapSharedTables(const std::string& filePath, U64 hash) const;
+
 public:
 
     /* @brief Converts a float ranging in [0 - 1.f] in the desired color-space to linear color-space also ranging in [0 - 1.f]
@@ -214,6 +236,11 @@ public:
      */
     unsigned short toColorSpaceUint8xxFromLinearFloatFast(float v) const;
 
+    /* @brief Same as toColorSpaceUint8xxFromLinearFloatFast(float) applied to n values.
+     * \a inDelta and \a outDelta are the distances between the input and output elements.
+     */
+    void toColorSpaceUint8xxFromLinearFloatFast(const float* from, int inDelta, unsigned short* to, int outDelta, int n) const;
+
     /* @brief Converts a float ranging in [0 - 1.f] in linear color-space using the look-up tables.
      * @return An unsigned short in [0 - 65535] in the destination color-space.
      * This function uses localluy linear approximations of the transfer function.
@@ -0,0 +1,145 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "MemoryAccount.h"
+
+#include <algorithm> // min
+#include <cassert>
+
+#include <QtCore/QMutex>
+
+#include "Engine/EffectInstance.h"
+#include "Engine/Node.h"
+#include "Engine/TreeRender.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct MemoryAccountPrivate
+{
+    // Protects all data below
+    mutable QMutex lock;
+
+    std::size_t bytes[eMemoryAccountTypeCount];
+    std::size_t totalBytes;
+    std::size_t peakTotalBytes;
+
+    MemoryAccountPrivate()
+    : lock()
+    , totalBytes(0)
+    , peakTotalBytes(0)
+    {
+        for (int i = 0; i < eMemoryAccountTypeCount; ++i) {
+            bytes[i] = 0;
+        }
+    }
+};
+
+MemoryAccount::MemoryAccount()
+    : _imp( new MemoryAccountPrivate() )
+{
+}
+
+MemoryAccount::~MemoryAccount()
+{
+}
+
+void
+MemoryAccount::addBytes(MemoryAccountTypeEnum type,
+                        std::size_t bytes)
+{
+    QMutexLocker k(&_imp->lock);
+    _imp->bytes[type] += bytes;
+    _imp->totalBytes += bytes;
+    if (_imp->totalBytes > _imp->peakTotalBytes) {
+        _imp->peakTotalBytes = _imp->totalBytes;
+    }
+}
+
+void
+MemoryAccount::removeBytes(MemoryAccountTypeEnum type,
+                           std::size_t bytes)
+{
+    QMutexLocker k(&_imp->lock);
+    assert(_imp->bytes[type] >= bytes);
+    _imp->bytes[type] -= std::min(bytes, _imp->bytes[type]);
+    _imp->totalBytes -= std::min(bytes, _imp->totalBytes);
+}
+
+std::size_t
+MemoryAccount::getBytes(MemoryAccountTypeEnum type) const
+{
+    QMutexLocker k(&_imp->lock);
+    return _imp->bytes[type];
+}
+
+std::size_t
+MemoryAccount::getTotalBytes() const
+{
+    QMutexLocker k(&_imp->lock);
+    return _imp->totalBytes;
+}
+
+std::size_t
+MemoryAccount::getPeakTotalBytes() const
+{
+    QMutexLocker k(&_imp->lock);
+    return _imp->peakTotalBytes;
+}
+
+void
+MemoryAccount::getEffectAccounts(const EffectInstancePtr& effect,
+                                 std::vector<MemoryAccountPtr>* accounts)
+{
+    if (!effect) {
+        return;
+    }
+    NodePtr node = effect->getNode();
+    if (node) {
+        accounts->push_back( node->getMemoryAccount() );
+    }
+    if ( effect->isRenderClone() ) {
+        TreeRenderPtr render = effect->getCurrentRender();
+        if (render) {
+            accounts->push_back( render->getMemoryAccount() );
+        }
+    }
+}
+
+const char*
+MemoryAccount::getTypeLabel(MemoryAccountTypeEnum type)
+{
+    switch (type) {
+    case eMemoryAccountTypeImageRAM:
+        return "Images (RAM)";
+    case eMemoryAccountTypeImageGL:
+        return "Images (OpenGL)";
+    case eMemoryAccountTypePlugin:
+        return "Plug-in memory";
+    case eMemoryAccountTypeCount:
+        break;
+    }
+    return "";
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,115 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_MEMORYACCOUNT_H
+#define NATRON_ENGINE_MEMORYACCOUNT_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief The kinds of memory attributed to a MemoryAccount
+ **/
+enum MemoryAccountTypeEnum
+{
+    // Image buffers in RAM which are not held by the cache
+    eMemoryAccountTypeImageRAM = 0,
+
+    // Image buffers in OpenGL textures
+    eMemoryAccountTypeImageGL,
+
+    // Memory allocated by the plug-in with the OpenFX memory suite
+    eMemoryAccountTypePlugin,
+
+    eMemoryAccountTypeCount
+};
+
+/**
+ * @brief The live memory allocated on behalf of an owner, a node or a render, so that the owner
+ * responsible for the memory usage of a project can be found.
+ * The memory of an ImageStorageBase is added to the accounts given to ImageStorageBase::setMemoryAccounts()
+ * when it is allocated and removed when it is freed.
+ * The memory of the images held by the cache is attributed to the node quota groups of the cache instead,
+ * see CacheBase::getMemoryStats().
+ * All functions are MT-safe.
+ **/
+struct MemoryAccountPrivate;
+class MemoryAccount
+{
+public:
+
+    MemoryAccount();
+
+    ~MemoryAccount();
+
+    void addBytes(MemoryAccountTypeEnum type, std::size_t bytes);
+
+    void removeBytes(MemoryAccountTypeEnum type, std::size_t bytes);
+
+    /**
+     * @brief Returns the memory currently allocated of the given type
+     **/
+    std::size_t getBytes(MemoryAccountTypeEnum type) const;
+
+    /**
+     * @brief Returns the memory currently allocated of all types
+     **/
+    std::size_t getTotalBytes() const;
+
+    /**
+     * @brief Returns the highest value of getTotalBytes() since the account was created
+     **/
+    std::size_t getPeakTotalBytes() const;
+
+    /**
+     * @brief Returns the accounts charged for the memory allocated by the given effect: the account of its node
+     * and, if the effect is a render clone, the account of its render.
+     **/
+    static void getEffectAccounts(const EffectInstancePtr& effect, std::vector<MemoryAccountPtr>* accounts);
+
+    /**
+     * @brief Returns a label for the given type, used in the memory reports
+     **/
+    static const char* getTypeLabel(MemoryAccountTypeEnum type);
+
+private:
+
+    boost::scoped_ptr<MemoryAccountPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_MEMORYACCOUNT_H
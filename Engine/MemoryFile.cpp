@@ -336,6 +336,38 @@ MemoryFile::resize(size_t new_size, bool preserve)
     _imp->size = new_size;
 }
 
+bool
+MemoryFile::rename(const std::string& newPath)
+{
+    if ( _imp->path.empty() ) {
+        return false;
+    }
+    if (::rename( _imp->path.c_str(), newPath.c_str() ) != 0) {
+        return false;
+    }
+    _imp->path = newPath;
+
+    return true;
+}
+
+bool
+MemoryFile::preallocate(size_t offset, size_t numBytes)
+{
+#ifdef __NATRON_LINUX__
+    if (numBytes == 0) {
+        return true;
+    }
+    assert(offset + numBytes <= _imp->size);
+
+    return ::posix_fallocate(_imp->file_handle, (off_t)offset, (off_t)numBytes) == 0;
+#else
+    Q_UNUSED(offset);
+    Q_UNUSED(numBytes);
+
+    return false;
+#endif
+}
+
 void
 MemoryFilePrivate::closeMapping()
 {
@@ -425,6 +457,25 @@ MemoryFile::flush(FlushTypeEnum type, void* data, std::size_t size)
     return false;
 } // flush
 
+bool
+MemoryFile::prefetch(void* data, std::size_t size)
+{
+    if (!data || !_imp->data) {
+        return false;
+    }
+#if defined(__NATRON_UNIX__)
+#  ifdef POSIX_MADV_WILLNEED
+    return posix_madvise(data, size, POSIX_MADV_WILLNEED) == 0;
+#  else
+    return madvise(data, size, MADV_WILLNEED) == 0;
+#  endif
+#else
+    // PrefetchVirtualMemory is only available from Windows 8: let the pages be faulted in when accessed
+    Q_UNUSED(size);
+    return false;
+#endif
+} // prefetch
+
 void
 MemoryFile::close()
 {
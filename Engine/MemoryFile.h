@@ -100,6 +100,19 @@ public:
      **/
     void resize(size_t new_size, bool preserve);
 
+    /**
+     * @brief Reserves the disk blocks of the given range of the file so that writing to it later on does not
+     * allocate them one page fault at a time. The file must be at least offset + numBytes long.
+     * This is only implemented on Linux and does nothing elsewhere. Returns false if the blocks could not be reserved.
+     **/
+    bool preallocate(size_t offset, size_t numBytes);
+
+    /**
+     * @brief Moves the backing file to the given path, keeping the mapping. Returns false if the file could not be
+     * moved, e.g: on Windows a mapped file cannot be moved.
+     **/
+    bool rename(const std::string& newPath);
+
     /**
      * @brief Close any mapping opened. Data will be not be flushed, make sure to call
      * flush first.
@@ -131,6 +144,13 @@ public:
      **/
     bool flush(FlushTypeEnum type, void* data, std::size_t size);
 
+    /**
+     * @brief Hints the system that the portion starting at data and spanning size bytes
+     * is going to be accessed soon, so that it starts reading it from the backing file.
+     * This function does not wait for the data to be read.
+     **/
+    bool prefetch(void* data, std::size_t size);
+
     /**
      * @brief Returns the filepath of the backing file.
      **/
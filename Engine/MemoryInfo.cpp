@@ -188,7 +188,6 @@ printAsRAM(U64 bytes)
 }
 
 
-#if 0 // not used for now
 /**
  * Returns the peak (maximum so far) resident set size (physical
  * memory use) measured in bytes, or zero if the value cannot be
@@ -238,9 +237,7 @@ getPeakRSS( )
     return (size_t)0L;          /* Unsupported. */
 #endif
 }
-#endif // 0
 
-#if 0 // not used for now
 /**
  * Returns the current resident set size (physical memory use) measured
  * in bytes, or zero if the value cannot be determined on this OS.
@@ -297,7 +294,6 @@ getCurrentRSS( )
     return (size_t)0L;          /* Unsupported. */
 #endif
 } // getCurrentRSS
-#endif // 0
 
 
 std::size_t
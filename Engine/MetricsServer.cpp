@@ -0,0 +1,88 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "MetricsServer.h"
+
+#include <QtNetwork/QHostAddress>
+
+#include "qhttpserver.h"
+#include "qhttprequest.h"
+#include "qhttpresponse.h"
+
+#include "Engine/EngineMetrics.h"
+
+NATRON_NAMESPACE_ENTER;
+
+MetricsServer::MetricsServer(QObject *parent)
+    : QObject(parent)
+    , _server(NULL)
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+    if (_server) {
+        _server->close();
+    }
+}
+
+bool
+MetricsServer::listen(int port)
+{
+    if (!_server) {
+        _server = new QHttpServer(this);
+        connect( _server, SIGNAL(newRequest(QHttpRequest*,QHttpResponse*)), this, SLOT(handler(QHttpRequest*,QHttpResponse*)) );
+    }
+
+    return _server->listen( QHostAddress::Any, (quint16)port );
+}
+
+void
+MetricsServer::handler(QHttpRequest *req,
+                       QHttpResponse *resp)
+{
+    QByteArray body;
+    int status;
+    QString contentType;
+    if ( req->path() == QString::fromUtf8("/metrics") ) {
+        status = 200;
+        body = QByteArray( EngineMetrics::toPrometheusText().c_str() );
+        // The content type of the Prometheus text exposition format
+        contentType = QString::fromUtf8("text/plain; version=0.0.4; charset=utf-8");
+    } else {
+        status = 404;
+        body = QByteArray("Not found: the metrics are served at /metrics\n");
+        contentType = QString::fromUtf8("text/plain; charset=utf-8");
+    }
+
+    resp->setHeader( QString::fromUtf8("Content-Type"), contentType );
+    resp->setHeader( QString::fromUtf8("Content-Length"), QString::number( body.size() ) );
+    resp->writeHead(status);
+    resp->end(body);
+}
+
+NATRON_NAMESPACE_EXIT;
+
+NATRON_NAMESPACE_USING;
+#include "moc_MetricsServer.cpp"
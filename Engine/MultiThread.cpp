@@ -25,13 +25,16 @@
 
 #include "MultiThread.h"
 
+#include <algorithm>
 #include <map>
 #include <list>
+#include <vector>
 
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
 CLANG_DIAG_OFF(deprecated-register) //'register' storage class specifier is deprecated
 CLANG_DIAG_OFF(uninitialized)
+#include <QtCore/QAtomicInt>
 #include <QtCore/QMutex>
 #include <QtCore/QThreadPool>
 #include <QtCore/QCoreApplication>
@@ -39,6 +42,7 @@ CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QThread>
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QThreadStorage>
+#include <QtCore/QWaitCondition>
 #include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 CLANG_DIAG_ON(deprecated-register)
 CLANG_DIAG_ON(uninitialized)
@@ -60,9 +64,90 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 // An effect may not use more than this amount of threads
 #define NATRON_MULTI_THREAD_SUITE_MAX_NUM_CPU 4
 
+// ImageMultiThreadProcessorBase checks whether the render is aborted each time a thread has processed
+// this amount of pixels. This bounds the time an aborted render keeps using the CPUs
+#define NATRON_MULTI_THREAD_ABORT_CHECK_PIXELS 65536
+
+// Maximum number of threads of the persistent team of a render thread, see MultiThreadTeam
+#define NATRON_MULTI_THREAD_TEAM_MAX_WORKERS 16
+
+// Number of times a thread of a team polls for work (or the render thread for the end of the work)
+// before it goes to sleep. OpenFX plug-ins call multiThread several times in a row per render: the
+// threads are then still spinning when the next call comes in and do not need to be woken up.
+#define NATRON_MULTI_THREAD_TEAM_SPIN_COUNT 20000
+
 
 NATRON_NAMESPACE_ENTER;
 
+struct MultiThreadPrivate;
+class MultiThreadTeamWorker;
+
+/**
+ * @brief The threads kept around by a render thread (a thread of the global thread pool) to run its calls
+ * to MultiThread::launchThreadsBlocking(). Dispatching work to threads that are already running is much
+ * cheaper than scheduling new runnables on the thread pool for each call.
+ * The render thread processes indices too: the workers and the render thread take the next index to process
+ * until there is none left, then the render thread waits for the workers to finish.
+ * Threads poll for a while before sleeping, so that consecutive calls do not pay for waking them up.
+ * Only the render thread owning the team may call run().
+ **/
+class MultiThreadTeam
+{
+public:
+
+    MultiThreadTeam(MultiThreadPrivate* imp);
+
+    ~MultiThreadTeam();
+
+    /**
+     * @brief Runs func for all indices in [0, nThreads) with nWorkers threads of the team and the calling thread.
+     **/
+    ActionRetCodeEnum run(MultiThread::ThreadFunctor func,
+                          unsigned int nThreads,
+                          unsigned int nWorkers,
+                          void *customArg,
+                          const EffectInstancePtr& effect);
+
+    // True while run() is executing: a recursive call cannot use the team
+    bool isBusy() const
+    {
+        return _busy;
+    }
+
+    // Called by the workers
+    void processIndices();
+    void notifyWorkerDone();
+
+private:
+
+    MultiThreadPrivate* _imp;
+
+    std::vector<MultiThreadTeamWorker*> _workers;
+
+    bool _busy;
+
+    // The current job, only written by the render thread while the workers do not run
+    MultiThread::ThreadFunctor _func;
+    unsigned int _nThreads;
+    void* _customArg;
+    QThread* _spawnerThread;
+    EffectInstancePtr _effect;
+
+    // The next index to process
+    QAtomicInt _nextIndex;
+
+    // The first failure of the job
+    QAtomicInt _status;
+
+    // The workers that did not finish the job yet
+    QAtomicInt _nWorkersRunning;
+
+    // Set when the render thread sleeps until the workers finish
+    QAtomicInt _spawnerSleeping;
+    QMutex _doneMutex;
+    QWaitCondition _doneCond;
+};
+
 struct MultiThreadThreadData
 {
     // Index of the thread. This is a list so that the launchThread functino
@@ -78,11 +163,24 @@ struct MultiThreadPrivate
     PerThreadMultiThreadDataMap threadsData;
     mutable QReadWriteLock threadsDataMutex;
 
+    // The number of frames currently rendering concurrently, see MultiThread::registerFrameRender()
+    QAtomicInt nConcurrentFrameRenders;
+
+    // The number of threads of the teams currently processing, which are not thread pool threads
+    QAtomicInt nBusyTeamWorkers;
+
+    // The team of each render thread
+    QThreadStorage<MultiThreadTeam*> teams;
+
     MultiThreadPrivate()
     : threadsData()
     , threadsDataMutex()
+    , nConcurrentFrameRenders()
+    , nBusyTeamWorkers()
+    , teams()
     {
-
+        nConcurrentFrameRenders.fetchAndStoreRelaxed(0);
+        nBusyTeamWorkers.fetchAndStoreRelaxed(0);
     }
 
     void pushThreadIndex(QThread* thread, unsigned int index)
@@ -175,6 +273,12 @@ threadFunctionWrapper(MultiThreadPrivate* imp,
         copyOFXRenderTLS(effect, spawnerThread , renderActionData);
     }
 
+    // Do not start processing if the render was aborted while this thread was waiting to be scheduled
+    if (effect && effect->isRenderAborted()) {
+        imp->popThreadIndex(spawnedThread);
+        return eActionStatusAborted;
+    }
+
     ActionRetCodeEnum ret = eActionStatusOK;
     try {
         ret = func(threadIndex, threadMax, customArg);
@@ -260,6 +364,203 @@ private:
 
 NATRON_NAMESPACE_ANONYMOUS_EXIT
 
+class MultiThreadTeamWorker
+    : public QThread
+    , public AbortableThread
+{
+public:
+
+    MultiThreadTeamWorker(MultiThreadTeam* team)
+    : QThread()
+    , AbortableThread(this)
+    , _team(team)
+    , _jobGeneration()
+    , _sleeping()
+    , _quit()
+    , _mutex()
+    , _cond()
+    {
+        _jobGeneration.fetchAndStoreRelaxed(0);
+        _sleeping.fetchAndStoreRelaxed(0);
+        _quit.fetchAndStoreRelaxed(0);
+        setThreadName("Multi-thread suite team");
+    }
+
+    /**
+     * @brief Makes the worker process the current job of the team.
+     **/
+    void startJob()
+    {
+        _jobGeneration.fetchAndAddOrdered(1);
+        // If the worker is not sleeping yet, it checks the generation after having flagged itself as sleeping
+        if ( _sleeping.fetchAndAddOrdered(0) ) {
+            QMutexLocker k(&_mutex);
+            _cond.wakeOne();
+        }
+    }
+
+    void quit()
+    {
+        {
+            QMutexLocker k(&_mutex);
+            _quit.fetchAndStoreOrdered(1);
+            _jobGeneration.fetchAndAddOrdered(1);
+            _cond.wakeOne();
+        }
+        wait();
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        int lastGeneration = 0;
+        for (;;) {
+            int generation = _jobGeneration.fetchAndAddOrdered(0);
+            for (int i = 0; generation == lastGeneration && i < NATRON_MULTI_THREAD_TEAM_SPIN_COUNT; ++i) {
+                generation = _jobGeneration.fetchAndAddOrdered(0);
+            }
+            if (generation == lastGeneration) {
+                QMutexLocker k(&_mutex);
+                _sleeping.fetchAndStoreOrdered(1);
+                while ( (_jobGeneration.fetchAndAddOrdered(0) == lastGeneration) ) {
+                    _cond.wait(&_mutex);
+                }
+                _sleeping.fetchAndStoreOrdered(0);
+                generation = _jobGeneration.fetchAndAddOrdered(0);
+            }
+            if ( _quit.fetchAndAddOrdered(0) ) {
+                return;
+            }
+            lastGeneration = generation;
+
+            _team->processIndices();
+            _team->notifyWorkerDone();
+        }
+    }
+
+    MultiThreadTeam* _team;
+
+    // Incremented by the render thread for each job
+    QAtomicInt _jobGeneration;
+
+    // Set when the worker sleeps on _cond
+    QAtomicInt _sleeping;
+
+    QAtomicInt _quit;
+    QMutex _mutex;
+    QWaitCondition _cond;
+};
+
+MultiThreadTeam::MultiThreadTeam(MultiThreadPrivate* imp)
+: _imp(imp)
+, _workers()
+, _busy(false)
+, _func(0)
+, _nThreads(0)
+, _customArg(0)
+, _spawnerThread(0)
+, _effect()
+, _nextIndex()
+, _status()
+, _nWorkersRunning()
+, _spawnerSleeping()
+, _doneMutex()
+, _doneCond()
+{
+    _spawnerSleeping.fetchAndStoreRelaxed(0);
+}
+
+MultiThreadTeam::~MultiThreadTeam()
+{
+    for (std::size_t i = 0; i < _workers.size(); ++i) {
+        _workers[i]->quit();
+        delete _workers[i];
+    }
+}
+
+void
+MultiThreadTeam::processIndices()
+{
+    for (;;) {
+        if ( isFailureRetCode( (ActionRetCodeEnum)_status.fetchAndAddOrdered(0) ) ) {
+            return;
+        }
+        unsigned int index = (unsigned int)_nextIndex.fetchAndAddOrdered(1);
+        if (index >= _nThreads) {
+            return;
+        }
+        ActionRetCodeEnum stat = threadFunctionWrapper(_imp, _func, index, _nThreads, _spawnerThread, _effect, _customArg);
+        if ( isFailureRetCode(stat) ) {
+            _status.fetchAndStoreOrdered( (int)stat );
+        }
+    }
+}
+
+void
+MultiThreadTeam::notifyWorkerDone()
+{
+    if (_nWorkersRunning.fetchAndAddOrdered(-1) == 1) {
+        if ( _spawnerSleeping.fetchAndAddOrdered(0) ) {
+            QMutexLocker k(&_doneMutex);
+            _doneCond.wakeOne();
+        }
+    }
+}
+
+ActionRetCodeEnum
+MultiThreadTeam::run(MultiThread::ThreadFunctor func,
+                     unsigned int nThreads,
+                     unsigned int nWorkers,
+                     void *customArg,
+                     const EffectInstancePtr& effect)
+{
+    assert(!_busy && nWorkers > 0 && nWorkers <= NATRON_MULTI_THREAD_TEAM_MAX_WORKERS);
+    _busy = true;
+
+    while (_workers.size() < nWorkers) {
+        MultiThreadTeamWorker* worker = new MultiThreadTeamWorker(this);
+        worker->start();
+        _workers.push_back(worker);
+    }
+
+    _func = func;
+    _nThreads = nThreads;
+    _customArg = customArg;
+    _spawnerThread = QThread::currentThread();
+    _effect = effect;
+    _nextIndex.fetchAndStoreOrdered(0);
+    _status.fetchAndStoreOrdered( (int)eActionStatusOK );
+    _nWorkersRunning.fetchAndStoreOrdered( (int)nWorkers );
+
+    _imp->nBusyTeamWorkers.fetchAndAddOrdered( (int)nWorkers );
+    for (unsigned int i = 0; i < nWorkers; ++i) {
+        _workers[i]->startJob();
+    }
+
+    // Process indices in this thread too instead of just waiting
+    processIndices();
+
+    // Wait for the workers
+    for (int i = 0; _nWorkersRunning.fetchAndAddOrdered(0) > 0 && i < NATRON_MULTI_THREAD_TEAM_SPIN_COUNT; ++i) {
+    }
+    if (_nWorkersRunning.fetchAndAddOrdered(0) > 0) {
+        QMutexLocker k(&_doneMutex);
+        _spawnerSleeping.fetchAndStoreOrdered(1);
+        while (_nWorkersRunning.fetchAndAddOrdered(0) > 0) {
+            _doneCond.wait(&_doneMutex);
+        }
+        _spawnerSleeping.fetchAndStoreOrdered(0);
+    }
+    _imp->nBusyTeamWorkers.fetchAndAddOrdered( -(int)nWorkers );
+
+    // Do not hold a reference to the effect after the job
+    _effect.reset();
+    _busy = false;
+
+    return (ActionRetCodeEnum)_status.fetchAndAddOrdered(0);
+} // run
+
 
 MultiThread::MultiThread()
 : _imp(new MultiThreadPrivate())
@@ -340,6 +641,10 @@ MultiThread::launchThreadsInternal(MultiThread::ThreadFunctor func, unsigned int
         // multiple times.
         try {
             for (unsigned int i = 0; i < nThreads; ++i) {
+                if (effect && effect->isRenderAborted()) {
+                    ret->_imp->status = eActionStatusAborted;
+                    return ret;
+                }
                 ActionRetCodeEnum stat = func(i, nThreads, customArg);
                 if (isFailureRetCode(stat)) {
                     ret->_imp->status = stat;
@@ -419,10 +724,22 @@ MultiThread::launchThreadsInternal(MultiThread::ThreadFunctor func, unsigned int
             unsigned int i = 0; // index of next thread to launch
             unsigned int running = 0; // number of running threads
             unsigned int j = 0; // index of first running thread. all threads before this one are finished running
-            while (j < nThreads) {
+            unsigned int nThreadsToLaunch = nThreads; // lowered if the render is aborted
+            while (j < nThreadsToLaunch) {
                 // have no more than maxConcurrentThread threads launched at the same time
                 int threadsStarted = 0;
-                while (i < nThreads && running < maxConcurrentThread) {
+                if (i < nThreadsToLaunch && effect && effect->isRenderAborted()) {
+                    // Do not launch the remaining threads, they would return immediately anyway
+                    for (unsigned int k = i; k < nThreadsToLaunch; ++k) {
+                        status[k] = eActionStatusAborted;
+                        delete threads[k];
+                    }
+                    nThreadsToLaunch = i;
+                    if (j >= nThreadsToLaunch) {
+                        break;
+                    }
+                }
+                while (i < nThreadsToLaunch && running < maxConcurrentThread) {
                     threads[i]->start();
                     ++i;
                     ++running;
@@ -457,6 +774,27 @@ MultiThread::launchThreadsInternal(MultiThread::ThreadFunctor func, unsigned int
 ActionRetCodeEnum
 MultiThread::launchThreadsBlocking(ThreadFunctor func, unsigned int nThreads, void *customArg, const EffectInstancePtr& effect)
 {
+    // Render threads run their calls on their persistent team, except for plug-ins that need fresh threads (see launchThreadsInternal())
+    // and calls made from a thread of a team or while the team is already processing.
+    if ( func && (nThreads > 1) && isRunningInThreadPoolThread() && !dynamic_cast<MultiThreadTeamWorker*>( QThread::currentThread() ) ) {
+        bool isFurnace = false;
+        if (effect) {
+            NodePtr node = effect->getNode();
+            isFurnace = node && boost::starts_with(node->getPluginID(), "uk.co.thefoundry.furnace");
+        }
+        unsigned int nWorkers = std::min( std::min( nThreads, MultiThread::getNCPUsAvailable() ), (unsigned int)NATRON_MULTI_THREAD_TEAM_MAX_WORKERS + 1 ) - 1;
+        if (!isFurnace && nWorkers > 0) {
+            MultiThreadPrivate* imp = appPTR->getMultiThreadHandler()->_imp.get();
+            if ( !imp->teams.hasLocalData() ) {
+                imp->teams.setLocalData( new MultiThreadTeam(imp) );
+            }
+            MultiThreadTeam* team = imp->teams.localData();
+            if ( !team->isBusy() ) {
+                return team->run(func, nThreads, nWorkers, customArg, effect);
+            }
+        }
+    }
+
     MultiThreadFuturePtr ret = launchThreadsInternal(func, nThreads, customArg, effect);
     return ret->waitForFinished();
 } // launchThreads
@@ -485,10 +823,51 @@ MultiThread::getNCPUsAvailable()
     const int maxThreadsCount = QThreadPool::globalInstance()->maxThreadCount();
     assert(maxThreadsCount >= 0);
 
+    // The threads of the teams are not thread pool threads but use CPUs as well
+    if (appPTR) {
+        activeThreadsCount += (int)appPTR->getMultiThreadHandler()->_imp->nBusyTeamWorkers;
+    }
+
     int ret = std::max(1, maxThreadsCount - activeThreadsCount);
+
+    // When several frames are rendering concurrently, each frame only gets its share of the CPUs. Otherwise the first
+    // frame to spawn threads takes all idle CPUs and the other frames end-up waiting for them whilst holding their own threads.
+    // The scheduler adapts the number of frames rendering concurrently to the observed thread pool utilization
+    int nFrames = getNConcurrentFrameRenders();
+    if (nFrames > 1) {
+        int share = std::max(1, (maxThreadsCount + nFrames - 1) / nFrames);
+        ret = std::min(ret, share);
+    }
     return ret;
 } // getNCPUsAvailable
 
+void
+MultiThread::registerFrameRender()
+{
+    if (!appPTR) {
+        return;
+    }
+    appPTR->getMultiThreadHandler()->_imp->nConcurrentFrameRenders.fetchAndAddOrdered(1);
+}
+
+void
+MultiThread::unregisterFrameRender()
+{
+    if (!appPTR) {
+        return;
+    }
+    appPTR->getMultiThreadHandler()->_imp->nConcurrentFrameRenders.fetchAndAddOrdered(-1);
+}
+
+int
+MultiThread::getNConcurrentFrameRenders()
+{
+    if (!appPTR) {
+        return 0;
+    }
+    return (int)appPTR->getMultiThreadHandler()->_imp->nConcurrentFrameRenders;
+}
+
 ActionRetCodeEnum
 MultiThread::getCurrentThreadIndex(unsigned int *threadIndex)
 {
@@ -574,6 +953,9 @@ MultiThreadProcessorBase::launchThreadsNonBlocking(unsigned int nCPUs)
 
 ImageMultiThreadProcessorBase::ImageMultiThreadProcessorBase(const EffectInstancePtr& effect)
 : MultiThreadProcessorBase(effect)
+, _renderWindow()
+, _tileSizeX(0)
+, _tileSizeY(0)
 {
 
 }
@@ -589,6 +971,16 @@ ImageMultiThreadProcessorBase::setRenderWindow(const RectI& renderWindow)
     _renderWindow = renderWindow;
 }
 
+void
+ImageMultiThreadProcessorBase::alignRenderWindowToTiles(int tileSizeX, int tileSizeY)
+{
+    if (tileSizeX <= 0 || tileSizeY <= 0) {
+        return;
+    }
+    _tileSizeX = _tileSizeX > 0 ? std::min(_tileSizeX, tileSizeX) : tileSizeX;
+    _tileSizeY = _tileSizeY > 0 ? std::min(_tileSizeY, tileSizeY) : tileSizeY;
+}
+
 
 void
 ImageMultiThreadProcessorBase::getThreadRange(unsigned int threadID, unsigned int nThreads, int ibegin, int iend, int* ibegin_range, int* iend_range)
@@ -615,16 +1007,62 @@ ActionRetCodeEnum
 ImageMultiThreadProcessorBase::multiThreadFunction(unsigned int threadID,
                                                    unsigned int nThreads)
 {
+    if (_tileSizeX > 0) {
+        // Each thread gets a range of tiles, in the order they are stored
+        RectI tilesBounds = _renderWindow;
+        tilesBounds.roundToTileSize(_tileSizeX, _tileSizeY);
+        const int nTilesPerRow = tilesBounds.width() / _tileSizeX;
+        const int nTiles = nTilesPerRow * (tilesBounds.height() / _tileSizeY);
+
+        int fromIndex, toIndex;
+        getThreadRange(threadID, nThreads, 0, nTiles, &fromIndex, &toIndex);
+        for (int i = fromIndex; i < toIndex; ++i) {
+            if (_effect && _effect->isRenderAborted()) {
+                return eActionStatusAborted;
+            }
+            RectI tileRect;
+            tileRect.x1 = tilesBounds.x1 + (i % nTilesPerRow) * _tileSizeX;
+            tileRect.y1 = tilesBounds.y1 + (i / nTilesPerRow) * _tileSizeY;
+            tileRect.x2 = tileRect.x1 + _tileSizeX;
+            tileRect.y2 = tileRect.y1 + _tileSizeY;
+            RectI tileWindow;
+            if ( !tileRect.intersect(_renderWindow, &tileWindow) ) {
+                continue;
+            }
+            ActionRetCodeEnum stat = multiThreadProcessImages(tileWindow);
+            if (isFailureRetCode(stat)) {
+                return stat;
+            }
+        }
+        return eActionStatusOK;
+    }
+
     // Each threads get a rectangular portion but full scan-lines
     RectI win = _renderWindow;
     getThreadRange(threadID, nThreads, _renderWindow.y1, _renderWindow.y2, &win.y1, &win.y2);
 
-    if ( (win.y2 - win.y1) > 0 ) {
-        // and render that thread on each
-        return multiThreadProcessImages(win);
+    if ( (win.y2 - win.y1) <= 0 ) {
+        return eActionStatusOK;
+    }
+
+    // Process the range by bands of scan-lines so that an abort is noticed
+    // without waiting for the thread to finish its whole range
+    int width = std::max(1, win.x2 - win.x1);
+    int rowsPerBand = std::max(1, NATRON_MULTI_THREAD_ABORT_CHECK_PIXELS / width);
+    RectI band = win;
+    for (int y = win.y1; y < win.y2; y += rowsPerBand) {
+        if (_effect && _effect->isRenderAborted()) {
+            return eActionStatusAborted;
+        }
+        band.y1 = y;
+        band.y2 = std::min(y + rowsPerBand, win.y2);
+        ActionRetCodeEnum stat = multiThreadProcessImages(band);
+        if (isFailureRetCode(stat)) {
+            return stat;
+        }
     }
     return eActionStatusOK;
-}
+} // multiThreadFunction
 
 
 ActionRetCodeEnum
@@ -638,6 +1076,14 @@ ImageMultiThreadProcessorBase::process()
     // make sure the number of CPUs is valid (and use at least 1 CPU)
     nCPUs = std::max(1u, std::min( nCPUs, MultiThread::getNCPUsAvailable())) ;
 
+    // When processing by tiles, there is no point in having more threads than tiles
+    if (_tileSizeX > 0) {
+        RectI tilesBounds = _renderWindow;
+        tilesBounds.roundToTileSize(_tileSizeX, _tileSizeY);
+        unsigned int nTiles = (unsigned int)( (tilesBounds.width() / _tileSizeX) * (tilesBounds.height() / _tileSizeY) );
+        nCPUs = std::max(1u, std::min(nCPUs, nTiles));
+    }
+
     // call the base multi threading code
     return launchThreadsBlocking(nCPUs);
 
@@ -90,6 +90,8 @@ public:
      * Each thread will call 'func' passing in the index of the thread and the number of threads actually launched.
      * This function will not return until all the spawned threads have returned.
      * It is up to the host how it waits for all the threads to return (busy wait, blocking, whatever).
+     * When called from a render thread, the function runs on threads kept around by this thread for its
+     * subsequent calls, which poll for a while before sleeping.
      *
      * @param nThreads can be more than the value returned by getNCPUsAvailable,
      * however the threads will be limitted to the number of CPUs returned by getNCPUsAvailable.
@@ -120,6 +122,19 @@ public:
      **/
     static unsigned int getNCPUsAvailable();
 
+    /**
+     * @brief Register a frame render that runs concurrently with other frame renders, e.g: the frames of a render on disk.
+     * The CPUs returned by getNCPUsAvailable() are shared amongst all registered frame renders.
+     * Each call must be balanced with a call to unregisterFrameRender(), see FrameRenderCPUBudget_RAII.
+     **/
+    static void registerFrameRender();
+    static void unregisterFrameRender();
+
+    /**
+     * @brief Returns the number of frame renders currently registered with registerFrameRender()
+     **/
+    static int getNConcurrentFrameRenders();
+
     /**
      * @brief Function which indicates the index of the current thread.
      * This function returns the thread index, which is the same as the threadIndex argument passed to the ThreadFunctor.
@@ -143,6 +158,24 @@ private:
     boost::scoped_ptr<MultiThreadPrivate> _imp;
 };
 
+/**
+ * @brief Registers a frame render for the lifetime of this object, see MultiThread::registerFrameRender()
+ **/
+class FrameRenderCPUBudget_RAII
+{
+public:
+
+    FrameRenderCPUBudget_RAII()
+    {
+        MultiThread::registerFrameRender();
+    }
+
+    ~FrameRenderCPUBudget_RAII()
+    {
+        MultiThread::unregisterFrameRender();
+    }
+};
+
 /**
  * @brief Base class to multi-thread a function, makes use of the global application MultiThread object.
  **/
@@ -186,6 +219,9 @@ class ImageMultiThreadProcessorBase : public MultiThreadProcessorBase
 {
     RectI _renderWindow;
 
+    // If non 0, the render window is processed tile by tile
+    int _tileSizeX, _tileSizeY;
+
 public:
 
     ImageMultiThreadProcessorBase(const EffectInstancePtr& effect);
@@ -198,6 +234,15 @@ public:
      **/
     void setRenderWindow(const RectI& renderWindow);
 
+    /**
+     * @brief Ensures that each rectangle passed to multiThreadProcessImages() is contained in a single tile
+     * of the given size: the render window is split on the tiles and each thread processes whole tiles.
+     * This must be called for each image in the eImageBufferLayoutMonoChannelTiled layout processed, with the tile size
+     * of its CPU data. Tile sizes are powers of 2, so the smallest tiles also split the larger ones.
+     * This does nothing if tileSizeX or tileSizeY is 0, i.e: the image is not tiled.
+     **/
+    void alignRenderWindowToTiles(int tileSizeX, int tileSizeY);
+
     /**
      * @brief Launch the threads and render. This is a simple wrapper over launchThreads()
      * which set the appropriate number of threads given the render window
@@ -229,6 +274,86 @@ private:
 
 };
 
+#define NATRON_IMAGE_KERNEL_OPTIONS(PIX, maxValue, nComps, packed) \
+    { &KERNEL<PIX, maxValue, nComps, packed, false>::process, &KERNEL<PIX, maxValue, nComps, packed, true>::process }
+#define NATRON_IMAGE_KERNEL_LAYOUTS(PIX, maxValue, nComps) \
+    { NATRON_IMAGE_KERNEL_OPTIONS(PIX, maxValue, nComps, false), NATRON_IMAGE_KERNEL_OPTIONS(PIX, maxValue, nComps, true) }
+#define NATRON_IMAGE_KERNEL_COMPONENTS(PIX, maxValue) \
+    { NATRON_IMAGE_KERNEL_LAYOUTS(PIX, maxValue, 1), NATRON_IMAGE_KERNEL_LAYOUTS(PIX, maxValue, 2), \
+      NATRON_IMAGE_KERNEL_LAYOUTS(PIX, maxValue, 3), NATRON_IMAGE_KERNEL_LAYOUTS(PIX, maxValue, 4) }
+
+/**
+ * @brief A table of image processing kernels specialized at compile time for each combination of bit depth,
+ * number of components, buffer layout and of a boolean option of the kernel (e.g: premultiplied or masked).
+ * The kernel is looked-up once before processing a render window instead of going through nested switches,
+ * which is noticeable when processing many small tiles. KERNEL must be a class template of the form:
+ *
+ * template <typename PIX, int maxValue, int nComps, bool packed, bool option>
+ * struct MyKernel
+ * {
+ *     static ActionRetCodeEnum process(const MyKernelArgs& args, const RectI& roi);
+ * };
+ *
+ * where packed is true if the image has the eImageBufferLayoutRGBAPackedFullRect layout, in which case
+ * the pixel stride is nComps, otherwise the pixel stride is 1.
+ **/
+template <typename ARGS, template <typename, int, int, bool, bool> class KERNEL>
+class ImageKernelTable
+{
+public:
+
+    typedef ActionRetCodeEnum (*KernelFunction)(const ARGS& args, const RectI& roi);
+
+    /**
+     * @brief Returns the kernel for the given parameters, or NULL if the bit depth or the number of components
+     * is not supported.
+     **/
+    static KernelFunction getKernel(ImageBitDepthEnum bitdepth,
+                                    int nComps,
+                                    bool packed,
+                                    bool option)
+    {
+        // The table only holds addresses of functions: it is initialized statically, which is thread-safe
+        static const KernelFunction table[3][4][2][2] = {
+            NATRON_IMAGE_KERNEL_COMPONENTS(unsigned char, 255),
+            NATRON_IMAGE_KERNEL_COMPONENTS(unsigned short, 65535),
+            NATRON_IMAGE_KERNEL_COMPONENTS(float, 1)
+        };
+
+        int depthIndex;
+        switch (bitdepth) {
+            case eImageBitDepthByte:
+                depthIndex = 0;
+                break;
+            case eImageBitDepthShort:
+                depthIndex = 1;
+                break;
+            case eImageBitDepthFloat:
+                depthIndex = 2;
+                break;
+            default:
+                return 0;
+        }
+        if (nComps < 1 || nComps > 4) {
+            return 0;
+        }
+        return table[depthIndex][nComps - 1][packed ? 1 : 0][option ? 1 : 0];
+    }
+
+    /**
+     * @brief Returns whether the image whose channel pointers are given has the eImageBufferLayoutRGBAPackedFullRect
+     * layout, see Image::getChannelPointers()
+     **/
+    static bool isPackedLayout(void* const ptrs[4], int nComps)
+    {
+        return nComps == 1 || !ptrs[1];
+    }
+};
+
+#undef NATRON_IMAGE_KERNEL_OPTIONS
+#undef NATRON_IMAGE_KERNEL_LAYOUTS
+#undef NATRON_IMAGE_KERNEL_COMPONENTS
+
 NATRON_NAMESPACE_EXIT;
 
 #endif // NATRON_ENGINE_MULTITHREAD_H
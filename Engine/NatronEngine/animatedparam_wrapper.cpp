@@ -1094,6 +1094,89 @@ static PyObject* Sbk_AnimatedParamFunc_setInterpolationAtTime(PyObject* self, Py
         return 0;
 }
 
+static PyObject* Sbk_AnimatedParamFunc_smoothAnimation(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    AnimatedParamWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (AnimatedParamWrapper*)((::AnimatedParam*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_ANIMATEDPARAM_IDX], (SbkObject*)self));
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numNamedArgs = (kwds ? PyDict_Size(kwds) : 0);
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0};
+
+    // invalid argument lengths
+    if (numArgs + numNamedArgs > 2) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.AnimatedParam.smoothAnimation(): too many arguments");
+        return 0;
+    }
+
+    if (!PyArg_ParseTuple(args, "|OO:smoothAnimation", &(pyArgs[0]), &(pyArgs[1])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: smoothAnimation(int,QString)
+    if (numArgs == 0) {
+        overloadId = 0; // smoothAnimation(int,QString)
+    } else if ((pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[0])))) {
+        if (numArgs == 1) {
+            overloadId = 0; // smoothAnimation(int,QString)
+        } else if ((pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArgs[1])))) {
+            overloadId = 0; // smoothAnimation(int,QString)
+        }
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_AnimatedParamFunc_smoothAnimation_TypeError;
+
+    // Call function/method
+    {
+        if (kwds) {
+            PyObject* value = PyDict_GetItemString(kwds, "dimension");
+            if (value && pyArgs[0]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.AnimatedParam.smoothAnimation(): got multiple values for keyword argument 'dimension'.");
+                return 0;
+            } else if (value) {
+                pyArgs[0] = value;
+                if (!(pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[0]))))
+                    goto Sbk_AnimatedParamFunc_smoothAnimation_TypeError;
+            }
+            value = PyDict_GetItemString(kwds, "view");
+            if (value && pyArgs[1]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.AnimatedParam.smoothAnimation(): got multiple values for keyword argument 'view'.");
+                return 0;
+            } else if (value) {
+                pyArgs[1] = value;
+                if (!(pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArgs[1]))))
+                    goto Sbk_AnimatedParamFunc_smoothAnimation_TypeError;
+            }
+        }
+        int cppArg0 = -1;
+        if (pythonToCpp[0]) pythonToCpp[0](pyArgs[0], &cppArg0);
+        ::QString cppArg1 = QLatin1String("All");
+        if (pythonToCpp[1]) pythonToCpp[1](pyArgs[1], &cppArg1);
+
+        if (!PyErr_Occurred()) {
+            // smoothAnimation(int,QString)
+            cppSelf->smoothAnimation(cppArg0, cppArg1);
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+
+    Sbk_AnimatedParamFunc_smoothAnimation_TypeError:
+        const char* overloads[] = {"int = -1, unicode = QLatin1String(\"All\")", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.AnimatedParam.smoothAnimation", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_AnimatedParamFunc_splitView(PyObject* self, PyObject* pyArg)
 {
     AnimatedParamWrapper* cppSelf = 0;
@@ -1192,6 +1275,7 @@ static PyMethodDef Sbk_AnimatedParam_methods[] = {
     {"removeAnimation", (PyCFunction)Sbk_AnimatedParamFunc_removeAnimation, METH_VARARGS|METH_KEYWORDS},
     {"setExpression", (PyCFunction)Sbk_AnimatedParamFunc_setExpression, METH_VARARGS|METH_KEYWORDS},
     {"setInterpolationAtTime", (PyCFunction)Sbk_AnimatedParamFunc_setInterpolationAtTime, METH_VARARGS|METH_KEYWORDS},
+    {"smoothAnimation", (PyCFunction)Sbk_AnimatedParamFunc_smoothAnimation, METH_VARARGS|METH_KEYWORDS},
     {"splitView", (PyCFunction)Sbk_AnimatedParamFunc_splitView, METH_O},
     {"unSplitView", (PyCFunction)Sbk_AnimatedParamFunc_unSplitView, METH_O},
 
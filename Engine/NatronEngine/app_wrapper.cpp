@@ -512,6 +512,58 @@ static PyObject* Sbk_AppFunc_getAppID(PyObject* self)
     return pyResult;
 }
 
+static PyObject* Sbk_AppFunc_getCacheStats(PyObject* self)
+{
+    AppWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (AppWrapper*)((::App*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_APP_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+
+    // Call function/method
+    {
+
+        if (!PyErr_Occurred()) {
+            // getCacheStats()const
+            QMap<QString, QVariant > cppResult = const_cast<const ::AppWrapper*>(cppSelf)->getCacheStats();
+            pyResult = Shiboken::Conversions::copyToPython(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_QMAP_QSTRING_QVARIANT_IDX], &cppResult);
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+}
+
+static PyObject* Sbk_AppFunc_getMemoryUsage(PyObject* self)
+{
+    AppWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (AppWrapper*)((::App*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_APP_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+
+    // Call function/method
+    {
+
+        if (!PyErr_Occurred()) {
+            // getMemoryUsage()const
+            QMap<QString, QVariant > cppResult = const_cast<const ::AppWrapper*>(cppSelf)->getMemoryUsage();
+            pyResult = Shiboken::Conversions::copyToPython(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_QMAP_QSTRING_QVARIANT_IDX], &cppResult);
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+}
+
 static PyObject* Sbk_AppFunc_getProjectParam(PyObject* self, PyObject* pyArg)
 {
     AppWrapper* cppSelf = 0;
@@ -1037,6 +1089,87 @@ static PyObject* Sbk_AppFunc_render(PyObject* self, PyObject* args, PyObject* kw
         return 0;
 }
 
+static PyObject* Sbk_AppFunc_renderCombined(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    AppWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (AppWrapper*)((::App*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_APP_IDX], (SbkObject*)self));
+    PythonToCppFunc pythonToCpp[] = { 0, 0, 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numNamedArgs = (kwds ? PyDict_Size(kwds) : 0);
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0, 0, 0};
+
+    // invalid argument lengths
+    if (numArgs + numNamedArgs > 4) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.App.renderCombined(): too many arguments");
+        return 0;
+    } else if (numArgs < 3) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.App.renderCombined(): not enough arguments");
+        return 0;
+    }
+
+    if (!PyArg_ParseTuple(args, "|OOOO:renderCombined", &(pyArgs[0]), &(pyArgs[1]), &(pyArgs[2]), &(pyArgs[3])))
+        return 0;
+
+    // Overloaded function decisor
+    // 0: renderCombined(std::list<Effect*>,int,int,int)
+    if (!PyList_Check(pyArgs[0])
+        || !(pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[1])))
+        || !(pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[2]))))
+        goto Sbk_AppFunc_renderCombined_TypeError;
+    if (kwds) {
+        PyObject* value = PyDict_GetItemString(kwds, "frameStep");
+        if (value && pyArgs[3]) {
+            PyErr_SetString(PyExc_TypeError, "NatronEngine.App.renderCombined(): got multiple values for keyword argument 'frameStep'.");
+            return 0;
+        } else if (value) {
+            pyArgs[3] = value;
+        }
+    }
+    if (pyArgs[3] && !(pythonToCpp[3] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[3]))))
+        goto Sbk_AppFunc_renderCombined_TypeError;
+
+    // Call function/method
+    {
+        std::list<Effect*> writeNodes;
+        int size = (int)PyList_GET_SIZE(pyArgs[0]);
+        for (int i = 0; i < size; ++i) {
+            PyObject* item = PyList_GET_ITEM(pyArgs[0], i);
+            if (!Shiboken::Conversions::isPythonToCppPointerConvertible((SbkObjectType*)SbkNatronEngineTypes[SBK_EFFECT_IDX], item)) {
+                PyErr_SetString(PyExc_TypeError, "writeNodes must be a list of Effect objects.");
+                return 0;
+            }
+            ::Effect* writeNode = ((::Effect*)0);
+            Shiboken::Conversions::pythonToCppPointer((SbkObjectType*)SbkNatronEngineTypes[SBK_EFFECT_IDX], item, &(writeNode));
+            writeNodes.push_back(writeNode);
+        }
+        int cppArg1;
+        pythonToCpp[1](pyArgs[1], &cppArg1);
+        int cppArg2;
+        pythonToCpp[2](pyArgs[2], &cppArg2);
+        int cppArg3 = 1;
+        if (pythonToCpp[3]) pythonToCpp[3](pyArgs[3], &cppArg3);
+
+        if (!PyErr_Occurred()) {
+            // renderCombined(std::list<Effect*>,int,int,int)
+            cppSelf->renderCombined(writeNodes, cppArg1, cppArg2, cppArg3);
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+
+    Sbk_AppFunc_renderCombined_TypeError:
+        const char* overloads[] = {"list, int, int, int = 1", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.App.renderCombined", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_AppFunc_resetProject(PyObject* self)
 {
     AppWrapper* cppSelf = 0;
@@ -1368,6 +1501,8 @@ static PyMethodDef Sbk_App_methods[] = {
     {"createReader", (PyCFunction)Sbk_AppFunc_createReader, METH_VARARGS|METH_KEYWORDS},
     {"createWriter", (PyCFunction)Sbk_AppFunc_createWriter, METH_VARARGS|METH_KEYWORDS},
     {"getAppID", (PyCFunction)Sbk_AppFunc_getAppID, METH_NOARGS},
+    {"getCacheStats", (PyCFunction)Sbk_AppFunc_getCacheStats, METH_NOARGS},
+    {"getMemoryUsage", (PyCFunction)Sbk_AppFunc_getMemoryUsage, METH_NOARGS},
     {"getProjectParam", (PyCFunction)Sbk_AppFunc_getProjectParam, METH_O},
     {"getViewIndex", (PyCFunction)Sbk_AppFunc_getViewIndex, METH_O},
     {"getViewName", (PyCFunction)Sbk_AppFunc_getViewName, METH_O},
@@ -1377,6 +1512,7 @@ static PyMethodDef Sbk_App_methods[] = {
     {"redrawViewer", (PyCFunction)Sbk_AppFunc_redrawViewer, METH_O},
     {"refreshViewer", (PyCFunction)Sbk_AppFunc_refreshViewer, METH_VARARGS|METH_KEYWORDS},
     {"render", (PyCFunction)Sbk_AppFunc_render, METH_VARARGS|METH_KEYWORDS},
+    {"renderCombined", (PyCFunction)Sbk_AppFunc_renderCombined, METH_VARARGS|METH_KEYWORDS},
     {"resetProject", (PyCFunction)Sbk_AppFunc_resetProject, METH_NOARGS},
     {"saveProject", (PyCFunction)Sbk_AppFunc_saveProject, METH_O},
     {"saveProjectAs", (PyCFunction)Sbk_AppFunc_saveProjectAs, METH_O},
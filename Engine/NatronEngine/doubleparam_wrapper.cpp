@@ -698,6 +698,99 @@ static PyObject* Sbk_DoubleParamFunc_getValueAtTime(PyObject* self, PyObject* ar
         return 0;
 }
 
+static PyObject* Sbk_DoubleParamFunc_getValuesAtTimes(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    DoubleParamWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (DoubleParamWrapper*)((::DoubleParam*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_DOUBLEPARAM_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numNamedArgs = (kwds ? PyDict_Size(kwds) : 0);
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0, 0};
+
+    // invalid argument lengths
+    if (numArgs + numNamedArgs > 3) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.getValuesAtTimes(): too many arguments");
+        return 0;
+    } else if (numArgs < 1) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.getValuesAtTimes(): not enough arguments");
+        return 0;
+    }
+
+    if (!PyArg_ParseTuple(args, "|OOO:getValuesAtTimes", &(pyArgs[0]), &(pyArgs[1]), &(pyArgs[2])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: getValuesAtTimes(std::vector<double>,int,QString)const
+    if ((pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_STD_VECTOR_DOUBLE_IDX], (pyArgs[0])))) {
+        if (numArgs == 1) {
+            overloadId = 0; // getValuesAtTimes(std::vector<double>,int,QString)const
+        } else if ((pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[1])))) {
+            if (numArgs == 2) {
+                overloadId = 0; // getValuesAtTimes(std::vector<double>,int,QString)const
+            } else if ((pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArgs[2])))) {
+                overloadId = 0; // getValuesAtTimes(std::vector<double>,int,QString)const
+            }
+        }
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_DoubleParamFunc_getValuesAtTimes_TypeError;
+
+    // Call function/method
+    {
+        if (kwds) {
+            PyObject* value = PyDict_GetItemString(kwds, "dimension");
+            if (value && pyArgs[1]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.getValuesAtTimes(): got multiple values for keyword argument 'dimension'.");
+                return 0;
+            } else if (value) {
+                pyArgs[1] = value;
+                if (!(pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[1]))))
+                    goto Sbk_DoubleParamFunc_getValuesAtTimes_TypeError;
+            }
+            value = PyDict_GetItemString(kwds, "view");
+            if (value && pyArgs[2]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.getValuesAtTimes(): got multiple values for keyword argument 'view'.");
+                return 0;
+            } else if (value) {
+                pyArgs[2] = value;
+                if (!(pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArgs[2]))))
+                    goto Sbk_DoubleParamFunc_getValuesAtTimes_TypeError;
+            }
+        }
+        ::std::vector<double > cppArg0;
+        pythonToCpp[0](pyArgs[0], &cppArg0);
+        int cppArg1 = 0;
+        if (pythonToCpp[1]) pythonToCpp[1](pyArgs[1], &cppArg1);
+        ::QString cppArg2 = QLatin1String("Main");
+        if (pythonToCpp[2]) pythonToCpp[2](pyArgs[2], &cppArg2);
+
+        if (!PyErr_Occurred()) {
+            // getValuesAtTimes(std::vector<double>,int,QString)const
+            std::vector<double > cppResult = const_cast<const ::DoubleParamWrapper*>(cppSelf)->getValuesAtTimes(cppArg0, cppArg1, cppArg2);
+            pyResult = Shiboken::Conversions::copyToPython(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_STD_VECTOR_DOUBLE_IDX], &cppResult);
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+
+    Sbk_DoubleParamFunc_getValuesAtTimes_TypeError:
+        const char* overloads[] = {"list, int = 0, unicode = QLatin1String(\"Main\")", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.DoubleParam.getValuesAtTimes", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_DoubleParamFunc_restoreDefaultValue(PyObject* self, PyObject* args, PyObject* kwds)
 {
     DoubleParamWrapper* cppSelf = 0;
@@ -1452,6 +1545,100 @@ static PyObject* Sbk_DoubleParamFunc_setValueAtTime(PyObject* self, PyObject* ar
         return 0;
 }
 
+static PyObject* Sbk_DoubleParamFunc_setValuesAtTimes(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    DoubleParamWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (DoubleParamWrapper*)((::DoubleParam*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_DOUBLEPARAM_IDX], (SbkObject*)self));
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0, 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numNamedArgs = (kwds ? PyDict_Size(kwds) : 0);
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0, 0, 0};
+
+    // invalid argument lengths
+    if (numArgs + numNamedArgs > 4) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.setValuesAtTimes(): too many arguments");
+        return 0;
+    } else if (numArgs < 2) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.setValuesAtTimes(): not enough arguments");
+        return 0;
+    }
+
+    if (!PyArg_ParseTuple(args, "|OOOO:setValuesAtTimes", &(pyArgs[0]), &(pyArgs[1]), &(pyArgs[2]), &(pyArgs[3])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: setValuesAtTimes(std::vector<double>,std::vector<double>,int,QString)
+    if (numArgs >= 2
+        && (pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_STD_VECTOR_DOUBLE_IDX], (pyArgs[0])))
+        && (pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_STD_VECTOR_DOUBLE_IDX], (pyArgs[1])))) {
+        if (numArgs == 2) {
+            overloadId = 0; // setValuesAtTimes(std::vector<double>,std::vector<double>,int,QString)
+        } else if ((pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[2])))) {
+            if (numArgs == 3) {
+                overloadId = 0; // setValuesAtTimes(std::vector<double>,std::vector<double>,int,QString)
+            } else if ((pythonToCpp[3] = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArgs[3])))) {
+                overloadId = 0; // setValuesAtTimes(std::vector<double>,std::vector<double>,int,QString)
+            }
+        }
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_DoubleParamFunc_setValuesAtTimes_TypeError;
+
+    // Call function/method
+    {
+        if (kwds) {
+            PyObject* value = PyDict_GetItemString(kwds, "dimension");
+            if (value && pyArgs[2]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.setValuesAtTimes(): got multiple values for keyword argument 'dimension'.");
+                return 0;
+            } else if (value) {
+                pyArgs[2] = value;
+                if (!(pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[2]))))
+                    goto Sbk_DoubleParamFunc_setValuesAtTimes_TypeError;
+            }
+            value = PyDict_GetItemString(kwds, "view");
+            if (value && pyArgs[3]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.DoubleParam.setValuesAtTimes(): got multiple values for keyword argument 'view'.");
+                return 0;
+            } else if (value) {
+                pyArgs[3] = value;
+                if (!(pythonToCpp[3] = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArgs[3]))))
+                    goto Sbk_DoubleParamFunc_setValuesAtTimes_TypeError;
+            }
+        }
+        ::std::vector<double > cppArg0;
+        pythonToCpp[0](pyArgs[0], &cppArg0);
+        ::std::vector<double > cppArg1;
+        pythonToCpp[1](pyArgs[1], &cppArg1);
+        int cppArg2 = 0;
+        if (pythonToCpp[2]) pythonToCpp[2](pyArgs[2], &cppArg2);
+        ::QString cppArg3 = QLatin1String("All");
+        if (pythonToCpp[3]) pythonToCpp[3](pyArgs[3], &cppArg3);
+
+        if (!PyErr_Occurred()) {
+            // setValuesAtTimes(std::vector<double>,std::vector<double>,int,QString)
+            cppSelf->setValuesAtTimes(cppArg0, cppArg1, cppArg2, cppArg3);
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+
+    Sbk_DoubleParamFunc_setValuesAtTimes_TypeError:
+        const char* overloads[] = {"list, list, int = 0, unicode = QLatin1String(\"All\")", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.DoubleParam.setValuesAtTimes", overloads);
+        return 0;
+}
+
 static PyMethodDef Sbk_DoubleParam_methods[] = {
     {"addAsDependencyOf", (PyCFunction)Sbk_DoubleParamFunc_addAsDependencyOf, METH_VARARGS},
     {"get", (PyCFunction)Sbk_DoubleParamFunc_get, METH_VARARGS|METH_KEYWORDS},
@@ -1462,6 +1649,7 @@ static PyMethodDef Sbk_DoubleParam_methods[] = {
     {"getMinimum", (PyCFunction)Sbk_DoubleParamFunc_getMinimum, METH_VARARGS|METH_KEYWORDS},
     {"getValue", (PyCFunction)Sbk_DoubleParamFunc_getValue, METH_VARARGS|METH_KEYWORDS},
     {"getValueAtTime", (PyCFunction)Sbk_DoubleParamFunc_getValueAtTime, METH_VARARGS|METH_KEYWORDS},
+    {"getValuesAtTimes", (PyCFunction)Sbk_DoubleParamFunc_getValuesAtTimes, METH_VARARGS|METH_KEYWORDS},
     {"restoreDefaultValue", (PyCFunction)Sbk_DoubleParamFunc_restoreDefaultValue, METH_VARARGS|METH_KEYWORDS},
     {"set", (PyCFunction)Sbk_DoubleParamFunc_set, METH_VARARGS|METH_KEYWORDS},
     {"setDefaultValue", (PyCFunction)Sbk_DoubleParamFunc_setDefaultValue, METH_VARARGS|METH_KEYWORDS},
@@ -1471,6 +1659,7 @@ static PyMethodDef Sbk_DoubleParam_methods[] = {
     {"setMinimum", (PyCFunction)Sbk_DoubleParamFunc_setMinimum, METH_VARARGS|METH_KEYWORDS},
     {"setValue", (PyCFunction)Sbk_DoubleParamFunc_setValue, METH_VARARGS|METH_KEYWORDS},
     {"setValueAtTime", (PyCFunction)Sbk_DoubleParamFunc_setValueAtTime, METH_VARARGS|METH_KEYWORDS},
+    {"setValuesAtTimes", (PyCFunction)Sbk_DoubleParamFunc_setValuesAtTimes, METH_VARARGS|METH_KEYWORDS},
 
     {0} // Sentinel
 };
@@ -674,6 +674,108 @@ static PyObject* Sbk_EffectFunc_getFrameRate(PyObject* self)
     return pyResult;
 }
 
+static PyObject* Sbk_EffectFunc_getImage(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    ::Effect* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = ((::Effect*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_EFFECT_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0, 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numNamedArgs = (kwds ? PyDict_Size(kwds) : 0);
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0, 0, 0};
+
+    // invalid argument lengths
+    if (numArgs + numNamedArgs > 4) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.Effect.getImage(): too many arguments");
+        return 0;
+    } else if (numArgs < 2) {
+        PyErr_SetString(PyExc_TypeError, "NatronEngine.Effect.getImage(): not enough arguments");
+        return 0;
+    }
+
+    if (!PyArg_ParseTuple(args, "|OOOO:getImage", &(pyArgs[0]), &(pyArgs[1]), &(pyArgs[2]), &(pyArgs[3])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: getImage(double,ImageLayer,QString,int)const
+    if ((pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<double>(), (pyArgs[0])))
+        && (pythonToCpp[1] = Shiboken::Conversions::isPythonToCppReferenceConvertible((SbkObjectType*)SbkNatronEngineTypes[SBK_IMAGELAYER_IDX], (pyArgs[1])))) {
+        if (numArgs == 2) {
+            overloadId = 0; // getImage(double,ImageLayer,QString,int)const
+        } else if ((pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArgs[2])))) {
+            if (numArgs == 3) {
+                overloadId = 0; // getImage(double,ImageLayer,QString,int)const
+            } else if ((pythonToCpp[3] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[3])))) {
+                overloadId = 0; // getImage(double,ImageLayer,QString,int)const
+            }
+        }
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_EffectFunc_getImage_TypeError;
+
+    // Call function/method
+    {
+        if (kwds) {
+            PyObject* value = PyDict_GetItemString(kwds, "view");
+            if (value && pyArgs[2]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.Effect.getImage(): got multiple values for keyword argument 'view'.");
+                return 0;
+            } else if (value) {
+                pyArgs[2] = value;
+                if (!(pythonToCpp[2] = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArgs[2]))))
+                    goto Sbk_EffectFunc_getImage_TypeError;
+            }
+            value = PyDict_GetItemString(kwds, "mipMapLevel");
+            if (value && pyArgs[3]) {
+                PyErr_SetString(PyExc_TypeError, "NatronEngine.Effect.getImage(): got multiple values for keyword argument 'mipMapLevel'.");
+                return 0;
+            } else if (value) {
+                pyArgs[3] = value;
+                if (!(pythonToCpp[3] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[3]))))
+                    goto Sbk_EffectFunc_getImage_TypeError;
+            }
+        }
+        double cppArg0;
+        pythonToCpp[0](pyArgs[0], &cppArg0);
+        if (!Shiboken::Object::isValid(pyArgs[1]))
+            return 0;
+        ::ImageLayer cppArg1_local = ::ImageLayer(::QString(), ::QString(), ::QStringList());
+        ::ImageLayer* cppArg1 = &cppArg1_local;
+        if (Shiboken::Conversions::isImplicitConversion((SbkObjectType*)SbkNatronEngineTypes[SBK_IMAGELAYER_IDX], pythonToCpp[1]))
+            pythonToCpp[1](pyArgs[1], &cppArg1_local);
+        else
+            pythonToCpp[1](pyArgs[1], &cppArg1);
+        ::QString cppArg2 = QString::fromUtf8("Main");
+        if (pythonToCpp[2]) pythonToCpp[2](pyArgs[2], &cppArg2);
+        int cppArg3 = 0;
+        if (pythonToCpp[3]) pythonToCpp[3](pyArgs[3], &cppArg3);
+
+        if (!PyErr_Occurred()) {
+            // getImage(double,ImageLayer,QString,int)const
+            // The result is a new reference created by the Engine
+            pyResult = const_cast<const ::Effect*>(cppSelf)->getImage(cppArg0, *cppArg1, cppArg2, cppArg3);
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+
+    Sbk_EffectFunc_getImage_TypeError:
+        const char* overloads[] = {"float, NatronEngine.ImageLayer, unicode = QString.fromUtf8(\"Main\"), int = 0", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.Effect.getImage", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_EffectFunc_getInput(PyObject* self, PyObject* pyArg)
 {
     ::Effect* cppSelf = 0;
@@ -1941,6 +2043,7 @@ static PyMethodDef Sbk_Effect_methods[] = {
     {"getContainerGroup", (PyCFunction)Sbk_EffectFunc_getContainerGroup, METH_NOARGS},
     {"getCurrentTime", (PyCFunction)Sbk_EffectFunc_getCurrentTime, METH_NOARGS},
     {"getFrameRate", (PyCFunction)Sbk_EffectFunc_getFrameRate, METH_NOARGS},
+    {"getImage", (PyCFunction)Sbk_EffectFunc_getImage, METH_VARARGS|METH_KEYWORDS},
     {"getInput", (PyCFunction)Sbk_EffectFunc_getInput, METH_O},
     {"getInputLabel", (PyCFunction)Sbk_EffectFunc_getInputLabel, METH_O},
     {"getItemsTable", (PyCFunction)Sbk_EffectFunc_getItemsTable, METH_NOARGS},
@@ -707,6 +707,109 @@ static PyObject* Sbk_PyCoreApplicationFunc_isWindows(PyObject* self)
     return pyResult;
 }
 
+static PyObject* Sbk_PyCoreApplicationFunc_readProjectNodes(PyObject* self, PyObject* pyArg)
+{
+    ::PyCoreApplication* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = ((::PyCoreApplication*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_PYCOREAPPLICATION_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp;
+    SBK_UNUSED(pythonToCpp)
+
+    // Overloaded function decisor
+    // 0: readProjectNodes(QString)const
+    if ((pythonToCpp = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArg)))) {
+        overloadId = 0; // readProjectNodes(QString)const
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_PyCoreApplicationFunc_readProjectNodes_TypeError;
+
+    // Call function/method
+    {
+        ::QString cppArg0 = ::QString();
+        pythonToCpp(pyArg, &cppArg0);
+
+        if (!PyErr_Occurred()) {
+            // readProjectNodes(QString)const
+            std::map<QString, QString > cppResult = const_cast<const ::PyCoreApplication*>(cppSelf)->readProjectNodes(cppArg0);
+            pyResult = Shiboken::Conversions::copyToPython(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_STD_MAP_QSTRING_QSTRING_IDX], &cppResult);
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+
+    Sbk_PyCoreApplicationFunc_readProjectNodes_TypeError:
+        const char* overloads[] = {"unicode", 0};
+        Shiboken::setErrorAboutWrongArguments(pyArg, "NatronEngine.PyCoreApplication.readProjectNodes", overloads);
+        return 0;
+}
+
+static PyObject* Sbk_PyCoreApplicationFunc_readProjectParamValues(PyObject* self, PyObject* args)
+{
+    ::PyCoreApplication* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = ((::PyCoreApplication*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_PYCOREAPPLICATION_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0};
+
+    // invalid argument lengths
+
+
+    if (!PyArg_UnpackTuple(args, "readProjectParamValues", 2, 2, &(pyArgs[0]), &(pyArgs[1])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: readProjectParamValues(QString,QString)const
+    if (numArgs == 2
+        && (pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArgs[0])))
+        && (pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(SbkPySide_QtCoreTypeConverters[SBK_QSTRING_IDX], (pyArgs[1])))) {
+        overloadId = 0; // readProjectParamValues(QString,QString)const
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_PyCoreApplicationFunc_readProjectParamValues_TypeError;
+
+    // Call function/method
+    {
+        ::QString cppArg0 = ::QString();
+        pythonToCpp[0](pyArgs[0], &cppArg0);
+        ::QString cppArg1 = ::QString();
+        pythonToCpp[1](pyArgs[1], &cppArg1);
+
+        if (!PyErr_Occurred()) {
+            // readProjectParamValues(QString,QString)const
+            std::map<QString, QString > cppResult = const_cast<const ::PyCoreApplication*>(cppSelf)->readProjectParamValues(cppArg0, cppArg1);
+            pyResult = Shiboken::Conversions::copyToPython(SbkNatronEngineTypeConverters[SBK_NATRONENGINE_STD_MAP_QSTRING_QSTRING_IDX], &cppResult);
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+
+    Sbk_PyCoreApplicationFunc_readProjectParamValues_TypeError:
+        const char* overloads[] = {"unicode, unicode", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.PyCoreApplication.readProjectParamValues", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_PyCoreApplicationFunc_setOnProjectCreatedCallback(PyObject* self, PyObject* pyArg)
 {
     ::PyCoreApplication* cppSelf = 0;
@@ -813,6 +916,8 @@ static PyMethodDef Sbk_PyCoreApplication_methods[] = {
     {"isMacOSX", (PyCFunction)Sbk_PyCoreApplicationFunc_isMacOSX, METH_NOARGS},
     {"isUnix", (PyCFunction)Sbk_PyCoreApplicationFunc_isUnix, METH_NOARGS},
     {"isWindows", (PyCFunction)Sbk_PyCoreApplicationFunc_isWindows, METH_NOARGS},
+    {"readProjectNodes", (PyCFunction)Sbk_PyCoreApplicationFunc_readProjectNodes, METH_O},
+    {"readProjectParamValues", (PyCFunction)Sbk_PyCoreApplicationFunc_readProjectParamValues, METH_VARARGS},
     {"setOnProjectCreatedCallback", (PyCFunction)Sbk_PyCoreApplicationFunc_setOnProjectCreatedCallback, METH_O},
     {"setOnProjectLoadedCallback", (PyCFunction)Sbk_PyCoreApplicationFunc_setOnProjectLoadedCallback, METH_O},
 
@@ -82,7 +82,7 @@ public:
 
     virtual bool isHostChannelSelectorSupported(bool* defaultR, bool* defaultG, bool* defaultB, bool* defaultA) const OVERRIDE FINAL;
 
-private:
+protected:
 
     /**
      * @brief A NoOp is always an identity on its input.
@@ -95,7 +95,7 @@ private:
                                          TimeValue* inputTime,
                                          ViewIdx* inputView,
                                          int* inputNb,
-                                         ImagePlaneDesc* inputPlane) OVERRIDE FINAL WARN_UNUSED_RETURN;
+                                         ImagePlaneDesc* inputPlane) OVERRIDE WARN_UNUSED_RETURN;
 };
 
 inline NoOpBasePtr
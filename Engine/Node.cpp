@@ -1153,6 +1153,35 @@ Node::getIsInputNRenderingCounter(int inputNb) const
     return _imp->inputIsRenderingCounter[inputNb];
 }
 
+void
+Node::addRenderTimeSample(double timeSeconds, double nPixels)
+{
+    if (timeSeconds <= 0 || nPixels <= 0) {
+        return;
+    }
+    double sample = timeSeconds / nPixels;
+    QMutexLocker l(&_imp->renderTimeEstimateMutex);
+    if (_imp->renderTimePerPixelEstimate == 0) {
+        _imp->renderTimePerPixelEstimate = sample;
+    } else {
+        // Exponential moving average: recent renders weigh more since the settings of the node may have changed
+        _imp->renderTimePerPixelEstimate = 0.8 * _imp->renderTimePerPixelEstimate + 0.2 * sample;
+    }
+}
+
+double
+Node::getRenderTimePerPixelEstimate() const
+{
+    QMutexLocker l(&_imp->renderTimeEstimateMutex);
+    return _imp->renderTimePerPixelEstimate;
+}
+
+MemoryAccountPtr
+Node::getMemoryAccount() const
+{
+    return _imp->memoryAccount;
+}
+
 int
 Node::getIsNodeRenderingCounter() const
 {
@@ -1415,18 +1444,24 @@ Node::getPosition(double *x,
 void
 Node::onNodeUIPositionChanged(double x, double y)
 {
-    QMutexLocker k(&_imp->nodeUIDataMutex);
-    _imp->nodePositionCoords[0] = x;
-    _imp->nodePositionCoords[1] = y;
+    {
+        QMutexLocker k(&_imp->nodeUIDataMutex);
+        _imp->nodePositionCoords[0] = x;
+        _imp->nodePositionCoords[1] = y;
+    }
+    invalidateAutoSaveSerialization();
 }
 
 void
 Node::onNodeUISizeChanged(double w,
               double h)
 {
-    QMutexLocker k(&_imp->nodeUIDataMutex);
-    _imp->nodeSize[0] = w;
-    _imp->nodeSize[1] = h;
+    {
+        QMutexLocker k(&_imp->nodeUIDataMutex);
+        _imp->nodeSize[0] = w;
+        _imp->nodeSize[1] = h;
+    }
+    invalidateAutoSaveSerialization();
 }
 
 
@@ -1529,11 +1564,13 @@ Node::onNodeUIColorChanged(double r,
                            double g,
                            double b)
 {
-    QMutexLocker k(&_imp->nodeUIDataMutex);
-    _imp->nodeColor[0] = r;
-    _imp->nodeColor[1] = g;
-    _imp->nodeColor[2] = b;
-
+    {
+        QMutexLocker k(&_imp->nodeUIDataMutex);
+        _imp->nodeColor[0] = r;
+        _imp->nodeColor[1] = g;
+        _imp->nodeColor[2] = b;
+    }
+    invalidateAutoSaveSerialization();
 }
 
 
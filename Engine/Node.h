@@ -157,6 +157,8 @@ public:
 
 private:
 
+    void toSerializationInternal(SERIALIZATION_NAMESPACE::NodeSerialization* serialization, bool useAutoSaveSerialization);
+
     void initNodeNameFallbackOnPluginDefault();
 
     void createNodeGuiInternal(const CreateNodeArgsPtr& args);
@@ -181,6 +183,20 @@ public:
      **/
     virtual void fromSerialization(const SERIALIZATION_NAMESPACE::SerializationObjectBase& serializationBase) OVERRIDE FINAL;
 
+    /**
+     * @brief Returns the serialization of this node written in auto-saves. The serialization of the previous
+     * auto-save is returned as long as invalidateAutoSaveSerialization() was not called since, so that auto-saves
+     * only serialize the nodes that were modified. Group nodes are always serialized, but re-use the cached
+     * serialization of their children.
+     **/
+    SERIALIZATION_NAMESPACE::NodeSerializationPtr getAutoSaveSerialization();
+
+    /**
+     * @brief Must be called whenever something saved in the serialization of this node is modified.
+     * This is MT-safe.
+     **/
+    void invalidateAutoSaveSerialization();
+
     void loadInternalNodeGraph(bool initialSetupAllowed,
                                const SERIALIZATION_NAMESPACE::NodeSerialization* projectSerialization,
                                const SERIALIZATION_NAMESPACE::NodeSerialization* pyPlugSerialization);
@@ -798,6 +814,23 @@ public:
 
     int getIsNodeRenderingCounter() const;
 
+    /**
+     * @brief Records the time in seconds spent rendering the given number of pixels. A running average of the time
+     * per pixel is kept, so that TreeRender can estimate which branches of a tree are the longest to render.
+     **/
+    void addRenderTimeSample(double timeSeconds, double nPixels);
+
+    /**
+     * @brief Returns the running average of the time in seconds spent rendering one pixel, or 0 if the node never rendered.
+     **/
+    double getRenderTimePerPixelEstimate() const;
+
+    /**
+     * @brief Returns the account of the memory currently allocated by the node and its render clones for
+     * images which are not in the cache and for the plug-in, see MemoryAccount.
+     **/
+    MemoryAccountPtr getMemoryAccount() const;
+
     void refreshPreviewsRecursivelyDownstream();
 
     void refreshPreviewsRecursivelyUpstream();
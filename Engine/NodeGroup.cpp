@@ -24,6 +24,7 @@
 
 #include "NodeGroup.h"
 
+#include <map>
 #include <set>
 #include <locale>
 #include <cfloat>
@@ -34,8 +35,10 @@
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QTextStream>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 
 #include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
 #include "Engine/Bezier.h"
 #include "Engine/BezierCP.h"
 #include "Engine/Curve.h"
@@ -57,6 +60,7 @@
 #include "Engine/TimeLine.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/ViewerInstance.h"
+#include "Engine/ViewerNode.h"
 
 #include "Serialization/NodeSerialization.h"
 
@@ -339,6 +343,43 @@ NodeCollection::refreshViewersAndPreviews()
 
 }
 
+void
+NodeCollection::prefetchViewersCachedImages(TimeValue first, TimeValue last)
+{
+    AppInstancePtr appInst = getApplication();
+    if (!appInst || appInst->isBackground()) {
+        return;
+    }
+
+    NodesList nodes = getNodes();
+    for (NodesList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        ViewerNodePtr isViewer = (*it)->isEffectViewerNode();
+        if (isViewer) {
+            // Prefetch both the viewer process outputs and the nodes they display
+            std::list<EffectInstancePtr> effects;
+            for (int i = 0; i < 2; ++i) {
+                ViewerInstancePtr viewerProcess = isViewer->getViewerProcessNode(i);
+                if (viewerProcess) {
+                    effects.push_back(viewerProcess);
+                }
+            }
+            NodePtr inputs[2] = {isViewer->getCurrentAInput(), isViewer->getCurrentBInput()};
+            for (int i = 0; i < 2; ++i) {
+                if (inputs[i]) {
+                    effects.push_back(inputs[i]->getEffectInstance());
+                }
+            }
+            for (std::list<EffectInstancePtr>::const_iterator it2 = effects.begin(); it2 != effects.end(); ++it2) {
+                (*it2)->prefetchCachedImages(first, last, ViewIdx(0));
+            }
+        }
+        NodeGroupPtr isGrp = (*it)->isEffectNodeGroup();
+        if (isGrp) {
+            isGrp->prefetchViewersCachedImages(first, last);
+        }
+    }
+} // prefetchViewersCachedImages
+
 void
 NodeCollection::refreshPreviews()
 {
@@ -1054,6 +1095,128 @@ NodeCollection::refreshTimeInvariantMetadataOnAllNodes_recursive()
     }
 }
 
+static int
+getTopologicalLevel(const NodePtr& node,
+                    std::map<NodePtr, int>* levels)
+{
+    std::map<NodePtr, int>::const_iterator found = levels->find(node);
+    if ( found != levels->end() ) {
+        return found->second;
+    }
+
+    // Mark the node before recursing in case there is a cycle
+    (*levels)[node] = 0;
+
+    int level = 0;
+    int nInputs = node->getMaxInputCount();
+    for (int i = 0; i < nInputs; ++i) {
+        NodePtr input = node->getInput(i);
+        if (input) {
+            level = std::max( level, getTopologicalLevel(input, levels) + 1 );
+        }
+    }
+
+    // A group is processed after the nodes it contains
+    NodeGroupPtr isGroup = node->isEffectNodeGroup();
+    if (isGroup) {
+        NodesList nodes = isGroup->getNodes();
+        for (NodesList::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+            level = std::max( level, getTopologicalLevel(*it, levels) + 1 );
+        }
+    }
+
+    (*levels)[node] = level;
+
+    return level;
+} // getTopologicalLevel
+
+void
+NodeCollection::getNodesByTopologicalLevel_recursive(std::vector<NodesList>* levels) const
+{
+    NodesList nodes;
+    getNodes_recursive(nodes, true);
+
+    std::map<NodePtr, int> nodeLevels;
+    for (NodesList::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        int level = getTopologicalLevel(*it, &nodeLevels);
+        if ( level >= (int)levels->size() ) {
+            levels->resize(level + 1);
+        }
+        (*levels)[level].push_back(*it);
+    }
+
+    // Inactive inputs are not part of the levels: remove the empty levels
+    std::vector<NodesList>::iterator it = levels->begin();
+    while ( it != levels->end() ) {
+        if ( it->empty() ) {
+            it = levels->erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void
+NodeCollection::forEachNodeByTopologicalLevel_parallel(void (*func)(const NodePtr& node)) const
+{
+    std::vector<NodesList> levels;
+    getNodesByTopologicalLevel_recursive(&levels);
+
+    // Python code may run in func on the thread pool
+    PythonGILUnlocker pgl;
+
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        if (levels[i].size() == 1) {
+            func( levels[i].front() );
+        } else {
+            std::vector<NodePtr> levelNodes( levels[i].begin(), levels[i].end() );
+            QtConcurrent::blockingMap(levelNodes, func);
+        }
+    }
+}
+
+static void
+computeHashAndMetadata(const NodePtr& node)
+{
+    EffectInstancePtr effect = node->getEffectInstance();
+    if (!effect) {
+        return;
+    }
+
+    // The results are cached on the effect
+    {
+        HashableObject::ComputeHashArgs args;
+        args.time = TimeValue(0);
+        args.view = ViewIdx(0);
+        args.hashType = HashableObject::eComputeHashTypeTimeViewInvariant;
+        (void)effect->computeHash(args);
+    }
+    if ( !node->isEffectNodeGroup() ) {
+        GetTimeInvariantMetadataResultsPtr results;
+        (void)effect->getTimeInvariantMetadata_public(&results);
+    }
+}
+
+void
+NodeCollection::refreshHashAndMetadataOnAllNodes_parallel()
+{
+    assert( QThread::currentThread() == qApp->thread() );
+
+    forEachNodeByTopologicalLevel_parallel(computeHashAndMetadata);
+
+    // The onMetadataChanged action modifies knobs: call it on the main thread, inputs first.
+    // The meta-datas are already computed so this does not call the plug-in again.
+    std::vector<NodesList> levels;
+    getNodesByTopologicalLevel_recursive(&levels);
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        for (NodesList::const_iterator it = levels[i].begin(); it != levels[i].end(); ++it) {
+            if ( !(*it)->isEffectNodeGroup() && (*it)->getEffectInstance() ) {
+                (*it)->getEffectInstance()->onMetadataChanged_nonRecursive_public();
+            }
+        }
+    }
+} // refreshHashAndMetadataOnAllNodes_parallel
+
 struct NodeGroupPrivate
 {
     mutable QMutex nodesLock; // protects inputs & outputs
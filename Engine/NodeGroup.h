@@ -29,6 +29,7 @@
 
 #include <list>
 #include <set>
+#include <vector>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/scoped_ptr.hpp>
@@ -196,6 +197,12 @@ public:
      **/
     void refreshViewersAndPreviews();
     void refreshPreviews();
+
+    /**
+     * @brief Recursively for each viewer of each sub-group, prefetch the images already in the persistent cache
+     * that the viewer displays in the given frame range, see EffectInstance::prefetchCachedImages
+     **/
+    void prefetchViewersCachedImages(TimeValue first, TimeValue last);
     void forceRefreshPreviews();
 
     void quitAnyProcessingForAllNodes_non_blocking();
@@ -248,6 +255,27 @@ public:
      **/
     void refreshTimeInvariantMetadataOnAllNodes_recursive();
 
+    /**
+     * @brief Returns the active nodes of this collection and of its sub-groups sorted by topological level:
+     * the inputs of the nodes of a level are all in the previous levels.
+     **/
+    void getNodesByTopologicalLevel_recursive(std::vector<NodesList>* levels) const;
+
+    /**
+     * @brief Calls func on all nodes returned by getNodesByTopologicalLevel_recursive(), level by level.
+     * The nodes of a level are on independent branches: they are processed concurrently on the global thread pool,
+     * once all the nodes of the previous levels are processed. func must be MT-safe.
+     * This blocks until all nodes are processed.
+     **/
+    void forEachNodeByTopologicalLevel_parallel(void (*func)(const NodePtr& node)) const;
+
+    /**
+     * @brief Computes the hash and the meta-datas of all nodes concurrently with forEachNodeByTopologicalLevel_parallel(),
+     * then calls the onMetadataChanged action of each node on the main thread in topological order.
+     * This is done once after loading a project instead of refreshing the meta-datas downstream each time an input is connected.
+     **/
+    void refreshHashAndMetadataOnAllNodes_parallel();
+
 public:
 
 
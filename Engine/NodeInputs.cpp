@@ -101,6 +101,10 @@ applyNodeRedirectionsUpstream(const NodePtr& node)
     }
     NodeGroupPtr isGrp = node->isEffectNodeGroup();
     if (isGrp) {
+        if ( isGrp->isCacheBoundaryEnabled() ) {
+            // The output node of a cache boundary renders and caches the output of the group
+            return isGrp->getOutputNode();
+        }
         //The node is a group, instead jump directly to the output node input of the  group
         return applyNodeRedirectionsUpstream(isGrp->getOutputNodeInput());
     }
@@ -151,6 +155,12 @@ applyNodeRedirectionsDownstream(int recurseCounter,
     }
 
     GroupOutputPtr isOutput = node->isEffectGroupOutput();
+    if ( isOutput && (recurseCounter > 0) && isOutput->isCacheBoundary() ) {
+        // The output node of a cache boundary is not skipped by the render
+        translated.push_back(node);
+
+        return;
+    }
     if (isOutput) {
         //The node is the output of a group, its outputs are the outputs of the group
         NodeCollectionPtr collection = isOutput->getNode()->getGroup();
@@ -1239,9 +1249,11 @@ Node::endInputEdition(bool triggerRender)
 
         if (hasChanged) {
 
-            // Force a refresh of the meta-datas
-
-            _imp->effect->onMetadataChanged_recursive_public();
+            // Force a refresh of the meta-datas.
+            // While loading a project, they are refreshed on all nodes once all nodes are connected, see Project::fromSerialization
+            if ( !getApp()->getProject()->isLoadingProjectInternal() ) {
+                _imp->effect->onMetadataChanged_recursive_public();
+            }
 
             _imp->effect->refreshDynamicProperties();
         }
@@ -1269,6 +1281,8 @@ Node::onInputChanged(int inputNb)
 
 
 
+    invalidateAutoSaveSerialization();
+
     ///Don't do clip preferences while loading a project, they will be refreshed globally once the project is loaded.
     _imp->effect->onInputChanged_public(inputNb);
     _imp->inputsModified.insert(inputNb);
@@ -529,7 +529,46 @@ Node::toSerialization(SERIALIZATION_NAMESPACE::SerializationObjectBase* serializ
     if (!serialization) {
         return;
     }
+    toSerializationInternal(serialization, false);
+} // toSerialization
 
+SERIALIZATION_NAMESPACE::NodeSerializationPtr
+Node::getAutoSaveSerialization()
+{
+    // The children of a group may change without the group itself being modified, so a group
+    // is never cached: its serialization is rebuilt from the cached serialization of its children.
+    const bool isGroup = (bool)isEffectNodeGroup();
+    U64 age;
+    {
+        QMutexLocker k(&_imp->autoSaveSerializationMutex);
+        if (!isGroup && _imp->autoSaveSerialization && _imp->autoSaveSerializationAge == _imp->modificationAge) {
+            return _imp->autoSaveSerialization;
+        }
+        age = _imp->modificationAge;
+    }
+
+    SERIALIZATION_NAMESPACE::NodeSerializationPtr state(new SERIALIZATION_NAMESPACE::NodeSerialization);
+    toSerializationInternal(state.get(), true);
+
+    if (!isGroup) {
+        // If the node was modified while serializing, age is already outdated and the next auto-save serializes it again
+        QMutexLocker k(&_imp->autoSaveSerializationMutex);
+        _imp->autoSaveSerialization = state;
+        _imp->autoSaveSerializationAge = age;
+    }
+    return state;
+} // getAutoSaveSerialization
+
+void
+Node::invalidateAutoSaveSerialization()
+{
+    QMutexLocker k(&_imp->autoSaveSerializationMutex);
+    ++_imp->modificationAge;
+}
+
+void
+Node::toSerializationInternal(SERIALIZATION_NAMESPACE::NodeSerialization* serialization, bool useAutoSaveSerialization)
+{
     // All this code is MT-safe as it runs in the serialization thread
 
     OfxEffectInstancePtr isOfxEffect = boost::dynamic_pointer_cast<OfxEffectInstance>(getEffectInstance());
@@ -697,6 +736,8 @@ Node::toSerialization(SERIALIZATION_NAMESPACE::SerializationObjectBase* serializ
                     if (!state) {
                         continue;
                     }
+                } else if (useAutoSaveSerialization) {
+                    state = (*it)->getAutoSaveSerialization();
                 } else {
                     state.reset( new SERIALIZATION_NAMESPACE::NodeSerialization );
                     (*it)->toSerialization(state.get());
@@ -751,7 +792,7 @@ Node::toSerialization(SERIALIZATION_NAMESPACE::SerializationObjectBase* serializ
         }
     }
 
-} // Node::toSerialization
+} // Node::toSerializationInternal
 
 void
 Node::fromSerialization(const SERIALIZATION_NAMESPACE::SerializationObjectBase& serializationBase)
@@ -877,7 +918,9 @@ Node::loadKnobsFromSerialization(const SERIALIZATION_NAMESPACE::NodeSerializatio
 
 
     {
-        // Load all knobs
+        // Load all knobs. Their animation curves are restored concurrently at the end of the scope.
+        KnobDeferredCurvesRestore_RAII deferCurves;
+
         checkForOldStringParametersForChoices(getApp(), getKnobs(), serialization._knobsValues);
 
         for (SERIALIZATION_NAMESPACE::KnobSerializationList::const_iterator it = serialization._knobsValues.begin(); it!=serialization._knobsValues.end(); ++it) {
@@ -902,7 +945,10 @@ Node::loadKnobsFromSerialization(const SERIALIZATION_NAMESPACE::NodeSerializatio
     KnobItemsTablePtr table = _imp->effect->getItemsTable();
     if (serialization._tableModel && table) {
         table->resetModel(eTableChangeReasonInternal);
-        table->fromSerialization(*serialization._tableModel);
+        {
+            KnobDeferredCurvesRestore_RAII deferCurves;
+            table->fromSerialization(*serialization._tableModel);
+        }
         table->declareItemsToPython();
     }
 
@@ -24,7 +24,10 @@
 
 #include "NodeMetadata.h"
 #include "Engine/RectI.h"
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 #include <sstream>
 
@@ -35,6 +38,7 @@ GCC_DIAG_OFF(unused-parameter)
 GCC_DIAG_ON(unused-parameter)
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
+#include "Engine/Hash64.h"
 #include "Engine/ImagePlaneDesc.h"
 #include "Engine/PropertiesHolder.h"
 
@@ -43,27 +47,214 @@ namespace bip = boost::interprocess;
 
 NATRON_NAMESPACE_ENTER;
 
+enum NodeMetadataDataTypeEnum
+{
+    eNodeMetadataDataTypeInt = 0,
+    eNodeMetadataDataTypeDouble,
+    eNodeMetadataDataTypeString
+};
+
+// The built-in meta-datas, which are read for each node at each render: they are stored in a flat array
+// indexed by these keys instead of being looked up by name.
+enum NodeMetadataKeyEnum
+{
+    eNodeMetadataKeyOutputPremult = 0,
+    eNodeMetadataKeyOutputFrameRate,
+    eNodeMetadataKeyOutputFielding,
+    eNodeMetadataKeyIsContinuous,
+    eNodeMetadataKeyIsFrameVarying,
+    eNodeMetadataKeyOutputFormat,
+    eNodeMetadataKeyPixelAspectRatio,
+    eNodeMetadataKeyBitDepth,
+    eNodeMetadataKeyColorPlaneNComps,
+    eNodeMetadataKeyComponentsType,
+    eNodeMetadataKeyCount
+};
+
+struct NodeMetadataKeyDescriptor
+{
+    const char* name;
+    NodeMetadataDataTypeEnum type;
+    int dimension;
+
+    // If true, the index of the input (or -1 for the output) is appended to the name
+    bool perInput;
+};
+
+// Maximum dimension of a built-in meta-data
+#define NATRON_NODE_METADATA_MAX_DIMENSION 4
+
+static const NodeMetadataKeyDescriptor metadataKeys[eNodeMetadataKeyCount] = {
+    {kNatronMetadataOutputPremult, eNodeMetadataDataTypeInt, 1, false},
+    {kNatronMetadataOutputFrameRate, eNodeMetadataDataTypeDouble, 1, false},
+    {kNatronMetadataOutputFielding, eNodeMetadataDataTypeInt, 1, false},
+    {kNatronMetadataIsContinuous, eNodeMetadataDataTypeInt, 1, false},
+    {kNatronMetadataIsFrameVarying, eNodeMetadataDataTypeInt, 1, false},
+    {kNatronMetadataOutputFormat, eNodeMetadataDataTypeInt, 4, false},
+    {kNatronMetadataPixelAspectRatio, eNodeMetadataDataTypeDouble, 1, true},
+    {kNatronMetadataBitDepth, eNodeMetadataDataTypeInt, 1, true},
+    {kNatronMetadataColorPlaneNComps, eNodeMetadataDataTypeInt, 1, true},
+    {kNatronMetadataComponentsType, eNodeMetadataDataTypeString, 1, true},
+};
+
+/**
+ * @brief Finds the built-in meta-data with the given name. For a per-input meta-data, inputNb is set to the index
+ * of the input parsed from the name. Returns false if this is not a built-in meta-data.
+ **/
+static bool
+findMetadataKey(const std::string& name,
+                NodeMetadataKeyEnum* key,
+                int* inputNb)
+{
+    for (int i = 0; i < eNodeMetadataKeyCount; ++i) {
+        const NodeMetadataKeyDescriptor& desc = metadataKeys[i];
+        if (!desc.perInput) {
+            if (name == desc.name) {
+                *key = (NodeMetadataKeyEnum)i;
+                *inputNb = -1;
+
+                return true;
+            }
+            continue;
+        }
+        std::size_t prefixLen = std::strlen(desc.name);
+        if ( (name.size() <= prefixLen) || (name.compare(0, prefixLen, desc.name) != 0) ) {
+            continue;
+        }
+        const char* suffix = name.c_str() + prefixLen;
+        char* end = 0;
+        long index = std::strtol(suffix, &end, 10);
+        if ( (end == suffix) || (*end != '\0') || (index < -1) ) {
+            return false;
+        }
+        *key = (NodeMetadataKeyEnum)i;
+        *inputNb = (int)index;
+
+        return true;
+    }
+
+    return false;
+} // findMetadataKey
+
+// The value of a built-in meta-data. Int values are stored exactly as double.
+struct NodeMetadataValue
+{
+    bool isSet;
+    double podValues[NATRON_NODE_METADATA_MAX_DIMENSION];
+    std::string stringValue;
+
+    NodeMetadataValue()
+    : isSet(false)
+    , podValues()
+    , stringValue()
+    {
+    }
+};
 
 class NodeMetadata::Implementation : public PropertiesHolder
 {
 public:
 
+    // The built-in meta-datas, indexed by NodeMetadataKeyEnum, then by the input number + 1
+    std::vector<NodeMetadataValue> values[eNodeMetadataKeyCount];
 
     Implementation()
     : PropertiesHolder()
+    , values()
     {
     }
 
     Implementation(const Implementation& other)
     : PropertiesHolder(other)
+    , values()
     {
-
+        for (int i = 0; i < eNodeMetadataKeyCount; ++i) {
+            values[i] = other.values[i];
+        }
     }
 
     virtual void initializeProperties() const OVERRIDE FINAL;
 
+    /**
+     * @brief Returns the value of the given built-in meta-data, or NULL if it was never set
+     **/
+    const NodeMetadataValue* getValue(NodeMetadataKeyEnum key, int inputNb) const
+    {
+        std::size_t i = (std::size_t)(inputNb + 1);
+        if ( (inputNb < -1) || ( i >= values[key].size() ) || !values[key][i].isSet ) {
+            return 0;
+        }
+
+        return &values[key][i];
+    }
+
+    /**
+     * @brief Returns the value of the given built-in meta-data to modify it. If createIfNotExists is false
+     * and the meta-data was never set, returns NULL.
+     **/
+    NodeMetadataValue* getValueForWriting(NodeMetadataKeyEnum key, int inputNb, bool createIfNotExists)
+    {
+        if (inputNb < -1) {
+            return 0;
+        }
+        std::size_t i = (std::size_t)(inputNb + 1);
+        if ( i >= values[key].size() ) {
+            if (!createIfNotExists) {
+                return 0;
+            }
+            values[key].resize(i + 1);
+        }
+        NodeMetadataValue& value = values[key][i];
+        if (!value.isSet) {
+            if (!createIfNotExists) {
+                return 0;
+            }
+            value.isSet = true;
+        }
+
+        return &value;
+    }
+
+    static std::string getValueName(NodeMetadataKeyEnum key, int inputNb)
+    {
+        if (!metadataKeys[key].perInput) {
+            return metadataKeys[key].name;
+        }
+        std::stringstream ss;
+        ss << metadataKeys[key].name << inputNb;
+
+        return ss.str();
+    }
+
+    void setPodValue(NodeMetadataKeyEnum key, int inputNb, double value)
+    {
+        NodeMetadataValue* v = getValueForWriting(key, inputNb, true);
+        if (v) {
+            v->podValues[0] = value;
+        }
+    }
+
+    bool getPodValue(NodeMetadataKeyEnum key, int inputNb, double* value) const
+    {
+        const NodeMetadataValue* v = getValue(key, inputNb);
+        if (!v) {
+            return false;
+        }
+        *value = v->podValues[0];
+
+        return true;
+    }
+
+    template <typename T>
+    bool setBuiltInValues(const std::string& name, NodeMetadataDataTypeEnum type, const T values[], int index, int count, bool createIfNotExists);
+
+    template <typename T>
+    int getBuiltInValues(NodeMetadataKeyEnum key, int inputNb, NodeMetadataDataTypeEnum type, int index, int count, T* values) const;
+
     void toMemorySegment(IPCPropertyMap* properties) const;
 
+    U64 computeHash() const;
+
     void fromMemorySegment(const IPCPropertyMap& properties);
 
     virtual ~Implementation()
@@ -88,9 +279,111 @@ NodeMetadata::Implementation::initializeProperties() const
 
 }
 
+static void
+toMetadataValue(double value, double* pod, std::string* /*str*/)
+{
+    *pod = value;
+}
+
+static void
+toMetadataValue(int value, double* pod, std::string* /*str*/)
+{
+    *pod = (double)value;
+}
+
+static void
+toMetadataValue(const std::string& value, double* /*pod*/, std::string* str)
+{
+    *str = value;
+}
+
+static void
+fromMetadataValue(double pod, const std::string& /*str*/, double* value)
+{
+    *value = pod;
+}
+
+static void
+fromMetadataValue(double pod, const std::string& /*str*/, int* value)
+{
+    *value = (int)pod;
+}
+
+static void
+fromMetadataValue(double /*pod*/, const std::string& str, std::string* value)
+{
+    *value = str;
+}
+
+/**
+ * @brief If name is a built-in meta-data, sets count values starting at index and returns true. The values are
+ * not set if the type does not match the type of the built-in meta-data.
+ * Returns false if this is not a built-in meta-data, in which case it is stored by name in the properties.
+ **/
+template <typename T>
+bool
+NodeMetadata::Implementation::setBuiltInValues(const std::string& name,
+                                               NodeMetadataDataTypeEnum type,
+                                               const T values[],
+                                               int index,
+                                               int count,
+                                               bool createIfNotExists)
+{
+    NodeMetadataKeyEnum key;
+    int inputNb;
+    if ( !findMetadataKey(name, &key, &inputNb) ) {
+        return false;
+    }
+    const NodeMetadataKeyDescriptor& desc = metadataKeys[key];
+    if ( (desc.type != type) || (index < 0) || (index + count > desc.dimension) ) {
+        return true;
+    }
+    NodeMetadataValue* v = getValueForWriting(key, inputNb, createIfNotExists);
+    if (!v) {
+        return true;
+    }
+    for (int i = 0; i < count; ++i) {
+        toMetadataValue(values[i], &v->podValues[index + i], &v->stringValue);
+    }
+
+    return true;
+} // setBuiltInValues
+
+/**
+ * @brief Reads count values starting at index of the given built-in meta-data, and returns the number of values read,
+ * or -1 if the meta-data is not set or does not have the given type.
+ **/
+template <typename T>
+int
+NodeMetadata::Implementation::getBuiltInValues(NodeMetadataKeyEnum key,
+                                               int inputNb,
+                                               NodeMetadataDataTypeEnum type,
+                                               int index,
+                                               int count,
+                                               T* values) const
+{
+    const NodeMetadataKeyDescriptor& desc = metadataKeys[key];
+    if ( (desc.type != type) || (index < 0) ) {
+        return -1;
+    }
+    const NodeMetadataValue* v = getValue(key, inputNb);
+    if (!v) {
+        return -1;
+    }
+    int nVal = std::max(0, std::min(count, desc.dimension - index));
+    for (int i = 0; i < nVal; ++i) {
+        fromMetadataValue(v->podValues[index + i], v->stringValue, &values[i]);
+    }
+
+    return nVal;
+} // getBuiltInValues
+
 void
 NodeMetadata::setIntMetadata(const std::string& name, int value, int index, bool createIfNotExists)
 {
+    if ( _imp->setBuiltInValues(name, eNodeMetadataDataTypeInt, &value, index, 1, createIfNotExists) ) {
+        return;
+    }
     try {
         _imp->setProperty(name, value, index, !createIfNotExists);
     } catch (...) {
@@ -101,6 +394,9 @@ NodeMetadata::setIntMetadata(const std::string& name, int value, int index, bool
 void
 NodeMetadata::setDoubleMetadata(const std::string& name, double value, int index, bool createIfNotExists)
 {
+    if ( _imp->setBuiltInValues(name, eNodeMetadataDataTypeDouble, &value, index, 1, createIfNotExists) ) {
+        return;
+    }
     try {
         _imp->setProperty(name, value, index, !createIfNotExists);
     } catch (...) {
@@ -111,6 +407,9 @@ NodeMetadata::setDoubleMetadata(const std::string& name, double value, int index
 void
 NodeMetadata::setStringMetadata(const std::string& name, const std::string& value, int index, bool createIfNotExists)
 {
+    if ( _imp->setBuiltInValues(name, eNodeMetadataDataTypeString, &value, index, 1, createIfNotExists) ) {
+        return;
+    }
     try {
         _imp->setProperty(name, value, index, !createIfNotExists);
     } catch (...) {
@@ -121,6 +420,9 @@ NodeMetadata::setStringMetadata(const std::string& name, const std::string& valu
 void
 NodeMetadata::setIntNMetadata(const std::string& name, const int value[], int count, bool createIfNotExists)
 {
+    if ( _imp->setBuiltInValues(name, eNodeMetadataDataTypeInt, value, 0, count, createIfNotExists) ) {
+        return;
+    }
     try {
         std::vector<int> values(&value[0], (&value[count -1]) + 1);
         _imp->setPropertyN(name, values, !createIfNotExists);
@@ -132,6 +434,9 @@ NodeMetadata::setIntNMetadata(const std::string& name, const int value[], int co
 void
 NodeMetadata::setDoubleNMetadata(const std::string& name, const double value[], int count, bool createIfNotExists)
 {
+    if ( _imp->setBuiltInValues(name, eNodeMetadataDataTypeDouble, value, 0, count, createIfNotExists) ) {
+        return;
+    }
     try {
         std::vector<double> values(&value[0], (&value[count -1]) + 1);
         _imp->setPropertyN(name, values, !createIfNotExists);
@@ -143,6 +448,9 @@ NodeMetadata::setDoubleNMetadata(const std::string& name, const double value[],
 void
 NodeMetadata::setStringNMetadata(const std::string& name, const std::string value[], int count, bool createIfNotExists)
 {
+    if ( _imp->setBuiltInValues(name, eNodeMetadataDataTypeString, value, 0, count, createIfNotExists) ) {
+        return;
+    }
     try {
         std::vector<std::string> values(&value[0], (&value[count -1]) + 1);
         _imp->setPropertyN(name, values, !createIfNotExists);
@@ -154,18 +462,33 @@ NodeMetadata::setStringNMetadata(const std::string& name, const std::string valu
 bool
 NodeMetadata::getIntMetadata(const std::string& name, int index, int *value) const
 {
+    NodeMetadataKeyEnum key;
+    int inputNb;
+    if ( findMetadataKey(name, &key, &inputNb) ) {
+        return _imp->getBuiltInValues(key, inputNb, eNodeMetadataDataTypeInt, index, 1, value) == 1;
+    }
     return _imp->getPropertySafe<int>(name, index, value);
 }
 
 bool
 NodeMetadata::getDoubleMetadata(const std::string& name, int index, double *value) const
 {
+    NodeMetadataKeyEnum key;
+    int inputNb;
+    if ( findMetadataKey(name, &key, &inputNb) ) {
+        return _imp->getBuiltInValues(key, inputNb, eNodeMetadataDataTypeDouble, index, 1, value) == 1;
+    }
     return _imp->getPropertySafe<double>(name, index, value);
 }
 
 bool
 NodeMetadata::getStringMetadata(const std::string& name, int index, std::string *value) const
 {
+    NodeMetadataKeyEnum key;
+    int inputNb;
+    if ( findMetadataKey(name, &key, &inputNb) ) {
+        return _imp->getBuiltInValues(key, inputNb, eNodeMetadataDataTypeString, index, 1, value) == 1;
+    }
     return _imp->getPropertySafe<std::string>(name, index, value);
 
 }
@@ -173,6 +496,11 @@ NodeMetadata::getStringMetadata(const std::string& name, int index, std::string
 bool
 NodeMetadata::getIntNMetadata(const std::string& name, int count, int *value) const
 {
+    NodeMetadataKeyEnum key;
+    int inputNb;
+    if ( findMetadataKey(name, &key, &inputNb) ) {
+        return _imp->getBuiltInValues(key, inputNb, eNodeMetadataDataTypeInt, 0, count, value) >= 0;
+    }
     std::vector<int> values;
     if (!_imp->getPropertyNSafe<int>(name, &values)) {
         return false;
@@ -186,6 +514,11 @@ NodeMetadata::getIntNMetadata(const std::string& name, int count, int *value) co
 bool
 NodeMetadata::getDoubleNMetadata(const std::string& name, int count, double *value) const
 {
+    NodeMetadataKeyEnum key;
+    int inputNb;
+    if ( findMetadataKey(name, &key, &inputNb) ) {
+        return _imp->getBuiltInValues(key, inputNb, eNodeMetadataDataTypeDouble, 0, count, value) >= 0;
+    }
     std::vector<double> values;
     if (!_imp->getPropertyNSafe<double>(name, &values)) {
         return false;
@@ -199,6 +532,11 @@ NodeMetadata::getDoubleNMetadata(const std::string& name, int count, double *val
 bool
 NodeMetadata::getStringNMetadata(const std::string& name, int count, std::string *value) const
 {
+    NodeMetadataKeyEnum key;
+    int inputNb;
+    if ( findMetadataKey(name, &key, &inputNb) ) {
+        return _imp->getBuiltInValues(key, inputNb, eNodeMetadataDataTypeString, 0, count, value) >= 0;
+    }
     std::vector<std::string> values;
     if (!_imp->getPropertyNSafe<std::string>(name, &values)) {
         return false;
@@ -215,6 +553,12 @@ NodeMetadata::getStringNMetadata(const std::string& name, int count, std::string
 int
 NodeMetadata::getMetadataDimension(const std::string& name) const
 {
+    NodeMetadataKeyEnum key;
+    int inputNb;
+    if ( findMetadataKey(name, &key, &inputNb) ) {
+        return _imp->getValue(key, inputNb) ? metadataKeys[key].dimension : 0;
+    }
+
     return _imp->getPropertyDimension(name, false /*throwIfFailed*/);
 }
 
@@ -230,12 +574,62 @@ NodeMetadata::fromMemorySegment(const IPCPropertyMap& properties)
     _imp->fromMemorySegment(properties);
 }
 
-enum NodeMetadataDataTypeEnum
+U64
+NodeMetadata::computeHash() const
 {
-    eNodeMetadataDataTypeInt = 0,
-    eNodeMetadataDataTypeDouble,
-    eNodeMetadataDataTypeString
-};
+    return _imp->computeHash();
+}
+
+U64
+NodeMetadata::Implementation::computeHash() const
+{
+    Hash64 hash;
+
+    for (int i = 0; i < eNodeMetadataKeyCount; ++i) {
+        const NodeMetadataKeyDescriptor& desc = metadataKeys[i];
+        for (std::size_t j = 0; j < values[i].size(); ++j) {
+            const NodeMetadataValue& value = values[i][j];
+            if (!value.isSet) {
+                continue;
+            }
+            hash.append(i);
+            hash.append(j);
+            if (desc.type == eNodeMetadataDataTypeString) {
+                Hash64::appendString(value.stringValue, &hash);
+            } else {
+                hash.appendArray(value.podValues, desc.dimension);
+            }
+        }
+    }
+
+    // Meta-datas that are not built-in, in the order of their names
+    for (std::map<std::string, boost::shared_ptr<PropertiesHolder::PropertyBase> >::const_iterator it = _properties.begin(); it != _properties.end(); ++it) {
+        Hash64::appendString(it->first, &hash);
+
+        PropertiesHolder::Property<int>* isInt = dynamic_cast<PropertiesHolder::Property<int>*>(it->second.get());
+        PropertiesHolder::Property<double>* isDouble = dynamic_cast<PropertiesHolder::Property<double>*>(it->second.get());
+        PropertiesHolder::Property<std::string>* isString = dynamic_cast<PropertiesHolder::Property<std::string>*>(it->second.get());
+        if (isInt) {
+            hash.append(eNodeMetadataDataTypeInt);
+            for (std::size_t i = 0; i < isInt->value.size(); ++i) {
+                hash.append(isInt->value[i]);
+            }
+        } else if (isDouble) {
+            hash.append(eNodeMetadataDataTypeDouble);
+            if ( !isDouble->value.empty() ) {
+                hash.appendArray(&isDouble->value[0], isDouble->value.size());
+            }
+        } else if (isString) {
+            hash.append(eNodeMetadataDataTypeString);
+            for (std::size_t i = 0; i < isString->value.size(); ++i) {
+                Hash64::appendString(isString->value[i], &hash);
+            }
+        }
+    }
+    hash.computeHash();
+
+    return hash.value();
+} // computeHash
 
 struct MetadataValueIPC
 {
@@ -285,6 +679,37 @@ struct MetadataValuesIPC
 void
 NodeMetadata::Implementation::toMemorySegment(IPCPropertyMap* properties) const
 {
+    // Built-in meta-datas are written by name, as other properties
+    for (int i = 0; i < eNodeMetadataKeyCount; ++i) {
+        const NodeMetadataKeyDescriptor& desc = metadataKeys[i];
+        for (std::size_t j = 0; j < values[i].size(); ++j) {
+            const NodeMetadataValue& value = values[i][j];
+            if (!value.isSet) {
+                continue;
+            }
+            std::string name = getValueName( (NodeMetadataKeyEnum)i, (int)j - 1 );
+            switch (desc.type) {
+            case eNodeMetadataDataTypeInt: {
+                std::vector<int> intValues(desc.dimension);
+                for (int d = 0; d < desc.dimension; ++d) {
+                    intValues[d] = (int)value.podValues[d];
+                }
+                properties->setIPCPropertyN<int>(name, intValues);
+                break;
+            }
+            case eNodeMetadataDataTypeDouble: {
+                std::vector<double> doubleValues(value.podValues, value.podValues + desc.dimension);
+                properties->setIPCPropertyN<double>(name, doubleValues);
+                break;
+            }
+            case eNodeMetadataDataTypeString: {
+                std::vector<std::string> stringValues(1, value.stringValue);
+                properties->setIPCPropertyN<std::string>(name, stringValues);
+                break;
+            }
+            }
+        }
+    }
 
     for (std::map<std::string, boost::shared_ptr<PropertiesHolder::PropertyBase> >::const_iterator it = _properties.begin(); it != _properties.end(); ++it) {
 
@@ -313,6 +738,40 @@ NodeMetadata::Implementation::fromMemorySegment(const IPCPropertyMap& properties
 
         std::string name(it->first.c_str());
 
+        NodeMetadataKeyEnum key;
+        int inputNb;
+        if ( findMetadataKey(name, &key, &inputNb) ) {
+            switch ( it->second.getType() ) {
+            case eIPCVariantTypeInt: {
+                std::vector<int> intValues;
+                IPCPropertyMap::getIPCPropertyN(it->second, &intValues);
+                if ( !intValues.empty() ) {
+                    setBuiltInValues(name, eNodeMetadataDataTypeInt, &intValues[0], 0, std::min( (int)intValues.size(), metadataKeys[key].dimension ), true);
+                }
+                break;
+            }
+            case eIPCVariantTypeDouble: {
+                std::vector<double> doubleValues;
+                IPCPropertyMap::getIPCPropertyN(it->second, &doubleValues);
+                if ( !doubleValues.empty() ) {
+                    setBuiltInValues(name, eNodeMetadataDataTypeDouble, &doubleValues[0], 0, std::min( (int)doubleValues.size(), metadataKeys[key].dimension ), true);
+                }
+                break;
+            }
+            case eIPCVariantTypeString: {
+                std::vector<std::string> stringValues;
+                IPCPropertyMap::getIPCPropertyN(it->second, &stringValues);
+                if ( !stringValues.empty() ) {
+                    setBuiltInValues(name, eNodeMetadataDataTypeString, &stringValues[0], 0, 1, true);
+                }
+                break;
+            }
+            default:
+                break;
+            }
+            continue;
+        }
+
         switch (it->second.getType()) {
             case eIPCVariantTypeInt:
             {
@@ -342,15 +801,15 @@ NodeMetadata::Implementation::fromMemorySegment(const IPCPropertyMap& properties
 void
 NodeMetadata::setOutputPremult(ImagePremultiplicationEnum premult)
 {
-    setIntMetadata(kNatronMetadataOutputPremult, (int)premult, 0, true);
+    _imp->setPodValue(eNodeMetadataKeyOutputPremult, -1, (int)premult);
 }
 
 ImagePremultiplicationEnum
 NodeMetadata::getOutputPremult() const
 {
-    int ret;
-    if (getIntMetadata(kNatronMetadataOutputPremult, 0, &ret)) {
-        return (ImagePremultiplicationEnum)ret;
+    double ret;
+    if ( _imp->getPodValue(eNodeMetadataKeyOutputPremult, -1, &ret) ) {
+        return (ImagePremultiplicationEnum)(int)ret;
     }
     return eImagePremultiplicationPremultiplied;
 }
@@ -358,14 +817,14 @@ NodeMetadata::getOutputPremult() const
 void
 NodeMetadata::setOutputFrameRate(double fps)
 {
-    setDoubleMetadata(kNatronMetadataOutputFrameRate, fps, 0, true);
+    _imp->setPodValue(eNodeMetadataKeyOutputFrameRate, -1, fps);
 }
 
 double
 NodeMetadata::getOutputFrameRate() const
 {
     double ret;
-    if (getDoubleMetadata(kNatronMetadataOutputFrameRate, 0, &ret)) {
+    if ( _imp->getPodValue(eNodeMetadataKeyOutputFrameRate, -1, &ret) ) {
         return ret;
     }
     return 24.;
@@ -374,15 +833,15 @@ NodeMetadata::getOutputFrameRate() const
 void
 NodeMetadata::setOutputFielding(ImageFieldingOrderEnum fielding)
 {
-    setIntMetadata(kNatronMetadataOutputFielding, (int)fielding, 0, true);
+    _imp->setPodValue(eNodeMetadataKeyOutputFielding, -1, (int)fielding);
 }
 
 ImageFieldingOrderEnum
 NodeMetadata::getOutputFielding() const
 {
-    int ret;
-    if (getIntMetadata(kNatronMetadataOutputFielding, 0, &ret)) {
-        return (ImageFieldingOrderEnum)ret;
+    double ret;
+    if ( _imp->getPodValue(eNodeMetadataKeyOutputFielding, -1, &ret) ) {
+        return (ImageFieldingOrderEnum)(int)ret;
     }
     return eImageFieldingOrderNone;
 }
@@ -390,15 +849,15 @@ NodeMetadata::getOutputFielding() const
 void
 NodeMetadata::setIsContinuous(bool continuous)
 {
-    setIntMetadata(kNatronMetadataIsContinuous, (int)continuous, 0, true);
+    _imp->setPodValue(eNodeMetadataKeyIsContinuous, -1, (int)continuous);
 }
 
 bool
 NodeMetadata::getIsContinuous() const
 {
-    int ret;
-    if (getIntMetadata(kNatronMetadataIsContinuous, 0, &ret)) {
-        return (bool)ret;
+    double ret;
+    if ( _imp->getPodValue(eNodeMetadataKeyIsContinuous, -1, &ret) ) {
+        return ret != 0.;
     }
     return false;
 }
@@ -406,15 +865,15 @@ NodeMetadata::getIsContinuous() const
 void
 NodeMetadata::setIsFrameVarying(bool varying)
 {
-    setIntMetadata(kNatronMetadataIsFrameVarying, (int)varying, 0, true);
+    _imp->setPodValue(eNodeMetadataKeyIsFrameVarying, -1, (int)varying);
 }
 
 bool
 NodeMetadata::getIsFrameVarying() const
 {
-    int ret;
-    if (getIntMetadata(kNatronMetadataIsFrameVarying, 0, &ret)) {
-        return (bool)ret;
+    double ret;
+    if ( _imp->getPodValue(eNodeMetadataKeyIsFrameVarying, -1, &ret) ) {
+        return ret != 0.;
     }
     return false;
 }
@@ -422,18 +881,14 @@ NodeMetadata::getIsFrameVarying() const
 void
 NodeMetadata::setPixelAspectRatio(int inputNb, double par)
 {
-    std::stringstream ss;
-    ss << kNatronMetadataPixelAspectRatio << inputNb;
-    setDoubleMetadata(ss.str(), par, 0, true);
+    _imp->setPodValue(eNodeMetadataKeyPixelAspectRatio, inputNb, par);
 }
 
 double
 NodeMetadata::getPixelAspectRatio(int inputNb) const
 {
-    std::stringstream ss;
-    ss << kNatronMetadataPixelAspectRatio << inputNb;
     double ret;
-    if (getDoubleMetadata(ss.str(), 0, &ret)) {
+    if ( _imp->getPodValue(eNodeMetadataKeyPixelAspectRatio, inputNb, &ret) ) {
         return ret;
     }
     return 1.;
@@ -442,19 +897,15 @@ NodeMetadata::getPixelAspectRatio(int inputNb) const
 void
 NodeMetadata::setBitDepth(int inputNb, ImageBitDepthEnum depth)
 {
-    std::stringstream ss;
-    ss << kNatronMetadataBitDepth << inputNb;
-    setIntMetadata(ss.str(), (int)depth, 0, true);
+    _imp->setPodValue(eNodeMetadataKeyBitDepth, inputNb, (int)depth);
 }
 
 ImageBitDepthEnum
 NodeMetadata::getBitDepth(int inputNb) const
 {
-    std::stringstream ss;
-    ss << kNatronMetadataBitDepth << inputNb;
-    int ret;
-    if (getIntMetadata(ss.str(), 0, &ret)) {
-        return (ImageBitDepthEnum)ret;
+    double ret;
+    if ( _imp->getPodValue(eNodeMetadataKeyBitDepth, inputNb, &ret) ) {
+        return (ImageBitDepthEnum)(int)ret;
     }
     return eImageBitDepthFloat;
 }
@@ -463,19 +914,15 @@ NodeMetadata::getBitDepth(int inputNb) const
 void
 NodeMetadata::setColorPlaneNComps(int inputNb, int nComps)
 {
-    std::stringstream ss;
-    ss << kNatronMetadataColorPlaneNComps << inputNb;
-    setIntMetadata(ss.str(), (int)nComps, 0, true);
+    _imp->setPodValue(eNodeMetadataKeyColorPlaneNComps, inputNb, nComps);
 }
 
 int
 NodeMetadata::getColorPlaneNComps(int inputNb) const
 {
-    std::stringstream ss;
-    ss << kNatronMetadataColorPlaneNComps << inputNb;
-    int ret;
-    if (getIntMetadata(ss.str(), 0, &ret)) {
-        return ret;
+    double ret;
+    if ( _imp->getPodValue(eNodeMetadataKeyColorPlaneNComps, inputNb, &ret) ) {
+        return (int)ret;
     }
     return 4;
 }
@@ -483,19 +930,18 @@ NodeMetadata::getColorPlaneNComps(int inputNb) const
 void
 NodeMetadata::setComponentsType(int inputNb, const std::string& componentsType)
 {
-    std::stringstream ss;
-    ss << kNatronMetadataComponentsType << inputNb;
-    setStringMetadata(ss.str(), componentsType, 0, true);
+    NodeMetadataValue* v = _imp->getValueForWriting(eNodeMetadataKeyComponentsType, inputNb, true);
+    if (v) {
+        v->stringValue = componentsType;
+    }
 }
 
 std::string
 NodeMetadata::getComponentsType(int inputNb) const
 {
-    std::stringstream ss;
-    ss << kNatronMetadataComponentsType << inputNb;
-    std::string ret;
-    if (getStringMetadata(ss.str(), 0, &ret)) {
-        return ret;
+    const NodeMetadataValue* v = _imp->getValue(eNodeMetadataKeyComponentsType, inputNb);
+    if (v) {
+        return v->stringValue;
     }
     return kNatronColorPlaneID;
 }
@@ -503,14 +949,26 @@ NodeMetadata::getComponentsType(int inputNb) const
 void
 NodeMetadata::setOutputFormat(const RectI& format)
 {
-    setIntNMetadata(kNatronMetadataOutputFormat, &format.x1, 4, true);
+    NodeMetadataValue* v = _imp->getValueForWriting(eNodeMetadataKeyOutputFormat, -1, true);
+    if (v) {
+        v->podValues[0] = format.x1;
+        v->podValues[1] = format.y1;
+        v->podValues[2] = format.x2;
+        v->podValues[3] = format.y2;
+    }
 }
 
 RectI
 NodeMetadata::getOutputFormat() const
 {
     RectI ret;
-    getIntNMetadata(kNatronMetadataOutputFormat, 4, &ret.x1);
+    const NodeMetadataValue* v = _imp->getValue(eNodeMetadataKeyOutputFormat, -1);
+    if (v) {
+        ret.x1 = (int)v->podValues[0];
+        ret.y1 = (int)v->podValues[1];
+        ret.x2 = (int)v->podValues[2];
+        ret.y2 = (int)v->podValues[3];
+    }
     return ret;
 }
 
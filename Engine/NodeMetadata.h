@@ -212,6 +212,12 @@ public:
      **/
     int getMetadataDimension(const std::string& name) const;
 
+    /**
+     * @brief Returns a hash of all meta-datas names and values. Two sets of meta-datas with the same hash
+     * can be considered equal.
+     **/
+    U64 computeHash() const;
+
     /**
      * @brief Serializes the meta-data to a memory segment
      **/
@@ -177,6 +177,7 @@ Node::setLabel(const std::string& label)
         curLabel = QString::fromUtf8(_imp->label.c_str());
         _imp->label = label;
     }
+    invalidateAutoSaveSerialization();
     NodeCollectionPtr collection = getGroup();
     if (collection) {
         collection->notifyNodeLabelChanged( shared_from_this() );
@@ -317,6 +318,13 @@ Node::setNameInternal(const std::string& name,
             labelSet = true;
         }
     }
+
+    // Other nodes refer to this node by its script-name in their inputs and expressions
+    ProjectPtr project = getApp()->getProject();
+    if (project) {
+        project->invalidateAutoSaveSerializations();
+    }
+
     std::string fullySpecifiedName = getFullyQualifiedName();
 
     if (collection) {
@@ -33,6 +33,7 @@
 #include "Engine/KnobItemsTable.h"
 #include "Engine/ImagePlaneDesc.h"
 #include "Engine/Image.h"
+#include "Engine/MemoryAccount.h"
 #include "Engine/Project.h"
 #include "Engine/Timer.h"
 #include "Engine/NodeGuiI.h"
@@ -77,6 +78,9 @@ NodePrivate::NodePrivate(Node* publicInterface,
 , renderStartedCounter(0)
 , inputIsRenderingCounter(0)
 , lastInputNRenderStartedSlotCallTime()
+, renderTimeEstimateMutex()
+, renderTimePerPixelEstimate(0)
+, memoryAccount(new MemoryAccount)
 , persistentMessages()
 , persistentMessageMutex()
 , guiPointer()
@@ -96,6 +100,10 @@ NodePrivate::NodePrivate(Node* publicInterface,
 , overlayColor()
 , nodeIsSelected(false)
 , restoringDefaults(false)
+, autoSaveSerializationMutex()
+, autoSaveSerialization()
+, autoSaveSerializationAge(0)
+, modificationAge(0)
 {
     nodePositionCoords[0] = nodePositionCoords[1] = INT_MIN;
     nodeSize[0] = nodeSize[1] = -1;
@@ -238,6 +238,15 @@ public:
     std::vector<int> inputIsRenderingCounter;
     timeval lastInputNRenderStartedSlotCallTime;
 
+    // Protects renderTimePerPixelEstimate
+    mutable QMutex renderTimeEstimateMutex;
+
+    // Running average of the time spent rendering a pixel, see addRenderTimeSample()
+    double renderTimePerPixelEstimate;
+
+    // The memory allocated by the node and its render clones, see getMemoryAccount()
+    MemoryAccountPtr memoryAccount;
+
     // The last persistent message posted by the plug-in
     PersistentMessageMap persistentMessages;
 
@@ -311,6 +320,15 @@ public:
     // True when restoreNodeToDefault is called
     bool restoringDefaults;
 
+    // The serialization written by the last auto-save, see Node::getAutoSaveSerialization().
+    // It is valid as long as autoSaveSerializationAge is equal to modificationAge.
+    mutable QMutex autoSaveSerializationMutex;
+    SERIALIZATION_NAMESPACE::NodeSerializationPtr autoSaveSerialization;
+    U64 autoSaveSerializationAge;
+
+    // Incremented by Node::invalidateAutoSaveSerialization()
+    U64 modificationAge;
+
 };
 
 
@@ -295,6 +295,7 @@ Node::makePreviewImage(TimeValue time,
         args->draftMode = false;
         args->playback = false;
         args->byPassCache = false;
+        args->priority = eRenderPriorityIdle;
     }
 
     ImagePtr img;
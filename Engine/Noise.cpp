@@ -20,6 +20,8 @@
 #include "Noise.h"
 
 #include <iostream>
+#include <vector>
+#include <algorithm> // min
 #ifdef SEEXPR_USE_SSE
 #include <smmintrin.h>
 #endif
@@ -168,6 +170,80 @@ T noiseHelper(const T* X, const int* period = 0) {
 
 
 
+//! Number of samples whose lattice cells and interpolants are computed together by noiseHelperN
+#define NATRON_NOISE_BLOCK_SIZE 4
+
+//! Same as noiseHelper, for n points. Consecutive points in the same lattice cell (as on a scan-line)
+//! reuse the gradients of the cell corners instead of hashing them again.
+//! The lattice cells and interpolants are computed by blocks of samples so that the compiler can vectorize them.
+//! Gives exactly the same result as noiseHelper.
+template <int d, class T>
+void noiseHelperN(const T* X, int n, T* out, int outStride) {
+    const int num = 1 << d;
+    int cachedIndex[d];
+    bool hasCachedCell = false;
+    double grads[1 << d][d];
+
+    for (int first = 0; first < n; first += NATRON_NOISE_BLOCK_SIZE) {
+        const int blockCount = std::min(NATRON_NOISE_BLOCK_SIZE, n - first);
+        int index[NATRON_NOISE_BLOCK_SIZE][d];
+        T weights[NATRON_NOISE_BLOCK_SIZE][2][d];  // lower and upper weights
+        T alphas[NATRON_NOISE_BLOCK_SIZE][d];
+        for (int b = 0; b < blockCount; b++) {
+            const T* P = X + (first + b) * d;
+            for (int k = 0; k < d; k++) {
+                T f = floorSSE(P[k]);
+                index[b][k] = (int)f;
+                weights[b][0][k] = P[k] - f;
+                weights[b][1][k] = weights[b][0][k] - 1;  // dist to cell with index one above
+            }
+        }
+        for (int b = 0; b < blockCount; b++) {
+            for (int k = 0; k < d; k++) alphas[b][k] = s_curve(weights[b][0][k]);
+        }
+
+        for (int b = 0; b < blockCount; b++) {
+            bool sameCell = hasCachedCell;
+            for (int k = 0; sameCell && k < d; k++) sameCell = (cachedIndex[k] == index[b][k]);
+            if (!sameCell) {
+                // hash to get representative gradient vectors of the corners of the cell
+                for (int dummy = 0; dummy < num; dummy++) {
+                    int latticeIndex[d];
+                    for (int k = 0; k < d; k++) latticeIndex[k] = index[b][k] + ((dummy & (1 << k)) != 0);
+                    int lookup = hashReduceChar<d>(latticeIndex);
+                    for (int k = 0; k < d; k++) grads[dummy][k] = NOISE_TABLES<d>::g[lookup][k];
+                }
+                for (int k = 0; k < d; k++) cachedIndex[k] = index[b][k];
+                hasCachedCell = true;
+            }
+
+            // compute function values propagated from zero from each node
+            T vals[1 << d];
+            for (int dummy = 0; dummy < num; dummy++) {
+                T val = 0;
+                for (int k = 0; k < d; k++) {
+                    double weight = weights[b][(dummy & (1 << k)) != 0][k];
+                    val += grads[dummy][k] * weight;
+                }
+                vals[dummy] = val;
+            }
+            // perform multilinear interpolation (i.e. linear, bilinear, trilinear, quadralinear)
+            for (int newd = d - 1; newd >= 0; newd--) {
+                int newnum = 1 << newd;
+                int k = (d - newd - 1);
+                T alpha = alphas[b][k];
+                T beta = T(1) - alphas[b][k];
+                for (int dummy = 0; dummy < newnum; dummy++) {
+                    int index = dummy * (1 << (d - newd));
+                    int otherIndex = index + (1 << k);
+                    vals[index] = beta * vals[index] + alpha * vals[otherIndex];
+                }
+            }
+            out[(first + b) * outStride] = vals[0];
+        }
+    }
+}
+
 //! Computes cellular noise (non-interpolated piecewise constant cell random values)
 template <int d_in, int d_out, class T>
 void CellNoise(const T* in, T* out) {
@@ -238,6 +314,73 @@ void FBM(const T* in, T* out, int octaves, T lacunarity, T gain) {
     }
 }
 
+//! Noise for n points: in holds n points of d_in coordinates, out receives n values of d_out components
+template <int d_in, int d_out, class T>
+void NoiseN(const T* in, T* out, int n) {
+    if (d_out == 1) {
+        noiseHelperN<d_in, T>(in, n, out, 1);
+        return;
+    }
+    std::vector<T> P(in, in + n * d_in);
+    int i = 0;
+    while (1) {
+        noiseHelperN<d_in, T>(&P[0], n, out + i, d_out);
+        if (++i >= d_out) break;
+        // same offsets as Noise()
+        for (int s = 0; s < n; s++)
+            for (int k = 0; k < d_out; k++) P[s * d_in + k] += (T)1000;
+    }
+}
+
+//! FBM for n points: in holds n points of d_in coordinates, out receives n values of d_out components
+template <int d_in, int d_out, bool turbulence, class T>
+void FBMN(const T* in, T* out, int n, int octaves, T lacunarity, T gain) {
+    std::vector<T> P(in, in + n * d_in);
+    std::vector<T> localResult(n * d_out);
+
+    T scale = 1;
+    for (int s = 0; s < n * d_out; s++) out[s] = 0;
+    int octave = 0;
+    while (1) {
+        NoiseN<d_in, d_out>(&P[0], &localResult[0], n);
+        if (turbulence)
+            for (int s = 0; s < n * d_out; s++) out[s] += fabs(localResult[s]) * scale;
+        else
+            for (int s = 0; s < n * d_out; s++) out[s] += localResult[s] * scale;
+        if (++octave >= octaves) break;
+        scale *= gain;
+        for (int s = 0; s < n * d_in; s++) {
+            P[s] *= lacunarity;
+            P[s] += (T)1234;
+        }
+    }
+}
+
+//! Fills the points of the given row of a tile
+template <int d_in, class T>
+void tileRowPoints(const T* origin, const T* dx, const T* dy, int width, int y, T* points) {
+    for (int x = 0; x < width; x++)
+        for (int k = 0; k < d_in; k++) points[x * d_in + k] = origin[k] + x * dx[k] + y * dy[k];
+}
+
+template <int d_in, int d_out, class T>
+void NoiseTile(const T* origin, const T* dx, const T* dy, int width, int height, T* out, int rowStride) {
+    std::vector<T> points(width * d_in);
+    for (int y = 0; y < height; y++) {
+        tileRowPoints<d_in>(origin, dx, dy, width, y, &points[0]);
+        NoiseN<d_in, d_out>(&points[0], out + (std::size_t)y * rowStride, width);
+    }
+}
+
+template <int d_in, int d_out, bool turbulence, class T>
+void FBMTile(const T* origin, const T* dx, const T* dy, int width, int height, T* out, int rowStride, int octaves, T lacunarity, T gain) {
+    std::vector<T> points(width * d_in);
+    for (int y = 0; y < height; y++) {
+        tileRowPoints<d_in>(origin, dx, dy, width, y, &points[0]);
+        FBMN<d_in, d_out, turbulence>(&points[0], out + (std::size_t)y * rowStride, width, octaves, lacunarity, gain);
+    }
+}
+
 // Explicit instantiations
 template void CellNoise<3, 1, double>(const double*, double*);
 template void CellNoise<3, 3, double>(const double*, double*);
@@ -254,6 +397,23 @@ template void FBM<3, 3, false, double>(const double*, double*, int, double, doub
 template void FBM<3, 3, true, double>(const double*, double*, int, double, double);
 template void FBM<4, 1, false, double>(const double*, double*, int, double, double);
 template void FBM<4, 3, false, double>(const double*, double*, int, double, double);
+template void NoiseN<2, 1, double>(const double*, double*, int);
+template void NoiseN<3, 1, double>(const double*, double*, int);
+template void NoiseN<3, 3, double>(const double*, double*, int);
+template void NoiseN<4, 1, double>(const double*, double*, int);
+template void NoiseN<4, 3, double>(const double*, double*, int);
+template void FBMN<3, 1, false, double>(const double*, double*, int, int, double, double);
+template void FBMN<3, 1, true, double>(const double*, double*, int, int, double, double);
+template void FBMN<3, 3, false, double>(const double*, double*, int, int, double, double);
+template void FBMN<3, 3, true, double>(const double*, double*, int, int, double, double);
+template void FBMN<4, 1, false, double>(const double*, double*, int, int, double, double);
+template void FBMN<4, 3, false, double>(const double*, double*, int, int, double, double);
+template void NoiseTile<3, 1, double>(const double*, const double*, const double*, int, int, double*, int);
+template void NoiseTile<3, 3, double>(const double*, const double*, const double*, int, int, double*, int);
+template void FBMTile<3, 1, false, double>(const double*, const double*, const double*, int, int, double*, int, int, double, double);
+template void FBMTile<3, 1, true, double>(const double*, const double*, const double*, int, int, double*, int, int, double, double);
+template void FBMTile<3, 3, false, double>(const double*, const double*, const double*, int, int, double*, int, int, double, double);
+template void FBMTile<3, 3, true, double>(const double*, const double*, const double*, int, int, double*, int, int, double, double);
 NATRON_NAMESPACE_EXIT
 
 #ifdef MAINTEST
@@ -61,6 +61,27 @@ void PNoise(const T* in, const int* period, T* out);
 template <int d_in, int d_out, bool turbulence, class T>
 void FBM(const T* in, T* out, int octaves, T lacunarity, T gain);
 
+//! One octave of non-periodic Perlin noise for n points: in holds n points of d_in
+//! coordinates and out receives n values of d_out components. Gives the same values
+//! as n calls to Noise(), but consecutive points in the same lattice cell share the
+//! hashing of the cell corners: this is much faster for points along a scan-line.
+template <int d_in, int d_out, class T>
+void NoiseN(const T* in, T* out, int n);
+
+//! Fractional Brownian Motion for n points, same layout as NoiseN()
+template <int d_in, int d_out, bool turbulence, class T>
+void FBMN(const T* in, T* out, int n, int octaves, T lacunarity, T gain);
+
+//! Noise over a tile of width x height samples for generators: the sample (x, y)
+//! is evaluated at origin + x * dx + y * dy (d_in coordinates each) and its d_out
+//! components are written at out + y * rowStride + x * d_out
+template <int d_in, int d_out, class T>
+void NoiseTile(const T* origin, const T* dx, const T* dy, int width, int height, T* out, int rowStride);
+
+//! Fractional Brownian Motion over a tile, same layout as NoiseTile()
+template <int d_in, int d_out, bool turbulence, class T>
+void FBMTile(const T* origin, const T* dx, const T* dy, int width, int height, T* out, int rowStride, int octaves, T lacunarity, T gain);
+
 //! Cellular noise with input and output dimensionality
 template <int d_in, int d_out, class T>
 void CellNoise(const T* in, T* out);
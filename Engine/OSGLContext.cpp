@@ -27,6 +27,7 @@
 #include <stdexcept>
 #include <sstream> // stringstream
 #include <cstring> // strlen
+#include <map>
 
 #include <QtCore/QDebug>
 #include <QtCore/QMutex>
@@ -48,9 +49,13 @@
 
 #include "Engine/AppManager.h"
 #include "Engine/GPUContextPool.h"
+#include "Engine/Texture.h"
 
 #include "Global/GLIncludes.h"
 
+// The maximum amount of video memory in bytes held by the textures released to the pool of a context
+#define NATRON_GL_TEXTURE_POOL_MAX_SIZE ((std::size_t)256 << 20)
+
 NATRON_NAMESPACE_ENTER;
 
 
@@ -112,6 +117,41 @@ static const char* copyUnprocessedChannels_FragmentShader =
 "#endif\n"
 "}";
 
+// Same as applyMaskMix_FragmentShader followed by copyUnprocessedChannels_FragmentShader, in a single pass
+static const char* applyMaskMixCopyUnprocessedChannels_FragmentShader =
+"uniform sampler2D originalImageTex;\n"
+"uniform sampler2D outputImageTex;\n"
+"uniform sampler2D maskImageTex;\n"
+"uniform float mixValue;\n"
+"\n"
+"void main() {\n"
+"   vec4 srcColor = texture2D(originalImageTex,gl_TexCoord[0].st);\n"
+"   vec4 dstColor = texture2D(outputImageTex,gl_TexCoord[0].st);\n"
+"   float alpha;\n"
+"#ifdef MASK_ENABLED\n"
+"       vec4 maskColor = texture2D(maskImageTex,gl_TexCoord[0].st);\n"
+"#ifdef MASK_INVERT\n"
+"       maskColor.a = -maskColor.a;\n"
+"#endif\n"
+"       alpha = mixValue * maskColor.a;\n"
+"#else\n"
+"       alpha = mixValue;\n"
+"#endif\n"
+"   gl_FragColor = dstColor * alpha + (1.0 - alpha) * srcColor;\n"
+"#ifdef DO_R\n"
+"       gl_FragColor.r = srcColor.r;\n"
+"#endif\n"
+"#ifdef DO_G\n"
+"       gl_FragColor.g = srcColor.g;\n"
+"#endif\n"
+"#ifdef DO_B\n"
+"       gl_FragColor.b = srcColor.b;\n"
+"#endif\n"
+"#ifdef DO_A\n"
+"       gl_FragColor.a = srcColor.a;\n"
+"#endif\n"
+"}";
+
 static  const char* copyTex_FragmentShader =
 "uniform sampler2D srcTex;\n"
 "void main() {\n"
@@ -313,6 +353,16 @@ struct OSGLContextPrivate
     GLShaderBasePtr copyTexShader;
     std::vector<GLShaderBasePtr> applyMaskMixShader;
     std::vector<GLShaderBasePtr> copyUnprocessedChannelsShader;
+    std::vector<GLShaderBasePtr> applyMaskMixCopyUnprocessedChannelsShader;
+
+    // Shaders shared by the effects rendering with this context, see getSharedShader()
+    std::map<std::string, GLShaderBasePtr> sharedShaders;
+
+    // Textures that are no longer used by any image, the most recently released first
+    std::list<GLTexturePtr> texturePool;
+
+    // The sum of the size of the textures in texturePool
+    std::size_t texturePoolSize;
 
     OSGLContextPrivate(bool useGPUContext)
         : useGPUContext(useGPUContext)
@@ -333,6 +383,10 @@ struct OSGLContextPrivate
         , fillImageShader()
         , applyMaskMixShader(4)
         , copyUnprocessedChannelsShader(16)
+        , applyMaskMixCopyUnprocessedChannelsShader(64)
+        , sharedShaders()
+        , texturePool()
+        , texturePoolSize(0)
     {
 
     }
@@ -386,6 +440,10 @@ OSGLContext::~OSGLContext()
 {
     setContextCurrentInternal(0, 0, 0, 0);
 
+    _imp->sharedShaders.clear();
+    _imp->texturePool.clear();
+    _imp->texturePoolSize = 0;
+
     if (_imp->pboID) {
         if (_imp->useGPUContext) {
             GL_GPU::DeleteBuffers(1, &_imp->pboID);
@@ -524,6 +582,60 @@ OSGLContext::getOrCreateFBOId()
     return _imp->fboID;
 }
 
+GLShaderBasePtr
+OSGLContext::getSharedShader(const std::string& name) const
+{
+    std::map<std::string, GLShaderBasePtr>::const_iterator found = _imp->sharedShaders.find(name);
+    if ( found == _imp->sharedShaders.end() ) {
+        return GLShaderBasePtr();
+    }
+    return found->second;
+}
+
+void
+OSGLContext::setSharedShader(const std::string& name,
+                             const GLShaderBasePtr& shader)
+{
+    _imp->sharedShaders[name] = shader;
+}
+
+GLTexturePtr
+OSGLContext::takeTextureFromPool(U32 target,
+                                 int internalFormat,
+                                 int width,
+                                 int height)
+{
+    for (std::list<GLTexturePtr>::iterator it = _imp->texturePool.begin(); it != _imp->texturePool.end(); ++it) {
+        if ( ( (U32)(*it)->getTexTarget() == target ) && ( (*it)->getInternalFormat() == internalFormat ) &&
+             ( (*it)->w() == width ) && ( (*it)->h() == height ) ) {
+            GLTexturePtr ret = *it;
+            _imp->texturePoolSize -= ret->getSize();
+            _imp->texturePool.erase(it);
+
+            return ret;
+        }
+    }
+
+    return GLTexturePtr();
+} // takeTextureFromPool
+
+void
+OSGLContext::releaseTextureToPool(const GLTexturePtr& texture)
+{
+    std::size_t size = texture->getSize();
+    if ( (size == 0) || (size > NATRON_GL_TEXTURE_POOL_MAX_SIZE) ) {
+        return;
+    }
+    _imp->texturePool.push_front(texture);
+    _imp->texturePoolSize += size;
+
+    // Deleting the texture calls glDeleteTextures
+    while (_imp->texturePoolSize > NATRON_GL_TEXTURE_POOL_MAX_SIZE) {
+        _imp->texturePoolSize -= _imp->texturePool.back()->getSize();
+        _imp->texturePool.pop_back();
+    }
+} // releaseTextureToPool
+
 
 
 void
@@ -835,6 +947,63 @@ getOrCreateCopyUnprocessedChannelsShaderInternal(bool doR,
     return shader;
 } // OSGLContext::getOrCreateCopyUnprocessedChannelsShader
 
+template <typename GL>
+static boost::shared_ptr<GLShader<GL> >
+getOrCreateMaskMixCopyUnprocessedChannelsShaderInternal(bool maskEnabled,
+                                                        bool maskInvert,
+                                                        bool doR,
+                                                        bool doG,
+                                                        bool doB,
+                                                        bool doA)
+{
+    boost::shared_ptr<GLShader<GL> > shader( new GLShader<GL>() );
+
+    std::string fragmentSource;
+    if (maskEnabled) {
+        fragmentSource += "#define MASK_ENABLED\n";
+    }
+    if (maskInvert) {
+        fragmentSource += "#define MASK_INVERT\n";
+    }
+    // Channels that are not processed are copied from the original image
+    if (!doR) {
+        fragmentSource += "#define DO_R\n";
+    }
+    if (!doG) {
+        fragmentSource += "#define DO_G\n";
+    }
+    if (!doB) {
+        fragmentSource += "#define DO_B\n";
+    }
+    if (!doA) {
+        fragmentSource += "#define DO_A\n";
+    }
+    fragmentSource += std::string(applyMaskMixCopyUnprocessedChannels_FragmentShader);
+
+#ifdef DEBUG
+    std::string error;
+    bool ok = shader->addShader(GLShader<GL>::eShaderTypeFragment, fragmentSource.c_str(), &error);
+    if (!ok) {
+        qDebug() << error.c_str();
+    }
+#else
+    bool ok = shader->addShader(GLShader<GL>::eShaderTypeFragment, fragmentSource.c_str(), 0);
+#endif
+    assert(ok);
+#ifdef DEBUG
+    ok = shader->link(&error);
+    if (!ok) {
+        qDebug() << error.c_str();
+    }
+#else
+    ok = shader->link();
+#endif
+    assert(ok);
+    Q_UNUSED(ok);
+
+    return shader;
+} // getOrCreateMaskMixCopyUnprocessedChannelsShaderInternal
+
 
 GLShaderBasePtr
 OSGLContext::getOrCreateCopyTexShader()
@@ -915,6 +1084,47 @@ OSGLContext::getOrCreateCopyUnprocessedChannelsShader(bool doR,
 
 }
 
+GLShaderBasePtr
+OSGLContext::getOrCreateMaskMixCopyUnprocessedChannelsShader(bool maskEnabled,
+                                                             bool maskInvert,
+                                                             bool doR,
+                                                             bool doG,
+                                                             bool doB,
+                                                             bool doA)
+{
+    int index = 0x0;
+
+    if (doR) {
+        index |= 0x01;
+    }
+    if (doG) {
+        index |= 0x02;
+    }
+    if (doB) {
+        index |= 0x04;
+    }
+    if (doA) {
+        index |= 0x08;
+    }
+    if (maskEnabled) {
+        index |= 0x10;
+    }
+    if (maskInvert) {
+        index |= 0x20;
+    }
+
+    if (_imp->applyMaskMixCopyUnprocessedChannelsShader[index]) {
+        return _imp->applyMaskMixCopyUnprocessedChannelsShader[index];
+    }
+    if (_imp->useGPUContext) {
+        _imp->applyMaskMixCopyUnprocessedChannelsShader[index] = getOrCreateMaskMixCopyUnprocessedChannelsShaderInternal<GL_GPU>(maskEnabled, maskInvert, doR, doG, doB, doA);
+    } else {
+        _imp->applyMaskMixCopyUnprocessedChannelsShader[index] = getOrCreateMaskMixCopyUnprocessedChannelsShaderInternal<GL_CPU>(maskEnabled, maskInvert, doR, doG, doB, doA);
+    }
+
+    return _imp->applyMaskMixCopyUnprocessedChannelsShader[index];
+}
+
 
 OSGLContextAttacher::OSGLContextAttacher(const OSGLContextPtr& c)
 : _c(c)
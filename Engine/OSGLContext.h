@@ -116,6 +116,21 @@ public:
 
     unsigned int getOrCreateFBOId();
 
+    /**
+     * @brief Returns a texture released with releaseTextureToPool() that has the given target, internal format and size,
+     * or NULL if there is none. The returned texture is removed from the pool and its content is undefined.
+     * Note: the context must be made current before calling this function
+     **/
+    GLTexturePtr takeTextureFromPool(U32 target, int internalFormat, int width, int height);
+
+    /**
+     * @brief Gives back a texture that is no longer used so that it can be re-used by takeTextureFromPool()
+     * instead of calling glTexImage2D again. The least recently released textures are deleted when
+     * the pool exceeds NATRON_GL_TEXTURE_POOL_MAX_SIZE bytes.
+     * Note: the context must be made current before calling this function
+     **/
+    void releaseTextureToPool(const GLTexturePtr& texture);
+
 
     // Helper functions used by platform dependent implementations
     static bool stringInExtensionString(const char* string, const char* extensions);
@@ -132,6 +147,22 @@ public:
                                                              bool doB,
                                                              bool doA);
 
+    GLShaderBasePtr getOrCreateMaskMixCopyUnprocessedChannelsShader(bool maskEnabled,
+                                                                    bool maskInvert,
+                                                                    bool doR,
+                                                                    bool doG,
+                                                                    bool doB,
+                                                                    bool doA);
+
+    /**
+     * @brief Returns the shader registered with setSharedShader() under the given name, or NULL if none was registered.
+     * Effects sharing the same GLSL programs use this so that each program is compiled only once per context
+     * instead of once per effect.
+     **/
+    GLShaderBasePtr getSharedShader(const std::string& name) const;
+
+    void setSharedShader(const std::string& name, const GLShaderBasePtr& shader);
+
 
 
     static void unsetCurrentContextNoRenderInternal(bool useGPU, const OSGLContext* context);
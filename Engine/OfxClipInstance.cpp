@@ -86,6 +86,25 @@ struct OfxClipInstancePrivate
     }
 
     const std::vector<std::string>& getComponentsPresentInternal(const OfxClipInstance::ClipDataTLSPtr& tls) const;
+
+    /**
+     * @brief Returns the TLS data of the clip with its cached values invalidated if they were computed in another action.
+     **/
+    OfxClipInstance::ClipDataTLSPtr getActionCache() const
+    {
+        OfxClipInstance::ClipDataTLSPtr tls = tlsData->getOrCreateTLSData();
+        U64 actionID = appPTR->getOFXCurrentActionID_TLS();
+        // Outside of an action nothing is cached
+        if ( (actionID == 0) || (tls->actionID != actionID) ) {
+            tls->actionID = actionID;
+            tls->componentsPresentValid = false;
+            tls->unmappedComponentsValid = false;
+            tls->componentsValid = false;
+            tls->pixelDepth = 0;
+            tls->unmappedBitDepth = 0;
+        }
+        return tls;
+    }
 };
 
 OfxClipInstance::OfxClipInstance(const OfxEffectInstancePtr& nodeInstance,
@@ -156,22 +175,32 @@ OfxClipInstance::getIsMask() const
 const std::string&
 OfxClipInstance::getPixelDepth() const
 {
+    ClipDataTLSPtr tls = _imp->getActionCache();
+    if (tls->pixelDepth) {
+        return *tls->pixelDepth;
+    }
+
     EffectInstancePtr effect = getEffectHolder();
 
     if (!effect) {
-        return natronsDepthToOfxDepth(eImageBitDepthFloat);
+        tls->pixelDepth = &natronsDepthToOfxDepth(eImageBitDepthFloat);
     } else {
 
         int inputNb = getInputNb();
 
         ImageBitDepthEnum depth = effect->getBitDepth(inputNb);
-        return natronsDepthToOfxDepth(depth);
+        tls->pixelDepth = &natronsDepthToOfxDepth(depth);
     }
+    return *tls->pixelDepth;
 }
 
 const std::string &
 OfxClipInstance::getUnmappedBitDepth() const
 {
+    ClipDataTLSPtr tls = _imp->getActionCache();
+    if (tls->unmappedBitDepth) {
+        return *tls->unmappedBitDepth;
+    }
 
     if (isOutput()) {
         EffectInstancePtr effect = getEffectHolder();
@@ -208,23 +237,28 @@ OfxClipInstance::getUnmappedBitDepth() const
         }
 
         deepestBitDepth = effect->getClosestSupportedBitDepth(deepestBitDepth);
-        return natronsDepthToOfxDepth(deepestBitDepth);
+        tls->unmappedBitDepth = &natronsDepthToOfxDepth(deepestBitDepth);
 
     } else {
         EffectInstancePtr effect = getAssociatedNode();
         if (!effect) {
-            return natronsDepthToOfxDepth( getEffectHolder()->getClosestSupportedBitDepth(eImageBitDepthFloat) );
+            tls->unmappedBitDepth = &natronsDepthToOfxDepth( getEffectHolder()->getClosestSupportedBitDepth(eImageBitDepthFloat) );
         } else {
-            return natronsDepthToOfxDepth(effect->getBitDepth(-1));
+            tls->unmappedBitDepth = &natronsDepthToOfxDepth(effect->getBitDepth(-1));
         }
     }
+    return *tls->unmappedBitDepth;
 
 } // OfxClipInstance::getUnmappedBitDepth
 
 const std::string &
 OfxClipInstance::getUnmappedComponents() const
 {
-    
+    ClipDataTLSPtr tls = _imp->getActionCache();
+    if (tls->unmappedComponentsValid) {
+        return tls->unmappedComponents;
+    }
+
     std::string ret;
     
     if (isOutput()) {
@@ -286,8 +320,8 @@ OfxClipInstance::getUnmappedComponents() const
         }
     }
     
-    ClipDataTLSPtr tls = _imp->tlsData->getOrCreateTLSData();
     tls->unmappedComponents = ret;
+    tls->unmappedComponentsValid = true;
     return tls->unmappedComponents;
 
 } // getUnmappedComponents
@@ -367,8 +401,12 @@ OfxClipInstance::getDimension(const std::string &name) const OFX_EXCEPTION_SPEC
         return OFX::Host::ImageEffect::ClipInstance::getDimension(name);
     }
     try {
-        ClipDataTLSPtr tls = _imp->tlsData->getOrCreateTLSData();
+        ClipDataTLSPtr tls = _imp->getActionCache();
+        if (tls->componentsPresentValid) {
+            return (int)tls->componentsPresent.size();
+        }
         const std::vector<std::string>& components = _imp->getComponentsPresentInternal(tls);
+        tls->componentsPresentValid = true;
 
         return (int)components.size();
     } catch (...) {
@@ -379,6 +417,11 @@ OfxClipInstance::getDimension(const std::string &name) const OFX_EXCEPTION_SPEC
 const std::string &
 OfxClipInstance::getComponents() const
 {
+    ClipDataTLSPtr tls = _imp->getActionCache();
+    if (tls->componentsValid) {
+        return tls->components;
+    }
+
     EffectInstancePtr effect = getEffectHolder();
 
     std::string ret;
@@ -401,8 +444,8 @@ OfxClipInstance::getComponents() const
         ret = ImagePlaneDesc::mapPlaneToOFXComponentsTypeString(metadataPlane);
     }
 
-    ClipDataTLSPtr tls = _imp->tlsData->getOrCreateTLSData();
     tls->components = ret;
+    tls->componentsValid = true;
     return tls->components;
     
 
@@ -1038,7 +1081,7 @@ OfxClipInstance::getOutputImageInternal(const std::string* ofxPlane,
     // Find an image plane already allocated, if not create it.
     ImagePtr image;
     for (std::map<ImagePlaneDesc, ImagePtr>::const_iterator it = outputPlanes.begin(); it != outputPlanes.end(); ++it) {
-        if (it->first.getPlaneID() == plane.getPlaneID()) {
+        if ( it->first.isSamePlane(plane) ) {
             image = it->second;
             break;
         }
@@ -1353,6 +1396,13 @@ OfxImageCommon::OfxImageCommon(const EffectInstancePtr& outputClipEffect,
         const unsigned char* ptr = Image::pixelAtStatic(pluginsSeenBounds.x1, pluginsSeenBounds.y1, data.bounds, nComps, dataSizeOf, (const unsigned char*)data.ptrs[0]);
 
         assert(ptr);
+
+        // A plug-in rendering with CUDA is given the same pixel in the copy of the buffer on the device
+        OfxEffectInstancePtr ofxEffect = toOfxEffectInstance(outputClipEffect);
+        U64 cudaBuffer = 0;
+        if ( ofxEffect && ofxEffect->getCudaImageBuffer(internalImage, inputNb == -1, &cudaBuffer) ) {
+            ptr = reinterpret_cast<const unsigned char*>( (std::size_t)cudaBuffer ) + ( ptr - (const unsigned char*)data.ptrs[0] );
+        }
         ofxImageBase->setPointerProperty( kOfxImagePropData, const_cast<unsigned char*>(ptr) );
 
     }
@@ -243,10 +243,25 @@ public:
         std::string unmappedComponents;
         std::string components;
 
+        // Plug-ins query the same clip properties many times per action: the values above are re-used
+        // until the action changes, see OfxHost::getCurrentActionID_TLS()
+        U64 actionID;
+        bool componentsPresentValid;
+        bool unmappedComponentsValid;
+        bool componentsValid;
+        const std::string* pixelDepth;
+        const std::string* unmappedBitDepth;
+
         ClipTLSData()
             : componentsPresent()
             , unmappedComponents()
             , components()
+            , actionID(0)
+            , componentsPresentValid(false)
+            , unmappedComponentsValid(false)
+            , componentsValid(false)
+            , pixelDepth(0)
+            , unmappedBitDepth(0)
         {
         }
     };
@@ -33,6 +33,7 @@
 #include <QtCore/QByteArray>
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QPointF>
+#include <QtCore/QThread>
 
 // ofxhPropertySuite.h:565:37: warning: 'this' pointer cannot be null in well-defined C++ code; comparison may be assumed to always evaluate to true [-Wtautological-undefined-compare]
 CLANG_DIAG_OFF(unknown-pragmas)
@@ -55,9 +56,12 @@ CLANG_DIAG_ON(unknown-pragmas)
 #include "Engine/KnobFile.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/CreateNodeArgs.h"
+#include "Engine/CudaDriver.h"
 #include "Engine/Distortion2D.h"
 #include "Engine/EffectInstanceTLSData.h"
 #include "Engine/EffectOpenGLContextData.h"
+#include "Engine/Image.h"
+#include "Engine/ImageStorage.h"
 #include "Engine/Node.h"
 #include "Engine/NodeMetadata.h"
 #include "Engine/OfxClipInstance.h"
@@ -84,6 +88,138 @@ CLANG_DIAG_ON(unknown-pragmas)
 
 NATRON_NAMESPACE_ENTER;
 
+/**
+ * @brief The state of a render action of a plug-in rendering with CUDA, on the thread calling it. The context of the
+ * CUDA device is current on that thread while this object lives. The RAM images given to the plug-in are copied to
+ * buffers on the device, the buffers of the output images are copied back by finish(). The buffers are freed when
+ * the render action returns.
+ **/
+class OfxCudaRender
+{
+    struct ImageBuffer
+    {
+        // Keeps the RAM image alive until its buffer is copied back
+        ImagePtr image;
+        CudaImageStoragePtr storage;
+        bool isOutput;
+    };
+
+    typedef std::map<const Image*, ImageBuffer> ImageBuffersMap;
+
+public:
+
+    OfxCudaRender(const CudaDriverPtr& driver,
+                  bool useStream)
+    : _driver(driver)
+    , _stream(0)
+    , _contextPushed(false)
+    , _buffers()
+    {
+        _contextPushed = _driver->pushContext();
+        if (_contextPushed && useStream) {
+            _stream = _driver->createStream();
+        }
+    }
+
+    ~OfxCudaRender()
+    {
+        // The buffers must be freed while the context is current
+        _buffers.clear();
+        if (_stream) {
+            _driver->destroyStream(_stream);
+        }
+        if (_contextPushed) {
+            _driver->popContext();
+        }
+    }
+
+    bool isValid() const
+    {
+        return _contextPushed;
+    }
+
+    void* getStream() const
+    {
+        return _stream;
+    }
+
+    /**
+     * @brief Returns in deviceBuffer the address on the device of the copy of the buffer of the given RAM image,
+     * copying it the first time the image is given to the plug-in.
+     **/
+    bool getImageBuffer(const ImagePtr& image,
+                        bool isOutput,
+                        U64* deviceBuffer)
+    {
+        ImageBuffersMap::iterator found = _buffers.find( image.get() );
+        if ( found != _buffers.end() ) {
+            found->second.isOutput |= isOutput;
+            *deviceBuffer = found->second.storage->getDeviceBuffer();
+
+            return true;
+        }
+        if ( (image->getStorageMode() != eStorageModeRAM) || (image->getBufferFormat() != eImageBufferLayoutRGBAPackedFullRect) ) {
+            return false;
+        }
+
+        Image::CPUData data;
+        image->getCPUData(&data);
+
+        // The output is copied too: the plug-in may not write all of its pixels
+        CudaAllocateMemoryArgs args;
+        args.bitDepth = data.bitDepth;
+        args.sizeBytes = (std::size_t)data.bounds.area() * data.nComps * getSizeOfForBitDepth(data.bitDepth);
+        args.driver = _driver;
+        ImageBuffer buffer;
+        buffer.image = image;
+        buffer.storage.reset( new CudaImageStorage() );
+        buffer.isOutput = isOutput;
+        try {
+            buffer.storage->allocateMemory(args);
+        } catch (const std::bad_alloc&) {
+            return false;
+        }
+        if ( !buffer.storage->copyFromHost(data.ptrs[0]) ) {
+            return false;
+        }
+        _buffers[image.get()] = buffer;
+        *deviceBuffer = buffer.storage->getDeviceBuffer();
+
+        return true;
+    } // getImageBuffer
+
+    /**
+     * @brief Waits for the work of the plug-in on the device and copies the buffers of the output images back
+     **/
+    bool finish()
+    {
+        if ( _stream && !_driver->synchronizeStream(_stream) ) {
+            return false;
+        }
+        for (ImageBuffersMap::iterator it = _buffers.begin(); it != _buffers.end(); ++it) {
+            if (!it->second.isOutput) {
+                continue;
+            }
+            Image::CPUData data;
+            it->second.image->getCPUData(&data);
+            if ( !it->second.storage->copyToHost(data.ptrs[0]) ) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+
+    CudaDriverPtr _driver;
+    void* _stream;
+    bool _contextPushed;
+    ImageBuffersMap _buffers;
+};
+
+typedef boost::shared_ptr<OfxCudaRender> OfxCudaRenderPtr;
+
 struct OfxEffectInstanceCommon
 {
     // The internal OpenFX image effect is shared amongst clones because cloning for render
@@ -145,6 +281,11 @@ struct OfxEffectInstanceCommon
     bool multiplanar;
     bool preferRenderAllPlaneAtOnce;
 
+    // The CUDA render actions in progress, by render thread. This is shared by the render clones because the plug-in
+    // fetches its images through the clips of the shared effect.
+    mutable QMutex cudaRendersMutex;
+    std::map<QThread*, OfxCudaRenderPtr> cudaRenders;
+
     OfxEffectInstanceCommon()
     : effect()
     , overlayInteract()
@@ -167,6 +308,8 @@ struct OfxEffectInstanceCommon
     , supportsRenderQuality(false)
     , multiplanar(false)
     , preferRenderAllPlaneAtOnce(false)
+    , cudaRendersMutex()
+    , cudaRenders()
     {
 
     }
@@ -187,6 +330,39 @@ struct OfxEffectInstancePrivate
 
 
 
+/**
+ * @brief Registers the CUDA render of the current thread, if any, for the duration of the render action
+ **/
+class CudaRenderRegistration_RAII
+{
+    OfxEffectInstanceCommon* _common;
+    bool _registered;
+
+public:
+
+    CudaRenderRegistration_RAII(OfxEffectInstanceCommon* common,
+                                const OfxCudaRenderPtr& render)
+    : _common(common)
+    , _registered(false)
+    {
+        if (!render) {
+            return;
+        }
+        QMutexLocker k(&_common->cudaRendersMutex);
+        _common->cudaRenders[QThread::currentThread()] = render;
+        _registered = true;
+    }
+
+    ~CudaRenderRegistration_RAII()
+    {
+        if (!_registered) {
+            return;
+        }
+        QMutexLocker k(&_common->cudaRendersMutex);
+        _common->cudaRenders.erase( QThread::currentThread() );
+    }
+};
+
 ThreadIsActionCaller_RAII::ThreadIsActionCaller_RAII(const OfxEffectInstancePtr& effect)
 {
     appPTR->setOFXLastActionCaller_TLS(effect);
@@ -1622,6 +1798,28 @@ OfxEffectInstance::render(const RenderActionArgs& args)
         outputPlanesMap[it->first] = it->second;
     }
 
+    // Plug-ins supporting CUDA render on the device when the effect renders on the CPU. The OpenGL render path is unchanged.
+    OfxCudaRenderPtr cudaRender;
+    if (args.backendType == eRenderBackendTypeCPU) {
+        const std::string& cudaSupport = getCudaRenderSupport();
+        if (cudaSupport != "false") {
+            CudaDriverPtr driver = appPTR->getCudaDriver();
+            if ( driver->isValid() ) {
+                bool useStream = effectInstance()->getDescriptor().getProps().getStringProperty(kOfxImageEffectPropCudaStreamSupported) == "true";
+                cudaRender.reset( new OfxCudaRender(driver, useStream) );
+                if ( !cudaRender->isValid() ) {
+                    cudaRender.reset();
+                }
+            }
+            if ( !cudaRender && (cudaSupport == "needed") ) {
+                getNode()->setPersistentMessage( eMessageTypeError, kNatronPersistentErrorOpenFXPlugin, tr("This plug-in requires a CUDA device to render.").toStdString() );
+
+                return eActionStatusFailed;
+            }
+        }
+    }
+    CudaRenderRegistration_RAII cudaRenderRegistration(_imp->common.get(), cudaRender);
+
     {
         assert(_imp->common->effect);
 
@@ -1651,6 +1849,9 @@ OfxEffectInstance::render(const RenderActionArgs& args)
                                           viewsCount,
                                           ofxPlanes );
     }
+    if ( (stat == kOfxStatOK) && cudaRender && !cudaRender->finish() ) {
+        stat = kOfxStatFailed;
+    }
 
     if (stat == kOfxStatOK) {
         getNode()->clearPersistentMessage(kNatronPersistentErrorOpenFXPlugin);
@@ -1672,6 +1873,44 @@ OfxEffectInstance::render(const RenderActionArgs& args)
     }
 } // render
 
+const std::string&
+OfxEffectInstance::getCudaRenderSupport() const
+{
+    return effectInstance()->getDescriptor().getProps().getStringProperty(kOfxImageEffectPropCudaRenderSupported);
+}
+
+bool
+OfxEffectInstance::isCudaRenderInProgress(void** stream) const
+{
+    QMutexLocker k(&_imp->common->cudaRendersMutex);
+    std::map<QThread*, OfxCudaRenderPtr>::const_iterator found = _imp->common->cudaRenders.find( QThread::currentThread() );
+    if ( found == _imp->common->cudaRenders.end() ) {
+        return false;
+    }
+    *stream = found->second->getStream();
+
+    return true;
+}
+
+bool
+OfxEffectInstance::getCudaImageBuffer(const ImagePtr& image,
+                                      bool isOutput,
+                                      U64* deviceBuffer)
+{
+    OfxCudaRenderPtr cudaRender;
+    {
+        QMutexLocker k(&_imp->common->cudaRendersMutex);
+        std::map<QThread*, OfxCudaRenderPtr>::const_iterator found = _imp->common->cudaRenders.find( QThread::currentThread() );
+        if ( found == _imp->common->cudaRenders.end() ) {
+            return false;
+        }
+        cudaRender = found->second;
+    }
+
+    // Only the thread of the render action uses its OfxCudaRender
+    return cudaRender->getImageBuffer(image, isOutput, deviceBuffer);
+}
+
 PluginMemoryPtr
 OfxEffectInstance::createPluginMemory()
 {
@@ -286,6 +286,24 @@ public:
     void onClipHintChanged(int inputNb, const std::string& hint);
     void onClipSecretChanged(int inputNb, bool isSecret);
 
+    /**
+     * @brief Returns the kOfxImageEffectPropCudaRenderSupported property of the plug-in: "false", "true" or "needed"
+     **/
+    const std::string& getCudaRenderSupport() const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Returns true if the calling thread is in a render action of this effect with CUDA enabled, and the CUDA
+     * stream the plug-in must use in stream, or NULL if it synchronizes its work itself.
+     **/
+    bool isCudaRenderInProgress(void** stream) const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief During a CUDA render action, returns in deviceBuffer the address on the CUDA device of the copy of the buffer
+     * of the given RAM image. The buffer of an output image is copied back to the image when the render action returns.
+     * Returns false if the calling thread is not in a CUDA render action of this effect.
+     **/
+    bool getCudaImageBuffer(const ImagePtr& image, bool isOutput, U64* deviceBuffer) WARN_UNUSED_RETURN;
+
 public Q_SLOTS:
 
     void onSyncPrivateDataRequested();
@@ -34,6 +34,7 @@
 #include <algorithm> // transform, min, max
 #include <string>
 #include <cstring> // for std::memcpy, std::memset, std::strcmp
+#include <sstream> // ostringstream
 
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
@@ -108,8 +109,10 @@ CLANG_DIAG_ON(unknown-pragmas)
 #include "Engine/Project.h"
 #include "Engine/Settings.h"
 #include "Engine/StandardPaths.h"
+#include "Engine/StartupTrace.h"
 #include "Engine/TLSHolder.h"
 #include "Engine/ThreadPool.h"
+#include "Engine/Timer.h"
 
 #include "Serialization/NodeSerialization.h"
 
@@ -156,12 +159,16 @@ struct OfxHostPrivate
     int loadingPluginVersionMajor;
     int loadingPluginVersionMinor;
 
+    // Traces the loading of the plug-in being loaded while scanning the plug-in files
+    boost::scoped_ptr<StartupTrace::Scope_RAII> loadingPluginTrace;
+
     OfxHostPrivate()
         : imageEffectPluginCache()
         , tlsData( new TLSHolder<OfxHost::OfxHostTLSData>() )
         , loadingPluginID()
         , loadingPluginVersionMajor(0)
         , loadingPluginVersionMinor(0)
+        , loadingPluginTrace()
     {
     }
 };
@@ -295,6 +302,22 @@ OfxHost::setProperties()
     //    _properties.setStringProperty(kOfxImageEffectPropOpenGLRenderSupported, "false"); // OFX 1.3
     //}
 #endif
+    {
+        // GPU render extensions (OFX 1.5). CUDA is supported wherever the NVIDIA driver exists: whether a device is
+        // actually available is only known at render time, plug-ins that do not need CUDA then render on the CPU.
+        static const OFX::Host::Property::PropSpec gpuRenderHostProps[] = {
+            { kOfxImageEffectPropCudaRenderSupported,  OFX::Host::Property::eString,    1,    true,    "false" },
+            { kOfxImageEffectPropCudaStreamSupported,  OFX::Host::Property::eString,    1,    true,    "false" },
+            { kOfxImageEffectPropOpenCLRenderSupported,  OFX::Host::Property::eString,    1,    true,    "false" },
+            { kOfxImageEffectPropMetalRenderSupported,  OFX::Host::Property::eString,    1,    true,    "false" },
+            OFX::Host::Property::propSpecEnd
+        };
+        _properties.addProperties(gpuRenderHostProps);
+#ifndef __NATRON_OSX__
+        _properties.setStringProperty(kOfxImageEffectPropCudaRenderSupported, "true");
+        _properties.setStringProperty(kOfxImageEffectPropCudaStreamSupported, "true");
+#endif
+    }
     _properties.setIntProperty(kOfxImageEffectPropRenderQualityDraft, 1); // OFX 1.4
     _properties.setStringProperty(kOfxImageEffectHostPropNativeOrigin, kOfxHostNativeOriginBottomLeft); // OFX 1.4
 
@@ -632,6 +655,8 @@ OfxHost::getPluginContextAndDescribe(OFX::Host::ImageEffect::ImageEffectPlugin*
     _imp->loadingPluginVersionMajor = plugin->getVersionMajor();
     _imp->loadingPluginVersionMinor = plugin->getVersionMajor();
 
+    StartupTrace::Scope_RAII trace(plugin->getRawIdentifier(), "describe", false);
+
     OFX::Host::PluginHandle *pluginHandle;
     // getPluginHandle() must be called before getContexts():
     // it calls kOfxActionLoad on the plugin and kOfxActionDescribe, which may set properties (including supported contexts)
@@ -798,11 +823,196 @@ QDebug operator<<(QDebug dbg, const std::list<std::string> &l)
 }
 
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief The Natron plug-in made from the descriptor of an OpenFX plug-in, before it is registered
+ **/
+struct OFXPluginDescription
+{
+    // NULL if the plug-in has no context
+    PluginPtr plugin;
+
+    // If the plug-in is a reader or a writer, the file extensions it supports
+    std::vector<std::string> formats;
+    double evaluation;
+    bool isReader, isWriter;
+
+    OFXPluginDescription()
+    : plugin()
+    , formats()
+    , evaluation(0)
+    , isReader(false)
+    , isWriter(false)
+    {
+
+    }
+};
+
+/**
+ * @brief Makes the Natron plug-in from the cached descriptor of an OpenFX plug-in.
+ * This only reads the descriptor, which was already described, and may run concurrently for different plug-ins.
+ **/
+OFXPluginDescription
+makeOFXPluginDescription(OFX::Host::ImageEffect::ImageEffectPlugin* p)
+{
+    OFXPluginDescription ret;
+    assert(p);
+    if (p->getContexts().size() == 0) {
+        return ret;
+    }
+
+    std::string openfxId = p->getIdentifier();
+    const std::string & grouping = p->getDescriptor().getPluginGrouping();
+    const std::string & bundlePath = p->getBinary()->getBundlePath();
+    std::string pluginLabel = OfxEffectInstance::makePluginLabel( p->getDescriptor().getShortLabel(),
+                                                                  p->getDescriptor().getLabel(),
+                                                                  p->getDescriptor().getLongLabel() );
+    std::vector<std::string> groups = OfxEffectInstance::makePluginGrouping(p->getIdentifier(),
+                                                               p->getVersionMajor(), p->getVersionMinor(),
+                                                               pluginLabel, grouping);
+
+    assert( p->getBinary() );
+    std::string resourcesPath = bundlePath+ "/Contents/Resources/";
+    std::string iconFileName;
+    {
+        try {
+            // kOfxPropIcon is normally only defined for parameter desctriptors
+            // (see <http://openfx.sourceforge.net/Documentation/1.3/ofxProgrammingReference.html#ParameterProperties>)
+            // but let's assume it may also be defained on the plugin descriptor.
+            iconFileName = p->getDescriptor().getProps().getStringProperty(kOfxPropIcon, 1); // dimension 1 is PNG icon
+        } catch (OFX::Host::Property::Exception) {
+        }
+
+        if ( iconFileName.empty() ) {
+            // no icon defined by kOfxPropIcon, use the plug-in id value
+            iconFileName = openfxId + ".png";
+        }
+    }
+    std::string groupIconFilename;
+    if (groups.size() > 0) {
+        groupIconFilename = resourcesPath;
+        // the plugin grouping has no descriptor, just try the default filename.
+        groupIconFilename.append(groups[0]);
+        groupIconFilename.append(".png");
+    } else {
+        //Use default Misc group when the plug-in doesn't belong to a group
+        groups.push_back(PLUGIN_GROUP_DEFAULT);
+    }
+    std::vector<std::string> groupIcons;
+    groupIcons.push_back(groupIconFilename);
+    for (std::size_t i = 1; i < groups.size(); ++i) {
+        std::string groupIconPath = resourcesPath;
+        for (std::size_t j = 0; j <= i; ++j) {
+            groupIconPath += groups[j];
+            if (j < i) {
+                groupIconPath += '/';
+            } else {
+                groupIconPath.append(".png");
+            }
+        }
+        groupIcons.push_back(groupIconPath);
+    }
+
+    RenderSafetyEnum renderSafety;
+    {
+        std::string safety = p->getDescriptor().getRenderThreadSafety();
+        if (safety == kOfxImageEffectRenderUnsafe) {
+            renderSafety =  eRenderSafetyUnsafe;
+        } else if (safety == kOfxImageEffectRenderInstanceSafe) {
+            renderSafety = eRenderSafetyInstanceSafe;
+        } else if (safety == kOfxImageEffectRenderFullySafe) {
+            if ( p->getDescriptor().getHostFrameThreading() ) {
+                renderSafety = eRenderSafetyFullySafeFrame;
+            } else {
+                renderSafety = eRenderSafetyFullySafe;
+            }
+        } else {
+            qDebug() << "Unknown thread safety level: " << safety.c_str();
+            renderSafety = eRenderSafetyUnsafe;
+        }
+    }
+
+    PluginOpenGLRenderSupport glSupport = ePluginOpenGLRenderSupportNone;
+    {
+        const std::string& str = p->getDescriptor().getProps().getStringProperty(kOfxImageEffectPropOpenGLRenderSupported);
+        if (str == "false") {
+            glSupport = ePluginOpenGLRenderSupportNone;
+        } else if (str == "needed") {
+            glSupport = ePluginOpenGLRenderSupportNeeded;
+        } else if (str == "true") {
+            glSupport = ePluginOpenGLRenderSupportYes;
+        }
+    }
+
+    const std::set<std::string> & contexts = p->getContexts();
+    std::set<std::string>::const_iterator foundReader = contexts.find(kOfxImageEffectContextReader);
+    std::set<std::string>::const_iterator foundWriter = contexts.find(kOfxImageEffectContextWriter);
+    const bool isDeprecated = p->getDescriptor().isDeprecated();
+    std::string description = p->getDescriptor().getProps().getStringProperty(kOfxPropPluginDescription);
+
+    bool isDescMarkdown = (bool)p->getDescriptor().getProps().getIntProperty(kNatronOfxPropDescriptionIsMarkdown);
+
+    PluginPtr natronPlugin = Plugin::create((void*)OfxEffectInstance::create, (void*)OfxEffectInstance::createRenderClone, openfxId, pluginLabel, p->getVersionMajor(), p->getVersionMinor(), groups, groupIcons);
+    natronPlugin->setProperty<std::string>(kNatronPluginPropDescription, description);
+    natronPlugin->setProperty<bool>(kNatronPluginPropDescriptionIsMarkdown, isDescMarkdown);
+    natronPlugin->setProperty<std::string>(kNatronPluginPropResourcesPath, resourcesPath);
+    natronPlugin->setProperty<std::string>(kNatronPluginPropIconFilePath, iconFileName);
+    natronPlugin->setProperty<int>(kNatronPluginPropRenderSafety, renderSafety);
+    natronPlugin->setProperty<bool>(kNatronPluginPropIsDeprecated, isDeprecated);
+    natronPlugin->setProperty<int>(kNatronPluginPropOpenGLSupport, (int)glSupport);
+    natronPlugin->setProperty<void*>(kNatronPluginPropOpenFXPluginPtr, (void*)p);
+
+    std::list<PluginActionShortcut> shortcuts;
+    getPluginShortcuts(p->getDescriptor(), &shortcuts);
+    for (std::list<PluginActionShortcut>::iterator it = shortcuts.begin(); it!=shortcuts.end(); ++it) {
+        natronPlugin->addActionShortcut(*it);
+    }
+
+    Key symbol = (Key)0;
+    KeyboardModifiers mods = eKeyboardModifierNone;
+    if (openfxId == PLUGINID_OFX_TRANSFORM) {
+        symbol = Key_T;
+    } else if (openfxId == PLUGINID_OFX_MERGE) {
+        symbol = Key_M;
+    } else if (openfxId == PLUGINID_OFX_GRADE) {
+        symbol = Key_G;
+    } else if (openfxId == PLUGINID_OFX_COLORCORRECT) {
+        symbol = Key_C;
+    } else if (openfxId == PLUGINID_OFX_BLURCIMG) {
+        symbol = Key_B;
+    }
+
+    natronPlugin->setProperty<int>(kNatronPluginPropShortcut, (int)symbol, 0);
+    natronPlugin->setProperty<int>(kNatronPluginPropShortcut, (int)mods, 1);
+
+    ///if this plugin's descriptor has the kTuttleOfxImageEffectPropSupportedExtensions property,
+    ///use it to fill the readersMap and writersMap
+    int formatsCount = p->getDescriptor().getProps().getDimension(kTuttleOfxImageEffectPropSupportedExtensions);
+    ret.formats.resize(formatsCount);
+    for (int k = 0; k < formatsCount; ++k) {
+        ret.formats[k] = p->getDescriptor().getProps().getStringProperty(kTuttleOfxImageEffectPropSupportedExtensions, k);
+        std::transform(ret.formats[k].begin(), ret.formats[k].end(), ret.formats[k].begin(), ::tolower);
+    }
+
+    ret.evaluation = p->getDescriptor().getProps().getDoubleProperty(kTuttleOfxImageEffectPropEvaluation);
+    if ( !isDeprecated && (formatsCount > 0) ) {
+        ret.isReader = foundReader != contexts.end();
+        ret.isWriter = foundWriter != contexts.end();
+    }
+    ret.plugin = natronPlugin;
+
+    return ret;
+} // makeOFXPluginDescription
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 void
 OfxHost::loadOFXPlugins(IOPluginsMap* readersMap,
                         IOPluginsMap* writersMap)
 {
     qDebug() << "Load OFX Plugins...";
+    TimeLapse phaseTimer;
     SettingsPtr settings = appPTR->getCurrentSettings();
     assert(settings);
     bool useStdOFXPluginsLocation = settings->getUseStdOFXPluginsLocation();
@@ -857,6 +1067,7 @@ OfxHost::loadOFXPlugins(IOPluginsMap* readersMap,
     qDebug() << "Load OFX Plugins: reading cache file" << ofxCacheFilePath;
 
     {
+        StartupTrace::Scope_RAII trace("Read the OpenFX plug-ins cache", "startup");
         FStreamsSupport::ifstream ifs;
         FStreamsSupport::open( &ifs, ofxCacheFilePath.toStdString() );
         if (!ifs) {
@@ -864,7 +1075,7 @@ OfxHost::loadOFXPlugins(IOPluginsMap* readersMap,
         } else {
             try {
                 pluginCache->readCache(ifs);
-                qDebug() << "Load OFX Plugins: reading cache file... done!";
+                qDebug() << "Load OFX Plugins: reading cache file... done in" << phaseTimer.getTimeElapsedReset() << "s";
             } catch (const std::exception& e) {
                 qDebug() << "Load OFX Plugins: reading cache file... failed!";
                 appPTR->writeToErrorLog_mt_safe( QLatin1String("OpenFX"), QDateTime::currentDateTime(),
@@ -875,15 +1086,23 @@ OfxHost::loadOFXPlugins(IOPluginsMap* readersMap,
     
     qDebug() << "Load OFX Plugins: plugin path is" << pluginCache->getPluginPath();
     qDebug() << "Load OFX Plugins: scan plugins...";
-    pluginCache->scanPluginFiles();
-    qDebug() << "Load OFX Plugins: scan plugins... done!";
+    phaseTimer.reset();
+    {
+        StartupTrace::Scope_RAII trace("Scan the OpenFX plug-ins", "startup");
+        pluginCache->scanPluginFiles();
+        _imp->loadingPluginTrace.reset();
+    }
+    qDebug() << "Load OFX Plugins: scan plugins... done in" << phaseTimer.getTimeElapsedReset() << "s";
     _imp->loadingPluginID.clear(); // finished loading plugins
 
     // write the cache NOW (it won't change anyway)
     qDebug() << "Load OFX Plugins: writing cache file" << ofxCacheFilePath;
     /// flush out the current cache
-    writeOFXCache();
-    qDebug() << "Load OFX Plugins: writing cache file... done!";
+    {
+        StartupTrace::Scope_RAII trace("Write the OpenFX plug-ins cache", "startup");
+        writeOFXCache();
+    }
+    qDebug() << "Load OFX Plugins: writing cache file... done in" << phaseTimer.getTimeElapsedReset() << "s";
 
     /*Filling node name list and plugin grouping*/
     typedef std::map<OFX::Host::ImageEffect::MajorPlugin, OFX::Host::ImageEffect::ImageEffectPlugin *> PMap;
@@ -891,167 +1110,39 @@ OfxHost::loadOFXPlugins(IOPluginsMap* readersMap,
         _imp->imageEffectPluginCache->getPluginsByIDMajor();
 
 
-    for (PMap::const_iterator it = ofxPlugins.begin();
-         it != ofxPlugins.end(); ++it) {
-        OFX::Host::ImageEffect::ImageEffectPlugin* p = it->second;
-        assert(p);
-        if (p->getContexts().size() == 0) {
-            continue;
-        }
-
-        std::string openfxId = p->getIdentifier();
-        const std::string & grouping = p->getDescriptor().getPluginGrouping();
-        const std::string & bundlePath = p->getBinary()->getBundlePath();
-        std::string pluginLabel = OfxEffectInstance::makePluginLabel( p->getDescriptor().getShortLabel(),
-                                                                      p->getDescriptor().getLabel(),
-                                                                      p->getDescriptor().getLongLabel() );
-        std::vector<std::string> groups = OfxEffectInstance::makePluginGrouping(p->getIdentifier(),
-                                                                   p->getVersionMajor(), p->getVersionMinor(),
-                                                                   pluginLabel, grouping);
-
-        assert( p->getBinary() );
-        std::string resourcesPath = bundlePath+ "/Contents/Resources/";
-        std::string iconFileName;
-        {
-            try {
-                // kOfxPropIcon is normally only defined for parameter desctriptors
-                // (see <http://openfx.sourceforge.net/Documentation/1.3/ofxProgrammingReference.html#ParameterProperties>)
-                // but let's assume it may also be defained on the plugin descriptor.
-                iconFileName = p->getDescriptor().getProps().getStringProperty(kOfxPropIcon, 1); // dimension 1 is PNG icon
-            } catch (OFX::Host::Property::Exception) {
-            }
-
-            if ( iconFileName.empty() ) {
-                // no icon defined by kOfxPropIcon, use the plug-in id value
-                iconFileName = openfxId + ".png";
-            }
-        }
-        std::string groupIconFilename;
-        if (groups.size() > 0) {
-            groupIconFilename = resourcesPath;
-            // the plugin grouping has no descriptor, just try the default filename.
-            groupIconFilename.append(groups[0]);
-            groupIconFilename.append(".png");
-        } else {
-            //Use default Misc group when the plug-in doesn't belong to a group
-            groups.push_back(PLUGIN_GROUP_DEFAULT);
-        }
-        std::vector<std::string> groupIcons;
-        groupIcons.push_back(groupIconFilename);
-        for (std::size_t i = 1; i < groups.size(); ++i) {
-            std::string groupIconPath = resourcesPath;
-            for (std::size_t j = 0; j <= i; ++j) {
-                groupIconPath += groups[j];
-                if (j < i) {
-                    groupIconPath += '/';
-                } else {
-                    groupIconPath.append(".png");
-                }
-            }
-            groupIcons.push_back(groupIconPath);
-        }
-
-        RenderSafetyEnum renderSafety;
-        {
-            std::string safety = p->getDescriptor().getRenderThreadSafety();
-            if (safety == kOfxImageEffectRenderUnsafe) {
-                renderSafety =  eRenderSafetyUnsafe;
-            } else if (safety == kOfxImageEffectRenderInstanceSafe) {
-                renderSafety = eRenderSafetyInstanceSafe;
-            } else if (safety == kOfxImageEffectRenderFullySafe) {
-                if ( p->getDescriptor().getHostFrameThreading() ) {
-                    renderSafety = eRenderSafetyFullySafeFrame;
-                } else {
-                    renderSafety = eRenderSafetyFullySafe;
-                }
-            } else {
-                qDebug() << "Unknown thread safety level: " << safety.c_str();
-                renderSafety = eRenderSafetyUnsafe;
-            }
-        }
-
-        PluginOpenGLRenderSupport glSupport = ePluginOpenGLRenderSupportNone;
-        {
-            const std::string& str = p->getDescriptor().getProps().getStringProperty(kOfxImageEffectPropOpenGLRenderSupported);
-            if (str == "false") {
-                glSupport = ePluginOpenGLRenderSupportNone;
-            } else if (str == "needed") {
-                glSupport = ePluginOpenGLRenderSupportNeeded;
-            } else if (str == "true") {
-                glSupport = ePluginOpenGLRenderSupportYes;
-            }
-        }
-
-        const std::set<std::string> & contexts = p->getContexts();
-        std::set<std::string>::const_iterator foundReader = contexts.find(kOfxImageEffectContextReader);
-        std::set<std::string>::const_iterator foundWriter = contexts.find(kOfxImageEffectContextWriter);
-        const bool isDeprecated = p->getDescriptor().isDeprecated();
-        std::string description = p->getDescriptor().getProps().getStringProperty(kOfxPropPluginDescription);
-
-        bool isDescMarkdown = (bool)p->getDescriptor().getProps().getIntProperty(kNatronOfxPropDescriptionIsMarkdown);
-
-        PluginPtr natronPlugin = Plugin::create((void*)OfxEffectInstance::create, (void*)OfxEffectInstance::createRenderClone, openfxId, pluginLabel, p->getVersionMajor(), p->getVersionMinor(), groups, groupIcons);
-        natronPlugin->setProperty<std::string>(kNatronPluginPropDescription, description);
-        natronPlugin->setProperty<bool>(kNatronPluginPropDescriptionIsMarkdown, isDescMarkdown);
-        natronPlugin->setProperty<std::string>(kNatronPluginPropResourcesPath, resourcesPath);
-        natronPlugin->setProperty<std::string>(kNatronPluginPropIconFilePath, iconFileName);
-        natronPlugin->setProperty<int>(kNatronPluginPropRenderSafety, renderSafety);
-        natronPlugin->setProperty<bool>(kNatronPluginPropIsDeprecated, isDeprecated);
-        natronPlugin->setProperty<int>(kNatronPluginPropOpenGLSupport, (int)glSupport);
-        natronPlugin->setProperty<void*>(kNatronPluginPropOpenFXPluginPtr, (void*)p);
-
-        std::list<PluginActionShortcut> shortcuts;
-        getPluginShortcuts(p->getDescriptor(), &shortcuts);
-        for (std::list<PluginActionShortcut>::iterator it = shortcuts.begin(); it!=shortcuts.end(); ++it) {
-            natronPlugin->addActionShortcut(*it);
-        }
-
-        Key symbol = (Key)0;
-        KeyboardModifiers mods = eKeyboardModifierNone;
-        if (openfxId == PLUGINID_OFX_TRANSFORM) {
-            symbol = Key_T;
-        } else if (openfxId == PLUGINID_OFX_MERGE) {
-            symbol = Key_M;
-        } else if (openfxId == PLUGINID_OFX_GRADE) {
-            symbol = Key_G;
-        } else if (openfxId == PLUGINID_OFX_COLORCORRECT) {
-            symbol = Key_C;
-        } else if (openfxId == PLUGINID_OFX_BLURCIMG) {
-            symbol = Key_B;
-        }
-
-        natronPlugin->setProperty<int>(kNatronPluginPropShortcut, (int)symbol, 0);
-        natronPlugin->setProperty<int>(kNatronPluginPropShortcut, (int)mods, 1);
+    // Reading the descriptors does not call the plug-ins: do it in parallel, but register the plug-ins in order
+    StartupTrace::Scope_RAII registerTrace("Register the OpenFX plug-ins", "startup");
+    std::vector<OFX::Host::ImageEffect::ImageEffectPlugin*> pluginsToRegister;
+    pluginsToRegister.reserve( ofxPlugins.size() );
+    for (PMap::const_iterator it = ofxPlugins.begin(); it != ofxPlugins.end(); ++it) {
+        assert(it->second);
+        pluginsToRegister.push_back(it->second);
+    }
+    std::vector<OFXPluginDescription> descriptions = QtConcurrent::blockingMapped<std::vector<OFXPluginDescription> >(pluginsToRegister, makeOFXPluginDescription);
 
-        ///if this plugin's descriptor has the kTuttleOfxImageEffectPropSupportedExtensions property,
-        ///use it to fill the readersMap and writersMap
-        int formatsCount = p->getDescriptor().getProps().getDimension(kTuttleOfxImageEffectPropSupportedExtensions);
-        std::vector<std::string> formats(formatsCount);
-        for (int k = 0; k < formatsCount; ++k) {
-            formats[k] = p->getDescriptor().getProps().getStringProperty(kTuttleOfxImageEffectPropSupportedExtensions, k);
-            std::transform(formats[k].begin(), formats[k].end(), formats[k].begin(), ::tolower);
+    for (std::vector<OFXPluginDescription>::const_iterator it = descriptions.begin(); it != descriptions.end(); ++it) {
+        if (!it->plugin) {
+            continue;
         }
-
-        double evaluation = p->getDescriptor().getProps().getDoubleProperty(kTuttleOfxImageEffectPropEvaluation);
-
-
-        if (!isDeprecated && ( foundReader != contexts.end() ) && (formatsCount > 0) && readersMap) {
+        const std::string& openfxId = it->plugin->getPluginID();
+        if (it->isReader && readersMap) {
             ///we're safe to assume that this plugin is a reader
-            for (std::size_t k = 0; k < formats.size(); ++k) {
-                IOPluginSetForFormat& evalForFormat = (*readersMap)[formats[k]];
-                evalForFormat.insert( IOPluginEvaluation(openfxId, evaluation) );
+            for (std::size_t k = 0; k < it->formats.size(); ++k) {
+                IOPluginSetForFormat& evalForFormat = (*readersMap)[it->formats[k]];
+                evalForFormat.insert( IOPluginEvaluation(openfxId, it->evaluation) );
             }
-        } else if (!isDeprecated && ( foundWriter != contexts.end() ) && (formatsCount > 0) && writersMap) {
+        } else if (it->isWriter && writersMap) {
             ///we're safe to assume that this plugin is a writer.
-            for (std::size_t k = 0; k < formats.size(); ++k) {
-                IOPluginSetForFormat& evalForFormat = (*writersMap)[formats[k]];
-                evalForFormat.insert( IOPluginEvaluation(openfxId, evaluation) );
+            for (std::size_t k = 0; k < it->formats.size(); ++k) {
+                IOPluginSetForFormat& evalForFormat = (*writersMap)[it->formats[k]];
+                evalForFormat.insert( IOPluginEvaluation(openfxId, it->evaluation) );
             }
         }
 
-        appPTR->registerPlugin(natronPlugin);
+        appPTR->registerPlugin(it->plugin);
     }
-    qDebug() << "Load OFX Plugins... done!";
+    qDebug() << "Load OFX Plugins: registered" << descriptions.size() << "plug-ins in" << phaseTimer.getTimeElapsedReset() << "s";
+    qDebug() << "Load OFX Plugins... done in" << phaseTimer.getTimeSinceCreation() << "s";
 } // loadOFXPlugins
 
 void
@@ -1062,26 +1153,45 @@ OfxHost::writeOFXCache()
     QDir().mkpath(ofxCachePath);
     QString ofxCacheFilePath = getCacheFilePath();
 
-    QTemporaryFile tmpf;
-    tmpf.open();
-    QString tmpFileName = tmpf.fileName();
-    tmpf.remove();
+    OFX::Host::PluginCache* pluginCache = OFX::Host::PluginCache::getPluginCache();
+    assert(pluginCache);
+    std::ostringstream ss;
+    pluginCache->writePluginCache(ss);
+    const std::string cacheContent = ss.str();
 
-    FStreamsSupport::ofstream ofile;
-    FStreamsSupport::open( &ofile, tmpFileName.toStdString() );
-    if (!ofile) {
+    // When no plug-in binary changed, the cache is the same as the one read at startup: do not rewrite it.
+    // Many processes (e.g: render farm tasks) may start at the same time, and a process that would find
+    // the cache file missing while another one replaces it would load and describe all plug-ins again.
+    {
+        QFile existingFile(ofxCacheFilePath);
+        if ( existingFile.open(QIODevice::ReadOnly) && ( existingFile.size() == (qint64)cacheContent.size() ) ) {
+            QByteArray existingContent = existingFile.readAll();
+            if ( ( existingContent.size() == (int)cacheContent.size() ) &&
+                 ( std::memcmp(existingContent.constData(), cacheContent.data(), cacheContent.size()) == 0 ) ) {
+                return;
+            }
+        }
+    }
+
+    // Write in the cache directory so that the file can then be renamed instead of copied
+    QTemporaryFile tmpf( ofxCachePath + QString::fromUtf8("/OFXCache_XXXXXX.tmp") );
+    if ( !tmpf.open() ) {
         return;
     }
-    OFX::Host::PluginCache* pluginCache = OFX::Host::PluginCache::getPluginCache();
-    assert(pluginCache);
-    pluginCache->writePluginCache(ofile);
+    if ( tmpf.write( cacheContent.data(), (qint64)cacheContent.size() ) != (qint64)cacheContent.size() ) {
+        return;
+    }
+    tmpf.close();
+    tmpf.setAutoRemove(false);
+    QString tmpFileName = tmpf.fileName();
 
-    ofile.close();
     if (QFile::exists(ofxCacheFilePath)) {
         QFile::remove(ofxCacheFilePath);
     }
-    QFile::copy(tmpFileName, ofxCacheFilePath);
-    QFile::remove(tmpFileName);
+    if ( !QFile::rename(tmpFileName, ofxCacheFilePath) ) {
+        // Another process wrote the cache in the meantime
+        QFile::remove(tmpFileName);
+    }
 }
 
 void
@@ -1110,6 +1220,12 @@ OfxHost::loadingStatus(bool loading,
     _imp->loadingPluginID = pluginId;
     _imp->loadingPluginVersionMajor = versionMajor;
     _imp->loadingPluginVersionMinor = versionMinor;
+
+    // Close the event of the previous plug-in first
+    _imp->loadingPluginTrace.reset();
+    if ( loading && StartupTrace::isEnabled() ) {
+        _imp->loadingPluginTrace.reset( new StartupTrace::Scope_RAII(pluginId + " v" + QString::number(versionMajor).toStdString() + '.' + QString::number(versionMinor).toStdString(), "load", false) );
+    }
     if (loading && appPTR) {
         appPTR->setLoadingStatus( QString::fromUtf8("OpenFX: loading ") + QString::fromUtf8( pluginId.c_str() ) + QString::fromUtf8(" v") + QString::number(versionMajor) + QLatin1Char('.') + QString::number(versionMinor) );
 #     ifdef DEBUG
@@ -1164,9 +1280,15 @@ OfxHost::setOFXLastActionCaller_TLS(const OfxEffectInstancePtr& effect)
     OfxHostDataTLSPtr tls = _imp->tlsData->getOrCreateTLSData();
     if (effect) {
         tls->effectActionsStack.push_back(effect);
+        tls->actionIDsStack.push_back(++tls->nActionsCalled);
     } else {
         assert(!tls->effectActionsStack.empty());
         tls->effectActionsStack.pop_back();
+        tls->actionIDsStack.pop_back();
+        // The values computed during the nested action may differ from the ones of the calling action
+        if ( !tls->actionIDsStack.empty() ) {
+            tls->actionIDsStack.back() = ++tls->nActionsCalled;
+        }
     }
 
 }
@@ -1181,6 +1303,16 @@ OfxHost::getCurrentEffect_TLS() const
     return tls->effectActionsStack.back();
 }
 
+U64
+OfxHost::getCurrentActionID_TLS() const
+{
+    OfxHostDataTLSPtr tls = _imp->tlsData->getTLSData();
+    if (!tls || tls->actionIDsStack.empty()) {
+        return 0;
+    }
+    return tls->actionIDsStack.back();
+}
+
 struct OfxFunctorArgs
 {
     void* customArg;
@@ -167,9 +167,17 @@ public:
     struct OfxHostTLSData
     {
         std::list<OfxEffectInstancePtr> effectActionsStack;
-        
+
+        // The identifier of each action in effectActionsStack
+        std::list<U64> actionIDsStack;
+
+        // The number of actions called on this thread
+        U64 nActionsCalled;
+
         OfxHostTLSData()
         : effectActionsStack()
+        , actionIDsStack()
+        , nActionsCalled(0)
         {
         }
     };
@@ -178,6 +186,12 @@ public:
     
     OfxEffectInstancePtr getCurrentEffect_TLS() const;
 
+    /**
+     * @brief Returns an identifier of the action being called on this thread, unique for this thread,
+     * or 0 if no action is being called. Values computed for the plug-in may be kept until it changes.
+     **/
+    U64 getCurrentActionID_TLS() const;
+
 private:
 
     /*Writes all plugins loaded and their descriptors to
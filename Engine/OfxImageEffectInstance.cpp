@@ -128,6 +128,22 @@ OfxImageEffectInstance::mainEntry(const char *action,
                                   OFX::Host::Property::Set *inArgs,
                                   OFX::Host::Property::Set *outArgs)
 {
+    if ( inArgs && (std::strcmp(action, kOfxImageEffectActionRender) == 0) ) {
+        // The render action arguments of the CUDA render extension
+        OfxEffectInstancePtr effect = getOfxEffectInstance();
+        void* cudaStream = 0;
+        if ( effect && effect->isCudaRenderInProgress(&cudaStream) ) {
+            static const OFX::Host::Property::PropSpec cudaRenderArgsProps[] = {
+                { kOfxImageEffectPropCudaEnabled,  OFX::Host::Property::eInt,    1,    true,    "0" },
+                { kOfxImageEffectPropCudaStream,  OFX::Host::Property::ePointer,    1,    true,    NULL },
+                OFX::Host::Property::propSpecEnd
+            };
+            inArgs->addProperties(cudaRenderArgsProps);
+            inArgs->setIntProperty(kOfxImageEffectPropCudaEnabled, 1);
+            inArgs->setPointerProperty(kOfxImageEffectPropCudaStream, cudaStream);
+        }
+    }
+
     return OFX::Host::ImageEffect::Instance::mainEntry(action, handle, inArgs, outArgs);
 }
 
@@ -1308,15 +1324,35 @@ OfxImageEffectInstance::isInAnalysis() const
 
 #endif
 
+/**
+ * @brief Adds the properties of the GPU render extensions to a root descriptor so that the plug-in may set them.
+ * Context descriptors copy the properties of the root descriptor.
+ **/
+static void
+addGPURenderDescriptorProps(OFX::Host::Property::Set& props)
+{
+    static const OFX::Host::Property::PropSpec gpuRenderDescProps[] = {
+        { kOfxImageEffectPropCudaRenderSupported,  OFX::Host::Property::eString,    1,    false,    "false" },
+        { kOfxImageEffectPropCudaStreamSupported,  OFX::Host::Property::eString,    1,    false,    "false" },
+        { kOfxImageEffectPropOpenCLRenderSupported,  OFX::Host::Property::eString,    1,    false,    "false" },
+        { kOfxImageEffectPropMetalRenderSupported,  OFX::Host::Property::eString,    1,    false,    "false" },
+        OFX::Host::Property::propSpecEnd
+    };
+
+    props.addProperties(gpuRenderDescProps);
+}
+
 OfxImageEffectDescriptor::OfxImageEffectDescriptor(OFX::Host::Plugin *plug)
     : OFX::Host::ImageEffect::Descriptor(plug)
 {
+    addGPURenderDescriptorProps(getProps());
 }
 
 OfxImageEffectDescriptor::OfxImageEffectDescriptor(const std::string &bundlePath,
                                                    OFX::Host::Plugin *plug)
     : OFX::Host::ImageEffect::Descriptor(bundlePath, plug)
 {
+    addGPURenderDescriptorProps(getProps());
 }
 
 OfxImageEffectDescriptor::OfxImageEffectDescriptor(const OFX::Host::ImageEffect::Descriptor &rootContext,
@@ -51,6 +51,24 @@ CLANG_DIAG_ON(unknown-pragmas)
 
 #include "Engine/EngineFwd.h"
 
+// The CUDA render extension of OpenFX 1.5 (ofxGPURender.h), for the OpenFX headers that do not define it yet.
+// The plug-in sets kOfxImageEffectPropCudaRenderSupported to "false", "true" or "needed" on its descriptor, and
+// kOfxImageEffectPropCudaStreamSupported to "true" if it queues its work on the stream given in the render action
+// instead of synchronizing before it returns. When kOfxImageEffectPropCudaEnabled is set in the arguments of the render
+// action, the kOfxImagePropData of the images are addresses on the CUDA device.
+#ifndef kOfxImageEffectPropCudaRenderSupported
+#define kOfxImageEffectPropCudaRenderSupported "OfxImageEffectPropCudaRenderSupported"
+#define kOfxImageEffectPropCudaEnabled "OfxImageEffectPropCudaEnabled"
+#define kOfxImageEffectPropCudaStreamSupported "OfxImageEffectPropCudaStreamSupported"
+#define kOfxImageEffectPropCudaStream "OfxImageEffectPropCudaStream"
+#endif
+#ifndef kOfxImageEffectPropOpenCLRenderSupported
+#define kOfxImageEffectPropOpenCLRenderSupported "OfxImageEffectPropOpenCLRenderSupported"
+#endif
+#ifndef kOfxImageEffectPropMetalRenderSupported
+#define kOfxImageEffectPropMetalRenderSupported "OfxImageEffectPropMetalRenderSupported"
+#endif
+
 NATRON_NAMESPACE_ENTER;
 
 class OfxImageEffectInstance
@@ -32,6 +32,7 @@ CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_ON(deprecated)
 
 #include "Engine/EffectInstance.h"
+#include "Engine/MemoryAccount.h"
 
 NATRON_NAMESPACE_ENTER;
 
@@ -42,7 +43,9 @@ OfxMemory::OfxMemory(const EffectInstancePtr& effect)
     , _lock()
     , _lockedCount(0)
 {
-    
+    std::vector<MemoryAccountPtr> memoryAccounts;
+    MemoryAccount::getEffectAccounts(effect, &memoryAccounts);
+    setMemoryAccounts(memoryAccounts, eMemoryAccountTypePlugin);
 }
 
 OfxMemory::~OfxMemory()
@@ -4770,6 +4770,12 @@ OfxParametricInstance::getValue(int curveIndex,
         return kOfxStatErrBadHandle;
     }
     ViewIdx view = knob->getCurrentRenderView();
+
+    // Plug-ins may call this for each pixel: answer from the lookup table of the curve when possible
+    ParametricCurveLUTConstPtr lut = knob->getCurveLUT(DimIdx(curveIndex), view);
+    if ( lut && lut->getValueAt(parametricPosition, returnValue) ) {
+        return kOfxStatOK;
+    }
     ActionRetCodeEnum stat = knob->evaluateCurve(DimIdx(curveIndex), view, parametricPosition, returnValue);
 
     if (!isFailureRetCode(stat)) {
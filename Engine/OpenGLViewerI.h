@@ -115,7 +115,7 @@ public:
     virtual void updateColorPicker(int textureIndex, int x = INT_MAX, int y = INT_MAX) = 0;
 
     /**
-     * @brief Must use OpenGL to query the texture color at the given image coordinates
+     * @brief Must query the color of the displayed texture at the given image coordinates
      * X and Y are in canonical coordinates
      **/
     virtual void getTextureColorAt(int x, int y, double* r, double *g, double *b, double *a) = 0;
@@ -27,6 +27,7 @@
 #include <iostream>
 #include <set>
 #include <list>
+#include <map>
 #include <algorithm> // min, max
 #include <cassert>
 #include <stdexcept>
@@ -49,6 +50,10 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include <QtCore/QTextStream>
 #include <QtCore/QRunnable>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
 
 #include <QtConcurrentRun>
 
@@ -59,7 +64,11 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
+#include "Engine/Cache.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/EngineMetrics.h"
+#include "Engine/FrameEncodeQueue.h"
+#include "Engine/FrameStreamWriter.h"
 #include "Engine/FrameViewRequest.h"
 #include "Engine/ImageCacheKey.h"
 #include "Engine/Image.h"
@@ -67,10 +76,13 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/KnobFile.h"
 #include "Engine/Node.h"
 #include "Engine/KnobItemsTable.h"
+#include "Engine/MemoryInfo.h"
+#include "Engine/MultiThread.h"
 #include "Engine/OpenGLViewerI.h"
 #include "Global/FStreamsSupport.h"
 #include "Engine/GenericSchedulerThreadWatcher.h"
 #include "Engine/Project.h"
+#include "Engine/ReadNodePrefetcher.h"
 #include "Engine/RenderStats.h"
 #include "Engine/Settings.h"
 #include "Engine/Timer.h"
@@ -80,6 +92,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/RotoPaint.h"
 #include "Engine/RotoStrokeItem.h"
 #include "Engine/ViewIdx.h"
+#include "Engine/ViewerFlipbookCache.h"
 #include "Engine/ViewerNode.h"
 #include "Engine/ViewerInstance.h"
 #include "Engine/WriteNode.h"
@@ -93,6 +106,42 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 #define NATRON_SCHEDULER_ABORT_AFTER_X_UNSUCCESSFUL_ITERATIONS 5000
 
+// The maximum number of frames rendered concurrently by a scheduler with the eSchedulingPolicyFFA policy
+#define NATRON_SCHEDULER_MAX_FRAMES_IN_FLIGHT 16
+
+// When the tile cache is filled above this ratio of its maximum size or when the free RAM is below this ratio
+// of the total RAM, the scheduler renders less frames concurrently
+#define NATRON_SCHEDULER_LOOK_AHEAD_CACHE_QUOTA_RATIO 0.9
+#define NATRON_SCHEDULER_LOOK_AHEAD_MIN_FREE_RAM_RATIO 0.05
+
+// Rendering one more frame concurrently is kept only if it reduces the time between two rendered frames by this ratio
+#define NATRON_SCHEDULER_LOOK_AHEAD_MIN_GAIN 0.05
+
+// During real-time playback, the maximum number of mipmap levels added to the viewer mipmap level when the renders cannot keep up
+#define NATRON_PLAYBACK_MAX_EXTRA_MIPMAP_LEVELS 3
+
+// During real-time playback, a frame is rendered with less degradation if its render time is below this ratio of the frame duration.
+// A mipmap level has 4 times less pixels than the level below, hence 0.25
+#define NATRON_PLAYBACK_UPGRADE_RENDER_TIME_RATIO 0.25
+
+// Number of frames decoded ahead of the frame being rendered by the readers upstream of the output, see prefetchReadersAhead()
+#define NATRON_READ_PREFETCH_N_FRAMES 8
+
+// Number of frames whose asynchronous after frame render callback may wait to be run before the render threads block, see runAfterFrameRenderedCallback()
+#define NATRON_AFTER_FRAME_RENDER_CALLBACK_MAX_QUEUED_FRAMES 16
+
+// With progressive viewer renders, the number of mipmap levels above the viewer level of the draft render displayed first
+#define NATRON_VIEWER_PROGRESSIVE_DRAFT_MIPMAP_LEVELS 2
+
+// With progressive viewer renders, the full resolution render is launched when no other render was requested for this delay
+#define NATRON_VIEWER_PROGRESSIVE_REFINE_DELAY_MS 250
+
+// With progressive viewer renders, a draft is rendered first only if the last full resolution render took longer than this (in seconds)
+#define NATRON_VIEWER_PROGRESSIVE_MIN_RENDER_TIME 0.1
+
+// With idle caching, the frames around the current frame are rendered when no other render was requested for this delay
+#define NATRON_VIEWER_IDLE_CACHE_DELAY_MS 1000
+
 NATRON_NAMESPACE_ENTER;
 
 
@@ -181,6 +230,21 @@ struct OutputSchedulerThreadPrivate
     U64 nFramesRendered;
     bool renderFinished; //< set to true when nFramesRendered = runArgs->lastFrame - runArgs->firstFrame + 1
 
+    // Pipelined encoding, see FrameEncodeQueue. The number of frames whose input was rendered and queued to the
+    // encode stage, also protected by renderFinishedMutex
+    bool encodePipelineEnabled;
+    U64 nFramesRenderStageFinished;
+    boost::scoped_ptr<FrameEncodeQueue> encodeQueue;
+
+    // The checkpoint file listing the frames written by the renders of the output from the command line,
+    // so that an interrupted render can be resumed, see startCheckpoint()
+    mutable QMutex checkpointMutex;
+    QString checkpointFilePath;
+    bool checkpointStarted;
+
+    // The frames and views listed in the checkpoint file when resuming, with the size of their image
+    std::map<std::pair<double, int>, qint64> checkpointFrames;
+
     // Pointer to the args used in threadLoopOnce(), only usable from the scheduler thread
     boost::weak_ptr<OutputSchedulerThreadStartArgs> runArgs;
     
@@ -228,6 +292,75 @@ struct OutputSchedulerThreadPrivate
     mutable QMutex sequentialRenderQueueMutex;
     std::list<RenderSequenceArgs> sequentialRenderQueue;
 
+    // Adaptive look-ahead: with the eSchedulingPolicyFFA policy, the frames do not need to be rendered in order
+    // so several frames are rendered concurrently. Their number is adapted each time a frame is rendered, see updateLookAhead().
+    // Protects all look-ahead data
+    mutable QMutex lookAheadMutex;
+
+    // True if several frames can be rendered concurrently. This is set in startRender()
+    bool lookAheadEnabled;
+
+    // The number of frames to render concurrently
+    int framesInFlightTarget;
+
+    // The number of frames currently rendering
+    int nFramesInFlight;
+
+    // The number of frames rendered since framesInFlightTarget was changed and the average time between
+    // two rendered frames over these frames
+    int nFramesRenderedAtTarget;
+    TimeLapse frameIntervalTimer;
+    double averageFrameInterval;
+
+    // The target before the last increase and its average time between two rendered frames,
+    // or 0 if the target was not increased
+    int previousFramesInFlightTarget;
+    double previousAverageFrameInterval;
+
+    // The target above which rendering more frames concurrently did not render faster
+    int maxUsefulFramesInFlight;
+
+    // Real-time playback: when the frames cannot be rendered at the desired FPS, frames are degraded and dropped,
+    // see updatePlaybackDeadline(). Protects all playback deadline data
+    mutable QMutex playbackDeadlineMutex;
+
+    // True if frames may be degraded and dropped. This is set in startRender()
+    bool realTimePlayback;
+
+    // The average render time of the frames
+    double averagePlaybackRenderTime;
+
+    // See OutputSchedulerThread::getPlaybackDegradationLevel()
+    int playbackDegradationLevel;
+
+    // The number of frames rendered since playbackDegradationLevel was changed
+    int nFramesAtDegradationLevel;
+
+    // Read-ahead of the readers upstream of the output, see prefetchReadersAhead().
+    // Protects the prefetch frame range
+    mutable QMutex prefetchMutex;
+
+    // True if the readers may decode ahead. This is set in startRender()
+    bool prefetchEnabled;
+    TimeValue prefetchFirstFrame, prefetchLastFrame, prefetchFrameStep;
+
+    boost::scoped_ptr<ReadNodePrefetcher> readersPrefetcher;
+
+    // Protects the data below
+    QMutex afterFrameRenderCallbacksMutex;
+
+    // Woken up when a callback is taken out of the queue and when the callback thread returns
+    QWaitCondition afterFrameRenderCallbacksCond;
+
+    // The frames whose asynchronous after frame render callback is waiting to be run, in the order they were rendered
+    std::list<TimeValue> afterFrameRenderCallbacksQueue;
+
+    // True while a runnable is running the queued callbacks on afterFrameRenderCallbackThread
+    bool afterFrameRenderCallbackThreadActive;
+
+    // A single thread runs the asynchronous callbacks, in order
+    QThreadPool afterFrameRenderCallbackThread;
+
 
     OutputSchedulerThreadPrivate(RenderEngine* engine,
                                  OutputSchedulerThread* publicInterface,
@@ -243,6 +376,13 @@ struct OutputSchedulerThreadPrivate
         , renderFinishedMutex()
         , nFramesRendered(0)
         , renderFinished(false)
+        , encodePipelineEnabled(false)
+        , nFramesRenderStageFinished(0)
+        , encodeQueue( new FrameEncodeQueue(publicInterface) )
+        , checkpointMutex()
+        , checkpointFilePath()
+        , checkpointStarted(false)
+        , checkpointFrames()
         , runArgs()
         , lastRunArgsMutex()
         , lastPlaybackViewsToRender()
@@ -260,7 +400,68 @@ struct OutputSchedulerThreadPrivate
         , lastBufferedOutputSize(0)
         , sequentialRenderQueueMutex()
         , sequentialRenderQueue()
+        , lookAheadMutex()
+        , lookAheadEnabled(false)
+        , framesInFlightTarget(1)
+        , nFramesInFlight(0)
+        , nFramesRenderedAtTarget(0)
+        , frameIntervalTimer()
+        , averageFrameInterval(0)
+        , previousFramesInFlightTarget(0)
+        , previousAverageFrameInterval(0)
+        , maxUsefulFramesInFlight(NATRON_SCHEDULER_MAX_FRAMES_IN_FLIGHT)
+        , playbackDeadlineMutex()
+        , realTimePlayback(false)
+        , averagePlaybackRenderTime(0)
+        , playbackDegradationLevel(0)
+        , nFramesAtDegradationLevel(0)
+        , prefetchMutex()
+        , prefetchEnabled(false)
+        , prefetchFirstFrame(0)
+        , prefetchLastFrame(0)
+        , prefetchFrameStep(1)
+        , readersPrefetcher(new ReadNodePrefetcher)
+        , afterFrameRenderCallbacksMutex()
+        , afterFrameRenderCallbacksCond()
+        , afterFrameRenderCallbacksQueue()
+        , afterFrameRenderCallbackThreadActive(false)
+        , afterFrameRenderCallbackThread()
+    {
+        afterFrameRenderCallbackThread.setMaxThreadCount(1);
+    }
+
+    /**
+     * @brief Run the queued asynchronous after frame render callbacks until the queue is empty
+     **/
+    void runQueuedAfterFrameRenderCallbacks();
+
+    /**
+     * @brief Waits for the queued asynchronous after frame render callbacks to be run.
+     * If dropQueued is true, the callbacks that did not start yet are not run.
+     **/
+    void waitForAfterFrameRenderCallbacks(bool dropQueued);
+
+    void resetPlaybackDeadline(bool enabled)
     {
+        QMutexLocker k(&playbackDeadlineMutex);
+        realTimePlayback = enabled;
+        averagePlaybackRenderTime = 0;
+        playbackDegradationLevel = 0;
+        nFramesAtDegradationLevel = 0;
+    }
+
+    int updatePlaybackDeadline(double frameRenderTime);
+
+    void resetLookAhead(bool enabled);
+
+    bool isMemoryNearQuota() const;
+
+    void updateLookAhead(double frameRenderTime);
+
+    bool canStartFrame() const
+    {
+        QMutexLocker k(&lookAheadMutex);
+        return !lookAheadEnabled || nFramesInFlight < framesInFlightTarget;
     }
 
     void validateRenderSequenceArgs(RenderSequenceArgs& args) const;
@@ -308,7 +509,7 @@ struct OutputSchedulerThreadPrivate
         // Instead we explicitly manage them and ensure they do not hold any external strong refs.
         runnable->setAutoDelete(false);
         renderThreads.push_back(r);
-        QThreadPool::globalInstance()->start(runnable.get());
+        QThreadPool::globalInstance()->start( runnable.get(), (int)_publicInterface->getRenderPriority() );
     }
 
     RenderThreads::iterator getRunnableIterator(RenderThreadTask* runnable)
@@ -370,6 +571,65 @@ struct OutputSchedulerThreadPrivate
     }
 };
 
+class AfterFrameRenderCallbackRunnable
+    : public QRunnable
+{
+    OutputSchedulerThreadPrivate* _imp;
+
+public:
+
+    AfterFrameRenderCallbackRunnable(OutputSchedulerThreadPrivate* imp)
+        : QRunnable()
+        , _imp(imp)
+    {
+        setAutoDelete(true);
+    }
+
+    virtual ~AfterFrameRenderCallbackRunnable()
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        _imp->runQueuedAfterFrameRenderCallbacks();
+    }
+};
+
+void
+OutputSchedulerThreadPrivate::runQueuedAfterFrameRenderCallbacks()
+{
+    for (;;) {
+        TimeValue frame;
+        {
+            QMutexLocker k(&afterFrameRenderCallbacksMutex);
+            if ( afterFrameRenderCallbacksQueue.empty() ) {
+                afterFrameRenderCallbackThreadActive = false;
+                afterFrameRenderCallbacksCond.wakeAll();
+
+                return;
+            }
+            frame = afterFrameRenderCallbacksQueue.front();
+            afterFrameRenderCallbacksQueue.pop_front();
+            afterFrameRenderCallbacksCond.wakeAll();
+        }
+        _publicInterface->runAfterFrameRenderedCallbackNow(frame);
+    }
+}
+
+void
+OutputSchedulerThreadPrivate::waitForAfterFrameRenderCallbacks(bool dropQueued)
+{
+    QMutexLocker k(&afterFrameRenderCallbacksMutex);
+    if (dropQueued) {
+        afterFrameRenderCallbacksQueue.clear();
+        afterFrameRenderCallbacksCond.wakeAll();
+    }
+    while (afterFrameRenderCallbackThreadActive) {
+        afterFrameRenderCallbacksCond.wait(&afterFrameRenderCallbacksMutex);
+    }
+}
+
+
 OutputSchedulerThread::OutputSchedulerThread(RenderEngine* engine,
                                              const NodePtr& effect,
                                              ProcessFrameModeEnum mode)
@@ -380,10 +640,13 @@ OutputSchedulerThread::OutputSchedulerThread(RenderEngine* engine,
 
 
     setThreadName("Scheduler thread");
+
+    EngineMetrics::registerScheduler(this);
 }
 
 OutputSchedulerThread::~OutputSchedulerThread()
 {
+    EngineMetrics::unregisterScheduler(this);
 
     // Make sure all tasks are finished, there will be a deadlock here if that's not the case.
     _imp->waitForRenderThreadsToQuit();
@@ -501,11 +764,156 @@ OutputSchedulerThreadPrivate::getNearestInSequence(RenderDirectionEnum direction
     }
 }
 
+void
+OutputSchedulerThreadPrivate::resetLookAhead(bool enabled)
+{
+    QMutexLocker k(&lookAheadMutex);
+    lookAheadEnabled = enabled;
+    nFramesInFlight = 0;
+    nFramesRenderedAtTarget = 0;
+    averageFrameInterval = 0;
+    previousFramesInFlightTarget = 0;
+    previousAverageFrameInterval = 0;
+    maxUsefulFramesInFlight = std::max(1, std::min(appPTR->getHardwareIdealThreadCount(), NATRON_SCHEDULER_MAX_FRAMES_IN_FLIGHT));
+
+    // Do not leave cores idle while measuring the first frames
+    framesInFlightTarget = (enabled && !isMemoryNearQuota()) ? std::min(2, maxUsefulFramesInFlight) : 1;
+    frameIntervalTimer.reset();
+}
+
+bool
+OutputSchedulerThreadPrivate::isMemoryNearQuota() const
+{
+    // Rendering more frames while the tile cache is full would evict the tiles of the frames being rendered
+    CacheBasePtr tileCache = appPTR->getTileCache();
+    if (tileCache) {
+        std::size_t maxSize = tileCache->getMaximumCacheSize();
+        if (maxSize > 0 && tileCache->getCurrentSize() >= maxSize * NATRON_SCHEDULER_LOOK_AHEAD_CACHE_QUOTA_RATIO) {
+            return true;
+        }
+    }
+    U64 totalRAM = getSystemTotalRAM();
+    if (totalRAM > 0 && getAmountFreePhysicalRAM() < totalRAM * NATRON_SCHEDULER_LOOK_AHEAD_MIN_FREE_RAM_RATIO) {
+        return true;
+    }
+    return false;
+} // isMemoryNearQuota
+
+void
+OutputSchedulerThreadPrivate::updateLookAhead(double frameRenderTime)
+{
+    QMutexLocker k(&lookAheadMutex);
+    if (!lookAheadEnabled) {
+        return;
+    }
+    --nFramesInFlight;
+
+    // The time between two rendered frames is what the render throughput depends on, whereas the render time of a frame
+    // increases with the number of frames rendered concurrently.
+    // The first frame rendered at a new target was started at the previous one: use its render time instead.
+    double frameInterval = frameIntervalTimer.getTimeElapsedReset();
+    if (nFramesRenderedAtTarget == 0) {
+        frameInterval = frameRenderTime / std::max(1, framesInFlightTarget);
+    }
+    averageFrameInterval = (averageFrameInterval * nFramesRenderedAtTarget + frameInterval) / (nFramesRenderedAtTarget + 1);
+    ++nFramesRenderedAtTarget;
+
+    // Back-pressure: render less frames concurrently before the cache starts evicting or the system swaps
+    if (isMemoryNearQuota()) {
+        if (framesInFlightTarget > 1) {
+            --framesInFlightTarget;
+            maxUsefulFramesInFlight = framesInFlightTarget;
+            previousFramesInFlightTarget = 0;
+            nFramesRenderedAtTarget = 0;
+        }
+        return;
+    }
+
+    // Wait for enough frames rendered at this target to have a meaningful measure
+    if (nFramesRenderedAtTarget < std::max(2, framesInFlightTarget)) {
+        return;
+    }
+
+    if (previousFramesInFlightTarget > 0 && averageFrameInterval > previousAverageFrameInterval * (1. - NATRON_SCHEDULER_LOOK_AHEAD_MIN_GAIN)) {
+        // The last increase did not render faster: go back to the previous target and stop increasing
+        framesInFlightTarget = previousFramesInFlightTarget;
+        maxUsefulFramesInFlight = framesInFlightTarget;
+        previousFramesInFlightTarget = 0;
+        nFramesRenderedAtTarget = 0;
+        return;
+    }
+
+    // Render one more frame concurrently only if some threads of the pool are idle
+    QThreadPool* threadPool = QThreadPool::globalInstance();
+    if (framesInFlightTarget < maxUsefulFramesInFlight && threadPool->activeThreadCount() < threadPool->maxThreadCount()) {
+        previousFramesInFlightTarget = framesInFlightTarget;
+        previousAverageFrameInterval = averageFrameInterval;
+        ++framesInFlightTarget;
+        nFramesRenderedAtTarget = 0;
+    }
+#ifdef TRACE_SCHEDULER
+    qDebug() << "Scheduler Thread: rendering" << framesInFlightTarget << "frames concurrently, average time between frames:" << averageFrameInterval;
+#endif
+} // updateLookAhead
+
+/**
+ * @brief Called by the scheduler thread for each frame played during playback with the time it took to render.
+ * If the frames cannot be rendered in the duration of a frame at the desired FPS, the next frames are degraded.
+ * @returns The number of frames to drop after this one so that the next frame displayed is the one
+ * due when it is rendered.
+ **/
+int
+OutputSchedulerThreadPrivate::updatePlaybackDeadline(double frameRenderTime)
+{
+    QMutexLocker k(&playbackDeadlineMutex);
+    if (!realTimePlayback) {
+        return 0;
+    }
+    double fps = timer->getDesiredFrameRate();
+    if (fps <= 0) {
+        return 0;
+    }
+    const double frameDuration = 1. / fps;
+
+    // Give as much weight to the last frame as to the previous ones so that the average follows the degradation level quickly
+    if (nFramesAtDegradationLevel == 0) {
+        averagePlaybackRenderTime = frameRenderTime;
+    } else {
+        averagePlaybackRenderTime = (averagePlaybackRenderTime + frameRenderTime) / 2.;
+    }
+    ++nFramesAtDegradationLevel;
+
+    // Wait for a frame rendered at the current level before changing it again
+    if (nFramesAtDegradationLevel >= 2) {
+        if (averagePlaybackRenderTime > frameDuration && playbackDegradationLevel < NATRON_PLAYBACK_MAX_EXTRA_MIPMAP_LEVELS + 1) {
+            ++playbackDegradationLevel;
+            nFramesAtDegradationLevel = 0;
+        } else if (averagePlaybackRenderTime < frameDuration * NATRON_PLAYBACK_UPGRADE_RENDER_TIME_RATIO && playbackDegradationLevel > 0) {
+            --playbackDegradationLevel;
+            nFramesAtDegradationLevel = 0;
+        }
+    }
+#ifdef TRACE_SCHEDULER
+    qDebug() << "Scheduler Thread: average render time" << averagePlaybackRenderTime << "degradation level" << playbackDegradationLevel;
+#endif
+
+    // While the renders are late, skip the frames that would be late anyway
+    if (frameRenderTime <= frameDuration) {
+        return 0;
+    }
+    return (int)std::ceil(frameRenderTime / frameDuration) - 1;
+} // updatePlaybackDeadline
+
 
 void
 OutputSchedulerThread::startTasksFromLastStartedFrame()
 {
 
+    // Enough frames are already rendering, the next frame will be started when one of them is done
+    if (!_imp->canStartFrame()) {
+        return;
+    }
+
     TimeValue frame;
     bool canContinue;
 
@@ -547,6 +955,12 @@ OutputSchedulerThread::startTasks(TimeValue startingFrame)
     PlaybackModeEnum pMode = _imp->engine->getPlaybackMode();
     if (args->firstFrame == args->lastFrame) {
         boost::shared_ptr<RenderThreadTask> task(createRunnable(startingFrame, args->enableRenderStats, args->viewsToRender));
+        {
+            QMutexLocker k(&_imp->lookAheadMutex);
+            if (_imp->lookAheadEnabled) {
+                ++_imp->nFramesInFlight;
+            }
+        }
         {
             QMutexLocker k(&_imp->renderThreadsMutex);
             _imp->startRunnable(task);
@@ -555,8 +969,15 @@ OutputSchedulerThread::startTasks(TimeValue startingFrame)
         _imp->lastFrameRequested = startingFrame;
     } else {
 
-        // For now just run one frame concurrently, it is better to try to render one frame the fastest
-        const int nConcurrentFrames = 1;
+        // Unless the frames must be rendered in order, fill the look-ahead window. Otherwise just run one frame
+        // concurrently, it is better to try to render one frame the fastest
+        int nConcurrentFrames = 1;
+        {
+            QMutexLocker k(&_imp->lookAheadMutex);
+            if (_imp->lookAheadEnabled) {
+                nConcurrentFrames = std::max(1, _imp->framesInFlightTarget - _imp->nFramesInFlight);
+            }
+        }
 
         TimeValue frame = startingFrame;
         RenderDirectionEnum newDirection = args->direction;
@@ -564,6 +985,12 @@ OutputSchedulerThread::startTasks(TimeValue startingFrame)
         for (int i = 0; i < nConcurrentFrames; ++i) {
 
             boost::shared_ptr<RenderThreadTask> task(createRunnable(frame, args->enableRenderStats, args->viewsToRender));
+            {
+                QMutexLocker k(&_imp->lookAheadMutex);
+                if (_imp->lookAheadEnabled) {
+                    ++_imp->nFramesInFlight;
+                }
+            }
             {
                 QMutexLocker k(&_imp->renderThreadsMutex);
                 _imp->startRunnable(task);
@@ -642,7 +1069,35 @@ OutputSchedulerThread::startRender()
         }
     }
     SequentialPreferenceEnum pref = node->getEffectInstance()->getSequentialPreference();
-    if ( (pref == eSequentialPreferenceOnlySequential) || (pref == eSequentialPreferencePreferSequential) ) {
+
+    // Frames can be rendered concurrently only if the output does not need them in order
+    _imp->resetLookAhead(getSchedulingPolicy() == eSchedulingPolicyFFA && pref == eSequentialPreferenceNotSequential);
+
+    _imp->resetPlaybackDeadline(isFPSRegulationNeeded() && appPTR->getCurrentSettings()->isRealTimePlaybackEnabled());
+
+    // When rendering on disk, the writer encodes each frame while the next ones render.
+    // Video writers need the frames in order: they are encoded one at a time.
+    {
+        // Extra outputs are rendered in the same TreeRender as the output, which the encode stage does not do
+        bool encodePipelineEnabled = getSchedulingPolicy() == eSchedulingPolicyFFA && node->getEffectInstance()->isWriter() && getEngine()->getExtraOutputNodes().empty();
+        if (encodePipelineEnabled) {
+            _imp->encodeQueue->start(pref != eSequentialPreferenceNotSequential || node->getEffectInstance()->isVideoWriter());
+        }
+        QMutexLocker k(&_imp->renderFinishedMutex);
+        _imp->encodePipelineEnabled = encodePipelineEnabled;
+        _imp->nFramesRenderStageFinished = 0;
+    }
+
+    {
+        QMutexLocker k(&_imp->prefetchMutex);
+        _imp->prefetchEnabled = firstFrame != lastFrame;
+        _imp->prefetchFirstFrame = firstFrame;
+        _imp->prefetchLastFrame = lastFrame;
+        _imp->prefetchFrameStep = frameStep;
+    }
+
+    // When the frames are streamed, the writer does not write anything
+    if ( !_imp->engine->getFrameStreamWriter() && ( (pref == eSequentialPreferenceOnlySequential) || (pref == eSequentialPreferencePreferSequential) ) ) {
         RenderScale scaleOne(1.);
         ActionRetCodeEnum stat = node->getEffectInstance()->beginSequenceRender_public(firstFrame,
                                                                                        lastFrame,
@@ -669,6 +1124,8 @@ OutputSchedulerThread::startRender()
         _imp->schedulerRenderDirection = direction;
     }
 
+    startCheckpoint();
+
     startTasks(startingFrame);
 
 
@@ -682,6 +1139,22 @@ OutputSchedulerThread::stopRender()
     // Remove all current threads so the new render doesn't have many threads concurrently trying to do the same thing at the same time
     _imp->waitForRenderThreadsToQuit();
 
+    {
+        QMutexLocker k(&_imp->prefetchMutex);
+        _imp->prefetchEnabled = false;
+    }
+    _imp->readersPrefetcher->stop();
+
+    // The frames still waiting to be encoded were aborted
+    _imp->encodeQueue->stop();
+
+    // Run the after frame render callbacks of all rendered frames before notifying that the render is finished
+    _imp->waitForAfterFrameRenderCallbacks( isBeingAborted() );
+    {
+        QMutexLocker k(&_imp->renderFinishedMutex);
+        _imp->encodePipelineEnabled = false;
+    }
+
     ///If the output effect is sequential (only WriteFFMPEG for now)
     NodePtr node = _imp->outputEffect.lock();
     WriteNodePtr isWrite = toWriteNode( node->getEffectInstance() );
@@ -692,7 +1165,7 @@ OutputSchedulerThread::stopRender()
         }
     }
     SequentialPreferenceEnum pref = node->getEffectInstance()->getSequentialPreference();
-    if ( (pref == eSequentialPreferenceOnlySequential) || (pref == eSequentialPreferencePreferSequential) ) {
+    if ( !_imp->engine->getFrameStreamWriter() && ( (pref == eSequentialPreferenceOnlySequential) || (pref == eSequentialPreferencePreferSequential) ) ) {
         TimeValue firstFrame, lastFrame, frameStep;
 
         {
@@ -873,6 +1346,34 @@ OutputSchedulerThread::threadLoopOnce(const GenericThreadStartArgsPtr &inArgs)
                                                                                            lastFrame, frameStep, &nextFrameToRender, &newDirection);
                 }
 
+                // If the renders are late on the playback, skip frames so that the next frame rendered is the one
+                // that should be displayed when it is done rendering. The last frame of the range is never dropped.
+                int nFramesToDrop = _imp->updatePlaybackDeadline(framesToRender->frames->renderTime);
+                if (!renderFinished && nFramesToDrop > 0) {
+                    TimeValue frameBeforeNext = expectedTimeToRender;
+                    RenderDirectionEnum directionBeforeNext = timelineDirection;
+                    for (int i = 0; i < nFramesToDrop; ++i) {
+                        TimeValue frame;
+                        RenderDirectionEnum direction;
+                        if ( !OutputSchedulerThreadPrivate::getNextFrameInSequence(pMode, newDirection, nextFrameToRender, firstFrame,
+                                                                                   lastFrame, frameStep, &frame, &direction) ) {
+                            break;
+                        }
+                        frameBeforeNext = nextFrameToRender;
+                        directionBeforeNext = newDirection;
+                        nextFrameToRender = frame;
+                        newDirection = direction;
+                    }
+
+                    // Only one frame is rendered at a time during playback: pretend the frame before the next one was requested
+                    // so that startTasksFromLastStartedFrame() requests the next frame
+                    {
+                        QMutexLocker k(&_imp->lastFrameRequestedMutex);
+                        _imp->lastFrameRequested = frameBeforeNext;
+                    }
+                    args->direction = directionBeforeNext;
+                }
+
                 if (newDirection != timelineDirection) {
                     _imp->schedulerRenderDirection = newDirection;
                 }
@@ -977,6 +1478,14 @@ OutputSchedulerThread::onAbortRequested(bool /*keepOldestRender*/)
             it->runnable->abortRender();
         }
     }
+    _imp->encodeQueue->abort();
+
+    // The after frame render callbacks that did not start yet are not run
+    {
+        QMutexLocker k(&_imp->afterFrameRenderCallbacksMutex);
+        _imp->afterFrameRenderCallbacksQueue.clear();
+        _imp->afterFrameRenderCallbacksCond.wakeAll();
+    }
 
     // If the scheduler is asleep waiting for the buffer to be filling up, we post a fake request
     // that will not be processed anyway because the first thing it does is checking for abort
@@ -1002,6 +1511,8 @@ OutputSchedulerThread::notifyFrameRendered(const BufferedFrameContainerPtr& fram
 
     // This function only supports
 
+    EngineMetrics::addFrameRendered(frameContainer->renderTime);
+
     // Report render stats if desired
     NodePtr effect = _imp->outputEffect.lock();
     for (std::list<BufferedFramePtr>::const_iterator it = frameContainer->frames.begin(); it != frameContainer->frames.end(); ++it) {
@@ -1021,6 +1532,10 @@ OutputSchedulerThread::notifyFrameRendered(const BufferedFrameContainerPtr& fram
     U64 nbFramesRendered;
     //bool renderingIsFinished = false;
     if (policy == eSchedulingPolicyFFA) {
+        // The look-ahead was updated when the input of the frame was rendered
+        if (!frameContainer->renderStageNotified) {
+            _imp->updateLookAhead(frameContainer->renderTime);
+        }
         {
             QMutexLocker l(&_imp->renderFinishedMutex);
             ++_imp->nFramesRendered;
@@ -1030,7 +1545,9 @@ OutputSchedulerThread::notifyFrameRendered(const BufferedFrameContainerPtr& fram
 
 
             if (_imp->nFramesRendered != nbTotalFrames) {
-                startTasksFromLastStartedFrame();
+                if (!frameContainer->renderStageNotified) {
+                    startTasksFromLastStartedFrame();
+                }
             } else {
                 _imp->renderFinished = true;
                 l.unlock();
@@ -1107,6 +1624,213 @@ OutputSchedulerThread::notifyFrameRendered(const BufferedFrameContainerPtr& fram
 
 } // OutputSchedulerThread::notifyFrameRendered
 
+void
+OutputSchedulerThread::notifyFrameRenderStageFinished(double renderTime)
+{
+    _imp->updateLookAhead(renderTime);
+
+    OutputSchedulerThreadStartArgsPtr runArgs = _imp->runArgs.lock();
+    assert(runArgs);
+
+    QMutexLocker l(&_imp->renderFinishedMutex);
+    ++_imp->nFramesRenderStageFinished;
+    U64 nbTotalFrames = std::ceil( (double)(runArgs->lastFrame - runArgs->firstFrame + 1) / runArgs->frameStep );
+    if (_imp->nFramesRenderStageFinished < nbTotalFrames) {
+        startTasksFromLastStartedFrame();
+    }
+}
+
+FrameEncodeQueue*
+OutputSchedulerThread::getFrameEncodeQueue() const
+{
+    QMutexLocker l(&_imp->renderFinishedMutex);
+    return _imp->encodePipelineEnabled ? _imp->encodeQueue.get() : 0;
+}
+
+/**
+ * @brief Returns the file written by the writer for the given frame and view, and the file next to it storing its hash.
+ * Returns false if the writer does not write a file per frame.
+ **/
+static bool
+getFrameHashFilePaths(const NodePtr& writer,
+                      TimeValue time,
+                      ViewIdx view,
+                      QString* imageFilePath,
+                      QString* hashFilePath)
+{
+    EffectInstancePtr encoder = writer->getEffectInstance();
+    {
+        WriteNodePtr isWrite = toWriteNode(encoder);
+        if (isWrite) {
+            NodePtr embeddedWriter = isWrite->getEmbeddedWriter();
+            if (embeddedWriter) {
+                encoder = embeddedWriter->getEffectInstance();
+            }
+        }
+    }
+    if ( !encoder->isWriter() || encoder->isVideoWriter() || (encoder->getSequentialPreference() != eSequentialPreferenceNotSequential) ) {
+        return false;
+    }
+    KnobFilePtr fileKnob = toKnobFile( writer->getKnobByName(kOfxImageEffectFileParamName) );
+    if (!fileKnob) {
+        return false;
+    }
+    *imageFilePath = QString::fromUtf8( SequenceParsing::generateFileNameFromPattern(fileKnob->getValue(DimIdx(0), view), writer->getApp()->getProject()->getProjectViewNames(), time, view).c_str() );
+    if ( imageFilePath->isEmpty() ) {
+        return false;
+    }
+
+    // Same naming as the render statistics file, see RenderEngine::reportStats()
+    *hashFilePath = *imageFilePath;
+    QtCompat::removeFileExtension(*hashFilePath);
+    hashFilePath->append( QString::fromUtf8("-hash.txt") );
+
+    return true;
+}
+
+static QString
+getFrameHashString(const NodePtr& writer,
+                   TimeValue time,
+                   ViewIdx view)
+{
+    HashableObject::ComputeHashArgs hashArgs;
+    hashArgs.time = time;
+    hashArgs.view = view;
+    hashArgs.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+
+    return QString::number(writer->getEffectInstance()->computeHash(hashArgs), 16);
+}
+
+void
+OutputSchedulerThread::startCheckpoint()
+{
+    QMutexLocker k(&_imp->checkpointMutex);
+
+    _imp->checkpointFilePath.clear();
+
+    // Only the renders from the command line are checkpointed: the render farms restart them
+    NodePtr writer = _imp->outputEffect.lock();
+    if ( !appPTR->isBackground() || !writer || _imp->engine->getFrameStreamWriter() ) {
+        return;
+    }
+    QString imageFilePath, hashFilePath;
+    if ( !getFrameHashFilePaths(writer, TimeValue(0), ViewIdx(0), &imageFilePath, &hashFilePath) ) {
+        return;
+    }
+
+    // One file per writer, named after the pattern of its output files
+    KnobFilePtr fileKnob = toKnobFile( writer->getKnobByName(kOfxImageEffectFileParamName) );
+    assert(fileKnob);
+    QString checkpointFilePath = QString::fromUtf8( fileKnob->getValue().c_str() );
+    QtCompat::removeFileExtension(checkpointFilePath);
+    checkpointFilePath.append( QString::fromUtf8("-checkpoint.txt") );
+    _imp->checkpointFilePath = checkpointFilePath;
+
+    // The frame ranges rendered by this output in this process add to the same checkpoint
+    if (_imp->checkpointStarted) {
+        return;
+    }
+    _imp->checkpointStarted = true;
+    _imp->checkpointFrames.clear();
+    if ( !_imp->engine->isResumeEnabled() ) {
+        QFile::remove(checkpointFilePath);
+
+        return;
+    }
+
+    // Each line is: <frame> <view> <size of the image in bytes>
+    QFile checkpointFile(checkpointFilePath);
+    if ( !checkpointFile.open(QIODevice::ReadOnly) ) {
+        return;
+    }
+    while ( !checkpointFile.atEnd() ) {
+        QStringList fields = QString::fromUtf8( checkpointFile.readLine().trimmed() ).split( QChar::fromLatin1(' ') );
+        if (fields.size() != 3) {
+            // The process may have been killed while writing the last line
+            continue;
+        }
+        bool timeOk, viewOk, sizeOk;
+        double time = fields[0].toDouble(&timeOk);
+        int view = fields[1].toInt(&viewOk);
+        qint64 size = fields[2].toLongLong(&sizeOk);
+        if (timeOk && viewOk && sizeOk) {
+            _imp->checkpointFrames[std::make_pair(time, view)] = size;
+        }
+    }
+} // startCheckpoint
+
+void
+OutputSchedulerThread::removeUpToDateViews(const NodePtr& writer,
+                                           TimeValue time,
+                                           std::vector<ViewIdx>* views) const
+{
+    // A stream needs all the frames
+    if ( !writer || _imp->engine->getFrameStreamWriter() ) {
+        return;
+    }
+    bool incremental = _imp->engine->isIncrementalRenderEnabled();
+    for (std::vector<ViewIdx>::iterator it = views->begin(); it != views->end();) {
+        QString imageFilePath, hashFilePath;
+        bool upToDate = false;
+        if ( getFrameHashFilePaths(writer, time, *it, &imageFilePath, &hashFilePath) && QFile::exists(imageFilePath) ) {
+            // A frame of the interrupted render is complete if its image has the size it had when it was written
+            {
+                QMutexLocker k(&_imp->checkpointMutex);
+                std::map<std::pair<double, int>, qint64>::const_iterator found = _imp->checkpointFrames.find( std::make_pair( (double)time, (int)*it ) );
+                upToDate = found != _imp->checkpointFrames.end() && QFileInfo(imageFilePath).size() == found->second;
+            }
+            if (!upToDate && incremental) {
+                QFile hashFile(hashFilePath);
+                if ( hashFile.open(QIODevice::ReadOnly) ) {
+                    upToDate = QString::fromUtf8( hashFile.readAll().trimmed() ) == getFrameHashString(writer, time, *it);
+                }
+            }
+        }
+        if (upToDate) {
+            it = views->erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void
+OutputSchedulerThread::onFrameWritten(const NodePtr& writer,
+                                      TimeValue time,
+                                      const std::vector<ViewIdx>& views) const
+{
+    if ( !writer || _imp->engine->getFrameStreamWriter() ) {
+        return;
+    }
+    bool incremental = _imp->engine->isIncrementalRenderEnabled();
+    for (std::vector<ViewIdx>::const_iterator it = views.begin(); it != views.end(); ++it) {
+        QString imageFilePath, hashFilePath;
+        if ( !getFrameHashFilePaths(writer, time, *it, &imageFilePath, &hashFilePath) ) {
+            continue;
+        }
+        if (incremental) {
+            QFile hashFile(hashFilePath);
+            if ( hashFile.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+                hashFile.write( getFrameHashString(writer, time, *it).toUtf8() );
+            }
+        }
+
+        QMutexLocker k(&_imp->checkpointMutex);
+        if ( _imp->checkpointFilePath.isEmpty() ) {
+            continue;
+        }
+        QFileInfo imageInfo(imageFilePath);
+        if ( !imageInfo.exists() ) {
+            continue;
+        }
+        QFile checkpointFile(_imp->checkpointFilePath);
+        if ( checkpointFile.open(QIODevice::WriteOnly | QIODevice::Append) ) {
+            QString line = QString::fromUtf8("%1 %2 %3\n").arg( (double)time ).arg( (int)*it ).arg( imageInfo.size() );
+            checkpointFile.write( line.toUtf8() );
+        }
+    }
+} // onFrameWritten
+
 void
 OutputSchedulerThread::appendToBuffer(const BufferedFrameContainerPtr& frame)
 {
@@ -1413,6 +2137,10 @@ OutputSchedulerThread::notifyRenderFailure(ActionRetCodeEnum stat, const std::st
 
     assert(args);
 
+    if (stat != eActionStatusAborted) {
+        EngineMetrics::addRenderFailure();
+    }
+
     std::string message = errorMessage;
     if (message.empty()) {
         if (stat == eActionStatusFailed) {
@@ -1454,7 +2182,58 @@ OutputSchedulerThread::getNActiveRenderThreads() const
     return _imp->getNActiveRenderThreads();
 }
 
+int
+OutputSchedulerThread::getPlaybackDegradationLevel() const
+{
+    QMutexLocker k(&_imp->playbackDeadlineMutex);
+    return _imp->playbackDegradationLevel;
+}
+
+
+
+void
+OutputSchedulerThread::prefetchReadersAhead(const NodePtr& treeRoot,
+                                            TimeValue time,
+                                            const std::vector<ViewIdx>& viewsToRender,
+                                            unsigned int mipMapLevel,
+                                            bool draftMode)
+{
+    RenderDirectionEnum direction;
+    {
+        QMutexLocker k(&_imp->lastFrameRequestedMutex);
+        direction = _imp->schedulerRenderDirection;
+    }
+    PlaybackModeEnum pMode = _imp->engine->getPlaybackMode();
+
+    std::list<TimeValue> frames;
+    {
+        QMutexLocker k(&_imp->prefetchMutex);
+        if (!_imp->prefetchEnabled) {
+            return;
+        }
+        TimeValue frame = time;
+        for (int i = 0; i < NATRON_READ_PREFETCH_N_FRAMES; ++i) {
+            if ( !OutputSchedulerThreadPrivate::getNextFrameInSequence(pMode, direction, frame, _imp->prefetchFirstFrame, _imp->prefetchLastFrame,
+                                                                       _imp->prefetchFrameStep, &frame, &direction) ) {
+                break;
+            }
+            // Stop when looping back to the frame being rendered or when stepping out of the range
+            if ( (frame == time) || (frame < _imp->prefetchFirstFrame) || (frame > _imp->prefetchLastFrame) ) {
+                break;
+            }
+            frames.push_back(frame);
+        }
+    }
+
+    // Decoded frames that do not fit in the cache would evict the tiles of the frames being rendered
+    if ( frames.empty() || _imp->isMemoryNearQuota() ) {
+        return;
+    }
+    _imp->readersPrefetcher->prefetch(treeRoot, time, frames, viewsToRender, mipMapLevel, draftMode, getRenderPriority());
 
+    // The frames of the videos are decoded in order by the prefetcher
+    _imp->readersPrefetcher->waitForVideoFrames(treeRoot, time, viewsToRender, mipMapLevel);
+} // prefetchReadersAhead
 
 RenderEngine*
 OutputSchedulerThread::getEngine() const
@@ -1488,6 +2267,36 @@ OutputSchedulerThread::runCallbackWithVariables(const QString& callback)
 
 void
 OutputSchedulerThread::runAfterFrameRenderedCallback(TimeValue frame)
+{
+    NodePtr effect = getOutputNode();
+    EffectInstancePtr effectInstance = effect->getEffectInstance();
+    if ( effectInstance->getAfterFrameRenderCallback().empty() ) {
+        return;
+    }
+    if ( !effectInstance->isAfterFrameRenderCallbackAsynchronous() ) {
+        runAfterFrameRenderedCallbackNow(frame);
+
+        return;
+    }
+
+    // Queue the callback to the callback thread so that the caller can deliver the next frames while it runs.
+    // Block while the queue is full so that a slow callback does not fall behind indefinitely.
+    QMutexLocker k(&_imp->afterFrameRenderCallbacksMutex);
+    while ( ( (int)_imp->afterFrameRenderCallbacksQueue.size() >= NATRON_AFTER_FRAME_RENDER_CALLBACK_MAX_QUEUED_FRAMES ) && !isBeingAborted() ) {
+        _imp->afterFrameRenderCallbacksCond.wait(&_imp->afterFrameRenderCallbacksMutex);
+    }
+    if ( isBeingAborted() ) {
+        return;
+    }
+    _imp->afterFrameRenderCallbacksQueue.push_back(frame);
+    if (!_imp->afterFrameRenderCallbackThreadActive) {
+        _imp->afterFrameRenderCallbackThreadActive = true;
+        _imp->afterFrameRenderCallbackThread.start( new AfterFrameRenderCallbackRunnable( _imp.get() ) );
+    }
+} // runAfterFrameRenderedCallback
+
+void
+OutputSchedulerThread::runAfterFrameRenderedCallbackNow(TimeValue frame)
 {
     NodePtr effect = getOutputNode();
     std::string cb = effect->getEffectInstance()->getAfterFrameRenderCallback();
@@ -1540,7 +2349,7 @@ OutputSchedulerThread::runAfterFrameRenderedCallback(TimeValue frame)
         return;
     }
 
-} // runAfterFrameRenderedCallback
+} // runAfterFrameRenderedCallbackNow
 
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
@@ -1597,7 +2406,11 @@ RenderThreadTask::getScheduler() const
 void
 RenderThreadTask::run()
 {
-    renderFrame(_imp->time, _imp->viewsToRender, _imp->useRenderStats);
+    {
+        // Share the CPUs with the other frames rendering concurrently
+        FrameRenderCPUBudget_RAII cpuBudget;
+        renderFrame(_imp->time, _imp->viewsToRender, _imp->useRenderStats);
+    }
     _imp->scheduler->notifyThreadAboutToQuit(this);
 }
 
@@ -1620,6 +2433,26 @@ DefaultScheduler::~DefaultScheduler()
 {
 }
 
+/**
+ * @brief A frame converted for the FrameStreamWriter, written in order by DefaultScheduler::processFrame()
+ **/
+class StreamBufferedFrame : public BufferedFrame
+{
+public:
+
+    StreamBufferedFrame()
+    : BufferedFrame()
+    , frameData()
+    {
+    }
+
+    virtual ~StreamBufferedFrame() {}
+
+    std::vector<unsigned char> frameData;
+};
+
+typedef boost::shared_ptr<StreamBufferedFrame> StreamBufferedFramePtr;
+
 class DefaultRenderFrameRunnable
     : public RenderThreadTask
 {
@@ -1716,33 +2549,55 @@ private:
 
 protected:
 
+    /**
+     * @brief If the given node is a Write node, returns the internal writer which actually encodes the frames
+     **/
+    static NodePtr getWriterToRender(const NodePtr& outputNode)
+    {
+        WriteNodePtr isWrite = toWriteNode(outputNode->getEffectInstance());
+        if (isWrite) {
+            NodePtr embeddedWriter = isWrite->getEmbeddedWriter();
+            if (embeddedWriter) {
+                return embeddedWriter;
+            }
+        }
+
+        return outputNode;
+    }
+
+    /**
+     * @brief Renders all the given views of the frame with a single TreeRender so that they render concurrently
+     **/
     ActionRetCodeEnum renderFrameInternal(NodePtr outputNode,
                                           TimeValue time,
-                                          ViewIdx view,
-                                          const RenderStatsPtr& stats,
-                                          ImagePtr* imagePlane)
+                                          const std::vector<ViewIdx>& viewsToRender,
+                                          const RenderStatsPtr& stats)
     {
+        if (viewsToRender.empty()) {
+            return eActionStatusOK;
+        }
         if (!outputNode) {
             return eActionStatusFailed;
         }
 
         // If the output is a Write node, actually write is the internal write node encoder
-        {
-            WriteNodePtr isWrite = toWriteNode(outputNode->getEffectInstance());
-            if (isWrite) {
-                NodePtr embeddedWriter = isWrite->getEmbeddedWriter();
-                if (embeddedWriter) {
-                    outputNode = embeddedWriter;
-                }
-            }
-        }
+        outputNode = getWriterToRender(outputNode);
         assert(outputNode);
 
 
         TreeRender::CtorArgsPtr args(new TreeRender::CtorArgs);
         args->treeRootEffect = outputNode->getEffectInstance();
+
+        // The other writers rendered with this one share the same TreeRender so that their common upstream tree renders once
+        {
+            std::list<NodePtr> extraOutputs = _imp->scheduler->getEngine()->getExtraOutputNodes();
+            for (std::list<NodePtr>::const_iterator it = extraOutputs.begin(); it != extraOutputs.end(); ++it) {
+                args->extraTreeRoots.push_back( getWriterToRender(*it)->getEffectInstance() );
+            }
+        }
         args->time = time;
-        args->view = view;
+        args->view = viewsToRender[0];
+        args->extraViews.assign(viewsToRender.begin() + 1, viewsToRender.end());
 
         // Render default layer produced
         args->plane = 0;
@@ -1759,6 +2614,7 @@ protected:
         args->draftMode = false;
         args->playback = true;
         args->byPassCache = false;
+        args->priority = eRenderPriorityWrite;
 
         ActionRetCodeEnum retCode = eActionStatusFailed;
         TreeRenderPtr render = TreeRender::create(args);
@@ -1767,11 +2623,8 @@ protected:
                 QMutexLocker k(&renderObjectsMutex);
                 renderObjects.push_back(render);
             }
-            FrameViewRequestPtr outputRequest;
-            retCode = render->launchRender(&outputRequest);
-            if (!isFailureRetCode(retCode)) {
-                *imagePlane = outputRequest->getRequestedScaleImagePlane();
-            }
+            std::list<FrameViewRequestPtr> outputRequests;
+            retCode = render->launchRender(&outputRequests);
         }
 
         if (isFailureRetCode(retCode)) {
@@ -1781,19 +2634,137 @@ protected:
         }
     }
 
+    /**
+     * @brief Renders the image in input of the writer with the arguments renderFrameInternal() would use,
+     * so that it is in the cache when the FrameEncodeQueue renders the writer.
+     * All the views are rendered by a single TreeRender. If outputRequests is set, the request of each view is returned in it.
+     * Returns eActionStatusFailed if the writer has no input.
+     **/
+    ActionRetCodeEnum renderWriterInput(NodePtr outputNode,
+                                        TimeValue time,
+                                        const std::vector<ViewIdx>& viewsToRender,
+                                        const RenderStatsPtr& stats,
+                                        std::list<FrameViewRequestPtr>* outputRequests = 0)
+    {
+        if (viewsToRender.empty()) {
+            return eActionStatusOK;
+        }
+        WriteNodePtr isWrite = toWriteNode(outputNode->getEffectInstance());
+        if (isWrite) {
+            NodePtr embeddedWriter = isWrite->getEmbeddedWriter();
+            if (embeddedWriter) {
+                outputNode = embeddedWriter;
+            }
+        }
+        NodePtr inputNode = outputNode->getInput(0);
+        if (!inputNode) {
+            return eActionStatusFailed;
+        }
+
+        TreeRender::CtorArgsPtr args(new TreeRender::CtorArgs);
+        args->treeRootEffect = inputNode->getEffectInstance();
+        args->time = time;
+        args->view = viewsToRender[0];
+        args->extraViews.assign(viewsToRender.begin() + 1, viewsToRender.end());
+        args->plane = 0;
+        args->mipMapLevel = 0;
+        args->proxyScale = RenderScale(1.);
+        args->canonicalRoI = 0;
+        args->stats = stats;
+        args->draftMode = false;
+        args->playback = true;
+        args->byPassCache = false;
+        args->priority = eRenderPriorityWrite;
+
+        TreeRenderPtr render = TreeRender::create(args);
+        if (!render) {
+            return eActionStatusFailed;
+        }
+        {
+            QMutexLocker k(&renderObjectsMutex);
+            renderObjects.push_back(render);
+        }
+        std::list<FrameViewRequestPtr> requests;
+        ActionRetCodeEnum stat = render->launchRender(&requests);
+        if (outputRequests) {
+            *outputRequests = requests;
+        }
+
+        return stat;
+    }
+
+    /**
+     * @brief Renders the image in input of the writer and converts it on this thread for the stream:
+     * the scheduler thread then writes the frames in order in processFrame().
+     * Multi-view projects stream the first view.
+     **/
+    void renderFrameForStream(const FrameStreamWriterPtr& frameStream,
+                              const NodePtr& outputNode,
+                              TimeValue time,
+                              const std::vector<ViewIdx>& viewsToRender,
+                              const RenderStatsPtr& stats)
+    {
+        TimeLapse renderTimer;
+
+        std::list<FrameViewRequestPtr> outputRequests;
+        ActionRetCodeEnum stat = renderWriterInput(outputNode, time, viewsToRender, stats, &outputRequests);
+        if (stat == eActionStatusAborted) {
+            return;
+        }
+        if (isFailureRetCode(stat)) {
+            _imp->scheduler->notifyRenderFailure(stat, std::string());
+
+            return;
+        }
+
+        StreamBufferedFramePtr frame(new StreamBufferedFrame);
+        frame->view = viewsToRender[0];
+        frame->stats = stats;
+        if ( outputRequests.empty() || !frameStream->convertImage(outputRequests.front()->getRequestedScaleImagePlane(), &frame->frameData) ) {
+            _imp->scheduler->notifyRenderFailure( eActionStatusFailed, std::string("Failed to convert the rendered image for the frame stream") );
+
+            return;
+        }
+
+        BufferedFrameContainerPtr frameContainer(new BufferedFrameContainer);
+        frameContainer->time = time;
+        frameContainer->frames.push_back(frame);
+        frameContainer->renderTime = renderTimer.getTimeSinceCreation();
+        _imp->scheduler->appendToBuffer(frameContainer);
+    }
+
 private:
 
 
     virtual void renderFrame(TimeValue time,
-                             const std::vector<ViewIdx>& viewsToRender,
+                             const std::vector<ViewIdx>& allViewsToRender,
                              bool enableRenderStats) OVERRIDE
     {
         NodePtr outputNode = _imp->output.lock();
         assert(outputNode);
 
+        // Skip the views whose image is up to date, see removeUpToDateViews()
+        std::vector<ViewIdx> viewsToRender = allViewsToRender;
+        _imp->scheduler->removeUpToDateViews(outputNode, time, &viewsToRender);
+        if ( viewsToRender.empty() && !allViewsToRender.empty() ) {
+            BufferedFrameContainerPtr frameContainer(new BufferedFrameContainer);
+            frameContainer->time = time;
+            for (std::size_t i = 0; i < allViewsToRender.size(); ++i) {
+                BufferedFramePtr frame(new BufferedFrame);
+                frame->view = allViewsToRender[i];
+                frameContainer->frames.push_back(frame);
+            }
+            _imp->scheduler->notifyFrameRendered(frameContainer, eSchedulingPolicyFFA);
+
+            return;
+        }
+
         // Notify we start rendering a frame to Python
         runBeforeFrameRenderCallback(time, outputNode);
 
+        // Render on disk is always using a mipmap level of 0, see renderFrameInternal()
+        _imp->scheduler->prefetchReadersAhead(outputNode, time, viewsToRender, 0 /*mipMapLevel*/, false /*draftMode*/);
+
         // Even if enableRenderStats is false, we at least profile the time spent rendering the frame when rendering with a Write node.
         // Though we don't enable render stats for sequential renders (e.g: WriteFFMPEG) since this is 1 file.
         RenderStatsPtr stats;
@@ -1801,23 +2772,51 @@ private:
             stats.reset( new RenderStats(enableRenderStats) );
         }
         
+        FrameStreamWriterPtr frameStream = _imp->scheduler->getEngine()->getFrameStreamWriter();
+        if (frameStream) {
+            if ( !viewsToRender.empty() ) {
+                renderFrameForStream(frameStream, outputNode, time, viewsToRender, stats);
+            }
+
+            return;
+        }
+
+        TimeLapse renderTimer;
+
+        // Render the input of the writer and let the encode stage write the frame while the next frames render.
+        // If this fails, render the whole frame on this thread which reports the error.
+        FrameEncodeQueue* encodeQueue = _imp->scheduler->getFrameEncodeQueue();
+        if (encodeQueue) {
+            ActionRetCodeEnum stat = renderWriterInput(outputNode, time, viewsToRender, stats);
+            if (!isFailureRetCode(stat)) {
+                double renderTime = renderTimer.getTimeSinceCreation();
+                encodeQueue->queueFrame(outputNode, time, viewsToRender, stats, renderTime);
+                _imp->scheduler->notifyFrameRenderStageFinished(renderTime);
+
+                return;
+            }
+            if (stat == eActionStatusAborted) {
+                return;
+            }
+        }
+
         BufferedFrameContainerPtr frameContainer(new BufferedFrameContainer);
         frameContainer->time = time;
 
+        // All views render concurrently in the same TreeRender
+        ActionRetCodeEnum stat = renderFrameInternal(outputNode, time, viewsToRender, stats);
+        if (isFailureRetCode(stat)) {
+            _imp->scheduler->notifyRenderFailure(stat, std::string());
+        } else {
+            _imp->scheduler->onFrameWritten(outputNode, time, viewsToRender);
+        }
         for (std::size_t view = 0; view < viewsToRender.size(); ++view) {
-            
             BufferedFramePtr frame(new BufferedFrame);
             frame->view = viewsToRender[view];
-            frame->stats = stats;
-            
-            ImagePtr imagePlane;
-            ActionRetCodeEnum stat = renderFrameInternal(outputNode, time, viewsToRender[view], stats, &imagePlane);
-            if (isFailureRetCode(stat)) {
-                _imp->scheduler->notifyRenderFailure(stat, std::string());
-            }
-            
+            frame->stats = stats;
             frameContainer->frames.push_back(frame);
         }
+        frameContainer->renderTime = renderTimer.getTimeSinceCreation();
         
         _imp->scheduler->notifyFrameRendered(frameContainer, eSchedulingPolicyFFA);
 
@@ -1840,9 +2839,25 @@ DefaultScheduler::createRunnable(TimeValue frame,
 
 
 void
-DefaultScheduler::processFrame(const BufferedFrameContainerPtr& /*frames*/)
+DefaultScheduler::processFrame(const BufferedFrameContainerPtr& frames)
 {
-    // We don't have anymore writer that need to process things in order. WriteFFMPEG is doing it for us
+    // We don't have anymore writer that need to process things in order. WriteFFMPEG is doing it for us.
+    // Only the frames sent to a stream are processed here, in order, see getSchedulingPolicy()
+    FrameStreamWriterPtr frameStream = getEngine()->getFrameStreamWriter();
+    if (!frameStream) {
+        return;
+    }
+    for (std::list<BufferedFramePtr>::const_iterator it = frames->frames.begin(); it != frames->frames.end(); ++it) {
+        StreamBufferedFrame* streamFrame = dynamic_cast<StreamBufferedFrame*>( it->get() );
+        if (!streamFrame) {
+            continue;
+        }
+        if ( !frameStream->writeFrame(streamFrame->frameData, frames->time) ) {
+            notifyRenderFailure( eActionStatusFailed, tr("Failed to write frame %1 to the frame stream").arg(frames->time).toStdString() );
+
+            return;
+        }
+    }
 } // DefaultScheduler::processFrame
 
 
@@ -1885,7 +2900,8 @@ DefaultScheduler::handleRenderFailure(ActionRetCodeEnum /*stat*/, const std::str
 SchedulingPolicyEnum
 DefaultScheduler::getSchedulingPolicy() const
 {
-    return eSchedulingPolicyFFA;
+    // A stream needs the frames in order
+    return getEngine()->getFrameStreamWriter() ? eSchedulingPolicyOrdered : eSchedulingPolicyFFA;
 }
 
 void
@@ -1914,6 +2930,15 @@ DefaultScheduler::aboutToStartRender()
     if (isWrite) {
         isWrite->onSequenceRenderStarted();
     }
+    {
+        std::list<NodePtr> extraOutputs = getEngine()->getExtraOutputNodes();
+        for (std::list<NodePtr>::const_iterator it = extraOutputs.begin(); it != extraOutputs.end(); ++it) {
+            WriteNodePtr isExtraWrite = toWriteNode( (*it)->getEffectInstance() );
+            if (isExtraWrite) {
+                isExtraWrite->onSequenceRenderStarted();
+            }
+        }
+    }
 
     std::string cb = outputNode->getEffectInstance()->getBeforeRenderCallback();
     if ( !cb.empty() ) {
@@ -1973,6 +2998,16 @@ DefaultScheduler::onRenderStopped(bool aborted)
         appPTR->writeToOutputPipe(longText, QString::fromUtf8(kRenderingFinishedStringShort), true);
     }
 
+    // The engines of the extra outputs did not run: notify their Write node here
+    {
+        std::list<NodePtr> extraOutputs = getEngine()->getExtraOutputNodes();
+        for (std::list<NodePtr>::const_iterator it = extraOutputs.begin(); it != extraOutputs.end(); ++it) {
+            WriteNodePtr isExtraWrite = toWriteNode( (*it)->getEffectInstance() );
+            if (isExtraWrite) {
+                isExtraWrite->onSequenceRenderFinished();
+            }
+        }
+    }
 
     std::string cb = outputNode->getEffectInstance()->getAfterRenderCallback();
     if ( !cb.empty() ) {
@@ -2036,6 +3071,7 @@ DefaultScheduler::onRenderStopped(bool aborted)
 ViewerDisplayScheduler::ViewerDisplayScheduler(RenderEngine* engine,
                                                const NodePtr& viewer)
     : OutputSchedulerThread(engine, viewer, eProcessFrameByMainThread)
+    , _flipbookCache( new ViewerFlipbookCache() )
 {
 
 }
@@ -2044,6 +3080,12 @@ ViewerDisplayScheduler::~ViewerDisplayScheduler()
 {
 }
 
+ViewerFlipbookCache*
+ViewerDisplayScheduler::getFlipbookCache() const
+{
+    return _flipbookCache.get();
+}
+
 
 
 
@@ -2087,7 +3129,7 @@ public:
     , canonicalRoi()
     , viewerProcessImageKey()
     {
-
+        retCode[0] = retCode[1] = eActionStatusOK;
     }
 
     virtual ~ViewerRenderBufferedFrame() {}
@@ -2148,9 +3190,16 @@ struct RenderViewerProcessFunctorArgs
     bool isDraftModeEnabled;
     bool isPlayback;
     bool byPassCache;
+    RenderPriorityEnum priority;
+
+    // True if the image of this viewer process is not displayed at all in the RoI because of the wipe:
+    // no render object is created
+    bool isHiddenByWipe;
 
     RenderViewerProcessFunctorArgs()
     : retCode(eActionStatusOK)
+    , priority(eRenderPriorityInteractive)
+    , isHiddenByWipe(false)
     {
 
     }
@@ -2187,6 +3236,11 @@ public:
 
     static void createRenderViewerObject(RenderViewerProcessFunctorArgs* inArgs)
     {
+        if (inArgs->isHiddenByWipe) {
+            inArgs->retCode = eActionStatusOK;
+            return;
+        }
+
         TreeRender::CtorArgsPtr args(new TreeRender::CtorArgs);
         args->treeRootEffect = inArgs->viewerProcessNode->getEffectInstance();
         args->time = inArgs->time;
@@ -2207,6 +3261,7 @@ public:
         args->draftMode = inArgs->isDraftModeEnabled;
         args->playback = inArgs->isPlayback;
         args->byPassCache = inArgs->byPassCache;
+        args->priority = inArgs->priority;
         args->activeRotoDrawableItem = inArgs->activeStrokeItem;
         if (inArgs->colorPickerNode) {
             args->extraNodesToSample.push_back(inArgs->colorPickerNode);
@@ -2343,21 +3398,35 @@ public:
         return mipMapLevel;
     } // getViewerMipMapLevel
 
-    static void createRenderViewerProcessArgs(const ViewerNodePtr& viewer,
-                                              int viewerProcess_i,
-                                              TimeValue time,
-                                              ViewIdx view,
-                                              bool isPlayback,
-                                              const RenderStatsPtr& stats,
-                                              const RotoStrokeItemPtr& activeStroke,
-                                              const RectD* roiParam,
-                                              ViewerRenderBufferedFrame* bufferedFrame,
-                                              RenderViewerProcessFunctorArgs* outArgs)
+    /**
+     * @brief Same as createRenderViewerProcessArgs() but does not create the render object
+     **/
+    static void computeRenderViewerProcessArgs(const ViewerNodePtr& viewer,
+                                               int viewerProcess_i,
+                                               TimeValue time,
+                                               ViewIdx view,
+                                               bool isPlayback,
+                                               int playbackDegradationLevel,
+                                               bool isProgressiveDraft,
+                                               const RenderStatsPtr& stats,
+                                               const RotoStrokeItemPtr& activeStroke,
+                                               const RectD* roiParam,
+                                               ViewerRenderBufferedFrame* bufferedFrame,
+                                               RenderViewerProcessFunctorArgs* outArgs)
     {
 
         bool fullFrameProcessing = viewer->isFullFrameProcessingEnabled();
-        bool draftModeEnabled = viewer->getApp()->isDraftRenderEnabled();
+
+        // If the playback cannot keep up with the desired FPS, render in draft mode and then at a lower resolution
+        bool draftModeEnabled = viewer->getApp()->isDraftRenderEnabled() || playbackDegradationLevel > 0 || isProgressiveDraft;
         unsigned int mipMapLevel = getViewerMipMapLevel(viewer, draftModeEnabled, fullFrameProcessing);
+        if (!fullFrameProcessing && playbackDegradationLevel > 1) {
+            mipMapLevel += playbackDegradationLevel - 1;
+        }
+        // The draft of a progressive render is displayed until the full resolution render replaces it
+        if (!fullFrameProcessing && isProgressiveDraft) {
+            mipMapLevel = std::max( mipMapLevel, getViewerMipMapLevel(viewer, false, fullFrameProcessing) + NATRON_VIEWER_PROGRESSIVE_DRAFT_MIPMAP_LEVELS );
+        }
         bool byPassCache = viewer->isRenderWithoutCacheEnabledAndTurnOff();
 
         RectD roi;
@@ -2366,6 +3435,17 @@ public:
         } else if (!fullFrameProcessing) {
             roi = viewer->getUiContext()->getImageRectangleDisplayed();
         }
+
+        // Only render the part of the B input displayed on its side of the wipe
+        outArgs->isHiddenByWipe = false;
+        if ( !roi.isNull() ) {
+            RectD visibleRoI;
+            if ( !viewer->getWipeVisibleRoI(viewerProcess_i, roi, &visibleRoI) ) {
+                outArgs->isHiddenByWipe = true;
+            } else {
+                roi = visibleRoI;
+            }
+        }
         outArgs->activeStrokeItem = activeStroke;
         outArgs->isPlayback = isPlayback;
         outArgs->isDraftModeEnabled = draftModeEnabled;
@@ -2384,17 +3464,77 @@ public:
             }
         }
         outArgs->viewerProcessNode = viewer->getViewerProcessNode(viewerProcess_i)->getNode();
-        createRenderViewerObject(outArgs);
         bufferedFrame->canonicalRoi[viewerProcess_i] = roi;
 
     }
 
+    static void createRenderViewerProcessArgs(const ViewerNodePtr& viewer,
+                                              int viewerProcess_i,
+                                              TimeValue time,
+                                              ViewIdx view,
+                                              bool isPlayback,
+                                              int playbackDegradationLevel,
+                                              bool isProgressiveDraft,
+                                              const RenderStatsPtr& stats,
+                                              const RotoStrokeItemPtr& activeStroke,
+                                              const RectD* roiParam,
+                                              ViewerRenderBufferedFrame* bufferedFrame,
+                                              RenderViewerProcessFunctorArgs* outArgs)
+    {
+        computeRenderViewerProcessArgs(viewer, viewerProcess_i, time, view, isPlayback, playbackDegradationLevel, isProgressiveDraft, stats, activeStroke, roiParam, bufferedFrame, outArgs);
+        createRenderViewerObject(outArgs);
+    }
+
 private:
 
     void createAndLaunchRenderInThread(const RenderViewerProcessFunctorArgsPtr& processArgs, int viewerProcess_i, TimeValue time, const RenderStatsPtr& stats, ViewerRenderBufferedFrame* bufferedFrame)
     {
 
-        createRenderViewerProcessArgs(_viewer, viewerProcess_i, time, bufferedFrame->view, true /*isPlayback*/, stats,  RotoStrokeItemPtr(), 0 /*roiParam*/,  bufferedFrame, processArgs.get());
+        computeRenderViewerProcessArgs(_viewer, viewerProcess_i, time, bufferedFrame->view, true /*isPlayback*/, getScheduler()->getPlaybackDegradationLevel(), false /*isProgressiveDraft*/, stats,  RotoStrokeItemPtr(), 0 /*roiParam*/,  bufferedFrame, processArgs.get());
+
+        if (processArgs->isHiddenByWipe) {
+            // Nothing to upload: the texture is not displayed
+            processArgs->retCode = eActionStatusOK;
+            bufferedFrame->retCode[viewerProcess_i] = eActionStatusOK;
+            return;
+        }
+
+        // If the frame was already displayed with the same parameters, upload it again without rendering
+        ViewerDisplayScheduler* viewerScheduler = dynamic_cast<ViewerDisplayScheduler*>( getScheduler() );
+        assert(viewerScheduler);
+        ViewerFlipbookCache* flipbook = viewerScheduler ? viewerScheduler->getFlipbookCache() : 0;
+        SettingsPtr settings = appPTR->getCurrentSettings();
+        U64 viewerProcessHash = 0;
+        if ( flipbook && !settings->isViewerFlipbookEnabled() ) {
+            flipbook->clear();
+            flipbook = 0;
+        }
+        if (flipbook && !processArgs->byPassCache) {
+            HashableObject::ComputeHashArgs hashArgs;
+            hashArgs.time = time;
+            hashArgs.view = bufferedFrame->view;
+            hashArgs.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+            viewerProcessHash = processArgs->viewerProcessNode->getEffectInstance()->computeHash(hashArgs);
+
+            ImagePtr cachedImage;
+            RectD cachedRoi;
+            ImageCacheKeyPtr cachedImageKey;
+            if ( flipbook->getFrame(time, bufferedFrame->view, viewerProcess_i, viewerProcessHash, processArgs->viewerMipMapLevel, processArgs->isDraftModeEnabled, processArgs->roi, &cachedImage, &cachedRoi, &cachedImageKey) ) {
+                bufferedFrame->canonicalRoi[viewerProcess_i] = cachedRoi;
+                bufferedFrame->retCode[viewerProcess_i] = eActionStatusOK;
+                bufferedFrame->viewerProcessImageKey[viewerProcess_i] = cachedImageKey;
+                bufferedFrame->viewerProcessImages[viewerProcess_i] = cachedImage;
+                processArgs->retCode = eActionStatusOK;
+                processArgs->viewerProcessImageCacheKey = cachedImageKey;
+                processArgs->outputImage = cachedImage;
+
+                return;
+            }
+        }
+
+        createRenderViewerObject( processArgs.get() );
+
+        getScheduler()->prefetchReadersAhead(processArgs->viewerProcessNode, time, std::vector<ViewIdx>(1, bufferedFrame->view), processArgs->viewerMipMapLevel, processArgs->isDraftModeEnabled);
 
         // Register the render so that it can be aborted in abortRenders()
         {
@@ -2408,6 +3548,10 @@ private:
 
         launchRenderFunctor(processArgs);
 
+        if ( flipbook && !processArgs->byPassCache && (processArgs->retCode == eActionStatusOK) ) {
+            flipbook->insertFrame(time, bufferedFrame->view, viewerProcess_i, viewerProcessHash, processArgs->viewerMipMapLevel, processArgs->isDraftModeEnabled, processArgs->roi, processArgs->outputImage, processArgs->viewerProcessImageCacheKey, settings->getViewerFlipbookMaxMemoryBytes());
+        }
+
         bufferedFrame->retCode[viewerProcess_i] = processArgs->retCode;
         bufferedFrame->viewerProcessImageKey[viewerProcess_i] = processArgs->viewerProcessImageCacheKey;
         bufferedFrame->viewerProcessImages[viewerProcess_i] = processArgs->outputImage;
@@ -2430,7 +3574,8 @@ private:
         ViewerRenderBufferedFrameContainerPtr frameContainer(new  ViewerRenderBufferedFrameContainer());
         frameContainer->time = time;
         frameContainer->recenterViewer = false;
-        
+
+        TimeLapse renderTimer;
         for (std::size_t i = 0; i < viewsToRender.size(); ++i) {
 
 
@@ -2490,6 +3635,7 @@ private:
             // Notify the scheduler thread which will in turn call processFrame
 
         } // for all views
+        frameContainer->renderTime = renderTimer.getTimeSinceCreation();
 
         _imp->scheduler->appendToBuffer(frameContainer);
 
@@ -2614,6 +3760,22 @@ struct RenderEnginePrivate
      */
     std::list<RefreshRequest> refreshQueue;
 
+    // The other outputs rendered together with the output, see setExtraOutputNodes()
+    mutable QMutex extraOutputNodesMutex;
+    std::list<NodeWPtr> extraOutputNodes;
+
+    // Protects frameStream, incrementalRender and resume
+    mutable QMutex frameStreamMutex;
+
+    // The stream the frames are sent to, see setFrameStreamWriter()
+    FrameStreamWriterPtr frameStream;
+
+    // See setIncrementalRenderEnabled()
+    bool incrementalRender;
+
+    // See setResumeEnabled()
+    bool resume;
+
     RenderEnginePrivate(const NodePtr& output)
         : schedulerCreationLock()
         , scheduler(0)
@@ -2624,6 +3786,12 @@ struct RenderEnginePrivate
         , pbMode(ePlaybackModeLoop)
         , currentFrameScheduler(0)
         , refreshQueue()
+        , extraOutputNodesMutex()
+        , extraOutputNodes()
+        , frameStreamMutex()
+        , frameStream()
+        , incrementalRender(false)
+        , resume(false)
     {
     }
 };
@@ -2654,6 +3822,73 @@ RenderEngine::getOutput() const
     return _imp->output.lock();
 }
 
+void
+RenderEngine::setExtraOutputNodes(const std::list<NodePtr>& nodes)
+{
+    QMutexLocker k(&_imp->extraOutputNodesMutex);
+    _imp->extraOutputNodes.clear();
+    for (std::list<NodePtr>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        _imp->extraOutputNodes.push_back(*it);
+    }
+}
+
+std::list<NodePtr>
+RenderEngine::getExtraOutputNodes() const
+{
+    std::list<NodePtr> ret;
+    QMutexLocker k(&_imp->extraOutputNodesMutex);
+    for (std::list<NodeWPtr>::const_iterator it = _imp->extraOutputNodes.begin(); it != _imp->extraOutputNodes.end(); ++it) {
+        NodePtr node = it->lock();
+        if (node) {
+            ret.push_back(node);
+        }
+    }
+
+    return ret;
+}
+
+void
+RenderEngine::setFrameStreamWriter(const FrameStreamWriterPtr& stream)
+{
+    QMutexLocker k(&_imp->frameStreamMutex);
+    _imp->frameStream = stream;
+}
+
+FrameStreamWriterPtr
+RenderEngine::getFrameStreamWriter() const
+{
+    QMutexLocker k(&_imp->frameStreamMutex);
+    return _imp->frameStream;
+}
+
+void
+RenderEngine::setResumeEnabled(bool enabled)
+{
+    QMutexLocker k(&_imp->frameStreamMutex);
+    _imp->resume = enabled;
+}
+
+bool
+RenderEngine::isResumeEnabled() const
+{
+    QMutexLocker k(&_imp->frameStreamMutex);
+    return _imp->resume;
+}
+
+void
+RenderEngine::setIncrementalRenderEnabled(bool enabled)
+{
+    QMutexLocker k(&_imp->frameStreamMutex);
+    _imp->incrementalRender = enabled;
+}
+
+bool
+RenderEngine::isIncrementalRenderEnabled() const
+{
+    QMutexLocker k(&_imp->frameStreamMutex);
+    return _imp->incrementalRender;
+}
+
 void
 RenderEngine::renderFrameRange(bool isBlocking,
                                bool enableRenderStats,
@@ -3055,9 +4290,32 @@ RenderEngine::reportStats(TimeValue time,
     std::map<NodePtr, NodeRenderStats > statsMap = stats->getStats(&wallTime);
 
     ofile << "Time spent to render frame (wall clock time): " << Timer::printAsTime(wallTime, false).toStdString() << std::endl;
+
+    // The time spent rendering by all threads over the wall clock time is the average number of threads busy rendering
+    double totalTimeSpentRendering = 0;
+    for (std::map<NodePtr, NodeRenderStats >::const_iterator it = statsMap.begin(); it != statsMap.end(); ++it) {
+        totalTimeSpentRendering += it->second.getTotalTimeSpentRendering();
+    }
+    if (wallTime > 0) {
+        ofile << "Average number of threads rendering: " << totalTimeSpentRendering / wallTime << std::endl;
+    }
+
     for (std::map<NodePtr, NodeRenderStats >::const_iterator it = statsMap.begin(); it != statsMap.end(); ++it) {
         ofile << "------------------------------- " << it->first->getScriptName_mt_safe() << "------------------------------- " << std::endl;
         ofile << "Time spent rendering: " << Timer::printAsTime(it->second.getTotalTimeSpentRendering(), false).toStdString() << std::endl;
+        for (int i = 0; i < eRenderStatsActionCount; ++i) {
+            RenderStatsActionEnum action = (RenderStatsActionEnum)i;
+            int nCalls = it->second.getActionCallsCount(action);
+            if (nCalls == 0) {
+                continue;
+            }
+            ofile << "Time spent in " << RenderStats::getActionLabel(action) << ": " << Timer::printAsTime(it->second.getActionTime(action), false).toStdString() << " (" << nCalls << " calls)" << std::endl;
+        }
+        ofile << "Cache hits: " << it->second.getNumCacheHits() << ", misses: " << it->second.getNumCacheMisses() << std::endl;
+        ofile << "Memory allocated: " << printAsRAM( it->second.getBytesAllocated() ).toStdString() << std::endl;
+        ofile << "Threads used: " << it->second.getNumRenderThreads() << std::endl;
+        ofile << "Render clones allocated: " << it->second.getNumRenderClonesCreated() << ", re-used: " << it->second.getNumRenderClonesReused() << std::endl;
+        ofile << "NaN values replaced: " << it->second.getNumNaNsReplaced() << std::endl;
     }
 } // reportStats
 
@@ -3093,6 +4351,9 @@ public:
     RotoStrokeItemPtr strokeItem;
     U64 age;
 
+    // True if this is the coarse render of a progressive render, to be refined at full resolution
+    bool isProgressiveDraft;
+
     CurrentFrameFunctorArgs()
         : GenericThreadStartArgs()
         , viewsToRender()
@@ -3102,6 +4363,7 @@ public:
         , scheduler(0)
         , strokeItem()
         , age(0)
+        , isProgressiveDraft(false)
     {
     }
 
@@ -3119,6 +4381,7 @@ public:
         , scheduler(scheduler)
         , strokeItem(strokeItem)
         , age(0)
+        , isProgressiveDraft(false)
     {
         viewsToRender.push_back(view);
     }
@@ -3162,7 +4425,7 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
     QWaitCondition currentFrameRenderTasksCond;
     std::list<boost::shared_ptr<RenderCurrentFrameFunctorRunnable> > currentFrameRenderTasks;
 
-    mutable QMutex renderAgeMutex; // protects renderAge displayAge currentRenders
+    mutable QMutex renderAgeMutex; // protects renderAge displayAge currentRenders refineRequestAge refineWithStats lastFullRenderTime
 
     // This is the age to attribute to the next incomming render
     U64 renderAge;
@@ -3173,6 +4436,32 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
     // A set of active renders and their age.
     TreeRenderSetOrderedByAge currentRenders;
 
+    // The age of the progressive draft render to refine at full resolution once displayed. If 0 there is none.
+    U64 refineRequestAge;
+
+    // Whether the full resolution render refining the draft should report stats
+    bool refineWithStats;
+
+    // The time in seconds of the last full resolution render that was not aborted
+    double lastFullRenderTime;
+
+    // Started on the main thread when the progressive draft is displayed, launches the full resolution render
+    QTimer* refineTimer;
+
+    // Started on the main thread when a full resolution render is displayed, launches the idle caching
+    QTimer* idleCacheTimer;
+
+    mutable QMutex idleCacheMutex; // protects idleCacheGeneration idleCacheRenders
+
+    // Incremented in stopIdleCaching(): the idle caching of a previous generation stops
+    U64 idleCacheGeneration;
+
+    // The idle caching renders in progress, so that they can be aborted
+    std::list<TreeRenderPtr> idleCacheRenders;
+
+    // A single low priority thread renders the frames around the current frame when the user is idle
+    QThreadPool idleCacheThreadPool;
+
     ViewerCurrentFrameRequestSchedulerPrivate(ViewerCurrentFrameRequestScheduler* publicInterface, const NodePtr& viewer)
         : _publicInterface(publicInterface)
         , viewer(viewer)
@@ -3183,7 +4472,35 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
         , renderAge(1)
         , displayAge(0)
         , currentRenders()
+        , refineRequestAge(0)
+        , refineWithStats(false)
+        , lastFullRenderTime(0)
+        , refineTimer(0)
+        , idleCacheTimer(0)
+        , idleCacheMutex()
+        , idleCacheGeneration(0)
+        , idleCacheRenders()
+        , idleCacheThreadPool()
+    {
+        idleCacheThreadPool.setMaxThreadCount(1);
+    }
+
+    /**
+     * @brief Aborts the idle caching in progress, without waiting for it to return
+     **/
+    void stopIdleCaching()
+    {
+        QMutexLocker k(&idleCacheMutex);
+        ++idleCacheGeneration;
+        for (std::list<TreeRenderPtr>::const_iterator it = idleCacheRenders.begin(); it != idleCacheRenders.end(); ++it) {
+            (*it)->setRenderAborted();
+        }
+    }
+
+    bool isIdleCacheGenerationCurrent(U64 generation) const
     {
+        QMutexLocker k(&idleCacheMutex);
+        return generation == idleCacheGeneration;
     }
 
     void appendRunnableTask(const boost::shared_ptr<RenderCurrentFrameFunctorRunnable>& task)
@@ -3222,6 +4539,122 @@ struct ViewerCurrentFrameRequestSchedulerPrivate
     void processProducedFrame(U64 age, const BufferedFrameContainerPtr& frames);
 };
 
+/**
+ * @brief Renders the frames around the current frame into the cache, the frames after first and then the frames before,
+ * with the same parameters as the playback so that the playback finds them in the cache.
+ **/
+class ViewerIdleCacheRunnable
+    : public QRunnable
+{
+    ViewerCurrentFrameRequestSchedulerPrivate* _scheduler;
+    ViewerNodePtr _viewer;
+    TimeValue _time, _first, _last;
+    ViewIdx _view;
+    U64 _generation;
+
+public:
+
+    ViewerIdleCacheRunnable(ViewerCurrentFrameRequestSchedulerPrivate* scheduler,
+                            const ViewerNodePtr& viewer,
+                            TimeValue time,
+                            TimeValue first,
+                            TimeValue last,
+                            ViewIdx view,
+                            U64 generation)
+        : QRunnable()
+        , _scheduler(scheduler)
+        , _viewer(viewer)
+        , _time(time)
+        , _first(first)
+        , _last(last)
+        , _view(view)
+        , _generation(generation)
+    {
+        setAutoDelete(true);
+    }
+
+    virtual ~ViewerIdleCacheRunnable()
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        // Do not slow down the renders requested by the user. The thread pool is only used for the idle caching.
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+        std::list<TimeValue> frames;
+        for (double t = _time + 1; t <= _last; t += 1) {
+            frames.push_back( TimeValue(t) );
+        }
+        for (double t = _time - 1; t >= _first; t -= 1) {
+            frames.push_back( TimeValue(t) );
+        }
+
+        CacheBasePtr tileCache = appPTR->getTileCache();
+        const double memoryShare = appPTR->getCurrentSettings()->getViewerIdleCachingMemoryShare();
+        for (std::list<TimeValue>::const_iterator it = frames.begin(); it != frames.end(); ++it) {
+            if ( !_scheduler->isIdleCacheGenerationCurrent(_generation) ) {
+                return;
+            }
+
+            // Do not evict the frames cached so far
+            if (tileCache) {
+                std::size_t maxSize = tileCache->getMaximumCacheSize();
+                if ( (maxSize > 0) && (tileCache->getCurrentSize() >= maxSize * memoryShare) ) {
+                    return;
+                }
+            }
+            if ( !renderFrame(*it) ) {
+                return;
+            }
+        }
+    } // run
+
+private:
+
+    /**
+     * @brief Renders the frame for the viewer process nodes displayed. Returns false if aborted.
+     **/
+    bool renderFrame(TimeValue time)
+    {
+        ViewerCompositingOperatorEnum viewerBlend = _viewer->getCurrentOperator();
+        bool viewerBEqualsViewerA = _viewer->getCurrentAInput() == _viewer->getCurrentBInput();
+        int nViewerProcess = (!viewerBEqualsViewerA && viewerBlend != eViewerCompositingOperatorNone) ? 2 : 1;
+        for (int i = 0; i < nViewerProcess; ++i) {
+            ViewerRenderBufferedFrame bufferedFrame;
+            bufferedFrame.view = _view;
+
+            RenderViewerProcessFunctorArgs processArgs;
+            ViewerRenderFrameRunnable::computeRenderViewerProcessArgs(_viewer, i, time, _view, true /*isPlayback*/, 0 /*playbackDegradationLevel*/, false /*isProgressiveDraft*/, RenderStatsPtr(), RotoStrokeItemPtr(), 0 /*roiParam*/, &bufferedFrame, &processArgs);
+            processArgs.priority = eRenderPriorityIdle;
+            ViewerRenderFrameRunnable::createRenderViewerObject(&processArgs);
+            if (!processArgs.renderObject) {
+                continue;
+            }
+            {
+                QMutexLocker k(&_scheduler->idleCacheMutex);
+                if (_generation != _scheduler->idleCacheGeneration) {
+                    return false;
+                }
+                _scheduler->idleCacheRenders.push_back(processArgs.renderObject);
+            }
+
+            // The image stays in the cache: the result is not needed here
+            FrameViewRequestPtr outputRequest;
+            ActionRetCodeEnum stat = processArgs.renderObject->launchRender(&outputRequest);
+
+            {
+                QMutexLocker k(&_scheduler->idleCacheMutex);
+                _scheduler->idleCacheRenders.remove(processArgs.renderObject);
+            }
+            if (stat == eActionStatusAborted) {
+                return false;
+            }
+        }
+        return true;
+    } // renderFrame
+};
+
 class RenderCurrentFrameFunctorRunnable
     : public QRunnable
 {
@@ -3248,7 +4681,13 @@ public:
                                        ViewerRenderBufferedFrame* bufferedFrame)
     {
 
-        ViewerRenderFrameRunnable::createRenderViewerProcessArgs(viewer, viewerProcess_i, time, bufferedFrame->view, false /*isPlayback*/, stats, activeStroke, roiParam,  bufferedFrame, processArgs.get());
+        ViewerRenderFrameRunnable::createRenderViewerProcessArgs(viewer, viewerProcess_i, time, bufferedFrame->view, false /*isPlayback*/, 0 /*playbackDegradationLevel*/, _args->isProgressiveDraft, stats, activeStroke, roiParam,  bufferedFrame, processArgs.get());
+
+        if (processArgs->isHiddenByWipe) {
+            // Nothing to upload: the texture is not displayed
+            bufferedFrame->retCode[viewerProcess_i] = eActionStatusOK;
+            return;
+        }
 
         // Register the current renders and their age on the scheduler so that they can be aborted
         {
@@ -3356,6 +4795,7 @@ public:
         framesContainer->time = _args->time;
         framesContainer->recenterViewer = viewer->getViewerCenterPoint(&framesContainer->viewerCenter);
 
+        TimeLapse renderTimer;
 
         if (viewer->isDoingPartialUpdates()) {
             // If the viewer is doing partial updates (i.e: during tracking we only update the markers areas)
@@ -3368,6 +4808,22 @@ public:
             computeViewsForRoI(viewer, 0, framesContainer);
         }
 
+        if (!_args->isProgressiveDraft) {
+            // Remember how long a full resolution render takes to decide whether the next render should be progressive
+            bool aborted = false;
+            for (std::list<BufferedFramePtr>::const_iterator it = framesContainer->frames.begin(); it != framesContainer->frames.end(); ++it) {
+                ViewerRenderBufferedFrame* viewerObject = dynamic_cast<ViewerRenderBufferedFrame*>(it->get());
+                if ( viewerObject && ( (viewerObject->retCode[0] == eActionStatusAborted) || (viewerObject->retCode[1] == eActionStatusAborted) ) ) {
+                    aborted = true;
+                    break;
+                }
+            }
+            if (!aborted) {
+                QMutexLocker k(&_args->scheduler->renderAgeMutex);
+                _args->scheduler->lastFullRenderTime = renderTimer.getTimeSinceCreation();
+            }
+        }
+
         // Call updateViewer() on the main thread
         _args->scheduler->_publicInterface->s_doProcessFrameOnMainThread(_args->age, framesContainer);
 
@@ -3392,10 +4848,23 @@ ViewerCurrentFrameRequestScheduler::ViewerCurrentFrameRequestScheduler(const Nod
 : _imp( new ViewerCurrentFrameRequestSchedulerPrivate(this, viewer) )
 {
     QObject::connect(this, SIGNAL(doProcessFrameOnMainThread(U64,BufferedFrameContainerPtr)), this, SLOT(onDoProcessFrameOnMainThreadReceived(U64,BufferedFrameContainerPtr)));
+
+    _imp->refineTimer = new QTimer(this);
+    _imp->refineTimer->setSingleShot(true);
+    _imp->refineTimer->setInterval(NATRON_VIEWER_PROGRESSIVE_REFINE_DELAY_MS);
+    QObject::connect( _imp->refineTimer, SIGNAL(timeout()), this, SLOT(onRefineTimerTimeout()) );
+
+    _imp->idleCacheTimer = new QTimer(this);
+    _imp->idleCacheTimer->setSingleShot(true);
+    _imp->idleCacheTimer->setInterval(NATRON_VIEWER_IDLE_CACHE_DELAY_MS);
+    QObject::connect( _imp->idleCacheTimer, SIGNAL(timeout()), this, SLOT(onIdleCacheTimerTimeout()) );
 }
 
 ViewerCurrentFrameRequestScheduler::~ViewerCurrentFrameRequestScheduler()
 {
+    _imp->stopIdleCaching();
+    _imp->idleCacheThreadPool.waitForDone();
+
     // Should've been stopped before anyway
     if (_imp->backupThread.quitThread(false)) {
         _imp->backupThread.waitForAbortToComplete_enforce_blocking();
@@ -3474,6 +4943,14 @@ ViewerCurrentFrameRequestSchedulerPrivate::processProducedFrame(U64 age, const B
         QMutexLocker k(&renderAgeMutex);
         // Update the display age
         displayAge = age;
+
+        // The draft of a progressive render is displayed: refine it if no other render is requested in the meantime
+        if (age == refineRequestAge) {
+            refineTimer->start();
+        } else if ( appPTR->getCurrentSettings()->isViewerIdleCachingEnabled() ) {
+            // Cache the frames around if the user does not do anything else in the meantime
+            idleCacheTimer->start();
+        }
     }
     // At least redraw the viewer, we might be here when the user removed a node upstream of the viewer.
     viewerNode->redrawViewer();
@@ -3487,6 +4964,9 @@ ViewerCurrentFrameRequestScheduler::onAbortRequested(bool keepOldestRender)
 #endif
     _imp->backupThread.abortThreadedTask();
 
+    // Any render requested by the user has priority over the idle caching
+    _imp->stopIdleCaching();
+
     ViewerNodePtr viewerNode = _imp->viewer->isEffectViewerNode();
 
     // Do not abort the oldest render while scrubbing timeline or sliders so that the user gets some feedback
@@ -3533,6 +5013,8 @@ ViewerCurrentFrameRequestScheduler::onQuitRequested(bool allowRestarts)
 void
 ViewerCurrentFrameRequestScheduler::onWaitForThreadToQuit()
 {
+    _imp->stopIdleCaching();
+    _imp->idleCacheThreadPool.waitForDone();
     _imp->waitForRunnableTasks();
     _imp->backupThread.waitForThreadToQuit_enforce_blocking();
 }
@@ -3540,6 +5022,7 @@ ViewerCurrentFrameRequestScheduler::onWaitForThreadToQuit()
 void
 ViewerCurrentFrameRequestScheduler::onWaitForAbortCompleted()
 {
+    _imp->idleCacheThreadPool.waitForDone();
     _imp->waitForRunnableTasks();
     _imp->backupThread.waitForAbortToComplete_enforce_blocking();
 }
@@ -3568,13 +5051,85 @@ ViewerCurrentFrameRequestScheduler::renderCurrentFrameInternal(const boost::shar
         boost::shared_ptr<RenderCurrentFrameFunctorRunnable> task(new RenderCurrentFrameFunctorRunnable(args));
         task->setAutoDelete(false);
         _imp->appendRunnableTask(task);
-        _imp->threadPool->start(task.get());
+        _imp->threadPool->start( task.get(), (int)eRenderPriorityInteractive );
     }
 
 } // renderCurrentFrameInternal
 
+void
+ViewerCurrentFrameRequestScheduler::onRefineTimerTimeout()
+{
+    bool enableRenderStats;
+    {
+        QMutexLocker k(&_imp->renderAgeMutex);
+        // Another render was requested since the draft was launched
+        if ( (_imp->refineRequestAge == 0) || (_imp->refineRequestAge != _imp->renderAge - 1) ) {
+            return;
+        }
+        _imp->refineRequestAge = 0;
+        enableRenderStats = _imp->refineWithStats;
+    }
+    launchCurrentFrameRender(enableRenderStats, false /*allowProgressiveDraft*/);
+}
+
+void
+ViewerCurrentFrameRequestScheduler::onIdleCacheTimerTimeout()
+{
+    if ( !appPTR->getCurrentSettings()->isViewerIdleCachingEnabled() ) {
+        return;
+    }
+    ViewerNodePtr viewerNode = _imp->viewer->isEffectViewerNode();
+    if ( !viewerNode || !viewerNode->isViewerUIVisible() ) {
+        return;
+    }
+
+    // The user is still interacting: scrubbing, painting or tracking
+    AppInstancePtr app = viewerNode->getApp();
+    if ( app->isDraftRenderEnabled() || app->getActiveRotoDrawingStroke() || viewerNode->isDoingPartialUpdates() ) {
+        return;
+    }
+
+    // The playback already renders the frames
+    RenderEnginePtr engine = _imp->viewer->getRenderEngine();
+    if ( engine && engine->isDoingSequentialRender() ) {
+        return;
+    }
+    {
+        QMutexLocker k(&_imp->renderAgeMutex);
+        if ( !_imp->currentRenders.empty() ) {
+            return;
+        }
+    }
+
+    TimeValue time( viewerNode->getTimeline()->currentFrame() );
+    int viewsCount = viewerNode->getRenderViewsCount();
+    ViewIdx view = viewsCount > 0 ? viewerNode->getCurrentRenderView() : ViewIdx(0);
+
+    // Same frame range as the playback, see ViewerDisplayScheduler::getFrameRangeToRender
+    int left, right;
+    {
+        ViewerNodePtr leadViewer = app->getLastViewerUsingTimeline();
+        ViewerNodePtr v = leadViewer ? leadViewer : viewerNode;
+        v->getTimelineBounds(&left, &right);
+    }
+
+    U64 generation;
+    {
+        QMutexLocker k(&_imp->idleCacheMutex);
+        ++_imp->idleCacheGeneration;
+        generation = _imp->idleCacheGeneration;
+    }
+    _imp->idleCacheThreadPool.start( new ViewerIdleCacheRunnable( _imp.get(), viewerNode, time, TimeValue(left), TimeValue(right), view, generation ) );
+} // onIdleCacheTimerTimeout
+
 void
 ViewerCurrentFrameRequestScheduler::renderCurrentFrame(bool enableRenderStats)
+{
+    launchCurrentFrameRender(enableRenderStats, appPTR->getCurrentSettings()->isProgressiveViewerRenderEnabled());
+}
+
+void
+ViewerCurrentFrameRequestScheduler::launchCurrentFrameRender(bool enableRenderStats, bool allowProgressiveDraft)
 {
     // Sanity check, also do not render viewer that are not made visible by the user
     NodePtr treeRoot = _imp->viewer;
@@ -3583,9 +5138,6 @@ ViewerCurrentFrameRequestScheduler::renderCurrentFrame(bool enableRenderStats)
         return;
     }
 
-    // We are about to trigger a new render, cancel all other renders except the oldest so user gets some feedback.
-    onAbortRequested(true /*keepOldestRender*/);
-
     // Get the frame/view to render
     TimeValue frame;
     ViewIdx view;
@@ -3604,6 +5156,18 @@ ViewerCurrentFrameRequestScheduler::renderCurrentFrame(bool enableRenderStats)
     // While painting, use a single render thread and always the same thread.
     RotoStrokeItemPtr curStroke = _imp->viewer->getApp()->getActiveRotoDrawingStroke();
 
+    // Render a draft first if the full resolution render is slow. Draft renders (e.g: when dragging a slider) are not refined
+    // until the draft mode is turned off, which triggers a new render anyway.
+    bool isProgressiveDraft = allowProgressiveDraft && !curStroke && !isTracking && !viewerNode->getApp()->isDraftRenderEnabled();
+    if (isProgressiveDraft) {
+        QMutexLocker k(&_imp->renderAgeMutex);
+        isProgressiveDraft = _imp->lastFullRenderTime > NATRON_VIEWER_PROGRESSIVE_MIN_RENDER_TIME;
+    }
+
+    // We are about to trigger a new render, cancel all other renders except the oldest so user gets some feedback.
+    // A progressive draft gives feedback quickly: the other renders are all aborted.
+    onAbortRequested(!isProgressiveDraft /*keepOldestRender*/);
+
 
     // Ok we have to render at least one of A or B input
     boost::shared_ptr<CurrentFrameFunctorArgs> functorArgs( new CurrentFrameFunctorArgs(view,
@@ -3612,6 +5176,7 @@ ViewerCurrentFrameRequestScheduler::renderCurrentFrame(bool enableRenderStats)
                                                                                         _imp->viewer,
                                                                                         _imp.get(),
                                                                                         curStroke) );
+    functorArgs->isProgressiveDraft = isProgressiveDraft;
 
 
 
@@ -3626,6 +5191,8 @@ ViewerCurrentFrameRequestScheduler::renderCurrentFrame(bool enableRenderStats)
         } else {
             ++_imp->renderAge;
         }
+        _imp->refineRequestAge = isProgressiveDraft ? functorArgs->age : 0;
+        _imp->refineWithStats = enableRenderStats;
     }
 
     // When painting, limit the number of threads to 1 to be sure strokes are painted in the right order
@@ -27,6 +27,7 @@
 
 #include "Global/Macros.h"
 
+#include <list>
 #include <vector>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
@@ -224,6 +225,38 @@ public:
     void notifyFrameRendered(const BufferedFrameContainerPtr& stats,
                              SchedulingPolicyEnum policy);
 
+    /**
+     * @brief Called by the render threads when they rendered the input of the writer and queued the frame
+     * to the FrameEncodeQueue: this starts rendering the next frames while the frame is encoded.
+     * The frame is then reported with notifyFrameRendered() when it is written.
+     **/
+    void notifyFrameRenderStageFinished(double renderTime);
+
+    /**
+     * @brief Returns the encode stage of the render in progress if the frames are rendered by a writer
+     * with the eSchedulingPolicyFFA policy, NULL otherwise. See FrameEncodeQueue.
+     **/
+    FrameEncodeQueue* getFrameEncodeQueue() const;
+
+    /**
+     * @brief Removes from views the views of the frame whose image written by the given writer exists and either:
+     * - the incremental render is enabled on the engine and its hash is the one stored in the -hash.txt file next to it
+     * - the render resumes an interrupted render which wrote it, see startCheckpoint()
+     * This does nothing for writers that do not write a file per frame.
+     **/
+    void removeUpToDateViews(const NodePtr& writer, TimeValue time, std::vector<ViewIdx>* views) const;
+
+    /**
+     * @brief Must be called once the given views of the frame are written by the writer: this stores the hash of the
+     * writer next to the image of each view when the incremental render is enabled, and records the frame in the checkpoint.
+     **/
+    void onFrameWritten(const NodePtr& writer, TimeValue time, const std::vector<ViewIdx>& views) const;
+
+    /**
+     * @brief Runs the after frame render callback of the output node for the given frame. If the callback is asynchronous
+     * (see EffectInstance::isAfterFrameRenderCallbackAsynchronous()), it is queued to be run on a dedicated thread and
+     * this returns immediately, unless too many callbacks are already waiting to be run.
+     **/
     void runAfterFrameRenderedCallback(TimeValue frame);
 
     /**
@@ -250,6 +283,13 @@ public:
      **/
     int getNActiveRenderThreads() const;
 
+    /**
+     * @brief When the renders cannot keep up with the desired FPS and the real-time playback is enabled in the settings,
+     * this is how much the frames should be degraded: 0 means the frames are rendered normally, 1 means they are rendered in
+     * draft mode and each level above adds a mipmap level.
+     **/
+    int getPlaybackDegradationLevel() const;
+
     /**
      * @brief Called by the render-threads when mustQuit() is true on the thread
      **/
@@ -275,9 +315,25 @@ public:
      **/
     virtual SchedulingPolicyEnum getSchedulingPolicy() const = 0;
 
-    RenderEngine* getEngine() const;
+    /**
+     * @brief Returns the priority class of the frames rendered in the thread pool
+     **/
+    virtual RenderPriorityEnum getRenderPriority() const = 0;
 
+    RenderEngine* getEngine() const;
 
+    /**
+     * @brief Called by the render threads when they start rendering the given frame of the tree below treeRoot:
+     * decodes the next frames in the render direction of the readers upstream of treeRoot on dedicated threads,
+     * at the given scale, so that they are in the cache when the render threads reach them. See ReadNodePrefetcher.
+     * The videos are decoded in order by the prefetcher: this then waits for the frame at the given time of the videos.
+     * This does nothing if a single frame is rendered or if the cache is nearly full.
+     **/
+    void prefetchReadersAhead(const NodePtr& treeRoot,
+                              TimeValue time,
+                              const std::vector<ViewIdx>& viewsToRender,
+                              unsigned int mipMapLevel,
+                              bool draftMode);
 
 Q_SIGNALS:
 
@@ -369,6 +425,14 @@ private:
 
     void startRender();
 
+    /**
+     * @brief Called when a render starts. When rendering from the command line with a writer writing a file per frame,
+     * the frames written are recorded in a -checkpoint.txt file named after its output files. The first render of the
+     * output in the process starts a new checkpoint, unless the engine resumes the render of the previous process:
+     * the frames listed in the checkpoint are then skipped if their image still has the size it had when written.
+     **/
+    void startCheckpoint();
+
     void stopRender();
 
 
@@ -376,6 +440,8 @@ private:
     
     void startTasks(TimeValue startingFrame);
 
+    void runAfterFrameRenderedCallbackNow(TimeValue frame);
+
     friend struct OutputSchedulerThreadPrivate;
     boost::scoped_ptr<OutputSchedulerThreadPrivate> _imp;
 };
@@ -397,6 +463,8 @@ public:
 
     virtual SchedulingPolicyEnum getSchedulingPolicy() const OVERRIDE FINAL;
 
+    virtual RenderPriorityEnum getRenderPriority() const OVERRIDE FINAL { return eRenderPriorityWrite; }
+
 
 private:
 
@@ -432,6 +500,13 @@ public:
 
     virtual SchedulingPolicyEnum getSchedulingPolicy() const OVERRIDE FINAL { return eSchedulingPolicyOrdered; }
 
+    virtual RenderPriorityEnum getRenderPriority() const OVERRIDE FINAL { return eRenderPriorityInteractive; }
+
+    /**
+     * @brief The images displayed during playback, re-used when a frame is played again, see Settings::isViewerFlipbookEnabled()
+     **/
+    ViewerFlipbookCache* getFlipbookCache() const;
+
 private:
 
 
@@ -449,6 +524,8 @@ private:
 
     virtual TimeValue getLastRenderedTime() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual void onRenderStopped(bool aborted) OVERRIDE FINAL;
+
+    boost::scoped_ptr<ViewerFlipbookCache> _flipbookCache;
 };
 
 /**
@@ -491,11 +568,26 @@ public Q_SLOTS:
 
     void onDoProcessFrameOnMainThreadReceived(U64 age, const BufferedFrameContainerPtr& frames);
 
+    void onRefineTimerTimeout();
+
+    /**
+     * @brief Renders the frames around the current frame into the cache when the user did not do anything for a while,
+     * see Settings::isViewerIdleCachingEnabled()
+     **/
+    void onIdleCacheTimerTimeout();
+
 Q_SIGNALS:
 
     void doProcessFrameOnMainThread(U64 age, BufferedFrameContainerPtr frames);
 private:
 
+    /**
+     * @brief Launches the render of the current frame. If allowProgressiveDraft is true and the full resolution render is slow,
+     * a draft is rendered at a coarser mipmap level and displayed first, then it is refined at full resolution
+     * when no other render was requested for a short while.
+     **/
+    void launchCurrentFrameRender(bool enableRenderStats, bool allowProgressiveDraft);
+
     void renderCurrentFrameInternal(const boost::shared_ptr<CurrentFrameFunctorArgs>& args, bool useSingleThread);
 
     boost::scoped_ptr<ViewerCurrentFrameRequestSchedulerPrivate> _imp;
@@ -552,6 +644,35 @@ public:
 
     NodePtr getOutput() const;
 
+    /**
+     * @brief Sets the other Write nodes rendered together with the output by the next calls to renderFrameRange():
+     * each frame of all the outputs is rendered by a single TreeRender, so that the images they have in common
+     * upstream are rendered once. The frame range of the output is used for all of them.
+     **/
+    void setExtraOutputNodes(const std::list<NodePtr>& nodes);
+    std::list<NodePtr> getExtraOutputNodes() const;
+
+    /**
+     * @brief Sets the stream to which the next calls to renderFrameRange() send the frames in input of the output
+     * instead of rendering the output. The frames are then rendered in order, see FrameStreamWriter.
+     **/
+    void setFrameStreamWriter(const FrameStreamWriterPtr& stream);
+    FrameStreamWriterPtr getFrameStreamWriter() const;
+
+    /**
+     * @brief If enabled, the next calls to renderFrameRange() skip the frames whose image exists and whose hash
+     * is the one stored next to it by the previous render, see OutputSchedulerThread::removeUpToDateViews()
+     **/
+    void setIncrementalRenderEnabled(bool enabled);
+    bool isIncrementalRenderEnabled() const;
+
+    /**
+     * @brief If enabled, the next render of the output skips the frames completed by the interrupted render
+     * of a previous process, see OutputSchedulerThread::startCheckpoint()
+     **/
+    void setResumeEnabled(bool enabled);
+    bool isResumeEnabled() const;
+
     /**
      * @brief Call this to render from firstFrame to lastFrame included.
      **/
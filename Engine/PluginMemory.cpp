@@ -24,8 +24,10 @@
 
 #include "PluginMemory.h"
 
+#include <map>
 #include <vector>
 #include <cassert>
+#include <cstdlib>
 #include <stdexcept>
 
 CLANG_DIAG_OFF(deprecated)
@@ -33,18 +35,182 @@ CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_ON(deprecated)
 #include "Engine/AppManager.h"
 #include "Engine/Cache.h"
-#include "Engine/RamBuffer.h"
+
+// Allocations below this size are not pooled: malloc already serves them from its free lists without page faults
+#define NATRON_PLUGIN_MEMORY_POOL_MIN_SIZE 65536
+
+// Number of size classes between two powers of two. An allocation wastes at most 1 / this of its size.
+#define NATRON_PLUGIN_MEMORY_POOL_CLASSES_PER_OCTAVE 4
+
+// The idle buffers kept by the pool may not take more than this fraction of the maximum size of the tile cache
+#define NATRON_PLUGIN_MEMORY_POOL_MAX_CACHE_RATIO 0.05
+
 NATRON_NAMESPACE_ENTER;
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Keeps the large buffers freed by plug-ins to serve their next allocations.
+ * Plug-ins allocate and free the same temporary buffers for each render: re-using them avoids
+ * the page faults of fresh mmap'ed memory and the fragmentation of the heap on long renders.
+ * Buffers are rounded up to size classes so that buffers of slightly different sizes can be re-used.
+ **/
+class PluginMemoryPool
+{
+public:
+
+    PluginMemoryPool()
+    : _lock()
+    , _idleBuffers()
+    , _idleBytes(0)
+    {
+    }
+
+    ~PluginMemoryPool()
+    {
+        trim();
+    }
+
+    /**
+     * @brief Returns the size of the buffer actually allocated for nBytes
+     **/
+    static std::size_t getClassSize(std::size_t nBytes)
+    {
+        if (nBytes < NATRON_PLUGIN_MEMORY_POOL_MIN_SIZE) {
+            return nBytes;
+        }
+        std::size_t octave = NATRON_PLUGIN_MEMORY_POOL_MIN_SIZE;
+        while (octave * 2 <= nBytes) {
+            octave *= 2;
+        }
+        std::size_t step = octave / NATRON_PLUGIN_MEMORY_POOL_CLASSES_PER_OCTAVE;
+
+        return ( (nBytes + step - 1) / step ) * step;
+    }
+
+    void* allocate(std::size_t classSize)
+    {
+        if (classSize >= NATRON_PLUGIN_MEMORY_POOL_MIN_SIZE) {
+            QMutexLocker k(&_lock);
+            std::map<std::size_t, std::vector<void*> >::iterator found = _idleBuffers.find(classSize);
+            if ( (found != _idleBuffers.end()) && !found->second.empty() ) {
+                void* ret = found->second.back();
+                found->second.pop_back();
+                _idleBytes -= classSize;
+
+                return ret;
+            }
+        }
+
+        return std::malloc(classSize);
+    }
+
+    void release(void* buffer, std::size_t classSize)
+    {
+        if (classSize >= NATRON_PLUGIN_MEMORY_POOL_MIN_SIZE) {
+            std::size_t maxIdleBytes = getMaxIdleBytes();
+            QMutexLocker k(&_lock);
+            if (_idleBytes + classSize <= maxIdleBytes) {
+                _idleBuffers[classSize].push_back(buffer);
+                _idleBytes += classSize;
+
+                return;
+            }
+        }
+        std::free(buffer);
+    }
+
+    std::size_t trim()
+    {
+        std::map<std::size_t, std::vector<void*> > buffers;
+        std::size_t ret;
+        {
+            QMutexLocker k(&_lock);
+            buffers.swap(_idleBuffers);
+            ret = _idleBytes;
+            _idleBytes = 0;
+        }
+        for (std::map<std::size_t, std::vector<void*> >::const_iterator it = buffers.begin(); it != buffers.end(); ++it) {
+            for (std::size_t i = 0; i < it->second.size(); ++i) {
+                std::free(it->second[i]);
+            }
+        }
+
+        return ret;
+    }
+
+    std::size_t getIdleBytes() const
+    {
+        QMutexLocker k(&_lock);
+
+        return _idleBytes;
+    }
+
+private:
+
+    static std::size_t getMaxIdleBytes()
+    {
+        // The pool is part of the memory budget of the cache
+        CacheBasePtr tileCache = appPTR ? appPTR->getTileCache() : CacheBasePtr();
+        if (!tileCache) {
+            return 0;
+        }
+
+        return (std::size_t)(tileCache->getMaximumCacheSize() * NATRON_PLUGIN_MEMORY_POOL_MAX_CACHE_RATIO);
+    }
+
+    mutable QMutex _lock;
+
+    // The idle buffers of each size class
+    std::map<std::size_t, std::vector<void*> > _idleBuffers;
+
+    // The sum of the sizes of the idle buffers
+    std::size_t _idleBytes;
+};
+
+PluginMemoryPool&
+getPluginMemoryPool()
+{
+    static PluginMemoryPool pool;
+
+    return pool;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 struct PluginMemory::Implementation
 {
     Implementation()
-    : data()
+    : data(0)
+    , size(0)
+    , classSize(0)
     , mutex()
     {
     }
 
-    RamBuffer<char> data;
+    ~Implementation()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        if (data) {
+            getPluginMemoryPool().release(data, classSize);
+        }
+        data = 0;
+        size = classSize = 0;
+    }
+
+    // The buffer, taken from the pool
+    char* data;
+
+    // The size requested by the plug-in
+    std::size_t size;
+
+    // The size of data
+    std::size_t classSize;
+
     QMutex mutex;
 };
 
@@ -62,7 +228,7 @@ PluginMemory::~PluginMemory()
 std::size_t
 PluginMemory::getBufferSize() const
 {
-    return _imp->data.size();
+    return _imp->size;
 }
 
 void
@@ -72,14 +238,24 @@ PluginMemory::allocateMemoryImpl(const AllocateMemoryArgs& args)
     assert(thisArgs);
 
     QMutexLocker l(&_imp->mutex);
-    _imp->data.resize(thisArgs->_nBytes);
+    if (thisArgs->_nBytes == 0) {
+        return;
+    }
+    _imp->clear();
+    std::size_t classSize = PluginMemoryPool::getClassSize(thisArgs->_nBytes);
+    _imp->data = (char*)getPluginMemoryPool().allocate(classSize);
+    if (!_imp->data) {
+        throw std::bad_alloc();
+    }
+    _imp->size = thisArgs->_nBytes;
+    _imp->classSize = classSize;
 }
 
 void
 PluginMemory::deallocateMemoryImpl()
 {
     QMutexLocker l(&_imp->mutex);
-    _imp->data.clear();
+    _imp->clear();
 
 }
 
@@ -89,9 +265,21 @@ PluginMemory::getData()
 {
     QMutexLocker l(&_imp->mutex);
 
-    assert( _imp->data.size() == 0 || ( _imp->data.size() > 0 && _imp->data.getData() ) );
+    assert( _imp->size == 0 || ( _imp->size > 0 && _imp->data ) );
 
-    return _imp->data.getData();
+    return _imp->data;
+}
+
+std::size_t
+PluginMemory::trimPool()
+{
+    return getPluginMemoryPool().trim();
+}
+
+std::size_t
+PluginMemory::getPoolIdleBytes()
+{
+    return getPluginMemoryPool().getIdleBytes();
 }
 
 NATRON_NAMESPACE_EXIT;
@@ -80,6 +80,17 @@ public:
         return eStorageModeRAM;
     }
 
+    /**
+     * @brief The large buffers freed by plug-ins are kept in a pool to serve their next allocations.
+     * This frees the idle buffers of the pool and returns the number of bytes freed.
+     **/
+    static std::size_t trimPool();
+
+    /**
+     * @brief Returns the size in bytes of the idle buffers of the pool.
+     **/
+    static std::size_t getPoolIdleBytes();
+
 private:
 
     virtual void allocateMemoryImpl(const AllocateMemoryArgs& args) OVERRIDE FINAL;
@@ -25,6 +25,7 @@
 #include "PrecompNode.h"
 
 #include <cassert>
+#include <cstring>
 #include <stdexcept>
 #include <sstream> // stringstream
 
@@ -34,10 +35,16 @@
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QTextStream>
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
 #include <ofxNatron.h>
+#include <SequenceParsing.h>
 
 #include "Engine/AppInstance.h"
 #include "Engine/AppManager.h"
@@ -45,17 +52,30 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/CreateNodeArgs.h"
 #include "Engine/Node.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/FileSystemModel.h"
+#include "Engine/Hash64.h"
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/KnobFile.h"
 #include "Engine/Project.h"
 #include "Engine/RenderQueue.h"
 #include "Engine/Settings.h"
+#include "Engine/StandardPaths.h"
 #include "Engine/TimeLine.h"
 #include "Engine/ViewIdx.h"
 
 #include "Serialization/KnobSerialization.h"
 
+#define kPrecompNodeParamLoadOnDemand "loadOnDemand"
+#define kPrecompNodeParamLoadOnDemandLabel "Load Project On Demand"
+#define kPrecompNodeParamLoadOnDemandHint "When checked, the pre-rendered images are recorded in the cache location along with a hash of the project file, " \
+    "of the Write node and of the frame-range. When the project is opened again, in this process or any other (e.g: a render farm), " \
+    "and the project file did not change, the pre-rendered images are read directly without loading the pre-comp project. " \
+    "The project is only loaded when it is needed: when Pre-Render is unchecked, when the Write node is changed or when Render is pressed."
+
+// The directory, in the cache location, where the pre-rendered results of the pre-comps are recorded
+#define NATRON_PRECOMP_RESULTS_DIRECTORY_NAME "PrecompResults"
+
 
 NATRON_NAMESPACE_ENTER;
 
@@ -97,8 +117,12 @@ public:
     KnobStringWPtr outputNodeNameKnob;
     KnobChoiceWPtr errorBehaviourKnbo;
     KnobStringWPtr subLabelKnob;
+    KnobBoolWPtr loadOnDemandKnob;
     QMutex dataMutex;
 
+    // False as long as the pre-comp project was not loaded because its pre-rendered images were found in the results
+    bool projectLoaded;
+
     // To read-back the pre-comp image sequence/video
     NodePtr readNode;
     NodePtr subProjectOutputNode;
@@ -119,7 +143,9 @@ public:
     , outputNodeNameKnob()
     , errorBehaviourKnbo()
     , subLabelKnob()
+    , loadOnDemandKnob()
     , dataMutex()
+    , projectLoaded(false)
     , readNode()
     , subProjectOutputNode()
     , groupOutputNode()
@@ -130,8 +156,18 @@ public:
 
     void reloadProject(bool setWriteNodeChoice);
 
+    void ensureProjectLoaded();
+
+    std::string getResultFilePath() const;
+
+    bool loadFromResult();
+
+    void writeResult();
+
     void createReadNode();
 
+    void createReadNodeForPattern(const std::string& pattern);
+
     void setReadNodeErrorChoice();
 
     void setFirstAndLastFrame();
@@ -244,6 +280,16 @@ PrecompNode::initializeKnobs()
         _imp->enablePreRenderKnob = param;
     }
 
+    {
+        KnobBoolPtr param = createKnob<KnobBool>(kPrecompNodeParamLoadOnDemand);
+        param->setLabel(tr(kPrecompNodeParamLoadOnDemandLabel));
+        param->setHintToolTip( tr(kPrecompNodeParamLoadOnDemandHint) );
+        param->setAnimationEnabled(false);
+        param->setEvaluateOnChange(false);
+        mainPage->addKnob(param);
+        _imp->loadOnDemandKnob = param;
+    }
+
     KnobGroupPtr renderGroup = createKnob<KnobGroup>("preRenderSettings");
     renderGroup->setLabel(tr("Pre-Render Settings"));
     renderGroup->setDefaultValue(true);
@@ -330,7 +376,10 @@ PrecompNode::initializeKnobs()
 void
 PrecompNode::onKnobsLoaded()
 {
-    _imp->reloadProject(false);
+    // The project is not loaded if its pre-rendered images can be read directly
+    if ( !_imp->loadFromResult() ) {
+        _imp->reloadProject(false);
+    }
     _imp->refreshKnobsVisibility();
 }
 
@@ -349,17 +398,27 @@ PrecompNode::knobChanged(const KnobIPtr& k,
         AppInstancePtr appInstance = getApp()->loadProject(filename);
         Q_UNUSED(appInstance);
     } else if ( k == _imp->preRenderKnob.lock() ) {
+        _imp->ensureProjectLoaded();
         _imp->launchPreRender();
     } else if ( k == _imp->outputNodeNameKnob.lock() ) {
+        _imp->ensureProjectLoaded();
         _imp->refreshOutputNode();
     } else if ( k == _imp->writeNodesKnob.lock() ) {
+        _imp->ensureProjectLoaded();
         _imp->createReadNode();
         _imp->setFirstAndLastFrame();
     } else if ( k == _imp->errorBehaviourKnbo.lock() ) {
         _imp->setReadNodeErrorChoice();
     } else if ( k == _imp->enablePreRenderKnob.lock() ) {
         _imp->refreshKnobsVisibility();
+        if ( !_imp->enablePreRenderKnob.lock()->getValue() ) {
+            // The output node is in the pre-comp project
+            _imp->ensureProjectLoaded();
+        }
         _imp->refreshOutputNode();
+    } else if ( (reason == eValueChangedReasonUserEdited) && ( k == _imp->loadOnDemandKnob.lock() ) ) {
+        // Record the images already pre-rendered
+        _imp->writeResult();
     } else {
         ret = false;
     }
@@ -413,6 +472,8 @@ PrecompNodePrivate::reloadProject(bool setWriteNodeChoice)
 
     QString path = file.path() + QLatin1Char('/');
 
+    projectLoaded = true;
+
     ProjectPtr project = app.lock()->getProject();
     project->resetProject();
     {
@@ -438,6 +499,136 @@ PrecompNodePrivate::reloadProject(bool setWriteNodeChoice)
     refreshOutputNode();
 }
 
+void
+PrecompNodePrivate::ensureProjectLoaded()
+{
+    if (!projectLoaded) {
+        reloadProject(false);
+    }
+}
+
+std::string
+PrecompNodePrivate::getResultFilePath() const
+{
+    std::string filename = projectFileNameKnob.lock()->getValue();
+    QFile file( QString::fromUtf8( filename.c_str() ) );
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        return std::string();
+    }
+
+    // The result only depends on the content of the project file, the Write node rendering it and the frame-range
+    Hash64 hash;
+    {
+        QByteArray content = file.readAll();
+        std::vector<U64> words( (content.size() + sizeof(U64) - 1) / sizeof(U64), 0 );
+        if ( !words.empty() ) {
+            memcpy( &words[0], content.constData(), content.size() );
+        }
+        hash.append( (U64)content.size() );
+        hash.insert(words);
+    }
+    Hash64::appendString(writeNodesKnob.lock()->getActiveEntry().id, &hash);
+    hash.append( firstFrameKnob.lock()->getValue() );
+    hash.append( lastFrameKnob.lock()->getValue() );
+    hash.computeHash();
+
+    QString dirPath = StandardPaths::writableLocation(StandardPaths::eStandardLocationCache) + QLatin1Char('/') + QString::fromUtf8(NATRON_PRECOMP_RESULTS_DIRECTORY_NAME);
+    QString fileName = QString::fromUtf8("%1.txt").arg(hash.value(), 16, 16, QLatin1Char('0'));
+
+    return ( dirPath + QLatin1Char('/') + fileName ).toStdString();
+} // getResultFilePath
+
+bool
+PrecompNodePrivate::loadFromResult()
+{
+    if ( !enablePreRenderKnob.lock()->getValue() || !loadOnDemandKnob.lock()->getValue() ) {
+        return false;
+    }
+    std::string resultFilePath = getResultFilePath();
+    if ( resultFilePath.empty() ) {
+        return false;
+    }
+    QFile resultFile( QString::fromUtf8( resultFilePath.c_str() ) );
+    if ( !resultFile.open(QIODevice::ReadOnly | QIODevice::Text) ) {
+        return false;
+    }
+    QTextStream ts(&resultFile);
+    std::string pattern = ts.readLine().toStdString();
+    if ( pattern.empty() ) {
+        return false;
+    }
+
+    // The images may have been removed since they were recorded
+    SequenceParsing::SequenceFromPattern seq;
+    FileSystemModel::filesListFromPattern(pattern, &seq);
+    if ( seq.empty() ) {
+        return false;
+    }
+
+    QFileInfo file( QString::fromUtf8( projectFileNameKnob.lock()->getValue().c_str() ) );
+    subLabelKnob.lock()->setValue( file.fileName().toStdString() );
+
+    createReadNodeForPattern(pattern);
+    refreshOutputNode();
+
+    return true;
+} // loadFromResult
+
+void
+PrecompNodePrivate::writeResult()
+{
+    if ( !projectLoaded || !loadOnDemandKnob.lock()->getValue() ) {
+        return;
+    }
+    NodePtr writeNode = getWriteNodeFromPreComp();
+    if (!writeNode) {
+        return;
+    }
+    KnobFilePtr fileKnob = toKnobFile( writeNode->getKnobByName(kOfxImageEffectFileParamName) );
+    if (!fileKnob) {
+        return;
+    }
+
+    // The pattern is read without the pre-comp project: it must not depend on its variables
+    std::string pattern = fileKnob->getValue();
+    app.lock()->getProject()->canonicalizePath(pattern);
+
+    // Only record the images once all the frames were rendered
+    SequenceParsing::SequenceFromPattern seq;
+    FileSystemModel::filesListFromPattern(pattern, &seq);
+    int first = firstFrameKnob.lock()->getValue();
+    int last = lastFrameKnob.lock()->getValue();
+    if ( seq.empty() || ( (seq.size() > 1) && ( (seq.begin()->first > first) || (seq.rbegin()->first < last) ) ) ) {
+        return;
+    }
+
+    std::string resultFilePath = getResultFilePath();
+    if ( resultFilePath.empty() ) {
+        return;
+    }
+    QString qResultFilePath = QString::fromUtf8( resultFilePath.c_str() );
+    QString dirPath = QFileInfo(qResultFilePath).absolutePath();
+    if ( !QDir().mkpath(dirPath) ) {
+        return;
+    }
+
+    // Write to a temporary file renamed once complete, so that other processes never read a partial file
+    QTemporaryFile tmpFile( dirPath + QString::fromUtf8("/XXXXXX.tmp") );
+    if ( !tmpFile.open() ) {
+        return;
+    }
+    {
+        QTextStream ts(&tmpFile);
+        ts << QString::fromUtf8( pattern.c_str() ) << '\n';
+    }
+    tmpFile.close();
+    tmpFile.setAutoRemove(false);
+    QFile::remove(qResultFilePath);
+    if ( !QFile::rename(tmpFile.fileName(), qResultFilePath) ) {
+        QFile::remove( tmpFile.fileName() );
+    }
+} // writeResult
+
 void
 PrecompNodePrivate::populateWriteNodesChoice(bool setWriteNodeChoice)
 {
@@ -525,7 +716,12 @@ PrecompNodePrivate::createReadNode()
         return;
     }
 
-    std::string pattern = fileKnob->getValue();
+    createReadNodeForPattern( fileKnob->getValue() );
+} // PrecompNodePrivate::createReadNode
+
+void
+PrecompNodePrivate::createReadNodeForPattern(const std::string& pattern)
+{
     QString qpattern = QString::fromUtf8( pattern.c_str() );
     std::string ext = QtCompat::removeFileExtension(qpattern).toLower().toStdString();
     std::string found = appPTR->getReaderPluginIDForFileType(ext);
@@ -564,7 +760,7 @@ PrecompNodePrivate::createReadNode()
         QMutexLocker k(&dataMutex);
         readNode = read;
     }
-} // PrecompNodePrivate::createReadNode
+} // PrecompNodePrivate::createReadNodeForPattern
 
 void
 PrecompNodePrivate::refreshOutputNode()
@@ -684,6 +880,7 @@ PrecompNode::onPreRenderFinished()
         }
     }
     _imp->refreshReadNodeInput();
+    _imp->writeResult();
 }
 
 void
@@ -0,0 +1,211 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ProcessLocalBuffer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <new>
+#include <algorithm>
+
+#ifdef __NATRON_LINUX__
+#include <sys/mman.h>      // mmap, munmap, madvise
+#include <sys/syscall.h>   // SYS_mbind
+#include <unistd.h>        // syscall, access
+#endif
+
+// The size of the huge pages mapped with MAP_HUGETLB: mappings are rounded up to it
+#define NATRON_HUGE_PAGE_SIZE ((std::size_t)2 << 20)
+
+// From <linux/mempolicy.h>, which is not available on all distributions
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE 3
+#endif
+
+NATRON_NAMESPACE_ENTER;
+
+ProcessLocalBuffer::ProcessLocalBuffer()
+: _data(0)
+, _size(0)
+, _mappedSize(0)
+, _pageType(ePageTypeDefault)
+, _interleaveNUMANodes(false)
+{
+}
+
+ProcessLocalBuffer::~ProcessLocalBuffer()
+{
+    clear();
+}
+
+void
+ProcessLocalBuffer::setAllocationPolicy(PageTypeEnum pageType, bool interleaveNUMANodes)
+{
+    _pageType = pageType;
+    _interleaveNUMANodes = interleaveNUMANodes;
+}
+
+int
+ProcessLocalBuffer::getNUMANodesCount()
+{
+#ifdef __NATRON_LINUX__
+    static int nNodes = 0;
+    if (nNodes == 0) {
+        int count = 0;
+        for (;;) {
+            char path[64];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", count);
+            if (access(path, F_OK) != 0) {
+                break;
+            }
+            ++count;
+        }
+        nNodes = std::max(1, count);
+    }
+    return nNodes;
+#else
+    return 1;
+#endif
+} // getNUMANodesCount
+
+char*
+ProcessLocalBuffer::allocate(std::size_t size, std::size_t* mappedSize)
+{
+    *mappedSize = 0;
+#ifdef __NATRON_LINUX__
+    bool interleave = _interleaveNUMANodes && getNUMANodesCount() > 1;
+    if (_pageType != ePageTypeDefault || interleave) {
+        void* ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        if (_pageType == ePageTypeExplicitHuge) {
+            std::size_t hugeSize = (size + NATRON_HUGE_PAGE_SIZE - 1) / NATRON_HUGE_PAGE_SIZE * NATRON_HUGE_PAGE_SIZE;
+            ptr = ::mmap(0, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED) {
+                *mappedSize = hugeSize;
+            }
+        }
+#endif
+        if (ptr == MAP_FAILED) {
+            // No huge pages reserved: use transparent huge pages instead
+            ptr = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            *mappedSize = size;
+#ifdef MADV_HUGEPAGE
+            if (_pageType != ePageTypeDefault) {
+                // This is only a hint: it fails if transparent huge pages are disabled
+                ::madvise(ptr, size, MADV_HUGEPAGE);
+            }
+#endif
+        }
+#ifdef SYS_mbind
+        if (interleave) {
+            // The policy must be set before the pages are touched for the first time
+            unsigned long nodeMask = 0;
+            int nNodes = std::min(getNUMANodesCount(), (int)sizeof(unsigned long) * 8);
+            for (int i = 0; i < nNodes; ++i) {
+                nodeMask |= (1UL << i);
+            }
+            ::syscall(SYS_mbind, ptr, *mappedSize, MPOL_INTERLEAVE, &nodeMask, (unsigned long)nNodes + 1, 0);
+        }
+#endif
+        return static_cast<char*>(ptr);
+    }
+#endif // __NATRON_LINUX__
+    char* ret = (char*)malloc(size);
+    if (!ret) {
+        throw std::bad_alloc();
+    }
+    return ret;
+} // allocate
+
+void
+ProcessLocalBuffer::deallocate(char* data, std::size_t mappedSize)
+{
+    if (!data) {
+        return;
+    }
+#ifdef __NATRON_LINUX__
+    if (mappedSize > 0) {
+        ::munmap(data, mappedSize);
+        return;
+    }
+#else
+    (void)mappedSize;
+#endif
+    free(data);
+}
+
+void
+ProcessLocalBuffer::resize(std::size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+    deallocate(_data, _mappedSize);
+    _data = 0;
+    _size = 0;
+    _mappedSize = 0;
+    _data = allocate(size, &_mappedSize);
+    _size = size;
+}
+
+void
+ProcessLocalBuffer::resizeAndPreserve(std::size_t size)
+{
+    if (size == 0 || size == _size) {
+        return;
+    }
+    if (_mappedSize == 0 && _pageType == ePageTypeDefault && !_interleaveNUMANodes) {
+        char* data = (char*)realloc(_data, size);
+        if (!data) {
+            throw std::bad_alloc();
+        }
+        _data = data;
+        _size = size;
+        return;
+    }
+    std::size_t mappedSize;
+    char* data = allocate(size, &mappedSize);
+    if (_data) {
+        std::memcpy(data, _data, std::min(size, _size));
+    }
+    deallocate(_data, _mappedSize);
+    _data = data;
+    _size = size;
+    _mappedSize = mappedSize;
+} // resizeAndPreserve
+
+void
+ProcessLocalBuffer::clear()
+{
+    deallocate(_data, _mappedSize);
+    _data = 0;
+    _size = 0;
+    _mappedSize = 0;
+}
+
+NATRON_NAMESPACE_EXIT;
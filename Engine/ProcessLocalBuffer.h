@@ -0,0 +1,126 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_PROCESSLOCALBUFFER_H
+#define NATRON_ENGINE_PROCESSLOCALBUFFER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief A buffer in process memory used as storage by the cache when it is not persistent.
+ * Unlike RamBuffer, the pages backing the buffer may be huge pages and may be interleaved across
+ * NUMA nodes, see setAllocationPolicy(). Large buffers such as the tile storage benefit from it:
+ * huge pages reduce TLB misses and interleaving spreads the memory bandwidth across all sockets.
+ * This is not MT-safe.
+ **/
+class ProcessLocalBuffer
+{
+public:
+
+    enum PageTypeEnum
+    {
+        // Memory is allocated with malloc
+        ePageTypeDefault = 0,
+
+        // Memory is mapped with the default page size but the kernel is advised to back it with
+        // huge pages (Linux transparent huge pages)
+        ePageTypeTransparentHuge,
+
+        // Memory is mapped from the huge pages reserved by the system administrator (Linux hugetlbfs).
+        // If none are available, this falls back to ePageTypeTransparentHuge.
+        ePageTypeExplicitHuge
+    };
+
+    ProcessLocalBuffer();
+
+    ~ProcessLocalBuffer();
+
+    /**
+     * @brief Set how the memory is allocated by subsequent calls to resize() and resizeAndPreserve().
+     * @param interleaveNUMANodes If true and the system has several NUMA nodes, the pages are interleaved
+     * across all nodes instead of being placed on the node of the thread that first touches them.
+     * On systems other than Linux, memory is always allocated with malloc.
+     **/
+    void setAllocationPolicy(PageTypeEnum pageType, bool interleaveNUMANodes);
+
+    char* getData()
+    {
+        return _data;
+    }
+
+    const char* getData() const
+    {
+        return _data;
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    /**
+     * @brief Re-allocates the buffer to the given size. The previous content is lost.
+     * This function throws a std::bad_alloc if the memory could not be allocated.
+     **/
+    void resize(std::size_t size);
+
+    /**
+     * @brief Same as resize() but the content of the buffer is preserved up to the new size.
+     **/
+    void resizeAndPreserve(std::size_t size);
+
+    void clear();
+
+    /**
+     * @brief Returns the number of NUMA nodes of the system, or 1 if it cannot be determined.
+     **/
+    static int getNUMANodesCount();
+
+private:
+
+    char* allocate(std::size_t size, std::size_t* mappedSize);
+
+    void deallocate(char* data, std::size_t mappedSize);
+
+    char* _data;
+    std::size_t _size;
+
+    // If not 0, _data was mapped with mmap and this is the size of the mapping, otherwise it was allocated with malloc
+    std::size_t _mappedSize;
+
+    PageTypeEnum _pageType;
+    bool _interleaveNUMANodes;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_PROCESSLOCALBUFFER_H
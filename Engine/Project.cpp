@@ -89,6 +89,9 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Serialization/ProjectSerialization.h"
 #include "Serialization/SerializationIO.h"
 
+// Auto-saves only serialize the nodes modified since the previous auto-save: every this many
+// auto-saves, all the nodes are serialized again in case a modification was not notified.
+#define NATRON_AUTOSAVE_FULL_SERIALIZATION_INTERVAL 10
 
 NATRON_NAMESPACE_ENTER;
 
@@ -261,6 +264,13 @@ Project::loadProject(const QString & path,
         return false;
     }
 
+    // With a persistent cache, start reading from the disk the images the viewers are going to display
+    {
+        TimeValue first, last;
+        getFrameRange(&first, &last);
+        prefetchViewersCachedImages(first, last);
+    }
+
     refreshViewersAndPreviews();
 
     return true;
@@ -300,7 +310,8 @@ Project::loadProjectInternal(const QString & pathIn,
 
     bool ret = false;
     FStreamsSupport::ifstream ifile;
-    FStreamsSupport::open( &ifile, filePathOut.toStdString() );
+    // Open in binary mode: the project may have been saved with SERIALIZATION_NAMESPACE::writeBinary()
+    FStreamsSupport::open( &ifile, filePathOut.toStdString(), std::ios_base::in | std::ios_base::binary );
     if (!ifile) {
         throw std::runtime_error( tr("Failed to open %1").arg(filePathOut).toStdString() );
     }
@@ -523,8 +534,9 @@ Project::saveProjectInternal(const QString & path,
     tmpFilename.append( QString::number( time.toMSecsSinceEpoch() ) );
 
     {
+        const bool binaryFormat = appPTR->getCurrentSettings()->isBinaryProjectFormatEnabled();
         FStreamsSupport::ofstream ofile;
-        FStreamsSupport::open( &ofile, tmpFilename.toStdString() );
+        FStreamsSupport::open( &ofile, tmpFilename.toStdString(), binaryFormat ? (std::ios_base::out | std::ios_base::binary) : std::ios_base::out );
         if (!ofile) {
             throw std::runtime_error( tr("Failed to open file ").toStdString() + tmpFilename.toStdString() );
         }
@@ -539,11 +551,37 @@ Project::saveProjectInternal(const QString & path,
             _imp->natronVersion->setValue( generateUserFriendlyNatronVersionName());
         }
 
+        // Auto-saves re-use the serialization of the nodes that were not modified since the previous auto-save
+        if (autoSave) {
+            bool serializeAllNodes = false;
+            {
+                QMutexLocker l(&_imp->projectLock);
+                if (_imp->autoSaveMustSerializeAllNodes || _imp->nAutoSavesSinceFullSerialization >= NATRON_AUTOSAVE_FULL_SERIALIZATION_INTERVAL) {
+                    _imp->autoSaveMustSerializeAllNodes = false;
+                    _imp->nAutoSavesSinceFullSerialization = 0;
+                    serializeAllNodes = true;
+                } else {
+                    ++_imp->nAutoSavesSinceFullSerialization;
+                }
+            }
+            if (serializeAllNodes) {
+                NodesList nodes;
+                getNodes_recursive(nodes, false);
+                for (NodesList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+                    (*it)->invalidateAutoSaveSerialization();
+                }
+            }
+        }
+
         try {
             SERIALIZATION_NAMESPACE::ProjectSerialization projectSerializationObj;
-            toSerialization(&projectSerializationObj);
+            toSerializationInternal(&projectSerializationObj, autoSave);
             appPTR->aboutToSaveProject(&projectSerializationObj);
-            SERIALIZATION_NAMESPACE::write(ofile, projectSerializationObj, NATRON_PROJECT_FILE_HEADER);
+            if (binaryFormat) {
+                SERIALIZATION_NAMESPACE::writeBinary(ofile, projectSerializationObj, NATRON_PROJECT_FILE_HEADER);
+            } else {
+                SERIALIZATION_NAMESPACE::write(ofile, projectSerializationObj, NATRON_PROJECT_FILE_HEADER);
+            }
         } catch (...) {
             if (!autoSave && updateProjectProperties) {
                 ///Reset the old project path in case of failure.
@@ -2571,6 +2609,12 @@ Project::getEnvVarKnob() const
     return _imp->envVars;
 }
 
+void
+Project::setOutputNodesToLoad(const std::list<std::string>& nodeNames)
+{
+    _imp->outputNodesToLoad = nodeNames;
+}
+
 std::string
 Project::getOnProjectLoadCB() const
 {
@@ -2843,15 +2887,28 @@ Project::setTimeLine(const TimeLinePtr& timeline)
 }
 
 
+void
+Project::invalidateAutoSaveSerializations()
+{
+    QMutexLocker l(&_imp->projectLock);
+    _imp->autoSaveMustSerializeAllNodes = true;
+}
+
 void
 Project::toSerialization(SERIALIZATION_NAMESPACE::SerializationObjectBase* serializationBase)
 {
-    // All the code in this function is MT-safe and run in the serialization thread
     SERIALIZATION_NAMESPACE::ProjectSerialization* serialization = dynamic_cast<SERIALIZATION_NAMESPACE::ProjectSerialization*>(serializationBase);
     assert(serialization);
     if (!serialization) {
         return;
     }
+    toSerializationInternal(serialization, false);
+}
+
+void
+Project::toSerializationInternal(SERIALIZATION_NAMESPACE::ProjectSerialization* serialization, bool useAutoSaveSerialization)
+{
+    // All the code in this function is MT-safe and run in the serialization thread
 
     // Serialize nodes
     {
@@ -2867,6 +2924,8 @@ Project::toSerialization(SERIALIZATION_NAMESPACE::SerializationObjectBase* seria
                     if (!state) {
                         continue;
                     }
+                } else if (useAutoSaveSerialization) {
+                    state = (*it)->getAutoSaveSerialization();
                 } else {
                     state.reset( new SERIALIZATION_NAMESPACE::NodeSerialization );
                     (*it)->toSerialization(state.get());
@@ -2983,7 +3042,7 @@ Project::toSerialization(SERIALIZATION_NAMESPACE::SerializationObjectBase* seria
         getApp()->getViewportsProjection(&serialization->_viewportsData);
     }
     
-} // Project::toSerialization
+} // Project::toSerializationInternal
 
 
 
@@ -3063,7 +3122,17 @@ Project::fromSerialization(const SERIALIZATION_NAMESPACE::SerializationObjectBas
 
 
     // Restore the nodes
-    Project::restoreGroupFromSerialization(serialization->_nodes, shared_from_this(),  0);
+    // The onProjectLoaded callback may access any node: only skip nodes that are not needed if there is none
+    SERIALIZATION_NAMESPACE::NodeSerializationList nodesUpstreamOfOutputs;
+    if ( getOnProjectLoadCB().empty() && _imp->filterNodesUpstreamOfOutputs(serialization->_nodes, &nodesUpstreamOfOutputs) ) {
+        Project::restoreGroupFromSerialization(nodesUpstreamOfOutputs, shared_from_this(),  0);
+    } else {
+        Project::restoreGroupFromSerialization(serialization->_nodes, shared_from_this(),  0);
+    }
+
+    // The meta-datas were not refreshed while connecting the nodes, refresh them on all nodes at once
+    getApp()->updateProjectLoadStatus( tr("Refreshing nodes meta-datas") );
+    refreshHashAndMetadataOnAllNodes_parallel();
 
 
 
@@ -101,6 +101,22 @@ public:
      **/
     bool loadProject(const QString & path, const QString & name, bool isUntitledAutosave = false, bool attemptToLoadAutosave = true);
 
+    /**
+     * @brief When set, projects loaded afterwards only create the top-level nodes that the given nodes
+     * (fully specified script-names) depend on: through their inputs, or by referring to them by name
+     * in expressions, links or scripts. This is used by background renders which only need the tree of the
+     * nodes that are rendered. It is ignored if the project has an onProjectLoaded callback.
+     **/
+    void setOutputNodesToLoad(const std::list<std::string>& nodeNames);
+
+    /**
+     * @brief Auto-saves only serialize the nodes that were modified since the previous auto-save, see
+     * Node::getAutoSaveSerialization(). Call this when a change may affect the serialization of nodes other
+     * than the one modified: the next auto-save will serialize all nodes again.
+     * This is MT-safe.
+     **/
+    void invalidateAutoSaveSerializations();
+
 
     /**
      * @brief Saves the project with the given path and name corresponding to a file on disk.
@@ -427,6 +443,8 @@ private:
 
     QString saveProjectInternal(const QString & path, const QString & name, bool autosave, bool updateProjectProperties);
 
+    void toSerializationInternal(SERIALIZATION_NAMESPACE::ProjectSerialization* serialization, bool useAutoSaveSerialization);
+
 
 
     void doResetEnd(bool aboutToQuit);
@@ -25,6 +25,8 @@
 #include "ProjectPrivate.h"
 
 #include <list>
+#include <set>
+#include <cctype> // isalnum
 #include <cassert>
 #include <stdexcept>
 #include <sstream> // stringstream
@@ -53,6 +55,7 @@
 
 #include "Serialization/NodeSerialization.h"
 #include "Serialization/ProjectSerialization.h"
+#include "Serialization/SerializationIO.h"
 
 
 NATRON_NAMESPACE_ENTER;
@@ -88,11 +91,16 @@ ProjectPrivate::ProjectPrivate(Project* project)
     , timeline( new TimeLine(project) )
     , autoSetProjectFormat( appPTR->getCurrentSettings()->isAutoProjectFormatEnabled() )
     , isLoadingProjectMutex()
+    , lastProjectLoaded()
+    , outputNodesToLoad()
     , isLoadingProject(false)
     , isLoadingProjectInternal(false)
     , isSavingProjectMutex()
     , isSavingProject(false)
     , autoSaveTimer( new QTimer() )
+    , autoSaveFutures()
+    , nAutoSavesSinceFullSerialization(0)
+    , autoSaveMustSerializeAllNodes(true)
     , projectClosing(false)
     , tlsData( new TLSHolder<Project::ProjectTLSData>() )
 
@@ -339,6 +347,97 @@ Project::restoreGroupFromSerialization(const SERIALIZATION_NAMESPACE::NodeSerial
     return !mustShowErrorsLog;
 } // ProjectPrivate::restoreGroupFromSerialization
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Adds to tokens all the identifiers (sequences of letters, digits and underscores) found in text
+ **/
+void
+extractIdentifiers(const std::string& text,
+                   std::set<std::string>* tokens)
+{
+    std::size_t start = std::string::npos;
+
+    for (std::size_t i = 0; i <= text.size(); ++i) {
+        bool isIdentifierChar = i < text.size() && ( std::isalnum( (unsigned char)text[i] ) || (text[i] == '_') );
+        if (isIdentifierChar) {
+            if (start == std::string::npos) {
+                start = i;
+            }
+        } else if (start != std::string::npos) {
+            tokens->insert( text.substr(start, i - start) );
+            start = std::string::npos;
+        }
+    }
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+bool
+ProjectPrivate::filterNodesUpstreamOfOutputs(const SERIALIZATION_NAMESPACE::NodeSerializationList& serializedNodes,
+                                             SERIALIZATION_NAMESPACE::NodeSerializationList* filteredNodes) const
+{
+    if ( outputNodesToLoad.empty() ) {
+        return false;
+    }
+
+    std::map<std::string, SERIALIZATION_NAMESPACE::NodeSerializationPtr> nodesByName;
+    for (SERIALIZATION_NAMESPACE::NodeSerializationList::const_iterator it = serializedNodes.begin(); it != serializedNodes.end(); ++it) {
+        nodesByName[(*it)->_nodeScriptName] = *it;
+    }
+
+    std::set<std::string> nodesToLoad;
+    std::list<std::string> nodesToVisit;
+    for (std::list<std::string>::const_iterator it = outputNodesToLoad.begin(); it != outputNodesToLoad.end(); ++it) {
+        // The output may be in a group, e.g: "Group1.Write1": load the top-level group entirely
+        std::string topLevelName = it->substr( 0, it->find('.') );
+        if ( nodesByName.find(topLevelName) == nodesByName.end() ) {
+            // Let the regular loading report the error
+            return false;
+        }
+        if ( nodesToLoad.insert(topLevelName).second ) {
+            nodesToVisit.push_back(topLevelName);
+        }
+    }
+
+    while ( !nodesToVisit.empty() ) {
+        SERIALIZATION_NAMESPACE::NodeSerializationPtr node = nodesByName[nodesToVisit.front()];
+        nodesToVisit.pop_front();
+
+        // Its inputs and masks
+        std::set<std::string> dependencies;
+        for (std::map<std::string, std::string>::const_iterator it = node->_inputs.begin(); it != node->_inputs.end(); ++it) {
+            dependencies.insert(it->second);
+        }
+        for (std::map<std::string, std::string>::const_iterator it = node->_masks.begin(); it != node->_masks.end(); ++it) {
+            dependencies.insert(it->second);
+        }
+
+        // Any other node that it may refer to by name: in expressions, links, Python callbacks, or nodes within it
+        // if it is a group. This over-estimates the dependencies but never misses one.
+        {
+            YAML::Emitter em;
+            node->encode(em);
+            extractIdentifiers(em.c_str(), &dependencies);
+        }
+
+        for (std::set<std::string>::const_iterator it = dependencies.begin(); it != dependencies.end(); ++it) {
+            if ( ( nodesByName.find(*it) != nodesByName.end() ) && nodesToLoad.insert(*it).second ) {
+                nodesToVisit.push_back(*it);
+            }
+        }
+    }
+
+    for (SERIALIZATION_NAMESPACE::NodeSerializationList::const_iterator it = serializedNodes.begin(); it != serializedNodes.end(); ++it) {
+        if ( nodesToLoad.find( (*it)->_nodeScriptName ) != nodesToLoad.end() ) {
+            filteredNodes->push_back(*it);
+        }
+    }
+    qDebug() << "Project loading: creating" << filteredNodes->size() << "of" << serializedNodes.size() << "top-level nodes needed by the requested outputs";
+
+    return true;
+} // filterNodesUpstreamOfOutputs
+
 bool
 ProjectPrivate::findFormat(int index,
                            Format* format) const
@@ -99,12 +99,20 @@ public:
     bool autoSetProjectFormat;
     mutable QMutex isLoadingProjectMutex;
     SERIALIZATION_NAMESPACE::ProjectSerializationPtr lastProjectLoaded;
+
+    // If not empty, only the top-level nodes these nodes depend on are created when loading a project, see Project::setOutputNodesToLoad()
+    std::list<std::string> outputNodesToLoad;
     bool isLoadingProject; //< true when the project is loading
     bool isLoadingProjectInternal; //< true when loading the internal project (not gui)
     mutable QMutex isSavingProjectMutex;
     bool isSavingProject; //< true when the project is saving
     boost::shared_ptr<QTimer> autoSaveTimer;
     std::list<boost::shared_ptr<QFutureWatcher<void> > > autoSaveFutures;
+
+    // Number of auto-saves since one last serialized all nodes, protected by projectLock
+    int nAutoSavesSinceFullSerialization;
+    // If true, the next auto-save serializes all nodes, protected by projectLock
+    bool autoSaveMustSerializeAllNodes;
     mutable QMutex projectClosingMutex;
     bool projectClosing;
     boost::shared_ptr<TLSHolder<Project::ProjectTLSData> > tlsData;
@@ -135,6 +143,13 @@ public:
 
     void runOnProjectLoadCallback();
 
+    /**
+     * @brief Returns in filteredNodes the top-level nodes that outputNodesToLoad depend on, in the order of serializedNodes.
+     * Returns false if all nodes must be loaded.
+     **/
+    bool filterNodesUpstreamOfOutputs(const SERIALIZATION_NAMESPACE::NodeSerializationList& serializedNodes,
+                                      SERIALIZATION_NAMESPACE::NodeSerializationList* filteredNodes) const;
+
     void setProjectFilename(const std::string& filename);
     std::string getProjectFilename() const;
 
@@ -41,7 +41,10 @@ GCC_DIAG_ON(unused-parameter)
 
 
 #include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/Cache.h"
 #include "Engine/CreateNodeArgs.h"
+#include "Engine/MemoryAccount.h"
 #include "Engine/Project.h"
 #include "Engine/Node.h"
 #include "Engine/NodeGroup.h"
@@ -256,7 +259,11 @@ App::createNode(const QString& pluginID,
     CreateNodeArgsPtr args(new CreateNodeArgs);
     makeCreateNodeArgs(getInternalApp(), pluginID, majorVersion, collection, props, args.get());
 
-    NodePtr node = getInternalApp()->createNode(args);
+    NodePtr node;
+    {
+        PythonGILUnlocker pgu;
+        node = getInternalApp()->createNode(args);
+    }
     if (node) {
         return App::createEffectFromNodeWrapper(node);
     } else {
@@ -276,7 +283,11 @@ App::createReader(const QString& filename,
     CreateNodeArgsPtr args(new CreateNodeArgs);
     makeCreateNodeArgs(getInternalApp(),  QString::fromUtf8(PLUGINID_NATRON_READ), -1, collection, props, args.get());
 
-    NodePtr node = getInternalApp()->createReader(filename.toStdString(), args);
+    NodePtr node;
+    {
+        PythonGILUnlocker pgu;
+        node = getInternalApp()->createReader(filename.toStdString(), args);
+    }
     if (node) {
         return App::createEffectFromNodeWrapper(node);
     } else {
@@ -294,7 +305,11 @@ App::createWriter(const QString& filename,
     assert(collection);
     CreateNodeArgsPtr args(new CreateNodeArgs);
     makeCreateNodeArgs(getInternalApp(), QString::fromUtf8(PLUGINID_NATRON_WRITE), -1, collection, props, args.get());
-    NodePtr node = getInternalApp()->createWriter(filename.toStdString(), args);
+    NodePtr node;
+    {
+        PythonGILUnlocker pgu;
+        node = getInternalApp()->createWriter(filename.toStdString(), args);
+    }
     if (node) {
         return App::createEffectFromNodeWrapper(node);
     } else {
@@ -397,6 +412,46 @@ App::render(const std::list<Effect*>& effects,
     renderInternal(false, effects, firstFrames, lastFrames, frameSteps);
 }
 
+void
+App::renderCombined(const std::list<Effect*>& writeNodes,
+                    int firstFrame,
+                    int lastFrame,
+                    int frameStep)
+{
+    // The first writer drives the render, the others are rendered in the same pass over its frame range
+    RenderQueue::RenderWork w;
+    for (std::list<Effect*>::const_iterator it = writeNodes.begin(); it != writeNodes.end(); ++it) {
+        NodePtr node = *it ? (*it)->getInternalNode() : NodePtr();
+        if ( !node || !node->getEffectInstance()->isOutput() ) {
+            std::cerr << tr("Invalid write node").toStdString() << std::endl;
+
+            return;
+        }
+        if (!w.treeRoot) {
+            w.treeRoot = node;
+        } else {
+            w.extraTreeRoots.push_back(node);
+        }
+    }
+    if (!w.treeRoot) {
+        std::cerr << tr("Invalid write node").toStdString() << std::endl;
+
+        return;
+    }
+
+    w.firstFrame = TimeValue(firstFrame);
+    w.lastFrame = TimeValue(lastFrame);
+    w.frameStep = TimeValue(frameStep);
+    w.useRenderStats = false;
+
+    std::list<RenderQueue::RenderWork> l;
+    l.push_back(w);
+
+    // In background mode the render blocks: let the render threads evaluate Python expressions meanwhile
+    PythonGILUnlocker pgu;
+    getInternalApp()->getRenderQueue()->renderNonBlocking(l);
+}
+
 void
 App::renderInternal(bool forceBlocking,
                     Effect* writeNode,
@@ -426,6 +481,9 @@ App::renderInternal(bool forceBlocking,
 
     std::list<RenderQueue::RenderWork> l;
     l.push_back(w);
+
+    // In background mode the render blocks: let the render threads evaluate Python expressions meanwhile
+    PythonGILUnlocker pgu;
     if (forceBlocking) {
         getInternalApp()->getRenderQueue()->renderBlocking(l);
     } else {
@@ -474,6 +532,9 @@ App::renderInternal(bool forceBlocking,
 
         l.push_back(w);
     }
+
+    // In background mode the render blocks: let the render threads evaluate Python expressions meanwhile
+    PythonGILUnlocker pgu;
     if (forceBlocking) {
         getInternalApp()->getRenderQueue()->renderBlocking(l);
     } else {
@@ -547,25 +608,35 @@ App::addFormat(const QString& formatSpec)
 bool
 App::saveTempProject(const QString& filename)
 {
+    PythonGILUnlocker pgu;
+
     return getInternalApp()->saveTemp( filename.toStdString() );
 }
 
 bool
 App::saveProject(const QString& filename)
 {
+    PythonGILUnlocker pgu;
+
     return getInternalApp()->save( filename.toStdString() );
 }
 
 bool
 App::saveProjectAs(const QString& filename)
 {
+    PythonGILUnlocker pgu;
+
     return getInternalApp()->saveAs( filename.toStdString() );
 }
 
 App*
 App::loadProject(const QString& filename)
 {
-    AppInstancePtr app  = getInternalApp()->loadProject( filename.toStdString() );
+    AppInstancePtr app;
+    {
+        PythonGILUnlocker pgu;
+        app = getInternalApp()->loadProject( filename.toStdString() );
+    }
 
     if (!app) {
         return 0;
@@ -639,5 +710,54 @@ App::addProjectLayer(const ImageLayer& layer)
     getInternalApp()->getProject()->addProjectDefaultLayer( layer.getInternalComps() );
 }
 
+QMap<QString, QVariant>
+App::getCacheStats() const
+{
+    QMap<QString, QVariant> ret;
+    CacheBasePtr cache = appPTR->getTileCache();
+    if (!cache) {
+        return ret;
+    }
+    std::map<std::string, CacheReportInfo> infos;
+    cache->getMemoryStats(&infos);
+    for (std::map<std::string, CacheReportInfo>::const_iterator it = infos.begin(); it != infos.end(); ++it) {
+        QMap<QString, QVariant> stats;
+        stats[QString::fromUtf8("entries")] = it->second.nEntries;
+        stats[QString::fromUtf8("bytes")] = (qulonglong)it->second.nBytes;
+        stats[QString::fromUtf8("hits")] = (qulonglong)it->second.nHits;
+        stats[QString::fromUtf8("misses")] = (qulonglong)it->second.nMisses;
+        stats[QString::fromUtf8("pendingWaits")] = (qulonglong)it->second.nPendingWaits;
+        stats[QString::fromUtf8("pendingWaitTimeMS")] = it->second.pendingWaitTimeMS;
+        stats[QString::fromUtf8("evictions")] = (qulonglong)it->second.nEvictions;
+        stats[QString::fromUtf8("bytesAllocated")] = (qulonglong)it->second.nBytesAllocated;
+        stats[QString::fromUtf8("compressedTiles")] = it->second.nCompressedTiles;
+        stats[QString::fromUtf8("compressedBytes")] = (qulonglong)it->second.nCompressedBytes;
+        ret[QString::fromUtf8(it->first.c_str())] = stats;
+    }
+    return ret;
+}
+
+QMap<QString, QVariant>
+App::getMemoryUsage() const
+{
+    QMap<QString, QVariant> ret;
+    NodesList nodes;
+    getInternalApp()->getProject()->getNodes_recursive(nodes, false);
+    for (NodesList::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        MemoryAccountPtr account = (*it)->getMemoryAccount();
+        if (account->getPeakTotalBytes() == 0) {
+            continue;
+        }
+        QMap<QString, QVariant> usage;
+        usage[QString::fromUtf8("imagesRAM")] = (qulonglong)account->getBytes(eMemoryAccountTypeImageRAM);
+        usage[QString::fromUtf8("imagesGL")] = (qulonglong)account->getBytes(eMemoryAccountTypeImageGL);
+        usage[QString::fromUtf8("plugin")] = (qulonglong)account->getBytes(eMemoryAccountTypePlugin);
+        usage[QString::fromUtf8("total")] = (qulonglong)account->getTotalBytes();
+        usage[QString::fromUtf8("peak")] = (qulonglong)account->getPeakTotalBytes();
+        ret[QString::fromUtf8( (*it)->getFullyQualifiedName().c_str() )] = usage;
+    }
+    return ret;
+}
+
 NATRON_PYTHON_NAMESPACE_EXIT;
 NATRON_NAMESPACE_EXIT;
@@ -33,6 +33,8 @@ CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QCoreApplication>
 #include <QtCore/QString>
+#include <QtCore/QMap>
+#include <QtCore/QVariant>
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
@@ -311,6 +313,8 @@ public:
 
     void render(const std::list<Effect*>& effects, const std::list<int>& firstFrames, const std::list<int>& lastFrames, const std::list<int>& frameSteps);
 
+    void renderCombined(const std::list<Effect*>& writeNodes, int firstFrame, int lastFrame, int frameStep = 1);
+
     void redrawViewer(Effect* viewerNode);
 
     void refreshViewer(Effect* viewerNode,bool useCache = true);
@@ -340,6 +344,18 @@ public:
 
     void addProjectLayer(const ImageLayer& layer);
 
+    /**
+     * @brief Returns for each plug-in a dictionary of the tile cache access counters of this process,
+     * see CacheReportInfo.
+     **/
+    QMap<QString, QVariant> getCacheStats() const;
+
+    /**
+     * @brief Returns for each node of the project which allocated memory outside of the cache a dictionary
+     * of its memory usage, see MemoryAccount.
+     **/
+    QMap<QString, QVariant> getMemoryUsage() const;
+
     static Effect* createEffectFromNodeWrapper(const NodePtr& node);
 
     static App* createAppFromAppInstance(const AppInstancePtr& app);
@@ -0,0 +1,239 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "PyGlobalFunctions.h"
+
+#include <stdexcept>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+
+#include "Global/FStreamsSupport.h"
+
+#include "Serialization/KnobSerialization.h"
+#include "Serialization/NodeSerialization.h"
+#include "Serialization/ProjectSerialization.h"
+#include "Serialization/SerializationIO.h"
+
+NATRON_NAMESPACE_ENTER
+NATRON_PYTHON_NAMESPACE_ENTER
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+// Batch scripts usually query several nodes of the same project in a row: keep the last project read
+struct ReadProjectCache
+{
+    QMutex lock;
+    QString filePath;
+    QDateTime lastModified;
+    boost::shared_ptr<SERIALIZATION_NAMESPACE::ProjectSerialization> serialization;
+};
+
+ReadProjectCache&
+getReadProjectCache()
+{
+    static ReadProjectCache cache;
+
+    return cache;
+}
+
+/**
+ * @brief Returns the serialization of the given project file, or NULL with the Python error set.
+ **/
+boost::shared_ptr<SERIALIZATION_NAMESPACE::ProjectSerialization>
+readProjectSerialization(const QString& projectFilePath)
+{
+    boost::shared_ptr<SERIALIZATION_NAMESPACE::ProjectSerialization> ret;
+    QFileInfo info(projectFilePath);
+    if ( !info.exists() ) {
+        PyErr_SetString( PyExc_ValueError, QCoreApplication::translate("PyCoreApplication", "%1: No such file.").arg(projectFilePath).toStdString().c_str() );
+
+        return ret;
+    }
+
+    ReadProjectCache& cache = getReadProjectCache();
+    QMutexLocker k(&cache.lock);
+    QString filePath = info.canonicalFilePath();
+    if ( cache.serialization && (cache.filePath == filePath) && (cache.lastModified == info.lastModified()) ) {
+        return cache.serialization;
+    }
+
+    FStreamsSupport::ifstream ifile;
+    // Open in binary mode: the project may have been saved with SERIALIZATION_NAMESPACE::writeBinary()
+    FStreamsSupport::open( &ifile, filePath.toStdString(), std::ios_base::in | std::ios_base::binary );
+    if (!ifile) {
+        PyErr_SetString( PyExc_RuntimeError, QCoreApplication::translate("PyCoreApplication", "Failed to open %1").arg(filePath).toStdString().c_str() );
+
+        return ret;
+    }
+    ret.reset(new SERIALIZATION_NAMESPACE::ProjectSerialization);
+    try {
+        SERIALIZATION_NAMESPACE::read(NATRON_PROJECT_FILE_HEADER, ifile, ret.get());
+    } catch (...) {
+        // Projects saved before Natron 2.2 must be converted by loading them in an application
+        PyErr_SetString( PyExc_RuntimeError, QCoreApplication::translate("PyCoreApplication", "%1: Unrecognized or damaged project file").arg(filePath).toStdString().c_str() );
+        ret.reset();
+
+        return ret;
+    }
+    cache.filePath = filePath;
+    cache.lastModified = info.lastModified();
+    cache.serialization = ret;
+
+    return ret;
+} // readProjectSerialization
+
+void
+appendNodes(const SERIALIZATION_NAMESPACE::NodeSerializationList& nodes,
+            const QString& prefix,
+            std::map<QString, QString>* ret)
+{
+    for (SERIALIZATION_NAMESPACE::NodeSerializationList::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        QString fullName = prefix + QString::fromUtf8( (*it)->_nodeScriptName.c_str() );
+        (*ret)[fullName] = QString::fromUtf8( (*it)->_pluginID.c_str() );
+        appendNodes( (*it)->_children, fullName + QLatin1Char('.'), ret );
+    }
+}
+
+SERIALIZATION_NAMESPACE::NodeSerializationPtr
+findNode(const SERIALIZATION_NAMESPACE::NodeSerializationList& nodes,
+         const QStringList& names,
+         int index)
+{
+    for (SERIALIZATION_NAMESPACE::NodeSerializationList::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        if ( QString::fromUtf8( (*it)->_nodeScriptName.c_str() ) != names[index] ) {
+            continue;
+        }
+        if ( index == (int)names.size() - 1 ) {
+            return *it;
+        }
+
+        return findNode( (*it)->_children, names, index + 1 );
+    }
+
+    return SERIALIZATION_NAMESPACE::NodeSerializationPtr();
+}
+
+/**
+ * @brief Returns the value of a dimension as a string, or an empty string if it was not serialized, i.e: it has its default value.
+ **/
+QString
+valueToString(const SERIALIZATION_NAMESPACE::ValueSerialization& value,
+              SERIALIZATION_NAMESPACE::SerializationValueVariantTypeEnum dataType)
+{
+    if ( !value._expression.empty() ) {
+        return QLatin1Char('=') + QString::fromUtf8( value._expression.c_str() );
+    }
+    if (value._slaveMasterLink.hasLink) {
+        return QString::fromUtf8("@%1.%2").arg( QString::fromUtf8( value._slaveMasterLink.masterNodeName.c_str() ) ).arg( QString::fromUtf8( value._slaveMasterLink.masterKnobName.c_str() ) );
+    }
+    if ( !value._animationCurve.keys.empty() ) {
+        QStringList keys;
+        for (std::list<SERIALIZATION_NAMESPACE::KeyFrameSerialization>::const_iterator it = value._animationCurve.keys.begin(); it != value._animationCurve.keys.end(); ++it) {
+            keys.push_back( QString::number(it->time) + QLatin1Char(':') + QString::number(it->value, 'g', 15) );
+        }
+
+        return QString::fromUtf8("{%1}").arg( keys.join( QString::fromUtf8(", ") ) );
+    }
+    if (!value._serializeValue) {
+        return QString();
+    }
+    switch (dataType) {
+    case SERIALIZATION_NAMESPACE::eSerializationValueVariantTypeBoolean:
+
+        return value._value.isBool ? QString::fromUtf8("True") : QString::fromUtf8("False");
+    case SERIALIZATION_NAMESPACE::eSerializationValueVariantTypeInteger:
+
+        return QString::number(value._value.isInt);
+    case SERIALIZATION_NAMESPACE::eSerializationValueVariantTypeDouble:
+
+        return QString::number(value._value.isDouble, 'g', 15);
+    case SERIALIZATION_NAMESPACE::eSerializationValueVariantTypeString:
+
+        return QString::fromUtf8( value._value.isString.c_str() );
+    case SERIALIZATION_NAMESPACE::eSerializationValueVariantTypeTable:
+    case SERIALIZATION_NAMESPACE::eSerializationValueVariantTypeNone:
+        break;
+    }
+
+    return QString();
+} // valueToString
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+std::map<QString, QString>
+PyCoreApplication::readProjectNodes(const QString& projectFilePath) const
+{
+    std::map<QString, QString> ret;
+    boost::shared_ptr<SERIALIZATION_NAMESPACE::ProjectSerialization> serialization = readProjectSerialization(projectFilePath);
+    if (serialization) {
+        appendNodes(serialization->_nodes, QString(), &ret);
+    }
+
+    return ret;
+}
+
+std::map<QString, QString>
+PyCoreApplication::readProjectParamValues(const QString& projectFilePath,
+                                          const QString& nodeName) const
+{
+    std::map<QString, QString> ret;
+    boost::shared_ptr<SERIALIZATION_NAMESPACE::ProjectSerialization> serialization = readProjectSerialization(projectFilePath);
+    if (!serialization) {
+        return ret;
+    }
+    SERIALIZATION_NAMESPACE::NodeSerializationPtr node = findNode( serialization->_nodes, nodeName.split( QLatin1Char('.') ), 0 );
+    if (!node) {
+        PyErr_SetString( PyExc_ValueError, QCoreApplication::translate("PyCoreApplication", "%1: No such node in %2").arg(nodeName).arg(projectFilePath).toStdString().c_str() );
+
+        return ret;
+    }
+
+    for (SERIALIZATION_NAMESPACE::KnobSerializationList::const_iterator it = node->_knobsValues.begin(); it != node->_knobsValues.end(); ++it) {
+        const SERIALIZATION_NAMESPACE::KnobSerialization& knob = **it;
+        QString knobName = QString::fromUtf8( knob._scriptName.c_str() );
+        bool isFirstView = true;
+        for (SERIALIZATION_NAMESPACE::KnobSerialization::PerViewValueSerializationMap::const_iterator itView = knob._values.begin(); itView != knob._values.end(); ++itView) {
+            // Only the views other than the first one are named, see the documentation
+            QString viewPrefix = isFirstView ? knobName : knobName + QLatin1Char('.') + QString::fromUtf8( itView->first.c_str() );
+            isFirstView = false;
+            for (std::size_t i = 0; i < itView->second.size(); ++i) {
+                QString value = valueToString(itView->second[i], knob._dataType);
+                if ( value.isEmpty() ) {
+                    continue;
+                }
+                QString key = itView->second.size() > 1 ? viewPrefix + QLatin1Char('.') + QString::number(i) : viewPrefix;
+                ret[key] = value;
+            }
+        }
+    }
+
+    return ret;
+} // readProjectParamValues
+
+NATRON_PYTHON_NAMESPACE_EXIT
+NATRON_NAMESPACE_EXIT
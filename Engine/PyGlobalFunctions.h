@@ -27,6 +27,8 @@
 
 #include "Global/Macros.h"
 
+#include <map>
+
 #include "Engine/AppManager.h"
 #include "Engine/MemoryInfo.h" // isApplication32Bits
 #include "Engine/PyAppInstance.h"
@@ -226,6 +228,19 @@ public:
     {
         appPTR->setOnProjectLoadedCallback( pythonFunctionName.toStdString() );
     }
+
+    /**
+     * @brief Reads the given project file without creating its nodes: no plug-in is loaded nor instantiated.
+     * Returns a dict mapping the fully qualified script-name of each node to its plug-in ID.
+     * The file read last is kept in memory so that querying its nodes parameters does not read it again.
+     **/
+    std::map<QString, QString> readProjectNodes(const QString& projectFilePath) const;
+
+    /**
+     * @brief Same as readProjectNodes but returns the parameters of the node with the given fully qualified
+     * script-name, mapped to their value as a string. See the documentation for the format of the values.
+     **/
+    std::map<QString, QString> readProjectParamValues(const QString& projectFilePath, const QString& nodeName) const;
 };
 
 NATRON_PYTHON_NAMESPACE_EXIT;
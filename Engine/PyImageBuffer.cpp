@@ -0,0 +1,217 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "PyImageBuffer.h"
+
+#include <cassert>
+
+#include "Engine/CacheEntryBase.h" // getSizeOfForBitDepth
+#include "Engine/Image.h"
+
+NATRON_NAMESPACE_ENTER;
+NATRON_PYTHON_NAMESPACE_ENTER;
+
+struct PyImageBufferObject
+{
+    PyObject_HEAD
+
+    // Keeps the image, hence its storage, alive. Allocated with new since PyObject_New does not call constructors
+    ImagePtr* image;
+
+    // The first pixel of the image bounds
+    void* data;
+
+    // The format character of the components, see the struct module
+    const char* format;
+    Py_ssize_t itemSize;
+    Py_ssize_t shape[3];
+    Py_ssize_t strides[3];
+
+    // The image bounds, as a tuple (x1, y1, x2, y2)
+    PyObject* bounds;
+};
+
+static void
+PyImageBuffer_dealloc(PyObject* self)
+{
+    PyImageBufferObject* obj = (PyImageBufferObject*)self;
+
+    delete obj->image;
+    Py_XDECREF(obj->bounds);
+    PyObject_Del(self);
+}
+
+static int
+PyImageBuffer_getbuffer(PyObject* self,
+                        Py_buffer* view,
+                        int flags)
+{
+    PyImageBufferObject* obj = (PyImageBufferObject*)self;
+
+    if ( (flags & PyBUF_WRITABLE) == PyBUF_WRITABLE ) {
+        PyErr_SetString(PyExc_BufferError, "NatronEngine.ImageBuffer is read-only");
+        view->obj = NULL;
+
+        return -1;
+    }
+
+    view->buf = obj->data;
+    view->obj = self;
+    Py_INCREF(self);
+    view->len = obj->shape[0] * obj->shape[1] * obj->shape[2] * obj->itemSize;
+    view->readonly = 1;
+    view->itemsize = obj->itemSize;
+    view->format = ( (flags & PyBUF_FORMAT) == PyBUF_FORMAT ) ? const_cast<char*>(obj->format) : NULL;
+    // The buffer is C-contiguous: the shape and strides may be omitted when not requested
+    view->ndim = 3;
+    view->shape = ( (flags & PyBUF_ND) == PyBUF_ND ) ? obj->shape : NULL;
+    view->strides = ( (flags & PyBUF_STRIDES) == PyBUF_STRIDES ) ? obj->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    return 0;
+}
+
+static PyObject*
+PyImageBuffer_getBounds(PyObject* self,
+                        void* /*closure*/)
+{
+    PyImageBufferObject* obj = (PyImageBufferObject*)self;
+
+    Py_INCREF(obj->bounds);
+
+    return obj->bounds;
+}
+
+static PyGetSetDef PyImageBuffer_getset[] = {
+    {const_cast<char*>("bounds"), (getter)PyImageBuffer_getBounds, NULL, const_cast<char*>("The bounds of the image in pixel coordinates: (x1, y1, x2, y2)"), NULL},
+    {NULL, NULL, NULL, NULL, NULL} // Sentinel
+};
+
+static PyBufferProcs PyImageBuffer_bufferProcs;
+
+static PyTypeObject PyImageBuffer_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+};
+
+static bool
+initImageBufferType()
+{
+    static bool initialized = false;
+    if (initialized) {
+        return true;
+    }
+
+    PyImageBuffer_bufferProcs.bf_getbuffer = PyImageBuffer_getbuffer;
+    PyImageBuffer_bufferProcs.bf_releasebuffer = NULL;
+
+    PyImageBuffer_Type.tp_name = "NatronEngine.ImageBuffer";
+    PyImageBuffer_Type.tp_basicsize = sizeof(PyImageBufferObject);
+    PyImageBuffer_Type.tp_dealloc = PyImageBuffer_dealloc;
+    PyImageBuffer_Type.tp_as_buffer = &PyImageBuffer_bufferProcs;
+#if PY_MAJOR_VERSION >= 3
+    PyImageBuffer_Type.tp_flags = Py_TPFLAGS_DEFAULT;
+#else
+    PyImageBuffer_Type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+    PyImageBuffer_Type.tp_doc = "The pixels of an image, exposed with the buffer protocol, read-only";
+    PyImageBuffer_Type.tp_getset = PyImageBuffer_getset;
+    if (PyType_Ready(&PyImageBuffer_Type) < 0) {
+        return false;
+    }
+    initialized = true;
+
+    return true;
+}
+
+PyObject*
+createImageBufferObject(const ImagePtr& image)
+{
+    if ( !image || (image->getStorageMode() != eStorageModeRAM) || (image->getBufferFormat() != eImageBufferLayoutRGBAPackedFullRect) ) {
+        PyErr_SetString(PyExc_ValueError, "The image must be a RAM image with packed components");
+
+        return NULL;
+    }
+
+    const char* format = NULL;
+    switch ( image->getBitDepth() ) {
+    case eImageBitDepthByte:
+        format = "B";
+        break;
+    case eImageBitDepthShort:
+        format = "H";
+        break;
+    case eImageBitDepthHalf:
+        format = "e";
+        break;
+    case eImageBitDepthFloat:
+        format = "f";
+        break;
+    case eImageBitDepthNone:
+        break;
+    }
+    if (!format) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported image bit depth");
+
+        return NULL;
+    }
+
+    Image::CPUData data;
+    image->getCPUData(&data);
+    if (!data.ptrs[0]) {
+        PyErr_SetString(PyExc_ValueError, "The image has no buffer");
+
+        return NULL;
+    }
+
+    if ( !initImageBufferType() ) {
+        return NULL;
+    }
+
+    PyImageBufferObject* obj = PyObject_New(PyImageBufferObject, &PyImageBuffer_Type);
+    if (!obj) {
+        return NULL;
+    }
+    obj->image = new ImagePtr(image);
+    obj->data = data.ptrs[0];
+    obj->format = format;
+    obj->itemSize = getSizeOfForBitDepth(data.bitDepth);
+    obj->shape[0] = data.bounds.height();
+    obj->shape[1] = data.bounds.width();
+    obj->shape[2] = data.nComps;
+    obj->strides[2] = obj->itemSize;
+    obj->strides[1] = obj->strides[2] * obj->shape[2];
+    obj->strides[0] = obj->strides[1] * obj->shape[1];
+    obj->bounds = Py_BuildValue("(iiii)", data.bounds.x1, data.bounds.y1, data.bounds.x2, data.bounds.y2);
+    if (!obj->bounds) {
+        Py_DECREF( (PyObject*)obj );
+
+        return NULL;
+    }
+
+    return (PyObject*)obj;
+} // createImageBufferObject
+
+NATRON_PYTHON_NAMESPACE_EXIT;
+NATRON_NAMESPACE_EXIT;
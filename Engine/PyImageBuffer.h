@@ -0,0 +1,48 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_PYIMAGEBUFFER_H
+#define NATRON_ENGINE_PYIMAGEBUFFER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+NATRON_PYTHON_NAMESPACE_ENTER;
+
+/**
+ * @brief Returns a new NatronEngine.ImageBuffer object exposing the pixels of the given image to Python with the buffer
+ * protocol, without any copy: memoryview(obj) or numpy.asarray(obj) point directly into the image buffer.
+ * The buffer is read-only, of shape (height, width, components) with the first row being the bottom row of the image bounds.
+ * The object holds a reference on the image so that the buffer stays valid as long as the object or any view of it is alive.
+ * The image must be a RAM image in the eImageBufferLayoutRGBAPackedFullRect layout.
+ * Returns NULL with a Python exception set on failure. The GIL must be held.
+ **/
+PyObject* createImageBufferObject(const ImagePtr& image);
+
+NATRON_PYTHON_NAMESPACE_EXIT;
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_PYIMAGEBUFFER_H
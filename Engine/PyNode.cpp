@@ -50,15 +50,20 @@ GCC_DIAG_ON(unused-parameter)
 #include "Engine/KnobTypes.h"
 #include "Engine/KnobFile.h"
 #include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/FrameViewRequest.h"
+#include "Engine/Image.h"
 #include "Engine/NodeGroup.h"
 #include "Engine/PyAppInstance.h"
+#include "Engine/PyImageBuffer.h"
 #include "Engine/PyRoto.h"
 #include "Engine/PyTracker.h"
 #include "Engine/Project.h"
 #include "Engine/RotoPaintPrivate.h"
 #include "Engine/TrackerNode.h"
 #include "Engine/TrackerHelper.h"
+#include "Engine/TreeRender.h"
 
 #include "Engine/Hash64.h"
 
@@ -100,11 +105,11 @@ ImageLayer::getHash(const ImageLayer& layer)
 {
     Hash64 h;
 
-    Hash64::appendQString(QString::fromUtf8( layer._comps->getPlaneLabel().c_str() ), &h );
+    Hash64::appendString(layer._comps->getPlaneLabel(), &h);
 
     const std::vector<std::string>& comps = layer._comps->getChannels();
     for (std::size_t i = 0; i < comps.size(); ++i) {
-        Hash64::appendQString(QString::fromUtf8( comps[i].c_str() ), &h );
+        Hash64::appendString(comps[i], &h);
     }
 
     return (int)h.value();
@@ -1523,6 +1528,80 @@ Effect::getRegionOfDefinition(double time, const QString& view) const
 
 }
 
+PyObject*
+Effect::getImage(double time,
+                 const ImageLayer& layer,
+                 const QString& view,
+                 int mipMapLevel) const
+{
+    EffectInstancePtr effect = getCurrentEffectInstance();
+    if (!effect) {
+        PythonSetNullError();
+        return 0;
+    }
+    const std::vector<std::string>& projectViews = effect->getApp()->getProject()->getProjectViewNames();
+    ViewIdx foundViewIdx;
+    if ( !Project::getViewIndex(projectViews, view.toStdString(), &foundViewIdx) ) {
+        PythonSetInvalidViewName(view);
+        return 0;
+    }
+    if (mipMapLevel < 0) {
+        PyErr_SetString(PyExc_ValueError, tr("Invalid mipmap level").toStdString().c_str());
+        return 0;
+    }
+
+    ImagePtr image;
+    {
+        // The render may be long and may run Python callbacks on other threads
+        PythonGILUnlocker pgu;
+
+        TreeRender::CtorArgsPtr args(new TreeRender::CtorArgs);
+        args->treeRootEffect = effect;
+        args->time = TimeValue(time);
+        args->view = foundViewIdx;
+        args->plane = &layer.getInternalComps();
+        args->mipMapLevel = (unsigned int)mipMapLevel;
+        args->proxyScale = RenderScale(1.);
+        args->canonicalRoI = 0;
+        args->draftMode = false;
+        args->playback = false;
+        args->byPassCache = false;
+
+        TreeRenderPtr render = TreeRender::create(args);
+        FrameViewRequestPtr outputRequest;
+        if ( render && !isFailureRetCode( render->launchRender(&outputRequest) ) && outputRequest ) {
+            image = outputRequest->getRequestedScaleImagePlane();
+        }
+
+        // The buffer protocol needs a contiguous buffer in RAM: this is usually already the case for images held by the cache,
+        // otherwise the image is converted once.
+        if ( image && ( (image->getStorageMode() != eStorageModeRAM) || (image->getBufferFormat() != eImageBufferLayoutRGBAPackedFullRect) ) ) {
+            Image::InitStorageArgs initArgs;
+            initArgs.bounds = image->getBounds();
+            initArgs.bufferFormat = eImageBufferLayoutRGBAPackedFullRect;
+            initArgs.storage = eStorageModeRAM;
+            initArgs.mipMapLevel = image->getMipMapLevel();
+            initArgs.proxyScale = image->getProxyScale();
+            initArgs.plane = image->getLayer();
+            initArgs.bitdepth = image->getBitDepth();
+            ImagePtr packedImage = Image::create(initArgs);
+            if (packedImage) {
+                Image::CopyPixelsArgs cpyArgs;
+                cpyArgs.roi = initArgs.bounds;
+                packedImage->copyPixels(*image, cpyArgs);
+            }
+            image = packedImage;
+        }
+    }
+
+    if (!image) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+
+    return createImageBufferObject(image);
+} // getImage
+
 void
 Effect::setSubGraphEditable(bool editable)
 {
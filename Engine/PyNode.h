@@ -391,6 +391,14 @@ public:
 
     RectD getRegionOfDefinition(double time, const QString& view) const;
 
+    /**
+     * @brief Renders the given layer of this node at the given time and view and returns it as a NatronEngine.ImageBuffer,
+     * exposing the pixels with the buffer protocol. The buffer points directly into the image held by the cache: it is read-only
+     * and keeps the image alive as long as a view of it exists.
+     * Returns None if the render failed.
+     **/
+    PyObject* getImage(double time, const ImageLayer& layer, const QString& view = QString::fromUtf8("Main"), int mipMapLevel = 0) const;
+
     static Param* createParamWrapperForKnob(const KnobIPtr& knob);
 
     static ItemsTable* createItemsTableWrapper(const KnobItemsTablePtr& table);
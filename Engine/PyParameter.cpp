@@ -27,6 +27,8 @@
 #include <cassert>
 #include <stdexcept>
 
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
 #include <boost/algorithm/string/predicate.hpp>
@@ -395,6 +397,34 @@ Param::setEvaluateOnChange(bool eval)
     knob->setEvaluateOnChange(eval);
 }
 
+void
+Param::beginChanges()
+{
+    KnobIPtr knob = getInternalKnob();
+    if (!knob) {
+        PythonSetNullError();
+        return;
+    }
+    KnobHolderPtr holder = knob->getHolder();
+    if (holder) {
+        holder->beginChanges();
+    }
+}
+
+void
+Param::endChanges()
+{
+    KnobIPtr knob = getInternalKnob();
+    if (!knob) {
+        PythonSetNullError();
+        return;
+    }
+    KnobHolderPtr holder = knob->getHolder();
+    if (holder) {
+        holder->endChanges();
+    }
+}
+
 bool
 Param::getCanAnimate() const
 {
@@ -1175,6 +1205,74 @@ AnimatedParam::removeAnimation(int dimension, const QString& view)
 
 }
 
+// The smoothing of a copy of an animation curve of a knob
+struct SmoothCurveJob
+{
+    ViewIdx view;
+    DimIdx dimension;
+    CurvePtr curve;
+};
+
+static void
+smoothCurveJob(SmoothCurveJob& job)
+{
+    job.curve->smooth(0);
+}
+
+void
+AnimatedParam::smoothAnimation(int dimension, const QString& view)
+{
+    KnobIPtr knob = getInternalKnob();
+    if (!knob) {
+        PythonSetNullError();
+        return;
+    }
+
+    ViewSetSpec thisViewSpec;
+    if (!getViewSetSpecFromViewName(view, &thisViewSpec)) {
+        PythonSetInvalidViewName(view);
+        return;
+    }
+    if (dimension != kPyParamDimSpecAll && (dimension < 0 || dimension >= knob->getNDimensions())) {
+        PythonSetInvalidDimensionError(dimension);
+        return;
+    }
+
+    std::list<ViewIdx> views;
+    if ( thisViewSpec.isAll() ) {
+        views = knob->getViewsList();
+    } else {
+        views.push_back( ViewIdx( thisViewSpec.value() ) );
+    }
+
+    // Smooth copies of the curves concurrently, then set them on the knob so that it is notified once per curve
+    std::vector<SmoothCurveJob> jobs;
+    for (std::list<ViewIdx>::const_iterator it = views.begin(); it != views.end(); ++it) {
+        for (int i = 0; i < knob->getNDimensions(); ++i) {
+            if ( (dimension != kPyParamDimSpecAll) && (i != dimension) ) {
+                continue;
+            }
+            CurvePtr curve = knob->getAnimationCurve(*it, DimIdx(i));
+            if ( !curve || (curve->getKeyFramesCount() < 3) ) {
+                continue;
+            }
+            SmoothCurveJob job;
+            job.view = *it;
+            job.dimension = DimIdx(i);
+            job.curve.reset( new Curve(*curve) );
+            jobs.push_back(job);
+        }
+    }
+    if (jobs.size() > 1) {
+        QtConcurrent::blockingMap(jobs, smoothCurveJob);
+    } else if (jobs.size() == 1) {
+        smoothCurveJob(jobs[0]);
+    }
+    for (std::vector<SmoothCurveJob>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        knob->cloneCurve(it->view, it->dimension, *it->curve, 0., 0, 0);
+    }
+} // smoothAnimation
+
 double
 AnimatedParam::getDerivativeAtTime(double time,
                                    int dimension, const QString& view) const
@@ -1720,6 +1818,63 @@ IntParam::setValueAtTime(int value,
     knob->setValueAtTime(TimeValue(time), value, thisViewSpec, dim);
 }
 
+std::vector<int>
+IntParam::getValuesAtTimes(const std::vector<double>& times,
+                         int dimension, const QString& view) const
+{
+    std::vector<int> ret;
+    KnobIntPtr knob = getRenderCloneKnob<KnobInt>();
+    if (!knob) {
+        PythonSetNullError();
+        return ret;
+    }
+    if (dimension < 0 || dimension >= knob->getNDimensions()) {
+        PythonSetInvalidDimensionError(dimension);
+        return ret;
+    }
+    ViewIdx thisViewSpec;
+    if (!getViewIdxFromViewName(view, &thisViewSpec)) {
+        PythonSetInvalidViewName(view);
+        return ret;
+    }
+    ret.resize( times.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        ret[i] = knob->getValueAtTime(TimeValue(times[i]), DimIdx(dimension), thisViewSpec);
+    }
+    return ret;
+}
+
+void
+IntParam::setValuesAtTimes(const std::vector<int>& values,
+                         const std::vector<double>& times,
+                         int dimension, const QString& view)
+{
+    KnobIntPtr knob = _intKnob.lock();
+    if (!knob) {
+        PythonSetNullError();
+        return;
+    }
+    if (dimension != kPyParamDimSpecAll && (dimension < 0 || dimension >= knob->getNDimensions())) {
+        PythonSetInvalidDimensionError(dimension);
+        return;
+    }
+    ViewSetSpec thisViewSpec;
+    if (!getViewSetSpecFromViewName(view, &thisViewSpec)) {
+        PythonSetInvalidViewName(view);
+        return;
+    }
+    if ( values.size() != times.size() ) {
+        PyErr_SetString(PyExc_ValueError, tr("The number of values does not match the number of times").toStdString().c_str());
+        return;
+    }
+    DimSpec dim = getDimSpecFromDimensionIndex(dimension);
+    std::list<TimeValuePair<int> > keys;
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        keys.push_back( TimeValuePair<int>(TimeValue(times[i]), values[i]) );
+    }
+    knob->setMultipleValueAtTime(keys, thisViewSpec, dim);
+}
+
 void
 IntParam::setDefaultValue(int value,
                           int dimension)
@@ -2269,6 +2424,63 @@ DoubleParam::setValueAtTime(double value,
     knob->setValueAtTime(TimeValue(time), value, thisViewSpec, dim);
 }
 
+std::vector<double>
+DoubleParam::getValuesAtTimes(const std::vector<double>& times,
+                         int dimension, const QString& view) const
+{
+    std::vector<double> ret;
+    KnobDoublePtr knob = getRenderCloneKnob<KnobDouble>();
+    if (!knob) {
+        PythonSetNullError();
+        return ret;
+    }
+    if (dimension < 0 || dimension >= knob->getNDimensions()) {
+        PythonSetInvalidDimensionError(dimension);
+        return ret;
+    }
+    ViewIdx thisViewSpec;
+    if (!getViewIdxFromViewName(view, &thisViewSpec)) {
+        PythonSetInvalidViewName(view);
+        return ret;
+    }
+    ret.resize( times.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        ret[i] = knob->getValueAtTime(TimeValue(times[i]), DimIdx(dimension), thisViewSpec);
+    }
+    return ret;
+}
+
+void
+DoubleParam::setValuesAtTimes(const std::vector<double>& values,
+                         const std::vector<double>& times,
+                         int dimension, const QString& view)
+{
+    KnobDoublePtr knob = _doubleKnob.lock();
+    if (!knob) {
+        PythonSetNullError();
+        return;
+    }
+    if (dimension != kPyParamDimSpecAll && (dimension < 0 || dimension >= knob->getNDimensions())) {
+        PythonSetInvalidDimensionError(dimension);
+        return;
+    }
+    ViewSetSpec thisViewSpec;
+    if (!getViewSetSpecFromViewName(view, &thisViewSpec)) {
+        PythonSetInvalidViewName(view);
+        return;
+    }
+    if ( values.size() != times.size() ) {
+        PyErr_SetString(PyExc_ValueError, tr("The number of values does not match the number of times").toStdString().c_str());
+        return;
+    }
+    DimSpec dim = getDimSpecFromDimensionIndex(dimension);
+    std::list<TimeValuePair<double> > keys;
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        keys.push_back( TimeValuePair<double>(TimeValue(times[i]), values[i]) );
+    }
+    knob->setMultipleValueAtTime(keys, thisViewSpec, dim);
+}
+
 void
 DoubleParam::setDefaultValue(double value,
                              int dimension)
@@ -2677,6 +2889,63 @@ ColorParam::setValueAtTime(double value,
     knob->setValueAtTime(TimeValue(time), value, thisViewSpec, dim);
 }
 
+std::vector<double>
+ColorParam::getValuesAtTimes(const std::vector<double>& times,
+                         int dimension, const QString& view) const
+{
+    std::vector<double> ret;
+    KnobColorPtr knob = getRenderCloneKnob<KnobColor>();
+    if (!knob) {
+        PythonSetNullError();
+        return ret;
+    }
+    if (dimension < 0 || dimension >= knob->getNDimensions()) {
+        PythonSetInvalidDimensionError(dimension);
+        return ret;
+    }
+    ViewIdx thisViewSpec;
+    if (!getViewIdxFromViewName(view, &thisViewSpec)) {
+        PythonSetInvalidViewName(view);
+        return ret;
+    }
+    ret.resize( times.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        ret[i] = knob->getValueAtTime(TimeValue(times[i]), DimIdx(dimension), thisViewSpec);
+    }
+    return ret;
+}
+
+void
+ColorParam::setValuesAtTimes(const std::vector<double>& values,
+                         const std::vector<double>& times,
+                         int dimension, const QString& view)
+{
+    KnobColorPtr knob = _colorKnob.lock();
+    if (!knob) {
+        PythonSetNullError();
+        return;
+    }
+    if (dimension != kPyParamDimSpecAll && (dimension < 0 || dimension >= knob->getNDimensions())) {
+        PythonSetInvalidDimensionError(dimension);
+        return;
+    }
+    ViewSetSpec thisViewSpec;
+    if (!getViewSetSpecFromViewName(view, &thisViewSpec)) {
+        PythonSetInvalidViewName(view);
+        return;
+    }
+    if ( values.size() != times.size() ) {
+        PyErr_SetString(PyExc_ValueError, tr("The number of values does not match the number of times").toStdString().c_str());
+        return;
+    }
+    DimSpec dim = getDimSpecFromDimensionIndex(dimension);
+    std::list<TimeValuePair<double> > keys;
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        keys.push_back( TimeValuePair<double>(TimeValue(times[i]), values[i]) );
+    }
+    knob->setMultipleValueAtTime(keys, thisViewSpec, dim);
+}
+
 void
 ColorParam::setDefaultValue(double value,
                             int dimension)
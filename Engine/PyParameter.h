@@ -197,6 +197,16 @@ public:
      **/
     void setEvaluateOnChange(bool eval);
 
+    /**
+     * @brief Starts a group of changes on the parameters of the holder of this parameter (the effect, the table item or
+     * the project settings). Until the matching call to endChanges(), value changes do not trigger a render and
+     * the end of the changes is notified once, when the last endChanges() is called.
+     * This is much faster when setting many values from a script, e.g. to bake an animation.
+     **/
+    void beginChanges();
+
+    void endChanges();
+
     /**
      * @brief Returns whether the parameter type can animate or not. For example a button parameter cannot animate.
      * This is "static" (per parameter type property) and does not mean the same thing that getIsAnimationEnabled().
@@ -366,6 +376,12 @@ public:
      **/
     void removeAnimation(int dimension = kPyParamDimSpecAll, const QString& view = QLatin1String(kPyParamViewSetSpecAll));
 
+    /**
+     * @brief Smooths the animation curve of the given dimension and view. The curves of all dimensions and views
+     * are smoothed at once, concurrently, when dimension and view are set to all.
+     **/
+    void smoothAnimation(int dimension = kPyParamDimSpecAll, const QString& view = QLatin1String(kPyParamViewSetSpecAll));
+
     /**
      * @brief Compute the derivative at time as a double
      **/
@@ -475,6 +491,17 @@ public:
      **/
     void setValueAtTime(int value, double time, int dimension = 0, const QString& view = QLatin1String(kPyParamViewSetSpecAll));
 
+    /**
+     * @brief Same as getValueAtTime() for each of the given times, in a single call.
+     **/
+    std::vector<int> getValuesAtTimes(const std::vector<double>& times, int dimension = 0, const QString& view = QLatin1String(kPyParamViewIdxMain)) const;
+
+    /**
+     * @brief Set a keyframe at each of the given times with the value at the same index in values, in a single call.
+     * The parameter is notified of the change once for all keyframes.
+     **/
+    void setValuesAtTimes(const std::vector<int>& values, const std::vector<double>& times, int dimension = 0, const QString& view = QLatin1String(kPyParamViewSetSpecAll));
+
     /**
      * @brief Set the default value for the given dimension
      **/
@@ -623,6 +650,17 @@ public:
      **/
     void setValueAtTime(double value, double time, int dimension = 0, const QString& view = QLatin1String(kPyParamViewSetSpecAll));
 
+    /**
+     * @brief Same as getValueAtTime() for each of the given times, in a single call.
+     **/
+    std::vector<double> getValuesAtTimes(const std::vector<double>& times, int dimension = 0, const QString& view = QLatin1String(kPyParamViewIdxMain)) const;
+
+    /**
+     * @brief Set a keyframe at each of the given times with the value at the same index in values, in a single call.
+     * The parameter is notified of the change once for all keyframes.
+     **/
+    void setValuesAtTimes(const std::vector<double>& values, const std::vector<double>& times, int dimension = 0, const QString& view = QLatin1String(kPyParamViewSetSpecAll));
+
     /**
      * @brief Set the default value for the given dimension
      **/
@@ -772,6 +810,17 @@ public:
      **/
     void setValueAtTime(double value, double time, int dimension = 0, const QString& view = QLatin1String(kPyParamViewSetSpecAll));
 
+    /**
+     * @brief Same as getValueAtTime() for each of the given times, in a single call.
+     **/
+    std::vector<double> getValuesAtTimes(const std::vector<double>& times, int dimension = 0, const QString& view = QLatin1String(kPyParamViewIdxMain)) const;
+
+    /**
+     * @brief Set a keyframe at each of the given times with the value at the same index in values, in a single call.
+     * The parameter is notified of the change once for all keyframes.
+     **/
+    void setValuesAtTimes(const std::vector<double>& values, const std::vector<double>& times, int dimension = 0, const QString& view = QLatin1String(kPyParamViewSetSpecAll));
+
     /**
      * @brief Set the default value for the given dimension
      **/
@@ -24,6 +24,7 @@
 
 #include "ReadNode.h"
 
+#include <climits>
 #include <sstream> // stringstream
 
 #include "Global/QtCompat.h"
@@ -51,6 +52,7 @@ CLANG_DIAG_ON(uninitialized)
 #include "Engine/KnobFile.h"
 #include "Engine/Project.h"
 #include "Engine/Plugin.h"
+#include "Engine/ReadNodePrefetcher.h"
 #include "Engine/Settings.h"
 
 #include "Serialization/NodeSerialization.h"
@@ -62,6 +64,16 @@ CLANG_DIAG_ON(uninitialized)
 
 #define kNatronPersistentErrorDecoderMissing "NatronPersistentErrorDecoderMissing"
 
+#define kNatronReadNodeParamProxyCacheLevel "proxyCacheLevel"
+#define kNatronReadNodeParamProxyCacheLevelLabel "Proxy Level"
+#define kNatronReadNodeParamProxyCacheLevelHint "The proxy level of the Viewer at which the images are decoded by Generate Proxies."
+
+#define kNatronReadNodeParamGenerateProxyCache "generateProxyCache"
+#define kNatronReadNodeParamGenerateProxyCacheLabel "Generate Proxies"
+#define kNatronReadNodeParamGenerateProxyCacheHint "Decodes in the background all the frames of the sequence at the selected proxy level and keeps the reduced images " \
+    "in the cache directory. When the proxy mode of the Viewer is at this level, the images are then read from the cache instead of decoding the full " \
+    "resolution files. With a persistent cache the proxies are kept across sessions, and they are shared with other workstations when a shared cache tier is set in the Preferences."
+
 NATRON_NAMESPACE_ENTER;
 
 //Generic Reader
@@ -219,8 +231,13 @@ public:
     KnobChoiceWPtr pluginSelectorKnob;
     KnobSeparatorWPtr separatorKnob;
     KnobButtonWPtr fileInfosKnob;
+    KnobChoiceWPtr proxyCacheLevelKnob;
+    KnobButtonWPtr generateProxyCacheKnob;
     std::list<KnobIWPtr > readNodeKnobs;
 
+    // Decodes the frames at the proxy level in the background, created on the first use
+    boost::scoped_ptr<ReadNodePrefetcher> proxyGenerator;
+
     NodePtr inputNode, outputNode;
 
     //MT only
@@ -243,7 +260,10 @@ public:
     , pluginSelectorKnob()
     , separatorKnob()
     , fileInfosKnob()
+    , proxyCacheLevelKnob()
+    , generateProxyCacheKnob()
     , readNodeKnobs()
+    , proxyGenerator()
     , inputNode()
     , outputNode()
     , creatingReadNode(0)
@@ -264,6 +284,8 @@ public:
 
     void refreshPluginSelectorKnob();
 
+    void generateProxies();
+
     void refreshFileInfoVisibility(const std::string& pluginID);
 
     void createDefaultReadNode();
@@ -788,6 +810,51 @@ ReadNodePrivate::refreshPluginSelectorKnob()
 
 } // ReadNodePrivate::refreshPluginSelectorKnob
 
+void
+ReadNodePrivate::generateProxies()
+{
+    NodePtr reader = _publicInterface->getEmbeddedReader();
+    if (!reader) {
+        return;
+    }
+
+    RangeD range;
+    {
+        GetFrameRangeResultsPtr results;
+        ActionRetCodeEnum stat = reader->getEffectInstance()->getFrameRange_public(&results);
+        if ( isFailureRetCode(stat) ) {
+            return;
+        }
+        results->getFrameRangeResults(&range);
+    }
+    if ( (range.min == INT_MIN) || (range.max == INT_MAX) ) {
+        // Videos do not always know their frame range: use the frame range of the project
+        TimeValue first, last;
+        _publicInterface->getApp()->getProject()->getFrameRange(&first, &last);
+        range.min = first;
+        range.max = last;
+    }
+
+    std::list<TimeValue> frames;
+    for (double t = range.min; t <= range.max; t += 1.) {
+        frames.push_back( TimeValue(t) );
+    }
+    std::vector<ViewIdx> views;
+    int nViews = _publicInterface->getApp()->getProject()->getProjectViewsCount();
+    for (int i = 0; i < nViews; ++i) {
+        views.push_back( ViewIdx(i) );
+    }
+
+    // The proxy levels start at 2, i.e: mipmap level 1
+    unsigned int mipMapLevel = (unsigned int)proxyCacheLevelKnob.lock()->getValue() + 1;
+
+    // The decodes go in the cache like any render at this level: the Viewer finds them there in proxy mode
+    if (!proxyGenerator) {
+        proxyGenerator.reset(new ReadNodePrefetcher);
+    }
+    proxyGenerator->prefetch(reader, TimeValue(range.min), frames, views, mipMapLevel, false, eRenderPriorityIdle);
+} // generateProxies
+
 bool
 ReadNode::isReader() const
 {
@@ -856,6 +923,37 @@ ReadNode::initializeKnobs()
         _imp->readNodeKnobs.push_back(param);
 
     }
+    {
+        KnobChoicePtr param = createKnob<KnobChoice>(kNatronReadNodeParamProxyCacheLevel);
+        param->setAnimationEnabled(false);
+        param->setLabel(tr(kNatronReadNodeParamProxyCacheLevelLabel));
+        param->setHintToolTip( tr(kNatronReadNodeParamProxyCacheLevelHint) );
+        param->setEvaluateOnChange(false);
+        {
+            // Same levels as the proxy mode of the Viewer, starting at mipmap level 1
+            std::vector<ChoiceOption> choices;
+            choices.push_back(ChoiceOption("2", "", ""));
+            choices.push_back(ChoiceOption("4", "", ""));
+            choices.push_back(ChoiceOption("8", "", ""));
+            choices.push_back(ChoiceOption("16", "", ""));
+            choices.push_back(ChoiceOption("32", "", ""));
+            param->populateChoices(choices);
+        }
+        param->setDefaultValue(1);
+        param->setAddNewLine(false);
+        _imp->proxyCacheLevelKnob = param;
+        controlpage->addKnob(param);
+        _imp->readNodeKnobs.push_back(param);
+    }
+    {
+        KnobButtonPtr param = createKnob<KnobButton>(kNatronReadNodeParamGenerateProxyCache);
+        param->setLabel(tr(kNatronReadNodeParamGenerateProxyCacheLabel));
+        param->setHintToolTip( tr(kNatronReadNodeParamGenerateProxyCacheHint) );
+        param->setEvaluateOnChange(false);
+        _imp->generateProxyCacheKnob = param;
+        controlpage->addKnob(param);
+        _imp->readNodeKnobs.push_back(param);
+    }
     {
         KnobSeparatorPtr param = createKnob<KnobSeparator>("decoderOptionsSeparator");
         param->setLabel(tr("Decoder Options"));
@@ -1017,6 +1115,8 @@ ReadNode::knobChanged(const KnobIPtr& k,
 
 
         _imp->refreshFileInfoVisibility(entry.id);
+    } else if ( k == _imp->generateProxyCacheKnob.lock() ) {
+        _imp->generateProxies();
     } else if ( k == _imp->fileInfosKnob.lock() ) {
 
         NodePtr p = getEmbeddedReader();
@@ -0,0 +1,476 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ReadNodePrefetcher.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
+
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+#include <QtCore/QWaitCondition>
+
+#include "Engine/EffectInstance.h"
+#include "Engine/EffectInstanceActionResults.h"
+#include "Engine/FrameViewRequest.h"
+#include "Engine/Node.h"
+#include "Engine/ThreadPool.h"
+#include "Engine/TreeRender.h"
+
+// Number of threads decoding ahead of the render threads. They mostly wait for the files to be read.
+#define NATRON_READ_PREFETCH_N_THREADS 4
+
+// Number of consecutive frames of a video decoded in order by the video thread. The decoder seeks to the keyframe
+// before the first frame and decodes the next frames without seeking: this should cover the group of pictures
+// of the common inter-frame codecs, an intra-frame codec such as ProRes does not need it.
+#define NATRON_READ_PREFETCH_VIDEO_GOP_SIZE 16
+
+NATRON_NAMESPACE_ENTER;
+
+struct ReadPrefetchRequest
+{
+    NodeWPtr reader;
+    TimeValue time;
+    ViewIdx view;
+    unsigned int mipMapLevel;
+    bool draftMode;
+
+    // The number of frames to decode from time: a whole group of pictures for a video, 1 otherwise
+    int nFrames;
+    RenderPriorityEnum priority;
+
+    // The value of ReadNodePrefetcherPrivate::generation when the request was queued
+    U64 generation;
+};
+
+// Identifies a decode: the reader, the time, the view and the mipmap level
+typedef boost::tuple<const Node*, double, int, unsigned int> ReadPrefetchKey;
+
+struct ReadNodePrefetcherPrivate
+{
+    // Protects all data below
+    QMutex lock;
+
+    // The decodes not started yet, the nearest frames first
+    std::list<ReadPrefetchRequest> queue;
+
+    // The groups of pictures of the videos not decoded yet, the nearest first. They are decoded in order by a single
+    // thread: decoding the frames of a video concurrently or backwards makes the decoder seek to a keyframe for each frame.
+    std::list<ReadPrefetchRequest> videoQueue;
+
+    // The decodes queued since the last call to stop(). A group of pictures is identified by its first frame.
+    std::set<ReadPrefetchKey> requested;
+
+    // The frames of the videos queued or being decoded, see waitForVideoFrames()
+    std::set<ReadPrefetchKey> pendingVideoFrames;
+    QWaitCondition pendingVideoFramesCond;
+
+    // The decodes in progress, so that they can be aborted in stop()
+    std::list<TreeRenderPtr> activeRenders;
+
+    // Incremented in stop(): requests of a previous generation are not decoded
+    U64 generation;
+
+    // Number of worker runnables started on threadPool
+    int nActiveWorkers;
+
+    // True if a worker is started on videoThreadPool
+    bool videoWorkerActive;
+
+    QThreadPool threadPool;
+
+    // A single thread decoding the videos
+    QThreadPool videoThreadPool;
+
+    ReadNodePrefetcherPrivate()
+    : lock()
+    , queue()
+    , videoQueue()
+    , requested()
+    , pendingVideoFrames()
+    , pendingVideoFramesCond()
+    , activeRenders()
+    , generation(0)
+    , nActiveWorkers(0)
+    , videoWorkerActive(false)
+    , threadPool()
+    , videoThreadPool()
+    {
+        threadPool.setMaxThreadCount(NATRON_READ_PREFETCH_N_THREADS);
+        videoThreadPool.setMaxThreadCount(1);
+    }
+
+    /**
+     * @brief Pops the next request to decode. Returns false if there is none, in which case the worker calling this must return.
+     **/
+    bool popNextRequest(bool video, ReadPrefetchRequest* request)
+    {
+        QMutexLocker k(&lock);
+        std::list<ReadPrefetchRequest>& requests = video ? videoQueue : queue;
+        if ( requests.empty() ) {
+            if (video) {
+                videoWorkerActive = false;
+            } else {
+                --nActiveWorkers;
+            }
+
+            return false;
+        }
+        *request = requests.front();
+        requests.pop_front();
+
+        return true;
+    }
+
+    void decode(const ReadPrefetchRequest& request);
+
+    void decodeFrame(const NodePtr& reader, const ReadPrefetchRequest& request, TimeValue time);
+};
+
+class ReadPrefetchWorker
+    : public QRunnable
+{
+    ReadNodePrefetcherPrivate* _imp;
+    bool _video;
+
+public:
+
+    ReadPrefetchWorker(ReadNodePrefetcherPrivate* imp, bool video)
+        : QRunnable()
+        , _imp(imp)
+        , _video(video)
+    {
+        setAutoDelete(true);
+    }
+
+    virtual ~ReadPrefetchWorker()
+    {
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        ReadPrefetchRequest request;
+        while ( _imp->popNextRequest(_video, &request) ) {
+            _imp->decode(request);
+        }
+    }
+};
+
+/**
+ * @brief Returns the first frame of the group of pictures of the given video reader containing time, and in nFrames
+ * the number of frames from there to decode, within the frame range of the reader.
+ **/
+static TimeValue
+getVideoGOPStart(const RangeD& range,
+                 TimeValue time,
+                 int* nFrames)
+{
+    double first = range.min;
+    if (range.min > range.max) {
+        // Unknown frame range
+        first = 0;
+    }
+    double gopStart = first + std::floor( (time - first) / NATRON_READ_PREFETCH_VIDEO_GOP_SIZE ) * NATRON_READ_PREFETCH_VIDEO_GOP_SIZE;
+    *nFrames = NATRON_READ_PREFETCH_VIDEO_GOP_SIZE;
+    if (range.min <= range.max) {
+        gopStart = std::max(gopStart, range.min);
+        *nFrames = std::max( 1, std::min( *nFrames, (int)(range.max - gopStart) + 1 ) );
+    }
+
+    return TimeValue(gopStart);
+}
+
+static RangeD
+getReaderFrameRange(const NodePtr& reader)
+{
+    RangeD range = {1., 0.};
+    GetFrameRangeResultsPtr results;
+    ActionRetCodeEnum stat = reader->getEffectInstance()->getFrameRange_public(&results);
+    if ( !isFailureRetCode(stat) && results ) {
+        results->getFrameRangeResults(&range);
+    }
+
+    return range;
+}
+
+static void
+appendUpstreamReaders(const NodePtr& node,
+                      std::set<NodePtr>* visited,
+                      std::list<NodePtr>* readers)
+{
+    if ( !node || !visited->insert(node).second ) {
+        return;
+    }
+    // getInput() applies the group redirections: a Read node input resolves to the reader plug-in it embeds
+    if ( node->getEffectInstance()->isReader() ) {
+        readers->push_back(node);
+    }
+    int nInputs = node->getMaxInputCount();
+    for (int i = 0; i < nInputs; ++i) {
+        appendUpstreamReaders(node->getInput(i), visited, readers);
+    }
+}
+
+ReadNodePrefetcher::ReadNodePrefetcher()
+    : _imp( new ReadNodePrefetcherPrivate )
+{
+}
+
+ReadNodePrefetcher::~ReadNodePrefetcher()
+{
+    stop();
+}
+
+void
+ReadNodePrefetcher::prefetch(const NodePtr& treeRoot,
+                             TimeValue currentTime,
+                             const std::list<TimeValue>& frames,
+                             const std::vector<ViewIdx>& views,
+                             unsigned int mipMapLevel,
+                             bool draftMode,
+                             RenderPriorityEnum videoPriority)
+{
+    std::list<NodePtr> readers;
+    {
+        std::set<NodePtr> visited;
+        appendUpstreamReaders(treeRoot, &visited, &readers);
+    }
+
+    // The frame range bounds the groups of pictures of the videos
+    std::map<NodePtr, RangeD> videoReaders;
+    for (std::list<NodePtr>::iterator it = readers.begin(); it != readers.end();) {
+        if ( (*it)->getEffectInstance()->isVideoReader() ) {
+            videoReaders[*it] = getReaderFrameRange(*it);
+            it = readers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    QMutexLocker k(&_imp->lock);
+
+    // The caller decodes currentTime itself
+    for (std::list<ReadPrefetchRequest>::iterator it = _imp->queue.begin(); it != _imp->queue.end();) {
+        if (it->time == currentTime) {
+            it = _imp->queue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (std::list<TimeValue>::const_iterator itFrame = frames.begin(); itFrame != frames.end(); ++itFrame) {
+        for (std::list<NodePtr>::const_iterator itReader = readers.begin(); itReader != readers.end(); ++itReader) {
+            for (std::size_t i = 0; i < views.size(); ++i) {
+                ReadPrefetchKey key( itReader->get(), (double)*itFrame, (int)views[i], mipMapLevel );
+                if ( !_imp->requested.insert(key).second ) {
+                    continue;
+                }
+                ReadPrefetchRequest request;
+                request.reader = *itReader;
+                request.time = *itFrame;
+                request.view = views[i];
+                request.mipMapLevel = mipMapLevel;
+                request.draftMode = draftMode;
+                request.nFrames = 1;
+                request.priority = eRenderPriorityIdle;
+                request.generation = _imp->generation;
+                _imp->queue.push_back(request);
+            }
+        }
+    }
+
+    // A video is decoded by groups of pictures, which include currentTime: the caller waits for it in waitForVideoFrames().
+    // The group of currentTime is decoded first, then the groups of the next frames in the order of frames.
+    for (std::map<NodePtr, RangeD>::const_iterator itReader = videoReaders.begin(); itReader != videoReaders.end(); ++itReader) {
+        std::list<TimeValue> videoFrames(frames);
+        videoFrames.push_front(currentTime);
+        std::list<ReadPrefetchRequest>::iterator insertPos = _imp->videoQueue.begin();
+        for (std::list<TimeValue>::const_iterator itFrame = videoFrames.begin(); itFrame != videoFrames.end(); ++itFrame) {
+            int nFrames;
+            TimeValue gopStart = getVideoGOPStart(itReader->second, *itFrame, &nFrames);
+            for (std::size_t i = 0; i < views.size(); ++i) {
+                ReadPrefetchKey key( itReader->first.get(), (double)gopStart, (int)views[i], mipMapLevel );
+                if ( !_imp->requested.insert(key).second ) {
+                    continue;
+                }
+                ReadPrefetchRequest request;
+                request.reader = itReader->first;
+                request.time = gopStart;
+                request.view = views[i];
+                request.mipMapLevel = mipMapLevel;
+                request.draftMode = draftMode;
+                request.nFrames = nFrames;
+                request.priority = videoPriority;
+                request.generation = _imp->generation;
+                if (itFrame == videoFrames.begin()) {
+                    _imp->videoQueue.insert(insertPos, request);
+                } else {
+                    _imp->videoQueue.push_back(request);
+                }
+                for (int f = 0; f < nFrames; ++f) {
+                    _imp->pendingVideoFrames.insert( ReadPrefetchKey( itReader->first.get(), (double)gopStart + f, (int)views[i], mipMapLevel ) );
+                }
+            }
+        }
+    }
+
+    while ( !_imp->queue.empty() && (_imp->nActiveWorkers < NATRON_READ_PREFETCH_N_THREADS) ) {
+        ++_imp->nActiveWorkers;
+        _imp->threadPool.start( new ReadPrefetchWorker( _imp.get(), false ) );
+    }
+    if ( !_imp->videoQueue.empty() && !_imp->videoWorkerActive ) {
+        _imp->videoWorkerActive = true;
+        _imp->videoThreadPool.start( new ReadPrefetchWorker( _imp.get(), true ) );
+    }
+} // prefetch
+
+void
+ReadNodePrefetcher::waitForVideoFrames(const NodePtr& treeRoot,
+                                       TimeValue time,
+                                       const std::vector<ViewIdx>& views,
+                                       unsigned int mipMapLevel)
+{
+    std::list<NodePtr> readers;
+    {
+        std::set<NodePtr> visited;
+        appendUpstreamReaders(treeRoot, &visited, &readers);
+    }
+    std::list<ReadPrefetchKey> keys;
+    for (std::list<NodePtr>::const_iterator it = readers.begin(); it != readers.end(); ++it) {
+        if ( (*it)->getEffectInstance()->isVideoReader() ) {
+            for (std::size_t i = 0; i < views.size(); ++i) {
+                keys.push_back( ReadPrefetchKey( it->get(), (double)time, (int)views[i], mipMapLevel ) );
+            }
+        }
+    }
+    if ( keys.empty() ) {
+        return;
+    }
+
+    QMutexLocker k(&_imp->lock);
+
+    bool isThreadPoolThread = isRunningInThreadPoolThread();
+    bool threadReleased = false;
+    for (std::list<ReadPrefetchKey>::const_iterator it = keys.begin(); it != keys.end(); ++it) {
+        while ( _imp->pendingVideoFrames.find(*it) != _imp->pendingVideoFrames.end() ) {
+            // Do not hold a thread of the global thread pool while the video thread decodes
+            if (isThreadPoolThread && !threadReleased) {
+                QThreadPool::globalInstance()->releaseThread();
+                threadReleased = true;
+            }
+            _imp->pendingVideoFramesCond.wait(&_imp->lock);
+        }
+    }
+    if (threadReleased) {
+        QThreadPool::globalInstance()->reserveThread();
+    }
+} // waitForVideoFrames
+
+void
+ReadNodePrefetcherPrivate::decode(const ReadPrefetchRequest& request)
+{
+    NodePtr reader = request.reader.lock();
+    for (int i = 0; i < request.nFrames; ++i) {
+        TimeValue time(request.time + i);
+        if (reader) {
+            decodeFrame(reader, request, time);
+        }
+
+        // Notify the render threads waiting for this frame if this is a video
+        QMutexLocker k(&lock);
+        if ( pendingVideoFrames.erase( ReadPrefetchKey( reader.get(), (double)time, (int)request.view, request.mipMapLevel ) ) ) {
+            pendingVideoFramesCond.wakeAll();
+        }
+        if (request.generation != generation) {
+            return;
+        }
+    }
+} // decode
+
+void
+ReadNodePrefetcherPrivate::decodeFrame(const NodePtr& reader,
+                                       const ReadPrefetchRequest& request,
+                                       TimeValue time)
+{
+    TreeRender::CtorArgsPtr args(new TreeRender::CtorArgs);
+    args->treeRootEffect = reader->getEffectInstance();
+    args->time = time;
+    args->view = request.view;
+    args->plane = 0;
+    args->mipMapLevel = request.mipMapLevel;
+    args->proxyScale = RenderScale(1.);
+    args->canonicalRoI = 0;
+    args->draftMode = request.draftMode;
+    args->playback = true;
+    args->byPassCache = false;
+    args->priority = request.priority;
+
+    TreeRenderPtr render = TreeRender::create(args);
+    if (!render) {
+        return;
+    }
+    {
+        QMutexLocker k(&lock);
+        if (request.generation != generation) {
+            return;
+        }
+        activeRenders.push_back(render);
+    }
+
+    // The decoded image stays in the cache: the result is not needed here
+    FrameViewRequestPtr outputRequest;
+    ignore_result( render->launchRender(&outputRequest) );
+
+    QMutexLocker k(&lock);
+    activeRenders.remove(render);
+} // decodeFrame
+
+void
+ReadNodePrefetcher::stop()
+{
+    {
+        QMutexLocker k(&_imp->lock);
+        ++_imp->generation;
+        _imp->queue.clear();
+        _imp->videoQueue.clear();
+        _imp->requested.clear();
+        _imp->pendingVideoFrames.clear();
+        _imp->pendingVideoFramesCond.wakeAll();
+        for (std::list<TreeRenderPtr>::const_iterator it = _imp->activeRenders.begin(); it != _imp->activeRenders.end(); ++it) {
+            (*it)->setRenderAborted();
+        }
+    }
+    _imp->threadPool.waitForDone();
+    _imp->videoThreadPool.waitForDone();
+}
+
+NATRON_NAMESPACE_EXIT;
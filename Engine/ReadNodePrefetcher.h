@@ -0,0 +1,104 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_READNODEPREFETCHER_H
+#define NATRON_ENGINE_READNODEPREFETCHER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <list>
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/TimeValue.h"
+#include "Engine/ViewIdx.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct ReadNodePrefetcherPrivate;
+
+/**
+ * @brief Decodes the frames of the readers upstream of a playback or a render on disk ahead of the render threads,
+ * so that when a render thread reaches a frame, the decoded image is already in the cache.
+ * Decoding from a network storage mostly waits for the file to be read: the decodes run on dedicated threads
+ * so that they do not take the threads of the global thread pool used to render.
+ * Each decode is a TreeRender whose root is the reader plug-in embedded in the Read node (which is what the
+ * render threads pull images from), rendered at the same scale as the frames rendered by the scheduler.
+ * All functions are MT-safe.
+ **/
+class ReadNodePrefetcher
+{
+public:
+
+    ReadNodePrefetcher();
+
+    ~ReadNodePrefetcher();
+
+    /**
+     * @brief Queue the decode of the given frames for all the readers upstream of treeRoot.
+     * Frames which were already queued since the last call to stop() are skipped.
+     * currentTime is the frame the caller starts rendering: its decodes which are still queued
+     * are removed since the caller will decode them.
+     *
+     * The videos are decoded differently: the frames of an inter-frame codec cannot be decoded concurrently or backwards
+     * without seeking to a keyframe for each frame. A single thread decodes them by groups of pictures, each in order,
+     * starting with the group of currentTime, at the given priority: the caller must then call waitForVideoFrames() so that
+     * it finds the frames of the videos in the cache instead of decoding them itself. This also serves reverse playback.
+     **/
+    void prefetch(const NodePtr& treeRoot,
+                  TimeValue currentTime,
+                  const std::list<TimeValue>& frames,
+                  const std::vector<ViewIdx>& views,
+                  unsigned int mipMapLevel,
+                  bool draftMode,
+                  RenderPriorityEnum videoPriority);
+
+    /**
+     * @brief Blocks until the frame at the given time of the videos upstream of treeRoot is decoded, if it was queued by prefetch()
+     **/
+    void waitForVideoFrames(const NodePtr& treeRoot,
+                            TimeValue time,
+                            const std::vector<ViewIdx>& views,
+                            unsigned int mipMapLevel);
+
+    /**
+     * @brief Removes the queued decodes, aborts the decodes in progress and waits for them to return.
+     **/
+    void stop();
+
+private:
+
+    boost::scoped_ptr<ReadNodePrefetcherPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_READNODEPREFETCHER_H
@@ -0,0 +1,137 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderArena.h"
+
+#include <algorithm> // min, max
+#include <cassert>
+#include <cstdlib> // malloc, free
+#include <vector>
+
+#include <QtCore/QMutex>
+
+// Alignment of all allocations, enough for any type used by the render objects
+#define NATRON_RENDER_ARENA_ALIGNMENT 16
+
+// Size of the first block of the arena: most renders of a simple graph fit in it
+#define NATRON_RENDER_ARENA_FIRST_BLOCK_SIZE (16 * 1024)
+
+// Blocks double in size up to this size
+#define NATRON_RENDER_ARENA_MAX_BLOCK_SIZE (256 * 1024)
+
+NATRON_NAMESPACE_ENTER;
+
+struct RenderArenaPrivate
+{
+    // Protects all data below
+    mutable QMutex lock;
+
+    // All the blocks taken from the heap
+    std::vector<char*> blocks;
+
+    // The free space of the current block
+    char* current;
+    std::size_t remaining;
+
+    // Size of the next block to allocate
+    std::size_t nextBlockSize;
+
+    std::size_t reservedBytes;
+
+    RenderArenaPrivate()
+    : lock()
+    , blocks()
+    , current(0)
+    , remaining(0)
+    , nextBlockSize(NATRON_RENDER_ARENA_FIRST_BLOCK_SIZE)
+    , reservedBytes(0)
+    {
+    }
+
+    char* allocateBlock(std::size_t size)
+    {
+        char* block = static_cast<char*>( std::malloc(size) );
+        if (!block) {
+            throw std::bad_alloc();
+        }
+        blocks.push_back(block);
+        reservedBytes += size;
+
+        return block;
+    }
+};
+
+RenderArena::RenderArena()
+    : _imp( new RenderArenaPrivate() )
+{
+}
+
+RenderArena::~RenderArena()
+{
+    for (std::size_t i = 0; i < _imp->blocks.size(); ++i) {
+        std::free(_imp->blocks[i]);
+    }
+}
+
+void*
+RenderArena::allocate(std::size_t size)
+{
+    // Keep all allocations aligned
+    size = ( (size + NATRON_RENDER_ARENA_ALIGNMENT - 1) / NATRON_RENDER_ARENA_ALIGNMENT ) * NATRON_RENDER_ARENA_ALIGNMENT;
+    if (size == 0) {
+        size = NATRON_RENDER_ARENA_ALIGNMENT;
+    }
+
+    QMutexLocker k(&_imp->lock);
+    if (size <= _imp->remaining) {
+        char* ret = _imp->current;
+        _imp->current += size;
+        _imp->remaining -= size;
+
+        return ret;
+    }
+
+    // Allocations larger than a block get their own block, the current block is kept for the next allocations
+    if (size > NATRON_RENDER_ARENA_MAX_BLOCK_SIZE / 2) {
+        return _imp->allocateBlock(size);
+    }
+
+    std::size_t blockSize = std::max(_imp->nextBlockSize, size);
+    char* block = _imp->allocateBlock(blockSize);
+    _imp->nextBlockSize = std::min(_imp->nextBlockSize * 2, (std::size_t)NATRON_RENDER_ARENA_MAX_BLOCK_SIZE);
+    _imp->current = block + size;
+    _imp->remaining = blockSize - size;
+
+    return block;
+} // allocate
+
+std::size_t
+RenderArena::getReservedBytes() const
+{
+    QMutexLocker k(&_imp->lock);
+
+    return _imp->reservedBytes;
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,190 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_RENDERARENA_H
+#define NATRON_ENGINE_RENDERARENA_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief A monotonic allocator for the small objects created by a single render (the FrameViewRequest,
+ * the RequestPassSharedData, the nodes of their containers and their shared_ptr control blocks).
+ * Memory is taken from large blocks and is never given back individually: all blocks are freed at once
+ * when the arena is destroyed, which happens when the last object allocated with a RenderArenaAllocator is destroyed.
+ * This avoids contention on the global heap when many threads create render requests concurrently.
+ * All functions are MT-safe.
+ **/
+struct RenderArenaPrivate;
+class RenderArena
+{
+public:
+
+    RenderArena();
+
+    ~RenderArena();
+
+    /**
+     * @brief Returns a block of the given size, suitably aligned for any type.
+     * Throws std::bad_alloc if the memory cannot be allocated.
+     **/
+    void* allocate(std::size_t size);
+
+    /**
+     * @brief Returns the memory taken from the heap by the arena
+     **/
+    std::size_t getReservedBytes() const;
+
+private:
+
+    boost::scoped_ptr<RenderArenaPrivate> _imp;
+};
+
+/**
+ * @brief A standard allocator allocating from a RenderArena. Each copy of the allocator, and thus each container
+ * or shared_ptr using it, holds a strong reference to the arena.
+ * A default constructed allocator has no arena and allocates on the heap, so that containers using it
+ * may be declared before the arena is known.
+ **/
+template <typename T>
+class RenderArenaAllocator
+{
+public:
+
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef RenderArenaAllocator<U> other;
+    };
+
+    RenderArenaAllocator()
+    : _arena()
+    {
+    }
+
+    explicit RenderArenaAllocator(const RenderArenaPtr& arena)
+    : _arena(arena)
+    {
+    }
+
+    template <typename U>
+    RenderArenaAllocator(const RenderArenaAllocator<U>& other)
+    : _arena( other.getArena() )
+    {
+    }
+
+    const RenderArenaPtr& getArena() const
+    {
+        return _arena;
+    }
+
+    pointer address(reference x) const
+    {
+        return &x;
+    }
+
+    const_pointer address(const_reference x) const
+    {
+        return &x;
+    }
+
+    pointer allocate(size_type n, const void* /*hint*/ = 0)
+    {
+        if ( n > max_size() ) {
+            throw std::bad_alloc();
+        }
+        if (!_arena) {
+            return static_cast<pointer>( ::operator new( n * sizeof(T) ) );
+        }
+
+        return static_cast<pointer>( _arena->allocate( n * sizeof(T) ) );
+    }
+
+    void deallocate(pointer p, size_type /*n*/)
+    {
+        // Memory allocated in the arena is freed with the arena
+        if (!_arena) {
+            ::operator delete(p);
+        }
+    }
+
+    size_type max_size() const
+    {
+        return std::numeric_limits<size_type>::max() / sizeof(T);
+    }
+
+    void construct(pointer p, const T& value)
+    {
+        new (static_cast<void*>(p)) T(value);
+    }
+
+    void destroy(pointer p)
+    {
+        p->~T();
+    }
+
+private:
+
+    RenderArenaPtr _arena;
+};
+
+template <typename T, typename U>
+bool
+operator==(const RenderArenaAllocator<T>& lhs, const RenderArenaAllocator<U>& rhs)
+{
+    return lhs.getArena() == rhs.getArena();
+}
+
+template <typename T, typename U>
+bool
+operator!=(const RenderArenaAllocator<T>& lhs, const RenderArenaAllocator<U>& rhs)
+{
+    return lhs.getArena() != rhs.getArena();
+}
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_RENDERARENA_H
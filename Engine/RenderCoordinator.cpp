@@ -0,0 +1,424 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderCoordinator.h"
+
+#include <algorithm> // find
+#include <cassert>
+#include <iostream>
+#include <list>
+#include <map>
+#include <stdexcept>
+
+#include <QtCore/QEventLoop>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+#include "Engine/AppInstance.h"
+#include "Engine/CLArgs.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Node.h"
+#include "Engine/RenderQueue.h"
+
+// Number of times a frame is rendered before it is considered as failed
+#define NATRON_RENDER_FARM_MAX_FRAME_ATTEMPTS 3
+
+NATRON_NAMESPACE_ENTER;
+
+struct RenderFarmTask
+{
+    std::string writer;
+    int frame;
+
+    // The workers on which the frame failed
+    std::list<QString> failedWorkers;
+};
+
+struct RenderFarmWorker
+{
+    // The host name and address of the worker, empty until it is ready
+    QString name;
+
+    // The frame being rendered by the worker
+    bool hasTask;
+    RenderFarmTask task;
+
+    RenderFarmWorker()
+    : name()
+    , hasTask(false)
+    , task()
+    {
+    }
+};
+
+struct RenderCoordinatorPrivate
+{
+    AppInstanceWPtr app;
+    QString projectFilePath;
+    boost::scoped_ptr<QTcpServer> server;
+    QEventLoop eventLoop;
+
+    // The frames not rendered yet, the frames to retry first
+    std::list<RenderFarmTask> pendingTasks;
+
+    // The frames which failed NATRON_RENDER_FARM_MAX_FRAME_ATTEMPTS times
+    std::list<RenderFarmTask> failedTasks;
+
+    std::map<QTcpSocket*, RenderFarmWorker> workers;
+
+    int nTasks;
+    int nTasksRendered;
+
+    RenderCoordinatorPrivate(const AppInstancePtr& app)
+    : app(app)
+    , projectFilePath()
+    , server()
+    , eventLoop()
+    , pendingTasks()
+    , failedTasks()
+    , workers()
+    , nTasks(0)
+    , nTasksRendered(0)
+    {
+    }
+
+    bool createTasks(const CLArgs& cl, QString* error);
+
+    void writeToWorker(QTcpSocket* socket, const QString& message);
+
+    /**
+     * @brief Returns the best pending task for the given worker, or pendingTasks.end() if the worker
+     * should rather stay idle
+     **/
+    std::list<RenderFarmTask>::iterator pickTask(QTcpSocket* socket);
+
+    /**
+     * @brief Sends a frame to all the workers which are idle
+     **/
+    void dispatchTasks();
+
+    void onFrameFinished(QTcpSocket* socket, const QString& message);
+
+    /**
+     * @brief Quits the event loop if all frames are rendered or failed
+     **/
+    void checkFinished();
+};
+
+RenderCoordinator::RenderCoordinator(const AppInstancePtr& app)
+    : QObject()
+    , _imp( new RenderCoordinatorPrivate(app) )
+{
+}
+
+RenderCoordinator::~RenderCoordinator()
+{
+    for (std::map<QTcpSocket*, RenderFarmWorker>::iterator it = _imp->workers.begin(); it != _imp->workers.end(); ++it) {
+        it->first->disconnect(this);
+        it->first->abort();
+        delete it->first;
+    }
+    if (_imp->server) {
+        _imp->server->close();
+    }
+}
+
+bool
+RenderCoordinatorPrivate::createTasks(const CLArgs& cl,
+                                      QString* error)
+{
+    AppInstancePtr instance = app.lock();
+    if (!instance) {
+        *error = RenderCoordinator::tr("The application was closed.");
+
+        return false;
+    }
+
+    // The workers load the project file as is: they would not know about the writers created from the command-line
+    const std::list<CLArgs::WriterArg>& writerArgs = cl.getWriterArgs();
+    for (std::list<CLArgs::WriterArg>::const_iterator it = writerArgs.begin(); it != writerArgs.end(); ++it) {
+        if ( it->mustCreate || !it->filename.isEmpty() ) {
+            *error = RenderCoordinator::tr("%1: The output file of a Write node cannot be set from the command-line in a distributed render.").arg(it->name);
+
+            return false;
+        }
+    }
+
+    RenderQueuePtr queue = instance->getRenderQueue();
+    std::list<RenderQueue::RenderWork> works;
+    try {
+        queue->createRenderRequestsFromCommandLineArgs(cl, works);
+    } catch (const std::exception& e) {
+        *error = QString::fromUtf8( e.what() );
+
+        return false;
+    }
+    if ( works.empty() ) {
+        *error = RenderCoordinator::tr("No active Write node to render.");
+
+        return false;
+    }
+
+    for (std::list<RenderQueue::RenderWork>::iterator it = works.begin(); it != works.end(); ++it) {
+        if ( !queue->validateRenderOptions(&*it) ) {
+            *error = RenderCoordinator::tr("%1: Invalid frame range.").arg( QString::fromUtf8( it->treeRoot->getScriptName_mt_safe().c_str() ) );
+
+            return false;
+        }
+
+        // Video files are written by a single process in the order of the frames
+        EffectInstancePtr effect = it->treeRoot->getEffectInstance();
+        if ( effect->isVideoWriter() || (effect->getSequentialPreference() == eSequentialPreferenceOnlySequential) ) {
+            *error = RenderCoordinator::tr("%1: This Write node needs to render the frames in order and cannot be rendered by several workers.").arg( QString::fromUtf8( it->treeRoot->getScriptName_mt_safe().c_str() ) );
+
+            return false;
+        }
+
+        RenderFarmTask task;
+        task.writer = it->treeRoot->getFullyQualifiedName();
+        int step = (int)it->frameStep;
+        for (int frame = (int)it->firstFrame; step > 0 ? frame <= (int)it->lastFrame : frame >= (int)it->lastFrame; frame += step) {
+            task.frame = frame;
+            pendingTasks.push_back(task);
+        }
+    }
+    nTasks = (int)pendingTasks.size();
+
+    return true;
+} // createTasks
+
+bool
+RenderCoordinator::exec(int port,
+                        const CLArgs& cl)
+{
+    _imp->projectFilePath = QFileInfo( cl.getScriptFilename() ).absoluteFilePath();
+
+    QString error;
+    if ( !_imp->createTasks(cl, &error) ) {
+        std::cerr << error.toStdString() << std::endl;
+
+        return false;
+    }
+
+    _imp->server.reset( new QTcpServer() );
+    QObject::connect( _imp->server.get(), SIGNAL(newConnection()), this, SLOT(onNewConnection()) );
+    if ( !_imp->server->listen( QHostAddress::Any, (quint16)port ) ) {
+        std::cerr << tr("Failed to create the render coordinator on port %1: %2").arg(port).arg( _imp->server->errorString() ).toStdString() << std::endl;
+
+        return false;
+    }
+    std::cout << tr("Render coordinator waiting for workers on port %1 to render %2 frames").arg(port).arg(_imp->nTasks).toStdString() << std::endl;
+
+    if ( !_imp->pendingTasks.empty() ) {
+        _imp->eventLoop.exec();
+    }
+    _imp->server->close();
+
+    for (std::list<RenderFarmTask>::const_iterator it = _imp->failedTasks.begin(); it != _imp->failedTasks.end(); ++it) {
+        std::cerr << tr("%1: Frame %2 could not be rendered.").arg( QString::fromUtf8( it->writer.c_str() ) ).arg(it->frame).toStdString() << std::endl;
+    }
+    std::cout << tr("Distributed render finished: %1 of %2 frames rendered").arg(_imp->nTasksRendered).arg(_imp->nTasks).toStdString() << std::endl;
+
+    return _imp->failedTasks.empty();
+} // exec
+
+void
+RenderCoordinatorPrivate::writeToWorker(QTcpSocket* socket,
+                                        const QString& message)
+{
+    socket->write( ( message + QLatin1Char('\n') ).toUtf8() );
+    socket->flush();
+}
+
+void
+RenderCoordinator::onNewConnection()
+{
+    while ( _imp->server->hasPendingConnections() ) {
+        QTcpSocket* socket = _imp->server->nextPendingConnection();
+        if (!socket) {
+            continue;
+        }
+        // The sockets are owned by the coordinator, not by the server
+        socket->setParent(0);
+        QObject::connect( socket, SIGNAL(readyRead()), this, SLOT(onWorkerReadyRead()) );
+        QObject::connect( socket, SIGNAL(disconnected()), this, SLOT(onWorkerDisconnected()) );
+        _imp->workers.insert( std::make_pair( socket, RenderFarmWorker() ) );
+        _imp->writeToWorker( socket, QString::fromUtf8(kRenderFarmJobShort " ") + _imp->projectFilePath );
+    }
+}
+
+void
+RenderCoordinator::onWorkerReadyRead()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>( sender() );
+    std::map<QTcpSocket*, RenderFarmWorker>::iterator found = _imp->workers.find(socket);
+    if ( found == _imp->workers.end() ) {
+        return;
+    }
+    while ( socket->canReadLine() ) {
+        QString str = QString::fromUtf8( socket->readLine() );
+        while ( str.endsWith( QLatin1Char('\n') ) || str.endsWith( QLatin1Char('\r') ) ) {
+            str.chop(1);
+        }
+        if ( str.startsWith( QString::fromUtf8(kRenderFarmFrameFinishedShort) ) ) {
+            _imp->onFrameFinished( socket, str.mid( QString::fromUtf8(kRenderFarmFrameFinishedShort).size() ).trimmed() );
+        } else if ( str.startsWith( QString::fromUtf8(kRenderFarmWorkerReadyShort) ) ) {
+            found->second.name = tr("%1 (%2)").arg( str.mid( QString::fromUtf8(kRenderFarmWorkerReadyShort).size() ).trimmed() ).arg( socket->peerAddress().toString() );
+            std::cout << tr("Worker %1 connected").arg(found->second.name).toStdString() << std::endl;
+        }
+    }
+    _imp->dispatchTasks();
+    _imp->checkFinished();
+}
+
+void
+RenderCoordinatorPrivate::onFrameFinished(QTcpSocket* socket,
+                                          const QString& message)
+{
+    std::map<QTcpSocket*, RenderFarmWorker>::iterator found = workers.find(socket);
+    assert( found != workers.end() );
+    RenderFarmWorker& worker = found->second;
+
+    // <status> <frame> [error]
+    QStringList fields = message.split( QLatin1Char(' ') );
+    if ( !worker.hasTask || (fields.size() < 2) || (fields[1].toInt() != worker.task.frame) ) {
+        return;
+    }
+    worker.hasTask = false;
+
+    if (fields[0].toInt() == 0) {
+        ++nTasksRendered;
+        std::cout << RenderCoordinator::tr("%1 ==> Frame %2 rendered by %3 (%4 of %5)").arg( QString::fromUtf8( worker.task.writer.c_str() ) ).arg(worker.task.frame).arg(worker.name).arg(nTasksRendered).arg(nTasks).toStdString() << std::endl;
+
+        return;
+    }
+
+    QString error = QStringList( fields.mid(2) ).join( QString::fromUtf8(" ") );
+    std::cerr << RenderCoordinator::tr("%1 ==> Frame %2 failed on %3: %4").arg( QString::fromUtf8( worker.task.writer.c_str() ) ).arg(worker.task.frame).arg(worker.name).arg(error).toStdString() << std::endl;
+    worker.task.failedWorkers.push_back(worker.name);
+    if ( (int)worker.task.failedWorkers.size() < NATRON_RENDER_FARM_MAX_FRAME_ATTEMPTS ) {
+        pendingTasks.push_front(worker.task);
+    } else {
+        failedTasks.push_back(worker.task);
+    }
+} // onFrameFinished
+
+void
+RenderCoordinator::onWorkerDisconnected()
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>( sender() );
+    std::map<QTcpSocket*, RenderFarmWorker>::iterator found = _imp->workers.find(socket);
+    if ( found == _imp->workers.end() ) {
+        return;
+    }
+
+    // Give the frame of the worker to another one: this does not count as a failure of the frame
+    if (found->second.hasTask) {
+        std::cerr << tr("Lost worker %1 while rendering frame %2").arg(found->second.name).arg(found->second.task.frame).toStdString() << std::endl;
+        _imp->pendingTasks.push_front(found->second.task);
+    } else if ( !found->second.name.isEmpty() ) {
+        std::cout << tr("Worker %1 disconnected").arg(found->second.name).toStdString() << std::endl;
+    }
+    _imp->workers.erase(found);
+    socket->deleteLater();
+
+    _imp->dispatchTasks();
+    _imp->checkFinished();
+}
+
+std::list<RenderFarmTask>::iterator
+RenderCoordinatorPrivate::pickTask(QTcpSocket* socket)
+{
+    const QString& name = workers[socket].name;
+
+    for (std::list<RenderFarmTask>::iterator it = pendingTasks.begin(); it != pendingTasks.end(); ++it) {
+        if ( std::find(it->failedWorkers.begin(), it->failedWorkers.end(), name) == it->failedWorkers.end() ) {
+            return it;
+        }
+    }
+
+    // All pending frames failed on this worker: only retry one here if no other worker can take it
+    for (std::list<RenderFarmTask>::iterator it = pendingTasks.begin(); it != pendingTasks.end(); ++it) {
+        bool otherWorkerCanRender = false;
+        for (std::map<QTcpSocket*, RenderFarmWorker>::const_iterator it2 = workers.begin(); it2 != workers.end(); ++it2) {
+            if ( (it2->first != socket) && !it2->second.name.isEmpty() &&
+                 ( std::find(it->failedWorkers.begin(), it->failedWorkers.end(), it2->second.name) == it->failedWorkers.end() ) ) {
+                otherWorkerCanRender = true;
+                break;
+            }
+        }
+        if (!otherWorkerCanRender) {
+            return it;
+        }
+    }
+
+    return pendingTasks.end();
+} // pickTask
+
+void
+RenderCoordinatorPrivate::dispatchTasks()
+{
+    for (std::map<QTcpSocket*, RenderFarmWorker>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        if ( pendingTasks.empty() ) {
+            return;
+        }
+        // Workers which did not report they are ready yet are still loading the project
+        if ( it->second.hasTask || it->second.name.isEmpty() ) {
+            continue;
+        }
+        std::list<RenderFarmTask>::iterator task = pickTask(it->first);
+        if ( task == pendingTasks.end() ) {
+            continue;
+        }
+        it->second.task = *task;
+        it->second.hasTask = true;
+        pendingTasks.erase(task);
+        writeToWorker( it->first, QString::fromUtf8(kRenderFarmFrameShort " ") + QString::number(it->second.task.frame) + QLatin1Char('\t') + QString::fromUtf8( it->second.task.writer.c_str() ) );
+    }
+}
+
+void
+RenderCoordinatorPrivate::checkFinished()
+{
+    if ( !pendingTasks.empty() ) {
+        return;
+    }
+    for (std::map<QTcpSocket*, RenderFarmWorker>::const_iterator it = workers.begin(); it != workers.end(); ++it) {
+        if (it->second.hasTask) {
+            return;
+        }
+    }
+    for (std::map<QTcpSocket*, RenderFarmWorker>::const_iterator it = workers.begin(); it != workers.end(); ++it) {
+        writeToWorker( it->first, QString::fromUtf8(kRenderServerQuitShort) );
+    }
+    eventLoop.quit();
+}
+
+NATRON_NAMESPACE_EXIT;
+
+NATRON_NAMESPACE_USING;
+#include "moc_RenderCoordinator.cpp"
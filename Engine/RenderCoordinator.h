@@ -0,0 +1,103 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_RENDERCOORDINATOR_H
+#define NATRON_ENGINE_RENDERCOORDINATOR_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+CLANG_DIAG_OFF(deprecated)
+CLANG_DIAG_OFF(uninitialized)
+#include <QtCore/QObject>
+CLANG_DIAG_ON(deprecated)
+CLANG_DIAG_ON(uninitialized)
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief The coordinator of a distributed render: it is started with the --render-coordinator <port> command-line
+ * option and, instead of rendering the frames of the Write nodes passed on the command-line, distributes them
+ * to the render workers (see RenderWorker) which connect to that port from any host.
+ *
+ * Frames are handed out one at a time: a worker is sent its next frame as soon as it reports the previous one,
+ * so that fast workers render more frames than slow ones when the cost of the frames varies across the shot.
+ * A frame that fails is retried, preferably on a worker on which it did not fail yet, until it failed
+ * NATRON_RENDER_FARM_MAX_FRAME_ATTEMPTS times. The frame of a worker that disconnects is given to another worker.
+ *
+ * As with ProcessHandler, each message consists of exactly 1 line. The coordinator sends:
+ * - kRenderFarmJobShort followed by the project file path, when a worker connects. The path must be valid on the host of the worker.
+ * - kRenderFarmFrameShort followed by the frame number and the tab-separated script name of the Write node to render it with.
+ * - kRenderServerQuitShort when all frames are rendered.
+ * The worker sends:
+ * - kRenderFarmWorkerReadyShort followed by its host name, once it is ready to render.
+ * - kRenderFarmFrameFinishedShort followed by 0 and the frame number if it was rendered, or by 1, the frame number
+ * and an error message otherwise.
+ *
+ * The network events are handled by an event loop in exec(), in the main thread.
+ **/
+struct RenderCoordinatorPrivate;
+class RenderCoordinator
+    : public QObject
+{
+    GCC_DIAG_SUGGEST_OVERRIDE_OFF
+    Q_OBJECT
+    GCC_DIAG_SUGGEST_OVERRIDE_ON
+
+public:
+
+    RenderCoordinator(const AppInstancePtr& app);
+
+    virtual ~RenderCoordinator();
+
+    /**
+     * @brief Listens on the given port and distributes the frames of the Write nodes given on the command-line
+     * until they are all rendered or failed too many times. This function blocks.
+     * Returns false if the coordinator could not be started or if some frames could not be rendered.
+     **/
+    bool exec(int port, const CLArgs& cl);
+
+private Q_SLOTS:
+
+    void onNewConnection();
+
+    void onWorkerReadyRead();
+
+    void onWorkerDisconnected();
+
+private:
+
+    boost::scoped_ptr<RenderCoordinatorPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_RENDERCOORDINATOR_H
@@ -33,6 +33,8 @@
 #include "Engine/CreateNodeArgs.h"
 #include "Engine/CLArgs.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/Format.h"
+#include "Engine/FrameStreamWriter.h"
 #include "Engine/KnobFile.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/Node.h"
@@ -197,9 +199,31 @@ RenderQueuePrivate::validateRenderOptions(RenderQueue::RenderWork& w)
             return false;
         }
     }
+
+    // The extra outputs are encoded on the render threads of the tree root, which renders the frames in any order
+    for (std::list<NodePtr>::iterator it = w.extraTreeRoots.begin(); it != w.extraTreeRoots.end();) {
+        EffectInstancePtr effect = (*it)->getEffectInstance();
+        if ( (*it == w.treeRoot) || !(*it)->isActivated() || effect->getDisabledKnobValue() ) {
+            it = w.extraTreeRoots.erase(it);
+            continue;
+        }
+        if ( !effect->isWriter() || effect->isVideoWriter() || (effect->getSequentialPreference() != eSequentialPreferenceNotSequential) ) {
+            Dialogs::errorDialog( (*it)->getLabel_mt_safe(),
+                                  _publicInterface->tr("Only writers of image sequences can be rendered along with another writer.").toStdString(), false );
+
+            return false;
+        }
+        ++it;
+    }
     return true;
 } // validateRenderOptions
 
+bool
+RenderQueue::validateRenderOptions(RenderWork* work)
+{
+    return _imp->validateRenderOptions(*work);
+}
+
 
 void
 RenderQueuePrivate::dispatchQueue(bool doBlockingRender, const std::list<RenderQueue::RenderWork>& writers)
@@ -240,7 +264,8 @@ RenderQueuePrivate::dispatchQueue(bool doBlockingRender, const std::list<RenderQ
 
         item.savePath = savePath;
 
-        if (renderInSeparateProcess) {
+        // A render of several writers in a single pass is not expressible on the command line of a background process
+        if ( renderInSeparateProcess && item.work.extraTreeRoots.empty() && !item.work.frameStream ) {
             item.process.reset( new ProcessHandler(savePath, item.work.treeRoot) );
             QObject::connect( item.process.get(), SIGNAL(processFinished(int)), _publicInterface, SLOT(onBackgroundRenderProcessFinished()) );
         } else {
@@ -310,6 +335,7 @@ RenderQueuePrivate::createRenderRequestsFromCommandLineArgsInternal(const std::l
 
     for (std::list<CLArgs::WriterArg>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
         NodePtr writerNode;
+        FrameStreamWriterPtr frameStream;
         if (!it->mustCreate) {
 
             std::string writerName = it->name.toStdString();
@@ -328,7 +354,20 @@ RenderQueuePrivate::createRenderRequestsFromCommandLineArgsInternal(const std::l
             if (!writerNode->isActivated() || writerNode->getEffectInstance()->getDisabledKnobValue()) {
                 continue;
             }
-            if ( !it->filename.isEmpty() ) {
+            if ( !it->streamFormat.isEmpty() ) {
+                // The stream is opened now so that what is printed from now on does not end up in it
+                FrameStreamWriter::FrameStreamFormatEnum format;
+                if ( !FrameStreamWriter::getFormatFromString(it->streamFormat.toStdString(), &format) ) {
+                    throw std::invalid_argument( _publicInterface->tr("Invalid stream format %1").arg(it->streamFormat).toStdString() );
+                }
+                Format projectFormat;
+                app->getProject()->getProjectDefaultFormat(&projectFormat);
+                frameStream.reset( new FrameStreamWriter( format, it->streamPath.toStdString(), projectFormat, app->getProjectFrameRate() ) );
+                std::string error;
+                if ( !frameStream->open(&error) ) {
+                    throw std::runtime_error(error);
+                }
+            } else if ( !it->filename.isEmpty() ) {
                 KnobIPtr fileKnob = writerNode->getKnobByName(kOfxImageEffectFileParamName);
                 if (fileKnob) {
                     KnobFilePtr outFile = toKnobFile(fileKnob);
@@ -371,6 +410,7 @@ RenderQueuePrivate::createRenderRequestsFromCommandLineArgsInternal(const std::l
                 request.lastFrame = TimeValue(it2->second.second);
                 request.frameStep = TimeValue(it2->first);
                 request.useRenderStats = useStats;
+                request.frameStream = frameStream;
                 requests.push_back(request);
             }
         } else {
@@ -382,6 +422,7 @@ RenderQueuePrivate::createRenderRequestsFromCommandLineArgsInternal(const std::l
             request.lastFrame = TimeValue(INT_MAX);
             request.frameStep = TimeValue(INT_MIN);
             request.useRenderStats = useStats;
+            request.frameStream = frameStream;
             requests.push_back(request);
         }
     } // for each writer cl args
@@ -406,6 +447,10 @@ RenderQueue::createRenderRequestsFromCommandLineArgs(const CLArgs& cl, std::list
         }
     }
     _imp->createRenderRequestsFromCommandLineArgsInternal(cl.getFrameRanges(), cl.areRenderStatsEnabled(), writerArgs, requests);
+    for (std::list<RenderQueue::RenderWork>::iterator it = requests.begin(); it != requests.end(); ++it) {
+        it->incremental = cl.isIncrementalRenderEnabled();
+        it->resume = cl.isResumeRenderEnabled();
+    }
 }
 
 
@@ -473,6 +518,10 @@ RenderQueuePrivate::renderInternal(const RenderQueueItem& w)
         
         // Note that we don't need to make the sequential render blocking since we already block in dispatchQueue()
         // The views passed are empty, meaning we want to render all views, see OutputSchedulerThreadPrivate::validateRenderSequenceArgs
+        w.work.treeRoot->getRenderEngine()->setExtraOutputNodes(w.work.extraTreeRoots);
+        w.work.treeRoot->getRenderEngine()->setFrameStreamWriter(w.work.frameStream);
+        w.work.treeRoot->getRenderEngine()->setIncrementalRenderEnabled(w.work.incremental);
+        w.work.treeRoot->getRenderEngine()->setResumeEnabled(w.work.resume);
         w.work.treeRoot->getRenderEngine()->renderFrameRange(false /*blocking*/, w.work.useRenderStats, w.work.firstFrame, w.work.lastFrame, w.work.frameStep, std::vector<ViewIdx>() /*views*/, eRenderDirectionForward);
     }
 }
@@ -520,6 +569,22 @@ RenderQueue::removeRenderFromQueue(const NodePtr& writer)
     }
 }
 
+int
+RenderQueue::getNumQueuedRenders() const
+{
+    QMutexLocker k(&_imp->renderQueueMutex);
+
+    return (int)_imp->renderQueue.size();
+}
+
+int
+RenderQueue::getNumActiveRenders() const
+{
+    QMutexLocker k(&_imp->renderQueueMutex);
+
+    return (int)_imp->activeRenders.size();
+}
+
 void
 RenderQueuePrivate::startNextQueuedRender(const NodePtr& finishedWriter)
 {
@@ -27,6 +27,7 @@
 
 #include "Global/Macros.h"
 
+#include <list>
 #include <cmath>
 #include <climits>
 #include <QObject>
@@ -79,6 +80,21 @@ public:
         // True if this request is a restart of a previous request
         bool isRestart;
 
+        // Other writers rendered in the same pass as the tree root, over the frame range of the tree root.
+        // The images upstream that they have in common with the tree root are rendered once per frame.
+        std::list<NodePtr> extraTreeRoots;
+
+        // If set, the frames in input of the tree root are streamed in order instead of being written by it
+        FrameStreamWriterPtr frameStream;
+
+        // True if the frames whose hash did not change since the previous render are skipped,
+        // see RenderEngine::setIncrementalRenderEnabled()
+        bool incremental;
+
+        // True if the frames completed by the interrupted render of a previous process are skipped,
+        // see RenderEngine::setResumeEnabled()
+        bool resume;
+
         RenderWork()
         : treeRoot()
         , renderLabel()
@@ -87,6 +103,10 @@ public:
         , frameStep(INT_MIN)
         , useRenderStats(false)
         , isRestart(false)
+        , extraTreeRoots()
+        , frameStream()
+        , incremental(false)
+        , resume(false)
         {
         }
 
@@ -103,6 +123,10 @@ public:
         , frameStep(frameStep)
         , useRenderStats(useRenderStats)
         , isRestart(false)
+        , extraTreeRoots()
+        , frameStream()
+        , incremental(false)
+        , resume(false)
         {
         }
     };
@@ -132,6 +156,12 @@ public:
      **/
     void createRenderRequestsFromCommandLineArgs(const CLArgs& cl, std::list<RenderWork>& requests);
 
+    /**
+     * @brief Resolves the frame range and frame step of the given work from the knobs of its tree root
+     * if they were not set, as done before rendering it. Returns false if they are invalid.
+     **/
+    bool validateRenderOptions(RenderWork* work);
+
     /**
      * @brief Queues the given write nodes to render. This function will block until all renders are finished.
      **/
@@ -148,6 +178,12 @@ public:
      **/
     void removeRenderFromQueue(const NodePtr& writer);
 
+    /**
+     * @brief Returns the number of renders waiting in the queue and the number of renders in progress
+     **/
+    int getNumQueuedRenders() const;
+    int getNumActiveRenders() const;
+
 public Q_SLOTS:
 
 
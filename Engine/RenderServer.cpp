@@ -0,0 +1,223 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderServer.h"
+
+#include <iostream>
+#include <list>
+#include <stdexcept>
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#include "Engine/AppInstance.h"
+#include "Engine/RenderQueue.h"
+
+NATRON_NAMESPACE_ENTER;
+
+RenderServer::RenderServer(const AppInstancePtr& app)
+    : _app(app)
+    , _server()
+    , _clientMutex()
+    , _client(0)
+    , _projectFilePath()
+    , _projectLastModified()
+{
+}
+
+RenderServer::~RenderServer()
+{
+    if (_server) {
+        _server->close();
+    }
+}
+
+bool
+RenderServer::exec(const QString& serverName)
+{
+    // A previous server that crashed may have left its socket file behind
+    QLocalServer::removeServer(serverName);
+
+    _server.reset( new QLocalServer() );
+    if ( !_server->listen(serverName) ) {
+        std::cerr << tr("Failed to create the render server %1: %2").arg(serverName).arg( _server->errorString() ).toStdString() << std::endl;
+
+        return false;
+    }
+    std::cout << tr("Render server listening on %1").arg( _server->fullServerName() ).toStdString() << std::endl;
+
+    for (;;) {
+        if ( !_server->waitForNewConnection(-1) ) {
+            std::cerr << tr("The render server stopped: %1").arg( _server->errorString() ).toStdString() << std::endl;
+            break;
+        }
+        QLocalSocket* client = _server->nextPendingConnection();
+        if (!client) {
+            continue;
+        }
+        bool mustQuit = serveClient(client);
+        client->close();
+        delete client;
+        if (mustQuit) {
+            break;
+        }
+    }
+    _server->close();
+
+    return true;
+} // exec
+
+bool
+RenderServer::serveClient(QLocalSocket* client)
+{
+    {
+        QMutexLocker k(&_clientMutex);
+        _client = client;
+    }
+    bool mustQuit = false;
+    while (!mustQuit) {
+        // waitForReadyRead() returns false when the client disconnects
+        if ( !client->canReadLine() && !client->waitForReadyRead(-1) ) {
+            break;
+        }
+        while ( client->canReadLine() ) {
+            QString str = QString::fromUtf8( client->readLine() );
+            while ( str.endsWith( QLatin1Char('\n') ) || str.endsWith( QLatin1Char('\r') ) ) {
+                str.chop(1);
+            }
+            if ( str.startsWith( QString::fromUtf8(kRenderServerQuitShort) ) ) {
+                mustQuit = true;
+                break;
+            } else if ( str.startsWith( QString::fromUtf8(kRenderServerRenderJobShort) ) ) {
+                QString job = str.mid( QString::fromUtf8(kRenderServerRenderJobShort).size() ).trimmed();
+                QString error;
+                if ( renderJob(job, &error) ) {
+                    writeToClient( QString::fromUtf8(kRenderServerJobFinishedShort " 0") );
+                } else {
+                    std::cerr << error.toStdString() << std::endl;
+                    writeToClient( QString::fromUtf8(kRenderServerJobFinishedShort " 1 ") + error );
+                }
+            } else {
+                writeToClient( QString::fromUtf8(kRenderServerJobFinishedShort " 1 ") + tr("Unable to interpret message: %1").arg(str) );
+            }
+        }
+    }
+    client->waitForBytesWritten(5000);
+    {
+        QMutexLocker k(&_clientMutex);
+        _client = 0;
+    }
+
+    return mustQuit;
+} // serveClient
+
+bool
+RenderServer::renderJob(const QString& job,
+                        QString* error)
+{
+    AppInstancePtr app = _app.lock();
+    if (!app) {
+        *error = tr("The application was closed.");
+
+        return false;
+    }
+
+    QStringList fields = job.split( QLatin1Char('\t') );
+    QFileInfo info( fields.front() );
+    if ( fields.front().isEmpty() || !info.exists() ) {
+        *error = tr("%1: No such file.").arg( fields.front() );
+
+        return false;
+    }
+
+    // Plug-ins stay loaded between jobs: only load the project again if it changed
+    QString projectFilePath = info.canonicalFilePath();
+    QDateTime lastModified = info.lastModified();
+    if ( (projectFilePath != _projectFilePath) || (lastModified != _projectLastModified) ) {
+        _projectFilePath.clear();
+        std::cout << tr("Loading project %1").arg(projectFilePath).toStdString() << std::endl;
+        if ( !app->loadProject( projectFilePath.toStdString() ) ) {
+            *error = tr("Project file loading failed.");
+
+            return false;
+        }
+        _projectFilePath = projectFilePath;
+        _projectLastModified = lastModified;
+    }
+
+    std::list<std::string> writers;
+    if ( (fields.size() > 1) && !fields[1].isEmpty() ) {
+        writers.push_back( fields[1].toStdString() );
+    }
+
+    std::list<std::pair<int, std::pair<int, int> > > frameRanges;
+    if (fields.size() > 3) {
+        bool firstOk, lastOk;
+        int firstFrame = fields[2].toInt(&firstOk);
+        int lastFrame = fields[3].toInt(&lastOk);
+        int frameStep = (fields.size() > 4) ? fields[4].toInt() : 1;
+        if (!firstOk || !lastOk) {
+            *error = tr("Invalid frame range: %1-%2").arg(fields[2]).arg(fields[3]);
+
+            return false;
+        }
+        if (frameStep == 0) {
+            frameStep = 1;
+        }
+        frameRanges.push_back( std::make_pair( frameStep, std::make_pair(firstFrame, lastFrame) ) );
+    }
+
+    RenderQueuePtr queue = app->getRenderQueue();
+    std::list<RenderQueue::RenderWork> works;
+    try {
+        queue->createRenderRequestsFromCommandLineArgs(false /*enableRenderStats*/, writers, frameRanges, works);
+    } catch (const std::exception& e) {
+        *error = QString::fromUtf8( e.what() );
+
+        return false;
+    }
+    if ( works.empty() ) {
+        *error = tr("No active Write node to render.");
+
+        return false;
+    }
+    queue->renderBlocking(works);
+
+    return true;
+} // renderJob
+
+void
+RenderServer::writeToClient(const QString& message)
+{
+    QMutexLocker k(&_clientMutex);
+    if (!_client) {
+        return;
+    }
+    _client->write( ( message + QLatin1Char('\n') ).toUtf8() );
+    _client->flush();
+}
+
+NATRON_NAMESPACE_EXIT;
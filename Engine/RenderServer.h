@@ -0,0 +1,115 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_RENDERSERVER_H
+#define NATRON_ENGINE_RENDERSERVER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#endif
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+CLANG_DIAG_ON(deprecated)
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief A render server keeps a background process resident so that render farm tasks do not pay for
+ * the Python initialization, the plug-ins loading and the project loading every time.
+ * It is started with the --render-server <server name> command-line option and listens to a local socket
+ * (a named pipe on Windows) with that name. Clients are served one at a time.
+ *
+ * As with ProcessHandler, each message consists of exactly 1 line, i.e a string terminated with the \n character.
+ * The client sends:
+ * - kRenderServerRenderJobShort followed by the tab-separated project file path, Write node script name,
+ * first frame, last frame and frame step. All fields but the project file path are optional: if the Write node
+ * is empty, all Write nodes of the project are rendered, and if the frame range is not given, it is read from the Write node.
+ * - kRenderServerQuitShort to stop the server.
+ * The server replies with the messages of a background render launched from the GUI (kRenderingStartedShort,
+ * kFrameRenderedStringShort, kRenderingFinishedStringShort...) and finishes each job with kRenderServerJobFinishedShort
+ * followed by 0 if the render was launched, or by 1 and an error message otherwise.
+ *
+ * The project is only loaded again when a job refers to another project file or when the file was modified on disk.
+ **/
+class RenderServer
+{
+    Q_DECLARE_TR_FUNCTIONS(RenderServer)
+
+public:
+
+    RenderServer(const AppInstancePtr& app);
+
+    ~RenderServer();
+
+    /**
+     * @brief Listens to the given server name and serves the clients until one of them sends kRenderServerQuitShort.
+     * This function blocks. Returns false if the server could not be created.
+     **/
+    bool exec(const QString& serverName);
+
+    /**
+     * @brief Writes the given message to the client of the job being rendered, if any.
+     * This may be called from any thread.
+     **/
+    void writeToClient(const QString& message);
+
+private:
+
+    /**
+     * @brief Reads the messages of the client until it disconnects. Returns true if the server must quit.
+     **/
+    bool serveClient(QLocalSocket* client);
+
+    /**
+     * @brief Loads the project of the job if needed and renders it. Returns false and sets the error
+     * if the render could not be launched.
+     **/
+    bool renderJob(const QString& job, QString* error);
+
+    boost::weak_ptr<AppInstance> _app;
+    boost::scoped_ptr<QLocalServer> _server;
+
+    // Protects _client which may be written to by the render threads
+    QMutex _clientMutex;
+    QLocalSocket* _client;
+
+    // The project currently loaded and its modification date when it was loaded
+    QString _projectFilePath;
+    QDateTime _projectLastModified;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_RENDERSERVER_H
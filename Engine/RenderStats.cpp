@@ -29,11 +29,14 @@
 #include <stdexcept>
 
 #include <QtCore/QMutex>
+#include <QtCore/QThread>
 
+#include "Engine/EffectInstance.h"
 #include "Engine/Node.h"
 #include "Engine/Timer.h"
 #include "Engine/RectI.h"
 #include "Engine/RectD.h"
+#include "Engine/TreeRender.h"
 
 NATRON_NAMESPACE_ENTER;
 
@@ -42,11 +45,39 @@ struct NodeRenderStatsPrivate
     //The accumulated time spent in the EffectInstance::renderHandler function
     double totalTimeSpentRendering;
 
+    // Render clones allocated and re-used from previous renders
+    int nRenderClonesCreated, nRenderClonesReused;
+
+    // NaN values replaced in the rendered images
+    std::size_t nNaNsReplaced;
+
+    // Time spent and number of calls for each RenderStatsActionEnum
+    double actionTimes[eRenderStatsActionCount];
+    int actionCalls[eRenderStatsActionCount];
+
+    // Cache lookups of the node images
+    int nCacheHits, nCacheMisses;
+
+    // Memory allocated for the image buffers
+    std::size_t bytesAllocated;
+
+    // The threads which rendered the node
+    std::set<const void*> renderThreads;
 
     NodeRenderStatsPrivate()
     : totalTimeSpentRendering(0)
+    , nRenderClonesCreated(0)
+    , nRenderClonesReused(0)
+    , nNaNsReplaced(0)
+    , nCacheHits(0)
+    , nCacheMisses(0)
+    , bytesAllocated(0)
+    , renderThreads()
     {
-
+        for (int i = 0; i < eRenderStatsActionCount; ++i) {
+            actionTimes[i] = 0;
+            actionCalls[i] = 0;
+        }
     }
 };
 
@@ -69,6 +100,17 @@ void
 NodeRenderStats::operator=(const NodeRenderStats& other)
 {
     _imp->totalTimeSpentRendering = other._imp->totalTimeSpentRendering;
+    _imp->nRenderClonesCreated = other._imp->nRenderClonesCreated;
+    _imp->nRenderClonesReused = other._imp->nRenderClonesReused;
+    _imp->nNaNsReplaced = other._imp->nNaNsReplaced;
+    for (int i = 0; i < eRenderStatsActionCount; ++i) {
+        _imp->actionTimes[i] = other._imp->actionTimes[i];
+        _imp->actionCalls[i] = other._imp->actionCalls[i];
+    }
+    _imp->nCacheHits = other._imp->nCacheHits;
+    _imp->nCacheMisses = other._imp->nCacheMisses;
+    _imp->bytesAllocated = other._imp->bytesAllocated;
+    _imp->renderThreads = other._imp->renderThreads;
 }
 
 void
@@ -83,6 +125,108 @@ NodeRenderStats::getTotalTimeSpentRendering() const
     return _imp->totalTimeSpentRendering;
 }
 
+void
+NodeRenderStats::addRenderClone(bool reused)
+{
+    if (reused) {
+        ++_imp->nRenderClonesReused;
+    } else {
+        ++_imp->nRenderClonesCreated;
+    }
+}
+
+int
+NodeRenderStats::getNumRenderClonesCreated() const
+{
+    return _imp->nRenderClonesCreated;
+}
+
+int
+NodeRenderStats::getNumRenderClonesReused() const
+{
+    return _imp->nRenderClonesReused;
+}
+
+void
+NodeRenderStats::addNaNsReplaced(std::size_t count)
+{
+    _imp->nNaNsReplaced += count;
+}
+
+std::size_t
+NodeRenderStats::getNumNaNsReplaced() const
+{
+    return _imp->nNaNsReplaced;
+}
+
+void
+NodeRenderStats::addActionTime(RenderStatsActionEnum action, double time)
+{
+    assert(action >= 0 && action < eRenderStatsActionCount);
+    _imp->actionTimes[action] += time;
+    ++_imp->actionCalls[action];
+}
+
+double
+NodeRenderStats::getActionTime(RenderStatsActionEnum action) const
+{
+    assert(action >= 0 && action < eRenderStatsActionCount);
+    return _imp->actionTimes[action];
+}
+
+int
+NodeRenderStats::getActionCallsCount(RenderStatsActionEnum action) const
+{
+    assert(action >= 0 && action < eRenderStatsActionCount);
+    return _imp->actionCalls[action];
+}
+
+void
+NodeRenderStats::addCacheLookup(bool hit)
+{
+    if (hit) {
+        ++_imp->nCacheHits;
+    } else {
+        ++_imp->nCacheMisses;
+    }
+}
+
+int
+NodeRenderStats::getNumCacheHits() const
+{
+    return _imp->nCacheHits;
+}
+
+int
+NodeRenderStats::getNumCacheMisses() const
+{
+    return _imp->nCacheMisses;
+}
+
+void
+NodeRenderStats::addBytesAllocated(std::size_t bytes)
+{
+    _imp->bytesAllocated += bytes;
+}
+
+std::size_t
+NodeRenderStats::getBytesAllocated() const
+{
+    return _imp->bytesAllocated;
+}
+
+void
+NodeRenderStats::addRenderThread(const void* thread)
+{
+    _imp->renderThreads.insert(thread);
+}
+
+int
+NodeRenderStats::getNumRenderThreads() const
+{
+    return (int)_imp->renderThreads.size();
+}
+
 
 struct RenderStatsPrivate
 {
@@ -161,6 +305,96 @@ RenderStats::addRenderInfosForNode(const NodePtr& node, double timeSpent)
 
     NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
     stats.addTimeSpentRendering(timeSpent);
+    stats.addRenderThread( QThread::currentThread() );
+}
+
+void
+RenderStats::addRenderCloneForNode(const NodePtr& node, bool reused)
+{
+    QMutexLocker k(&_imp->lock);
+
+    NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.addRenderClone(reused);
+}
+
+void
+RenderStats::addNaNsReplacedForNode(const NodePtr& node, std::size_t count)
+{
+    QMutexLocker k(&_imp->lock);
+
+    NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.addNaNsReplaced(count);
+}
+
+void
+RenderStats::addActionTimeForNode(const NodePtr& node, RenderStatsActionEnum action, double timeSpent)
+{
+    QMutexLocker k(&_imp->lock);
+
+    assert(_imp->doNodesProfiling);
+
+    NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.addActionTime(action, timeSpent);
+}
+
+void
+RenderStats::addCacheLookupForNode(const NodePtr& node, bool hit)
+{
+    QMutexLocker k(&_imp->lock);
+
+    NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.addCacheLookup(hit);
+}
+
+void
+RenderStats::addBytesAllocatedForNode(const NodePtr& node, std::size_t bytes)
+{
+    QMutexLocker k(&_imp->lock);
+
+    NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.addBytesAllocated(bytes);
+}
+
+const char*
+RenderStats::getActionLabel(RenderStatsActionEnum action)
+{
+    switch (action) {
+    case eRenderStatsActionGetRegionOfDefinition:
+        return "getRegionOfDefinition";
+    case eRenderStatsActionGetRegionsOfInterest:
+        return "getRegionsOfInterest";
+    case eRenderStatsActionIsIdentity:
+        return "isIdentity";
+    case eRenderStatsActionRender:
+        return "render";
+    case eRenderStatsActionCacheLookup:
+        return "cacheLookup";
+    case eRenderStatsActionTileWait:
+        return "tileWait";
+    case eRenderStatsActionConversion:
+        return "conversion";
+    case eRenderStatsActionPostProcess:
+        return "maskMix";
+    case eRenderStatsActionCount:
+        break;
+    }
+
+    return "";
+} // getActionLabel
+
+static const char*
+getActionTraceCategory(RenderStatsActionEnum action)
+{
+    switch (action) {
+    case eRenderStatsActionCacheLookup:
+    case eRenderStatsActionTileWait:
+        return kRenderTraceCategoryCache;
+    case eRenderStatsActionConversion:
+    case eRenderStatsActionPostProcess:
+        return kRenderTraceCategoryRender;
+    default:
+        return kRenderTraceCategoryAction;
+    }
 }
 
 std::map<NodePtr, NodeRenderStats >
@@ -181,4 +415,31 @@ RenderStats::getStats(double *totalTimeSpent) const
     return ret;
 }
 
+RenderStatsActionTimer_RAII::RenderStatsActionTimer_RAII(const EffectInstance* effect, RenderStatsActionEnum action)
+    : _trace( RenderStats::getActionLabel(action), getActionTraceCategory(action), effect )
+    , _stats()
+    , _node()
+    , _action(action)
+    , _timer()
+{
+    TreeRenderPtr render = effect->getCurrentRender();
+    if (!render) {
+        return;
+    }
+    RenderStatsPtr stats = render->getStatsObject();
+    if ( !stats || !stats->isInDepthProfilingEnabled() ) {
+        return;
+    }
+    _stats = stats;
+    _node = effect->getNode();
+    _timer.reset(new TimeLapse);
+}
+
+RenderStatsActionTimer_RAII::~RenderStatsActionTimer_RAII()
+{
+    if (_timer) {
+        _stats->addActionTimeForNode( _node, _action, _timer->getTimeSinceCreation() );
+    }
+}
+
 NATRON_NAMESPACE_EXIT;
@@ -32,6 +32,7 @@
 #include <set>
 #include <string>
 #include <bitset>
+#include <cstddef>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
@@ -43,12 +44,29 @@
 
 #include "Engine/RectI.h"
 #include "Engine/RectD.h"
+#include "Engine/RenderTrace.h"
 #include "Engine/TimeValue.h"
 
 #include "Engine/EngineFwd.h"
 
 NATRON_NAMESPACE_ENTER;
 
+/**
+ * @brief The steps of the render of a node which are timed separately when in-depth profiling is enabled
+ **/
+enum RenderStatsActionEnum
+{
+    eRenderStatsActionGetRegionOfDefinition = 0,
+    eRenderStatsActionGetRegionsOfInterest,
+    eRenderStatsActionIsIdentity,
+    eRenderStatsActionRender,
+    eRenderStatsActionCacheLookup,
+    eRenderStatsActionTileWait,
+    eRenderStatsActionConversion,
+    eRenderStatsActionPostProcess,
+    eRenderStatsActionCount
+};
+
 /**
  * @brief Holds render infos for one frame for one node. Not MT-safe: MT-safety is handled by RenderStats.
  **/
@@ -68,6 +86,33 @@ public:
     void addTimeSpentRendering(double time);
     double getTotalTimeSpentRendering() const;
 
+    void addRenderClone(bool reused);
+
+    // The number of render clones allocated for the node and the number of clones re-used from previous renders
+    int getNumRenderClonesCreated() const;
+    int getNumRenderClonesReused() const;
+
+    // The number of NaN values replaced in the images rendered by the node
+    void addNaNsReplaced(std::size_t count);
+    std::size_t getNumNaNsReplaced() const;
+
+    // The accumulated time spent in the given action and the number of times it was called
+    void addActionTime(RenderStatsActionEnum action, double time);
+    double getActionTime(RenderStatsActionEnum action) const;
+    int getActionCallsCount(RenderStatsActionEnum action) const;
+
+    // The number of images of the node found entirely rendered in the cache and the number of images which had to be rendered
+    void addCacheLookup(bool hit);
+    int getNumCacheHits() const;
+    int getNumCacheMisses() const;
+
+    // The memory allocated for the image buffers of the node, in bytes
+    void addBytesAllocated(std::size_t bytes);
+    std::size_t getBytesAllocated() const;
+
+    // The number of distinct threads which rendered tiles of the node
+    void addRenderThread(const void* thread);
+    int getNumRenderThreads() const;
 
 private:
 
@@ -94,6 +139,38 @@ public:
 
     void addRenderInfosForNode(const NodePtr& node, double timeSpent);
 
+    /**
+     * @brief Called when a render clone of the node is needed by the render.
+     * @param reused True if the clone was re-used from a previous render instead of being allocated
+     **/
+    void addRenderCloneForNode(const NodePtr& node, bool reused);
+
+    /**
+     * @brief Called when NaN values were found and replaced in an image rendered by the node.
+     **/
+    void addNaNsReplacedForNode(const NodePtr& node, std::size_t count);
+
+    /**
+     * @brief Called when the node spent the given time in the given action. Only called when in-depth profiling is enabled.
+     **/
+    void addActionTimeForNode(const NodePtr& node, RenderStatsActionEnum action, double timeSpent);
+
+    /**
+     * @brief Called when the node looked up its image in the cache.
+     * @param hit True if the image was entirely rendered in the cache
+     **/
+    void addCacheLookupForNode(const NodePtr& node, bool hit);
+
+    /**
+     * @brief Called when image buffers of the given size were allocated for the node.
+     **/
+    void addBytesAllocatedForNode(const NodePtr& node, std::size_t bytes);
+
+    /**
+     * @brief Returns a label for the given action, used in the stats reports.
+     **/
+    static const char* getActionLabel(RenderStatsActionEnum action);
+
     std::map<NodePtr, NodeRenderStats > getStats(double *totalTimeSpent) const;
 
 private:
@@ -101,6 +178,26 @@ private:
     boost::scoped_ptr<RenderStatsPrivate> _imp;
 };
 
+/**
+ * @brief Times the scope it is declared in and adds it to the given action of the node when the current
+ * render of the effect has in-depth profiling enabled. The scope is also recorded in the render trace
+ * when it is recording (see RenderTrace).
+ **/
+class RenderStatsActionTimer_RAII
+{
+    RenderTrace::Scope_RAII _trace;
+    RenderStatsPtr _stats;
+    NodePtr _node;
+    RenderStatsActionEnum _action;
+    boost::scoped_ptr<TimeLapse> _timer;
+
+public:
+
+    RenderStatsActionTimer_RAII(const EffectInstance* effect, RenderStatsActionEnum action);
+
+    ~RenderStatsActionTimer_RAII();
+};
+
 NATRON_NAMESPACE_EXIT;
 
 
@@ -0,0 +1,290 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderTrace.h"
+
+#include <vector>
+#include <map>
+#include <iostream>
+#include <sstream>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+
+#include "Global/FStreamsSupport.h"
+
+#include "Engine/EffectInstance.h"
+#include "Engine/Timer.h"
+
+// Maximum number of events recorded, so that a recording left running does not fill the memory
+#define NATRON_RENDER_TRACE_MAX_EVENTS 4000000
+
+NATRON_NAMESPACE_ENTER;
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+struct RenderTraceEvent
+{
+    const char* name;
+    const char* category;
+    std::string nodeName;
+    double startTime; // seconds since the recording started
+    double duration; // seconds
+    int threadIndex;
+};
+
+struct RenderTraceThread
+{
+    int index;
+    std::string name;
+};
+
+struct RenderTraceData
+{
+    QMutex lock;
+
+    // Read without taking the lock by the events: 1 while recording
+    QAtomicInt recording;
+
+    // Incremented by each call to start(), so that events started during a previous recording are not recorded
+    U64 generation;
+
+    boost::scoped_ptr<TimeLapse> timer;
+    std::vector<RenderTraceEvent> events;
+
+    // Number of events not recorded because NATRON_RENDER_TRACE_MAX_EVENTS was reached
+    std::size_t nDroppedEvents;
+
+    // Maps each thread that recorded an event to a small index
+    std::map<QThread*, RenderTraceThread> threads;
+
+    RenderTraceData()
+    : lock()
+    , recording()
+    , generation(0)
+    , timer()
+    , events()
+    , nDroppedEvents(0)
+    , threads()
+    {
+    }
+
+    int getThreadIndex(QThread* thread)
+    {
+        std::map<QThread*, RenderTraceThread>::iterator found = threads.find(thread);
+        if ( found != threads.end() ) {
+            return found->second.index;
+        }
+        RenderTraceThread t;
+        t.index = (int)threads.size();
+        // The thread may be destroyed before the trace is written: copy its name now
+        t.name = thread ? thread->objectName().toStdString() : std::string();
+        threads.insert( std::make_pair(thread, t) );
+        return t.index;
+    }
+};
+
+RenderTraceData&
+getTraceData()
+{
+    static RenderTraceData data;
+    return data;
+}
+
+std::string
+escapeJSONString(const std::string& str)
+{
+    std::string ret;
+    ret.reserve( str.size() );
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        unsigned char c = (unsigned char)str[i];
+        if ( (c == '"') || (c == '\\') ) {
+            ret.push_back('\\');
+            ret.push_back(str[i]);
+        } else if (c < 0x20) {
+            const char* hexDigits = "0123456789abcdef";
+            ret.append("\\u00");
+            ret.push_back(hexDigits[c >> 4]);
+            ret.push_back(hexDigits[c & 0xf]);
+        } else {
+            ret.push_back(str[i]);
+        }
+    }
+    return ret;
+}
+
+bool
+writeChromeTrace(const std::vector<RenderTraceEvent>& events,
+                 const std::map<QThread*, RenderTraceThread>& threads,
+                 std::size_t nDroppedEvents,
+                 const std::string& filePath)
+{
+    FStreamsSupport::ofstream ofile;
+    FStreamsSupport::open(&ofile, filePath);
+    if (!ofile) {
+        return false;
+    }
+
+    // Durations are expressed in microseconds. See the "Trace Event Format" specification.
+    ofile << "{\"traceEvents\":[\n";
+
+    // Name the threads so that the timeline shows one track per thread
+    for (std::map<QThread*, RenderTraceThread>::const_iterator it = threads.begin(); it != threads.end(); ++it) {
+        std::string name = it->second.name;
+        if ( name.empty() ) {
+            std::stringstream ss;
+            ss << "Thread " << it->second.index;
+            name = ss.str();
+        }
+        ofile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << it->second.index
+              << ",\"args\":{\"name\":\"" << escapeJSONString(name) << "\"}},\n";
+    }
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const RenderTraceEvent& e = events[i];
+        ofile << "{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category << "\",\"ph\":\"X\""
+              << ",\"ts\":" << (long long)(e.startTime * 1e6) << ",\"dur\":" << (long long)(e.duration * 1e6)
+              << ",\"pid\":1,\"tid\":" << e.threadIndex;
+        if ( !e.nodeName.empty() ) {
+            ofile << ",\"args\":{\"node\":\"" << escapeJSONString(e.nodeName) << "\"}";
+        }
+        ofile << "},\n";
+    }
+    ofile << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"" NATRON_APPLICATION_NAME "\"}}\n";
+    ofile << "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << (unsigned long long)nDroppedEvents << "}}\n";
+
+    return (bool)ofile;
+} // writeChromeTrace
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+void
+RenderTrace::start()
+{
+    RenderTraceData& data = getTraceData();
+    QMutexLocker k(&data.lock);
+    data.events.clear();
+    data.threads.clear();
+    data.nDroppedEvents = 0;
+    ++data.generation;
+    data.timer.reset( new TimeLapse );
+    data.recording.fetchAndStoreOrdered(1);
+}
+
+bool
+RenderTrace::isRecording()
+{
+    return getTraceData().recording.fetchAndAddRelaxed(0) != 0;
+}
+
+bool
+RenderTrace::stop(const std::string& chromeTraceFilePath)
+{
+    RenderTraceData& data = getTraceData();
+    std::vector<RenderTraceEvent> events;
+    std::map<QThread*, RenderTraceThread> threads;
+    std::size_t nDroppedEvents;
+    {
+        QMutexLocker k(&data.lock);
+        if ( !data.recording.fetchAndStoreOrdered(0) ) {
+            return true;
+        }
+        events.swap(data.events);
+        threads.swap(data.threads);
+        nDroppedEvents = data.nDroppedEvents;
+    }
+
+    if ( chromeTraceFilePath.empty() ) {
+        return true;
+    }
+    if ( !writeChromeTrace(events, threads, nDroppedEvents, chromeTraceFilePath) ) {
+        std::cerr << "Failed to write the render trace to " << chromeTraceFilePath << std::endl;
+        return false;
+    }
+    std::cout << "Render trace written to " << chromeTraceFilePath << std::endl;
+    return true;
+} // stop
+
+RenderTrace::Scope_RAII::Scope_RAII(const char* name,
+                                    const char* category,
+                                    const EffectInstance* effect)
+: _name(name)
+, _category(category)
+, _nodeName()
+, _enabled( RenderTrace::isRecording() )
+, _generation(0)
+, _startTime(0)
+{
+    if (!_enabled) {
+        return;
+    }
+    if (effect) {
+        _nodeName = effect->getScriptName_mt_safe();
+    }
+    RenderTraceData& data = getTraceData();
+    QMutexLocker k(&data.lock);
+    if (!data.timer) {
+        _enabled = false;
+        return;
+    }
+    _generation = data.generation;
+    _startTime = data.timer->getTimeSinceCreation();
+}
+
+RenderTrace::Scope_RAII::~Scope_RAII()
+{
+    finish();
+}
+
+void
+RenderTrace::Scope_RAII::finish()
+{
+    if (!_enabled) {
+        return;
+    }
+    _enabled = false;
+
+    RenderTraceData& data = getTraceData();
+    QMutexLocker k(&data.lock);
+    // The recording may have been stopped or restarted since the event started
+    if ( !data.recording.fetchAndAddRelaxed(0) || (data.generation != _generation) ) {
+        return;
+    }
+    if (data.events.size() >= NATRON_RENDER_TRACE_MAX_EVENTS) {
+        ++data.nDroppedEvents;
+        return;
+    }
+    RenderTraceEvent e;
+    e.name = _name;
+    e.category = _category;
+    e.nodeName = _nodeName;
+    e.startTime = _startTime;
+    e.duration = data.timer->getTimeSinceCreation() - _startTime;
+    e.threadIndex = data.getThreadIndex( QThread::currentThread() );
+    data.events.push_back(e);
+} // finish
+
+NATRON_NAMESPACE_EXIT;
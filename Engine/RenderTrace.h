@@ -0,0 +1,103 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_RENDERTRACE_H
+#define NATRON_ENGINE_RENDERTRACE_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <string>
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+// Categories of the render trace events
+#define kRenderTraceCategoryRender "render"
+#define kRenderTraceCategoryAction "action"
+#define kRenderTraceCategoryCache "cache"
+#define kRenderTraceCategoryGL "gl"
+#define kRenderTraceCategoryPython "python"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Records a timeline of the renders: the request passes and render tasks of the TreeRender, the plug-in actions,
+ * the cache lookups and waits, the viewer texture uploads and the Python expressions, with the thread that ran them.
+ * Nothing is recorded unless the recording was started, either from the Render menu of the GUI or with the
+ * --render-trace command-line option of NatronRenderer. When stopped, the events are written in the
+ * Chrome trace event format (to be opened with chrome://tracing or https://ui.perfetto.dev).
+ * All functions are MT-safe.
+ **/
+class RenderTrace
+{
+public:
+
+    /**
+     * @brief Starts recording. The events recorded by a previous recording are discarded.
+     **/
+    static void start();
+
+    static bool isRecording();
+
+    /**
+     * @brief Stops recording and writes the events to the given file. If the file path is empty, the events are discarded.
+     * Returns false if the file could not be written.
+     **/
+    static bool stop(const std::string& chromeTraceFilePath);
+
+    /**
+     * @brief Records an event for the lifetime of this object, or until finish() is called.
+     * name and category must be string literals: nothing is copied when not recording.
+     * If effect is set, the script name of its node is recorded with the event.
+     **/
+    class Scope_RAII
+    {
+    public:
+
+        Scope_RAII(const char* name,
+                   const char* category,
+                   const EffectInstance* effect = 0);
+
+        ~Scope_RAII();
+
+        /**
+         * @brief Ends the event before the end of the scope.
+         **/
+        void finish();
+
+    private:
+
+        const char* _name;
+        const char* _category;
+        std::string _nodeName;
+        bool _enabled;
+        U64 _generation;
+        double _startTime;
+    };
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_RENDERTRACE_H
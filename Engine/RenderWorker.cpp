@@ -0,0 +1,249 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderWorker.h"
+
+#include <cmath> // floor
+#include <iostream>
+#include <list>
+#include <stdexcept>
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
+#include <QtNetwork/QHostInfo>
+#include <QtNetwork/QTcpSocket>
+
+#include "Engine/AppInstance.h"
+#include "Engine/Cache.h"
+#include "Engine/RenderQueue.h"
+
+// Number of attempts to connect to the coordinator, which may not be started yet when the worker starts
+#define NATRON_RENDER_WORKER_CONNECT_ATTEMPTS 30
+
+// Time between 2 connection attempts
+#define NATRON_RENDER_WORKER_CONNECT_INTERVAL_MS 1000
+
+NATRON_NAMESPACE_ENTER;
+
+RenderWorker::RenderWorker(const AppInstancePtr& app)
+    : _app(app)
+    , _socket()
+    , _projectFilePath()
+    , _projectLastModified()
+    , _jobError()
+    , _renderedFramesMutex()
+    , _renderedFrames()
+{
+}
+
+RenderWorker::~RenderWorker()
+{
+    if (_socket) {
+        _socket->close();
+    }
+}
+
+bool
+RenderWorker::exec(const QString& coordinatorAddress)
+{
+    int separator = coordinatorAddress.lastIndexOf( QLatin1Char(':') );
+    QString host = coordinatorAddress.left(separator);
+    bool portOk;
+    int port = coordinatorAddress.mid(separator + 1).toInt(&portOk);
+    if ( host.isEmpty() || !portOk || (port <= 0) || (port > 65535) ) {
+        std::cerr << tr("Invalid render coordinator address: %1").arg(coordinatorAddress).toStdString() << std::endl;
+
+        return false;
+    }
+
+    _socket.reset( new QTcpSocket() );
+    for (int i = 0; i < NATRON_RENDER_WORKER_CONNECT_ATTEMPTS; ++i) {
+        _socket->connectToHost(host, (quint16)port);
+        if ( _socket->waitForConnected(NATRON_RENDER_WORKER_CONNECT_INTERVAL_MS) ) {
+            break;
+        }
+        _socket->abort();
+        CacheEntryLockerBase::sleep_milliseconds(NATRON_RENDER_WORKER_CONNECT_INTERVAL_MS);
+    }
+    if ( _socket->state() != QAbstractSocket::ConnectedState ) {
+        std::cerr << tr("Failed to connect to the render coordinator %1: %2").arg(coordinatorAddress).arg( _socket->errorString() ).toStdString() << std::endl;
+
+        return false;
+    }
+    std::cout << tr("Connected to the render coordinator %1").arg(coordinatorAddress).toStdString() << std::endl;
+
+    bool mustQuit = false;
+    while (!mustQuit) {
+        // waitForReadyRead() returns false when the coordinator disconnects
+        if ( !_socket->canReadLine() && !_socket->waitForReadyRead(-1) ) {
+            break;
+        }
+        while ( _socket->canReadLine() ) {
+            QString str = QString::fromUtf8( _socket->readLine() );
+            while ( str.endsWith( QLatin1Char('\n') ) || str.endsWith( QLatin1Char('\r') ) ) {
+                str.chop(1);
+            }
+            if ( str.startsWith( QString::fromUtf8(kRenderServerQuitShort) ) ) {
+                mustQuit = true;
+                break;
+            } else if ( str.startsWith( QString::fromUtf8(kRenderFarmJobShort) ) ) {
+                QString projectFilePath = str.mid( QString::fromUtf8(kRenderFarmJobShort).size() ).trimmed();
+                _jobError.clear();
+                if ( !loadProject(projectFilePath, &_jobError) ) {
+                    // Report the error for each frame so that the coordinator gives them to other workers
+                    std::cerr << _jobError.toStdString() << std::endl;
+                }
+                writeToCoordinator( QString::fromUtf8(kRenderFarmWorkerReadyShort " ") + QHostInfo::localHostName() );
+            } else if ( str.startsWith( QString::fromUtf8(kRenderFarmFrameShort) ) ) {
+                // <frame>\t<writer>
+                QStringList fields = str.mid( QString::fromUtf8(kRenderFarmFrameShort).size() ).trimmed().split( QLatin1Char('\t') );
+                int frame = fields.front().toInt();
+                QString error = _jobError;
+                bool ok = error.isEmpty() && (fields.size() > 1) && renderFrame(fields[1].toStdString(), frame, &error);
+                if (ok) {
+                    writeToCoordinator( QString::fromUtf8(kRenderFarmFrameFinishedShort " 0 ") + QString::number(frame) );
+                } else {
+                    writeToCoordinator( QString::fromUtf8(kRenderFarmFrameFinishedShort " 1 ") + QString::number(frame) + QLatin1Char(' ') + error );
+                }
+            }
+        }
+    }
+    _socket->close();
+    if (!mustQuit) {
+        std::cerr << tr("Lost the connection to the render coordinator %1").arg(coordinatorAddress).toStdString() << std::endl;
+    }
+
+    return mustQuit;
+} // exec
+
+bool
+RenderWorker::loadProject(const QString& projectFilePath,
+                          QString* error)
+{
+    AppInstancePtr app = _app.lock();
+    if (!app) {
+        *error = tr("The application was closed.");
+
+        return false;
+    }
+
+    QFileInfo info(projectFilePath);
+    if ( projectFilePath.isEmpty() || !info.exists() ) {
+        *error = tr("%1: No such file.").arg(projectFilePath);
+
+        return false;
+    }
+
+    // Plug-ins stay loaded between jobs: only load the project again if it changed
+    QString canonicalFilePath = info.canonicalFilePath();
+    QDateTime lastModified = info.lastModified();
+    if ( (canonicalFilePath != _projectFilePath) || (lastModified != _projectLastModified) ) {
+        _projectFilePath.clear();
+        std::cout << tr("Loading project %1").arg(canonicalFilePath).toStdString() << std::endl;
+        if ( !app->loadProject( canonicalFilePath.toStdString() ) ) {
+            *error = tr("Project file loading failed.");
+
+            return false;
+        }
+        _projectFilePath = canonicalFilePath;
+        _projectLastModified = lastModified;
+    }
+
+    return true;
+} // loadProject
+
+bool
+RenderWorker::renderFrame(const std::string& writer,
+                          int frame,
+                          QString* error)
+{
+    AppInstancePtr app = _app.lock();
+    if (!app) {
+        *error = tr("The application was closed.");
+
+        return false;
+    }
+
+    std::list<std::string> writers;
+    writers.push_back(writer);
+    std::list<std::pair<int, std::pair<int, int> > > frameRanges;
+    frameRanges.push_back( std::make_pair( 1, std::make_pair(frame, frame) ) );
+
+    RenderQueuePtr queue = app->getRenderQueue();
+    std::list<RenderQueue::RenderWork> works;
+    try {
+        queue->createRenderRequestsFromCommandLineArgs(false /*enableRenderStats*/, writers, frameRanges, works);
+    } catch (const std::exception& e) {
+        *error = QString::fromUtf8( e.what() );
+
+        return false;
+    }
+
+    {
+        QMutexLocker k(&_renderedFramesMutex);
+        _renderedFrames.clear();
+    }
+    queue->renderBlocking(works);
+
+    // The render does not report failures to the caller: check that the scheduler notified the frame
+    QMutexLocker k(&_renderedFramesMutex);
+    if ( _renderedFrames.find(frame) == _renderedFrames.end() ) {
+        *error = tr("Render failed.");
+
+        return false;
+    }
+
+    return true;
+} // renderFrame
+
+void
+RenderWorker::onOutputMessage(const QString& message)
+{
+    // kFrameRenderedStringShort<frame>kProgressChangedStringShort<progress>
+    if ( !message.startsWith( QString::fromUtf8(kFrameRenderedStringShort) ) ) {
+        return;
+    }
+    QString frameStr = message.mid( QString::fromUtf8(kFrameRenderedStringShort).size() );
+    int progressIndex = frameStr.indexOf( QString::fromUtf8(kProgressChangedStringShort) );
+    if (progressIndex != -1) {
+        frameStr = frameStr.left(progressIndex);
+    }
+    bool ok;
+    double frame = frameStr.toDouble(&ok);
+    if (!ok) {
+        return;
+    }
+    QMutexLocker k(&_renderedFramesMutex);
+    _renderedFrames.insert( (int)std::floor(frame + 0.5) );
+}
+
+void
+RenderWorker::writeToCoordinator(const QString& message)
+{
+    _socket->write( ( message + QLatin1Char('\n') ).toUtf8() );
+    _socket->flush();
+    _socket->waitForBytesWritten(-1);
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,111 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_RENDERWORKER_H
+#define NATRON_ENGINE_RENDERWORKER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <set>
+#include <string>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#endif
+
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+CLANG_DIAG_ON(deprecated)
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+class QTcpSocket;
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief A worker of a distributed render: it is started with the --render-worker <host>:<port> command-line option,
+ * connects to the RenderCoordinator listening at that address, loads the project it is sent and renders the frames
+ * it is sent one at a time until the coordinator has no frame left. See RenderCoordinator for the messages exchanged.
+ **/
+class RenderWorker
+{
+    Q_DECLARE_TR_FUNCTIONS(RenderWorker)
+
+public:
+
+    RenderWorker(const AppInstancePtr& app);
+
+    ~RenderWorker();
+
+    /**
+     * @brief Connects to the coordinator at the given <host>:<port> address and renders its frames until it sends
+     * kRenderServerQuitShort. This function blocks. Returns false if the connection could not be made or was lost.
+     **/
+    bool exec(const QString& coordinatorAddress);
+
+    /**
+     * @brief Called with the messages normally written to the output pipe of a background render, to find out
+     * which frames were rendered. This may be called from any thread.
+     **/
+    void onOutputMessage(const QString& message);
+
+private:
+
+    /**
+     * @brief Loads the project of the job if it is not loaded yet. Returns false and sets the error otherwise.
+     **/
+    bool loadProject(const QString& projectFilePath, QString* error);
+
+    /**
+     * @brief Renders a single frame with the given Write node. Returns false and sets the error if the frame was not rendered.
+     **/
+    bool renderFrame(const std::string& writer, int frame, QString* error);
+
+    void writeToCoordinator(const QString& message);
+
+    boost::weak_ptr<AppInstance> _app;
+    boost::scoped_ptr<QTcpSocket> _socket;
+
+    // The project currently loaded and its modification date when it was loaded
+    QString _projectFilePath;
+    QDateTime _projectLastModified;
+
+    // If the project of the job could not be loaded, the error reported for all its frames
+    QString _jobError;
+
+    // Protects _renderedFrames which is written to by the render threads
+    QMutex _renderedFramesMutex;
+    std::set<int> _renderedFrames;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_RENDERWORKER_H
@@ -25,13 +25,23 @@
 #include "RotoBezierTriangulation.h"
 
 #include <QDebug>
+#include <QtCore/QMutex>
 #include <cmath>
+#include <list>
+#include <map>
 #include <set>
 #include <boost/cstdint.hpp> // uintptr_t
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
 #include <cstddef> // size_t
 
 #include "libtess.h"
 
+#include "Engine/Hash64.h"
+
+// Maximum memory used by the tessellations kept for the next renders
+#define NATRON_ROTO_TESSELATION_CACHE_MAX_BYTES (64 * 1024 * 1024)
+
 using boost::uintptr_t;
 using std::size_t;
 using std::vector;
@@ -1110,6 +1120,112 @@ static void originalPolygonCopy(PolygonCSGData& data,
 }
 
 
+// Identifies a tessellation: the hash of the Bezier at the time and view, and the render scale
+typedef boost::tuple<U64, double, double> TesselationKey;
+
+struct TesselationCacheEntry
+{
+    TesselationKey key;
+    RotoBezierTriangulation::PolygonData data;
+    std::size_t size;
+};
+
+typedef std::list<TesselationCacheEntry> TesselationCacheEntryList;
+
+/**
+ * @brief The tessellations of the last rendered shapes: most shapes are not animated at every frame,
+ * so their tessellation does not change from a frame to the next one. The least recently used are removed first.
+ **/
+struct TesselationCache
+{
+    QMutex lock;
+
+    // The most recently used first
+    TesselationCacheEntryList entries;
+    std::map<TesselationKey, TesselationCacheEntryList::iterator> index;
+    std::size_t totalSize;
+
+    TesselationCache()
+    : lock()
+    , entries()
+    , index()
+    , totalSize(0)
+    {
+    }
+};
+
+TesselationCache&
+getTesselationCache()
+{
+    static TesselationCache cache;
+
+    return cache;
+}
+
+std::size_t
+getPolygonDataSize(const RotoBezierTriangulation::PolygonData& data)
+{
+    std::size_t size = sizeof(RotoBezierTriangulation::PolygonData);
+    size += data.featherVertices.size() * sizeof(RotoBezierTriangulation::BezierVertex);
+    size += data.featherTriangles.size() * sizeof(unsigned int);
+    size += data.internalShapeVertices.size() * sizeof(Point);
+    const std::vector<std::vector<unsigned int> >* primitives[3] = { &data.internalShapeTriangles, &data.internalShapeTriangleFans, &data.internalShapeTriangleStrips };
+    for (int i = 0; i < 3; ++i) {
+        for (std::size_t j = 0; j < primitives[i]->size(); ++j) {
+            size += (*primitives[i])[j].size() * sizeof(unsigned int);
+        }
+    }
+
+    return size;
+}
+
+bool
+findCachedTesselation(const TesselationKey& key,
+                      RotoBezierTriangulation::PolygonData* data)
+{
+    TesselationCache& cache = getTesselationCache();
+    QMutexLocker k(&cache.lock);
+
+    std::map<TesselationKey, TesselationCacheEntryList::iterator>::iterator found = cache.index.find(key);
+    if ( found == cache.index.end() ) {
+        return false;
+    }
+    cache.entries.splice(cache.entries.begin(), cache.entries, found->second);
+    *data = found->second->data;
+
+    return true;
+}
+
+void
+insertCachedTesselation(const TesselationKey& key,
+                        const RotoBezierTriangulation::PolygonData& data)
+{
+    std::size_t size = getPolygonDataSize(data);
+    if (size > NATRON_ROTO_TESSELATION_CACHE_MAX_BYTES) {
+        return;
+    }
+
+    TesselationCache& cache = getTesselationCache();
+    QMutexLocker k(&cache.lock);
+
+    if ( cache.index.find(key) != cache.index.end() ) {
+        // Another render thread tessellated the same shape
+        return;
+    }
+    while ( !cache.entries.empty() && (cache.totalSize + size > NATRON_ROTO_TESSELATION_CACHE_MAX_BYTES) ) {
+        cache.totalSize -= cache.entries.back().size;
+        cache.index.erase(cache.entries.back().key);
+        cache.entries.pop_back();
+    }
+    TesselationCacheEntry entry;
+    entry.key = key;
+    entry.data = data;
+    entry.size = size;
+    cache.entries.push_front(entry);
+    cache.index[key] = cache.entries.begin();
+    cache.totalSize += size;
+}
+
 NATRON_NAMESPACE_ANONYMOUS_EXIT;
 
 
@@ -1125,6 +1241,20 @@ RotoBezierTriangulation::tesselate(const BezierPtr& bezier,
 
     assert(outArgs);
 
+    // The hash of the Bezier covers its control points and its parameters (feather, transform...) at the given time:
+    // it is the same for all the frames where the shape is not animated
+    TesselationKey key;
+    {
+        HashableObject::ComputeHashArgs hashArgs;
+        hashArgs.time = time;
+        hashArgs.view = view;
+        hashArgs.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+        key = TesselationKey(bezier->computeHash(hashArgs), scale.x, scale.y);
+    }
+    if ( findCachedTesselation(key, outArgs) ) {
+        return;
+    }
+
     bool clockWise = bezier->isClockwiseOriented(time, view);
 
     PolygonCSGData data;
@@ -1177,6 +1307,8 @@ RotoBezierTriangulation::tesselate(const BezierPtr& bezier,
     // Now that we have the role (inner or outter) for each vertex, compute the feather mesh
     computeFeatherTriangles(data, outArgs);
 
+    insertCachedTesselation(key, *outArgs);
+
 } // tesselate
 
 
@@ -923,6 +923,14 @@ RotoDrawableItem::resetNodesThreadSafety()
     node->getEffectInstance()->revertToPluginThreadSafety();
 }
 
+void
+RotoDrawableItem::clearNodesAccumulationBuffers()
+{
+    for (NodesList::iterator it = _imp->nodes.begin(); it != _imp->nodes.end(); ++it) {
+        (*it)->getEffectInstance()->clearLastRenderedImage();
+    }
+}
+
 
 bool
 RotoDrawableItem::isActivated(TimeValue time, ViewIdx view) const
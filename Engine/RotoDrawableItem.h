@@ -134,6 +134,13 @@ protected:
     void resetNodesThreadSafety();
     
 public:
+
+    /**
+     * @brief While painting a stroke, the internal nodes render the newly added points on top of the image
+     * of the previous draw step, which they hold. This releases these images once the stroke is done.
+     **/
+    void clearNodesAccumulationBuffers();
+
     /**
      * @brief Connects nodes used by this item in the rotopaint tree. createNodes() must have been called prior
      * to calling this function.
@@ -25,6 +25,8 @@
 #include "RotoPaint.h"
 #include "RotoPaintPrivate.h"
 
+#include <algorithm> // find
+#include <iterator> // distance
 #include <sstream> // stringstream
 #include <cassert>
 #include <stdexcept>
@@ -103,6 +105,9 @@
 
 #define ROTOPAINT_VIEWER_UI_SECTIONS_SPACING_PX 5
 
+// Minimum number of consecutive items composited with a global Merge node when the whole tree cannot be concatenated
+#define NATRON_ROTOPAINT_MIN_CONCATENATED_ITEMS 8
+
 NATRON_NAMESPACE_ENTER;
 
 static void addPluginShortcuts(const PluginPtr& plugin)
@@ -2242,6 +2247,23 @@ RotoPaint::initializeKnobs()
         generalPage->addKnob(premultKnob);
     }
 
+    if (_imp->nodeType != eRotoPaintTypeComp) {
+        KnobChoicePtr param = createKnob<KnobChoice>(kRotoCPURendererParam);
+        param->setLabel(tr(kRotoCPURendererParamLabel));
+        param->setHintToolTip( tr(kRotoCPURendererParamHint) );
+        param->setAnimationEnabled(false);
+        {
+            std::vector<ChoiceOption> entries;
+            assert((int)entries.size() == eRotoCPURendererDefault);
+            entries.push_back(ChoiceOption(kRotoCPURendererDefault, "", tr(kRotoCPURendererDefaultHint).toStdString()));
+            assert((int)entries.size() == eRotoCPURendererScanline);
+            entries.push_back(ChoiceOption(kRotoCPURendererScanline, "", tr(kRotoCPURendererScanlineHint).toStdString()));
+            param->populateChoices(entries);
+        }
+        generalPage->addKnob(param);
+        _imp->cpuRendererKnob = param;
+    }
+
     if (_imp->nodeType != eRotoPaintTypeComp) {
         initViewerUIKnobs(generalPage);
     }
@@ -2291,6 +2313,7 @@ RotoPaint::fetchRenderCloneKnobs()
 {
     EffectInstance::fetchRenderCloneKnobs();
     _imp->motionBlurTypeKnob = toKnobChoice(getKnobByName(kRotoMotionBlurModeParam));
+    _imp->cpuRendererKnob = toKnobChoice(getKnobByName(kRotoCPURendererParam));
     _imp->globalMotionBlurKnob = toKnobInt(getKnobByName(kRotoGlobalMotionBlurParam));
     _imp->globalShutterKnob = toKnobDouble(getKnobByName(kRotoGlobalShutterParam));
     _imp->globalShutterTypeKnob = toKnobChoice(getKnobByName(kRotoGlobalShutterOffsetTypeParam));
@@ -2817,79 +2840,79 @@ RotoPaintKnobItemsTable::createSerializationFromItem(const KnobTableItemPtr& ite
 }
 
 bool
-RotoPaintPrivate::isRotoPaintTreeConcatenatableInternal(const std::list<RotoDrawableItemPtr >& items,  int* blendingMode) const
+RotoPaintPrivate::isItemConcatenatable(const RotoDrawableItemPtr& item, int* blendingOperator) const
 {
-    // Iterate over items, if they all have the same compositing operator, concatenate. Concatenation only works for Solids or Comp items. If a comp item has a mask or mix is animated or different than 1, we cannot concatenate
-    bool operatorSet = false;
-    int comp_i = -1;
-
-    for (std::list<RotoDrawableItemPtr >::const_iterator it = items.begin(); it != items.end(); ++it) {
-
-        MergingFunctionEnum op = (MergingFunctionEnum)(*it)->getOperatorKnob()->getValue();
+    // The merge node of an item has its operator linked to the item operator: the global merge nodes
+    // composite each of their A inputs in turn onto the previous result with the same operator.
+    KnobChoicePtr operatorKnob = item->getOperatorKnob();
+    if ( operatorKnob->hasAnimation() ) {
+        return false;
+    }
+    *blendingOperator = operatorKnob->getValue();
 
-        // Can only concatenate with over
-        if (op != eMergeOver) {
+    RotoPaintItemLifeTimeTypeEnum lifeTime = (RotoPaintItemLifeTimeTypeEnum)item->getLifeTimeFrameKnob()->getValue();
+    if (lifeTime != eRotoPaintItemLifeTimeTypeAll && lifeTime != eRotoPaintItemLifeTimeTypeCustom) {
+        // An item with a varying lifetime makes the concatenation impossible: we cannot disconenct and reconnect the A input of the global
+        // Merge through time.
+        return false;
+    }
+    if (lifeTime == eRotoPaintItemLifeTimeTypeCustom) {
+        // If custom and the custom range checkbox is animated or unchecked, do not concatenate
+        KnobBoolPtr customRange = item->getCustomRangeKnob();
+        if (customRange->hasAnimation() || !customRange->getValue()) {
             return false;
         }
+    }
 
-        if (!operatorSet) {
-            operatorSet = true;
-            comp_i = op;
-        } else {
-            if (op != comp_i) {
-                // 2 items have a different compositing operator
-                return false;
-            }
-        }
+    // Now check the global activated/solo switches
+    if (!item->isGloballyActivated()) {
+        return false;
+    }
+
+    RotoStrokeType type = item->getBrushType();
 
-        RotoPaintItemLifeTimeTypeEnum lifeTime = (RotoPaintItemLifeTimeTypeEnum)(*it)->getLifeTimeFrameKnob()->getValue();
-        if (lifeTime != eRotoPaintItemLifeTimeTypeAll && lifeTime != eRotoPaintItemLifeTimeTypeCustom) {
-            // An item with a varying lifetime makes the concatenation impossible: we cannot disconenct and reconnect the A input of the global
-            // Merge through time.
+    // Other item types cannot concatenate since they use a custom mask on their Merge node.
+    if (type != eRotoStrokeTypeSolid && type != eRotoStrokeTypeEraser && type != eRotoStrokeTypeComp) {
+        return false;
+    }
+
+
+    // If the comp item has a mask on the merge node or a mix != 1, forget concatenating
+    if (type == eRotoStrokeTypeComp) {
+        if (item->getMergeMaskChoiceKnob()->getValue() > 0) {
             return false;
         }
-        if (lifeTime == eRotoPaintItemLifeTimeTypeCustom) {
-            // If custom and the custom range checkbox is animated or unchecked, do not concatenate
-            KnobBoolPtr customRange = (*it)->getCustomRangeKnob();
-            if (customRange->hasAnimation() || !customRange->getValue()) {
-                return false;
-            }
-        }
-
-        // Now check the global activated/solo switches
-        if (!(*it)->isGloballyActivated()) {
+        KnobDoublePtr mixKnob = item->getMixKnob();
+        if (mixKnob->hasAnimation() || mixKnob->getValue() != 1.) {
             return false;
         }
+    }
 
-        RotoStrokeType type = (*it)->getBrushType();
+    return true;
+} // isItemConcatenatable
 
-        // Other item types cannot concatenate since they use a custom mask on their Merge node.
-        if (type != eRotoStrokeTypeSolid && type != eRotoStrokeTypeEraser && type != eRotoStrokeTypeComp) {
+bool
+RotoPaintPrivate::isRotoPaintTreeConcatenatableInternal(const std::list<RotoDrawableItemPtr >& items,  int* blendingMode) const
+{
+    // Iterate over items, if they all can be composited with a single Merge with the same operator, concatenate.
+    // Concatenation only works for Solids or Comp items.
+    if ( items.empty() ) {
+        return false;
+    }
+    int treeOperator = -1;
+    for (std::list<RotoDrawableItemPtr >::const_iterator it = items.begin(); it != items.end(); ++it) {
+        int itemOperator;
+        if ( !isItemConcatenatable(*it, &itemOperator) ) {
             return false;
         }
-
-
-        // If the comp item has a mask on the merge node or a mix != 1, forget concatenating
-        if (type == eRotoStrokeTypeComp) {
-            if ((*it)->getMergeMaskChoiceKnob()->getValue() > 0) {
-                return false;
-            }
-            KnobDoublePtr mixKnob = (*it)->getMixKnob();
-            if (mixKnob->hasAnimation() || mixKnob->getValue() != 1.) {
-                return false;
-            }
-
+        if ( (treeOperator != -1) && (itemOperator != treeOperator) ) {
+            return false;
         }
-
-        
+        treeOperator = itemOperator;
     }
-    if (operatorSet) {
-        *blendingMode = comp_i;
+    *blendingMode = treeOperator;
 
-        return true;
-    }
-
-    return false;
+    return true;
 } // isRotoPaintTreeConcatenatableInternal
 
 bool
@@ -2956,11 +2979,15 @@ RotoPaintPrivate::getOrCreateGlobalTimeBlurNode()
 }
 
 NodePtr
-RotoPaintPrivate::getOrCreateGlobalMergeNode(int blendingOperator, int *availableInputIndex)
+RotoPaintPrivate::getOrCreateGlobalMergeNode(int blendingOperator, int firstMergeIndex, int *availableInputIndex)
 {
     {
         QMutexLocker k(&globalMergeNodesMutex);
-        for (NodesList::iterator it = globalMergeNodes.begin(); it != globalMergeNodes.end(); ++it) {
+        NodesList::iterator it = globalMergeNodes.begin();
+        for (int i = 0; i < firstMergeIndex && it != globalMergeNodes.end(); ++i) {
+            ++it;
+        }
+        for (; it != globalMergeNodes.end(); ++it) {
             const std::vector<NodeWPtr > &inputs = (*it)->getInputs();
 
             // Merge node goes like this: B, A, Mask, A2, A3, A4 ...
@@ -3095,6 +3122,72 @@ RotoPaintPrivate::connectRotoPaintBottomTreeToItems(bool /*canConcatenate*/,
 
 }
 
+NodePtr
+RotoPaintPrivate::concatenateItems(const std::vector<RotoDrawableItemPtr>& items,
+                                   std::size_t firstItem,
+                                   std::size_t lastItem,
+                                   const NodePtr& upstreamNode,
+                                   int blendingOperator,
+                                   int* firstMergeIndex,
+                                   Point* mergeNodeBeginPos)
+{
+    int globalMergeIndex = -1;
+    NodePtr globalMerge = getOrCreateGlobalMergeNode(blendingOperator, *firstMergeIndex, &globalMergeIndex);
+    if (!globalMerge) {
+        return globalMerge;
+    }
+
+    // The B input of the first global Merge is the image the items are composited onto
+    if (upstreamNode) {
+        globalMerge->swapInput(upstreamNode, 0);
+    }
+
+    for (std::size_t i = firstItem; i < lastItem; ++i) {
+
+        // Items are placed every 200 pixels in the node-graph, see refreshRotoPaintTree()
+        double itemPosX = 200. * (i + 1);
+
+        // Connect the global merge Ax input to the effect
+        NodePtr mergeInputA = items[i]->getMergeNode()->getInput(1);
+        if (!mergeInputA) {
+            continue;
+        }
+        //qDebug() << "Connecting" << items[i]->getScriptName().c_str() << "to input" << globalMergeIndex <<
+        //"(" << globalMerge->getInputLabel(globalMergeIndex).c_str() << ")" << "of" << globalMerge->getScriptName().c_str();
+        globalMerge->swapInput(mergeInputA, globalMergeIndex);
+
+        // If the global merge node has all its A inputs connected, create a new one, otherwise get the next A input.
+        NodePtr nextMerge = getOrCreateGlobalMergeNode(blendingOperator, *firstMergeIndex, &globalMergeIndex);
+        if (nextMerge != globalMerge) {
+
+            // Place the global merge below at the average of all nodes used
+            mergeNodeBeginPos->x = (itemPosX + mergeNodeBeginPos->x) / 2.;
+            globalMerge->setPosition(mergeNodeBeginPos->x, mergeNodeBeginPos->y);
+
+            mergeNodeBeginPos->y -= 200;
+
+            // If we made a new merge node, connect the B input of the new merge to the previous global merge.
+            assert( !nextMerge->getInput(0) );
+            nextMerge->connectInput(globalMerge, 0);
+            globalMerge = nextMerge;
+        }
+    }
+
+    // Refresh the last global merge position
+    mergeNodeBeginPos->x = (200. * lastItem + mergeNodeBeginPos->x) / 2.;
+    globalMerge->setPosition(mergeNodeBeginPos->x, mergeNodeBeginPos->y);
+
+    // The next concatenation must not use the global merge nodes of this one
+    {
+        QMutexLocker k(&globalMergeNodesMutex);
+        NodesList::iterator found = std::find(globalMergeNodes.begin(), globalMergeNodes.end(), globalMerge);
+        assert( found != globalMergeNodes.end() );
+        *firstMergeIndex = (int)std::distance(globalMergeNodes.begin(), found) + 1;
+    }
+
+    return globalMerge;
+} // concatenateItems
+
 void
 RotoPaint::refreshRotoPaintTree()
 {
@@ -3112,13 +3205,6 @@ RotoPaint::refreshRotoPaintTree()
     // Check if the tree can be concatenated into a single merge node
     int blendingOperator = -1;
     bool canConcatenate = _imp->isRotoPaintTreeConcatenatableInternal(items, &blendingOperator);
-    NodePtr globalMerge;
-    int globalMergeIndex = -1;
-
-
-    // Get the first global merge node.
-    globalMerge = _imp->getOrCreateGlobalMergeNode(blendingOperator, &globalMergeIndex);
-
 
     {
         NodesList mergeNodes;
@@ -3142,59 +3228,76 @@ RotoPaint::refreshRotoPaintTree()
     RotoPaintPtr rotoPaintEffect = toRotoPaint(getNode()->getEffectInstance());
     assert(rotoPaintEffect);
 
-    // If concatenation enabled, connect the B input of the global Merge to the RotoPaint
-    // background input node.
-    if (canConcatenate) {
-        NodePtr rotopaintNodeInput = rotoPaintEffect->getInternalInputNode(0);
-        if (rotopaintNodeInput) {
-            globalMerge->swapInput(rotopaintNodeInput, 0);
-        }
-    }
-
     // Refresh each item separately
     // Also place items in the node-graph
     Point nodePosition = {0.,0.};
-    Point mergeNodeBeginPos = {0, 300};
     for (std::list<RotoDrawableItemPtr >::const_iterator it = items.begin(); it != items.end(); ++it) {
         (*it)->refreshNodesConnections();
         (*it)->refreshNodesPositions(nodePosition.x, nodePosition.y);
 
         // Place each item tree on the right
         nodePosition.x += 200;
+    }
 
-        if (canConcatenate) {
-
-            // If we concatenate the tree, connect the global merge Ax input to the effect
-
-            NodePtr mergeInputA = (*it)->getMergeNode()->getInput(1);
-            if (mergeInputA) {
-                //qDebug() << "Connecting" << (*it)->getScriptName().c_str() << "to input" << globalMergeIndex <<
-                //"(" << globalMerge->getInputLabel(globalMergeIndex).c_str() << ")" << "of" << globalMerge->getScriptName().c_str();
-                globalMerge->swapInput(mergeInputA, globalMergeIndex);
-
-                // If the global merge node has all its A inputs connected, create a new one, otherwise get the next A input.
-                NodePtr nextMerge = _imp->getOrCreateGlobalMergeNode(blendingOperator, &globalMergeIndex);
-                if (nextMerge != globalMerge) {
-
-                    // Place the global merge below at the average of all nodes used
-                    mergeNodeBeginPos.x = (nodePosition.x + mergeNodeBeginPos.x) / 2.;
-                    globalMerge->setPosition(mergeNodeBeginPos.x, mergeNodeBeginPos.y);
-
-                    mergeNodeBeginPos.y -= 200;
+    // The node at the bottom of the items tree
+    NodePtr itemsTreeOutput;
+    Point mergeNodeBeginPos = {0, 300};
+    std::vector<RotoDrawableItemPtr> itemsVec(items.begin(), items.end());
+    int firstMergeIndex = 0;
+    if (canConcatenate) {
+        // If concatenation enabled, connect the B input of the global Merge to the RotoPaint
+        // background input node and the A inputs to the items.
+        itemsTreeOutput = _imp->concatenateItems(itemsVec, 0, itemsVec.size(), rotoPaintEffect->getInternalInputNode(0), blendingOperator, &firstMergeIndex, &mergeNodeBeginPos);
+    } else {
+        // Otherwise each item is merged onto the previous one. Long runs of consecutive items that can be composited
+        // with the same operator by a single Merge are still concatenated, so that the shapes of dense layers are not
+        // merged one after another in a deep tree of Merge nodes: the global Merge renders all its inputs concurrently
+        // and composites them in a single output image.
+        std::size_t i = 0;
+        while ( i < itemsVec.size() ) {
+            std::size_t runEnd = i;
+            int runOperator = -1;
+            while ( runEnd < itemsVec.size() ) {
+                int itemOperator;
+                if ( !_imp->isItemConcatenatable(itemsVec[runEnd], &itemOperator) ) {
+                    break;
+                }
+                if ( (runOperator != -1) && (itemOperator != runOperator) ) {
+                    break;
+                }
+                runOperator = itemOperator;
+                ++runEnd;
+            }
+            if (runEnd - i < NATRON_ROTOPAINT_MIN_CONCATENATED_ITEMS) {
+                i = std::max(runEnd, i + 1);
+                continue;
+            }
 
-                    // If we made a new merge node, connect the B input of the new merge to the previous global merge.
-                    assert( !nextMerge->getInput(0) );
-                    nextMerge->connectInput(globalMerge, 0);
-                    globalMerge = nextMerge;
+            NodePtr upstreamNode = i > 0 ? itemsVec[i - 1]->getMergeNode() : rotoPaintEffect->getInternalInputNode(0);
+            NodePtr runOutput = _imp->concatenateItems(itemsVec, i, runEnd, upstreamNode, runOperator, &firstMergeIndex, &mergeNodeBeginPos);
+            if (!runOutput) {
+                break;
+            }
+            if ( runEnd < itemsVec.size() ) {
+                // The next item takes the output of the global Merge instead of the merge node of the last concatenated item
+                NodePtr lastRunItemMerge = itemsVec[runEnd - 1]->getMergeNode();
+                const NodesList& nextItemNodes = itemsVec[runEnd]->getItemNodes();
+                for (NodesList::const_iterator it = nextItemNodes.begin(); it != nextItemNodes.end(); ++it) {
+                    int maxInputs = (*it)->getMaxInputCount();
+                    for (int j = 0; j < maxInputs; ++j) {
+                        if ( (*it)->getInput(j) == lastRunItemMerge ) {
+                            (*it)->swapInput(runOutput, j);
+                        }
+                    }
                 }
+            } else {
+                itemsTreeOutput = runOutput;
             }
+            i = runEnd;
+        }
+        if ( !itemsTreeOutput && !items.empty() ) {
+            itemsTreeOutput = items.back()->getMergeNode();
         }
-    }
-
-    // Refresh the last global merge position
-    {
-        mergeNodeBeginPos.x = (nodePosition.x + mergeNodeBeginPos.x) / 2.;
-        globalMerge->setPosition(mergeNodeBeginPos.x, mergeNodeBeginPos.y);
     }
 
     // At this point all items have their tree OK, now just connect the bottom of the tree
@@ -3257,18 +3360,12 @@ RotoPaint::refreshRotoPaintTree()
     }
 
 
-    if (canConcatenate) {
-        // Connect the bottom of the tree to the last global merge node.
-        _imp->connectRotoPaintBottomTreeToItems(canConcatenate, rotoPaintEffect, premultNode,  timeBlurNode, treeOutputNode, _imp->globalMergeNodes.back());
+    if (itemsTreeOutput) {
+        // Connect the bottom of the tree to the last global merge node or the last item merge node.
+        _imp->connectRotoPaintBottomTreeToItems(canConcatenate, rotoPaintEffect, premultNode, timeBlurNode, treeOutputNode, itemsTreeOutput);
     } else {
-
-        if (!items.empty()) {
-            // Connect the bottom of the tree to the last item merge node.
-            _imp->connectRotoPaintBottomTreeToItems(canConcatenate, rotoPaintEffect, premultNode, timeBlurNode, treeOutputNode, items.back()->getMergeNode());
-        } else {
-            // Connect output to Input, the RotoPaint is pass-through
-            treeOutputNode->swapInput(rotoPaintEffect->getInternalInputNode(0), 0);
-        }
+        // Connect output to Input, the RotoPaint is pass-through
+        treeOutputNode->swapInput(rotoPaintEffect->getInternalInputNode(0), 0);
     }
 
     if (premultNode) {
@@ -3488,6 +3585,12 @@ RotoPaint::getMotionBlurTypeKnob() const
     return _imp->motionBlurTypeKnob.lock();
 }
 
+KnobChoicePtr
+RotoPaint::getCPURendererKnob() const
+{
+    return _imp->cpuRendererKnob.lock();
+}
+
 KnobDoublePtr
 RotoPaint::getMixKnob() const
 {
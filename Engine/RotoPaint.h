@@ -341,6 +341,22 @@ enum RotoMotionBlurModeEnum
     eRotoMotionBlurModeGlobal
 };
 
+#define kRotoCPURendererParam "cpuRenderer"
+#define kRotoCPURendererParamLabel "CPU Renderer"
+#define kRotoCPURendererParamHint "The renderer used for the shapes when they are not rendered with the GPU, e.g: on a render farm without OpenGL."
+
+#define kRotoCPURendererDefault "Default"
+#define kRotoCPURendererDefaultHint "Renders the shapes with OSMesa or Cairo, depending on how " NATRON_APPLICATION_NAME " was compiled"
+#define kRotoCPURendererScanline "Scanline"
+#define kRotoCPURendererScanlineHint "Renders the closed Beziers with a multi-threaded scan-line rasterizer which is faster for feathered shapes. " \
+"Paint strokes and open Beziers are rendered with the default renderer."
+
+enum RotoCPURendererEnum
+{
+    eRotoCPURendererDefault,
+    eRotoCPURendererScanline
+};
+
 #define kRotoPerShapeMotionBlurParam "motionBlur"
 #define kRotoGlobalMotionBlurParam "globalMotionBlur"
 #define kRotoMotionBlurParamLabel "Motion Blur"
@@ -492,6 +508,8 @@ public:
 
     KnobChoicePtr getMotionBlurTypeKnob() const;
 
+    KnobChoicePtr getCPURendererKnob() const;
+
     KnobDoublePtr getMixKnob() const;
 
     void refreshSourceKnobs(const RotoDrawableItemPtr& item);
@@ -3236,6 +3236,9 @@ RotoPaintInteract::onOverlayPenUp(TimeValue /*time*/,
         
         bool multiStrokeEnabled = isMultiStrokeEnabled();
         if (!multiStrokeEnabled) {
+            // The stroke is done: the final render no longer accumulates and is cached.
+            // With multi-stroke, the next sub-stroke is drawn on top of the buffer.
+            strokeBeingPaint->clearNodesAccumulationBuffers();
             _imp->publicInterface->pushUndoCommand( new AddStrokeUndoCommand(_imp->ui, strokeBeingPaint) );
             makeStroke( true, RotoPoint() );
         } else {
@@ -28,6 +28,7 @@
 #include "Global/Macros.h"
 
 #include <list>
+#include <vector>
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/enable_shared_from_this.hpp>
 #endif
@@ -581,6 +582,7 @@ struct RotoPaintPrivate
     KnobButtonWPtr resetTransformKnob;
 
     KnobChoiceWPtr motionBlurTypeKnob;
+    KnobChoiceWPtr cpuRendererKnob;
     KnobIntWPtr motionBlurKnob, globalMotionBlurKnob;
     KnobDoubleWPtr shutterKnob, globalShutterKnob;
     KnobChoiceWPtr shutterTypeKnob, globalShutterTypeKnob;
@@ -612,10 +614,33 @@ struct RotoPaintPrivate
     RotoPaintPrivate(RotoPaint* publicInterface,
                      RotoPaint::RotoPaintTypeEnum type);
 
-    NodePtr getOrCreateGlobalMergeNode(int blendingOperator, int *availableInputIndex);
+    /**
+     * @brief Returns a global merge node with a free A input, skipping the firstMergeIndex first global merge nodes.
+     **/
+    NodePtr getOrCreateGlobalMergeNode(int blendingOperator, int firstMergeIndex, int *availableInputIndex);
+
+    /**
+     * @brief Composites the items in [firstItem, lastItem) onto upstreamNode with global merge nodes instead of their own merge node.
+     * The global merge nodes used are after firstMergeIndex, which is updated to the index following the last one used.
+     * Returns the last global merge node.
+     **/
+    NodePtr concatenateItems(const std::vector<RotoDrawableItemPtr>& items,
+                             std::size_t firstItem,
+                             std::size_t lastItem,
+                             const NodePtr& upstreamNode,
+                             int blendingOperator,
+                             int* firstMergeIndex,
+                             Point* mergeNodeBeginPos);
 
     NodePtr getOrCreateGlobalTimeBlurNode();
 
+    /**
+     * @brief Returns true if the given item can be composited by a global merge node instead of its own merge node.
+     * Its compositing operator is returned in blendingOperator: only consecutive items with the same operator
+     * may be composited by the same global merge node.
+     **/
+    bool isItemConcatenatable(const RotoDrawableItemPtr& item, int* blendingOperator) const;
+
     bool isRotoPaintTreeConcatenatableInternal(const std::list<RotoDrawableItemPtr >& items,
                                                int* blendingMode) const;
 
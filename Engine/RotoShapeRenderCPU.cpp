@@ -0,0 +1,502 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RotoShapeRenderCPU.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "Engine/Bezier.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Image.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/MultiThread.h"
+#include "Engine/RotoBezierTriangulation.h"
+#include "Engine/RotoShapeRenderGL.h" // RampTypeEnum
+
+// Number of scan-lines of the bins the triangles are sorted into before being rasterized:
+// a thread only goes through the triangles of the bins its band of scan-lines overlaps
+#define NATRON_ROTO_CPU_BIN_HEIGHT 16
+
+NATRON_NAMESPACE_ENTER;
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER;
+
+/**
+ * @brief A triangle of the mesh with the plane equation of its ramp parameter: t(x,y) = tx * x + ty * y + t0
+ * The ramp parameter is 1 on the inner vertices and 0 on the outter vertices of the feather.
+ **/
+struct RasterTriangle
+{
+    Point p[3];
+    double tx, ty, t0;
+
+    // True if the ramp parameter is 1 everywhere, i.e: a triangle of the internal shape
+    bool isSolid;
+
+    // The scan-lines whose center is in the triangle bounding box
+    int y1, y2;
+};
+
+void
+appendTriangle(const Point& a,
+               double ta,
+               const Point& b,
+               double tb,
+               const Point& c,
+               double tc,
+               std::vector<RasterTriangle>* triangles)
+{
+    double det = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+
+    if (det == 0.) {
+        // Degenerated triangle: no pixel center is inside
+        return;
+    }
+
+    RasterTriangle tri;
+    tri.p[0] = a;
+    tri.p[1] = b;
+    tri.p[2] = c;
+    tri.isSolid = (ta == 1.) && (tb == 1.) && (tc == 1.);
+    tri.tx = ( (tb - ta) * (c.y - a.y) - (tc - ta) * (b.y - a.y) ) / det;
+    tri.ty = ( (tc - ta) * (b.x - a.x) - (tb - ta) * (c.x - a.x) ) / det;
+    tri.t0 = ta - tri.tx * a.x - tri.ty * a.y;
+
+    double ymin = std::min( a.y, std::min(b.y, c.y) );
+    double ymax = std::max( a.y, std::max(b.y, c.y) );
+    tri.y1 = (int)std::ceil(ymin - 0.5);
+    tri.y2 = (int)std::floor(ymax - 0.5) + 1;
+    if (tri.y1 >= tri.y2) {
+        return;
+    }
+    triangles->push_back(tri);
+} // appendTriangle
+
+void
+appendPolygonTriangles(const RotoBezierTriangulation::PolygonData& data,
+                       std::vector<RasterTriangle>* triangles)
+{
+    // The feather mesh is made of GL_TRIANGLES
+    for (std::size_t i = 0; i + 2 < data.featherTriangles.size(); i += 3) {
+        const RotoBezierTriangulation::BezierVertex* v[3];
+        Point p[3];
+        for (int j = 0; j < 3; ++j) {
+            assert(data.featherTriangles[i + j] < data.featherVertices.size());
+            v[j] = &data.featherVertices[data.featherTriangles[i + j]];
+            p[j].x = v[j]->x;
+            p[j].y = v[j]->y;
+        }
+        appendTriangle(p[0], v[0]->isInner ? 1. : 0., p[1], v[1]->isInner ? 1. : 0., p[2], v[2]->isInner ? 1. : 0., triangles);
+    }
+
+    const std::vector<Point>& vertices = data.internalShapeVertices;
+    for (std::size_t i = 0; i < data.internalShapeTriangles.size(); ++i) {
+        const std::vector<unsigned int>& ids = data.internalShapeTriangles[i];
+        for (std::size_t j = 0; j + 2 < ids.size(); j += 3) {
+            appendTriangle(vertices[ids[j]], 1., vertices[ids[j + 1]], 1., vertices[ids[j + 2]], 1., triangles);
+        }
+    }
+    for (std::size_t i = 0; i < data.internalShapeTriangleFans.size(); ++i) {
+        const std::vector<unsigned int>& ids = data.internalShapeTriangleFans[i];
+        for (std::size_t j = 1; j + 1 < ids.size(); ++j) {
+            appendTriangle(vertices[ids[0]], 1., vertices[ids[j]], 1., vertices[ids[j + 1]], 1., triangles);
+        }
+    }
+    for (std::size_t i = 0; i < data.internalShapeTriangleStrips.size(); ++i) {
+        const std::vector<unsigned int>& ids = data.internalShapeTriangleStrips[i];
+        for (std::size_t j = 0; j + 2 < ids.size(); ++j) {
+            appendTriangle(vertices[ids[j]], 1., vertices[ids[j + 1]], 1., vertices[ids[j + 2]], 1., triangles);
+        }
+    }
+} // appendPolygonTriangles
+
+/**
+ * @brief Shades the pixels [x1, x2) of a scan-line of a feather triangle, t being the ramp parameter at the center of x1.
+ * Same as the rotoRamp_FragmentShader, without branches in the loop so that it can be vectorized.
+ **/
+template <RampTypeEnum rampType, bool applyFallOff>
+void
+shadeFeatherSpan(float* pixels,
+                 int x1,
+                 int x2,
+                 double t,
+                 double dt,
+                 float fallOff)
+{
+    for (int x = x1; x < x2; ++x, t += dt) {
+        float v = (float)std::max( 0., std::min(t, 1.) );
+        switch (rampType) {
+        case eRampTypeLinear:
+            break;
+        case eRampTypePLinear:
+            v = v * v * v;
+            break;
+        case eRampTypeEaseIn:
+            v = v * v * (2.f - v);
+            break;
+        case eRampTypeEaseOut:
+            v = v * (1.f + v * (1.f - v));
+            break;
+        case eRampTypeSmooth:
+            v = v * v * (3.f - 2.f * v);
+            break;
+        }
+        if (applyFallOff) {
+            v = std::pow(v, fallOff);
+        }
+        pixels[x] = std::max(pixels[x], v);
+    }
+}
+
+template <RampTypeEnum rampType>
+void
+shadeFeatherSpanForRamp(float* pixels,
+                        int x1,
+                        int x2,
+                        double t,
+                        double dt,
+                        float fallOff)
+{
+    if (fallOff == 1.f) {
+        shadeFeatherSpan<rampType, false>(pixels, x1, x2, t, dt, fallOff);
+    } else {
+        shadeFeatherSpan<rampType, true>(pixels, x1, x2, t, dt, fallOff);
+    }
+}
+
+/**
+ * @brief Rasterizes the triangles of a motion blur sample into a coverage buffer the size of the render window,
+ * then accumulates the coverage of the sample and writes the image after the last sample.
+ **/
+class RotoScanlineRasterizer
+    : public ImageMultiThreadProcessorBase
+{
+    const std::vector<RasterTriangle>* _triangles;
+
+    // For each bin of NATRON_ROTO_CPU_BIN_HEIGHT scan-lines of the render window, the triangles overlapping it
+    const std::vector<std::vector<int> >* _bins;
+    RectI _roi;
+    float* _coverage;
+
+    // The sum of the coverage of the previous samples, or NULL without motion blur
+    float* _accum;
+    RampTypeEnum _rampType;
+    float _fallOff;
+
+    // The sum of the opacities of the motion blur samples with this coverage
+    float _opacity;
+    bool _isFirstSample, _isLastSample;
+    int _nDivisions;
+    Image::CPUData _dstData;
+
+public:
+
+    RotoScanlineRasterizer(const EffectInstancePtr& effect)
+        : ImageMultiThreadProcessorBase(effect)
+        , _triangles(0)
+        , _bins(0)
+        , _roi()
+        , _coverage(0)
+        , _accum(0)
+        , _rampType(eRampTypeLinear)
+        , _fallOff(1.f)
+        , _opacity(1.f)
+        , _isFirstSample(true)
+        , _isLastSample(true)
+        , _nDivisions(1)
+        , _dstData()
+    {
+    }
+
+    virtual ~RotoScanlineRasterizer()
+    {
+    }
+
+    void setValues(const std::vector<RasterTriangle>* triangles,
+                   const std::vector<std::vector<int> >* bins,
+                   const RectI& roi,
+                   float* coverage,
+                   float* accum,
+                   RampTypeEnum rampType,
+                   double fallOff,
+                   double opacity,
+                   bool isFirstSample,
+                   bool isLastSample,
+                   int nDivisions,
+                   const Image::CPUData& dstData)
+    {
+        _triangles = triangles;
+        _bins = bins;
+        _roi = roi;
+        _coverage = coverage;
+        _accum = accum;
+        _rampType = rampType;
+        _fallOff = (float)fallOff;
+        _opacity = (float)opacity;
+        _isFirstSample = isFirstSample;
+        _isLastSample = isLastSample;
+        _nDivisions = nDivisions;
+        _dstData = dstData;
+    }
+
+private:
+
+    void rasterizeTriangle(const RasterTriangle& tri,
+                           int y1,
+                           int y2)
+    {
+        const int width = _roi.width();
+
+        for (int y = std::max(y1, tri.y1); y < std::min(y2, tri.y2); ++y) {
+            const double py = y + 0.5;
+
+            // Intersect the scan-line with the edges. The lower end of an edge is included, not the upper one,
+            // so that a vertex on the scan-line is counted once.
+            double xs[2];
+            int nxs = 0;
+            for (int e = 0; e < 3 && nxs < 2; ++e) {
+                const Point& p0 = tri.p[e];
+                const Point& p1 = tri.p[(e + 1) % 3];
+                if ( ( (p0.y <= py) && (p1.y > py) ) || ( (p1.y <= py) && (p0.y > py) ) ) {
+                    xs[nxs++] = p0.x + (py - p0.y) * (p1.x - p0.x) / (p1.y - p0.y);
+                }
+            }
+            if (nxs < 2) {
+                continue;
+            }
+
+            // The pixels whose center is inside the span
+            int x1 = (int)std::ceil(std::min(xs[0], xs[1]) - 0.5);
+            int x2 = (int)std::floor(std::max(xs[0], xs[1]) - 0.5) + 1;
+            x1 = std::max(x1, _roi.x1);
+            x2 = std::min(x2, _roi.x2);
+            if (x1 >= x2) {
+                continue;
+            }
+
+            float* row = _coverage + (std::size_t)(y - _roi.y1) * width;
+            int rx1 = x1 - _roi.x1;
+            int rx2 = x2 - _roi.x1;
+            if (tri.isSolid) {
+                std::fill(row + rx1, row + rx2, 1.f);
+                continue;
+            }
+            double t = tri.tx * (x1 + 0.5) + tri.ty * py + tri.t0;
+            switch (_rampType) {
+            case eRampTypeLinear:
+                shadeFeatherSpanForRamp<eRampTypeLinear>(row, rx1, rx2, t, tri.tx, _fallOff);
+                break;
+            case eRampTypePLinear:
+                shadeFeatherSpanForRamp<eRampTypePLinear>(row, rx1, rx2, t, tri.tx, _fallOff);
+                break;
+            case eRampTypeEaseIn:
+                shadeFeatherSpanForRamp<eRampTypeEaseIn>(row, rx1, rx2, t, tri.tx, _fallOff);
+                break;
+            case eRampTypeEaseOut:
+                shadeFeatherSpanForRamp<eRampTypeEaseOut>(row, rx1, rx2, t, tri.tx, _fallOff);
+                break;
+            case eRampTypeSmooth:
+                shadeFeatherSpanForRamp<eRampTypeSmooth>(row, rx1, rx2, t, tri.tx, _fallOff);
+                break;
+            }
+        } // for each scan-line
+    } // rasterizeTriangle
+
+    void writeScanLine(int y)
+    {
+        const int width = _roi.width();
+        const float* cov = _coverage + (std::size_t)(y - _roi.y1) * width;
+        float* accum = _accum ? _accum + (std::size_t)(y - _roi.y1) * width : 0;
+
+        if (accum) {
+            // Motion blur: average the samples
+            if (_isFirstSample) {
+                for (int x = 0; x < width; ++x) {
+                    accum[x] = cov[x] * _opacity;
+                }
+            } else {
+                for (int x = 0; x < width; ++x) {
+                    accum[x] += cov[x] * _opacity;
+                }
+            }
+            if (!_isLastSample) {
+                return;
+            }
+        }
+
+        float* dstPixels[4];
+        int dstPixelStride;
+        Image::getChannelPointers<float>( (const float**)_dstData.ptrs, _roi.x1, y, _dstData.bounds, _dstData.nComps, dstPixels, &dstPixelStride );
+        const float scale = accum ? 1.f / _nDivisions : _opacity;
+        const float* src = accum ? accum : cov;
+        for (int c = 0; c < _dstData.nComps; ++c) {
+            float* dst = dstPixels[c];
+            if (!dst) {
+                continue;
+            }
+            for (int x = 0; x < width; ++x, dst += dstPixelStride) {
+                *dst = src[x] * scale;
+            }
+        }
+    } // writeScanLine
+
+    virtual ActionRetCodeEnum multiThreadProcessImages(const RectI& renderWindow) OVERRIDE FINAL
+    {
+        const int width = _roi.width();
+
+        std::fill(_coverage + (std::size_t)(renderWindow.y1 - _roi.y1) * width, _coverage + (std::size_t)(renderWindow.y2 - _roi.y1) * width, 0.f);
+
+        int firstBin = (renderWindow.y1 - _roi.y1) / NATRON_ROTO_CPU_BIN_HEIGHT;
+        int lastBin = (renderWindow.y2 - 1 - _roi.y1) / NATRON_ROTO_CPU_BIN_HEIGHT;
+        for (int b = firstBin; b <= lastBin; ++b) {
+            int binY1 = std::max(_roi.y1 + b * NATRON_ROTO_CPU_BIN_HEIGHT, renderWindow.y1);
+            int binY2 = std::min(_roi.y1 + (b + 1) * NATRON_ROTO_CPU_BIN_HEIGHT, renderWindow.y2);
+            const std::vector<int>& binTriangles = (*_bins)[b];
+            for (std::size_t i = 0; i < binTriangles.size(); ++i) {
+                rasterizeTriangle( (*_triangles)[binTriangles[i]], binY1, binY2 );
+            }
+        }
+
+        for (int y = renderWindow.y1; y < renderWindow.y2; ++y) {
+            writeScanLine(y);
+        }
+
+        if ( _effect && _effect->isRenderAborted() ) {
+            return eActionStatusAborted;
+        }
+
+        return eActionStatusOK;
+    } // multiThreadProcessImages
+};
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT;
+
+
+ActionRetCodeEnum
+RotoShapeRenderCPU::renderBezier_cpu(const EffectInstancePtr& effect,
+                                     const BezierPtr& bezier,
+                                     const RectI& roi,
+                                     TimeValue time,
+                                     ViewIdx view,
+                                     const RangeD& shutterRange,
+                                     int nDivisions,
+                                     const RenderScale& scale,
+                                     const ImagePtr& dstImage)
+{
+    if ( roi.isNull() || (nDivisions <= 0) ) {
+        return eActionStatusOK;
+    }
+
+    Image::CPUData dstData;
+    dstImage->getCPUData(&dstData);
+    assert(dstData.bitDepth == eImageBitDepthFloat);
+    assert( dstData.bounds.contains(roi) );
+
+    RampTypeEnum rampType = (RampTypeEnum)bezier->getFallOffRampTypeKnob()->getValue();
+
+    double interval = nDivisions >= 1 ? (shutterRange.max - shutterRange.min) / nDivisions : 1.;
+    std::vector<TimeValue> sampleTimes(nDivisions);
+    for (int d = 0; d < nDivisions; ++d) {
+        sampleTimes[d] = nDivisions > 1 ? TimeValue(shutterRange.min + d * interval) : time;
+    }
+
+    // Evaluate the opacity of all motion blur samples at once
+    std::vector<double> sampleOpacities;
+    bezier->getOpacityKnob()->getValuesAtTimes(sampleTimes, DimIdx(0), view, true /*clamp*/, &sampleOpacities);
+
+    const std::size_t nPixels = (std::size_t)roi.width() * roi.height();
+    std::vector<float> coverage(nPixels);
+    std::vector<float> accum;
+    if (nDivisions > 1) {
+        accum.resize(nPixels);
+    }
+
+    const int nBins = (roi.height() + NATRON_ROTO_CPU_BIN_HEIGHT - 1) / NATRON_ROTO_CPU_BIN_HEIGHT;
+    std::vector<RasterTriangle> triangles;
+    std::vector<std::vector<int> > bins(nBins);
+
+    // Consecutive samples where the shape does not change have the same coverage: it is rasterized once
+    std::vector<U64> sampleHashes(nDivisions);
+    {
+        HashableObject::ComputeHashArgs hashArgs;
+        hashArgs.view = view;
+        hashArgs.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+        for (int d = 0; d < nDivisions; ++d) {
+            hashArgs.time = sampleTimes[d];
+            sampleHashes[d] = bezier->computeHash(hashArgs);
+        }
+    }
+
+    for (int d = 0; d < nDivisions;) {
+        const TimeValue t = sampleTimes[d];
+
+        int nextSample = d + 1;
+        double opacity = sampleOpacities[d];
+        while ( nextSample < nDivisions && (sampleHashes[nextSample] == sampleHashes[d]) ) {
+            opacity += sampleOpacities[nextSample];
+            ++nextSample;
+        }
+
+        double fallOff = bezier->getFeatherFallOffKnob()->getValueAtTime(t, DimIdx(0), view);
+
+        // Compute the feather triangles as well as the internal shape triangles.
+        RotoBezierTriangulation::PolygonData data;
+        RotoBezierTriangulation::tesselate(bezier, t, view, scale, &data);
+
+        triangles.clear();
+        appendPolygonTriangles(data, &triangles);
+
+        // Sort the triangles by bins of scan-lines
+        for (int b = 0; b < nBins; ++b) {
+            bins[b].clear();
+        }
+        for (std::size_t i = 0; i < triangles.size(); ++i) {
+            int y1 = std::max(triangles[i].y1, roi.y1);
+            int y2 = std::min(triangles[i].y2, roi.y2);
+            if (y1 >= y2) {
+                continue;
+            }
+            int lastBin = (y2 - 1 - roi.y1) / NATRON_ROTO_CPU_BIN_HEIGHT;
+            for (int b = (y1 - roi.y1) / NATRON_ROTO_CPU_BIN_HEIGHT; b <= lastBin; ++b) {
+                bins[b].push_back( (int)i );
+            }
+        }
+
+        RotoScanlineRasterizer processor(effect);
+        processor.setValues(&triangles, &bins, roi, &coverage[0], accum.empty() ? 0 : &accum[0], rampType, fallOff, opacity, d == 0, nextSample == nDivisions, nDivisions, dstData);
+        processor.setRenderWindow(roi);
+        ActionRetCodeEnum stat = processor.process();
+        if ( isFailureRetCode(stat) ) {
+            return stat;
+        }
+        d = nextSample;
+    } // for all divisions
+
+    return eActionStatusOK;
+} // renderBezier_cpu
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,64 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef ROTOSHAPERENDERCPU_H
+#define ROTOSHAPERENDERCPU_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include "Global/GlobalDefines.h"
+#include "Engine/TimeValue.h"
+#include "Engine/ViewIdx.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Renders closed Beziers on CPU without Cairo nor OSMesa: the triangles computed by RotoBezierTriangulation
+ * are rasterized by scan-lines, the render window being split by bands of scan-lines rendered concurrently.
+ * The result matches the OpenGL renderer: pixels are sampled at their center, the feather mesh is shaded with
+ * the fall-off ramp of the Bezier and overlapping triangles are combined with a max.
+ **/
+class RotoShapeRenderCPU
+{
+public:
+
+    /**
+     * @brief Renders the given bezier with motion blur onto dstImage, which must be a float CPU image containing roi.
+     **/
+    static ActionRetCodeEnum renderBezier_cpu(const EffectInstancePtr& effect,
+                                              const BezierPtr& bezier,
+                                              const RectI& roi,
+                                              TimeValue time,
+                                              ViewIdx view,
+                                              const RangeD& shutterRange,
+                                              int nDivisions,
+                                              const RenderScale& scale,
+                                              const ImagePtr& dstImage);
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // ROTOSHAPERENDERCPU_H
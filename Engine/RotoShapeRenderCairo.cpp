@@ -1826,9 +1826,18 @@ RotoShapeRenderCairo::renderMaskInternal_cairo(const RotoDrawableItemPtr& rotoIt
     assert(rotoItem->isActivated(time, view));
 
     double interval = nDivisions >= 1 ? (shutterRange.max - shutterRange.min) / nDivisions : 1.;
+    std::vector<TimeValue> sampleTimes(std::max(nDivisions, 0));
+    for (int d = 0; d < nDivisions; ++d) {
+        sampleTimes[d] = nDivisions > 1 ? TimeValue(shutterRange.min + d * interval) : time;
+    }
+
+    // Evaluate the opacity of all motion blur samples at once
+    std::vector<double> sampleOpacities;
+    rotoItem->getOpacityKnob()->getValuesAtTimes(sampleTimes, DimIdx(0), view, true /*clamp*/, &sampleOpacities);
+
     for (int d = 0; d < nDivisions; ++d) {
 
-        const TimeValue t = nDivisions > 1 ? TimeValue(shutterRange.min + d * interval) : time;
+        const TimeValue t = sampleTimes[d];
 
         std::list<std::list<std::pair<Point, double> > > strokes;
         if (isStroke) {
@@ -1856,7 +1865,7 @@ RotoShapeRenderCairo::renderMaskInternal_cairo(const RotoDrawableItemPtr& rotoIt
         }
 
 
-        double opacity = rotoItem->getOpacityKnob()->getValueAtTime(t, DimIdx(0), view);
+        double opacity = sampleOpacities[d];
 
         Image::CPUData imageData;
         dstImage->getCPUData(&imageData);
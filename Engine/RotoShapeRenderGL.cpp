@@ -194,8 +194,9 @@ static const char* rotoSmearDot_FragmentShader =
 "}"
 ;
 
-RotoShapeRenderNodeOpenGLData::RotoShapeRenderNodeOpenGLData(bool isGPUContext)
-: EffectOpenGLContextData(isGPUContext)
+RotoShapeRenderNodeOpenGLData::RotoShapeRenderNodeOpenGLData(const OSGLContextPtr& glContext)
+: EffectOpenGLContextData(glContext->isGPUContext())
+, _glContext(glContext)
 , _iboID(0)
 , _vboVerticesID(0)
 , _vboColorsID(0)
@@ -253,6 +254,25 @@ RotoShapeRenderNodeOpenGLData::~RotoShapeRenderNodeOpenGLData()
 
 }
 
+GLShaderBasePtr
+RotoShapeRenderNodeOpenGLData::getSharedShader(const std::string& name) const
+{
+    OSGLContextPtr glContext = _glContext.lock();
+    if (!glContext) {
+        return GLShaderBasePtr();
+    }
+    return glContext->getSharedShader(name);
+}
+
+void
+RotoShapeRenderNodeOpenGLData::setSharedShader(const std::string& name, const GLShaderBasePtr& shader)
+{
+    OSGLContextPtr glContext = _glContext.lock();
+    if (glContext) {
+        glContext->setSharedShader(name, shader);
+    }
+}
+
 
 unsigned int
 RotoShapeRenderNodeOpenGLData::getOrCreateIBOID()
@@ -383,10 +403,15 @@ RotoShapeRenderNodeOpenGLData::getOrCreateFeatherRampShader(RampTypeEnum type)
     if (_featherRampShader[type_i]) {
         return _featherRampShader[type_i];
     }
-    if (isGPUContext()) {
-        _featherRampShader[type_i] = getOrCreateFeatherRampShaderInternal<GL_GPU>(type);
-    } else {
-        _featherRampShader[type_i] = getOrCreateFeatherRampShaderInternal<GL_CPU>(type);
+    std::string name = "RotoFeatherRamp" + std::string(1, (char)('0' + type_i));
+    _featherRampShader[type_i] = getSharedShader(name);
+    if (!_featherRampShader[type_i]) {
+        if (isGPUContext()) {
+            _featherRampShader[type_i] = getOrCreateFeatherRampShaderInternal<GL_GPU>(type);
+        } else {
+            _featherRampShader[type_i] = getOrCreateFeatherRampShaderInternal<GL_CPU>(type);
+        }
+        setSharedShader(name, _featherRampShader[type_i]);
     }
 
     return _featherRampShader[type_i];
@@ -450,10 +475,15 @@ RotoShapeRenderNodeOpenGLData::getOrCreateStrokeDotShader(bool buildUp)
     if (_strokeDotShader[index]) {
         return _strokeDotShader[index];
     }
-    if (isGPUContext()) {
-        _strokeDotShader[index] = getOrCreateStrokeDotShaderInternal<GL_GPU>(buildUp);
-    } else {
-        _strokeDotShader[index] = getOrCreateStrokeDotShaderInternal<GL_CPU>(buildUp);
+    std::string name = buildUp ? "RotoStrokeDotBuildUp" : "RotoStrokeDot";
+    _strokeDotShader[index] = getSharedShader(name);
+    if (!_strokeDotShader[index]) {
+        if (isGPUContext()) {
+            _strokeDotShader[index] = getOrCreateStrokeDotShaderInternal<GL_GPU>(buildUp);
+        } else {
+            _strokeDotShader[index] = getOrCreateStrokeDotShaderInternal<GL_CPU>(buildUp);
+        }
+        setSharedShader(name, _strokeDotShader[index]);
     }
 
     return _strokeDotShader[index];
@@ -530,10 +560,14 @@ RotoShapeRenderNodeOpenGLData::getOrCreateAccumulateShader()
     if (_accumShader) {
         return _accumShader;
     }
-    if (isGPUContext()) {
-        _accumShader = getOrCreateAccumShaderInternal<GL_GPU>();
-    } else {
-        _accumShader = getOrCreateAccumShaderInternal<GL_CPU>();
+    _accumShader = getSharedShader("RotoAccumulate");
+    if (!_accumShader) {
+        if (isGPUContext()) {
+            _accumShader = getOrCreateAccumShaderInternal<GL_GPU>();
+        } else {
+            _accumShader = getOrCreateAccumShaderInternal<GL_CPU>();
+        }
+        setSharedShader("RotoAccumulate", _accumShader);
     }
     return _accumShader;
 }
@@ -544,10 +578,14 @@ RotoShapeRenderNodeOpenGLData::getOrCreateDivideShader()
     if (_divideShader) {
         return _divideShader;
     }
-    if (isGPUContext()) {
-        _divideShader = getOrCreateDivideShaderInternal<GL_GPU>();
-    } else {
-        _divideShader = getOrCreateDivideShaderInternal<GL_CPU>();
+    _divideShader = getSharedShader("RotoDivide");
+    if (!_divideShader) {
+        if (isGPUContext()) {
+            _divideShader = getOrCreateDivideShaderInternal<GL_GPU>();
+        } else {
+            _divideShader = getOrCreateDivideShaderInternal<GL_CPU>();
+        }
+        setSharedShader("RotoDivide", _divideShader);
     }
     return _divideShader;
 }
@@ -592,10 +630,14 @@ RotoShapeRenderNodeOpenGLData::getOrCreateStrokeSecondPassShader()
     if (_strokeDotSecondPassShader) {
         return _strokeDotSecondPassShader;
     }
-    if (isGPUContext()) {
-        _strokeDotSecondPassShader = getOrCreateStrokeSecondPassShaderInternal<GL_GPU>();
-    } else {
-        _strokeDotSecondPassShader = getOrCreateStrokeSecondPassShaderInternal<GL_CPU>();
+    _strokeDotSecondPassShader = getSharedShader("RotoStrokeDotSecondPass");
+    if (!_strokeDotSecondPassShader) {
+        if (isGPUContext()) {
+            _strokeDotSecondPassShader = getOrCreateStrokeSecondPassShaderInternal<GL_GPU>();
+        } else {
+            _strokeDotSecondPassShader = getOrCreateStrokeSecondPassShaderInternal<GL_CPU>();
+        }
+        setSharedShader("RotoStrokeDotSecondPass", _strokeDotSecondPassShader);
     }
 
     return _strokeDotSecondPassShader;
@@ -655,10 +697,14 @@ RotoShapeRenderNodeOpenGLData::getOrCreateSmearShader()
     if (_smearShader) {
         return _smearShader;
     }
-    if (isGPUContext()) {
-        _smearShader = getOrCreateSmearShaderInternal<GL_GPU>();
-    } else {
-        _smearShader = getOrCreateSmearShaderInternal<GL_CPU>();
+    _smearShader = getSharedShader("RotoSmear");
+    if (!_smearShader) {
+        if (isGPUContext()) {
+            _smearShader = getOrCreateSmearShaderInternal<GL_GPU>();
+        } else {
+            _smearShader = getOrCreateSmearShaderInternal<GL_CPU>();
+        }
+        setSharedShader("RotoSmear", _smearShader);
     }
 
     return _smearShader;
@@ -1172,7 +1218,9 @@ struct RenderStrokeGLData
     RamBuffer<float> primitivesColors;
     RamBuffer<float> primitivesVertices;
     RamBuffer<float> primitivesHardness;
-    std::vector<boost::shared_ptr<RamBuffer<unsigned int> > > indicesBuf;
+
+    // The triangles of all dots of the stroke, so that they are all drawn with a single glDrawElements call
+    std::vector<unsigned int> indices;
 };
 
 static void toTexCoords(const RectI& texBounds, const float xi, const float yi, float* xo, float* yo)
@@ -1280,15 +1328,18 @@ getDotTriangleFan(const Point& center,
 static void renderDot_gl(RenderStrokeGLData& data, const Point &center, double radius_x, double radius_y, double opacity, double hardness)
 {
 
-    // Create the indices buffer for this triangle fan
+    // Append the triangles of this triangle fan: the center vertex comes first, followed by the nbPointsPerSegment + 1
+    // vertices on the outside of the dot
     {
-        boost::shared_ptr<RamBuffer<unsigned int> > vec(new RamBuffer<unsigned int>);
-        data.indicesBuf.push_back(vec);
-        unsigned int vSize = data.primitivesVertices.size() / 2;
-        vec->resize(data.nbPointsPerSegment + 2);
-        unsigned int* idxData = vec->getData();
-        for (std::size_t i = 0; i < vec->size(); ++i, ++vSize) {
-            idxData[i] = vSize;
+        unsigned int centerIndex = data.primitivesVertices.size() / 2;
+        std::size_t nTriangles = data.nbPointsPerSegment;
+        std::size_t idxSize = data.indices.size();
+        data.indices.resize(idxSize + nTriangles * 3);
+        unsigned int* idxData = &data.indices[idxSize];
+        for (std::size_t i = 0; i < nTriangles; ++i, idxData += 3) {
+            idxData[0] = centerIndex;
+            idxData[1] = centerIndex + 1 + i;
+            idxData[2] = centerIndex + 2 + i;
         }
     }
 
@@ -1348,25 +1399,25 @@ renderStrokeBegin_gl(RotoShapeRenderNodePrivate::RenderStrokeDataPtr userData,
 
 
 template <typename GL>
-void renderStroke_gl_multiDrawElements(int nbVertices,
-                                       int vboVerticesID,
-                                       int vboColorsID,
-                                       int vboHardnessID,
-                                       const OSGLContextPtr& glContext,
-                                       const GLShaderBasePtr& strokeShader,
-                                       const GLShaderBasePtr& strokeSecondPassShader,
-                                       bool doBuildUp,
-                                       double opacity,
-                                       const RectI& roi,
-                                       const ImagePtr& dstImage,
-                                       bool dstImageIsFinalTexture, // < when doing motion-blur this is false
-                                       unsigned int primitiveType,
-                                       const void* verticesData,
-                                       const void* colorsData,
-                                       const void* hardnessData,
-                                       const int* perDrawCount,
-                                       const void** perDrawIdsPtr,
-                                       int drawCount)
+void renderStroke_gl_drawElements(int nbVertices,
+                                  int nbIds,
+                                  int vboVerticesID,
+                                  int vboColorsID,
+                                  int vboHardnessID,
+                                  int iboID,
+                                  const OSGLContextPtr& glContext,
+                                  const GLShaderBasePtr& strokeShader,
+                                  const GLShaderBasePtr& strokeSecondPassShader,
+                                  bool doBuildUp,
+                                  double opacity,
+                                  const RectI& roi,
+                                  const ImagePtr& dstImage,
+                                  bool dstImageIsFinalTexture, // < when doing motion-blur this is false
+                                  unsigned int primitiveType,
+                                  const void* verticesData,
+                                  const void* colorsData,
+                                  const void* hardnessData,
+                                  const void* idsData)
 {
 
     glCheckError(GL);
@@ -1514,7 +1565,10 @@ void renderStroke_gl_multiDrawElements(int nbVertices,
     GL::ColorPointer(4, GL_FLOAT, 0, 0);
 
 
-    GL::MultiDrawElements(primitiveType, perDrawCount, GL_UNSIGNED_INT, perDrawIdsPtr, drawCount);
+    GL::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID);
+    GL::BufferData(GL_ELEMENT_ARRAY_BUFFER, nbIds * sizeof(GLuint), idsData, GL_DYNAMIC_DRAW);
+
+    GL::DrawElements(primitiveType, nbIds, GL_UNSIGNED_INT, 0);
 
     GL::DisableClientState(GL_COLOR_ARRAY);
     GL::BindBuffer(GL_ARRAY_BUFFER, 0);
@@ -1526,10 +1580,10 @@ void renderStroke_gl_multiDrawElements(int nbVertices,
     const float* vptr = (const float*)verticesData;
     const float* cptr = (const float*)colorsData;
     const float* hptr = (const float*)hardnessData;
-    for (int c = 0; c < drawCount; ++c) {
+    {
         GL::Begin(primitiveType);
-        const unsigned int* iptr = (const unsigned int*)perDrawIdsPtr[c];
-        for (int i = 0; i < perDrawCount[c]; ++i, ++iptr) {
+        const unsigned int* iptr = (const unsigned int*)idsData;
+        for (int i = 0; i < nbIds; ++i, ++iptr) {
             int vindex = *iptr;
             double hardness = hptr[vindex];
             double a = cptr[vindex];
@@ -1600,7 +1654,7 @@ void renderStroke_gl_multiDrawElements(int nbVertices,
     }
     GL::BindTexture( target, 0);
 
-} // void renderStroke_gl_multiDrawElements
+} // void renderStroke_gl_drawElements
 
 
 static void
@@ -1612,61 +1666,59 @@ renderStrokeEnd_gl(RotoShapeRenderNodePrivate::RenderStrokeDataPtr userData)
     int vboColorsID = myData->glData->getOrCreateVBOColorsID();
     int vboVerticesID = myData->glData->getOrCreateVBOVerticesID();
     int vboHardnessID = myData->glData->getOrCreateVBOHardnessID();
+    int iboID = myData->glData->getOrCreateIBOID();
     bool dstImageIsFinalTexture = myData->dstImageIsFinalTexture;
     GLShaderBasePtr strokeShader = myData->glData->getOrCreateStrokeDotShader(myData->buildUp);
     GLShaderBasePtr buildUpPassShader = myData->glData->getOrCreateStrokeSecondPassShader();
 
-    std::vector<const void*> indicesVec(myData->indicesBuf.size());
-    std::vector<int> perDrawCount(myData->indicesBuf.size());
-    for (std::size_t i = 0; i < myData->indicesBuf.size(); ++i) {
-        indicesVec[i] = (const void*)myData->indicesBuf[i]->getData();
-        assert((int)myData->indicesBuf[i]->size() == (myData->nbPointsPerSegment + 2));
-        perDrawCount[i] = myData->indicesBuf[i]->size();
+    int nbIds = (int)myData->indices.size();
+    if (nbIds == 0) {
+        return;
     }
 
     if (myData->glContext->isGPUContext()) {
 
-        renderStroke_gl_multiDrawElements<GL_GPU>(nbVertices,
-                                                  vboVerticesID,
-                                                  vboColorsID,
-                                                  vboHardnessID,
-                                                  myData->glContext,
-                                                  strokeShader,
-                                                  buildUpPassShader,
-                                                  myData->buildUp,
-                                                  myData->opacity,
-                                                  myData->roi,
-                                                  myData->dstImage,
-                                                  dstImageIsFinalTexture,
-                                                  GL_TRIANGLE_FAN,
-                                                  (const void*)(myData->primitivesVertices.getData()),
-                                                  (const void*)(myData->primitivesColors.getData()),
-                                                  (const void*)(myData->primitivesHardness.getData()),
-                                                  (const int*)(&perDrawCount[0]),
-                                                  (const void**)(&indicesVec[0]),
-                                                  indicesVec.size());
+        renderStroke_gl_drawElements<GL_GPU>(nbVertices,
+                                             nbIds,
+                                             vboVerticesID,
+                                             vboColorsID,
+                                             vboHardnessID,
+                                             iboID,
+                                             myData->glContext,
+                                             strokeShader,
+                                             buildUpPassShader,
+                                             myData->buildUp,
+                                             myData->opacity,
+                                             myData->roi,
+                                             myData->dstImage,
+                                             dstImageIsFinalTexture,
+                                             GL_TRIANGLES,
+                                             (const void*)(myData->primitivesVertices.getData()),
+                                             (const void*)(myData->primitivesColors.getData()),
+                                             (const void*)(myData->primitivesHardness.getData()),
+                                             (const void*)(&myData->indices[0]));
 
 
     } else {
-        renderStroke_gl_multiDrawElements<GL_CPU>(nbVertices,
-                                                  vboVerticesID,
-                                                  vboColorsID,
-                                                  vboHardnessID,
-                                                  myData->glContext,
-                                                  strokeShader,
-                                                  buildUpPassShader,
-                                                  myData->buildUp,
-                                                  myData->opacity,
-                                                  myData->roi,
-                                                  myData->dstImage,
-                                                  dstImageIsFinalTexture,
-                                                  GL_TRIANGLE_FAN,
-                                                  (const void*)(myData->primitivesVertices.getData()),
-                                                  (const void*)(myData->primitivesColors.getData()),
-                                                  (const void*)(myData->primitivesHardness.getData()),
-                                                  (const int*)(&perDrawCount[0]),
-                                                  (const void**)(&indicesVec[0]),
-                                                  indicesVec.size());
+        renderStroke_gl_drawElements<GL_CPU>(nbVertices,
+                                             nbIds,
+                                             vboVerticesID,
+                                             vboColorsID,
+                                             vboHardnessID,
+                                             iboID,
+                                             myData->glContext,
+                                             strokeShader,
+                                             buildUpPassShader,
+                                             myData->buildUp,
+                                             myData->opacity,
+                                             myData->roi,
+                                             myData->dstImage,
+                                             dstImageIsFinalTexture,
+                                             GL_TRIANGLES,
+                                             (const void*)(myData->primitivesVertices.getData()),
+                                             (const void*)(myData->primitivesColors.getData()),
+                                             (const void*)(myData->primitivesHardness.getData()),
+                                             (const void*)(&myData->indices[0]));
 
     }
 }
@@ -28,6 +28,7 @@
 #include "Global/Macros.h"
 
 #include <list>
+#include <string>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
@@ -74,6 +75,7 @@ enum RampTypeEnum
 
 class RotoShapeRenderNodeOpenGLData : public EffectOpenGLContextData
 {
+    OSGLContextWPtr _glContext;
     unsigned int _iboID;
     unsigned int _vboVerticesID;
     unsigned int _vboColorsID;
@@ -91,7 +93,7 @@ public:
 
     void cleanup();
 
-    RotoShapeRenderNodeOpenGLData(bool isGPUContext);
+    RotoShapeRenderNodeOpenGLData(const OSGLContextPtr& glContext);
 
     unsigned int getOrCreateIBOID();
 
@@ -116,6 +118,13 @@ public:
     GLShaderBasePtr getOrCreateSmearShader();
 
     virtual ~RotoShapeRenderNodeOpenGLData();
+
+private:
+
+    // The shaders are shared with all other nodes rendering with the same context so that they are compiled only once per context
+    GLShaderBasePtr getSharedShader(const std::string& name) const;
+
+    void setSharedShader(const std::string& name, const GLShaderBasePtr& shader);
     
 };
 
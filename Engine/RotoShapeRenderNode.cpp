@@ -24,6 +24,10 @@
 
 #include "RotoShapeRenderNode.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include <QDebug>
 #include <QThread>
 
@@ -41,6 +45,7 @@
 #include "Engine/RotoStrokeItem.h"
 #include "Engine/RotoShapeRenderNodePrivate.h"
 #include "Engine/RotoShapeRenderCairo.h"
+#include "Engine/RotoShapeRenderCPU.h"
 #include "Engine/RotoShapeRenderGL.h"
 #include "Engine/RotoPaint.h"
 
@@ -48,6 +53,9 @@
 //#define ROTO_SHAPE_RENDER_CPU_USES_CAIRO
 #endif
 
+// Distance in pixels under which the points of a shape may move between 2 motion blur samples without visible difference
+#define NATRON_ROTO_MOTION_BLUR_SAMPLE_DISTANCE_PX 1.
+
 NATRON_NAMESPACE_ENTER;
 
 enum RotoShapeRenderTypeEnum
@@ -56,6 +64,116 @@ enum RotoShapeRenderTypeEnum
     eRotoShapeRenderTypeSmear
 };
 
+/**
+ * @brief Returns true if the item is rendered with RotoShapeRenderCPU when rendering on CPU
+ **/
+static bool
+isScanlineRendererEnabled(const RotoDrawableItemPtr& item)
+{
+    BezierPtr isBezier = toBezier(item);
+    if ( !isBezier || isBezier->isOpenBezier() ) {
+        return false;
+    }
+    KnobItemsTablePtr model = item->getModel();
+    if (!model) {
+        return false;
+    }
+    RotoPaintPtr rotoPaintNode = toRotoPaint( model->getNode()->getEffectInstance() );
+    if (!rotoPaintNode) {
+        return false;
+    }
+    KnobChoicePtr rendererKnob = rotoPaintNode->getCPURendererKnob();
+
+    return rendererKnob && ( (RotoCPURendererEnum)rendererKnob->getValue() == eRotoCPURendererScanline );
+}
+
+/**
+ * @brief Returns the number of motion blur samples needed to render the bezier, at most nDivisions.
+ * A shape that does not change during the shutter needs a single sample. Otherwise the samples are spaced
+ * so that no point of the shape moves more than NATRON_ROTO_MOTION_BLUR_SAMPLE_DISTANCE_PX between 2 samples.
+ **/
+static int
+getAdaptiveMotionBlurDivisions(const BezierPtr& bezier,
+                               TimeValue time,
+                               ViewIdx view,
+                               const RangeD& range,
+                               int nDivisions,
+                               const RenderScale& scale)
+{
+    if (nDivisions <= 1) {
+        return nDivisions;
+    }
+
+    const double interval = (range.max - range.min) / nDivisions;
+
+    // The hash covers the control points and all the parameters of the shape. The current time is compared too
+    // since the renderers evaluate the shape at the current time when there is a single sample.
+    {
+        HashableObject::ComputeHashArgs hashArgs;
+        hashArgs.time = time;
+        hashArgs.view = view;
+        hashArgs.hashType = HashableObject::eComputeHashTypeTimeViewVariant;
+        U64 currentTimeHash = bezier->computeHash(hashArgs);
+        bool isStatic = true;
+        for (int d = 0; d < nDivisions && isStatic; ++d) {
+            hashArgs.time = TimeValue(range.min + d * interval);
+            isStatic = bezier->computeHash(hashArgs) == currentTimeHash;
+        }
+        if (isStatic) {
+            return 1;
+        }
+    }
+
+    // Length of the path travelled by each control and feather point during the shutter
+    std::list<BezierCPPtr> points = bezier->getControlPoints(view);
+    {
+        std::list<BezierCPPtr> featherPoints = bezier->getFeatherPoints(view);
+        points.insert( points.end(), featherPoints.begin(), featherPoints.end() );
+    }
+    std::vector<double> pathLengths(points.size(), 0.);
+    std::vector<Point> prevPositions( points.size() );
+    double featherPathLength = 0.;
+    double prevFeather = 0.;
+    KnobDoublePtr featherKnob = bezier->getFeatherKnob();
+    for (int d = 0; d < nDivisions; ++d) {
+        TimeValue t(range.min + d * interval);
+        Transform::Matrix3x3 transform;
+        bezier->getTransformAtTime(t, view, &transform);
+
+        std::size_t i = 0;
+        for (std::list<BezierCPPtr>::const_iterator it = points.begin(); it != points.end(); ++it, ++i) {
+            Transform::Point3D p;
+            p.z = 1.;
+            (*it)->getPositionAtTime(t, &p.x, &p.y);
+            p = Transform::matApply(transform, p);
+            Point pos;
+            pos.x = p.x / p.z * scale.x;
+            pos.y = p.y / p.z * scale.y;
+            if (d > 0) {
+                pathLengths[i] += std::sqrt( (pos.x - prevPositions[i].x) * (pos.x - prevPositions[i].x) + (pos.y - prevPositions[i].y) * (pos.y - prevPositions[i].y) );
+            }
+            prevPositions[i] = pos;
+        }
+
+        // An animated feather distance moves the outter edge of the feather
+        double feather = featherKnob->getValueAtTime(t, DimIdx(0), view) * std::max(scale.x, scale.y);
+        if (d > 0) {
+            featherPathLength += std::abs(feather - prevFeather);
+        }
+        prevFeather = feather;
+    }
+
+    double maxPathLength = featherPathLength;
+    for (std::size_t i = 0; i < pathLengths.size(); ++i) {
+        maxPathLength = std::max(maxPathLength, pathLengths[i]);
+    }
+
+    // At least 2 samples since the shape changes during the shutter
+    int nSamples = (int)std::ceil(maxPathLength / NATRON_ROTO_MOTION_BLUR_SAMPLE_DISTANCE_PX) + 1;
+
+    return std::max( 2, std::min(nSamples, nDivisions) );
+} // getAdaptiveMotionBlurDivisions
+
 PluginPtr
 RotoShapeRenderNode::createPlugin()
 {
@@ -99,6 +217,11 @@ RotoShapeRenderNode::canCPUImplementationSupportOSMesa() const
 #ifdef ROTO_SHAPE_RENDER_CPU_USES_CAIRO
     return false;
 #else
+    // The scan-line renderer is a CPU implementation
+    RotoDrawableItemPtr item = getAttachedRotoItem();
+    if ( item && isScanlineRendererEnabled(item) ) {
+        return false;
+    }
     return true;
 #endif
 }
@@ -231,6 +354,12 @@ RotoShapeRenderNode::appendToHash(const ComputeHashArgs& args, Hash64* hash)
     if  (rotoPaintNode) {
         U64 sh = rotoPaintNode->getMotionBlurTypeKnob()->computeHash(args);
         hash->append(sh);
+
+        // Same for the CPU renderer, the renderers do not produce exactly the same image
+        KnobChoicePtr rendererKnob = rotoPaintNode->getCPURendererKnob();
+        if (rendererKnob) {
+            hash->append( rendererKnob->computeHash(args) );
+        }
     }
 
 
@@ -404,13 +533,25 @@ ActionRetCodeEnum
 RotoShapeRenderNode::render(const RenderActionArgs& args)
 {
 
+    // Get the Roto item attached to this node. It will be a render-local clone of the original item.
+    RotoDrawableItemPtr rotoItem = getAttachedRotoItem();
+    assert(rotoItem);
+    if (!rotoItem) {
+        return eActionStatusFailed;
+    }
+
+    // Closed beziers may be rendered on CPU with the scan-line renderer, which does not need Cairo nor OSMesa
+    const bool useScanlineRenderer = args.backendType == eRenderBackendTypeCPU && isScanlineRendererEnabled(rotoItem);
+
 #if !defined(ROTO_SHAPE_RENDER_CPU_USES_CAIRO) && !defined(HAVE_OSMESA)
-    getNode()->setPersistentMessage(eMessageTypeError, kNatronPersistentErrorGenericRenderMessage, tr("Roto requires either OSMesa (CONFIG += enable-osmesa) or Cairo (CONFIG += enable-cairo) in order to render on CPU").toStdString());
-    return eActionStatusFailed;
+    if (!useScanlineRenderer) {
+        getNode()->setPersistentMessage(eMessageTypeError, kNatronPersistentErrorGenericRenderMessage, tr("Roto requires either OSMesa (CONFIG += enable-osmesa) or Cairo (CONFIG += enable-cairo) in order to render on CPU").toStdString());
+        return eActionStatusFailed;
+    }
 #endif
 
 #if !defined(ROTO_SHAPE_RENDER_CPU_USES_CAIRO)
-    if (args.backendType == eRenderBackendTypeCPU) {
+    if (args.backendType == eRenderBackendTypeCPU && !useScanlineRenderer) {
         getNode()->setPersistentMessage(eMessageTypeError, kNatronPersistentErrorGenericRenderMessage, tr("An OpenGL context is required to draw with the Roto node. This might be because you are trying to render an image too big for OpenGL.").toStdString());
         return eActionStatusFailed;
     }
@@ -418,13 +559,6 @@ RotoShapeRenderNode::render(const RenderActionArgs& args)
 
     RenderScale combinedScale = EffectInstance::getCombinedScale(args.mipMapLevel, args.proxyScale);
 
-    // Get the Roto item attached to this node. It will be a render-local clone of the original item.
-    RotoDrawableItemPtr rotoItem = getAttachedRotoItem();
-    assert(rotoItem);
-    if (!rotoItem) {
-        return eActionStatusFailed;
-    }
-
     // To be thread-safe we can only operate on a render clone.
     assert(rotoItem->isRenderClone());
 
@@ -517,8 +651,17 @@ RotoShapeRenderNode::render(const RenderActionArgs& args)
                 // Do not use motion-blur when drawing.
                 range.min = range.max = args.time;
                 divisions = 1;
+            } else if (isBezier && !isBezier->isOpenBezier()) {
+                // Do not render more samples than what the motion of the shape requires
+                divisions = getAdaptiveMotionBlurDivisions(isBezier, args.time, args.view, range, divisions, combinedScale);
             }
 
+            if (useScanlineRenderer) {
+                ActionRetCodeEnum stat = RotoShapeRenderCPU::renderBezier_cpu(shared_from_this(), isBezier, args.roi, args.time, args.view, range, divisions, combinedScale, outputPlane.second);
+                if ( isFailureRetCode(stat) ) {
+                    return stat;
+                }
+            } else
 #ifdef ROTO_SHAPE_RENDER_CPU_USES_CAIRO
             // When cairo is enabled, render with it for a CPU render
             if (args.backendType == eRenderBackendTypeCPU) {
@@ -679,7 +822,7 @@ RotoShapeRenderNode::purgeCaches()
 ActionRetCodeEnum
 RotoShapeRenderNode::attachOpenGLContext(TimeValue /*time*/, ViewIdx /*view*/, const RenderScale& /*scale*/, const OSGLContextPtr& glContext, EffectOpenGLContextDataPtr* data)
 {
-    RotoShapeRenderNodeOpenGLDataPtr ret(new RotoShapeRenderNodeOpenGLData(glContext->isGPUContext()));
+    RotoShapeRenderNodeOpenGLDataPtr ret(new RotoShapeRenderNodeOpenGLData(glContext));
     *data = ret;
     return eActionStatusOK;
 }
@@ -116,6 +116,12 @@ private:
 
     virtual KnobHolderPtr createRenderCopy(const FrameViewRenderKey& key) const OVERRIDE FINAL;
 
+    virtual bool isRenderCloneReusable() const OVERRIDE FINAL
+    {
+        // The clone of the attached item is created for the render in fetchRenderCloneKnobs()
+        return false;
+    }
+
     virtual void fetchRenderCloneKnobs() OVERRIDE FINAL;
 
     virtual void initializeKnobs() OVERRIDE FINAL;
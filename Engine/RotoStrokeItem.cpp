@@ -46,6 +46,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/Bezier.h"
 #include "Engine/BezierCP.h"
 #include "Engine/CoonsRegularization.h"
+#include "Engine/EffectInstance.h"
 #include "Engine/FeatherPoint.h"
 #include "Engine/Format.h"
 #include "Engine/Hash64.h"
@@ -198,6 +199,11 @@ struct RotoStrokeItemPrivate
 
     RectD computeBoundingBox(TimeValue time, ViewIdx view) const;
 
+    /**
+     * @brief Same as computeBoundingBox() but only for the segment ending with the last point of the last sub-stroke
+     **/
+    RectD computeLastSegmentBoundingBox(TimeValue time, ViewIdx view) const;
+
     U64 computeHashFromStrokes();
 
 };
@@ -860,7 +866,24 @@ RotoStrokeItem::appendPoint(const RotoPoint& p)
 
     } // QMutexLocker k(&itemMutex);
 
-    invalidateCacheHashAndEvaluate(true, false);
+    if ( isEvaluationBlocked() ) {
+        return;
+    }
+    {
+        // Only the pixels around the new segment change: the tiles of the images rendered before outside of it are re-used
+        EffectInstancePtr effect = getHolderEffect();
+        TimeValue time = getCurrentRenderTime();
+        EffectInstance::DirtyRegionChange_RAII dirtyRegion(effect, time);
+        if (effect) {
+            QMutexLocker k(&_imp->lock);
+            int nViews = effect->getRenderViewsCount();
+            for (int v = 0; v < nViews; ++v) {
+                dirtyRegion.addDirtyRegion( _imp->computeLastSegmentBoundingBox( time, ViewIdx(v) ) );
+            }
+        }
+        invalidateHashCache();
+    }
+    evaluate(true, false);
 } // RotoStrokeItem::appendPoint
 
 void
@@ -1232,6 +1255,85 @@ RotoStrokeItemPrivate::computeBoundingBox(TimeValue time, ViewIdx view) const
     return bbox;
 } // RotoStrokeItem::computeBoundingBox
 
+RectD
+RotoStrokeItemPrivate::computeLastSegmentBoundingBox(TimeValue time, ViewIdx view) const
+{
+    // Private - should not lock
+    assert(!lock.tryLock());
+
+    RectD bbox;
+    if ( strokes.empty() ) {
+        return bbox;
+    }
+
+    KeyFrameSet xCurve = strokes.back().xCurve->getKeyFrames_mt_safe();
+    KeyFrameSet yCurve = strokes.back().yCurve->getKeyFrames_mt_safe();
+    KeyFrameSet pCurve = strokes.back().pressureCurve->getKeyFrames_mt_safe();
+    if ( xCurve.empty() || ( xCurve.size() != yCurve.size() ) || ( xCurve.size() != pCurve.size() ) ) {
+        return bbox;
+    }
+
+    Transform::Matrix3x3 transform;
+    _publicInterface->getTransformAtTime(time, view, &transform);
+    bool pressureAffectsSize = pressureSize.lock()->getValueAtTime(time);
+    double halfBrushSize = _publicInterface->getBrushSizeKnob()->getValueAtTime(time) / 2. + 1;
+    halfBrushSize = std::max(0.5, halfBrushSize);
+
+    KeyFrameSet::const_reverse_iterator xNext = xCurve.rbegin();
+    KeyFrameSet::const_reverse_iterator yNext = yCurve.rbegin();
+    KeyFrameSet::const_reverse_iterator pNext = pCurve.rbegin();
+
+    if (xCurve.size() == 1) {
+        Transform::Point3D p;
+        p.x = xNext->getValue();
+        p.y = yNext->getValue();
+        p.z = 1.;
+        p = Transform::matApply(transform, p);
+        double pressure = pressureAffectsSize ? pNext->getValue() : 1.;
+        bbox.x1 = p.x - halfBrushSize * pressure;
+        bbox.x2 = p.x + halfBrushSize * pressure;
+        bbox.y1 = p.y - halfBrushSize * pressure;
+        bbox.y2 = p.y + halfBrushSize * pressure;
+        return bbox;
+    }
+
+    KeyFrameSet::const_reverse_iterator xIt = xNext;
+    KeyFrameSet::const_reverse_iterator yIt = yNext;
+    KeyFrameSet::const_reverse_iterator pIt = pNext;
+    ++xIt;
+    ++yIt;
+    ++pIt;
+
+    double dt = xNext->getTime() - xIt->getTime();
+    double pressure = pressureAffectsSize ? std::max( pIt->getValue(), pNext->getValue() ) : 1.;
+    Transform::Point3D p0, p1, p2, p3;
+    p0.z = p1.z = p2.z = p3.z = 1;
+    p0.x = xIt->getValue();
+    p0.y = yIt->getValue();
+    p1.x = p0.x + dt * xIt->getRightDerivative() / 3.;
+    p1.y = p0.y + dt * yIt->getRightDerivative() / 3.;
+    p3.x = xNext->getValue();
+    p3.y = yNext->getValue();
+    p2.x = p3.x - dt * xNext->getLeftDerivative() / 3.;
+    p2.y = p3.y - dt * yNext->getLeftDerivative() / 3.;
+
+    p0 = Transform::matApply(transform, p0);
+    p1 = Transform::matApply(transform, p1);
+    p2 = Transform::matApply(transform, p2);
+    p3 = Transform::matApply(transform, p3);
+
+    Point p0_, p1_, p2_, p3_;
+    p0_.x = p0.x; p0_.y = p0.y;
+    p1_.x = p1.x; p1_.y = p1.y;
+    p2_.x = p2.x; p2_.y = p2.y;
+    p3_.x = p3.x; p3_.y = p3.y;
+
+    bbox = Bezier::getBezierSegmentControlPolygonBbox(p0_, p1_, p2_, p3_);
+    bbox.addPadding(halfBrushSize * pressure + 1, halfBrushSize * pressure + 1);
+
+    return bbox;
+} // computeLastSegmentBoundingBox
+
 
 RectD
 RotoStrokeItem::getBoundingBox(TimeValue time, ViewIdx view) const
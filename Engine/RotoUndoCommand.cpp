@@ -443,9 +443,7 @@ RemovePointUndoCommand::RemovePointUndoCommand(const RotoPaintInteractPtr& roto,
     desc.curve = curve;
     desc.points.push_back(indexToRemove);
 
-    // Copy the state of the curve
-    desc.oldCurve.reset( new Bezier(curve->getModel(), curve->getBaseItemName(), curve->isOpenBezier()) );
-    desc.oldCurve->copyItem(*curve);
+    // The state of the curve is saved in redo()
     _curves.push_back(desc);
 
     setText( tr("Remove control point(s)").toStdString() );
@@ -498,10 +496,7 @@ RemovePointUndoCommand::RemovePointUndoCommand(const RotoPaintInteractPtr& roto,
             curveDesc.points.push_back(indexToRemove);
             curveDesc.curve = curve;
 
-            // Make a copy of the current state of this bezier
-            curveDesc.oldCurve.reset( new Bezier(curve->getModel(), curve->getBaseItemName(), curve->isOpenBezier()) );
-            curveDesc.oldCurve->copyItem(*curve);
-
+            // The state of the curve is saved in redo()
             _curves.push_back(curveDesc);
         } else {
             // The curve was already encountered, just add the index of the control point to the points list
@@ -535,8 +530,8 @@ RemovePointUndoCommand::undo()
     SelectedCpList cpSelection;
 
     for (std::list< CurveDesc >::iterator it = _curves.begin(); it != _curves.end(); ++it) {
-        // Clone the original curve
-        it->curve->copyItem( *it->oldCurve );
+        // Restore the points of the original curve
+        it->curve->restoreShapesSnapshot(it->oldShapes);
 
         // If the curve was removed entirely, add it back
         if (it->curveRemoved) {
@@ -558,9 +553,10 @@ RemovePointUndoCommand::redo()
         return;
     }
 
-    // Clone the original curve first
+    // Save the points of the original curve first. Removing points does not modify the others
+    // so the snapshot can share them with the curve instead of copying the whole curve.
     for (std::list< CurveDesc >::iterator it = _curves.begin(); it != _curves.end(); ++it) {
-        it->oldCurve->copyItem(*it->curve);
+        it->curve->getShapesSnapshot(&it->oldShapes);
     }
 
     std::list<BezierPtr > toRemove;
@@ -1342,8 +1338,8 @@ MakeBezierUndoCommand::MakeBezierUndoCommand(const RotoPaintInteractPtr& roto,
     , _roto(roto)
     , _parentLayer()
     , _indexInLayer(0)
-    , _oldCurve()
     , _newCurve(curve)
+    , _oldShapes()
     , _curveNonExistant(false)
     , _createdPoint(createPoint)
     , _x(dx)
@@ -1356,10 +1352,6 @@ MakeBezierUndoCommand::MakeBezierUndoCommand(const RotoPaintInteractPtr& roto,
 {
     if (!_newCurve) {
         _curveNonExistant = true;
-    } else {
-        // If the curve already exists, copy its current state
-        _oldCurve.reset( new Bezier(_newCurve->getModel(), _newCurve->getBaseItemName(), _newCurve->isOpenBezier()));
-        _oldCurve->copyItem( *_newCurve );
     }
     setText( tr("Draw Bezier").toStdString() );
 }
@@ -1380,7 +1372,9 @@ MakeBezierUndoCommand::undo()
     assert(_createdPoint);
     roto->setCurrentTool( roto->drawBezierAction.lock() );
     assert(_lastPointAdded != -1);
-    _oldCurve->copyItem(*_newCurve);
+
+    // Only the last point is removed: the other points are shared with the snapshot
+    _newCurve->getShapesSnapshot(&_oldShapes);
     if (_newCurve->getControlPointsCount(ViewIdx(0)) == 1) {
         _curveNonExistant = true;
         roto->removeCurve(_newCurve);
@@ -1413,12 +1407,9 @@ MakeBezierUndoCommand::redo()
             if (!_newCurve) {
                 _newCurve = roto->_imp->publicInterface->makeBezier(_x, _y, _isOpenBezier ? tr(kRotoOpenBezierBaseName).toStdString() : tr(kRotoBezierBaseName).toStdString(), _time, _isOpenBezier);
                 assert(_newCurve);
-                _oldCurve.reset( new Bezier(_newCurve->getModel(), _newCurve->getBaseItemName(), _newCurve->isOpenBezier()));
-                _oldCurve->copyItem(*_newCurve);
                 _lastPointAdded = 0;
                 _curveNonExistant = false;
             } else {
-                _oldCurve->copyItem(*_newCurve);
                 _newCurve->addControlPoint(_x, _y, _time, ViewSetSpec::all());
                 int lastIndex = _newCurve->getControlPointsCount(ViewIdx(0)) - 1;
                 assert(lastIndex > 0);
@@ -1426,7 +1417,6 @@ MakeBezierUndoCommand::redo()
             }
         } else {
             assert(_newCurve);
-            _oldCurve->copyItem(*_newCurve);
             int lastIndex = _newCurve->getControlPointsCount(ViewIdx(0)) - 1;
             assert(lastIndex >= 0);
             _lastPointAdded = lastIndex;
@@ -1440,7 +1430,7 @@ MakeBezierUndoCommand::redo()
             _indexInLayer = _newCurve->getIndexInParent();
         }
     } else {
-        _newCurve->copyItem(*_oldCurve);
+        _newCurve->restoreShapesSnapshot(_oldShapes);
         if (_curveNonExistant) {
             roto->_imp->knobsTable->insertItem(_indexInLayer, _newCurve, _parentLayer, eTableChangeReasonViewer);
         }
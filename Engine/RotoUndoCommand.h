@@ -41,6 +41,7 @@ CLANG_DIAG_OFF(uninitialized)
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
+#include "Engine/Bezier.h"
 #include "Engine/UndoCommand.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/TimeValue.h"
@@ -172,7 +173,10 @@ class RemovePointUndoCommand
 private:
     struct CurveDesc
     {
-        BezierPtr oldCurve, curve;
+        BezierPtr curve;
+
+        // The points of the curve before the removal. They are shared with the curve, not copied.
+        PerViewBezierShapeMap oldShapes;
         std::list<int> points;
         RotoLayerPtr parentLayer;
         bool curveRemoved;
@@ -458,7 +462,10 @@ private:
     RotoPaintInteractWPtr _roto;
     RotoLayerPtr _parentLayer;
     int _indexInLayer;
-    BezierPtr _oldCurve, _newCurve;
+    BezierPtr _newCurve;
+
+    // The points of the curve before undo() removed the last point, shared with the curve
+    PerViewBezierShapeMap _oldShapes;
     bool _curveNonExistant;
     bool _createdPoint;
     double _x, _y;
@@ -24,6 +24,7 @@
 
 #include "Settings.h"
 
+#include <algorithm> // min, max
 #include <cassert>
 #include <stdexcept>
 #include <sstream>
@@ -44,6 +45,7 @@
 #include "Engine/AppManager.h"
 #include "Engine/AppInstance.h"
 #include "Engine/Cache.h"
+#include "Engine/EngineCalibration.h"
 #include "Global/FStreamsSupport.h"
 #include "Engine/KeybindShortcut.h"
 #include "Engine/KnobFactory.h"
@@ -57,6 +59,7 @@
 #include "Engine/Plugin.h"
 #include "Engine/Project.h"
 #include "Engine/StandardPaths.h"
+#include "Engine/StartupTrace.h"
 #include "Engine/Utils.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/ViewerInstance.h"
@@ -117,12 +120,17 @@ public:
     KnobPathPtr _fileDialogSavedPaths;
     KnobIntPtr _autoSaveDelay;
     KnobBoolPtr _saveSafetyMode;
+    KnobBoolPtr _binaryProjectFormat;
     KnobChoicePtr _hostName;
     KnobStringPtr _customHostName;
 
     // General/Threading
     KnobPagePtr _threadingPage;
     KnobIntPtr _numberOfThreads;
+    KnobIntPtr _numberOfIOThreads;
+    KnobIntPtr _maxIOTasksPerMount;
+    KnobIntPtr _numberOfThreadsReservedForViewer;
+    KnobButtonPtr _calibrateButton;
     KnobBoolPtr _renderInSeparateProcess;
     KnobBoolPtr _queueRenders;
 
@@ -136,7 +144,10 @@ public:
     KnobPagePtr _gpuPage;
     KnobStringPtr _openglRendererString;
     KnobChoicePtr _availableOpenGLRenderers;
+    KnobBoolPtr _useAllOpenGLRenderers;
     KnobChoicePtr _osmesaRenderers;
+    KnobIntPtr _nOSMesaContexts;
+    KnobIntPtr _osmesaRendererThreads;
     KnobIntPtr _nOpenGLContexts;
     KnobChoicePtr _enableOpenGL;
 
@@ -182,6 +193,18 @@ public:
     // The total disk space allowed for all Natron's caches
     KnobIntPtr _maxDiskCacheSizeGb;
     KnobPathPtr _diskCachePath;
+    KnobChoicePtr _tileCacheTileSize;
+    KnobIntPtr _compressedCacheTierSizeMb;
+    KnobPathPtr _remoteCacheTierPath;
+    KnobIntPtr _remoteCacheTierMinRenderTimeMs;
+    KnobIntPtr _diskCacheFlushWatermarkMb;
+    KnobChoicePtr _cacheEvictionPolicy;
+    KnobIntPtr _projectCacheQuotaPercent;
+    KnobIntPtr _nodeCacheQuotaPercent;
+    KnobIntPtr _viewerReservedCachePercent;
+    KnobChoicePtr _tileCachePages;
+    KnobBoolPtr _tileCacheInterleaveNUMANodes;
+    KnobBoolPtr _bypassSystemCacheForReads;
 
     // Viewer
     KnobPagePtr _viewersTab;
@@ -192,6 +215,12 @@ public:
     KnobBoolPtr _autoWipe;
     KnobBoolPtr _autoProxyWhenScrubbingTimeline;
     KnobChoicePtr _autoProxyLevel;
+    KnobBoolPtr _realTimePlayback;
+    KnobBoolPtr _progressiveViewerRender;
+    KnobBoolPtr _viewerIdleCaching;
+    KnobIntPtr _viewerIdleCachingMemoryShare;
+    KnobBoolPtr _viewerFlipbook;
+    KnobIntPtr _viewerFlipbookMaxMemory;
     KnobIntPtr _maximumNodeViewerUIOpened;
     KnobBoolPtr _viewerKeys;
 
@@ -357,6 +386,8 @@ public:
 
     void restoreNumThreads();
 
+    void restoreNumIOThreads();
+
     void refreshCacheSize();
 
 };
@@ -636,6 +667,7 @@ Settings::populateShortcuts()
     addKeybind(kShortcutGroupGlobal, kShortcutActionRenderAll, kShortcutActionRenderAllLabel, kShortcutActionRenderAllHint, eKeyboardModifierNone, Key_F5);
 
     addKeybind(kShortcutGroupGlobal, kShortcutActionEnableRenderStats, kShortcutActionEnableRenderStatsLabel, kShortcutActionEnableRenderStatsHint, eKeyboardModifierNone, Key_F2);
+    addKeybind(kShortcutGroupGlobal, kShortcutActionRecordRenderTrace, kShortcutActionRecordRenderTraceLabel, kShortcutActionRecordRenderTraceHint, eKeyboardModifierNone, (Key)0);
 
     // Note: keys 0-1 are handled by Gui::handleNativeKeys(), and should thus work even on international keyboards
     addKeybind(kShortcutGroupGlobal, kShortcutActionConnectViewerToInput1, kShortcutActionConnectViewerToInput1Label, kShortcutActionConnectViewerToInput1Hint, eKeyboardModifierNone, Key_1);
@@ -829,6 +861,15 @@ SettingsPrivate::initializeKnobsGeneral()
                                        "Note that checking this parameter can make project files significantly larger.").arg(QString::fromUtf8(NATRON_APPLICATION_NAME)));
     _generalTab->addKnob(_saveSafetyMode);
 
+    _binaryProjectFormat = _publicInterface->createKnob<KnobBool>("binaryProjectFormat");
+    _binaryProjectFormat->setLabel(tr("Save Projects in Binary Format"));
+    _binaryProjectFormat->setHintToolTip(tr("When checked, projects and auto-saves are written in a compact binary format instead of text. "
+                                            "Large projects (e.g: with a lot of roto shapes or tracks) load much faster, which matters when each "
+                                            "render farm task loads the project. Both formats can always be loaded. "
+                                            "Binary projects can only be loaded by versions of %1 that support this format.").arg(QString::fromUtf8(NATRON_APPLICATION_NAME)));
+    _binaryProjectFormat->setDefaultValue(false);
+    _generalTab->addKnob(_binaryProjectFormat);
+
 
     _hostName = _publicInterface->createKnob<KnobChoice>("pluginHostName");
     _hostName->setLabel(tr("Appear to plug-ins as"));
@@ -937,6 +978,49 @@ SettingsPrivate::initializeKnobsThreading()
     _numberOfThreads->setDefaultValue(0);
     _threadingPage->addKnob(_numberOfThreads);
 
+    _numberOfIOThreads = _publicInterface->createKnob<KnobInt>("numIOThreads");
+    _numberOfIOThreads->setLabel(tr("Number of I/O threads"));
+    _numberOfIOThreads->setHintToolTip( tr("Controls how many threads %1 should use to decode images in readers and to encode images in writers. "
+                                           "These threads mostly wait for the files to be read or written, so they are not taken from the render threads: "
+                                           "rendering goes on while waiting for a slow storage.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ).toStdString() );
+    _numberOfIOThreads->disableSlider();
+    _numberOfIOThreads->setRange(1, 256);
+    _numberOfIOThreads->setDisplayRange(1, 64);
+    _numberOfIOThreads->setDefaultValue(8);
+    _threadingPage->addKnob(_numberOfIOThreads);
+
+    _maxIOTasksPerMount = _publicInterface->createKnob<KnobInt>("maxIOTasksPerMount");
+    _maxIOTasksPerMount->setLabel(tr("Max. concurrent I/O per mount point (0=\"unlimited\")"));
+    _maxIOTasksPerMount->setHintToolTip( tr("Controls how many files may be read or written at the same time on the same mount point (drive, network share...). "
+                                            "Limiting this avoids overloading a network storage with many concurrent requests. "
+                                            "0: No limit other than the number of I/O threads.").toStdString() );
+    _maxIOTasksPerMount->disableSlider();
+    _maxIOTasksPerMount->setRange(0, 256);
+    _maxIOTasksPerMount->setDisplayRange(0, 64);
+    _maxIOTasksPerMount->setDefaultValue(0);
+    _threadingPage->addKnob(_maxIOTasksPerMount);
+
+    _numberOfThreadsReservedForViewer = _publicInterface->createKnob<KnobInt>("threadsReservedForViewer");
+    _numberOfThreadsReservedForViewer->setLabel(tr("Render threads reserved for the viewer"));
+    _numberOfThreadsReservedForViewer->setHintToolTip( tr("Controls how many render threads are kept for the viewer and the other interactive renders: "
+                                                          "renders on disk, tracking, previews and the idle caching of the viewer never use them, "
+                                                          "so that the interface stays responsive while rendering in the background. "
+                                                          "Whatever this value, the tasks of the viewer are always started before the others.\n"
+                                                          "0: The other renders may use all render threads.").toStdString() );
+    _numberOfThreadsReservedForViewer->disableSlider();
+    _numberOfThreadsReservedForViewer->setRange(0, hwThreadsCount);
+    _numberOfThreadsReservedForViewer->setDisplayRange(0, hwThreadsCount);
+    _numberOfThreadsReservedForViewer->setDefaultValue(0);
+    _threadingPage->addKnob(_numberOfThreadsReservedForViewer);
+
+    _calibrateButton = _publicInterface->createKnob<KnobButton>("calibrate");
+    _calibrateButton->setLabel(tr("Calibrate..."));
+    _calibrateButton->setHintToolTip( tr("Measures this machine for a few seconds to recommend the number of render threads, the cache tile size "
+                                         "and the compressed cache size, then proposes to apply them. "
+                                         "This is also done by the --calibrate command-line option. "
+                                         "Other applications should be idle during the measures.").toStdString() );
+    _threadingPage->addKnob(_calibrateButton);
+
 
     _renderInSeparateProcess = _publicInterface->createKnob<KnobBool>("renderNewProcess");
     _renderInSeparateProcess->setLabel(tr("Render in a separate process"));
@@ -992,6 +1076,7 @@ Settings::populateOpenGLRenderers(const std::list<OpenGLRendererInfo>& renderers
 {
     if ( renderers.empty() ) {
         _imp->_availableOpenGLRenderers->setSecret(true);
+        _imp->_useAllOpenGLRenderers->setSecret(true);
         _imp->_nOpenGLContexts->setSecret(true);
         _imp->_enableOpenGL->setSecret(true);
         return;
@@ -1008,6 +1093,7 @@ Settings::populateOpenGLRenderers(const std::list<OpenGLRendererInfo>& renderers
     }
     _imp->_availableOpenGLRenderers->populateChoices(entries);
     _imp->_availableOpenGLRenderers->setSecret(renderers.size() == 1);
+    _imp->_useAllOpenGLRenderers->setSecret(renderers.size() == 1);
 
 
 #ifdef HAVE_OSMESA
@@ -1020,8 +1106,12 @@ Settings::populateOpenGLRenderers(const std::list<OpenGLRendererInfo>& renderers
 #else
     _imp->_osmesaRenderers->setSecret(false);
 #endif
+    _imp->_nOSMesaContexts->setSecret(false);
+    _imp->_osmesaRendererThreads->setSecret(false);
 #else
     _imp->_osmesaRenderers->setSecret(true);
+    _imp->_nOSMesaContexts->setSecret(true);
+    _imp->_osmesaRendererThreads->setSecret(true);
 #endif
 }
 
@@ -1054,6 +1144,18 @@ Settings::getMaxOpenGLContexts() const
     return _imp->_nOpenGLContexts->getValue();
 }
 
+int
+Settings::getMaxCPUOpenGLContexts() const
+{
+    return _imp->_nOSMesaContexts->getValue();
+}
+
+int
+Settings::getCPUOpenGLRendererThreads() const
+{
+    return _imp->_osmesaRendererThreads->getValue();
+}
+
 GLRendererID
 Settings::getActiveOpenGLRendererID() const
 {
@@ -1077,6 +1179,21 @@ Settings::getActiveOpenGLRendererID() const
     return GLRendererID();
 }
 
+void
+Settings::getOpenGLRendererIDsForRendering(std::vector<GLRendererID>* rendererIDs) const
+{
+    rendererIDs->clear();
+    if ( !_imp->_useAllOpenGLRenderers->getIsSecret() && _imp->_useAllOpenGLRenderers->getValue() ) {
+        const std::list<OpenGLRendererInfo>& renderers = appPTR->getOpenGLRenderers();
+        for (std::list<OpenGLRendererInfo>::const_iterator it = renderers.begin(); it != renderers.end(); ++it) {
+            rendererIDs->push_back(it->rendererID);
+        }
+    }
+    if ( rendererIDs->empty() ) {
+        rendererIDs->push_back( getActiveOpenGLRendererID() );
+    }
+}
+
 void
 SettingsPrivate::initializeKnobsGPU()
 {
@@ -1098,6 +1215,17 @@ SettingsPrivate::initializeKnobsGPU()
     _knobsRequiringRestart.insert(_availableOpenGLRenderers);
     _gpuPage->addKnob(_availableOpenGLRenderers);
 
+    _useAllOpenGLRenderers = _publicInterface->createKnob<KnobBool>("useAllOpenGLRenderers");
+    _useAllOpenGLRenderers->setLabel(tr("Use all OpenGL renderers"));
+    _useAllOpenGLRenderers->setHintToolTip( tr("When checked, OpenGL contexts are created on all the renderers available instead of only "
+                                               "the one selected above and frames are distributed across them in turn. "
+                                               "The number of OpenGL contexts is then per renderer.") +
+                                            QLatin1Char('\n') +
+                                            tr("Changing this requires a restart of the application to take effect.") );
+    _useAllOpenGLRenderers->setDefaultValue(false);
+    _knobsRequiringRestart.insert(_useAllOpenGLRenderers);
+    _gpuPage->addKnob(_useAllOpenGLRenderers);
+
     _osmesaRenderers = _publicInterface->createKnob<KnobChoice>("cpuOpenGLRenderer");
     _osmesaRenderers->setLabel(tr("CPU OpenGL renderer"));
     _knobsRequiringRestart.insert(_osmesaRenderers);
@@ -1109,6 +1237,29 @@ SettingsPrivate::initializeKnobsGPU()
     _osmesaRenderers->setDefaultValue(defaultMesaDriver);
     _gpuPage->addKnob(_osmesaRenderers);
 
+    _nOSMesaContexts = _publicInterface->createKnob<KnobInt>("maxCPUOpenGLContexts");
+    _nOSMesaContexts->setLabel(tr("No. of CPU OpenGL Contexts"));
+    _nOSMesaContexts->setRange(0, 64);
+    _nOSMesaContexts->setDisplayRange(0, 64);
+    _nOSMesaContexts->setHintToolTip( tr("The number of OSMesa contexts created to render OpenGL plug-ins on the CPU. Each context can be "
+                                         "attached to a render thread, allowing for more frames to be rendered simultaneously. "
+                                         "When 0, one context is created per hardware thread.") );
+    _nOSMesaContexts->setDefaultValue(0);
+    _gpuPage->addKnob(_nOSMesaContexts);
+
+    _osmesaRendererThreads = _publicInterface->createKnob<KnobInt>("cpuOpenGLRendererThreads");
+    _osmesaRendererThreads->setLabel(tr("CPU OpenGL renderer threads"));
+    _osmesaRendererThreads->setRange(0, 64);
+    _osmesaRendererThreads->setDisplayRange(0, 64);
+    _osmesaRendererThreads->setHintToolTip( tr("The number of threads used by the llvmpipe driver to rasterize each OSMesa context. "
+                                               "Since frames are already rendered in parallel with one context each, a low value "
+                                               "avoids creating more threads than there are cores. When 0, llvmpipe uses one thread per core.") +
+                                            QLatin1Char('\n') +
+                                            tr("Changing this requires a restart of the application to take effect.") );
+    _osmesaRendererThreads->setDefaultValue(0);
+    _knobsRequiringRestart.insert(_osmesaRendererThreads);
+    _gpuPage->addKnob(_osmesaRendererThreads);
+
 
     _nOpenGLContexts = _publicInterface->createKnob<KnobInt>("maxOpenGLContexts");
     _nOpenGLContexts->setLabel(tr("No. of OpenGL Contexts"));
@@ -1986,6 +2137,61 @@ SettingsPrivate::initializeKnobsViewers()
 
     _viewersTab->addKnob(_autoProxyLevel);
 
+    _realTimePlayback = _publicInterface->createKnob<KnobBool>("realTimePlayback");
+    _realTimePlayback->setLabel(tr("Drop frames to keep up with the playback frame rate"));
+    _realTimePlayback->setHintToolTip( tr("When checked, if the frames cannot be rendered as fast as the frame rate requested for playback, "
+                                          "the viewer renders them in draft mode and at a lower resolution and skips frames, "
+                                          "so that the playback stays in real-time.") );
+    _realTimePlayback->setDefaultValue(false);
+
+    _viewersTab->addKnob(_realTimePlayback);
+
+    _progressiveViewerRender = _publicInterface->createKnob<KnobBool>("progressiveViewerRender");
+    _progressiveViewerRender->setLabel(tr("Progressive rendering"));
+    _progressiveViewerRender->setHintToolTip( tr("When checked, if the image displayed by the viewer is slow to render, a lower resolution "
+                                                 "draft is rendered and displayed first when a parameter changes. "
+                                                 "The image is then rendered at full resolution as soon as no parameter changed for a short while.") );
+    _progressiveViewerRender->setDefaultValue(true);
+
+    _viewersTab->addKnob(_progressiveViewerRender);
+
+    _viewerIdleCaching = _publicInterface->createKnob<KnobBool>("viewerIdleCaching");
+    _viewerIdleCaching->setLabel(tr("Cache frames when idle"));
+    _viewerIdleCaching->setHintToolTip( tr("When checked, once the viewer displayed the current frame and nothing else happened for a second, "
+                                           "the frames after the current frame and then the frames before it are rendered in the background "
+                                           "and kept in the cache, so that the playback starts immediately. "
+                                           "The background render stops as soon as another render is requested.") );
+    _viewerIdleCaching->setDefaultValue(false);
+    _viewerIdleCaching->setAddNewLine(false);
+    _viewersTab->addKnob(_viewerIdleCaching);
+
+    _viewerIdleCachingMemoryShare = _publicInterface->createKnob<KnobInt>("viewerIdleCachingMemoryShare");
+    _viewerIdleCachingMemoryShare->setLabel(tr("Max. cache usage (%)"));
+    _viewerIdleCachingMemoryShare->setRange(0, 100);
+    _viewerIdleCachingMemoryShare->setDisplayRange(0, 100);
+    _viewerIdleCachingMemoryShare->setHintToolTip( tr("The frames are cached when idle only while the cache uses less than this percentage of its maximum size.") );
+    _viewerIdleCachingMemoryShare->setDefaultValue(50);
+    _viewersTab->addKnob(_viewerIdleCachingMemoryShare);
+
+    _viewerFlipbook = _publicInterface->createKnob<KnobBool>("viewerFlipbook");
+    _viewerFlipbook->setLabel(tr("RAM flipbook playback"));
+    _viewerFlipbook->setHintToolTip( tr("When checked, the images displayed by the viewer during playback are kept in memory "
+                                        "as they are sent to the display, after the color transform of the viewer. "
+                                        "When a frame is played again and nothing changed, it is displayed without being rendered, "
+                                        "so that a loop plays in real-time. Frames that do not fit in the memory are compressed.") );
+    _viewerFlipbook->setDefaultValue(false);
+    _viewerFlipbook->setAddNewLine(false);
+    _viewersTab->addKnob(_viewerFlipbook);
+
+    _viewerFlipbookMaxMemory = _publicInterface->createKnob<KnobInt>("viewerFlipbookMaxMemory");
+    _viewerFlipbookMaxMemory->setLabel(tr("Max. flipbook memory (MiB)"));
+    _viewerFlipbookMaxMemory->setRange(0, INT_MAX);
+    _viewerFlipbookMaxMemory->disableSlider();
+    _viewerFlipbookMaxMemory->setHintToolTip( tr("The memory used by the images of the RAM flipbook playback of each viewer, in MiB. "
+                                                 "Once it is reached, the frames that are not cached yet are rendered during playback.") );
+    _viewerFlipbookMaxMemory->setDefaultValue(2048);
+    _viewersTab->addKnob(_viewerFlipbookMaxMemory);
+
     _maximumNodeViewerUIOpened = _publicInterface->createKnob<KnobInt>("maxNodeUiOpened");
     _maximumNodeViewerUIOpened->setLabel(tr("Max. opened node viewer interface"));
     _maximumNodeViewerUIOpened->setRange(1, INT_MAX);
@@ -2103,7 +2309,7 @@ SettingsPrivate::initializeKnobsCaching()
     _maxDiskCacheSizeGb->disableSlider();
 
     // The disk should at least allow storage of 1000 tiles accross each bucket
-    std::size_t cacheMinSize = NATRON_TILE_SIZE_BYTES;
+    std::size_t cacheMinSize = NATRON_TILE_SIZE_BYTES_FOR_PO2(NATRON_TILE_SIZE_PO2_DEFAULT);
     cacheMinSize = cacheMinSize * 1024 * 256;
     _maxDiskCacheSizeGb->setRange(cacheMinSize, INT_MAX);
     _maxDiskCacheSizeGb->setHintToolTip( tr("The maximum Disk size that may be used by the Cache (in GiB)") );
@@ -2128,6 +2334,160 @@ SettingsPrivate::initializeKnobsCaching()
 
     _cachingTab->addKnob(_diskCachePath);
 
+    _tileCacheTileSize = _publicInterface->createKnob<KnobChoice>("tileCacheTileSize");
+    _tileCacheTileSize->setLabel(tr("Cache Tile Size"));
+    {
+        std::vector<ChoiceOption> entries;
+        for (int po2 = NATRON_TILE_SIZE_PO2_MIN; po2 <= NATRON_TILE_SIZE_PO2_MAX; ++po2) {
+            int tx, ty;
+            CacheBase::getTileSizePxForPo2(po2, eImageBitDepthFloat, &tx, &ty);
+            std::string label = tr("%1 KiB (%2x%2 pixels in 32-bit float)").arg((qulonglong)(NATRON_TILE_SIZE_BYTES_FOR_PO2(po2) / 1024)).arg(tx).toStdString();
+            entries.push_back(ChoiceOption(QString::number(po2).toStdString(), label, ""));
+        }
+        _tileCacheTileSize->populateChoices(entries);
+    }
+    _tileCacheTileSize->setHintToolTip( tr("The size of a single tile of image in the cache. All images are split in tiles of this size in memory. "
+                                           "Larger tiles reduce the bookkeeping overhead of very large images (e.g: 8K 32-bit float renders) "
+                                           "but waste more memory on the borders of images and on small images. "
+                                           "Changing this wipes the disk cache.") +
+                                        QLatin1Char('\n') +
+                                        tr("Changing this requires a restart of the application to take effect.") );
+    _tileCacheTileSize->setDefaultValue(NATRON_TILE_SIZE_PO2_DEFAULT - NATRON_TILE_SIZE_PO2_MIN);
+    _knobsRequiringRestart.insert(_tileCacheTileSize);
+
+    _cachingTab->addKnob(_tileCacheTileSize);
+
+    _compressedCacheTierSizeMb = _publicInterface->createKnob<KnobInt>("compressedCacheTierSizeMb");
+    _compressedCacheTierSizeMb->setLabel(tr("Compressed Cache Size (MiB)"));
+    _compressedCacheTierSizeMb->disableSlider();
+    _compressedCacheTierSizeMb->setRange(0, INT_MAX);
+    _compressedCacheTierSizeMb->setHintToolTip( tr("When the cache is full, the images that are evicted are compressed and kept in RAM "
+                                                   "up to this size, so that they can be restored quickly instead of being rendered again. "
+                                                   "This is useful when scrubbing long sequences that do not fit in the cache. "
+                                                   "A value of 0 disables the compressed cache.") );
+    _compressedCacheTierSizeMb->setDefaultValue(0);
+
+    _cachingTab->addKnob(_compressedCacheTierSizeMb);
+
+    _remoteCacheTierPath = _publicInterface->createKnob<KnobPath>("remoteCacheTierPath");
+    _remoteCacheTierPath->setLabel(tr("Shared Cache Path (empty = disabled)"));
+    _remoteCacheTierPath->setMultiPath(false);
+    _remoteCacheTierPath->setHintToolTip( tr("A directory on a storage shared by all the computers rendering the same projects, e.g: the hosts of a render farm. "
+                                             "The images of nodes that are expensive to render are written there in the background, "
+                                             "and any computer that needs an image that is not in its own cache reads it from there "
+                                             "instead of rendering it. The images are identified by a hash of the node tree that produced them, "
+                                             "so the directory can be shared by different projects. Nothing is ever removed from this directory: "
+                                             "it must be cleaned externally. If empty, the shared cache is disabled.") );
+    _cachingTab->addKnob(_remoteCacheTierPath);
+
+    _remoteCacheTierMinRenderTimeMs = _publicInterface->createKnob<KnobInt>("remoteCacheTierMinRenderTimeMs");
+    _remoteCacheTierMinRenderTimeMs->setLabel(tr("Shared Cache Minimum Render Time (ms)"));
+    _remoteCacheTierMinRenderTimeMs->disableSlider();
+    _remoteCacheTierMinRenderTimeMs->setRange(0, INT_MAX);
+    _remoteCacheTierMinRenderTimeMs->setHintToolTip( tr("Only the images that took at least this time to render are written to the shared cache: "
+                                                        "images that are cheap to render are faster to render again than to read from a network storage.") );
+    _remoteCacheTierMinRenderTimeMs->setDefaultValue(1000);
+    _cachingTab->addKnob(_remoteCacheTierMinRenderTimeMs);
+
+    _diskCacheFlushWatermarkMb = _publicInterface->createKnob<KnobInt>("diskCacheFlushWatermarkMb");
+    _diskCacheFlushWatermarkMb->setLabel(tr("Disk Cache Flush Threshold (MiB)"));
+    _diskCacheFlushWatermarkMb->disableSlider();
+    _diskCacheFlushWatermarkMb->setRange(0, INT_MAX);
+    _diskCacheFlushWatermarkMb->setHintToolTip( tr("The rendered images held in the disk cache are written to disk in the background in large "
+                                                   "contiguous chunks. When the amount of images not yet written to disk exceeds this size, "
+                                                   "they are written immediately, otherwise they are written every few seconds.\n"
+                                                   "Lower values produce a steadier I/O load, which is preferable when the cache is located "
+                                                   "on a network drive. A value of 0 only writes images periodically.") );
+    _diskCacheFlushWatermarkMb->setDefaultValue(256);
+
+    _cachingTab->addKnob(_diskCacheFlushWatermarkMb);
+
+    _cacheEvictionPolicy = _publicInterface->createKnob<KnobChoice>("cacheEvictionPolicy");
+    _cacheEvictionPolicy->setLabel(tr("Cache Eviction Policy"));
+    {
+        std::vector<ChoiceOption> options;
+        options.push_back(ChoiceOption("LRU", tr("Least Recently Used").toStdString(), tr("When the cache is full, the images that were not used for the longest time are removed first.").toStdString()));
+        options.push_back(ChoiceOption("RenderCost", tr("Render Cost").toStdString(), tr("When the cache is full, amongst the images that were not used for a long time, the images "
+                                                                                        "that are the fastest to render again relative to their size are removed first. "
+                                                                                        "This keeps the results of expensive nodes longer in the cache.").toStdString()));
+        _cacheEvictionPolicy->populateChoices(options);
+    }
+    _cacheEvictionPolicy->setHintToolTip( tr("Controls which images are removed from the cache when it is full.") );
+    _cacheEvictionPolicy->setDefaultValue(0);
+
+    _cachingTab->addKnob(_cacheEvictionPolicy);
+
+    _projectCacheQuotaPercent = _publicInterface->createKnob<KnobInt>("projectCacheQuotaPercent");
+    _projectCacheQuotaPercent->setLabel(tr("Project Cache Quota (%)"));
+    _projectCacheQuotaPercent->setRange(0, 100);
+    _projectCacheQuotaPercent->setHintToolTip( tr("The maximum percentage of the cache that the images of a single project may use. "
+                                                  "When a project exceeds it, its own least recently used images are removed first, "
+                                                  "so that it does not remove the images of the other opened projects. "
+                                                  "A value of 0 disables the quota.") );
+    _projectCacheQuotaPercent->setDefaultValue(0);
+
+    _cachingTab->addKnob(_projectCacheQuotaPercent);
+
+    _nodeCacheQuotaPercent = _publicInterface->createKnob<KnobInt>("nodeCacheQuotaPercent");
+    _nodeCacheQuotaPercent->setLabel(tr("Node Cache Quota (%)"));
+    _nodeCacheQuotaPercent->setRange(0, 100);
+    _nodeCacheQuotaPercent->setHintToolTip( tr("The maximum percentage of the cache that the images of a single node may use. "
+                                               "When a node exceeds it, its own least recently used images are removed first. "
+                                               "A value of 0 disables the quota.") );
+    _nodeCacheQuotaPercent->setDefaultValue(0);
+
+    _cachingTab->addKnob(_nodeCacheQuotaPercent);
+
+    _viewerReservedCachePercent = _publicInterface->createKnob<KnobInt>("viewerReservedCachePercent");
+    _viewerReservedCachePercent->setLabel(tr("Viewer Reserved Cache (%)"));
+    _viewerReservedCachePercent->setRange(0, 100);
+    _viewerReservedCachePercent->setHintToolTip( tr("The percentage of the cache reserved to the images displayed by the viewers. "
+                                                    "The viewer images are not removed from the cache to make room for other images "
+                                                    "as long as they fit in this share of the cache. "
+                                                    "A value of 0 does not reserve any space for the viewers.") );
+    _viewerReservedCachePercent->setDefaultValue(0);
+
+    _cachingTab->addKnob(_viewerReservedCachePercent);
+
+    _tileCachePages = _publicInterface->createKnob<KnobChoice>("tileCachePages");
+    _tileCachePages->setLabel(tr("RAM Cache Pages"));
+    {
+        std::vector<ChoiceOption> options;
+        options.push_back(ChoiceOption("Default", tr("Default").toStdString(), tr("The cache is allocated with the default page size of the system.").toStdString()));
+        options.push_back(ChoiceOption("TransparentHuge", tr("Transparent Huge Pages").toStdString(), tr("The system is advised to back the cache with huge pages when transparent huge pages are enabled.").toStdString()));
+        options.push_back(ChoiceOption("ExplicitHuge", tr("Explicit Huge Pages").toStdString(), tr("The cache is allocated in the huge pages reserved by the system administrator. "
+                                                                                                  "If there are not enough of them, transparent huge pages are used instead.").toStdString()));
+        _tileCachePages->populateChoices(options);
+    }
+    _tileCachePages->setHintToolTip( tr("Controls the size of the memory pages backing the cache when it is in RAM. "
+                                        "Huge pages reduce the overhead of accessing large images. "
+                                        "This only has an effect on Linux and when the cache is not located on disk. "
+                                        "Changing this clears the cache.") );
+    _tileCachePages->setDefaultValue(0);
+
+    _cachingTab->addKnob(_tileCachePages);
+
+    _tileCacheInterleaveNUMANodes = _publicInterface->createKnob<KnobBool>("tileCacheInterleaveNUMANodes");
+    _tileCacheInterleaveNUMANodes->setLabel(tr("Interleave RAM Cache Across NUMA Nodes"));
+    _tileCacheInterleaveNUMANodes->setHintToolTip( tr("When checked on a computer with several processors sockets (NUMA nodes), the memory of the cache "
+                                                      "is spread evenly across the memory of all sockets, so that render threads running on any socket "
+                                                      "get the same memory bandwidth instead of contending on the memory of a single socket. "
+                                                      "This only has an effect on Linux and when the cache is not located on disk. "
+                                                      "Changing this clears the cache.") );
+    _tileCacheInterleaveNUMANodes->setDefaultValue(false);
+
+    _cachingTab->addKnob(_tileCacheInterleaveNUMANodes);
+
+    _bypassSystemCacheForReads = _publicInterface->createKnob<KnobBool>("bypassSystemCacheForReads");
+    _bypassSystemCacheForReads->setLabel(tr("Do Not Keep Read Files In System Cache"));
+    _bypassSystemCacheForReads->setHintToolTip( tr("When checked, once a frame of an image sequence has been decoded by a Read node, the system is advised "
+                                                   "to release the file from its own file cache, since the decoded image is in the %1 cache. "
+                                                   "When playing large sequences this avoids keeping each frame twice in memory, leaving it to the %1 cache. "
+                                                   "This only has an effect on Linux.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ) );
+    _bypassSystemCacheForReads->setDefaultValue(false);
+
+    _cachingTab->addKnob(_bypassSystemCacheForReads);
+
 
 } // Settings::initializeKnobsCaching
 
@@ -2465,6 +2825,7 @@ Settings::loadSettingsFromFile(int loadType)
 
         // Restore number of threads
         _imp->restoreNumThreads();
+        _imp->restoreNumIOThreads();
 
 
         // If the appearance changed, flag it
@@ -2554,6 +2915,7 @@ SettingsPrivate::ensureUserDataDirectory()
 bool
 SettingsPrivate::tryLoadOpenColorIOConfig()
 {
+    StartupTrace::Scope_RAII trace("Load OpenColorIO configuration", "startup");
     QString configFile;
 
 
@@ -2667,12 +3029,29 @@ SettingsPrivate::restoreNumThreads()
     }
 }
 
+void
+SettingsPrivate::restoreNumIOThreads()
+{
+    QThreadPool* ioThreadPool = appPTR->getIOThreadPool();
+    if (ioThreadPool) {
+        ioThreadPool->setMaxThreadCount( std::max(1, _numberOfIOThreads->getValue()) );
+    }
+}
+
 void
 SettingsPrivate::refreshCacheSize()
 {
     CacheBasePtr tileCache = appPTR->getTileCache();
     if (tileCache) {
         tileCache->setMaximumCacheSize(_publicInterface->getTileCacheSize());
+        tileCache->setCompressedTierMaximumSize(_publicInterface->getCompressedCacheTierSize());
+        tileCache->setRemoteTier(_publicInterface->getRemoteCacheTierPath(), _publicInterface->getRemoteCacheTierMinimumRenderTime());
+        tileCache->setDirtyTilesHighWatermark(_publicInterface->getDiskCacheFlushWatermark());
+        tileCache->setEvictionPolicy((CacheBase::CacheEvictionPolicyEnum)_publicInterface->getCacheEvictionPolicy());
+        tileCache->setQuotaGroupSize(CacheBase::eCacheQuotaGroupProject, _publicInterface->getProjectCacheQuota());
+        tileCache->setQuotaGroupSize(CacheBase::eCacheQuotaGroupNode, _publicInterface->getNodeCacheQuota());
+        tileCache->setQuotaGroupSize(CacheBase::eCacheQuotaGroupViewer, _publicInterface->getViewerReservedCacheSize());
+        tileCache->setTileStorageAllocation((CacheBase::CacheTileStoragePagesEnum)_publicInterface->getTileCachePages(), _publicInterface->isTileCacheInterleavedAcrossNUMANodes());
     }
 
     CacheBasePtr cache = appPTR->getGeneralPurposeCache();
@@ -2701,6 +3080,93 @@ Settings::getTileCacheSize() const
     return maxDiskBytes;
 }
 
+std::size_t
+Settings::getCompressedCacheTierSize() const
+{
+    std::size_t mb = 1024 * 1024;
+    return (std::size_t)_imp->_compressedCacheTierSizeMb->getValue() * mb;
+}
+
+void
+Settings::setCompressedCacheTierSize(std::size_t size)
+{
+    std::size_t mb = 1024 * 1024;
+    _imp->_compressedCacheTierSizeMb->setValue( (int)std::min(size / mb, (std::size_t)INT_MAX) );
+}
+
+std::string
+Settings::getRemoteCacheTierPath() const
+{
+    return _imp->_remoteCacheTierPath->getValue();
+}
+
+double
+Settings::getRemoteCacheTierMinimumRenderTime() const
+{
+    return _imp->_remoteCacheTierMinRenderTimeMs->getValue() / 1000.;
+}
+
+std::size_t
+Settings::getDiskCacheFlushWatermark() const
+{
+    std::size_t mb = 1024 * 1024;
+    return (std::size_t)_imp->_diskCacheFlushWatermarkMb->getValue() * mb;
+}
+
+int
+Settings::getCacheEvictionPolicy() const
+{
+    return _imp->_cacheEvictionPolicy->getValue();
+}
+
+std::size_t
+Settings::getProjectCacheQuota() const
+{
+    return (std::size_t)(getTileCacheSize() * (_imp->_projectCacheQuotaPercent->getValue() / 100.));
+}
+
+std::size_t
+Settings::getNodeCacheQuota() const
+{
+    return (std::size_t)(getTileCacheSize() * (_imp->_nodeCacheQuotaPercent->getValue() / 100.));
+}
+
+std::size_t
+Settings::getViewerReservedCacheSize() const
+{
+    return (std::size_t)(getTileCacheSize() * (_imp->_viewerReservedCachePercent->getValue() / 100.));
+}
+
+int
+Settings::getTileCachePages() const
+{
+    return _imp->_tileCachePages->getValue();
+}
+
+bool
+Settings::isTileCacheInterleavedAcrossNUMANodes() const
+{
+    return _imp->_tileCacheInterleaveNUMANodes->getValue();
+}
+
+bool
+Settings::isReadFilesSystemCacheBypassEnabled() const
+{
+    return _imp->_bypassSystemCacheForReads->getValue();
+}
+
+int
+Settings::getTileCacheTileSizePo2() const
+{
+    return NATRON_TILE_SIZE_PO2_MIN + _imp->_tileCacheTileSize->getValue();
+}
+
+void
+Settings::setTileCacheTileSizePo2(int tileSizePo2)
+{
+    _imp->_tileCacheTileSize->setValue(tileSizePo2 - NATRON_TILE_SIZE_PO2_MIN);
+}
+
 bool
 Settings::onKnobValueChanged(const KnobIPtr& k,
                              ValueChangedReasonEnum reason,
@@ -2711,10 +3177,15 @@ Settings::onKnobValueChanged(const KnobIPtr& k,
     Q_EMIT settingChanged(k, reason);
     bool ret = true;
 
-    if ( k == _imp->_maxDiskCacheSizeGb ) {
+    if ( k == _imp->_maxDiskCacheSizeGb || k == _imp->_compressedCacheTierSizeMb || k == _imp->_remoteCacheTierPath || k == _imp->_remoteCacheTierMinRenderTimeMs ||
+         k == _imp->_diskCacheFlushWatermarkMb || k == _imp->_cacheEvictionPolicy ||
+         k == _imp->_projectCacheQuotaPercent || k == _imp->_nodeCacheQuotaPercent || k == _imp->_viewerReservedCachePercent ||
+         k == _imp->_tileCachePages || k == _imp->_tileCacheInterleaveNUMANodes ) {
         _imp->refreshCacheSize();
     }  else if ( k == _imp->_numberOfThreads ) {
         _imp->restoreNumThreads();
+    }  else if ( k == _imp->_numberOfIOThreads ) {
+        _imp->restoreNumIOThreads();
     } else if ( k == _imp->_ocioConfigKnob ) {
         if (_imp->_ocioConfigKnob->getActiveEntry().id == NATRON_CUSTOM_OCIO_CONFIG_NAME) {
             _imp->_customOcioConfigFile->setEnabled(true);
@@ -2753,6 +3224,16 @@ Settings::onKnobValueChanged(const KnobIPtr& k,
         if (reply == eStandardButtonYes) {
             crash_application();
         }
+    } else if ( ( k == _imp->_calibrateButton ) && (reason == eValueChangedReasonUserEdited) ) {
+        EngineCalibrationResults results;
+        EngineCalibration::run(&results);
+        StandardButtonEnum reply = Dialogs::questionDialog( tr("Calibration").toStdString(),
+                                                           EngineCalibration::getReport(results) + '\n' + tr("Apply the recommended settings?").toStdString(), false,
+                                                           StandardButtons(eStandardButtonYes | eStandardButtonNo) );
+        if ( (reply == eStandardButtonYes) && EngineCalibration::apply(results) ) {
+            Dialogs::informationDialog( tr("Calibration").toStdString(),
+                                        tr("The cache tile size changes when %1 is restarted.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ).toStdString() );
+        }
     } else if ( ( k == _imp->_scriptEditorFontChoice ) || ( k == _imp->_scriptEditorFontSize ) ) {
         appPTR->reloadScriptEditorFonts();
     } else if ( k == _imp->_enableOpenGL ) {
@@ -2856,6 +3337,42 @@ Settings::getAutoProxyMipMapLevel() const
     return (unsigned int)_imp->_autoProxyLevel->getValue() + 1;
 }
 
+bool
+Settings::isRealTimePlaybackEnabled() const
+{
+    return _imp->_realTimePlayback->getValue();
+}
+
+bool
+Settings::isProgressiveViewerRenderEnabled() const
+{
+    return _imp->_progressiveViewerRender->getValue();
+}
+
+bool
+Settings::isViewerIdleCachingEnabled() const
+{
+    return _imp->_viewerIdleCaching->getValue();
+}
+
+double
+Settings::getViewerIdleCachingMemoryShare() const
+{
+    return _imp->_viewerIdleCachingMemoryShare->getValue() / 100.;
+}
+
+bool
+Settings::isViewerFlipbookEnabled() const
+{
+    return _imp->_viewerFlipbook->getValue();
+}
+
+std::size_t
+Settings::getViewerFlipbookMaxMemoryBytes() const
+{
+    return (std::size_t)_imp->_viewerFlipbookMaxMemory->getValue() * 1024 * 1024;
+}
+
 int
 Settings::getMaxOpenedNodesViewerContext() const
 {
@@ -2901,6 +3418,18 @@ Settings::setNumberOfThreads(int threadsNb)
     _imp->_numberOfThreads->setValue(threadsNb);
 }
 
+int
+Settings::getMaxIOTasksPerMount() const
+{
+    return _imp->_maxIOTasksPerMount->getValue();
+}
+
+int
+Settings::getNumberOfThreadsReservedForViewer() const
+{
+    return _imp->_numberOfThreadsReservedForViewer->getValue();
+}
+
 bool
 Settings::isAutoPreviewOnForNewProjects() const
 {
@@ -3986,6 +4515,12 @@ Settings::getIsFullRecoverySaveModeEnabled() const
     return _imp->_saveSafetyMode->getValue();
 }
 
+bool
+Settings::isBinaryProjectFormatEnabled() const
+{
+    return _imp->_binaryProjectFormat->getValue();
+}
+
 KnobPathPtr
 Settings::getFileDialogFavoritePathsKnob() const
 {
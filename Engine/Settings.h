@@ -127,12 +127,72 @@ public:
 
     std::size_t getTileCacheSize() const;
 
+    /**
+     * @brief Returns the tileSizePo2 the tile cache should be created with, see NATRON_TILE_SIZE_PO2_DEFAULT
+     **/
+    int getTileCacheTileSizePo2() const;
+
+    void setTileCacheTileSizePo2(int tileSizePo2);
+
+    /**
+     * @brief Returns the maximum size in bytes of the tile cache compressed tier, 0 if disabled
+     **/
+    std::size_t getCompressedCacheTierSize() const;
+
+    void setCompressedCacheTierSize(std::size_t size);
+
+    /**
+     * @brief Returns the directory of the tile cache remote tier, empty if disabled, and the minimum time in seconds
+     * an image must have taken to render to be written there, see CacheBase::setRemoteTier()
+     **/
+    std::string getRemoteCacheTierPath() const;
+    double getRemoteCacheTierMinimumRenderTime() const;
+
+    /**
+     * @brief Returns the amount in bytes of tiles not yet written to disk above which the disk cache flushes them
+     **/
+    std::size_t getDiskCacheFlushWatermark() const;
+
+    /**
+     * @brief Returns the policy the tile cache should use to evict entries, a value of CacheBase::CacheEvictionPolicyEnum
+     **/
+    int getCacheEvictionPolicy() const;
+
+    /**
+     * @brief Returns the quotas in bytes of the tile cache quota groups, see CacheBase::setQuotaGroupSize()
+     **/
+    std::size_t getProjectCacheQuota() const;
+    std::size_t getNodeCacheQuota() const;
+    std::size_t getViewerReservedCacheSize() const;
+
+    /**
+     * @brief Returns how the tile cache allocates its storage in RAM, see CacheBase::setTileStorageAllocation().
+     * getTileCachePages() returns a value of CacheBase::CacheTileStoragePagesEnum
+     **/
+    int getTileCachePages() const;
+    bool isTileCacheInterleavedAcrossNUMANodes() const;
+
+    /**
+     * @brief If true, the files decoded by the readers are released from the system page cache once decoded
+     **/
+    bool isReadFilesSystemCacheBypassEnabled() const;
+
     bool getColorPickerLinear() const;
 
     int getNumberOfThreads() const;
 
     void setNumberOfThreads(int threadsNb);
 
+    /**
+     * @brief Returns the maximum number of I/O-bound render tasks accessing the same mount point concurrently, or 0 if unlimited.
+     **/
+    int getMaxIOTasksPerMount() const;
+
+    /**
+     * @brief Returns the number of render threads that only the renders of priority eRenderPriorityInteractive may use, see RenderTaskDispatcher
+     **/
+    int getNumberOfThreadsReservedForViewer() const;
+
     void populateSystemFonts(const std::vector<std::string>& fonts);
     
     bool doesKnobChangeRequireRestart(const KnobIPtr& knob);
@@ -252,6 +312,14 @@ public:
     bool isAutoWipeEnabled() const;
     bool isAutoProxyEnabled() const;
     unsigned int getAutoProxyMipMapLevel() const;
+    bool isRealTimePlaybackEnabled() const;
+    bool isProgressiveViewerRenderEnabled() const;
+    bool isViewerIdleCachingEnabled() const;
+
+    // Between 0 and 1
+    double getViewerIdleCachingMemoryShare() const;
+    bool isViewerFlipbookEnabled() const;
+    std::size_t getViewerFlipbookMaxMemoryBytes() const;
     int getMaxOpenedNodesViewerContext() const;
     bool isViewerKeysEnabled() const;
     ///////////////////////////////////////////////////////
@@ -360,6 +428,12 @@ public:
 
     GLRendererID getActiveOpenGLRendererID() const;
 
+    /**
+     * @brief Returns the renderers on which OpenGL contexts should be created for rendering:
+     * all renderers if "Use all OpenGL renderers" is checked, otherwise only the active renderer.
+     **/
+    void getOpenGLRendererIDsForRendering(std::vector<GLRendererID>* rendererIDs) const;
+
     void populateOpenGLRenderers(const std::list<OpenGLRendererInfo>& renderers);
 
     bool isOpenGLRenderingEnabled() const;
@@ -368,10 +442,22 @@ public:
 
     int getMaxOpenGLContexts() const;
 
+    /**
+     * @brief Returns the max number of OSMesa contexts, 0 meaning one per hardware thread
+     **/
+    int getMaxCPUOpenGLContexts() const;
+
+    /**
+     * @brief Returns the number of threads llvmpipe should use per OSMesa context, 0 meaning the driver default
+     **/
+    int getCPUOpenGLRendererThreads() const;
+
     bool isDriveLetterToUNCPathConversionEnabled() const;
 
     bool getIsFullRecoverySaveModeEnabled() const;
 
+    bool isBinaryProjectFormatEnabled() const;
+
     KnobPathPtr getFileDialogFavoritePathsKnob() const;
 
     void addKeybind(const std::string & grouping,
@@ -0,0 +1,318 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "StartupTrace.h"
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+
+#include "Global/FStreamsSupport.h"
+
+#include "Engine/MemoryInfo.h"
+#include "Engine/Timer.h"
+
+// Number of per-plug-in events listed in the report, sorted by decreasing duration
+#define NATRON_STARTUP_TRACE_REPORT_N_SLOWEST_PLUGINS 20
+
+NATRON_NAMESPACE_ENTER;
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+struct StartupTraceEvent
+{
+    std::string name;
+    const char* category;
+    double startTime; // seconds since the trace was enabled
+    double duration; // seconds
+    bool hasMemory;
+    std::size_t startRSS, endRSS;
+    int threadIndex;
+};
+
+struct StartupTraceData
+{
+    QMutex lock;
+    bool enabled;
+    bool finished;
+    std::string chromeTraceFilePath;
+    boost::scoped_ptr<TimeLapse> timer;
+    std::vector<StartupTraceEvent> events;
+
+    // Maps each thread that recorded an event to a small index, the main thread being 0
+    std::map<QThread*, int> threadIndices;
+
+    StartupTraceData()
+    : lock()
+    , enabled(false)
+    , finished(false)
+    , chromeTraceFilePath()
+    , timer()
+    , events()
+    , threadIndices()
+    {
+    }
+
+    int getThreadIndex(QThread* thread)
+    {
+        std::map<QThread*, int>::iterator found = threadIndices.find(thread);
+        if ( found != threadIndices.end() ) {
+            return found->second;
+        }
+        int index = (int)threadIndices.size();
+        threadIndices.insert( std::make_pair(thread, index) );
+        return index;
+    }
+};
+
+StartupTraceData&
+getTraceData()
+{
+    static StartupTraceData data;
+    return data;
+}
+
+std::string
+escapeJSONString(const std::string& str)
+{
+    std::string ret;
+    ret.reserve( str.size() );
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        unsigned char c = (unsigned char)str[i];
+        if ( (c == '"') || (c == '\\') ) {
+            ret.push_back('\\');
+            ret.push_back(str[i]);
+        } else if (c < 0x20) {
+            const char* hexDigits = "0123456789abcdef";
+            ret.append("\\u00");
+            ret.push_back(hexDigits[c >> 4]);
+            ret.push_back(hexDigits[c & 0xf]);
+        } else {
+            ret.push_back(str[i]);
+        }
+    }
+    return ret;
+}
+
+bool
+eventStartsBefore(const StartupTraceEvent& lhs, const StartupTraceEvent& rhs)
+{
+    // Parents start earlier or at the same time but last longer than their children
+    if (lhs.startTime != rhs.startTime) {
+        return lhs.startTime < rhs.startTime;
+    }
+    return lhs.duration > rhs.duration;
+}
+
+bool
+eventLastsLonger(const StartupTraceEvent& lhs, const StartupTraceEvent& rhs)
+{
+    return lhs.duration > rhs.duration;
+}
+
+void
+printReport(const std::vector<StartupTraceEvent>& events, double totalTime)
+{
+    std::vector<StartupTraceEvent> phases, plugins;
+    for (std::vector<StartupTraceEvent>::const_iterator it = events.begin(); it != events.end(); ++it) {
+        if (it->hasMemory) {
+            phases.push_back(*it);
+        } else {
+            plugins.push_back(*it);
+        }
+    }
+    std::sort(phases.begin(), phases.end(), eventStartsBefore);
+    std::sort(plugins.begin(), plugins.end(), eventLastsLonger);
+
+    std::ios_base::fmtflags coutFlags = std::cout.flags();
+    std::streamsize coutPrecision = std::cout.precision();
+
+    std::cout << "Startup trace: " << std::fixed << std::setprecision(3) << totalTime << " s" << std::endl;
+    std::cout << "  time (s)   memory delta   resident   phase" << std::endl;
+
+    // Indent each phase by the number of phases of the same thread that enclose it
+    std::vector<const StartupTraceEvent*> enclosing;
+    for (std::vector<StartupTraceEvent>::const_iterator it = phases.begin(); it != phases.end(); ++it) {
+        while ( !enclosing.empty() && ( (enclosing.back()->startTime + enclosing.back()->duration < it->startTime) || (enclosing.back()->threadIndex != it->threadIndex) ) ) {
+            enclosing.pop_back();
+        }
+        double delta = (double)it->endRSS - (double)it->startRSS;
+        QString deltaStr = printAsRAM( (U64)(delta < 0 ? -delta : delta) );
+        std::cout << "  " << std::setw(8) << it->duration << "   "
+                  << (delta < 0 ? "-" : "+") << std::setw(12) << std::left << deltaStr.toStdString() << std::right << "  "
+                  << std::setw(9) << std::left << printAsRAM(it->endRSS).toStdString() << std::right << "  "
+                  << std::string(enclosing.size() * 2, ' ') << it->name << std::endl;
+        enclosing.push_back(&*it);
+    }
+
+    if ( !plugins.empty() ) {
+        double pluginsTotal = 0.;
+        for (std::vector<StartupTraceEvent>::const_iterator it = plugins.begin(); it != plugins.end(); ++it) {
+            pluginsTotal += it->duration;
+        }
+        std::cout << "Plug-in actions: " << plugins.size() << " in " << pluginsTotal << " s, slowest:" << std::endl;
+        std::size_t nPrinted = std::min( plugins.size(), (std::size_t)NATRON_STARTUP_TRACE_REPORT_N_SLOWEST_PLUGINS );
+        for (std::size_t i = 0; i < nPrinted; ++i) {
+            std::cout << "  " << std::setw(8) << plugins[i].duration << "   " << plugins[i].category << "   " << plugins[i].name << std::endl;
+        }
+    }
+    std::cout << "Peak resident memory: " << printAsRAM( getPeakRSS() ).toStdString() << std::endl;
+
+    std::cout.flags(coutFlags);
+    std::cout.precision(coutPrecision);
+} // printReport
+
+bool
+writeChromeTrace(const std::vector<StartupTraceEvent>& events, const std::string& filePath)
+{
+    FStreamsSupport::ofstream ofile;
+    FStreamsSupport::open(&ofile, filePath);
+    if (!ofile) {
+        return false;
+    }
+
+    // Durations are expressed in microseconds. See the "Trace Event Format" specification.
+    ofile << "{\"traceEvents\":[\n";
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const StartupTraceEvent& e = events[i];
+        ofile << "{\"name\":\"" << escapeJSONString(e.name) << "\",\"cat\":\"" << e.category << "\",\"ph\":\"X\""
+              << ",\"ts\":" << (long long)(e.startTime * 1e6) << ",\"dur\":" << (long long)(e.duration * 1e6)
+              << ",\"pid\":1,\"tid\":" << e.threadIndex;
+        if (e.hasMemory) {
+            ofile << ",\"args\":{\"rssStartBytes\":" << (unsigned long long)e.startRSS << ",\"rssEndBytes\":" << (unsigned long long)e.endRSS << "}";
+        }
+        ofile << "}" << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    ofile << "],\"displayTimeUnit\":\"ms\"}\n";
+
+    return (bool)ofile;
+} // writeChromeTrace
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+void
+StartupTrace::setEnabled(const std::string& chromeTraceFilePath)
+{
+    StartupTraceData& data = getTraceData();
+    QMutexLocker k(&data.lock);
+    if (data.enabled) {
+        return;
+    }
+    data.enabled = true;
+    data.chromeTraceFilePath = chromeTraceFilePath;
+    data.timer.reset( new TimeLapse );
+
+    // The thread enabling the trace is the main thread
+    (void)data.getThreadIndex( QThread::currentThread() );
+}
+
+bool
+StartupTrace::isEnabled()
+{
+    StartupTraceData& data = getTraceData();
+    QMutexLocker k(&data.lock);
+    return data.enabled && !data.finished;
+}
+
+void
+StartupTrace::finish()
+{
+    StartupTraceData& data = getTraceData();
+    std::vector<StartupTraceEvent> events;
+    std::string filePath;
+    double totalTime;
+    {
+        QMutexLocker k(&data.lock);
+        if (!data.enabled || data.finished) {
+            return;
+        }
+        data.finished = true;
+        events.swap(data.events);
+        filePath = data.chromeTraceFilePath;
+        totalTime = data.timer->getTimeSinceCreation();
+    }
+
+    printReport(events, totalTime);
+    if ( !filePath.empty() ) {
+        if ( writeChromeTrace(events, filePath) ) {
+            std::cout << "Startup trace written to " << filePath << std::endl;
+        } else {
+            std::cerr << "Failed to write the startup trace to " << filePath << std::endl;
+        }
+    }
+} // finish
+
+StartupTrace::Scope_RAII::Scope_RAII(const std::string& name,
+                                     const char* category,
+                                     bool recordMemory)
+: _name()
+, _category(category)
+, _enabled( StartupTrace::isEnabled() )
+, _recordMemory(recordMemory)
+, _startTime(0)
+, _startRSS(0)
+{
+    if (!_enabled) {
+        return;
+    }
+    _name = name;
+    if (_recordMemory) {
+        _startRSS = getCurrentRSS();
+    }
+    StartupTraceData& data = getTraceData();
+    QMutexLocker k(&data.lock);
+    _startTime = data.timer->getTimeSinceCreation();
+}
+
+StartupTrace::Scope_RAII::~Scope_RAII()
+{
+    if (!_enabled) {
+        return;
+    }
+    StartupTraceEvent e;
+    e.name = _name;
+    e.category = _category;
+    e.startTime = _startTime;
+    e.hasMemory = _recordMemory;
+    e.startRSS = _startRSS;
+    e.endRSS = _recordMemory ? getCurrentRSS() : 0;
+
+    StartupTraceData& data = getTraceData();
+    QMutexLocker k(&data.lock);
+    if (data.finished) {
+        return;
+    }
+    e.duration = data.timer->getTimeSinceCreation() - _startTime;
+    e.threadIndex = data.getThreadIndex( QThread::currentThread() );
+    data.events.push_back(e);
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,92 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_STARTUPTRACE_H
+#define NATRON_ENGINE_STARTUPTRACE_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+#include <string>
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Records the wall time and the memory used by each phase of the application startup
+ * (Python initialization, plug-ins loading, OpenFX describe actions, project loading...).
+ * Nothing is recorded unless the trace was enabled with the --startup-trace command-line option.
+ * When the startup is finished, the report is printed and optionally exported as a Chrome trace
+ * (to be opened with chrome://tracing or https://ui.perfetto.dev).
+ * All functions are MT-safe.
+ **/
+class StartupTrace
+{
+public:
+
+    /**
+     * @brief Enable the trace. If chromeTraceFilePath is not empty, the events are also written
+     * to this file in the Chrome trace event format when finish() is called.
+     **/
+    static void setEnabled(const std::string& chromeTraceFilePath);
+
+    static bool isEnabled();
+
+    /**
+     * @brief Called when the startup is done, i.e: when the first application instance is loaded and before
+     * any render starts. This prints the report and writes the Chrome trace file. Subsequent calls do nothing.
+     **/
+    static void finish();
+
+    /**
+     * @brief Records an event for the lifetime of this object. Per-plug-in events (such as describe
+     * actions) do not record memory since there may be thousands of them.
+     **/
+    class Scope_RAII
+    {
+    public:
+
+        Scope_RAII(const std::string& name,
+                   const char* category,
+                   bool recordMemory = true);
+
+        ~Scope_RAII();
+
+    private:
+
+        std::string _name;
+        const char* _category;
+        bool _enabled;
+        bool _recordMemory;
+        double _startTime;
+        std::size_t _startRSS;
+    };
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_STARTUPTRACE_H
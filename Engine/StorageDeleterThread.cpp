@@ -25,20 +25,125 @@
 #include "StorageDeleterThread.h"
 
 #include <list>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#ifdef __GLIBC__
+#include <malloc.h> // malloc_trim
+#endif
 
 #include <QMutex>
 #include <QWaitCondition>
+#include <QElapsedTimer>
 
 #include "Engine/AppManager.h"
 #include "Engine/Cache.h"
 #include "Engine/ImageStorage.h"
+#include "Engine/PluginMemory.h"
+
+// How often the thread checks whether the system reports memory pressure, in milliseconds
+#define NATRON_MEMORY_PRESSURE_POLL_INTERVAL_MS 500
+
+// Above this fraction of its memory limit (cgroup memory.high or memory.max), the process is considered under pressure
+#define NATRON_MEMORY_PRESSURE_LIMIT_RATIO 0.9
+
+// Above this share of time (in percents over the last 10 seconds) during which some tasks were stalled waiting for memory
+// (Linux PSI), the process is considered under pressure
+#define NATRON_MEMORY_PRESSURE_PSI_THRESHOLD 10.
+
+// The fraction of the tile cache evicted when PSI reports pressure but no memory limit applies
+#define NATRON_MEMORY_PRESSURE_PSI_EVICT_RATIO 0.1
 
 NATRON_NAMESPACE_ENTER;
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+#ifdef __NATRON_LINUX__
+/**
+ * @brief Reads a single unsigned value from a cgroup file. Returns false if the file does not exist
+ * or if it contains "max" (no limit).
+ **/
+bool
+readCGroupValue(const char* filePath, std::size_t* value)
+{
+    FILE* file = std::fopen(filePath, "r");
+    if (!file) {
+        return false;
+    }
+    unsigned long long v = 0;
+    bool ok = std::fscanf(file, "%llu", &v) == 1;
+    std::fclose(file);
+    if (!ok) {
+        return false;
+    }
+    *value = (std::size_t)v;
+    return true;
+} // readCGroupValue
+
+/**
+ * @brief Returns the "some avg10" value of the Linux PSI memory pressure, or 0 if not available
+ **/
+double
+readPSIMemorySomeAvg10()
+{
+    FILE* file = std::fopen("/proc/pressure/memory", "r");
+    if (!file) {
+        return 0.;
+    }
+    double avg10 = 0.;
+    if (std::fscanf(file, "some avg10=%lf", &avg10) != 1) {
+        avg10 = 0.;
+    }
+    std::fclose(file);
+    return avg10;
+} // readPSIMemorySomeAvg10
+#endif // __NATRON_LINUX__
+
+/**
+ * @brief Returns the number of bytes the caches should free to relieve the memory pressure reported
+ * by the system, or 0 if there is none.
+ **/
+std::size_t
+getSystemMemoryPressureBytesToFree(std::size_t tileCacheSize)
+{
+    std::size_t ret = 0;
+#ifdef __NATRON_LINUX__
+    // The memory limit of the cgroup of the process, as set by container runtimes (cgroup v2 then v1)
+    std::size_t current = 0, limit = 0;
+    bool hasLimit = false;
+    if ( readCGroupValue("/sys/fs/cgroup/memory.current", &current) ) {
+        hasLimit = readCGroupValue("/sys/fs/cgroup/memory.high", &limit) || readCGroupValue("/sys/fs/cgroup/memory.max", &limit);
+    } else if ( readCGroupValue("/sys/fs/cgroup/memory/memory.usage_in_bytes", &current) ) {
+        hasLimit = readCGroupValue("/sys/fs/cgroup/memory/memory.limit_in_bytes", &limit);
+    }
+    if (hasLimit && limit > 0) {
+        std::size_t threshold = (std::size_t)(limit * NATRON_MEMORY_PRESSURE_LIMIT_RATIO);
+        if (current > threshold) {
+            ret = current - threshold;
+        }
+    }
+
+    if ( (ret == 0) && (readPSIMemorySomeAvg10() > NATRON_MEMORY_PRESSURE_PSI_THRESHOLD) ) {
+        ret = (std::size_t)(tileCacheSize * NATRON_MEMORY_PRESSURE_PSI_EVICT_RATIO);
+    }
+#else
+    Q_UNUSED(tileCacheSize);
+#endif
+    return ret;
+} // getSystemMemoryPressureBytesToFree
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 struct StorageDeleterThreadPrivate
 {
     mutable QMutex entriesQueueMutex;
-    std::list<ImageStorageBasePtr> entriesQueue;
+
+    // Each entry with its size when it was queued
+    std::list<std::pair<ImageStorageBasePtr, std::size_t> > entriesQueue;
+
+    // The sum of the sizes in entriesQueue
+    std::size_t pendingBytes;
     int cacheEvictChecksRequest;
     QWaitCondition noworkCond;
     QMutex mustQuitMutex;
@@ -48,6 +153,7 @@ struct StorageDeleterThreadPrivate
     StorageDeleterThreadPrivate()
     : entriesQueueMutex()
     , entriesQueue()
+    , pendingBytes(0)
     , cacheEvictChecksRequest(0)
     , noworkCond()
     , mustQuitMutex()
@@ -89,7 +195,11 @@ StorageDeleterThread::appendToQueue(const std::list<ImageStorageBasePtr> & entri
 
     {
         QMutexLocker k(&_imp->entriesQueueMutex);
-        _imp->entriesQueue.insert( _imp->entriesQueue.begin(), entriesToDelete.begin(), entriesToDelete.end() );
+        for (std::list<ImageStorageBasePtr>::const_reverse_iterator it = entriesToDelete.rbegin(); it != entriesToDelete.rend(); ++it) {
+            std::size_t size = *it ? (*it)->getBufferSize() : 0;
+            _imp->entriesQueue.push_front( std::make_pair(*it, size) );
+            _imp->pendingBytes += size;
+        }
     }
     if ( !isRunning() ) {
         start();
@@ -114,6 +224,14 @@ StorageDeleterThread::checkCachesMemory()
     }
 }
 
+std::size_t
+StorageDeleterThread::getPendingDeletionBytes() const
+{
+    QMutexLocker k(&_imp->entriesQueueMutex);
+
+    return _imp->pendingBytes;
+}
+
 void
 StorageDeleterThread::quitThread()
 {
@@ -126,7 +244,7 @@ StorageDeleterThread::quitThread()
 
     {
         QMutexLocker k2(&_imp->entriesQueueMutex);
-        _imp->entriesQueue.push_back( ImageStorageBasePtr() );
+        _imp->entriesQueue.push_back( std::make_pair(ImageStorageBasePtr(), (std::size_t)0) );
         _imp->noworkCond.wakeOne();
     }
     while (_imp->mustQuit) {
@@ -146,6 +264,9 @@ StorageDeleterThread::isWorking() const
 void
 StorageDeleterThread::run()
 {
+    QElapsedTimer pressureTimer;
+    pressureTimer.start();
+
     for (;;) {
         bool quit;
         {
@@ -155,6 +276,7 @@ StorageDeleterThread::run()
 
         {
             ImageStorageBasePtr front;
+            std::size_t frontSize = 0;
             int evictRequest = 0;
             {
                 QMutexLocker k(&_imp->entriesQueueMutex);
@@ -167,28 +289,66 @@ StorageDeleterThread::run()
 
                     return;
                 }
-                while ( _imp->entriesQueue.empty() ) {
-                    _imp->noworkCond.wait(&_imp->entriesQueueMutex);
+
+                // Wake up regularly even without work to check the memory pressure
+                while ( _imp->entriesQueue.empty() && (_imp->cacheEvictChecksRequest == 0) &&
+                        (pressureTimer.elapsed() < NATRON_MEMORY_PRESSURE_POLL_INTERVAL_MS) ) {
+                    _imp->noworkCond.wait(&_imp->entriesQueueMutex, NATRON_MEMORY_PRESSURE_POLL_INTERVAL_MS);
                 }
 
                 if (!_imp->entriesQueue.empty() ) {
-                    front = _imp->entriesQueue.front();
+                    front = _imp->entriesQueue.front().first;
+                    frontSize = _imp->entriesQueue.front().second;
                     _imp->entriesQueue.pop_front();
                 }
-                if (_imp->cacheEvictChecksRequest > 0) {
-                    _imp->cacheEvictChecksRequest = 0;
-                    evictRequest = _imp->cacheEvictChecksRequest;
-                }
+                evictRequest = _imp->cacheEvictChecksRequest;
+                _imp->cacheEvictChecksRequest = 0;
             }
             if (front) {
                 // if we are the last owner using this buffer, remove it
                 if (front.use_count() == 1) {
                     front->deallocateMemory();
                 }
-            } else if (evictRequest > 0) {
-                appPTR->getGeneralPurposeCache()->evictLRUEntries(0);
-                appPTR->getTileCache()->evictLRUEntries(0);
+                front.reset();
+
+                QMutexLocker k(&_imp->entriesQueueMutex);
+                _imp->pendingBytes -= std::min(_imp->pendingBytes, frontSize);
+            }
+
+            CacheBasePtr tileCache = appPTR->getTileCache();
+            CacheBasePtr generalCache = appPTR->getGeneralPurposeCache();
+            if (!tileCache || !generalCache) {
+                continue;
+            }
+
+            std::size_t pressureBytesToFree = 0;
+            if (pressureTimer.elapsed() >= NATRON_MEMORY_PRESSURE_POLL_INTERVAL_MS) {
+                pressureTimer.restart();
+                pressureBytesToFree = getSystemMemoryPressureBytesToFree( tileCache->getCurrentSize() );
+            }
+
+            if (evictRequest > 0 || pressureBytesToFree > 0) {
+                // Under memory pressure, evict from the tile cache the amount the system reports, even if the
+                // cache is still below its maximum size: evictLRUEntries() frees until the cache size is below
+                // its maximum size minus the given amount.
+                std::size_t nBytesToFree = 0;
+                if (pressureBytesToFree > 0) {
+                    std::size_t curSize = tileCache->getCurrentSize();
+                    std::size_t maxSize = tileCache->getMaximumCacheSize();
+                    std::size_t targetSize = curSize - std::min(curSize, pressureBytesToFree);
+                    nBytesToFree = maxSize > targetSize ? maxSize - targetSize : 0;
+                }
+                // The idle buffers kept for plug-ins are freed first: they are cheaper to re-allocate than cache entries
+                PluginMemory::trimPool();
+                generalCache->evictLRUEntries(0);
+                tileCache->evictLRUEntries(nBytesToFree);
+            }
+#ifdef __GLIBC__
+            if (pressureBytesToFree > 0) {
+                // Give back to the system the memory freed in the heap, otherwise it stays accounted to the process
+                malloc_trim(0);
             }
+#endif
      
         } // front. After this scope, the image is guarenteed to be freed
       
@@ -28,6 +28,7 @@
 #include "Global/Macros.h"
 
 #include <list>
+#include <cstddef>
 
 #include <QtCore/QThread>
 
@@ -41,7 +42,10 @@ NATRON_NAMESPACE_ENTER;
 
 /**
  * @brief The point of this thread is to delete the content of the list in a separate thread so the thread calling
- * get() doesn't wait for all the entries to be deleted (which can be expensive for large images)
+ * get() doesn't wait for all the entries to be deleted (which can be expensive for large images).
+ * It also evicts cache entries when the caches approach their size (see CacheBase::evictLRUEntries()), and when the system reports memory pressure:
+ * on Linux, the memory limit of the cgroup of the process (e.g: a container) and the PSI memory stall information
+ * are checked regularly.
  **/
 struct StorageDeleterThreadPrivate;
 class StorageDeleterThread
@@ -61,6 +65,11 @@ public:
 
     void checkCachesMemory();
 
+    /**
+     * @brief Returns the size in bytes of the storages queued but not yet deleted
+     **/
+    std::size_t getPendingDeletionBytes() const;
+
     void quitThread();
 
     bool isWorking() const;
@@ -40,6 +40,21 @@
 
 NATRON_NAMESPACE_ENTER;
 
+#ifdef NATRON_TLS_FAST_PATH
+NATRON_THREAD_LOCAL TLSHolderBase::FastPathSlot TLSHolderBase::_fastPathSlots[NATRON_TLS_FAST_PATH_N_SLOTS];
+
+// Protects lastHolderID
+static QMutex holderIDMutex;
+static U64 lastHolderID = 0;
+
+U64
+TLSHolderBase::generateHolderID()
+{
+    QMutexLocker k(&holderIDMutex);
+
+    return ++lastHolderID;
+}
+#endif
 
 AppTLS::AppTLS()
     : _objectMutex()
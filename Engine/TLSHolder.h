@@ -50,6 +50,28 @@
 
 #define NATRON_TLS_DISABLE_COPY
 
+// The compiler thread-local storage of plain data, if supported
+#if defined(_MSC_VER)
+#define NATRON_THREAD_LOCAL __declspec(thread)
+#elif defined(__APPLE__) && defined(__clang__)
+// Apple clang supports __thread since Xcode 8, which also introduced thread_local
+#if defined(__has_feature) && __has_feature(cxx_thread_local)
+#define NATRON_THREAD_LOCAL __thread
+#endif
+#elif defined(__GNUC__)
+#define NATRON_THREAD_LOCAL __thread
+#endif
+
+// When defined, the TLS of the current thread is first looked up in a small per-thread cache indexed by holder
+// before the map of the holder: the TLS of the most used holders is then retrieved without any lock.
+// A copied TLS must be looked up on the spawner thread, so this is only possible when the copy is disabled.
+#if defined(NATRON_THREAD_LOCAL) && defined(NATRON_TLS_DISABLE_COPY)
+#define NATRON_TLS_FAST_PATH
+#endif
+
+// Number of slots of the per-thread cache of the fast path, must be a power of 2
+#define NATRON_TLS_FAST_PATH_N_SLOTS 64
+
 NATRON_NAMESPACE_ENTER;
 
 ///This must be stored as a shared_ptr
@@ -62,13 +84,48 @@ public:
     // TODO: enable_shared_from_this
     // constructors should be privatized in any class that derives from boost::enable_shared_from_this<>
 
-    TLSHolderBase() {}
+    TLSHolderBase()
+#ifdef NATRON_TLS_FAST_PATH
+    : _holderID( generateHolderID() )
+#endif
+    {}
 
 public:
     virtual ~TLSHolderBase() {}
 
 protected:
 
+#ifdef NATRON_TLS_FAST_PATH
+    /**
+     * @brief Returns the data cached for this holder on the current thread by setFastPathData(), or NULL.
+     **/
+    const void* getFastPathData() const
+    {
+        const FastPathSlot& slot = _fastPathSlots[_holderID & (NATRON_TLS_FAST_PATH_N_SLOTS - 1)];
+        return slot.holderID == _holderID ? slot.data : 0;
+    }
+
+    /**
+     * @brief Caches the data of this holder for the current thread. It must remain valid until
+     * clearFastPathData() is called on the current thread.
+     **/
+    void setFastPathData(const void* data) const
+    {
+        FastPathSlot& slot = _fastPathSlots[_holderID & (NATRON_TLS_FAST_PATH_N_SLOTS - 1)];
+        slot.holderID = _holderID;
+        slot.data = data;
+    }
+
+    void clearFastPathData() const
+    {
+        FastPathSlot& slot = _fastPathSlots[_holderID & (NATRON_TLS_FAST_PATH_N_SLOTS - 1)];
+        if (slot.holderID == _holderID) {
+            slot.holderID = 0;
+            slot.data = 0;
+        }
+    }
+#endif
+
     /**
      * @brief Returns true if cleanupPerThreadData would do anything OR would return true.
      * It does not return the same value as cleanupPerThreadData, since cleanupPerThreadData
@@ -89,6 +146,24 @@ protected:
      **/
     virtual void copyTLS(const QThread* fromThread, const QThread* toThread) const = 0;
 #endif
+
+private:
+
+#ifdef NATRON_TLS_FAST_PATH
+    struct FastPathSlot
+    {
+        // The holder owning the slot, 0 if none. IDs are never reused, so a slot left by a destroyed holder never matches
+        U64 holderID;
+        const void* data;
+    };
+
+    static U64 generateHolderID();
+
+    U64 _holderID;
+
+    // Zero-initialized for each thread
+    static NATRON_THREAD_LOCAL FastPathSlot _fastPathSlots[NATRON_TLS_FAST_PATH_N_SLOTS];
+#endif
 };
 
 
@@ -220,6 +295,9 @@ private:
     boost::shared_ptr<T> copyAndReturnNewTLS(const QThread* fromThread, const QThread* toThread) const WARN_UNUSED_RETURN;
 #endif
 
+    // Returns the data of the given thread in perThreadData, or NULL. The pointer remains valid until cleanupPerThreadData() is called for the thread.
+    const boost::shared_ptr<T>* findThreadData(const QThread* thread) const;
+
     //Store a cache on the object to be faster than using the getOrCreate... function from AppTLS
     mutable QReadWriteLock perThreadDataMutex;
     mutable ThreadDataMap perThreadData;
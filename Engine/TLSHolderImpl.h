@@ -87,9 +87,30 @@ TLSHolder<T>::cleanupPerThreadData(const QThread* curThread) const
         perThreadData.erase(found);
     }
 
+#ifdef NATRON_TLS_FAST_PATH
+    // The per-thread cache can only be cleared from its own thread, which is the case of AppTLS::cleanupTLSForThread()
+    assert( curThread == QThread::currentThread() );
+    clearFastPathData();
+#endif
+
     return perThreadData.empty();
 }
 
+template <typename T>
+const boost::shared_ptr<T>*
+TLSHolder<T>::findThreadData(const QThread* thread) const
+{
+    QReadLocker k(&perThreadDataMutex);
+    const ThreadDataMap& perThreadDataCRef = perThreadData; // take a const ref, since it's a read lock
+    typename ThreadDataMap::const_iterator found = perThreadDataCRef.find(thread);
+    if ( found == perThreadDataCRef.end() ) {
+        return 0;
+    }
+
+    // The nodes of a std::map are not moved by the insertion of other threads
+    return &found->second.value;
+}
+
 template <typename T>
 boost::shared_ptr<T>
 TLSHolder<T>::getTLSDataForThread(QThread* curThread) const
@@ -104,13 +125,9 @@ TLSHolder<T>::getTLSDataForThread(QThread* curThread) const
 #endif
 
     //Attempt to find an object in the map. It will be there if we already called getOrCreateTLSData() for this thread
-    {
-        QReadLocker k(&perThreadDataMutex);
-        const ThreadDataMap& perThreadDataCRef = perThreadData; // take a const ref, since it's a read lock
-        typename ThreadDataMap::const_iterator found = perThreadDataCRef.find(curThread);
-        if ( found != perThreadDataCRef.end() ) {
-            ret = found->second.value;
-        }
+    const boost::shared_ptr<T>* found = findThreadData(curThread);
+    if (found) {
+        ret = *found;
     }
 
     return ret;
@@ -120,14 +137,37 @@ template <typename T>
 boost::shared_ptr<T>
 TLSHolder<T>::getTLSData() const
 {
+#ifdef NATRON_TLS_FAST_PATH
+    const boost::shared_ptr<T>* cached = static_cast<const boost::shared_ptr<T>*>( getFastPathData() );
+    if (cached) {
+        return *cached;
+    }
+    const boost::shared_ptr<T>* found = findThreadData( QThread::currentThread() );
+    if (!found) {
+        return boost::shared_ptr<T>();
+    }
+    setFastPathData(found);
+
+    return *found;
+#else
     QThread* curThread  = QThread::currentThread();
     return getTLSDataForThread(curThread);
+#endif
 }
 
 template <typename T>
 boost::shared_ptr<T>
 TLSHolder<T>::getOrCreateTLSData() const
 {
+#ifdef NATRON_TLS_FAST_PATH
+    const boost::shared_ptr<T>* cached = static_cast<const boost::shared_ptr<T>*>( getFastPathData() );
+    if (cached) {
+        assert(*cached);
+
+        return *cached;
+    }
+#endif
+
     QThread* curThread  = QThread::currentThread();
 
     //This thread might be registered by a spawner thread, copy the TLS and attempt to find the TLS for this holder.
@@ -144,13 +184,14 @@ TLSHolder<T>::getOrCreateTLSData() const
     //Attempt to find an object in the map. It will be there if we already called getOrCreateTLSData() for this thread
     //Note that if present, this call is extremely fast as we do not block other threads
     {
-        QReadLocker k(&perThreadDataMutex);
-        const ThreadDataMap& perThreadDataCRef = perThreadData; // take a const ref, since it's a read lock
-        typename ThreadDataMap::const_iterator found = perThreadDataCRef.find(curThread);
-        if ( found != perThreadDataCRef.end() ) {
-            assert(found->second.value);
+        const boost::shared_ptr<T>* found = findThreadData(curThread);
+        if (found) {
+            assert(*found);
+#ifdef NATRON_TLS_FAST_PATH
+            setFastPathData(found);
+#endif
 
-            return found->second.value;
+            return *found;
         }
     }
 
@@ -161,7 +202,12 @@ TLSHolder<T>::getOrCreateTLSData() const
     data.value.reset(new T);
     {
         QWriteLocker k(&perThreadDataMutex);
-        perThreadData.insert( std::make_pair(curThread, data) );
+        typename ThreadDataMap::iterator inserted = perThreadData.insert( std::make_pair(curThread, data) ).first;
+#ifdef NATRON_TLS_FAST_PATH
+        setFastPathData(&inserted->second.value);
+#else
+        Q_UNUSED(inserted);
+#endif
     }
     assert(data.value);
     return data.value;
@@ -130,6 +130,12 @@ Texture::ensureTextureHasSize(const RectI& bounds,
     if (bounds == _bounds) {
         return false;
     }
+    if ( !_bounds.isNull() && (bounds.width() == _bounds.width()) && (bounds.height() == _bounds.height()) ) {
+        // e.g: the viewer is panned, the storage can be kept as is
+        _bounds = bounds;
+
+        return false;
+    }
     _bounds = bounds;
 
     if (_useOpenGL) {
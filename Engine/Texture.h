@@ -27,6 +27,8 @@
 
 #include "Global/Macros.h"
 
+#include <cassert>
+
 #include "Global/GlobalDefines.h"
 #include "Engine/RectI.h"
 
@@ -110,12 +112,24 @@ public:
 
     /*
      * @brief Ensures that the texture is of size texRect and of the given type
-     * @returns True if something changed, false otherwise
+     * @returns True if the texture storage was re-allocated (and filled with originalRAMBuffer), false otherwise.
+     * If only the position of the bounds changed, the storage is kept and false is returned: the caller
+     * must then upload the data itself.
      * Note: Internally this function calls glTexImage2D to reallocate the texture buffer
      * @param originalRAMBuffer Optional pointer to a mapped PBO for asynchronous texture upload
      */
     bool ensureTextureHasSize(const RectI & bounds, const unsigned char* originalRAMBuffer);
 
+    /**
+     * @brief Moves the texture to the given bounds without touching its storage, the bounds must have the same
+     * width and height as the current bounds. Used when a texture is re-used for another image of the same size.
+     **/
+    void setBoundsKeepingStorage(const RectI & bounds)
+    {
+        assert(bounds.width() == _bounds.width() && bounds.height() == _bounds.height());
+        _bounds = bounds;
+    }
+
     /**
      * @brief Update the texture with the currently bound PBO across the given rectangle.
      * @param bounds The bounds of the texture, if the texture does not match these bounds, it will be reallocated
@@ -24,15 +24,28 @@
 
 #include "ThreadPool.h"
 
+#include <algorithm>
+#include <cassert>
 #include <string>
 #include <sstream> // stringstream
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
 
 #include <QtCore/QAtomicInt>
 #include <QtCore/QMutex>
+#include <QtCore/QSemaphore>
 #include <QtCore/QThread>
 #include <QtCore/QThreadPool>
 
+#include "Global/FStreamsSupport.h"
+
+#include "Engine/AppManager.h"
 #include "Engine/Node.h"
+#include "Engine/Settings.h"
 #include "Engine/TreeRender.h"
 
 NATRON_NAMESPACE_ENTER;
@@ -117,6 +130,323 @@ AbortableThread::getThread() const
 
 
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+struct IOMountSemaphore
+{
+    // The value of Settings::getMaxIOTasksPerMount() when the semaphore was created
+    int maxTasks;
+    boost::shared_ptr<QSemaphore> semaphore;
+
+    IOMountSemaphore()
+    : maxTasks(0)
+    , semaphore()
+    {
+    }
+};
+
+struct IOMountLimits
+{
+    QMutex lock;
+    std::map<std::string, IOMountSemaphore> mounts;
+
+    // The mount points of the system, read once
+    bool mountPointsRead;
+    std::vector<std::string> mountPoints;
+
+    IOMountLimits()
+    : lock()
+    , mounts()
+    , mountPointsRead(false)
+    , mountPoints()
+    {
+    }
+};
+
+IOMountLimits&
+getIOMountLimits()
+{
+    static IOMountLimits limits;
+
+    return limits;
+}
+
+#ifdef __NATRON_LINUX__
+// Decodes the octal escapes of /proc/self/mounts, e.g: \040 for a space
+std::string
+unescapeMountPoint(const std::string& str)
+{
+    std::string ret;
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        if ( (str[i] == '\\') && (i + 3 < str.size()) && (str[i + 1] >= '0') && (str[i + 1] <= '7') ) {
+            ret.push_back( (char)( (str[i + 1] - '0') * 64 + (str[i + 2] - '0') * 8 + (str[i + 3] - '0') ) );
+            i += 3;
+        } else {
+            ret.push_back(str[i]);
+        }
+    }
+
+    return ret;
+}
+
+std::vector<std::string>
+readMountPoints()
+{
+    std::vector<std::string> ret;
+    FStreamsSupport::ifstream ifile;
+    FStreamsSupport::open(&ifile, "/proc/self/mounts");
+    if (!ifile) {
+        return ret;
+    }
+    std::string line;
+    while ( std::getline(ifile, line) ) {
+        // Each line is: device mount-point type options...
+        std::istringstream ss(line);
+        std::string device, mountPoint;
+        if (ss >> device >> mountPoint) {
+            ret.push_back( unescapeMountPoint(mountPoint) );
+        }
+    }
+
+    return ret;
+}
+#endif // __NATRON_LINUX__
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+struct IOMountLockerPrivate
+{
+    boost::shared_ptr<QSemaphore> semaphore;
+
+    IOMountLockerPrivate()
+    : semaphore()
+    {
+    }
+};
+
+IOMountLocker_RAII::IOMountLocker_RAII(const std::string& filePath)
+    : _imp( new IOMountLockerPrivate )
+{
+    int maxTasks = appPTR->getCurrentSettings()->getMaxIOTasksPerMount();
+    if ( (maxTasks <= 0) || filePath.empty() ) {
+        return;
+    }
+    std::string mountPoint = getMountPoint(filePath);
+    {
+        IOMountLimits& limits = getIOMountLimits();
+        QMutexLocker k(&limits.lock);
+        IOMountSemaphore& mount = limits.mounts[mountPoint];
+
+        // If the setting changed, the tasks holding the previous semaphore still release it
+        if (!mount.semaphore || mount.maxTasks != maxTasks) {
+            mount.maxTasks = maxTasks;
+            mount.semaphore.reset( new QSemaphore(maxTasks) );
+        }
+        _imp->semaphore = mount.semaphore;
+    }
+    _imp->semaphore->acquire();
+}
+
+IOMountLocker_RAII::~IOMountLocker_RAII()
+{
+    if (_imp->semaphore) {
+        _imp->semaphore->release();
+    }
+}
+
+std::string
+IOMountLocker_RAII::getMountPoint(const std::string& filePath)
+{
+    std::string path = filePath;
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        if (path[i] == '\\') {
+            path[i] = '/';
+        }
+    }
+
+#ifdef __NATRON_WIN32__
+    // Network share: //server/share
+    if ( (path.size() > 2) && (path[0] == '/') && (path[1] == '/') ) {
+        std::size_t serverEnd = path.find('/', 2);
+        if (serverEnd == std::string::npos) {
+            return path;
+        }
+        return path.substr( 0, path.find('/', serverEnd + 1) );
+    }
+    // Drive: C:
+    if ( (path.size() >= 2) && (path[1] == ':') ) {
+        return path.substr(0, 2);
+    }
+#endif
+
+#ifdef __NATRON_LINUX__
+    {
+        IOMountLimits& limits = getIOMountLimits();
+        QMutexLocker k(&limits.lock);
+        if (!limits.mountPointsRead) {
+            limits.mountPoints = readMountPoints();
+            limits.mountPointsRead = true;
+        }
+        const std::string* longestMatch = 0;
+        for (std::vector<std::string>::const_iterator it = limits.mountPoints.begin(); it != limits.mountPoints.end(); ++it) {
+            bool isPrefix = (*it == "/") || ( (path.compare(0, it->size(), *it) == 0) && ( (path.size() == it->size()) || (path[it->size()] == '/') ) );
+            if ( isPrefix && ( !longestMatch || (it->size() > longestMatch->size()) ) ) {
+                longestMatch = &*it;
+            }
+        }
+        if (longestMatch) {
+            return *longestMatch;
+        }
+    }
+#endif
+
+#ifdef __NATRON_OSX__
+    // Volume: /Volumes/name
+    if (path.compare(0, 9, "/Volumes/") == 0) {
+        return path.substr( 0, path.find('/', 9) );
+    }
+#endif
+
+    // Unknown: use the first directory of the path
+    std::size_t firstDirEnd = path.find('/', 1);
+
+    return path.substr(0, firstDirEnd);
+} // getMountPoint
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+struct RenderTaskDispatcherData
+{
+    // Protects all data below
+    QMutex lock;
+
+    // The limited tasks waiting to be started, for each priority
+    std::list<QRunnable*> queuedTasks[eRenderPriorityInteractive];
+
+    // The number of limited tasks started and not waiting
+    int nRunningTasks;
+
+    // The threads running a limited task and, among them, those waiting for other tasks
+    std::set<QThread*> runningThreads;
+    std::set<QThread*> waitingThreads;
+
+    RenderTaskDispatcherData()
+    : lock()
+    , queuedTasks()
+    , nRunningTasks(0)
+    , runningThreads()
+    , waitingThreads()
+    {
+    }
+
+    int getMaxRunningTasks() const
+    {
+        int nReservedThreads = appPTR->getCurrentSettings()->getNumberOfThreadsReservedForViewer();
+
+        return std::max(1, QThreadPool::globalInstance()->maxThreadCount() - nReservedThreads);
+    }
+
+    /**
+     * @brief Starts the queued tasks, highest priority first, until the limit is reached
+     **/
+    void startQueuedTasks()
+    {
+        int maxRunningTasks = getMaxRunningTasks();
+        for (int i = (int)eRenderPriorityInteractive - 1; i >= 0 && nRunningTasks < maxRunningTasks; --i) {
+            while ( !queuedTasks[i].empty() && (nRunningTasks < maxRunningTasks) ) {
+                QRunnable* task = queuedTasks[i].front();
+                queuedTasks[i].pop_front();
+                ++nRunningTasks;
+                QThreadPool::globalInstance()->start(task, i);
+            }
+        }
+    }
+};
+
+RenderTaskDispatcherData&
+getRenderTaskDispatcherData()
+{
+    static RenderTaskDispatcherData data;
+
+    return data;
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+bool
+RenderTaskDispatcher::isTaskLimited(QThreadPool* threadPool,
+                                    RenderPriorityEnum priority)
+{
+    return priority < eRenderPriorityInteractive && threadPool == QThreadPool::globalInstance() &&
+           appPTR->getCurrentSettings()->getNumberOfThreadsReservedForViewer() > 0;
+}
+
+void
+RenderTaskDispatcher::startTask(QThreadPool* threadPool,
+                                QRunnable* task,
+                                RenderPriorityEnum priority,
+                                bool limited)
+{
+    if (!limited) {
+        threadPool->start(task, (int)priority);
+
+        return;
+    }
+    assert(threadPool == QThreadPool::globalInstance() && priority < eRenderPriorityInteractive);
+
+    RenderTaskDispatcherData& data = getRenderTaskDispatcherData();
+    QMutexLocker k(&data.lock);
+    data.queuedTasks[priority].push_back(task);
+    data.startQueuedTasks();
+}
+
+void
+RenderTaskDispatcher::onLimitedTaskStarted()
+{
+    RenderTaskDispatcherData& data = getRenderTaskDispatcherData();
+    QMutexLocker k(&data.lock);
+
+    data.runningThreads.insert( QThread::currentThread() );
+}
+
+void
+RenderTaskDispatcher::onLimitedTaskFinished()
+{
+    RenderTaskDispatcherData& data = getRenderTaskDispatcherData();
+    QMutexLocker k(&data.lock);
+
+    data.runningThreads.erase( QThread::currentThread() );
+    --data.nRunningTasks;
+    data.startQueuedTasks();
+}
+
+void
+RenderTaskDispatcher::onThreadWaitStarted()
+{
+    RenderTaskDispatcherData& data = getRenderTaskDispatcherData();
+    QMutexLocker k(&data.lock);
+    QThread* thread = QThread::currentThread();
+
+    if ( data.runningThreads.find(thread) == data.runningThreads.end() ) {
+        return;
+    }
+    data.waitingThreads.insert(thread);
+    --data.nRunningTasks;
+    data.startQueuedTasks();
+}
+
+void
+RenderTaskDispatcher::onThreadWaitFinished()
+{
+    RenderTaskDispatcherData& data = getRenderTaskDispatcherData();
+    QMutexLocker k(&data.lock);
+
+    // This may exceed the limit until a limited task finishes
+    if ( data.waitingThreads.erase( QThread::currentThread() ) ) {
+        ++data.nRunningTasks;
+    }
+}
+
 // We patched Qt to be able to derive QThreadPool to control the threads that are spawned to improve performances
 // of the EffectInstance::aborted() function
 #ifdef QT_CUSTOM_THREADPOOL
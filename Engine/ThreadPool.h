@@ -27,12 +27,16 @@
 
 #include "Global/Macros.h"
 
+#include <string>
+
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/scoped_ptr.hpp>
 #endif
 
 #include <QtCore/QThreadPool> // defines QT_CUSTOM_THREADPOOL (or not)
 
+#include "Global/GlobalDefines.h"
+
 #include "Engine/EngineFwd.h"
 
 NATRON_NAMESPACE_ENTER;
@@ -104,6 +108,69 @@ inline bool isRunningInThreadPoolThread()
 #endif
 }
 
+/**
+ * @brief Limits the number of render tasks of I/O-bound effects accessing the same mount point concurrently
+ * to the value of Settings::getMaxIOTasksPerMount(), so that many I/O threads do not overload a network storage.
+ * The constructor blocks until the file path can be accessed.
+ **/
+struct IOMountLockerPrivate;
+class IOMountLocker_RAII
+{
+public:
+
+    IOMountLocker_RAII(const std::string& filePath);
+
+    ~IOMountLocker_RAII();
+
+    /**
+     * @brief Returns the mount point containing the given file path: the longest mount point prefix of the path on Linux,
+     * the drive or the network share on Windows, the volume on macOS. If unknown, the first directory of the path is returned.
+     **/
+    static std::string getMountPoint(const std::string& filePath);
+
+private:
+
+    boost::scoped_ptr<IOMountLockerPrivate> _imp;
+};
+
+/**
+ * @brief Starts the render tasks of the trees in their thread pool by priority class (see RenderPriorityEnum): the
+ * queued tasks of the viewer run before those of the tracker, that run before those of a render on disk, that run
+ * before previews and idle caching.
+ * The tasks of the global thread pool with a priority lower than eRenderPriorityInteractive may also be limited to
+ * maxThreadCount() - Settings::getNumberOfThreadsReservedForViewer() threads, so that a background render does not
+ * saturate all cores and the viewer always has threads to render when the user interacts.
+ * The tasks above this limit are queued here and each started, highest priority first, when a limited task finishes
+ * or waits.
+ **/
+class RenderTaskDispatcher
+{
+public:
+
+    /**
+     * @brief Returns whether a task of the given priority started in the given thread pool counts in the limit
+     **/
+    static bool isTaskLimited(QThreadPool* threadPool, RenderPriorityEnum priority);
+
+    /**
+     * @brief Starts the task in the given thread pool, or queues it if it is limited and the limit is reached.
+     * The run() function of a limited task must call onLimitedTaskStarted() and onLimitedTaskFinished().
+     **/
+    static void startTask(QThreadPool* threadPool, QRunnable* task, RenderPriorityEnum priority, bool limited);
+
+    static void onLimitedTaskStarted();
+
+    static void onLimitedTaskFinished();
+
+    /**
+     * @brief Must be called when a thread of the global thread pool releases its thread to wait for other render tasks:
+     * if it runs a limited task, other limited tasks may run meanwhile, otherwise the tasks it waits for may never start.
+     **/
+    static void onThreadWaitStarted();
+
+    static void onThreadWaitFinished();
+};
+
 #define REPORT_CURRENT_THREAD_ACTION(actionName, node) \
     { \
         QThread* thread = QThread::currentThread(); \
@@ -120,6 +120,11 @@ struct TrackMarkerPrivate
         , trackingStartedCount(0)
     {
     }
+
+    /**
+     * @brief Returns the knobs on which a keyframe is set at each track step
+     **/
+    void getKnobsSetWhileTracking(std::vector<KnobIPtr>* knobs) const;
 };
 
 TrackMarker::TrackMarker(const KnobItemsTablePtr& model)
@@ -618,22 +623,51 @@ TrackMarker::setKeyFrameOnCenterAndPatternAtTime(TimeValue time)
         k->setValueAcrossDimensions(values);
     }
 }
+void
+TrackMarkerPrivate::getKnobsSetWhileTracking(std::vector<KnobIPtr>* knobs) const
+{
+    knobs->push_back( center.lock() );
+    knobs->push_back( error.lock() );
+    knobs->push_back( patternBtmLeft.lock() );
+    knobs->push_back( patternBtmRight.lock() );
+    knobs->push_back( patternTopLeft.lock() );
+    knobs->push_back( patternTopRight.lock() );
+}
+
 void
 TrackMarker::notifyTrackingStarted()
 {
     if (!_imp->trackingStartedCount) {
         // When tracking disable keyframes tracking on knobs that get updated at each track
         // step to keep the UI from refreshing at each frame.
-        _imp->center.lock()->setKeyFrameTrackingEnabled(false);
-        _imp->error.lock()->setKeyFrameTrackingEnabled(false);
-        _imp->patternBtmLeft.lock()->setKeyFrameTrackingEnabled(false);
-        _imp->patternBtmRight.lock()->setKeyFrameTrackingEnabled(false);
-        _imp->patternTopLeft.lock()->setKeyFrameTrackingEnabled(false);
-        _imp->patternTopRight.lock()->setKeyFrameTrackingEnabled(false);
+        // The gui of the knobs is refreshed at a capped rate in refreshKnobsGuiWhileTracking() instead.
+        std::vector<KnobIPtr> knobs;
+        _imp->getKnobsSetWhileTracking(&knobs);
+        for (std::size_t i = 0; i < knobs.size(); ++i) {
+            knobs[i]->setKeyFrameTrackingEnabled(false);
+            knobs[i]->blockValueChanges();
+        }
     }
     ++_imp->trackingStartedCount;
 }
 
+void
+TrackMarker::refreshKnobsGuiWhileTracking()
+{
+    if (!_imp->trackingStartedCount) {
+        return;
+    }
+
+    // Flush at once the keyframes set since the last refresh to the gui of the knobs and the curve editor
+    std::vector<KnobIPtr> knobs;
+    _imp->getKnobsSetWhileTracking(&knobs);
+    for (std::size_t i = 0; i < knobs.size(); ++i) {
+        boost::shared_ptr<KnobSignalSlotHandler> handler = knobs[i]->getSignalSlotHandler();
+        handler->s_curveAnimationChanged( ViewSetSpec::all(), DimSpec::all() );
+        handler->s_mustRefreshKnobGui( ViewSetSpec::all(), DimSpec::all(), eValueChangedReasonUserEdited );
+    }
+}
+
 void
 TrackMarker::notifyTrackingEnded()
 {
@@ -643,12 +677,13 @@ TrackMarker::notifyTrackingEnded()
 
     // Refresh knobs once finished
     if (!_imp->trackingStartedCount) {
-        _imp->center.lock()->setKeyFrameTrackingEnabled(true);
-        _imp->error.lock()->setKeyFrameTrackingEnabled(true);
-        _imp->patternBtmLeft.lock()->setKeyFrameTrackingEnabled(true);
-        _imp->patternBtmRight.lock()->setKeyFrameTrackingEnabled(true);
-        _imp->patternTopLeft.lock()->setKeyFrameTrackingEnabled(true);
-        _imp->patternTopRight.lock()->setKeyFrameTrackingEnabled(true);
+        std::vector<KnobIPtr> knobs;
+        _imp->getKnobsSetWhileTracking(&knobs);
+        for (std::size_t i = 0; i < knobs.size(); ++i) {
+            knobs[i]->unblockValueChanges();
+            knobs[i]->setKeyFrameTrackingEnabled(true);
+            knobs[i]->getSignalSlotHandler()->s_mustRefreshKnobGui( ViewSetSpec::all(), DimSpec::all(), eValueChangedReasonUserEdited );
+        }
     }
 }
 
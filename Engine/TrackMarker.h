@@ -184,6 +184,12 @@ public:
     void notifyTrackingStarted();
     void notifyTrackingEnded();
 
+    /**
+     * @brief While tracking, the gui of the knobs set at each track step is not refreshed: this refreshes it
+     * with all keyframes set since the previous call. This is called by the TrackScheduler at a capped rate.
+     **/
+    void refreshKnobsGuiWhileTracking();
+
     virtual std::string getBaseItemName() const OVERRIDE;
 
     virtual std::string getSerializationClassName() const OVERRIDE FINAL;
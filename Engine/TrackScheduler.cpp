@@ -229,13 +229,20 @@ TrackScheduler::threadLoopOnce(const GenericThreadStartArgsPtr& inArgs)
             }
 
 
+            // The gui is refreshed at a capped rate, independently of the tracking speed: the keyframes set
+            // by the track steps since the last refresh are shown at once
+            if (enoughTimePassedToReportProgress) {
+                paramsProvider->refreshTrackSequenceGui(args);
+            }
+
             ///Ok all tracks are finished now for this frame, refresh viewer if needed
             if (isUpdateViewerOnTrackingEnabled && viewer) {
-                //This will not refresh the viewer since when tracking, renderCurrentFrame()
-                //is not called on viewers, see Gui::onTimeChanged
-                timeline->seekFrame(cur, true, EffectInstancePtr(), eTimelineChangeReasonOtherSeek);
-
                 if (enoughTimePassedToReportProgress) {
+                    //This will not refresh the viewer since when tracking, renderCurrentFrame()
+                    //is not called on viewers, see Gui::onTimeChanged
+                    //Seeking refreshes the gui of all knobs, so it is not done at each frame
+                    timeline->seekFrame(cur, true, EffectInstancePtr(), eTimelineChangeReasonOtherSeek);
+
                     if (doPartialUpdates) {
                         std::list<RectD> updateRects;
                         args->getRedrawAreasNeeded(TimeValue(cur), &updateRects);
@@ -32,7 +32,12 @@ GCC_DIAG_OFF(unused-parameter)
 GCC_DIAG_ON(unused-function)
 GCC_DIAG_ON(unused-parameter)
 
+#include <cstring>
+#include <map>
+#include <set>
+
 #include <QtCore/QDebug>
+#include <QtCore/QWaitCondition>
 
 #include "Engine/AppInstance.h"
 #include "Engine/Project.h"
@@ -43,6 +48,9 @@ GCC_DIAG_ON(unused-parameter)
 #include "Engine/TreeRender.h"
 #include "Engine/Node.h"
 
+// Memory used by the greyscale frames shared by all markers tracking the same frame
+#define NATRON_TRACKER_SHARED_FRAMES_MAX_BYTES (256 * 1024 * 1024)
+
 NATRON_NAMESPACE_ENTER;
 
 NATRON_NAMESPACE_ANONYMOUS_ENTER
@@ -122,6 +130,34 @@ struct FrameAccessorCacheEntry
 
 typedef std::multimap<FrameAccessorCacheKey, FrameAccessorCacheEntry, CacheKey_compare_less > FrameAccessorCache;
 
+// A frame converted to greyscale entirely, from which the regions requested by the markers are copied
+struct SharedFrame
+{
+    boost::shared_ptr<MvFloatImage> image;
+    RectI bounds;
+
+    // Used to release the least recently used frames first
+    U64 lastUse;
+};
+
+typedef std::map<FrameAccessorCacheKey, SharedFrame, CacheKey_compare_less > SharedFrames;
+
+void
+copyMvFloatImageRegion(const MvFloatImage& srcImg,
+                       const RectI& srcBounds,
+                       const RectI& roi,
+                       MvFloatImage& dstImg)
+{
+    assert( srcBounds.contains(roi) );
+    const float* src = srcImg.Data() + (std::size_t)(roi.y1 - srcBounds.y1) * srcBounds.width() + (roi.x1 - srcBounds.x1);
+    float* dst = dstImg.Data();
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        std::memcpy( dst, src, roi.width() * sizeof(float) );
+        src += srcBounds.width();
+        dst += roi.width();
+    }
+}
+
 template <bool doR, bool doG, bool doB, int srcNComps, typename PIX, int maxValue>
 void
 natronImageToLibMvFloatImageForDepth(const Image::CPUData& source,
@@ -265,8 +301,24 @@ struct TrackerFrameAccessorPrivate
 {
     NodeWPtr node;
     NodePtr trackerInput;
+    // Protects cache, sharedFrames, sharedFramesSize, useCounter, requestedFrames and pendingSharedFrames
     mutable QMutex cacheMutex;
+
+    // The images returned to libmv
     FrameAccessorCache cache;
+
+    // Markers tracking the same frame copy their region from a single rendered and converted frame
+    SharedFrames sharedFrames;
+    std::size_t sharedFramesSize;
+    U64 useCounter;
+
+    // The frames for which a region was already rendered: the next request renders them entirely
+    std::set<FrameAccessorCacheKey, CacheKey_compare_less> requestedFrames;
+
+    // The shared frames being rendered, the other markers wait for them on sharedFrameRenderedCond
+    std::set<FrameAccessorCacheKey, CacheKey_compare_less> pendingSharedFrames;
+    QWaitCondition sharedFrameRenderedCond;
+
     bool enabledChannels[3];
     int formatHeight;
 
@@ -277,6 +329,12 @@ struct TrackerFrameAccessorPrivate
         , trackerInput()
         , cacheMutex()
         , cache()
+        , sharedFrames()
+        , sharedFramesSize(0)
+        , useCounter(0)
+        , requestedFrames()
+        , pendingSharedFrames()
+        , sharedFrameRenderedCond()
         , enabledChannels()
         , formatHeight(formatHeight)
     {
@@ -286,8 +344,124 @@ struct TrackerFrameAccessorPrivate
             this->enabledChannels[i] = enabledChannels[i];
         }
     }
+
+    /**
+     * @brief Renders the input of the tracker in the given canonical region, or its region of definition if NULL.
+     * The returned image is in RAM.
+     **/
+    ImagePtr renderInputImage(int frame, int downscale, const RectD* roiCanonical) const;
+
+    /**
+     * @brief Renders the given frame entirely and converts it to greyscale. Returns false if it could not be rendered.
+     **/
+    bool renderSharedFrame(const FrameAccessorCacheKey& key, SharedFrame* sharedFrame);
+
+    /**
+     * @brief Releases the least recently used shared frames until the memory they use is below the budget.
+     * Private - should be called with cacheMutex locked.
+     **/
+    void evictSharedFrames();
 };
 
+ImagePtr
+TrackerFrameAccessorPrivate::renderInputImage(int frame,
+                                              int downscale,
+                                              const RectD* roiCanonical) const
+{
+    TreeRender::CtorArgsPtr args(new TreeRender::CtorArgs);
+    {
+        args->treeRootEffect = trackerInput->getEffectInstance();
+        args->time = TimeValue(frame);
+        args->view = ViewIdx(0);
+
+        // Render all layers produced
+        args->plane = 0;
+        args->mipMapLevel = downscale;
+        args->proxyScale = RenderScale(1.);
+
+        args->canonicalRoI = roiCanonical;
+        args->draftMode = false;
+        args->playback = false;
+        args->byPassCache = false;
+        args->priority = eRenderPriorityTracking;
+    }
+
+    TreeRenderPtr render = TreeRender::create(args);
+    FrameViewRequestPtr outputRequest;
+    ActionRetCodeEnum stat = render->launchRender(&outputRequest);
+    if (isFailureRetCode(stat)) {
+
+#ifdef TRACE_LIB_MV
+        qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "Failed to call renderRoI on input at frame" << frame;
+#endif
+        return ImagePtr();
+    }
+
+    ImagePtr sourceImage = outputRequest->getRequestedScaleImagePlane();
+
+    // Make sure the Natron image rendered is RGBA full rect and on CPU, we don't support other formats to conver to libmv
+    if (sourceImage->getStorageMode() != eStorageModeRAM) {
+        Image::InitStorageArgs initArgs;
+        initArgs.bounds = sourceImage->getBounds();
+        initArgs.plane = sourceImage->getLayer();
+        initArgs.bufferFormat = eImageBufferLayoutRGBAPackedFullRect;
+        initArgs.storage = eStorageModeRAM;
+        initArgs.bitdepth = sourceImage->getBitDepth();
+        ImagePtr tmpImage = Image::create(initArgs);
+        if (!tmpImage) {
+            return ImagePtr();
+        }
+        Image::CopyPixelsArgs cpyArgs;
+        cpyArgs.roi = initArgs.bounds;
+        tmpImage->copyPixels(*sourceImage, cpyArgs);
+        sourceImage = tmpImage;
+
+    }
+    return sourceImage;
+} // renderInputImage
+
+bool
+TrackerFrameAccessorPrivate::renderSharedFrame(const FrameAccessorCacheKey& key,
+                                               SharedFrame* sharedFrame)
+{
+    ImagePtr sourceImage = renderInputImage(key.frame, key.mipMapLevel, 0);
+    if (!sourceImage) {
+        return false;
+    }
+    sharedFrame->bounds = sourceImage->getBounds();
+    if ( sharedFrame->bounds.isNull() ) {
+        return false;
+    }
+
+    Image::CPUData imageData;
+    sourceImage->getCPUData(&imageData);
+
+    sharedFrame->image.reset( new MvFloatImage( sharedFrame->bounds.height(), sharedFrame->bounds.width() ) );
+    natronImageToLibMvFloatImage(enabledChannels,
+                                 imageData,
+                                 sharedFrame->bounds,
+                                 *sharedFrame->image);
+    return true;
+}
+
+void
+TrackerFrameAccessorPrivate::evictSharedFrames()
+{
+    // Private - should not lock
+    assert(!cacheMutex.tryLock());
+
+    while ( (sharedFramesSize > NATRON_TRACKER_SHARED_FRAMES_MAX_BYTES) && (sharedFrames.size() > 1) ) {
+        SharedFrames::iterator oldest = sharedFrames.begin();
+        for (SharedFrames::iterator it = sharedFrames.begin(); it != sharedFrames.end(); ++it) {
+            if (it->second.lastUse < oldest->second.lastUse) {
+                oldest = it;
+            }
+        }
+        sharedFramesSize -= oldest->second.bounds.area() * sizeof(float);
+        sharedFrames.erase(oldest);
+    }
+}
+
 TrackerFrameAccessor::TrackerFrameAccessor(const NodePtr& node,
                                            bool enabledChannels[3],
                                            int formatHeight)
@@ -352,130 +526,129 @@ TrackerFrameAccessor::GetImage(int /*clip*/,
     key.mipMapLevel = downscale;
     key.mode = input_mode;
 
-    /*
-       Check if a frame exists in the cache with matching key and bounds enclosing the given region
-     */
+    if (!_imp->trackerInput) {
+        return (mv::FrameAccessor::Key)0;
+    }
+
     RectI roi;
     if (region) {
         convertLibMVRegionToRectI(*region, _imp->formatHeight, &roi);
+    }
 
+    SharedFrame sharedFrame;
+    bool mustRenderSharedFrame = false;
+    {
         QMutexLocker k(&_imp->cacheMutex);
-        std::pair<FrameAccessorCache::iterator, FrameAccessorCache::iterator> range = _imp->cache.equal_range(key);
-        for (FrameAccessorCache::iterator it = range.first; it != range.second; ++it) {
-            if ( (roi.x1 >= it->second.bounds.x1) && (roi.x2 <= it->second.bounds.x2) &&
-                 ( roi.y1 >= it->second.bounds.y1) && ( roi.y2 <= it->second.bounds.y2) ) {
+
+        // Check if the same region of this frame was already returned.
+        // LibMV expects the origin of the image to be the origin of the region, so only exact matches are re-used.
+        if (region) {
+            std::pair<FrameAccessorCache::iterator, FrameAccessorCache::iterator> range = _imp->cache.equal_range(key);
+            for (FrameAccessorCache::iterator it = range.first; it != range.second; ++it) {
+                if (it->second.bounds == roi) {
 #ifdef TRACE_LIB_MV
-                qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "Found cached image at frame" << frame << "with RoI x1="
-                         << region->min(0) << "y1=" << region->max(1) << "x2=" << region->max(0) << "y2=" << region->min(1);
+                    qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "Found cached image at frame" << frame << "with RoI x1="
+                             << region->min(0) << "y1=" << region->max(1) << "x2=" << region->max(0) << "y2=" << region->min(1);
 #endif
-                // LibMV is kinda dumb on this we must necessarily copy the data either via CopyFrom or the
-                // assignment constructor:
-                // EDIT: fixed libmv
-                *destination = it->second.image.get();
-                //destination->CopyFrom<float>(*it->second.image);
-                ++it->second.referenceCount;
-
-                return (mv::FrameAccessor::Key)it->second.image.get();
+                    *destination = it->second.image.get();
+                    ++it->second.referenceCount;
+
+                    return (mv::FrameAccessor::Key)it->second.image.get();
+                }
             }
         }
-    }
 
+        // Check if the frame was converted entirely for another marker, or wait if it is being converted
+        for (;;) {
+            SharedFrames::iterator found = _imp->sharedFrames.find(key);
+            if ( found != _imp->sharedFrames.end() ) {
+                found->second.lastUse = ++_imp->useCounter;
+                sharedFrame = found->second;
+                break;
+            }
+            if ( _imp->pendingSharedFrames.find(key) == _imp->pendingSharedFrames.end() ) {
+                break;
+            }
+            _imp->sharedFrameRenderedCond.wait(&_imp->cacheMutex);
+        }
 
-    if (!_imp->trackerInput) {
-        return (mv::FrameAccessor::Key)0;
+        // The first marker tracking a frame only renders its region. When other markers track the same frame,
+        // render and convert it once for all of them.
+        if (!sharedFrame.image) {
+            mustRenderSharedFrame = !region || !_imp->requestedFrames.insert(key).second;
+            if (mustRenderSharedFrame) {
+                _imp->pendingSharedFrames.insert(key);
+            }
+        }
     }
 
-    // Not in accessor cache, call renderRoI
-    RenderScale scale;
-    scale.y = scale.x = Image::getScaleFromMipMapLevel( (unsigned int)downscale );
-
-    NodePtr node = _imp->node.lock();
+    if (mustRenderSharedFrame) {
+        bool ok = _imp->renderSharedFrame(key, &sharedFrame);
 
-    // Convert roi to canonical coordinates
-    RectD roiCanonical;
-    roi.toCanonical_noClipping(0, 1., &roiCanonical);
-
-
-    TreeRender::CtorArgsPtr args(new TreeRender::CtorArgs);
-    {
-        args->treeRootEffect = _imp->trackerInput->getEffectInstance();
-        args->time = TimeValue(frame);
-        args->view = ViewIdx(0);
-
-        // Render all layers produced
-        args->plane = 0;
-        args->mipMapLevel = downscale;
-        args->proxyScale = RenderScale(1.);
-
-        args->canonicalRoI = &roiCanonical;
-        args->draftMode = false;
-        args->playback = false;
-        args->byPassCache = false;
+        QMutexLocker k(&_imp->cacheMutex);
+        _imp->pendingSharedFrames.erase(key);
+        _imp->sharedFrameRenderedCond.wakeAll();
+        if (!ok) {
+            return (mv::FrameAccessor::Key)0;
+        }
+        sharedFrame.lastUse = ++_imp->useCounter;
+        _imp->sharedFrames[key] = sharedFrame;
+        _imp->sharedFramesSize += sharedFrame.bounds.area() * sizeof(float);
+        _imp->evictSharedFrames();
     }
 
-    TreeRenderPtr render = TreeRender::create(args);
-    FrameViewRequestPtr outputRequest;
-    ActionRetCodeEnum stat = render->launchRender(&outputRequest);
-    if (isFailureRetCode(stat)) {
+    FrameAccessorCacheEntry entry;
+    entry.referenceCount = 1;
+    if (sharedFrame.image) {
+        // Copy the region from the shared frame
+        RectI intersectedRoI = sharedFrame.bounds;
+        if ( region && !roi.intersect(sharedFrame.bounds, &intersectedRoI) ) {
+            return (mv::FrameAccessor::Key)0;
+        }
+        entry.image.reset( new MvFloatImage( intersectedRoI.height(), intersectedRoI.width() ) );
+        entry.bounds = intersectedRoI;
+        copyMvFloatImageRegion(*sharedFrame.image, sharedFrame.bounds, intersectedRoI, *entry.image);
+    } else {
+        // Not in accessor cache, call renderRoI
 
-#ifdef TRACE_LIB_MV
-        qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "Failed to call renderRoI on input at frame" << frame << "with RoI x1="
-        << roi.x1 << "y1=" << roi.y1 << "x2=" << roi.x2 << "y2=" << roi.y2;
-#endif
-        return (mv::FrameAccessor::Key)0;
-    }
+        // Convert roi to canonical coordinates
+        RectD roiCanonical;
+        roi.toCanonical_noClipping(0, 1., &roiCanonical);
 
+        ImagePtr sourceImage = _imp->renderInputImage(frame, downscale, &roiCanonical);
+        if (!sourceImage) {
+            return (mv::FrameAccessor::Key)0;
+        }
 
-    ImagePtr sourceImage = outputRequest->getRequestedScaleImagePlane();
-    const RectI& sourceBounds = sourceImage->getBounds();
-    RectI intersectedRoI;
-    if ( !roi.intersect(sourceBounds, &intersectedRoI) ) {
+        const RectI& sourceBounds = sourceImage->getBounds();
+        RectI intersectedRoI;
+        if ( !roi.intersect(sourceBounds, &intersectedRoI) ) {
 #ifdef TRACE_LIB_MV
-        qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "RoI does not intersect the source image bounds (RoI x1="
-        << roi.x1 << "y1=" << roi.y1 << "x2=" << roi.x2 << "y2=" << roi.y2 << ")";
+            qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "RoI does not intersect the source image bounds (RoI x1="
+            << roi.x1 << "y1=" << roi.y1 << "x2=" << roi.x2 << "y2=" << roi.y2 << ")";
 #endif
 
-        return (mv::FrameAccessor::Key)0;
-    }
+            return (mv::FrameAccessor::Key)0;
+        }
 
 #ifdef TRACE_LIB_MV
-    qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "renderRoi (frame" << frame << ") OK  (BOUNDS= x1="
-    << sourceBounds.x1 << "y1=" << sourceBounds.y1 << "x2=" << sourceBounds.x2 << "y2=" << sourceBounds.y2 << ") (ROI = " << roi.x1 << "y1=" << roi.y1 << "x2=" << roi.x2 << "y2=" << roi.y2 << ")";
+        qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "renderRoi (frame" << frame << ") OK  (BOUNDS= x1="
+        << sourceBounds.x1 << "y1=" << sourceBounds.y1 << "x2=" << sourceBounds.x2 << "y2=" << sourceBounds.y2 << ") (ROI = " << roi.x1 << "y1=" << roi.y1 << "x2=" << roi.x2 << "y2=" << roi.y2 << ")";
 #endif
 
-    // Make sure the Natron image rendered is RGBA full rect and on CPU, we don't support other formats to conver to libmv
-    if (sourceImage->getStorageMode() != eStorageModeRAM) {
-        Image::InitStorageArgs initArgs;
-        initArgs.bounds = sourceBounds;
-        initArgs.plane = sourceImage->getLayer();
-        initArgs.bufferFormat = eImageBufferLayoutRGBAPackedFullRect;
-        initArgs.storage = eStorageModeRAM;
-        initArgs.bitdepth = sourceImage->getBitDepth();
-        ImagePtr tmpImage = Image::create(initArgs);
-        if (!tmpImage) {
-            return (mv::FrameAccessor::Key)0;
-        }
-        Image::CopyPixelsArgs cpyArgs;
-        cpyArgs.roi = initArgs.bounds;
-        tmpImage->copyPixels(*sourceImage, cpyArgs);
-        sourceImage = tmpImage;
+        Image::CPUData imageData;
+        sourceImage->getCPUData(&imageData);
 
+        entry.image.reset( new MvFloatImage( intersectedRoI.height(), intersectedRoI.width() ) );
+        entry.bounds = intersectedRoI;
+        natronImageToLibMvFloatImage(_imp->enabledChannels,
+                                     imageData,
+                                     intersectedRoI,
+                                     *entry.image);
+        // we ignore the transform parameter and do it in natronImageToLibMvFloatImage instead
     }
-    Image::CPUData imageData;
-    sourceImage->getCPUData(&imageData);
-
-    FrameAccessorCacheEntry entry;
-    entry.image.reset( new MvFloatImage( intersectedRoI.height(), intersectedRoI.width() ) );
-    entry.bounds = intersectedRoI;
-    entry.referenceCount = 1;
-    natronImageToLibMvFloatImage(_imp->enabledChannels,
-                                 imageData,
-                                 intersectedRoI,
-                                 *entry.image);
-    // we ignore the transform parameter and do it in natronImageToLibMvFloatImage instead
 
     *destination = entry.image.get();
-    //destination->CopyFrom<float>(*entry.image);
 
     //insert into the cache
     {
@@ -483,8 +656,8 @@ TrackerFrameAccessor::GetImage(int /*clip*/,
         _imp->cache.insert( std::make_pair(key, entry) );
     }
 #ifdef TRACE_LIB_MV
-    qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "Rendered frame" << frame << "with RoI x1="
-             << intersectedRoI.x1 << "y1=" << intersectedRoI.y1 << "x2=" << intersectedRoI.x2 << "y2=" << intersectedRoI.y2;
+    qDebug() << QThread::currentThread() << "FrameAccessor::GetImage():" << "Got frame" << frame << "with RoI x1="
+             << entry.bounds.x1 << "y1=" << entry.bounds.y1 << "x2=" << entry.bounds.x2 << "y2=" << entry.bounds.y2;
 #endif
 
     return (mv::FrameAccessor::Key)entry.image.get();
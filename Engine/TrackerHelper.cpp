@@ -32,6 +32,7 @@
 
 #include "Engine/AppInstance.h"
 #include "Engine/EffectInstance.h"
+#include "Engine/Hash64.h"
 #include "Engine/Node.h"
 #include "Engine/Project.h"
 #include "Engine/TrackArgs.h"
@@ -40,6 +41,53 @@
 
 NATRON_NAMESPACE_ENTER;
 
+bool
+TrackerSolverCache::getTransformData(TimeValue time,
+                                     U64 pointsHash,
+                                     TransformData* data) const
+{
+    QMutexLocker k(&_lock);
+    std::map<double, std::pair<U64, TransformData> >::const_iterator found = _transforms.find(time);
+    if ( (found == _transforms.end()) || (found->second.first != pointsHash) ) {
+        return false;
+    }
+    *data = found->second.second;
+
+    return true;
+}
+
+void
+TrackerSolverCache::setTransformData(TimeValue time,
+                                     U64 pointsHash,
+                                     const TransformData& data)
+{
+    QMutexLocker k(&_lock);
+    _transforms[time] = std::make_pair(pointsHash, data);
+}
+
+bool
+TrackerSolverCache::getCornerPinData(TimeValue time,
+                                     U64 pointsHash,
+                                     CornerPinData* data) const
+{
+    QMutexLocker k(&_lock);
+    std::map<double, std::pair<U64, CornerPinData> >::const_iterator found = _cornerPins.find(time);
+    if ( (found == _cornerPins.end()) || (found->second.first != pointsHash) ) {
+        return false;
+    }
+    *data = found->second.second;
+
+    return true;
+}
+
+void
+TrackerSolverCache::setCornerPinData(TimeValue time,
+                                     U64 pointsHash,
+                                     const CornerPinData& data)
+{
+    QMutexLocker k(&_lock);
+    _cornerPins[time] = std::make_pair(pointsHash, data);
+}
 
 TrackerHelper::TrackerHelper(const TrackerParamsProviderPtr &provider)
 : QObject()
@@ -29,14 +29,17 @@
 
 #include <set>
 #include <list>
+#include <map>
 
 #include "Global/GlobalDefines.h"
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #endif
 
 #include <QObject>
+#include <QMutex>
 
 #include "Engine/Transform.h"
 #include "Engine/TimeValue.h"
@@ -95,6 +98,38 @@ public:
     double rms;
 };
 
+/**
+ * @brief Remembers the result of the transform and corner pin solves at each frame along with a hash of the points
+ * the solve was computed from, so that solving again after editing a few markers only solves the frames whose
+ * points changed. All functions are MT-safe.
+ **/
+class TrackerSolverCache
+{
+public:
+
+    TrackerSolverCache()
+    : _lock()
+    , _transforms()
+    , _cornerPins()
+    {
+    }
+
+    bool getTransformData(TimeValue time, U64 pointsHash, TransformData* data) const;
+
+    void setTransformData(TimeValue time, U64 pointsHash, const TransformData& data);
+
+    bool getCornerPinData(TimeValue time, U64 pointsHash, CornerPinData* data) const;
+
+    void setCornerPinData(TimeValue time, U64 pointsHash, const CornerPinData& data);
+
+private:
+
+    mutable QMutex _lock;
+    std::map<double, std::pair<U64, TransformData> > _transforms;
+    std::map<double, std::pair<U64, CornerPinData> > _cornerPins;
+};
+
+typedef boost::shared_ptr<TrackerSolverCache> TrackerSolverCachePtr;
 
 class TrackerHelperPrivate;
 class TrackerHelper
@@ -232,6 +267,7 @@ public:
     /**
      * @brief Given the markers that have been tracked, computes the affine transform mapping from refTime
      * to time.
+     * If cache is not NULL, the result is taken from it if the points at time did not change since it was last computed.
      **/
     static TransformData computeTransformParamsFromTracksAtTime(TimeValue refTime,
                                                                 TimeValue time,
@@ -239,13 +275,15 @@ public:
                                                                 bool jitterAdd,
                                                                 bool robustModel,
                                                                 const TrackerParamsProviderPtr& params,
-                                                                const std::vector<TrackMarkerPtr>& allMarkers);
+                                                                const std::vector<TrackMarkerPtr>& allMarkers,
+                                                                const TrackerSolverCachePtr& cache);
 
 
 
     /**
      * @brief Given the markers that have been tracked, computes the CornerPin mapping from refTime
      * to time.
+     * If cache is not NULL, the result is taken from it if the points at time did not change since it was last computed.
      **/
     static CornerPinData computeCornerPinParamsFromTracksAtTime(TimeValue refTime,
                                                                 TimeValue time,
@@ -253,7 +291,8 @@ public:
                                                                 bool jitterAdd,
                                                                 bool robustModel,
                                                                 const TrackerParamsProviderPtr& params,
-                                                                const std::vector<TrackMarkerPtr>& allMarkers);
+                                                                const std::vector<TrackMarkerPtr>& allMarkers,
+                                                                const TrackerSolverCachePtr& cache);
 
     static Point applyHomography(const Point& p, const Transform::Matrix3x3& h);
     
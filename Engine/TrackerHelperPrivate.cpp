@@ -30,6 +30,7 @@
 
 #include "Engine/AppInstance.h"
 #include "Engine/Curve.h"
+#include "Engine/Hash64.h"
 #include "Engine/Project.h"
 #include "Engine/TimeLine.h"
 #include "Engine/KnobTypes.h"
@@ -350,6 +351,7 @@ TrackerHelperPrivate::beginLibMVOptionsForTrack(mv::TrackRegionOptions* options)
     assert(options->minimum_correlation >= 0. && options->minimum_correlation <= 1.);
     options->max_iterations = params->getMaxNIterations();
     options->use_brute_initialization = params->isBruteForcePreTrackEnabled();
+    options->brute_pyramid_levels = params->getBrutePyramidLevels();
     options->use_normalized_intensities = params->isNormalizeIntensitiesEnabled();
     options->sigma = params->getPreBlurSigma();
 
@@ -802,6 +804,39 @@ TrackerHelper::extractSortedPointsFromMarkers(TimeValue refTime,
     }
 } // TrackerContext::extractSortedPointsFromMarkers
 
+/**
+ * @brief Returns a hash of everything a solve at a frame depends on, see TrackerSolverCache
+ **/
+static U64
+getSolvePointsHash(TimeValue refTime,
+                   TimeValue time,
+                   bool robustModel,
+                   int w1,
+                   int h1,
+                   int w2,
+                   int h2,
+                   const std::vector<Point>& x1,
+                   const std::vector<Point>& x2)
+{
+    Hash64 hash;
+    hash.append((double)refTime);
+    hash.append((double)time);
+    hash.append(robustModel);
+    hash.append(w1);
+    hash.append(h1);
+    hash.append(w2);
+    hash.append(h2);
+    for (std::size_t i = 0; i < x1.size(); ++i) {
+        hash.append(x1[i].x);
+        hash.append(x1[i].y);
+        hash.append(x2[i].x);
+        hash.append(x2[i].y);
+    }
+    hash.computeHash();
+
+    return hash.value();
+}
+
 TransformData
 TrackerHelper::computeTransformParamsFromTracksAtTime(TimeValue refTime,
                                                       TimeValue time,
@@ -809,7 +844,8 @@ TrackerHelper::computeTransformParamsFromTracksAtTime(TimeValue refTime,
                                                       bool jitterAdd,
                                                       bool robustModel,
                                                       const TrackerParamsProviderPtr& params,
-                                                      const std::vector<TrackMarkerPtr>& allMarkers)
+                                                      const std::vector<TrackMarkerPtr>& allMarkers,
+                                                      const TrackerSolverCachePtr& cache)
 {
     RectD rodRef = params->getNormalizationRoD(refTime, ViewIdx(0));
     RectD rodTime = params->getNormalizationRoD(time, ViewIdx(0));
@@ -847,6 +883,14 @@ TrackerHelper::computeTransformParamsFromTracksAtTime(TimeValue refTime,
     }
 
 
+    U64 pointsHash = 0;
+    if (cache) {
+        pointsHash = getSolvePointsHash(refTime, time, robustModel, w1, h1, w2, h2, x1, x2);
+        if ( cache->getTransformData(time, pointsHash, &data) ) {
+            return data;
+        }
+    }
+
     const bool dataSetIsUserManual = true;
 
     try {
@@ -861,6 +905,10 @@ TrackerHelper::computeTransformParamsFromTracksAtTime(TimeValue refTime,
         data.valid = false;
     }
 
+    if (cache) {
+        cache->setTransformData(time, pointsHash, data);
+    }
+
     return data;
 } // TrackerHelperPrivate::computeTransformParamsFromTracksAtTime
 
@@ -871,7 +919,8 @@ TrackerHelper::computeCornerPinParamsFromTracksAtTime(TimeValue refTime,
                                                       bool jitterAdd,
                                                       bool robustModel,
                                                       const TrackerParamsProviderPtr& params,
-                                                      const std::vector<TrackMarkerPtr>& allMarkers)
+                                                      const std::vector<TrackMarkerPtr>& allMarkers,
+                                                      const TrackerSolverCachePtr& cache)
 {
     RectD rodRef = params->getNormalizationRoD(refTime, ViewIdx(0));
     RectD rodTime = params->getNormalizationRoD(time, ViewIdx(0));
@@ -919,6 +968,14 @@ TrackerHelper::computeCornerPinParamsFromTracksAtTime(TimeValue refTime,
         data.h.setAffineFromThreePoints( euclideanToHomogenous(x1[0]), euclideanToHomogenous(x1[1]), euclideanToHomogenous(x1[2]), euclideanToHomogenous(x2[0]), euclideanToHomogenous(x2[1]), euclideanToHomogenous(x2[2]) );
         data.nbEnabledPoints = 3;
     } else {
+        // Only the homography is expensive to solve
+        U64 pointsHash = 0;
+        if (cache) {
+            pointsHash = getSolvePointsHash(refTime, time, robustModel, w1, h1, w2, h2, x1, x2);
+            if ( cache->getCornerPinData(time, pointsHash, &data) ) {
+                return data;
+            }
+        }
         const bool dataSetIsUserManual = true;
         try {
             computeHomographyFromNPoints(dataSetIsUserManual, robustModel, x1, x2, w1, h1, w2, h2, &data.h, &data.rms);
@@ -926,6 +983,9 @@ TrackerHelper::computeCornerPinParamsFromTracksAtTime(TimeValue refTime,
         } catch (...) {
             data.valid = false;
         }
+        if (cache) {
+            cache->setCornerPinData(time, pointsHash, data);
+        }
     }
 
     return data;
@@ -882,6 +882,17 @@ TrackerNode::initializeTrackingPageKnobs(const KnobPagePtr& trackingPage)
         trackingPage->addKnob(param);
         _imp->useNormalizedIntensities = param;
     }
+    {
+        KnobIntPtr param = createKnob<KnobInt>(kTrackerParamBrutePyramidLevels);
+        param->setLabel(tr(kTrackerParamBrutePyramidLevelsLabel));
+        param->setHintToolTip( tr(kTrackerParamBrutePyramidLevelsHint) );
+        param->setAnimationEnabled(false);
+        param->setRange(0, 4);
+        param->setDefaultValue(0);
+        param->setEvaluateOnChange(false);
+        trackingPage->addKnob(param);
+        _imp->brutePyramidLevels = param;
+    }
     {
         KnobDoublePtr param = createKnob<KnobDouble>(kTrackerParamPreBlurSigma);
         param->setLabel(tr(kTrackerParamPreBlurSigmaLabel));
@@ -1856,6 +1867,7 @@ TrackerNodePrivate::refreshVisibilityFromTransformTypeInternal(TrackerTransformN
     maxError.lock()->setSecret(usePM);
     maxIterations.lock()->setSecret(usePM);
     bruteForcePreTrack.lock()->setSecret(usePM);
+    brutePyramidLevels.lock()->setSecret(usePM);
     useNormalizedIntensities.lock()->setSecret(usePM);
     preBlurSigma.lock()->setSecret(usePM);
 
@@ -1961,6 +1973,17 @@ TrackerNodePrivate::endTrackSequence(const TrackArgsBasePtr& args)
 
 }
 
+void
+TrackerNodePrivate::refreshTrackSequenceGui(const TrackArgsBasePtr& args)
+{
+    TrackArgs* trackerArgs = dynamic_cast<TrackArgs*>(args.get());
+    const std::vector<TrackMarkerAndOptionsPtr >& tracks = trackerArgs->getTracks();
+
+    for (std::size_t i = 0; i < tracks.size(); ++i) {
+        tracks[i]->natronMarker->refreshKnobsGuiWhileTracking();
+    }
+}
+
 NodePtr
 TrackerNodePrivate::getTrackerNode() const
 {
@@ -2023,6 +2046,12 @@ TrackerNodePrivate::isBruteForcePreTrackEnabled() const
     return bruteForcePreTrack.lock()->getValue();
 }
 
+int
+TrackerNodePrivate::getBrutePyramidLevels() const
+{
+    return brutePyramidLevels.lock()->getValue();
+}
+
 bool
 TrackerNodePrivate::isNormalizeIntensitiesEnabled() const
 {
@@ -52,6 +52,7 @@ TrackerNodePrivate::TrackerNodePrivate(TrackerNode* publicInterface)
     : TrackerParamsProvider()
     , publicInterface(publicInterface)
     , ui()
+    , solverCache( new TrackerSolverCache() )
 {
 }
 
@@ -1881,24 +1882,116 @@ TrackerNodeInteract::onAllKeyframesRemovedOnTrack(const TrackMarkerPtr& marker)
 }
 
 
-struct CenterPointDisplayInfo
+const CenterPointsMap&
+TrackerNodeInteract::getTrackCenterPoints(const TrackMarkerPtr& marker,
+                                          bool showErrorColor)
 {
-    double x;
-    double y;
-    double err;
-    bool isValid;
-
-    CenterPointDisplayInfo()
-    : x(0)
-    , y(0)
-    , err(0)
-    , isValid(false)
-    {
+    KnobDoublePtr centerKnob = marker->getCenterKnob();
+    KnobDoublePtr errorKnob = marker->getErrorKnob();
+    CurvePtr xCurve = centerKnob->getAnimationCurve(ViewIdx(0), DimIdx(0));
+    CurvePtr yCurve = centerKnob->getAnimationCurve(ViewIdx(0), DimIdx(1));
+    CurvePtr errorCurve = errorKnob->getAnimationCurve(ViewIdx(0), DimIdx(0));
+
+    KeyFrameSetConstPtr xKeysSnapshot = xCurve->getKeyFramesSnapshot_mt_safe();
+    KeyFrameSetConstPtr yKeysSnapshot = yCurve->getKeyFramesSnapshot_mt_safe();
+    KeyFrameSetConstPtr errKeysSnapshot;
+    if (showErrorColor) {
+        errKeysSnapshot = errorCurve->getKeyFramesSnapshot_mt_safe();
+    }
+
+    TrackCenterPointsCache& cache = trackCenterPoints[marker];
+    if ( cache.xKeys && (cache.xKeys == xKeysSnapshot) && (cache.yKeys == yKeysSnapshot) && (cache.errKeys == errKeysSnapshot) && (cache.showErrorColor == showErrorColor) ) {
+        return cache.points;
+    }
+    cache.xKeys = xKeysSnapshot;
+    cache.yKeys = yKeysSnapshot;
+    cache.errKeys = errKeysSnapshot;
+    cache.showErrorColor = showErrorColor;
+
+    CenterPointsMap& centerPoints = cache.points;
+    centerPoints.clear();
+
+    const KeyFrameSet& xKeyframes = *xKeysSnapshot;
+    const KeyFrameSet& yKeyframes = *yKeysSnapshot;
+    KeyFrameSet noErrKeyframes;
+    const KeyFrameSet& errKeyframes = showErrorColor ? *errKeysSnapshot : noErrKeyframes;
+
+    // Try first to do an optimized case in O(N) where we assume that all 3 curves have the same keyframes
+    // at the same time
+    KeyFrameSet remainingXKeys,remainingYKeys, remainingErrKeys;
+    if (xKeyframes.size() == yKeyframes.size() && (!showErrorColor || xKeyframes.size() == errKeyframes.size())) {
+        KeyFrameSet::const_iterator errIt = errKeyframes.begin();
+        KeyFrameSet::const_iterator xIt = xKeyframes.begin();
+        KeyFrameSet::const_iterator yIt = yKeyframes.begin();
+
+        bool setsHaveDifferentKeyTimes = false;
+        while (xIt!=xKeyframes.end()) {
+            if (xIt->getTime() != yIt->getTime() || (showErrorColor && xIt->getTime() != errIt->getTime())) {
+                setsHaveDifferentKeyTimes = true;
+                break;
+            }
+            CenterPointDisplayInfo& p = centerPoints[xIt->getTime()];
+            p.x = xIt->getValue();
+            p.y = yIt->getValue();
+            if ( showErrorColor ) {
+                p.err = errIt->getValue();
+            }
+            p.isValid = true;
+
+            ++xIt;
+            ++yIt;
+            if (showErrorColor) {
+                ++errIt;
+            }
 
+        }
+        if (setsHaveDifferentKeyTimes) {
+            remainingXKeys.insert(xIt, xKeyframes.end());
+            remainingYKeys.insert(yIt, yKeyframes.end());
+            if (showErrorColor) {
+                remainingErrKeys.insert(errIt, errKeyframes.end());
+            }
+        }
+    } else {
+        remainingXKeys = xKeyframes;
+        remainingYKeys = yKeyframes;
+        if (showErrorColor) {
+            remainingErrKeys = errKeyframes;
+        }
+    }
+    for (KeyFrameSet::iterator xIt = remainingXKeys.begin(); xIt != remainingXKeys.end(); ++xIt) {
+        CenterPointDisplayInfo& p = centerPoints[xIt->getTime()];
+        p.x = xIt->getValue();
+        p.isValid = false;
+    }
+    for (KeyFrameSet::iterator yIt = remainingYKeys.begin(); yIt != remainingYKeys.end(); ++yIt) {
+        CenterPointsMap::iterator foundPoint = centerPoints.find(yIt->getTime());
+        if (foundPoint == centerPoints.end()) {
+            continue;
+        }
+        foundPoint->second.y = yIt->getValue();
+        if (!showErrorColor) {
+            foundPoint->second.isValid = true;
+        }
+    }
+    for (KeyFrameSet::iterator errIt = remainingErrKeys.begin(); errIt != remainingErrKeys.end(); ++errIt) {
+        CenterPointsMap::iterator foundPoint = centerPoints.find(errIt->getTime());
+        if (foundPoint == centerPoints.end()) {
+            continue;
+        }
+        foundPoint->second.err = errIt->getValue();
+        foundPoint->second.isValid = true;
     }
-};
 
-typedef std::map<double, CenterPointDisplayInfo> CenterPointsMap;
+    return centerPoints;
+} // getTrackCenterPoints
+
+struct UnselectedMarkerDisplayInfo
+{
+    double x;
+    double y;
+    double color[3];
+};
 
 void
 TrackerNodeInteract::drawOverlay(TimeValue time,
@@ -1929,6 +2022,84 @@ TrackerNodeInteract::drawOverlay(TimeValue time,
         bool trackingPageSecret = _imp->trackingPageKnob.lock()->getIsSecret();
         bool showErrorColor = showCorrelationButton.lock()->getValue();
         TrackMarkerPtr marker = selectedMarker.lock();
+
+        // Forget the tracks of the markers that were removed
+        for (TrackCenterPointsMap::iterator it = trackCenterPoints.begin(); it != trackCenterPoints.end();) {
+            if ( it->first.expired() ) {
+                trackCenterPoints.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+
+        // The markers that are not selected are drawn first, all at once since there may be hundreds of them
+        {
+            std::vector<UnselectedMarkerDisplayInfo> unselectedMarkers;
+            unselectedMarkers.reserve( allMarkers.size() );
+            for (std::vector<TrackMarkerPtr >::iterator it = allMarkers.begin(); it != allMarkers.end(); ++it) {
+                bool isSelected = std::find(selectedMarkers.begin(), selectedMarkers.end(), *it) != selectedMarkers.end();
+                if (isSelected && !trackingPageSecret) {
+                    continue;
+                }
+                bool isEnabled = (*it)->isEnabled(time);
+                KnobDoublePtr centerKnob = (*it)->getCenterKnob();
+                UnselectedMarkerDisplayInfo info;
+                info.x = centerKnob->getValueAtTime(time, DimIdx(0));
+                info.y = centerKnob->getValueAtTime(time, DimIdx(1));
+                for (int i = 0; i < 3; ++i) {
+                    info.color[i] = isEnabled ? markerColor[i] : markerColor[i] / 2.;
+                }
+                unselectedMarkers.push_back(info);
+            }
+
+            if ( !unselectedMarkers.empty() ) {
+                ///Draw a custom interact, indicating the track isn't selected
+                GL_GPU::Enable(GL_LINE_SMOOTH);
+                GL_GPU::Hint(GL_LINE_SMOOTH_HINT, GL_DONT_CARE);
+                GL_GPU::LineWidth(1.5f);
+
+                for (int l = 0; l < 2; ++l) {
+                    // shadow (uses GL_PROJECTION)
+                    GL_GPU::MatrixMode(GL_PROJECTION);
+                    int direction = (l == 0) ? 1 : -1;
+                    // translate (1,-1) pixels
+                    GL_GPU::Translated(direction * pixelScaleX / 256, -direction * pixelScaleY / 256, 0);
+                    GL_GPU::MatrixMode(GL_MODELVIEW);
+
+                    if (l == 0) {
+                        GL_GPU::Color4d(0., 0., 0., 1.);
+                    }
+
+                    GL_GPU::PointSize(POINT_SIZE);
+                    GL_GPU::Begin(GL_POINTS);
+                    for (std::size_t i = 0; i < unselectedMarkers.size(); ++i) {
+                        if (l != 0) {
+                            GL_GPU::Color4f(unselectedMarkers[i].color[0], unselectedMarkers[i].color[1], unselectedMarkers[i].color[2], 1.);
+                        }
+                        GL_GPU::Vertex2d(unselectedMarkers[i].x, unselectedMarkers[i].y);
+                    }
+                    GL_GPU::End();
+
+                    GL_GPU::Begin(GL_LINES);
+                    for (std::size_t i = 0; i < unselectedMarkers.size(); ++i) {
+                        double x = unselectedMarkers[i].x;
+                        double y = unselectedMarkers[i].y;
+                        if (l != 0) {
+                            GL_GPU::Color4f(unselectedMarkers[i].color[0], unselectedMarkers[i].color[1], unselectedMarkers[i].color[2], 1.);
+                        }
+                        GL_GPU::Vertex2d(x - CROSS_SIZE * pixelScaleX, y);
+                        GL_GPU::Vertex2d(x + CROSS_SIZE * pixelScaleX, y);
+
+
+                        GL_GPU::Vertex2d(x, y - CROSS_SIZE * pixelScaleY);
+                        GL_GPU::Vertex2d(x, y + CROSS_SIZE * pixelScaleY);
+                    }
+                    GL_GPU::End();
+                }
+                GL_GPU::PointSize(1.);
+            }
+        }
+
         bool selectedFound = false;
         Point selectedCenter;
         Point selectedPtnTopLeft;
@@ -1940,6 +2111,14 @@ TrackerNodeInteract::drawOverlay(TimeValue time,
         Point selectedSearchTopRight;
 
         for (std::vector<TrackMarkerPtr >::iterator it = allMarkers.begin(); it != allMarkers.end(); ++it) {
+            std::list<TrackMarkerPtr >::iterator foundSelected = std::find(selectedMarkers.begin(), selectedMarkers.end(), *it);
+            bool isSelected = foundSelected != selectedMarkers.end();
+
+            // When the tracking page is secret, still show markers, but as if deselected: they were drawn above
+            if (!isSelected || trackingPageSecret) {
+                continue;
+            }
+
             bool isEnabled = (*it)->isEnabled(time);
 
             double thisMarkerColor[3];
@@ -1956,11 +2135,8 @@ TrackerNodeInteract::drawOverlay(TimeValue time,
             bool isHoverMarker = *it == hoverMarker;
             bool isDraggedMarker = *it == interactMarker;
             bool isHoverOrDraggedMarker = isHoverMarker || isDraggedMarker;
-            std::list<TrackMarkerPtr >::iterator foundSelected = std::find(selectedMarkers.begin(), selectedMarkers.end(), *it);
-            bool isSelected = foundSelected != selectedMarkers.end();
             KnobDoublePtr centerKnob = (*it)->getCenterKnob();
             KnobDoublePtr offsetKnob = (*it)->getOffsetKnob();
-            KnobDoublePtr errorKnob = (*it)->getErrorKnob();
             KnobDoublePtr ptnTopLeft = (*it)->getPatternTopLeftKnob();
             KnobDoublePtr ptnTopRight = (*it)->getPatternTopRightKnob();
             KnobDoublePtr ptnBtmRight = (*it)->getPatternBtmRightKnob();
@@ -1968,47 +2144,7 @@ TrackerNodeInteract::drawOverlay(TimeValue time,
             KnobDoublePtr searchWndBtmLeft = (*it)->getSearchWindowBottomLeftKnob();
             KnobDoublePtr searchWndTopRight = (*it)->getSearchWindowTopRightKnob();
 
-            // When the tracking page is secret, still show markers, but as if deselected
-            if (!isSelected || trackingPageSecret) {
-                ///Draw a custom interact, indicating the track isn't selected
-                GL_GPU::Enable(GL_LINE_SMOOTH);
-                GL_GPU::Hint(GL_LINE_SMOOTH_HINT, GL_DONT_CARE);
-                GL_GPU::LineWidth(1.5f);
-
-                for (int l = 0; l < 2; ++l) {
-                    // shadow (uses GL_PROJECTION)
-                    GL_GPU::MatrixMode(GL_PROJECTION);
-                    int direction = (l == 0) ? 1 : -1;
-                    // translate (1,-1) pixels
-                    GL_GPU::Translated(direction * pixelScaleX / 256, -direction * pixelScaleY / 256, 0);
-                    GL_GPU::MatrixMode(GL_MODELVIEW);
-
-                    if (l == 0) {
-                        GL_GPU::Color4d(0., 0., 0., 1.);
-                    } else {
-                        GL_GPU::Color4f(thisMarkerColor[0], thisMarkerColor[1], thisMarkerColor[2], 1.);
-                    }
-
-
-                    double x = centerKnob->getValueAtTime(time, DimIdx(0));
-                    double y = centerKnob->getValueAtTime(time, DimIdx(1));
-
-                    GL_GPU::PointSize(POINT_SIZE);
-                    GL_GPU::Begin(GL_POINTS);
-                    GL_GPU::Vertex2d(x, y);
-                    GL_GPU::End();
-
-                    GL_GPU::Begin(GL_LINES);
-                    GL_GPU::Vertex2d(x - CROSS_SIZE * pixelScaleX, y);
-                    GL_GPU::Vertex2d(x + CROSS_SIZE * pixelScaleX, y);
-
-
-                    GL_GPU::Vertex2d(x, y - CROSS_SIZE * pixelScaleY);
-                    GL_GPU::Vertex2d(x, y + CROSS_SIZE * pixelScaleY);
-                    GL_GPU::End();
-                }
-                GL_GPU::PointSize(1.);
-            } else { // if (isSelected) {
+            {
                 GL_GPU::Enable(GL_LINE_SMOOTH);
                 GL_GPU::Hint(GL_LINE_SMOOTH_HINT, GL_DONT_CARE);
                 GLdouble projection[16];
@@ -2087,89 +2223,7 @@ TrackerNodeInteract::drawOverlay(TimeValue time,
                     name += ' ';
                     name += tr("(disabled)").toStdString();
                 }
-                CenterPointsMap centerPoints;
-                CurvePtr xCurve = centerKnob->getAnimationCurve(ViewIdx(0), DimIdx(0));
-                CurvePtr yCurve = centerKnob->getAnimationCurve(ViewIdx(0), DimIdx(1));
-                CurvePtr errorCurve = errorKnob->getAnimationCurve(ViewIdx(0), DimIdx(0));
-
-                {
-                    KeyFrameSet xKeyframes = xCurve->getKeyFrames_mt_safe();
-                    KeyFrameSet yKeyframes = yCurve->getKeyFrames_mt_safe();
-                    KeyFrameSet errKeyframes;
-                    if (showErrorColor) {
-                        errKeyframes = errorCurve->getKeyFrames_mt_safe();
-                    }
-
-                    // Try first to do an optimized case in O(N) where we assume that all 3 curves have the same keyframes
-                    // at the same time
-                    KeyFrameSet remainingXKeys,remainingYKeys, remainingErrKeys;
-                    if (xKeyframes.size() == yKeyframes.size() && (!showErrorColor || xKeyframes.size() == errKeyframes.size())) {
-                        KeyFrameSet::iterator errIt = errKeyframes.begin();
-                        KeyFrameSet::iterator xIt = xKeyframes.begin();
-                        KeyFrameSet::iterator yIt = yKeyframes.begin();
-
-                        bool setsHaveDifferentKeyTimes = false;
-                        while (xIt!=xKeyframes.end()) {
-                            if (xIt->getTime() != yIt->getTime() || (showErrorColor && xIt->getTime() != errIt->getTime())) {
-                                setsHaveDifferentKeyTimes = true;
-                                break;
-                            }
-                            CenterPointDisplayInfo& p = centerPoints[xIt->getTime()];
-                            p.x = xIt->getValue();
-                            p.y = yIt->getValue();
-                            if ( showErrorColor ) {
-                                p.err = errIt->getValue();
-                            }
-                            p.isValid = true;
-
-                            ++xIt;
-                            ++yIt;
-                            if (showErrorColor) {
-                                ++errIt;
-                            }
-
-                        }
-                        if (setsHaveDifferentKeyTimes) {
-                            remainingXKeys.insert(xIt, xKeyframes.end());
-                            remainingYKeys.insert(yIt, yKeyframes.end());
-                            if (showErrorColor) {
-                                remainingErrKeys.insert(errIt, errKeyframes.end());
-                            }
-                        }
-                    } else {
-                        remainingXKeys = xKeyframes;
-                        remainingYKeys = yKeyframes;
-                        if (showErrorColor) {
-                            remainingErrKeys = errKeyframes;
-                        }
-                    }
-                    for (KeyFrameSet::iterator xIt = remainingXKeys.begin(); xIt != remainingXKeys.end(); ++xIt) {
-                        CenterPointDisplayInfo& p = centerPoints[xIt->getTime()];
-                        p.x = xIt->getValue();
-                        p.isValid = false;
-                    }
-                    for (KeyFrameSet::iterator yIt = remainingYKeys.begin(); yIt != remainingYKeys.end(); ++yIt) {
-                        CenterPointsMap::iterator foundPoint = centerPoints.find(yIt->getTime());
-                        if (foundPoint == centerPoints.end()) {
-                            continue;
-                        }
-                        foundPoint->second.y = yIt->getValue();
-                        if (!showErrorColor) {
-                            foundPoint->second.isValid = true;
-                        }
-                    }
-                    for (KeyFrameSet::iterator errIt = remainingErrKeys.begin(); errIt != remainingErrKeys.end(); ++errIt) {
-                        CenterPointsMap::iterator foundPoint = centerPoints.find(errIt->getTime());
-                        if (foundPoint == centerPoints.end()) {
-                            continue;
-                        }
-                        foundPoint->second.err = errIt->getValue();
-                        foundPoint->second.isValid = true;
-                    }
-
-                }
-
-
+                const CenterPointsMap& centerPoints = getTrackCenterPoints(*it, showErrorColor);
 
                 for (int l = 0; l < 2; ++l) {
                     // shadow (uses GL_PROJECTION)
@@ -2413,7 +2467,7 @@ TrackerNodeInteract::drawOverlay(TimeValue time,
 
                     overlay->renderText( center.x(), center.y(), name, markerColor[0], markerColor[1], markerColor[2], markerColor[3]);
                 } // for (int l = 0; l < 2; ++l) {
-            } // if (!isSelected) {
+            }
         } // for (std::vector<TrackMarkerPtr >::iterator it = allMarkers.begin(); it!=allMarkers.end(); ++it) {
 
         if (showMarkerTexture && selectedFound) {
@@ -42,6 +42,7 @@
 
 #include <ofxNatron.h>
 
+#include "Engine/Curve.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/RectI.h"
 #include "Engine/KnobItemsTable.h"
@@ -270,6 +271,12 @@ NATRON_NAMESPACE_ENTER;
 #define kTrackerParamBruteForcePreTrackLabel "Use brute-force pre-track"
 #define kTrackerParamBruteForcePreTrackHint "Use a brute-force translation-only pre-track before refinement"
 
+#define kTrackerParamBrutePyramidLevels "brutePyramidLevels"
+#define kTrackerParamBrutePyramidLevelsLabel "Pre-track pyramid levels"
+#define kTrackerParamBrutePyramidLevelsHint "When greater than 0, the brute-force pre-track first searches the translation on the images " \
+"downscaled by 2 to the power of this value, then refines it on each finer level. This is much faster for large search areas " \
+"and fast motion, but may miss the best match for patterns with very fine details."
+
 #define kTrackerParamNormalizeIntensities "normalizeIntensities"
 #define kTrackerParamNormalizeIntensitiesLabel "Normalize Intensities"
 #define kTrackerParamNormalizeIntensitiesHint "Normalize the image patches by their mean before doing the sum of squared" \
@@ -535,6 +542,44 @@ enum TrackerDrawStateEnum
     eDrawStateShowScalingHint,
 };
 
+struct CenterPointDisplayInfo
+{
+    double x;
+    double y;
+    double err;
+    bool isValid;
+
+    CenterPointDisplayInfo()
+    : x(0)
+    , y(0)
+    , err(0)
+    , isValid(false)
+    {
+
+    }
+};
+
+typedef std::map<double, CenterPointDisplayInfo> CenterPointsMap;
+
+// The track of a marker drawn by the interact, computed from the keyframes of the center and error curves
+struct TrackCenterPointsCache
+{
+    // The keyframes from which points was computed: if the curves still return the same snapshots, the track did not change
+    KeyFrameSetConstPtr xKeys, yKeys, errKeys;
+    bool showErrorColor;
+    CenterPointsMap points;
+
+    TrackCenterPointsCache()
+    : xKeys()
+    , yKeys()
+    , errKeys()
+    , showErrorColor(false)
+    , points()
+    {
+
+    }
+};
+
 typedef QFutureWatcher<std::pair<ImagePtr, RectD> > TrackWatcher;
 typedef boost::shared_ptr<TrackWatcher> TrackWatcherPtr;
 
@@ -619,6 +664,7 @@ public:
     KnobDoubleWPtr maxError;
     KnobIntWPtr maxIterations;
     KnobBoolWPtr bruteForcePreTrack, useNormalizedIntensities;
+    KnobIntWPtr brutePyramidLevels;
     KnobDoubleWPtr preBlurSigma;
     KnobSeparatorWPtr perTrackParamsSeparator;
     KnobBoolWPtr activateTrack;
@@ -680,6 +726,9 @@ public:
 
     SolveRequest lastSolveRequest;
 
+    // The results of the previous solves, re-used for the frames whose markers did not change
+    TrackerSolverCachePtr solverCache;
+
 
 private:
 
@@ -757,10 +806,17 @@ public:
 
     void endSolve();
 
+    /**
+     * @brief Cancels the solve in progress, if any, and waits for the frames being solved to return.
+     * The results of the cancelled solve are not applied.
+     **/
+    void cancelSolve();
+
     //////////////////// Overriden from TrackerParamsProviderBase
     virtual bool trackStepFunctor(int trackIndex, const TrackArgsBasePtr& args, int frame) OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual void beginTrackSequence(const TrackArgsBasePtr& args) OVERRIDE FINAL;
     virtual void endTrackSequence(const TrackArgsBasePtr& args) OVERRIDE FINAL;
+    virtual void refreshTrackSequenceGui(const TrackArgsBasePtr& args) OVERRIDE FINAL;
     ////////////////////
 
     //////////////////// Overriden from TrackerParamsProvider
@@ -773,6 +829,7 @@ public:
     virtual double getMaxError() const OVERRIDE FINAL;
     virtual int getMaxNIterations() const OVERRIDE FINAL;
     virtual bool isBruteForcePreTrackEnabled() const OVERRIDE FINAL;
+    virtual int getBrutePyramidLevels() const OVERRIDE FINAL;
     virtual bool isNormalizeIntensitiesEnabled() const OVERRIDE FINAL;
     virtual double getPreBlurSigma() const OVERRIDE FINAL;
     virtual RectD getNormalizationRoD(TimeValue time, ViewIdx view) const OVERRIDE FINAL;
@@ -886,6 +943,8 @@ public:
     typedef std::map<TimeValue, GLTexturePtr > KeyFrameTexIDs;
     typedef std::map<boost::weak_ptr<TrackMarker>, KeyFrameTexIDs> TrackKeysMap;
     TrackKeysMap trackTextures;
+    typedef std::map<boost::weak_ptr<TrackMarker>, TrackCenterPointsCache> TrackCenterPointsMap;
+    TrackCenterPointsMap trackCenterPoints;
     TrackKeyframeRequests trackRequestsMap;
     GLTexturePtr selectedMarkerTexture;
     //If theres a single selection, this points to it
@@ -980,6 +1039,12 @@ public:
     static Point toMagWindowPoint(const Point& ptnPoint,
                                   const RectD& canonicalSearchWindow,
                                   const RectD& textureRectCanonical);
+    /**
+     * @brief Returns the points of the track of the given marker. They are computed again only if the keyframes of the marker
+     * center or error changed since the last call.
+     **/
+    const CenterPointsMap& getTrackCenterPoints(const TrackMarkerPtr& marker, bool showErrorColor);
+
     static QPointF computeMidPointExtent(const QPointF& prev,
                                          const QPointF& next,
                                          const QPointF& point,
@@ -282,6 +282,9 @@ TrackerNodePrivate::solveTransformParamsIfAutomatic()
 void
 TrackerNodePrivate::solveTransformParams()
 {
+    // Editing a marker while the previous solve is running must not pile up solves of the whole range
+    cancelSolve();
+
     setTransformOutOfDate(false);
 
     std::vector<TrackMarkerPtr> markers;
@@ -796,7 +799,8 @@ TrackerNodePrivate::computeCornerParamsFromTracks()
                                                                                                          lastSolveRequest.jitterAdd,
                                                                                                          lastSolveRequest.robustModel,
                                                                                                          thisShared,
-                                                                                                         lastSolveRequest.allMarkers)) );
+                                                                                                         lastSolveRequest.allMarkers,
+                                                                                                         solverCache)) );
 #else
     NodePtr thisNode = publicInterface->getNode();
     QList<CornerPinData> validResults;
@@ -804,7 +808,7 @@ TrackerNodePrivate::computeCornerParamsFromTracks()
         int nKeys = (int)lastSolveRequest.keyframes.size();
         int keyIndex = 0;
         for (std::set<double>::const_iterator it = lastSolveRequest.keyframes.begin(); it != lastSolveRequest.keyframes.end(); ++it, ++keyIndex) {
-            CornerPinData data = tracker->computeCornerPinParamsFromTracksAtTime(lastSolveRequest.refTime, *it, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, thisShared, lastSolveRequest.allMarkers);
+            CornerPinData data = tracker->computeCornerPinParamsFromTracksAtTime(lastSolveRequest.refTime, *it, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, thisShared, lastSolveRequest.allMarkers, solverCache);
             if (data.valid) {
                 validResults.push_back(data);
             }
@@ -976,7 +980,8 @@ TrackerNodePrivate::computeTransformParamsFromTracks()
                                                                                                         lastSolveRequest.jitterAdd,
                                                                                                         lastSolveRequest.robustModel,
                                                                                                         thisShared,
-                                                                                                        lastSolveRequest.allMarkers)) );
+                                                                                                        lastSolveRequest.allMarkers,
+                                                                                                        solverCache)) );
 #else
     NodePtr thisNode = publicInterface->getNode();
     QList<TransformData> validResults;
@@ -984,7 +989,7 @@ TrackerNodePrivate::computeTransformParamsFromTracks()
         int nKeys = lastSolveRequest.keyframes.size();
         int keyIndex = 0;
         for (std::set<double>::const_iterator it = lastSolveRequest.keyframes.begin(); it != lastSolveRequest.keyframes.end(); ++it, ++keyIndex) {
-            TransformData data = tracker->computeTransformParamsFromTracksAtTime(lastSolveRequest.refTime, *it, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, thisShared, lastSolveRequest.allMarkers);
+            TransformData data = tracker->computeTransformParamsFromTracksAtTime(lastSolveRequest.refTime, *it, lastSolveRequest.jitterPeriod, lastSolveRequest.jitterAdd, lastSolveRequest.robustModel, thisShared, lastSolveRequest.allMarkers, solverCache);
             if (data.valid) {
                 validResults.push_back(data);
             }
@@ -1000,6 +1005,13 @@ void
 TrackerNode::onCornerPinSolverWatcherFinished()
 {
     assert(_imp->lastSolveRequest.cpWatcher);
+    if ( _imp->lastSolveRequest.cpWatcher->isCanceled() ) {
+        // Cancelled from the progress dialog
+        _imp->endSolve();
+        _imp->setTransformOutOfDate(true);
+
+        return;
+    }
     _imp->computeCornerParamsFromTracksEnd( _imp->lastSolveRequest.refTime, _imp->lastSolveRequest.maxFittingError, _imp->lastSolveRequest.cpWatcher->future().results() );
 }
 
@@ -1007,6 +1019,13 @@ void
 TrackerNode::onTransformSolverWatcherFinished()
 {
     assert(_imp->lastSolveRequest.tWatcher);
+    if ( _imp->lastSolveRequest.tWatcher->isCanceled() ) {
+        // Cancelled from the progress dialog
+        _imp->endSolve();
+        _imp->setTransformOutOfDate(true);
+
+        return;
+    }
     _imp->computeTransformParamsFromTracksEnd( _imp->lastSolveRequest.refTime, _imp->lastSolveRequest.maxFittingError, _imp->lastSolveRequest.tWatcher->future().results() );
 }
 
@@ -1018,7 +1037,10 @@ TrackerNode::onCornerPinSolverWatcherProgress(int progress)
     double min = _imp->lastSolveRequest.cpWatcher->progressMinimum();
     double max = _imp->lastSolveRequest.cpWatcher->progressMaximum();
     double p = (progress - min) / (max - min);
-    thisNode->getApp()->progressUpdate(thisNode, p);
+    if ( !thisNode->getApp()->progressUpdate(thisNode, p) ) {
+        // The frames not solved yet are skipped, finished() is then emitted
+        _imp->lastSolveRequest.cpWatcher->cancel();
+    }
 }
 
 void
@@ -1029,7 +1051,10 @@ TrackerNode::onTransformSolverWatcherProgress(int progress)
     double min = _imp->lastSolveRequest.tWatcher->progressMinimum();
     double max = _imp->lastSolveRequest.tWatcher->progressMaximum();
     double p = (progress - min) / (max - min);
-    thisNode->getApp()->progressUpdate(thisNode, p);
+    if ( !thisNode->getApp()->progressUpdate(thisNode, p) ) {
+        // The frames not solved yet are skipped, finished() is then emitted
+        _imp->lastSolveRequest.tWatcher->cancel();
+    }
 }
 
 
@@ -1047,5 +1072,26 @@ TrackerNodePrivate::endSolve()
     n->getEffectInstance()->endChanges();
 }
 
+void
+TrackerNodePrivate::cancelSolve()
+{
+    if (!lastSolveRequest.tWatcher && !lastSolveRequest.cpWatcher) {
+        return;
+    }
+
+    // Disconnect first so that finished() of the cancelled solve is not handled
+    if (lastSolveRequest.tWatcher) {
+        lastSolveRequest.tWatcher->disconnect();
+        lastSolveRequest.tWatcher->cancel();
+        lastSolveRequest.tWatcher->waitForFinished();
+    }
+    if (lastSolveRequest.cpWatcher) {
+        lastSolveRequest.cpWatcher->disconnect();
+        lastSolveRequest.cpWatcher->cancel();
+        lastSolveRequest.cpWatcher->waitForFinished();
+    }
+    endSolve();
+}
+
 
 NATRON_NAMESPACE_EXIT
@@ -78,6 +78,12 @@ public:
      * @brief Called when the tracking ends for the sequence
      **/
     virtual void endTrackSequence(const TrackArgsBasePtr& /*args*/) {}
+
+    /**
+     * @brief Called while tracking a sequence, at most every NATRON_TRACKER_REPORT_PROGRESS_DELTA_MS,
+     * to refresh the gui with the results of the track steps since the previous call.
+     **/
+    virtual void refreshTrackSequenceGui(const TrackArgsBasePtr& /*args*/) {}
 };
 
 class TrackerParamsProvider : public TrackerParamsProviderBase
@@ -127,6 +133,12 @@ public:
      **/
     virtual bool isBruteForcePreTrackEnabled() const = 0;
 
+    /**
+     * @brief The number of downscaled levels the brute force track goes through before searching at full resolution.
+     * 0 means the brute force track searches the whole search area at full resolution.
+     **/
+    virtual int getBrutePyramidLevels() const = 0;
+
     /**
      * @brief Should all computations be normalized internally ?
      **/
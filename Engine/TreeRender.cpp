@@ -25,7 +25,11 @@
 
 #include "TreeRender.h"
 
+#include <algorithm>
+#include <list>
+#include <map>
 #include <set>
+#include <vector>
 #include <QtCore/QThread>
 #include <QMutex>
 #include <QTimer>
@@ -33,12 +37,20 @@
 #include <QWaitCondition>
 #include <QRunnable>
 
+#include <boost/make_shared.hpp>
+
+#include "Engine/AppManager.h"
+#include "Engine/ColorMatrix.h"
 #include "Engine/Image.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/FrameViewRequest.h"
 #include "Engine/GPUContextPool.h"
+#include "Engine/KnobFile.h"
+#include "Engine/MemoryAccount.h"
 #include "Engine/Node.h"
 #include "Engine/NodeGroup.h"
+#include "Engine/RenderArena.h"
+#include "Engine/RenderTrace.h"
 #include "Engine/RotoStrokeItem.h"
 #include "Engine/Settings.h"
 #include "Engine/Timer.h"
@@ -53,6 +65,50 @@
 
 //#define TRACE_RENDER_DEPENDENCIES
 
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Process-wide statistics on the time it takes for a render to return once setRenderAborted() was called
+ **/
+struct AbortLatencyStats
+{
+    QMutex lock;
+    int nAbortedRenders;
+    double totalLatency;
+    double maxLatency;
+
+    AbortLatencyStats()
+    : lock()
+    , nAbortedRenders(0)
+    , totalLatency(0)
+    , maxLatency(0)
+    {
+
+    }
+};
+
+static AbortLatencyStats abortLatencyStats;
+
+/**
+ * @brief The renders created by TreeRender::create() which are not destroyed yet, see TreeRender::getActiveRenders()
+ **/
+struct ActiveTreeRenders
+{
+    QMutex lock;
+    std::map<const TreeRender*, TreeRenderWPtr> renders;
+
+    ActiveTreeRenders()
+    : lock()
+    , renders()
+    {
+
+    }
+};
+
+static ActiveTreeRenders activeTreeRenders;
+
+NATRON_NAMESPACE_EXIT;
+
 
 NATRON_NAMESPACE_ENTER;
 
@@ -70,7 +126,9 @@ struct FrameViewRequestSharedDataPair
     RequestPassSharedDataPtr launchData;
 };
 
-// Render first the tasks with more dependencies: it has more chance to make more dependency-free new renders
+// Render first the tasks on the critical path, i.e: the tasks with the longest chain of tasks depending on them,
+// estimated with the past render times of the nodes.
+// Otherwise render first the tasks with more dependencies: it has more chance to make more dependency-free new renders
 // to enable better concurrency
 struct FrameViewRequestComparePriority
 {
@@ -87,6 +145,13 @@ struct FrameViewRequestComparePriority
         if (lhs.get() == rhs.get()) {
             return false;
         }
+        double lCost = _launchData->getCriticalPathCost(lhs);
+        double rCost = _launchData->getCriticalPathCost(rhs);
+        if (lCost > rCost) {
+            return true;
+        } else if (lCost < rCost) {
+            return false;
+        }
         int lNum = lhs->getNumListeners(_launchData);
         int rNum = rhs->getNumListeners(_launchData);
         if (lNum < rNum) {
@@ -100,7 +165,68 @@ struct FrameViewRequestComparePriority
     }
 };
 
-typedef std::set<FrameViewRequestPtr, FrameViewRequestComparePriority> DependencyFreeRenderSet;
+typedef std::set<FrameViewRequestPtr, FrameViewRequestComparePriority, RenderArenaAllocator<FrameViewRequestPtr> > DependencyFreeRenderSet;
+
+// Identifies the image produced by a request, see TreeRender::getOrRegisterIdenticalRequest()
+struct IdenticalRequestKey
+{
+    U64 nodeFrameViewHash;
+    unsigned int mipMapLevel;
+    RenderScale proxyScale;
+    ImagePlaneDesc plane;
+
+    // Draft renders produce lower quality images: only requests of the same quality are identical
+    bool draftMode;
+};
+
+struct IdenticalRequestKey_Compare
+{
+    bool operator() (const IdenticalRequestKey& lhs, const IdenticalRequestKey& rhs) const
+    {
+        if (lhs.nodeFrameViewHash != rhs.nodeFrameViewHash) {
+            return lhs.nodeFrameViewHash < rhs.nodeFrameViewHash;
+        }
+        if (lhs.mipMapLevel != rhs.mipMapLevel) {
+            return lhs.mipMapLevel < rhs.mipMapLevel;
+        }
+        if (lhs.proxyScale.x != rhs.proxyScale.x) {
+            return lhs.proxyScale.x < rhs.proxyScale.x;
+        }
+        if (lhs.proxyScale.y != rhs.proxyScale.y) {
+            return lhs.proxyScale.y < rhs.proxyScale.y;
+        }
+        if (lhs.draftMode != rhs.draftMode) {
+            return !lhs.draftMode;
+        }
+        // The plane comparison only compares the plane ID, but the images must have the same components
+        if (lhs.plane < rhs.plane) {
+            return true;
+        } else if (rhs.plane < lhs.plane) {
+            return false;
+        }
+        return lhs.plane.getNumComponents() < rhs.plane.getNumComponents();
+    }
+};
+
+typedef std::map<IdenticalRequestKey, FrameViewRequestWPtr, IdenticalRequestKey_Compare> IdenticalRequestsMap;
+
+/**
+ * @brief The requests of all renders that are going to render their image, see TreeRender::getInFlightRequest()
+ **/
+struct InFlightRequests
+{
+    QMutex lock;
+    IdenticalRequestsMap requests;
+
+    InFlightRequests()
+    : lock()
+    , requests()
+    {
+
+    }
+};
+
+static InFlightRequests inFlightRequests;
 
 struct TreeRenderPrivate
 {
@@ -124,16 +250,34 @@ struct TreeRenderPrivate
     std::map<NodePtr, FrameViewRequestPtr> extraRequestedResults;
     mutable QMutex extraRequestedResultsMutex;
 
+    // The first request rendering each distinct image, see getOrRegisterIdenticalRequest()
+    IdenticalRequestsMap identicalRequests;
+    QMutex identicalRequestsMutex;
+
+    // The keys of the requests of this render registered in inFlightRequests, protected by inFlightRequests.lock
+    std::list<IdenticalRequestKey> inFlightRequestKeys;
+
     // the OpenGL contexts
     OSGLContextWPtr openGLContext, cpuOpenGLContext;
 
     // Are we aborted ?
     QAtomicInt aborted;
 
+    // Started when the render is aborted to measure how long it takes for the render to actually return.
+    // Protected by abortTimerMutex
+    boost::scoped_ptr<TimeLapse> abortTimer;
+    QMutex abortTimerMutex;
+
 
     bool handleNaNs;
     bool useConcatenations;
 
+    // The memory allocated by the nodes for this render
+    MemoryAccountPtr memoryAccount;
+
+    // The arena of the transient objects of this render
+    RenderArenaPtr arena;
+
 
     TreeRenderPrivate(TreeRender* publicInterface)
     : _publicInterface(publicInterface)
@@ -142,11 +286,18 @@ struct TreeRenderPrivate
     , state(eActionStatusOK)
     , extraRequestedResults()
     , extraRequestedResultsMutex()
+    , identicalRequests()
+    , identicalRequestsMutex()
+    , inFlightRequestKeys()
     , openGLContext()
     , cpuOpenGLContext()
     , aborted()
+    , abortTimer()
+    , abortTimerMutex()
     , handleNaNs(true)
     , useConcatenations(true)
+    , memoryAccount(new MemoryAccount)
+    , arena(new RenderArena)
     {
         aborted.fetchAndStoreAcquire(0);
 
@@ -161,10 +312,33 @@ struct TreeRenderPrivate
 
     void fetchOpenGLContext(const TreeRender::CtorArgsPtr& inArgs);
 
+    /**
+     * @brief If the render was aborted, add the time elapsed since the abort to the abort latency statistics
+     **/
+    void recordAbortLatency();
+
+    /**
+     * @brief Removes the requests of this render from the in-flight requests once it no longer renders them
+     **/
+    void unregisterInFlightRequests();
+
     static ActionRetCodeEnum getTreeRootRoD(const EffectInstancePtr& effect, TimeValue time, ViewIdx view, const RenderScale& scale, RectD* rod);
 
     static ActionRetCodeEnum getTreeRootPlane(const EffectInstancePtr& effect, TimeValue time, ViewIdx view, ImagePlaneDesc* plane);
 
+    /**
+     * @brief The list of planes to pass to launchRenderInternal(): empty if the plane is not provided
+     **/
+    static std::list<ImagePlaneDesc> getPlanesParam(const ImagePlaneDesc* plane)
+    {
+        std::list<ImagePlaneDesc> ret;
+        if (plane) {
+            ret.push_back(*plane);
+        }
+
+        return ret;
+    }
+
     ActionRetCodeEnum launchRenderInternal(bool removeRenderClonesWhenFinished,
                                            const EffectInstancePtr& treeRoot,
                                            TimeValue time,
@@ -174,12 +348,24 @@ struct TreeRenderPrivate
                                            const ImagePlaneDesc* plane,
                                            const RectD* canonicalRoI,
                                            FrameViewRequestPtr* outputRequest);
+
+    ActionRetCodeEnum launchRenderInternal(bool removeRenderClonesWhenFinished,
+                                           const EffectInstancePtr& treeRoot,
+                                           const std::list<FrameViewPair>& frames,
+                                           const RenderScale& proxyScale,
+                                           unsigned int mipMapLevel,
+                                           const std::list<ImagePlaneDesc>& planes,
+                                           const RectD* canonicalRoI,
+                                           const std::list<EffectInstancePtr>& extraTreeRoots,
+                                           std::list<FrameViewRequestPtr>* outputRequests);
 };
 
 TreeRender::CtorArgs::CtorArgs()
 : time(0)
 , view(0)
 , treeRootEffect()
+, extraTreeRoots()
+, extraViews()
 , extraNodesToSample()
 , activeRotoDrawableItem()
 , stats()
@@ -190,6 +376,7 @@ TreeRender::CtorArgs::CtorArgs()
 , draftMode(false)
 , playback(false)
 , byPassCache(false)
+, priority(eRenderPriorityInteractive)
 {
 
 }
@@ -201,7 +388,10 @@ TreeRender::TreeRender()
 
 TreeRender::~TreeRender()
 {
+    _imp->unregisterInFlightRequests();
 
+    QMutexLocker k(&activeTreeRenders.lock);
+    activeTreeRenders.renders.erase(this);
 }
 
 
@@ -216,6 +406,106 @@ TreeRender::getExtraRequestedResultsForNode(const NodePtr& node) const
     return found->second;
 }
 
+FrameViewRequestPtr
+TreeRender::getOrRegisterIdenticalRequest(U64 nodeFrameViewHash,
+                                          const FrameViewRequestPtr& request)
+{
+    IdenticalRequestKey key = {nodeFrameViewHash, request->getMipMapLevel(), request->getProxyScale(), request->getPlaneDesc(), isDraftRender()};
+
+    QMutexLocker k(&_imp->identicalRequestsMutex);
+    IdenticalRequestsMap::iterator found = _imp->identicalRequests.find(key);
+    if (found != _imp->identicalRequests.end()) {
+        FrameViewRequestPtr existingRequest = found->second.lock();
+        if (existingRequest) {
+            if (existingRequest == request) {
+                return FrameViewRequestPtr();
+            }
+            return existingRequest;
+        }
+    }
+    _imp->identicalRequests[key] = request;
+    return FrameViewRequestPtr();
+} // getOrRegisterIdenticalRequest
+
+FrameViewRequestPtr
+TreeRender::getInFlightRequest(U64 nodeFrameViewHash,
+                               const FrameViewRequestPtr& request) const
+{
+    IdenticalRequestKey key = {nodeFrameViewHash, request->getMipMapLevel(), request->getProxyScale(), request->getPlaneDesc(), isDraftRender()};
+
+    FrameViewRequestPtr existingRequest;
+    {
+        QMutexLocker k(&inFlightRequests.lock);
+        IdenticalRequestsMap::iterator found = inFlightRequests.requests.find(key);
+        if ( found == inFlightRequests.requests.end() ) {
+            return FrameViewRequestPtr();
+        }
+        existingRequest = found->second.lock();
+    }
+    if (!existingRequest) {
+        return FrameViewRequestPtr();
+    }
+
+    // Requests of this render are found with getOrRegisterIdenticalRequest()
+    TreeRenderPtr existingRender = existingRequest->getParentRender();
+    if ( !existingRender || (existingRender.get() == this) || existingRender->isRenderAborted() ) {
+        return FrameViewRequestPtr();
+    }
+
+    return existingRequest;
+} // getInFlightRequest
+
+void
+TreeRender::registerInFlightRequest(U64 nodeFrameViewHash,
+                                    const FrameViewRequestPtr& request)
+{
+    IdenticalRequestKey key = {nodeFrameViewHash, request->getMipMapLevel(), request->getProxyScale(), request->getPlaneDesc(), isDraftRender()};
+
+    QMutexLocker k(&inFlightRequests.lock);
+    IdenticalRequestsMap::iterator found = inFlightRequests.requests.find(key);
+    if ( found != inFlightRequests.requests.end() ) {
+        FrameViewRequestPtr existingRequest = found->second.lock();
+        if ( existingRequest && existingRequest->getParentRender() ) {
+            // Another render is already rendering this image
+            return;
+        }
+    }
+    inFlightRequests.requests[key] = request;
+    _imp->inFlightRequestKeys.push_back(key);
+} // registerInFlightRequest
+
+bool
+TreeRender::isInFlightRequest(const FrameViewRequestPtr& request)
+{
+    QMutexLocker k(&inFlightRequests.lock);
+    for (IdenticalRequestsMap::const_iterator it = inFlightRequests.requests.begin(); it != inFlightRequests.requests.end(); ++it) {
+        if (it->second.lock() == request) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+TreeRenderPrivate::unregisterInFlightRequests()
+{
+    QMutexLocker k(&inFlightRequests.lock);
+    for (std::list<IdenticalRequestKey>::const_iterator it = inFlightRequestKeys.begin(); it != inFlightRequestKeys.end(); ++it) {
+        IdenticalRequestsMap::iterator found = inFlightRequests.requests.find(*it);
+        if (found == inFlightRequests.requests.end()) {
+            continue;
+        }
+        // The entry may only have been replaced by the request of another render once ours was destroyed
+        FrameViewRequestPtr request = found->second.lock();
+        TreeRenderPtr requestRender = request ? request->getParentRender() : TreeRenderPtr();
+        if ( !requestRender || (requestRender.get() == _publicInterface) ) {
+            inFlightRequests.requests.erase(found);
+        }
+    }
+    inFlightRequestKeys.clear();
+}
+
 OSGLContextPtr
 TreeRender::getGPUOpenGLContext() const
 {
@@ -241,7 +531,63 @@ TreeRender::isRenderAborted() const
 void
 TreeRender::setRenderAborted()
 {
-    _imp->aborted.fetchAndAddAcquire(1);
+    if (_imp->aborted.fetchAndAddAcquire(1) == 0) {
+        QMutexLocker k(&_imp->abortTimerMutex);
+        _imp->abortTimer.reset(new TimeLapse);
+    }
+}
+
+void
+TreeRenderPrivate::recordAbortLatency()
+{
+    double latency;
+    {
+        QMutexLocker k(&abortTimerMutex);
+        if (!abortTimer) {
+            return;
+        }
+        latency = abortTimer->getTimeSinceCreation();
+        abortTimer.reset();
+    }
+    QMutexLocker k(&abortLatencyStats.lock);
+    ++abortLatencyStats.nAbortedRenders;
+    abortLatencyStats.totalLatency += latency;
+    abortLatencyStats.maxLatency = std::max(abortLatencyStats.maxLatency, latency);
+} // recordAbortLatency
+
+void
+TreeRender::getAbortLatencyStats(int* nAbortedRenders, double* averageLatency, double* maxLatency)
+{
+    QMutexLocker k(&abortLatencyStats.lock);
+    *nAbortedRenders = abortLatencyStats.nAbortedRenders;
+    *averageLatency = abortLatencyStats.nAbortedRenders > 0 ? abortLatencyStats.totalLatency / abortLatencyStats.nAbortedRenders : 0.;
+    *maxLatency = abortLatencyStats.maxLatency;
+}
+
+MemoryAccountPtr
+TreeRender::getMemoryAccount() const
+{
+    return _imp->memoryAccount;
+}
+
+RenderArenaPtr
+TreeRender::getArena() const
+{
+    return _imp->arena;
+}
+
+std::list<TreeRenderPtr>
+TreeRender::getActiveRenders()
+{
+    std::list<TreeRenderPtr> ret;
+    QMutexLocker k(&activeTreeRenders.lock);
+    for (std::map<const TreeRender*, TreeRenderWPtr>::const_iterator it = activeTreeRenders.renders.begin(); it != activeTreeRenders.renders.end(); ++it) {
+        TreeRenderPtr render = it->second.lock();
+        if (render) {
+            ret.push_back(render);
+        }
+    }
+    return ret;
 }
 
 bool
@@ -257,6 +603,12 @@ TreeRender::isDraftRender() const
     return _imp->ctorArgs->draftMode;
 }
 
+RenderPriorityEnum
+TreeRender::getPriority() const
+{
+    return _imp->ctorArgs->priority;
+}
+
 bool
 TreeRender::isByPassCacheEnabled() const
 {
@@ -389,6 +741,10 @@ TreeRenderPrivate::init(const TreeRender::CtorArgsPtr& inArgs)
     for (std::list<NodePtr>::const_iterator it = inArgs->extraNodesToSample.begin(); it != inArgs->extraNodesToSample.end(); ++it) {
         extraRequestedResults.insert(std::make_pair(*it, FrameViewRequestPtr()));
     }
+    for (std::list<EffectInstancePtr>::const_iterator it = inArgs->extraTreeRoots.begin(); it != inArgs->extraTreeRoots.end(); ++it) {
+        assert(!(*it)->isRenderClone());
+        extraRequestedResults.insert(std::make_pair((*it)->getNode(), FrameViewRequestPtr()));
+    }
 
     // Fetch the OpenGL context used for the render. It will not be attached to any render thread yet.
     fetchOpenGLContext(inArgs);
@@ -402,6 +758,11 @@ TreeRender::create(const CtorArgsPtr& inArgs)
     TreeRenderPtr render(new TreeRender());
 
     assert(!inArgs->treeRootEffect->isRenderClone());
+
+    {
+        QMutexLocker k(&activeTreeRenders.lock);
+        activeTreeRenders.renders[render.get()] = render;
+    }
     
     try {
         // Setup the render tree and make local copy of knob values for the render.
@@ -418,38 +779,114 @@ TreeRender::create(const CtorArgsPtr& inArgs)
 }
 
 
+class FrameViewRenderRunnable;
+typedef boost::shared_ptr<FrameViewRenderRunnable> FrameViewRenderRunnablePtr;
+
+typedef std::set<FrameViewRequestPtr, std::less<FrameViewRequestPtr>, RenderArenaAllocator<FrameViewRequestPtr> > FrameViewRequestSet;
+typedef std::map<FrameViewRequestPtr, FrameViewRenderRunnablePtr, std::less<FrameViewRequestPtr>, RenderArenaAllocator<std::pair<const FrameViewRequestPtr, FrameViewRenderRunnablePtr> > > TaskRunnablesMap;
+typedef std::map<FrameViewRequestPtr, double, std::less<FrameViewRequestPtr>, RenderArenaAllocator<std::pair<const FrameViewRequestPtr, double> > > CriticalPathCostsMap;
+
 struct RequestPassSharedDataPrivate
 {
-    // Protects dependencyFreeRenders and allRenderTasks
+    RenderArenaPtr arena;
+
+    // Protects dependencyFreeRenders and allRenderTasksToProcess during the request pass.
+    // Once the tasks are launched, it is only taken to notify the launching thread that all tasks are done.
     mutable QMutex dependencyFreeRendersMutex;
 
-    QWaitCondition dependencyFreeRendersEmptyCond;
+    QWaitCondition allTasksRenderedCond;
 
-    // A set of renders that we can launch right now
+    // The renders without dependencies at the end of the request pass: they are launched first
     boost::scoped_ptr<DependencyFreeRenderSet> dependencyFreeRenders;
 
-    // All renders left to do
-    std::set<FrameViewRequestPtr> allRenderTasksToProcess;
+    // All renders to do
+    FrameViewRequestSet allRenderTasksToProcess;
+
+    // For each task, the runnable used to launch it in the thread pool.
+    // This is built before launching any task and is then read-only until all tasks are rendered,
+    // so that finished tasks can launch their listeners without taking any lock.
+    TaskRunnablesMap taskRunnables;
+
+    // For each task, the estimated time to render it and the longest chain of tasks depending on it.
+    // This is computed once the request pass is finished and is read-only afterwards.
+    CriticalPathCostsMap criticalPathCosts;
 
-    // The status global to the tasks, protected by dependencyFreeRendersMutex
-    ActionRetCodeEnum stat;
+    // The number of tasks not rendered yet
+    QAtomicInt numTasksRemaining;
+
+    // The status global to the tasks, a value of ActionRetCodeEnum
+    QAtomicInt stat;
 
     TreeRenderWPtr treeRender;
 
-    RequestPassSharedDataPrivate()
-    : dependencyFreeRendersMutex()
-    , dependencyFreeRendersEmptyCond()
+    RequestPassSharedDataPrivate(const RenderArenaPtr& arena)
+    : arena(arena)
+    , dependencyFreeRendersMutex()
+    , allTasksRenderedCond()
     , dependencyFreeRenders()
-    , allRenderTasksToProcess()
+    , allRenderTasksToProcess( std::less<FrameViewRequestPtr>(), RenderArenaAllocator<FrameViewRequestPtr>(arena) )
+    , taskRunnables( std::less<FrameViewRequestPtr>(), TaskRunnablesMap::allocator_type(arena) )
+    , criticalPathCosts( std::less<FrameViewRequestPtr>(), CriticalPathCostsMap::allocator_type(arena) )
+    , numTasksRemaining(0)
     , stat(eActionStatusOK)
     , treeRender()
     {
         
     }
+
+    double computeCriticalPathCost(const RequestPassSharedDataPtr& sharedData, const FrameViewRequestPtr& render);
 };
 
-RequestPassSharedData::RequestPassSharedData()
-: _imp(new RequestPassSharedDataPrivate())
+// Each task costs at least this: without any render time history, the longest chain is the one with the most tasks
+#define NATRON_TREE_RENDER_MIN_TASK_COST 1e-6
+
+double
+RequestPassSharedDataPrivate::computeCriticalPathCost(const RequestPassSharedDataPtr& sharedData, const FrameViewRequestPtr& render)
+{
+    CriticalPathCostsMap::const_iterator found = criticalPathCosts.find(render);
+    if (found != criticalPathCosts.end()) {
+        return found->second;
+    }
+
+    // Estimate the time to render the task from the time per pixel of the node and the number of pixels to render
+    double cost = NATRON_TREE_RENDER_MIN_TASK_COST;
+    {
+        NodePtr node = render->getEffect()->getNode();
+        double timePerPixel = node ? node->getRenderTimePerPixelEstimate() : 0;
+        if (timePerPixel > 0) {
+            RectD roi = render->getCurrentRoI();
+            const RenderScale& proxyScale = render->getProxyScale();
+            double mipMapScale = Image::getScaleFromMipMapLevel(render->getMipMapLevel());
+            double nPixels = roi.width() * proxyScale.x * mipMapScale * roi.height() * proxyScale.y * mipMapScale;
+            cost += timePerPixel * std::max(0., nPixels);
+        }
+    }
+
+    // The tasks depending on this one can only start once it is rendered
+    double maxListenersCost = 0;
+    std::list<FrameViewRequestPtr> listeners = render->getListeners(sharedData);
+    for (std::list<FrameViewRequestPtr>::const_iterator it = listeners.begin(); it != listeners.end(); ++it) {
+        if (*it) {
+            maxListenersCost = std::max(maxListenersCost, computeCriticalPathCost(sharedData, *it));
+        }
+    }
+    cost += maxListenersCost;
+    criticalPathCosts[render] = cost;
+    return cost;
+} // computeCriticalPathCost
+
+double
+RequestPassSharedData::getCriticalPathCost(const FrameViewRequestPtr& render) const
+{
+    CriticalPathCostsMap::const_iterator found = _imp->criticalPathCosts.find(render);
+    if (found == _imp->criticalPathCosts.end()) {
+        return 0;
+    }
+    return found->second;
+}
+
+RequestPassSharedData::RequestPassSharedData(const RenderArenaPtr& arena)
+: _imp(new RequestPassSharedDataPrivate(arena))
 {
 
 }
@@ -459,12 +896,25 @@ RequestPassSharedData::~RequestPassSharedData()
 
 }
 
+const RenderArenaPtr&
+RequestPassSharedData::getArena() const
+{
+    return _imp->arena;
+}
+
 TreeRenderPtr
 RequestPassSharedData::getTreeRender() const
 {
     return _imp->treeRender.lock();
 }
 
+bool
+RequestPassSharedData::isTaskToRender(const FrameViewRequestPtr& render) const
+{
+    // The set is read-only once the request pass is finished
+    return _imp->allRenderTasksToProcess.find(render) != _imp->allRenderTasksToProcess.end();
+}
+
 void
 RequestPassSharedData::addTaskToRender(const FrameViewRequestPtr& render)
 {
@@ -505,13 +955,64 @@ public:
     }
 };
 
+/**
+ * @brief The comparator of the dependency-free set holds a strong reference to the shared data: release the set
+ * when the request pass is done so that the shared data, and with it the arena of the render, can be freed.
+ **/
+class ReleaseRequestPassSharedData_RAII
+{
+    RequestPassSharedDataPtr requestData;
+public:
+
+    ReleaseRequestPassSharedData_RAII(const RequestPassSharedDataPtr& requestData)
+    : requestData(requestData)
+    {
+
+    }
+
+    ~ReleaseRequestPassSharedData_RAII()
+    {
+        requestData->_imp->taskRunnables.clear();
+        requestData->_imp->dependencyFreeRenders.reset();
+    }
+};
+
+/**
+ * @brief Returns the thread pool running the given task: the tasks of I/O-bound effects run in the I/O thread pool
+ * so that waiting for a file does not hold a thread of the global thread pool.
+ **/
+static QThreadPool*
+getThreadPoolForTask(const FrameViewRequestPtr& request)
+{
+    if ( request->getEffect()->isIOBound() ) {
+        QThreadPool* ioThreadPool = appPTR->getIOThreadPool();
+        if (ioThreadPool) {
+            return ioThreadPool;
+        }
+    }
+
+    return QThreadPool::globalInstance();
+}
+
 
+/**
+ * @brief Renders a task and then the tasks that it made dependency-free.
+ * When a task finishes, the listeners for which it was the last dependency are launched directly from the thread
+ * that rendered it: the first one running in the same thread pool is rendered by the same thread, which has the inputs of the listener hot in its
+ * caches, and the others are started in the thread pool. The dependencies are counted on each FrameViewRequest
+ * so that finishing tasks never contend on a lock shared by the whole tree.
+ **/
 class FrameViewRenderRunnable : public QRunnable
 {
 
     RequestPassSharedDataWPtr _sharedData;
     FrameViewRequestWPtr _request;
     TreeRenderPrivate* _imp;
+    QThreadPool* _threadPool;
+    RenderPriorityEnum _priority;
+
+    // True if the task counts in the threads limit of its priority class, see RenderTaskDispatcher
+    bool _limited;
 public:
 
     FrameViewRenderRunnable(TreeRenderPrivate* imp, const RequestPassSharedDataPtr& sharedData, const FrameViewRequestPtr& request)
@@ -519,69 +1020,93 @@ public:
     , _sharedData(sharedData)
     , _request(request)
     , _imp(imp)
+    , _threadPool( getThreadPoolForTask(request) )
+    , _priority(imp->ctorArgs->priority)
+    , _limited(false)
     {
         assert(request);
+        _limited = RenderTaskDispatcher::isTaskLimited(_threadPool, _priority);
     }
 
     virtual ~FrameViewRenderRunnable()
     {
     }
 
+    /**
+     * @brief Starts the task in its thread pool with the priority of the render
+     **/
+    void launch()
+    {
+        RenderTaskDispatcher::startTask(_threadPool, this, _priority, _limited);
+    }
+
 private:
 
     virtual void run() OVERRIDE FINAL
     {
+        // The runnable may be destroyed as soon as the last task is rendered, see renderTask()
+        const bool limited = _limited;
+        if (limited) {
+            RenderTaskDispatcher::onLimitedTaskStarted();
+        }
 
         RequestPassSharedDataPtr sharedData = _sharedData.lock();
+        FrameViewRequestPtr request = _request.lock();
+        while (request) {
+            request = renderTask(sharedData, request);
+        }
 
-        ActionRetCodeEnum stat;
-        {
-            QMutexLocker k(&sharedData->_imp->dependencyFreeRendersMutex);
-            stat = sharedData->_imp->stat;
+        if (limited) {
+            RenderTaskDispatcher::onLimitedTaskFinished();
         }
+    }
+
+    /**
+     * @brief Renders the given task, launches its listeners that became dependency-free and returns
+     * the one that should be rendered next by this thread, if any.
+     **/
+    FrameViewRequestPtr renderTask(const RequestPassSharedDataPtr& sharedData, const FrameViewRequestPtr& request)
+    {
+        ActionRetCodeEnum stat = (ActionRetCodeEnum)(int)sharedData->_imp->stat;
 
-        FrameViewRequestPtr request = _request.lock();
         EffectInstancePtr renderClone = request->getEffect();
+        bool isIOBound = renderClone->isIOBound();
 
         if (!isFailureRetCode(stat)) {
 #ifdef TRACE_RENDER_DEPENDENCIES
             qDebug() << sharedData.get() << "Launching render of" << renderClone->getScriptName_mt_safe().c_str();
 #endif
+            boost::scoped_ptr<IOMountLocker_RAII> mountLocker;
+            if (isIOBound) {
+                KnobFilePtr fileKnob = toKnobFile( renderClone->getKnobByName(kOfxImageEffectFileParamName) );
+                mountLocker.reset( new IOMountLocker_RAII( fileKnob ? fileKnob->getRawFileName() : std::string() ) );
+            }
+            RenderTrace::Scope_RAII trace("Render task", kRenderTraceCategoryRender, renderClone.get());
             stat = renderClone->launchRender(sharedData, request);
         }
 
         // Remove all stashes input frame view requests that we kept around.
         request->clearRenderedDependencies(sharedData);
 
-        QMutexLocker k(&sharedData->_imp->dependencyFreeRendersMutex);
-
         if (isFailureRetCode(stat)) {
-            sharedData->_imp->stat = stat;
-        }
-
-        // Remove this render from all tasks left
-        {
-            std::set<FrameViewRequestPtr>::const_iterator foundTask = sharedData->_imp->allRenderTasksToProcess.find(request);
-            assert(foundTask != sharedData->_imp->allRenderTasksToProcess.end());
-            if (foundTask != sharedData->_imp->allRenderTasksToProcess.end()) {
-                sharedData->_imp->allRenderTasksToProcess.erase(foundTask);
-            }
+            sharedData->_imp->stat.fetchAndStoreOrdered((int)stat);
         }
 
         // For each frame/view that depend on this frame, remove it from the dependencies list.
+        // Only the task rendering the last dependency of a listener sees 0 dependencies left, hence each
+        // listener is launched exactly once.
+        DependencyFreeRenderSet newDependencyFreeRenders( (FrameViewRequestComparePriority(sharedData)), DependencyFreeRenderSet::allocator_type( sharedData->getArena() ) );
         std::list<FrameViewRequestPtr> listeners = request->getListeners(sharedData);
         for (std::list<FrameViewRequestPtr>::const_iterator it = listeners.begin(); it != listeners.end(); ++it) {
             int numDepsLeft = (*it)->markDependencyAsRendered(sharedData, request);
 
             // If the task has all its dependencies available, add it to the render queue.
             if (numDepsLeft == 0) {
-                if (sharedData->_imp->dependencyFreeRenders->find(*it) == sharedData->_imp->dependencyFreeRenders->end()) {
 #ifdef TRACE_RENDER_DEPENDENCIES
-                    qDebug() << sharedData.get() << "Adding" << (*it)->getEffect()->getScriptName_mt_safe().c_str() << "(" << it->get() << ") to the dependency-free list";
+                qDebug() << sharedData.get() << "Adding" << (*it)->getEffect()->getScriptName_mt_safe().c_str() << "(" << it->get() << ") to the dependency-free list";
 #endif
-                    assert(sharedData->_imp->allRenderTasksToProcess.find(*it) != sharedData->_imp->allRenderTasksToProcess.end());
-                    sharedData->_imp->dependencyFreeRenders->insert(*it);
-                }
+                assert(sharedData->_imp->allRenderTasksToProcess.find(*it) != sharedData->_imp->allRenderTasksToProcess.end());
+                newDependencyFreeRenders.insert(*it);
             }
         }
 
@@ -595,9 +1120,29 @@ private:
             }
         }
 
-        // Notify the main render thread that some more stuff can be rendered (or that we are done)
-        sharedData->_imp->dependencyFreeRendersEmptyCond.wakeOne();
-    }
+        // Keep the first dependency-free render that runs in the same thread pool for this thread and start the others in their thread pool
+        FrameViewRequestPtr nextRequest;
+        for (DependencyFreeRenderSet::const_iterator it = newDependencyFreeRenders.begin(); it != newDependencyFreeRenders.end(); ++it) {
+            if ( !nextRequest && ( (*it)->getEffect()->isIOBound() == isIOBound ) ) {
+                nextRequest = *it;
+                continue;
+            }
+            TaskRunnablesMap::const_iterator foundRunnable = sharedData->_imp->taskRunnables.find(*it);
+            assert(foundRunnable != sharedData->_imp->taskRunnables.end());
+            if (foundRunnable != sharedData->_imp->taskRunnables.end()) {
+                foundRunnable->second->launch();
+            }
+        }
+
+        // Notify the main render thread if we are done. The runnables may be destroyed as soon as the count
+        // reaches 0, so this must be the last access to the shared data.
+        if (sharedData->_imp->numTasksRemaining.fetchAndAddOrdered(-1) == 1) {
+            assert(!nextRequest);
+            QMutexLocker k(&sharedData->_imp->dependencyFreeRendersMutex);
+            sharedData->_imp->allTasksRenderedCond.wakeAll();
+        }
+        return nextRequest;
+    } // renderTask
 };
 
 
@@ -612,6 +1157,30 @@ TreeRenderPrivate::launchRenderInternal(bool removeRenderClonesWhenFinished,
                                         const RectD* canonicalRoIParam,
                                         FrameViewRequestPtr* outputRequest)
 {
+    std::list<FrameViewPair> frames;
+    FrameViewPair p = {time, view};
+    frames.push_back(p);
+
+    std::list<FrameViewRequestPtr> outputRequests;
+    ActionRetCodeEnum stat = launchRenderInternal(removeRenderClonesWhenFinished, treeRoot, frames, proxyScale, mipMapLevel, getPlanesParam(planeParam), canonicalRoIParam, std::list<EffectInstancePtr>(), &outputRequests);
+    if (outputRequest && !outputRequests.empty()) {
+        *outputRequest = outputRequests.front();
+    }
+    return stat;
+} // launchRenderInternal
+
+ActionRetCodeEnum
+TreeRenderPrivate::launchRenderInternal(bool removeRenderClonesWhenFinished,
+                                        const EffectInstancePtr& treeRoot,
+                                        const std::list<FrameViewPair>& frames,
+                                        const RenderScale& proxyScale,
+                                        unsigned int mipMapLevel,
+                                        const std::list<ImagePlaneDesc>& planesParam,
+                                        const RectD* canonicalRoIParam,
+                                        const std::list<EffectInstancePtr>& extraTreeRoots,
+                                        std::list<FrameViewRequestPtr>* outputRequests)
+{
+    assert(!frames.empty());
 
     // Get the combined scale
     RenderScale scale = ctorArgs->proxyScale;
@@ -621,46 +1190,16 @@ TreeRenderPrivate::launchRenderInternal(bool removeRenderClonesWhenFinished,
         scale.y *= mipMapScale;
     }
 
-    EffectInstancePtr rootRenderClone;
-    {
-        FrameViewRenderKey key = {time, view, _publicInterface->shared_from_this()};
-        rootRenderClone = toEffectInstance(treeRoot->createRenderClone(key));
-    }
-
     // If we are within a EffectInstance::getImagePlane() call, the treeRoot may already be a render clone spawned by this tree, in which case
     // we don't want to remove clones yet. Clean the clones when the render tree is done executing the last call to launchRenderInternal.
-    boost::scoped_ptr<CleanupRenderClones_RAII> clonesCleaner;
-    if (removeRenderClonesWhenFinished) {
-        clonesCleaner.reset(new CleanupRenderClones_RAII(rootRenderClone, _publicInterface->shared_from_this()));
-    }
+    std::list<boost::shared_ptr<CleanupRenderClones_RAII> > clonesCleaners;
 
-    assert(rootRenderClone->isRenderClone());
-
-    // Resolve plane to render if not provided
-    ImagePlaneDesc plane;
-    if (planeParam) {
-        plane = *planeParam;
-    } else {
-        ActionRetCodeEnum stat = TreeRenderPrivate::getTreeRootPlane(rootRenderClone, time, view, &plane);
-        if (isFailureRetCode(stat)) {
-            return stat;
-        }
-    }
-
-    // Resolve RoI to render if not provided
-    RectD canonicalRoI;
-    if (canonicalRoIParam) {
-        canonicalRoI = *canonicalRoIParam;
-    } else {
-        ActionRetCodeEnum stat = TreeRenderPrivate::getTreeRootRoD(rootRenderClone, time, view, scale, &canonicalRoI);
-        if (isFailureRetCode(stat)) {
-            return stat;
-        }
-    }
     ActionRetCodeEnum stat = eActionStatusOK;
     {
-        RequestPassSharedDataPtr requestData(new RequestPassSharedData());
-        requestData->_imp->dependencyFreeRenders.reset(new DependencyFreeRenderSet(FrameViewRequestComparePriority(requestData)));
+        // The shared data, its containers and the requests it references are allocated in the arena of the render
+        RequestPassSharedDataPtr requestData = boost::allocate_shared<RequestPassSharedData>(RenderArenaAllocator<RequestPassSharedData>(arena), arena);
+        requestData->_imp->dependencyFreeRenders.reset( new DependencyFreeRenderSet( FrameViewRequestComparePriority(requestData), DependencyFreeRenderSet::allocator_type(arena) ) );
+        ReleaseRequestPassSharedData_RAII requestDataReleaser(requestData);
 
         requestData->_imp->treeRender = _publicInterface->shared_from_this();
 
@@ -669,14 +1208,80 @@ TreeRenderPrivate::launchRenderInternal(bool removeRenderClonesWhenFinished,
         qDebug() << "Starting launchRenderInternal" << requestData.get();
 #endif
 
-        // Cycle through the tree to find and requested frames and RoIs
-        {
-            stat = treeRoot->requestRender(time, view, proxyScale, mipMapLevel, plane, canonicalRoI, -1, FrameViewRequestPtr(), requestData, outputRequest, 0);
+        RenderTrace::Scope_RAII requestPassTrace("Request pass", kRenderTraceCategoryRender, treeRoot.get());
+
+        // Cycle through the tree to find and requested frames and RoIs.
+        // All frames are requested in the same pass so that the upstream frames they have in common
+        // are requested only once and the renders of all frames are scheduled together.
+        // The extra tree roots are requested in the same pass for the same reason.
+        std::list<EffectInstancePtr> roots;
+        std::list<FrameViewRequestPtr> extraRootsRequests;
+        roots.push_back(treeRoot);
+        roots.insert(roots.end(), extraTreeRoots.begin(), extraTreeRoots.end());
+        for (std::list<FrameViewPair>::const_iterator it = frames.begin(); it != frames.end(); ++it) {
+            for (std::list<EffectInstancePtr>::const_iterator itRoot = roots.begin(); itRoot != roots.end(); ++itRoot) {
+
+                // The planes and RoI passed only apply to the tree root
+                bool isTreeRoot = itRoot == roots.begin();
+
+                EffectInstancePtr rootRenderClone;
+                {
+                    FrameViewRenderKey key = {it->time, it->view, _publicInterface->shared_from_this()};
+                    rootRenderClone = toEffectInstance((*itRoot)->createRenderClone(key));
+                }
+
+                // All clones of the render upstream of a root are removed at once, from any of its clones
+                if (removeRenderClonesWhenFinished && it == frames.begin()) {
+                    clonesCleaners.push_back(boost::make_shared<CleanupRenderClones_RAII>(rootRenderClone, _publicInterface->shared_from_this()));
+                }
+
+                assert(rootRenderClone->isRenderClone());
+
+                // Resolve planes to render if not provided
+                std::list<ImagePlaneDesc> planes;
+                if ( isTreeRoot && !planesParam.empty() ) {
+                    planes = planesParam;
+                } else {
+                    ImagePlaneDesc plane;
+                    stat = TreeRenderPrivate::getTreeRootPlane(rootRenderClone, it->time, it->view, &plane);
+                    if (isFailureRetCode(stat)) {
+                        return stat;
+                    }
+                    planes.push_back(plane);
+                }
 
-            if (isFailureRetCode(stat)) {
-                return stat;
+                // Resolve RoI to render if not provided
+                RectD canonicalRoI;
+                if (canonicalRoIParam && isTreeRoot) {
+                    canonicalRoI = *canonicalRoIParam;
+                } else {
+                    stat = TreeRenderPrivate::getTreeRootRoD(rootRenderClone, it->time, it->view, scale, &canonicalRoI);
+                    if (isFailureRetCode(stat)) {
+                        return stat;
+                    }
+                }
+
+                // The planes of a frame are requested together so that the effect may render them in a single action
+                for (std::list<ImagePlaneDesc>::const_iterator itPlane = planes.begin(); itPlane != planes.end(); ++itPlane) {
+                    FrameViewRequestPtr outputRequest;
+                    stat = (*itRoot)->requestRender(it->time, it->view, proxyScale, mipMapLevel, *itPlane, canonicalRoI, -1, FrameViewRequestPtr(), requestData, &outputRequest, 0);
+                    if (isFailureRetCode(stat)) {
+                        return stat;
+                    }
+                    if (isTreeRoot) {
+                        outputRequests->push_back(outputRequest);
+                    } else {
+                        // The result kept for an extra root is the one of the first frame/view
+                        extraRootsRequests.push_back(outputRequest);
+                        if (it == frames.begin()) {
+                            QMutexLocker k(&extraRequestedResultsMutex);
+                            extraRequestedResults[(*itRoot)->getNode()] = outputRequest;
+                        }
+                    }
+                }
             }
         }
+        requestPassTrace.finish();
 
         // At this point, the request pass should have created the first batch of dependency-free renders.
         // The list cannot be empty, otherwise it should have failed before.
@@ -685,58 +1290,63 @@ TreeRenderPrivate::launchRenderInternal(bool removeRenderClonesWhenFinished,
             return eActionStatusFailed;
         }
 
-        int numTasksRemaining;
-        {
-            QMutexLocker k(&requestData->_imp->dependencyFreeRendersMutex);
-            numTasksRemaining = requestData->_imp->allRenderTasksToProcess.size();
-        }
-        QThreadPool* threadPool = QThreadPool::globalInstance();
-
         bool isThreadPoolThread = isRunningInThreadPoolThread();
 
+        QMutexLocker k(&requestData->_imp->dependencyFreeRendersMutex);
+
         // See bug https://bugreports.qt.io/browse/QTBUG-20251
         // The Qt thread-pool mem-leaks the runnable if using release/reserveThread
         // Instead we explicitly manage them and ensure they do not hold any external strong refs.
-        std::vector<boost::shared_ptr<FrameViewRenderRunnable> > runnables;
-
-        // While we still have tasks to render loop
-        while (numTasksRemaining > 0) {
+        // Create the runnables of all tasks before launching any of them, so that the map is read-only while rendering.
+        for (FrameViewRequestSet::const_iterator it = requestData->_imp->allRenderTasksToProcess.begin(); it != requestData->_imp->allRenderTasksToProcess.end(); ++it) {
+            FrameViewRenderRunnablePtr runnable = boost::allocate_shared<FrameViewRenderRunnable>(RenderArenaAllocator<FrameViewRenderRunnable>(arena), this, requestData, *it);
+            runnable->setAutoDelete(false);
+            requestData->_imp->taskRunnables[*it] = runnable;
+        }
+        requestData->_imp->numTasksRemaining.fetchAndStoreOrdered((int)requestData->_imp->allRenderTasksToProcess.size());
 
+        // Now that the graph of tasks is known, estimate the critical path of each task
+        for (FrameViewRequestSet::const_iterator it = requestData->_imp->allRenderTasksToProcess.begin(); it != requestData->_imp->allRenderTasksToProcess.end(); ++it) {
+            requestData->_imp->computeCriticalPathCost(requestData, *it);
+        }
 
-            // Launch all dependency-free tasks in parallel
-            QMutexLocker k(&requestData->_imp->dependencyFreeRendersMutex);
-            while (requestData->_imp->dependencyFreeRenders->size() > 0) {
+        // The dependency-free set was sorted while the costs were unknown: sort the tasks again.
+        std::vector<FrameViewRequestPtr> dependencyFreeRenders(requestData->_imp->dependencyFreeRenders->begin(), requestData->_imp->dependencyFreeRenders->end());
+        requestData->_imp->dependencyFreeRenders->clear();
+        std::sort(dependencyFreeRenders.begin(), dependencyFreeRenders.end(), FrameViewRequestComparePriority(requestData));
 
-                FrameViewRequestPtr request = *requestData->_imp->dependencyFreeRenders->begin();
-                requestData->_imp->dependencyFreeRenders->erase(requestData->_imp->dependencyFreeRenders->begin());
+        // Launch all dependency-free tasks in parallel, the longest chains first: each finished task then launches its own listeners.
+        for (std::vector<FrameViewRequestPtr>::const_iterator it = dependencyFreeRenders.begin(); it != dependencyFreeRenders.end(); ++it) {
 #ifdef TRACE_RENDER_DEPENDENCIES
-                qDebug() << "Queuing " << request->getEffect()->getScriptName_mt_safe().c_str() << " in task pool";
+            qDebug() << "Queuing " << (*it)->getEffect()->getScriptName_mt_safe().c_str() << " in task pool";
 #endif
-                boost::shared_ptr<FrameViewRenderRunnable> runnable(new FrameViewRenderRunnable(this, requestData, request));
-                runnable->setAutoDelete(false);
-                runnables.push_back(runnable);
-                threadPool->start(runnable.get());
-            }
+            requestData->_imp->taskRunnables[*it]->launch();
+        }
 
-            // If this thread is a threadpool thread, it may wait for a while that results gets available.
-            // Release the thread to the thread pool so that it may use this thread for other runnables
-            // and reserve it back when done waiting.
-            if (isThreadPoolThread) {
-                QThreadPool::globalInstance()->releaseThread();
-            }
+        // If this thread is a threadpool thread, it may wait for a while that results gets available.
+        // Release the thread to the thread pool so that it may use this thread for other runnables
+        // and reserve it back when done waiting.
+        if (isThreadPoolThread) {
+            QThreadPool::globalInstance()->releaseThread();
+            RenderTaskDispatcher::onThreadWaitStarted();
+        }
 
-            // Wait until a task is finished: we should be able to launch more tasks afterwards.
-            requestData->_imp->dependencyFreeRendersEmptyCond.wait(&requestData->_imp->dependencyFreeRendersMutex);
-            
-            if (isThreadPoolThread) {
-                QThreadPool::globalInstance()->reserveThread();
+        // Wait until all tasks are rendered
+        {
+            RenderTrace::Scope_RAII trace("Wait for render tasks", kRenderTraceCategoryRender, treeRoot.get());
+            while ((int)requestData->_imp->numTasksRemaining > 0) {
+                requestData->_imp->allTasksRenderedCond.wait(&requestData->_imp->dependencyFreeRendersMutex);
             }
-            
-            numTasksRemaining = requestData->_imp->allRenderTasksToProcess.size();
         }
-        runnables.clear();
 
-        stat = requestData->_imp->stat;
+        if (isThreadPoolThread) {
+            RenderTaskDispatcher::onThreadWaitFinished();
+            QThreadPool::globalInstance()->reserveThread();
+        }
+
+        requestData->_imp->taskRunnables.clear();
+
+        stat = (ActionRetCodeEnum)(int)requestData->_imp->stat;
     } // requestData
 
 
@@ -771,8 +1381,81 @@ TreeRender::launchRenderWithArgs(const EffectInstancePtr& root,
     return stat;
 }
 
+ActionRetCodeEnum
+TreeRender::launchRenderWithArgs(const EffectInstancePtr& root,
+                                 const std::list<FrameViewPair>& frames,
+                                 const RenderScale& proxyScale,
+                                 unsigned int mipMapLevel,
+                                 const ImagePlaneDesc* plane,
+                                 const RectD* canonicalRoI,
+                                 std::list<FrameViewRequestPtr>* outputRequests)
+{
+    if (frames.empty()) {
+        return eActionStatusFailed;
+    }
+    ActionRetCodeEnum stat =  _imp->launchRenderInternal(false /*removeRenderClonesWhenFinished*/, root, frames, proxyScale, mipMapLevel, TreeRenderPrivate::getPlanesParam(plane), canonicalRoI, std::list<EffectInstancePtr>(), outputRequests);
+    return stat;
+}
+
+ActionRetCodeEnum
+TreeRender::launchRenderWithArgs(const EffectInstancePtr& root,
+                                 TimeValue time,
+                                 ViewIdx view,
+                                 const RenderScale& proxyScale,
+                                 unsigned int mipMapLevel,
+                                 const std::list<ImagePlaneDesc>& planes,
+                                 const RectD* canonicalRoI,
+                                 std::list<FrameViewRequestPtr>* outputRequests)
+{
+    if (planes.empty()) {
+        return eActionStatusFailed;
+    }
+    std::list<FrameViewPair> frames;
+    FrameViewPair p = {time, view};
+    frames.push_back(p);
+    ActionRetCodeEnum stat =  _imp->launchRenderInternal(false /*removeRenderClonesWhenFinished*/, root, frames, proxyScale, mipMapLevel, planes, canonicalRoI, std::list<EffectInstancePtr>(), outputRequests);
+    return stat;
+}
+
+/**
+ * @brief The effects fetching images apply the matrix of the colour effects concatenated upstream (see EffectInstance::getImagePlane).
+ * The results handed out by the render must have it applied.
+ **/
+static ActionRetCodeEnum
+applyConcatenatedColorMatrix(const FrameViewRequestPtr& request)
+{
+    if (!request) {
+        return eActionStatusOK;
+    }
+    ColorMatrixPtr matrix = request->getColorMatrix();
+    ImagePtr image = request->getRequestedScaleImagePlane();
+    if (!matrix || !image) {
+        return eActionStatusOK;
+    }
+    ImagePtr colorImage = ColorMatrix::applyToImageCopy(*matrix, image);
+    if (!colorImage) {
+        return eActionStatusFailed;
+    }
+    request->setRequestedScaleImagePlane(colorImage);
+    request->setColorMatrix(ColorMatrixPtr());
+
+    return eActionStatusOK;
+} // applyConcatenatedColorMatrix
+
 ActionRetCodeEnum
 TreeRender::launchRender(FrameViewRequestPtr* outputRequest)
+{
+    std::list<FrameViewRequestPtr> outputRequests;
+    ActionRetCodeEnum stat = launchRender(&outputRequests);
+    if ( !outputRequests.empty() ) {
+        *outputRequest = outputRequests.front();
+    }
+
+    return stat;
+}
+
+ActionRetCodeEnum
+TreeRender::launchRender(std::list<FrameViewRequestPtr>* outputRequests)
 {
     
 #ifdef TRACE_RENDER_DEPENDENCIES
@@ -782,7 +1465,36 @@ TreeRender::launchRender(FrameViewRequestPtr* outputRequest)
     if (isFailureRetCode(_imp->state)) {
         return _imp->state;
     }
-    _imp->state = _imp->launchRenderInternal(true /*removeRenderClonesWhenFinished*/, _imp->ctorArgs->treeRootEffect, _imp->ctorArgs->time, _imp->ctorArgs->view, _imp->ctorArgs->proxyScale, _imp->ctorArgs->mipMapLevel, _imp->ctorArgs->plane, _imp->ctorArgs->canonicalRoI, outputRequest);
+    {
+        // All views are requested in the same pass so that they are rendered concurrently
+        std::list<FrameViewPair> frames;
+        FrameViewPair p = {_imp->ctorArgs->time, _imp->ctorArgs->view};
+        frames.push_back(p);
+        for (std::list<ViewIdx>::const_iterator it = _imp->ctorArgs->extraViews.begin(); it != _imp->ctorArgs->extraViews.end(); ++it) {
+            if (*it != _imp->ctorArgs->view) {
+                p.view = *it;
+                frames.push_back(p);
+            }
+        }
+        _imp->state = _imp->launchRenderInternal(true /*removeRenderClonesWhenFinished*/, _imp->ctorArgs->treeRootEffect, frames, _imp->ctorArgs->proxyScale, _imp->ctorArgs->mipMapLevel, TreeRenderPrivate::getPlanesParam(_imp->ctorArgs->plane), _imp->ctorArgs->canonicalRoI, _imp->ctorArgs->extraTreeRoots, outputRequests);
+    }
+
+    // The requests that are not rendered yet will not be: the renders that subscribed to them must render them
+    _imp->unregisterInFlightRequests();
+
+    for (std::list<FrameViewRequestPtr>::const_iterator it = outputRequests->begin(); it != outputRequests->end() && !isFailureRetCode(_imp->state); ++it) {
+        _imp->state = applyConcatenatedColorMatrix(*it);
+    }
+    if ( !isFailureRetCode(_imp->state) ) {
+        QMutexLocker k(&_imp->extraRequestedResultsMutex);
+        for (std::map<NodePtr, FrameViewRequestPtr>::const_iterator it = _imp->extraRequestedResults.begin(); it != _imp->extraRequestedResults.end(); ++it) {
+            _imp->state = applyConcatenatedColorMatrix(it->second);
+            if ( isFailureRetCode(_imp->state) ) {
+                break;
+            }
+        }
+    }
+    _imp->recordAbortLatency();
 
     return _imp->state;
 } // launchRender
@@ -27,6 +27,7 @@
 
 #include "Global/Macros.h"
 
+#include <list>
 #include <map>
 
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
@@ -52,18 +53,41 @@ struct RequestPassSharedDataPrivate;
 class RequestPassSharedData : public boost::enable_shared_from_this<RequestPassSharedData>
 {
 public:
-    RequestPassSharedData();
+
+    /**
+     * @brief The data and its containers are allocated in the arena of the render, see TreeRender::getArena()
+     **/
+    explicit RequestPassSharedData(const RenderArenaPtr& arena);
 
     ~RequestPassSharedData();
 
     void addTaskToRender(const FrameViewRequestPtr& render);
 
+    /**
+     * @brief Returns true if the given request is rendered by this request pass.
+     * This may only be called once the request pass is finished.
+     **/
+    bool isTaskToRender(const FrameViewRequestPtr& render) const;
+
     TreeRenderPtr getTreeRender() const;
 
+    /**
+     * @brief Returns the arena in which the objects of this request pass are allocated
+     **/
+    const RenderArenaPtr& getArena() const;
+
 private:
 
+    /**
+     * @brief Returns the estimated time to render the given task and the longest chain of tasks depending on it.
+     * This is 0 until the request pass is finished.
+     **/
+    double getCriticalPathCost(const FrameViewRequestPtr& render) const;
+
     friend class FrameViewRenderRunnable;
+    friend struct FrameViewRequestComparePriority;
     friend struct TreeRenderPrivate;
+    friend class ReleaseRequestPassSharedData_RAII;
     boost::scoped_ptr<RequestPassSharedDataPrivate> _imp;
 };
 
@@ -93,6 +117,16 @@ public:
         // effect that was created in TreeRender::create, otherwise this can be the main instance.
         EffectInstancePtr treeRootEffect;
 
+        // Other nodes rendered at the same time and view as treeRootEffect by launchRender(), in the same request pass,
+        // so that the images they have in common upstream are rendered once. This is used to render several
+        // Write nodes fed by the same tree together. Their results are retrieved with getExtraRequestedResultsForNode().
+        std::list<EffectInstancePtr> extraTreeRoots;
+
+        // Other views of the tree roots rendered at the same time by launchRender(), in the same request pass as view,
+        // so that the views of a multi-view project render concurrently and the branches of the tree which do not
+        // depend on the view are shared through the cache. The result of each view is returned by launchRender(std::list<FrameViewRequestPtr>*).
+        std::list<ViewIdx> extraViews;
+
         // List of nodes that belong to the tree upstream of treeRootEffect for which we desire
         // a pointer of the resulting image. This is useful for the Viewer to enable color-picking:
         // the output image is the image out of the ViewerProcess node, but what the user really
@@ -133,6 +167,9 @@ public:
         // Make sure each node in the tree gets rendered at least once
         bool byPassCache;
 
+        // The priority class of the render tasks in the thread pool
+        RenderPriorityEnum priority;
+
         CtorArgs();
     };
 
@@ -165,6 +202,12 @@ public:
      **/
     ActionRetCodeEnum launchRender(FrameViewRequestPtr* outputRequest);
 
+    /**
+     * @brief Same as launchRender() but returns the output request of each view rendered:
+     * the view passed to the CtorArgs first, then each of the extraViews in order.
+     **/
+    ActionRetCodeEnum launchRender(std::list<FrameViewRequestPtr>* outputRequests);
+
     /**
      * @brief Same as launchRender() except that it launches the render on a different node than the root
      * of the tree with different parameters. 
@@ -177,6 +220,35 @@ public:
                                            const ImagePlaneDesc* plane,
                                            const RectD* canonicalRoI,
                                            FrameViewRequestPtr* outputRequest);
+
+    /**
+     * @brief Same as launchRenderWithArgs() except that the root is rendered at each of the given frames/views
+     * within a single request pass: the upstream frames needed by several of them are requested once
+     * and the renders of all frames are scheduled in parallel.
+     * @param outputRequests[out] The output request of each frame/view, in the same order as frames.
+     **/
+    ActionRetCodeEnum launchRenderWithArgs(const EffectInstancePtr& root,
+                                           const std::list<FrameViewPair>& frames,
+                                           const RenderScale& proxyScale,
+                                           unsigned int mipMapLevel,
+                                           const ImagePlaneDesc* plane,
+                                           const RectD* canonicalRoI,
+                                           std::list<FrameViewRequestPtr>* outputRequests);
+
+    /**
+     * @brief Same as launchRenderWithArgs() except that each of the given planes of the root is rendered
+     * within a single request pass: the RoI is shared and a multi-planar effect may render all of them in a single
+     * render action, see EffectInstance::getImagePlanes().
+     * @param outputRequests[out] The output request of each plane, in the same order as planes.
+     **/
+    ActionRetCodeEnum launchRenderWithArgs(const EffectInstancePtr& root,
+                                           TimeValue time,
+                                           ViewIdx view,
+                                           const RenderScale& proxyScale,
+                                           unsigned int mipMapLevel,
+                                           const std::list<ImagePlaneDesc>& planes,
+                                           const RectD* canonicalRoI,
+                                           std::list<FrameViewRequestPtr>* outputRequests);
 public:
 
     virtual ~TreeRender();
@@ -211,6 +283,29 @@ public:
      **/
     void setRenderAborted();
 
+    /**
+     * @brief Returns statistics on the time elapsed between the call to setRenderAborted() and the
+     * moment launchRender() returned, for all renders aborted since the application started.
+     * Latencies are in seconds.
+     **/
+    static void getAbortLatencyStats(int* nAbortedRenders, double* averageLatency, double* maxLatency);
+
+    /**
+     * @brief Returns the account of the memory currently allocated by the nodes for this render, see MemoryAccount.
+     **/
+    MemoryAccountPtr getMemoryAccount() const;
+
+    /**
+     * @brief Returns the arena in which the transient objects of this render (the FrameViewRequest and
+     * the RequestPassSharedData) are allocated. The arena is freed when the last of these objects is destroyed.
+     **/
+    RenderArenaPtr getArena() const;
+
+    /**
+     * @brief Returns all the renders which are not destroyed yet in the application
+     **/
+    static std::list<TreeRenderPtr> getActiveRenders();
+
     /**
      * @brief Returns whether this render is part of a playback render or just a single render
      **/
@@ -221,6 +316,11 @@ public:
      **/
     bool isDraftRender() const;
 
+    /**
+     * @brief Returns the priority class of the render tasks in the thread pool, see RenderTaskDispatcher
+     **/
+    RenderPriorityEnum getPriority() const;
+
     /**
      * @brief If true, effects should always render at least once during the render of the tree
      **/
@@ -243,6 +343,30 @@ public:
      **/
     FrameViewRequestPtr getExtraRequestedResultsForNode(const NodePtr& node) const;
 
+    /**
+     * @brief Returns the request of another effect of this render that produces the same image as the given request:
+     * an effect with the same frame/view hash, rendered at the same mipmap level, proxy scale and plane.
+     * Duplicated sub-graphs (copy-pasted groups, PyPlugs with the same settings and inputs) are then rendered once per render
+     * instead of relying on the cache to find the results of the other copy.
+     * If there is no such request, the given request is registered so that the next identical requests find it
+     * and a NULL pointer is returned.
+     **/
+    FrameViewRequestPtr getOrRegisterIdenticalRequest(U64 nodeFrameViewHash, const FrameViewRequestPtr& request);
+
+    /**
+     * @brief Same as getOrRegisterIdenticalRequest() but across renders: returns the request of another render which is not aborted
+     * that is going to render the same image as the given request, e.g. when the viewer, the node previews and a background render
+     * render the same frame at once. The given request may then wait for its results instead of rendering the image again.
+     * The requests of a render are registered with registerInFlightRequest() and are unregistered when its launchRender() function returns.
+     **/
+    FrameViewRequestPtr getInFlightRequest(U64 nodeFrameViewHash, const FrameViewRequestPtr& request) const;
+    void registerInFlightRequest(U64 nodeFrameViewHash, const FrameViewRequestPtr& request);
+
+    /**
+     * @brief Returns true if the given request is still registered with registerInFlightRequest()
+     **/
+    static bool isInFlightRequest(const FrameViewRequestPtr& request);
+
     /**
      * @brief Returns the object used to gather stats for this rende
      **/
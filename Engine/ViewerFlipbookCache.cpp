@@ -0,0 +1,325 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ViewerFlipbookCache.h"
+
+#include <map>
+#include <cassert>
+#include <cstring> // memcpy
+
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+
+#include "Engine/CacheEntryBase.h"
+#include "Engine/Image.h"
+#include "Engine/ImagePlaneDesc.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct FlipbookFrameKey
+{
+    TimeValue time;
+    ViewIdx view;
+    int viewerProcessIndex;
+
+    bool operator<(const FlipbookFrameKey& other) const
+    {
+        if ( (double)time != (double)other.time ) {
+            return (double)time < (double)other.time;
+        }
+        if ( (int)view != (int)other.view ) {
+            return (int)view < (int)other.view;
+        }
+
+        return viewerProcessIndex < other.viewerProcessIndex;
+    }
+};
+
+struct FlipbookFrame
+{
+    // What the frame was rendered with
+    U64 viewerProcessHash;
+    unsigned int mipMapLevel;
+    bool draftMode;
+    RectD roi;
+    ImageCacheKeyPtr imageKey;
+
+    // The image, if it is not compressed
+    ImagePtr image;
+
+    // Otherwise the compressed buffer of the image and what is needed to allocate it again
+    QByteArray compressedData;
+    RectI bounds;
+    ImageBitDepthEnum bitDepth;
+    RenderScale proxyScale;
+
+    // The memory used by this frame
+    std::size_t sizeBytes;
+
+    FlipbookFrame()
+    : viewerProcessHash(0)
+    , mipMapLevel(0)
+    , draftMode(false)
+    , roi()
+    , imageKey()
+    , image()
+    , compressedData()
+    , bounds()
+    , bitDepth(eImageBitDepthByte)
+    , proxyScale(1.)
+    , sizeBytes(0)
+    {
+    }
+};
+
+typedef std::map<FlipbookFrameKey, FlipbookFrame> FlipbookFramesMap;
+
+struct ViewerFlipbookCachePrivate
+{
+    // Protects all data below
+    mutable QMutex lock;
+
+    FlipbookFramesMap frames;
+
+    // Sum of sizeBytes of all frames
+    std::size_t sizeBytes;
+
+    ViewerFlipbookCachePrivate()
+    : lock()
+    , frames()
+    , sizeBytes(0)
+    {
+    }
+
+    void removeFrame(FlipbookFramesMap::iterator it)
+    {
+        assert(sizeBytes >= it->second.sizeBytes);
+        sizeBytes -= it->second.sizeBytes;
+        frames.erase(it);
+    }
+
+    /**
+     * @brief Removes the frames that were not rendered with the given mipmap level and draft mode: they are left
+     * from a previous zoom level and would otherwise hold the memory until their frame is played again.
+     **/
+    void removeFramesWithOtherParameters(unsigned int mipMapLevel, bool draftMode)
+    {
+        FlipbookFramesMap::iterator it = frames.begin();
+        while ( it != frames.end() ) {
+            if ( (it->second.mipMapLevel != mipMapLevel) || (it->second.draftMode != draftMode) ) {
+                FlipbookFramesMap::iterator next = it;
+                ++next;
+                removeFrame(it);
+                it = next;
+            } else {
+                ++it;
+            }
+        }
+    }
+};
+
+ViewerFlipbookCache::ViewerFlipbookCache()
+    : _imp( new ViewerFlipbookCachePrivate() )
+{
+}
+
+ViewerFlipbookCache::~ViewerFlipbookCache()
+{
+}
+
+static std::size_t
+getImageSizeBytes(const RectI& bounds,
+                  ImageBitDepthEnum bitDepth)
+{
+    // The images are always RGBA
+    return (std::size_t)bounds.area() * 4 * getSizeOfForBitDepth(bitDepth);
+}
+
+bool
+ViewerFlipbookCache::getFrame(TimeValue time,
+                              ViewIdx view,
+                              int viewerProcessIndex,
+                              U64 viewerProcessHash,
+                              unsigned int mipMapLevel,
+                              bool draftMode,
+                              const RectD& roi,
+                              ImagePtr* image,
+                              RectD* cachedRoi,
+                              ImageCacheKeyPtr* imageKey) const
+{
+    FlipbookFrameKey key;
+    key.time = time;
+    key.view = view;
+    key.viewerProcessIndex = viewerProcessIndex;
+
+    FlipbookFrame frame;
+    {
+        QMutexLocker k(&_imp->lock);
+        FlipbookFramesMap::const_iterator found = _imp->frames.find(key);
+        if ( found == _imp->frames.end() ) {
+            return false;
+        }
+        if ( (found->second.viewerProcessHash != viewerProcessHash) || (found->second.mipMapLevel != mipMapLevel) || (found->second.draftMode != draftMode) ) {
+            return false;
+        }
+        if ( roi.isNull() ? !found->second.roi.isNull() : ( !found->second.roi.isNull() && !found->second.roi.contains(roi) ) ) {
+            return false;
+        }
+
+        // Copying the frame only references the image or the compressed buffer
+        frame = found->second;
+    }
+
+    *cachedRoi = frame.roi;
+    *imageKey = frame.imageKey;
+    if (frame.image) {
+        *image = frame.image;
+
+        return true;
+    }
+
+    // Decompress outside of the lock
+    QByteArray data = qUncompress(frame.compressedData);
+    if ( (std::size_t)data.size() != getImageSizeBytes(frame.bounds, frame.bitDepth) ) {
+        return false;
+    }
+
+    Image::InitStorageArgs initArgs;
+    initArgs.bounds = frame.bounds;
+    initArgs.plane = ImagePlaneDesc::getRGBAComponents();
+    initArgs.mipMapLevel = frame.mipMapLevel;
+    initArgs.proxyScale = frame.proxyScale;
+    initArgs.bitdepth = frame.bitDepth;
+    initArgs.storage = eStorageModeRAM;
+    initArgs.bufferFormat = eImageBufferLayoutRGBAPackedFullRect;
+    ImagePtr decompressedImage = Image::create(initArgs);
+    if (!decompressedImage) {
+        return false;
+    }
+
+    Image::CPUData imageData;
+    decompressedImage->getCPUData(&imageData);
+    std::memcpy( imageData.ptrs[0], data.constData(), data.size() );
+    *image = decompressedImage;
+
+    return true;
+} // getFrame
+
+void
+ViewerFlipbookCache::insertFrame(TimeValue time,
+                                 ViewIdx view,
+                                 int viewerProcessIndex,
+                                 U64 viewerProcessHash,
+                                 unsigned int mipMapLevel,
+                                 bool draftMode,
+                                 const RectD& roi,
+                                 const ImagePtr& image,
+                                 const ImageCacheKeyPtr& imageKey,
+                                 std::size_t maxSizeBytes)
+{
+    if (!image) {
+        return;
+    }
+    assert(image->getBufferFormat() == eImageBufferLayoutRGBAPackedFullRect);
+
+    FlipbookFrameKey key;
+    key.time = time;
+    key.view = view;
+    key.viewerProcessIndex = viewerProcessIndex;
+
+    FlipbookFrame frame;
+    frame.viewerProcessHash = viewerProcessHash;
+    frame.mipMapLevel = mipMapLevel;
+    frame.draftMode = draftMode;
+    frame.roi = roi;
+    frame.imageKey = imageKey;
+    frame.bounds = image->getBounds();
+    frame.bitDepth = image->getBitDepth();
+    frame.proxyScale = image->getProxyScale();
+
+    const std::size_t imageSizeBytes = getImageSizeBytes(frame.bounds, frame.bitDepth);
+
+    bool compress;
+    {
+        QMutexLocker k(&_imp->lock);
+
+        // The frame this one replaces is stale
+        FlipbookFramesMap::iterator found = _imp->frames.find(key);
+        if ( found != _imp->frames.end() ) {
+            _imp->removeFrame(found);
+        }
+        if (_imp->sizeBytes + imageSizeBytes > maxSizeBytes) {
+            _imp->removeFramesWithOtherParameters(mipMapLevel, draftMode);
+        }
+        if (_imp->sizeBytes >= maxSizeBytes) {
+            return;
+        }
+        compress = _imp->sizeBytes + imageSizeBytes > maxSizeBytes;
+    }
+
+    if (!compress) {
+        frame.image = image;
+        frame.sizeBytes = imageSizeBytes;
+    } else {
+        // Compress outside of the lock, with the fastest level as for the compressed tier of the tile cache
+        Image::CPUData imageData;
+        image->getCPUData(&imageData);
+        frame.compressedData = qCompress( (const uchar*)imageData.ptrs[0], (int)imageSizeBytes, 1 );
+        if ( frame.compressedData.isEmpty() ) {
+            return;
+        }
+        frame.sizeBytes = frame.compressedData.size();
+    }
+
+    QMutexLocker k(&_imp->lock);
+    if (_imp->sizeBytes + frame.sizeBytes > maxSizeBytes) {
+        return;
+    }
+    FlipbookFramesMap::iterator found = _imp->frames.find(key);
+    if ( found != _imp->frames.end() ) {
+        // Inserted concurrently
+        _imp->removeFrame(found);
+    }
+    _imp->frames[key] = frame;
+    _imp->sizeBytes += frame.sizeBytes;
+} // insertFrame
+
+void
+ViewerFlipbookCache::clear()
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->frames.clear();
+    _imp->sizeBytes = 0;
+}
+
+std::size_t
+ViewerFlipbookCache::getSizeBytes() const
+{
+    QMutexLocker k(&_imp->lock);
+
+    return _imp->sizeBytes;
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,116 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_VIEWERFLIPBOOKCACHE_H
+#define NATRON_ENGINE_VIEWERFLIPBOOKCACHE_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include <cstddef>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/RectD.h"
+#include "Engine/TimeValue.h"
+#include "Engine/ViewIdx.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct ViewerFlipbookCachePrivate;
+
+/**
+ * @brief An in-RAM store of the images displayed by the viewer during playback, as they are uploaded to the
+ * OpenGL textures: the output of the viewer process nodes (with the display color transform applied) converted
+ * to RGBA. When a frame is played again, its image is uploaded directly without launching a render.
+ *
+ * There is a single slot per frame, view and viewer process: a frame is valid as long as the hash of the
+ * viewer process node at that frame did not change and it was rendered with the same mipmap level and draft mode.
+ * A frame that does not fit in the memory budget is compressed, and frames are not added any more once the budget
+ * is reached, so that a playback loop longer than the budget still plays the cached part of the loop without rendering.
+ * All functions are MT-safe.
+ **/
+class ViewerFlipbookCache
+{
+public:
+
+    ViewerFlipbookCache();
+
+    ~ViewerFlipbookCache();
+
+    /**
+     * @brief Returns in image the frame cached for the given viewer process at the given time and view if it is still valid
+     * and its canonical region contains roi. A null roi means the full image: it only matches a frame cached with a null roi.
+     * The canonical region of the cached image is returned in cachedRoi and the key of the image of the viewer process
+     * node in the image cache in imageKey.
+     **/
+    bool getFrame(TimeValue time,
+                  ViewIdx view,
+                  int viewerProcessIndex,
+                  U64 viewerProcessHash,
+                  unsigned int mipMapLevel,
+                  bool draftMode,
+                  const RectD& roi,
+                  ImagePtr* image,
+                  RectD* cachedRoi,
+                  ImageCacheKeyPtr* imageKey) const;
+
+    /**
+     * @brief Stores the given image, which must have the eImageBufferLayoutRGBAPackedFullRect layout, replacing the frame
+     * previously cached for the same time, view and viewer process. The frame is not stored if it does not fit in maxSizeBytes.
+     **/
+    void insertFrame(TimeValue time,
+                     ViewIdx view,
+                     int viewerProcessIndex,
+                     U64 viewerProcessHash,
+                     unsigned int mipMapLevel,
+                     bool draftMode,
+                     const RectD& roi,
+                     const ImagePtr& image,
+                     const ImageCacheKeyPtr& imageKey,
+                     std::size_t maxSizeBytes);
+
+    /**
+     * @brief Removes all frames
+     **/
+    void clear();
+
+    /**
+     * @brief Returns the memory used by the cached frames, in bytes
+     **/
+    std::size_t getSizeBytes() const;
+
+private:
+
+    boost::scoped_ptr<ViewerFlipbookCachePrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_VIEWERFLIPBOOKCACHE_H
@@ -29,6 +29,7 @@
 #include <cassert>
 #include <cstring> // for std::memcpy
 #include <cfloat> // DBL_MAX
+#include <vector>
 
 #include "Engine/AppInstance.h"
 #include "Engine/AppManager.h"
@@ -45,6 +46,10 @@
 #include "Engine/Settings.h"
 #include "Engine/ViewerNode.h"
 
+#ifdef __NATRON_SSE2__
+#include <emmintrin.h>
+#endif
+
 #define GAMMA_LUT_NB_VALUES 1023
 
 
@@ -110,9 +115,22 @@ struct ViewerInstancePrivate
     void getChannelOptions(TimeValue time, ImagePlaneDesc* rgbLayer, ImagePlaneDesc* alphaLayer, int* alphaChannelIndex, ImagePlaneDesc* displayChannels) const;
 
     void setDisplayChannelsFromLayer(const std::list<ImagePlaneDesc>& availableLayers);
+
+    /**
+     * @brief Returns true if the gain and gamma are not applied by the render action but by the OpenGL
+     * viewer when drawing the texture. This is the case for float outputs when auto-contrast is disabled.
+     * The display colorspace of float outputs is always applied by the OpenGL viewer.
+     **/
+    bool isGradingDoneByViewer() const;
     
 };
 
+bool
+ViewerInstancePrivate::isGradingDoneByViewer() const
+{
+    return _publicInterface->getBitDepth(-1) == eImageBitDepthFloat && !autoContrastKnob.lock()->getValue();
+}
+
 
 const Color::Lut*
 ViewerInstance::lutFromColorspace(ViewerColorSpaceEnum cs)
@@ -403,12 +421,13 @@ ViewerInstance::isIdentity(TimeValue time,
         return eActionStatusOK;
     }
 
-    if (_imp->gainKnob.lock()->getValue() != 1.) {
+    bool gradingDoneByViewer = _imp->isGradingDoneByViewer();
+    if (!gradingDoneByViewer && _imp->gainKnob.lock()->getValue() != 1.) {
         *inputNb = -1;
         return eActionStatusOK;
     }
 
-    if (_imp->gammaKnob.lock()->getValue() != 1.) {
+    if (!gradingDoneByViewer && _imp->gammaKnob.lock()->getValue() != 1.) {
         *inputNb = -1;
         return eActionStatusOK;
     }
@@ -720,6 +739,110 @@ struct MinMaxVal {
     double max;
 };
 
+/**
+ * @brief Finds the min and max of n float values separated by stride values, ignoring NaNs.
+ **/
+static void
+findMinMaxFloatValues(const float* values,
+                      int stride,
+                      int n,
+                      float* vmin,
+                      float* vmax)
+{
+    float mini = std::numeric_limits<float>::infinity();
+    float maxi = -std::numeric_limits<float>::infinity();
+    int i = 0;
+#ifdef __NATRON_SSE2__
+    if (stride == 1) {
+        // Parallel min/max on 4 lanes, reduced at the end of the run.
+        // The accumulator is the second operand so that NaNs are ignored as in the scalar loop.
+        __m128 minV = _mm_set1_ps(mini);
+        __m128 maxV = _mm_set1_ps(maxi);
+        for (; i + 4 <= n; i += 4) {
+            const __m128 v = _mm_loadu_ps(values + i);
+            minV = _mm_min_ps(v, minV);
+            maxV = _mm_max_ps(v, maxV);
+        }
+        float mins[4], maxs[4];
+        _mm_storeu_ps(mins, minV);
+        _mm_storeu_ps(maxs, maxV);
+        for (int k = 0; k < 4; ++k) {
+            mini = std::min(mini, mins[k]);
+            maxi = std::max(maxi, maxs[k]);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        const float v = values[i * stride];
+        if (v < mini) {
+            mini = v;
+        }
+        if (v > maxi) {
+            maxi = v;
+        }
+    }
+    *vmin = mini;
+    *vmax = maxi;
+} // findMinMaxFloatValues
+
+/**
+ * @brief Returns false: only float images are reduced channel by channel.
+ **/
+template <int srcNComps, typename PIX>
+bool
+findScanLineChannelsMinMax(const PIX* /*src_pixels*/[4],
+                           int /*pixelStride*/,
+                           int /*width*/,
+                           float /*chMin*/[4],
+                           float /*chMax*/[4])
+{
+    return false;
+}
+
+/**
+ * @brief Finds the min and max of each channel of the pixels of a float scan-line, as fetched in
+ * findAutoContrastVminVmax_generic(): channels that are not in the image are 0, except alpha which is 1,
+ * and a single channel image is alpha.
+ **/
+template <int srcNComps>
+bool
+findScanLineChannelsMinMax(const float* src_pixels[4],
+                           int pixelStride,
+                           int width,
+                           float chMin[4],
+                           float chMax[4])
+{
+    for (int i = 0; i < 4; ++i) {
+        chMin[i] = chMax[i] = (i == 3) ? 1.f : 0.f;
+    }
+
+#ifdef __NATRON_SSE2__
+    if ( srcNComps == 4 && pixelStride == 4 && src_pixels[0] &&
+         (src_pixels[1] == src_pixels[0] + 1) && (src_pixels[2] == src_pixels[0] + 2) && (src_pixels[3] == src_pixels[0] + 3) ) {
+        // Packed RGBA: a pixel fills a vector, each lane accumulates the min/max of a channel
+        __m128 minV = _mm_set1_ps( std::numeric_limits<float>::infinity() );
+        __m128 maxV = _mm_set1_ps( -std::numeric_limits<float>::infinity() );
+        const float* pix = src_pixels[0];
+        for (int x = 0; x < width; ++x, pix += 4) {
+            const __m128 v = _mm_loadu_ps(pix);
+            minV = _mm_min_ps(v, minV);
+            maxV = _mm_max_ps(v, maxV);
+        }
+        _mm_storeu_ps(chMin, minV);
+        _mm_storeu_ps(chMax, maxV);
+        return true;
+    }
+#endif
+
+    for (int i = 0; i < srcNComps; ++i) {
+        if (src_pixels[i]) {
+            const int channelIndex = (srcNComps == 1) ? 3 : i;
+            findMinMaxFloatValues(src_pixels[i], pixelStride, width, &chMin[channelIndex], &chMax[channelIndex]);
+        }
+    }
+    return true;
+} // findScanLineChannelsMinMax
+
 template <typename PIX, int maxValue, int srcNComps, DisplayChannelsEnum channels>
 MinMaxVal
 findAutoContrastVminVmax_generic(const Image::CPUData& colorImage,
@@ -739,6 +862,43 @@ findAutoContrastVminVmax_generic(const Image::CPUData& colorImage,
         const PIX* src_pixels[4];
         Image::getChannelPointers<PIX, srcNComps>((const PIX**)colorImage.ptrs, roi.x1, y, colorImage.bounds, (PIX**)src_pixels, &pixelStride);
 
+        // Float scan-lines are reduced channel by channel in single precision, which is exact, except for
+        // the luminance which is computed per pixel below
+        float chMin[4], chMax[4];
+        if ( (channels != eDisplayChannelsY) && (channels != eDisplayChannelsMatte) &&
+             findScanLineChannelsMinMax<srcNComps>(src_pixels, pixelStride, roi.width(), chMin, chMax) ) {
+            double mini, maxi;
+            switch (channels) {
+                case eDisplayChannelsRGB:
+                    mini = std::min(std::min(chMin[0], chMin[1]), chMin[2]);
+                    maxi = std::max(std::max(chMax[0], chMax[1]), chMax[2]);
+                    break;
+                case eDisplayChannelsR:
+                    mini = chMin[0];
+                    maxi = chMax[0];
+                    break;
+                case eDisplayChannelsG:
+                    mini = chMin[1];
+                    maxi = chMax[1];
+                    break;
+                case eDisplayChannelsB:
+                    mini = chMin[2];
+                    maxi = chMax[2];
+                    break;
+                case eDisplayChannelsA:
+                    mini = chMin[3];
+                    maxi = chMax[3];
+                    break;
+                default:
+                    mini = 0.;
+                    maxi = 0.;
+                    break;
+            }
+            localVmin = std::min(localVmin, mini);
+            localVmax = std::max(localVmax, maxi);
+            continue;
+        }
+
         for (int x = roi.x1; x < roi.x2; ++x) {
 
             double tmpPix[4] = {0., 0., 0., 1.};
@@ -962,13 +1122,36 @@ toBGRA(unsigned char r,
     return (a << 24) | (r << 16) | (g << 8) | b;
 }
 
+/**
+ * @brief Converts a pixel value in the colorspace of the input image to a linear float
+ **/
+template <typename PIX>
+static inline float
+toLinearFloat(PIX pix, const Color::Lut* srcColorspace)
+{
+    float ret = Image::convertPixelDepth<PIX, float>(pix);
+    return srcColorspace ? srcColorspace->fromColorSpaceFloatToLinearFloat(ret) : ret;
+}
+
+// 8-bit values can be looked up in the tables of the Lut, which hold exactly the same values
+template <>
+inline float
+toLinearFloat(unsigned char pix, const Color::Lut* srcColorspace)
+{
+    return srcColorspace ? srcColorspace->fromColorSpaceUint8ToLinearFloatFast(pix) : Image::convertPixelDepth<unsigned char, float>(pix);
+}
+
+/**
+ * @brief Fetches the pixel of the input images in linear RGBA, according to the displayed channels.
+ * The pixel still has to be graded with gradeViewerScanLine().
+ **/
 template <typename PIX, int maxValue, int srcNComps, DisplayChannelsEnum channels>
 void
-genericViewerProcessFunctor(const RenderViewerArgs& args,
-                            const PIX* color_pixels[4],
-                            const PIX* alpha_pixels[4],
-                            float tmpPix[4],
-                            double* alphaMatteValue)
+genericViewerFetchFunctor(const RenderViewerArgs& args,
+                          const PIX* color_pixels[4],
+                          const PIX* alpha_pixels[4],
+                          float tmpPix[4],
+                          double* alphaMatteValue)
 {
     memset(tmpPix, 0, sizeof(float) * 4);
 
@@ -989,10 +1172,7 @@ genericViewerProcessFunctor(const RenderViewerArgs& args,
             break;
         case eDisplayChannelsB:
             if (color_pixels[2]) {
-                tmpPix[0] = Image::convertPixelDepth<PIX, float>(*color_pixels[2]);
-                if (args.srcColorspace) {
-                    tmpPix[0] = args.srcColorspace->fromColorSpaceFloatToLinearFloat(tmpPix[0]);
-                }
+                tmpPix[0] = toLinearFloat<PIX>(*color_pixels[2], args.srcColorspace);
             } else {
                 tmpPix[0] = 0.;
             }
@@ -1001,10 +1181,7 @@ genericViewerProcessFunctor(const RenderViewerArgs& args,
             break;
         case eDisplayChannelsG:
             if (color_pixels[1]) {
-                tmpPix[0] = Image::convertPixelDepth<PIX, float>(*color_pixels[1]);
-                if (args.srcColorspace) {
-                    tmpPix[0] = args.srcColorspace->fromColorSpaceFloatToLinearFloat(tmpPix[0]);
-                }
+                tmpPix[0] = toLinearFloat<PIX>(*color_pixels[1], args.srcColorspace);
             } else {
                 tmpPix[0] = 0.;
             }
@@ -1013,10 +1190,7 @@ genericViewerProcessFunctor(const RenderViewerArgs& args,
             break;
         case eDisplayChannelsR:
             if (color_pixels[0]) {
-                tmpPix[0] = Image::convertPixelDepth<PIX, float>(*color_pixels[0]);
-                if (args.srcColorspace) {
-                    tmpPix[0] = args.srcColorspace->fromColorSpaceFloatToLinearFloat(tmpPix[0]);
-                }
+                tmpPix[0] = toLinearFloat<PIX>(*color_pixels[0], args.srcColorspace);
             } else {
                 tmpPix[0] = 0.;
             }
@@ -1029,10 +1203,7 @@ genericViewerProcessFunctor(const RenderViewerArgs& args,
             for (int i = 0; i < 3; ++i) {
                 if (color_pixels[i]) {
                     assert(*color_pixels[i] == *color_pixels[i]); // check for NaNs
-                    tmpPix[i] = Image::convertPixelDepth<PIX, float>(*color_pixels[i]);
-                    if (args.srcColorspace) {
-                        tmpPix[i] = args.srcColorspace->fromColorSpaceFloatToLinearFloat(tmpPix[i]);
-                    }
+                    tmpPix[i] = toLinearFloat<PIX>(*color_pixels[i], args.srcColorspace);
 
                 }
             }
@@ -1045,45 +1216,164 @@ genericViewerProcessFunctor(const RenderViewerArgs& args,
     }
 
 
-    // Apply gain gamma and offset to the RGB channels
+    // If this is the same image, the matte is the graded pixel, see gradeViewerScanLine()
+    if (channels == eDisplayChannelsMatte && args.colorImage.ptrs != args.alphaImage.ptrs) {
+        // If the image has a color space, convert to linear float first
+        *alphaMatteValue = toLinearFloat<PIX>(*alpha_pixels[args.alphaChannelIndex], args.srcColorspace);
+    }
+} // genericViewerFetchFunctor
+
+/**
+ * @brief Same as ViewerInstancePrivate::lookupGammaLut() applied to the RGB channels of the pixel.
+ **/
+static inline void
+lookupGammaLutRGB(float pix[4], const float* gammaLookupBuffer)
+{
+#ifdef __NATRON_SSE2__
+    assert(pix[0] == pix[0] && pix[1] == pix[1] && pix[2] == pix[2]); // check for NaN
+    // Values outside of [0,1] are clamped: the lut gives 0 for 0 and 1 for 1
+    const __m128 clamped = _mm_min_ps( _mm_max_ps( _mm_loadu_ps(pix), _mm_setzero_ps() ), _mm_set1_ps(1.f) );
+    const __m128 scaled = _mm_mul_ps( clamped, _mm_set1_ps( (float)GAMMA_LUT_NB_VALUES ) );
+    const __m128i indices = _mm_cvttps_epi32(scaled);
+    const __m128 alpha = _mm_sub_ps( scaled, _mm_cvtepi32_ps(indices) );
+
+    // There is no gather instruction in SSE2
+    int idx[4];
+    _mm_storeu_si128( (__m128i*)idx, indices );
+    float a[4], b[4];
+    for (int i = 0; i < 3; ++i) {
+        a[i] = gammaLookupBuffer[idx[i]];
+        b[i] = (idx[i] < GAMMA_LUT_NB_VALUES) ? gammaLookupBuffer[idx[i] + 1] : 0.f;
+    }
+    a[3] = b[3] = 0.f;
+
+    float result[4];
+    _mm_storeu_ps( result, _mm_add_ps( _mm_mul_ps( _mm_loadu_ps(a), _mm_sub_ps(_mm_set1_ps(1.f), alpha) ), _mm_mul_ps(_mm_loadu_ps(b), alpha) ) );
     for (int i = 0; i < 3; ++i) {
-        tmpPix[i] = tmpPix[i] * args.gain + args.offset;
+        pix[i] = result[i];
     }
-    if (args.gamma <= 0.) {
+#else
+    for (int i = 0; i < 3; ++i) {
+        pix[i] = ViewerInstancePrivate::lookupGammaLut(pix[i], gammaLookupBuffer);
+    }
+#endif
+} // lookupGammaLutRGB
+
+/**
+ * @brief Applies gain, offset and gamma to the RGB channels of a scan-line of pixels fetched with
+ * genericViewerFetchFunctor(). The computations are done in single precision on whole pixels.
+ **/
+template <DisplayChannelsEnum channels>
+void
+gradeViewerScanLine(const RenderViewerArgs& args,
+                    float* pixels,
+                    double* matte,
+                    int width)
+{
+    const float gain = (float)args.gain;
+    const float offset = (float)args.offset;
+#ifdef __NATRON_SSE2__
+    // The alpha channel is left untouched
+    const __m128 gainV = _mm_set_ps(1.f, gain, gain, gain);
+    const __m128 offsetV = _mm_set_ps(0.f, offset, offset, offset);
+    for (int x = 0; x < width; ++x) {
+        float* tmpPix = pixels + x * 4;
+        _mm_storeu_ps( tmpPix, _mm_add_ps( _mm_mul_ps(_mm_loadu_ps(tmpPix), gainV), offsetV ) );
+    }
+#else
+    for (int x = 0; x < width; ++x) {
+        float* tmpPix = pixels + x * 4;
         for (int i = 0; i < 3; ++i) {
-            tmpPix[i] = (tmpPix[i]  < 1.) ? 0. : (tmpPix[i]  == 1. ? 1. : std::numeric_limits<double>::infinity() );
+            tmpPix[i] = tmpPix[i] * gain + offset;
+        }
+    }
+#endif
+
+    if (args.gamma <= 0.) {
+        for (int x = 0; x < width; ++x) {
+            float* tmpPix = pixels + x * 4;
+            for (int i = 0; i < 3; ++i) {
+                tmpPix[i] = (tmpPix[i]  < 1.f) ? 0.f : (tmpPix[i]  == 1.f ? 1.f : std::numeric_limits<float>::infinity() );
+            }
         }
     } else if (args.gamma != 1.) {
-        for (int i = 0; i < 3; ++i) {
-            tmpPix[i] = ViewerInstancePrivate::lookupGammaLut(tmpPix[i], args.gammaLut);
+        for (int x = 0; x < width; ++x) {
+            lookupGammaLutRGB(pixels + x * 4, args.gammaLut);
         }
     }
 
     if (channels == eDisplayChannelsY) {
-        tmpPix[0] = 0.299 * tmpPix[1] + 0.587 * tmpPix[2] + 0.114 * tmpPix[3];
-        tmpPix[1] = tmpPix[0];
-        tmpPix[2] = tmpPix[0];
-    } else if (channels == eDisplayChannelsMatte) {
-        *alphaMatteValue = 0;
-
-        // If this is the same image, use the already processed tmpPix
-        if (args.colorImage.ptrs == args.alphaImage.ptrs) {
-            *alphaMatteValue = tmpPix[args.alphaChannelIndex];
-        } else {
-            *alphaMatteValue = Image::convertPixelDepth<PIX, float>(*alpha_pixels[args.alphaChannelIndex]);
-            // If the image has a color space, convert to linear float first
-            if (args.srcColorspace) {
-                *alphaMatteValue = args.srcColorspace->fromColorSpaceFloatToLinearFloat(*alphaMatteValue);
+        for (int x = 0; x < width; ++x) {
+            float* tmpPix = pixels + x * 4;
+            tmpPix[0] = 0.299f * tmpPix[1] + 0.587f * tmpPix[2] + 0.114f * tmpPix[3];
+            tmpPix[1] = tmpPix[0];
+            tmpPix[2] = tmpPix[0];
+        }
+    } else if (channels == eDisplayChannelsMatte && args.colorImage.ptrs == args.alphaImage.ptrs) {
+        // If this is the same image, use the already processed pixels
+        for (int x = 0; x < width; ++x) {
+            matte[x] = pixels[x * 4 + args.alphaChannelIndex];
+        }
+    }
+} // gradeViewerScanLine
+
+/**
+ * @brief Fetches and grades the scan-line y of the roi in linePixels (and lineMatte for the matte display)
+ **/
+template <typename PIX, int maxValue, int srcNComps, DisplayChannelsEnum channels>
+void
+processViewerScanLine(const RenderViewerArgs& args,
+                      const RectI & roi,
+                      int y,
+                      float* linePixels,
+                      double* lineMatte)
+{
+    const int width = roi.width();
+
+    int colorPixelStride;
+    const PIX* color_pixels[4];
+    Image::getChannelPointers<PIX, srcNComps>((const PIX**)args.colorImage.ptrs, roi.x1, y, args.colorImage.bounds, (PIX**)color_pixels, &colorPixelStride);
+
+    int alphaPixelStride;
+    const PIX* alpha_pixels[4];
+    Image::getChannelPointers<PIX>((const PIX**)args.alphaImage.ptrs, roi.x1, y, args.alphaImage.bounds, args.alphaImage.nComps, (PIX**)alpha_pixels, &alphaPixelStride);
+
+    for (int x = 0; x < width; ++x) {
+        double alphaMatteValue = 0;
+        genericViewerFetchFunctor<PIX, maxValue, srcNComps, channels>(args, color_pixels, alpha_pixels, &linePixels[x * 4], &alphaMatteValue);
+        if (channels == eDisplayChannelsMatte) {
+            lineMatte[x] = alphaMatteValue;
+        }
+        for (int i = 0; i < 4; ++i) {
+            if (color_pixels[i]) {
+                color_pixels[i] += colorPixelStride;
+            }
+            if (alpha_pixels[i]) {
+                alpha_pixels[i] += alphaPixelStride;
             }
         }
     }
-} // genericViewerProcessFunctor
+
+    gradeViewerScanLine<channels>(args, linePixels, lineMatte, width);
+} // processViewerScanLine
 
 template <typename PIX, int maxValue, int srcNComps, DisplayChannelsEnum channels>
 void
 applyViewerProcess8bit_generic(const RenderViewerArgs& args, const RectI & roi)
 {
+    const int width = roi.width();
+
+    // Each scan-line is processed in passes: pixels are first fetched, graded and converted
+    // to the display colorspace, then the error is diffused, which has to be done pixel after pixel.
 
+    // The processed linear RGBA values of each pixel of the scan-line
+    std::vector<float> linePixels(width * 4);
+
+    // The alpha of the matte of each pixel of the scan-line
+    std::vector<double> lineMatte(channels == eDisplayChannelsMatte ? width : 0);
+
+    // The RGB values of each pixel of the scan-line in the display colorspace, in [0 - 0xff00]
+    std::vector<unsigned short> lineUint8xx(args.dstColorspace ? width * 3 : 0);
 
     for (int y = roi.y1; y < roi.y2; ++y) {
 
@@ -1092,36 +1382,33 @@ applyViewerProcess8bit_generic(const RenderViewerArgs& args, const RectI & roi)
             return;
         }
 
+        processViewerScanLine<PIX, maxValue, srcNComps, channels>(args, roi, y, &linePixels[0], channels == eDisplayChannelsMatte ? &lineMatte[0] : 0);
+
+        if (args.dstColorspace) {
+            for (int i = 0; i < 3; ++i) {
+                args.dstColorspace->toColorSpaceUint8xxFromLinearFloatFast(&linePixels[i], 4, &lineUint8xx[i], 3, width);
+            }
+        }
+
+        int dstPixelStride;
+        unsigned char* dst_pixels[4];
+        Image::getChannelPointers<unsigned char>((const unsigned char**)args.dstImage.ptrs, roi.x1, y, args.dstImage.bounds, args.dstImage.nComps, (unsigned char**)dst_pixels, &dstPixelStride);
+        assert(dst_pixels[0]);
+
         // For error diffusion, we start at each line at a random pixel along the line so it does
         // not create a pattern in the output image.
-        const int startX = (int)( rand() % (roi.width()) ) + roi.x1;
+        const int startX = (int)( rand() % width );
 
         for (int backward = 0; backward < 2; ++backward) {
 
-            int x = backward ? std::max(roi.x1, startX - 1) : startX;
+            int x = backward ? std::max(0, startX - 1) : startX;
 
-            const int endX = backward ? roi.x1 - 1 : roi.x2;
+            const int endX = backward ? -1 : width;
 
             unsigned error[3] = {0x80, 0x80, 0x80};
 
-
-            int colorPixelStride;
-            const PIX* color_pixels[4];
-            Image::getChannelPointers<PIX, srcNComps>((const PIX**)args.colorImage.ptrs, x, y, args.colorImage.bounds, (PIX**)color_pixels, &colorPixelStride);
-
-            int alphaPixelStride;
-            const PIX* alpha_pixels[4];
-            Image::getChannelPointers<PIX>((const PIX**)args.alphaImage.ptrs, x, y, args.alphaImage.bounds, args.alphaImage.nComps, (PIX**)alpha_pixels, &alphaPixelStride);
-
-            int dstPixelStride;
-            unsigned char* dst_pixels[4];
-            Image::getChannelPointers<unsigned char>((const unsigned char**)args.dstImage.ptrs, x, y, args.dstImage.bounds, args.dstImage.nComps, (unsigned char**)dst_pixels, &dstPixelStride);
-            assert(dst_pixels[0]);
-
             while (x != endX) {
-                float tmpPix[4];
-                double alphaMatteValue;
-                genericViewerProcessFunctor<PIX, maxValue, srcNComps, channels>(args, color_pixels, alpha_pixels, tmpPix, &alphaMatteValue);
+                const float* tmpPix = &linePixels[x * 4];
 
                 unsigned char uTmpPix[4];
                 if (!args.dstColorspace) {
@@ -1130,7 +1417,7 @@ applyViewerProcess8bit_generic(const RenderViewerArgs& args, const RectI & roi)
                     }
                 } else {
                     for (int i = 0; i < 3; ++i) {
-                        error[i] = (error[i] & 0xff) + args.dstColorspace->toColorSpaceUint8xxFromLinearFloatFast(tmpPix[i]);
+                        error[i] = (error[i] & 0xff) + lineUint8xx[x * 3 + i];
                         assert(error[i] < 0x10000);
                         uTmpPix[i] = (unsigned char)(error[i] >> 8);
                     }
@@ -1141,9 +1428,9 @@ applyViewerProcess8bit_generic(const RenderViewerArgs& args, const RectI & roi)
                 if (channels == eDisplayChannelsMatte) {
                     unsigned char matteA;
                     if (args.dstColorspace) {
-                        matteA = args.dstColorspace->toColorSpaceUint8FromLinearFloatFast(alphaMatteValue) / 2;
+                        matteA = args.dstColorspace->toColorSpaceUint8FromLinearFloatFast(lineMatte[x]) / 2;
                     } else {
-                        matteA = Color::floatToInt<256>(alphaMatteValue) / 2;
+                        matteA = Color::floatToInt<256>(lineMatte[x]) / 2;
                     }
 
                     // Add to the red channel the matte value
@@ -1152,34 +1439,12 @@ applyViewerProcess8bit_generic(const RenderViewerArgs& args, const RectI & roi)
                 }
                 // The viewer has the particularity to write-out BGRA 8-bit images instead of RGBA since the resulting
                 // image is directly fed to the GL_BGRA OpenGL texture format.
-                *reinterpret_cast<unsigned int*>(dst_pixels[0]) = toBGRA(uTmpPix[0], uTmpPix[1], uTmpPix[2], uTmpPix[3]);
-                
+                *reinterpret_cast<unsigned int*>(dst_pixels[0] + x * dstPixelStride) = toBGRA(uTmpPix[0], uTmpPix[1], uTmpPix[2], uTmpPix[3]);
+
                 if (backward) {
                     --x;
-                    for (int i = 0; i < 4; ++i) {
-                        if (color_pixels[i]) {
-                            color_pixels[i] -= colorPixelStride;
-                        }
-                        if (alpha_pixels[i]) {
-                            alpha_pixels[i] -= alphaPixelStride;
-                        }
-                        if (dst_pixels[i]) {
-                            dst_pixels[i] -= dstPixelStride;
-                        }
-                    }
                 } else {
                     ++x;
-                    for (int i = 0; i < 4; ++i) {
-                        if (color_pixels[i]) {
-                            color_pixels[i] += colorPixelStride;
-                        }
-                        if (alpha_pixels[i]) {
-                            alpha_pixels[i] += alphaPixelStride;
-                        }
-                        if (dst_pixels[i]) {
-                            dst_pixels[i] += dstPixelStride;
-                        }
-                    }
                 }
 
             } // for each pixels on the line
@@ -1270,7 +1535,13 @@ template <typename PIX, int maxValue, int srcNComps, DisplayChannelsEnum channel
 void
 applyViewerProcess32bit_Generic(const RenderViewerArgs& args, const RectI & roi)
 {
+    const int width = roi.width();
 
+    // The processed linear RGBA values of each pixel of the scan-line
+    std::vector<float> linePixels(width * 4);
+
+    // The alpha of the matte of each pixel of the scan-line
+    std::vector<double> lineMatte(channels == eDisplayChannelsMatte ? width : 0);
 
     for (int y = roi.y1; y < roi.y2; ++y) {
 
@@ -1279,35 +1550,20 @@ applyViewerProcess32bit_Generic(const RenderViewerArgs& args, const RectI & roi)
             return;
         }
 
-
-        int colorPixelStride;
-        const PIX* color_pixels[4];
-        Image::getChannelPointers<PIX, srcNComps>((const PIX**)args.colorImage.ptrs, roi.x1, y, args.colorImage.bounds, (PIX**)color_pixels, &colorPixelStride);
-
-        int alphaPixelStride;
-        const PIX* alpha_pixels[4];
-        Image::getChannelPointers<PIX>((const PIX**)args.alphaImage.ptrs, roi.x1, y, args.alphaImage.bounds, args.alphaImage.nComps, (PIX**)alpha_pixels, &alphaPixelStride);
+        processViewerScanLine<PIX, maxValue, srcNComps, channels>(args, roi, y, &linePixels[0], channels == eDisplayChannelsMatte ? &lineMatte[0] : 0);
 
         int dstPixelStride;
         float* dst_pixels[4];
         Image::getChannelPointers<float>((const float**)args.dstImage.ptrs, roi.x1, y, args.dstImage.bounds, args.dstImage.nComps, (float**)dst_pixels, &dstPixelStride);
 
-        for (int x = roi.x1; x < roi.x2; ++x) {
+        for (int x = 0; x < width; ++x) {
 
-            float tmpPix[4];
-            double alphaMatteValue;
-            genericViewerProcessFunctor<PIX, maxValue, srcNComps, channels>(args, color_pixels, alpha_pixels, tmpPix, &alphaMatteValue);
+            float* tmpPix = &linePixels[x * 4];
             if (channels == eDisplayChannelsMatte) {
-                tmpPix[0] += alphaMatteValue * 0.5;
+                tmpPix[0] += lineMatte[x] * 0.5;
             }
 
             for (int i = 0; i < 4; ++i) {
-                if (color_pixels[i]) {
-                    color_pixels[i] += colorPixelStride;
-                }
-                if (alpha_pixels[i]) {
-                    alpha_pixels[i] += alphaPixelStride;
-                }
                 if (dst_pixels[i]) {
                     *dst_pixels[i] = tmpPix[i];
                     dst_pixels[i] += dstPixelStride;
@@ -1526,14 +1782,21 @@ ViewerInstance::render(const RenderActionArgs& args)
 
     dstImage->getCPUData(&renderViewerArgs.dstImage);
 
-    renderViewerArgs.gamma = _imp->gammaKnob.lock()->getValue();
+    // For float outputs, the OpenGL viewer applies the gain, gamma and display colorspace in a fragment shader
+    // when drawing the texture, so that they can be changed without re-processing the image.
+    bool gradingDoneByViewer = _imp->isGradingDoneByViewer();
+
+    renderViewerArgs.gamma = gradingDoneByViewer ? 1. : _imp->gammaKnob.lock()->getValue();
 
     RamBuffer<float> gammaLut;
     ViewerInstancePrivate::buildGammaLut(renderViewerArgs.gamma, &gammaLut);
     renderViewerArgs.gammaLut = gammaLut.getData();
 
     bool doAutoContrast = _imp->autoContrastKnob.lock()->getValue();
-    if (!doAutoContrast) {
+    if (gradingDoneByViewer) {
+        renderViewerArgs.gain = 1.;
+        renderViewerArgs.offset = 0;
+    } else if (!doAutoContrast) {
         renderViewerArgs.gain = _imp->gainKnob.lock()->getValue();
         renderViewerArgs.gain = std::pow(2, renderViewerArgs.gain);
         renderViewerArgs.offset = 0;
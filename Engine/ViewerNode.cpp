@@ -25,6 +25,8 @@
 #include "ViewerNode.h"
 #include "ViewerNodePrivate.h"
 
+#include <cmath> // cos, sin
+
 
 
 
@@ -648,6 +650,18 @@ ViewerNode::isAutoContrastEnabled() const
     return _imp->enableAutoContrastButtonKnob.lock()->getValue();
 }
 
+double
+ViewerNode::getGain() const
+{
+    return _imp->gainSliderKnob.lock()->getValue();
+}
+
+double
+ViewerNode::getGamma() const
+{
+    return _imp->gammaSliderKnob.lock()->getValue();
+}
+
 ViewerColorSpaceEnum
 ViewerNode::getColorspace() const
 {
@@ -819,6 +833,72 @@ ViewerNode::getWipeCenter() const
     return r;
 }
 
+bool
+ViewerNode::getWipeVisibleRoI(int viewerProcessIndex,
+                              const RectD& roi,
+                              RectD* visibleRoI) const
+{
+    *visibleRoI = roi;
+    if (viewerProcessIndex == 0) {
+        return true;
+    }
+
+    ViewerCompositingOperatorEnum op = getCurrentOperator();
+    if ( (op != eViewerCompositingOperatorWipeUnder) &&
+         (op != eViewerCompositingOperatorWipeOver) &&
+         (op != eViewerCompositingOperatorWipeMinus) &&
+         (op != eViewerCompositingOperatorWipeOnionSkin) ) {
+        return true;
+    }
+
+    // B is blended with a constant alpha equal to the mix amount
+    if (getWipeAmount() <= 0.) {
+        return false;
+    }
+
+    // B is displayed on the side of the wipe line where (p - center).(cos(angle), sin(angle)) >= 0,
+    // see ViewerGL::Implementation::getWipePolygon
+    QPointF center = getWipeCenter();
+    double angle = getWipeAngle();
+    const double dirX = std::cos(angle);
+    const double dirY = std::sin(angle);
+
+    const QPointF corners[4] = {
+        QPointF(roi.x1, roi.y1), QPointF(roi.x2, roi.y1), QPointF(roi.x2, roi.y2), QPointF(roi.x1, roi.y2)
+    };
+    double dist[4];
+    for (int i = 0; i < 4; ++i) {
+        dist[i] = ( corners[i].x() - center.x() ) * dirX + ( corners[i].y() - center.y() ) * dirY;
+    }
+
+    // Bounding box of the corners on the B side and of the intersections of the wipe line with the edges of roi
+    bool visible = false;
+    for (int i = 0; i < 4; ++i) {
+        const int next = (i + 1) % 4;
+        if (dist[i] >= 0) {
+            if (!visible) {
+                visibleRoI->set( corners[i].x(), corners[i].y(), corners[i].x(), corners[i].y() );
+                visible = true;
+            } else {
+                visibleRoI->merge( corners[i].x(), corners[i].y(), corners[i].x(), corners[i].y() );
+            }
+        }
+        if (dist[i] * dist[next] < 0) {
+            double t = dist[i] / (dist[i] - dist[next]);
+            double x = corners[i].x() + t * ( corners[next].x() - corners[i].x() );
+            double y = corners[i].y() + t * ( corners[next].y() - corners[i].y() );
+            if (!visible) {
+                visibleRoI->set(x, y, x, y);
+                visible = true;
+            } else {
+                visibleRoI->merge(x, y, x, y);
+            }
+        }
+    }
+
+    return visible && !visibleRoI->isNull();
+} // getWipeVisibleRoI
+
 bool
 ViewerNode::isCheckerboardEnabled() const
 {
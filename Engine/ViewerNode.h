@@ -180,6 +180,13 @@ public:
 
     bool isAutoContrastEnabled() const;
 
+    /**
+     * @brief Returns the gain in f-stops, i.e: pixels are multiplied by 2^gain.
+     **/
+    double getGain() const;
+
+    double getGamma() const;
+
     ViewerColorSpaceEnum getColorspace() const;
 
     void setRefreshButtonDown(bool down);
@@ -208,6 +215,14 @@ public:
 
     QPointF getWipeCenter() const;
 
+    /**
+     * @brief With a wipe compositing operator, the B input is only displayed on one side of the wipe line.
+     * Returns in visibleRoI the bounding box of the part of roi (in canonical coordinates) where the image
+     * of the given viewer process is displayed, or false if it is not displayed at all in roi.
+     * The A input is always displayed in the whole roi.
+     **/
+    bool getWipeVisibleRoI(int viewerProcessIndex, const RectD& roi, RectD* visibleRoI) const;
+
     void resetWipe(); 
 
     bool isCheckerboardEnabled() const;
@@ -558,6 +558,16 @@ enum ImageBufferLayoutEnum
     // This is the preferred layout by default for OpenFX.
     // OpenGL textures only support this mode for now.
     eImageBufferLayoutRGBAPackedFullRect,
+
+    // This will make an image with an internal storage composed
+    // of a single buffer for each channel, organized in tiles of the size of the cache tiles
+    // for the bitdepth (see CacheBase::getTileSizePx). The tiles cover the bounds of the image
+    // rounded to the tile size and are stored one after another, row by row from the bottom-left tile.
+    // Each tile has exactly the memory layout of a tile in the cache, so that pixels are transferred
+    // to and from the cache with a single memcpy per tile.
+    // This can only be processed by functions that split their work on the tiles,
+    // see Image::getCPUTileData and ImageMultiThreadProcessorBase::alignRenderWindowToTiles
+    eImageBufferLayoutMonoChannelTiled,
 };
 
 enum RenderBackendTypeEnum
@@ -573,6 +583,23 @@ enum RenderBackendTypeEnum
     eRenderBackendTypeOSMesa
 };
 
+// The priority class of a render. The render tasks are started in the thread pool by decreasing priority, this is
+// passed as the priority to QThreadPool::start(). See RenderTaskDispatcher.
+enum RenderPriorityEnum
+{
+    // Previews, idle caching of the viewer and prefetching: nobody waits for these renders
+    eRenderPriorityIdle = 0,
+
+    // Render on disk
+    eRenderPriorityWrite,
+
+    // Tracking
+    eRenderPriorityTracking,
+
+    // Renders of the viewer and the other renders the user waits for, this is the default
+    eRenderPriorityInteractive
+};
+
 enum RenderScaleSupportEnum
 {
     eSupportsMaybe = -1, // We don't know yet if the effect supports render scale
@@ -584,7 +611,8 @@ enum StorageModeEnum
 {
     eStorageModeNone = 0, //< no memory will be allocated
     eStorageModeRAM, //< will be allocated in RAM using malloc or a malloc based implementation (such as std::vector) or mmap
-    eStorageModeGLTex //< will be allocated as an OpenGL texture
+    eStorageModeGLTex, //< will be allocated as an OpenGL texture
+    eStorageModeCudaBuffer //< will be allocated in the memory of a CUDA device, only to pass images to OpenFX plug-ins rendering with CUDA
 };
 
 enum OrientationEnum
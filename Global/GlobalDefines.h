@@ -102,6 +102,22 @@ typedef OfxRangeD RangeD;
 
 #define kBgProcessServerCreatedShort "--bg_server_created"
 
+///these are used between a render server and its clients, see RenderServer
+#define kRenderServerRenderJobShort "--render_job"
+
+#define kRenderServerJobFinishedShort "--job_finished"
+
+#define kRenderServerQuitShort "--quit"
+
+///these are used between a render coordinator and its workers, see RenderCoordinator
+#define kRenderFarmJobShort "--farm_job"
+
+#define kRenderFarmWorkerReadyShort "--farm_ready"
+
+#define kRenderFarmFrameShort "--farm_frame"
+
+#define kRenderFarmFrameFinishedShort "--farm_frame_finished"
+
 #define kNodeGraphObjectName "nodeGraph"
 #define kAnimationModuleEditorObjectName "animationModule"
 
@@ -36,6 +36,11 @@
 #define __NATRON_LINUX__
 #endif
 
+// SSE2 is part of the x86-64 baseline: it can be used without detecting it at runtime
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define __NATRON_SSE2__
+#endif
+
 #ifdef SBK_RUN
 
 // run shiboken without the Natron namespace, and add NATRON_NAMESPACE_USING to each cpp afterwards
@@ -64,6 +64,7 @@ ActionWithShortcut::ActionWithShortcut(const std::string & group,
     (void)QT_TR_NOOP(kShortcutActionShowAbout);
     (void)QT_TR_NOOP(kShortcutActionRenderSelected);
     (void)QT_TR_NOOP(kShortcutActionEnableRenderStats);
+    (void)QT_TR_NOOP(kShortcutActionRecordRenderTrace);
     (void)QT_TR_NOOP(kShortcutActionRenderAll);
     (void)QT_TR_NOOP(kShortcutActionConnectViewerToInput1);
     (void)QT_TR_NOOP(kShortcutActionConnectViewerToInput2);
@@ -264,6 +264,17 @@ AnimItemBase::evaluateCurve(bool /*useExpressionIfAny*/, double x, DimIdx dimens
    
 }
 
+void
+AnimItemBase::evaluateCurveAtTimes(bool /*useExpressionIfAny*/, const std::vector<TimeValue>& times, DimIdx dimension, ViewIdx view, std::vector<double>* values)
+{
+    CurvePtr curve = getCurve(dimension, view);
+    assert(curve);
+    if (!curve) {
+        throw std::runtime_error("Curve is null");
+    }
+    curve->getValuesAt(times, false /*doClamp*/, values);
+}
+
 KnobAnimPtr
 KnobsHolderAnimBase::findKnobAnim(const KnobIPtr& knob) const
 {
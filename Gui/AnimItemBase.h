@@ -191,6 +191,12 @@ public:
      **/
     virtual double evaluateCurve(bool useExpressionIfAny, double x, DimIdx dimension, ViewIdx view);
 
+    /**
+     * @brief Same as evaluateCurve for each time in times: values[i] is the Y value at times[i].
+     * The default implementation evaluates the curve at all times in a single call.
+     **/
+    virtual void evaluateCurveAtTimes(bool useExpressionIfAny, const std::vector<TimeValue>& times, DimIdx dimension, ViewIdx view, std::vector<double>* values);
+
     enum GetKeyframesTypeEnum
     {
         // If passing DimSpec::all() or ViewSetSpec::all(), only keyframes that
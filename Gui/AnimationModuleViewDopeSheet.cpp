@@ -358,24 +358,32 @@ AnimationModuleViewPrivate::drawDopeSheetScale() const
 } // drawDopeSheetScale
 
 
-void
+bool
 AnimationModuleViewPrivate::drawDopeSheetTreeItemRecursive(QTreeWidgetItem* item,  std::list<NodeAnimPtr>* nodesRowsOrdered) const
 {
     assert(item);
     if ( item->isHidden() ) {
-        return;
+        return true;
     }
 
     QTreeWidgetItem* parentItem = item->parent();
     if (parentItem && !parentItem->isExpanded()) {
-        return;
+        return true;
     }
 
+    // The rows are visited in the order of the tree view: once a row is below the view, all the next ones are too.
+    // Rows above the view are not drawn but their children may be visible.
+    QRect itemRect = treeView->visualItemRect(item);
+    if ( itemRect.top() > _publicInterface->height() ) {
+        return false;
+    }
+    bool rowVisible = itemRect.bottom() >= 0;
+
     AnimatedItemTypeEnum type = (AnimatedItemTypeEnum)item->data(0, QT_ROLE_CONTEXT_TYPE).toInt();
     void* ptr = item->data(0, QT_ROLE_CONTEXT_ITEM_POINTER).value<void*>();
     assert(ptr);
     if (!ptr) {
-        return;
+        return true;
     }
     DimSpec dimension = DimSpec(item->data(0, QT_ROLE_CONTEXT_DIM).toInt());
     ViewSetSpec view = ViewSetSpec(item->data(0, QT_ROLE_CONTEXT_VIEW).toInt());
@@ -403,7 +411,9 @@ AnimationModuleViewPrivate::drawDopeSheetTreeItemRecursive(QTreeWidgetItem* item
         }   break;
     }
 
-    if (isNodeAnim) {
+    if (!rowVisible) {
+        // Nothing to draw
+    } else if (isNodeAnim) {
         drawDopeSheetNodeRow(item, isNodeAnim);
         nodesRowsOrdered->push_back(isNodeAnim);
     } else if (isKnobAnim) {
@@ -415,9 +425,12 @@ AnimationModuleViewPrivate::drawDopeSheetTreeItemRecursive(QTreeWidgetItem* item
     int nChildren = item->childCount();
     for (int i = 0; i < nChildren; ++i) {
         QTreeWidgetItem* child = item->child(i);
-        drawDopeSheetTreeItemRecursive(child, nodesRowsOrdered);
+        if ( !drawDopeSheetTreeItemRecursive(child, nodesRowsOrdered) ) {
+            return false;
+        }
     }
 
+    return true;
 } // drawDopeSheetTreeItemRecursive
 
 void
@@ -436,8 +449,9 @@ AnimationModuleViewPrivate::drawDopeSheetRows() const
             if (!topLevelItem) {
                 continue;
             }
-            drawDopeSheetTreeItemRecursive(topLevelItem, &nodesAnimOrdered);
-            
+            if ( !drawDopeSheetTreeItemRecursive(topLevelItem, &nodesAnimOrdered) ) {
+                break;
+            }
         }
 
         // Draw node rows separations
@@ -717,6 +731,14 @@ AnimationModuleViewPrivate::drawDopeSheetKeyframes(QTreeWidgetItem* treeItem, co
         const TimeValue keyTime = it->key.getTime();
         RectD zoomKfRect = getKeyFrameBoundingRectCanonical(dopeSheetZoomContext, keyTime, rowCenterYCanonical);
 
+        // Skip the keyframes outside of the view. They are sorted by time.
+        if ( zoomKfRect.x2 < dopeSheetZoomContext.left() ) {
+            continue;
+        }
+        if ( zoomKfRect.x1 > dopeSheetZoomContext.right() ) {
+            break;
+        }
+
         bool isKeyFrameSelected = selectModel->isKeyframeSelected(item, dimension, view, TimeValue(keyTime));
         bool drawSelected = isKeyFrameSelected;
         if (!drawSelected) {
@@ -752,15 +774,7 @@ AnimationModuleViewPrivate::drawDopeSheetKeyframes(QTreeWidgetItem* treeItem, co
     } // for all keyframes
 
     // Draw selection highlight
-    bool itemSelected = false;
-    QList<QTreeWidgetItem*> selectedItems = animModel->getEditor()->getTreeView()->selectedItems();
-    for (QList<QTreeWidgetItem*>::const_iterator it = selectedItems.begin(); it!=selectedItems.end(); ++it) {
-        if (*it == treeItem) {
-            itemSelected = true;
-            break;
-        }
-    }
-    if (itemSelected) {
+    if ( treeItem->isSelected() ) {
         GL_GPU::Color4f(selectionColorRGB[0], selectionColorRGB[1], selectionColorRGB[2], 0.15);
 
         GL_GPU::Begin(GL_POLYGON);
@@ -164,7 +164,11 @@ public:
 
     void drawDopeSheetRows() const;
 
-    void drawDopeSheetTreeItemRecursive(QTreeWidgetItem* item, std::list<NodeAnimPtr>* nodesRowsOrdered) const;
+    /**
+     * @brief Draws the row of the given item and of its children, only if they are in the view.
+     * Returns false if the row is below the view, in which case the rows after it are not visible either.
+     **/
+    bool drawDopeSheetTreeItemRecursive(QTreeWidgetItem* item, std::list<NodeAnimPtr>* nodesRowsOrdered) const;
 
     void drawDopeSheetNodeRow(QTreeWidgetItem* treeItem, const NodeAnimPtr& item) const;
     void drawDopeSheetKnobRow(QTreeWidgetItem* treeItem, const KnobAnimPtr& item, DimSpec dimension, ViewSetSpec view) const;
@@ -25,6 +25,7 @@
 #include "CachedFramesThread.h"
 
 #include <map>
+#include <set>
 #include <QMutex>
 #include <QWaitCondition>
 
@@ -52,7 +53,19 @@ struct CachedFramesThread::Implementation
     ViewerTab* viewer;
 
     QMutex cachedFramesMutex;
-    std::list<TimeValue> cachedFrames;
+
+    // The frames cached, as ranges of consecutive frames
+    std::list<RangeD> cachedFrames;
+
+    // Only accessed by the thread: the frames in cachedFrames
+    std::set<TimeValue> cachedFramesSet;
+
+    // Only accessed by the thread: the hash of the viewer output of each frame found in the cache by the last refresh.
+    // These entries are not looked up in the cache again until the cache removes entries.
+    std::map<FrameViewPair, U64, FrameView_compare_less> knownCachedEntries;
+
+    // The value of CacheBase::getRemovedEntriesCount() when knownCachedEntries was last looked up
+    int lastRemovedEntriesCount;
 
     QMutex mustQuitMutex;
     QWaitCondition mustQuitCond;
@@ -65,6 +78,9 @@ struct CachedFramesThread::Implementation
     : viewer(viewer)
     , cachedFramesMutex()
     , cachedFrames()
+    , cachedFramesSet()
+    , knownCachedEntries()
+    , lastRemovedEntriesCount(0)
     , regulatingTimer()
     {
 
@@ -120,7 +136,7 @@ CachedFramesThread::quitThread()
 }
 
 void
-CachedFramesThread::getCachedFrames(std::list<TimeValue>* cachedFrames) const
+CachedFramesThread::getCachedFrames(std::list<RangeD>* cachedFrames) const
 {
     QMutexLocker k(&_imp->cachedFramesMutex);
     *cachedFrames = _imp->cachedFrames;
@@ -144,25 +160,32 @@ CachedFramesThread::Implementation::refreshCachedFramesInternal()
     // 1) Check the hash is still valid at that frame
     // 2) Check if the cache still has a tile entry for this frame
 
+    // Looking up the cache for each frame is expensive on large caches: only do it for frames that were not found
+    // in the cache last time or when the cache removed entries since then.
+    // The counter is read before the lookups so that entries removed meanwhile are looked up again on the next refresh.
+    CacheBasePtr cache = appPTR->getTileCache();
+    const int removedEntriesCount = cache->getRemovedEntriesCount();
+    const bool cacheRemovedEntries = removedEntriesCount != lastRemovedEntriesCount;
+    lastRemovedEntriesCount = removedEntriesCount;
 
-    std::set<TimeValue> existingCachedFrames;
+    std::map<FrameViewPair, U64, FrameView_compare_less> updatedKnownCachedEntries;
     std::set<TimeValue> updatedCachedFrames;
-    {
-        QMutexLocker k(&cachedFramesMutex);
-        for (std::list<TimeValue>::const_iterator it = cachedFrames.begin(); it!=cachedFrames.end(); ++it) {
-            existingCachedFrames.insert(*it);
-        }
-    }
-    bool hasChanged = false;
     for (ViewerCachedImagesMap::const_iterator it = framesDisplayed.begin(); it != framesDisplayed.end(); ++it) {
 
         bool isValid = true;
 
 
         // Check if it is still cached
+        U64 hash = it->second->getHash();
         {
-            U64 hash = it->second->getHash();
-            bool isCached = appPTR->getTileCache()->hasCacheEntryForHash(hash);
+            bool isCached = false;
+            if (!cacheRemovedEntries) {
+                std::map<FrameViewPair, U64, FrameView_compare_less>::const_iterator found = knownCachedEntries.find(it->first);
+                isCached = found != knownCachedEntries.end() && found->second == hash;
+            }
+            if (!isCached) {
+                isCached = cache->hasCacheEntryForHash(hash);
+            }
             if (!isCached) {
                 isValid = false;
 
@@ -189,35 +212,33 @@ CachedFramesThread::Implementation::refreshCachedFramesInternal()
         if (!isValid) {
             viewer->getViewer()->removeViewerProcessHashAtTime(it->first.time, it->first.view);
         } else {
+            updatedKnownCachedEntries[it->first] = hash;
             updatedCachedFrames.insert(it->first.time);
-            std::set<TimeValue>::iterator found = existingCachedFrames.find(it->first.time);
-            if (found == existingCachedFrames.end()) {
-                // We added a keyframe that didnt exist
-                hasChanged = true;
-            }
         }
 
     }
+    knownCachedEntries.swap(updatedKnownCachedEntries);
 
-    if (!hasChanged) {
-        // Check if we removed a keyframe that existed
-        for (std::set<TimeValue>::iterator it = existingCachedFrames.begin(); it != existingCachedFrames.end(); ++it) {
-            std::set<TimeValue>::iterator found = updatedCachedFrames.find(*it);
-            if (found == updatedCachedFrames.end()) {
-                // We removed a keyframe
-                hasChanged = true;
-                break;
-            }
+    if (updatedCachedFrames == cachedFramesSet) {
+        return false;
+    }
+    cachedFramesSet.swap(updatedCachedFrames);
+
+    // Merge consecutive frames into ranges: the timeline draws a line per range
+    std::list<RangeD> ranges;
+    for (std::set<TimeValue>::const_iterator it = cachedFramesSet.begin(); it != cachedFramesSet.end(); ++it) {
+        const double frame = (double)*it;
+        if ( !ranges.empty() && (ranges.back().max + 1 >= frame) ) {
+            ranges.back().max = frame;
+        } else {
+            RangeD range = {frame, frame};
+            ranges.push_back(range);
         }
     }
 
-    if (hasChanged) {
-        QMutexLocker k(&cachedFramesMutex);
-        cachedFrames.clear();
-        cachedFrames.insert(cachedFrames.end(),updatedCachedFrames.begin(), updatedCachedFrames.end());
-        return true;
-    }
-    return false;
+    QMutexLocker k(&cachedFramesMutex);
+    cachedFrames.swap(ranges);
+    return true;
 
 } // refreshCachedFramesInternal
 
@@ -37,6 +37,8 @@
 #include <boost/scoped_ptr.hpp>
 #endif
 
+#include "Global/GlobalDefines.h"
+
 #include "Engine/TimeValue.h"
 
 NATRON_NAMESPACE_ENTER;
@@ -53,7 +55,10 @@ public:
 
     virtual ~CachedFramesThread();
 
-    void getCachedFrames(std::list<TimeValue>* cachedFrames) const;
+    /**
+     * @brief Returns the frames of the viewer that are cached, as ranges of consecutive frames.
+     **/
+    void getCachedFrames(std::list<RangeD>* cachedFrames) const;
 
     void quitThread();
 
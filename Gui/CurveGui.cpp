@@ -35,6 +35,8 @@
 #include <QtCore/QDebug>
 
 #include <QTreeWidgetItem>
+#include <QtConcurrentRun> // QtCore on Qt4, QtConcurrent on Qt5
+#include <QtCore/QFutureWatcher>
 
 #include "Engine/Curve.h"
 #include "Engine/KnobTypes.h"
@@ -56,6 +58,10 @@ NATRON_NAMESPACE_ENTER;
 #define NATRON_NO_PREDEFINED_CURVE_COLORS 6
 #define NATRON_NO_PREDEFINED_CURVE_SATURATION 220
 #define NATRON_NO_PREDEFINED_CURVE_VALUE 150
+
+// Curves with at least this number of keyframes are re-sampled in a background thread when the view changes,
+// the previous line strip is drawn in the meantime
+#define NATRON_CURVE_BACKGROUND_SAMPLING_MIN_KEYFRAMES 500
 static const OfxRGBColourD curveColors[NATRON_NO_PREDEFINED_CURVE_COLORS] =
 {
     // h s v
@@ -67,6 +73,310 @@ static const OfxRGBColourD curveColors[NATRON_NO_PREDEFINED_CURVE_COLORS] =
     {300, NATRON_NO_PREDEFINED_CURVE_SATURATION, NATRON_NO_PREDEFINED_CURVE_VALUE}
 };
 
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+/**
+ * @brief Identifies the line strip drawn for the keyframes of a curve: it must be sampled again
+ * when the keyframes, the horizontal zoom or the vertical scale change, but not when the view is panned vertically.
+ **/
+struct CurvePolylineKey
+{
+    // The keyframes pointer is shared until the curve is modified, see Curve::getKeyFramesSnapshot_mt_safe()
+    KeyFrameSetConstPtr keyframes;
+    double zoomLeft, pixelWidth, pixelHeight, screenWidth;
+
+    CurvePolylineKey()
+    : keyframes()
+    , zoomLeft(0)
+    , pixelWidth(0)
+    , pixelHeight(0)
+    , screenWidth(0)
+    {
+
+    }
+
+    bool operator==(const CurvePolylineKey& other) const
+    {
+        return keyframes == other.keyframes && zoomLeft == other.zoomLeft && pixelWidth == other.pixelWidth &&
+               pixelHeight == other.pixelHeight && screenWidth == other.screenWidth;
+    }
+};
+
+struct CurvePolyline
+{
+    CurvePolylineKey key;
+
+    // The line strip, in curve coordinates
+    std::vector<float> vertices;
+};
+
+/**
+ * @brief A copy of everything sampleCurvePolyline() needs so that it can run in a background thread
+ **/
+struct CurvePolylineSamplingArgs
+{
+    CurvePolylineKey key;
+    ZoomContext zoomCtx;
+    CurveSnapshotConstPtr curve;
+    bool isPeriodic;
+    double parametricXMin, parametricXMax;
+};
+
+void
+nextPointForSegment(const ZoomContext& zoomCtx,
+                    const double x, // < in curve coordinates
+                    const KeyFrameSet & keys,
+                    const bool isPeriodic,
+                    const double parametricXMin,
+                    const double parametricXMax,
+                    KeyFrameSet::const_iterator* lastUpperIt,
+                    double* x2WidgetCoords,
+                    KeyFrame* x1Key,
+                    bool* isx1Key)
+{
+    assert( !keys.empty() );
+
+    *isx1Key = false;
+
+    // If non periodic and out of curve range, draw straight lines from widget border to
+    // the keyframe on the side
+    if (!isPeriodic && x < keys.begin()->getTime()) {
+        *x2WidgetCoords = zoomCtx.toWidgetCoordinates(keys.begin()->getTime(), 0).x();
+        *x1Key = *keys.begin();
+        *isx1Key = true;
+        return;
+    } else if (!isPeriodic && x >= keys.rbegin()->getTime()) {
+        *x2WidgetCoords = zoomCtx.screenWidth() - 1;
+        return;
+    }
+
+
+
+    // We're between 2 keyframes or the curve is periodic, get the upper and lower keyframes widget coordinates
+
+    // Points to the first keyframe with a greater time (in widget coords) than x1
+    KeyFrameSet::const_iterator upperIt = keys.end();
+
+    // If periodic, bring back x in the period range (in widget coordinates)
+    double xClamped = x;
+    double period = parametricXMax - parametricXMin;
+
+    {
+        //KeyFrameSet::const_iterator start = keys.begin();
+        const double xMin = parametricXMin;// + start->getTime();
+        const double xMax = parametricXMax;// + start->getTime();
+        if ((x < xMin || x > xMax) && isPeriodic) {
+            xClamped = std::fmod(x - xMin, period) + parametricXMin;
+            if (xClamped < xMin) {
+                xClamped += period;
+            }
+            assert(xClamped >= xMin && xClamped <= xMax);
+        }
+    }
+    {
+
+        KeyFrameSet::const_iterator itKeys = keys.begin();
+
+        if ( *lastUpperIt != keys.end() ) {
+            // If we already have called this function before, start from the previously
+            // computed iterator to avoid n square complexity
+            itKeys = *lastUpperIt;
+        } else {
+            // Otherwise start from the begining
+            itKeys = keys.begin();
+        }
+        *lastUpperIt = keys.end();
+        for (; itKeys != keys.end(); ++itKeys) {
+            if (itKeys->getTime() > xClamped) {
+                upperIt = itKeys;
+                *lastUpperIt = upperIt;
+                break;
+            }
+        }
+    }
+
+    double tprev, vprev, vprevDerivRight, tnext, vnext, vnextDerivLeft;
+    if ( upperIt == keys.end() ) {
+        // We are in a periodic curve: we are in-between the last keyframe and the parametric xMax
+        // If the curve is non periodic, it should have been handled in the 2 cases above: we only draw a straightline
+        // from the widget border to the first/last keyframe
+        assert(isPeriodic);
+        KeyFrameSet::const_iterator start = keys.begin();
+        KeyFrameSet::const_reverse_iterator last = keys.rbegin();
+        tprev = last->getTime();
+        vprev = last->getValue();
+        vprevDerivRight = last->getRightDerivative();
+        tnext = std::fmod(last->getTime() - start->getTime(), period) + tprev;
+        //xClamped += period;
+        vnext = start->getValue();
+        vnextDerivLeft = start->getLeftDerivative();
+
+    } else if ( upperIt == keys.begin() ) {
+        // We are in a periodic curve: we are in-between the parametric xMin and the first keyframe
+        // If the curve is non periodic, it should have been handled in the 2 cases above: we only draw a straightline
+        // from the widget border to the first/last keyframe
+        assert(isPeriodic);
+        KeyFrameSet::const_reverse_iterator last = keys.rbegin();
+        tprev = last->getTime();
+        //xClamped -= period;
+        vprev = last->getValue();
+        vprevDerivRight = last->getRightDerivative();
+        tnext = std::fmod(last->getTime() - upperIt->getTime(), period) + tprev;
+        vnext = upperIt->getValue();
+        vnextDerivLeft = upperIt->getLeftDerivative();
+
+    } else {
+        // in-between 2 keyframes
+        KeyFrameSet::const_iterator prev = upperIt;
+        --prev;
+        tprev = prev->getTime();
+        vprev = prev->getValue();
+        vprevDerivRight = prev->getRightDerivative();
+        tnext = upperIt->getTime();
+        vnext = upperIt->getValue();
+        vnextDerivLeft = upperIt->getLeftDerivative();
+    }
+    double normalizeTimeRange = tnext - tprev;
+    if (normalizeTimeRange == 0) {
+        // Only 1 keyframe, draw a horizontal line
+        *x2WidgetCoords = zoomCtx.screenWidth() - 1;
+        return;
+    }
+    assert(normalizeTimeRange > 0.);
+
+    double t = ( xClamped - tprev ) / normalizeTimeRange;
+    double P3 = vnext;
+    double P0 = vprev;
+    // Hermite coefficients P0' and P3' are for t normalized in [0,1]
+    double P3pl = vnextDerivLeft / normalizeTimeRange; // normalize for t \in [0,1]
+    double P0pr = vprevDerivRight / normalizeTimeRange; // normalize for t \in [0,1]
+    double secondDer = 6. * (1. - t) * (P3 - P3pl / 3. - P0 - 2. * P0pr / 3.) +
+    6. * t * (P0 - P3 + 2 * P3pl / 3. + P0pr / 3. );
+
+    // This is a difference of values: it only depends on the vertical scale, not on the vertical position of the view
+    double secondDerWidgetCoord = zoomCtx.toWidgetCoordinates(0, secondDer).y() - zoomCtx.toWidgetCoordinates(0, 0).y();
+    double normalizedSecondDerWidgetCoord = std::abs(secondDerWidgetCoord / normalizeTimeRange);
+
+    // compute delta_x so that the y difference between the derivative and the curve is at most
+    // 1 pixel (use the second order Taylor expansion of the function)
+    double delta_x = std::max(2. / std::max(std::sqrt(normalizedSecondDerWidgetCoord), 0.1), 1.);
+
+    // The x widget coordinate of the next keyframe
+    double tNextWidgetCoords = zoomCtx.toWidgetCoordinates(tnext, 0).x();
+
+    // The widget coordinate of the x passed in parameter but clamped to the curve period
+    double xClampedWidgetCoords = zoomCtx.toWidgetCoordinates(xClamped, 0).x();
+
+    // The real x passed in parameter in widget coordinates
+    double xWidgetCoords = zoomCtx.toWidgetCoordinates(x, 0).x();
+
+    double x2ClampedWidgetCoords = xClampedWidgetCoords + delta_x;
+
+    double deltaXtoNext = (tNextWidgetCoords - xClampedWidgetCoords);
+    // If nearby next key, clamp to it
+    if (x2ClampedWidgetCoords > tNextWidgetCoords && deltaXtoNext > 1e-6) {
+        // x2 is the position of the next keyframe with the period removed
+        *x2WidgetCoords = xWidgetCoords + deltaXtoNext;
+        x1Key->setValue(vnext);
+        x1Key->setTime(TimeValue(x + (tnext - xClamped)));
+        *isx1Key = true;
+    } else {
+        // just add the delta to the x widget coord
+        *x2WidgetCoords = xWidgetCoords + delta_x;
+    }
+
+} // nextPointForSegment
+
+/**
+ * @brief When zoomed out, dense curves (e.g: a track with a keyframe at each frame) have many vertices in each pixel column.
+ * Only keep the first, lowest, highest and last vertices of each column: the line strip covers the same pixels.
+ **/
+void
+decimatePolyline(double zoomLeft,
+                 double pixelWidth,
+                 std::vector<float>* vertices)
+{
+    const std::vector<float>& src = *vertices;
+    const std::size_t nVertices = src.size() / 2;
+    std::vector<float> ret;
+    ret.reserve( src.size() );
+
+    std::size_t i = 0;
+    while (i < nVertices) {
+        const double column = std::floor( (src[2 * i] - zoomLeft) / pixelWidth );
+        std::size_t lowest = i, highest = i, last = i;
+        for (std::size_t j = i + 1; j < nVertices && std::floor( (src[2 * j] - zoomLeft) / pixelWidth ) == column; ++j) {
+            last = j;
+            if (src[2 * j + 1] < src[2 * lowest + 1]) {
+                lowest = j;
+            }
+            if (src[2 * j + 1] > src[2 * highest + 1]) {
+                highest = j;
+            }
+        }
+        const std::size_t kept[4] = {i, std::min(lowest, highest), std::max(lowest, highest), last};
+        for (int k = 0; k < 4; ++k) {
+            if ( (k == 0) || (kept[k] != kept[k - 1]) ) {
+                ret.push_back(src[2 * kept[k]]);
+                ret.push_back(src[2 * kept[k] + 1]);
+            }
+        }
+        i = last + 1;
+    }
+    vertices->swap(ret);
+} // decimatePolyline
+
+/**
+ * @brief Samples the line strip of an animated curve with one vertex every few pixels, depending on the curvature.
+ * This only uses the copies held by args and may run in any thread.
+ **/
+CurvePolyline
+sampleCurvePolyline(const CurvePolylineSamplingArgs& args)
+{
+    CurvePolyline ret;
+    ret.key = args.key;
+
+    const KeyFrameSet& keyframes = *args.key.keyframes;
+    std::vector<float>& vertices = ret.vertices;
+    const double widgetWidth = args.zoomCtx.screenWidth();
+
+    double x1 = 0;
+    double x2;
+
+    bool isX1AKey = false;
+    KeyFrame x1Key;
+    KeyFrameSet::const_iterator lastUpperIt = keyframes.end();
+
+    while ( x1 < (widgetWidth - 1) ) {
+        double x, y;
+        if (!isX1AKey) {
+            x = args.zoomCtx.toZoomCoordinates(x1, 0).x();
+            y = args.curve->getValueAt(TimeValue(x), false /*doClamp*/);
+        } else {
+            x = x1Key.getTime();
+            y = x1Key.getValue();
+        }
+
+        vertices.push_back( (float)x );
+        vertices.push_back( (float)y );
+        nextPointForSegment(args.zoomCtx, x, keyframes, args.isPeriodic, args.parametricXMin, args.parametricXMax,  &lastUpperIt, &x2, &x1Key, &isX1AKey);
+        x1 = x2;
+    }
+    //also add the last point
+    {
+        double x = args.zoomCtx.toZoomCoordinates(x1, 0).x();
+        double y = args.curve->getValueAt(TimeValue(x), false /*doClamp*/);
+        vertices.push_back( (float)x );
+        vertices.push_back( (float)y );
+    }
+
+    decimatePolyline(args.key.zoomLeft, args.key.pixelWidth, &vertices);
+
+    return ret;
+} // sampleCurvePolyline
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
 struct CurveGuiPrivate
 {
     AnimationModuleView* curveWidget;
@@ -78,6 +388,14 @@ struct CurveGuiPrivate
     double color[4]; // the color that must be used to draw the curve
     int lineWidth; // its thickness
 
+    // The last line strip sampled for the keyframes of the curve
+    CurvePolyline polyline;
+    bool polylineValid;
+
+    // Watches the re-sampling of dense curves in a background thread
+    boost::scoped_ptr<QFutureWatcher<CurvePolyline> > samplingWatcher;
+    bool samplingRunning;
+
     CurveGuiPrivate(AnimationModuleView *curveWidget,
                     const AnimItemBasePtr& item, DimIdx dimension, ViewIdx view)
     : curveWidget(curveWidget)
@@ -87,6 +405,10 @@ struct CurveGuiPrivate
     , internalCurve()
     , color()
     , lineWidth(1.)
+    , polyline()
+    , polylineValid(false)
+    , samplingWatcher()
+    , samplingRunning(false)
     {
 
         QColor tmpColor;
@@ -102,8 +424,42 @@ struct CurveGuiPrivate
         assert(internalCurve.lock());
 
     }
+
+    /**
+     * @brief Makes polyline up to date with the given args, or starts re-sampling it in a background thread
+     * in which case the previous polyline should be drawn until the view is redrawn once it is done.
+     **/
+    void refreshPolyline(const CurvePolylineSamplingArgs& args);
 };
 
+void
+CurveGuiPrivate::refreshPolyline(const CurvePolylineSamplingArgs& args)
+{
+    if ( samplingRunning && samplingWatcher->isFinished() ) {
+        samplingRunning = false;
+        polyline = samplingWatcher->result();
+        polylineValid = true;
+    }
+    if ( polylineValid && (polyline.key == args.key) ) {
+        return;
+    }
+    if (samplingRunning) {
+        // The view will be redrawn when it is done and a new sampling started then if needed
+        return;
+    }
+    if ( polylineValid && (args.key.keyframes->size() >= NATRON_CURVE_BACKGROUND_SAMPLING_MIN_KEYFRAMES) ) {
+        if (!samplingWatcher) {
+            samplingWatcher.reset(new QFutureWatcher<CurvePolyline>);
+            QObject::connect( samplingWatcher.get(), SIGNAL(finished()), curveWidget, SLOT(update()) );
+        }
+        samplingWatcher->setFuture( QtConcurrent::run(sampleCurvePolyline, args) );
+        samplingRunning = true;
+        return;
+    }
+    polyline = sampleCurvePolyline(args);
+    polylineValid = true;
+} // refreshPolyline
+
 CurveGui::CurveGui(AnimationModuleView *curveWidget,
                    const AnimItemBasePtr& item, DimIdx dimension, ViewIdx view)
 : _imp(new CurveGuiPrivate(curveWidget, item, dimension, view))
@@ -234,6 +590,22 @@ CurveGui::evaluate(bool useExpr, double x) const
     }
 }
 
+void
+CurveGui::evaluateAtTimes(bool useExpr,
+                          const std::vector<TimeValue>& times,
+                          std::vector<double>* values) const
+{
+    AnimItemBasePtr item = _imp->item.lock();
+    if (item) {
+        try {
+            item->evaluateCurveAtTimes(useExpr, times, _imp->dimension, _imp->view, values);
+            return;
+        } catch (...) {
+        }
+    }
+    values->assign(times.size(), 0.);
+}
+
 int
 CurveGui::getKeyFrameIndex(TimeValue time) const
 {
@@ -248,172 +620,6 @@ CurveGui::setKeyFrameInterpolation(KeyframeTypeEnum interp,
 }
 
 
-void
-CurveGui::nextPointForSegment(const double x, // < in curve coordinates
-                              const KeyFrameSet & keys,
-                              const bool isPeriodic,
-                              const double parametricXMin,
-                              const double parametricXMax,
-                              KeyFrameSet::const_iterator* lastUpperIt,
-                              double* x2WidgetCoords,
-                              KeyFrame* x1Key,
-                              bool* isx1Key)
-{
-    // always running in the main thread
-    assert( qApp && qApp->thread() == QThread::currentThread() );
-    assert( !keys.empty() );
-
-    *isx1Key = false;
-
-    // If non periodic and out of curve range, draw straight lines from widget border to
-    // the keyframe on the side
-    if (!isPeriodic && x < keys.begin()->getTime()) {
-        *x2WidgetCoords = keys.begin()->getTime();
-        double y;
-        _imp->curveWidget->toWidgetCoordinates(x2WidgetCoords, &y);
-        *x1Key = *keys.begin();
-        *isx1Key = true;
-        return;
-    } else if (!isPeriodic && x >= keys.rbegin()->getTime()) {
-        *x2WidgetCoords = _imp->curveWidget->width() - 1;
-        return;
-    }
-
-
-
-    // We're between 2 keyframes or the curve is periodic, get the upper and lower keyframes widget coordinates
-
-    // Points to the first keyframe with a greater time (in widget coords) than x1
-    KeyFrameSet::const_iterator upperIt = keys.end();
-
-    // If periodic, bring back x in the period range (in widget coordinates)
-    double xClamped = x;
-    double period = parametricXMax - parametricXMin;
-
-    {
-        //KeyFrameSet::const_iterator start = keys.begin();
-        const double xMin = parametricXMin;// + start->getTime();
-        const double xMax = parametricXMax;// + start->getTime();
-        if ((x < xMin || x > xMax) && isPeriodic) {
-            xClamped = std::fmod(x - xMin, period) + parametricXMin;
-            if (xClamped < xMin) {
-                xClamped += period;
-            }
-            assert(xClamped >= xMin && xClamped <= xMax);
-        }
-    }
-    {
-
-        KeyFrameSet::const_iterator itKeys = keys.begin();
-
-        if ( *lastUpperIt != keys.end() ) {
-            // If we already have called this function before, start from the previously
-            // computed iterator to avoid n square complexity
-            itKeys = *lastUpperIt;
-        } else {
-            // Otherwise start from the begining
-            itKeys = keys.begin();
-        }
-        *lastUpperIt = keys.end();
-        for (; itKeys != keys.end(); ++itKeys) {
-            if (itKeys->getTime() > xClamped) {
-                upperIt = itKeys;
-                *lastUpperIt = upperIt;
-                break;
-            }
-        }
-    }
-
-    double tprev, vprev, vprevDerivRight, tnext, vnext, vnextDerivLeft;
-    if ( upperIt == keys.end() ) {
-        // We are in a periodic curve: we are in-between the last keyframe and the parametric xMax
-        // If the curve is non periodic, it should have been handled in the 2 cases above: we only draw a straightline
-        // from the widget border to the first/last keyframe
-        assert(isPeriodic);
-        KeyFrameSet::const_iterator start = keys.begin();
-        KeyFrameSet::const_reverse_iterator last = keys.rbegin();
-        tprev = last->getTime();
-        vprev = last->getValue();
-        vprevDerivRight = last->getRightDerivative();
-        tnext = std::fmod(last->getTime() - start->getTime(), period) + tprev;
-        //xClamped += period;
-        vnext = start->getValue();
-        vnextDerivLeft = start->getLeftDerivative();
-
-    } else if ( upperIt == keys.begin() ) {
-        // We are in a periodic curve: we are in-between the parametric xMin and the first keyframe
-        // If the curve is non periodic, it should have been handled in the 2 cases above: we only draw a straightline
-        // from the widget border to the first/last keyframe
-        assert(isPeriodic);
-        KeyFrameSet::const_reverse_iterator last = keys.rbegin();
-        tprev = last->getTime();
-        //xClamped -= period;
-        vprev = last->getValue();
-        vprevDerivRight = last->getRightDerivative();
-        tnext = std::fmod(last->getTime() - upperIt->getTime(), period) + tprev;
-        vnext = upperIt->getValue();
-        vnextDerivLeft = upperIt->getLeftDerivative();
-
-    } else {
-        // in-between 2 keyframes
-        KeyFrameSet::const_iterator prev = upperIt;
-        --prev;
-        tprev = prev->getTime();
-        vprev = prev->getValue();
-        vprevDerivRight = prev->getRightDerivative();
-        tnext = upperIt->getTime();
-        vnext = upperIt->getValue();
-        vnextDerivLeft = upperIt->getLeftDerivative();
-    }
-    double normalizeTimeRange = tnext - tprev;
-    if (normalizeTimeRange == 0) {
-        // Only 1 keyframe, draw a horizontal line
-        *x2WidgetCoords = _imp->curveWidget->width() - 1;
-        return;
-    }
-    assert(normalizeTimeRange > 0.);
-
-    double t = ( xClamped - tprev ) / normalizeTimeRange;
-    double P3 = vnext;
-    double P0 = vprev;
-    // Hermite coefficients P0' and P3' are for t normalized in [0,1]
-    double P3pl = vnextDerivLeft / normalizeTimeRange; // normalize for t \in [0,1]
-    double P0pr = vprevDerivRight / normalizeTimeRange; // normalize for t \in [0,1]
-    double secondDer = 6. * (1. - t) * (P3 - P3pl / 3. - P0 - 2. * P0pr / 3.) +
-    6. * t * (P0 - P3 + 2 * P3pl / 3. + P0pr / 3. );
-
-    double secondDerWidgetCoord = _imp->curveWidget->toWidgetCoordinates(0, secondDer).y();
-    double normalizedSecondDerWidgetCoord = std::abs(secondDerWidgetCoord / normalizeTimeRange);
-
-    // compute delta_x so that the y difference between the derivative and the curve is at most
-    // 1 pixel (use the second order Taylor expansion of the function)
-    double delta_x = std::max(2. / std::max(std::sqrt(normalizedSecondDerWidgetCoord), 0.1), 1.);
-
-    // The x widget coordinate of the next keyframe
-    double tNextWidgetCoords = _imp->curveWidget->toWidgetCoordinates(tnext, 0).x();
-
-    // The widget coordinate of the x passed in parameter but clamped to the curve period
-    double xClampedWidgetCoords = _imp->curveWidget->toWidgetCoordinates(xClamped, 0).x();
-
-    // The real x passed in parameter in widget coordinates
-    double xWidgetCoords = _imp->curveWidget->toWidgetCoordinates(x, 0).x();
-
-    double x2ClampedWidgetCoords = xClampedWidgetCoords + delta_x;
-
-    double deltaXtoNext = (tNextWidgetCoords - xClampedWidgetCoords);
-    // If nearby next key, clamp to it
-    if (x2ClampedWidgetCoords > tNextWidgetCoords && deltaXtoNext > 1e-6) {
-        // x2 is the position of the next keyframe with the period removed
-        *x2WidgetCoords = xWidgetCoords + deltaXtoNext;
-        x1Key->setValue(vnext);
-        x1Key->setTime(TimeValue(x + (tnext - xClamped)));
-        *isx1Key = true;
-    } else {
-        // just add the delta to the x widget coord
-        *x2WidgetCoords = xWidgetCoords + delta_x;
-    }
-
-} // nextPointForSegment
 
 
 
@@ -492,16 +698,19 @@ CurveGui::drawCurve(int curveIndex,
 
     std::vector<float> vertices, exprVertices;
     const double widgetWidth = _imp->curveWidget->width();
-    KeyFrameSet keyframes;
     bool hasDrawnExpr = false;
     if (item->hasExpression(_imp->dimension, _imp->view)) {
 
         //we have no choice but to evaluate the expression at each time
+        std::vector<TimeValue> times;
         for (int i = 0; i < widgetWidth; ++i) {
-            double x = _imp->curveWidget->toZoomCoordinates(i, 0).x();
-            double y = evaluate(true /*useExpr*/, x);
-            exprVertices.push_back(x);
-            exprVertices.push_back(y);
+            times.push_back( TimeValue( _imp->curveWidget->toZoomCoordinates(i, 0).x() ) );
+        }
+        std::vector<double> values;
+        evaluateAtTimes(true /*useExpr*/, times, &values);
+        for (std::size_t i = 0; i < times.size(); ++i) {
+            exprVertices.push_back(times[i]);
+            exprVertices.push_back(values[i]);
         }
         hasDrawnExpr = true;
 
@@ -517,9 +726,11 @@ CurveGui::drawCurve(int curveIndex,
     bool isPeriodic = false;
     std::pair<double,double> parametricRange = std::make_pair(-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
 
-    keyframes = getInternalCurve()->getKeyFrames_mt_safe();
-    isPeriodic = getInternalCurve()->isCurvePeriodic();
-    parametricRange = getInternalCurve()->getXRange();
+    CurvePtr internalCurve = getInternalCurve();
+    KeyFrameSetConstPtr keyframesPtr = internalCurve->getKeyFramesSnapshot_mt_safe();
+    const KeyFrameSet& keyframes = *keyframesPtr;
+    isPeriodic = internalCurve->isCurvePeriodic();
+    parametricRange = internalCurve->getXRange();
 
     if ( keyframes.empty() ) {
         // Add a horizontal line for constant knobs, except string knobs.
@@ -536,38 +747,20 @@ CurveGui::drawCurve(int curveIndex,
             }
         }
     } else {
-        try {
-            double x1 = 0;
-            double x2;
-
-            bool isX1AKey = false;
-            KeyFrame x1Key;
-            KeyFrameSet::const_iterator lastUpperIt = keyframes.end();
-
-            while ( x1 < (widgetWidth - 1) ) {
-                double x, y;
-                if (!isX1AKey) {
-                    x = _imp->curveWidget->toZoomCoordinates(x1, 0).x();
-                    y = evaluate(false, x);
-                } else {
-                    x = x1Key.getTime();
-                    y = x1Key.getValue();
-                }
-
-                vertices.push_back( (float)x );
-                vertices.push_back( (float)y );
-                nextPointForSegment(x, keyframes, isPeriodic, parametricRange.first, parametricRange.second,  &lastUpperIt, &x2, &x1Key, &isX1AKey);
-                x1 = x2;
-            }
-            //also add the last point
-            {
-                double x = _imp->curveWidget->toZoomCoordinates(x1, 0).x();
-                double y = evaluate(false, x);
-                vertices.push_back( (float)x );
-                vertices.push_back( (float)y );
-            }
-        } catch (...) {
-        }
+        const ZoomContext& zoomCtx = _imp->curveWidget->_imp->curveEditorZoomContext;
+        CurvePolylineSamplingArgs args;
+        args.key.keyframes = keyframesPtr;
+        args.key.zoomLeft = zoomCtx.left();
+        args.key.pixelWidth = zoomCtx.screenPixelWidth();
+        args.key.pixelHeight = zoomCtx.screenPixelHeight();
+        args.key.screenWidth = zoomCtx.screenWidth();
+        args.zoomCtx = zoomCtx;
+        args.curve = internalCurve->createEvaluationSnapshot();
+        args.isPeriodic = isPeriodic;
+        args.parametricXMin = parametricRange.first;
+        args.parametricXMax = parametricRange.second;
+        _imp->refreshPolyline(args);
+        vertices = _imp->polyline.vertices;
     }
 
     // No Expr curve or no vertices for the curve, don't draw anything else
@@ -84,6 +84,11 @@ public:
      **/
     double evaluate(bool useExpr, double x) const;
 
+    /**
+     * @brief Same as evaluate() for each time in times: values[i] is the y position at times[i].
+     **/
+    void evaluateAtTimes(bool useExpr, const std::vector<TimeValue>& times, std::vector<double>* values) const;
+
     CurvePtr getInternalCurve() const;
 
     void drawCurve(int curveIndex, int curvesCount);
@@ -104,19 +109,6 @@ public:
 
     KeyFrame setKeyFrameInterpolation(KeyframeTypeEnum interp, int index);
 
-private:
-
-    void nextPointForSegment(const double x,
-                             const KeyFrameSet & keyframes,
-                             const bool isPeriodic,
-                             const double parametricXMin,
-                             const double parametricXMax,
-                             KeyFrameSet::const_iterator* lastUpperIt,
-                             double* x2,
-                             KeyFrame* key,
-                             bool* isKey );
-
-
 private:
 
     boost::scoped_ptr<CurveGuiPrivate> _imp;
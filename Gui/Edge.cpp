@@ -31,6 +31,7 @@
 #include <QPainter>
 #include <QApplication>
 #include <QGraphicsScene>
+#include <QStyleOptionGraphicsItem>
 
 #include "Gui/NodeGui.h"
 #include "Gui/NodeGraph.h"
@@ -57,6 +58,9 @@
 #define ARROW_SIZE_DISCONNECTED 10
 #define ARROW_HEAD_ANGLE ( (2 * M_PI) / 15 ) // 24 degrees opening angle is a nice thin arrow
 
+// Below this scale of the edge on the device, only a solid line is drawn, without antialiasing
+#define EDGE_MIN_DETAIL_LOD 0.4
+
 // number of offset pixels from the arrow that determine if a click is contained in the arrow or not
 #define kGraphicalContainerOffset 10
 
@@ -725,16 +729,9 @@ Edge::isNearbyBendPoint(const QPointF & scenePoint)
 
 void
 Edge::paint(QPainter *painter,
-            const QStyleOptionGraphicsItem * /*options*/,
+            const QStyleOptionGraphicsItem *options,
             QWidget * /*parent*/)
 {
-    bool antialias = appPTR->getCurrentSettings()->isNodeGraphAntiAliasingEnabled();
-
-    if (!antialias) {
-        painter->setRenderHint(QPainter::Antialiasing, false);
-    }
-
-    QPen myPen = pen();
     NodeGuiPtr dst = _imp->dest.lock();
     if (dst) {
         if ( dst->getDagGui()->isDoingNavigatorRender() ) {
@@ -742,7 +739,16 @@ Edge::paint(QPainter *painter,
         }
     }
 
-    if (_imp->paintWithDash) {
+    // When the graph is zoomed out, the dash, the arrow head and the bend point would be a few pixels wide
+    bool lowDetail = options->levelOfDetailFromTransform( painter->worldTransform() ) < EDGE_MIN_DETAIL_LOD;
+    bool antialias = !lowDetail && appPTR->getCurrentSettings()->isNodeGraphAntiAliasingEnabled();
+
+    if (!antialias) {
+        painter->setRenderHint(QPainter::Antialiasing, false);
+    }
+
+    QPen myPen = pen();
+    if (_imp->paintWithDash && !lowDetail) {
         QVector<qreal> dashStyle;
         qreal space = 4;
         dashStyle << 3 << space;
@@ -768,6 +774,10 @@ Edge::paint(QPainter *painter,
 
     painter->drawLine( line() );
 
+    if (lowDetail) {
+        return;
+    }
+
     myPen.setStyle(Qt::SolidLine);
     painter->setPen(myPen);
 
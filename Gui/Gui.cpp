@@ -493,6 +493,11 @@ Gui::createMenuActions()
     _imp->enableRenderStats->setChecked(false);
     QObject::connect( _imp->enableRenderStats, SIGNAL(triggered()), this, SLOT(onEnableRenderStatsActionTriggered()) );
 
+    _imp->recordRenderTrace = new ActionWithShortcut(kShortcutGroupGlobal, kShortcutActionRecordRenderTrace, kShortcutActionRecordRenderTraceLabel, this);
+    _imp->recordRenderTrace->setCheckable(true);
+    _imp->recordRenderTrace->setChecked(false);
+    QObject::connect( _imp->recordRenderTrace, SIGNAL(triggered()), this, SLOT(onRecordRenderTraceActionTriggered()) );
+
     for (int c = 0; c < NATRON_MAX_RECENT_FILES; ++c) {
         _imp->actionsOpenRecentFile[c] = new QAction(this);
         _imp->actionsOpenRecentFile[c]->setVisible(false);
@@ -635,6 +640,7 @@ Gui::createMenuActions()
     _imp->menuRender->addAction(_imp->renderAllWriters);
     _imp->menuRender->addAction(_imp->renderSelectedNode);
     _imp->menuRender->addAction(_imp->enableRenderStats);
+    _imp->menuRender->addAction(_imp->recordRenderTrace);
 
     _imp->cacheMenu->addAction(_imp->actionShowCacheReport);
     _imp->cacheMenu->addAction(_imp->actionClearAllCaches);
@@ -643,6 +643,8 @@ public Q_SLOTS:
 
     void onEnableRenderStatsActionTriggered();
 
+    void onRecordRenderTraceActionTriggered();
+
     void onMaxVisibleDockablePanelChanged(int maxPanels);
 
     void clearAllVisiblePanels();
@@ -53,6 +53,7 @@
 #include "Engine/ProcessHandler.h"
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/RenderQueue.h"
+#include "Engine/RenderTrace.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/ViewerInstance.h"
 #include "Engine/ViewerNode.h"
@@ -819,6 +820,28 @@ Gui::onEnableRenderStatsActionTriggered()
     }
 }
 
+void
+Gui::onRecordRenderTraceActionTriggered()
+{
+    assert( QThread::currentThread() == qApp->thread() );
+
+    if ( _imp->recordRenderTrace->isChecked() ) {
+        RenderTrace::start();
+
+        return;
+    }
+
+    std::vector<std::string> filters;
+    filters.push_back("json");
+    std::string filePath = popSaveFileDialog(false, filters, _imp->_lastSaveProjectOpenedDir.toStdString(), false);
+    if ( !filePath.empty() && !QString::fromUtf8( filePath.c_str() ).endsWith( QString::fromUtf8(".json"), Qt::CaseInsensitive ) ) {
+        filePath.append(".json");
+    }
+    if ( !RenderTrace::stop(filePath) ) {
+        Dialogs::errorDialog( tr("Render Trace").toStdString(), tr("Failed to write the render trace to %1.").arg( QString::fromUtf8( filePath.c_str() ) ).toStdString() );
+    }
+}
+
 void
 Gui::onTimelineTimeAboutToChange()
 {
@@ -123,6 +123,7 @@ public:
     ActionWithShortcut *renderAllWriters;
     ActionWithShortcut *renderSelectedNode;
     ActionWithShortcut *enableRenderStats;
+    ActionWithShortcut *recordRenderTrace;
     ActionWithShortcut* actionConnectInput[NATRON_CONNECT_INPUT_NB];
     ActionWithShortcut* actionImportLayout;
     ActionWithShortcut* actionExportLayout;
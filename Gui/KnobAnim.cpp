@@ -25,6 +25,7 @@
 #include "KnobAnim.h"
 
 #include <map>
+#include <algorithm> // fill
 
 #include <QTreeWidgetItem>
 
@@ -617,6 +618,32 @@ KnobAnim::evaluateCurve(bool useExpressionIfAny, double x, DimIdx dimension, Vie
 
 }
 
+void
+KnobAnim::evaluateCurveAtTimes(bool useExpressionIfAny, const std::vector<TimeValue>& times, DimIdx dimension, ViewIdx view, std::vector<double>* values)
+{
+    values->resize( times.size() );
+    KnobIPtr knob = getInternalKnob();
+    if (useExpressionIfAny && knob) {
+        std::string expr = knob->getExpression(dimension, view);
+        if (!expr.empty()) {
+            knob->getValuesAtWithExpression(times, view, dimension, values);
+            return;
+        }
+    }
+    CurvePtr curve = getCurve(dimension, view);
+    assert(curve);
+    if (!curve) {
+        throw std::runtime_error("Curve is null");
+    }
+    if (!curve->isAnimated()) {
+        // The value is the same at all times
+        double value = times.empty() ? 0. : evaluateCurve(false, times[0], dimension, view);
+        std::fill(values->begin(), values->end(), value);
+    } else {
+        curve->getValuesAt(times, false /*doClamp*/, values);
+    }
+}
+
 bool
 KnobAnim::getAllDimensionsVisible(ViewIdx view) const
 {
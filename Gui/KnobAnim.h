@@ -78,6 +78,7 @@ public:
     virtual int getNDimensions() const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual bool hasExpression(DimIdx dimension, ViewIdx view) const OVERRIDE FINAL WARN_UNUSED_RETURN;
     virtual double evaluateCurve(bool useExpressionIfAny, double x, DimIdx dimension, ViewIdx view) OVERRIDE FINAL WARN_UNUSED_RETURN;
+    virtual void evaluateCurveAtTimes(bool useExpressionIfAny, const std::vector<TimeValue>& times, DimIdx dimension, ViewIdx view, std::vector<double>* values) OVERRIDE FINAL;
     virtual bool getAllDimensionsVisible(ViewIdx view) const OVERRIDE FINAL WARN_UNUSED_RETURN;
     ////
 
@@ -626,6 +626,7 @@ KnobGui::createGUI(QWidget* parentWidget)
 
     // Create the main container
     _imp->mainContainer = new QWidget(parentWidget);
+    _imp->mainContainer->installEventFilter(this);
     _imp->mainLayout = new QHBoxLayout(_imp->mainContainer);
     _imp->mainLayout->setContentsMargins(0, 0, 0, 0);
     _imp->mainLayout->setSpacing(0);
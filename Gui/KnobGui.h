@@ -221,6 +221,11 @@ public:
 
     void reflectKnobSelectionState(bool selected);
 
+    /**
+     * @brief Refreshes the widgets when they are shown, if a refresh was skipped while they were hidden.
+     **/
+    virtual bool eventFilter(QObject* watched, QEvent* event) OVERRIDE;
+
 public Q_SLOTS:
 
     void onProjectViewsChanged();
@@ -237,7 +242,9 @@ public Q_SLOTS:
                                            DimSpec dimension);
 
     /**
-     * @brief Called when the internal value held by the knob is changed. It calls updateGUI().
+     * @brief Called when the internal value held by the knob is changed. All the changes received before
+     * the event loop runs again are coalesced in a single call to updateGUI(), which is skipped while
+     * the widgets are hidden.
      **/
     void onMustRefreshGuiActionTriggered(ViewSetSpec view ,DimSpec dimension ,ValueChangedReasonEnum reason);
 
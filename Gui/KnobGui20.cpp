@@ -31,6 +31,7 @@
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
 #include <QAction>
+#include <QtCore/QEvent>
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
@@ -55,21 +56,51 @@ NATRON_NAMESPACE_ENTER;
 void
 KnobGui::onMustRefreshGuiActionTriggered(ViewSetSpec /*view*/, DimSpec /*dimension*/, ValueChangedReasonEnum /*reason*/)
 {
-    ++_imp->refreshGuiRequests;
+    // Only the first change since the last refresh posts an event, the others are handled by the same refresh
+    if (_imp->refreshGuiRequests++ > 0) {
+        return;
+    }
     Q_EMIT s_doUpdateGuiLater();
 }
 
 void
 KnobGui::onDoUpdateGuiLaterReceived()
 {
-    if (_imp->guiRemoved || !_imp->widgetCreated || !_imp->refreshGuiRequests) {
+    if (!_imp->refreshGuiRequests) {
         return;
     }
-    
     _imp->refreshGuiRequests = 0;
+
+    // createGUI() refreshes the widgets
+    if (_imp->guiRemoved || !_imp->widgetCreated) {
+        return;
+    }
+
+    // The knob is in a closed panel, a hidden page or a folded group: refresh it when it is shown
+    if ( _imp->mainContainer && !_imp->mainContainer->isVisible() ) {
+        _imp->refreshGuiWhenShown = true;
+
+        return;
+    }
+    _imp->refreshGuiWhenShown = false;
     refreshGuiNow();
 }
 
+bool
+KnobGui::eventFilter(QObject* watched,
+                     QEvent* event)
+{
+    // The show event is also received when a parent of mainContainer is shown
+    if ( (watched == _imp->mainContainer) && (event->type() == QEvent::Show) && _imp->refreshGuiWhenShown ) {
+        _imp->refreshGuiWhenShown = false;
+        if (!_imp->guiRemoved) {
+            refreshGuiNow();
+        }
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
 void
 KnobGui::refreshGuiNow()
 {
@@ -24,6 +24,8 @@
 
 #include "KnobGuiContainerHelper.h"
 
+#include <set>
+
 CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
 #include <QScrollArea>
@@ -223,9 +225,23 @@ void
 KnobGuiContainerHelper::setCurrentPage(const KnobPageGuiPtr& curPage)
 {
     _imp->currentPage = curPage;
+    createPageKnobsIfNeeded(curPage);
     _imp->refreshPagesEnabledness();
 }
 
+void
+KnobGuiContainerHelper::createPageKnobsIfNeeded(const KnobPageGuiPtr& page)
+{
+    if (!page || page->knobsCreated) {
+        return;
+    }
+    page->knobsCreated = true;
+    KnobPagePtr pageKnob = page->pageKnob.lock();
+    if (pageKnob) {
+        initializeKnobVector( pageKnob->getChildren() );
+    }
+}
+
 KnobPageGuiPtr
 KnobGuiContainerHelper::getOrCreatePage(const KnobPagePtr& page)
 {
@@ -278,6 +294,7 @@ KnobGuiContainerHelper::getOrCreatePage(const KnobPagePtr& page)
     pageGui->pageKnob = page;
     pageGui->groupAsTab = 0;
     pageGui->gridLayout = tabLayout;
+    pageGui->knobsCreated = false;
 
     boost::shared_ptr<KnobSignalSlotHandler> handler = page->getSignalSlotHandler();
     QObject::connect( handler.get(), SIGNAL(labelChanged()), _imp->signals.get(), SLOT(onPageLabelChangedInternally()) );
@@ -374,6 +391,10 @@ KnobGuiContainerHelper::initializeKnobs()
             }
         }
         if (guiPage) {
+            // The table goes after the knobs of the page
+            createPageKnobsIfNeeded(guiPage);
+        }
+        if (guiPage && !_imp->knobsTable) {
             _imp->knobsTable = createKnobItemsTable(guiPage->tab);
             _imp->knobsTable->addWidgetsToLayout(guiPage->gridLayout);
         }
@@ -414,6 +435,9 @@ KnobGuiContainerHelper::initializeKnobVector(const KnobsVec& knobs)
     std::list<KnobPagePtr > pages;
     KnobsVec regularKnobs;
 
+    // The pages whose knobs are created when they are made current
+    std::set<KnobPagePtr> deferredPages;
+
     for (std::size_t i = 0; i < knobs.size(); ++i) {
         KnobPagePtr isPage = toKnobPage(knobs[i]);
         if (isPage) {
@@ -425,15 +449,45 @@ KnobGuiContainerHelper::initializeKnobVector(const KnobsVec& knobs)
         }
     }
     for (std::list<KnobPagePtr >::iterator it = pages.begin(); it != pages.end(); ++it) {
+        KnobsVec children = (*it)->getChildren();
+
+        // Only the knobs of the current page are created now: building the widgets of all pages is slow for nodes with many knobs
+        if ( isPagingEnabled() && !children.empty() ) {
+            KnobPageGuiPtr pageGui = getOrCreatePage(*it);
+            if ( pageGui && !pageGui->knobsCreated && (pageGui != getCurrentPage()) ) {
+                deferredPages.insert(*it);
+                continue;
+            }
+            if (pageGui) {
+                pageGui->knobsCreated = true;
+            }
+        }
+
         // Create page
         KnobGuiPtr knobGui = findKnobGuiOrCreate(*it);
         Q_UNUSED(knobGui);
 
         // Create its children
-        KnobsVec children = (*it)->getChildren();
         initializeKnobVectorInternal(children, &regularKnobs);
     }
 
+    // Remove the knobs of the deferred pages, including the children of their groups
+    if ( !deferredPages.empty() ) {
+        KnobsVec notDeferredKnobs;
+        for (KnobsVec::const_iterator it = regularKnobs.begin(); it != regularKnobs.end(); ++it) {
+            KnobIPtr parent = (*it)->getParentKnob();
+            KnobPagePtr topLevelPage;
+            while (parent && !topLevelPage) {
+                topLevelPage = toKnobPage(parent);
+                parent = parent->getParentKnob();
+            }
+            if ( !topLevelPage || ( deferredPages.find(topLevelPage) == deferredPages.end() ) ) {
+                notDeferredKnobs.push_back(*it);
+            }
+        }
+        regularKnobs.swap(notDeferredKnobs);
+    }
+
     // For knobs that did not belong to a page,  create them
     initializeKnobVectorInternal(regularKnobs, 0);
     refreshTabWidgetMaxHeight();
@@ -701,6 +755,14 @@ KnobGuiContainerHelper::findKnobGuiOrCreate(const KnobIPtr &knob)
         if (!page) {
             return ret;
         }
+
+        // The knobs of the page must be created in order: if they were not created yet, create all of them now
+        if (!page->knobsCreated) {
+            createPageKnobsIfNeeded(page);
+            if ( ret->hasWidgetBeenCreated() ) {
+                return ret;
+            }
+        }
         // Retrieve the main grid layout
         QGridLayout* gridLayout = page->gridLayout;
 
@@ -62,11 +62,15 @@ struct KnobPageGui
     KnobPageWPtr pageKnob;
     QGridLayout* gridLayout;
 
+    // False until the widgets of the knobs in the page are created: this is done when the page is made current
+    bool knobsCreated;
+
     KnobPageGui()
         : tab(0)
         , groupAsTab(0)
         , pageKnob()
         , gridLayout(0)
+        , knobsCreated(true)
     {
     }
 };
@@ -372,6 +376,11 @@ private:
 
     void initializeKnobVector(const KnobsVec& knobs);
 
+    /**
+     * @brief Creates the widgets of the knobs in the given page if it was not done yet.
+     **/
+    void createPageKnobsIfNeeded(const KnobPageGuiPtr& page);
+
     void refreshPagesOrder(const KnobPageGuiPtr& curTabName, bool restorePageIndex);
 
     void clearUndoRedoStack();
@@ -58,6 +58,7 @@ KnobGuiPrivate::KnobGuiPrivate(KnobGui* publicInterface, const KnobIPtr& knob, K
 , guiRemoved(false)
 , tabGroup(0)
 , refreshGuiRequests(0)
+, refreshGuiWhenShown(false)
 , refreshModifStateRequests(0)
 , refreshDimensionVisibilityRequests()
 , layoutType(layoutType)
@@ -202,6 +202,9 @@ struct KnobGuiPrivate
     // Used to concatenate updateGui() request
     int refreshGuiRequests;
 
+    // True if a refresh of the widgets was skipped because they were hidden: they are refreshed when shown
+    bool refreshGuiWhenShown;
+
     // Used to concatenate onHasModificationsChanged() request
     int refreshModifStateRequests;
     
@@ -201,7 +201,11 @@ struct KnobItemsTableGuiPrivate
     
     void itemsToSelection(const std::list<KnobTableItemPtr>& items, QItemSelection* selection);
 
-    void createTableItems(const KnobTableItemPtr& item);
+    /**
+     * @brief Creates the row of the given item. If resizeColumns is false, the caller resizes the columns
+     * once all rows are created: resizing them measures all rows.
+     **/
+    void createTableItems(const KnobTableItemPtr& item, bool resizeColumns = true);
 
     void removeTableItem(const KnobTableItemPtr& item);
 
@@ -1873,7 +1877,7 @@ void
 KnobItemsTableGuiPrivate::createItemsVecRecursive(const std::vector<KnobTableItemPtr>& items)
 {
     for (std::size_t i = 0; i < items.size(); ++i) {
-        createTableItems(items[i]);
+        createTableItems(items[i], false);
         const std::vector<KnobTableItemPtr>& children = items[i]->getChildren();
         if (!children.empty()) {
             createItemsVecRecursive(children);
@@ -1887,6 +1891,11 @@ KnobItemsTableGuiPrivate::recreateItemsFromModel()
     assert(items.empty());
     const std::vector<KnobTableItemPtr>& items = internalModel.lock()->getTopLevelItems();
     createItemsVecRecursive(items);
+
+    int nCols = tableModel->columnCount();
+    for (int i = 0; i < nCols; ++i) {
+        tableView->resizeColumnToContents(i);
+    }
 }
 
 
@@ -1915,7 +1924,7 @@ KnobItemsTableGuiPrivate::removeTableItem(const KnobTableItemPtr& item)
 }
 
 void
-KnobItemsTableGuiPrivate::createTableItems(const KnobTableItemPtr& item)
+KnobItemsTableGuiPrivate::createTableItems(const KnobTableItemPtr& item, bool resizeColumns)
 {
     // The item should not exist in the table GUI yet.
     assert(findItem(item) == items.end());
@@ -1954,10 +1963,8 @@ KnobItemsTableGuiPrivate::createTableItems(const KnobTableItemPtr& item)
         
 
         
-        if (d.knob.lock()) {
-            // If we have a knob, create the custom widget
-            createItemCustomWidgetAtCol(item, itemRow, i);
-        } else {
+        // If we have a knob, the custom widget is created below, once the column data is set
+        if (!d.knob.lock()) {
             // Ok the column must be kKnobTableItemColumnLabel
             // otherwise we don't know what the user want
             std::string columnID = item->getColumnName(i);
@@ -1974,7 +1981,9 @@ KnobItemsTableGuiPrivate::createTableItems(const KnobTableItemPtr& item)
 
         }
         
-        tableView->resizeColumnToContents(i);
+        if (resizeColumns) {
+            tableView->resizeColumnToContents(i);
+        }
         mitem.columnItems[i] = d;
 
     }
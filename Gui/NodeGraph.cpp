@@ -303,7 +303,8 @@ NodeGraph::paintEvent(QPaintEvent* e)
         QPointF navTopLeftScene = mapToScene(navTopLeftWidget);
 
         _imp->_navigator->refreshPosition(navTopLeftScene, navWidth, navHeight);
-        updateNavigator();
+        // The view was panned, zoomed or resized
+        updateNavigator(false);
         _imp->_refreshOverlays = false;
     }
     QGraphicsView::paintEvent(e);
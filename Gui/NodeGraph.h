@@ -103,9 +103,11 @@ public:
     bool areAllNodesVisible();
 
     /**
-     * @brief Repaint the navigator
+     * @brief Repaint the navigator. If sceneChanged is false, the scene is assumed to be unchanged since the
+     * last repaint, except for the visible portion and the position and size of the nodes: the
+     * last render of the scene in the navigator may then be reused.
      **/
-    void updateNavigator();
+    void updateNavigator(bool sceneChanged = true);
 
     const NodesGuiList & getAllActiveNodes() const;
     NodesGuiList getAllActiveNodes_mt_safe() const;
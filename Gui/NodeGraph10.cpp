@@ -359,7 +359,7 @@ NodeGraph::mousePressEvent(QMouseEvent* e)
         QPointF mousePosSceneCoordinates;
         bool insideNavigator = isNearbyNavigator(e->pos(), mousePosSceneCoordinates);
         if (insideNavigator) {
-            updateNavigator();
+            updateNavigator(false);
             _imp->_refreshOverlays = true;
             centerOn(mousePosSceneCoordinates);
             _imp->_evtState = eEventStateDraggingNavigator;
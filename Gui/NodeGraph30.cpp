@@ -475,8 +475,11 @@ NodeGraph::clearSelection()
 }
 
 void
-NodeGraph::updateNavigator()
+NodeGraph::updateNavigator(bool sceneChanged)
 {
+    if (sceneChanged) {
+        _imp->navigatorSceneDirty = true;
+    }
     if ( !areAllNodesVisible() ) {
         _imp->_navigator->setPixmap( QPixmap::fromImage( getFullSceneScreenShot() ) );
         _imp->_navigator->show();
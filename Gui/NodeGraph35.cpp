@@ -62,10 +62,9 @@ NATRON_NAMESPACE_ENTER;
 QImage
 NodeGraph::getFullSceneScreenShot()
 {
-    _imp->isDoingPreviewRender = true;
-
     // The bbox of all nodes in the nodegraph
-    QRectF sceneR = _imp->calcNodesBoundingRect();
+    U64 nodesChecksum;
+    QRectF sceneR = _imp->calcNodesBoundingRect(&nodesChecksum);
 
     // The visible portion of the nodegraph
     QRectF viewRect = visibleSceneRect();
@@ -83,11 +82,42 @@ NodeGraph::getFullSceneScreenShot()
     int sceneW_navPixelCoord = std::floor(sceneR.width() * scaleFactor);
     int sceneH_navPixelCoord = std::floor(sceneR.height() * scaleFactor);
 
-    // Render the scene in an image with the same aspect ratio  as the scene rect
-    QImage renderImage(sceneW_navPixelCoord, sceneH_navPixelCoord, QImage::Format_ARGB32_Premultiplied);
+    // Render the scene in an image with the same aspect ratio  as the scene rect, unless the last render is still valid
+    if ( _imp->navigatorSceneDirty ||
+         ( _imp->navigatorSceneImage.size() != QSize(sceneW_navPixelCoord, sceneH_navPixelCoord) ) ||
+         ( _imp->navigatorSceneRect != sceneR ) ||
+         ( _imp->navigatorNodesChecksum != nodesChecksum ) ) {
+        _imp->isDoingPreviewRender = true;
+
+        QImage sceneImage(sceneW_navPixelCoord, sceneH_navPixelCoord, QImage::Format_ARGB32_Premultiplied);
+
+        // Fill the background
+        sceneImage.fill( QColor(71, 71, 71, 255) );
+
+        QPainter scenePainter(&sceneImage);
+
+        // Remove the overlays from the scene before rendering it
+        scene()->removeItem(_imp->_cacheSizeText);
+        scene()->removeItem(_imp->_navigator);
+
+        // Render into the QImage with downscaling
+        scene()->render(&scenePainter, sceneImage.rect(), sceneR, Qt::KeepAspectRatio);
+
+        // Add the overlays back
+        scene()->addItem(_imp->_navigator);
+        scene()->addItem(_imp->_cacheSizeText);
 
-    // Fill the background
-    renderImage.fill( QColor(71, 71, 71, 255) );
+        scenePainter.end();
+
+        _imp->navigatorSceneImage = sceneImage;
+        _imp->navigatorSceneRect = sceneR;
+        _imp->navigatorNodesChecksum = nodesChecksum;
+        _imp->navigatorSceneDirty = false;
+        _imp->isDoingPreviewRender = false;
+    }
+
+    // The highlight is painted on a copy
+    QImage renderImage = _imp->navigatorSceneImage.copy();
 
     // Offset the visible rect corner as an offset relative to the scene rect corner
     viewRect.setX( viewRect.x() - sceneR.x() );
@@ -104,17 +134,6 @@ NodeGraph::getFullSceneScreenShot()
     // Paint the visible portion with a highlight
     QPainter painter(&renderImage);
 
-    // Remove the overlays from the scene before rendering it
-    scene()->removeItem(_imp->_cacheSizeText);
-    scene()->removeItem(_imp->_navigator);
-
-    // Render into the QImage with downscaling
-    scene()->render(&painter, renderImage.rect(), sceneR, Qt::KeepAspectRatio);
-
-    // Add the overlays back
-    scene()->addItem(_imp->_navigator);
-    scene()->addItem(_imp->_cacheSizeText);
-
     // Fill the highlight with a semi transparent whitish grey
     painter.fillRect( viewRect_navCoordinates, QColor(200, 200, 200, 100) );
 
@@ -154,8 +173,6 @@ NodeGraph::getFullSceneScreenShot()
         }
     }
 
-    _imp->isDoingPreviewRender = false;
-
     return img;
 } // getFullSceneScreenShot
 
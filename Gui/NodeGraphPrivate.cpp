@@ -27,6 +27,7 @@
 
 #include <stdexcept>
 
+#include "Engine/Hash64.h"
 #include "Engine/Node.h"
 #include "Engine/NodeGroup.h"
 #include "Engine/Project.h"
@@ -91,6 +92,10 @@ NodeGraphPrivate::NodeGraphPrivate(NodeGraph* p,
     , _hasMovedOnce(false)
     , lastSelectedViewer(0)
     , isDoingPreviewRender(false)
+    , navigatorSceneImage()
+    , navigatorSceneRect()
+    , navigatorNodesChecksum(0)
+    , navigatorSceneDirty(true)
     , autoScrollTimer()
     , linkedNodes()
     , refreshNodesLinkRequest(0)
@@ -171,16 +176,28 @@ NodeGraphPrivate::setNodesBendPointsVisible(bool visible)
 }
 
 QRectF
-NodeGraphPrivate::calcNodesBoundingRect()
+NodeGraphPrivate::calcNodesBoundingRect(U64* nodesChecksum)
 {
     QRectF ret;
+    Hash64 hash;
     QMutexLocker l(&_nodesMutex);
 
     for (NodesGuiList::iterator it = _nodes.begin(); it != _nodes.end(); ++it) {
         if ( (*it)->isVisible() ) {
-            ret = ret.united( (*it)->boundingRectWithEdges() );
+            QRectF nodeRect = (*it)->boundingRectWithEdges();
+            ret = ret.united(nodeRect);
+            if (nodesChecksum) {
+                hash.append( nodeRect.x() );
+                hash.append( nodeRect.y() );
+                hash.append( nodeRect.width() );
+                hash.append( nodeRect.height() );
+            }
         }
     }
+    if (nodesChecksum) {
+        hash.computeHash();
+        *nodesChecksum = hash.value();
+    }
 
     return ret;
 }
@@ -205,6 +205,14 @@ public:
 
     ///True when the graph is rendered from the getFullSceneScreenShot() function
     bool isDoingPreviewRender;
+
+    // The scene as last rendered by getFullSceneScreenShot(), without the visible portion highlight.
+    // It is rendered again only if the scene rect, the nodes or the navigator size changed, or if
+    // navigatorSceneDirty is set, so panning and zooming does not render all nodes again.
+    QImage navigatorSceneImage;
+    QRectF navigatorSceneRect;
+    U64 navigatorNodesChecksum;
+    bool navigatorSceneDirty;
     QTimer autoScrollTimer;
     QTimer refreshRenderStateTimer;
 
@@ -235,7 +243,11 @@ public:
 
     QPoint getPyPlugUnlockPos() const;
 
-    QRectF calcNodesBoundingRect();
+    /**
+     * @brief Returns the bounding rect of all visible nodes. If nodesChecksum is set, it receives a checksum
+     * of the bounding rects of the nodes that changes whenever a node moves, is resized, or is shown or hidden.
+     **/
+    QRectF calcNodesBoundingRect(U64* nodesChecksum = 0);
 
     /**
      * @brief Serialize the given node list 
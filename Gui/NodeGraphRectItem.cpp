@@ -26,6 +26,10 @@
 #include "NodeGraphRectItem.h"
 
 #include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+// Below this scale of the item on the device, the rect is filled without the outline and the rounded corners
+#define NODEGRAPH_RECT_ITEM_MIN_DETAIL_LOD 0.4
 
 NATRON_NAMESPACE_ENTER
 
@@ -37,8 +41,14 @@ NodeGraphRectItem::NodeGraphRectItem(QGraphicsItem *parent,
 }
 
 void
-NodeGraphRectItem::paint(QPainter *painter, const QStyleOptionGraphicsItem* /*option*/, QWidget* /*widget*/)
+NodeGraphRectItem::paint(QPainter *painter, const QStyleOptionGraphicsItem* option, QWidget* /*widget*/)
 {
+    if ( option->levelOfDetailFromTransform( painter->worldTransform() ) < NODEGRAPH_RECT_ITEM_MIN_DETAIL_LOD ) {
+        // The details would not be visible anyway
+        painter->fillRect( rect(), brush() );
+
+        return;
+    }
     painter->setPen(pen());
     painter->setBrush(brush());
     painter->drawRoundedRect(rect(), _cornerRadiusPx, _cornerRadiusPx);
@@ -72,10 +72,9 @@ NodeGraphTextItem::paint(QPainter *painter,
         if ( _graph->isDoingNavigatorRender() ) {
             isTooSmall = true;
         } else {
+            // The scale of the item on the device, taken from the painter instead of mapping the item through the view
             QFontMetrics fm( font() );
-            QPoint topLeft = _graph->mapFromScene( mapToScene( QPointF(0, 0) ) );
-            QPoint btmLeft = _graph->mapFromScene( mapToScene( QPointF( 0, fm.height() ) ) );
-            int height = std::abs( btmLeft.y() - topLeft.y() );
+            double height = fm.height() * option->levelOfDetailFromTransform( painter->worldTransform() );
             isTooSmall = height < NODEGRAPH_TEXT_ITEM_MIN_HEIGHT_PX;
         }
     }
@@ -116,10 +115,9 @@ NodeGraphSimpleTextItem::paint(QPainter *painter,
         if ( _graph->isDoingNavigatorRender() ) {
             isTooSmall = true;
         } else {
+            // The scale of the item on the device, taken from the painter instead of mapping the item through the view
             QFontMetrics fm( font() );
-            QPoint topLeft = _graph->mapFromScene( mapToScene( QPointF(0, 0) ) );
-            QPoint btmLeft = _graph->mapFromScene( mapToScene( QPointF( 0, fm.height() ) ) );
-            int height = std::abs( btmLeft.y() - topLeft.y() );
+            double height = fm.height() * option->levelOfDetailFromTransform( painter->worldTransform() );
             isTooSmall = height < NODEGRAPH_SIMPLE_TEXT_ITEM_MIN_HEIGHT_PX;
         }
     }
@@ -148,8 +146,7 @@ NodeGraphPixmapItem::paint(QPainter *painter,
     if ( _graph->isDoingNavigatorRender() ) {
         return;
     }
-    QRect br = _graph->mapFromScene( mapToScene( boundingRect() ).boundingRect() ).boundingRect();
-    int height = br.height();
+    double height = boundingRect().height() * option->levelOfDetailFromTransform( painter->worldTransform() );
     if (height < NODEGRAPH_PIXMAP_ITEM_MIN_HEIGHT_PX) {
         return;
     }
@@ -123,6 +123,9 @@ CLANG_DIAG_ON(uninitialized)
 
 
 #define NATRON_PLUGIN_ICON_SIZE 20
+
+// Time without preview refresh request after which the preview is computed
+#define NATRON_PREVIEW_REFRESH_DELAY_MS 300
 #define PLUGIN_ICON_OFFSET 2
 
 NATRON_NAMESPACE_ENTER;
@@ -176,6 +179,7 @@ NodeGui::NodeGui(QGraphicsItem *parent)
     , _previewData( NATRON_PREVIEW_HEIGHT * NATRON_PREVIEW_WIDTH * sizeof(unsigned int) )
     , _previewW(NATRON_PREVIEW_WIDTH)
     , _previewH(NATRON_PREVIEW_HEIGHT)
+    , _previewRefreshTimer(NULL)
     , _persistentMessage(NULL)
     , _stateIndicator(NULL)
     , _mergeHintActive(false)
@@ -221,6 +225,11 @@ NodeGui::initialize(NodeGraph* dag,
 
     internalNode->setNodeGuiPointer(thisAsShared);
 
+    _previewRefreshTimer = new QTimer(this);
+    _previewRefreshTimer->setSingleShot(true);
+    _previewRefreshTimer->setInterval(NATRON_PREVIEW_REFRESH_DELAY_MS);
+    QObject::connect( _previewRefreshTimer, SIGNAL(timeout()), this, SLOT(updatePreviewNow()) );
+
     QObject::connect( internalNode.get(), SIGNAL(labelChanged(QString,QString)), this, SLOT(onInternalNameChanged(QString,QString)) );
     QObject::connect( internalNode.get(), SIGNAL(refreshEdgesGUI()), this, SLOT(refreshEdges()) );
     QObject::connect( internalNode.get(), SIGNAL(inputsInitialized()), this, SLOT(initializeInputs()) );
@@ -1244,11 +1253,9 @@ NodeGui::updatePreviewImage()
 
         ensurePreviewCreated();
 
-        NodeGuiPtr thisShared = shared_from_this();
-        assert(thisShared);
-
         // Delay the preview: this enables to almost always have a cached image instead of running concurrently with the viewer render.
-        QTimer::singleShot(300, this, SLOT(updatePreviewNow()));
+        // Restarting the timer coalesces the requests received while a knob is dragged.
+        _previewRefreshTimer->start();
 
     }
 }
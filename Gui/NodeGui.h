@@ -47,6 +47,7 @@ CLANG_DIAG_OFF(uninitialized)
 #include <QGraphicsItem>
 #include <QDialog>
 #include <QtCore/QMutex>
+#include <QtCore/QTimer>
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
@@ -550,6 +551,9 @@ private:
     mutable QMutex _previewDataMutex;
     std::vector<unsigned int> _previewData;
     int _previewW, _previewH;
+
+    // Restarted by each preview refresh request: the preview is only computed once the changes (e.g. a knob drag) pause
+    QTimer* _previewRefreshTimer;
     QGraphicsSimpleTextItem* _persistentMessage;
     NodeGraphRectItem* _stateIndicator;
     bool _mergeHintActive;
@@ -25,6 +25,7 @@
 #include "PreviewThread.h"
 
 #include <list>
+#include <map>
 #include <vector>
 #include <stdexcept>
 #include <cstring> // for std::memcpy, std::memset
@@ -48,10 +49,16 @@ public:
     TimeValue time;
     NodeGuiWPtr node;
 
+    // Identifies the request in PreviewThreadPrivate::latestRequests, the key is valid even if the node was destroyed
+    const NodeGui* nodeKey;
+    U64 requestID;
+
     ComputePreviewRequest()
         : GenericThreadStartArgs()
         , time(0)
         , node()
+        , nodeKey(0)
+        , requestID(0)
     {}
 
     virtual ~ComputePreviewRequest()
@@ -63,10 +70,39 @@ struct PreviewThreadPrivate
 {
     std::vector<unsigned int> data;
 
+    // Protects latestRequests and requestsCounter
+    QMutex requestsMutex;
+
+    // For each node with a queued request, the ID of the most recent one: older requests are skipped
+    std::map<const NodeGui*, U64> latestRequests;
+    U64 requestsCounter;
+
+    // True once the thread priority was lowered
+    bool priorityLowered;
+
     PreviewThreadPrivate()
         : data( NATRON_PREVIEW_HEIGHT * NATRON_PREVIEW_WIDTH * sizeof(unsigned int) )
+        , requestsMutex()
+        , latestRequests()
+        , requestsCounter(0)
+        , priorityLowered(false)
     {
     }
+
+    /**
+     * @brief Returns true if the given request is the most recent one for its node, in which case it is no longer pending.
+     **/
+    bool takeRequestIfLatest(const NodeGui* node, U64 requestID)
+    {
+        QMutexLocker k(&requestsMutex);
+        std::map<const NodeGui*, U64>::iterator found = latestRequests.find(node);
+        if ( ( found == latestRequests.end() ) || (found->second != requestID) ) {
+            return false;
+        }
+        latestRequests.erase(found);
+
+        return true;
+    }
 };
 
 PreviewThread::PreviewThread()
@@ -90,6 +126,12 @@ PreviewThread::appendToQueue(const NodeGuiPtr& node,
 
     r->node = node;
     r->time = time;
+    r->nodeKey = node.get();
+    {
+        QMutexLocker k(&_imp->requestsMutex);
+        r->requestID = ++_imp->requestsCounter;
+        _imp->latestRequests[node.get()] = r->requestID;
+    }
     startTask(r);
 }
 
@@ -100,8 +142,20 @@ PreviewThread::threadLoopOnce(const GenericThreadStartArgsPtr& inArgs)
 
     assert(args);
 
+    // Previews must not take the CPU from the interactive renders (the viewer).
+    // The priority can only be set once the thread runs.
+    if (!_imp->priorityLowered) {
+        setPriority(QThread::LowestPriority);
+        _imp->priorityLowered = true;
+    }
 
     NodeGuiPtr node = args->node.lock();
+
+    // A more recent request for the same node was queued since: it will compute the preview instead
+    if ( !_imp->takeRequestIfLatest(args->nodeKey, args->requestID) ) {
+        return eThreadStateActive;
+    }
+
     if (node) {
 
         //process the request if valid
@@ -24,6 +24,7 @@
 
 #include "RenderStatsDialog.h"
 
+#include <algorithm> // max
 #include <bitset>
 #include <stdexcept>
 
@@ -35,6 +36,7 @@
 #include <QItemSelectionModel>
 #include <QtCore/QRegExp>
 
+#include "Engine/MemoryInfo.h" // printAsRAM
 #include "Engine/Node.h"
 #include "Engine/Timer.h"
 #include "Engine/Utils.h" // convertFromPlainText
@@ -51,8 +53,14 @@
 #define COL_NAME 0
 #define COL_PLUGIN_ID 1
 #define COL_TIME 2
+#define COL_CLONES 3
+#define COL_NANS 4
+#define COL_ACTIONS 5
+#define COL_CACHE 6
+#define COL_MEMORY 7
+#define COL_THREADS 8
 
-#define NUM_COLS 3
+#define NUM_COLS 9
 
 NATRON_NAMESPACE_ENTER;
 
@@ -63,6 +71,18 @@ enum ItemsRoleEnum
     eItemsRoleIdentityTilesInfo = 102,
     eItemsRoleRenderedTilesNb = 103,
     eItemsRoleRenderedTilesInfo = 104,
+    eItemsRoleClonesCreatedNb = 105,
+    eItemsRoleClonesReusedNb = 106,
+    eItemsRoleNaNsNb = 107,
+    eItemsRoleActionsTime = 108,
+    eItemsRoleCacheHitsNb = 109,
+    eItemsRoleCacheMissesNb = 110,
+    eItemsRoleBytesAllocated = 111,
+    eItemsRoleThreadsNb = 112,
+
+    // The time spent in each RenderStatsActionEnum are stored from this role
+    eItemsRoleActionTimeFirst = 120,
+    eItemsRoleActionCallsFirst = 140,
 };
 
 struct RowInfo
@@ -90,6 +110,18 @@ struct StatRowsCompare
         switch (_col) {
             case COL_TIME:
                 return lhs.item->getData(_col, (int)eItemsRoleTime ).toDouble() < rhs.item->getData(_col, (int)eItemsRoleTime ).toDouble();
+            case COL_CLONES:
+                return lhs.item->getData(_col, (int)eItemsRoleClonesCreatedNb ).toInt() < rhs.item->getData(_col, (int)eItemsRoleClonesCreatedNb ).toInt();
+            case COL_NANS:
+                return lhs.item->getData(_col, (int)eItemsRoleNaNsNb ).toULongLong() < rhs.item->getData(_col, (int)eItemsRoleNaNsNb ).toULongLong();
+            case COL_ACTIONS:
+                return lhs.item->getData(_col, (int)eItemsRoleActionsTime ).toDouble() < rhs.item->getData(_col, (int)eItemsRoleActionsTime ).toDouble();
+            case COL_CACHE:
+                return lhs.item->getData(_col, (int)eItemsRoleCacheMissesNb ).toInt() < rhs.item->getData(_col, (int)eItemsRoleCacheMissesNb ).toInt();
+            case COL_MEMORY:
+                return lhs.item->getData(_col, (int)eItemsRoleBytesAllocated ).toULongLong() < rhs.item->getData(_col, (int)eItemsRoleBytesAllocated ).toULongLong();
+            case COL_THREADS:
+                return lhs.item->getData(_col, (int)eItemsRoleThreadsNb ).toInt() < rhs.item->getData(_col, (int)eItemsRoleThreadsNb ).toInt();
             default:
                 return lhs.item->getText(_col) < rhs.item->getText(_col);
         }
@@ -219,6 +251,139 @@ public:
             item->setText(COL_TIME, Timer::printAsTime(timeSoFar, false) );
         }
 
+        {
+            int nCreated, nReused;
+            if (exists) {
+                nCreated = item->getData(COL_CLONES, (int)eItemsRoleClonesCreatedNb).toInt() + stats.getNumRenderClonesCreated();
+                nReused = item->getData(COL_CLONES, (int)eItemsRoleClonesReusedNb).toInt() + stats.getNumRenderClonesReused();
+            } else {
+                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("The number of render clones of this node allocated by the renders and the number of "
+                                                                       "clones re-used from previous renders instead of being allocated."), NATRON_NAMESPACE::WhiteSpaceNormal);
+                item->setToolTip(COL_CLONES, tt);
+                nCreated = stats.getNumRenderClonesCreated();
+                nReused = stats.getNumRenderClonesReused();
+                item->setFlags(COL_CLONES, Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            }
+            if (nodeUi) {
+                item->setTextColor(COL_CLONES, Qt::black);
+                item->setBackgroundColor(COL_CLONES, c);
+            }
+            item->setData(COL_CLONES, (int)eItemsRoleClonesCreatedNb, nCreated);
+            item->setData(COL_CLONES, (int)eItemsRoleClonesReusedNb, nReused);
+            item->setText(COL_CLONES, tr("%1 allocated, %2 re-used").arg(nCreated).arg(nReused));
+        }
+
+        {
+            qulonglong nNaNs;
+            if (exists) {
+                nNaNs = item->getData(COL_NANS, (int)eItemsRoleNaNsNb).toULongLong() + stats.getNumNaNsReplaced();
+            } else {
+                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("The number of NaN values found in the images rendered by this node. They have been converted to 1. "
+                                                                       "This is only counted when \"Convert NaN values\" is enabled in the preferences."), NATRON_NAMESPACE::WhiteSpaceNormal);
+                item->setToolTip(COL_NANS, tt);
+                nNaNs = stats.getNumNaNsReplaced();
+                item->setFlags(COL_NANS, Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            }
+            if (nodeUi) {
+                item->setTextColor(COL_NANS, Qt::black);
+                item->setBackgroundColor(COL_NANS, c);
+            }
+            item->setData(COL_NANS, (int)eItemsRoleNaNsNb, nNaNs);
+            item->setText(COL_NANS, QString::number(nNaNs));
+        }
+
+        {
+            if (!exists) {
+                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("The time spent by this node in each step of its render across all threads and the number of calls: "
+                                                                       "the getRegionOfDefinition, getRegionsOfInterest, isIdentity and render actions, "
+                                                                       "the cache lookups, the wait for tiles rendered by other threads, the conversion of the input images "
+                                                                       "and the mask/mix post-processing."), NATRON_NAMESPACE::WhiteSpaceNormal);
+                item->setToolTip(COL_ACTIONS, tt);
+                item->setFlags(COL_ACTIONS, Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            }
+            if (nodeUi) {
+                item->setTextColor(COL_ACTIONS, Qt::black);
+                item->setBackgroundColor(COL_ACTIONS, c);
+            }
+            double actionsTime = 0;
+            QStringList actionsText;
+            for (int i = 0; i < eRenderStatsActionCount; ++i) {
+                RenderStatsActionEnum action = (RenderStatsActionEnum)i;
+                double time = stats.getActionTime(action);
+                int nCalls = stats.getActionCallsCount(action);
+                if (exists) {
+                    time += item->getData(COL_ACTIONS, (int)eItemsRoleActionTimeFirst + i).toDouble();
+                    nCalls += item->getData(COL_ACTIONS, (int)eItemsRoleActionCallsFirst + i).toInt();
+                }
+                item->setData(COL_ACTIONS, (int)eItemsRoleActionTimeFirst + i, time);
+                item->setData(COL_ACTIONS, (int)eItemsRoleActionCallsFirst + i, nCalls);
+                actionsTime += time;
+                if (nCalls > 0) {
+                    actionsText.push_back( tr("%1: %2 (%3)").arg( QString::fromUtf8( RenderStats::getActionLabel(action) ) ).arg( Timer::printAsTime(time, false) ).arg(nCalls) );
+                }
+            }
+            item->setData(COL_ACTIONS, (int)eItemsRoleActionsTime, actionsTime);
+            item->setText( COL_ACTIONS, actionsText.join( QString::fromUtf8(", ") ) );
+        }
+
+        {
+            int nHits, nMisses;
+            if (exists) {
+                nHits = item->getData(COL_CACHE, (int)eItemsRoleCacheHitsNb).toInt() + stats.getNumCacheHits();
+                nMisses = item->getData(COL_CACHE, (int)eItemsRoleCacheMissesNb).toInt() + stats.getNumCacheMisses();
+            } else {
+                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("The number of images of this node found entirely rendered in the cache and the number "
+                                                                       "of images which had to be rendered."), NATRON_NAMESPACE::WhiteSpaceNormal);
+                item->setToolTip(COL_CACHE, tt);
+                nHits = stats.getNumCacheHits();
+                nMisses = stats.getNumCacheMisses();
+                item->setFlags(COL_CACHE, Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            }
+            if (nodeUi) {
+                item->setTextColor(COL_CACHE, Qt::black);
+                item->setBackgroundColor(COL_CACHE, c);
+            }
+            item->setData(COL_CACHE, (int)eItemsRoleCacheHitsNb, nHits);
+            item->setData(COL_CACHE, (int)eItemsRoleCacheMissesNb, nMisses);
+            item->setText(COL_CACHE, tr("%1 hits, %2 misses").arg(nHits).arg(nMisses));
+        }
+
+        {
+            qulonglong bytes;
+            if (exists) {
+                bytes = item->getData(COL_MEMORY, (int)eItemsRoleBytesAllocated).toULongLong() + stats.getBytesAllocated();
+            } else {
+                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("The memory allocated for the images rendered by this node and for the conversion of its input images."), NATRON_NAMESPACE::WhiteSpaceNormal);
+                item->setToolTip(COL_MEMORY, tt);
+                bytes = stats.getBytesAllocated();
+                item->setFlags(COL_MEMORY, Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            }
+            if (nodeUi) {
+                item->setTextColor(COL_MEMORY, Qt::black);
+                item->setBackgroundColor(COL_MEMORY, c);
+            }
+            item->setData(COL_MEMORY, (int)eItemsRoleBytesAllocated, bytes);
+            item->setText( COL_MEMORY, printAsRAM(bytes) );
+        }
+
+        {
+            int nThreads;
+            if (exists) {
+                nThreads = std::max( item->getData(COL_THREADS, (int)eItemsRoleThreadsNb).toInt(), stats.getNumRenderThreads() );
+            } else {
+                QString tt = NATRON_NAMESPACE::convertFromPlainText(tr("The maximum number of threads which rendered this node for a frame."), NATRON_NAMESPACE::WhiteSpaceNormal);
+                item->setToolTip(COL_THREADS, tt);
+                nThreads = stats.getNumRenderThreads();
+                item->setFlags(COL_THREADS, Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            }
+            if (nodeUi) {
+                item->setTextColor(COL_THREADS, Qt::black);
+                item->setBackgroundColor(COL_THREADS, c);
+            }
+            item->setData(COL_THREADS, (int)eItemsRoleThreadsNb, nThreads);
+            item->setText( COL_THREADS, QString::number(nThreads) );
+        }
+
         if (!exists) {
             rows.push_back(node);
         }
@@ -429,7 +594,13 @@ RenderStatsDialog::RenderStatsDialog(Gui* gui)
     dimensionNames
     << tr("Node")
     << tr("Plugin ID")
-    << tr("Time Spent");
+    << tr("Time Spent")
+    << tr("Render Clones")
+    << tr("NaNs")
+    << tr("Actions")
+    << tr("Cache")
+    << tr("Memory")
+    << tr("Threads");
     _imp->model = StatsTableModel::create(dimensionNames.size());
     _imp->view->setTableModel(_imp->model);
 
@@ -2800,27 +2800,22 @@ std::vector< SequenceParsing::SequenceFromFilesPtr >
 SequenceFileDialog::fileSequencesFromFilesList(const QStringList & files,
                                                const QStringList & supportedFileTypes)
 {
-    std::vector< SequenceParsing::SequenceFromFilesPtr > sequences;
-
+    std::vector<std::string> supportedFiles;
     for (int i = 0; i < files.size(); ++i) {
-        SequenceParsing::FileNameContent fileContent( files.at(i).toStdString() );
-
-        if ( !supportedFileTypes.contains(QString::fromUtf8( fileContent.getExtension().c_str() ), Qt::CaseInsensitive) ) {
+        const QString& file = files.at(i);
+        int lastDotPos = file.lastIndexOf( QLatin1Char('.') );
+        if ( (lastDotPos == -1) || !supportedFileTypes.contains(file.mid(lastDotPos + 1), Qt::CaseInsensitive) ) {
             continue;
         }
+        supportedFiles.push_back( file.toStdString() );
+    }
 
-        bool found = false;
+    std::vector<std::pair<SequenceParsing::SequenceFromFilesPtr, int> > groups;
+    FileSystemModel::groupFilesInSequences(supportedFiles, std::vector<bool>(supportedFiles.size(), true), true, false, &groups);
 
-        for (U32 j = 0; j < sequences.size(); ++j) {
-            if ( sequences[j]->tryInsertFile(fileContent) ) {
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
-            SequenceParsing::SequenceFromFilesPtr seq( new SequenceParsing::SequenceFromFiles(fileContent, false) );
-            sequences.push_back(seq);
-        }
+    std::vector< SequenceParsing::SequenceFromFilesPtr > sequences( groups.size() );
+    for (std::size_t i = 0; i < groups.size(); ++i) {
+        sequences[i] = groups[i].first;
     }
 
     return sequences;
@@ -28,6 +28,9 @@
 
 NATRON_NAMESPACE_ENTER;
 
+// Applies the viewer display transform to a linear texture, in the same order as the CPU
+// viewer process (see ViewerInstance.cpp): gain and offset, then gamma, then the display
+// colorspace. lut takes the values of ViewerColorSpaceEnum.
 const char* fragRGB =
     "uniform sampler2D Tex;\n"
     "uniform float gain;\n"
@@ -44,7 +47,16 @@ const char* fragRGB =
     "void main(){\n"
     "    vec4 color_tmp = texture2D(Tex,gl_TexCoord[0].st);\n"
     "    color_tmp.rgb = (color_tmp.rgb * gain) + offset;\n"
-    "    if(lut == 0){ // srgb\n"
+    "   if (gamma <= 0.) {\n"
+    "       color_tmp.r = (color_tmp.r >= 1.) ? 1. : 0.;\n"
+    "       color_tmp.g = (color_tmp.g >= 1.) ? 1. : 0.;\n"
+    "       color_tmp.b = (color_tmp.b >= 1.) ? 1. : 0.;\n"
+    "   } else if (gamma != 1.) {\n"
+    "       color_tmp.r = pow(max(color_tmp.r, 0.), 1./gamma);\n"
+    "       color_tmp.g = pow(max(color_tmp.g, 0.), 1./gamma);\n"
+    "       color_tmp.b = pow(max(color_tmp.b, 0.), 1./gamma);\n"
+    "   }\n"
+    "    if(lut == 1){ // srgb\n"
 // << TO SRGB
     "       color_tmp.r = linear_to_srgb(color_tmp.r);\n"
     "       color_tmp.g = linear_to_srgb(color_tmp.g);\n"
@@ -56,15 +68,6 @@ const char* fragRGB =
     "       color_tmp.g = linear_to_rec709(color_tmp.g);\n"
     "       color_tmp.b = linear_to_rec709(color_tmp.b);\n"
     "   }\n" // << END TO REC 709
-    "   if (gamma <= 0.) {\n"
-    "       color_tmp.r = (color_tmp.r >= 1.) ? 1. : 0.;\n"
-    "       color_tmp.g = (color_tmp.g >= 1.) ? 1. : 0.;\n"
-    "       color_tmp.b = (color_tmp.b >= 1.) ? 1. : 0.;\n"
-    "   } else {\n"
-    "       color_tmp.r = pow(color_tmp.r, 1./gamma);\n"
-    "       color_tmp.g = pow(color_tmp.g, 1./gamma);\n"
-    "       color_tmp.b = pow(color_tmp.b, 1./gamma);\n"
-    "   }\n"
     "	gl_FragColor = color_tmp;\n"
     "}\n"
 ;
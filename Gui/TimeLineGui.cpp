@@ -25,6 +25,7 @@
 #include "TimeLineGui.h"
 
 #include <cmath>
+#include <algorithm> // min, max
 #include <set>
 #include <stdexcept>
 
@@ -614,14 +615,16 @@ TimeLineGui::paintGL()
         glCheckError(GL_GPU);
         GL_GPU::Begin(GL_LINES);
 
-        std::list<TimeValue> cachedFrames;
+        std::list<RangeD> cachedFrames;
         _imp->viewerTab->getTimeLineCachedFrames(&cachedFrames);
-        for (std::list<TimeValue>::const_iterator i = cachedFrames.begin(); i != cachedFrames.end(); ++i) {
-            if ( ( *i >= btmLeft.x() ) && ( *i <= topRight.x() ) ) {
-                GL_GPU::Color4f(cachedR, cachedG, cachedB, 1.);
-
-                GL_GPU::Vertex2f((int)*i, cachedLineYPos);
-                GL_GPU::Vertex2f((int)*i + 1, cachedLineYPos);
+        GL_GPU::Color4f(cachedR, cachedG, cachedB, 1.);
+        for (std::list<RangeD>::const_iterator i = cachedFrames.begin(); i != cachedFrames.end(); ++i) {
+            // Only draw the visible part of each range of cached frames
+            int first = (int)std::max( i->min, std::floor( btmLeft.x() ) );
+            int last = (int)std::min( i->max, std::ceil( topRight.x() ) );
+            if (first <= last) {
+                GL_GPU::Vertex2f(first, cachedLineYPos);
+                GL_GPU::Vertex2f(last + 1, cachedLineYPos);
             }
         }
         GL_GPU::End();
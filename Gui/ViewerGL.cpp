@@ -53,6 +53,7 @@ GCC_DIAG_UNUSED_PRIVATE_FIELD_ON
 #include "Global/GLObfuscate.h" //!<must be included after QGLWidget
 #include <QTreeWidget>
 #include <QTabBar>
+#include <QtConcurrentRun> // QtCore on Qt4, QtConcurrent on Qt5
 
 #include "Engine/Lut.h"
 #include "Engine/Node.h"
@@ -64,6 +65,7 @@ GCC_DIAG_UNUSED_PRIVATE_FIELD_ON
 #include "Engine/NodeMetadata.h"
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/OSGLFunctions.h"
+#include "Engine/RenderTrace.h"
 #include "Engine/Settings.h"
 #include "Engine/Timer.h" // for gettimeofday
 #include "Engine/Texture.h"
@@ -93,6 +95,10 @@ GCC_DIAG_UNUSED_PRIVATE_FIELD_ON
 
 #define PERSISTENT_MESSAGE_LEFT_OFFSET_PIXELS 20
 
+// The number of PBOs used in turn to upload the images to the textures: a PBO is only written again
+// once the uploads from the other PBOs were issued, so that the GPU is most likely done reading it
+#define NATRON_VIEWER_PBO_RING_SIZE 3
+
 #ifndef M_PI
 #define M_PI        3.14159265358979323846264338327950288   /* pi             */
 #endif
@@ -350,7 +356,8 @@ ViewerGL::paintGL()
             if (!viewerNode) {
                 return;
             }
-            // don't even bind the shader on 8-bits gamma-compressed textures
+            // The shader is only bound on float textures, 8-bits textures are already gamma-compressed
+            _imp->displayingImageLut = viewerNode->getColorspace();
             ViewerCompositingOperatorEnum compOperator = viewerNode->getCurrentOperator();
 
             aInputNode = viewerNode->getCurrentAInput();
@@ -516,12 +523,16 @@ ViewerGL::paintGL()
 
                     GL_GPU::ActiveTexture(GL_TEXTURE0);
                     GL_GPU::BindTexture( GL_TEXTURE_2D, _imp->partialUpdateTextures[i].texture->getTexID() );
+                    bool shaderBound = _imp->activateShaderRGB(_imp->partialUpdateTextures[i].texture);
                     GL_GPU::Begin(GL_POLYGON);
                     GL_GPU::TexCoord2d(0, 0); GL_GPU::Vertex2d(canonicalTexRect.x1, canonicalTexRect.y1);
                     GL_GPU::TexCoord2d(0, 1); GL_GPU::Vertex2d(canonicalTexRect.x1, canonicalTexRect.y2);
                     GL_GPU::TexCoord2d(1, 1); GL_GPU::Vertex2d(canonicalTexRect.x2, canonicalTexRect.y2);
                     GL_GPU::TexCoord2d(1, 0); GL_GPU::Vertex2d(canonicalTexRect.x2, canonicalTexRect.y1);
                     GL_GPU::End();
+                    if (shaderBound) {
+                        _imp->shaderRGB->release();
+                    }
                     GL_GPU::BindTexture(GL_TEXTURE_2D, 0);
                     
                     glCheckError(GL_GPU);
@@ -933,6 +944,7 @@ ViewerGL::getPboID(int index)
         GLuint handle;
         GL_GPU::GenBuffers(1, &handle);
         _imp->pboIds.push_back(handle);
+        _imp->pboCapacities.push_back(0);
 
         return handle;
     } else {
@@ -1117,6 +1129,8 @@ ViewerGL::transferBufferFromRAMtoGPU(const ImagePtr& image,
                                      const Point& viewportCenter,
                                      const ImageCacheKeyPtr& viewerProcessNodeTileKey)
 {
+    RenderTrace::Scope_RAII trace("Upload viewer texture", kRenderTraceCategoryGL);
+
     // always running in the main thread
     OpenGLContextLocker locker(_imp.get());
     
@@ -1129,7 +1143,7 @@ ViewerGL::transferBufferFromRAMtoGPU(const ImagePtr& image,
     GL_GPU::GetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING_ARB, &currentBoundPBO);
     glCheckError(GL_GPU);
 
-    // We use 2 PBOs to make use of asynchronous data uploading
+    // We use a ring of PBOs to make use of asynchronous data uploading
     GLuint pboId = getPboID(_imp->updateViewerPboIndex);
 
     assert(textureIndex == 0 || textureIndex == 1);
@@ -1243,15 +1257,18 @@ ViewerGL::transferBufferFromRAMtoGPU(const ImagePtr& image,
 
     // Note that glMapBufferARB() causes sync issue.
     // If GPU is working with this buffer, glMapBufferARB() will wait(stall)
-    // until GPU to finish its job. To avoid waiting (idle), you can call
-    // first glBufferDataARB() with NULL pointer before glMapBufferARB().
-    // If you do that, the previous data in PBO will be discarded and
-    // glMapBufferARB() returns a new allocated pointer immediately
-    // even if GPU is still working with the previous data.
+    // until GPU to finish its job. Since the PBOs are used in turn, the upload
+    // from this PBO was issued NATRON_VIEWER_PBO_RING_SIZE uploads ago and is most
+    // likely done. The buffer storage is only re-allocated with glBufferDataARB() when it
+    // is too small: orphaning the buffer on each upload still stalls on some drivers.
     int dataSizeOf = getSizeOfForBitDepth(imageData.bitDepth);
     std::size_t bytesCount = imageData.bounds.area() * imageData.nComps * dataSizeOf;
     assert(bytesCount > 0);
-    GL_GPU::BufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, bytesCount, NULL, GL_DYNAMIC_DRAW_ARB);
+    std::size_t& pboCapacity = _imp->pboCapacities[_imp->updateViewerPboIndex];
+    if (bytesCount > pboCapacity) {
+        GL_GPU::BufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, bytesCount, NULL, GL_STREAM_DRAW_ARB);
+        pboCapacity = bytesCount;
+    }
 
     // map the buffer object into client's memory
     assert(QGLContext::currentContext() == context());
@@ -1278,7 +1295,7 @@ ViewerGL::transferBufferFromRAMtoGPU(const ImagePtr& image,
     //glBindTexture(GL_TEXTURE_2D, 0); // why should we bind texture 0?
     glCheckError(GL_GPU);
 
-    _imp->updateViewerPboIndex = (_imp->updateViewerPboIndex + 1) % 2;
+    _imp->updateViewerPboIndex = (_imp->updateViewerPboIndex + 1) % NATRON_VIEWER_PBO_RING_SIZE;
 
 
 
@@ -1966,7 +1983,7 @@ ViewerGL::checkIfViewPortRoIValidOrRenderForInput(int texIndex)
 
 
     int tx,ty;
-    CacheBase::getTileSizePx(_imp->displayTextures[texIndex].texture->getBitDepth(), &tx, &ty);
+    appPTR->getTileCache()->getTileSizePx(_imp->displayTextures[texIndex].texture->getBitDepth(), &tx, &ty);
 
 
     const RectI& texBounds = _imp->displayTextures[texIndex].texture->getBounds();
@@ -2933,10 +2950,19 @@ ViewerGL::updateRectangleColorPicker()
     }
 }
 
+static RectangleColorPickerResults computeRectangleColorPicker(const RectangleColorPickerArgs& args);
+
 void
 ViewerGL::updateRectangleColorPickerInternal()
 {
-    float r, g, b, a;
+    if ( _imp->rectanglePickerWatcher && _imp->rectanglePickerWatcher->isRunning() ) {
+        // Computed again with the current rectangle when done, see onRectangleColorPickerComputed()
+        _imp->rectanglePickerDirty = true;
+
+        return;
+    }
+    _imp->rectanglePickerDirty = false;
+
     bool linear = appPTR->getCurrentSettings()->getColorPickerLinear();
     QPointF topLeft = _imp->pickerRect.topLeft();
     QPointF btmRight = _imp->pickerRect.bottomRight();
@@ -2950,18 +2976,54 @@ ViewerGL::updateRectangleColorPickerInternal()
     rect.set_right( std::max( topLeft.x(), btmRight.x() ) );
     rect.set_bottom( std::min( topLeft.y(), btmRight.y() ) );
     rect.set_top( std::max( topLeft.y(), btmRight.y() ) );
+
+    RectangleColorPickerArgs args;
+    args.view = currentView;
     for (int i = 0; i < 2; ++i) {
-        unsigned int mm;
-        bool picked = getColorAtRect(rect, linear, i, pickInput, &r, &g, &b, &a, &mm);
-        if (picked) {
+        ignore_result( getColorAtRectArgs(rect, linear, i, pickInput, &args) );
+    }
+
+    // The results are pushed to the info bar in onRectangleColorPickerComputed()
+    if (!_imp->rectanglePickerWatcher) {
+        _imp->rectanglePickerWatcher.reset(new QFutureWatcher<RectangleColorPickerResults>);
+        QObject::connect( _imp->rectanglePickerWatcher.get(), SIGNAL(finished()), this, SLOT(onRectangleColorPickerComputed()) );
+    }
+    _imp->rectanglePickerWatcher->setFuture( QtConcurrent::run(computeRectangleColorPicker, args) );
+} // updateRectangleColorPickerInternal
+
+void
+ViewerGL::onRectangleColorPickerComputed()
+{
+    // always running in the main thread
+    assert( qApp && qApp->thread() == QThread::currentThread() );
+
+    if (_imp->pickerState != ePickerStateRectangle) {
+        _imp->rectanglePickerDirty = false;
+
+        return;
+    }
+    if (_imp->rectanglePickerDirty) {
+        // The rectangle changed in the meantime, these results are already stale
+        updateRectangleColorPickerInternal();
+
+        return;
+    }
+
+    RectangleColorPickerResults results = _imp->rectanglePickerWatcher->result();
+    for (int i = 0; i < 2; ++i) {
+        if (results.picked[i]) {
+            float r = results.color[i][0];
+            float g = results.color[i][1];
+            float b = results.color[i][2];
+            float a = results.color[i][3];
             if (i == 0) {
-                _imp->viewerTab->getGui()->setColorPickersColor(currentView, r, g, b, a);
+                _imp->viewerTab->getGui()->setColorPickersColor(results.view, r, g, b, a);
             }
             _imp->infoViewer[i]->setColorValid(true);
             if ( !_imp->infoViewer[i]->colorVisible() ) {
                 _imp->infoViewer[i]->showColorInfo();
             }
-            _imp->infoViewer[i]->setColorApproximated(mm > 0);
+            _imp->infoViewer[i]->setColorApproximated(results.mipMapLevel[i] > 0);
             _imp->infoViewer[i]->setColor(r, g, b, a);
 
             ColorRgba<double> c(r,g,b,a);
@@ -2971,7 +3033,7 @@ ViewerGL::updateRectangleColorPickerInternal()
             setParametricParamsPickerColor(ColorRgba<double>(), false, false);
         }
     }
-}
+} // onRectangleColorPickerComputed
 
 void
 ViewerGL::resetWipeControls()
@@ -3005,57 +3067,26 @@ ViewerGL::getTextureColorAt(int x,
                             double *a)
 {
     assert( QThread::currentThread() == qApp->thread() );
-    OpenGLContextLocker locker(_imp.get());
-
-    makeCurrent();
 
     *r = 0;
     *g = 0;
     *b = 0;
     *a = 0;
 
-    ImageBitDepthEnum bitDepth;
+    // Read the color from the CPU side image of the displayed texture rather than from the OpenGL front buffer:
+    // a glReadPixels stalls until the GPU is done drawing
+    for (int i = 0; i < 2; ++i) {
+        float fr, fg, fb, fa;
+        unsigned int mmLevel;
+        if ( getColorAt(x, y, false, i, false, &fr, &fg, &fb, &fa, &mmLevel) ) {
+            *r = fr;
+            *g = fg;
+            *b = fb;
+            *a = fa;
 
-    {
-        QMutexLocker k(&_imp->displayDataMutex);
-        if (_imp->displayTextures[0].texture) {
-            bitDepth = _imp->displayTextures[0].texture->getBitDepth();
-        } else if (_imp->displayTextures[1].texture) {
-            bitDepth = _imp->displayTextures[1].texture->getBitDepth();
-        } else {
             return;
         }
     }
-
-    QPointF pos;
-    {
-        QMutexLocker k(&_imp->zoomCtxMutex);
-        pos = _imp->zoomCtx.toWidgetCoordinates(x, y);
-    }
-
-    if (bitDepth == eImageBitDepthByte) {
-        U32 pixel;
-        GL_GPU::ReadBuffer(GL_FRONT);
-        GL_GPU::ReadPixels(pos.x(), height() - pos.y(), 1, 1, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, &pixel);
-        U8 red = 0, green = 0, blue = 0, alpha = 0;
-        blue |= pixel;
-        green |= (pixel >> 8);
-        red |= (pixel >> 16);
-        alpha |= (pixel >> 24);
-        *r = (double)red / 255.;
-        *g = (double)green / 255.;
-        *b = (double)blue / 255.;
-        *a = (double)alpha / 255.;
-        glCheckError(GL_GPU);
-    } else if (bitDepth == eImageBitDepthFloat) {
-        GLfloat pixel[4];
-        GL_GPU::ReadPixels(pos.x(), height() - pos.y(), 1, 1, GL_RGBA, GL_FLOAT, pixel);
-        *r = (double)pixel[0];
-        *g = (double)pixel[1];
-        *b = (double)pixel[2];
-        *a = (double)pixel[3];
-        glCheckError(GL_GPU);
-    }
 }
 
 void
@@ -3434,19 +3465,15 @@ getColorAtRectForDepth(const Image::CPUData& image,
 
 
 bool
-ViewerGL::getColorAtRect(const RectD &roi, // rectangle in canonical coordinates
-                         bool forceLinear,
-                         int textureIndex,
-                         bool pickInput,
-                         float* r,
-                         float* g,
-                         float* b,
-                         float* a,
-                         unsigned int* imgMmlevel)
+ViewerGL::getColorAtRectArgs(const RectD &roi, // rectangle in canonical coordinates
+                             bool forceLinear,
+                             int textureIndex,
+                             bool pickInput,
+                             RectangleColorPickerArgs* args)
 {
     // always running in the main thread
     assert( qApp && qApp->thread() == QThread::currentThread() );
-    assert(r && g && b && a);
+    assert(args);
     assert(textureIndex == 0 || textureIndex == 1);
 
 
@@ -3466,54 +3493,90 @@ ViewerGL::getColorAtRect(const RectD &roi, // rectangle in canonical coordinates
     }
 
 
-    Image::CPUData imageData;
-    image->getCPUData(&imageData);
-    
     ViewerColorSpaceEnum srcCS = _imp->viewerTab->getGui()->getApp()->getDefaultColorSpaceForBitDepth(image->getBitDepth());
-    const Color::Lut* dstColorSpace;
-    const Color::Lut* srcColorSpace;
     if ( (srcCS == _imp->displayingImageLut) && ( (_imp->displayingImageLut == eViewerColorSpaceLinear) || !forceLinear ) ) {
         // identity transform
-        srcColorSpace = 0;
-        dstColorSpace = 0;
+        args->srcColorSpace[textureIndex] = 0;
+        args->dstColorSpace[textureIndex] = 0;
     } else {
-        srcColorSpace = ViewerInstance::lutFromColorspace(srcCS);
-        dstColorSpace = ViewerInstance::lutFromColorspace(_imp->displayingImageLut);
+        args->srcColorSpace[textureIndex] = ViewerInstance::lutFromColorspace(srcCS);
+        args->dstColorSpace[textureIndex] = ViewerInstance::lutFromColorspace(_imp->displayingImageLut);
     }
 
-    *imgMmlevel = image->getMipMapLevel();
     double par;
     {
         QMutexLocker k(&_imp->displayDataMutex);
         par = _imp->displayTextures[textureIndex].pixelAspectRatio;
     }
 
+    roi.toPixelEnclosing(image->getMipMapLevel(), par, &args->roiPixels[textureIndex]);
+    args->image[textureIndex] = image;
+    args->forceLinear = forceLinear;
 
-    RectI roiPixels;
-    roi.toPixelEnclosing(*imgMmlevel, par, &roiPixels);
+    return true;
+} // getColorAtRectArgs
 
-    double pixelSums[4];
-    switch (image->getBitDepth()) {
-        case eImageBitDepthByte:
-            getColorAtRectForDepth<unsigned char, 255>(imageData, roiPixels, forceLinear, srcColorSpace, dstColorSpace, pixelSums);
-            break;
-        case eImageBitDepthShort:
-            getColorAtRectForDepth<unsigned short, 65535>(imageData, roiPixels, forceLinear, srcColorSpace, dstColorSpace, pixelSums);
-            break;
-        case eImageBitDepthFloat:
-            getColorAtRectForDepth<float, 1>(imageData, roiPixels, forceLinear, srcColorSpace, dstColorSpace, pixelSums);
-            break;
-        case eImageBitDepthHalf:
-        case eImageBitDepthNone:
-            break;
-    }
+/**
+ * @brief Computes the mean color of the rectangle color picker for both inputs. This runs in a background thread:
+ * it only reads the images referenced by args.
+ **/
+static RectangleColorPickerResults
+computeRectangleColorPicker(const RectangleColorPickerArgs& args)
+{
+    RectangleColorPickerResults results;
+    results.view = args.view;
+    for (int i = 0; i < 2; ++i) {
+        results.picked[i] = false;
+        results.mipMapLevel[i] = 0;
+        std::memset( results.color[i], 0, sizeof(float) * 4 );
 
+        const ImagePtr& image = args.image[i];
+        if (!image) {
+            continue;
+        }
 
+        Image::CPUData imageData;
+        image->getCPUData(&imageData);
+        if (!imageData.ptrs[0]) {
+            continue;
+        }
+
+        RectI roiPixels;
+        if ( !args.roiPixels[i].intersect(imageData.bounds, &roiPixels) ) {
+            continue;
+        }
 
+        double pixelSums[4];
+        bool picked;
+        switch ( image->getBitDepth() ) {
+            case eImageBitDepthByte:
+                picked = getColorAtRectForDepth<unsigned char, 255>(imageData, roiPixels, args.forceLinear, args.srcColorSpace[i], args.dstColorSpace[i], pixelSums);
+                break;
+            case eImageBitDepthShort:
+                picked = getColorAtRectForDepth<unsigned short, 65535>(imageData, roiPixels, args.forceLinear, args.srcColorSpace[i], args.dstColorSpace[i], pixelSums);
+                break;
+            case eImageBitDepthFloat:
+                picked = getColorAtRectForDepth<float, 1>(imageData, roiPixels, args.forceLinear, args.srcColorSpace[i], args.dstColorSpace[i], pixelSums);
+                break;
+            case eImageBitDepthHalf:
+            case eImageBitDepthNone:
+            default:
+                picked = false;
+                break;
+        }
+        if (!picked) {
+            continue;
+        }
 
+        results.picked[i] = true;
+        results.mipMapLevel[i] = image->getMipMapLevel();
+        for (int c = 0; c < 4; ++c) {
+            results.color[i][c] = (float)pixelSums[c];
+        }
+    }
 
-    return false;
-} // getColorAtRect
+    return results;
+} // computeRectangleColorPicker
 
 TimeValue
 ViewerGL::getCurrentlyDisplayedTime() const
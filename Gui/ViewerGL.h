@@ -54,6 +54,8 @@ NATRON_NAMESPACE_ENTER;
 
 typedef std::map<FrameViewPair, ImageCacheKeyPtr, FrameView_compare_less> ViewerCachedImagesMap;
 
+struct RectangleColorPickerArgs;
+
 /**
  *@class ViewerGL
  *@brief The main viewport. This class is part of the ViewerTab GUI and handles all
@@ -221,6 +223,8 @@ public Q_SLOTS:
 
     void onCheckerboardSettingsChanged();
 
+    void onRectangleColorPickerComputed();
+
 
     /**
      * @brief Reset the wipe position so it is in the center of the B input.
@@ -393,9 +397,13 @@ public:
     bool getColorAt(double x, double y, bool forceLinear, int textureIndex, bool pickInput, float* r,
                     float* g, float* b, float* a, unsigned int* mipMapLevel) WARN_UNUSED_RETURN;
 
-    // same as getColor, but computes the mean over a given rectangle
-    bool getColorAtRect(const RectD &rect, // rectangle in canonical coordinates
-                        bool forceLinear, int textureIndex, bool pickInput, float* r, float* g, float* b, float* a, unsigned int* mipMapLevel);
+    /**
+     * @brief Same as getColorAt, but sets in args what is needed to compute the mean over a given rectangle
+     * in a background thread for the given input.
+     * @return true if the input has an image to pick colors from
+     **/
+    bool getColorAtRectArgs(const RectD &rect, // rectangle in canonical coordinates
+                            bool forceLinear, int textureIndex, bool pickInput, RectangleColorPickerArgs* args);
 
 
     virtual unsigned int getCurrentRenderScale() const OVERRIDE FINAL;
@@ -32,6 +32,7 @@
 
 #include <QThread>
 #include <QApplication> // qApp
+#include <QtCore/QDebug>
 #include "Global/GLIncludes.h" //!<must be included before QGLWidget
 #include <QtOpenGL/QGLWidget>
 #include <QtOpenGL/QGLShaderProgram>
@@ -47,6 +48,7 @@
 #include "Gui/Gui.h"
 #include "Gui/GuiApplicationManager.h" // appFont
 #include "Gui/Menu.h"
+#include "Gui/Shaders.h"
 #include "Gui/ViewerTab.h"
 
 #ifndef M_PI
@@ -69,9 +71,11 @@ ViewerGL::Implementation::Implementation(ViewerGL* this_,
                                          ViewerTab* parent)
     : _this(this_)
     , pboIds()
+    , pboCapacities()
     , vboVerticesId(0)
     , vboTexturesId(0)
     , iboTriangleStripId(0)
+    , shaderRGB()
     , displayTextures()
     , partialUpdateTextures()
     , infoViewer()
@@ -98,6 +102,9 @@ ViewerGL::Implementation::Implementation(ViewerGL* this_,
     , currentViewerInfo_resolutionOverlay()
     , pickerState(ePickerStateInactive)
     , lastPickerPos()
+    , pickerRect()
+    , rectanglePickerWatcher()
+    , rectanglePickerDirty(false)
     , zoomCtx()   // protected by mutex
     , selectionRectangle()
     , checkerboardTextureID(0)
@@ -140,6 +147,7 @@ ViewerGL::Implementation::~Implementation()
         displayTextures[i].texture.reset();
     }
     partialUpdateTextures.clear();
+    shaderRGB.reset();
 
     if ( appPTR && appPTR->isOpenGLLoaded() ) {
         glCheckError(GL_GPU);
@@ -288,6 +296,7 @@ ViewerGL::Implementation::drawRenderingVAO(unsigned int mipMapLevel,
             GL_GPU::ActiveTexture(GL_TEXTURE0);
             GL_GPU::GetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&prevBoundTexture);
             GL_GPU::BindTexture( GL_TEXTURE_2D, displayTextures[textureIndex].texture->getTexID() );
+            bool shaderBound = activateShaderRGB(displayTextures[textureIndex].texture);
 
             GL_GPU::Begin(GL_POLYGON);
             for (int i = 0; i < polygonTexCoords.size(); ++i) {
@@ -298,6 +307,10 @@ ViewerGL::Implementation::drawRenderingVAO(unsigned int mipMapLevel,
             }
             GL_GPU::End();
 
+            if (shaderBound) {
+                shaderRGB->release();
+            }
+
             GL_GPU::BindTexture( GL_TEXTURE_2D, prevBoundTexture);
 
         } else {
@@ -373,6 +386,7 @@ ViewerGL::Implementation::drawRenderingVAO(unsigned int mipMapLevel,
         GL_GPU::ActiveTexture(GL_TEXTURE0);
         GL_GPU::GetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&prevBoundTexture);
         GL_GPU::BindTexture( GL_TEXTURE_2D, displayTextures[textureIndex].texture->getTexID() );
+        bool shaderBound = activateShaderRGB(displayTextures[textureIndex].texture);
         glCheckError(GL_GPU);
 
         GL_GPU::BindBuffer(GL_ARRAY_BUFFER, this->vboVerticesId);
@@ -394,6 +408,10 @@ ViewerGL::Implementation::drawRenderingVAO(unsigned int mipMapLevel,
         GL_GPU::DrawElements(GL_TRIANGLE_STRIP, 28, GL_UNSIGNED_BYTE, 0);
         glCheckErrorIgnoreOSXBug(GL_GPU);
 
+        if (shaderBound) {
+            shaderRGB->release();
+        }
+
         GL_GPU::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
         GL_GPU::DisableClientState(GL_VERTEX_ARRAY);
         GL_GPU::DisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -410,6 +428,7 @@ ViewerGL::Implementation::initializeGL()
     assert( qApp && qApp->thread() == QThread::currentThread() );
     _this->makeCurrent();
     initAndCheckGlExtensions();
+    initShaderGLSL();
 
     int format, internalFormat, glType;
     Texture::getRecommendedTexParametersForRGBAByteTexture(&format, &internalFormat, &glType);
@@ -451,6 +470,59 @@ ViewerGL::Implementation::initAndCheckGlExtensions()
     return true;
 }
 
+void
+ViewerGL::Implementation::initShaderGLSL()
+{
+    // always running in the main thread
+    assert( qApp && qApp->thread() == QThread::currentThread() );
+    if (shaderRGB) {
+        return;
+    }
+    shaderRGB.reset( new QGLShaderProgram( _this->context() ) );
+    if ( !shaderRGB->addShaderFromSourceCode(QGLShader::Vertex, vertRGB) ||
+         !shaderRGB->addShaderFromSourceCode(QGLShader::Fragment, fragRGB) ||
+         !shaderRGB->link() ) {
+        qDebug() << qPrintable( shaderRGB->log() );
+        // Float textures will be displayed without the display transform
+        shaderRGB.reset();
+    }
+} // initShaderGLSL
+
+bool
+ViewerGL::Implementation::activateShaderRGB(const GLTexturePtr& texture)
+{
+    // always running in the main thread
+    assert( qApp && qApp->thread() == QThread::currentThread() );
+    assert( QGLContext::currentContext() == _this->context() );
+
+    if ( !shaderRGB || !texture || (texture->getBitDepth() != eImageBitDepthFloat) ) {
+        return false;
+    }
+    ViewerNodePtr internalNode = _this->getViewerTab()->getInternalNode();
+    if (!internalNode) {
+        return false;
+    }
+    if ( !shaderRGB->bind() ) {
+        qDebug() << qPrintable( shaderRGB->log() );
+        return false;
+    }
+
+    // Must be kept in sync with ViewerInstancePrivate::isGradingDoneByViewer(): with auto-contrast
+    // the gain and gamma were already applied by the viewer process.
+    double gain = 1., gamma = 1.;
+    if ( !internalNode->isAutoContrastEnabled() ) {
+        gain = std::pow( 2., internalNode->getGain() );
+        gamma = internalNode->getGamma();
+    }
+    shaderRGB->setUniformValue("Tex", 0);
+    shaderRGB->setUniformValue("gain", (GLfloat)gain);
+    shaderRGB->setUniformValue("offset", (GLfloat)0.);
+    shaderRGB->setUniformValue("lut", (GLint)displayingImageLut);
+    shaderRGB->setUniformValue("gamma", (GLfloat)gamma);
+
+    return true;
+} // activateShaderRGB
+
 
 void
 ViewerGL::Implementation::getPolygonTextureCoordinates(const QPolygonF & polygonPoints,
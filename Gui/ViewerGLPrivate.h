@@ -31,9 +31,12 @@ CLANG_DIAG_OFF(deprecated)
 CLANG_DIAG_OFF(uninitialized)
 #include <QtCore/QMutex>
 #include <QtCore/QWaitCondition>
+#include <QtCore/QFutureWatcher>
 CLANG_DIAG_ON(deprecated)
 CLANG_DIAG_ON(uninitialized)
 
+#include <boost/scoped_ptr.hpp>
+
 #include "Engine/Image.h"
 #include "Gui/TextRenderer.h"
 #include "Gui/ViewerGL.h"
@@ -110,6 +113,40 @@ struct TextureInfo
     bool isVisible;
 };
 
+/**
+ * @brief What is needed to compute the mean color of the rectangle color picker over the images of both inputs
+ * in a background thread. The image of an input that can not be picked is NULL.
+ **/
+struct RectangleColorPickerArgs
+{
+    ImagePtr image[2];
+
+    // The rectangle to average, in pixel coordinates of the image
+    RectI roiPixels[2];
+    const Color::Lut* srcColorSpace[2];
+    const Color::Lut* dstColorSpace[2];
+    bool forceLinear;
+    ViewIdx view;
+
+    RectangleColorPickerArgs()
+    : image()
+    , roiPixels()
+    , srcColorSpace()
+    , dstColorSpace()
+    , forceLinear(false)
+    , view()
+    {
+    }
+};
+
+struct RectangleColorPickerResults
+{
+    bool picked[2];
+    float color[2][4];
+    unsigned int mipMapLevel[2];
+    ViewIdx view;
+};
+
 struct ViewerGL::Implementation
 {
     Implementation(ViewerGL* this_,
@@ -122,9 +159,11 @@ struct ViewerGL::Implementation
     /////////////////////////////////////////////////////////
     // The following are only accessed from the main thread:
     std::vector<GLuint> pboIds; //!< PBO's id's used by the OpenGL context
+    std::vector<std::size_t> pboCapacities; //!< The size in bytes of the storage allocated for each PBO in pboIds
     GLuint vboVerticesId; //!< VBO holding the vertices for the texture mapping.
     GLuint vboTexturesId; //!< VBO holding texture coordinates.
     GLuint iboTriangleStripId; /*!< IBOs holding vertices indexes for triangle strip sets*/
+    boost::scoped_ptr<QGLShaderProgram> shaderRGB; //!< Applies the display transform (gain, gamma, colorspace) to float textures
 
     // Protects displayTextures, partialUpdateTextures, currentViewerInfo_btmLeftBBOXoverlay currentViewerInfo_topRightBBOXoverlay currentViewerInfo_resolutionOverlay
     mutable QMutex displayDataMutex;
@@ -161,6 +200,13 @@ struct ViewerGL::Implementation
     QPointF lastPickerPos;
     QRectF pickerRect;
 
+    // Computes the mean color of the rectangle color picker in a background thread, so that dragging the rectangle
+    // over a large image does not block the main thread
+    boost::scoped_ptr<QFutureWatcher<RectangleColorPickerResults> > rectanglePickerWatcher;
+
+    // True if the rectangle color picker changed while its mean color was computed: it is computed again once done
+    bool rectanglePickerDirty;
+
     // projection info, only used by the main thread
     QPointF glShadow; //!< pixel size in projection coordinates - used to create shadow
 
@@ -230,6 +276,13 @@ public:
 
     void drawCheckerboardTexture(const QPolygonF& polygon);
 
+    /**
+     * @brief If the given texture is a float texture, binds shaderRGB with the current
+     * display transform of the viewer and returns true. The caller must then call shaderRGB->release()
+     * once the texture is drawn. 8-bit textures have already been transformed by the viewer process.
+     **/
+    bool activateShaderRGB(const GLTexturePtr& texture);
+
     void lockGLContext();
 
     void releaseGLContext();
@@ -239,6 +292,8 @@ private:
      *@brief Checks extensions and init glew on windows. Called by  initializeGL()
      **/
     bool initAndCheckGlExtensions ();
+
+    void initShaderGLSL();
 };
 
 NATRON_NAMESPACE_EXIT;
@@ -265,7 +265,7 @@ ViewerTab::~ViewerTab()
 }
 
 void
-ViewerTab::getTimeLineCachedFrames(std::list<TimeValue>* cachedFrames) const
+ViewerTab::getTimeLineCachedFrames(std::list<RangeD>* cachedFrames) const
 {
     _imp->cachedFramesThread->getCachedFrames(cachedFrames);
 }
@@ -38,6 +38,7 @@ SUBDIRS += \
     Renderer \
     Gui \
     Tests \
+    Benchmarks \
     ProjectConverter \
     PythonBin \
     App
@@ -59,10 +60,11 @@ ceres.depends = glog gflags
 libmv.depends = gflags ceres
 openMVG.depends = ceres
 Serialization.depends = yaml-cpp
-Engine.depends = libmv openMVG HostSupport libtess ceres Serialization
+Engine.depends = libmv openMVG HostSupport libtess ceres Serialization qhttpserver
 Renderer.depends = Engine
 Gui.depends = Engine qhttpserver
 Tests.depends = Gui Engine
+Benchmarks.depends = Engine
 App.depends = Gui Engine
 ProjectConverter.depends = Gui Engine
 
@@ -64,6 +64,7 @@ HEADERS += \
     SerializationBase.h \
     SerializationFwd.h \
     SerializationIO.h \
+    SerializationBinary.h \
     SerializationCompat.h \
     WorkspaceSerialization.h
 
@@ -81,5 +82,6 @@ SOURCES += \
     RectDSerialization.cpp \
     RectISerialization.cpp \
     RotoStrokeItemSerialization.cpp \
+    SerializationBinary.cpp \
     SettingsSerialization.cpp \
     WorkspaceSerialization.cpp
@@ -0,0 +1,320 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "SerializationBinary.h"
+
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <iterator>
+
+#include <boost/cstdint.hpp>
+
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+#include <yaml-cpp/yaml.h>
+#include <yaml-cpp/eventhandler.h>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+
+// One byte identifies the type of each node
+#define NATRON_SERIALIZATION_BINARY_NULL 'n'
+#define NATRON_SERIALIZATION_BINARY_SCALAR 's'
+#define NATRON_SERIALIZATION_BINARY_SEQUENCE 'q'
+#define NATRON_SERIALIZATION_BINARY_MAP 'm'
+
+SERIALIZATION_NAMESPACE_ENTER;
+
+NATRON_NAMESPACE_ANONYMOUS_ENTER
+
+void
+appendU32(boost::uint32_t value, std::string* buffer)
+{
+    // Little endian, whatever the CPU
+    for (int i = 0; i < 4; ++i) {
+        buffer->push_back( (char)( (value >> (8 * i)) & 0xff ) );
+    }
+}
+
+void
+setU32(boost::uint32_t value, std::size_t offset, std::string* buffer)
+{
+    for (int i = 0; i < 4; ++i) {
+        (*buffer)[offset + i] = (char)( (value >> (8 * i)) & 0xff );
+    }
+}
+
+/**
+ * @brief Receives the events of the YAML parser and writes each node as it is parsed.
+ * The number of children of a collection is only known when it ends: its count is written then.
+ **/
+class BinaryEncoderEventHandler
+    : public YAML::EventHandler
+{
+public:
+
+    BinaryEncoderEventHandler()
+    : _buffer()
+    , _collections()
+    {
+    }
+
+    virtual ~BinaryEncoderEventHandler()
+    {
+    }
+
+    const std::string& getBuffer() const
+    {
+        return _buffer;
+    }
+
+    virtual void OnDocumentStart(const YAML::Mark& /*mark*/) OVERRIDE FINAL
+    {
+    }
+
+    virtual void OnDocumentEnd() OVERRIDE FINAL
+    {
+    }
+
+    virtual void OnNull(const YAML::Mark& /*mark*/, YAML::anchor_t /*anchor*/) OVERRIDE FINAL
+    {
+        onNodeStarted();
+        _buffer.push_back(NATRON_SERIALIZATION_BINARY_NULL);
+    }
+
+    virtual void OnAlias(const YAML::Mark& mark, YAML::anchor_t /*anchor*/) OVERRIDE FINAL
+    {
+        // Serialization objects never emit anchors
+        throw YAML::ParserException(mark, "Aliases are not supported by the binary serialization");
+    }
+
+    virtual void OnScalar(const YAML::Mark& /*mark*/, const std::string& /*tag*/,
+                          YAML::anchor_t /*anchor*/, const std::string& value) OVERRIDE FINAL
+    {
+        onNodeStarted();
+        _buffer.push_back(NATRON_SERIALIZATION_BINARY_SCALAR);
+        appendU32( (boost::uint32_t)value.size(), &_buffer );
+        _buffer.append(value);
+    }
+
+    virtual void OnSequenceStart(const YAML::Mark& /*mark*/, const std::string& /*tag*/,
+                                 YAML::anchor_t /*anchor*/, YAML::EmitterStyle::value /*style*/) OVERRIDE FINAL
+    {
+        onCollectionStarted(NATRON_SERIALIZATION_BINARY_SEQUENCE);
+    }
+
+    virtual void OnSequenceEnd() OVERRIDE FINAL
+    {
+        onCollectionEnded(1);
+    }
+
+    virtual void OnMapStart(const YAML::Mark& /*mark*/, const std::string& /*tag*/,
+                            YAML::anchor_t /*anchor*/, YAML::EmitterStyle::value /*style*/) OVERRIDE FINAL
+    {
+        onCollectionStarted(NATRON_SERIALIZATION_BINARY_MAP);
+    }
+
+    virtual void OnMapEnd() OVERRIDE FINAL
+    {
+        // Keys and values were both counted
+        onCollectionEnded(2);
+    }
+
+private:
+
+    void onNodeStarted()
+    {
+        if ( !_collections.empty() ) {
+            ++_collections.back().second;
+        }
+    }
+
+    void onCollectionStarted(char type)
+    {
+        onNodeStarted();
+        _buffer.push_back(type);
+        _collections.push_back( std::make_pair(_buffer.size(), (boost::uint32_t)0) );
+        appendU32(0, &_buffer);
+    }
+
+    void onCollectionEnded(boost::uint32_t nodesPerElement)
+    {
+        assert( !_collections.empty() );
+        setU32(_collections.back().second / nodesPerElement, _collections.back().first, &_buffer);
+        _collections.pop_back();
+    }
+
+    std::string _buffer;
+
+    // For each collection being parsed: the offset of its count in the buffer and its number of child nodes so far
+    std::vector<std::pair<std::size_t, boost::uint32_t> > _collections;
+};
+
+class BinaryDecoder
+{
+public:
+
+    BinaryDecoder(const char* data,
+                  std::size_t size)
+    : _p(data)
+    , _end(data + size)
+    {
+    }
+
+    YAML::Node decodeNode()
+    {
+        char type = readByte();
+
+        switch (type) {
+        case NATRON_SERIALIZATION_BINARY_NULL:
+
+            return YAML::Node(YAML::NodeType::Null);
+        case NATRON_SERIALIZATION_BINARY_SCALAR: {
+            boost::uint32_t size = readU32();
+            checkAvailable(size);
+            YAML::Node ret( std::string(_p, size) );
+            _p += size;
+
+            return ret;
+        }
+        case NATRON_SERIALIZATION_BINARY_SEQUENCE: {
+            boost::uint32_t count = readU32();
+            YAML::Node ret(YAML::NodeType::Sequence);
+            for (boost::uint32_t i = 0; i < count; ++i) {
+                ret.push_back( decodeNode() );
+            }
+
+            return ret;
+        }
+        case NATRON_SERIALIZATION_BINARY_MAP: {
+            boost::uint32_t count = readU32();
+            YAML::Node ret(YAML::NodeType::Map);
+            for (boost::uint32_t i = 0; i < count; ++i) {
+                YAML::Node key = decodeNode();
+                YAML::Node value = decodeNode();
+                // Keys are known to be unique: do not search for an existing key as operator[] would
+                ret.force_insert(key, value);
+            }
+
+            return ret;
+        }
+        default:
+            throw std::runtime_error("Invalid binary serialization: unknown node type");
+        }
+    } // decodeNode
+
+private:
+
+    void checkAvailable(std::size_t size) const
+    {
+        if ( (std::size_t)(_end - _p) < size ) {
+            throw std::runtime_error("Invalid binary serialization: unexpected end of file");
+        }
+    }
+
+    char readByte()
+    {
+        checkAvailable(1);
+
+        return *_p++;
+    }
+
+    boost::uint32_t readU32()
+    {
+        checkAvailable(4);
+        boost::uint32_t ret = 0;
+        for (int i = 0; i < 4; ++i) {
+            ret |= (boost::uint32_t)(unsigned char)_p[i] << (8 * i);
+        }
+        _p += 4;
+
+        return ret;
+    }
+
+    const char* _p;
+    const char* _end;
+};
+
+void
+stripCarriageReturn(std::string* line)
+{
+    if ( !line->empty() && ( (*line)[line->size() - 1] == '\r' ) ) {
+        line->erase(line->size() - 1);
+    }
+}
+
+NATRON_NAMESPACE_ANONYMOUS_EXIT
+
+void
+encodeYAMLToBinary(const std::string& yaml,
+                   std::ostream& stream)
+{
+    std::istringstream ss(yaml);
+    YAML::Parser parser(ss);
+    BinaryEncoderEventHandler handler;
+
+    if ( !parser.HandleNextDocument(handler) ) {
+        // Empty document
+        stream.put(NATRON_SERIALIZATION_BINARY_NULL);
+
+        return;
+    }
+    const std::string& buffer = handler.getBuffer();
+    stream.write( buffer.data(), buffer.size() );
+}
+
+void
+decodeBinaryToYAMLNode(std::istream& stream,
+                       YAML::Node* node)
+{
+    std::string data( (std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>() );
+    BinaryDecoder decoder( data.data(), data.size() );
+
+    *node = decoder.decodeNode();
+}
+
+void
+convertBinaryToYAML(std::istream& binaryStream,
+                    std::ostream& yamlStream)
+{
+    std::string line;
+    std::getline(binaryStream, line);
+    stripCarriageReturn(&line);
+    if (line != NATRON_SERIALIZATION_BINARY_MAGIC) {
+        // This is the header of the file
+        yamlStream << line << "\n";
+        std::getline(binaryStream, line);
+        stripCarriageReturn(&line);
+        if (line != NATRON_SERIALIZATION_BINARY_MAGIC) {
+            throw std::runtime_error("Invalid binary serialization: missing binary header");
+        }
+    }
+    YAML::Node node;
+    decodeBinaryToYAMLNode(binaryStream, &node);
+
+    YAML::Emitter em;
+    em << node;
+    yamlStream << em.c_str();
+}
+
+SERIALIZATION_NAMESPACE_EXIT;
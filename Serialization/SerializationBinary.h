@@ -0,0 +1,62 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2013-2017 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_SerializationBinary_h
+#define Engine_SerializationBinary_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "Serialization/SerializationFwd.h"
+
+// The line that follows the header of a file written in the binary format, see SERIALIZATION_NAMESPACE::writeBinary()
+#define NATRON_SERIALIZATION_BINARY_MAGIC "# Natron Binary Serialization 1"
+
+SERIALIZATION_NAMESPACE_ENTER;
+
+/**
+ * @brief Encodes the YAML document produced by the encode() function of a serialization object
+ * in a compact binary form: the tree of nodes is stored with the size of each scalar and collection
+ * so that it can be rebuilt without scanning and parsing text.
+ * Upon failure a YAML::Exception is thrown.
+ **/
+void encodeYAMLToBinary(const std::string& yaml, std::ostream& stream);
+
+/**
+ * @brief Reads the tree of nodes written by encodeYAMLToBinary(), starting at the current position of the stream.
+ * The node can be passed to the decode() function of a serialization object.
+ * Upon failure a std::runtime_error is thrown.
+ **/
+void decodeBinaryToYAMLNode(std::istream& stream, YAML::Node* node);
+
+/**
+ * @brief Converts a file written with writeBinary() to the same file written with write(), e.g: to compare projects.
+ * Upon failure an exception is thrown.
+ **/
+void convertBinaryToYAML(std::istream& binaryStream, std::ostream& yamlStream);
+
+SERIALIZATION_NAMESPACE_EXIT;
+
+#endif // Engine_SerializationBinary_h
@@ -798,6 +798,7 @@ void NATRON_NAMESPACE::Curve::serialize(Archive & ar, const unsigned int /*versi
 {
     QMutexLocker k(&_imp->_lock);
     ar & ::boost::serialization::make_nvp("KeyFrameSet", _imp->keyFrames);
+    _imp->invalidateEvaluationCache();
 }
 
 
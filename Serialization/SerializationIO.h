@@ -38,6 +38,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 
 #include "Serialization/SerializationFwd.h"
+#include "Serialization/SerializationBinary.h"
 #include "Serialization/WorkspaceSerialization.h"
 #include "Serialization/ProjectSerialization.h"
 #include "Serialization/NodeSerialization.h"
@@ -59,6 +60,23 @@ void write(std::ostream& stream, const T& obj, const std::string& header)
     stream << em.c_str();
 }
 
+/**
+ * @brief Same as write() but the object is written in a compact binary form that is much faster to read back,
+ * see encodeYAMLToBinary(). The stream must be opened in binary mode.
+ * read() recognizes both forms and convertBinaryToYAML() converts the file back to YAML.
+ **/
+template <typename T>
+void writeBinary(std::ostream& stream, const T& obj, const std::string& header)
+{
+    if (!header.empty()) {
+        stream << header.c_str() << "\n";
+    }
+    stream << NATRON_SERIALIZATION_BINARY_MAGIC << "\n";
+    YAML::Emitter em;
+    obj.encode(em);
+    encodeYAMLToBinary(em.c_str(), stream);
+}
+
 class InvalidSerializationFileException : public std::exception
 {
     std::string _what;
@@ -81,7 +99,8 @@ public:
 };
 
 /**
- * @brief Read any serialization object from a YAML encoded file. Upon failure an exception is thrown.
+ * @brief Read any serialization object from a YAML encoded file or a file written with writeBinary().
+ * Upon failure an exception is thrown.
  * @param header The first line of the file is matched against the given header string.
  * If it does not match, this function throws a InvalidSerializationFileException exception
  * If header is empty, it does not check against the header.
@@ -92,9 +111,21 @@ void read(const std::string& header, std::istream& stream, T* obj)
     if (!obj) {
         throw std::invalid_argument("Invalid serialization object");
     }
+    bool checkBinaryMagic = true;
     {
         std::string firstLine;
         std::getline(stream, firstLine);
+
+        // Files read in binary mode keep the carriage return of Windows line endings
+        if ( !firstLine.empty() && (firstLine[firstLine.size() - 1] == '\r') ) {
+            firstLine.erase(firstLine.size() - 1);
+        }
+        if (header.empty() && firstLine == NATRON_SERIALIZATION_BINARY_MAGIC) {
+            YAML::Node node;
+            decodeBinaryToYAMLNode(stream, &node);
+            obj->decode(node);
+            return;
+        }
         if (!header.empty()) {
             if (firstLine != header) {
                 throw InvalidSerializationFileException();
@@ -116,9 +147,27 @@ void read(const std::string& header, std::istream& stream, T* obj)
             // Since we called getline, we must reset the stream
             if (!skipFirstLine) {
                 stream.seekg(0);
+                checkBinaryMagic = false;
             }
         }
     }
+    if (checkBinaryMagic) {
+        // After the header, a file written with writeBinary() has the binary magic line
+        std::streampos pos = stream.tellg();
+        std::string secondLine;
+        std::getline(stream, secondLine);
+        if ( !secondLine.empty() && (secondLine[secondLine.size() - 1] == '\r') ) {
+            secondLine.erase(secondLine.size() - 1);
+        }
+        if (secondLine == NATRON_SERIALIZATION_BINARY_MAGIC) {
+            YAML::Node node;
+            decodeBinaryToYAMLNode(stream, &node);
+            obj->decode(node);
+            return;
+        }
+        stream.clear();
+        stream.seekg(pos);
+    }
     YAML::Node node = YAML::Load(stream);
     obj->decode(node);
 }
@@ -133,6 +133,11 @@ CONFIG(custombuild) {
 	CONFIG_SET=1
 }
 
+CONFIG(cache-interprocess) {
+	message("Compiling with a persistent cache shared by concurrent processes.")
+	DEFINES += NATRON_CACHE_INTERPROCESS_ROBUST
+}
+
 isEmpty(BUILD_NUMBER) {
 	DEFINES += NATRON_BUILD_NUMBER=0
 } else {
@@ -70,7 +70,7 @@ win32-msvc*{
 # Engine
 
 static-engine {
-CONFIG += static-libmv static-openmvg static-hoedown static-libtess static-serialization
+CONFIG += static-libmv static-openmvg static-hoedown static-libtess static-serialization static-qhttpserver
 
 win32-msvc*{
         CONFIG(64bit) {
@@ -32,7 +32,9 @@
 
 #include <Eigen/SVD>
 #include <Eigen/QR>
+#include <algorithm>
 #include <iostream>
+#include <vector>
 #include "ceres/ceres.h"
 #include "libmv/logging/logging.h"
 #include "libmv/image/image.h"
@@ -137,6 +139,7 @@ TrackRegionOptions::TrackRegionOptions()
       use_esm(true),
       use_brute_initialization(true),
       attempt_refine_before_brute(true),
+      brute_pyramid_levels(0),
       use_normalized_intensities(false),
       sigma(0.9),
       num_extra_points(0),
@@ -1179,6 +1182,117 @@ void CreateBrutePattern(const double *x1, const double *y1,
   *origin_y = min_y;
 }
 
+// The coarsest level of the brute-force pyramid keeps at least this many pixels
+// in each dimension of the pattern.
+const int kMinBrutePyramidPatternSize = 4;
+
+// Number of shifts tried around the shift found at the coarser level, in each
+// direction, when refining the brute-force search at a finer level.
+const int kBrutePyramidRefineRadius = 2;
+
+// Downscales the array by 2 by averaging blocks of 2x2 values.
+template<typename Array>
+void DownscaleBruteArrayBy2(const Array &in, FloatArray *out) {
+  out->resize(in.rows() / 2, in.cols() / 2);
+  for (int r = 0; r < out->rows(); ++r) {
+    for (int c = 0; c < out->cols(); ++c) {
+      (*out)(r, c) = 0.25f * (in(2 * r, 2 * c) + in(2 * r, 2 * c + 1) +
+                              in(2 * r + 1, 2 * c) + in(2 * r + 1, 2 * c + 1));
+    }
+  }
+}
+
+// Finds the shift of the pattern in the search area with the lowest weighted
+// sum of absolute differences, among the rows [min_r, max_r) and the columns
+// [min_c, max_c). Returns false if no shift was tried.
+template<typename SearchArray>
+bool BruteSearchTranslation(const FloatArray &pattern,
+                            const FloatArray &mask,
+                            const SearchArray &search,
+                            const double mask_sum,
+                            const bool use_normalized_intensities,
+                            const int min_r, const int max_r,
+                            const int min_c, const int max_c,
+                            int *best_r, int *best_c,
+                            int *num_shifts_tried) {
+  double best_sad = std::numeric_limits<double>::max();
+  *best_r = -1;
+  *best_c = -1;
+  int w = pattern.cols();
+  int h = pattern.rows();
+  if (max_r <= min_r || max_c <= min_c) {
+    return false;
+  }
+  *num_shifts_tried += (max_r - min_r) * (max_c - min_c);
+
+  // The rows of the search area are split between threads, each keeping its
+  // own best shift. Large search areas are worth the threading overhead.
+#ifdef _OPENMP
+  #pragma omp parallel if ((max_r - min_r) * (max_c - min_c) * h * w > 1 << 22)
+#endif
+  {
+    double thread_best_sad = std::numeric_limits<double>::max();
+    int thread_best_r = -1;
+    int thread_best_c = -1;
+
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic, 1)
+#endif
+    for (int r = min_r; r < max_r; ++r) {
+      for (int c = min_c; c < max_c; ++c) {
+        // Compute the weighted sum of absolute differences, Eigen style. Note
+        // that the block from the search image is never stored in a variable,
+        // to avoid copying overhead and permit inlining.
+        //
+        // The sum only grows: it is accumulated one pattern row at a time and
+        // the shift is given up as soon as it cannot beat the best one.
+        double inverse_search_mean = 1.0;
+        if (use_normalized_intensities) {
+          // TODO(keir): It's really dumb to recompute the search mean for every
+          // shift. A smarter implementation would use summed area tables
+          // instead, reducing the mean calculation to an O(1) operation.
+          inverse_search_mean =
+              mask_sum / ((mask * search.block(r, c, h, w)).sum());
+        }
+        double sad = 0.0;
+        for (int i = 0; i < h && sad < thread_best_sad; ++i) {
+          if (use_normalized_intensities) {
+            sad += (mask.row(i) * (pattern.row(i) -
+                                   (search.block(r + i, c, 1, w) *
+                                    inverse_search_mean))).abs().sum();
+          } else {
+            sad += (mask.row(i) * (pattern.row(i) -
+                                   search.block(r + i, c, 1, w))).abs().sum();
+          }
+        }
+        if (sad < thread_best_sad) {
+          thread_best_r = r;
+          thread_best_c = c;
+          thread_best_sad = sad;
+        }
+      }
+    }
+
+    // Keep the first of the best shifts in scan order, as a single thread
+    // would.
+#ifdef _OPENMP
+    #pragma omp critical
+#endif
+    {
+      if (thread_best_r != -1 &&
+          (thread_best_sad < best_sad ||
+           (thread_best_sad == best_sad &&
+            (thread_best_r < *best_r ||
+             (thread_best_r == *best_r && thread_best_c < *best_c))))) {
+        *best_r = thread_best_r;
+        *best_c = thread_best_c;
+        best_sad = thread_best_sad;
+      }
+    }
+  }
+  return *best_r != -1 && *best_c != -1;
+}
+
 // Compute a translation-only estimate of the warp, using brute force search. A
 // smarter implementation would use the FFT to compute the normalized cross
 // correlation. Instead, this is a dumb implementation. Surprisingly, it is
@@ -1202,6 +1316,7 @@ bool BruteTranslationOnlyInitialize(const FloatImage &image1,
                                     const FloatImage &image2,
                                     const int num_extra_points,
                                     const bool use_normalized_intensities,
+                                    const int num_pyramid_levels,
                                     const double *x1, const double *y1,
                                     double *x2, double *y2) {
   // Create the pattern to match in the space of image2, assuming our inital
@@ -1238,40 +1353,81 @@ bool BruteTranslationOnlyInitialize(const FloatImage &image1,
   // change in the cost function. If the image is a blob or splotch with blurry
   // edges, then fewer samples are necessary since a few pixels offset won't
   // change the cost function much.
-  double best_sad = std::numeric_limits<double>::max();
   int best_r = -1;
   int best_c = -1;
   int w = pattern.cols();
   int h = pattern.rows();
+  int num_shifts_tried = 0;
+
+  int min_r = 0;
+  int max_r = image2.Height() - h;
+  int min_c = 0;
+  int max_c = image2.Width() - w;
+
+  // With a pyramid, search the whole area at the coarsest level only, then
+  // restrict the search at each finer level around the shift found.
+  int num_levels = 0;
+  while (num_levels < num_pyramid_levels &&
+         (h >> (num_levels + 1)) >= kMinBrutePyramidPatternSize &&
+         (w >> (num_levels + 1)) >= kMinBrutePyramidPatternSize) {
+    ++num_levels;
+  }
+  if (num_levels > 0) {
+    std::vector<FloatArray> level_patterns(num_levels);
+    std::vector<FloatArray> level_masks(num_levels);
+    std::vector<FloatArray> level_searches(num_levels);
+    DownscaleBruteArrayBy2(pattern, &level_patterns[0]);
+    DownscaleBruteArrayBy2(mask, &level_masks[0]);
+    DownscaleBruteArrayBy2(search, &level_searches[0]);
+    for (int l = 1; l < num_levels; ++l) {
+      DownscaleBruteArrayBy2(level_patterns[l - 1], &level_patterns[l]);
+      DownscaleBruteArrayBy2(level_masks[l - 1], &level_masks[l]);
+      DownscaleBruteArrayBy2(level_searches[l - 1], &level_searches[l]);
+    }
 
-  for (int r = 0; r < (image2.Height() - h); ++r) {
-    for (int c = 0; c < (image2.Width() - w); ++c) {
-      // Compute the weighted sum of absolute differences, Eigen style. Note
-      // that the block from the search image is never stored in a variable, to
-      // avoid copying overhead and permit inlining.
-      double sad;
-      if (use_normalized_intensities) {
-        // TODO(keir): It's really dumb to recompute the search mean for every
-        // shift. A smarter implementation would use summed area tables
-        // instead, reducing the mean calculation to an O(1) operation.
-        double inverse_search_mean =
-            mask_sum / ((mask * search.block(r, c, h, w)).sum());
-        sad = (mask * (pattern - (search.block(r, c, h, w) *
-                                  inverse_search_mean))).abs().sum();
-      } else {
-        sad = (mask * (pattern - search.block(r, c, h, w))).abs().sum();
-      }
-      if (sad < best_sad) {
-        best_r = r;
-        best_c = c;
-        best_sad = sad;
+    bool found = true;
+    int level_r = -1;
+    int level_c = -1;
+    for (int l = num_levels - 1; l >= 0 && found; --l) {
+      const FloatArray &level_pattern = level_patterns[l];
+      const FloatArray &level_mask = level_masks[l];
+      const FloatArray &level_search = level_searches[l];
+      int level_min_r = 0;
+      int level_max_r = level_search.rows() - level_pattern.rows();
+      int level_min_c = 0;
+      int level_max_c = level_search.cols() - level_pattern.cols();
+      if (l < num_levels - 1) {
+        level_min_r = std::max(level_min_r, 2 * level_r - kBrutePyramidRefineRadius);
+        level_max_r = std::min(level_max_r, 2 * level_r + kBrutePyramidRefineRadius + 1);
+        level_min_c = std::max(level_min_c, 2 * level_c - kBrutePyramidRefineRadius);
+        level_max_c = std::min(level_max_c, 2 * level_c + kBrutePyramidRefineRadius + 1);
       }
+      double level_mask_sum =
+          use_normalized_intensities ? level_mask.sum() : 1.0;
+      found = BruteSearchTranslation(level_pattern, level_mask, level_search,
+                                     level_mask_sum, use_normalized_intensities,
+                                     level_min_r, level_max_r,
+                                     level_min_c, level_max_c,
+                                     &level_r, &level_c,
+                                     &num_shifts_tried);
+    }
+
+    // If the pattern vanished at a coarse level, fall back to the full search.
+    if (found) {
+      min_r = std::max(min_r, 2 * level_r - kBrutePyramidRefineRadius);
+      max_r = std::min(max_r, 2 * level_r + kBrutePyramidRefineRadius + 1);
+      min_c = std::max(min_c, 2 * level_c - kBrutePyramidRefineRadius);
+      max_c = std::min(max_c, 2 * level_c + kBrutePyramidRefineRadius + 1);
     }
   }
 
   // This mean the effective pattern area is zero. This check could go earlier,
   // but this is less code.
-  if (best_r == -1 || best_c == -1) {
+  if (!BruteSearchTranslation(pattern, mask, search,
+                              mask_sum, use_normalized_intensities,
+                              min_r, max_r, min_c, max_c,
+                              &best_r, &best_c,
+                              &num_shifts_tried)) {
     return false;
   }
 
@@ -1280,7 +1436,7 @@ bool BruteTranslationOnlyInitialize(const FloatImage &image1,
      << "origin_x: " << origin_x << ", origin_y: " << origin_y << ", "
      << "dc: " << (best_c - origin_x) << ", "
      << "dr: " << (best_r - origin_y)
-     << ", tried " << ((image2.Height() - h) * (image2.Width() - w))
+     << ", tried " << num_shifts_tried
      << " shifts.";
 
   // Apply the shift.
@@ -1388,6 +1544,7 @@ void TemplatedTrackRegion(const FloatImage &image1,
         image2,
         options.num_extra_points,
         options.use_normalized_intensities,
+        options.brute_pyramid_levels,
         x1, y1, x2, y2);
     if (!found_any_alignment) {
       LG << "Brute failed to find an alignment; pattern too small. "
@@ -68,6 +68,13 @@ struct TrackRegionOptions {
   // result is returned as is (skipping a costly brute search).
   bool attempt_refine_before_brute;
 
+  // If greater than zero, the brute-force search is done coarse-to-fine: the
+  // translation is first searched on the pattern and search area downscaled by
+  // 2^brute_pyramid_levels, then only refined around the best shift at each
+  // finer level. This is much faster for large search areas but may miss the
+  // best shift for patterns with fine details.
+  int brute_pyramid_levels;
+
   // If true, normalize the image patches by their mean before doing the sum of
   // squared error calculation. This is reasonable since the effect of
   // increasing light intensity is multiplicative on the pixel intensities.